@@ -0,0 +1,297 @@
+// ============================================================================
+// acquisition_controller.cpp
+// ============================================================================
+
+/**
+ * @file acquisition_controller.cpp
+ * @brief Pipeline start-up, hand-off between stages and display rendering
+ * @version 2.1.0
+ */
+
+#include "acquisition_controller.h"
+
+#include "XControl.h"
+#include "XDetector.h"
+#include "XImage.h"
+
+#include "utils/file_manager.h"
+#include "utils/qimage_wrap.h"
+
+AcquisitionController::AcquisitionController(QObject* parent)
+    : QObject(parent),
+      m_displayQueue(2, BoundedQueue<FrameHandle>::DROP_OLDEST),
+      m_displayPool(4, 4),
+      m_running(false),
+      m_accepting(false),
+      m_recording(false),
+      m_files(nullptr),
+      m_sequence(0),
+      m_framesDisplayed(0),
+      m_displaySkipped(0),
+      m_inFlight(0),
+      m_windowLow(0),
+      m_windowHigh(0),
+      m_windowGeneration(1),
+      m_lookupGeneration(0),
+      m_lookupDepth(0)
+{
+    m_returnFn = [this](HX::XImage* image, bool processed) { returnFrame(image, processed); };
+}
+
+AcquisitionController::~AcquisitionController() {
+    stop();
+}
+
+bool AcquisitionController::start(HX::XDetector& detector, HX::XControl& control,
+                                  const Settings& settings) {
+    if (m_running) {
+        return false;
+    }
+
+    // One buffer assembling, the rest in flight through the stages
+    const uint32_t poolSize = settings.poolSize < 3 ? 3 : settings.poolSize;
+    m_frame.SetLines(settings.linesPerFrame);
+    if (!m_frame.SetPoolSize(poolSize) || !m_frame.SetSegments(settings.segments)) {
+        return false;
+    }
+    m_frame.SetSink(this);
+    m_grabber.SetSink(this);
+    m_grabber.SetFrame(m_frame);
+    m_grabber.SetHeader(settings.lineHeader);
+
+    if (!m_processor.start(settings.correctionWorkers, settings.correctionQueue,
+                           [this](const FrameHandle& frame) { processed(frame); })) {
+        return false;
+    }
+    m_displayQueue.reset();
+    m_displayQueue.setCapacity(settings.displayQueue);
+    m_display = std::thread(&AcquisitionController::displayThread, this);
+
+    m_sequence = 0;
+    m_framesDisplayed = 0;
+    m_displaySkipped = 0;
+    m_accepting = true;
+    m_running = true;
+    if (!m_grabber.Open(detector, control) || !m_grabber.Grab(0)) {
+        stop();
+        return false;
+    }
+    return true;
+}
+
+void AcquisitionController::stop() {
+    if (!m_running) {
+        return;
+    }
+
+    // New frames go straight back to the pool; the stages drain in order,
+    // and the pool outlives every handle to it
+    m_accepting = false;
+    m_processor.stop();
+    m_displayQueue.close();
+    if (m_display.joinable()) {
+        m_display.join();
+    }
+    m_displayQueue.reset();
+    stopRecording();
+    {
+        std::unique_lock<std::mutex> lock(m_flightMutex);
+        m_flightDone.wait(lock, [this] { return m_inFlight == 0; });
+    }
+    m_grabber.Stop();
+    m_grabber.Close();
+    m_running = false;
+}
+
+bool AcquisitionController::startRecording(const QString& directory, const QString& prefix) {
+    if (m_recording) {
+        return false;
+    }
+    if (!m_recorder.Start(directory.toStdString(), prefix.toStdString())) {
+        return false;
+    }
+    m_recording = true;
+    return true;
+}
+
+void AcquisitionController::stopRecording() {
+    if (!m_recording) {
+        return;
+    }
+    // Frames returned from here on go straight back to the pool
+    m_recording = false;
+    m_recorder.Stop();
+}
+
+void AcquisitionController::setDisplayWindow(uint32_t low, uint32_t high) {
+    std::lock_guard<std::mutex> lock(m_windowMutex);
+    m_windowLow = low;
+    m_windowHigh = high;
+    m_windowGeneration++;
+}
+
+AcquisitionController::Statistics AcquisitionController::statistics() const {
+    Statistics stats;
+    stats.framesAcquired = m_sequence;
+    stats.framesDisplayed = m_framesDisplayed;
+    stats.displayDropped = m_displayQueue.dropped() + m_displaySkipped;
+    stats.poolFree = m_frame.GetFreeBuffers();
+    stats.processor = m_processor.statistics();
+    stats.recorder = m_recorder.GetStatistics();
+    return stats;
+}
+
+void AcquisitionController::OnXError(uint32_t err_id, const char* err_msg_) {
+    emit errorOccurred(err_id, QString::fromUtf8(err_msg_ ? err_msg_ : ""));
+}
+
+void AcquisitionController::OnXEvent(uint32_t event_id, uint32_t data) {
+    emit eventOccurred(event_id, data);
+}
+
+void AcquisitionController::OnFrameReady(HX::XImage* image_) {
+    // Receive thread: wrap the pool buffer and move on. A full correction
+    // queue drops the handle here, which returns the buffer at once.
+    if (!m_accepting) {
+        m_frame.Release(image_);
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_flightMutex);
+        m_inFlight++;
+    }
+    FrameHandle frame = std::make_shared<PipelineFrame>(image_, m_sequence++, m_returnFn);
+    m_processor.submit(frame);
+}
+
+void AcquisitionController::processed(const FrameHandle& frame) {
+    FileManager* files = m_files;
+    if (files) {
+        files->saveFrame(frame->image());
+    }
+    m_displayQueue.push(frame);
+}
+
+void AcquisitionController::returnFrame(HX::XImage* image, bool processed) {
+    // Only corrected frames are recorded. The recorder releases the buffer
+    // once it is on disk, or at once if its queue refuses it.
+    if (processed && m_recording) {
+        m_recorder.Submit(image, &m_frame);
+    } else {
+        m_frame.Release(image);
+    }
+
+    std::lock_guard<std::mutex> lock(m_flightMutex);
+    if (--m_inFlight == 0) {
+        m_flightDone.notify_all();
+    }
+}
+
+void AcquisitionController::displayThread() {
+    FrameHandle frame;
+    while (m_displayQueue.pop(frame)) {
+        const QImage image = render(frame);
+        const quint64 sequence = frame->sequence();
+        frame.reset();
+        if (image.isNull()) {
+            m_displaySkipped++;
+            continue;
+        }
+        m_framesDisplayed++;
+        emit frameReady(image, sequence);
+    }
+}
+
+QImage AcquisitionController::render(const FrameHandle& frame) {
+    const HX::XImage& image = *frame->image();
+    if (!image._data_ || image._width == 0 || image._height == 0) {
+        return QImage();
+    }
+    const uint8_t depth = image._pixel_depth;
+
+    uint32_t low;
+    uint32_t high;
+    {
+        std::lock_guard<std::mutex> lock(m_windowMutex);
+        low = m_windowLow;
+        high = m_windowHigh;
+    }
+
+    // 8-bit frames in the full window are shown from the pool buffer itself
+    if (depth == 8 && low >= high) {
+        const QImage wrapped = wrapImage(std::shared_ptr<HX::XImage>(frame, frame->image()));
+        if (!wrapped.isNull()) {
+            return wrapped;
+        }
+    }
+
+    // Everything else is windowed into a recycled 8-bit display buffer
+    const std::shared_ptr<HX::XImage> gray = m_displayPool.acquire(image._width, image._height, 8);
+    if (!gray) {
+        return QImage();
+    }
+
+    if (depth <= 16) {
+        updateLookup(depth);
+        const uint8_t* lookup = m_lookup.data();
+        const size_t mask = m_lookup.size() - 1;
+        for (uint32_t y = 0; y < image._height; ++y) {
+            const uint8_t* row = image._data_ + image._data_offset + static_cast<size_t>(y) * image._stride;
+            uint8_t* out = gray->_data_ + gray->_data_offset + static_cast<size_t>(y) * gray->_stride;
+            if (depth <= 8) {
+                for (uint32_t x = 0; x < image._width; ++x) {
+                    out[x] = lookup[row[x] & mask];
+                }
+            } else {
+                const uint16_t* row16 = reinterpret_cast<const uint16_t*>(row);
+                for (uint32_t x = 0; x < image._width; ++x) {
+                    out[x] = lookup[row16[x] & mask];
+                }
+            }
+        }
+        return wrapImage(gray);
+    }
+
+    // Wide (unpacked 17-24 bit) frames: no table, scale each pixel
+    if (low >= high) {
+        low = 0;
+        high = depth >= 32 ? 0xFFFFFFFFu : (1u << depth) - 1;
+    }
+    const double scale = 255.0 / static_cast<double>(high - low);
+    for (uint32_t y = 0; y < image._height; ++y) {
+        uint8_t* out = gray->_data_ + gray->_data_offset + static_cast<size_t>(y) * gray->_stride;
+        for (uint32_t x = 0; x < image._width; ++x) {
+            const uint32_t v = image.GetPixelVal(y, x);
+            out[x] = v <= low ? 0 : v >= high ? 255 : static_cast<uint8_t>((v - low) * scale + 0.5);
+        }
+    }
+    return wrapImage(gray);
+}
+
+void AcquisitionController::updateLookup(uint8_t pixelDepth) {
+    uint32_t low;
+    uint32_t high;
+    uint32_t generation;
+    {
+        std::lock_guard<std::mutex> lock(m_windowMutex);
+        low = m_windowLow;
+        high = m_windowHigh;
+        generation = m_windowGeneration;
+    }
+    if (generation == m_lookupGeneration && pixelDepth == m_lookupDepth) {
+        return;
+    }
+
+    const uint32_t entries = 1u << pixelDepth;
+    if (low >= high) {
+        low = 0;
+        high = entries - 1;
+    }
+    const double scale = 255.0 / static_cast<double>(high - low);
+    m_lookup.resize(entries);
+    for (uint32_t v = 0; v < entries; ++v) {
+        m_lookup[v] = v <= low ? 0 : v >= high ? 255 : static_cast<uint8_t>((v - low) * scale + 0.5);
+    }
+    m_lookupGeneration = generation;
+    m_lookupDepth = pixelDepth;
+}
@@ -0,0 +1,220 @@
+// ============================================================================
+// acquisition_controller.h
+// ============================================================================
+
+/**
+ * @file acquisition_controller.h
+ * @brief Staged acquisition pipeline: grab, correct, display and record
+ * @version 2.1.0
+ *
+ * The XGrabber receive thread assembles frames into a pool of XFrame
+ * buffers and hands each one to the ImageProcessor workers as a
+ * FrameHandle. Corrected frames, in acquisition order, go through a
+ * bounded queue to the display thread, which windows them into recycled
+ * 8-bit buffers off the GUI thread and emits frameReady() with a QImage
+ * wrapping the buffer (8-bit frames in the full window are wrapped as
+ * they are). A buffer is recycled when the GUI drops its last copy of the
+ * QImage, and an acquisition buffer goes back to the XFrame pool when the
+ * last stage drops its handle; while recording, that return submits it to
+ * the XRecorder instead, which writes it in place and releases it once it
+ * is on disk. Pixels are never copied between stages.
+ *
+ * Every queue drops rather than blocks, so a slow display or disk never
+ * stalls the receive thread: the display keeps the newest frames, the
+ * correction queue and the recorder refuse new ones.
+ */
+
+#ifndef ACQUISITION_CONTROLLER_H
+#define ACQUISITION_CONTROLLER_H
+
+#include <QImage>
+#include <QObject>
+#include <QString>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "XFrame.h"
+#include "XGrabber.h"
+#include "XRecorder.h"
+#include "iximg_sink.h"
+
+#include "image_processor.h"
+#include "pipeline_frame.h"
+#include "utils/bounded_queue.h"
+#include "utils/image_pool.h"
+
+namespace HX {
+class XControl;
+class XDetector;
+}
+
+class FileManager;
+
+/**
+ * @class AcquisitionController
+ * @brief Owner of the acquisition pipeline and its threads
+ */
+class AcquisitionController : public QObject, public HX::IXImgSink {
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Pipeline sizing, fixed for one start()
+     */
+    struct Settings {
+        uint32_t linesPerFrame;     ///< Lines assembled into one frame
+        uint32_t segments;          ///< Module segments per line (1 = whole lines)
+        bool lineHeader;            ///< Image packets carry the 8-byte line header
+        uint32_t poolSize;          ///< XFrame buffers, i.e. frames in flight (>= 3)
+        uint32_t correctionWorkers; ///< Correction threads (0 = one per core, minus one)
+        uint32_t correctionQueue;   ///< Frames waiting for a worker
+        uint32_t displayQueue;      ///< Frames waiting for the display; older ones are dropped
+
+        Settings()
+            : linesPerFrame(512),
+              segments(1),
+              lineHeader(true),
+              poolSize(8),
+              correctionWorkers(0),
+              correctionQueue(4),
+              displayQueue(2)
+        {}
+    };
+
+    /**
+     * @brief Pipeline counters since start()
+     */
+    struct Statistics {
+        uint64_t framesAcquired;                ///< Frames delivered by XFrame
+        uint64_t framesDisplayed;               ///< frameReady() emissions
+        uint64_t displayDropped;                ///< Frames the display skipped (queue or buffers full)
+        uint32_t poolFree;                      ///< XFrame buffers not in the pipeline
+        ImageProcessor::Statistics processor;
+        HX::XRecorder::Statistics recorder;
+    };
+
+    explicit AcquisitionController(QObject* parent = nullptr);
+    ~AcquisitionController() override;
+
+    /// Correction stage; load the calibration while stopped
+    ImageProcessor& processor() { return m_processor; }
+
+    /**
+     * @brief Open the image channel and start all stages
+     * @param detector Detector to acquire from
+     * @param control Open command channel of the detector
+     * @param settings Pipeline sizing
+     * @return true on success, false if running or a stage failed to start
+     */
+    bool start(HX::XDetector& detector, HX::XControl& control,
+               const Settings& settings = Settings());
+
+    /**
+     * @brief Stop grabbing, drain the stages and close the image channel
+     */
+    void stop();
+
+    bool isRunning() const { return m_running; }
+
+    /**
+     * @brief Write every corrected frame to disk
+     * @param directory Output directory
+     * @param prefix File name prefix
+     * @return true if the recorder started
+     */
+    bool startRecording(const QString& directory, const QString& prefix = QStringLiteral("frame"));
+
+    /**
+     * @brief Stop writing; frames already queued are finished first
+     */
+    void stopRecording();
+
+    bool isRecording() const { return m_recording; }
+
+    /**
+     * @brief Also hand every corrected frame to a file manager
+     * @param files Receiver of copies for "save sequence", or nullptr;
+     *              must stay alive while the pipeline runs
+     * @note Unlike startRecording(), frames are copied, so a slow disk
+     *       never holds acquisition buffers
+     */
+    void setFileManager(FileManager* files) { m_files = files; }
+
+    /**
+     * @brief Map [low, high] to the 8-bit display range
+     * @note low == high selects the full range of the pixel depth
+     */
+    void setDisplayWindow(uint32_t low, uint32_t high);
+
+    Statistics statistics() const;
+
+    // HX::IXImgSink, called on SDK threads
+    void OnXError(uint32_t err_id, const char* err_msg_) override;
+    void OnXEvent(uint32_t event_id, uint32_t data) override;
+    void OnFrameReady(HX::XImage* image_) override;
+
+signals:
+    /**
+     * @brief A corrected frame rendered for display (emitted on the display thread)
+     * @param image 8-bit grayscale image wrapping a pooled buffer; do not
+     *              write to it, and drop it once it is replaced on screen
+     * @param sequence Position of the frame in acquisition order
+     */
+    void frameReady(const QImage& image, quint64 sequence);
+
+    void errorOccurred(quint32 errorId, const QString& message);
+    void eventOccurred(quint32 eventId, quint32 data);
+
+private:
+    void processed(const FrameHandle& frame);
+    void returnFrame(HX::XImage* image, bool processed);
+    void displayThread();
+    QImage render(const FrameHandle& frame);
+    void updateLookup(uint8_t pixelDepth);
+
+    // Declared first so it outlives every handle to its buffers
+    HX::XFrame m_frame;
+    HX::XGrabber m_grabber;
+    HX::XRecorder m_recorder;
+    ImageProcessor m_processor;
+    PipelineFrame::ReturnFn m_returnFn;
+
+    BoundedQueue<FrameHandle> m_displayQueue;
+    ImagePool m_displayPool;
+    std::thread m_display;
+
+    std::atomic<bool> m_running;
+    std::atomic<bool> m_accepting;              ///< OnFrameReady() feeds the pipeline
+    std::atomic<bool> m_recording;
+    std::atomic<FileManager*> m_files;
+    std::atomic<uint64_t> m_sequence;
+    std::atomic<uint64_t> m_framesDisplayed;
+    std::atomic<uint64_t> m_displaySkipped;       ///< No free display buffer
+
+    // Frames handed to the pipeline and not yet returned. XFrame frees its
+    // pool when the grabber stops, so stop() waits for this to reach zero;
+    // a tap (calibration) may hold frames after the processor has stopped.
+    std::mutex m_flightMutex;
+    std::condition_variable m_flightDone;
+    uint32_t m_inFlight;
+
+    // Display window; the display thread rebuilds its table on change
+    std::mutex m_windowMutex;
+    uint32_t m_windowLow;
+    uint32_t m_windowHigh;
+    uint32_t m_windowGeneration;
+    uint32_t m_lookupGeneration;            ///< Display thread only
+    uint8_t m_lookupDepth;                  ///< Display thread only
+    std::vector<uint8_t> m_lookup;          ///< Display thread only, value -> gray
+
+    // Non-copyable
+    AcquisitionController(const AcquisitionController&) = delete;
+    AcquisitionController& operator=(const AcquisitionController&) = delete;
+};
+
+#endif // ACQUISITION_CONTROLLER_H
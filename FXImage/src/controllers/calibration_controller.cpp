@@ -0,0 +1,232 @@
+// ============================================================================
+// calibration_controller.cpp
+// ============================================================================
+
+/**
+ * @file calibration_controller.cpp
+ * @brief Calibration worker thread fed from the correction stage
+ * @version 2.1.0
+ */
+
+#include "calibration_controller.h"
+
+#include <cstring>
+
+#include "XImage.h"
+#include "xog_correct.h"
+
+#include "acquisition_controller.h"
+#include "image_processor.h"
+
+namespace {
+
+// Frames waiting for the worker; the tap holds pool buffers, so keep it short
+const size_t CALIBRATION_QUEUE = 2;
+
+// Pixel depth of the frames the corrector calibrates
+const uint8_t CALIBRATION_DEPTH = 16;
+
+} // namespace
+
+CalibrationController::CalibrationController(QObject* parent)
+    : QObject(parent),
+      m_xog(hubx_xog_create()),
+      m_processor(nullptr),
+      m_phase(PHASE_IDLE),
+      m_cancel(false),
+      m_hasOffset(false),
+      m_hasGain(false),
+      m_width(0),
+      m_height(0)
+{}
+
+CalibrationController::~CalibrationController() {
+    cancel();
+    hubx_xog_destroy(m_xog);
+}
+
+bool CalibrationController::startDark(AcquisitionController& acquisition, uint32_t frames) {
+    return startCollecting(acquisition, PHASE_DARK, frames, 0);
+}
+
+bool CalibrationController::startBright(AcquisitionController& acquisition, uint32_t frames,
+                                        uint16_t target) {
+    if (target == 0 || !m_hasOffset) {
+        return false;
+    }
+    return startCollecting(acquisition, PHASE_BRIGHT, frames, target);
+}
+
+bool CalibrationController::save(const QString& file) {
+    if (!m_xog || file.isEmpty() || !m_hasOffset || m_phase != PHASE_IDLE) {
+        return false;
+    }
+    join();
+
+    m_cancel = false;
+    m_phase = PHASE_SAVING;
+    m_worker = std::thread(&CalibrationController::saveThread, this,
+                           std::string(file.toLocal8Bit().constData()));
+    return true;
+}
+
+void CalibrationController::cancel() {
+    m_cancel = true;
+    if (m_queue) {
+        m_queue->close();
+    }
+    join();
+}
+
+bool CalibrationController::startCollecting(AcquisitionController& acquisition, Phase phase,
+                                            uint32_t frames, uint16_t target) {
+    if (!m_xog || frames == 0 || m_phase != PHASE_IDLE || !acquisition.isRunning()) {
+        return false;
+    }
+    join();
+
+    if (phase == PHASE_DARK) {
+        // A new calibration: the first frame sets the size and resets the maps
+        m_hasOffset = false;
+        m_hasGain = false;
+        m_width = 0;
+        m_height = 0;
+    } else {
+        m_hasGain = false;
+    }
+
+    m_cancel = false;
+    m_queue = std::make_shared<FrameQueue>(CALIBRATION_QUEUE, FrameQueue::DROP_NEWEST);
+    m_processor = &acquisition.processor();
+    m_phase = phase;
+    m_worker = std::thread(&CalibrationController::collectThread, this, frames, target);
+
+    std::shared_ptr<FrameQueue> queue = m_queue;
+    m_processor->setRawTap([queue](const FrameHandle& frame) {
+        if (frame) {
+            queue->push(frame);
+        } else {
+            queue->close();     // acquisition stopped
+        }
+    });
+    return true;
+}
+
+void CalibrationController::collectThread(uint32_t frames, uint16_t target) {
+    const int phase = m_phase;
+    QString error;
+    uint32_t done = 0;
+
+    FrameHandle frame;
+    while (done < frames && m_queue->pop(frame)) {
+        if (m_cancel) {
+            break;
+        }
+        const bool added = accumulate(frame, error);
+        frame.reset();      // back to the pool before anything slow
+        if (!added) {
+            break;
+        }
+        done++;
+        emit progress(phase, done, frames);
+    }
+
+    // Untap first, then let go of frames still queued
+    m_processor->setRawTap(ImageProcessor::RawTapFn());
+    m_processor = nullptr;
+    m_queue->close();
+    while (m_queue->pop(frame)) {
+        frame.reset();
+    }
+
+    bool ok = error.isEmpty() && done == frames;
+    if (ok) {
+        int result = phase == PHASE_DARK ? hubx_xog_finalize_offset(m_xog)
+                                         : hubx_xog_finalize_gain(m_xog, target);
+        if (result != 0) {
+            ok = false;
+            error = QStringLiteral("Calibration calculation failed (%1)").arg(result);
+        } else if (phase == PHASE_DARK) {
+            m_hasOffset = true;
+        } else {
+            m_hasGain = true;
+        }
+    } else if (error.isEmpty() && !m_cancel) {
+        error = QStringLiteral("Acquisition stopped after %1 of %2 frames").arg(done).arg(frames);
+    }
+
+    if (!ok) {
+        hubx_xog_discard_frames(m_xog);
+    }
+    finish(ok, error);
+}
+
+void CalibrationController::saveThread(std::string file) {
+    const int result = hubx_xog_save(m_xog, file.c_str());
+    finish(result == 0, result == 0 ? QString()
+                                    : QStringLiteral("Cannot write %1").arg(QString::fromLocal8Bit(file.c_str())));
+}
+
+bool CalibrationController::accumulate(const FrameHandle& frame, QString& error) {
+    const HX::XImage* image = frame->image();
+    const int width = static_cast<int>(image->_width);
+    const int height = static_cast<int>(image->_height);
+    if (image->_pixel_depth != CALIBRATION_DEPTH || width == 0 || height == 0) {
+        error = QStringLiteral("Calibration needs 16-bit frames (got %1-bit)").arg(image->_pixel_depth);
+        return false;
+    }
+
+    if (m_width == 0) {
+        if (hubx_xog_init(m_xog, width, height, CALIBRATION_DEPTH) != 0) {
+            error = QStringLiteral("Cannot calibrate %1 x %2 frames").arg(width).arg(height);
+            return false;
+        }
+        m_width = width;
+        m_height = height;
+    } else if (width != m_width || height != m_height) {
+        error = QStringLiteral("Frame size changed to %1 x %2 during calibration (was %3 x %4)")
+                    .arg(width).arg(height).arg(m_width).arg(m_height);
+        return false;
+    }
+
+    const size_t rowBytes = static_cast<size_t>(width) * sizeof(unsigned short);
+    const uint8_t* first = image->_data_ + image->_data_offset;
+    const unsigned short* pixels = reinterpret_cast<const unsigned short*>(first);
+    if (image->_stride != rowBytes) {
+        m_scratch.resize(static_cast<size_t>(width) * height);
+        for (int y = 0; y < height; ++y) {
+            memcpy(&m_scratch[static_cast<size_t>(y) * width], first + static_cast<size_t>(y) * image->_stride,
+                   rowBytes);
+        }
+        pixels = m_scratch.data();
+    }
+
+    const int result = m_phase == PHASE_DARK ? hubx_xog_add_dark(m_xog, pixels)
+                                             : hubx_xog_add_bright(m_xog, pixels);
+    if (result != 0) {
+        error = QStringLiteral("Cannot add calibration frame (%1)").arg(result);
+        return false;
+    }
+    return true;
+}
+
+void CalibrationController::finish(bool ok, const QString& error) {
+    const int phase = m_phase;
+    m_phase = PHASE_IDLE;
+    if (!error.isEmpty()) {
+        emit failed(error);
+    }
+    emit phaseFinished(phase, ok);
+}
+
+void CalibrationController::join() {
+    if (!m_worker.joinable()) {
+        return;
+    }
+    // A slot connected directly to phaseFinished() runs on the worker itself
+    if (m_worker.get_id() == std::this_thread::get_id()) {
+        m_worker.detach();
+    } else {
+        m_worker.join();
+    }
+}
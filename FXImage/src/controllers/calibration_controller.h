@@ -0,0 +1,136 @@
+// ============================================================================
+// calibration_controller.h
+// ============================================================================
+
+/**
+ * @file calibration_controller.h
+ * @brief Offset/gain calibration collected from the live pipeline
+ * @version 2.1.0
+ *
+ * While a phase runs, the acquisition pipeline's correction workers hand
+ * raw frames to this controller instead of correcting them (display and
+ * recording carry on with the raw frames). A worker thread folds each
+ * frame into the running mean of an hubx_xog instance, so memory stays at
+ * one frame whatever the frame count, and nothing runs on the GUI thread.
+ * Frames arriving while the worker is busy are skipped, not queued.
+ *
+ * Order: startDark(), then optionally startBright() (needs the offset),
+ * then save(). Each phase reports progress() and ends with
+ * phaseFinished(); all signals are emitted on the worker thread.
+ */
+
+#ifndef CALIBRATION_CONTROLLER_H
+#define CALIBRATION_CONTROLLER_H
+
+#include <QObject>
+#include <QString>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "pipeline_frame.h"
+#include "utils/bounded_queue.h"
+
+struct hubx_xog_t;
+class AcquisitionController;
+class ImageProcessor;
+
+/**
+ * @class CalibrationController
+ * @brief Background dark/bright collection, calibration and saving
+ */
+class CalibrationController : public QObject {
+    Q_OBJECT
+
+public:
+    enum Phase {
+        PHASE_IDLE = 0,
+        PHASE_DARK,                 ///< Collecting dark frames for the offset map
+        PHASE_BRIGHT,               ///< Collecting flat-field frames for the gain map
+        PHASE_SAVING                ///< Writing the calibration file
+    };
+
+    explicit CalibrationController(QObject* parent = nullptr);
+    ~CalibrationController() override;
+
+    /**
+     * @brief Start a new calibration from dark frames
+     * @param acquisition Running pipeline to take frames from; must outlive the phase
+     * @param frames Frames to average
+     * @return false if a phase is running or frames is 0
+     *
+     * @note Discards the offset and gain computed so far. The frame size is
+     *       taken from the first frame; only 16-bit frames are accepted.
+     */
+    bool startDark(AcquisitionController& acquisition, uint32_t frames);
+
+    /**
+     * @brief Compute the gain map from flat-field frames
+     * @param acquisition Running pipeline to take frames from; must outlive the phase
+     * @param frames Frames to average
+     * @param target Level the offset-corrected mean is scaled to
+     * @return false if a phase is running, there is no offset yet, or an argument is 0
+     */
+    bool startBright(AcquisitionController& acquisition, uint32_t frames, uint16_t target);
+
+    /**
+     * @brief Write the calibration for ImageProcessor::loadCalibration()
+     * @return false if a phase is running or there is no offset yet
+     */
+    bool save(const QString& file);
+
+    /**
+     * @brief Abort the running phase and wait for the worker
+     * @note Frames collected by the aborted phase are discarded; maps
+     *       finalized earlier are kept. A save in progress is finished.
+     */
+    void cancel();
+
+    Phase phase() const { return static_cast<Phase>(m_phase.load()); }
+    bool hasOffset() const { return m_hasOffset; }
+    bool hasGain() const { return m_hasGain; }
+
+signals:
+    /// Frames collected in the running phase
+    void progress(int phase, quint32 done, quint32 total);
+
+    /// A phase ended; ok is false on failure or cancel()
+    void phaseFinished(int phase, bool ok);
+
+    /// Why a phase failed (emitted before phaseFinished())
+    void failed(const QString& message);
+
+private:
+    typedef BoundedQueue<FrameHandle> FrameQueue;
+
+    bool startCollecting(AcquisitionController& acquisition, Phase phase,
+                         uint32_t frames, uint16_t target);
+    void collectThread(uint32_t frames, uint16_t target);
+    void saveThread(std::string file);
+    bool accumulate(const FrameHandle& frame, QString& error);
+    void finish(bool ok, const QString& error);
+    void join();
+
+    hubx_xog_t* m_xog;
+    ImageProcessor* m_processor;            ///< Tapped by the running phase
+    std::shared_ptr<FrameQueue> m_queue;    ///< Shared with the tap, which may outlive a phase
+    std::thread m_worker;
+    std::vector<unsigned short> m_scratch;  ///< Rows of a padded frame, made contiguous
+
+    std::atomic<int> m_phase;
+    std::atomic<bool> m_cancel;
+    std::atomic<bool> m_hasOffset;
+    std::atomic<bool> m_hasGain;
+    int m_width;                            ///< Calibration frame size, 0 until the first dark frame
+    int m_height;
+
+    // Non-copyable
+    CalibrationController(const CalibrationController&) = delete;
+    CalibrationController& operator=(const CalibrationController&) = delete;
+};
+
+#endif // CALIBRATION_CONTROLLER_H
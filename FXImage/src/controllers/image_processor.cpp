@@ -0,0 +1,263 @@
+// ============================================================================
+// image_processor.cpp
+// ============================================================================
+
+/**
+ * @file image_processor.cpp
+ * @brief Correction workers and in-order hand-off
+ * @version 2.1.0
+ */
+
+#include "image_processor.h"
+
+#include "XImage.h"
+#include "xog_correct.h"
+
+ImageProcessor::ImageProcessor()
+    : m_ownInstances(false),
+      m_calibWidth(0),
+      m_calibHeight(0),
+      m_queue(4, BoundedQueue<Job>::DROP_NEWEST),
+      m_running(false),
+      m_nextOrder(0),
+      m_nextOutput(0),
+      m_framesSubmitted(0),
+      m_framesCorrected(0),
+      m_framesPassed(0)
+{}
+
+ImageProcessor::~ImageProcessor() {
+    stop();
+    releaseInstances();
+}
+
+bool ImageProcessor::loadCalibration(const std::string& file) {
+    if (m_running) {
+        return false;
+    }
+
+    // Probe the file once; workers load their own instances in start()
+    hubx_xog_t* probe = hubx_xog_create();
+    if (!probe) {
+        return false;
+    }
+    int width = 0;
+    int height = 0;
+    const bool ok = hubx_xog_load(probe, file.c_str()) == 0 &&
+                    hubx_xog_get_size(probe, &width, &height) == 0;
+    hubx_xog_destroy(probe);
+    if (!ok) {
+        return false;
+    }
+
+    releaseInstances();
+    m_calibrationFile = file;
+    m_calibrationSet.reset();
+    m_calibWidth = width;
+    m_calibHeight = height;
+    return true;
+}
+
+bool ImageProcessor::setCalibration(const CalibrationSet& set) {
+    if (m_running || !set || set->empty()) {
+        return false;
+    }
+    int width = 0;
+    int height = 0;
+    if (hubx_xog_get_size((*set)[0], &width, &height) != 0) {
+        return false;
+    }
+
+    releaseInstances();
+    m_calibrationFile.clear();
+    m_calibrationSet = set;
+    m_calibWidth = width;
+    m_calibHeight = height;
+    return true;
+}
+
+void ImageProcessor::clearCalibration() {
+    if (m_running) {
+        return;
+    }
+    releaseInstances();
+    m_calibrationFile.clear();
+    m_calibrationSet.reset();
+    m_calibWidth = 0;
+    m_calibHeight = 0;
+}
+
+bool ImageProcessor::start(uint32_t workers, uint32_t queueDepth, const OutputFn& output) {
+    if (m_running || !output) {
+        return false;
+    }
+
+    if (workers == 0) {
+        const unsigned cores = std::thread::hardware_concurrency();
+        workers = cores > 1 ? cores - 1 : 1;
+    }
+
+    releaseInstances();
+    if (m_calibrationSet) {
+        if (workers > m_calibrationSet->size()) {
+            workers = static_cast<uint32_t>(m_calibrationSet->size());
+        }
+        m_instances.assign(m_calibrationSet->begin(), m_calibrationSet->begin() + workers);
+    } else if (!m_calibrationFile.empty()) {
+        m_ownInstances = true;
+        for (uint32_t i = 0; i < workers; ++i) {
+            hubx_xog_t* instance = hubx_xog_create();
+            if (instance && hubx_xog_load(instance, m_calibrationFile.c_str()) != 0) {
+                hubx_xog_destroy(instance);
+                instance = nullptr;
+            }
+            if (!instance) {
+                releaseInstances();
+                return false;
+            }
+            m_instances.push_back(instance);
+        }
+    }
+
+    m_queue.reset();
+    m_queue.setCapacity(queueDepth);
+    m_output = output;
+    m_nextOrder = 0;
+    m_nextOutput = 0;
+    m_finished.clear();
+    m_framesSubmitted = 0;
+    m_framesCorrected = 0;
+    m_framesPassed = 0;
+
+    m_running = true;
+    for (uint32_t i = 0; i < workers; ++i) {
+        m_workers.push_back(std::thread(&ImageProcessor::workerThread, this, static_cast<size_t>(i)));
+    }
+    return true;
+}
+
+void ImageProcessor::stop() {
+    if (!m_running) {
+        return;
+    }
+
+    m_queue.close();
+    for (size_t i = 0; i < m_workers.size(); ++i) {
+        m_workers[i].join();
+    }
+    m_workers.clear();
+    m_running = false;
+
+    // Tell a tap the stream ended
+    RawTapFn tap;
+    {
+        std::lock_guard<std::mutex> lock(m_tapMutex);
+        tap = m_tap;
+    }
+    if (tap) {
+        tap(FrameHandle());
+    }
+
+    // Every submitted frame completed, so nothing is left waiting
+    std::lock_guard<std::mutex> lock(m_outputMutex);
+    m_finished.clear();
+    m_output = OutputFn();
+}
+
+bool ImageProcessor::submit(const FrameHandle& frame) {
+    if (!m_running || !frame) {
+        return false;
+    }
+
+    m_framesSubmitted++;
+    Job job = { frame, m_nextOrder };
+    if (!m_queue.push(job)) {
+        return false;
+    }
+    m_nextOrder++;
+    return true;
+}
+
+void ImageProcessor::setRawTap(const RawTapFn& tap) {
+    std::lock_guard<std::mutex> lock(m_tapMutex);
+    m_tap = tap;
+}
+
+ImageProcessor::Statistics ImageProcessor::statistics() const {
+    Statistics stats;
+    stats.framesSubmitted = m_framesSubmitted;
+    stats.framesCorrected = m_framesCorrected;
+    stats.framesPassed = m_framesPassed;
+    stats.framesDropped = m_queue.dropped();
+    stats.queued = static_cast<uint32_t>(m_queue.size());
+    stats.queueHighWater = static_cast<uint32_t>(m_queue.highWater());
+    return stats;
+}
+
+void ImageProcessor::workerThread(size_t index) {
+    Job job;
+    while (m_queue.pop(job)) {
+        RawTapFn tap;
+        {
+            std::lock_guard<std::mutex> lock(m_tapMutex);
+            tap = m_tap;
+        }
+        if (tap) {
+            tap(job.frame);
+            m_framesPassed++;
+        } else {
+            correct(index, job.frame);
+        }
+        job.frame->setProcessed();
+        complete(job);
+        job.frame.reset();
+    }
+}
+
+void ImageProcessor::correct(size_t worker, const FrameHandle& frame) {
+    HX::XImage* image = frame->image();
+    const bool fits = worker < m_instances.size() &&
+                      image->_pixel_depth == 16 &&
+                      static_cast<int>(image->_width) == m_calibWidth &&
+                      static_cast<int>(image->_height) == m_calibHeight &&
+                      image->_stride == image->_width * sizeof(unsigned short);
+    if (!fits) {
+        m_framesPassed++;
+        return;
+    }
+
+    // In place: the pool buffer is the only copy of the frame
+    unsigned short* pixels = reinterpret_cast<unsigned short*>(image->_data_ + image->_data_offset);
+    if (hubx_xog_apply(m_instances[worker], pixels, pixels) == 0) {
+        m_framesCorrected++;
+    } else {
+        m_framesPassed++;
+    }
+}
+
+void ImageProcessor::complete(const Job& job) {
+    std::lock_guard<std::mutex> lock(m_outputMutex);
+    if (job.order != m_nextOutput) {
+        m_finished[job.order] = job.frame;
+        return;
+    }
+
+    m_output(job.frame);
+    m_nextOutput++;
+
+    // Frames that finished early and are now next in line
+    std::map<uint64_t, FrameHandle>::iterator it = m_finished.begin();
+    while (it != m_finished.end() && it->first == m_nextOutput) {
+        m_output(it->second);
+        m_nextOutput++;
+        it = m_finished.erase(it);
+    }
+}
+
+void ImageProcessor::releaseInstances() {
+    for (size_t i = 0; m_ownInstances && i < m_instances.size(); ++i) {
+        hubx_xog_destroy(m_instances[i]);
+    }
+    m_instances.clear();
+    m_ownInstances = false;
+}
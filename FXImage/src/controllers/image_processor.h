@@ -0,0 +1,161 @@
+// ============================================================================
+// image_processor.h
+// ============================================================================
+
+/**
+ * @file image_processor.h
+ * @brief Correction worker pool of the acquisition pipeline
+ * @version 2.1.0
+ *
+ * Frames are corrected in place in their pool buffers by a fixed set of
+ * worker threads, each with its own hubx_xog instance (calls on one
+ * instance are serialized). Workers finish out of order; completed frames
+ * are handed on strictly in submission order.
+ */
+
+#ifndef IMAGE_PROCESSOR_H
+#define IMAGE_PROCESSOR_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "pipeline_frame.h"
+#include "utils/bounded_queue.h"
+
+struct hubx_xog_t;
+
+/**
+ * @class ImageProcessor
+ * @brief Bounded input queue, correction workers, in-order output
+ */
+class ImageProcessor {
+public:
+    /// Receives corrected frames in submission order, on a worker thread
+    typedef std::function<void(const FrameHandle& frame)> OutputFn;
+
+    /// Sees each raw frame before it is handed on, on a worker thread
+    typedef std::function<void(const FrameHandle& frame)> RawTapFn;
+
+    /// Loaded calibration instances, one per worker, owned elsewhere
+    typedef std::shared_ptr<const std::vector<hubx_xog_t*> > CalibrationSet;
+
+    /**
+     * @brief Processor counters since start()
+     */
+    struct Statistics {
+        uint64_t framesSubmitted;   ///< submit() calls
+        uint64_t framesCorrected;   ///< Frames corrected with the calibration
+        uint64_t framesPassed;      ///< Frames handed on uncorrected (no or mismatched calibration)
+        uint64_t framesDropped;     ///< Frames refused because the queue was full
+        uint32_t queued;            ///< Frames waiting now
+        uint32_t queueHighWater;    ///< Most frames waiting at once
+    };
+
+    ImageProcessor();
+    ~ImageProcessor();
+
+    /**
+     * @brief Load offset/gain calibration for every worker
+     * @param file Calibration written by XOGCorrect::SaveCalibrationData()
+     * @return true on success; must be called while stopped
+     */
+    bool loadCalibration(const std::string& file);
+
+    /**
+     * @brief Use calibration instances that are already loaded
+     * @param set Instances of one calibration (e.g. from a calibration
+     *            cache); kept until the calibration is replaced or cleared
+     * @return true on success; must be called while stopped
+     * @note At most set->size() workers start, one per instance
+     */
+    bool setCalibration(const CalibrationSet& set);
+
+    /**
+     * @brief Forget the calibration; frames pass through uncorrected
+     */
+    void clearCalibration();
+
+    /**
+     * @brief Start the workers
+     * @param workers Worker threads (0 = one per core, minus one for acquisition)
+     * @param queueDepth Frames that may wait for a worker
+     * @param output Receiver of processed frames
+     * @return true on success, false if running or output is empty
+     */
+    bool start(uint32_t workers, uint32_t queueDepth, const OutputFn& output);
+
+    /**
+     * @brief Finish queued frames, then stop the workers
+     */
+    void stop();
+
+    bool isRunning() const { return m_running; }
+
+    /**
+     * @brief Queue a frame for correction (single producer, never blocks)
+     * @return false if the queue was full and the frame was dropped
+     */
+    bool submit(const FrameHandle& frame);
+
+    /**
+     * @brief Route raw frames to a tap instead of correcting them
+     * @param tap Receiver, or an empty function to resume correction
+     *
+     * Used while collecting calibration frames. The tap runs on worker
+     * threads, concurrently and out of order; it must not block, and it
+     * may keep the handle, which holds the buffer out of the pool. When
+     * the processor stops, the tap is called once with an empty handle.
+     * May be called while running.
+     */
+    void setRawTap(const RawTapFn& tap);
+
+    Statistics statistics() const;
+
+private:
+    struct Job {
+        FrameHandle frame;
+        uint64_t order;             ///< Submission position, no gaps
+    };
+
+    void workerThread(size_t index);
+    void correct(size_t worker, const FrameHandle& frame);
+    void complete(const Job& job);
+    void releaseInstances();
+
+    std::string m_calibrationFile;
+    CalibrationSet m_calibrationSet;
+    std::vector<hubx_xog_t*> m_instances;   ///< One per worker
+    bool m_ownInstances;                    ///< Created by start(), not from m_calibrationSet
+    int m_calibWidth;
+    int m_calibHeight;
+
+    BoundedQueue<Job> m_queue;
+    std::vector<std::thread> m_workers;
+    OutputFn m_output;
+    std::mutex m_tapMutex;
+    RawTapFn m_tap;
+    std::atomic<bool> m_running;
+    uint64_t m_nextOrder;
+
+    // Reordering: frames finished ahead of an earlier one wait here
+    std::mutex m_outputMutex;
+    std::map<uint64_t, FrameHandle> m_finished;
+    uint64_t m_nextOutput;
+
+    std::atomic<uint64_t> m_framesSubmitted;
+    std::atomic<uint64_t> m_framesCorrected;
+    std::atomic<uint64_t> m_framesPassed;
+
+    // Non-copyable
+    ImageProcessor(const ImageProcessor&) = delete;
+    ImageProcessor& operator=(const ImageProcessor&) = delete;
+};
+
+#endif // IMAGE_PROCESSOR_H
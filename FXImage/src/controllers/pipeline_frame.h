@@ -0,0 +1,71 @@
+// ============================================================================
+// pipeline_frame.h
+// ============================================================================
+
+/**
+ * @file pipeline_frame.h
+ * @brief Pool handle passed between the acquisition pipeline stages
+ * @version 2.1.0
+ *
+ * A frame delivered by XFrame stays in its pool buffer for its whole trip
+ * through the pipeline: stages pass a FrameHandle (shared ownership of
+ * the buffer, no pixel copy) and the last one to let go returns it.
+ */
+
+#ifndef PIPELINE_FRAME_H
+#define PIPELINE_FRAME_H
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+namespace HX {
+class XImage;
+}
+
+/**
+ * @class PipelineFrame
+ * @brief One XFrame pool buffer on its way through the pipeline
+ */
+class PipelineFrame {
+public:
+    /// Called once with the buffer when the last handle is dropped
+    typedef std::function<void(HX::XImage* image, bool processed)> ReturnFn;
+
+    PipelineFrame(HX::XImage* image, uint64_t sequence, const ReturnFn& returnFn)
+        : m_image(image),
+          m_sequence(sequence),
+          m_processed(false),
+          m_return(returnFn)
+    {}
+
+    ~PipelineFrame() {
+        if (m_return) {
+            m_return(m_image, m_processed);
+        }
+    }
+
+    /// Pool buffer; stages after correction only read it
+    HX::XImage* image() const { return m_image; }
+
+    /// Position in acquisition order; frames dropped on the way leave gaps
+    uint64_t sequence() const { return m_sequence; }
+
+    /// Correction finished (every later stage sees corrected pixels)
+    bool processed() const { return m_processed; }
+    void setProcessed() { m_processed = true; }
+
+private:
+    HX::XImage* m_image;
+    uint64_t m_sequence;
+    bool m_processed;
+    ReturnFn m_return;
+
+    // Non-copyable
+    PipelineFrame(const PipelineFrame&) = delete;
+    PipelineFrame& operator=(const PipelineFrame&) = delete;
+};
+
+typedef std::shared_ptr<PipelineFrame> FrameHandle;
+
+#endif // PIPELINE_FRAME_H
@@ -0,0 +1,195 @@
+// ============================================================================
+// data_analysis_page.cpp
+// ============================================================================
+
+/**
+ * @file data_analysis_page.cpp
+ * @brief Folder listing, visible-first thumbnail requests and capture viewer
+ * @version 2.1.0
+ */
+
+#include "data_analysis_page.h"
+
+#include <QDir>
+#include <QFileDialog>
+#include <QFileInfo>
+#include <QHBoxLayout>
+#include <QIcon>
+#include <QLabel>
+#include <QListWidget>
+#include <QPixmap>
+#include <QPushButton>
+#include <QScrollBar>
+#include <QSplitter>
+#include <QTimer>
+#include <QVBoxLayout>
+
+#include <vector>
+
+#include "utils/thumbnail_cache.h"
+#include "utils/tile_loader.h"
+#include "widgets/tile_view_widget.h"
+
+namespace {
+
+const int THUMBNAIL_SIZE = 160;
+
+// Item data: capture path, and whether its thumbnail is shown
+const int PATH_ROLE = Qt::UserRole;
+const int LOADED_ROLE = Qt::UserRole + 1;
+
+// Delay after the last scroll before thumbnails are asked for
+const int VISIBLE_DELAY_MS = 40;
+
+} // namespace
+
+DataAnalysisPage::DataAnalysisPage(QWidget* parent)
+    : QWidget(parent),
+      m_thumbnails(new ThumbnailCache(ThumbnailCache::defaultDirectory(), THUMBNAIL_SIZE, 0, this)),
+      m_tiles(new TileLoader(0, this)),
+      m_list(new QListWidget(this)),
+      m_view(new TileViewWidget(this)),
+      m_status(new QLabel(this)),
+      m_visibleTimer(new QTimer(this))
+{
+    QPushButton* openButton = new QPushButton(tr("Open Folder..."), this);
+    QHBoxLayout* top = new QHBoxLayout();
+    top->addWidget(openButton);
+    top->addWidget(m_status, 1);
+
+    // Batched layout: thousands of items are laid out without blocking the GUI
+    m_list->setViewMode(QListView::IconMode);
+    m_list->setIconSize(QSize(THUMBNAIL_SIZE, THUMBNAIL_SIZE));
+    m_list->setGridSize(QSize(THUMBNAIL_SIZE + 24, THUMBNAIL_SIZE + 40));
+    m_list->setResizeMode(QListView::Adjust);
+    m_list->setMovement(QListView::Static);
+    m_list->setUniformItemSizes(true);
+    m_list->setLayoutMode(QListView::Batched);
+    m_list->setBatchSize(500);
+    m_list->setSelectionMode(QAbstractItemView::SingleSelection);
+
+    m_view->setLoader(m_tiles);
+
+    QSplitter* splitter = new QSplitter(Qt::Horizontal, this);
+    splitter->addWidget(m_list);
+    splitter->addWidget(m_view);
+    splitter->setStretchFactor(1, 1);
+
+    QVBoxLayout* layout = new QVBoxLayout(this);
+    layout->addLayout(top);
+    layout->addWidget(splitter, 1);
+
+    m_visibleTimer->setSingleShot(true);
+    m_visibleTimer->setInterval(VISIBLE_DELAY_MS);
+    connect(m_visibleTimer, &QTimer::timeout, this, &DataAnalysisPage::requestVisibleThumbnails);
+    connect(m_list->verticalScrollBar(), &QScrollBar::valueChanged,
+            m_visibleTimer, static_cast<void (QTimer::*)()>(&QTimer::start));
+    connect(m_list->verticalScrollBar(), &QScrollBar::rangeChanged,
+            m_visibleTimer, static_cast<void (QTimer::*)()>(&QTimer::start));
+    connect(m_list, &QListWidget::itemActivated, this, &DataAnalysisPage::itemActivated);
+    connect(openButton, &QPushButton::clicked, this, &DataAnalysisPage::chooseFolder);
+
+    // Emitted on worker threads; queued to the GUI thread
+    connect(m_thumbnails, &ThumbnailCache::thumbnailReady, this, &DataAnalysisPage::thumbnailReady);
+    connect(m_tiles, &TileLoader::opened, this, &DataAnalysisPage::captureOpened);
+    connect(m_tiles, &TileLoader::openFailed, this, &DataAnalysisPage::captureFailed);
+}
+
+DataAnalysisPage::~DataAnalysisPage() {
+}
+
+void DataAnalysisPage::chooseFolder() {
+    const QString folder = QFileDialog::getExistingDirectory(this, tr("Open Capture Folder"), m_folder);
+    if (!folder.isEmpty()) {
+        openFolder(folder);
+    }
+}
+
+void DataAnalysisPage::openFolder(const QString& folder) {
+    m_thumbnails->cancelPending();
+    m_list->clear();
+    m_items.clear();
+    m_folder = folder;
+
+    // Names only: nothing is read from the captures here
+    const QDir dir(folder);
+    const QStringList names = dir.entryList(QStringList() << QStringLiteral("*.tif") << QStringLiteral("*.tiff"),
+                                            QDir::Files, QDir::Name);
+
+    QPixmap placeholder(THUMBNAIL_SIZE, THUMBNAIL_SIZE);
+    placeholder.fill(Qt::darkGray);
+    const QIcon icon(placeholder);
+
+    m_list->setUpdatesEnabled(false);
+    for (int i = 0; i < names.size(); ++i) {
+        const QString path = dir.filePath(names[i]);
+        QListWidgetItem* item = new QListWidgetItem(icon, names[i]);
+        item->setData(PATH_ROLE, path);
+        item->setToolTip(path);
+        m_list->addItem(item);
+        m_items.insert(path, item);
+    }
+    m_list->setUpdatesEnabled(true);
+
+    m_status->setText(tr("%1: %2 captures").arg(QDir::toNativeSeparators(folder)).arg(names.size()));
+    m_visibleTimer->start();
+}
+
+void DataAnalysisPage::openCapture(const QString& path) {
+    m_tiles->open(path);
+    m_status->setText(tr("Opening %1...").arg(QFileInfo(path).fileName()));
+}
+
+void DataAnalysisPage::requestVisibleThumbnails() {
+    // Items on screen and one screen below, in layout order
+    QRect area = m_list->viewport()->rect();
+    area.setBottom(area.bottom() + area.height());
+
+    std::vector<QListWidgetItem*> visible;
+    bool seen = false;
+    for (int i = 0; i < m_list->count(); ++i) {
+        QListWidgetItem* item = m_list->item(i);
+        const QRect rect = m_list->visualItemRect(item);
+        if (rect.intersects(area)) {
+            visible.push_back(item);
+            seen = true;
+        } else if (seen && rect.top() > area.bottom()) {
+            break;
+        }
+    }
+
+    // Requests run newest first, so ask for the top-left item last
+    for (size_t i = visible.size(); i-- > 0;) {
+        QListWidgetItem* item = visible[i];
+        if (item->data(LOADED_ROLE).toBool()) {
+            continue;
+        }
+        const QImage image = m_thumbnails->thumbnail(item->data(PATH_ROLE).toString());
+        if (!image.isNull()) {
+            item->setIcon(QIcon(QPixmap::fromImage(image)));
+            item->setData(LOADED_ROLE, true);
+        }
+    }
+}
+
+void DataAnalysisPage::thumbnailReady(const QString& path, const QImage& image) {
+    QListWidgetItem* item = m_items.value(path, nullptr);
+    if (item && !image.isNull()) {
+        item->setIcon(QIcon(QPixmap::fromImage(image)));
+        item->setData(LOADED_ROLE, true);
+    }
+}
+
+void DataAnalysisPage::itemActivated(QListWidgetItem* item) {
+    if (item) {
+        openCapture(item->data(PATH_ROLE).toString());
+    }
+}
+
+void DataAnalysisPage::captureOpened(const QString& path, int width, int height) {
+    m_status->setText(tr("%1: %2 x %3").arg(QFileInfo(path).fileName()).arg(width).arg(height));
+}
+
+void DataAnalysisPage::captureFailed(const QString& path) {
+    m_status->setText(tr("Cannot open %1").arg(QFileInfo(path).fileName()));
+}
@@ -0,0 +1,79 @@
+// ============================================================================
+// data_analysis_page.h
+// ============================================================================
+
+/**
+ * @file data_analysis_page.h
+ * @brief Capture archive browser: thumbnail grid and tiled viewer
+ * @version 2.1.0
+ *
+ * Opening a folder lists file names only; thumbnails are asked for as
+ * their items scroll into view and come from ThumbnailCache, so a folder
+ * of thousands of captures opens at once and decodes nothing it has
+ * shown before. Activating a capture opens it in a TileViewWidget.
+ */
+
+#ifndef DATA_ANALYSIS_PAGE_H
+#define DATA_ANALYSIS_PAGE_H
+
+#include <QHash>
+#include <QImage>
+#include <QString>
+#include <QWidget>
+
+class QLabel;
+class QListWidget;
+class QListWidgetItem;
+class QTimer;
+class ThumbnailCache;
+class TileLoader;
+class TileViewWidget;
+
+/**
+ * @class DataAnalysisPage
+ * @brief Browse a capture folder and inspect single captures
+ */
+class DataAnalysisPage : public QWidget {
+    Q_OBJECT
+
+public:
+    explicit DataAnalysisPage(QWidget* parent = nullptr);
+    ~DataAnalysisPage() override;
+
+    QString folder() const { return m_folder; }
+
+public slots:
+    /**
+     * @brief List the captures (*.tif, *.tiff) of a folder
+     */
+    void openFolder(const QString& folder);
+
+    /**
+     * @brief Ask for a folder, then open it
+     */
+    void chooseFolder();
+
+    /**
+     * @brief Show one capture in the tiled viewer
+     */
+    void openCapture(const QString& path);
+
+private slots:
+    void requestVisibleThumbnails();
+    void thumbnailReady(const QString& path, const QImage& image);
+    void itemActivated(QListWidgetItem* item);
+    void captureOpened(const QString& path, int width, int height);
+    void captureFailed(const QString& path);
+
+private:
+    ThumbnailCache* m_thumbnails;
+    TileLoader* m_tiles;
+    QListWidget* m_list;
+    TileViewWidget* m_view;
+    QLabel* m_status;
+    QTimer* m_visibleTimer;         ///< Coalesces scroll and resize into one request pass
+    QString m_folder;
+    QHash<QString, QListWidgetItem*> m_items;
+};
+
+#endif // DATA_ANALYSIS_PAGE_H
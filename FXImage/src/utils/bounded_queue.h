@@ -0,0 +1,161 @@
+// ============================================================================
+// bounded_queue.h
+// ============================================================================
+
+/**
+ * @file bounded_queue.h
+ * @brief Bounded blocking queue between pipeline stages
+ * @version 2.1.0
+ *
+ * push() never blocks: a full queue drops either the pushed item or its
+ * oldest one, so a slow consumer can never stall the stage feeding it.
+ * Dropped items are destroyed outside the lock, which matters when their
+ * destructor hands a frame back to its pool.
+ */
+
+#ifndef BOUNDED_QUEUE_H
+#define BOUNDED_QUEUE_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <utility>
+
+template <typename T>
+class BoundedQueue {
+public:
+    /**
+     * @brief What push() drops when the queue is full
+     */
+    enum Overflow {
+        DROP_NEWEST = 0,    ///< The pushed item (work queues)
+        DROP_OLDEST         ///< The oldest queued item (display: latest wins)
+    };
+
+    explicit BoundedQueue(size_t capacity = 4, Overflow overflow = DROP_NEWEST)
+        : m_capacity(capacity > 0 ? capacity : 1),
+          m_overflow(overflow),
+          m_closed(false),
+          m_dropped(0),
+          m_highWater(0)
+    {}
+
+    /**
+     * @brief Set the capacity; queued items above it stay until popped
+     */
+    void setCapacity(size_t capacity) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_capacity = capacity > 0 ? capacity : 1;
+    }
+
+    /**
+     * @brief Queue an item
+     * @return false if an item was dropped to make room (or the queue is closed)
+     */
+    bool push(T item) {
+        T dropped;
+        bool accepted = true;
+        bool queued = false;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_closed) {
+                dropped = std::move(item);
+                accepted = false;
+            } else if (m_items.size() >= m_capacity && m_overflow == DROP_NEWEST) {
+                ++m_dropped;
+                dropped = std::move(item);
+                accepted = false;
+            } else {
+                if (m_items.size() >= m_capacity) {
+                    ++m_dropped;
+                    dropped = std::move(m_items.front());
+                    m_items.pop_front();
+                    accepted = false;
+                }
+                m_items.push_back(std::move(item));
+                if (m_items.size() > m_highWater) {
+                    m_highWater = m_items.size();
+                }
+                queued = true;
+            }
+        }
+        if (queued) {
+            m_ready.notify_one();
+        }
+        return accepted;
+    }
+
+    /**
+     * @brief Wait for an item
+     * @return false once the queue is closed and empty
+     */
+    bool pop(T& item) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_ready.wait(lock, [this] { return m_closed || !m_items.empty(); });
+        if (m_items.empty()) {
+            return false;
+        }
+        item = std::move(m_items.front());
+        m_items.pop_front();
+        return true;
+    }
+
+    /**
+     * @brief Wake all consumers; pop() drains what is left, then fails
+     */
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_closed = true;
+        }
+        m_ready.notify_all();
+    }
+
+    /**
+     * @brief Drop every queued item and accept pushes again
+     */
+    void reset() {
+        std::deque<T> items;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            items.swap(m_items);
+            m_closed = false;
+            m_dropped = 0;
+            m_highWater = 0;
+        }
+    }
+
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_items.size();
+    }
+
+    /// Items dropped because the queue was full
+    uint64_t dropped() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_dropped;
+    }
+
+    /// Most items queued at once since reset()
+    size_t highWater() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_highWater;
+    }
+
+private:
+    mutable std::mutex m_mutex;
+    std::condition_variable m_ready;
+    std::deque<T> m_items;
+    size_t m_capacity;
+    Overflow m_overflow;
+    bool m_closed;
+    uint64_t m_dropped;
+    size_t m_highWater;
+
+    // Non-copyable
+    BoundedQueue(const BoundedQueue&) = delete;
+    BoundedQueue& operator=(const BoundedQueue&) = delete;
+};
+
+#endif // BOUNDED_QUEUE_H
@@ -0,0 +1,686 @@
+// ============================================================================
+// config_manager.cpp
+// ============================================================================
+
+/**
+ * @file config_manager.cpp
+ * @brief Recipe file parsing and validation, and recipe switching
+ * @version 2.1.0
+ */
+
+#include "config_manager.h"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QXmlStreamReader>
+
+#include <algorithm>
+#include <new>
+#include <thread>
+
+#include "XDetector.h"
+#include "xog_correct.h"
+
+namespace {
+
+/// How a parameter addresses detector modules
+enum ModuleIndex {
+    MODULE_NONE,                    ///< Device-wide, no dm attribute
+    MODULE_ONE,                     ///< dm="N" or dm="N-M"
+    MODULE_ONE_OR_ALL               ///< As MODULE_ONE, or dm="all"
+};
+
+/**
+ * @brief A writable detector parameter and the values its field carries
+ */
+struct ParameterSpec {
+    const char* name;
+    HX::XControl::XCode code;
+    uint64_t minimum;
+    uint64_t maximum;
+    ModuleIndex modules;
+};
+
+// Every code XControl can write; maxima are the protocol field widths
+const ParameterSpec PARAMETERS[] = {
+    { "integration_time",   HX::XControl::XINT_TIME,      1, 0xFFFFFFFFull, MODULE_NONE },
+    { "non_integration_time", HX::XControl::XNON_INTTIME, 0, 0xFFFF,        MODULE_NONE },
+    { "operation_mode",     HX::XControl::XOPERATION,     0, 0xFF,          MODULE_NONE },
+    { "gain",               HX::XControl::XDM_GAIN,       0, 0xFFFF,        MODULE_ONE },
+    { "baseline",           HX::XControl::XBASE_LINE,     0, 0xFFFF,        MODULE_ONE_OR_ALL },
+    { "led",                HX::XControl::XLED,           0, 0xFF,          MODULE_NONE },
+    { "line_trigger",       HX::XControl::XLINE_TRIGGER,  0, 0xFF,          MODULE_NONE },
+    { "line_trigger_mode",  HX::XControl::XLINE_TR_MODE,  0, 0xFF,          MODULE_NONE },
+    { "frame_trigger",      HX::XControl::XFRAME_TRIGGER, 0, 0xFFFF,        MODULE_NONE },
+    { "frame_trigger_mode", HX::XControl::XFRAME_TR_MODE, 0, 0xFF,          MODULE_NONE },
+};
+
+const uint8_t ALL_MODULES = 0xFF;
+const uint32_t MAX_MODULE = 0xFE;
+
+const ParameterSpec* findParameter(const QString& name) {
+    for (size_t i = 0; i < sizeof(PARAMETERS) / sizeof(PARAMETERS[0]); ++i) {
+        if (name == QLatin1String(PARAMETERS[i].name)) {
+            return &PARAMETERS[i];
+        }
+    }
+    return nullptr;
+}
+
+bool fail(QXmlStreamReader& xml, const QString& message) {
+    xml.raiseError(message);
+    return false;
+}
+
+/**
+ * @brief Read an optional unsigned attribute (decimal or 0x hex)
+ * @return false, with the error raised, if it is malformed or out of range
+ */
+bool readNumber(QXmlStreamReader& xml, const char* name, uint64_t minimum, uint64_t maximum,
+                uint64_t& value) {
+    const QXmlStreamAttributes attributes = xml.attributes();
+    if (!attributes.hasAttribute(QLatin1String(name))) {
+        return true;
+    }
+    bool ok = false;
+    const uint64_t parsed = attributes.value(QLatin1String(name)).toString().trimmed().toULongLong(&ok, 0);
+    if (!ok || parsed < minimum || parsed > maximum) {
+        return fail(xml, QStringLiteral("%1 must be a number in [%2, %3]")
+                             .arg(QLatin1String(name)).arg(minimum).arg(maximum));
+    }
+    value = parsed;
+    return true;
+}
+
+bool readNumber(QXmlStreamReader& xml, const char* name, uint64_t minimum, uint64_t maximum,
+                uint32_t& value) {
+    uint64_t wide = value;
+    if (!readNumber(xml, name, minimum, maximum, wide)) {
+        return false;
+    }
+    value = static_cast<uint32_t>(wide);
+    return true;
+}
+
+bool readBool(QXmlStreamReader& xml, const char* name, bool& value) {
+    const QXmlStreamAttributes attributes = xml.attributes();
+    if (!attributes.hasAttribute(QLatin1String(name))) {
+        return true;
+    }
+    const QString text = attributes.value(QLatin1String(name)).toString().trimmed();
+    if (text == QLatin1String("true") || text == QLatin1String("1")) {
+        value = true;
+    } else if (text == QLatin1String("false") || text == QLatin1String("0")) {
+        value = false;
+    } else {
+        return fail(xml, QStringLiteral("%1 must be true or false").arg(QLatin1String(name)));
+    }
+    return true;
+}
+
+/**
+ * @brief Parse dm="N", dm="N-M" or dm="all" into module indices
+ */
+bool readModules(QXmlStreamReader& xml, const ParameterSpec& spec, std::vector<uint8_t>& modules) {
+    const QXmlStreamAttributes attributes = xml.attributes();
+    const bool present = attributes.hasAttribute(QLatin1String("dm"));
+    if (spec.modules == MODULE_NONE) {
+        if (present) {
+            return fail(xml, QStringLiteral("%1 applies to the whole detector; remove dm")
+                                 .arg(QLatin1String(spec.name)));
+        }
+        modules.push_back(0);
+        return true;
+    }
+    if (!present) {
+        return fail(xml, QStringLiteral("%1 needs a module: dm=\"N\", dm=\"N-M\"%2")
+                             .arg(QLatin1String(spec.name))
+                             .arg(spec.modules == MODULE_ONE_OR_ALL ? QStringLiteral(" or dm=\"all\"") : QString()));
+    }
+
+    const QString text = attributes.value(QLatin1String("dm")).toString().trimmed();
+    if (text == QLatin1String("all")) {
+        if (spec.modules != MODULE_ONE_OR_ALL) {
+            return fail(xml, QStringLiteral("%1 cannot be written to all modules at once; use dm=\"N-M\"")
+                                 .arg(QLatin1String(spec.name)));
+        }
+        modules.push_back(ALL_MODULES);
+        return true;
+    }
+
+    const QStringList bounds = text.split(QLatin1Char('-'));
+    bool okFirst = false;
+    bool okLast = bounds.size() == 1;
+    const uint32_t first = bounds.value(0).trimmed().toUInt(&okFirst);
+    const uint32_t last = bounds.size() == 2 ? bounds[1].trimmed().toUInt(&okLast) : first;
+    if (bounds.size() > 2 || !okFirst || !okLast || first < 1 || last > MAX_MODULE || first > last) {
+        return fail(xml, QStringLiteral("dm must be a module in [1, %1], a range N-M or all").arg(MAX_MODULE));
+    }
+    for (uint32_t module = first; module <= last; ++module) {
+        modules.push_back(static_cast<uint8_t>(module));
+    }
+    return true;
+}
+
+/**
+ * @brief Fail on any attribute outside the known set (catches typos)
+ */
+bool checkAttributes(QXmlStreamReader& xml, const char* const* known) {
+    const QXmlStreamAttributes attributes = xml.attributes();
+    for (int i = 0; i < attributes.size(); ++i) {
+        const QString name = attributes[i].name().toString();
+        bool found = false;
+        for (const char* const* k = known; *k && !found; ++k) {
+            found = name == QLatin1String(*k);
+        }
+        if (!found) {
+            return fail(xml, QStringLiteral("Unknown attribute %1 on <%2>").arg(name, xml.name().toString()));
+        }
+    }
+    return true;
+}
+
+uint32_t resolveWorkers(uint32_t workers) {
+    // As ImageProcessor::start(): one per core, minus one for acquisition
+    if (workers == 0) {
+        const unsigned cores = std::thread::hardware_concurrency();
+        workers = cores > 1 ? cores - 1 : 1;
+    }
+    return workers;
+}
+
+std::string pointKey(const hubx_operating_point_t& point) {
+    return std::string(point.serial ? point.serial : "") + '/' +
+           std::to_string(point.integrationTime) + '/' + std::to_string(point.gain) + '/' +
+           std::to_string(point.energyMode) + '/' + std::to_string(point.binning);
+}
+
+bool sameSettings(const AcquisitionController::Settings& a, const AcquisitionController::Settings& b) {
+    return a.linesPerFrame == b.linesPerFrame && a.segments == b.segments &&
+           a.lineHeader == b.lineHeader && a.poolSize == b.poolSize &&
+           a.correctionWorkers == b.correctionWorkers && a.correctionQueue == b.correctionQueue &&
+           a.displayQueue == b.displayQueue;
+}
+
+bool sameWrite(const HX::XControl::XItem& a, const HX::XControl::XItem& b) {
+    return a.code == b.code && a.index == b.index && a.val == b.val;
+}
+
+bool writes(const Recipe& recipe, const HX::XControl::XItem& item) {
+    const std::vector<HX::XControl::XItem>& items = recipe.writes();
+    for (size_t i = 0; i < items.size(); ++i) {
+        if (sameWrite(items[i], item)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+// ============================================================================
+// Calibration store
+// ============================================================================
+
+/**
+ * @brief Calibration cache and what it loads for each operating point
+ *
+ * An entry is a std::vector<hubx_xog_t*> with one loaded instance per
+ * correction worker of the largest recipe at that operating point.
+ */
+struct ConfigManager::Store {
+    struct Source {
+        std::string file;
+        uint32_t instances;
+    };
+
+    std::mutex mutex;                           ///< sources; the loader runs on cache threads
+    std::map<std::string, Source> sources;      ///< By pointKey()
+    hubx_calib_cache_t* cache;
+
+    Store() : cache(hubx_calib_cache_create(&Store::load, &Store::release, this)) {}
+    ~Store() { hubx_calib_cache_destroy(cache); }
+
+    static void* load(const hubx_operating_point_t* point, void* user, size_t* bytes) {
+        Store* store = static_cast<Store*>(user);
+        Source source;
+        {
+            std::lock_guard<std::mutex> lock(store->mutex);
+            std::map<std::string, Source>::const_iterator it = store->sources.find(pointKey(*point));
+            if (it == store->sources.end()) {
+                return nullptr;
+            }
+            source = it->second;
+        }
+
+        std::vector<hubx_xog_t*>* instances = new (std::nothrow) std::vector<hubx_xog_t*>();
+        if (!instances) {
+            return nullptr;
+        }
+        for (uint32_t i = 0; i < source.instances; ++i) {
+            hubx_xog_t* instance = hubx_xog_create();
+            if (!instance || hubx_xog_load(instance, source.file.c_str()) != 0) {
+                hubx_xog_destroy(instance);
+                release(instances, user);
+                return nullptr;
+            }
+            instances->push_back(instance);
+        }
+
+        // Offset, baseline and gain map per instance
+        int width = 0;
+        int height = 0;
+        hubx_xog_get_size(instances->front(), &width, &height);
+        *bytes = instances->size() * static_cast<size_t>(width) * height *
+                 (2 * sizeof(unsigned short) + sizeof(float));
+        return instances;
+    }
+
+    static void release(void* entry, void*) {
+        std::vector<hubx_xog_t*>* instances = static_cast<std::vector<hubx_xog_t*>*>(entry);
+        for (size_t i = 0; i < instances->size(); ++i) {
+            hubx_xog_destroy((*instances)[i]);
+        }
+        delete instances;
+    }
+};
+
+// ============================================================================
+// Recipe
+// ============================================================================
+
+Recipe::Recipe()
+    : m_displayLow(0),
+      m_displayHigh(0)
+{
+    m_point.serial = nullptr;
+    m_point.integrationTime = 0;
+    m_point.gain = 0;
+    m_point.energyMode = 0;
+    m_point.binning = 1;
+}
+
+// ============================================================================
+// ConfigManager
+// ============================================================================
+
+ConfigManager::ConfigManager()
+    : m_store(std::make_shared<Store>())
+{}
+
+ConfigManager::~ConfigManager() {
+}
+
+QString ConfigManager::defaultFile() {
+    return QDir(QCoreApplication::applicationDirPath()).filePath(QStringLiteral("config/default_config.xml"));
+}
+
+bool ConfigManager::load(const QString& file) {
+    QFile input(file);
+    if (!input.open(QIODevice::ReadOnly)) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_error = QStringLiteral("Cannot open %1: %2").arg(file, input.errorString());
+        return false;
+    }
+
+    QXmlStreamReader xml(&input);
+    std::map<QString, RecipePtr> recipes;
+    if (!parse(xml, QFileInfo(file).absolutePath(), recipes)) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_error = QStringLiteral("%1:%2: %3").arg(file).arg(xml.lineNumber()).arg(xml.errorString());
+        return false;
+    }
+
+    // What the cache loads for each operating point
+    std::map<std::string, Store::Source> sources;
+    for (std::map<QString, RecipePtr>::const_iterator it = recipes.begin(); it != recipes.end(); ++it) {
+        const Recipe& recipe = *it->second;
+        if (recipe.calibrationFile().empty()) {
+            continue;
+        }
+        Store::Source& source = sources[pointKey(recipe.operatingPoint())];
+        if (source.file.empty()) {
+            source.file = recipe.calibrationFile();
+            source.instances = 0;
+        } else if (source.file != recipe.calibrationFile()) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_error = QStringLiteral("%1: recipe %2 uses %3, but another recipe at the same "
+                                     "operating point uses %4")
+                          .arg(file, it->first, QString::fromStdString(recipe.calibrationFile()),
+                               QString::fromStdString(source.file));
+            return false;
+        }
+        source.instances = qMax(source.instances, recipe.acquisition().correctionWorkers);
+    }
+
+    // Operating points whose calibration changed are reloaded on next use
+    std::vector<std::string> changed;
+    {
+        std::lock_guard<std::mutex> lock(m_store->mutex);
+        for (std::map<std::string, Store::Source>::const_iterator it = m_store->sources.begin();
+             it != m_store->sources.end(); ++it) {
+            std::map<std::string, Store::Source>::const_iterator now = sources.find(it->first);
+            if (now == sources.end() || now->second.file != it->second.file ||
+                now->second.instances != it->second.instances) {
+                changed.push_back(it->first);
+            }
+        }
+        m_store->sources = sources;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (std::map<QString, RecipePtr>::const_iterator it = m_recipes.begin(); it != m_recipes.end(); ++it) {
+        const Recipe& recipe = *it->second;
+        if (!recipe.calibrationFile().empty() &&
+            std::find(changed.begin(), changed.end(), pointKey(recipe.operatingPoint())) != changed.end()) {
+            hubx_calib_cache_evict(m_store->cache, &recipe.operatingPoint());
+        }
+    }
+    m_recipes.swap(recipes);
+    m_error.clear();
+    return true;
+}
+
+QString ConfigManager::errorString() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_error;
+}
+
+QStringList ConfigManager::recipeNames() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    QStringList names;
+    for (std::map<QString, RecipePtr>::const_iterator it = m_recipes.begin(); it != m_recipes.end(); ++it) {
+        names << it->first;
+    }
+    return names;
+}
+
+ConfigManager::RecipePtr ConfigManager::recipe(const QString& name) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::map<QString, RecipePtr>::const_iterator it = m_recipes.find(name);
+    return it != m_recipes.end() ? it->second : RecipePtr();
+}
+
+ConfigManager::RecipePtr ConfigManager::current() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_current;
+}
+
+bool ConfigManager::apply(const RecipePtr& recipe, HX::XDetector& detector, HX::XControl& control,
+                          AcquisitionController& acquisition) {
+    if (!recipe) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_error.clear();
+    bool ok = true;
+
+    // Detector parameters: only what the last good apply did not write
+    std::vector<HX::XControl::XItem> items;
+    items.reserve(recipe->writes().size());
+    for (size_t i = 0; i < recipe->writes().size(); ++i) {
+        const HX::XControl::XItem& item = recipe->writes()[i];
+        if (!m_written || !writes(*m_written, item)) {
+            items.push_back(item);
+        }
+    }
+    if (!items.empty()) {
+        const int32_t written = control.WriteMany(items.data(), static_cast<uint32_t>(items.size()));
+        if (written != static_cast<int32_t>(items.size())) {
+            m_error = QStringLiteral("%1 of %2 detector parameters were not written")
+                          .arg(static_cast<int>(items.size()) - qMax(written, 0)).arg(items.size());
+            ok = false;
+        }
+    }
+    m_written = ok ? recipe : RecipePtr();
+
+    // Pipeline: restarted only for a new calibration, or new sizing while running
+    const bool sameCalibration = m_pipeline &&
+                                 m_pipeline->calibrationFile() == recipe->calibrationFile() &&
+                                 pointKey(m_pipeline->operatingPoint()) == pointKey(recipe->operatingPoint());
+    const bool sameSizing = m_pipeline && sameSettings(m_pipeline->acquisition(), recipe->acquisition());
+    if (!sameCalibration || (!sameSizing && acquisition.isRunning())) {
+        ImageProcessor::CalibrationSet calibration = sameCalibration ? m_calibration : ImageProcessor::CalibrationSet();
+        if (!calibration && !recipe->calibrationFile().empty()) {
+            calibration = acquireCalibration(*recipe);
+        }
+        if (recipe->calibrationFile().empty() || calibration) {
+            const bool running = acquisition.isRunning();
+            if (running) {
+                acquisition.stop();
+            }
+            if (calibration) {
+                acquisition.processor().setCalibration(calibration);
+            } else {
+                acquisition.processor().clearCalibration();
+            }
+            m_calibration = calibration;
+            m_pipeline = recipe;
+            if (running && !acquisition.start(detector, control, recipe->acquisition())) {
+                m_error = QStringLiteral("Acquisition did not restart");
+                ok = false;
+            }
+        } else {
+            m_error = QStringLiteral("Cannot load calibration %1")
+                          .arg(QString::fromStdString(recipe->calibrationFile()));
+            ok = false;
+        }
+    } else {
+        m_pipeline = recipe;
+    }
+
+    acquisition.setDisplayWindow(recipe->displayLow(), recipe->displayHigh());
+    m_current = ok ? recipe : RecipePtr();
+    return ok;
+}
+
+void ConfigManager::prefetch(const RecipePtr& recipe) {
+    if (recipe && !recipe->calibrationFile().empty()) {
+        hubx_calib_cache_prefetch(m_store->cache, &recipe->operatingPoint());
+    }
+}
+
+void ConfigManager::setCacheCapacity(int maxEntries, size_t maxBytes) {
+    hubx_calib_cache_set_capacity(m_store->cache, maxEntries, maxBytes);
+}
+
+bool ConfigManager::cacheStatistics(hubx_calib_cache_stats_t& stats) const {
+    return hubx_calib_cache_get_stats(m_store->cache, &stats) == 0;
+}
+
+ImageProcessor::CalibrationSet ConfigManager::acquireCalibration(const Recipe& recipe) {
+    void* entry = hubx_calib_cache_acquire(m_store->cache, &recipe.operatingPoint());
+    if (!entry) {
+        return ImageProcessor::CalibrationSet();
+    }
+    // The set may outlive this manager; it keeps the cache alive until released
+    std::shared_ptr<Store> store = m_store;
+    return ImageProcessor::CalibrationSet(static_cast<const std::vector<hubx_xog_t*>*>(entry),
+                                          [store](const std::vector<hubx_xog_t*>* instances) {
+        hubx_calib_cache_release(store->cache, const_cast<std::vector<hubx_xog_t*>*>(instances));
+    });
+}
+
+// ============================================================================
+// Parsing
+// ============================================================================
+
+bool ConfigManager::parse(QXmlStreamReader& xml, const QString& directory,
+                          std::map<QString, RecipePtr>& recipes) {
+    if (!xml.readNextStartElement() || xml.name() != QLatin1String("fximage")) {
+        return xml.hasError() ? false : fail(xml, QStringLiteral("Not an FXImage recipe file"));
+    }
+    while (xml.readNextStartElement()) {
+        if (xml.name() != QLatin1String("recipe")) {
+            return fail(xml, QStringLiteral("Unknown element <%1>").arg(xml.name().toString()));
+        }
+        RecipePtr recipe = parseRecipe(xml, directory);
+        if (!recipe) {
+            return false;
+        }
+        const QString name = QString::fromStdString(recipe->name());
+        if (recipes.count(name)) {
+            return fail(xml, QStringLiteral("Recipe %1 is defined twice").arg(name));
+        }
+        recipes[name] = recipe;
+    }
+    if (xml.hasError()) {
+        return false;
+    }
+    return recipes.empty() ? fail(xml, QStringLiteral("No recipes")) : true;
+}
+
+ConfigManager::RecipePtr ConfigManager::parseRecipe(QXmlStreamReader& xml, const QString& directory) {
+    static const char* const KNOWN[] = { "name", nullptr };
+    static const char* const NONE[] = { nullptr };
+    const QString name = xml.attributes().value(QLatin1String("name")).toString().trimmed();
+    if (!checkAttributes(xml, KNOWN)) {
+        return RecipePtr();
+    }
+    if (name.isEmpty()) {
+        fail(xml, QStringLiteral("Recipe without a name"));
+        return RecipePtr();
+    }
+
+    std::shared_ptr<Recipe> recipe(new Recipe());
+    recipe->m_name = name.toStdString();
+    AcquisitionController::Settings& settings = recipe->m_acquisition;
+
+    while (xml.readNextStartElement()) {
+        const QString element = xml.name().toString();
+        bool ok = true;
+        if (element == QLatin1String("detector")) {
+            ok = checkAttributes(xml, NONE) && parseDetector(xml, *recipe);
+        } else if (element == QLatin1String("acquisition")) {
+            static const char* const ACQUISITION[] = {
+                "lines_per_frame", "segments", "line_header", "pool_size", "display_queue", nullptr
+            };
+            ok = checkAttributes(xml, ACQUISITION) &&
+                 readNumber(xml, "lines_per_frame", 1, 65535, settings.linesPerFrame) &&
+                 readNumber(xml, "segments", 1, 64, settings.segments) &&
+                 readBool(xml, "line_header", settings.lineHeader) &&
+                 readNumber(xml, "pool_size", 3, 256, settings.poolSize) &&
+                 readNumber(xml, "display_queue", 1, 64, settings.displayQueue);
+            xml.skipCurrentElement();
+        } else if (element == QLatin1String("correction")) {
+            ok = parseCorrection(xml, directory, *recipe);
+        } else if (element == QLatin1String("display")) {
+            static const char* const DISPLAY[] = { "low", "high", nullptr };
+            ok = checkAttributes(xml, DISPLAY) &&
+                 readNumber(xml, "low", 0, 0xFFFF, recipe->m_displayLow) &&
+                 readNumber(xml, "high", 0, 0xFFFF, recipe->m_displayHigh);
+            if (ok && recipe->m_displayLow > recipe->m_displayHigh) {
+                ok = fail(xml, QStringLiteral("Display low is above high"));
+            }
+            xml.skipCurrentElement();
+        } else {
+            ok = fail(xml, QStringLiteral("Unknown element <%1> in recipe %2").arg(element, name));
+        }
+        if (!ok || xml.hasError()) {
+            return RecipePtr();
+        }
+    }
+    if (xml.hasError()) {
+        return RecipePtr();
+    }
+    settings.correctionWorkers = resolveWorkers(settings.correctionWorkers);
+
+    // The calibration belongs to the integration time and gain the recipe writes
+    if (!recipe->m_calibrationFile.empty()) {
+        bool timed = false;
+        bool gained = false;
+        for (size_t i = 0; i < recipe->m_writes.size(); ++i) {
+            const HX::XControl::XItem& item = recipe->m_writes[i];
+            if (item.code == HX::XControl::XINT_TIME && !timed) {
+                recipe->m_point.integrationTime = static_cast<uint32_t>(item.val);
+                timed = true;
+            } else if (item.code == HX::XControl::XDM_GAIN && !gained) {
+                recipe->m_point.gain = static_cast<uint32_t>(item.val);
+                gained = true;
+            }
+        }
+        if (!timed || !gained) {
+            fail(xml, QStringLiteral("Recipe %1 has a calibration but does not set integration_time and gain")
+                          .arg(name));
+            return RecipePtr();
+        }
+    }
+    recipe->m_point.serial = recipe->m_serial.empty() ? nullptr : recipe->m_serial.c_str();
+    return recipe;
+}
+
+bool ConfigManager::parseDetector(QXmlStreamReader& xml, Recipe& recipe) {
+    static const char* const KNOWN[] = { "name", "dm", "value", nullptr };
+    while (xml.readNextStartElement()) {
+        if (xml.name() != QLatin1String("param")) {
+            return fail(xml, QStringLiteral("Unknown element <%1> in <detector>").arg(xml.name().toString()));
+        }
+        if (!checkAttributes(xml, KNOWN)) {
+            return false;
+        }
+        const QString name = xml.attributes().value(QLatin1String("name")).toString().trimmed();
+        const ParameterSpec* spec = findParameter(name);
+        if (!spec) {
+            return fail(xml, QStringLiteral("Unknown detector parameter \"%1\"").arg(name));
+        }
+        if (!xml.attributes().hasAttribute(QLatin1String("value"))) {
+            return fail(xml, QStringLiteral("%1 has no value").arg(name));
+        }
+        uint64_t value = 0;
+        std::vector<uint8_t> modules;
+        if (!readNumber(xml, "value", spec->minimum, spec->maximum, value) ||
+            !readModules(xml, *spec, modules)) {
+            return false;
+        }
+
+        for (size_t i = 0; i < modules.size(); ++i) {
+            for (size_t j = 0; j < recipe.m_writes.size(); ++j) {
+                if (recipe.m_writes[j].code == spec->code && recipe.m_writes[j].index == modules[i]) {
+                    return fail(xml, QStringLiteral("%1 is set twice").arg(name));
+                }
+            }
+            HX::XControl::XItem item;
+            item.code = spec->code;
+            item.index = modules[i];
+            item.val = value;
+            item.result = 0;
+            recipe.m_writes.push_back(item);
+        }
+        xml.skipCurrentElement();
+    }
+    return !xml.hasError();
+}
+
+bool ConfigManager::parseCorrection(QXmlStreamReader& xml, const QString& directory, Recipe& recipe) {
+    static const char* const CORRECTION[] = { "workers", "queue", nullptr };
+    static const char* const CALIBRATION[] = { "file", "serial", "energy_mode", "binning", nullptr };
+    AcquisitionController::Settings& settings = recipe.m_acquisition;
+    if (!checkAttributes(xml, CORRECTION) ||
+        !readNumber(xml, "workers", 0, 64, settings.correctionWorkers) ||
+        !readNumber(xml, "queue", 1, 1024, settings.correctionQueue)) {
+        return false;
+    }
+
+    while (xml.readNextStartElement()) {
+        if (xml.name() != QLatin1String("calibration") || !recipe.m_calibrationFile.empty()) {
+            return fail(xml, QStringLiteral("<correction> takes one <calibration>"));
+        }
+        if (!checkAttributes(xml, CALIBRATION) ||
+            !readNumber(xml, "energy_mode", 0, 0xFF, recipe.m_point.energyMode) ||
+            !readNumber(xml, "binning", 1, 0xFF, recipe.m_point.binning)) {
+            return false;
+        }
+        const QString file = xml.attributes().value(QLatin1String("file")).toString().trimmed();
+        if (file.isEmpty()) {
+            return fail(xml, QStringLiteral("<calibration> needs a file"));
+        }
+        // Relative to the recipe file; existence is checked when the calibration loads
+        const QString path = QDir::cleanPath(QDir(directory).absoluteFilePath(file));
+        recipe.m_calibrationFile = path.toLocal8Bit().constData();
+        recipe.m_serial = xml.attributes().value(QLatin1String("serial")).toString().trimmed().toStdString();
+        xml.skipCurrentElement();
+    }
+    return !xml.hasError();
+}
@@ -0,0 +1,178 @@
+// ============================================================================
+// config_manager.h
+// ============================================================================
+
+/**
+ * @file config_manager.h
+ * @brief Recipes: detector parameters and pipeline setup, compiled at load
+ * @version 2.1.0
+ *
+ * A recipe file (config/default_config.xml) is parsed and validated once;
+ * each recipe in it becomes an immutable Recipe holding the XControl
+ * writes, ready for WriteMany(), and the pipeline settings already
+ * resolved. Switching recipes is one apply() call: the parameters that
+ * differ from the applied recipe go out in one batched write, and the
+ * calibration comes from a calibration cache keyed by operating point,
+ * so a recipe used before switches without reading its calibration file.
+ */
+
+#ifndef CONFIG_MANAGER_H
+#define CONFIG_MANAGER_H
+
+#include <QString>
+#include <QStringList>
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "XControl.h"
+#include "calibration_cache.h"
+
+#include "controllers/acquisition_controller.h"
+
+class QXmlStreamReader;
+
+namespace HX {
+class XDetector;
+}
+
+/**
+ * @class Recipe
+ * @brief One compiled recipe; created only by ConfigManager::load()
+ */
+class Recipe {
+public:
+    const std::string& name() const { return m_name; }
+
+    /// Detector parameters in file order, validated against the protocol
+    const std::vector<HX::XControl::XItem>& writes() const { return m_writes; }
+
+    /// Pipeline sizing, correction workers resolved to a thread count
+    const AcquisitionController::Settings& acquisition() const { return m_acquisition; }
+
+    /// Calibration file (absolute), empty to run uncorrected
+    const std::string& calibrationFile() const { return m_calibrationFile; }
+
+    /// Calibration cache key; meaningful when calibrationFile() is set
+    const hubx_operating_point_t& operatingPoint() const { return m_point; }
+
+    /// Display window; low == high selects the full range
+    uint32_t displayLow() const { return m_displayLow; }
+    uint32_t displayHigh() const { return m_displayHigh; }
+
+private:
+    friend class ConfigManager;
+
+    Recipe();
+
+    std::string m_name;
+    std::vector<HX::XControl::XItem> m_writes;
+    AcquisitionController::Settings m_acquisition;
+    std::string m_calibrationFile;
+    std::string m_serial;               ///< Storage of m_point.serial
+    hubx_operating_point_t m_point;
+    uint32_t m_displayLow;
+    uint32_t m_displayHigh;
+
+    // Non-copyable: m_point points into m_serial
+    Recipe(const Recipe&) = delete;
+    Recipe& operator=(const Recipe&) = delete;
+};
+
+/**
+ * @class ConfigManager
+ * @brief Recipe set of a configuration file, and the applied recipe
+ */
+class ConfigManager {
+public:
+    typedef std::shared_ptr<const Recipe> RecipePtr;
+
+    ConfigManager();
+    ~ConfigManager();
+
+    /// config/default_config.xml next to the executable
+    static QString defaultFile();
+
+    /**
+     * @brief Parse and compile every recipe of a file
+     * @param file Recipe file
+     * @return true on success; on failure the loaded recipes are kept and
+     *         errorString() names the line and the problem
+     * @note Recipes handed out before stay valid
+     */
+    bool load(const QString& file);
+
+    /// Why the last load() or apply() failed
+    QString errorString() const;
+
+    QStringList recipeNames() const;
+
+    /**
+     * @brief A compiled recipe by name, or nullptr
+     */
+    RecipePtr recipe(const QString& name) const;
+
+    /**
+     * @brief Switch the detector and the pipeline to a recipe
+     * @param recipe Compiled recipe
+     * @param detector Detector to acquire from
+     * @param control Open command channel of the detector
+     * @param acquisition Pipeline; if it runs and the recipe changes its
+     *                    calibration or sizing, it is stopped and restarted
+     * @return true if every write succeeded and the pipeline runs the
+     *         recipe's calibration
+     *
+     * Only parameters differing from the last applied recipe are written,
+     * in one WriteMany(); after a failed write everything is written again
+     * next time. Without a calibration file the pipeline runs uncorrected.
+     */
+    bool apply(const RecipePtr& recipe, HX::XDetector& detector, HX::XControl& control,
+               AcquisitionController& acquisition);
+
+    /// Last recipe applied without error, or nullptr
+    RecipePtr current() const;
+
+    /**
+     * @brief Load a recipe's calibration in the background
+     * @note Call ahead of apply() for a switch that never waits on disk
+     */
+    void prefetch(const RecipePtr& recipe);
+
+    /**
+     * @brief Calibration sets kept loaded
+     * @param maxEntries Operating points resident at once
+     * @param maxBytes Memory budget (0 = no limit)
+     */
+    void setCacheCapacity(int maxEntries, size_t maxBytes);
+
+    bool cacheStatistics(hubx_calib_cache_stats_t& stats) const;
+
+private:
+    struct Store;
+
+    static bool parse(QXmlStreamReader& xml, const QString& directory,
+                      std::map<QString, RecipePtr>& recipes);
+    static RecipePtr parseRecipe(QXmlStreamReader& xml, const QString& directory);
+    static bool parseDetector(QXmlStreamReader& xml, Recipe& recipe);
+    static bool parseCorrection(QXmlStreamReader& xml, const QString& directory, Recipe& recipe);
+    ImageProcessor::CalibrationSet acquireCalibration(const Recipe& recipe);
+
+    mutable std::mutex m_mutex;             ///< Everything below; held through apply()
+    std::shared_ptr<Store> m_store;         ///< Shared with calibration sets in use
+    std::map<QString, RecipePtr> m_recipes;
+    RecipePtr m_current;
+    RecipePtr m_written;                    ///< Recipe the detector parameters are known to match
+    RecipePtr m_pipeline;                   ///< Recipe the pipeline calibration comes from
+    ImageProcessor::CalibrationSet m_calibration;   ///< Set of m_pipeline, if any
+    QString m_error;
+
+    // Non-copyable
+    ConfigManager(const ConfigManager&) = delete;
+    ConfigManager& operator=(const ConfigManager&) = delete;
+};
+
+#endif // CONFIG_MANAGER_H
@@ -0,0 +1,149 @@
+// ============================================================================
+// file_manager.cpp
+// ============================================================================
+
+/**
+ * @file file_manager.cpp
+ * @brief Sequence start/stop and the memory budget in front of XRecorder
+ * @version 2.1.0
+ */
+
+#include "file_manager.h"
+
+#include "XImage.h"
+
+namespace {
+
+// Recorder queue slots; the memory budget is what limits the queue
+const uint32_t RECORDER_QUEUE = 1024;
+
+uint64_t frameBytes(const HX::XImage& image) {
+    return static_cast<uint64_t>(image._width) * ((image._pixel_depth + 7) / 8) * image._height;
+}
+
+} // namespace
+
+FileManager::FileManager(QObject* parent)
+    : QObject(parent),
+      m_active(false),
+      m_finishing(false),
+      m_framesRequested(0),
+      m_memoryBudget(0),
+      m_framesAccepted(0),
+      m_budgetDropped(0),
+      m_frameBytes(0)
+{}
+
+FileManager::~FileManager() {
+    stopSequence();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    joinCloser();
+}
+
+void FileManager::setSettings(const Settings& settings) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_settings = settings;
+}
+
+FileManager::Settings FileManager::settings() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_settings;
+}
+
+bool FileManager::startSequence(const QString& directory, const QString& prefix, uint32_t frames) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_active || m_finishing) {
+        return false;
+    }
+    joinCloser();
+
+    m_recorder.SetQueueDepth(RECORDER_QUEUE);
+    m_recorder.SetQueuePolicy(HX::XRecorder::QUEUE_DROP_NEWEST);
+    m_recorder.SetDirectIO(m_settings.directIO);
+    m_recorder.SetIndexing(m_settings.indexing);
+    if (!m_recorder.Start(directory.toLocal8Bit().constData(), prefix.toLocal8Bit().constData())) {
+        return false;
+    }
+
+    m_framesRequested = frames;
+    m_memoryBudget = m_settings.memoryBudget;
+    m_framesAccepted = 0;
+    m_budgetDropped = 0;
+    m_frameBytes = 0;
+    m_active = true;
+    return true;
+}
+
+void FileManager::stopSequence() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_active) {
+        return;
+    }
+    m_active = false;
+    m_finishing = true;
+    joinCloser();
+    m_closer = std::thread(&FileManager::finishSequence, this);
+}
+
+bool FileManager::saveFrame(HX::XImage* image) {
+    if (!m_active || !image || !image->_data_) {
+        return false;
+    }
+    if (m_framesRequested > 0 && m_framesAccepted >= m_framesRequested) {
+        return false;
+    }
+
+    // Frames queued plus the one being written each hold a copy buffer
+    const uint64_t bytes = frameBytes(*image);
+    m_frameBytes = bytes;
+    const HX::XRecorder::Statistics recorder = m_recorder.GetStatistics();
+    if ((static_cast<uint64_t>(recorder.queued) + 2) * bytes > m_memoryBudget) {
+        m_budgetDropped++;
+        return false;
+    }
+
+    if (!m_recorder.Submit(image)) {
+        return false;
+    }
+    const uint64_t accepted = ++m_framesAccepted;
+    if (m_framesRequested > 0 && accepted == m_framesRequested) {
+        stopSequence();
+    }
+    return true;
+}
+
+FileManager::Status FileManager::status() const {
+    const HX::XRecorder::Statistics recorder = m_recorder.GetStatistics();
+
+    Status status;
+    status.active = m_active;
+    status.finishing = m_finishing;
+    status.framesAccepted = m_framesAccepted;
+    status.framesWritten = recorder.framesWritten;
+    status.framesDropped = recorder.framesDropped + m_budgetDropped;
+    status.writeErrors = recorder.writeErrors;
+    status.queued = recorder.queued;
+    status.queuedBytes = static_cast<uint64_t>(recorder.queued) * m_frameBytes;
+    status.averageMBps = recorder.averageMBps;
+    status.diskMBps = recorder.diskMBps;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        status.framesRequested = m_framesRequested;
+        status.memoryBudget = m_memoryBudget;
+    }
+    return status;
+}
+
+void FileManager::finishSequence() {
+    m_recorder.Stop();
+    const HX::XRecorder::Statistics recorder = m_recorder.GetStatistics();
+    m_finishing = false;
+    emit sequenceFinished(recorder.framesWritten, recorder.framesDropped + m_budgetDropped,
+                          recorder.writeErrors);
+}
+
+void FileManager::joinCloser() {
+    if (m_closer.joinable()) {
+        m_closer.join();
+    }
+}
@@ -0,0 +1,133 @@
+// ============================================================================
+// file_manager.h
+// ============================================================================
+
+/**
+ * @file file_manager.h
+ * @brief Frame sequences saved in the background through XRecorder
+ * @version 2.1.0
+ *
+ * saveFrame() copies the frame into one of the recorder's queue buffers
+ * and returns; the recorder's writer thread does the disk I/O. The copy
+ * buffers are allocated as the queue fills, and a frame that would take
+ * them past the memory budget is dropped instead, so a slow disk costs
+ * frames rather than memory or time on the calling thread. Finishing a
+ * sequence drains the queue on a helper thread, never on the caller.
+ */
+
+#ifndef FILE_MANAGER_H
+#define FILE_MANAGER_H
+
+#include <QObject>
+#include <QString>
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+#include "XRecorder.h"
+
+namespace HX {
+class XImage;
+}
+
+/**
+ * @class FileManager
+ * @brief Bounded-memory "save sequence" writer
+ */
+class FileManager : public QObject {
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Writer options, fixed for one sequence
+     */
+    struct Settings {
+        uint64_t memoryBudget;      ///< Most bytes of frames waiting for the disk
+        bool directIO;              ///< Bypass the page cache where the file system allows
+        bool indexing;              ///< Add every file to the directory's metadata index
+
+        Settings()
+            : memoryBudget(256ull * 1024 * 1024),
+              directIO(true),
+              indexing(false)
+        {}
+    };
+
+    /**
+     * @brief Sequence progress, for the info bar
+     */
+    struct Status {
+        bool active;                ///< Accepting frames
+        bool finishing;             ///< Draining the queue after the sequence ended
+        uint32_t framesRequested;   ///< Sequence length (0 = until stopSequence())
+        uint64_t framesAccepted;    ///< Frames queued for writing
+        uint64_t framesWritten;     ///< Files completed
+        uint64_t framesDropped;     ///< Frames refused: budget or recorder queue full
+        uint64_t writeErrors;       ///< Files that could not be written
+        uint32_t queued;            ///< Frames waiting for the disk now
+        uint64_t queuedBytes;       ///< Memory those frames hold
+        uint64_t memoryBudget;
+        double averageMBps;         ///< Throughput since the sequence started
+        double diskMBps;            ///< Throughput while writing
+    };
+
+    explicit FileManager(QObject* parent = nullptr);
+    ~FileManager() override;
+
+    void setSettings(const Settings& settings);
+    Settings settings() const;
+
+    /**
+     * @brief Start writing frames passed to saveFrame()
+     * @param directory Existing output directory
+     * @param prefix File name prefix; files are <prefix>_000000.tif, ...
+     * @param frames Frames to save before the sequence ends by itself (0 = no limit)
+     * @return false if a sequence is active or still finishing, or the recorder failed to start
+     */
+    bool startSequence(const QString& directory, const QString& prefix, uint32_t frames = 0);
+
+    /**
+     * @brief End the sequence; queued frames are still written
+     * @note Returns at once; sequenceFinished() follows once the queue is empty
+     */
+    void stopSequence();
+
+    bool isActive() const { return m_active; }
+
+    /**
+     * @brief Queue a copy of a frame (any thread, never waits for the disk)
+     * @return true if queued, false if inactive or over the memory budget
+     */
+    bool saveFrame(HX::XImage* image);
+
+    Status status() const;
+
+signals:
+    /// The last queued frame is on disk (emitted on the helper thread)
+    void sequenceFinished(quint64 written, quint64 dropped, quint64 errors);
+
+private:
+    void finishSequence();
+    void joinCloser();
+
+    HX::XRecorder m_recorder;
+    Settings m_settings;
+    mutable std::mutex m_mutex;             ///< Sequence state changes
+    std::thread m_closer;                   ///< Runs XRecorder::Stop() off the caller's thread
+
+    std::atomic<bool> m_active;
+    std::atomic<bool> m_finishing;
+    uint32_t m_framesRequested;
+    uint64_t m_memoryBudget;                ///< Settings::memoryBudget of this sequence
+    std::atomic<uint64_t> m_framesAccepted;
+    std::atomic<uint64_t> m_budgetDropped;
+    std::atomic<uint64_t> m_frameBytes;     ///< Size of the last frame saved
+
+    // Non-copyable
+    FileManager(const FileManager&) = delete;
+    FileManager& operator=(const FileManager&) = delete;
+};
+
+#endif // FILE_MANAGER_H
@@ -0,0 +1,143 @@
+// ============================================================================
+// gray_sampler.cpp
+// ============================================================================
+
+/**
+ * @file gray_sampler.cpp
+ * @brief Sparse windowing and reduced rendering of raw pixels
+ * @version 2.1.0
+ */
+
+#include "gray_sampler.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "XFile.h"
+
+namespace {
+
+// Grid of the window sample, per axis
+const uint32_t WINDOW_SAMPLES = 256;
+
+inline uint32_t pixelAt(const GraySource& source, uint32_t x, uint32_t y) {
+    const uint8_t* row = source.pixels + static_cast<size_t>(y) * source.stride;
+    switch (source.depth) {
+    case 8:
+        return row[x];
+    case 16:
+        return reinterpret_cast<const uint16_t*>(row)[x];
+    default:
+        return reinterpret_cast<const uint32_t*>(row)[x];
+    }
+}
+
+} // namespace
+
+GrayFile::GrayFile()
+    : m_file(new HX::XFile())
+{}
+
+GrayFile::~GrayFile() {
+}
+
+bool GrayFile::open(const QString& path) {
+    m_source = GraySource();
+    if (!m_file->Map(path.toLocal8Bit().constData())) {
+        return false;
+    }
+
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t depth = 0;
+    uint8_t* pixels = nullptr;
+    if (!m_file->Get(HX::XFile::XF_COLS, width) || !m_file->Get(HX::XFile::XF_ROWS, height) ||
+        !m_file->Get(HX::XFile::XF_DEPTH, depth) || !m_file->Get(HX::XFile::XF_DATA, &pixels)) {
+        return false;
+    }
+
+    GraySource source;
+    source.pixels = pixels;
+    source.width = width;
+    source.height = height;
+    source.depth = static_cast<uint8_t>(depth);
+    source.stride = width * ((depth + 7) / 8);
+    if (!source.isValid()) {
+        return false;
+    }
+    m_source = source;
+    return true;
+}
+
+void autoWindow(const GraySource& source, uint32_t& low, uint32_t& high) {
+    low = 0;
+    high = 0;
+    if (!source.isValid()) {
+        return;
+    }
+
+    const uint32_t cols = std::min(source.width, WINDOW_SAMPLES);
+    const uint32_t rows = std::min(source.height, WINDOW_SAMPLES);
+    std::vector<uint32_t> samples;
+    samples.reserve(static_cast<size_t>(cols) * rows);
+    for (uint32_t r = 0; r < rows; ++r) {
+        const uint32_t y = static_cast<uint32_t>((static_cast<uint64_t>(r) * 2 + 1) * source.height / (rows * 2));
+        for (uint32_t c = 0; c < cols; ++c) {
+            const uint32_t x = static_cast<uint32_t>((static_cast<uint64_t>(c) * 2 + 1) * source.width / (cols * 2));
+            samples.push_back(pixelAt(source, x, y));
+        }
+    }
+
+    const size_t lowIndex = samples.size() / 200;
+    const size_t highIndex = samples.size() - 1 - lowIndex;
+    std::nth_element(samples.begin(), samples.begin() + lowIndex, samples.end());
+    low = samples[lowIndex];
+    std::nth_element(samples.begin(), samples.begin() + highIndex, samples.end());
+    high = samples[highIndex];
+}
+
+QImage renderGray(const GraySource& source, const QRect& region, const QSize& size,
+                  uint32_t low, uint32_t high) {
+    const QRect bounds = region.intersected(QRect(0, 0, static_cast<int>(source.width),
+                                                  static_cast<int>(source.height)));
+    if (!source.isValid() || bounds.isEmpty() || size.isEmpty()) {
+        return QImage();
+    }
+
+    QImage image(size, QImage::Format_Grayscale8);
+    if (image.isNull()) {
+        return QImage();
+    }
+    if (high <= low) {
+        high = low + 1;
+    }
+    const uint64_t range = high - low;
+
+    // Source column (and row) of each output pixel's centre, 16.16 fixed point
+    const uint64_t stepX = (static_cast<uint64_t>(bounds.width()) << 16) / size.width();
+    const uint64_t stepY = (static_cast<uint64_t>(bounds.height()) << 16) / size.height();
+    const bool average = stepX >= (2u << 16) && stepY >= (2u << 16);
+    std::vector<uint32_t> columns(size.width());
+    for (int c = 0; c < size.width(); ++c) {
+        const uint32_t x = static_cast<uint32_t>(bounds.x() + ((stepX * c + stepX / 2) >> 16));
+        columns[c] = std::min(x, source.width - (average ? 2 : 1));
+    }
+
+    for (int r = 0; r < size.height(); ++r) {
+        uint32_t y = static_cast<uint32_t>(bounds.y() + ((stepY * r + stepY / 2) >> 16));
+        y = std::min(y, source.height - (average ? 2 : 1));
+        uchar* out = image.scanLine(r);
+        for (int c = 0; c < size.width(); ++c) {
+            const uint32_t x = columns[c];
+            uint32_t value = pixelAt(source, x, y);
+            if (average) {
+                const uint64_t sum = static_cast<uint64_t>(value) + pixelAt(source, x + 1, y) +
+                                     pixelAt(source, x, y + 1) + pixelAt(source, x + 1, y + 1);
+                value = static_cast<uint32_t>(sum / 4);
+            }
+            out[c] = value <= low ? 0 : value >= high ? 255
+                                      : static_cast<uchar>((value - low) * 255 / range);
+        }
+    }
+    return image;
+}
@@ -0,0 +1,89 @@
+// ============================================================================
+// gray_sampler.h
+// ============================================================================
+
+/**
+ * @file gray_sampler.h
+ * @brief Reduced 8-bit views of a raw image, for thumbnails and tiles
+ * @version 2.1.0
+ *
+ * Only the pixels that land in the output are read, so the cost follows
+ * the output size, not the image size; on a mapped file the rows that are
+ * skipped are never paged in.
+ */
+
+#ifndef GRAY_SAMPLER_H
+#define GRAY_SAMPLER_H
+
+#include <QImage>
+#include <QRect>
+#include <QSize>
+#include <QString>
+
+#include <cstdint>
+#include <memory>
+
+namespace HX {
+class XFile;
+}
+
+/**
+ * @brief Raw pixels of a read or mapped file (not owned)
+ */
+struct GraySource {
+    const uint8_t* pixels;
+    uint32_t width;
+    uint32_t height;
+    uint32_t stride;            ///< Bytes per row
+    uint8_t depth;              ///< 8, 16 or 32 bits per pixel
+
+    GraySource() : pixels(nullptr), width(0), height(0), stride(0), depth(0) {}
+    bool isValid() const { return pixels && width > 0 && height > 0 && (depth == 8 || depth == 16 || depth == 32); }
+};
+
+/**
+ * @class GrayFile
+ * @brief A capture opened with XFile::Map(), as a GraySource
+ */
+class GrayFile {
+public:
+    GrayFile();
+    ~GrayFile();
+
+    /**
+     * @brief Map a file XFile can read
+     * @return false if it cannot be read or its depth is not 8, 16 or 32 bits
+     */
+    bool open(const QString& path);
+
+    /// Pixels, valid until the next open() or destruction
+    const GraySource& source() const { return m_source; }
+
+private:
+    std::unique_ptr<HX::XFile> m_file;
+    GraySource m_source;
+
+    // Non-copyable
+    GrayFile(const GrayFile&) = delete;
+    GrayFile& operator=(const GrayFile&) = delete;
+};
+
+/**
+ * @brief Display window from a sparse sample of the image
+ * @param source Image
+ * @param low,high Receive the 0.5 and 99.5 percentiles
+ */
+void autoWindow(const GraySource& source, uint32_t& low, uint32_t& high);
+
+/**
+ * @brief Render a region of the image, reduced, into an 8-bit image
+ * @param source Image
+ * @param region Region, in image pixels
+ * @param size Output size; when reducing by 2 or more, each output pixel
+ *             averages the 2x2 source pixels at its centre
+ * @param low,high Window mapped to 0..255
+ */
+QImage renderGray(const GraySource& source, const QRect& region, const QSize& size,
+                  uint32_t low, uint32_t high);
+
+#endif // GRAY_SAMPLER_H
@@ -0,0 +1,72 @@
+// ============================================================================
+// image_pool.cpp
+// ============================================================================
+
+/**
+ * @file image_pool.cpp
+ * @brief ImagePool free list
+ * @version 2.1.0
+ */
+
+#include "image_pool.h"
+
+#include "XImage.h"
+
+ImagePool::State::~State() {
+    for (size_t i = 0; i < free.size(); ++i) {
+        delete free[i];
+    }
+}
+
+ImagePool::ImagePool(uint32_t capacity, uint32_t rowAlign)
+    : m_state(std::make_shared<State>())
+{
+    m_state->capacity = capacity > 0 ? capacity : 1;
+    m_state->rowAlign = rowAlign;
+    m_state->inUse = 0;
+}
+
+ImagePool::~ImagePool() {
+}
+
+std::shared_ptr<HX::XImage> ImagePool::acquire(uint32_t width, uint32_t height, uint8_t pixelDepth) {
+    HX::XImage* image = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(m_state->mutex);
+        if (m_state->inUse >= m_state->capacity) {
+            return std::shared_ptr<HX::XImage>();
+        }
+        if (!m_state->free.empty()) {
+            image = m_state->free.back();
+            m_state->free.pop_back();
+        }
+        m_state->inUse++;
+    }
+
+    if (!image) {
+        image = new HX::XImage();
+    }
+    if (image->_width != width || image->_height != height || image->_pixel_depth != pixelDepth ||
+        !image->_data_) {
+        if (!image->Allocate(width, height, pixelDepth, m_state->rowAlign)) {
+            delete image;
+            std::lock_guard<std::mutex> lock(m_state->mutex);
+            m_state->inUse--;
+            return std::shared_ptr<HX::XImage>();
+        }
+    }
+
+    std::shared_ptr<State> state = m_state;
+    return std::shared_ptr<HX::XImage>(image, [state](HX::XImage* p) { recycle(state, p); });
+}
+
+uint32_t ImagePool::inUse() const {
+    std::lock_guard<std::mutex> lock(m_state->mutex);
+    return m_state->inUse;
+}
+
+void ImagePool::recycle(const std::shared_ptr<State>& state, HX::XImage* image) {
+    std::lock_guard<std::mutex> lock(state->mutex);
+    state->inUse--;
+    state->free.push_back(image);
+}
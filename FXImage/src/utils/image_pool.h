@@ -0,0 +1,73 @@
+// ============================================================================
+// image_pool.h
+// ============================================================================
+
+/**
+ * @file image_pool.h
+ * @brief Recycled XImage buffers handed out as shared pointers
+ * @version 2.1.0
+ *
+ * acquire() returns a buffer of the requested geometry; dropping the last
+ * pointer puts it back for the next acquire(). The free list lives in
+ * shared state the pointers keep alive, so buffers may outlive the pool
+ * (a QImage still on screen after the controller stopped).
+ */
+
+#ifndef IMAGE_POOL_H
+#define IMAGE_POOL_H
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace HX {
+class XImage;
+}
+
+/**
+ * @class ImagePool
+ * @brief Bounded set of reusable XImage buffers
+ */
+class ImagePool {
+public:
+    /**
+     * @param capacity Most buffers handed out at once
+     * @param rowAlign Row stride multiple in bytes (4 keeps QImage scanlines aligned)
+     */
+    explicit ImagePool(uint32_t capacity = 4, uint32_t rowAlign = 4);
+    ~ImagePool();
+
+    /**
+     * @brief Get a buffer of the given geometry
+     * @return Buffer, or nullptr if capacity buffers are already out
+     *
+     * @note A free buffer of another geometry is reallocated, so changing
+     *       the frame size costs one allocation per buffer, once.
+     */
+    std::shared_ptr<HX::XImage> acquire(uint32_t width, uint32_t height, uint8_t pixelDepth);
+
+    /// Buffers handed out now
+    uint32_t inUse() const;
+
+private:
+    struct State {
+        std::mutex mutex;
+        std::vector<HX::XImage*> free;
+        uint32_t capacity;
+        uint32_t rowAlign;
+        uint32_t inUse;
+
+        ~State();
+    };
+
+    static void recycle(const std::shared_ptr<State>& state, HX::XImage* image);
+
+    std::shared_ptr<State> m_state;
+
+    // Non-copyable
+    ImagePool(const ImagePool&) = delete;
+    ImagePool& operator=(const ImagePool&) = delete;
+};
+
+#endif // IMAGE_POOL_H
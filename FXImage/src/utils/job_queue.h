@@ -0,0 +1,120 @@
+// ============================================================================
+// job_queue.h
+// ============================================================================
+
+/**
+ * @file job_queue.h
+ * @brief Worker threads running posted jobs, newest first
+ * @version 2.1.0
+ *
+ * Views post a job per thumbnail or tile they are about to show. The
+ * newest job runs first, because it is the one still on screen after a
+ * scroll or zoom, and clear() drops everything still queued when the view
+ * moves on altogether.
+ */
+
+#ifndef JOB_QUEUE_H
+#define JOB_QUEUE_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @class JobQueue
+ * @brief Unbounded LIFO queue of jobs and the threads that run them
+ */
+class JobQueue {
+public:
+    typedef std::function<void()> Job;
+
+    JobQueue() : m_stopping(false) {}
+    ~JobQueue() { stop(); }
+
+    /**
+     * @brief Start the workers
+     * @param workers Threads (0 = half the cores, at least one)
+     */
+    void start(uint32_t workers = 0) {
+        if (!m_threads.empty()) {
+            return;
+        }
+        if (workers == 0) {
+            const unsigned cores = std::thread::hardware_concurrency();
+            workers = cores > 1 ? cores / 2 : 1;
+        }
+        m_stopping = false;
+        for (uint32_t i = 0; i < workers; ++i) {
+            m_threads.push_back(std::thread(&JobQueue::run, this));
+        }
+    }
+
+    /**
+     * @brief Drop queued jobs, finish running ones and join the workers
+     */
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = true;
+        }
+        m_ready.notify_all();
+        for (size_t i = 0; i < m_threads.size(); ++i) {
+            m_threads[i].join();
+        }
+        m_threads.clear();
+        clear();
+    }
+
+    void post(const Job& job) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_jobs.push_back(job);
+        }
+        m_ready.notify_one();
+    }
+
+    /// Drop jobs not started yet
+    void clear() {
+        std::deque<Job> jobs;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        jobs.swap(m_jobs);
+    }
+
+    size_t pending() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_jobs.size();
+    }
+
+private:
+    void run() {
+        for (;;) {
+            Job job;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_ready.wait(lock, [this] { return m_stopping || !m_jobs.empty(); });
+                if (m_stopping) {
+                    return;
+                }
+                job.swap(m_jobs.back());
+                m_jobs.pop_back();
+            }
+            job();
+        }
+    }
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_ready;
+    std::deque<Job> m_jobs;
+    std::vector<std::thread> m_threads;
+    bool m_stopping;
+
+    // Non-copyable
+    JobQueue(const JobQueue&) = delete;
+    JobQueue& operator=(const JobQueue&) = delete;
+};
+
+#endif // JOB_QUEUE_H
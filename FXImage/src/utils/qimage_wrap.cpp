@@ -0,0 +1,60 @@
+// ============================================================================
+// qimage_wrap.cpp
+// ============================================================================
+
+/**
+ * @file qimage_wrap.cpp
+ * @brief QImage cleanup function holding an XImage reference
+ * @version 2.1.0
+ */
+
+#include "qimage_wrap.h"
+
+#include <cstdint>
+
+#include "XImage.h"
+
+namespace {
+
+typedef std::shared_ptr<HX::XImage> ImageRef;
+
+void releaseImage(void* info) {
+    delete static_cast<ImageRef*>(info);
+}
+
+} // namespace
+
+QImage::Format wrapFormat(const HX::XImage& image) {
+    // QImage needs 32-bit aligned scanlines
+    const uint8_t* first = image._data_ + image._data_offset;
+    if (!image._data_ || (reinterpret_cast<uintptr_t>(first) & 3) != 0 || (image._stride & 3) != 0) {
+        return QImage::Format_Invalid;
+    }
+    switch (image._pixel_depth) {
+    case 8:
+        return QImage::Format_Grayscale8;
+#if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
+    case 24:
+        return QImage::Format_BGR888;
+#endif
+    case 32:
+        return QImage::Format_RGB32;
+    default:
+        return QImage::Format_Invalid;
+    }
+}
+
+QImage wrapImage(const std::shared_ptr<HX::XImage>& image) {
+    if (!image) {
+        return QImage();
+    }
+    const QImage::Format format = wrapFormat(*image);
+    if (format == QImage::Format_Invalid || image->_width == 0 || image->_height == 0) {
+        return QImage();
+    }
+
+    // const data: Qt detaches (copies) instead of writing into the buffer
+    const uchar* pixels = image->_data_ + image->_data_offset;
+    return QImage(pixels, static_cast<int>(image->_width), static_cast<int>(image->_height),
+                  static_cast<int>(image->_stride), format, &releaseImage, new ImageRef(image));
+}
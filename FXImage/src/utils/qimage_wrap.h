@@ -0,0 +1,44 @@
+// ============================================================================
+// qimage_wrap.h
+// ============================================================================
+
+/**
+ * @file qimage_wrap.h
+ * @brief QImage views of XImage buffers, without a pixel copy
+ * @version 2.1.0
+ *
+ * The QImage points at the XImage's pixels and holds a reference to it;
+ * the QImage cleanup function drops that reference when the last copy of
+ * the QImage goes away, which is when a pooled buffer returns to its pool.
+ * Only formats Qt paints directly are wrapped: 8-bit gray, 24-bit BGR as
+ * XShow converts it (Qt 5.14 and later) and 32-bit BGRX.
+ */
+
+#ifndef QIMAGE_WRAP_H
+#define QIMAGE_WRAP_H
+
+#include <QImage>
+
+#include <memory>
+
+namespace HX {
+class XImage;
+}
+
+/**
+ * @brief QImage format that shows the XImage's pixels as they are
+ * @return QImage::Format_Invalid if Qt cannot use them without converting
+ */
+QImage::Format wrapFormat(const HX::XImage& image);
+
+/**
+ * @brief Wrap an XImage buffer in a QImage
+ * @param image Buffer kept alive (and read-only) until the QImage's last copy is destroyed
+ * @return Wrapping QImage, or a null QImage if wrapFormat() is invalid
+ *
+ * @note For a pipeline frame, pass std::shared_ptr<HX::XImage>(frame, frame->image())
+ *       so the pool handle is held instead.
+ */
+QImage wrapImage(const std::shared_ptr<HX::XImage>& image);
+
+#endif // QIMAGE_WRAP_H
@@ -0,0 +1,127 @@
+// ============================================================================
+// thumbnail_cache.cpp
+// ============================================================================
+
+/**
+ * @file thumbnail_cache.cpp
+ * @brief Thumbnail lookup, generation and disk entries
+ * @version 2.1.0
+ */
+
+#include "thumbnail_cache.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include "gray_sampler.h"
+
+namespace {
+
+// Thumbnails kept in memory, in KB (about 1200 at 160 x 160)
+const int MEMORY_CACHE_KB = 32 * 1024;
+
+} // namespace
+
+ThumbnailCache::ThumbnailCache(const QString& directory, int size, uint32_t workers, QObject* parent)
+    : QObject(parent),
+      m_directory(directory),
+      m_size(size > 0 ? size : 160),
+      m_memory(MEMORY_CACHE_KB)
+{
+    QDir().mkpath(m_directory);
+    m_jobs.start(workers);
+}
+
+ThumbnailCache::~ThumbnailCache() {
+    // Workers emit from this object: stop them while it is whole
+    m_jobs.stop();
+}
+
+QString ThumbnailCache::defaultDirectory() {
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + QStringLiteral("/thumbnails");
+}
+
+QImage ThumbnailCache::thumbnail(const QString& path) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const QImage* cached = m_memory.object(path);
+        if (cached) {
+            return *cached;
+        }
+        if (m_pending.contains(path)) {
+            return QImage();
+        }
+        m_pending.insert(path);
+    }
+    m_jobs.post([this, path]() { load(path); });
+    return QImage();
+}
+
+void ThumbnailCache::cancelPending() {
+    m_jobs.clear();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_pending.clear();
+}
+
+void ThumbnailCache::load(const QString& path) {
+    const QString file = cacheFile(path);
+    QImage image;
+    if (!file.isEmpty() && QFileInfo::exists(file)) {
+        image.load(file, "PNG");
+    }
+    if (image.isNull()) {
+        image = generate(path);
+        if (!image.isNull() && !file.isEmpty()) {
+            // Readers never see a partial entry
+            QSaveFile out(file);
+            if (out.open(QIODevice::WriteOnly) && image.save(&out, "PNG")) {
+                out.commit();
+            }
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_pending.remove(path);
+        if (!image.isNull()) {
+            m_memory.insert(path, new QImage(image), qMax(1, image.bytesPerLine() * image.height() / 1024));
+        }
+    }
+    emit thumbnailReady(path, image);
+}
+
+QImage ThumbnailCache::generate(const QString& path) const {
+    GrayFile capture;
+    if (!capture.open(path)) {
+        return QImage();
+    }
+    const GraySource& source = capture.source();
+
+    uint32_t low = 0;
+    uint32_t high = 0;
+    autoWindow(source, low, high);
+
+    QSize size(static_cast<int>(source.width), static_cast<int>(source.height));
+    size.scale(m_size, m_size, Qt::KeepAspectRatio);
+    size = size.expandedTo(QSize(1, 1));
+    return renderGray(source, QRect(0, 0, static_cast<int>(source.width), static_cast<int>(source.height)),
+                      size, low, high);
+}
+
+QString ThumbnailCache::cacheFile(const QString& path) const {
+    const QFileInfo info(path);
+    if (!info.exists()) {
+        return QString();
+    }
+    const QByteArray hash = QCryptographicHash::hash(info.absoluteFilePath().toUtf8(),
+                                                     QCryptographicHash::Sha1).toHex();
+    return QStringLiteral("%1/%2-%3-%4-%5.png")
+        .arg(m_directory, QString::fromLatin1(hash))
+        .arg(info.lastModified().toMSecsSinceEpoch())
+        .arg(info.size())
+        .arg(m_size);
+}
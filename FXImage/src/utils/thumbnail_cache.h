@@ -0,0 +1,86 @@
+// ============================================================================
+// thumbnail_cache.h
+// ============================================================================
+
+/**
+ * @file thumbnail_cache.h
+ * @brief Capture thumbnails, generated in the background and kept on disk
+ * @version 2.1.0
+ *
+ * A thumbnail is looked up in memory, then in the cache directory, and
+ * only then generated from the capture (mapped, so just the sampled rows
+ * are read). Disk entries are PNG files keyed by the capture's path,
+ * modification time and size, so a rewritten capture gets a new entry and
+ * reopening a folder of thousands of captures decodes none of them.
+ */
+
+#ifndef THUMBNAIL_CACHE_H
+#define THUMBNAIL_CACHE_H
+
+#include <QCache>
+#include <QImage>
+#include <QObject>
+#include <QSet>
+#include <QString>
+
+#include <mutex>
+
+#include "job_queue.h"
+
+/**
+ * @class ThumbnailCache
+ * @brief Memory and disk cache of capture thumbnails, filled by workers
+ */
+class ThumbnailCache : public QObject {
+    Q_OBJECT
+
+public:
+    /**
+     * @param directory Cache directory, created if missing
+     * @param size Longest thumbnail side in pixels
+     * @param workers Generating threads (0 = half the cores)
+     */
+    explicit ThumbnailCache(const QString& directory, int size = 160, uint32_t workers = 0,
+                            QObject* parent = nullptr);
+    ~ThumbnailCache() override;
+
+    /// Default cache directory, under the user's cache location
+    static QString defaultDirectory();
+
+    int size() const { return m_size; }
+
+    /**
+     * @brief Thumbnail of a capture, if it is in memory
+     * @return The thumbnail, or a null image after queueing it for
+     *         thumbnailReady(); the latest request is served first
+     */
+    QImage thumbnail(const QString& path);
+
+    /**
+     * @brief Drop requests not started yet (the view moved on)
+     */
+    void cancelPending();
+
+signals:
+    /// A requested thumbnail is ready (emitted on a worker); null if the file cannot be read
+    void thumbnailReady(const QString& path, const QImage& image);
+
+private:
+    void load(const QString& path);
+    QImage generate(const QString& path) const;
+    QString cacheFile(const QString& path) const;
+
+    QString m_directory;
+    int m_size;
+
+    std::mutex m_mutex;                     ///< m_memory and m_pending
+    QCache<QString, QImage> m_memory;       ///< Cost in KB
+    QSet<QString> m_pending;
+    JobQueue m_jobs;
+
+    // Non-copyable
+    ThumbnailCache(const ThumbnailCache&) = delete;
+    ThumbnailCache& operator=(const ThumbnailCache&) = delete;
+};
+
+#endif // THUMBNAIL_CACHE_H
@@ -0,0 +1,196 @@
+// ============================================================================
+// tile_loader.cpp
+// ============================================================================
+
+/**
+ * @file tile_loader.cpp
+ * @brief Background mapping and tile rendering
+ * @version 2.1.0
+ */
+
+#include "tile_loader.h"
+
+#include "gray_sampler.h"
+
+namespace {
+
+// Tiles kept in memory, in KB (512 tiles of 256 x 256)
+const int TILE_CACHE_KB = 32 * 1024;
+
+} // namespace
+
+TileLoader::TileLoader(uint32_t workers, QObject* parent)
+    : QObject(parent),
+      m_opening(0),
+      m_generation(0),
+      m_low(0),
+      m_high(0),
+      m_tiles(TILE_CACHE_KB)
+{
+    m_jobs.start(workers);
+}
+
+TileLoader::~TileLoader() {
+    // Workers emit from this object: stop them while it is whole
+    m_jobs.stop();
+}
+
+void TileLoader::open(const QString& path) {
+    m_jobs.clear();
+    uint64_t opening = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        opening = ++m_opening;
+        ++m_generation;
+        m_file.reset();
+        m_path = path;
+        m_tiles.clear();
+        m_pending.clear();
+    }
+    m_jobs.post([this, path, opening]() { openFile(path, opening); });
+}
+
+void TileLoader::close() {
+    m_jobs.clear();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ++m_opening;
+    ++m_generation;
+    m_file.reset();
+    m_path.clear();
+    m_tiles.clear();
+    m_pending.clear();
+}
+
+QString TileLoader::path() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_path;
+}
+
+int TileLoader::width() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_file ? static_cast<int>(m_file->source().width) : 0;
+}
+
+int TileLoader::height() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_file ? static_cast<int>(m_file->source().height) : 0;
+}
+
+int TileLoader::maxLevel() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_file) {
+        return 0;
+    }
+    int level = 0;
+    uint32_t side = qMax(m_file->source().width, m_file->source().height);
+    while (side > static_cast<uint32_t>(TILE_SIZE)) {
+        side = (side + 1) / 2;
+        ++level;
+    }
+    return level;
+}
+
+void TileLoader::setWindow(uint32_t low, uint32_t high) {
+    m_jobs.clear();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ++m_generation;
+    m_low = low;
+    m_high = high;
+    m_tiles.clear();
+    m_pending.clear();
+}
+
+QImage TileLoader::tile(int level, int column, int row, bool request) {
+    std::shared_ptr<GrayFile> file;
+    uint64_t generation = 0;
+    uint32_t low = 0;
+    uint32_t high = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const quint64 key = tileKey(level, column, row);
+        const QImage* cached = m_tiles.object(key);
+        if (cached) {
+            return *cached;
+        }
+        if (!request || !m_file || m_pending.contains(key)) {
+            return QImage();
+        }
+        m_pending.insert(key);
+        file = m_file;
+        generation = m_generation;
+        low = m_low;
+        high = m_high;
+    }
+    m_jobs.post([this, file, generation, low, high, level, column, row]() {
+        render(file, generation, low, high, level, column, row);
+    });
+    return QImage();
+}
+
+void TileLoader::cancelPending() {
+    m_jobs.clear();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_pending.clear();
+}
+
+quint64 TileLoader::tileKey(int level, int column, int row) {
+    return (static_cast<quint64>(level) << 48) | (static_cast<quint64>(row & 0xFFFFFF) << 24) |
+           static_cast<quint64>(column & 0xFFFFFF);
+}
+
+void TileLoader::openFile(const QString& path, uint64_t opening) {
+    std::shared_ptr<GrayFile> file = std::make_shared<GrayFile>();
+    if (!file->open(path)) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (opening == m_opening) {
+            lock.unlock();
+            emit openFailed(path);
+        }
+        return;
+    }
+    uint32_t low = 0;
+    uint32_t high = 0;
+    autoWindow(file->source(), low, high);
+
+    const int width = static_cast<int>(file->source().width);
+    const int height = static_cast<int>(file->source().height);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (opening != m_opening) {
+            return;     // another capture was opened meanwhile
+        }
+        m_file = file;
+        m_low = low;
+        m_high = high;
+    }
+    emit opened(path, width, height, low, high);
+}
+
+void TileLoader::render(std::shared_ptr<GrayFile> file, uint64_t generation, uint32_t low, uint32_t high,
+                        int level, int column, int row) {
+    const GraySource& source = file->source();
+    const int span = TILE_SIZE << level;       // tile side in capture pixels
+    const QRect region = QRect(column * span, row * span, span, span)
+                             .intersected(QRect(0, 0, static_cast<int>(source.width),
+                                                static_cast<int>(source.height)));
+    QImage image;
+    if (!region.isEmpty()) {
+        const int scale = 1 << level;
+        const QSize size((region.width() + scale - 1) / scale, (region.height() + scale - 1) / scale);
+        image = renderGray(source, region, size, low, high);
+    }
+
+    const quint64 key = tileKey(level, column, row);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (generation != m_generation) {
+            return;
+        }
+        m_pending.remove(key);
+        if (image.isNull()) {
+            return;
+        }
+        m_tiles.insert(key, new QImage(image), qMax(1, image.bytesPerLine() * image.height() / 1024));
+    }
+    emit tileReady(level, column, row);
+}
@@ -0,0 +1,116 @@
+// ============================================================================
+// tile_loader.h
+// ============================================================================
+
+/**
+ * @file tile_loader.h
+ * @brief On-demand 8-bit tiles of one large capture, at any zoom level
+ * @version 2.1.0
+ *
+ * The capture is mapped, not decoded: a tile reads only the rows it
+ * covers, and a reduced level (level n is 1/2^n of full size) reads only
+ * the rows its samples land on. Tiles are rendered by background workers
+ * when a view first asks for them and kept in a bounded memory cache.
+ */
+
+#ifndef TILE_LOADER_H
+#define TILE_LOADER_H
+
+#include <QCache>
+#include <QImage>
+#include <QObject>
+#include <QSet>
+#include <QString>
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+#include "job_queue.h"
+
+class GrayFile;
+
+/**
+ * @class TileLoader
+ * @brief Tile pyramid of a mapped capture
+ */
+class TileLoader : public QObject {
+    Q_OBJECT
+
+public:
+    /// Tile side in output pixels, at every level
+    static const int TILE_SIZE = 256;
+
+    explicit TileLoader(uint32_t workers = 0, QObject* parent = nullptr);
+    ~TileLoader() override;
+
+    /**
+     * @brief Map a capture in the background; opened() or openFailed() follows
+     * @note Tiles of the previous capture are dropped at once
+     */
+    void open(const QString& path);
+
+    /**
+     * @brief Forget the capture
+     */
+    void close();
+
+    QString path() const;
+    int width() const;
+    int height() const;
+
+    /// Coarsest useful level: the whole capture in one tile
+    int maxLevel() const;
+
+    /**
+     * @brief Map [low, high] to 0..255; cached tiles are dropped
+     */
+    void setWindow(uint32_t low, uint32_t high);
+
+    /**
+     * @brief A tile, if it is rendered
+     * @param level Zoom level (0 = full resolution)
+     * @param column,row Tile position at that level
+     * @param request Queue the tile if it is not rendered yet
+     * @return The tile, or a null image (after queueing it for tileReady()
+     *         if request is true)
+     */
+    QImage tile(int level, int column, int row, bool request = true);
+
+    /**
+     * @brief Drop tile requests not started yet (the view zoomed or panned away)
+     */
+    void cancelPending();
+
+signals:
+    /// Capture mapped; the window is the capture's auto window
+    void opened(const QString& path, int width, int height, quint32 low, quint32 high);
+    void openFailed(const QString& path);
+
+    /// A requested tile is ready (emitted on a worker)
+    void tileReady(int level, int column, int row);
+
+private:
+    static quint64 tileKey(int level, int column, int row);
+
+    void openFile(const QString& path, uint64_t opening);
+    void render(std::shared_ptr<GrayFile> file, uint64_t generation, uint32_t low, uint32_t high,
+                int level, int column, int row);
+
+    mutable std::mutex m_mutex;             ///< Everything below but m_jobs
+    std::shared_ptr<GrayFile> m_file;       ///< Shared with running tile jobs
+    QString m_path;
+    uint64_t m_opening;                     ///< Bumped by open() and close()
+    uint64_t m_generation;                  ///< Bumped whenever cached tiles become stale
+    uint32_t m_low;
+    uint32_t m_high;
+    QCache<quint64, QImage> m_tiles;        ///< Cost in KB
+    QSet<quint64> m_pending;
+    JobQueue m_jobs;
+
+    // Non-copyable
+    TileLoader(const TileLoader&) = delete;
+    TileLoader& operator=(const TileLoader&) = delete;
+};
+
+#endif // TILE_LOADER_H
@@ -0,0 +1,65 @@
+// ============================================================================
+// image_display_widget.cpp
+// ============================================================================
+
+/**
+ * @file image_display_widget.cpp
+ * @brief Scaled painting of the latest frame
+ * @version 2.1.0
+ */
+
+#include "image_display_widget.h"
+
+#include <QPainter>
+#include <QPaintEvent>
+
+ImageDisplayWidget::ImageDisplayWidget(QWidget* parent)
+    : QWidget(parent)
+{
+    // paintEvent() covers every pixel, so Qt need not erase first
+    setAttribute(Qt::WA_OpaquePaintEvent);
+}
+
+ImageDisplayWidget::~ImageDisplayWidget() {
+}
+
+QSize ImageDisplayWidget::sizeHint() const {
+    return m_image.isNull() ? QSize(640, 480) : m_image.size();
+}
+
+void ImageDisplayWidget::setImage(const QImage& image) {
+    m_image = image;
+    update();
+}
+
+void ImageDisplayWidget::clear() {
+    m_image = QImage();
+    update();
+}
+
+QRect ImageDisplayWidget::targetRect() const {
+    if (m_image.isNull()) {
+        return QRect();
+    }
+    const QSize size = m_image.size().scaled(this->size(), Qt::KeepAspectRatio);
+    return QRect(QPoint((width() - size.width()) / 2, (height() - size.height()) / 2), size);
+}
+
+void ImageDisplayWidget::paintEvent(QPaintEvent* event) {
+    QPainter painter(this);
+    const QRect target = targetRect();
+    if (target.isEmpty()) {
+        painter.fillRect(event->rect(), Qt::black);
+        return;
+    }
+
+    // Letterbox around the frame
+    const QRegion letterbox = QRegion(event->rect()).subtracted(QRegion(target));
+    for (QRegion::const_iterator it = letterbox.begin(); it != letterbox.end(); ++it) {
+        painter.fillRect(*it, Qt::black);
+    }
+
+    // Nearest-neighbour scaling straight from the wrapped buffer
+    painter.setRenderHint(QPainter::SmoothPixmapTransform, false);
+    painter.drawImage(target, m_image);
+}
@@ -0,0 +1,60 @@
+// ============================================================================
+// image_display_widget.h
+// ============================================================================
+
+/**
+ * @file image_display_widget.h
+ * @brief Widget that paints acquisition frames
+ * @version 2.1.0
+ *
+ * setImage() keeps a shallow copy of the QImage: frames from
+ * AcquisitionController::frameReady() wrap pooled buffers, so the widget
+ * neither copies nor converts them, and a frame's buffer goes back to its
+ * pool as soon as the next frame replaces it. The image is scaled to fit
+ * with its aspect ratio kept; the letterbox is painted black.
+ */
+
+#ifndef IMAGE_DISPLAY_WIDGET_H
+#define IMAGE_DISPLAY_WIDGET_H
+
+#include <QImage>
+#include <QWidget>
+
+/**
+ * @class ImageDisplayWidget
+ * @brief Shows the latest frame, scaled to the widget
+ */
+class ImageDisplayWidget : public QWidget {
+    Q_OBJECT
+
+public:
+    explicit ImageDisplayWidget(QWidget* parent = nullptr);
+    ~ImageDisplayWidget() override;
+
+    /// Frame on screen (shallow copy)
+    QImage image() const { return m_image; }
+
+    QSize sizeHint() const override;
+
+public slots:
+    /**
+     * @brief Show a frame
+     * @param image Frame to show; kept, not copied, until the next one
+     */
+    void setImage(const QImage& image);
+
+    /**
+     * @brief Drop the frame on screen, returning its buffer
+     */
+    void clear();
+
+protected:
+    void paintEvent(QPaintEvent* event) override;
+
+private:
+    QRect targetRect() const;
+
+    QImage m_image;
+};
+
+#endif // IMAGE_DISPLAY_WIDGET_H
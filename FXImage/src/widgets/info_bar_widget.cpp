@@ -0,0 +1,97 @@
+// ============================================================================
+// info_bar_widget.cpp
+// ============================================================================
+
+/**
+ * @file info_bar_widget.cpp
+ * @brief Info bar layout and save status text
+ * @version 2.1.0
+ */
+
+#include "info_bar_widget.h"
+
+#include <QHBoxLayout>
+#include <QLabel>
+#include <QProgressBar>
+#include <QTimer>
+
+InfoBarWidget::InfoBarWidget(QWidget* parent)
+    : QWidget(parent),
+      m_message(new QLabel(this)),
+      m_save(new QLabel(this)),
+      m_queue(new QProgressBar(this)),
+      m_timer(new QTimer(this)),
+      m_files(nullptr)
+{
+    m_queue->setRange(0, 100);
+    m_queue->setFormat(QStringLiteral("Queue %p%"));
+    m_queue->setMaximumWidth(160);
+    m_queue->hide();
+    m_save->hide();
+
+    QHBoxLayout* layout = new QHBoxLayout(this);
+    layout->setContentsMargins(4, 2, 4, 2);
+    layout->addWidget(m_message, 1);
+    layout->addWidget(m_save);
+    layout->addWidget(m_queue);
+
+    connect(m_timer, &QTimer::timeout, this, &InfoBarWidget::poll);
+}
+
+InfoBarWidget::~InfoBarWidget() {
+}
+
+void InfoBarWidget::watch(const FileManager* files, int intervalMs) {
+    m_files = files;
+    if (!m_files) {
+        m_timer->stop();
+        m_save->hide();
+        m_queue->hide();
+        return;
+    }
+    m_timer->start(intervalMs);
+    poll();
+}
+
+void InfoBarWidget::setMessage(const QString& message) {
+    m_message->setText(message);
+}
+
+void InfoBarWidget::setSaveStatus(const FileManager::Status& status) {
+    if (!status.active && !status.finishing && status.framesAccepted == 0) {
+        m_save->hide();
+        m_queue->hide();
+        return;
+    }
+
+    QString text;
+    if (status.framesRequested > 0) {
+        text = tr("Saved %1 / %2").arg(status.framesWritten).arg(status.framesRequested);
+    } else {
+        text = tr("Saved %1").arg(status.framesWritten);
+    }
+    text += tr(", %1 queued, %2 MB/s").arg(status.queued).arg(status.averageMBps, 0, 'f', 1);
+    if (status.framesDropped > 0) {
+        text += tr(", %1 dropped").arg(status.framesDropped);
+    }
+    if (status.writeErrors > 0) {
+        text += tr(", %1 errors").arg(status.writeErrors);
+    }
+    if (status.finishing) {
+        text += tr(" (finishing)");
+    }
+    m_save->setText(text);
+    m_save->show();
+
+    const int fill = status.memoryBudget > 0
+                         ? static_cast<int>(qMin<uint64_t>(100, status.queuedBytes * 100 / status.memoryBudget))
+                         : 0;
+    m_queue->setValue(fill);
+    m_queue->setVisible(status.active || status.finishing);
+}
+
+void InfoBarWidget::poll() {
+    if (m_files) {
+        setSaveStatus(m_files->status());
+    }
+}
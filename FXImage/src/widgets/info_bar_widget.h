@@ -0,0 +1,60 @@
+// ============================================================================
+// info_bar_widget.h
+// ============================================================================
+
+/**
+ * @file info_bar_widget.h
+ * @brief Status line under the image: messages and sequence saving
+ * @version 2.1.0
+ *
+ * While watching a FileManager the bar polls FileManager::status() on a
+ * GUI timer, so the writer threads never post to the GUI per frame.
+ */
+
+#ifndef INFO_BAR_WIDGET_H
+#define INFO_BAR_WIDGET_H
+
+#include <QWidget>
+
+#include "utils/file_manager.h"
+
+class QLabel;
+class QProgressBar;
+class QTimer;
+
+/**
+ * @class InfoBarWidget
+ * @brief Message text plus the save queue fill and throughput
+ */
+class InfoBarWidget : public QWidget {
+    Q_OBJECT
+
+public:
+    explicit InfoBarWidget(QWidget* parent = nullptr);
+    ~InfoBarWidget() override;
+
+    /**
+     * @brief Show the save queue of a file manager
+     * @param files File manager to poll, or nullptr to stop; must outlive the watch
+     * @param intervalMs Refresh period
+     */
+    void watch(const FileManager* files, int intervalMs = 250);
+
+public slots:
+    void setMessage(const QString& message);
+
+    /// Show one save status; called by the poll timer while watching
+    void setSaveStatus(const FileManager::Status& status);
+
+private slots:
+    void poll();
+
+private:
+    QLabel* m_message;
+    QLabel* m_save;
+    QProgressBar* m_queue;          ///< Queue memory against the budget
+    QTimer* m_timer;
+    const FileManager* m_files;
+};
+
+#endif // INFO_BAR_WIDGET_H
@@ -0,0 +1,195 @@
+// ============================================================================
+// tile_view_widget.cpp
+// ============================================================================
+
+/**
+ * @file tile_view_widget.cpp
+ * @brief Tile selection, fallback painting and pan/zoom input
+ * @version 2.1.0
+ */
+
+#include "tile_view_widget.h"
+
+#include <QMouseEvent>
+#include <QPainter>
+#include <QWheelEvent>
+
+#include <cmath>
+
+#include "utils/tile_loader.h"
+
+namespace {
+
+const double MAX_ZOOM = 32.0;
+
+} // namespace
+
+TileViewWidget::TileViewWidget(QWidget* parent)
+    : QWidget(parent),
+      m_loader(nullptr),
+      m_zoom(1.0),
+      m_dragging(false),
+      m_fitted(true)
+{
+    // paintEvent() covers every pixel, so Qt need not erase first
+    setAttribute(Qt::WA_OpaquePaintEvent);
+}
+
+TileViewWidget::~TileViewWidget() {
+}
+
+void TileViewWidget::setLoader(TileLoader* loader) {
+    if (m_loader) {
+        disconnect(m_loader, nullptr, this, nullptr);
+    }
+    m_loader = loader;
+    if (m_loader) {
+        // Emitted on loader workers; queued to the GUI thread, where updates coalesce
+        connect(m_loader, &TileLoader::tileReady, this, [this]() { update(); });
+        connect(m_loader, &TileLoader::opened, this, [this]() { captureOpened(); });
+    }
+    fitToWindow();
+}
+
+void TileViewWidget::fitToWindow() {
+    m_fitted = true;
+    const int width = m_loader ? m_loader->width() : 0;
+    const int height = m_loader ? m_loader->height() : 0;
+    if (width > 0 && height > 0 && !rect().isEmpty()) {
+        m_zoom = qMin(static_cast<double>(this->width()) / width, static_cast<double>(this->height()) / height);
+        m_origin = QPointF(width / 2.0 - this->width() / (2.0 * m_zoom),
+                           height / 2.0 - this->height() / (2.0 * m_zoom));
+    }
+    update();
+}
+
+void TileViewWidget::captureOpened() {
+    fitToWindow();
+}
+
+int TileViewWidget::levelForZoom() const {
+    if (!m_loader || m_zoom >= 1.0) {
+        return 0;
+    }
+    const int level = static_cast<int>(std::floor(std::log2(1.0 / m_zoom)));
+    return qBound(0, level, m_loader->maxLevel());
+}
+
+QPointF TileViewWidget::toCapture(const QPointF& widget) const {
+    return m_origin + widget / m_zoom;
+}
+
+void TileViewWidget::paintEvent(QPaintEvent* /*event*/) {
+    QPainter painter(this);
+    painter.fillRect(rect(), Qt::black);
+
+    const int width = m_loader ? m_loader->width() : 0;
+    const int height = m_loader ? m_loader->height() : 0;
+    if (width <= 0 || height <= 0) {
+        return;
+    }
+    painter.setRenderHint(QPainter::SmoothPixmapTransform, m_zoom < 1.0);
+
+    const int level = levelForZoom();
+    const int span = TileLoader::TILE_SIZE << level;
+    const QPointF topLeft = toCapture(QPointF(0, 0));
+    const QPointF bottomRight = toCapture(QPointF(this->width(), this->height()));
+    const int firstColumn = qMax(0, static_cast<int>(std::floor(topLeft.x() / span)));
+    const int firstRow = qMax(0, static_cast<int>(std::floor(topLeft.y() / span)));
+    const int lastColumn = qMin((width - 1) / span, static_cast<int>(std::floor(bottomRight.x() / span)));
+    const int lastRow = qMin((height - 1) / span, static_cast<int>(std::floor(bottomRight.y() / span)));
+
+    const int fallbackLevels = m_loader->maxLevel() - level;
+    for (int row = firstRow; row <= lastRow; ++row) {
+        for (int column = firstColumn; column <= lastColumn; ++column) {
+            drawTile(painter, level, column, row, fallbackLevels);
+        }
+    }
+}
+
+bool TileViewWidget::drawTile(QPainter& painter, int level, int column, int row, int fallbackLevels) {
+    const int span = TileLoader::TILE_SIZE << level;
+    const QRect area = QRect(column * span, row * span, span, span)
+                           .intersected(QRect(0, 0, m_loader->width(), m_loader->height()));
+    const QRectF target((area.x() - m_origin.x()) * m_zoom, (area.y() - m_origin.y()) * m_zoom,
+                        area.width() * m_zoom, area.height() * m_zoom);
+
+    const QImage image = m_loader->tile(level, column, row);
+    if (!image.isNull()) {
+        painter.drawImage(target, image, QRectF(image.rect()));
+        return true;
+    }
+
+    // Stand-in: the part of a coarser tile already rendered that covers this one
+    for (int up = 1; up <= fallbackLevels; ++up) {
+        const int coarse = level + up;
+        const QImage parent = m_loader->tile(coarse, column >> up, row >> up, false);
+        if (parent.isNull()) {
+            continue;
+        }
+        const int parentSpan = TileLoader::TILE_SIZE << coarse;
+        const double scale = 1.0 / (1 << coarse);
+        const QRectF source((area.x() - (column >> up) * parentSpan) * scale,
+                            (area.y() - (row >> up) * parentSpan) * scale,
+                            area.width() * scale, area.height() * scale);
+        painter.drawImage(target, parent, source);
+        return false;
+    }
+    return false;
+}
+
+void TileViewWidget::setZoom(double zoom, const QPointF& anchor) {
+    if (!m_loader || m_loader->width() <= 0) {
+        return;
+    }
+    const double minZoom = 1.0 / (1 << (m_loader->maxLevel() + 2));
+    zoom = qBound(minZoom, zoom, MAX_ZOOM);
+    const QPointF fixed = toCapture(anchor);
+    m_zoom = zoom;
+    m_origin = fixed - anchor / m_zoom;
+    m_fitted = false;
+
+    // Tiles of the old level that are still queued are not needed any more
+    m_loader->cancelPending();
+    update();
+}
+
+void TileViewWidget::wheelEvent(QWheelEvent* event) {
+    const double steps = event->angleDelta().y() / 120.0;
+    if (steps != 0.0) {
+        setZoom(m_zoom * std::pow(1.25, steps), QPointF(event->pos()));
+    }
+    event->accept();
+}
+
+void TileViewWidget::mousePressEvent(QMouseEvent* event) {
+    if (event->button() == Qt::LeftButton) {
+        m_dragging = true;
+        m_dragStart = event->pos();
+        m_dragOrigin = m_origin;
+    } else if (event->button() == Qt::RightButton) {
+        fitToWindow();
+    }
+}
+
+void TileViewWidget::mouseMoveEvent(QMouseEvent* event) {
+    if (!m_dragging) {
+        return;
+    }
+    m_origin = m_dragOrigin - QPointF(event->pos() - m_dragStart) / m_zoom;
+    m_fitted = false;
+    update();
+}
+
+void TileViewWidget::mouseReleaseEvent(QMouseEvent* event) {
+    if (event->button() == Qt::LeftButton) {
+        m_dragging = false;
+    }
+}
+
+void TileViewWidget::resizeEvent(QResizeEvent* event) {
+    QWidget::resizeEvent(event);
+    if (m_fitted) {
+        fitToWindow();
+    }
+}
@@ -0,0 +1,76 @@
+// ============================================================================
+// tile_view_widget.h
+// ============================================================================
+
+/**
+ * @file tile_view_widget.h
+ * @brief Pan and zoom view of a large capture, painted from tiles
+ * @version 2.1.0
+ *
+ * Only the tiles on screen are asked for, at the level matching the zoom;
+ * until a tile arrives its area shows the nearest coarser tile already
+ * rendered, scaled up, so zooming never shows holes for long.
+ */
+
+#ifndef TILE_VIEW_WIDGET_H
+#define TILE_VIEW_WIDGET_H
+
+#include <QPoint>
+#include <QPointF>
+#include <QWidget>
+
+class TileLoader;
+
+/**
+ * @class TileViewWidget
+ * @brief Tile-backed capture viewer (wheel zooms, drag pans)
+ */
+class TileViewWidget : public QWidget {
+    Q_OBJECT
+
+public:
+    explicit TileViewWidget(QWidget* parent = nullptr);
+    ~TileViewWidget() override;
+
+    /**
+     * @brief Show the capture of a loader
+     * @param loader Tile source, or nullptr; must outlive the widget or be replaced
+     */
+    void setLoader(TileLoader* loader);
+
+    /// Display pixels per capture pixel
+    double zoom() const { return m_zoom; }
+
+public slots:
+    /**
+     * @brief Show the whole capture
+     */
+    void fitToWindow();
+
+protected:
+    void paintEvent(QPaintEvent* event) override;
+    void wheelEvent(QWheelEvent* event) override;
+    void mousePressEvent(QMouseEvent* event) override;
+    void mouseMoveEvent(QMouseEvent* event) override;
+    void mouseReleaseEvent(QMouseEvent* event) override;
+    void resizeEvent(QResizeEvent* event) override;
+
+private slots:
+    void captureOpened();
+
+private:
+    int levelForZoom() const;
+    QPointF toCapture(const QPointF& widget) const;
+    bool drawTile(QPainter& painter, int level, int column, int row, int fallbackLevels);
+    void setZoom(double zoom, const QPointF& anchor);
+
+    TileLoader* m_loader;
+    double m_zoom;
+    QPointF m_origin;           ///< Capture point at the widget's top-left corner
+    QPoint m_dragStart;
+    QPointF m_dragOrigin;
+    bool m_dragging;
+    bool m_fitted;              ///< Follow the widget size until the user zooms
+};
+
+#endif // TILE_VIEW_WIDGET_H
@@ -0,0 +1,919 @@
+// ============================================================================
+// HubxNet.cs
+// ============================================================================
+
+// HubxNet - .NET binding of the hubx C API (hubx_capi.h, xog_correct.h)
+//
+// Frames are never marshaled: a Frame describes the native pool buffer the
+// detector data was assembled in, and its pixels are read and written
+// through Span<ushort> (or Memory<ushort>) over that buffer. The buffer
+// belongs to the caller until Frame.Release(); hold too many and the pool
+// runs dry, and acquisition drops frames.
+//
+// Frame callbacks come from the native receive thread through an unmanaged
+// function pointer to a static method, and reach the IFrameSink through a
+// GCHandle taken once per Start(): nothing is allocated per frame.
+//
+// Requires .NET 5 or later and AllowUnsafeBlocks; version 2.1.0.
+
+using System;
+using System.Buffers;
+using System.Collections.Generic;
+using System.Runtime.CompilerServices;
+using System.Runtime.InteropServices;
+using System.Threading;
+
+namespace Hubx
+{
+    /// <summary>Parameter and command codes (XControl::XCode)</summary>
+    public enum XCode
+    {
+        // System operations
+        Init = 0,               ///< Initialize from flash
+        Restore,                ///< Restore defaults
+        Save,                   ///< Save settings
+        FrameTriggerGenerate,   ///< Generate frame trigger
+
+        // Basic parameters
+        IntegrationTime,        ///< Integration time (us)
+        NonIntegrationTime,     ///< Non-continuous integration time
+        Operation,              ///< Operation mode
+        DmGain,                 ///< DM module gain
+        EnergyMode,             ///< High/Low energy mode
+        Channel,                ///< Channel configuration
+
+        // Correction parameters
+        BaselineCorrection,     ///< Baseline correction enable
+        Baseline,               ///< Baseline value
+        Binning,                ///< Pixel binning mode
+        Average,                ///< Row average filter
+        Sum,                    ///< Row sum filter
+        Scale,                  ///< Output scale
+        OffsetAverage,          ///< Offset average filter
+
+        // Trigger parameters
+        LineTriggerMode,        ///< Line trigger mode
+        LineTrigger,            ///< Line trigger enable
+        LineTriggerFineDelay,   ///< Line trigger fine delay
+        LineTriggerRawDelay,    ///< Line trigger coarse delay
+        FrameTriggerMode,       ///< Frame trigger mode
+        FrameTrigger,           ///< Frame trigger enable
+        FrameTriggerDelay,      ///< Frame trigger delay
+        LineTriggerParity,      ///< Line trigger parity
+
+        // Device information
+        PixelCount,             ///< Total pixel count
+        PixelSize,              ///< Pixel size (mm * 10)
+        PixelDepth,             ///< Bits per pixel
+        CuVersion,              ///< Firmware version
+        DmVersion,              ///< DM firmware version
+        CuTest,                 ///< Test pattern mode
+        DmTest,                 ///< DM test mode
+        DmPixelCount,           ///< Pixels per DM
+        DmType,                 ///< DM type
+        Led,                    ///< LED control
+        CuType,                 ///< Communication type
+        CuSerial,               ///< Serial number (string)
+        DmSerial                ///< DM serial number (string)
+    }
+
+    /// <summary>Return codes of the C API</summary>
+    public enum HubxError
+    {
+        Success = 0,
+        InvalidParam = -1,
+        NullPointer = -2,
+        BufferSize = -3,
+        Calculation = -4,
+        NotCalibrated = -5,
+        Device = -6,
+        Busy = -7
+    }
+
+    /// <summary>A C API call failed</summary>
+    public sealed class HubxException : Exception
+    {
+        public HubxError Error { get; }
+
+        public HubxException(HubxError error, string operation)
+            : base(operation + " failed: " + error)
+        {
+            Error = error;
+        }
+
+        internal static void Check(int result, string operation)
+        {
+            if (result < 0)
+            {
+                throw new HubxException((HubxError)result, operation);
+            }
+        }
+    }
+
+    /// <summary>Where the detector is and what it delivers</summary>
+    public sealed class DetectorSettings
+    {
+        public string Ip { get; set; } = "192.168.1.2";
+        public ushort CommandPort { get; set; } = 3000;
+        public ushort ImagePort { get; set; } = 4001;
+        public byte[] Mac { get; set; } = new byte[6];
+        public string Serial { get; set; }
+        public uint PixelCount { get; set; }
+        public uint ModuleCount { get; set; }
+        public uint PixelDepth { get; set; } = 16;
+    }
+
+    /// <summary>Acquisition settings, fixed for one Device.Start()</summary>
+    public sealed class AcquisitionSettings
+    {
+        public uint LinesPerFrame { get; set; } = 512;
+
+        /// <summary>Pool buffers: frames the application may hold at once, plus one</summary>
+        public uint PoolSize { get; set; } = 8;
+
+        public uint Segments { get; set; } = 1;
+        public bool LineHeader { get; set; } = true;
+
+        /// <summary>Frames to grab (0 = until Stop())</summary>
+        public uint Frames { get; set; }
+    }
+
+    /// <summary>
+    /// Receiver of acquisition callbacks, called on the native receive thread
+    /// </summary>
+    /// <remarks>
+    /// OnFrame must return quickly. Hand the frame to another thread (it is a
+    /// small struct, copying it costs nothing) and release it there; every
+    /// frame must be released exactly once.
+    /// </remarks>
+    public interface IFrameSink
+    {
+        void OnFrame(in Frame frame);
+        void OnError(uint id, string message);
+        void OnEvent(uint id, uint data);
+    }
+
+    /// <summary>Native frame description (hubx_frame_t)</summary>
+    [StructLayout(LayoutKind.Sequential)]
+    internal struct NativeFrame
+    {
+        public IntPtr Data;
+        public IntPtr Token;
+        public ulong Sequence;
+        public uint Width;
+        public uint Height;
+        public uint Stride;
+        public uint PixelDepth;
+        public uint BytesPerPixel;
+        public uint Reserved;
+    }
+
+    /// <summary>
+    /// A frame in a native pool buffer, valid until Release()
+    /// </summary>
+    /// <remarks>
+    /// Spans and memory taken from a frame must not be used after it is
+    /// released: the buffer is reused for a later frame.
+    /// </remarks>
+    public readonly unsafe struct Frame
+    {
+        private readonly Device _device;
+        private readonly NativeFrame _native;
+
+        internal Frame(Device device, in NativeFrame native)
+        {
+            _device = device;
+            _native = native;
+        }
+
+        public bool IsValid => _device != null && _native.Token != IntPtr.Zero;
+        public ulong Sequence => _native.Sequence;
+        public int Width => (int)_native.Width;
+        public int Height => (int)_native.Height;
+
+        /// <summary>Bytes from one row to the next</summary>
+        public int Stride => (int)_native.Stride;
+
+        public int PixelDepth => (int)_native.PixelDepth;
+        public int BytesPerPixel => (int)_native.BytesPerPixel;
+
+        /// <summary>Rows are packed: Pixels covers exactly Width * Height values</summary>
+        public bool IsPacked => _native.Stride == _native.Width * _native.BytesPerPixel;
+
+        /// <summary>Pointer to the first pixel, for native calls</summary>
+        public IntPtr Data => _native.Data;
+
+        /// <summary>The whole buffer, including any row padding</summary>
+        public Span<byte> Bytes => new Span<byte>((void*)_native.Data, checked((int)(_native.Stride * _native.Height)));
+
+        /// <summary>
+        /// All pixels, row after row (Stride / 2 values per row)
+        /// </summary>
+        /// <exception cref="InvalidOperationException">Pixels wider than 16 bits</exception>
+        public Span<ushort> Pixels
+        {
+            get
+            {
+                CheckWords();
+                return new Span<ushort>((void*)_native.Data, checked((int)(_native.Stride / 2 * _native.Height)));
+            }
+        }
+
+        /// <summary>One row of Width pixels</summary>
+        public Span<ushort> Row(int row)
+        {
+            CheckWords();
+            if ((uint)row >= _native.Height)
+            {
+                throw new ArgumentOutOfRangeException(nameof(row));
+            }
+            byte* start = (byte*)_native.Data + (long)row * _native.Stride;
+            return new Span<ushort>(start, (int)_native.Width);
+        }
+
+        /// <summary>
+        /// The pixels as Memory, e.g. for async code or another thread
+        /// </summary>
+        /// <remarks>
+        /// Backed by one reusable MemoryManager per pool buffer, so this
+        /// allocates only the first time a buffer is seen.
+        /// </remarks>
+        public Memory<ushort> GetMemory()
+        {
+            CheckWords();
+            return _device.MemoryOf(_native.Data, checked((int)(_native.Stride / 2 * _native.Height)));
+        }
+
+        /// <summary>Give the buffer back to the pool</summary>
+        public void Release()
+        {
+            if (IsValid)
+            {
+                _device.Release(_native.Token);
+            }
+        }
+
+        private void CheckWords()
+        {
+            if (_native.BytesPerPixel != 2)
+            {
+                throw new InvalidOperationException("Frame pixels are " + _native.BytesPerPixel +
+                                                    " bytes; use Bytes");
+            }
+        }
+    }
+
+    /// <summary>Memory over one native pool buffer; pinning is free</summary>
+    internal sealed unsafe class NativeBufferMemory : MemoryManager<ushort>
+    {
+        private readonly ushort* _pointer;
+        private int _length;
+
+        public NativeBufferMemory(IntPtr pointer)
+        {
+            _pointer = (ushort*)pointer;
+        }
+
+        public Memory<ushort> Get(int length)
+        {
+            _length = length;
+            return CreateMemory(length);
+        }
+
+        public override Span<ushort> GetSpan() => new Span<ushort>(_pointer, _length);
+
+        public override MemoryHandle Pin(int elementIndex = 0) => new MemoryHandle(_pointer + elementIndex);
+
+        public override void Unpin()
+        {
+        }
+
+        protected override void Dispose(bool disposing)
+        {
+        }
+    }
+
+    /// <summary>
+    /// Detector, command channel and acquisition (hubx_device_t)
+    /// </summary>
+    public sealed unsafe class Device : IDisposable
+    {
+        private IntPtr _handle;
+        private GCHandle _self;
+        private IFrameSink _sink;
+        private Exception _callbackException;
+        private readonly Dictionary<IntPtr, NativeBufferMemory> _memories = new Dictionary<IntPtr, NativeBufferMemory>();
+
+        public Device(DetectorSettings settings)
+        {
+            if (settings == null)
+            {
+                throw new ArgumentNullException(nameof(settings));
+            }
+            if (settings.Mac == null || settings.Mac.Length != 6)
+            {
+                throw new ArgumentException("MAC must be 6 bytes", nameof(settings));
+            }
+
+            IntPtr ip = Marshal.StringToHGlobalAnsi(settings.Ip);
+            IntPtr serial = settings.Serial != null ? Marshal.StringToHGlobalAnsi(settings.Serial) : IntPtr.Zero;
+            try
+            {
+                Native.DetectorConfig config = default;
+                config.Ip = ip;
+                config.CommandPort = settings.CommandPort;
+                config.ImagePort = settings.ImagePort;
+                for (int i = 0; i < 6; i++)
+                {
+                    config.Mac[i] = settings.Mac[i];
+                }
+                config.Serial = serial;
+                config.PixelCount = settings.PixelCount;
+                config.ModuleCount = settings.ModuleCount;
+                config.PixelDepth = settings.PixelDepth;
+                _handle = Native.hubx_device_create(&config);
+            }
+            finally
+            {
+                Marshal.FreeHGlobal(ip);
+                if (serial != IntPtr.Zero)
+                {
+                    Marshal.FreeHGlobal(serial);
+                }
+            }
+            if (_handle == IntPtr.Zero)
+            {
+                throw new HubxException(HubxError.InvalidParam, "hubx_device_create");
+            }
+        }
+
+        ~Device()
+        {
+            Destroy();
+        }
+
+        /// <summary>Open the command channel</summary>
+        public void Open() => HubxException.Check(Native.hubx_device_open(Handle), "Open");
+
+        /// <summary>Stop acquisition and close the command channel</summary>
+        /// <remarks>Waits until every frame is released</remarks>
+        public void Close()
+        {
+            Native.hubx_device_close(Handle);
+            FreeSelf();
+        }
+
+        public ulong Read(XCode code, byte index = 0)
+        {
+            ulong value;
+            HubxException.Check(Native.hubx_control_read(Handle, (int)code, index, &value), "Read " + code);
+            return value;
+        }
+
+        public void Write(XCode code, ulong value, byte index = 0) =>
+            HubxException.Check(Native.hubx_control_write(Handle, (int)code, value, index), "Write " + code);
+
+        public void Operate(XCode code, ulong data = 0) =>
+            HubxException.Check(Native.hubx_control_operate(Handle, (int)code, data), "Operate " + code);
+
+        /// <summary>Open the image channel and deliver frames to a sink</summary>
+        public void Start(IFrameSink sink, AcquisitionSettings settings)
+        {
+            if (sink == null)
+            {
+                throw new ArgumentNullException(nameof(sink));
+            }
+            settings = settings ?? new AcquisitionSettings();
+
+            _sink = sink;
+            _callbackException = null;
+            if (!_self.IsAllocated)
+            {
+                _self = GCHandle.Alloc(this);
+            }
+
+            Native.Callbacks callbacks;
+            callbacks.Frame = &OnFrameNative;
+            callbacks.Error = &OnErrorNative;
+            callbacks.Event = &OnEventNative;
+            callbacks.User = GCHandle.ToIntPtr(_self);
+            HubxException.Check(Native.hubx_acq_set_callbacks(Handle, &callbacks), "Set callbacks");
+
+            Native.AcquisitionConfig config;
+            config.LinesPerFrame = settings.LinesPerFrame;
+            config.PoolSize = settings.PoolSize;
+            config.Segments = settings.Segments;
+            config.LineHeader = settings.LineHeader ? 1u : 0u;
+            config.Frames = settings.Frames;
+            HubxException.Check(Native.hubx_acq_start(Handle, &config), "Start");
+        }
+
+        /// <summary>
+        /// Stop delivering frames, then stop grabbing once all are released
+        /// </summary>
+        /// <returns>false if frames are still held after the timeout; no more
+        /// are delivered, and a later Stop() completes once they are released</returns>
+        /// <remarks>Do not call from IFrameSink.OnFrame</remarks>
+        public bool Stop(TimeSpan timeout)
+        {
+            int result = Native.hubx_acq_stop(Handle, (uint)Math.Max(0, Math.Min(uint.MaxValue, timeout.TotalMilliseconds)));
+            if (result == (int)HubxError.Busy)
+            {
+                return false;
+            }
+            HubxException.Check(result, "Stop");
+            lock (_memories)
+            {
+                _memories.Clear();
+            }
+            return true;
+        }
+
+        /// <summary>Pool buffers neither assembling nor held</summary>
+        public uint FreeBuffers => Native.hubx_acq_free_buffers(Handle);
+
+        /// <summary>
+        /// First exception thrown by the sink since Start(); callbacks must
+        /// not throw into native code, so exceptions are caught and kept here
+        /// </summary>
+        public Exception CallbackException => Volatile.Read(ref _callbackException);
+
+        public void Dispose()
+        {
+            Destroy();
+            GC.SuppressFinalize(this);
+        }
+
+        internal void Release(IntPtr token) => Native.hubx_frame_release(Handle, token);
+
+        internal Memory<ushort> MemoryOf(IntPtr data, int length)
+        {
+            NativeBufferMemory memory;
+            lock (_memories)
+            {
+                if (!_memories.TryGetValue(data, out memory))
+                {
+                    memory = new NativeBufferMemory(data);
+                    _memories.Add(data, memory);
+                }
+            }
+            return memory.Get(length);
+        }
+
+        private IntPtr Handle
+        {
+            get
+            {
+                if (_handle == IntPtr.Zero)
+                {
+                    throw new ObjectDisposedException(nameof(Device));
+                }
+                return _handle;
+            }
+        }
+
+        private void Destroy()
+        {
+            IntPtr handle = Interlocked.Exchange(ref _handle, IntPtr.Zero);
+            if (handle != IntPtr.Zero)
+            {
+                Native.hubx_device_destroy(handle);
+            }
+            FreeSelf();
+        }
+
+        private void FreeSelf()
+        {
+            if (_self.IsAllocated)
+            {
+                _self.Free();
+            }
+        }
+
+        private void Fault(Exception e)
+        {
+            Interlocked.CompareExchange(ref _callbackException, e, null);
+        }
+
+        [UnmanagedCallersOnly(CallConvs = new[] { typeof(CallConvCdecl) })]
+        private static void OnFrameNative(NativeFrame* frame, IntPtr user)
+        {
+            Device device = (Device)GCHandle.FromIntPtr(user).Target;
+            try
+            {
+                device._sink.OnFrame(new Frame(device, *frame));
+            }
+            catch (Exception e)
+            {
+                device.Fault(e);
+            }
+        }
+
+        [UnmanagedCallersOnly(CallConvs = new[] { typeof(CallConvCdecl) })]
+        private static void OnErrorNative(uint id, IntPtr message, IntPtr user)
+        {
+            Device device = (Device)GCHandle.FromIntPtr(user).Target;
+            try
+            {
+                device._sink.OnError(id, Marshal.PtrToStringUTF8(message));
+            }
+            catch (Exception e)
+            {
+                device.Fault(e);
+            }
+        }
+
+        [UnmanagedCallersOnly(CallConvs = new[] { typeof(CallConvCdecl) })]
+        private static void OnEventNative(uint id, uint data, IntPtr user)
+        {
+            Device device = (Device)GCHandle.FromIntPtr(user).Target;
+            try
+            {
+                device._sink.OnEvent(id, data);
+            }
+            catch (Exception e)
+            {
+                device.Fault(e);
+            }
+        }
+    }
+
+    /// <summary>
+    /// Offset/gain correction and calibration (hubx_xog_t)
+    /// </summary>
+    /// <remarks>
+    /// Frames with packed rows are passed to the native code as they are;
+    /// padded rows are packed into one reusable native buffer first.
+    /// Calls on one instance are serialized; give each thread its own.
+    /// </remarks>
+    public sealed unsafe class XogCorrection : IDisposable
+    {
+        private IntPtr _handle;
+        private ushort* _packed;
+        private int _packedLength;
+
+        public XogCorrection()
+        {
+            _handle = Native.hubx_xog_create();
+            if (_handle == IntPtr.Zero)
+            {
+                throw new OutOfMemoryException();
+            }
+        }
+
+        ~XogCorrection()
+        {
+            Destroy();
+        }
+
+        /// <summary>Load a calibration written by Save()</summary>
+        public void Load(string file) => HubxException.Check(Native.hubx_xog_load(Handle, file), "Load calibration");
+
+        public void Save(string file) => HubxException.Check(Native.hubx_xog_save(Handle, file), "Save calibration");
+
+        /// <summary>Start a new calibration, discarding the loaded one</summary>
+        public void Init(int width, int height, int bitDepth) =>
+            HubxException.Check(Native.hubx_xog_init(Handle, width, height, bitDepth), "Init calibration");
+
+        public void AddDark(in Frame frame) =>
+            HubxException.Check(Native.hubx_xog_add_dark(Handle, Packed(frame)), "Add dark frame");
+
+        public void FinalizeOffset() => HubxException.Check(Native.hubx_xog_finalize_offset(Handle), "Finalize offset");
+
+        public void AddBright(in Frame frame) =>
+            HubxException.Check(Native.hubx_xog_add_bright(Handle, Packed(frame)), "Add bright frame");
+
+        public void FinalizeGain(ushort target) =>
+            HubxException.Check(Native.hubx_xog_finalize_gain(Handle, target), "Finalize gain");
+
+        public void DiscardFrames() => HubxException.Check(Native.hubx_xog_discard_frames(Handle), "Discard frames");
+
+        public (int Width, int Height) Size
+        {
+            get
+            {
+                int width;
+                int height;
+                HubxException.Check(Native.hubx_xog_get_size(Handle, &width, &height), "Get size");
+                return (width, height);
+            }
+        }
+
+        /// <summary>Version of the published calibration; grows with every load or finalize</summary>
+        public ulong Version
+        {
+            get
+            {
+                ulong version;
+                HubxException.Check(Native.hubx_xog_get_version(Handle, &version), "Get version");
+                return version;
+            }
+        }
+
+        /// <summary>
+        /// Store coefficients in 16 bits when the result stays within maxError
+        /// counts of float coefficients; 0 turns it off
+        /// </summary>
+        public void SetCompact(int maxError) =>
+            HubxException.Check(Native.hubx_xog_set_compact(Handle, maxError), "Set compact coefficients");
+
+        /// <summary>Largest difference from float coefficients, in output counts</summary>
+        public int ErrorBound
+        {
+            get
+            {
+                int counts;
+                HubxException.Check(Native.hubx_xog_get_error_bound(Handle, &counts), "Get error bound");
+                return counts;
+            }
+        }
+
+        /// <summary>
+        /// Gain from the median of this many bright group means, so frames with
+        /// cosmic hits are rejected; below 2 the plain mean is used
+        /// </summary>
+        public void SetRobustGain(int groups) =>
+            HubxException.Check(Native.hubx_xog_set_robust_gain(Handle, groups), "Set robust gain");
+
+        /// <summary>
+        /// Linear ceiling of every pixel from the last gain calibration: 4 bits per
+        /// pixel, even pixel in the low nibble; code c = linear below c / 15 of
+        /// full scale, 0 = saturated
+        /// </summary>
+        public byte[] GetSaturationMap()
+        {
+            var (width, height) = Size;
+            var map = new byte[((long)width * height + 1) / 2];
+            fixed (byte* p = map)
+            {
+                HubxException.Check(Native.hubx_xog_get_saturation_map(Handle, p, map.Length), "Get saturation map");
+            }
+            return map;
+        }
+
+        /// <summary>Pixels per saturation map code; [0] is the saturated pixels</summary>
+        public ulong[] GetSaturationCounts()
+        {
+            var counts = new ulong[16];
+            fixed (ulong* p = counts)
+            {
+                HubxException.Check(Native.hubx_xog_get_saturation_counts(Handle, p), "Get saturation counts");
+            }
+            return counts;
+        }
+
+        /// <summary>
+        /// Calibrate per detector module of modulePixels columns (XDM_PIX_NUM);
+        /// 0 = one calibration for the whole width
+        /// </summary>
+        public void SetModules(int modulePixels) =>
+            HubxException.Check(Native.hubx_xog_set_modules(Handle, modulePixels), "Set modules");
+
+        /// <summary>Module the finalize calls write, -1 for all</summary>
+        public void SetModuleScope(int module) =>
+            HubxException.Check(Native.hubx_xog_set_module_scope(Handle, module), "Set module scope");
+
+        /// <summary>Rewrite one module's maps in a file saved with modules</summary>
+        public void SaveModule(string file, int module) =>
+            HubxException.Check(Native.hubx_xog_save_module(Handle, file, module), "Save module calibration");
+
+        /// <summary>Replace one module's calibration from a file saved with modules</summary>
+        public void LoadModule(string file, int module) =>
+            HubxException.Check(Native.hubx_xog_load_module(Handle, file, module), "Load module calibration");
+
+        /// <summary>Save only what changed since baseFile was saved</summary>
+        public void SaveDelta(string file, string baseFile) =>
+            HubxException.Check(Native.hubx_xog_save_delta(Handle, file, baseFile), "Save calibration delta");
+
+        /// <summary>Load a full file with a delta saved against it</summary>
+        public void LoadDelta(string baseFile, string deltaFile) =>
+            HubxException.Check(Native.hubx_xog_load_delta(Handle, baseFile, deltaFile), "Load calibration delta");
+
+        /// <summary>Take the changes of a delta whose base is the loaded calibration</summary>
+        public void ApplyDelta(string deltaFile) =>
+            HubxException.Check(Native.hubx_xog_apply_delta(Handle, deltaFile), "Apply calibration delta");
+
+        /// <summary>Correct a frame in place, in its pool buffer</summary>
+        public void Apply(in Frame frame)
+        {
+            if (frame.IsPacked)
+            {
+                ushort* pixels = (ushort*)frame.Data;
+                HubxException.Check(Native.hubx_xog_apply(Handle, pixels, pixels), "Correct frame");
+                return;
+            }
+            ushort* packed = Packed(frame);
+            HubxException.Check(Native.hubx_xog_apply(Handle, packed, packed), "Correct frame");
+            for (int row = 0; row < frame.Height; row++)
+            {
+                new Span<ushort>(packed + (long)row * frame.Width, frame.Width).CopyTo(frame.Row(row));
+            }
+        }
+
+        public void Dispose()
+        {
+            Destroy();
+            GC.SuppressFinalize(this);
+        }
+
+        private IntPtr Handle
+        {
+            get
+            {
+                if (_handle == IntPtr.Zero)
+                {
+                    throw new ObjectDisposedException(nameof(XogCorrection));
+                }
+                return _handle;
+            }
+        }
+
+        private ushort* Packed(in Frame frame)
+        {
+            if (frame.BytesPerPixel != 2)
+            {
+                throw new ArgumentException("Correction takes 16-bit frames", nameof(frame));
+            }
+            if (frame.IsPacked)
+            {
+                return (ushort*)frame.Data;
+            }
+            int length = frame.Width * frame.Height;
+            if (_packedLength < length)
+            {
+                Marshal.FreeHGlobal((IntPtr)_packed);
+                _packed = (ushort*)Marshal.AllocHGlobal(length * sizeof(ushort));
+                _packedLength = length;
+            }
+            for (int row = 0; row < frame.Height; row++)
+            {
+                frame.Row(row).CopyTo(new Span<ushort>(_packed + (long)row * frame.Width, frame.Width));
+            }
+            return _packed;
+        }
+
+        private void Destroy()
+        {
+            IntPtr handle = Interlocked.Exchange(ref _handle, IntPtr.Zero);
+            if (handle != IntPtr.Zero)
+            {
+                Native.hubx_xog_destroy(handle);
+            }
+            if (_packed != null)
+            {
+                Marshal.FreeHGlobal((IntPtr)_packed);
+                _packed = null;
+                _packedLength = 0;
+            }
+        }
+    }
+
+    /// <summary>Entry points of the hubx library; every argument is blittable</summary>
+    internal static unsafe class Native
+    {
+        private const string Library = "hubx";
+
+        [StructLayout(LayoutKind.Sequential)]
+        public struct DetectorConfig
+        {
+            public IntPtr Ip;
+            public ushort CommandPort;
+            public ushort ImagePort;
+            public fixed byte Mac[6];
+            public IntPtr Serial;
+            public uint PixelCount;
+            public uint ModuleCount;
+            public uint PixelDepth;
+        }
+
+        [StructLayout(LayoutKind.Sequential)]
+        public struct Callbacks
+        {
+            public delegate* unmanaged[Cdecl]<NativeFrame*, IntPtr, void> Frame;
+            public delegate* unmanaged[Cdecl]<uint, IntPtr, IntPtr, void> Error;
+            public delegate* unmanaged[Cdecl]<uint, uint, IntPtr, void> Event;
+            public IntPtr User;
+        }
+
+        [StructLayout(LayoutKind.Sequential)]
+        public struct AcquisitionConfig
+        {
+            public uint LinesPerFrame;
+            public uint PoolSize;
+            public uint Segments;
+            public uint LineHeader;
+            public uint Frames;
+        }
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl)]
+        public static extern IntPtr hubx_device_create(DetectorConfig* config);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl)]
+        public static extern void hubx_device_destroy(IntPtr handle);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int hubx_device_open(IntPtr handle);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl)]
+        public static extern void hubx_device_close(IntPtr handle);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int hubx_control_read(IntPtr handle, int code, byte index, ulong* value);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int hubx_control_write(IntPtr handle, int code, ulong value, byte index);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int hubx_control_operate(IntPtr handle, int code, ulong data);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int hubx_acq_set_callbacks(IntPtr handle, Callbacks* callbacks);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int hubx_acq_start(IntPtr handle, AcquisitionConfig* config);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int hubx_acq_stop(IntPtr handle, uint timeoutMs);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int hubx_frame_release(IntPtr handle, IntPtr token);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl)]
+        public static extern uint hubx_acq_free_buffers(IntPtr handle);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl)]
+        public static extern IntPtr hubx_xog_create();
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl)]
+        public static extern void hubx_xog_destroy(IntPtr handle);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, CharSet = CharSet.Ansi, BestFitMapping = false)]
+        public static extern int hubx_xog_load(IntPtr handle, string file);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, CharSet = CharSet.Ansi, BestFitMapping = false)]
+        public static extern int hubx_xog_save(IntPtr handle, string file);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int hubx_xog_init(IntPtr handle, int width, int height, int bitDepth);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int hubx_xog_add_dark(IntPtr handle, ushort* frame);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int hubx_xog_finalize_offset(IntPtr handle);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int hubx_xog_add_bright(IntPtr handle, ushort* frame);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int hubx_xog_finalize_gain(IntPtr handle, ushort target);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int hubx_xog_discard_frames(IntPtr handle);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int hubx_xog_get_size(IntPtr handle, int* width, int* height);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int hubx_xog_apply(IntPtr handle, ushort* input, ushort* output);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int hubx_xog_get_version(IntPtr handle, ulong* version);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int hubx_xog_set_compact(IntPtr handle, int maxError);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int hubx_xog_get_error_bound(IntPtr handle, int* counts);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int hubx_xog_set_robust_gain(IntPtr handle, int groups);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int hubx_xog_get_saturation_map(IntPtr handle, byte* map, int size);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int hubx_xog_get_saturation_counts(IntPtr handle, ulong* counts);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int hubx_xog_set_modules(IntPtr handle, int modulePixels);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int hubx_xog_set_module_scope(IntPtr handle, int module);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, CharSet = CharSet.Ansi, BestFitMapping = false)]
+        public static extern int hubx_xog_save_module(IntPtr handle, string file, int module);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, CharSet = CharSet.Ansi, BestFitMapping = false)]
+        public static extern int hubx_xog_load_module(IntPtr handle, string file, int module);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, CharSet = CharSet.Ansi, BestFitMapping = false)]
+        public static extern int hubx_xog_save_delta(IntPtr handle, string file, string baseFile);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, CharSet = CharSet.Ansi, BestFitMapping = false)]
+        public static extern int hubx_xog_load_delta(IntPtr handle, string baseFile, string deltaFile);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, CharSet = CharSet.Ansi, BestFitMapping = false)]
+        public static extern int hubx_xog_apply_delta(IntPtr handle, string deltaFile);
+    }
+}
@@ -0,0 +1,85 @@
+// ============================================================================
+// bench_frames.h
+// ============================================================================
+
+/**
+ * @file bench_frames.h
+ * @brief Synthetic frames and throughput counters for the kernel benchmarks
+ * @version 2.1.0
+ *
+ * Frames are 16-bit line-scan captures: widths from 1K to 8K pixels (one to
+ * eight 1024-pixel detector rows side by side) and FRAME_LINES lines, large
+ * enough that each run leaves the caches like a real frame does.
+ */
+
+#ifndef BENCH_FRAMES_H
+#define BENCH_FRAMES_H
+
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <vector>
+
+namespace HX {
+namespace Bench {
+
+/// Lines per synthetic frame
+const int FRAME_LINES = 512;
+
+/**
+ * @brief Register the detector widths a benchmark runs at
+ */
+inline void frameWidths(benchmark::internal::Benchmark* b) {
+    for (int width = 1024; width <= 8192; width *= 2) {
+        b->Arg(width);
+    }
+    b->Unit(benchmark::kMicrosecond)->UseRealTime();
+}
+
+/**
+ * @brief Raw frame: a bright field with column structure and noise
+ * @param width Pixels per line
+ * @param height Lines
+ * @param mean Mean level
+ * @param spread Peak-to-peak noise, at most mean
+ */
+inline std::vector<unsigned short> makeFrame(int width, int height,
+                                             unsigned short mean, unsigned short spread) {
+    std::vector<unsigned short> frame(static_cast<size_t>(width) * height);
+    uint32_t state = 0x9E3779B9u;
+    for (size_t i = 0; i < frame.size(); ++i) {
+        // xorshift32, reproducible between runs
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        const int column = static_cast<int>(i % width) % 64;
+        frame[i] = static_cast<unsigned short>(mean - spread / 2 + column + state % (spread - 64u));
+    }
+    return frame;
+}
+
+/**
+ * @brief Per-pixel gain map around 1.0
+ */
+inline std::vector<float> makeGain(int width, int height) {
+    std::vector<float> gain(static_cast<size_t>(width) * height);
+    for (size_t i = 0; i < gain.size(); ++i) {
+        gain[i] = 0.9f + static_cast<float>((i * 2654435761u) % 1000) / 5000.0f;
+    }
+    return gain;
+}
+
+/**
+ * @brief Report pixels/s and bytes/s
+ * @param state Benchmark state
+ * @param pixels Pixels processed per iteration
+ * @param bytesPerPixel Bytes read and written per pixel
+ */
+inline void setThroughput(benchmark::State& state, int64_t pixels, int64_t bytesPerPixel) {
+    state.SetItemsProcessed(state.iterations() * pixels);
+    state.SetBytesProcessed(state.iterations() * pixels * bytesPerPixel);
+}
+
+} // namespace Bench
+} // namespace HX
+
+#endif // BENCH_FRAMES_H
@@ -0,0 +1,70 @@
+// ============================================================================
+// bench_fusion.cpp
+// ============================================================================
+
+/**
+ * @file bench_fusion.cpp
+ * @brief DualEnergyFusion throughput, every fusion mode
+ * @version 2.1.0
+ *
+ * DualEnergyFusion is not exported, so the kernel source is compiled into
+ * this translation unit.
+ */
+
+#include "../src/correction/dual_energy_fusion.cpp"
+#include "bench_frames.h"
+
+namespace {
+
+using namespace HX::Bench;
+using HubxSDK::Correction::DualEnergyFusion;
+using HubxSDK::Correction::FusionMode;
+
+const char* modeName(FusionMode mode) {
+    switch (mode) {
+        case HubxSDK::Correction::FUSION_WEIGHTED_AVERAGE:       return "weighted";
+        case HubxSDK::Correction::FUSION_MATERIAL_DECOMPOSITION: return "material";
+        case HubxSDK::Correction::FUSION_ADAPTIVE:               return "adaptive";
+        case HubxSDK::Correction::FUSION_LOGARITHMIC:            return "logarithmic";
+        default:                                                 return "custom";
+    }
+}
+
+/**
+ * @brief Fusion of one high/low energy frame pair
+ * @param state range(0) width, range(1) FusionMode
+ */
+void BM_DualEnergyFusion(benchmark::State& state) {
+    const int width = static_cast<int>(state.range(0));
+    const FusionMode mode = static_cast<FusionMode>(state.range(1));
+
+    DualEnergyFusion fusion;
+    fusion.initialize(width, FRAME_LINES);
+    fusion.setFusionWeights(0.6f, 0.4f);
+    fusion.setFusionMode(mode);
+
+    const std::vector<unsigned short> high = makeFrame(width, FRAME_LINES, 40000, 8000);
+    const std::vector<unsigned short> low = makeFrame(width, FRAME_LINES, 20000, 8000);
+    std::vector<unsigned short> output(high.size());
+    for (auto _ : state) {
+        fusion.fuse(high.data(), low.data(), output.data(), 16);
+        benchmark::DoNotOptimize(output.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetLabel(modeName(mode));
+    setThroughput(state, static_cast<int64_t>(width) * FRAME_LINES, 2 + 2 + 2);
+}
+
+void fusionArgs(benchmark::internal::Benchmark* b) {
+    for (int mode = HubxSDK::Correction::FUSION_WEIGHTED_AVERAGE;
+         mode <= HubxSDK::Correction::FUSION_CUSTOM; ++mode) {
+        for (int width = 1024; width <= 8192; width *= 2) {
+            b->Args({ width, mode });
+        }
+    }
+    b->Unit(benchmark::kMicrosecond)->UseRealTime();
+}
+
+BENCHMARK(BM_DualEnergyFusion)->Apply(fusionArgs);
+
+} // namespace
@@ -0,0 +1,55 @@
+// ============================================================================
+// bench_gain.cpp
+// ============================================================================
+
+/**
+ * @file bench_gain.cpp
+ * @brief SmoothGainCoefficients throughput
+ * @version 2.1.0
+ *
+ * The gain helpers have no public header, so the kernel source is compiled
+ * into this translation unit.
+ */
+
+#include "../src/correction/gain_correction.cpp"
+#include "bench_frames.h"
+
+namespace {
+
+using namespace HX::Bench;
+
+/**
+ * @brief Box smoothing of one gain map
+ * @param state range(0) width, range(1) kernel size
+ */
+void BM_SmoothGainCoefficients(benchmark::State& state) {
+    const int width = static_cast<int>(state.range(0));
+    const int kernel = static_cast<int>(state.range(1));
+
+    const std::vector<float> gain = makeGain(width, FRAME_LINES);
+    std::vector<float> smoothed(gain.size());
+    for (auto _ : state) {
+        // Smooths in place, so every run starts from the same map
+        state.PauseTiming();
+        smoothed = gain;
+        state.ResumeTiming();
+        fximage::SmoothGainCoefficients(smoothed.data(), width, FRAME_LINES, kernel);
+        benchmark::DoNotOptimize(smoothed.data());
+        benchmark::ClobberMemory();
+    }
+    setThroughput(state, static_cast<int64_t>(width) * FRAME_LINES, 4 + 4);
+}
+
+void smoothArgs(benchmark::internal::Benchmark* b) {
+    const int kernels[] = { 3, 15 };
+    for (int k = 0; k < 2; ++k) {
+        for (int width = 1024; width <= 8192; width *= 2) {
+            b->Args({ width, kernels[k] });
+        }
+    }
+    b->Unit(benchmark::kMicrosecond)->UseRealTime();
+}
+
+BENCHMARK(BM_SmoothGainCoefficients)->Apply(smoothArgs);
+
+} // namespace
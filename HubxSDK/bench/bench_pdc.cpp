@@ -0,0 +1,86 @@
+// ============================================================================
+// bench_pdc.cpp
+// ============================================================================
+
+/**
+ * @file bench_pdc.cpp
+ * @brief ApplyPDCCorrection throughput
+ * @version 2.1.0
+ *
+ * PDCCorrectionParams is not exported, so the kernel source is compiled
+ * into this translation unit.
+ */
+
+#include "../src/correction/pdc_correction.cpp"
+#include "bench_frames.h"
+
+namespace {
+
+using namespace HX::Bench;
+
+/// X-card layout: 64-pixel cards with 2-pixel gaps
+const int XCARD_PIXELS = 64;
+const int XCARD_GAP = 2;
+
+std::vector<float> gapPositions(int width) {
+    std::vector<float> gaps;
+    for (int x = XCARD_PIXELS; x + XCARD_GAP < width; x += XCARD_PIXELS + XCARD_GAP) {
+        gaps.push_back(static_cast<float>(x));
+    }
+    return gaps;
+}
+
+fximage::PDCCorrectionParams pdcParams(std::vector<float>& gaps) {
+    fximage::PDCCorrectionParams params;
+    params.num_xcards = static_cast<int>(gaps.size()) + 1;
+    params.pixels_per_xcard = XCARD_PIXELS;
+    params.gap_width = XCARD_GAP;
+    params.enable_interpolation = true;
+    params.gap_positions = gaps.data();
+    params.num_gaps = static_cast<int>(gaps.size());
+    return params;
+}
+
+/**
+ * @brief PDC resampling of one frame, plan built per call
+ * @param state range(0) input width
+ */
+void BM_ApplyPDCCorrection(benchmark::State& state) {
+    const int width = static_cast<int>(state.range(0));
+    std::vector<float> gaps = gapPositions(width);
+    const fximage::PDCCorrectionParams params = pdcParams(gaps);
+
+    const std::vector<unsigned short> input = makeFrame(width, FRAME_LINES, 30000, 4000);
+    std::vector<unsigned short> output(input.size());
+    for (auto _ : state) {
+        fximage::ApplyPDCCorrection(input.data(), output.data(), width, FRAME_LINES, params);
+        benchmark::DoNotOptimize(output.data());
+        benchmark::ClobberMemory();
+    }
+    setThroughput(state, static_cast<int64_t>(width) * FRAME_LINES, 2 + 2);
+}
+
+/**
+ * @brief PDC resampling of one frame with a prebuilt plan
+ * @param state range(0) input width
+ */
+void BM_ApplyPDCPlan(benchmark::State& state) {
+    const int width = static_cast<int>(state.range(0));
+    std::vector<float> gaps = gapPositions(width);
+    fximage::PDCPlan plan;
+    fximage::BuildPDCPlan(width, pdcParams(gaps), plan);
+
+    const std::vector<unsigned short> input = makeFrame(width, FRAME_LINES, 30000, 4000);
+    std::vector<unsigned short> output(static_cast<size_t>(plan.output_width) * FRAME_LINES);
+    for (auto _ : state) {
+        fximage::ApplyPDCPlan(plan, input.data(), output.data(), FRAME_LINES);
+        benchmark::DoNotOptimize(output.data());
+        benchmark::ClobberMemory();
+    }
+    setThroughput(state, static_cast<int64_t>(width) * FRAME_LINES, 2 + 2);
+}
+
+BENCHMARK(BM_ApplyPDCCorrection)->Apply(frameWidths);
+BENCHMARK(BM_ApplyPDCPlan)->Apply(frameWidths);
+
+} // namespace
@@ -0,0 +1,71 @@
+// ============================================================================
+// bench_xmg.cpp
+// ============================================================================
+
+/**
+ * @file bench_xmg.cpp
+ * @brief ApplyMultiGainCorrection throughput
+ * @version 2.1.0
+ *
+ * MultiGainParams is not exported, so the kernel source is compiled into
+ * this translation unit.
+ */
+
+#include "../src/correction/xmg_correct.cpp"
+#include "bench_frames.h"
+
+namespace {
+
+using namespace HX::Bench;
+
+/**
+ * @brief Multi-gain correction of one frame
+ * @param state range(0) width, range(1) gain mode (-1 = per-pixel switching)
+ */
+void BM_ApplyMultiGainCorrection(benchmark::State& state) {
+    const int width = static_cast<int>(state.range(0));
+    const int gainMode = static_cast<int>(state.range(1));
+    const int gains = 2;
+    const size_t pixels = static_cast<size_t>(width) * FRAME_LINES;
+
+    fximage::MultiGainParams params = fximage::MultiGainParams();
+    fximage::InitMultiGainCorrection(params, gains, width, FRAME_LINES);
+    params.bit_depth = 16;
+    params.thresholds[0] = 20000;
+    params.thresholds[1] = 65535;
+    const std::vector<float> gain = makeGain(width, FRAME_LINES);
+    const std::vector<unsigned short> offset = makeFrame(width, FRAME_LINES, 1000, 200);
+    for (int g = 0; g < gains; ++g) {
+        for (size_t i = 0; i < pixels; ++i) {
+            params.gain_coeffs[g][i] = gain[i] * static_cast<float>(g + 1);
+            params.offset_data[g][i] = offset[i];
+        }
+    }
+    std::fill(params.baseline_data, params.baseline_data + pixels, static_cast<unsigned short>(0));
+
+    // Straddles the threshold, so switching picks both modes
+    const std::vector<unsigned short> input = makeFrame(width, FRAME_LINES, 20000, 16000);
+    std::vector<unsigned short> output(pixels);
+    for (auto _ : state) {
+        fximage::ApplyMultiGainCorrection(input.data(), output.data(), width, FRAME_LINES,
+                                          params, gainMode);
+        benchmark::DoNotOptimize(output.data());
+        benchmark::ClobberMemory();
+    }
+    fximage::ReleaseMultiGainCorrection(params);
+    // Input, offset, gain, baseline and output of the selected mode
+    setThroughput(state, static_cast<int64_t>(pixels), 2 + 2 + 4 + 2 + 2);
+}
+
+void xmgArgs(benchmark::internal::Benchmark* b) {
+    for (int mode = -1; mode <= 0; ++mode) {
+        for (int width = 1024; width <= 8192; width *= 2) {
+            b->Args({ width, mode });
+        }
+    }
+    b->Unit(benchmark::kMicrosecond)->UseRealTime();
+}
+
+BENCHMARK(BM_ApplyMultiGainCorrection)->Apply(xmgArgs);
+
+} // namespace
@@ -0,0 +1,61 @@
+// ============================================================================
+// bench_xog.cpp
+// ============================================================================
+
+/**
+ * @file bench_xog.cpp
+ * @brief XOGCorrect::ApplyCorrection throughput
+ * @version 2.1.0
+ *
+ * XOGCorrect is not exported, so the kernel source is compiled into this
+ * translation unit.
+ */
+
+#include "../src/correction/xog_correct.cpp"
+#include "bench_frames.h"
+
+namespace {
+
+using namespace HX::Bench;
+
+/**
+ * @brief Offset and gain correction of one frame
+ * @param state range(0) width, range(1) 1 = fixed point, 0 = float
+ */
+void BM_XOGApplyCorrection(benchmark::State& state) {
+    const int width = static_cast<int>(state.range(0));
+    const bool fixedPoint = state.range(1) != 0;
+
+    fximage::XOGCorrect correct;
+    correct.Initialize(width, FRAME_LINES, 16);
+    const std::vector<unsigned short> offset = makeFrame(width, FRAME_LINES, 1000, 200);
+    const std::vector<float> gain = makeGain(width, FRAME_LINES);
+    correct.SetOffsetData(offset.data());
+    correct.SetGainData(gain.data());
+    correct.SetCorrectionMode(true, true, false);
+    correct.SetFixedPoint(fixedPoint);
+
+    const std::vector<unsigned short> input = makeFrame(width, FRAME_LINES, 30000, 4000);
+    std::vector<unsigned short> output(input.size());
+    for (auto _ : state) {
+        correct.ApplyCorrection(input.data(), output.data());
+        benchmark::DoNotOptimize(output.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetLabel(correct.IsFixedPointActive() ? "fixed" : "float");
+    // Input, offset, gain and output
+    setThroughput(state, static_cast<int64_t>(width) * FRAME_LINES, 2 + 2 + 4 + 2);
+}
+
+void xogArgs(benchmark::internal::Benchmark* b) {
+    for (int fixedPoint = 0; fixedPoint <= 1; ++fixedPoint) {
+        for (int width = 1024; width <= 8192; width *= 2) {
+            b->Args({ width, fixedPoint });
+        }
+    }
+    b->Unit(benchmark::kMicrosecond)->UseRealTime();
+}
+
+BENCHMARK(BM_XOGApplyCorrection)->Apply(xogArgs);
+
+} // namespace
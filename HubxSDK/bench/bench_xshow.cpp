@@ -0,0 +1,176 @@
+// ============================================================================
+// bench_xshow.cpp
+// ============================================================================
+
+/**
+ * @file bench_xshow.cpp
+ * @brief XShow colormapping throughput
+ * @version 2.1.0
+ *
+ * XShow needs a window, so this runs its per-frame conversion without one:
+ * the window kernel to 8-bit levels, then the level -> BGR lookup into a
+ * 32-bit display buffer, in row bands on the shared pool, as
+ * XShow::Impl::applyColorMapRows does for 16-bit frames. The material
+ * variant adds the (high, low) class lookup of Show(high, low); the CLAHE
+ * variant is the SetContrastEnhancement() stage that replaces the window.
+ */
+
+#include "XImage.h"
+#include "utils/clahe.h"
+#include "utils/material_class.h"
+#include "utils/thread_pool.h"
+#include "utils/window_level.h"
+#include "bench_frames.h"
+#include <cstring>
+
+namespace {
+
+using namespace HX::Bench;
+using HX::Internal::WindowKernel;
+using HX::Internal::WindowParams;
+
+/**
+ * @brief Window kernel alone
+ * @param state range(0) width
+ */
+void BM_XShowWindow(benchmark::State& state) {
+    const int width = static_cast<int>(state.range(0));
+    const WindowKernel kernel = HX::Internal::selectWindowKernel();
+    const WindowParams window = HX::Internal::makeWindow(26000, 34000, 16);
+
+    const std::vector<unsigned short> input = makeFrame(width, FRAME_LINES, 30000, 4000);
+    std::vector<uint8_t> levels(input.size());
+    for (auto _ : state) {
+        kernel(reinterpret_cast<const uint8_t*>(input.data()), levels.data(),
+               static_cast<uint32_t>(input.size()), window);
+        benchmark::DoNotOptimize(levels.data());
+        benchmark::ClobberMemory();
+    }
+    setThroughput(state, static_cast<int64_t>(width) * FRAME_LINES, 2 + 1);
+}
+
+/**
+ * @brief Window and colormap of one frame to a BGRX display buffer
+ * @param state range(0) width
+ */
+void BM_XShowColorMap(benchmark::State& state) {
+    const int width = static_cast<int>(state.range(0));
+    const uint32_t pixelBytes = 4;
+    const WindowKernel kernel = HX::Internal::selectWindowKernel();
+    const WindowParams window = HX::Internal::makeWindow(26000, 34000, 16);
+
+    // Any map costs the same; a hot-style ramp keeps the three channels apart
+    std::vector<uint8_t> lut(256 * 3);
+    for (int i = 0; i < 256; ++i) {
+        lut[i * 3 + 0] = static_cast<uint8_t>(i < 192 ? 0 : (i - 192) * 4);
+        lut[i * 3 + 1] = static_cast<uint8_t>(i < 96 ? 0 : std::min(255, (i - 96) * 8 / 3));
+        lut[i * 3 + 2] = static_cast<uint8_t>(std::min(255, i * 8 / 3));
+    }
+
+    const std::vector<unsigned short> input = makeFrame(width, FRAME_LINES, 30000, 4000);
+    const size_t stride = static_cast<size_t>(width) * pixelBytes;
+    std::vector<uint8_t> display(stride * FRAME_LINES);
+    for (auto _ : state) {
+        HX::Internal::ThreadPool::instance().parallelRows(FRAME_LINES, width,
+            [&](int firstRow, int endRow) {
+                std::vector<uint8_t> levels(width);
+                for (int row = firstRow; row < endRow; ++row) {
+                    kernel(reinterpret_cast<const uint8_t*>(input.data() +
+                               static_cast<size_t>(row) * width),
+                           levels.data(), static_cast<uint32_t>(width), window);
+                    uint8_t* out = display.data() + static_cast<size_t>(row) * stride;
+                    for (int col = 0; col < width; ++col) {
+                        const uint8_t* bgr = lut.data() + static_cast<size_t>(levels[col]) * 3;
+                        uint8_t* pixel = out + col * pixelBytes;
+                        pixel[0] = bgr[0];
+                        pixel[1] = bgr[1];
+                        pixel[2] = bgr[2];
+                    }
+                }
+            });
+        benchmark::DoNotOptimize(display.data());
+        benchmark::ClobberMemory();
+    }
+    setThroughput(state, static_cast<int64_t>(width) * FRAME_LINES, 2 + pixelBytes);
+}
+
+/**
+ * @brief Window, material class and color of a dual-energy pair to BGRX
+ * @param state range(0) width
+ */
+void BM_XShowMaterialMap(benchmark::State& state) {
+    const int width = static_cast<int>(state.range(0));
+    const uint32_t pixelBytes = 4;
+    const WindowKernel kernel = HX::Internal::selectWindowKernel();
+    const WindowParams window = HX::Internal::makeWindow(26000, 34000, 16);
+    const HX::Internal::MaterialModel model;
+    const uint32_t bits = static_cast<uint32_t>(HX::Internal::MaterialTableBits(model, 16));
+    const uint32_t shift = 16 - bits;
+    std::vector<uint16_t> table;
+    HX::Internal::BuildMaterialTable(model, 16, table);
+
+    // Class x level; the values do not change the cost
+    std::vector<uint8_t> lut(HX::Internal::MATERIAL_CLASSES * 256 * 3);
+    for (size_t i = 0; i < lut.size(); ++i) {
+        lut[i] = static_cast<uint8_t>(i * 7);
+    }
+
+    const std::vector<unsigned short> high = makeFrame(width, FRAME_LINES, 30000, 4000);
+    const std::vector<unsigned short> low = makeFrame(width, FRAME_LINES, 20000, 4000);
+    const size_t stride = static_cast<size_t>(width) * pixelBytes;
+    std::vector<uint8_t> display(stride * FRAME_LINES);
+    for (auto _ : state) {
+        HX::Internal::ThreadPool::instance().parallelRows(FRAME_LINES, width * 2,
+            [&](int firstRow, int endRow) {
+                std::vector<uint8_t> levels(width);
+                for (int row = firstRow; row < endRow; ++row) {
+                    const unsigned short* h = high.data() + static_cast<size_t>(row) * width;
+                    const unsigned short* l = low.data() + static_cast<size_t>(row) * width;
+                    kernel(reinterpret_cast<const uint8_t*>(h), levels.data(),
+                           static_cast<uint32_t>(width), window);
+                    uint8_t* out = display.data() + static_cast<size_t>(row) * stride;
+                    for (int col = 0; col < width; ++col) {
+                        const uint32_t cell = (static_cast<uint32_t>(h[col] >> shift) << bits) |
+                                              (l[col] >> shift);
+                        const uint32_t materialClass = table[cell] >> HX::Internal::MATERIAL_CLASS_SHIFT;
+                        const uint8_t* bgr = lut.data() + (materialClass * 256 + levels[col]) * 3;
+                        uint8_t* pixel = out + col * pixelBytes;
+                        pixel[0] = bgr[0];
+                        pixel[1] = bgr[1];
+                        pixel[2] = bgr[2];
+                    }
+                }
+            });
+        benchmark::DoNotOptimize(display.data());
+        benchmark::ClobberMemory();
+    }
+    setThroughput(state, static_cast<int64_t>(width) * FRAME_LINES, 2 * 2 + pixelBytes);
+}
+
+/**
+ * @brief Tiled CLAHE of one frame to 8-bit levels, without the kept result
+ * @param state range(0) width
+ */
+void BM_XShowClahe(benchmark::State& state) {
+    const int width = static_cast<int>(state.range(0));
+    const std::vector<unsigned short> input = makeFrame(width, FRAME_LINES, 30000, 4000);
+    HX::XImage image;
+    image.Allocate(static_cast<uint32_t>(width), FRAME_LINES, 16);
+    memcpy(image._data_ + image._data_offset, input.data(), input.size() * sizeof(unsigned short));
+
+    HX::Internal::Clahe clahe;
+    clahe.configure(8, 2.5f);
+    for (auto _ : state) {
+        clahe.invalidate();
+        benchmark::DoNotOptimize(clahe.levels(image));
+        benchmark::ClobberMemory();
+    }
+    setThroughput(state, static_cast<int64_t>(width) * FRAME_LINES, 2 + 1);
+}
+
+BENCHMARK(BM_XShowWindow)->Apply(frameWidths);
+BENCHMARK(BM_XShowColorMap)->Apply(frameWidths);
+BENCHMARK(BM_XShowMaterialMap)->Apply(frameWidths);
+BENCHMARK(BM_XShowClahe)->Apply(frameWidths);
+
+} // namespace
@@ -0,0 +1,226 @@
+// ============================================================================
+// golden.h
+// ============================================================================
+
+/**
+ * @file golden.h
+ * @brief Golden-output checks of the optimized correction kernels
+ * @version 2.1.0
+ *
+ * Each golden_*.cpp compiles one kernel source, like the benchmarks do, and
+ * registers a check that runs the scalar kernel and every optimized variant
+ * on the same frames. Context::compare() records the largest difference
+ * against the variant's documented bound (0 = bit-exact) and
+ * Context::time() the cost of both, for the speedup column of the report.
+ */
+
+#ifndef GOLDEN_H
+#define GOLDEN_H
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace HX {
+namespace Golden {
+
+/**
+ * @brief One 16-bit input frame
+ */
+struct Frame {
+    std::string name;
+    int width;
+    int height;
+    std::vector<unsigned short> pixels;
+
+    size_t count() const { return pixels.size(); }
+};
+
+/**
+ * @brief Frames, filters and results of one hx_golden run
+ */
+class Context {
+public:
+    Context() : m_minSeconds(0.01), m_failures(0) {}
+
+    /// Randomized, edge-case and recorded (--raw) frames
+    const std::vector<Frame>& frames() const { return m_frames; }
+    std::vector<Frame>& frames() { return m_frames; }
+
+    void setFilter(const std::string& filter) { m_filter = filter; }
+    void setMinSeconds(double seconds) { m_minSeconds = seconds; }
+
+    /// false if --kernel excludes the kernel
+    bool selected(const std::string& kernel) const {
+        return m_filter.empty() || kernel.find(m_filter) != std::string::npos;
+    }
+
+    /**
+     * @brief Seconds per call of fn, repeated until --min-time has passed
+     */
+    template <typename Fn>
+    double time(Fn fn) const {
+        typedef std::chrono::steady_clock Clock;
+        const Clock::time_point start = Clock::now();
+        uint64_t calls = 0;
+        double elapsed = 0.0;
+        do {
+            fn();
+            ++calls;
+            elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+        } while (elapsed < m_minSeconds);
+        return elapsed / calls;
+    }
+
+    /**
+     * @brief Compare a variant's output with the scalar reference
+     * @param bound Largest allowed |output - reference|, 0 = bit-exact
+     */
+    template <typename T>
+    void compare(const std::string& kernel, const std::string& variant, const Frame& frame,
+                 const T* reference, const T* output, size_t count, int bound) {
+        int maxDiff = 0;
+        uint64_t mismatches = 0;
+        size_t first = count;
+        for (size_t i = 0; i < count; ++i) {
+            const int diff = std::abs(static_cast<int>(output[i]) - static_cast<int>(reference[i]));
+            if (diff != 0) {
+                ++mismatches;
+                if (diff > maxDiff) maxDiff = diff;
+                if (first == count && diff > bound) first = i;
+            }
+        }
+        Result& r = result(kernel, variant);
+        r.frames++;
+        r.bound = bound;
+        r.mismatches += mismatches;
+        if (maxDiff > r.maxDiff) r.maxDiff = maxDiff;
+        if (maxDiff > bound) {
+            ++m_failures;
+            if (r.firstFailure.empty()) {
+                r.firstFailure = frame.name + " pixel " + std::to_string(first) + ": " +
+                                 std::to_string(static_cast<int>(output[first])) + " vs " +
+                                 std::to_string(static_cast<int>(reference[first]));
+            }
+        }
+    }
+
+    /// Add the cost of one frame to the variant's speedup
+    void timing(const std::string& kernel, const std::string& variant,
+                double referenceSeconds, double variantSeconds) {
+        Result& r = result(kernel, variant);
+        r.referenceSeconds += referenceSeconds;
+        r.variantSeconds += variantSeconds;
+    }
+
+    /// Record a variant this build or CPU cannot run
+    void skip(const std::string& kernel, const std::string& variant, const char* reason) {
+        result(kernel, variant).skipped = reason;
+    }
+
+    /// Print the report; returns the number of failed comparisons
+    int report() const;
+
+private:
+    struct Result {
+        uint32_t frames;
+        int maxDiff;
+        int bound;
+        uint64_t mismatches;
+        double referenceSeconds;
+        double variantSeconds;
+        std::string firstFailure;
+        const char* skipped;
+
+        Result()
+            : frames(0), maxDiff(0), bound(0), mismatches(0), referenceSeconds(0),
+              variantSeconds(0), skipped(nullptr) {}
+    };
+
+    Result& result(const std::string& kernel, const std::string& variant);
+
+    std::vector<Frame> m_frames;
+    std::string m_filter;
+    double m_minSeconds;
+    int m_failures;
+    std::vector<std::pair<std::string, std::string> > m_order;
+    std::map<std::pair<std::string, std::string>, Result> m_results;
+};
+
+typedef void (*CheckFn)(Context& context);
+
+/**
+ * @brief Register a check at static initialization
+ */
+class Registrar {
+public:
+    Registrar(const char* kernel, CheckFn check);
+};
+
+/// Checks in registration order
+const std::vector<std::pair<const char*, CheckFn> >& checks();
+
+/**
+ * @brief Reproducible values in [low, high] (xorshift32)
+ */
+class Random {
+public:
+    explicit Random(uint32_t seed) : m_state(seed ? seed : 0x9E3779B9u) {}
+
+    uint32_t next() {
+        m_state ^= m_state << 13;
+        m_state ^= m_state >> 17;
+        m_state ^= m_state << 5;
+        return m_state;
+    }
+
+    uint32_t range(uint32_t low, uint32_t high) {
+        return low + next() % (high - low + 1);
+    }
+
+    float uniform(float low, float high) {
+        return low + (high - low) * static_cast<float>(next() >> 8) * (1.0f / 16777216.0f);
+    }
+
+private:
+    uint32_t m_state;
+};
+
+/// Per-pixel map of random values in [low, high]
+inline std::vector<unsigned short> randomMap16(size_t count, uint32_t seed,
+                                               uint32_t low, uint32_t high) {
+    Random random(seed);
+    std::vector<unsigned short> map(count);
+    for (size_t i = 0; i < count; ++i) {
+        map[i] = static_cast<unsigned short>(random.range(low, high));
+    }
+    return map;
+}
+
+inline std::vector<float> randomMapF(size_t count, uint32_t seed, float low, float high) {
+    Random random(seed);
+    std::vector<float> map(count);
+    for (size_t i = 0; i < count; ++i) {
+        map[i] = random.uniform(low, high);
+    }
+    return map;
+}
+
+/// Frame pixels clamped to a bit depth
+inline std::vector<unsigned short> clampFrame(const Frame& frame, int bitDepth) {
+    const unsigned short maxValue = static_cast<unsigned short>((1u << bitDepth) - 1);
+    std::vector<unsigned short> pixels(frame.pixels);
+    for (size_t i = 0; i < pixels.size(); ++i) {
+        if (pixels[i] > maxValue) pixels[i] = maxValue;
+    }
+    return pixels;
+}
+
+} // namespace Golden
+} // namespace HX
+
+#endif // GOLDEN_H
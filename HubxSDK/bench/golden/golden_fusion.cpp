@@ -0,0 +1,113 @@
+// ============================================================================
+// golden_fusion.cpp
+// ============================================================================
+
+/**
+ * @file golden_fusion.cpp
+ * @brief Dual-energy fusion kernels against the scalar kernels
+ * @version 2.1.0
+ *
+ * Both kernels document the scalar operation order, so the AVX2 versions
+ * must be bit-exact. The frame is the high-energy image; the low-energy
+ * image and the local variances are random maps of the same size.
+ */
+
+#include "../../src/correction/dual_energy_fusion.cpp"
+#include "golden.h"
+
+namespace {
+
+using namespace HX::Golden;
+using namespace HubxSDK::Correction;
+
+const float MAX_VALUE = 65535.0f;
+
+/// The weighted, material and decomposition terms of DualEnergyFusion
+const LinearTerm TERMS[3] = {
+    { 0.7f, 0.3f, 0.0f },
+    { -0.5f, 1.0f, 0.0f },
+    { 1.0f, 0.0f, -0.3f }
+};
+
+struct Inputs {
+    std::vector<unsigned short> low;
+    std::vector<float> varHigh;
+    std::vector<float> varLow;
+
+    Inputs(size_t pixels, uint32_t seed)
+        : low(randomMap16(pixels, seed, 0, 65535)),
+          varHigh(randomMapF(pixels, seed + 1, 0.0f, 4000.0f)),
+          varLow(randomMapF(pixels, seed + 2, 0.0f, 4000.0f)) {
+        // Flat regions: both variances zero, weights from the epsilon alone
+        for (size_t i = 0; i < pixels; i += 97) {
+            varHigh[i] = 0.0f;
+            varLow[i] = 0.0f;
+        }
+    }
+};
+
+void runBlend(AdaptiveBlendKernel kernel, const Frame& frame, const Inputs& in,
+              unsigned short* output) {
+    for (int row = 0; row < frame.height; ++row) {
+        const size_t offset = static_cast<size_t>(row) * frame.width;
+        kernel(frame.pixels.data() + offset, in.low.data() + offset, in.varHigh.data() + offset,
+               in.varLow.data() + offset, output + offset, 0, frame.width, MAX_VALUE);
+    }
+}
+
+/// One term, or the two decomposition terms in one pass
+void runLinear(LinearFuseKernel kernel, const Frame& frame, const Inputs& in, int count,
+               std::vector<unsigned short>* outputs) {
+    const LinearTerm* terms = count == 1 ? TERMS : TERMS + 1;
+    unsigned short* const targets[2] = { outputs[0].data(), outputs[1].data() };
+    kernel(frame.pixels.data(), in.low.data(), terms, targets, count, 0, frame.count(), MAX_VALUE);
+}
+
+void checkFusion(Context& context) {
+#if defined(HX_ARCH_X86)
+    if (!HX::Internal::cpuFeatures().avx2) {
+        context.skip("fusion_adaptive", "avx2", "CPU");
+        context.skip("fusion_linear", "avx2", "CPU");
+        context.skip("fusion_decompose", "avx2", "CPU");
+        return;
+    }
+    for (size_t f = 0; f < context.frames().size(); ++f) {
+        const Frame& frame = context.frames()[f];
+        const Inputs in(frame.count(), static_cast<uint32_t>(f) * 13 + 3);
+        std::vector<unsigned short> reference[2];
+        std::vector<unsigned short> output[2];
+        for (int t = 0; t < 2; ++t) {
+            reference[t].resize(frame.count());
+            output[t].resize(frame.count());
+        }
+
+        runBlend(&AdaptiveBlendScalar, frame, in, reference[0].data());
+        runBlend(&AdaptiveBlendAVX2, frame, in, output[0].data());
+        context.compare("fusion_adaptive", "avx2", frame, reference[0].data(), output[0].data(),
+                        frame.count(), 0);
+        context.timing("fusion_adaptive", "avx2",
+                       context.time([&] { runBlend(&AdaptiveBlendScalar, frame, in, reference[0].data()); }),
+                       context.time([&] { runBlend(&AdaptiveBlendAVX2, frame, in, output[0].data()); }));
+
+        const char* names[2] = { "fusion_linear", "fusion_decompose" };
+        for (int count = 1; count <= 2; ++count) {
+            const char* kernel = names[count - 1];
+            runLinear(&LinearFuseScalar, frame, in, count, reference);
+            runLinear(&LinearFuseAVX2, frame, in, count, output);
+            for (int t = 0; t < count; ++t) {
+                context.compare(kernel, "avx2", frame, reference[t].data(), output[t].data(),
+                                frame.count(), 0);
+            }
+            context.timing(kernel, "avx2",
+                           context.time([&] { runLinear(&LinearFuseScalar, frame, in, count, reference); }),
+                           context.time([&] { runLinear(&LinearFuseAVX2, frame, in, count, output); }));
+        }
+    }
+#else
+    context.skip("fusion", "all", "no vector kernel in this build");
+#endif
+}
+
+const Registrar registrar("fusion", &checkFusion);
+
+} // namespace
@@ -0,0 +1,213 @@
+// ============================================================================
+// golden_main.cpp - Golden-output checks of the optimized kernels
+// ============================================================================
+
+/**
+ * @file golden_main.cpp
+ * @brief Frames, options and the report of hx_golden
+ * @version 2.1.0
+ *
+ * Runs every registered check on randomized frames, edge cases (dark,
+ * saturated, a ramp through all 16-bit values, widths that leave vector
+ * tails) and any recorded frames given with --raw. Exits 1 if a variant
+ * exceeds its bound, so a faster kernel can be gated on it.
+ *
+ *   hx_golden
+ *   hx_golden --kernel xog --min-time 0.05
+ *   hx_golden --raw capture.raw --width 2048 --height 512
+ */
+
+#include "golden.h"
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+namespace HX {
+namespace Golden {
+
+namespace {
+
+std::vector<std::pair<const char*, CheckFn> >& registry() {
+    static std::vector<std::pair<const char*, CheckFn> > checks;
+    return checks;
+}
+
+Frame makeRandom(const char* kind, int width, int height, uint32_t seed,
+                 uint32_t low, uint32_t high) {
+    Frame frame;
+    frame.name = std::string(kind) + "-" + std::to_string(width) + "x" + std::to_string(height);
+    frame.width = width;
+    frame.height = height;
+    frame.pixels = randomMap16(static_cast<size_t>(width) * height, seed, low, high);
+    return frame;
+}
+
+/// Every 16-bit value once, so table-driven kernels see each entry
+Frame makeRamp() {
+    Frame frame;
+    frame.name = "ramp-4096x16";
+    frame.width = 4096;
+    frame.height = 16;
+    frame.pixels.resize(65536);
+    for (size_t i = 0; i < frame.pixels.size(); ++i) {
+        frame.pixels[i] = static_cast<unsigned short>(i);
+    }
+    return frame;
+}
+
+void addFrames(std::vector<Frame>& frames) {
+    frames.push_back(makeRandom("random", 1024, 64, 1, 0, 65535));
+    frames.push_back(makeRandom("random", 4096, 128, 2, 0, 65535));
+    frames.push_back(makeRandom("tails", 1031, 17, 3, 0, 65535));
+    frames.push_back(makeRandom("bright", 2048, 64, 4, 28000, 32000));
+    frames.push_back(makeRandom("dark", 2048, 32, 5, 0, 400));
+    frames.push_back(makeRandom("saturated", 1024, 16, 6, 65000, 65535));
+    frames.push_back(makeRamp());
+}
+
+bool loadRaw(const std::string& file, int width, int height, std::vector<Frame>& frames) {
+    std::ifstream in(file.c_str(), std::ios::binary);
+    if (!in) {
+        std::cerr << "[hx_golden] Cannot open " << file << std::endl;
+        return false;
+    }
+    const size_t frameBytes = static_cast<size_t>(width) * height * sizeof(unsigned short);
+    int index = 0;
+    for (;;) {
+        Frame frame;
+        frame.name = file + "#" + std::to_string(index);
+        frame.width = width;
+        frame.height = height;
+        frame.pixels.resize(static_cast<size_t>(width) * height);
+        if (!in.read(reinterpret_cast<char*>(frame.pixels.data()), frameBytes)) {
+            break;
+        }
+        frames.push_back(frame);
+        ++index;
+    }
+    if (index == 0) {
+        std::cerr << "[hx_golden] " << file << " holds no whole " << width << "x" << height
+                  << " frame" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void usage() {
+    std::cerr <<
+        "Usage: hx_golden [options]\n"
+        "  --kernel NAME  Only checks whose name contains NAME\n"
+        "  --min-time S   Timing per frame and variant (default 0.01, 0 = run once)\n"
+        "  --raw FILE     Also check recorded 16-bit frames (repeatable)\n"
+        "  --width N      Pixels per line of --raw frames\n"
+        "  --height N     Lines per --raw frame (default 512)\n"
+        "  --no-random    Only the --raw frames\n";
+}
+
+} // namespace
+
+Registrar::Registrar(const char* kernel, CheckFn check) {
+    registry().push_back(std::make_pair(kernel, check));
+}
+
+const std::vector<std::pair<const char*, CheckFn> >& checks() {
+    return registry();
+}
+
+Context::Result& Context::result(const std::string& kernel, const std::string& variant) {
+    const std::pair<std::string, std::string> key(kernel, variant);
+    std::map<std::pair<std::string, std::string>, Result>::iterator it = m_results.find(key);
+    if (it == m_results.end()) {
+        m_order.push_back(key);
+        it = m_results.insert(std::make_pair(key, Result())).first;
+    }
+    return it->second;
+}
+
+int Context::report() const {
+    std::printf("%-22s %-10s %6s %8s %6s %11s %8s  %s\n",
+                "kernel", "variant", "frames", "max diff", "bound", "mismatches", "speedup", "result");
+    for (size_t i = 0; i < m_order.size(); ++i) {
+        const Result& r = m_results.find(m_order[i])->second;
+        if (r.skipped) {
+            std::printf("%-22s %-10s %6s %8s %6s %11s %8s  skipped (%s)\n",
+                        m_order[i].first.c_str(), m_order[i].second.c_str(),
+                        "-", "-", "-", "-", "-", r.skipped);
+            continue;
+        }
+        char speedup[32] = "-";
+        if (r.referenceSeconds > 0.0 && r.variantSeconds > 0.0) {
+            std::snprintf(speedup, sizeof(speedup), "%.2fx", r.referenceSeconds / r.variantSeconds);
+        }
+        const bool ok = r.maxDiff <= r.bound;
+        std::printf("%-22s %-10s %6u %8d %6d %11llu %8s  %s%s%s\n",
+                    m_order[i].first.c_str(), m_order[i].second.c_str(), r.frames, r.maxDiff,
+                    r.bound, static_cast<unsigned long long>(r.mismatches), speedup,
+                    ok ? "ok" : "FAIL", ok ? "" : ", first at ", r.firstFailure.c_str());
+    }
+    return m_failures;
+}
+
+} // namespace Golden
+} // namespace HX
+
+int main(int argc, char** argv) {
+    using namespace HX::Golden;
+
+    Context context;
+    std::vector<std::string> rawFiles;
+    int rawWidth = 0;
+    int rawHeight = 512;
+    bool random = true;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "--kernel" && hasValue) {
+            context.setFilter(argv[++i]);
+        } else if (arg == "--min-time" && hasValue) {
+            context.setMinSeconds(std::atof(argv[++i]));
+        } else if (arg == "--raw" && hasValue) {
+            rawFiles.push_back(argv[++i]);
+        } else if (arg == "--width" && hasValue) {
+            rawWidth = std::atoi(argv[++i]);
+        } else if (arg == "--height" && hasValue) {
+            rawHeight = std::atoi(argv[++i]);
+        } else if (arg == "--no-random") {
+            random = false;
+        } else {
+            usage();
+            return 2;
+        }
+    }
+    if (!rawFiles.empty() && (rawWidth <= 0 || rawHeight <= 0)) {
+        std::cerr << "[hx_golden] --raw needs --width (and --height)" << std::endl;
+        return 2;
+    }
+
+    if (random) {
+        addFrames(context.frames());
+    }
+    for (size_t i = 0; i < rawFiles.size(); ++i) {
+        if (!loadRaw(rawFiles[i], rawWidth, rawHeight, context.frames())) {
+            return 2;
+        }
+    }
+    if (context.frames().empty()) {
+        std::cerr << "[hx_golden] No frames to check" << std::endl;
+        return 2;
+    }
+
+    const std::vector<std::pair<const char*, CheckFn> >& all = checks();
+    for (size_t i = 0; i < all.size(); ++i) {
+        if (context.selected(all[i].first)) {
+            all[i].second(context);
+        }
+    }
+
+    const int failures = context.report();
+    if (failures > 0) {
+        std::printf("%d comparison(s) out of bounds\n", failures);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,99 @@
+// ============================================================================
+// golden_pdc.cpp
+// ============================================================================
+
+/**
+ * @file golden_pdc.cpp
+ * @brief PDC row gather against the scalar kernel
+ * @version 2.1.0
+ *
+ * The AVX2 gather evaluates LinearInterpolate() in the same order, so it
+ * must be bit-exact. A gap layout from BuildPDCPlan() only has whole-pixel
+ * taps, so a second plan with random fractional weights covers the
+ * interpolation itself.
+ */
+
+#include "../../src/correction/pdc_correction.cpp"
+#include "golden.h"
+
+namespace {
+
+using namespace HX::Golden;
+using namespace fximage;
+
+const int XCARD_PIXELS = 64;
+const int XCARD_GAP = 2;
+
+bool gapPlan(int width, PDCPlan& plan) {
+    std::vector<float> gaps;
+    for (int x = XCARD_PIXELS; x + XCARD_GAP < width; x += XCARD_PIXELS + XCARD_GAP) {
+        gaps.push_back(static_cast<float>(x));
+    }
+    PDCCorrectionParams params;
+    params.num_xcards = static_cast<int>(gaps.size()) + 1;
+    params.pixels_per_xcard = XCARD_PIXELS;
+    params.gap_width = XCARD_GAP;
+    params.enable_interpolation = true;
+    params.gap_positions = gaps.data();
+    params.num_gaps = static_cast<int>(gaps.size());
+    return BuildPDCPlan(width, params, plan);
+}
+
+/// Output column x reads anywhere in the row, with a fractional right tap
+void resamplePlan(int width, uint32_t seed, PDCPlan& plan) {
+    Random random(seed);
+    plan.input_width = width;
+    plan.output_width = width - 1;
+    plan.source_index.resize(plan.output_width);
+    plan.weight.resize(plan.output_width);
+    for (int x = 0; x < plan.output_width; ++x) {
+        plan.source_index[x] = static_cast<int>(random.range(0, width - 2));
+        plan.weight[x] = random.uniform(0.0f, 1.0f);
+    }
+}
+
+void run(PDCRowKernel kernel, const PDCPlan& plan, const Frame& frame, unsigned short* output) {
+    for (int row = 0; row < frame.height; ++row) {
+        kernel(plan, frame.pixels.data() + static_cast<size_t>(row) * plan.input_width,
+               output + static_cast<size_t>(row) * plan.output_width, 0, plan.output_width);
+    }
+}
+
+void checkPDC(Context& context) {
+#if defined(HX_ARCH_X86)
+    if (!HX::Internal::cpuFeatures().avx2) {
+        context.skip("pdc_gaps", "avx2", "CPU");
+        context.skip("pdc_resample", "avx2", "CPU");
+        return;
+    }
+    for (size_t f = 0; f < context.frames().size(); ++f) {
+        const Frame& frame = context.frames()[f];
+        PDCPlan plans[2];
+        const char* names[2] = { "pdc_gaps", "pdc_resample" };
+        if (!gapPlan(frame.width, plans[0])) {
+            context.skip(names[0], "avx2", "frame narrower than one X-card");
+            continue;
+        }
+        resamplePlan(frame.width, static_cast<uint32_t>(f) * 17 + 9, plans[1]);
+
+        for (int p = 0; p < 2; ++p) {
+            const PDCPlan& plan = plans[p];
+            const size_t count = static_cast<size_t>(plan.output_width) * frame.height;
+            std::vector<unsigned short> reference(count);
+            std::vector<unsigned short> output(count);
+            run(&PDCRowScalar, plan, frame, reference.data());
+            run(&PDCRowAVX2, plan, frame, output.data());
+            context.compare(names[p], "avx2", frame, reference.data(), output.data(), count, 0);
+            context.timing(names[p], "avx2",
+                           context.time([&] { run(&PDCRowScalar, plan, frame, reference.data()); }),
+                           context.time([&] { run(&PDCRowAVX2, plan, frame, output.data()); }));
+        }
+    }
+#else
+    context.skip("pdc", "all", "no vector kernel in this build");
+#endif
+}
+
+const Registrar registrar("pdc", &checkPDC);
+
+} // namespace
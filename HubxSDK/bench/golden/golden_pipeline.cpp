@@ -0,0 +1,233 @@
+// ============================================================================
+// golden_pipeline.cpp
+// ============================================================================
+
+/**
+ * @file golden_pipeline.cpp
+ * @brief Fused CorrectionPipeline against its stages run one after another
+ * @version 2.1.0
+ *
+ * Every stage rounds and clamps as its stand-alone function does, so one
+ * fused pipeline must produce the same frame as a chain of single-stage
+ * pipelines with 16-bit frames between them: bit-exact.
+ */
+
+#include "../../src/correction/correction_pipeline.cpp"
+#include "golden.h"
+
+namespace {
+
+using namespace HX::Golden;
+using namespace HubxSDK::Correction;
+
+const int BIT_DEPTH = 16;
+const int GAINS = 2;
+const int STAGE_COUNT = 6;
+
+/// Maps of every stage, sized for one frame
+struct Stages {
+    std::vector<unsigned short> offset;
+    std::vector<float> gain;
+    std::vector<float> baseline;
+    std::vector<float> background;
+    std::vector<unsigned short> modeOffset[GAINS];
+    std::vector<float> modeGain[GAINS];
+    unsigned short thresholds[GAINS];
+    std::vector<int> sourceIndex;
+    std::vector<float> weight;
+    int remapWidth;
+
+    Stages(const Frame& frame, uint32_t seed) {
+        const size_t pixels = frame.count();
+        offset = randomMap16(pixels, seed, 0, 400);
+        gain = randomMapF(pixels, seed + 1, 0.9f, 1.1f);
+        baseline = randomMapF(pixels, seed + 2, -50.0f, 50.0f);
+        background = randomMapF(pixels, seed + 3, 0.0f, 200.0f);
+        for (int m = 0; m < GAINS; ++m) {
+            modeOffset[m] = randomMap16(pixels, seed + 4 + m, 0, 100);
+            modeGain[m] = randomMapF(pixels, seed + 6 + m, 0.9f * (m + 1), 1.1f * (m + 1));
+        }
+        thresholds[0] = 30000;
+        thresholds[1] = 65535;
+
+        // Drop every 33rd column, interpolating across it
+        Random random(seed + 8);
+        for (int x = 0; x + 1 < frame.width; ++x) {
+            if (x % 33 != 32) {
+                sourceIndex.push_back(x);
+                weight.push_back(random.uniform(0.0f, 1.0f));
+            }
+        }
+        remapWidth = static_cast<int>(sourceIndex.size());
+    }
+
+    /// Append stage s to pipeline
+    int add(CorrectionPipeline& pipeline, int s) const {
+        const unsigned short* offsets[GAINS] = { modeOffset[0].data(), modeOffset[1].data() };
+        const float* gains[GAINS] = { modeGain[0].data(), modeGain[1].data() };
+        switch (s) {
+        case 0: return pipeline.addGain(offset.data(), gain.data(), 20.0f);
+        case 1: return pipeline.addBaseline(baseline.data());
+        case 2: return pipeline.addBackground(background.data(), nullptr, 1.05f, 10.0f);
+        case 3: return pipeline.addMultiGain(GAINS, thresholds, offsets, gains, nullptr);
+        case 4: return pipeline.addRemap(remapWidth, sourceIndex.data(), weight.data());
+        default: return pipeline.addSmooth(3);
+        }
+    }
+};
+
+/// Stages one after another, each in its own pipeline
+void runChained(const Frame& frame, const Stages& stages, std::vector<unsigned short>& output) {
+    std::vector<unsigned short> current(frame.pixels);
+    int width = frame.width;
+    for (int s = 0; s < STAGE_COUNT; ++s) {
+        CorrectionPipeline single;
+        single.initialize(width, frame.height, BIT_DEPTH);
+        stages.add(single, s);
+        std::vector<unsigned short> next(static_cast<size_t>(single.outputWidth()) * frame.height);
+        single.run(current.data(), next.data());
+        current.swap(next);
+        width = single.outputWidth();
+    }
+    output.swap(current);
+}
+
+void checkPipeline(Context& context) {
+    for (size_t f = 0; f < context.frames().size(); ++f) {
+        const Frame& frame = context.frames()[f];
+        if (frame.width < 3) {
+            context.skip("pipeline_fused", "fused", "frame too narrow");
+            continue;
+        }
+        const Stages stages(frame, static_cast<uint32_t>(f) * 19 + 1);
+
+        CorrectionPipeline fused;
+        fused.initialize(frame.width, frame.height, BIT_DEPTH);
+        for (int s = 0; s < STAGE_COUNT; ++s) {
+            stages.add(fused, s);
+        }
+        std::vector<unsigned short> reference;
+        runChained(frame, stages, reference);
+        std::vector<unsigned short> output(static_cast<size_t>(fused.outputWidth()) * frame.height);
+        fused.run(frame.pixels.data(), output.data());
+
+        context.compare("pipeline_fused", "fused", frame, reference.data(), output.data(),
+                        output.size(), 0);
+        context.timing("pipeline_fused", "fused",
+                       context.time([&] { runChained(frame, stages, reference); }),
+                       context.time([&] { fused.run(frame.pixels.data(), output.data()); }));
+    }
+}
+
+/// The fused stages on the first GPU against the CPU; the smooth stays on the CPU
+void checkPipelineGpu(Context& context) {
+    for (size_t f = 0; f < context.frames().size(); ++f) {
+        const Frame& frame = context.frames()[f];
+        if (GpuExecutor::deviceCount() == 0) {
+            context.skip("pipeline_gpu", "opencl", "no OpenCL device");
+            continue;
+        }
+        if (frame.width < 3) {
+            context.skip("pipeline_gpu", "opencl", "frame too narrow");
+            continue;
+        }
+        const Stages stages(frame, static_cast<uint32_t>(f) * 19 + 1);
+
+        CorrectionPipeline cpu;
+        CorrectionPipeline gpu;
+        cpu.initialize(frame.width, frame.height, BIT_DEPTH);
+        gpu.initialize(frame.width, frame.height, BIT_DEPTH);
+        if (gpu.setDevice(0) != HUBX_SUCCESS) {
+            context.skip("pipeline_gpu", "opencl", "device did not open");
+            continue;
+        }
+        for (int s = 0; s < STAGE_COUNT - 1; ++s) {
+            stages.add(cpu, s);
+            stages.add(gpu, s);
+        }
+        std::vector<unsigned short> reference(static_cast<size_t>(cpu.outputWidth()) * frame.height);
+        std::vector<unsigned short> output(reference.size());
+        cpu.run(frame.pixels.data(), reference.data());
+        gpu.run(frame.pixels.data(), output.data());
+
+        context.compare("pipeline_gpu", "opencl", frame, reference.data(), output.data(),
+                        output.size(), 0);
+        context.timing("pipeline_gpu", "opencl",
+                       context.time([&] { cpu.run(frame.pixels.data(), reference.data()); }),
+                       context.time([&] { gpu.run(frame.pixels.data(), output.data()); }));
+    }
+}
+
+/// Prebuilt passes against the generic pass, for every stage set they cover
+void checkPipelineSpecialized(Context& context) {
+    bool compared = false;
+    for (size_t f = 0; f < context.frames().size(); ++f) {
+        const Frame& frame = context.frames()[f];
+        const Stages stages(frame, static_cast<uint32_t>(f) * 23 + 5);
+
+        // Every 97th pixel of each row is replaced by its two neighbours
+        std::vector<int> index;
+        std::vector<int> first(1, 0);
+        std::vector<int> neighbor;
+        std::vector<float> weight;
+        for (int x = 1; x + 1 < frame.width; x += 97) {
+            index.push_back(x);
+            neighbor.push_back(x - 1);
+            neighbor.push_back(x + 1);
+            weight.push_back(0.25f);
+            weight.push_back(0.75f);
+            first.push_back(static_cast<int>(neighbor.size()));
+        }
+
+        const unsigned sets[] = {
+            SPEC_GAIN, SPEC_GAIN | SPEC_BASELINE, SPEC_GAIN | SPEC_DEFECT,
+            SPEC_GAIN | SPEC_BASELINE | SPEC_DEFECT, SPEC_BACKGROUND, SPEC_BACKGROUND | SPEC_DEFECT
+        };
+        for (size_t s = 0; s < sizeof(sets) / sizeof(sets[0]); ++s) {
+            CorrectionPipeline generic;
+            CorrectionPipeline fixed;
+            generic.initialize(frame.width, frame.height, BIT_DEPTH);
+            fixed.initialize(frame.width, frame.height, BIT_DEPTH);
+            generic.setSpecialized(false);
+            CorrectionPipeline* both[2] = { &generic, &fixed };
+            for (int p = 0; p < 2; ++p) {
+                if (sets[s] & SPEC_BACKGROUND) {
+                    stages.add(*both[p], 2);
+                }
+                if (sets[s] & SPEC_GAIN) {
+                    stages.add(*both[p], 0);
+                }
+                if (sets[s] & SPEC_BASELINE) {
+                    stages.add(*both[p], 1);
+                }
+                if (sets[s] & SPEC_DEFECT) {
+                    both[p]->addDefects(1, static_cast<int>(index.size()), index.data(), first.data(),
+                                        neighbor.data(), weight.data());
+                }
+            }
+            if (!fixed.isSpecialized()) {
+                break;
+            }
+            std::vector<unsigned short> reference(frame.count());
+            std::vector<unsigned short> output(frame.count());
+            generic.run(frame.pixels.data(), reference.data());
+            fixed.run(frame.pixels.data(), output.data());
+
+            context.compare("pipeline_special", "fixed", frame, reference.data(), output.data(),
+                            output.size(), 0);
+            context.timing("pipeline_special", "fixed",
+                           context.time([&] { generic.run(frame.pixels.data(), reference.data()); }),
+                           context.time([&] { fixed.run(frame.pixels.data(), output.data()); }));
+            compared = true;
+        }
+    }
+    if (!compared) {
+        context.skip("pipeline_special", "fixed", "no frame of a prebuilt width");
+    }
+}
+
+const Registrar registrar("pipeline", &checkPipeline);
+const Registrar registrarGpu("pipeline_gpu", &checkPipelineGpu);
+const Registrar registrarSpecialized("pipeline_special", &checkPipelineSpecialized);
+
+} // namespace
@@ -0,0 +1,232 @@
+// ============================================================================
+// golden_xog.cpp
+// ============================================================================
+
+/**
+ * @file golden_xog.cpp
+ * @brief XOGCorrect kernels against the scalar kernel
+ * @version 2.1.0
+ *
+ * Float vector kernels use FMA and may differ by one count (see the note
+ * above CorrectAVX2), and so may the 16-bit coefficient vector kernels;
+ * fixed-point vector kernels must be bit-exact. The end-to-end checks
+ * compare the fixed-point and 16-bit paths of XOGCorrect with the scalar
+ * float kernel under GetFixedPointErrorBound() and GetCompactErrorBound().
+ */
+
+#include "../../src/correction/xog_correct.cpp"
+#include "golden.h"
+
+namespace {
+
+using namespace HX::Golden;
+using namespace fximage;
+
+const int BIT_DEPTH = 14;
+const float MAX_VALUE = static_cast<float>((1 << BIT_DEPTH) - 1);
+const unsigned short TARGET_BASELINE = 200;
+
+struct FloatVariant {
+    const char* name;
+    OGKernel kernel;
+    bool available;
+};
+
+struct FixedVariant {
+    const char* name;
+    OGFixedKernel kernel;
+    bool available;
+};
+
+struct CompactVariant {
+    const char* name;
+    OGCompactKernel kernel;
+    bool available;
+};
+
+/// Calibration of one frame size, blocked like XOGCorrect::UpdateCoefficients()
+struct Calibration {
+    std::vector<unsigned short> offset;
+    std::vector<float> gain;
+    std::vector<float> coeffs;
+    std::vector<int32_t> fixedCoeffs;
+    int fixedBits;
+    std::vector<uint16_t> compactCoeffs;    ///< Gains in Q15, integer references
+
+    Calibration(size_t pixels, uint32_t seed) : fixedBits(14) {
+        offset = randomMap16(pixels, seed, 800, 1200);
+        gain = randomMapF(pixels, seed + 1, 0.8f, 1.25f);
+        coeffs.assign((pixels + COEFF_BLOCK - 1) / COEFF_BLOCK * 2 * COEFF_BLOCK, 0.0f);
+        fixedCoeffs.assign(coeffs.size(), 0);
+        compactCoeffs.assign(coeffs.size(), 0);
+        const double scale = static_cast<double>(1 << fixedBits);
+        const double half = static_cast<double>(1 << (fixedBits - 1));
+        for (size_t i = 0; i < pixels; ++i) {
+            const size_t k = CoeffIndex(i);
+            coeffs[k] = gain[i];
+            coeffs[k + COEFF_BLOCK] = TARGET_BASELINE - static_cast<float>(offset[i]) * gain[i];
+            fixedCoeffs[k] = static_cast<int32_t>(std::floor(coeffs[k] * scale + 0.5));
+            fixedCoeffs[k + COEFF_BLOCK] =
+                static_cast<int32_t>(std::floor(coeffs[k + COEFF_BLOCK] * scale + 0.5 + half));
+            compactCoeffs[k] = static_cast<uint16_t>(std::floor(gain[i] * 32768.0 + 0.5));
+            compactCoeffs[k + COEFF_BLOCK] = offset[i];
+        }
+    }
+};
+
+/// Row by row, so odd widths start rows inside a coefficient block
+void runFloat(OGKernel kernel, const Frame& frame, const unsigned short* input,
+              const Calibration& calib, unsigned short* output) {
+    for (int row = 0; row < frame.height; ++row) {
+        const size_t pixel = static_cast<size_t>(row) * frame.width;
+        OGRun run = { input + pixel, output + pixel, calib.coeffs.data(), pixel, frame.width, MAX_VALUE };
+        kernel(run);
+    }
+}
+
+void runFixed(OGFixedKernel kernel, const Frame& frame, const unsigned short* input,
+              const Calibration& calib, unsigned short* output) {
+    for (int row = 0; row < frame.height; ++row) {
+        const size_t pixel = static_cast<size_t>(row) * frame.width;
+        OGFixedRun run = { input + pixel, output + pixel, calib.fixedCoeffs.data(), pixel, frame.width,
+                           calib.fixedBits, static_cast<int32_t>(MAX_VALUE) };
+        kernel(run);
+    }
+}
+
+void runCompact(OGCompactKernel kernel, const Frame& frame, const unsigned short* input,
+                const Calibration& calib, unsigned short* output) {
+    for (int row = 0; row < frame.height; ++row) {
+        const size_t pixel = static_cast<size_t>(row) * frame.width;
+        OGCompactRun run = { input + pixel, output + pixel, calib.compactCoeffs.data(), pixel, frame.width,
+                             0, 1.0f / 32768.0f, TARGET_BASELINE, MAX_VALUE };
+        kernel(run);
+    }
+}
+
+void checkXOG(Context& context) {
+    const HX::Internal::CpuFeatures& cpu = HX::Internal::cpuFeatures();
+    (void)cpu;
+    std::vector<FloatVariant> floats;
+    std::vector<FixedVariant> fixeds;
+    std::vector<CompactVariant> compacts;
+#if defined(HX_ARCH_X86)
+    floats.push_back(FloatVariant{ "avx2", &CorrectAVX2, cpu.avx2 });
+    floats.push_back(FloatVariant{ "avx512", &CorrectAVX512, cpu.avx512 });
+    fixeds.push_back(FixedVariant{ "avx2", &CorrectFixedAVX2, cpu.avx2 });
+    fixeds.push_back(FixedVariant{ "avx512", &CorrectFixedAVX512, cpu.avx512 });
+    compacts.push_back(CompactVariant{ "avx2", &CorrectCompactAVX2, cpu.avx2 });
+    compacts.push_back(CompactVariant{ "avx512", &CorrectCompactAVX512, cpu.avx512 });
+#endif
+#if defined(HX_ARCH_NEON)
+    floats.push_back(FloatVariant{ "neon", &CorrectNEON, cpu.neon });
+    fixeds.push_back(FixedVariant{ "neon", &CorrectFixedNEON, cpu.neon });
+    compacts.push_back(CompactVariant{ "neon", &CorrectCompactNEON, cpu.neon });
+#endif
+
+    for (size_t f = 0; f < context.frames().size(); ++f) {
+        const Frame& frame = context.frames()[f];
+        const std::vector<unsigned short> input = clampFrame(frame, BIT_DEPTH);
+        const Calibration calib(frame.count(), static_cast<uint32_t>(f) * 7 + 11);
+
+        std::vector<unsigned short> reference(frame.count());
+        std::vector<unsigned short> output(frame.count());
+        runFloat(&CorrectScalar, frame, input.data(), calib, reference.data());
+        const double scalarSeconds = context.time([&] {
+            runFloat(&CorrectScalar, frame, input.data(), calib, reference.data());
+        });
+
+        for (size_t v = 0; v < floats.size(); ++v) {
+            if (!floats[v].available) {
+                context.skip("xog_float", floats[v].name, "CPU");
+                continue;
+            }
+            runFloat(floats[v].kernel, frame, input.data(), calib, output.data());
+            context.compare("xog_float", floats[v].name, frame, reference.data(), output.data(),
+                            frame.count(), 1);
+            context.timing("xog_float", floats[v].name, scalarSeconds, context.time([&] {
+                runFloat(floats[v].kernel, frame, input.data(), calib, output.data());
+            }));
+        }
+
+        std::vector<unsigned short> fixedReference(frame.count());
+        runFixed(&CorrectFixedScalar, frame, input.data(), calib, fixedReference.data());
+        const double fixedSeconds = context.time([&] {
+            runFixed(&CorrectFixedScalar, frame, input.data(), calib, fixedReference.data());
+        });
+        for (size_t v = 0; v < fixeds.size(); ++v) {
+            if (!fixeds[v].available) {
+                context.skip("xog_fixed", fixeds[v].name, "CPU");
+                continue;
+            }
+            runFixed(fixeds[v].kernel, frame, input.data(), calib, output.data());
+            context.compare("xog_fixed", fixeds[v].name, frame, fixedReference.data(), output.data(),
+                            frame.count(), 0);
+            context.timing("xog_fixed", fixeds[v].name, fixedSeconds, context.time([&] {
+                runFixed(fixeds[v].kernel, frame, input.data(), calib, output.data());
+            }));
+        }
+
+        std::vector<unsigned short> compactReference(frame.count());
+        runCompact(&CorrectCompactScalar, frame, input.data(), calib, compactReference.data());
+        const double compactSeconds = context.time([&] {
+            runCompact(&CorrectCompactScalar, frame, input.data(), calib, compactReference.data());
+        });
+        for (size_t v = 0; v < compacts.size(); ++v) {
+            if (!compacts[v].available) {
+                context.skip("xog_compact", compacts[v].name, "CPU");
+                continue;
+            }
+            runCompact(compacts[v].kernel, frame, input.data(), calib, output.data());
+            context.compare("xog_compact", compacts[v].name, frame, compactReference.data(), output.data(),
+                            frame.count(), 1);
+            context.timing("xog_compact", compacts[v].name, compactSeconds, context.time([&] {
+                runCompact(compacts[v].kernel, frame, input.data(), calib, output.data());
+            }));
+        }
+
+        // Whole correction, threaded and dispatched, 16-bit coefficients against scalar float
+        {
+            fximage::XOGCorrect correct;
+            correct.Initialize(frame.width, frame.height, BIT_DEPTH);
+            correct.SetOffsetData(calib.offset.data());
+            correct.SetGainData(calib.gain.data());
+            correct.SetTargetBaseline(TARGET_BASELINE);
+            correct.SetCorrectionMode(true, true, false);
+            correct.SetCompactCoefficients(true);
+            correct.ApplyCorrection(input.data(), output.data());
+            if (!correct.IsCompactActive()) {
+                context.skip("xog_apply", "compact", "error bound above 2 counts");
+            } else {
+                context.compare("xog_apply", "compact", frame, reference.data(), output.data(), frame.count(),
+                                correct.GetCompactErrorBound());
+                context.timing("xog_apply", "compact", scalarSeconds, context.time([&] {
+                    correct.ApplyCorrection(input.data(), output.data());
+                }));
+            }
+        }
+
+        // Whole correction, threaded and dispatched, fixed point against scalar float
+        fximage::XOGCorrect correct;
+        correct.Initialize(frame.width, frame.height, BIT_DEPTH);
+        correct.SetOffsetData(calib.offset.data());
+        correct.SetGainData(calib.gain.data());
+        correct.SetTargetBaseline(TARGET_BASELINE);
+        correct.SetCorrectionMode(true, true, false);
+        correct.SetFixedPoint(true);
+        correct.ApplyCorrection(input.data(), output.data());
+        if (!correct.IsFixedPointActive()) {
+            context.skip("xog_apply", "fixed", "coefficients out of Q range");
+            continue;
+        }
+        context.compare("xog_apply", "fixed", frame, reference.data(), output.data(), frame.count(),
+                        correct.GetFixedPointErrorBound());
+        context.timing("xog_apply", "fixed", scalarSeconds, context.time([&] {
+            correct.ApplyCorrection(input.data(), output.data());
+        }));
+    }
+}
+
+const Registrar registrar("xog", &checkXOG);
+
+} // namespace
@@ -0,0 +1,118 @@
+// ============================================================================
+// CalibrationDemo.cs
+// ============================================================================
+
+// CalibrationDemo - offset/gain calibration and in-place correction
+//
+// Dark and bright frames are fed to the calibration from their pool
+// buffers; corrected frames are written back into the buffer they arrived
+// in, so no frame is ever copied into managed memory.
+//
+// Usage: CalibrationDemo [ip] [calibration file]
+
+using System;
+using System.Collections.Concurrent;
+using Hubx;
+
+namespace HubxDemo
+{
+    internal static class CalibrationDemo
+    {
+        private const int FramesPerStage = 16;
+        private const ushort GainTarget = 16384;
+
+        private sealed class QueueSink : IFrameSink
+        {
+            public readonly BlockingCollection<Frame> Frames = new BlockingCollection<Frame>();
+
+            public void OnFrame(in Frame frame) => Frames.Add(frame);
+
+            public void OnError(uint id, string message) => Console.Error.WriteLine($"Error {id}: {message}");
+
+            public void OnEvent(uint id, uint data)
+            {
+            }
+        }
+
+        private static int Main(string[] args)
+        {
+            var detector = new DetectorSettings
+            {
+                Ip = args.Length > 0 ? args[0] : "192.168.1.2",
+                PixelCount = 2048,
+                ModuleCount = 4,
+                PixelDepth = 16
+            };
+            string file = args.Length > 1 ? args[1] : "calibration.xog";
+
+            try
+            {
+                using (var device = new Device(detector))
+                using (var correction = new XogCorrection())
+                {
+                    device.Open();
+                    var sink = new QueueSink();
+                    device.Start(sink, new AcquisitionSettings { LinesPerFrame = 512, PoolSize = 8 });
+
+                    Frame first = sink.Frames.Take();
+                    correction.Init(first.Width, first.Height, first.PixelDepth);
+                    first.Release();
+
+                    Console.WriteLine("Cover the detector (X-ray off), then press Enter");
+                    Console.ReadLine();
+                    Drain(sink);
+                    for (int i = 0; i < FramesPerStage; i++)
+                    {
+                        Frame frame = sink.Frames.Take();
+                        correction.AddDark(frame);
+                        frame.Release();
+                    }
+                    correction.FinalizeOffset();
+
+                    Console.WriteLine("Expose the detector to a flat field, then press Enter");
+                    Console.ReadLine();
+                    Drain(sink);
+                    for (int i = 0; i < FramesPerStage; i++)
+                    {
+                        Frame frame = sink.Frames.Take();
+                        correction.AddBright(frame);
+                        frame.Release();
+                    }
+                    correction.FinalizeGain(GainTarget);
+                    correction.Save(file);
+                    Console.WriteLine($"Calibration saved to {file}");
+
+                    for (int i = 0; i < FramesPerStage; i++)
+                    {
+                        Frame frame = sink.Frames.Take();
+                        correction.Apply(frame);
+                        Span<ushort> row = frame.Row(frame.Height / 2);
+                        Console.WriteLine($"Frame {frame.Sequence}: centre row {row[0]} .. {row[row.Length - 1]}");
+                        frame.Release();
+                    }
+
+                    while (!device.Stop(TimeSpan.FromMilliseconds(100)))
+                    {
+                        Drain(sink);
+                    }
+                    Drain(sink);
+                }
+            }
+            catch (HubxException e)
+            {
+                Console.Error.WriteLine(e.Message);
+                return 1;
+            }
+            return 0;
+        }
+
+        /// Release frames queued while waiting for the operator
+        private static void Drain(QueueSink sink)
+        {
+            while (sink.Frames.TryTake(out Frame frame))
+            {
+                frame.Release();
+            }
+        }
+    }
+}
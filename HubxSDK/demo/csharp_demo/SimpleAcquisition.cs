@@ -0,0 +1,102 @@
+// ============================================================================
+// SimpleAcquisition.cs
+// ============================================================================
+
+// SimpleAcquisition - grab frames through HubxNet without copying them
+//
+// The receive thread only queues each frame; the main thread reads the
+// pixels in place, straight from the pool buffer, and releases the frame.
+//
+// Usage: SimpleAcquisition [ip] [frames]
+
+using System;
+using System.Collections.Concurrent;
+using Hubx;
+
+namespace HubxDemo
+{
+    internal sealed class QueueSink : IFrameSink
+    {
+        public readonly BlockingCollection<Frame> Frames = new BlockingCollection<Frame>();
+
+        public void OnFrame(in Frame frame) => Frames.Add(frame);
+
+        public void OnError(uint id, string message) => Console.Error.WriteLine($"Error {id}: {message}");
+
+        public void OnEvent(uint id, uint data) => Console.WriteLine($"Event {id}: {data}");
+    }
+
+    internal static class SimpleAcquisition
+    {
+        private static int Main(string[] args)
+        {
+            var detector = new DetectorSettings
+            {
+                Ip = args.Length > 0 ? args[0] : "192.168.1.2",
+                PixelCount = 2048,
+                ModuleCount = 4,
+                PixelDepth = 16
+            };
+            int frames = args.Length > 1 ? int.Parse(args[1]) : 10;
+
+            try
+            {
+                using (var device = new Device(detector))
+                {
+                    device.Open();
+                    Console.WriteLine($"Firmware {device.Read(XCode.CuVersion):X}, " +
+                                      $"{device.Read(XCode.PixelCount)} pixels");
+                    device.Write(XCode.IntegrationTime, 1000);
+
+                    var sink = new QueueSink();
+                    device.Start(sink, new AcquisitionSettings { LinesPerFrame = 512, PoolSize = 8 });
+
+                    for (int i = 0; i < frames; i++)
+                    {
+                        Frame frame = sink.Frames.Take();
+                        try
+                        {
+                            ulong sum = 0;
+                            for (int row = 0; row < frame.Height; row++)
+                            {
+                                foreach (ushort pixel in frame.Row(row))
+                                {
+                                    sum += pixel;
+                                }
+                            }
+                            Console.WriteLine($"Frame {frame.Sequence}: {frame.Width}x{frame.Height}, " +
+                                              $"mean {(double)sum / (frame.Width * frame.Height):F1}");
+                        }
+                        finally
+                        {
+                            frame.Release();
+                        }
+                    }
+
+                    // Frames delivered meanwhile are still held: release them or Stop() waits
+                    while (!device.Stop(TimeSpan.FromMilliseconds(100)))
+                    {
+                        while (sink.Frames.TryTake(out Frame pending))
+                        {
+                            pending.Release();
+                        }
+                    }
+                    while (sink.Frames.TryTake(out Frame late))
+                    {
+                        late.Release();
+                    }
+                    if (device.CallbackException != null)
+                    {
+                        Console.Error.WriteLine(device.CallbackException);
+                    }
+                }
+            }
+            catch (HubxException e)
+            {
+                Console.Error.WriteLine(e.Message);
+                return 1;
+            }
+            return 0;
+        }
+    }
+}
@@ -0,0 +1,57 @@
+# ============================================================================
+# simple_acquisition.py
+# ============================================================================
+#
+# simple_acquisition - NumPy views of pooled frames, corrected in place
+#
+# Frames are never copied: numpy.asarray(frame) views the pool buffer, and
+# Correction.apply() writes the corrected pixels back into it without the
+# GIL. Release every frame (or let "with" do it), or the pool runs dry.
+#
+# Usage: python simple_acquisition.py [ip] [frames] [calibration file]
+
+import sys
+
+import numpy
+import pyhubx
+
+
+def main():
+    ip = sys.argv[1] if len(sys.argv) > 1 else "192.168.1.2"
+    count = int(sys.argv[2]) if len(sys.argv) > 2 else 10
+    calibration = sys.argv[3] if len(sys.argv) > 3 else None
+
+    device = pyhubx.Device(ip, pixel_count=2048, module_count=4)
+    device.open()
+    print("Firmware %x" % device.read(pyhubx.XCode.CU_VER))
+    device.write(pyhubx.XCode.INT_TIME, 1000)
+
+    correction = None
+    if calibration:
+        correction = pyhubx.Correction()
+        correction.load(calibration)
+
+    device.start(lines_per_frame=512, pool_size=8)
+    try:
+        for _ in range(count):
+            frame = device.next_frame(timeout=5.0)
+            if frame is None:
+                print("No frame within 5 s")
+                break
+            with frame:
+                if correction:
+                    correction.apply(frame)
+                pixels = numpy.asarray(frame)
+                print("Frame %d: %dx%d, mean %.1f" %
+                      (frame.sequence, pixels.shape[1], pixels.shape[0], pixels.mean()))
+                del pixels
+        for error_id, message in device.errors():
+            print("Error %d: %s" % (error_id, message))
+    finally:
+        while not device.stop(timeout=1.0):
+            print("Waiting for frames to be released")
+        device.close()
+
+
+if __name__ == "__main__":
+    main()
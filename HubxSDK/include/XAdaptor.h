@@ -11,6 +11,7 @@
 
 #include <cstdint>
 #include <string>
+#include <vector>
 
 namespace HX {
 
@@ -28,6 +29,43 @@ class IXCmdSink;
  */
 class XAdaptor {
 public:
+    /**
+     * @brief Outcome of one host network check
+     */
+    enum CheckStatus {
+        CHECK_PASS = 0,     ///< Meets the requirement
+        CHECK_WARN,         ///< Meets it with little margin, or depends on the setup
+        CHECK_FAIL,         ///< Loses data at the line rate
+        CHECK_UNKNOWN       ///< Not readable on this host
+    };
+    
+    /**
+     * @brief One setting of an adapter against the line rate
+     *
+     * Checks, by name: mtu, link_speed, rx_ring, irq_affinity, rp_filter,
+     * cpu_idle and rmem_max.
+     */
+    struct NetworkCheck {
+        std::string name;
+        CheckStatus status;
+        std::string value;          ///< What the host has
+        std::string required;       ///< What the line rate needs
+        
+        NetworkCheck() : status(CHECK_UNKNOWN) {}
+    };
+    
+    /**
+     * @brief Checks of one adapter
+     */
+    struct NetworkReport {
+        std::string adapter;        ///< Adapter IP
+        std::string interfaceName;  ///< Operating system name, empty if not found
+        bool pass;                  ///< No check failed
+        std::vector<NetworkCheck> checks;
+        
+        NetworkReport() : pass(false) {}
+    };
+    
     XAdaptor();
     explicit XAdaptor(const std::string& adp_ip);
     ~XAdaptor();
@@ -60,6 +98,22 @@ public:
      */
     int32_t Connect();
     
+    /**
+     * @brief Discover detectors on several adapters at once
+     * @param timeout Time to collect replies, for all adapters together (ms)
+     * @param allAdapters true for every local IPv4 adapter that is up,
+     *        false for the bound adapter only
+     * @param expected Stop as soon as this many detectors answered (0 = wait
+     *        for the timeout)
+     * @return Number of devices found, or -1 on error
+     *
+     * @note Every adapter broadcasts in its own thread. Each detector is
+     *       passed to IXCmdSink::OnXDetector as soon as it answers; one
+     *       reachable through two adapters is kept once, with the first.
+     *       Replaces the results of an earlier Connect() or Discover().
+     */
+    int32_t Discover(uint32_t timeout = 1000, bool allAdapters = true, uint32_t expected = 0);
+    
     /**
      * @brief Get discovered detector information
      * @param index Device index (0-based)
@@ -67,19 +121,93 @@ public:
      */
     XDetector GetDetector(uint32_t index);
     
+    /**
+     * @brief Get the local adapter a detector answered on
+     * @param index Device index (0-based)
+     * @return Adapter IP, empty if index is out of range
+     */
+    std::string GetDetectorAdapter(uint32_t index);
+    
     /**
      * @brief Configure detector network settings
      * @param det Detector configuration
      * @return 1 on success, -1 on error
+     *
+     * @note Returns once the detector answers discovery with the new
+     *       settings, or fails after SetRebootTimeout()
      */
     int32_t ConfigDetector(const XDetector& det);
     
     /**
      * @brief Restore detector to default settings
      * @return 1 on success, -1 on error
+     *
+     * @note All discovered detectors reboot together; returns once each
+     *       answers with the default settings or SetRebootTimeout() passes
      */
     int32_t Restore();
     
+    /**
+     * @brief Save the discovered detectors to a file
+     * @param file Inventory file path
+     * @return true on success
+     *
+     * @note Stores each detector's MAC, IP, ports, adapter and the device
+     *       information GetDetector() returns, for LoadInventory()
+     */
+    bool SaveInventory(const std::string& file);
+    
+    /**
+     * @brief Use a saved inventory instead of waiting for discovery
+     * @param file File written by SaveInventory()
+     * @param timeout Time to check the inventory against the network (ms),
+     *        0 to skip the check
+     * @return Number of detectors loaded, or -1 on error
+     *
+     * @note The detectors are available from GetDetector() on return. A
+     *       background discovery on the inventory's adapters then checks
+     *       them: moved or new detectors update the list in place (new
+     *       ones at the end) and are passed to IXCmdSink::OnXDetector, and
+     *       event 102 reports how many inventoried detectors did not
+     *       answer. Any other call that talks to the network cancels it.
+     */
+    int32_t LoadInventory(const std::string& file, uint32_t timeout = 1000);
+    
+    /**
+     * @brief Check host network settings against a detector's line rate
+     * @param det Detector: pixel count and depth size the line packets,
+     *        the IP is checked against reverse-path filtering
+     * @param lineRate Lines per second the detector will send
+     * @param reports Output, one report per adapter inspected
+     * @param recvBufferSize SO_RCVBUF the grabber will ask for
+     *        (XGrabber::NetworkConfig), 0 = 20 ms of packets
+     * @param allAdapters true for every local IPv4 adapter that is up,
+     *        false for the bound adapter only
+     * @return Number of adapters with a failed check, or -1 on error
+     *
+     * @note Needs neither Open() nor the detector. Packets are taken as
+     *       one line after an 8-byte header, the largest layout. The
+     *       receive core is the XFactory::THREAD_RECEIVE affinity. Use
+     *       NetworkReportJson() for a machine-readable result.
+     */
+    int32_t InspectNetwork(const XDetector& det, double lineRate, std::vector<NetworkReport>& reports,
+                           uint32_t recvBufferSize = 0, bool allAdapters = false);
+    
+    /**
+     * @brief Format InspectNetwork() reports as JSON
+     * @param reports Reports to format
+     * @return {"pass":bool,"adapters":[{"adapter","interface","pass",
+     *         "checks":[{"name","status","value","required"}]}]}, status
+     *         being "pass", "warn", "fail" or "unknown"
+     */
+    static std::string NetworkReportJson(const std::vector<NetworkReport>& reports);
+    
+    /**
+     * @brief Set how long ConfigDetector()/Restore() wait for a reboot
+     * @param timeout Timeout in milliseconds (default 10000)
+     */
+    void SetRebootTimeout(uint32_t timeout);
+    
     /**
      * @brief Set event callback sink
      * @param sink_ Callback handler
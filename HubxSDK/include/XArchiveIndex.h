@@ -0,0 +1,118 @@
+// ============================================================================
+
+/**
+ * @file XArchiveIndex.h
+ * @brief XArchiveIndex class - Metadata index of a capture directory
+ * @version 2.1.0
+ */
+
+#ifndef XARCHIVEINDEX_H
+#define XARCHIVEINDEX_H
+
+#include <cstdint>
+#include <string>
+
+namespace HX {
+
+/**
+ * @class XArchiveIndex
+ * @brief Queries the metadata index that XFile and XRecorder keep per directory
+ *
+ * With XFile::SetIndexing() or XRecorder::SetIndexing() every file written
+ * appends one record (the XFCode metadata, pixel offset and file size) to
+ * hxindex.dat in its directory. Open() reads that one small file, so
+ * finding captures by serial number, date or integration time no longer
+ * opens every TIFF. A file written more than once is listed once, with
+ * its latest record; records torn by a crash are ignored.
+ */
+class XArchiveIndex {
+public:
+    /// Name of the index file in a capture directory
+    static const char* const FILE_NAME;
+
+    /**
+     * @brief Metadata of one indexed file
+     */
+    struct Record {
+        std::string file;           ///< File name within the directory
+        std::string serialNum;      ///< XF_SN
+        std::string dateTime;       ///< XF_DATE, "YYYY-MM-DD HH:MM:SS"
+        uint32_t cols;              ///< XF_COLS
+        uint32_t rows;              ///< XF_ROWS
+        uint32_t depth;             ///< XF_DEPTH
+        uint32_t dmNum;             ///< XF_DM_NUM
+        uint32_t dmType;            ///< XF_DM_TYPE
+        uint32_t dmPix;             ///< XF_DM_PIX
+        uint32_t opMode;            ///< XF_OP_MODE
+        uint32_t intTime;           ///< XF_INT_TIME
+        uint32_t energy;            ///< XF_ENERGY
+        uint32_t bin;               ///< XF_BIN
+        float temp;                 ///< XF_TEMP
+        float humidity;             ///< XF_HUM
+        uint32_t compression;       ///< XFile::XFCompression of the pixels
+        uint32_t tileSize;          ///< Tile size of pyramid files, 0 for strips
+        uint64_t dataOffset;        ///< File offset of the pixel data
+        uint64_t fileSize;          ///< File size in bytes
+
+        Record();
+    };
+
+    /**
+     * @brief Record filter; empty or default fields match everything
+     */
+    struct Query {
+        std::string serialNum;      ///< Exact serial number
+        std::string dateFrom;       ///< First dateTime, inclusive
+        std::string dateTo;         ///< Last dateTime, exclusive
+        uint32_t intTimeMin;        ///< Smallest integration time
+        uint32_t intTimeMax;        ///< Largest integration time
+
+        Query();
+    };
+
+    XArchiveIndex();
+    ~XArchiveIndex();
+
+    /**
+     * @brief Load the index of a directory
+     * @param directory Capture directory
+     * @return true on success, false if the directory has no readable index
+     */
+    bool Open(const std::string& directory);
+
+    /**
+     * @brief Get number of indexed files
+     */
+    uint32_t GetCount() const;
+
+    /**
+     * @brief Get one record
+     * @param index Record index
+     * @param record Output record
+     * @return true on success, false if index is out of range
+     */
+    bool GetRecord(uint32_t index, Record& record) const;
+
+    /**
+     * @brief Find the next record matching a query
+     * @param query Filter
+     * @param start First record index to test
+     * @return Index of the match, GetCount() if there is none
+     *
+     * @note Dates compare as strings, so prefixes select whole periods:
+     *       dateFrom "2026-03-01", dateTo "2026-03-02" is one day
+     */
+    uint32_t Find(const Query& query, uint32_t start = 0) const;
+
+private:
+    class Impl;
+    Impl* m_impl;
+
+    // Non-copyable
+    XArchiveIndex(const XArchiveIndex&) = delete;
+    XArchiveIndex& operator=(const XArchiveIndex&) = delete;
+};
+
+} // namespace HX
+
+#endif // XARCHIVEINDEX_H
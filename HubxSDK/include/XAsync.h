@@ -0,0 +1,589 @@
+// ============================================================================
+
+/**
+ * @file XAsync.h
+ * @brief C++20 coroutine awaitables for frames and asynchronous commands
+ * @version 2.1.0
+ *
+ * Header-only; needs C++20 in the including code (link hubx_async in
+ * CMake). One XAsyncContext runs any number of XTask coroutines on the
+ * thread that calls Run(), so many detectors are driven without a thread
+ * per detector:
+ *
+ *     XTask Scan(XAsyncControl& control, XAsyncGrabber& frames) {
+ *         co_await control.WriteAsync(XControl::XINT_TIME, 1000);
+ *         while (XFrameRef frame = co_await frames.NextFrame()) {
+ *             Process(frame.get());
+ *         }
+ *     }
+ *
+ *     context.Spawn(Scan(control0, frames0));
+ *     context.Spawn(Scan(control1, frames1));
+ *     context.Run();
+ *
+ * Receive threads hand work to the context through a lock-free intrusive
+ * queue; frames reach it through a single-producer ring per grabber.
+ * Nothing is allocated per frame or per command.
+ */
+
+#ifndef XASYNC_H
+#define XASYNC_H
+
+#if !defined(__cpp_impl_coroutine)
+#error "XAsync.h needs C++20 coroutines (link hubx_async or compile with -std=c++20)"
+#endif
+
+#include "XControl.h"
+#include "XFrame.h"
+#include "XGrabber.h"
+#include "ixcmd_sink.h"
+#include "iximg_sink.h"
+#include <atomic>
+#include <coroutine>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace HX {
+
+class XAsyncContext;
+
+/**
+ * @struct XAsyncNode
+ * @brief Queue link of a coroutine waiting to be resumed
+ *
+ * Embedded in awaiters and task promises, i.e. in the coroutine frame.
+ */
+struct XAsyncNode {
+    XAsyncNode* next = nullptr;
+    std::coroutine_handle<> handle;
+};
+
+/**
+ * @class XTask
+ * @brief Fire-and-forget coroutine run by an XAsyncContext
+ *
+ * Starts when spawned and frees itself when it returns. An exception
+ * leaving the coroutine ends XAsyncContext::Run() with that exception.
+ */
+class XTask {
+public:
+    struct promise_type;
+    using Handle = std::coroutine_handle<promise_type>;
+
+    struct promise_type {
+        XAsyncContext* context = nullptr;
+        XAsyncNode node;
+
+        XTask get_return_object() { return XTask(Handle::from_promise(*this)); }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+
+        struct FinalAwaiter {
+            bool await_ready() noexcept { return false; }
+            void await_suspend(Handle handle) noexcept;
+            void await_resume() noexcept {}
+        };
+        FinalAwaiter final_suspend() noexcept { return {}; }
+
+        void return_void() {}
+        void unhandled_exception();
+    };
+
+    XTask(XTask&& other) noexcept : m_handle(std::exchange(other.m_handle, nullptr)) {}
+
+    /// Destroys a task that was never spawned
+    ~XTask() {
+        if (m_handle) {
+            m_handle.destroy();
+        }
+    }
+
+private:
+    friend class XAsyncContext;
+
+    explicit XTask(Handle handle) : m_handle(handle) {}
+
+    Handle m_handle;
+
+    // Non-copyable
+    XTask(const XTask&) = delete;
+    XTask& operator=(const XTask&) = delete;
+};
+
+/**
+ * @class XAsyncContext
+ * @brief Single-threaded run loop for XTask coroutines
+ *
+ * Awaiters complete on receive threads and post the waiting coroutine
+ * here; Run() resumes coroutines in posting order.
+ */
+class XAsyncContext {
+public:
+    XAsyncContext() = default;
+
+    /**
+     * @brief Schedule a task; it starts on the Run() thread
+     * @note Call before Run() or from the Run() thread
+     */
+    void Spawn(XTask task) {
+        XTask::Handle handle = std::exchange(task.m_handle, nullptr);
+        handle.promise().context = this;
+        handle.promise().node.handle = handle;
+        m_tasks.fetch_add(1, std::memory_order_relaxed);
+        Post(&handle.promise().node);
+    }
+
+    /**
+     * @brief Resume a coroutine on the Run() thread; lock-free, any thread
+     */
+    void Post(XAsyncNode* node) {
+        XAsyncNode* head = m_head.load(std::memory_order_relaxed);
+        do {
+            node->next = head;
+        } while (!m_head.compare_exchange_weak(head, node, std::memory_order_release,
+                                               std::memory_order_relaxed));
+        m_posts.fetch_add(1, std::memory_order_release);
+        m_posts.notify_one();
+    }
+
+    /**
+     * @brief Resume coroutines until every task has returned or Stop()
+     * @throws The first exception that left a task
+     *
+     * @note Tasks still suspended when Stop() ends the loop stay suspended;
+     *       finish their grabbers (XAsyncGrabber::Finish) to let them return.
+     */
+    void Run() {
+        m_stopped.store(false);
+        while (m_tasks.load(std::memory_order_relaxed) > 0 && !m_stopped.load()) {
+            const uint32_t seen = m_posts.load(std::memory_order_acquire);
+            XAsyncNode* list = m_head.exchange(nullptr, std::memory_order_acquire);
+            if (!list) {
+                m_posts.wait(seen, std::memory_order_acquire);
+                continue;
+            }
+
+            // Pushed last-first
+            XAsyncNode* ready = nullptr;
+            while (list) {
+                XAsyncNode* next = list->next;
+                list->next = ready;
+                ready = list;
+                list = next;
+            }
+            while (ready) {
+                // The node lives in the coroutine frame, which may end here
+                XAsyncNode* next = ready->next;
+                ready->handle.resume();
+                ready = next;
+            }
+
+            if (m_error) {
+                std::rethrow_exception(std::exchange(m_error, nullptr));
+            }
+        }
+    }
+
+    /**
+     * @brief End Run() after the coroutines being resumed; any thread
+     */
+    void Stop() {
+        m_stopped.store(true);
+        m_posts.fetch_add(1, std::memory_order_release);
+        m_posts.notify_one();
+    }
+
+    /**
+     * @brief Tasks spawned and not yet returned
+     */
+    uint32_t GetTaskCount() const { return m_tasks.load(std::memory_order_relaxed); }
+
+private:
+    friend struct XTask::promise_type;
+
+    void TaskFinished() { m_tasks.fetch_sub(1, std::memory_order_relaxed); }
+
+    void TaskFailed(std::exception_ptr error) {
+        if (!m_error) {
+            m_error = error;
+        }
+    }
+
+    std::atomic<XAsyncNode*> m_head{nullptr};   ///< Posted nodes, newest first
+    std::atomic<uint32_t> m_posts{0};           ///< Wake-up counter for Run()
+    std::atomic<uint32_t> m_tasks{0};
+    std::atomic<bool> m_stopped{false};
+    std::exception_ptr m_error;                 ///< Run() thread only
+
+    // Non-copyable
+    XAsyncContext(const XAsyncContext&) = delete;
+    XAsyncContext& operator=(const XAsyncContext&) = delete;
+};
+
+inline void XTask::promise_type::FinalAwaiter::await_suspend(Handle handle) noexcept {
+    XAsyncContext* context = handle.promise().context;
+    handle.destroy();
+    context->TaskFinished();
+}
+
+inline void XTask::promise_type::unhandled_exception() {
+    context->TaskFailed(std::current_exception());
+}
+
+/**
+ * @struct XCommandResult
+ * @brief Outcome of an asynchronous command
+ */
+struct XCommandResult {
+    int32_t result;                     ///< As the synchronous call: 1 success, 0 unsupported, -1 error
+    uint64_t val;                       ///< Value read (0 for writes and failures)
+};
+
+/**
+ * @class XAsyncControl
+ * @brief co_await-able ReadAsync/WriteAsync over XControl's pipelined channel
+ *
+ * Becomes the control's sink; errors and events go on to the sink given
+ * here. Every asynchronous command on the control must be issued through
+ * this object, since it matches OnXComplete tickets to awaiters.
+ */
+class XAsyncControl : public IXCmdSink {
+public:
+    class Awaiter : public XAsyncNode {
+    public:
+        bool await_ready() const noexcept { return false; }
+
+        bool await_suspend(std::coroutine_handle<> waiting) {
+            handle = waiting;
+            // Not under m_mutex: the call blocks while too many commands
+            // are in flight, until the receive thread completes one
+            const uint32_t ticket = m_read ? m_owner.m_control.ReadAsync(m_code, m_index)
+                                           : m_owner.m_control.WriteAsync(m_code, m_val, m_index);
+            if (ticket == 0) {
+                m_result.result = -1;
+                m_result.val = 0;
+                return false;
+            }
+
+            std::lock_guard<std::mutex> lock(m_owner.m_mutex);
+            auto early = m_owner.m_completed.find(ticket);
+            if (early != m_owner.m_completed.end()) {
+                m_result = early->second;
+                m_owner.m_completed.erase(early);
+                return false;
+            }
+            m_owner.m_waiting[ticket] = this;
+            return true;
+        }
+
+        XCommandResult await_resume() const noexcept { return m_result; }
+
+    private:
+        friend class XAsyncControl;
+
+        Awaiter(XAsyncControl& owner, bool read, XControl::XCode code, uint64_t val, uint8_t index)
+            : m_owner(owner), m_read(read), m_code(code), m_val(val), m_index(index), m_result{0, 0} {}
+
+        XAsyncControl& m_owner;
+        bool m_read;
+        XControl::XCode m_code;
+        uint64_t m_val;
+        uint8_t m_index;
+        XCommandResult m_result;
+    };
+
+    /**
+     * @param context Context the awaiting coroutines run on
+     * @param control Open or not yet opened control; outlives this object
+     * @param forward Receives OnXError/OnXEvent, may be nullptr
+     */
+    XAsyncControl(XAsyncContext& context, XControl& control, IXCmdSink* forward = nullptr)
+        : m_context(context), m_control(control), m_forward(forward) {
+        m_control.SetSink(this);
+    }
+
+    ~XAsyncControl() override { m_control.SetSink(m_forward); }
+
+    /**
+     * @brief co_await control.ReadAsync(code, index) -> XCommandResult
+     */
+    Awaiter ReadAsync(XControl::XCode code, uint8_t index = 0) {
+        return Awaiter(*this, true, code, 0, index);
+    }
+
+    /**
+     * @brief co_await control.WriteAsync(code, val, index) -> XCommandResult
+     * @note Commands are sent when awaited, in that order, and pipelined
+     *       with those of other coroutines on the same control
+     */
+    Awaiter WriteAsync(XControl::XCode code, uint64_t val, uint8_t index = 0) {
+        return Awaiter(*this, false, code, val, index);
+    }
+
+    void OnXError(uint32_t err_id, const char* err_msg_) override {
+        if (m_forward) {
+            m_forward->OnXError(err_id, err_msg_);
+        }
+    }
+
+    void OnXEvent(uint32_t event_id, float data) override {
+        if (m_forward) {
+            m_forward->OnXEvent(event_id, data);
+        }
+    }
+
+    void OnXComplete(uint32_t ticket, int32_t result, uint64_t val) override {
+        // The channel reports the response length on success
+        if (result > 0) {
+            result = 1;
+        }
+        Awaiter* awaiter = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto waiting = m_waiting.find(ticket);
+            if (waiting == m_waiting.end()) {
+                // Completed before the awaiter registered its ticket
+                m_completed[ticket] = XCommandResult{result, val};
+                return;
+            }
+            awaiter = waiting->second;
+            m_waiting.erase(waiting);
+        }
+        awaiter->m_result = XCommandResult{result, val};
+        m_context.Post(awaiter);
+    }
+
+private:
+    XAsyncContext& m_context;
+    XControl& m_control;
+    IXCmdSink* m_forward;
+    std::mutex m_mutex;                                     ///< Guards both maps
+    std::unordered_map<uint32_t, Awaiter*> m_waiting;
+    std::unordered_map<uint32_t, XCommandResult> m_completed;
+
+    // Non-copyable
+    XAsyncControl(const XAsyncControl&) = delete;
+    XAsyncControl& operator=(const XAsyncControl&) = delete;
+};
+
+/**
+ * @class XFrameRef
+ * @brief Frame from XAsyncGrabber::NextFrame(), returned to the pool on destruction
+ *
+ * Empty once the grabber is finished.
+ */
+class XFrameRef {
+public:
+    XFrameRef() noexcept : m_frame(nullptr), m_image(nullptr) {}
+    XFrameRef(XFrame* frame, XImage* image) noexcept : m_frame(frame), m_image(image) {}
+    XFrameRef(XFrameRef&& other) noexcept
+        : m_frame(other.m_frame), m_image(std::exchange(other.m_image, nullptr)) {}
+
+    XFrameRef& operator=(XFrameRef&& other) noexcept {
+        if (this != &other) {
+            Release();
+            m_frame = other.m_frame;
+            m_image = std::exchange(other.m_image, nullptr);
+        }
+        return *this;
+    }
+
+    ~XFrameRef() { Release(); }
+
+    XImage* get() const noexcept { return m_image; }
+    XImage* operator->() const noexcept { return m_image; }
+    explicit operator bool() const noexcept { return m_image != nullptr; }
+
+    /// Give the buffer back to the pool now
+    void Release() {
+        if (m_image) {
+            m_frame->Release(std::exchange(m_image, nullptr));
+        }
+    }
+
+private:
+    XFrame* m_frame;
+    XImage* m_image;
+
+    // Non-copyable
+    XFrameRef(const XFrameRef&) = delete;
+    XFrameRef& operator=(const XFrameRef&) = delete;
+};
+
+/**
+ * @class XAsyncGrabber
+ * @brief co_await-able frames of one XGrabber
+ *
+ * Becomes the sink of the grabber and its frame; errors and events go on
+ * to the sink given here. Frames are passed from the receive thread
+ * through a lock-free ring sized to the pool, so set the pool size (2 or
+ * more, overlapping frames are not supported) before constructing. One
+ * coroutine at a time may wait in NextFrame().
+ */
+class XAsyncGrabber : public IXImgSink {
+public:
+    class Awaiter : public XAsyncNode {
+    public:
+        bool await_ready() const noexcept { return m_owner.Ready(); }
+
+        bool await_suspend(std::coroutine_handle<> waiting) noexcept {
+            handle = waiting;
+            m_owner.m_waiting.store(this);
+            // A frame may have arrived before the store; reclaim the wait
+            // unless the receive thread already took it to post us
+            if (m_owner.Ready() && m_owner.m_waiting.exchange(nullptr) == this) {
+                return false;
+            }
+            return true;
+        }
+
+        XFrameRef await_resume() noexcept { return XFrameRef(&m_owner.m_frame, m_owner.Pop()); }
+
+    private:
+        friend class XAsyncGrabber;
+
+        explicit Awaiter(XAsyncGrabber& owner) : m_owner(owner) {}
+
+        XAsyncGrabber& m_owner;
+    };
+
+    /**
+     * @param context Context the awaiting coroutine runs on
+     * @param grabber Grabber, given the frame here; outlives this object
+     * @param frame Frame assembler with its pool size set
+     * @param forward Receives OnXError/OnXEvent, may be nullptr
+     */
+    XAsyncGrabber(XAsyncContext& context, XGrabber& grabber, XFrame& frame, IXImgSink* forward = nullptr)
+        : m_context(context), m_grabber(grabber), m_frame(frame), m_forward(forward),
+          m_mask(RingSize(frame.GetPoolSize()) - 1), m_ring(m_mask + 1, nullptr) {
+        m_frame.SetSink(this);
+        m_grabber.SetSink(this);
+        m_grabber.SetFrame(m_frame);
+    }
+
+    ~XAsyncGrabber() override {
+        m_grabber.SetSink(m_forward);
+        m_frame.SetSink(m_forward);
+    }
+
+    /**
+     * @brief co_await frames.NextFrame() -> XFrameRef, empty once finished
+     */
+    Awaiter NextFrame() { return Awaiter(*this); }
+
+    /**
+     * @brief Stop delivering frames and return the queued ones to the pool
+     *
+     * A coroutine waiting in NextFrame() gets an empty XFrameRef, as do
+     * later calls. Call on the context thread, then release the frames
+     * still held before stopping the grabber (XFrame frees its pool then).
+     */
+    void Finish() {
+        m_finished.store(true);
+        // Let a delivery that missed the flag finish its push
+        while (m_delivering.load() != 0) {
+            std::this_thread::yield();
+        }
+        while (XImage* image = Pop()) {
+            m_frame.Release(image);
+        }
+        if (XAsyncNode* waiting = m_waiting.exchange(nullptr)) {
+            m_context.Post(waiting);
+        }
+    }
+
+    /**
+     * @brief Deliver frames again after Finish(), before the next Grab()
+     */
+    void Reset() { m_finished.store(false); }
+
+    /**
+     * @brief Frames returned to the pool because the ring was full
+     */
+    uint64_t GetDropped() const { return m_dropped.load(std::memory_order_relaxed); }
+
+    void OnXError(uint32_t err_id, const char* err_msg_) override {
+        if (m_forward) {
+            m_forward->OnXError(err_id, err_msg_);
+        }
+    }
+
+    void OnXEvent(uint32_t event_id, uint32_t data) override {
+        if (m_forward) {
+            m_forward->OnXEvent(event_id, data);
+        }
+    }
+
+    void OnFrameReady(XImage* image_) override {
+        m_delivering.fetch_add(1);
+        if (m_finished.load()) {
+            m_frame.Release(image_);
+        } else if (!Push(image_)) {
+            m_frame.Release(image_);
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+        } else if (XAsyncNode* waiting = m_waiting.exchange(nullptr)) {
+            m_context.Post(waiting);
+        }
+        m_delivering.fetch_sub(1);
+    }
+
+private:
+    static size_t RingSize(uint32_t poolSize) {
+        size_t size = 2;
+        while (size < poolSize) {
+            size <<= 1;
+        }
+        return size;
+    }
+
+    bool Ready() const {
+        return m_finished.load() || m_tail.load(std::memory_order_acquire) != m_head.load(std::memory_order_relaxed);
+    }
+
+    /// Receive thread
+    bool Push(XImage* image) {
+        const size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_head.load(std::memory_order_acquire) > m_mask) {
+            return false;
+        }
+        m_ring[tail & m_mask] = image;
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /// Context thread; nullptr if empty
+    XImage* Pop() {
+        const size_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tail.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+        XImage* image = m_ring[head & m_mask];
+        m_head.store(head + 1, std::memory_order_release);
+        return image;
+    }
+
+    XAsyncContext& m_context;
+    XGrabber& m_grabber;
+    XFrame& m_frame;
+    IXImgSink* m_forward;
+    const size_t m_mask;
+    std::vector<XImage*> m_ring;
+    std::atomic<size_t> m_head{0};              ///< Next slot to pop (context thread)
+    std::atomic<size_t> m_tail{0};              ///< Next slot to push (receive thread)
+    std::atomic<XAsyncNode*> m_waiting{nullptr};
+    std::atomic<bool> m_finished{false};
+    std::atomic<uint32_t> m_delivering{0};      ///< Receive thread inside OnFrameReady
+    std::atomic<uint64_t> m_dropped{0};
+
+    // Non-copyable
+    XAsyncGrabber(const XAsyncGrabber&) = delete;
+    XAsyncGrabber& operator=(const XAsyncGrabber&) = delete;
+};
+
+} // namespace HX
+
+#endif // XASYNC_H
@@ -0,0 +1,212 @@
+// ============================================================================
+
+/**
+ * @file XBatcher.h
+ * @brief XBatcher class - Fixed-size inference batches of frames or tiles
+ * @version 2.1.0
+ */
+
+#ifndef XBATCHER_H
+#define XBATCHER_H
+
+#include "xfactory.h"
+#include <cstdint>
+
+namespace HX {
+
+class IXBatchSink;
+class IXImgSink;
+class XImage;
+
+/**
+ * @class XBatcher
+ * @brief Packs frames into normalized float16 batches for an inference engine
+ *
+ * Submit() cuts a frame into items of the size given to Start() and
+ * writes each as (value - offset) * scale straight into the batch buffer,
+ * in float16 by default, in the same pass on the shared processing pool
+ * (AVX2 + F16C where the CPU has them). A frame the size of an item is
+ * one item; a larger one is cut into tiles that overlap by
+ * SetTileOverlap() columns and rows, the last tile of a row or column
+ * moved back to the frame's edge; a smaller one is padded with 0.
+ *
+ * A full batch goes to IXBatchSink::OnBatchReady() on a hand-off thread
+ * and a new buffer starts filling, so the engine can copy or run one
+ * batch while the next fills. Buffers come from a fixed pool allocated in
+ * Start(); with SetAllocator() and AllocOptions::lock they are page-locked
+ * (pinned) pages a GPU can DMA from. A frame that finds too few free
+ * buffers for its items is dropped whole.
+ *
+ *   batcher.SetBatchSink(&engine);
+ *   XFactory::AllocOptions pinned;
+ *   pinned.lock = true;
+ *   batcher.SetAllocator(&factory, pinned);
+ *   batcher.Start(512, 512);           // 512 x 512 tiles, 8 per batch
+ *   ...
+ *   batcher.Submit(image_);            // in OnFrameReady
+ *   ...
+ *   batcher.Release(batch.buffer);     // when the engine is done with it
+ */
+class XBatcher {
+public:
+    /**
+     * @enum XOutputType
+     * @brief Value type of the batch tensor
+     */
+    enum XOutputType {
+        XBATCH_FLOAT16 = 0,     ///< IEEE binary16 (default)
+        XBATCH_FLOAT32          ///< IEEE binary32
+    };
+
+    /**
+     * @brief Batcher counters since Start()
+     */
+    struct Statistics {
+        uint64_t framesSubmitted;   ///< Submit() calls
+        uint64_t framesDropped;     ///< Frames without room in free buffers
+        uint64_t itemsBatched;      ///< Frames or tiles written to batches
+        uint64_t batchesReady;      ///< Batches handed to the sink
+        uint64_t batchesPartial;    ///< ... of them flushed before they were full
+        uint32_t buffersFree;       ///< Buffers neither filling, queued nor held
+    };
+
+    XBatcher();
+    ~XBatcher();
+
+    /**
+     * @brief Set error/event callback sink
+     * @param sink_ Callback handler
+     *
+     * @note Drops raise event 122 with the frames dropped since Start();
+     *       a failed buffer allocation is error 50
+     */
+    void SetSink(IXImgSink* sink_);
+
+    /**
+     * @brief Set the receiver of the batches
+     * @return true on success, false if running
+     */
+    bool SetBatchSink(IXBatchSink* sink_);
+
+    /**
+     * @brief Set items per batch
+     * @param items 1..1024 (default 8)
+     * @return true on success, false if running or out of range
+     */
+    bool SetBatchSize(uint32_t items);
+
+    /**
+     * @brief Set the number of batch buffers
+     * @param count 2..64 (default 4): one filling, the rest queued or
+     *              held by the engine
+     * @return true on success, false if running or out of range
+     */
+    bool SetBufferCount(uint32_t count);
+
+    /// Number of batch buffers
+    uint32_t GetBufferCount() const;
+
+    /**
+     * @brief Set the overlap of neighbouring tiles
+     * @param pixels Shared columns and rows (default 0), less than the item size
+     * @return true on success, false if running
+     */
+    bool SetTileOverlap(uint32_t pixels);
+
+    /**
+     * @brief Select the tensor value type
+     * @return true on success, false if running
+     */
+    bool SetOutputType(XOutputType type);
+
+    /**
+     * @brief Set the normalization (value - offset) * scale
+     * @param offset Raw value that becomes 0
+     * @param scale Factor after the offset (0 = 1 / (2^depth - 1), the default,
+     *              so the depth's full range maps to 0..1)
+     * @return true on success, false if running
+     */
+    bool SetNormalization(float offset, float scale = 0.0f);
+
+    /**
+     * @brief Hand off a partial batch once its first item is this old
+     * @param ms Timeout in milliseconds (0 = wait for a full batch, the default)
+     * @return true on success, false if running
+     */
+    bool SetFlushTimeout(uint32_t ms);
+
+    /**
+     * @brief Allocate batch buffers through XFactory::AllocateEx()
+     * @param factory Factory, or nullptr for page-aligned heap buffers (the default)
+     * @param options Placement; set lock for pinned buffers
+     * @return true on success, false if running
+     */
+    bool SetAllocator(XFactory* factory,
+                      const XFactory::AllocOptions& options = XFactory::AllocOptions());
+
+    /**
+     * @brief Allocate the buffers and start the hand-off thread
+     * @param itemWidth Values per item row
+     * @param itemHeight Rows per item
+     * @return false if running, no batch sink is set, the overlap is not
+     *         less than the item size, or the buffers cannot be allocated
+     *
+     * @note Buffers of the previous run are freed here; release them first
+     */
+    bool Start(uint32_t itemWidth, uint32_t itemHeight);
+
+    /**
+     * @brief Hand off the partial batch, deliver every queued batch and
+     *        stop the hand-off thread
+     *
+     * @note Buffers stay valid until the next Start() or destruction
+     */
+    void Stop();
+
+    /**
+     * @brief Check if the batcher is running
+     */
+    bool IsRunning() const;
+
+    /**
+     * @brief Add a frame's items to the batches
+     * @param image Frame with 1-16 bit pixels
+     * @return false if not running, the image is unsupported, or the frame
+     *         was dropped for lack of free buffers
+     *
+     * @note The frame is converted before Submit() returns, so the image
+     *       can be released on return
+     */
+    bool Submit(const XImage* image);
+
+    /**
+     * @brief Hand off the partial batch now
+     * @return true if a batch was handed off
+     */
+    bool Flush();
+
+    /**
+     * @brief Return a buffer once the engine no longer reads it
+     * @param buffer XBatch::buffer
+     * @return false if the buffer is not held by the sink
+     */
+    bool Release(uint32_t buffer);
+
+    /**
+     * @brief Get batcher counters
+     * @return Statistics since Start()
+     */
+    Statistics GetStatistics() const;
+
+private:
+    class Impl;
+    Impl* m_impl;
+
+    // Non-copyable
+    XBatcher(const XBatcher&) = delete;
+    XBatcher& operator=(const XBatcher&) = delete;
+};
+
+} // namespace HX
+
+#endif // XBATCHER_H
@@ -16,8 +16,13 @@ namespace HX {
 
 class XDetector;
 class XFactory;
+class XGrabber;
 class IXCmdSink;
 
+namespace Internal {
+class LinkListener;
+}
+
 /**
  * @class XControl
  * @brief Command control interface for X-ray detectors
@@ -27,6 +32,12 @@ class IXCmdSink;
  * - Command execution
  * - Heartbeat monitoring
  * - Error handling
+ *
+ * Commands are tagged with a sequence number and a receive thread matches
+ * each response to its command, so ReadAsync/WriteAsync can keep several
+ * commands in flight (a 30-parameter recipe costs a few round trips
+ * instead of thirty). The synchronous calls use the same channel and
+ * wait for their own response.
  */
 class XControl {
 public:
@@ -84,6 +95,53 @@ public:
         XDM_SN                  ///< DM serial number (string)
     };
     
+    /**
+     * @brief One parameter of a ReadMany/WriteMany transaction
+     */
+    struct XItem {
+        XCode code;         ///< Parameter code
+        uint8_t index;      ///< DM index (0xFF for all, 0 for none)
+        uint64_t val;       ///< Value to write, or numeric value read
+        std::string str;    ///< String value read (XCU_SN, XDM_SN)
+        int32_t result;     ///< Result of this item, as the single Read/Write
+    };
+    
+    /// Round-trip histogram buckets; bucket i counts [2^i, 2^(i+1)) µs
+    static const uint32_t LATENCY_BUCKETS = 24;
+    
+    /**
+     * @struct CommandStatistics
+     * @brief Round trips of one kind of command
+     */
+    struct CommandStatistics {
+        uint64_t commands;      ///< Commands answered
+        uint64_t timeouts;      ///< Commands not answered in time
+        uint64_t deviceErrors;  ///< Answers carrying a device error code
+        uint64_t totalUs;       ///< Sum of round trips (µs)
+        uint32_t maxUs;         ///< Longest round trip (µs)
+        uint64_t histogram[LATENCY_BUCKETS]; ///< Round trips; the last bucket holds all longer
+    };
+    
+    /**
+     * @struct Statistics
+     * @brief Live command-path counters
+     *
+     * A round trip runs from handing the command to the network until the
+     * receive thread matches its response, so it covers the network and the
+     * device. Time spent before that, waiting for the command lock or for
+     * a slot in the window (SetMaxInFlight()), is counted separately.
+     */
+    struct Statistics {
+        CommandStatistics commands;     ///< All other commands
+        CommandStatistics heartbeat;    ///< Heartbeats
+        CommandStatistics batch;        ///< ReadMany/WriteMany batch commands
+        uint64_t lockWaits;             ///< Command lock acquisitions that had to wait
+        uint64_t lockWaitUs;            ///< Time spent waiting for the command lock (µs)
+        uint32_t lockMaxUs;             ///< Longest wait for the command lock (µs)
+        uint64_t windowWaits;           ///< Commands that found the window full
+        uint64_t windowWaitUs;          ///< Time spent waiting for a window slot (µs)
+    };
+
     XControl();
     ~XControl();
     
@@ -117,18 +175,22 @@ public:
      * @param code Parameter code
      * @param val Output value
      * @param index DM index (0xFF for all, 0 for none)
+     * @param cached false to ask the device even if the value is cached
      * @return 1 on success, -1 on error, 0 if unsupported
+     *
+     * @note See EnableCache() for the values answered without the device
      */
-    int32_t Read(XCode code, uint64_t& val, uint8_t index = 0);
+    int32_t Read(XCode code, uint64_t& val, uint8_t index = 0, bool cached = true);
     
     /**
      * @brief Read string parameter
      * @param code Parameter code
      * @param val Output string
      * @param index DM index
+     * @param cached false to ask the device even if the value is cached
      * @return 1 on success, -1 on error, 0 if unsupported
      */
-    int32_t Read(XCode code, std::string& val, uint8_t index = 0);
+    int32_t Read(XCode code, std::string& val, uint8_t index = 0, bool cached = true);
     
     /**
      * @brief Write parameter value
@@ -138,7 +200,68 @@ public:
      * @return 1 on success, -1 on error, 0 if unsupported
      */
     int32_t Write(XCode code, uint64_t val, uint8_t index = 0);
-    
+
+    /**
+     * @brief Read several parameters in as few commands as possible
+     * @param items Parameters to read; val/str and result are filled in
+     * @param count Number of items
+     * @return Number of items read successfully, -1 on invalid arguments
+     *
+     * @note Items are packed into batch commands of up to 255 data bytes.
+     *       Firmware that rejects batch commands is read item by item
+     *       (remembered until the next Open()), as are codes the device does
+     *       not answer (XPIXEL_DEPTH).
+     */
+    int32_t ReadMany(XItem* items, uint32_t count);
+
+    /**
+     * @brief Write several parameters in as few commands as possible
+     * @param items Parameters and values to write; result is filled in
+     * @param count Number of items
+     * @return Number of items written successfully, -1 on invalid arguments
+     *
+     * @note Writes are applied in item order, with the same fallback as
+     *       ReadMany()
+     */
+    int32_t WriteMany(XItem* items, uint32_t count);
+
+    /**
+     * @brief Start a parameter read without waiting for the response
+     * @param code Parameter code (numeric parameters read from the device)
+     * @param index DM index (0xFF for all, 0 for none)
+     * @return Ticket passed to IXCmdSink::OnXComplete, 0 on error or if unsupported
+     *
+     * @note Always asks the device, bypassing the cache. Blocks only while
+     *       SetMaxInFlight() commands are already pending
+     */
+    uint32_t ReadAsync(XCode code, uint8_t index = 0);
+
+    /**
+     * @brief Start a parameter write without waiting for the response
+     * @param code Parameter code
+     * @param val Value to write
+     * @param index DM index (0xFF for all, 0 for none)
+     * @return Ticket passed to IXCmdSink::OnXComplete, 0 on error or if unsupported
+     *
+     * @note Commands are sent in call order; the device applies them in
+     *       arrival order. Call WaitAsync() before a write that depends on
+     *       earlier ones having taken effect.
+     */
+    uint32_t WriteAsync(XCode code, uint64_t val, uint8_t index = 0);
+
+    /**
+     * @brief Wait until no asynchronous command is pending
+     * @param timeout Timeout in milliseconds
+     * @return true if all completed, false on timeout
+     */
+    bool WaitAsync(uint32_t timeout);
+
+    /**
+     * @brief Limit the commands in flight at once
+     * @param count Pending commands (default 8, minimum 1)
+     */
+    void SetMaxInFlight(uint32_t count);
+
     /**
      * @brief Set event callback sink
      * @param sink_ Callback handler
@@ -157,6 +280,24 @@ public:
      */
     void SetTimeout(uint32_t time);
     
+    /**
+     * @brief Enable/disable the parameter cache (enabled by default)
+     * @param enable true to enable
+     *
+     * The cache holds values that do not change while the device runs
+     * (serial numbers, versions, pixel count and size) once read, and the
+     * values this client last wrote successfully. XINIT and XRESTORE drop
+     * the written values; Open() and Close() drop everything. Values
+     * changed by another client or on the device itself are not seen
+     * until read with cached = false, which also refreshes the entry.
+     */
+    void EnableCache(bool enable);
+    
+    /**
+     * @brief Drop all cached values
+     */
+    void InvalidateCache();
+    
     /**
      * @brief Enable/disable heartbeat monitoring
      * @param enable true to enable, false to disable
@@ -164,10 +305,73 @@ public:
      */
     bool EnableHeartbeat(bool enable);
     
+    /**
+     * @brief Set the heartbeat period
+     * @param period Milliseconds between heartbeats (default 1000)
+     * @return false if period is 0
+     *
+     * @note The heartbeat bypasses the SetMaxInFlight() window and nothing
+     *       waits for it. One unanswered within a period is a miss; ten
+     *       in a row, with no other command answered meanwhile, raise
+     *       error 39.
+     */
+    bool SetHeartbeatPeriod(uint32_t period);
+    
+    /**
+     * @brief Get the last temperature and humidity from the heartbeat
+     * @param temperature Output temperature (°C)
+     * @param humidity Output relative humidity (%)
+     * @return false if no heartbeat carried them yet
+     *
+     * @note Also published as IXCmdSink::OnXEvent 107 and 108
+     */
+    bool GetTelemetry(float& temperature, float& humidity);
+    
+    /**
+     * @brief Get live command-path statistics
+     * @param stats Output counters
+     */
+    void GetStatistics(Statistics& stats);
+    
+    /**
+     * @brief Get the round trips of the command behind one parameter
+     * @param code Parameter or operation code
+     * @param stats Output counters (reads and writes of the code together)
+     * @return false if the code is not sent to the device
+     *
+     * @note Parameters sent inside a batch are counted in Statistics::batch
+     */
+    bool GetStatistics(XCode code, CommandStatistics& stats);
+    
+    /**
+     * @brief Reset command-path statistics
+     */
+    void ResetStatistics();
+    
+    /**
+     * @brief Reconnect automatically when the heartbeat loses the link
+     * @param enable true to enable (disabled by default)
+     * @param retry Milliseconds between reconnect attempts
+     *
+     * @note On error 39 the heartbeat thread closes the network and reopens
+     *       it until the detector answers, then writes the values this
+     *       client last wrote again (those in the cache, see EnableCache())
+     *       and raises event 109 with the time since the last answer in ms.
+     *       An XGrabber opened with this control that was grabbing is
+     *       suspended meanwhile and resumes on the same XFrame. Commands
+     *       sent while reconnecting fail. Requires the heartbeat.
+     */
+    void SetAutoReconnect(bool enable, uint32_t retry = 1000);
+    
 private:
     class Impl;
     Impl* m_impl;
     
+    // XGrabber follows the reconnects of the control it was opened with
+    friend class XGrabber;
+    void addLinkListener(Internal::LinkListener* listener);
+    void removeLinkListener(Internal::LinkListener* listener);
+    
     // Non-copyable
     XControl(const XControl&) = delete;
     XControl& operator=(const XControl&) = delete;
@@ -0,0 +1,104 @@
+// ============================================================================
+
+/**
+ * @file XControlGroup.h
+ * @brief XControlGroup class - Commands fanned out to several detectors
+ * @version 2.1.0
+ */
+
+#ifndef XCONTROL_GROUP_H
+#define XCONTROL_GROUP_H
+
+#include <cstdint>
+#include "XControl.h"
+
+namespace HX {
+
+/**
+ * @class XControlGroup
+ * @brief Sends the same commands to several opened XControl objects at once
+ *
+ * Each call runs every detector's command in its own thread and returns
+ * once all have answered, so a fleet costs one round trip instead of one
+ * per detector. Results come back per detector, in the order they were
+ * added; errors are still reported to each XControl's own sink.
+ *
+ * The group does not own the controls; they must stay open while added.
+ */
+class XControlGroup {
+public:
+    XControlGroup();
+    ~XControlGroup();
+
+    /**
+     * @brief Add a detector's control
+     * @param control Opened XControl
+     * @return false if already in the group
+     */
+    bool Add(XControl& control);
+
+    /**
+     * @brief Remove all controls
+     */
+    void Clear();
+
+    /**
+     * @brief Get number of controls in the group
+     */
+    uint32_t GetCount();
+
+    /**
+     * @brief Execute an operation on every detector
+     * @param code Command code
+     * @param data Command data (optional)
+     * @param results One XControl::Operate() result per detector (optional)
+     * @return Number of detectors that succeeded
+     *
+     * @note The threads are started first and released together, so the
+     *       commands leave within microseconds of each other; use
+     *       XFRAME_TR_GEN to start exposure on all detectors together.
+     *       GetLastSkew() reports the spread.
+     */
+    int32_t Operate(XControl::XCode code, uint64_t data = 0, int32_t* results = nullptr);
+
+    /**
+     * @brief Write a parameter on every detector
+     * @param code Parameter code
+     * @param val Value to write
+     * @param index DM index (0xFF for all, 0 for none)
+     * @param results One XControl::Write() result per detector (optional)
+     * @return Number of detectors that succeeded
+     */
+    int32_t Write(XControl::XCode code, uint64_t val, uint8_t index = 0,
+                  int32_t* results = nullptr);
+
+    /**
+     * @brief Write the same parameter set on every detector
+     * @param items Parameters and values; result is not touched
+     * @param count Number of items
+     * @param results Per detector, the items XControl::WriteMany() wrote,
+     *        or -1 on invalid arguments (optional)
+     * @return Number of detectors on which every item was written
+     */
+    int32_t WriteMany(const XControl::XItem* items, uint32_t count,
+                      int32_t* results = nullptr);
+
+    /**
+     * @brief Get the spread of the last Operate()
+     * @return Microseconds between the first and the last detector's
+     *         command being handed to its XControl
+     */
+    uint32_t GetLastSkew();
+
+private:
+    class Impl;
+    Impl* m_impl;
+
+    // Non-copyable
+    XControlGroup(const XControlGroup&) = delete;
+    XControlGroup& operator=(const XControlGroup&) = delete;
+};
+
+} // namespace HX
+
+#endif // XCONTROL_GROUP_H
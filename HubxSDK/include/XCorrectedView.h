@@ -0,0 +1,158 @@
+// ============================================================================
+
+/**
+ * @file XCorrectedView.h
+ * @brief XCorrectedView class - Archived raw frames corrected on demand
+ * @version 2.1.0
+ */
+
+#ifndef XCORRECTEDVIEW_H
+#define XCORRECTEDVIEW_H
+
+#include <cstdint>
+
+namespace HX {
+
+class IXLineFilter;
+class XImage;
+
+/**
+ * @class XCorrectedView
+ * @brief Corrected pixels of a raw frame, corrected only where they are read
+ *
+ * Raw frames are archived so they can be corrected again with a later
+ * calibration. The view runs the line filters of a correction (the same
+ * IXLineFilter chain XFrame::AddLineFilter() takes, e.g. offset/gain
+ * loaded from the calibration version wanted) over the rows a region or
+ * pixel query touches, and nowhere else. Rows are corrected in bands of
+ * SetTileRows() rows, across the full width since the filters correct
+ * whole lines, and the most recently used bands are kept; looking at part
+ * of a long stitched scan costs time in proportion to the rows on screen.
+ *
+ *   view.SetSource(&raw);
+ *   view.AddLineFilter(xogFilter);
+ *   view.SetCalibrationVersion(version);
+ *   view.GetRegion(x, y, w, h, &tile);     // to show, measure or export
+ *
+ * Calls are thread-safe; the filters run on the calling thread, one row
+ * at a time.
+ */
+class XCorrectedView {
+public:
+    /**
+     * @brief View counters since the source was set
+     */
+    struct Statistics {
+        uint64_t bandHits;      ///< Band reads served from the cache
+        uint64_t bandMisses;    ///< ... that corrected the band
+        uint64_t rowsCorrected; ///< Rows run through the filters
+        uint32_t bandsCached;   ///< Bands in the cache now
+    };
+
+    XCorrectedView();
+    ~XCorrectedView();
+
+    /**
+     * @brief Set the raw frame or stitched scan to correct
+     * @param raw Raw image, 9-16 bit for the SDK's corrections (not copied,
+     *            must outlive the view or the next SetSource()); nullptr
+     *            detaches it
+     * @param firstRow Row number the filters see for row 0, e.g. the
+     *                 frame's line number since Start()
+     * @return true on success, false if the image has no pixels or is
+     *         deeper than 16 bits
+     *
+     * @note Drops the cache; call Invalidate() as well if the pixels of
+     *       the same image change
+     */
+    bool SetSource(const XImage* raw, uint32_t firstRow = 0);
+
+    /**
+     * @brief Append a correction stage
+     * @param filter Filter (not owned, must outlive the view)
+     * @return true on success, false if filter is null
+     *
+     * @note Filters run in order, as in XFrame; without any the view
+     *       returns the raw pixels. Drops the cache.
+     */
+    bool AddLineFilter(IXLineFilter* filter);
+
+    /**
+     * @brief Remove all correction stages and drop the cache
+     */
+    void ClearLineFilters();
+
+    /**
+     * @brief Name the calibration the filters apply
+     * @param version Version, e.g. from hubx_xog_get_version(); written to
+     *                XFrameInfo::calibrationVersion of every region
+     *
+     * @note A different version drops the cache, so bands corrected with
+     *       the old calibration are never mixed with new ones
+     */
+    void SetCalibrationVersion(uint64_t version);
+
+    /// Calibration version of the corrected rows
+    uint64_t GetCalibrationVersion() const;
+
+    /**
+     * @brief Set rows per cached band
+     * @param rows 1..4096 (default 64)
+     * @return true on success, false if out of range
+     */
+    bool SetTileRows(uint32_t rows);
+
+    /**
+     * @brief Set the number of bands kept
+     * @param bands 1..65536 (default 64)
+     * @return true on success, false if out of range
+     */
+    bool SetCacheSize(uint32_t bands);
+
+    /**
+     * @brief Get a corrected region
+     * @param x First column
+     * @param y First row
+     * @param width Columns, clipped to the source
+     * @param height Rows, clipped to the source
+     * @param out Output; reallocated if its size or depth does not match
+     * @return false if no source is set, the region starts outside it, or
+     *         out is null
+     *
+     * @note out gets the source's XFrameInfo with calibrationVersion set
+     */
+    bool GetRegion(uint32_t x, uint32_t y, uint32_t width, uint32_t height, XImage* out);
+
+    /**
+     * @brief Get one corrected pixel
+     * @param row Row index
+     * @param col Column index
+     * @param value Output value
+     * @return false if no source is set or the pixel is outside it
+     */
+    bool GetPixel(uint32_t row, uint32_t col, uint32_t& value);
+
+    /**
+     * @brief Drop every corrected band, e.g. after the calibration behind
+     *        the filters was reloaded under the same version
+     */
+    void Invalidate();
+
+    /**
+     * @brief Get view counters
+     * @return Statistics since the source was set
+     */
+    Statistics GetStatistics() const;
+
+private:
+    class Impl;
+    Impl* m_impl;
+
+    // Non-copyable
+    XCorrectedView(const XCorrectedView&) = delete;
+    XCorrectedView& operator=(const XCorrectedView&) = delete;
+};
+
+} // namespace HX
+
+#endif // XCORRECTEDVIEW_H
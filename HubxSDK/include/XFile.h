@@ -18,10 +18,36 @@ namespace HX {
 
 class XImage;
 class XDetector;
+class XFrame;
 
 /**
  * @class XFile
  * @brief Handles TIFF image file operations with metadata
+ *
+ * Write() produces an uncompressed little-endian grayscale TIFF (BigTIFF
+ * when the file would exceed 4 GB), one strip, with the XFCode metadata in
+ * private tags 65000-65010. Read() accepts such files, other uncompressed
+ * 8/16/32-bit grayscale TIFFs, and files of the older text-header format.
+ *
+ * With SetCompression(XF_COMPRESS_DELTA) the pixels are stored losslessly
+ * as strips of a delta + bit-packing codec (private TIFF compression
+ * 65000), encoded and decoded in parallel on the correction thread pool.
+ * Frames whose noise fits in a few bits shrink 2-3x; only HubxSDK reads
+ * these files back.
+ *
+ * XF_COMPRESS_TEMPORAL stores the residuals against a reference frame
+ * instead, normally the frame recorded before (private compression 65001,
+ * the reference's file name in tag 65011). Frames of a static scene or a
+ * slow rotation then need little more than their noise. Read() of such a
+ * file uses the decoded reference given to SetReference() if it names the
+ * same file, and otherwise reads the chain of references back to the last
+ * keyframe, a file stored with XF_COMPRESS_DELTA.
+ *
+ * With SetTiling() the file is a tiled pyramid instead: the full image in
+ * square tiles, followed by reduced-resolution copies (each a 2x2 box
+ * average of the one before) in further directories, so a viewer can pan
+ * and zoom a very large scan by reading only the tiles on screen. Read()
+ * loads the full-resolution image of such files.
  */
 class XFile {
 public:
@@ -47,6 +73,16 @@ public:
         XF_DATE             ///< Date/time string
     };
     
+    /**
+     * @enum XFCompression
+     * @brief Pixel storage used by Write()
+     */
+    enum XFCompression {
+        XF_COMPRESS_NONE = 0,   ///< One raw strip (default, readable by any TIFF reader)
+        XF_COMPRESS_DELTA,      ///< Delta + bit-packing strips
+        XF_COMPRESS_TEMPORAL    ///< Bit-packed residuals against SetReference()
+    };
+    
     XFile();
     XFile(XImage* image_, XDetector& det);
     ~XFile();
@@ -58,6 +94,29 @@ public:
      */
     bool Read(const std::string& file);
     
+    /**
+     * @brief Open TIFF file without copying the pixels
+     * @param file File path
+     * @return true on success
+     *
+     * @note The image (and XF_DATA) points into a copy-on-write mapping of
+     *       the file: pixels are paged in on first touch, and writes to them
+     *       never reach the file. The pixels stay valid until the next
+     *       Read()/Map() or until this XFile is destroyed. Files that cannot
+     *       be mapped (older text format, scattered or compressed strips) are
+     *       read instead.
+     */
+    bool Map(const std::string& file);
+    
+    /**
+     * @brief Get the image the pixels are read into
+     * @return Image given to the constructor, or the one Read()/Map()
+     *         allocated (nullptr before the first of them)
+     *
+     * @note An image allocated here is owned by this XFile
+     */
+    XImage* GetImage() const;
+    
     /**
      * @brief Write TIFF file
      * @param file File path
@@ -65,6 +124,80 @@ public:
      */
     bool Write(const std::string& file);
     
+    /**
+     * @brief Select how Write() stores the pixels
+     * @param mode Compression mode
+     */
+    void SetCompression(XFCompression mode);
+    
+    /**
+     * @brief Get compression mode
+     * @return Mode set for Write(), or the mode of the file last read
+     */
+    XFCompression GetCompression() const;
+    
+    /**
+     * @brief Set the frame XF_COMPRESS_TEMPORAL residuals are taken against
+     * @param reference Decoded reference frame (not copied, must stay valid
+     *                  until the next Write()/Read()); nullptr clears it
+     * @param file Name of the reference's file, relative to the directory
+     *             of the file written or read
+     *
+     * @note Write() stores residuals if the reference has the image's size
+     *       and container, and a keyframe (XF_COMPRESS_DELTA) otherwise.
+     *       Read() uses the reference only for a file whose residuals name
+     *       the same file. The reference may be the image read into, which
+     *       is then updated in place.
+     */
+    void SetReference(const XImage* reference, const std::string& file);
+    
+    /**
+     * @brief Select tiled pyramid output for Write()
+     * @param tileSize Tile width and height in pixels, a multiple of 16
+     *                 (0 = one strip, the default)
+     * @param levels Reduced-resolution levels after the full image
+     *               (0 = halve until the image fits in one tile)
+     * @return true on success, false if tileSize is not a multiple of 16
+     *
+     * @note Tiles are stored uncompressed so any TIFF viewer can open the
+     *       file; the compression mode does not apply to tiled output
+     */
+    bool SetTiling(uint32_t tileSize, uint32_t levels = 0);
+    
+    /**
+     * @brief Take tiled levels from the frames' own pyramid
+     * @param frame Frame assembler with XFrame::SetPyramid() on, whose
+     *              delivered frames are written (not owned, nullptr = off)
+     *
+     * @note The first reduced levels of a frame it still holds are copied
+     *       from XFrame::GetPyramid() instead of being computed again; the
+     *       file is the same either way. Other images are reduced as usual.
+     */
+    void SetPyramidSource(const XFrame* frame);
+    
+    /**
+     * @brief Record every file written in its directory's metadata index
+     * @param enable true to append a record after each successful Write()
+     *
+     * @note The index (see XArchiveIndex) is off by default
+     */
+    void SetIndexing(bool enable);
+    
+    /**
+     * @brief Write contrast-equalized pixels (CLAHE) instead of the raw ones
+     * @param enable true = Write() stores the image after tiled
+     *               contrast-limited adaptive histogram equalization
+     * @param tiles Tiles per axis (1..32)
+     * @param clipLimit Histogram clip as a multiple of the mean bin (>= 1)
+     * @return false if tiles or clipLimit is out of range
+     *
+     * @note Off by default. The file keeps the image's size and depth and
+     *       the image itself is not changed; Write() fails for pixels
+     *       deeper than 16 bits. Writing the same XFrame frame again (to
+     *       another path or format) reuses the equalized pixels.
+     */
+    bool SetContrastEnhancement(bool enable, uint32_t tiles = 8, float clipLimit = 2.5f);
+    
     /**
      * @brief Get parameter value (uint32_t)
      * @param code Parameter code
@@ -0,0 +1,132 @@
+// ============================================================================
+
+/**
+ * @file XFlightRecorder.h
+ * @brief XFlightRecorder class - Pre-trigger ring of the latest raw lines
+ * @version 2.1.0
+ */
+
+#ifndef XFLIGHTRECORDER_H
+#define XFLIGHTRECORDER_H
+
+#include <cstdint>
+#include <string>
+
+namespace HX {
+
+class IXImgSink;
+
+/**
+ * @class XFlightRecorder
+ * @brief Keeps the last seconds of raw line data in a memory-mapped ring file
+ *
+ * Attached with XGrabber::SetFlightRecorder(), every received line payload
+ * is copied into the next slot of a circular file mapped into memory. A
+ * line costs one memcpy and no system call; a background thread flushes
+ * the mapping with an asynchronous msync at the sync interval. Trigger()
+ * copies the current window into an XStreamFile, so a flagged scan can be
+ * kept after its frames are gone.
+ *
+ * Each slot carries a sequence number written after its payload, so the
+ * ring file stays readable when the process dies: Recover() extracts the
+ * window from it the same way Trigger() does. Lines reach the file in the
+ * order they are claimed; the few lines in flight at a crash are skipped.
+ *
+ * AddLine() may be called from several receive threads at once.
+ */
+class XFlightRecorder {
+public:
+    XFlightRecorder();
+    ~XFlightRecorder();
+
+    /**
+     * @brief Set error callback sink
+     * @param sink_ Callback handler
+     */
+    void SetSink(IXImgSink* sink_);
+
+    /**
+     * @brief Create the ring file and map it
+     * @param file Ring file path (replaced if it exists)
+     * @param width Pixels per line
+     * @param pixelDepth Bits per pixel
+     * @param lineRate Lines per second
+     * @param seconds Window kept by the ring
+     * @return true on success
+     *
+     * @note The file is allocated up front (lineRate * seconds slots of
+     *       one line each), so a full disk fails here and not mid-scan
+     */
+    bool Open(const std::string& file, uint32_t width, uint8_t pixelDepth,
+              uint32_t lineRate, uint32_t seconds);
+
+    /**
+     * @brief Flush and unmap the ring file
+     *
+     * @note The file is kept; Recover() can still read it. Stop grabbing
+     *       or detach the recorder first, AddLine() must not race Close()
+     */
+    void Close();
+
+    /**
+     * @brief Check if a ring file is mapped
+     */
+    bool IsOpen() const;
+
+    /**
+     * @brief Set how often the mapping is flushed to disk
+     * @param ms Interval in milliseconds (default 1000, 0 = only on Close())
+     */
+    void SetSyncInterval(uint32_t ms);
+
+    /**
+     * @brief Record one line
+     * @param data Line payload
+     * @param length Payload bytes; longer lines are truncated to one line
+     * @param lineId Detector lineId
+     *
+     * @note Segment and dual-energy packets are recorded one per call, as
+     *       the grabber receives them
+     */
+    void AddLine(const uint8_t* data, uint32_t length, uint32_t lineId);
+
+    /**
+     * @brief Get number of lines the ring holds
+     */
+    uint32_t GetCapacity() const;
+
+    /**
+     * @brief Get number of lines recorded since Open()
+     */
+    uint64_t GetLineCount() const;
+
+    /**
+     * @brief Copy the current window to a stream file
+     * @param file Output XStreamFile path
+     * @return true on success
+     *
+     * @note Runs on the calling thread while recording continues; the
+     *       oldest lines may be overwritten before they are copied
+     */
+    bool Trigger(const std::string& file);
+
+    /**
+     * @brief Extract the window of a ring file left by a previous run
+     * @param ringFile Ring file written by Open()
+     * @param file Output XStreamFile path
+     * @return true on success
+     */
+    static bool Recover(const std::string& ringFile, const std::string& file);
+
+private:
+    class Impl;
+    Impl* m_impl;
+
+    // Non-copyable
+    XFlightRecorder(const XFlightRecorder&) = delete;
+    XFlightRecorder& operator=(const XFlightRecorder&) = delete;
+};
+
+} // namespace HX
+
+#endif // XFLIGHTRECORDER_H
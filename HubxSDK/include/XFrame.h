@@ -8,10 +8,18 @@
 #define XFRAME_H
 
 #include <cstdint>
+#include "xfactory.h"
 
 namespace HX {
 
 class IXImgSink;
+class IXLineFilter;
+class XFrameBus;
+class XImage;
+
+namespace Internal {
+class FrameListener;
+}
 
 /**
  * @class XFrame
@@ -19,6 +27,115 @@ class IXImgSink;
  */
 class XFrame {
 public:
+    /**
+     * @brief What is zeroed before a frame buffer is reused
+     */
+    enum ClearPolicy {
+        CLEAR_NONE = 0,     ///< Nothing; rows that never arrive keep old data
+        CLEAR_MISSING,      ///< Missing rows only, just before delivery (default)
+        CLEAR_FULL          ///< Whole buffer after every frame
+    };
+    
+    /**
+     * @brief Working format for bit-packed (17-24 bit) wire lines
+     */
+    enum UnpackMode {
+        UNPACK_NONE = 0,    ///< Lines are stored as received (default)
+        UNPACK_32,          ///< One 32-bit container per pixel
+        UNPACK_16_CLIP      ///< One 16-bit container, values above 0xFFFF saturate
+    };
+    
+    /**
+     * @brief How binned pixels are reduced to the frame depth
+     */
+    enum BinMode {
+        BIN_SUM = 0,        ///< Sum, saturated at the pixel depth
+        BIN_AVERAGE         ///< Rounded mean of the pixels summed (default)
+    };
+    
+    /**
+     * @brief Frame-to-frame averaging of completed frames
+     */
+    enum TemporalMode {
+        TEMPORAL_OFF = 0,   ///< Frames are delivered as assembled (default)
+        TEMPORAL_RECURSIVE, ///< avg += (frame - avg) / K, one float per pixel
+        TEMPORAL_BLOCK      ///< Mean of K frames, one 32-bit sum per pixel
+    };
+    
+    /**
+     * @brief What a full AddSink() queue does with the next frame
+     */
+    enum SinkPolicy {
+        SINK_DROP_NEWEST = 0,   ///< Drop the new frame for this sink (default)
+        SINK_DROP_OLDEST,       ///< Drop the oldest frame not yet being delivered
+        SINK_BLOCK              ///< Wait for room: this sink paces assembly
+    };
+    
+    /**
+     * @brief Reduced image of a GetPyramid() level
+     */
+    enum PyramidStat {
+        PYRAMID_MIN = 0,        ///< Darkest pixel of each block
+        PYRAMID_MAX,            ///< Brightest pixel of each block
+        PYRAMID_MEAN            ///< Rounded mean of each block
+    };
+
+    /**
+     * @brief Time one sink spent in OnFrameReady since Start()
+     */
+    struct SinkLatency {
+        uint64_t calls;
+        uint64_t slowCalls;         ///< Calls over the SetSinkWatchdog() limit
+        uint64_t meanNs;
+        uint64_t p50Ns;
+        uint64_t p99Ns;
+        uint64_t p999Ns;
+        uint64_t maxNs;
+        uint64_t framePeriodNs;     ///< Period the limit is a share of (0 = not known yet)
+        
+        SinkLatency()
+            : calls(0), slowCalls(0), meanNs(0), p50Ns(0), p99Ns(0), p999Ns(0), maxNs(0),
+              framePeriodNs(0) {}
+    };
+
+    /**
+     * @brief Progress of a compressed burst (SetBurstCompression())
+     */
+    struct BurstStats {
+        uint32_t framesCaptured;    ///< Frames assembled and queued for packing
+        uint32_t framesPacked;      ///< Frames in the arena, readable with GetBurstFrame()
+        uint32_t backlog;           ///< Frames waiting for or being packed now
+        uint32_t backlogPeak;       ///< Most frames waiting at once since Start()
+        uint64_t rawBytes;          ///< Pixel bytes of the packed frames
+        uint64_t packedBytes;       ///< Arena bytes they take
+        uint64_t arenaBytes;
+        uint64_t stalls;            ///< Frames whose lines waited for a staging buffer
+        double ratio;               ///< rawBytes / packedBytes (0 = nothing packed yet)
+        bool arenaFull;             ///< A frame did not fit; the burst ended there
+        bool keepingUp;             ///< No stall since Start()
+        
+        BurstStats()
+            : framesCaptured(0), framesPacked(0), backlog(0), backlogPeak(0), rawBytes(0),
+              packedBytes(0), arenaBytes(0), stalls(0), ratio(0.0), arenaFull(false),
+              keepingUp(true) {}
+    };
+
+    /**
+     * @brief Acquisition time of one line
+     *
+     * The header timestamp is a 32-bit microsecond counter local to each
+     * detector; deviceUs extends it across wraps and hostNs places it on
+     * the host clock, so lines of different detectors can be aligned
+     * when the host runs PTP. Zero fields were not available.
+     */
+    struct LineTime {
+        uint64_t deviceUs;      ///< Detector timestamp, unwrapped to 64 bits
+        uint64_t hostNs;        ///< deviceUs on the host clock, ns since 1970 (arrival without deviceUs)
+        uint64_t receiveNs;     ///< NIC hardware receive time, ns since 1970
+        
+        LineTime() : deviceUs(0), hostNs(0), receiveNs(0) {}
+    };
+    
     XFrame();
     explicit XFrame(uint32_t lines);
     ~XFrame();
@@ -54,6 +171,23 @@ public:
      */
     void Stop();
     
+    /**
+     * @brief Allocate and touch the frame buffers ahead of Start()
+     * @param width Image width (pixels), as for Start()
+     * @param pixelDepth Bits per pixel, as for Start()
+     * @return true on success, false if running or the settings are invalid
+     * 
+     * @note Runs Start() and Stop() once without lines, so the pool (or
+     *       burst block) and the per-row bookkeeping are allocated, zeroed
+     *       and faulted in before acquisition, and the first frames do not
+     *       pay for it. From then on Stop() keeps the pool, and Start()
+     *       with the same format reuses its buffers as they are; a
+     *       different format, pool size or allocator replaces it. Frames
+     *       must not be held across Stop(). Not used with stride or a
+     *       frame bus, whose buffers are the window or the slots.
+     */
+    bool Prepare(uint32_t width, uint8_t pixelDepth);
+    
     /**
      * @brief Check if frame assembly is running
      * @return true if running
@@ -65,13 +199,842 @@ public:
      * @param lineData Line data pointer
      * @param lineLen Line data length
      * @param lineId Line identifier
+     * 
+     * @note The row is (lineId - first lineId) mod GetLines(), so lost or
+     *       reordered lines never shift the rows that follow them
      */
     void AddLine(const uint8_t* lineData, uint32_t lineLen, uint32_t lineId);
     
+    /**
+     * @brief Add line data with its acquisition time
+     * @param lineData Line data pointer
+     * @param lineLen Line data length
+     * @param lineId Line identifier
+     * @param timestampUs XLibPacketHeader::timestamp of the line
+     * 
+     * @note The timestamp only matters with SetScanResample(); lines added
+     *       without one are stamped with the host clock on arrival
+     */
+    void AddLine(const uint8_t* lineData, uint32_t lineLen, uint32_t lineId, uint32_t timestampUs);
+    
+    /**
+     * @brief Add line data with its full acquisition time
+     * @param lineData Line data pointer
+     * @param lineLen Line data length
+     * @param lineId Line identifier
+     * @param time Line time, kept for GetLineTimes()
+     * 
+     * @note The low 32 bits of deviceUs act as the timestamp above; lines
+     *       without one are stamped with the host clock on arrival
+     */
+    void AddLine(const uint8_t* lineData, uint32_t lineLen, uint32_t lineId, const LineTime& time);
+    
+    /**
+     * @brief Get the frame row a line will be written to (zero-copy receive)
+     * @param lineId Expected line identifier
+     * @param lineLen Output expected line length in bytes
+     * @return Row pointer inside the frame buffer, nullptr if not running
+     * 
+     * @note Fill the row, then call CommitLine() from the same thread
+     */
+    uint8_t* GetLineBuffer(uint32_t lineId, uint32_t& lineLen);
+    
+    /**
+     * @brief Commit a line written in place into a GetLineBuffer() row
+     * @param buffer Row pointer returned by GetLineBuffer()
+     * @param lineLen Bytes written
+     * @param lineId Actual line identifier
+     */
+    void CommitLine(uint8_t* buffer, uint32_t lineLen, uint32_t lineId);
+    
+    /**
+     * @brief Commit an in-place line with its acquisition time
+     * @param buffer Row pointer returned by GetLineBuffer()
+     * @param lineLen Bytes written
+     * @param lineId Actual line identifier
+     * @param timestampUs XLibPacketHeader::timestamp of the line
+     */
+    void CommitLine(uint8_t* buffer, uint32_t lineLen, uint32_t lineId, uint32_t timestampUs);
+    
+    /**
+     * @brief Commit an in-place line with its full acquisition time
+     * @param buffer Row pointer returned by GetLineBuffer()
+     * @param lineLen Bytes written
+     * @param lineId Actual line identifier
+     * @param time Line time, kept for GetLineTimes()
+     */
+    void CommitLine(uint8_t* buffer, uint32_t lineLen, uint32_t lineId, const LineTime& time);
+    
+    /**
+     * @brief Set number of preallocated frame buffers
+     * @param count Buffer count (1 = single buffer, reused after OnFrameReady)
+     * @return true on success, false if running or count is 0
+     * 
+     * @note With count > 1 every frame passed to OnFrameReady stays valid
+     *       until the sink returns it with Release(), also across Stop():
+     *       a buffer still held when the pool is freed is freed on its
+     *       last Release() instead, or with the XFrame. Buffers the sink holds
+     *       count towards XFactory::SetOverloadPolicy(); frames that policy
+     *       drops whole go back to the pool with event 118 (data = frames
+     *       shed since Start)
+     */
+    bool SetPoolSize(uint32_t count);
+    
+    /**
+     * @brief Get number of preallocated frame buffers
+     * @return Buffer count
+     */
+    uint32_t GetPoolSize() const;
+    
+    /**
+     * @brief Get number of buffers currently available for assembly
+     * @return Free buffer count
+     */
+    uint32_t GetFreeBuffers() const;
+    
+    /**
+     * @brief Return a frame delivered by OnFrameReady to the pool
+     * @param image Frame previously passed to OnFrameReady
+     */
+    void Release(XImage* image);
+    
+    /**
+     * @brief Add a sink with its own delivery queue and thread
+     * @param sink_ Frame consumer
+     * @param queueFrames Frames that may wait for this sink (default 4)
+     * @param policy What happens to a frame while the queue is full
+     * @return true on success, false if running, null, already added or queueFrames is 0
+     * 
+     * @note Every frame OnFrameReady would see is also queued to each added
+     *       sink, and a thread per sink calls its OnFrameReady, so a slow
+     *       consumer only loses its own frames. All sinks share the same
+     *       buffer: it goes back to the pool once the SetSink() sink has
+     *       released it and every added sink has returned. Added sinks
+     *       must not call Release(); the frame is only valid during their
+     *       callback. Drops raise event 121 (data = drops since Start())
+     *       on the SetSink() sink, which alone gets errors, events and
+     *       strips. Needs a pool of two or more buffers and no stride;
+     *       without SetPoolSize() the host profile's pool size is used.
+     *       Stop() returns once every queued frame was delivered.
+     */
+    bool AddSink(IXImgSink* sink_, uint32_t queueFrames = 4, SinkPolicy policy = SINK_DROP_NEWEST);
+    
+    /**
+     * @brief Remove a sink added with AddSink()
+     * @param sink_ Sink to remove
+     * @return true on success, false if running or not added
+     */
+    bool RemoveSink(IXImgSink* sink_);
+    
+    /**
+     * @brief Get frames an added sink lost to its queue policy
+     * @param sink_ Sink added with AddSink()
+     * @return Frames dropped for this sink since Start()
+     */
+    uint64_t GetSinkDropped(IXImgSink* sink_) const;
+    
+    /**
+     * @brief Also deliver every frame as it was received, before the line filters
+     * @param sink_ Raw frame consumer (nullptr = off)
+     * @return true on success, false if running
+     * 
+     * @note Each line is copied into a second pool buffer as it is placed,
+     *       while the filters write the corrected row, so both frames come
+     *       from the same pass and neither is cloned afterwards. The raw
+     *       frame is passed to this sink's OnFrameReady just before the
+     *       corrected one is delivered, with the same XFrameInfo and missing
+     *       lines; the sink returns it with Release(), e.g. through
+     *       XRecorder::Submit(image, &frame), and it goes back to the pool
+     *       then. When no buffer is left for it only the raw frame is
+     *       dropped, with event 124 (data = raw frames dropped since
+     *       Start()); a frame dropped for an exhausted pool takes its raw
+     *       frame with it and counts there too. Start() needs line filters,
+     *       a SetSink() or added sink and a pool of four or more buffers,
+     *       with no frame bus, stride, burst, object framing or temporal
+     *       averaging, and no SetUnpack(), SetROI(), SetScanResample() or
+     *       SetBinning(), which would change the lines before they are kept.
+     */
+    bool SetRawSink(IXImgSink* sink_);
+    
+    /**
+     * @brief Flag sink callbacks that hold up acquisition
+     * @param fraction Share of the frame period one OnFrameReady may take
+     *                 (0 = off, the default)
+     * @param framePeriodUs Frame period (0 = measured from the detector,
+     *                      else receive, times of successive frames)
+     * @return false if fraction is negative or running
+     * 
+     * @note Every OnFrameReady of the SetSink() sink and the added sinks
+     *       is timed, watchdog or not (GetSinkLatency()). A call over the
+     *       limit counts as slow and raises event 123 (data = duration of
+     *       the call, us) on the SetSink() sink with a log warning, at most
+     *       once per second and sink. A callback slower than the period
+     *       backs lines up into the receive ring until it overflows.
+     */
+    bool SetSinkWatchdog(float fraction, uint32_t framePeriodUs = 0);
+    
+    /**
+     * @brief Get the time a sink spends in OnFrameReady
+     * @param sink_ The SetSink() sink or one added with AddSink()
+     * @param latency Output, since Start()
+     * @return false if sink_ is neither
+     */
+    bool GetSinkLatency(IXImgSink* sink_, SinkLatency& latency) const;
+    
+    /**
+     * @brief Capture a burst of frames into one preallocated block
+     * @param frames Frames in the burst (0 = off, frees a kept burst)
+     * @return true on success, false if running
+     * 
+     * @note Start() allocates a single contiguous block for all frames
+     *       (through SetAllocator(), so on huge pages and pre-faulted if
+     *       asked for; otherwise zeroed heap) in place of the pool, and
+     *       later Start()s with the same format only zero it again. Lines
+     *       go straight into successive frames and nothing is called per
+     *       frame: no OnFrameReady, strips or event 111. Once the last
+     *       frame is complete, event 120 (data = frames) is raised and
+     *       further lines are dropped. The frames stay valid after Stop(),
+     *       until the next Start(), ReleaseBurst() or SetBurst(), for
+     *       correcting or saving; GetMissingLines() and GetLineTimes()
+     *       work on them. Needs no stride, strips, object framing,
+     *       temporal averaging or frame bus.
+     */
+    bool SetBurst(uint32_t frames);
+    
+    /**
+     * @brief Get frames per burst
+     * @return Frame count, 0 if off
+     */
+    uint32_t GetBurst() const;
+    
+    /**
+     * @brief Get number of burst frames captured so far
+     * @return Complete frames, each readable with GetBurstFrame()
+     */
+    uint32_t GetBurstFrames() const;
+    
+    /**
+     * @brief Get a captured burst frame
+     * @param index Frame below GetBurstFrames()
+     * @return The frame, nullptr past the captured ones
+     */
+    XImage* GetBurstFrame(uint32_t index) const;
+    
+    /**
+     * @brief Free the block of a burst kept after Stop()
+     */
+    void ReleaseBurst();
+    
+    /**
+     * @brief Keep burst frames packed losslessly, so more fit in memory
+     * @param arenaBytes Memory for the packed frames (0 = frames stay raw)
+     * @param workers Packing threads (default 2)
+     * @return true on success, false if running or workers is 0
+     * 
+     * @note Lines land in 2 x workers + 1 staging frames instead of one
+     *       frame per burst frame. Each completed frame is delta-packed by
+     *       a worker while the burst goes on, appended to the arena, which
+     *       Start() allocates and faults in with the staging frames, and
+     *       its staging frame is reused. Frames are kept in capture order:
+     *       the burst ends at SetBurst() frames or at the first frame that
+     *       does not fit the arena, whichever is first, with event 120
+     *       (data = frames packed so far) on the arena running full. When
+     *       every staging frame is still being packed the assembly waits
+     *       for a worker and event 125 (data = stalls since Start()) is
+     *       raised; lines then back up in the grabber. GetBurstStats()
+     *       reports the ratio and backlog live. GetBurstFrames() counts
+     *       the packed frames and GetBurstFrame() unpacks into one frame
+     *       of its own, valid until the next GetBurstFrame() call.
+     *       Stop() returns once every captured frame is packed.
+     */
+    bool SetBurstCompression(uint64_t arenaBytes, uint32_t workers = 2);
+    
+    /**
+     * @brief Get the progress of a compressed burst
+     * @param stats Output
+     * @return false if the burst is not compressed
+     */
+    bool GetBurstStats(BurstStats& stats) const;
+    
+    /**
+     * @brief Set how many early lines of the next frame are held back
+     * @param lines Reorder window in lines (0 = emit as soon as the next frame starts)
+     * @return true on success, false if running
+     */
+    bool SetReorderWindow(uint32_t lines);
+    
+    /**
+     * @brief Get reorder window
+     * @return Reorder window in lines
+     */
+    uint32_t GetReorderWindow() const;
+    
+    /**
+     * @brief Emit an incomplete frame when no line arrives for this long
+     * @param ms Timeout in milliseconds (0 = disabled)
+     */
+    void SetFrameTimeout(uint32_t ms);
+    
+    /**
+     * @brief Get incomplete-frame timeout
+     * @return Timeout in milliseconds
+     */
+    uint32_t GetFrameTimeout() const;
+    
+    /**
+     * @brief Check the frame timeout (called periodically by XGrabber)
+     */
+    void Poll();
+    
+    /**
+     * @brief Get rows that never arrived for a delivered frame
+     * @param image Frame passed to OnFrameReady
+     * @param mask Optional bitmask output, bit set = row missing
+     * @param maskBytes Size of mask in bytes ((GetLines() + 7) / 8)
+     * @return Number of missing rows
+     */
+    uint32_t GetMissingLines(const XImage* image, uint8_t* mask, uint32_t maskBytes) const;
+    
+    /**
+     * @brief Get the acquisition time of every row of a delivered frame
+     * @param image Frame passed to OnFrameReady
+     * @param times Output, one entry per row
+     * @param count Entries times holds (GetLines())
+     * @return Rows written
+     * 
+     * @note A row's time is that of the line (or first segment) that
+     *       filled it; binned rows take their first line, resampled rows
+     *       the line that completed them. Missing rows read zero.
+     */
+    uint32_t GetLineTimes(const XImage* image, LineTime* times, uint32_t count) const;
+    
+    /**
+     * @brief Get the time of a delivered frame
+     * @param image Frame passed to OnFrameReady
+     * @param time Output, time of the first row that has one
+     * @return true if any row of the frame carried a time
+     */
+    bool GetFrameTime(const XImage* image, LineTime& time) const;
+    
+    /**
+     * @brief Build reduced levels of every frame while it is assembled
+     * @param levels Levels after the frame, 1 = 2x, 2 = 4x, 3 = 8x (0 = off)
+     * @return true on success, false if running or levels is above 3
+     * 
+     * @note Each level holds the minimum, maximum and mean of 2x2 blocks
+     *       of the level before, so one pass over the rows serves display
+     *       decimation, previews and tiled export alike. Pairs of rows are
+     *       reduced as soon as both have arrived; rows behind a hole, and
+     *       frames changed after assembly (temporal averaging), are reduced
+     *       just before delivery. The levels add about one frame of memory
+     *       per pool buffer. Pooled frames only: not with a stride or burst.
+     */
+    bool SetPyramid(uint32_t levels);
+    
+    /**
+     * @brief Get reduced levels per frame
+     * @return Levels, 0 if off
+     */
+    uint32_t GetPyramid() const;
+    
+    /**
+     * @brief Get a reduced level of a delivered frame
+     * @param image Frame passed to OnFrameReady
+     * @param level 1 (2x) .. GetPyramid() (e.g. 3 = 8x)
+     * @param stat Reduced image wanted
+     * @return Level image, ceil(width / 2^level) by ceil(height / 2^level)
+     *         pixels of the frame's depth; nullptr if the frame has no
+     *         levels or level is out of range
+     * 
+     * @note Valid while the frame is held, i.e. until Release() (or the
+     *       end of OnFrameReady without a pool). Odd edge blocks repeat
+     *       their last row or column; the means equal the levels of
+     *       XFile::SetTiling().
+     */
+    const XImage* GetPyramid(const XImage* image, uint32_t level, PyramidStat stat) const;
+    
+    /**
+     * @brief Set number of equal segments (DM modules) each line arrives in
+     * @param count Segments per line (1-64, 1 = whole lines)
+     * @return true on success, false if running or count is invalid
+     */
+    bool SetSegments(uint32_t count);
+    
+    /**
+     * @brief Get number of segments per line
+     * @return Segments per line
+     */
+    uint32_t GetSegments() const;
+    
+    /**
+     * @brief Add one module segment of a line
+     * @param data Segment data pointer
+     * @param len Segment length (line length / segment count)
+     * @param lineId Line identifier
+     * @param segment Segment index (module number)
+     * 
+     * @note The row counts as received once all of its segments arrived;
+     *       may be called from several receive threads, see SetProducerThreads()
+     */
+    void AddSegment(const uint8_t* data, uint32_t len, uint32_t lineId, uint32_t segment);
+    
+    /**
+     * @brief Add one module segment of a line with its acquisition time
+     * @param data Segment data pointer
+     * @param len Segment length (line length / segment count)
+     * @param lineId Line identifier
+     * @param segment Segment index (module number)
+     * @param time Segment time; the row keeps that of its first segment
+     */
+    void AddSegment(const uint8_t* data, uint32_t len, uint32_t lineId, uint32_t segment,
+                    const LineTime& time);
+    
+    /**
+     * @brief Split dual-energy lines into a high and a low plane
+     * @param enable true to enable
+     * @return true on success, false if running
+     * 
+     * @note Frames are then GetLines() x 2 rows: the high-energy plane,
+     *       followed by the low-energy plane. Lines arrive through
+     *       AddEnergyLine(); the high and low line of a row share a lineId
+     *       and the row is complete once both arrived. Requires one segment
+     *       per line, no stride, strips or unpacking.
+     */
+    bool SetDualEnergy(bool enable);
+    
+    /**
+     * @brief Check if dual-energy planes are enabled
+     * @return true if enabled
+     */
+    bool GetDualEnergy() const;
+    
+    /**
+     * @brief Add one energy line of a dual-energy row
+     * @param data Line data pointer
+     * @param len Line length (one energy line)
+     * @param lineId Line identifier, shared by the row's high and low line
+     * @param energyFlag XLibPacketHeader::energyFlag (0 = low, 1 = high)
+     */
+    void AddEnergyLine(const uint8_t* data, uint32_t len, uint32_t lineId, uint8_t energyFlag);
+    
+    /**
+     * @brief Add one energy line of a dual-energy row with its acquisition time
+     * @param data Line data pointer
+     * @param len Line length (one energy line)
+     * @param lineId Line identifier, shared by the row's high and low line
+     * @param energyFlag XLibPacketHeader::energyFlag (0 = low, 1 = high)
+     * @param time Line time; the row keeps that of its first line
+     */
+    void AddEnergyLine(const uint8_t* data, uint32_t len, uint32_t lineId, uint8_t energyFlag,
+                       const LineTime& time);
+    
+    /**
+     * @brief Get the energy planes of a delivered dual-energy frame
+     * @param image Frame passed to OnFrameReady
+     * @param high Output high-energy plane (GetLines() rows)
+     * @param low Output low-energy plane (GetLines() rows)
+     * @return true on success, false if not a 9-16 bit dual-energy frame
+     * 
+     * @note The planes go straight to hubx_dualenergy_fuse()
+     */
+    bool GetEnergyPlanes(const XImage* image, const unsigned short** high,
+                         const unsigned short** low) const;
+    
+    /**
+     * @brief Register the energy planes to each other along the scan
+     * @param lowOffset Lines the low-energy row trails the high-energy
+     *                  row by: the low line lineId + lowOffset sees what
+     *                  the high line lineId saw. Negative if the high row
+     *                  trails; fractional values interpolate (0 = off).
+     * @return true on success, false if running or |lowOffset| > 64
+     * 
+     * @note The trailing plane is delayed as its lines arrive: row n is
+     *       interpolated between its lines n + k and n + k + 1 (offset
+     *       k + f, weights 1 - f and f) from a ring of k + 2 lines plus
+     *       the reorder window, so there is no pass over the frame and
+     *       the fused image has no color fringes. Rows whose trailing
+     *       line comes after the run ends stay missing. Requires 8, 16
+     *       or 32-bit pixels and a reorder window of at least k + 2
+     *       lines, since a frame's last rows complete after the next
+     *       frame's first lines arrived.
+     */
+    bool SetEnergyAlignment(double lowOffset);
+    
+    /**
+     * @brief Get the energy plane offset, 0 when alignment is off
+     */
+    double GetEnergyAlignment() const;
+    
+    /**
+     * @brief Report rows to IXImgSink::OnLinesReady every few lines
+     * @param lines Rows per strip (0 = off, 1 = every line)
+     * @return true on success, false if running
+     * 
+     * @note A strip is reported once all of its rows, and every row before
+     *       it, have arrived. When the frame closes, held-back rows are
+     *       reported before OnFrameReady; rows that never arrived read zero.
+     */
+    bool SetStripLines(uint32_t lines);
+    
+    /**
+     * @brief Get rows per OnLinesReady strip
+     * @return Rows per strip, 0 if off
+     */
+    uint32_t GetStripLines() const;
+    
+    /**
+     * @brief Emit overlapping frames that start every few lines
+     * @param lines Lines between frame starts (0 = disjoint frames); the
+     *              overlap between neighbours is GetLines() - lines
+     * @return true on success, false if running
+     * 
+     * @note Frames are views into one circular line buffer, so the overlap
+     *       rows are not copied per frame. Each view is only valid during
+     *       OnFrameReady; the pool size is ignored and Release() is not
+     *       needed. Requires one segment per line; strips are not reported.
+     */
+    bool SetStride(uint32_t lines);
+    
+    /**
+     * @brief Get lines between frame starts
+     * @return Stride in lines, 0 if frames are disjoint
+     */
+    uint32_t GetStride() const;
+    
+    /**
+     * @brief Select how frame buffers are cleared between frames
+     * @param policy Clear policy
+     * 
+     * @note CLEAR_MISSING and CLEAR_FULL deliver identical frames; missing
+     *       rows read zero either way. Use GetMissingLines() with CLEAR_NONE.
+     */
+    void SetClearPolicy(ClearPolicy policy);
+    
+    /**
+     * @brief Get current clear policy
+     * @return Clear policy
+     */
+    ClearPolicy GetClearPolicy() const;
+    
+    /**
+     * @brief Declare how many threads feed lines while running
+     * @param count Producer threads (1 = lock-free line path)
+     * @return true on success, false if running or count is 0
+     * 
+     * @note With one producer, AddLine/AddSegment/GetLineBuffer/CommitLine,
+     *       Poll and Stop must all come from that thread (XGrabber does
+     *       this). Set count > 1 when several threads add lines at once.
+     */
+    bool SetProducerThreads(uint32_t count);
+    
+    /**
+     * @brief Get declared producer thread count
+     * @return Producer threads
+     */
+    uint32_t GetProducerThreads() const;
+    
+    /**
+     * @brief Allocate pool buffers through XFactory::AllocateEx()
+     * @param factory Factory to allocate from (nullptr = plain heap)
+     * @param options NUMA node, huge pages and pre-fault for the buffers
+     * @return true on success, false if running
+     * 
+     * @note Typically the NIC's NUMA node with PAGE_2MB and prefault, so
+     *       buffers are local and faulted in before acquisition starts.
+     *       The factory must outlive Stop(), and a burst kept after it.
+     */
+    bool SetAllocator(XFactory* factory,
+                      const XFactory::AllocOptions& options = XFactory::AllocOptions());
+    
+    /**
+     * @brief Keep the frame pool in the slots of a shared-memory bus
+     * @param bus Bus created by XFrameBus::Create() (nullptr = off, not owned)
+     * @return true on success, false if running
+     * 
+     * @note Lines are assembled straight into the slots and every frame is
+     *       published before OnFrameReady, so other processes read it
+     *       without a copy. The pool size becomes the slot count, the slots
+     *       must hold a whole frame, and stride is not supported. Free
+     *       buffers are reused oldest first; the sink still returns frames
+     *       with Release(). The bus must outlive Stop().
+     */
+    bool SetFrameBus(XFrameBus* bus);
+    
+    /**
+     * @brief Append a filter that processes every line as it is placed
+     * @param filter Filter (not owned, must outlive Stop())
+     * @return true on success, false if running or filter is null
+     * 
+     * @note The first filter replaces the copy into the frame row, later
+     *       ones run in place on the row while it is still in cache.
+     *       Segmented lines are filtered in place once the row is complete.
+     */
+    bool AddLineFilter(IXLineFilter* filter);
+    
+    /**
+     * @brief Remove all line filters
+     * @return true on success, false if running
+     */
+    bool ClearLineFilters();
+    
+    /**
+     * @brief Unpack bit-packed lines as they are placed in the frame
+     * @param mode Working format (UNPACK_NONE = store lines as received)
+     * @return true on success, false if running
+     * 
+     * @note Start() then takes the wire depth (17-24 bits, packed with no
+     *       padding between pixels) and frames are 32 or 16 bits deep.
+     *       Lines and CommitLine() lengths are the packed size; the buffer
+     *       from GetLineBuffer() is a staging line, so with several
+     *       producers use AddLine(). Requires one segment per line.
+     */
+    bool SetUnpack(UnpackMode mode);
+    
+    /**
+     * @brief Get working format for packed lines
+     * @return Unpack mode
+     */
+    UnpackMode GetUnpack() const;
+    
+    /**
+     * @brief Keep only a column range of every line
+     * @param firstColumn First detector column kept
+     * @param columns Columns kept (0 = whole line, ROI off)
+     * @param decimation Keep every n-th column of the range (1 = all)
+     * @return true on success, false if running or decimation is zero
+     * 
+     * @note Start() still takes the detector width and lines arrive at
+     *       full length, but frames are only columns wide: columns are
+     *       gathered as the line is placed, so later stages never see the
+     *       rest. The range is checked against the width in Start(). The
+     *       buffer from GetLineBuffer() is then a staging line. Requires
+     *       one segment per line and no dual-energy mode.
+     */
+    bool SetROI(uint32_t firstColumn, uint32_t columns, uint32_t decimation = 1);
+    
+    /**
+     * @brief Get column range kept from every line
+     * @param firstColumn Receives first column (may be nullptr)
+     * @param columns Receives columns kept, 0 = ROI off (may be nullptr)
+     * @param decimation Receives column step (may be nullptr)
+     */
+    void GetROI(uint32_t* firstColumn, uint32_t* columns, uint32_t* decimation) const;
+    
+    /**
+     * @brief Bin lines in software as they are placed
+     * @param columns Adjacent columns combined into one pixel (1, 2 or 4)
+     * @param lines Consecutive lines combined into one row (1-4096)
+     * @param mode Sum or average
+     * @return true on success, false if running or a factor is invalid
+     * 
+     * @note Lines are added into a 32-bit accumulator row and only the
+     *       reduced row is placed, so GetLines() counts binned rows and
+     *       frames are width / columns wide (after the ROI, when one is
+     *       set). Group k is lines [k*lines, (k+1)*lines) after the first
+     *       line of the run; a group cut short by lost lines is placed as
+     *       soon as the next one starts (averaged over the lines it has),
+     *       and its stragglers count as late. The buffer from
+     *       GetLineBuffer() is then a staging line. Requires 8, 16 or 32-bit
+     *       pixels, one segment per line and no dual-energy mode.
+     *       SetBinning(1, 1) turns binning off.
+     */
+    bool SetBinning(uint32_t columns, uint32_t lines, BinMode mode = BIN_AVERAGE);
+    
+    /**
+     * @brief Get software binning factors
+     * @param columns Receives column factor (may be nullptr)
+     * @param lines Receives line factor (may be nullptr)
+     * @param mode Receives reduction mode (may be nullptr)
+     */
+    void GetBinning(uint32_t* columns, uint32_t* lines, BinMode* mode) const;
+    
+    /**
+     * @brief Resample lines onto a uniform belt-travel grid
+     * @param pitch Belt travel per frame row, in encoder units (0 = off)
+     * @param encoderRate Initial belt speed, encoder units per second
+     * @return true on success, false if running or a value is negative
+     * 
+     * @note Each line moves the belt by the encoder rate times the time
+     *       since the previous line's timestamp, and row k is interpolated
+     *       between the two lines around travel k * pitch, as the lines
+     *       arrive. Only two lines are kept, so there is no second pass
+     *       over the frame. Rows are numbered from the first line of the
+     *       run and replace lineIds for placement and line binning; lines
+     *       with an older timestamp than the previous one count as late.
+     *       While the belt stands still no rows are produced. Requires 8,
+     *       16 or 32-bit pixels, one segment per line and no dual-energy
+     *       mode; the buffer from GetLineBuffer() is then a staging line.
+     */
+    bool SetScanResample(double pitch, double encoderRate);
+    
+    /**
+     * @brief Get belt travel per row, 0 when resampling is off
+     */
+    double GetScanResample() const;
+    
+    /**
+     * @brief Update the belt speed used for lines from now on
+     * @param rate Encoder units per second; negative values are ignored
+     * @note Safe from any thread, e.g. on every encoder reading
+     */
+    void SetEncoderRate(double rate);
+    
+    /**
+     * @brief Get the current belt speed, encoder units per second
+     */
+    double GetEncoderRate() const;
+    
+    /**
+     * @brief Average completed frames over time before delivery
+     * @param mode Recursive, block or off
+     * @param frames K, frames averaged (2-32768)
+     * @param everyFrame true to deliver every frame, false every K-th only
+     * @return true on success, false if running or frames is invalid
+     * 
+     * @note The average is written into the frame's own pool buffer, so
+     *       memory is one accumulator, not K frames. Frames that are not
+     *       delivered go straight back to the pool. In block mode with
+     *       everyFrame, frames carry the mean of their block so far.
+     *       Requires 9-16 bit pixels and no stride; missing rows are
+     *       averaged as they were cleared.
+     */
+    bool SetTemporalAverage(TemporalMode mode, uint32_t frames, bool everyFrame = false);
+    
+    /**
+     * @brief Get temporal averaging settings
+     * @param mode Receives mode (may be nullptr)
+     * @param frames Receives K (may be nullptr)
+     * @param everyFrame Receives delivery mode (may be nullptr)
+     */
+    void GetTemporalAverage(TemporalMode* mode, uint32_t* frames, bool* everyFrame) const;
+    
+    /**
+     * @brief Restart the average with the next completed frame
+     * @note Safe from any thread, e.g. when the scene or exposure changes
+     */
+    void ResetTemporalAverage();
+    
+    /**
+     * @brief Tag frames that show only empty belt
+     * @param threshold Pixels below this value count as content (0 = off)
+     * @param minPixels Content pixels a frame needs to be non-empty (1 or more)
+     * @param step Pixels sampled every step rows and columns (1-256)
+     * @param skip true to drop empty frames instead of delivering them
+     * @return true on success, false if running or a value is invalid
+     * 
+     * @note Sampling stops at the minPixels-th content pixel, so frames with
+     *       an object cost little and empty ones 1/step^2 of a pass. Frames
+     *       are tagged as delivered (after temporal averaging); read the tag
+     *       with IsEmpty(). Skipped frames go straight back to the pool.
+     */
+    bool SetEmptyDetect(uint32_t threshold, uint32_t minPixels, uint32_t step = 8, bool skip = false);
+    
+    /**
+     * @brief Get empty-frame detection settings
+     * @param threshold Receives threshold, 0 if off (may be nullptr)
+     * @param minPixels Receives content pixel count (may be nullptr)
+     * @param step Receives sampling step (may be nullptr)
+     * @param skip Receives drop mode (may be nullptr)
+     */
+    void GetEmptyDetect(uint32_t* threshold, uint32_t* minPixels, uint32_t* step, bool* skip) const;
+    
+    /**
+     * @brief Check whether a delivered frame was tagged empty
+     * @param image Frame passed to OnFrameReady
+     * @return true if detection is on and the frame held too little content
+     */
+    bool IsEmpty(const XImage* image) const;
+    
+    /**
+     * @brief Frame objects instead of fixed line counts
+     * @param threshold Pixels below this value count as content (0 = off)
+     * @param minPixels Content pixels that make a line part of an object (1 or more)
+     * @param preLines Lines kept ahead of the first object line
+     * @param postLines Content-free lines that end an object
+     * @return true on success, false if running or a value is invalid
+     * 
+     * @note A frame opens with the first object line, preceded by up to
+     *       preLines belt lines, and closes after postLines lines without
+     *       content; a gap shorter than that keeps the object in one frame.
+     *       Frames are variable height, at most SetLines(); a longer object
+     *       continues in the next pool buffer, with event 116 (data = rows)
+     *       on the frame it fills. Lines are framed in arrival order and
+     *       lines outside objects are never delivered. Needs whole lines,
+     *       no dual-energy, stride, strips or temporal averaging, and
+     *       preLines + postLines below SetLines().
+     */
+    bool SetObjectFraming(uint32_t threshold, uint32_t minPixels, uint32_t preLines, uint32_t postLines);
+    
+    /**
+     * @brief Get object framing settings
+     * @param threshold Receives threshold, 0 if off (may be nullptr)
+     * @param minPixels Receives content pixels per object line (may be nullptr)
+     * @param preLines Receives leading margin (may be nullptr)
+     * @param postLines Receives trailing margin (may be nullptr)
+     */
+    void GetObjectFraming(uint32_t* threshold, uint32_t* minPixels,
+                          uint32_t* preLines, uint32_t* postLines) const;
+    
+    /**
+     * @brief Frame on external frame triggers instead of line counts
+     * @param enable true = frames open only at Trigger()
+     * @return true on success, false if running
+     * 
+     * @note For XControl::XFRAME_TRIGGER. Each frame starts at a triggered
+     *       line and holds the SetLines() lines from it; XGrabber triggers
+     *       on lines whose header carries the frame trigger marker. Lines
+     *       outside a triggered frame are dropped on entry, before any
+     *       copy, filter or frame timeout sees them, so an idle belt costs
+     *       a compare per line. A trigger before the frame is full emits it
+     *       short (event 111). Needs no stride, object framing, binning or
+     *       resampling.
+     */
+    bool SetFrameTrigger(bool enable);
+    
+    /**
+     * @brief Check if frames open on triggers
+     * @return true if enabled
+     */
+    bool GetFrameTrigger() const;
+    
+    /**
+     * @brief Open a frame at a line (frame trigger mode)
+     * @param lineId First line of the frame
+     * 
+     * @note Repeated for the same line (one per module or fragment) it
+     *       opens the frame once. Ignored unless SetFrameTrigger(true).
+     */
+    void Trigger(uint32_t lineId);
+    
+    /**
+     * @brief Get lines dropped outside triggered frames since Start()
+     * @return Line count (segments and energy lines count singly)
+     */
+    uint64_t GetUntriggeredLines() const;
+    
+    /**
+     * @brief Set the detector ID written into every frame's XImage::_info
+     * @param id Application-defined ID, e.g. the detector's index
+     * 
+     * @note The rest of XFrameInfo (sequence, first line, missing rows,
+     *       first row time, flags) is filled from the assembly itself.
+     */
+    void SetDetectorId(uint32_t id);
+    
+    /**
+     * @brief Get the detector ID written into frames
+     * @return Detector ID, 0 by default
+     */
+    uint32_t GetDetectorId() const;
+    
 private:
     class Impl;
     Impl* m_impl;
     
+    // XGrabber counts the frames of a Grab(frames) sequence
+    friend class XGrabber;
+    void setFrameListener(Internal::FrameListener* listener, uint32_t frameLimit);
+    
     // Non-copyable
     XFrame(const XFrame&) = delete;
     XFrame& operator=(const XFrame&) = delete;
@@ -0,0 +1,188 @@
+// ============================================================================
+
+/**
+ * @file XFrameBus.h
+ * @brief XFrameBus class - Shared-memory frame ring for local processes
+ * @version 2.1.0
+ */
+
+#ifndef XFRAMEBUS_H
+#define XFRAMEBUS_H
+
+#include <cstdint>
+#include <string>
+
+namespace HX {
+
+class IXImgSink;
+class XImage;
+
+/**
+ * @class XFrameBus
+ * @brief Hands frames to other processes on the host without copying them
+ *
+ * The acquisition process creates a named shared-memory segment of frame
+ * slots and attaches it with XFrame::SetFrameBus(): the XFrame pool then
+ * lives in the slots, lines are assembled straight into them and every
+ * delivered frame is published with a sequence number. Other processes
+ * Subscribe() to the same name and read the slots in place, so a frame
+ * is written once however many processes consume it.
+ *
+ * The publisher never waits for subscribers. A slot reused for a new
+ * frame has its sequence cleared first; a reader checks IsValid() after
+ * using a frame to know it was not overwritten meanwhile. Every
+ * subscriber has its own cursor in the segment: Next() skips the frames
+ * it was lapped on and counts them, and the publisher raises event 117
+ * (data = subscriber index) when a slot is reused before a subscriber
+ * read it.
+ *
+ * Segment layout (native byte order, for processes on one host):
+ *
+ *   BusHeader          magic "HXFRBUS\0", geometry, latest sequence
+ *   Subscriber[32]     owner pid, cursor, frames lost
+ *   Publication[2N]    sequence -> slot, written as frames are published
+ *   slot 0 .. N-1      64-byte SlotHeader + frame pixels, page aligned
+ */
+class XFrameBus {
+public:
+    /// Subscribers one segment can hold
+    static const uint32_t MAX_SUBSCRIBERS = 32;
+
+    /**
+     * @brief One published frame, read in place from the segment
+     */
+    struct Frame {
+        const uint8_t* data;        ///< First pixel; rows are width * bytes per pixel
+        uint32_t width;
+        uint32_t height;            ///< Rows published (object frames vary)
+        uint8_t  pixelDepth;
+        uint64_t sequence;          ///< 1 for the first frame published
+        uint64_t timeUs;            ///< Wall clock at publication
+        uint32_t missingLines;      ///< Rows that never arrived, see XFrame::GetMissingLines()
+        bool     empty;             ///< Tagged empty by XFrame::SetEmptyDetect()
+    };
+
+    /**
+     * @brief State of one subscriber, seen from the publisher
+     */
+    struct SubscriberInfo {
+        uint32_t index;             ///< Slot in the subscriber table, event 117 data
+        uint32_t pid;               ///< Owning process
+        uint64_t cursor;            ///< Last sequence it took
+        uint64_t lag;               ///< Frames published since then
+        uint64_t lost;              ///< Frames reused before it read them
+    };
+
+    XFrameBus();
+    ~XFrameBus();
+
+    /**
+     * @brief Set error and event callback sink
+     * @param sink_ Callback handler
+     */
+    void SetSink(IXImgSink* sink_);
+
+    /**
+     * @brief Create the segment as publisher
+     * @param name Segment name, the same for every process (no slashes)
+     * @param width Pixels per row
+     * @param height Rows per slot, the XFrame lines per frame (twice that
+     *               with dual-energy)
+     * @param pixelDepth Bits per pixel
+     * @param slots Frame slots (2-1024), also the XFrame pool size
+     * @return true on success
+     *
+     * @note An existing segment of the same name is replaced; readers of
+     *       the old one see it closed and must subscribe again
+     */
+    bool Create(const std::string& name, uint32_t width, uint32_t height,
+                uint8_t pixelDepth, uint32_t slots);
+
+    /**
+     * @brief Map an existing segment as subscriber
+     * @param name Segment name given to Create()
+     * @return false if there is no such segment or all subscriber slots are taken
+     *
+     * @note The cursor starts at the latest frame; Next() returns the one after
+     */
+    bool Subscribe(const std::string& name);
+
+    /**
+     * @brief Unmap the segment; a publisher marks it closed first
+     */
+    void Close();
+
+    /**
+     * @brief Check if a segment is mapped
+     */
+    bool IsOpen() const;
+
+    /**
+     * @brief Get number of frame slots
+     */
+    uint32_t GetSlots() const;
+
+    /**
+     * @brief Wait for the next frame (subscriber)
+     * @param frame Receives the frame
+     * @param timeoutMs Longest wait in milliseconds (0 = poll)
+     * @return false on timeout, or when the publisher closed the segment
+     *
+     * @note The data stays in place until the publisher reuses its slot,
+     *       slots - 1 frames later at the earliest
+     */
+    bool Next(Frame& frame, uint32_t timeoutMs);
+
+    /**
+     * @brief Check that a frame was not overwritten while it was read
+     * @param frame Frame returned by Next()
+     */
+    bool IsValid(const Frame& frame) const;
+
+    /**
+     * @brief Check if the publisher closed the segment (subscriber)
+     */
+    bool IsClosed() const;
+
+    /**
+     * @brief Get frames this subscriber missed since Subscribe()
+     */
+    uint64_t GetLost() const;
+
+    /**
+     * @brief List active subscribers (publisher)
+     * @param info Receives up to max entries (may be nullptr to count)
+     * @param max Capacity of info
+     * @return Active subscribers
+     */
+    uint32_t GetSubscribers(SubscriberInfo* info, uint32_t max) const;
+
+    /**
+     * @brief Copy a frame into the next slot and publish it (publisher)
+     * @param image Frame no larger than the slot geometry
+     * @return true on success
+     *
+     * @note For frames that do not come from an attached XFrame, such as
+     *       corrected output; do not mix with XFrame::SetFrameBus()
+     */
+    bool Publish(const XImage* image);
+
+    // Used by XFrame for a pool that lives in the slots
+    uint8_t* GetSlotData(uint32_t slot) const;
+    uint64_t GetSlotBytes() const;
+    void RetireSlot(uint32_t slot);
+    void PublishSlot(uint32_t slot, uint32_t width, uint32_t height, uint8_t pixelDepth,
+                     uint32_t missingLines, bool empty);
+
+private:
+    class Impl;
+    Impl* m_impl;
+
+    // Non-copyable
+    XFrameBus(const XFrameBus&) = delete;
+    XFrameBus& operator=(const XFrameBus&) = delete;
+};
+
+} // namespace HX
+
+#endif // XFRAMEBUS_H
@@ -0,0 +1,162 @@
+// ============================================================================
+
+/**
+ * @file XFrameDistributor.h
+ * @brief XFrameDistributor class - Shards frames to processing nodes over TCP
+ * @version 2.1.0
+ */
+
+#ifndef XFRAMEDISTRIBUTOR_H
+#define XFRAMEDISTRIBUTOR_H
+
+#include <cstdint>
+
+namespace HX {
+
+class IXImgSink;
+class XImage;
+
+/**
+ * @class XFrameDistributor
+ * @brief Spreads full-resolution frames across worker nodes
+ *
+ * Workers connect over TCP and grant credits, one per frame they are
+ * ready to take. Publish() copies the frame once and hands it to one
+ * worker: the next one round-robin that has credit, or the worker chosen
+ * by detector index. Each worker has a sender thread that encodes its
+ * frames and sends them while it holds credit, so a slow node only loses
+ * its own frames. Frames no worker can queue are dropped at once;
+ * acquisition never waits on the network.
+ *
+ * Worker to distributor, any time after connecting (8 bytes):
+ *
+ *   char[4]  magic "HXDC"        uint32 credits granted
+ *
+ * Distributor to worker, a 48-byte little-endian header then the payload:
+ *
+ *   char[4]  magic "HXDF"        uint16 version (1)    uint16 encoding
+ *   uint32   width               uint32 height
+ *   uint32   pixel depth         uint32 detector
+ *   uint64   sequence            uint64 wall clock, microseconds
+ *   uint32   payload bytes       uint32 reserved
+ *
+ * Sequences count every Publish() from 1, so a worker sees the frames it
+ * was not sent as gaps. XDIST_RAW payloads are rows of width * bytes per
+ * pixel; XDIST_DELTA payloads are the rows delta-packed as described in
+ * XPreviewServer.h, in the pixel's own container size.
+ */
+class XFrameDistributor {
+public:
+    /**
+     * @enum XEncoding
+     * @brief Payload encodings
+     */
+    enum XEncoding {
+        XDIST_RAW = 0,      ///< Pixels as is (default)
+        XDIST_DELTA         ///< Lossless delta packing, encoded by the sender thread
+    };
+
+    /**
+     * @enum XSharding
+     * @brief How a frame picks its worker
+     */
+    enum XSharding {
+        XDIST_ROUND_ROBIN = 0,  ///< Next worker with credit, then with queue room (default)
+        XDIST_BY_DETECTOR       ///< Worker detector % workers, in connection order
+    };
+
+    /**
+     * @brief Distributor counters since Start()
+     */
+    struct Statistics {
+        uint64_t framesPublished;   ///< Publish() calls
+        uint64_t framesSent;        ///< Frames handed to a worker's socket
+        uint64_t framesDropped;     ///< No worker could queue them, or lost with a worker
+        uint64_t bytesSent;         ///< Header and payload bytes, all workers
+        uint32_t workers;           ///< Workers connected now
+        uint32_t credits;           ///< Credit held by those workers
+    };
+
+    XFrameDistributor();
+    ~XFrameDistributor();
+
+    /**
+     * @brief Set error callback sink
+     * @param sink_ Callback handler
+     */
+    void SetSink(IXImgSink* sink_);
+
+    /**
+     * @brief Select the payload encoding
+     * @return true on success, false if running
+     */
+    bool SetEncoding(XEncoding encoding);
+
+    /**
+     * @brief Select how frames are spread
+     * @return true on success, false if running
+     */
+    bool SetSharding(XSharding sharding);
+
+    /**
+     * @brief Bound the frames held per worker
+     * @param frames Frames queued for one worker beyond its credit (1-64, default 4)
+     * @return true on success, false if running or out of range
+     *
+     * @note The queue covers the round trip of a credit; frames copied
+     *       into it are the distributor's whole memory cost
+     */
+    bool SetQueueDepth(uint32_t frames);
+
+    /**
+     * @brief Listen for workers
+     * @param port TCP port (0 = any free port, see GetPort())
+     * @param maxWorkers Connections served at once; more are closed
+     * @return true on success
+     */
+    bool Start(uint16_t port, uint32_t maxWorkers = 8);
+
+    /**
+     * @brief Disconnect all workers and stop the threads
+     */
+    void Stop();
+
+    /**
+     * @brief Check if the distributor is running
+     */
+    bool IsRunning() const;
+
+    /**
+     * @brief Get the port being listened on
+     * @return Port, 0 if not running
+     */
+    uint16_t GetPort() const;
+
+    /**
+     * @brief Hand a frame to a worker
+     * @param image Frame in any depth up to 32 bits
+     * @param detector Source detector, for XDIST_BY_DETECTOR and the header
+     * @return true if a worker queued it
+     *
+     * @note The pixels are copied; the image can be reused on return
+     */
+    bool Publish(const XImage* image, uint32_t detector = 0);
+
+    /**
+     * @brief Get distributor counters
+     * @return Statistics since Start()
+     */
+    Statistics GetStatistics() const;
+
+private:
+    class Impl;
+    Impl* m_impl;
+
+    // Non-copyable
+    XFrameDistributor(const XFrameDistributor&) = delete;
+    XFrameDistributor& operator=(const XFrameDistributor&) = delete;
+};
+
+} // namespace HX
+
+#endif // XFRAMEDISTRIBUTOR_H
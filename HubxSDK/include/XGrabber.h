@@ -12,13 +12,16 @@
 #define XGRABBER_H
 
 #include <cstdint>
+#include <string>
 
 namespace HX {
 
 class XDetector;
 class XControl;
 class XFrame;
+class XMultiFrame;
 class XFactory;
+class XFlightRecorder;
 class IXImgSink;
 
 /**
@@ -27,6 +30,60 @@ class IXImgSink;
  */
 class XGrabber {
 public:
+    /**
+     * @struct Statistics
+     * @brief Live receive counters
+     */
+    struct Statistics {
+        uint64_t packetsReceived;   ///< Packets taken off the socket
+        uint64_t packetsLost;       ///< packetId gaps not filled by late packets
+        uint64_t packetsDuplicate;  ///< Packets whose packetId was already seen
+        uint64_t packetsReordered;  ///< Packets that arrived after a higher packetId
+        uint64_t packetsLate;       ///< Packets 64 or more ids behind the highest, left counted as lost
+        uint64_t sequenceGaps;      ///< Number of packetId discontinuities
+        uint64_t linesReceived;     ///< Lines passed to XFrame
+        uint64_t ringOverflows;     ///< Packets dropped because the receive ring was full
+        uint64_t packetsCorrupt;    ///< Packets dropped by SetPacketCheck() (bad CRC16 trailer)
+        uint64_t patternChecked;    ///< Line segments compared by SetPatternCheck()
+        uint64_t patternMismatched; ///< Compared segments that differed from the pattern
+        uint32_t ringHighWater;     ///< Highest receive ring occupancy
+        uint32_t receiveBatch;      ///< Current RECEIVE_ADAPTIVE batch target (0 in other modes)
+    };
+    
+    /**
+     * @struct PacketLayout
+     * @brief How lines are packed into image packets (header mode)
+     */
+    struct PacketLayout {
+        uint32_t linesPerPacket;    ///< Header + line records per packet (1 = one line per packet, max 256)
+        uint32_t fragmentBytes;     ///< Payload bytes per packet of a split line (0 = lines are not split)
+        
+        PacketLayout() : linesPerPacket(1), fragmentBytes(0) {}
+    };
+    
+    /**
+     * @brief How receive threads wait for packets
+     */
+    enum ReceiveMode {
+        RECEIVE_BLOCKING = 0,   ///< Sleep in the socket wait up to SetTimeout()
+        RECEIVE_BUSY_POLL,      ///< Spin on non-blocking receives (dedicated cores)
+        RECEIVE_ADAPTIVE        ///< Batch under load, spin only while packets arrive
+    };
+    
+    /**
+     * @struct NetworkConfig
+     * @brief Image socket tuning
+     */
+    struct NetworkConfig {
+        uint32_t recvBufferSize;    ///< SO_RCVBUF in bytes (0 = system default)
+        uint32_t busyPollUs;        ///< Busy-poll time in microseconds (0 = off)
+        bool timestamping;          ///< NIC receive timestamps on/off (XFrame::GetLineTimes)
+        uint8_t dscp;               ///< DSCP code point (0-63)
+        
+        NetworkConfig()
+            : recvBufferSize(0), busyPollUs(0), timestamping(false), dscp(0) {}
+    };
+    
     XGrabber();
     ~XGrabber();
     
@@ -35,9 +92,66 @@ public:
      * @param dec Detector configuration
      * @param control Control interface
      * @return true on success
+     *
+     * @note control must stay alive until Close(). If it reconnects (see
+     *       XControl::SetAutoReconnect()) a running acquisition is stopped,
+     *       the image sockets are reopened and Grab() restarts on the same
+     *       frame; event 114 reports the gap in ms.
      */
     bool Open(XDetector& dec, XControl& control);
     
+    /**
+     * @brief Open connection to detector with socket tuning
+     * @param dec Detector configuration
+     * @param control Control interface
+     * @param config Requested settings; on return holds the effective values
+     *               after the operating system has clamped them
+     * @return true on success
+     */
+    bool Open(XDetector& dec, XControl& control, NetworkConfig& config);
+    
+    /**
+     * @brief Open a recorded capture instead of the detector
+     * @param dec Detector the capture was taken from: pixel count and depth
+     *            size the frames, the image port selects the pcap packets
+     *            (0 = every UDP packet)
+     * @param file pcap capture of the image port, or an XStreamFile such as
+     *             one written by XFlightRecorder::Trigger()
+     * @return true on success
+     *
+     * @note Grab() feeds the recorded packets through the same receive ring,
+     *       packet accounting and frame assembly as live ones; no network or
+     *       XControl is involved. Each Grab() starts from the beginning of
+     *       the capture, and acquisition ends by itself at its end with
+     *       event 115 (data = packets replayed). Stream files hold line
+     *       payloads only: replay them with SetHeader(false). A detector
+     *       without a pixel count takes the stream file's.
+     */
+    bool OpenReplay(XDetector& dec, const std::string& file);
+    
+    /**
+     * @brief Set replay pacing
+     * @param speed 1.0 = original timing, 2.0 = twice real time, and so on;
+     *              0 = as fast as the assembly takes packets
+     * @return true on success, false if grabbing or speed is negative
+     *
+     * @note A replay never drops packets: when the receive ring is full the
+     *       replay waits for the assembly, so runs are repeatable
+     */
+    bool SetReplaySpeed(double speed);
+    
+    /**
+     * @brief Get replay pacing
+     * @return Speed factor (0 = unpaced)
+     */
+    double GetReplaySpeed();
+    
+    /**
+     * @brief Get effective socket settings of the open connection
+     * @param config Output settings
+     */
+    void GetNetworkConfig(NetworkConfig& config);
+    
     /**
      * @brief Close connection
      */
@@ -53,15 +167,54 @@ public:
      * @brief Start image acquisition
      * @param frames Number of frames to grab (0 = continuous)
      * @return true on success
+     * @note With frames > 0 the XFrame reports every finished frame back
+     *       and acquisition stops right after the last one: lines past it
+     *       are dropped, no further frame reaches the sink, and event 119
+     *       (data = frames) follows its OnFrameReady(). Frames the XFrame
+     *       finishes without delivering (pool exhausted, shed, averaged,
+     *       empty ones skipped) do not count. Not enforced with
+     *       SetMultiFrame(), whose assembler is shared.
      */
     bool Grab(uint32_t frames);
     
     /**
      * @brief Capture single frame
-     * @return true on success
+     * @return true once the frame was delivered, false if acquisition
+     *         ended before it
+     * @note Blocks until the frame is in, without polling, then stops
      */
     bool Snap();
     
+    /**
+     * @brief Wait for Grab(frames) to finish
+     * @param timeoutMs Maximum wait, 0 = no limit
+     * @return true once the last frame was delivered and acquisition has
+     *         ended, so Grab() may be called again; false on timeout, if
+     *         acquisition ended before the last frame (Stop(), an error, a
+     *         lost link) or if it runs continuously
+     */
+    bool WaitGrab(uint32_t timeoutMs);
+    
+    /**
+     * @brief Allocate and touch the acquisition buffers ahead of Grab()
+     * @return true on success, false if not opened, grabbing or the frame
+     *         could not be prepared
+     * @note Prepares the XFrame for the detector's geometry (see
+     *       XFrame::Prepare()), sizes and zeroes the packet ring and its
+     *       store as Grab() would, and builds the CRC tables when packets
+     *       are checked, so the first frame sees no page faults or lazy
+     *       setup. Call after Open() and the settings, once per format.
+     *       Not for SetMultiFrame(), whose assembler is started by the
+     *       application.
+     */
+    bool Prepare();
+    
+    /**
+     * @brief Get how long the last Prepare() took
+     * @return Microseconds, 0 before the first one
+     */
+    uint32_t GetPrepareTime();
+    
     /**
      * @brief Stop image acquisition
      * @return true on success
@@ -80,6 +233,84 @@ public:
      */
     void SetHeader(bool enable);
     
+    /**
+     * @brief Set how lines are packed into image packets
+     * @param layout Lines per packet or fragment size the detector sends
+     * @return true on success, false if grabbing or the layout is invalid
+     *
+     * @note With linesPerPacket > 1 every packet is that many records of
+     *       an 8-byte header and a line (or module segment) back to back,
+     *       all the same size; narrow lines then share a jumbo frame. The
+     *       records carry their packet's packetId. Packets that do not
+     *       split evenly are dropped.
+     *
+     *       With fragmentBytes > 0 each packet carries fragmentBytes of a
+     *       line after a 12-byte header: the 8-byte header, then the byte
+     *       offset of the payload in the line (little-endian). Fragments
+     *       are placed as XFrame segments, so XFrame::SetSegments() must
+     *       be line bytes / fragmentBytes; module boundaries are then
+     *       fragment boundaries too. Not for dual energy or XMultiFrame.
+     *
+     *       Either needs header mode and excludes zero-copy receive; with
+     *       SetPacketCheck() the CRC16 covers the whole packet. AF_XDP
+     *       frames hold packets up to 3798 bytes, so jumbo packets need
+     *       the socket or io_uring receive.
+     */
+    bool SetPacketLayout(const PacketLayout& layout);
+    
+    /**
+     * @brief Get the packet layout
+     * @param layout Output layout
+     */
+    void GetPacketLayout(PacketLayout& layout);
+    
+    /**
+     * @brief Verify the CRC16 trailer of every image packet
+     * @param enable true if the detector sends packets with checksums
+     * @return true on success, false if grabbing
+     *
+     * @note Such packets end in the CRC16 (XLib_CalculateCRC16, low byte
+     *       first) of everything before it. The trailer is stripped from
+     *       good packets; bad ones are dropped and counted in
+     *       packetsCorrupt. Their packetId is still marked as seen, so
+     *       they do not count as lost too, but towards the loss alarm.
+     *       Not available with zero-copy receive, whose payloads land in
+     *       the frame before they can be checked.
+     */
+    bool SetPacketCheck(bool enable);
+    
+    /**
+     * @brief Check whether image packets are verified
+     * @return true if SetPacketCheck() is on
+     */
+    bool GetPacketCheck();
+    
+    /**
+     * @brief Verify every image line against a detector test pattern
+     * @param expected Expected lines, one after the other (nullptr = learn them)
+     * @param bytes Bytes at @p expected: lines * pixel count * bytes per pixel
+     * @param lines Lines before the pattern repeats (0 = off)
+     * @return true on success, false if grabbing
+     *
+     * @note For qualifying NICs, cables and switches with the XCU_TEST or
+     *       XDM_TEST pattern on: line id L is compared with expected line
+     *       L % lines, one DM module's share or fragment at a time, with
+     *       an AVX2 compare where the CPU has it. Without @p expected the
+     *       reference is learned after Grab(): a line of the period is
+     *       known once two copies in a row agree. Segments that differ raise error 27 and
+     *       count in patternMismatched; loss and reorder are counted as
+     *       always. Lines still reach XFrame. A period that divides 65536
+     *       keeps its phase across the 16-bit line id wrap. Needs header
+     *       mode and single-energy XFrame assembly.
+     */
+    bool SetPatternCheck(const uint8_t* expected, uint32_t bytes, uint32_t lines);
+    
+    /**
+     * @brief Get the test pattern period
+     * @return Lines per period, 0 if lines are not checked
+     */
+    uint32_t GetPatternCheck();
+    
     /**
      * @brief Set event callback sink
      * @param sink_ Callback handler
@@ -92,6 +323,25 @@ public:
      */
     void SetFrame(XFrame& frame);
     
+    /**
+     * @brief Feed one detector of a multi-detector assembler instead of an XFrame
+     * @param multi Running XMultiFrame shared by all detectors' grabbers
+     * @param detector Detector index inside multi
+     * 
+     * @note Requires the packet ring (no zero-copy, one receive queue). With
+     *       header mode lines are aligned by header lineId and timestamp.
+     */
+    void SetMultiFrame(XMultiFrame& multi, uint32_t detector);
+    
+    /**
+     * @brief Copy every received line payload into a pre-trigger ring
+     * @param recorder Open XFlightRecorder, nullptr to detach
+     * 
+     * @note Set before Grab(); the recorder is fed from the receive threads,
+     *       before frame assembly, in every receive mode
+     */
+    void SetFlightRecorder(XFlightRecorder* recorder);
+    
     /**
      * @brief Set factory for resource management
      * @param factory XFactory instance
@@ -104,6 +354,183 @@ public:
      */
     void SetTimeout(uint32_t time);
     
+    /**
+     * @brief Set number of packets received per system call
+     * @param count Packet slots per receive (1 = one packet per call, max 1024;
+     *              default 32, or the host profile's batch size)
+     * @return true on success, false if grabbing or count is invalid
+     */
+    bool SetBatchSize(uint32_t count);
+    
+    /**
+     * @brief Get number of packets received per system call
+     * @return Packet slots per receive
+     */
+    uint32_t GetBatchSize();
+    
+    /**
+     * @brief Set depth of the receive ring between network and frame assembly
+     * @param packets Ring depth in packets (rounded up to a power of two;
+     *                default 4096, or the host profile's ring depth)
+     * @return true on success, false if grabbing or depth is invalid
+     * 
+     * @note Size it to cover the worst-case sink latency at the line rate
+     */
+    bool SetRingDepth(uint32_t packets);
+    
+    /**
+     * @brief Get configured receive ring depth
+     * @return Ring depth in packets
+     */
+    uint32_t GetRingDepth();
+    
+    /**
+     * @brief Get highest receive ring occupancy since the last Grab
+     * @return High-water mark in packets
+     */
+    uint32_t GetRingHighWater();
+    
+    /**
+     * @brief Enable zero-copy receive straight into frame rows
+     * @param enable true to scatter payloads directly into the XFrame buffer
+     * @return true on success, false if grabbing
+     * 
+     * @note In this mode the receive ring is bypassed and frame assembly,
+     *       including OnFrameReady, runs on the receive thread
+     */
+    bool SetZeroCopy(bool enable);
+    
+    /**
+     * @brief Check whether zero-copy receive is enabled
+     * @return true if enabled
+     */
+    bool GetZeroCopy();
+    
+    /**
+     * @brief Select blocking or busy-poll receive
+     * @param mode Receive mode
+     * @return true on success, false if grabbing or mode is invalid
+     * 
+     * @note Busy-poll keeps the receive and assembly threads at 100% CPU;
+     *       pin them with XFactory::SetThreadPolicy(). In every mode Stop()
+     *       wakes the receivers immediately rather than after the timeout.
+     * @note Adaptive receive grows its batch up to SetBatchSize() while the
+     *       socket holds more packets than one batch, and hands a partial
+     *       batch on after SetBatchDelay(). It polls while a batch is open
+     *       and for one delay after the last packet, then sleeps in the
+     *       socket wait, so CPU follows traffic. It applies to the plain
+     *       socket receive; AF_XDP, io_uring and receive queues treat it
+     *       as blocking.
+     */
+    bool SetReceiveMode(ReceiveMode mode);
+    
+    /**
+     * @brief Get current receive mode
+     * @return Receive mode
+     */
+    ReceiveMode GetReceiveMode();
+    
+    /**
+     * @brief Set how long RECEIVE_ADAPTIVE holds a partial batch
+     * @param maxDelayUs Longest a packet waits for its batch, in microseconds
+     *                   (1..100000, default 100)
+     * @return true on success, false if grabbing or out of range
+     * 
+     * @note Bounds the latency batching adds to each line
+     */
+    bool SetBatchDelay(uint32_t maxDelayUs);
+    
+    /**
+     * @brief Get adaptive batch delay
+     * @return Delay in microseconds
+     */
+    uint32_t GetBatchDelay();
+    
+    /**
+     * @brief Set number of parallel receive queues for multi-module detectors
+     * @param count Queues (1 = single socket, max 64); call before Open()
+     * @return true on success
+     * 
+     * @note Each queue has its own socket (SO_REUSEPORT on the image port)
+     *       and thread. Requires header mode; with XFrame::SetSegments(modules)
+     *       each packet's moduleId selects its pixel range in the shared row.
+     *       The queues share one packetId sequence, so packets that one
+     *       queue delivers ahead of another count as reordered.
+     */
+    bool SetReceiveQueues(uint32_t count);
+    
+    /**
+     * @brief Receive image packets through AF_XDP instead of the UDP socket
+     * @param interfaceName Interface the detector is on (e.g. "enp3s0f0"), empty = socket
+     * @param queueId NIC receive queue the image flow is steered to
+     * @return true on success, false if grabbing or the name is too long
+     * 
+     * @note Linux only, with CAP_NET_RAW and CAP_BPF. The receive ring's
+     *       packet store becomes the UMEM: the NIC writes each packet into
+     *       its ring slot and assembly reads it there, with no system call
+     *       per packet and no kernel copy. Each packet must fit a 4096-byte
+     *       frame with its headers (packets up to 3798 bytes). Zero-copy and
+     *       multi-queue receive keep their sockets. When the AF_XDP socket
+     *       cannot be opened, Grab() logs a warning and uses the UDP socket.
+     */
+    bool SetKernelBypass(const std::string& interfaceName, uint32_t queueId = 0);
+    
+    /**
+     * @brief Check whether the running acquisition receives through AF_XDP
+     * @return true if packets come from the AF_XDP socket
+     */
+    bool GetKernelBypass();
+    
+    /**
+     * @brief Receive image packets through io_uring
+     * @param enable true to drive the image socket from an io_uring
+     * @return true on success, false if grabbing
+     * 
+     * @note Linux 6.0 or later. One multishot receive fills the receive
+     *       ring's packet slots, handed to the kernel as provided buffers,
+     *       so a burst of packets costs a single system call. Slots are
+     *       given back as assembly consumes them; while none are free the
+     *       socket buffer holds the packets. AF_XDP, zero-copy and
+     *       multi-queue receive take precedence. When io_uring or the
+     *       socket is unavailable, Grab() logs a warning and uses the
+     *       socket receive calls.
+     */
+    bool SetIoUring(bool enable);
+    
+    /**
+     * @brief Check whether the running acquisition receives through io_uring
+     * @return true if packets come from the io_uring
+     */
+    bool GetIoUring();
+    
+    /**
+     * @brief Get number of parallel receive queues
+     * @return Queue count
+     */
+    uint32_t GetReceiveQueues();
+    
+    /**
+     * @brief Get live receive statistics
+     * @param stats Output counters
+     * 
+     * @note packetId accounting requires header mode
+     */
+    void GetStatistics(Statistics& stats);
+    
+    /**
+     * @brief Reset receive statistics
+     */
+    void ResetStatistics();
+    
+    /**
+     * @brief Set packet-loss alarm
+     * @param ratio Loss ratio that raises event 112 (0.001 = 0.1%, 0 = off)
+     * @param windowMs Evaluation window and minimum event interval (ms)
+     * 
+     * @note Event 112 data is the number of packets lost in the window
+     */
+    void SetLossThreshold(double ratio, uint32_t windowMs = 1000);
+    
 private:
     class Impl;
     Impl* m_impl;
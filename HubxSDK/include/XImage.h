@@ -8,19 +8,98 @@
 #define XIMAGE_H
 
 #include <cstdint>
+#include <memory>
+#include "XImageView.h"
+#include "XPixel.h"
 
 namespace HX {
 
+/**
+ * @struct XFrameInfo
+ * @brief Fixed-layout metadata that travels with a frame
+ * 
+ * XFrame fills it in for every frame it emits, before OnFrameReady (in a
+ * burst, before the frame counts as captured), and does not touch it
+ * again until the buffer is reused. Stages downstream read it straight
+ * from the image, with no lookup into or lock on the XFrame. 64 bytes,
+ * no padding, so it can be written to a file or a wire as it is.
+ */
+struct XFrameInfo {
+    enum Flags {
+        FLAG_INCOMPLETE  = 0x01,    ///< Rows missing, see missingLines
+        FLAG_EMPTY       = 0x02,    ///< Tagged as empty belt
+        FLAG_DUAL_ENERGY = 0x04,    ///< Rows are the high plane, then the low plane
+        FLAG_AVERAGED    = 0x08,    ///< Temporal average of several frames
+        FLAG_TRIGGERED   = 0x10,    ///< Opened on a frame trigger
+        FLAG_OBJECT      = 0x20     ///< Object frame, as tall as its object
+    };
+    
+    uint64_t sequence;              ///< Frames finished since Start(); gaps are frames not delivered
+    uint64_t deviceUs;              ///< First received row: detector time
+    uint64_t hostNs;                ///< First received row: host time, ns since 1970
+    uint64_t calibrationVersion;    ///< Set by the correction stage (0 = not corrected)
+    uint32_t firstLineId;           ///< lineId of row 0 (0 for object frames)
+    uint32_t missingLines;          ///< Rows not received
+    uint32_t detectorId;            ///< XFrame::SetDetectorId()
+    uint32_t flags;                 ///< Flags
+    uint32_t reserved[4];
+    
+    XFrameInfo()
+        : sequence(0), deviceUs(0), hostNs(0), calibrationVersion(0), firstLineId(0),
+          missingLines(0), detectorId(0), flags(0), reserved() {}
+};
+
+static_assert(sizeof(XFrameInfo) == 64, "XFrameInfo layout is fixed");
+
 /**
  * @class XImage
  * @brief Encapsulates frame image data and metadata
+ * 
+ * Owned pixel buffers are reference-counted: Share() and copies of an
+ * XImage refer to the same allocation, which is freed with the last one.
  */
 class XImage {
 public:
+    /// Alignment of every owned pixel buffer in bytes
+    static const uint32_t DEFAULT_ALIGNMENT = 64;
+    
+    /// Base alignment that also requests transparent huge pages (Linux)
+    static const uint32_t HUGE_PAGE_ALIGNMENT = 2 * 1024 * 1024;
+    
+    /**
+     * @brief File formats for Save()
+     */
+    enum SaveFormat {
+        SAVE_TEXT = 0,      ///< Header lines, then decimal pixel values row by row
+        SAVE_RAW,           ///< Packed pixels only, native byte order
+        SAVE_BINARY         ///< 32-byte header (size, depth) + packed pixels, see Load()
+    };
+    
     XImage();
     XImage(uint32_t width, uint32_t height, uint8_t pixelDepth);
     ~XImage();
     
+    /**
+     * @brief Allocate an aligned pixel buffer, optionally with padded rows
+     * @param width Image width
+     * @param height Image height
+     * @param pixelDepth Bits per pixel
+     * @param rowAlign Row stride multiple in bytes (0 = packed rows)
+     * @param baseAlign Buffer alignment in bytes (power of two, >= 64;
+     *                  4096 = page, HUGE_PAGE_ALIGNMENT = huge page)
+     * @return true on success
+     * 
+     * @note With rowAlign > 0 rows are not contiguous: step by _stride
+     */
+    bool Allocate(uint32_t width, uint32_t height, uint8_t pixelDepth,
+                  uint32_t rowAlign = 0, uint32_t baseAlign = DEFAULT_ALIGNMENT);
+    
+    /**
+     * @brief Get bytes between the starts of consecutive rows
+     * @return Row stride in bytes
+     */
+    uint32_t GetStride() const { return _stride; }
+    
     /**
      * @brief Get pixel value at specified coordinates
      * @param row Row index
@@ -37,6 +116,18 @@ public:
      */
     void SetPixelVal(uint32_t row, uint32_t col, uint32_t pixel_value);
     
+    /**
+     * @brief Get a typed row accessor
+     * @tparam Bytes Container size; must equal (pixel depth + 7) / 8
+     * @param row Row index (not range-checked)
+     * 
+     * @note Pick Bytes once per image with XDispatchPixelBytes()
+     */
+    template <uint32_t Bytes>
+    XPixelRow<Bytes> Row(uint32_t row) const {
+        return XPixelRow<Bytes>(_data_ + _data_offset + static_cast<size_t>(row) * _stride, _width);
+    }
+    
     /**
      * @brief Save image to text file
      * @param file_name_ File path
@@ -44,6 +135,26 @@ public:
      */
     bool Save(const char* file_name_) const;
     
+    /**
+     * @brief Save image in a given format
+     * @param file_name_ File path
+     * @param format File format
+     * @return true on success
+     * 
+     * @note SAVE_RAW and SAVE_BINARY write the pixel block in one call
+     *       (one per row for padded strides); use them for dumps
+     */
+    bool Save(const char* file_name_, SaveFormat format) const;
+    
+    /**
+     * @brief Load an image written with Save(..., SAVE_BINARY)
+     * @param file_name_ File path
+     * @return true on success
+     * 
+     * @note Reallocates the image to the size and depth in the file
+     */
+    bool Load(const char* file_name_);
+    
     /**
      * @brief Set image data pointer
      * @param data Data pointer
@@ -66,19 +177,50 @@ public:
      */
     XImage* Clone() const;
     
+    /**
+     * @brief Get another image that shares this image's pixels (no copy)
+     * @return Pointer to new XImage instance, nullptr if no data
+     * 
+     * @note Writes through either image are visible in both. A shared
+     *       image of non-owned data does not keep that data alive.
+     */
+    XImage* Share() const;
+    
+    /**
+     * @brief Get number of images sharing this image's allocation
+     * @return Reference count, 0 if the data is not owned
+     */
+    uint32_t GetShareCount() const;
+    
+    /**
+     * @brief Get a view of the whole image
+     */
+    XImageView View() const;
+    
+    /**
+     * @brief Get a view of a region of interest
+     * @param x First column
+     * @param y First row
+     * @param width Columns
+     * @param height Rows
+     */
+    XImageView View(uint32_t x, uint32_t y, uint32_t width, uint32_t height) const;
+    
     // Public members (for direct access)
     uint8_t* _data_;            ///< Image data pointer
     uint32_t _data_offset;      ///< Offset to first pixel
     uint32_t _height;           ///< Number of rows
     uint32_t _width;            ///< Number of columns
     uint8_t _pixel_depth;       ///< Bits per pixel
-    uint32_t _size;             ///< Total size in bytes
+    uint32_t _size;             ///< Total size in bytes (_stride * _height)
+    uint32_t _stride;           ///< Bytes per row including padding
+    XFrameInfo _info;           ///< Frame metadata, filled by XFrame
     
 private:
-    void allocateMemory();
+    void allocateMemory(uint32_t rowAlign = 0, uint32_t baseAlign = DEFAULT_ALIGNMENT);
     void freeMemory();
     
-    bool m_ownsData;
+    std::shared_ptr<uint8_t> m_buffer;  ///< Owned allocation, empty if not owned
 };
 
 } // namespace HX
@@ -0,0 +1,92 @@
+/**
+ * @file XImageView.h
+ * @brief XImageView class - Non-owning view of image rows
+ * @version 2.1.0
+ */
+
+#ifndef XIMAGEVIEW_H
+#define XIMAGEVIEW_H
+
+#include <cstdint>
+
+namespace HX {
+
+/**
+ * @class XImageView
+ * @brief Non-owning window onto pixels held by an XImage
+ * 
+ * A view is a pointer, a size and a row stride; copying it never copies
+ * pixels. Sub() narrows it to a region of interest that shares the same
+ * rows. The view does not keep the pixels alive: keep the XImage (or a
+ * shared XImage from XImage::Share()) for as long as the view is used.
+ */
+class XImageView {
+public:
+    XImageView();
+    
+    /**
+     * @brief Construct view over existing pixels
+     * @param data First pixel of the view
+     * @param width Columns
+     * @param height Rows
+     * @param stride Bytes between the starts of consecutive rows
+     * @param pixelDepth Bits per pixel
+     */
+    XImageView(uint8_t* data, uint32_t width, uint32_t height,
+               uint32_t stride, uint8_t pixelDepth);
+    
+    /**
+     * @brief Get a region of interest within this view
+     * @param x First column
+     * @param y First row
+     * @param width Columns (clipped to the view)
+     * @param height Rows (clipped to the view)
+     * @return View sharing this view's rows, empty if x/y lie outside
+     */
+    XImageView Sub(uint32_t x, uint32_t y, uint32_t width, uint32_t height) const;
+    
+    /**
+     * @brief Get pointer to the first pixel of a row
+     * @param row Row index
+     * @return Row pointer, nullptr if out of range
+     */
+    uint8_t* Row(uint32_t row) const;
+    
+    /**
+     * @brief Get pixel value at specified coordinates
+     * @param row Row index
+     * @param col Column index
+     * @return Pixel value
+     */
+    uint32_t GetPixelVal(uint32_t row, uint32_t col) const;
+    
+    /**
+     * @brief Set pixel value at specified coordinates
+     * @param row Row index
+     * @param col Column index
+     * @param pixel_value Pixel value to set
+     */
+    void SetPixelVal(uint32_t row, uint32_t col, uint32_t pixel_value);
+    
+    uint8_t* GetData() const { return m_data; }
+    uint32_t GetWidth() const { return m_width; }
+    uint32_t GetHeight() const { return m_height; }
+    uint32_t GetStride() const { return m_stride; }
+    uint8_t GetPixelDepth() const { return m_pixelDepth; }
+    
+    /**
+     * @brief Check if the view refers to any pixels
+     */
+    bool IsValid() const { return m_data != nullptr && m_width > 0 && m_height > 0; }
+    
+private:
+    uint8_t* m_data;
+    uint32_t m_width;
+    uint32_t m_height;
+    uint32_t m_stride;
+    uint8_t m_pixelDepth;
+};
+
+} // namespace HX
+
+#endif // XIMAGEVIEW_H
@@ -0,0 +1,142 @@
+/**
+ * @file XPixel.h
+ * @brief Compile-time pixel container access for XImage data
+ * @version 2.1.0
+ *
+ * Pixels are stored little-endian in 1, 2, 3 or 4 byte containers
+ * ((pixelDepth + 7) / 8). XPixelAccess<Bytes> turns a container into a
+ * straight load/store; XDispatchPixelBytes() picks the specialization once
+ * per image so the per-pixel loop has no depth branch.
+ */
+
+#ifndef XPIXEL_H
+#define XPIXEL_H
+
+#include <cstdint>
+#include <cstring>
+
+namespace HX {
+
+/**
+ * @brief Load/store of one pixel container
+ * @tparam Bytes Container size (1, 2, 3 or 4)
+ */
+template <uint32_t Bytes>
+struct XPixelAccess;
+
+template <>
+struct XPixelAccess<1> {
+    typedef uint8_t Type;
+    static uint32_t Load(const uint8_t* p) { return p[0]; }
+    static void Store(uint8_t* p, uint32_t v) { p[0] = static_cast<uint8_t>(v); }
+};
+
+template <>
+struct XPixelAccess<2> {
+    typedef uint16_t Type;
+    static uint32_t Load(const uint8_t* p) {
+        // memcpy compiles to a single (possibly unaligned) load
+        uint16_t v;
+        memcpy(&v, p, sizeof(v));
+        return v;
+    }
+    static void Store(uint8_t* p, uint32_t v) {
+        uint16_t t = static_cast<uint16_t>(v);
+        memcpy(p, &t, sizeof(t));
+    }
+};
+
+template <>
+struct XPixelAccess<3> {
+    typedef uint32_t Type;
+    static uint32_t Load(const uint8_t* p) {
+        return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16);
+    }
+    static void Store(uint8_t* p, uint32_t v) {
+        p[0] = static_cast<uint8_t>(v);
+        p[1] = static_cast<uint8_t>(v >> 8);
+        p[2] = static_cast<uint8_t>(v >> 16);
+    }
+};
+
+template <>
+struct XPixelAccess<4> {
+    typedef uint32_t Type;
+    static uint32_t Load(const uint8_t* p) {
+        uint32_t v;
+        memcpy(&v, p, sizeof(v));
+        return v;
+    }
+    static void Store(uint8_t* p, uint32_t v) {
+        memcpy(p, &v, sizeof(v));
+    }
+};
+
+/**
+ * @class XPixelRow
+ * @brief Typed view of one image row
+ * @tparam Bytes Container size (1, 2, 3 or 4)
+ */
+template <uint32_t Bytes>
+class XPixelRow {
+public:
+    XPixelRow(uint8_t* data, uint32_t width) : m_data(data), m_width(width) {}
+
+    uint32_t Get(uint32_t col) const { return XPixelAccess<Bytes>::Load(m_data + col * Bytes); }
+    void Set(uint32_t col, uint32_t value) { XPixelAccess<Bytes>::Store(m_data + col * Bytes, value); }
+    uint32_t Width() const { return m_width; }
+    uint8_t* Data() const { return m_data; }
+
+    /**
+     * @brief Forward iterator over pixel values
+     */
+    class Iterator {
+    public:
+        explicit Iterator(const uint8_t* p) : m_p(p) {}
+        uint32_t operator*() const { return XPixelAccess<Bytes>::Load(m_p); }
+        Iterator& operator++() { m_p += Bytes; return *this; }
+        bool operator!=(const Iterator& other) const { return m_p != other.m_p; }
+    private:
+        const uint8_t* m_p;
+    };
+
+    Iterator begin() const { return Iterator(m_data); }
+    Iterator end() const { return Iterator(m_data + m_width * Bytes); }
+
+private:
+    uint8_t* m_data;
+    uint32_t m_width;
+};
+
+/**
+ * @brief Run a kernel specialized for the container size of a pixel depth
+ * @param pixelDepth Bits per pixel (1-32)
+ * @param kernel Object with a member template `template <uint32_t Bytes> void run()`
+ * @return false if the depth has no container
+ *
+ * @code
+ * struct Sum {
+ *     const XImage* img; uint64_t total;
+ *     template <uint32_t Bytes> void run() {
+ *         for (uint32_t r = 0; r < img->_height; ++r) {
+ *             XPixelRow<Bytes> row(img->_data_ + r * img->_stride, img->_width);
+ *             for (uint32_t c = 0; c < row.Width(); ++c) total += row.Get(c);
+ *         }
+ *     }
+ * };
+ * @endcode
+ */
+template <typename Kernel>
+bool XDispatchPixelBytes(uint32_t pixelDepth, Kernel& kernel) {
+    switch ((pixelDepth + 7) / 8) {
+        case 1: kernel.template run<1>(); return true;
+        case 2: kernel.template run<2>(); return true;
+        case 3: kernel.template run<3>(); return true;
+        case 4: kernel.template run<4>(); return true;
+        default: return false;
+    }
+}
+
+} // namespace HX
+
+#endif // XPIXEL_H
@@ -0,0 +1,168 @@
+// ============================================================================
+
+/**
+ * @file XPreviewServer.h
+ * @brief XPreviewServer class - Decimated live preview for remote viewers
+ * @version 2.1.0
+ */
+
+#ifndef XPREVIEWSERVER_H
+#define XPREVIEWSERVER_H
+
+#include <cstdint>
+
+namespace HX {
+
+class IXImgSink;
+class XImage;
+
+/**
+ * @class XPreviewServer
+ * @brief Serves a reduced 8-bit copy of the live image to TCP subscribers
+ *
+ * Publish() is meant for OnFrameReady: frames beyond the rate limit are
+ * skipped at once, the others are copied into a mailbox and return. A
+ * worker thread reduces the latest frame to the preview size (keeping
+ * the block extreme farther from its mean, as XShow does), applies the
+ * same window/level as XShow and encodes it. Every subscriber has its own
+ * sender thread and holds at most one frame: a newer frame replaces one
+ * not yet sent, so a slow client only loses frames and never holds up
+ * acquisition or the other clients.
+ *
+ * Each frame is sent as a 48-byte little-endian header followed by the
+ * payload:
+ *
+ *   char[4]  magic "HXPV"        uint16 version (1)    uint16 encoding
+ *   uint32   preview width       uint32 preview height
+ *   uint32   source width        uint32 source height
+ *   uint32   window low          uint32 window high
+ *   uint64   frame number        uint32 payload bytes  uint32 reserved
+ *
+ * XPREVIEW_RAW payloads are width * height levels, row by row;
+ * XPREVIEW_DELTA payloads are the same levels delta-packed (left
+ * neighbour prediction, zigzag residuals packed 32 at a time at the
+ * smallest width that holds them, each block prefixed by its width byte).
+ */
+class XPreviewServer {
+public:
+    /**
+     * @enum XEncoding
+     * @brief Payload encodings
+     */
+    enum XEncoding {
+        XPREVIEW_RAW = 0,   ///< 8-bit levels as is
+        XPREVIEW_DELTA      ///< Lossless delta packing (default)
+    };
+
+    /**
+     * @brief Server counters since Start()
+     */
+    struct Statistics {
+        uint64_t framesPublished;   ///< Publish() calls
+        uint64_t framesSkipped;     ///< Over the rate limit or replaced before encoding
+        uint64_t framesEncoded;     ///< Frames handed to the subscribers
+        uint64_t framesDropped;     ///< Replaced before a subscriber was sent them
+        uint64_t bytesSent;         ///< Header and payload bytes, all subscribers
+        uint32_t clients;           ///< Subscribers connected now
+    };
+
+    XPreviewServer();
+    ~XPreviewServer();
+
+    /**
+     * @brief Set error callback sink
+     * @param sink_ Callback handler
+     */
+    void SetSink(IXImgSink* sink_);
+
+    /**
+     * @brief Select the payload encoding
+     * @param encoding XPREVIEW_RAW or XPREVIEW_DELTA
+     * @return true on success, false if running
+     */
+    bool SetEncoding(XEncoding encoding);
+
+    /**
+     * @brief Bound the preview size
+     * @param width Largest preview width (default 1024)
+     * @param height Largest preview height (default 1024)
+     * @return true on success, false if running or a bound is 0
+     *
+     * @note Frames are reduced by the smallest whole factor that fits
+     */
+    bool SetMaxSize(uint32_t width, uint32_t height);
+
+    /**
+     * @brief Limit the preview rate
+     * @param fps Frames per second (default 15, 0 = every frame)
+     */
+    void SetMaxFps(uint32_t fps);
+
+    /**
+     * @brief Set a fixed display window
+     * @param low Value shown as level 0
+     * @param high Value shown as level 255
+     * @return false if low >= high
+     *
+     * @note Disables the auto-window
+     */
+    bool SetWindow(uint32_t low, uint32_t high);
+
+    /**
+     * @brief Fit the window to each frame's histogram
+     * @param enable true to enable
+     * @param clip Fraction of samples dropped at each end
+     */
+    void SetAutoWindow(bool enable, float clip = 0.005f);
+
+    /**
+     * @brief Listen for subscribers
+     * @param port TCP port (0 = any free port, see GetPort())
+     * @param maxClients Connections served at once; more are closed
+     * @return true on success
+     */
+    bool Start(uint16_t port, uint32_t maxClients = 8);
+
+    /**
+     * @brief Disconnect all subscribers and stop the threads
+     */
+    void Stop();
+
+    /**
+     * @brief Check if the server is running
+     */
+    bool IsRunning() const;
+
+    /**
+     * @brief Get the port being listened on
+     * @return Port, 0 if not running
+     */
+    uint16_t GetPort() const;
+
+    /**
+     * @brief Offer a frame to the preview
+     * @param image Frame in any depth up to 32 bits
+     * @return true if the frame was taken
+     *
+     * @note The pixels are copied; the image can be reused on return
+     */
+    bool Publish(const XImage* image);
+
+    /**
+     * @brief Get server counters
+     * @return Statistics since Start()
+     */
+    Statistics GetStatistics() const;
+
+private:
+    class Impl;
+    Impl* m_impl;
+
+    // Non-copyable
+    XPreviewServer(const XPreviewServer&) = delete;
+    XPreviewServer& operator=(const XPreviewServer&) = delete;
+};
+
+} // namespace HX
+
+#endif // XPREVIEWSERVER_H
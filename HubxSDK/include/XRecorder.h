@@ -0,0 +1,204 @@
+// ============================================================================
+
+/**
+ * @file XRecorder.h
+ * @brief XRecorder class - Asynchronous write-behind frame recording
+ * @version 2.1.0
+ */
+
+#ifndef XRECORDER_H
+#define XRECORDER_H
+
+#include "XFile.h"
+#include <cstdint>
+#include <string>
+
+namespace HX {
+
+class IXImgSink;
+class XFrame;
+class XImage;
+
+/**
+ * @class XRecorder
+ * @brief Writes frames to disk on a dedicated thread
+ *
+ * Submit() only queues the frame, so OnFrameReady never waits for the
+ * disk. The writer thread saves every frame as its own TIFF, in the same
+ * layout as XFile::Write(), with the pixel data on a 4 KB boundary so it
+ * can be written unbuffered (O_DIRECT / FILE_FLAG_NO_BUFFERING) without
+ * filling the page cache. File systems that refuse unbuffered I/O get
+ * ordinary buffered writes.
+ *
+ * SetCompression(XF_COMPRESS_TEMPORAL) suits static inspection and CT
+ * rotation sequences: each file holds the bit-packed residuals against the
+ * file written before it, and every keyframeInterval-th file is a
+ * keyframe (XF_COMPRESS_DELTA) that XSequenceReader and XFile::Read()
+ * start decoding from when they seek.
+ */
+class XRecorder {
+public:
+    /**
+     * @brief What Submit() does when the queue is full
+     */
+    enum QueuePolicy {
+        QUEUE_DROP_NEWEST = 0,  ///< Drop the submitted frame (default)
+        QUEUE_DROP_OLDEST,      ///< Drop the oldest frame not yet being written
+        QUEUE_BLOCK             ///< Wait for room, up to the block timeout
+    };
+
+    /**
+     * @brief Recorder counters since Start()
+     */
+    struct Statistics {
+        uint64_t framesSubmitted;   ///< Submit() calls
+        uint64_t framesWritten;     ///< Files completed
+        uint64_t framesDropped;     ///< Frames dropped by the queue policy
+        uint64_t writeErrors;       ///< Files that could not be written
+        uint64_t bytesWritten;      ///< File bytes written
+        uint64_t pixelBytes;        ///< Pixel bytes of the files written, before compression
+        uint64_t keyframesWritten;  ///< Compressed files that need no other file
+        uint32_t queued;            ///< Frames waiting now
+        uint32_t queueHighWater;    ///< Most frames waiting at once
+        double   averageMBps;       ///< bytesWritten over wall time since Start()
+        double   diskMBps;          ///< bytesWritten over time spent writing
+        double   maxWriteMs;        ///< Slowest single file
+        bool     directIO;          ///< Last file was written unbuffered
+    };
+
+    XRecorder();
+    ~XRecorder();
+
+    /**
+     * @brief Set error/event callback sink
+     * @param sink_ Callback handler
+     *
+     * @note Write errors are reported from the writer thread; drops raise
+     *       event 113 with the total dropped so far from Submit()
+     */
+    void SetSink(IXImgSink* sink_);
+
+    /**
+     * @brief Set number of frames that may wait for the disk
+     * @param frames Queue depth (default 16)
+     * @return true on success, false if running or frames is 0
+     */
+    bool SetQueueDepth(uint32_t frames);
+
+    /**
+     * @brief Get queue depth
+     * @return Queue depth in frames
+     */
+    uint32_t GetQueueDepth() const;
+
+    /**
+     * @brief Select what happens when the queue is full
+     * @param policy Queue policy
+     * @param blockTimeoutMs Longest QUEUE_BLOCK wait before the frame is
+     *                       dropped (0 = wait indefinitely)
+     */
+    void SetQueuePolicy(QueuePolicy policy, uint32_t blockTimeoutMs = 100);
+
+    /**
+     * @brief Get queue policy
+     * @return Queue policy
+     */
+    QueuePolicy GetQueuePolicy() const;
+
+    /**
+     * @brief Enable unbuffered writes
+     * @param enable true to bypass the page cache (default)
+     * @return true on success, false if running
+     */
+    bool SetDirectIO(bool enable);
+
+    /**
+     * @brief Record every file in the directory's metadata index
+     * @param enable true to append an XArchiveIndex record per file
+     * @return true on success, false if running
+     *
+     * @note Recorder files carry geometry and date only; the remaining
+     *       record fields are 0
+     */
+    bool SetIndexing(bool enable);
+
+    /**
+     * @brief Write files through io_uring
+     * @param enable true to keep several files in flight from one thread
+     * @return true on success, false if running
+     *
+     * @note Linux 6.0 or later, otherwise Start() logs a warning and
+     *       writes synchronously. Copy buffers are registered with the
+     *       kernel as fixed buffers; padded or unaligned pool frames still
+     *       go through the bounce buffer.
+     */
+    bool SetIoUring(bool enable);
+
+    /**
+     * @brief Select how the pixels are stored
+     * @param mode XF_COMPRESS_NONE (default), XF_COMPRESS_DELTA or
+     *             XF_COMPRESS_TEMPORAL
+     * @param keyframeInterval Files per keyframe with XF_COMPRESS_TEMPORAL
+     *                         (1..1000, default 30); shorter intervals make
+     *                         seeking cheaper and the recording larger
+     * @return true on success, false if running or out of range
+     *
+     * @note Compressed files are encoded on the processing pool by the
+     *       writer thread and always written synchronously, io_uring or
+     *       not. A file that fails to write makes the next one a keyframe.
+     */
+    bool SetCompression(XFile::XFCompression mode, uint32_t keyframeInterval = 30);
+
+    /**
+     * @brief Start the writer thread
+     * @param directory Existing output directory
+     * @param prefix File name prefix; files are <prefix>_000000.tif, ...
+     * @return true on success
+     */
+    bool Start(const std::string& directory, const std::string& prefix = "frame");
+
+    /**
+     * @brief Write all queued frames and stop the writer thread
+     */
+    void Stop();
+
+    /**
+     * @brief Check if the recorder is running
+     * @return true if running
+     */
+    bool IsRunning() const;
+
+    /**
+     * @brief Queue a frame for writing
+     * @param image Frame to record
+     * @param pool XFrame the image came from, or nullptr to copy it
+     * @return true if queued, false if dropped or not running
+     *
+     * @note With a pool the frame is written in place and handed back
+     *       with XFrame::Release() once it is on disk, or at once if it is
+     *       not queued: the caller must not release it. Frames still
+     *       queued when the pool's XFrame stops stay valid until written;
+     *       the XFrame must outlive the recorder's Stop(). Without a pool the
+     *       pixels are copied into one of the recorder's queue buffers and
+     *       the image can be reused when Submit() returns.
+     */
+    bool Submit(XImage* image, XFrame* pool = nullptr);
+
+    /**
+     * @brief Get recorder counters
+     * @return Statistics since Start()
+     */
+    Statistics GetStatistics() const;
+
+private:
+    class Impl;
+    Impl* m_impl;
+
+    // Non-copyable
+    XRecorder(const XRecorder&) = delete;
+    XRecorder& operator=(const XRecorder&) = delete;
+};
+
+} // namespace HX
+
+#endif // XRECORDER_H
@@ -0,0 +1,138 @@
+// ============================================================================
+
+/**
+ * @file XSequenceReader.h
+ * @brief XSequenceReader class - Random access to frame sequences with prefetch
+ * @version 2.1.0
+ */
+
+#ifndef XSEQUENCEREADER_H
+#define XSEQUENCEREADER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace HX {
+
+class XImage;
+
+/**
+ * @class XSequenceReader
+ * @brief Frames of a capture for playback and scrubbing
+ *
+ * A sequence is either a list of XFile captures, one frame per file, or
+ * an XStreamFile cut into frames of a fixed number of lines. GetFrame()
+ * serves frames from a cache of decoded frames and, from the step between
+ * the last requests, predicts the ones that follow: forward or backward
+ * playback, or scrubbing that skips frames. Worker threads load the next
+ * SetPrefetch() frames along that step ahead of time, so a viewer stepping
+ * through the sequence finds them decoded.
+ *
+ * Raw captures are mapped (XFile::Map()); a worker asks the kernel to read
+ * a mapping ahead and touches its pages, so they are resident once the
+ * frame is requested. Compressed strips are decoded in parallel on the
+ * shared processing pool, at low priority for prefetched frames. Each
+ * worker reads a stream file through its own handle.
+ *
+ * Files recorded with XF_COMPRESS_TEMPORAL decode against the frame before
+ * when it is cached or being loaded, so forward playback costs one decode
+ * per frame; a seek, or a step backward, reads back from the last keyframe.
+ *
+ *   XSequenceReader reader;
+ *   reader.OpenFiles(paths);
+ *   ...
+ *   const XImage* frame = reader.GetFrame(slider);   // on each redraw
+ *   if (frame) show.Render(frame);
+ *
+ * GetFrame() is meant for one thread, typically the UI thread.
+ */
+class XSequenceReader {
+public:
+    /**
+     * @brief Reader counters since the sequence was opened
+     */
+    struct Statistics {
+        uint64_t requests;      ///< GetFrame() calls
+        uint64_t hits;          ///< ... served from the cache
+        uint64_t waits;         ///< ... waiting for a prefetch in progress
+        uint64_t misses;        ///< ... loaded on the calling thread
+        uint64_t prefetched;    ///< Frames loaded ahead by the workers
+        uint64_t unused;        ///< Prefetched frames evicted before a request
+        uint64_t failed;        ///< Frames that could not be loaded
+        uint32_t cached;        ///< Frames in the cache now
+    };
+
+    XSequenceReader();
+    ~XSequenceReader();
+
+    /**
+     * @brief Set how far ahead frames are loaded
+     * @param frames Frames prefetched along the predicted step (0 = none,
+     *               default 8); the cache holds 2 * frames + threads + 1
+     *               frames
+     * @param threads Worker threads (1..16, default 2)
+     * @return true on success, false if a sequence is open or out of range
+     */
+    bool SetPrefetch(uint32_t frames, uint32_t threads = 2);
+
+    /**
+     * @brief Open a sequence of XFile captures
+     * @param files One file per frame, in sequence order
+     * @return false if the list is empty or the first file cannot be read
+     */
+    bool OpenFiles(const std::vector<std::string>& files);
+
+    /**
+     * @brief Open a stream file as a sequence of frames
+     * @param file XStreamFile path
+     * @param linesPerFrame Lines per frame; the last frame holds the rest
+     * @return false if the stream cannot be opened, is empty, or
+     *         linesPerFrame is 0
+     */
+    bool OpenStream(const std::string& file, uint32_t linesPerFrame);
+
+    /**
+     * @brief Stop the workers and drop the cache
+     */
+    void Close();
+
+    /**
+     * @brief Check if a sequence is open
+     */
+    bool IsOpen() const;
+
+    /**
+     * @brief Get number of frames in the sequence
+     */
+    uint32_t GetFrameCount() const;
+
+    /**
+     * @brief Get a frame
+     * @param index Frame index, 0..GetFrameCount()-1
+     * @return Frame, nullptr if index is out of range or the frame cannot
+     *         be loaded
+     *
+     * @note The frame stays valid until the next GetFrame() or Close();
+     *       clone it to keep it longer
+     */
+    const XImage* GetFrame(uint32_t index);
+
+    /**
+     * @brief Get reader counters
+     * @return Statistics since the sequence was opened
+     */
+    Statistics GetStatistics() const;
+
+private:
+    class Impl;
+    Impl* m_impl;
+
+    // Non-copyable
+    XSequenceReader(const XSequenceReader&) = delete;
+    XSequenceReader& operator=(const XSequenceReader&) = delete;
+};
+
+} // namespace HX
+
+#endif // XSEQUENCEREADER_H
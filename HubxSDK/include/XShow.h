@@ -4,7 +4,7 @@
 
 /**
  * @file XShow.h
- * @brief XShow class - Image display (Windows only)
+ * @brief XShow class - Image display (Windows, X11)
  * @version 2.1.0
  */
 
@@ -20,9 +20,12 @@ class XDetector;
 
 /**
  * @class XShow
- * @brief Displays image data (Windows only)
+ * @brief Displays image data (Windows, X11)
  * 
- * @note This class is only available on Windows systems
+ * @note Available on Windows and on Linux builds with HUBX_WITH_X11. On
+ *       X11 frames are converted straight into an MIT-SHM image shared
+ *       with the server (XPutImage on remote displays); the window must
+ *       have a 24 or 32-bit TrueColor visual.
  */
 class XShow {
 public:
@@ -38,6 +41,37 @@ public:
         XCOLOR_JET          ///< Jet color map (blue->cyan->yellow->red)
     };
     
+    /**
+     * @enum XBackend
+     * @brief Presentation backends
+     */
+    enum XBackend {
+        XBACKEND_GDI = 0,   ///< CPU conversion and GDI blit (XShm on X11, default)
+        XBACKEND_OPENGL     ///< Texture upload, conversion in a fragment shader
+    };
+    
+    /**
+     * @enum XOverlay
+     * @brief Overlay marker shapes
+     */
+    enum XOverlay {
+        XOVERLAY_RECT = 0,  ///< Rectangle outline (ROI, defect box)
+        XOVERLAY_LINE       ///< Line segment (measurement)
+    };
+    
+    /**
+     * @brief Pixel statistics of the last converted image
+     */
+    struct XStatistics {
+        uint64_t frame;     ///< Images counted so far
+        uint64_t pixels;    ///< Pixels counted
+        uint32_t min;       ///< Smallest raw value
+        uint32_t max;       ///< Largest raw value
+        double   mean;      ///< Mean raw value
+        double   stddev;    ///< Standard deviation (from bin centers above 16 bits)
+        uint32_t binShift;  ///< Value v is counted in histogram bin v >> binShift
+    };
+    
     XShow();
     ~XShow();
     
@@ -46,7 +80,7 @@ public:
      * @param cols Image width
      * @param rows Image height
      * @param pixel_depth Bits per pixel
-     * @param hwnd Window handle (HWND on Windows)
+     * @param hwnd Window handle (HWND on Windows, X11 Window id on Linux)
      * @param color Color map mode
      * @return true on success
      */
@@ -78,9 +112,76 @@ public:
     /**
      * @brief Display image
      * @param img_ Image to display
+     * 
+     * @note A frame larger than the window's client area is reduced by a
+     *       whole factor first; each block shows its minimum or maximum,
+     *       whichever is farther from the block mean, so isolated defects
+     *       stay visible
      */
     void Show(XImage* img_);
     
+    /**
+     * @brief Display a dual-energy pair in material colors
+     * @param high High-energy image, sets the brightness
+     * @param low Low-energy image of the same size and depth
+     * 
+     * @note One pass over the pair: each pixel's brightness is the windowed
+     *       high-energy level, its hue the material class of its (high,
+     *       low) cell in a table built once per model and depth, and a
+     *       class x level table gives the display color, so no fused image
+     *       is made. Organic, inorganic and metal take the SetMaterialColors()
+     *       colors; background and impenetrable pixels stay gray. Window,
+     *       auto-window, gamma and statistics work on the high image; the
+     *       color map of Open() is not used. Up to 16 bits per pixel (deeper
+     *       pairs show the high image alone), converted on the CPU also with
+     *       the OpenGL backend.
+     */
+    void Show(XImage* high, XImage* low);
+    
+    /**
+     * @brief Set the colors of Show(high, low)
+     * @param organic Organic materials, as 0xRRGGBB (default orange)
+     * @param inorganic Inorganic and mixed materials (default green)
+     * @param metal Metals (default blue)
+     * 
+     * @note Each color is scaled by the display level, so thick material
+     *       darkens toward black
+     */
+    void SetMaterialColors(uint32_t organic = 0xFF9000, uint32_t inorganic = 0x30C030,
+                           uint32_t metal = 0x3070FF);
+    
+    /**
+     * @brief Set the material classification of Show(high, low)
+     * @param z0 Z-effective curve, Z = z0 + z1 R + z2 R^2 of the
+     *           attenuation ratio R = ln(I_low) / ln(I_high) (I relative
+     *           to full scale)
+     * @param z1 Linear coefficient
+     * @param z2 Quadratic coefficient
+     * @param organicMaxZ Organic below this Z-effective
+     * @param metalMinZ Metal from this Z-effective up
+     * @param lutBits Bits of high and of low in the table index (6..12)
+     * @return false if organicMaxZ > metalMinZ or lutBits is out of range
+     * 
+     * @note The same model as hubx_dualenergy_set_classification(); the
+     *       default is a linear stand-in through R = 1.1 -> Z 6 and
+     *       R = 1.9 -> Z 28
+     */
+    bool SetMaterialModel(float z0, float z1, float z2, float organicMaxZ, float metalMinZ,
+                          uint32_t lutBits = 10);
+    
+    /**
+     * @brief Scroll new lines into a waterfall display
+     * @param strip Rows to add, e.g. the strip of IXImgSink::OnLinesReady
+     * @param firstLine Row of the strip within its frame (as passed to
+     *                  OnLinesReady; lines scroll in arrival order)
+     * @param count Number of rows in the strip
+     * 
+     * @note The display buffer is a ring of the Open() rows: only the new
+     *       lines are converted, and the window is drawn as two blits with
+     *       the newest line at the bottom. Show() restarts the waterfall.
+     */
+    void ShowLines(const XImage* strip, uint32_t firstLine, uint32_t count);
+    
     /**
      * @brief Set gamma correction value
      * @param gama Gamma value (1.0 - 4.0)
@@ -93,6 +194,167 @@ public:
      */
     float GetGama();
     
+    /**
+     * @brief Set display window (window/level)
+     * @param low Raw value shown black
+     * @param high Raw value shown white
+     * @return true on success, false if low >= high
+     * 
+     * @note Turns the auto-window off. The default window is the full
+     *       0..2^depth-1 range; gamma and the color map apply after it
+     */
+    bool SetWindow(uint32_t low, uint32_t high);
+    
+    /**
+     * @brief Get display window in effect
+     * @param low Raw value shown black
+     * @param high Raw value shown white
+     * 
+     * @note With the auto-window on this is the window of the last Show()
+     */
+    void GetWindow(uint32_t& low, uint32_t& high);
+    
+    /**
+     * @brief Fit the window to every shown image
+     * @param enable true = window from a sampled histogram in each Show()
+     * @param clip Fraction of samples clipped at each end (0.005 = 0.5%)
+     * 
+     * @note About 64K pixels are sampled on a regular grid
+     */
+    void SetAutoWindow(bool enable, float clip = 0.005f);
+    
+    /**
+     * @brief Equalize local contrast (CLAHE) before the color map
+     * @param enable true = levels from tiled contrast-limited adaptive
+     *               histogram equalization instead of the window
+     * @param tiles Tiles per axis (1..32)
+     * @param clipLimit Histogram clip as a multiple of the mean bin (>= 1;
+     *                  larger = stronger contrast, more noise)
+     * @return false if tiles or clipLimit is out of range
+     * 
+     * @note Applies to Show() and to the brightness of Show(high, low),
+     *       not to ShowLines(), and presents through GDI/X11 while on.
+     *       Gamma and the color map still apply; statistics stay on the
+     *       raw values. The levels of a frame from XFrame are kept until
+     *       another frame is shown, so showing it again (after a gamma or
+     *       color change) costs only the color map. Frames deeper than
+     *       16 bits use the window.
+     */
+    bool SetContrastEnhancement(bool enable, uint32_t tiles = 8, float clipLimit = 2.5f);
+    
+    /**
+     * @brief Select the presentation backend
+     * @param backend XBACKEND_GDI or XBACKEND_OPENGL
+     * @return true on success, false if OpenGL 2.0 is not available
+     * 
+     * @note May be called before Open(); if the context cannot be created
+     *       then, Open() falls back to GDI. With OpenGL, raw 8 and 16-bit
+     *       rows are uploaded as a texture and window, gamma, color map
+     *       and scaling to the window run on the GPU; deeper pixels and
+     *       failed uploads still take the GDI path.
+     */
+    bool SetBackend(XBackend backend);
+    
+    /**
+     * @brief Get backend in use
+     * @return XBACKEND_OPENGL while a context is active, else XBACKEND_GDI
+     */
+    XBackend GetBackend();
+    
+    /**
+     * @brief Render on a paced display thread instead of the caller's
+     * @param enable true = Show() only hands the frame over
+     * @param maxFps Render rate limit (0 = monitor refresh rate)
+     * @return true on success
+     * 
+     * @note Show() copies the frame into a mailbox and returns; the display
+     *       thread renders the latest frame once per interval, and frames
+     *       replaced before they were shown are dropped. ShowLines() stays
+     *       synchronous so no waterfall line is lost.
+     */
+    bool SetAsync(bool enable, uint32_t maxFps = 0);
+    
+    /**
+     * @brief Get number of frames replaced in the mailbox before display
+     */
+    uint64_t GetDroppedFrames();
+    
+    /**
+     * @brief Add a marker drawn over the displayed image
+     * @param type XOVERLAY_RECT or XOVERLAY_LINE
+     * @param x0 First corner or end point, image column
+     * @param y0 First corner or end point, image row
+     * @param x1 Opposite corner or other end point, image column
+     * @param y1 Opposite corner or other end point, image row
+     * @param rgb Color as 0xRRGGBB
+     * @return Overlay id, 0 on failure
+     * 
+     * @note Markers are composited over a cached copy of the converted
+     *       frame: adding, moving or removing one restores and re-blits
+     *       only its rectangle, without converting the frame again. In
+     *       the waterfall, rows count from the top of the window. Not
+     *       drawn by the OpenGL backend.
+     */
+    uint32_t AddOverlay(XOverlay type, int32_t x0, int32_t y0, int32_t x1, int32_t y1,
+                        uint32_t rgb = 0x00FF00);
+    
+    /**
+     * @brief Move a marker
+     * @param id Overlay id from AddOverlay()
+     * @return false if the id is unknown
+     */
+    bool MoveOverlay(uint32_t id, int32_t x0, int32_t y0, int32_t x1, int32_t y1);
+    
+    /**
+     * @brief Remove a marker
+     * @param id Overlay id from AddOverlay()
+     * @return false if the id is unknown
+     */
+    bool RemoveOverlay(uint32_t id);
+    
+    /**
+     * @brief Remove all markers
+     */
+    void ClearOverlays();
+    
+    /**
+     * @brief Collect a histogram and statistics while converting
+     * @param enable true to enable (default off)
+     * 
+     * @note Counted from the rows the display conversion reads anyway, so
+     *       no extra pass over the frame. Covers the Show() frame or the
+     *       ShowLines() strip last converted; the OpenGL backend converts
+     *       on the GPU and does not update them.
+     */
+    void SetStatistics(bool enable);
+    
+    /**
+     * @brief Collect a second histogram over a region of interest
+     * @param x First column
+     * @param y First row (of the frame, or of the ShowLines() strip)
+     * @param width Columns (0 with height 0 = no ROI)
+     * @param height Rows
+     * @return false if only one of width and height is 0
+     */
+    bool SetStatisticsRoi(uint32_t x, uint32_t y, uint32_t width, uint32_t height);
+    
+    /**
+     * @brief Get statistics of the last converted image
+     * @param stats Whole image
+     * @param roi ROI, or nullptr
+     * @return false if nothing was counted yet
+     */
+    bool GetStatistics(XStatistics& stats, XStatistics* roi = nullptr);
+    
+    /**
+     * @brief Copy the last histogram
+     * @param bins Output, or nullptr to query the size
+     * @param count Bins the output holds
+     * @param roi true for the ROI histogram
+     * @return Bins in the histogram (2^depth, at most 65536)
+     */
+    uint32_t GetHistogram(uint32_t* bins, uint32_t count, bool roi = false);
+    
 private:
     class Impl;
     Impl* m_impl;
@@ -0,0 +1,150 @@
+// ============================================================================
+
+/**
+ * @file XStartup.h
+ * @brief XStartup class - Concurrent SDK startup with a timeline
+ * @version 2.1.0
+ */
+
+#ifndef XSTARTUP_H
+#define XSTARTUP_H
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace HX {
+
+class XAdaptor;
+class XFactory;
+class XFrame;
+
+/**
+ * @class XStartup
+ * @brief Runs the steps of a cold start side by side
+ *
+ * Only discovery needs the library loaded; calibration files, frame pools
+ * and the correction threads do not, so they are warmed while
+ * XFactory::Initialize() runs:
+ *
+ *   library      XFactory::Initialize()
+ *   discovery    XAdaptor::Open(), then LoadInventory() of the inventory
+ *                file if it exists, else Discover() and SaveInventory(),
+ *                so the next start skips the broadcast
+ *   calibration  each AddCalibration() file read into the page cache,
+ *                one thread per file, so the correction's own load does
+ *                not wait for the disk; a calibration container also has
+ *                its header and table of contents checked
+ *   pools        each AddFrame() XFrame::Prepare(), and the correction
+ *                threads started
+ *   tasks        AddTask() functions, after the library if they need it
+ *
+ *   XStartup startup(factory, adaptor);
+ *   startup.SetInventory("detectors.inv");
+ *   startup.AddCalibration("xog.cal");
+ *   startup.AddFrame(frame, 2048, 16);
+ *   if (!startup.Run()) ...
+ *
+ * A loaded inventory is checked against the network in the background
+ * after Run() returns (XAdaptor::LoadInventory(), event 102).
+ */
+class XStartup {
+public:
+    /**
+     * @brief One step of the timeline
+     */
+    struct Step {
+        std::string name;       ///< library, discovery, calibration:<file>, pool:<n>, threads or a task
+        uint64_t startUs;       ///< Since Run() was called
+        uint64_t durationUs;
+        bool ok;
+        std::string error;      ///< Why it failed, empty if ok
+
+        Step() : startUs(0), durationUs(0), ok(false) {}
+    };
+
+    /**
+     * @brief Create a startup for a factory and an adaptor
+     * @param factory Initialized by Run() unless it already is
+     * @param adaptor Bound to its adapter; opened by Run() unless it already is
+     *
+     * @note Both must outlive the XStartup
+     */
+    XStartup(XFactory& factory, XAdaptor& adaptor);
+    ~XStartup();
+
+    /**
+     * @brief Use a detector inventory instead of waiting for discovery
+     * @param file XAdaptor::SaveInventory() file; written after a
+     *        discovery when it does not exist yet
+     * @param timeout Time to check the inventory in the background (ms)
+     */
+    void SetInventory(const std::string& file, uint32_t timeout = 1000);
+
+    /**
+     * @brief Set discovery when there is no inventory
+     * @param timeout XAdaptor::Discover() timeout (ms, default 1000)
+     * @param expected Stop once this many detectors answered (0 = wait
+     *        for the timeout)
+     * @param allAdapters Discover on every adapter, or the bound one only
+     */
+    void SetDiscovery(uint32_t timeout = 1000, uint32_t expected = 0, bool allAdapters = true);
+
+    /**
+     * @brief Warm a calibration file
+     * @param file Calibration container, or any file its loader reads
+     */
+    void AddCalibration(const std::string& file);
+
+    /**
+     * @brief Allocate and fault in a frame pool (XFrame::Prepare())
+     * @param frame Frame configured with its lines and pool size
+     * @param width Pixels per line
+     * @param pixelDepth Bits per pixel
+     *
+     * @note frame must outlive Run()
+     */
+    void AddFrame(XFrame& frame, uint32_t width, uint8_t pixelDepth);
+
+    /**
+     * @brief Run an application step with the others
+     * @param name Timeline name
+     * @param task Returns false on failure
+     * @param needsLibrary Start it once the library is loaded
+     */
+    void AddTask(const std::string& name, const std::function<bool()>& task, bool needsLibrary = true);
+
+    /**
+     * @brief Run every step and wait for them
+     * @return true if every step succeeded
+     *
+     * @note Steps that need the library are skipped if it fails to load.
+     *       The timeline is logged once all steps are done.
+     */
+    bool Run();
+
+    /**
+     * @brief Get the timeline of the last Run()
+     * @return Steps in the order they started
+     */
+    std::vector<Step> GetTimeline() const;
+
+    /**
+     * @brief Get the time the last Run() took
+     * @return Microseconds from the start to the last step done
+     */
+    uint64_t GetStartupTime() const;
+
+private:
+    class Impl;
+    Impl* m_impl;
+
+    // Non-copyable
+    XStartup(const XStartup&) = delete;
+    XStartup& operator=(const XStartup&) = delete;
+};
+
+} // namespace HX
+
+#endif // XSTARTUP_H
@@ -0,0 +1,172 @@
+// ============================================================================
+
+/**
+ * @file XStreamFile.h
+ * @brief XStreamFile class - Continuous line-scan stream files
+ * @version 2.1.0
+ */
+
+#ifndef XSTREAMFILE_H
+#define XSTREAMFILE_H
+
+#include <cstdint>
+#include <string>
+
+namespace HX {
+
+class XImage;
+
+/**
+ * @class XStreamFile
+ * @brief Append-only container for scans of any length
+ *
+ * Lines are written in large chunks; each chunk header records the
+ * stream position of its first line, the lineId range and the timestamps
+ * of its first and last line. Close() appends an index of all chunks, so
+ * a reader finds any line range or time with a binary search and reads
+ * only the chunks it needs. A file whose writer never reached Close() is
+ * still readable: Open() rebuilds the index by walking the chunk headers.
+ *
+ * Values are stored in native byte order. An instance either writes
+ * (Create) or reads (Open); it is not thread-safe.
+ */
+class XStreamFile {
+public:
+    /**
+     * @brief Description of one chunk
+     */
+    struct ChunkInfo {
+        uint64_t firstLine;     ///< Stream position of the first line
+        uint32_t lineCount;     ///< Lines in the chunk
+        uint32_t firstLineId;   ///< Detector lineId of the first line
+        uint32_t lastLineId;    ///< Detector lineId of the last line
+        uint64_t firstTime;     ///< Timestamp of the first line (us)
+        uint64_t lastTime;      ///< Timestamp of the latest timed line (us)
+    };
+
+    XStreamFile();
+    ~XStreamFile();
+
+    /**
+     * @brief Create a stream file for writing
+     * @param file File path (replaced if it exists)
+     * @param width Pixels per line
+     * @param pixelDepth Bits per pixel
+     * @param chunkLines Lines per chunk (0 = about 4 MB per chunk)
+     * @return true on success
+     */
+    bool Create(const std::string& file, uint32_t width, uint8_t pixelDepth,
+                uint32_t chunkLines = 0);
+
+    /**
+     * @brief Append consecutive lines
+     * @param data First line
+     * @param count Number of lines
+     * @param stride Bytes between line starts (0 = packed lines)
+     * @param firstLineId Detector lineId of the first line; the following
+     *                    lines are taken to be firstLineId + 1, + 2, ...
+     * @param timestampUs Acquisition time of the first line in
+     *                    microseconds (0 = now, wall clock)
+     * @return true on success
+     */
+    bool AppendLines(const uint8_t* data, uint32_t count, uint32_t stride,
+                     uint32_t firstLineId, uint64_t timestampUs = 0);
+
+    /**
+     * @brief Append all rows of an image (frame or OnLinesReady strip)
+     * @param image Rows to append; width and depth must match Create()
+     * @param firstLineId Detector lineId of the first row
+     * @param timestampUs Acquisition time of the first row (0 = now)
+     * @return true on success
+     */
+    bool Append(const XImage* image, uint32_t firstLineId, uint64_t timestampUs = 0);
+
+    /**
+     * @brief Write the lines collected so far as a chunk
+     * @return true on success
+     *
+     * @note Call at natural breaks (end of object); a crash after Flush()
+     *       loses no lines that were flushed
+     */
+    bool Flush();
+
+    /**
+     * @brief Finish writing (index and trailer) or release a read file
+     * @return true on success
+     */
+    bool Close();
+
+    /**
+     * @brief Open a stream file for reading
+     * @param file File path
+     * @return true on success
+     */
+    bool Open(const std::string& file);
+
+    /**
+     * @brief Get pixels per line
+     */
+    uint32_t GetWidth() const;
+
+    /**
+     * @brief Get bits per pixel
+     */
+    uint8_t GetPixelDepth() const;
+
+    /**
+     * @brief Get number of lines in the stream
+     */
+    uint64_t GetLineCount() const;
+
+    /**
+     * @brief Get number of chunks in the stream
+     */
+    uint32_t GetChunkCount() const;
+
+    /**
+     * @brief Get a chunk description
+     * @param index Chunk index
+     * @param info Output description
+     * @return true on success, false if index is out of range
+     */
+    bool GetChunkInfo(uint32_t index, ChunkInfo& info) const;
+
+    /**
+     * @brief Read a line range
+     * @param firstLine Stream position of the first line
+     * @param count Number of lines (clipped to the end of the stream)
+     * @param image Output; reallocated if its size does not match
+     * @return true on success
+     *
+     * @note Only the chunks overlapping the range are read
+     */
+    bool ReadLines(uint64_t firstLine, uint32_t count, XImage* image);
+
+    /**
+     * @brief Find the first line acquired at or after a time
+     * @param timestampUs Time in microseconds
+     * @return Stream position, GetLineCount() if every line is older
+     *
+     * @note Lines appended by one AppendLines() call share its timestamp;
+     *       between calls the position is interpolated linearly
+     */
+    uint64_t FindTime(uint64_t timestampUs) const;
+
+    /**
+     * @brief Check every chunk's CRC
+     * @return true if all chunks are intact
+     */
+    bool Verify();
+
+private:
+    class Impl;
+    Impl* m_impl;
+
+    // Non-copyable
+    XStreamFile(const XStreamFile&) = delete;
+    XStreamFile& operator=(const XStreamFile&) = delete;
+};
+
+} // namespace HX
+
+#endif // XSTREAMFILE_H
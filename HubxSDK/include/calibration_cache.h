@@ -0,0 +1,132 @@
+// ============================================================================
+// calibration_cache.h
+// ============================================================================
+
+/**
+ * @file calibration_cache.h
+ * @brief Calibration sets kept resident per detector operating point - C API
+ * @version 2.1.0
+ *
+ * Entries are whatever the loader callback returns, typically correction
+ * handles already loaded from their calibration files. Switching back to
+ * a known operating point is a lookup instead of a file reload.
+ */
+
+#ifndef CALIBRATION_CACHE_H
+#define CALIBRATION_CACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Detector operating point a calibration set belongs to
+ *
+ * The fields map to XControl reads: XCU_SN, XINT_TIME, XDM_GAIN, XHL_MODE
+ * and XBIN.
+ */
+typedef struct hubx_operating_point_t {
+    const char* serial;             ///< Detector serial number (XCU_SN), may be NULL
+    uint32_t integrationTime;       ///< XINT_TIME in microseconds
+    uint32_t gain;                  ///< XDM_GAIN
+    uint32_t energyMode;            ///< XHL_MODE
+    uint32_t binning;               ///< XBIN
+} hubx_operating_point_t;
+
+/**
+ * @brief Cache counters
+ */
+typedef struct hubx_calib_cache_stats_t {
+    uint64_t hits;                  ///< Acquires served from memory
+    uint64_t misses;                ///< Acquires that had to load
+    uint64_t prefetches;            ///< Loads started by prefetch
+    uint64_t evictions;             ///< Entries freed to stay within budget
+    uint64_t loadFailures;          ///< Loader calls that returned NULL
+    uint32_t entries;               ///< Resident entries
+    uint64_t bytes;                 ///< Resident bytes, as reported by the loader
+} hubx_calib_cache_stats_t;
+
+/**
+ * @brief Load the calibration set of an operating point
+ * @param point Operating point
+ * @param user User pointer given at cache creation
+ * @param bytes Output, memory held by the entry (used for the byte budget)
+ * @return Entry, or NULL on failure
+ * @note Called on the acquiring thread, or on the prefetch thread
+ */
+typedef void* (*hubx_calib_load_fn)(const hubx_operating_point_t* point, void* user, size_t* bytes);
+
+/**
+ * @brief Free an entry returned by the loader
+ */
+typedef void (*hubx_calib_free_fn)(void* entry, void* user);
+
+/**
+ * @brief Calibration cache; calls are thread-safe
+ *
+ * Functions returning int return 0 on success and a negative
+ * HUBX_ERROR_* code otherwise.
+ */
+typedef struct hubx_calib_cache_t hubx_calib_cache_t;
+
+/**
+ * @brief Create a calibration cache
+ * @param load Loader called on a miss or prefetch
+ * @param release Called for every entry the cache drops
+ * @param user Passed to both callbacks
+ * @return Handle, or NULL on invalid parameters or out of memory
+ */
+hubx_calib_cache_t* hubx_calib_cache_create(hubx_calib_load_fn load,
+                                            hubx_calib_free_fn release,
+                                            void* user);
+
+/**
+ * @brief Destroy a cache and free every entry, including ones still acquired
+ */
+void hubx_calib_cache_destroy(hubx_calib_cache_t* handle);
+
+/**
+ * @brief Set entry and byte budget (default 8 entries, no byte limit)
+ */
+int hubx_calib_cache_set_capacity(hubx_calib_cache_t* handle, int maxEntries, size_t maxBytes);
+
+/**
+ * @brief Get the calibration set of an operating point
+ * @return Entry, or NULL if loading failed; pass it to hubx_calib_cache_release()
+ * @note Entries in use are never evicted
+ */
+void* hubx_calib_cache_acquire(hubx_calib_cache_t* handle, const hubx_operating_point_t* point);
+
+/**
+ * @brief Release an acquired entry
+ */
+int hubx_calib_cache_release(hubx_calib_cache_t* handle, void* entry);
+
+/**
+ * @brief Load an operating point in the background
+ */
+int hubx_calib_cache_prefetch(hubx_calib_cache_t* handle, const hubx_operating_point_t* point);
+
+/**
+ * @brief Drop one operating point, e.g. after recalibrating it
+ */
+int hubx_calib_cache_evict(hubx_calib_cache_t* handle, const hubx_operating_point_t* point);
+
+/**
+ * @brief Drop every entry not currently acquired
+ */
+void hubx_calib_cache_clear(hubx_calib_cache_t* handle);
+
+/**
+ * @brief Get cache counters
+ */
+int hubx_calib_cache_get_stats(hubx_calib_cache_t* handle, hubx_calib_cache_stats_t* stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CALIBRATION_CACHE_H
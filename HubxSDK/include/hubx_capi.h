@@ -0,0 +1,177 @@
+// ============================================================================
+// hubx_capi.h
+// ============================================================================
+
+/**
+ * @file hubx_capi.h
+ * @brief Detector control and acquisition - C API for language bindings
+ * @version 2.1.0
+ *
+ * One hubx_device_t bundles an XDetector, its XControl command channel,
+ * an XGrabber and an XFrame buffer pool. Frames are delivered through a
+ * plain function pointer as a hubx_frame_t describing the pooled buffer
+ * itself; nothing is copied, and the buffer stays valid until it is given
+ * back with hubx_frame_release(). Used by HubxNet.cs.
+ *
+ * Functions returning int return 0 on success and a negative HUBX_ERROR_*
+ * code otherwise: -1 invalid parameter, -2 null pointer, -6 the device
+ * refused or did not answer, -7 frames are still held (see hubx_acq_stop()).
+ */
+
+#ifndef HUBX_CAPI_H
+#define HUBX_CAPI_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Detector and pipeline behind one handle
+ *
+ * Calls on one handle may come from any thread.
+ */
+typedef struct hubx_device_t hubx_device_t;
+
+/**
+ * @brief Where the detector is and what it delivers
+ */
+typedef struct hubx_detector_config_t {
+    const char* ip;                 ///< Detector IP address
+    uint16_t cmdPort;               ///< Command channel port
+    uint16_t imgPort;               ///< Image channel port
+    uint8_t mac[6];                 ///< Detector MAC address
+    const char* serial;             ///< Serial number, may be NULL
+    uint32_t pixelCount;            ///< Pixels per line
+    uint32_t moduleCount;           ///< Detector modules (DMs)
+    uint32_t pixelDepth;            ///< Bits per pixel
+} hubx_detector_config_t;
+
+/**
+ * @brief A frame in a pool buffer (fixed layout, mirrored by HubxNet.cs)
+ */
+typedef struct hubx_frame_t {
+    const void* data;               ///< First pixel; rows are stride bytes apart
+    void* token;                    ///< Pass to hubx_frame_release()
+    uint64_t sequence;              ///< Position in acquisition order
+    uint32_t width;                 ///< Pixels per row
+    uint32_t height;                ///< Rows
+    uint32_t stride;                ///< Bytes from one row to the next
+    uint32_t pixelDepth;            ///< Bits per pixel
+    uint32_t bytesPerPixel;         ///< Storage per pixel (2 up to 16 bits)
+    uint32_t reserved;
+} hubx_frame_t;
+
+/**
+ * @brief A frame is ready (receive thread)
+ * @param frame Frame description, valid during the call only; the pixels
+ *              stay valid until hubx_frame_release(frame->token)
+ * @param user User pointer of hubx_callbacks_t
+ * @note Must return quickly; every frame must be released exactly once,
+ *       from any thread, or the pool runs dry
+ */
+typedef void (*hubx_frame_fn)(const hubx_frame_t* frame, void* user);
+
+/// Error reported by the command or image channel
+typedef void (*hubx_error_fn)(uint32_t id, const char* message, void* user);
+
+/// Status event of the image channel
+typedef void (*hubx_event_fn)(uint32_t id, uint32_t data, void* user);
+
+/**
+ * @brief Callbacks of a device; any may be NULL
+ */
+typedef struct hubx_callbacks_t {
+    hubx_frame_fn frame;            ///< NULL: frames are released at once
+    hubx_error_fn error;
+    hubx_event_fn event;
+    void* user;
+} hubx_callbacks_t;
+
+/**
+ * @brief Acquisition settings, fixed for one hubx_acq_start()
+ */
+typedef struct hubx_acq_config_t {
+    uint32_t linesPerFrame;         ///< Lines assembled into one frame
+    uint32_t poolSize;              ///< Pool buffers, i.e. frames the caller may hold plus one (>= 2)
+    uint32_t segments;              ///< Module segments per line (1 = whole lines)
+    uint32_t lineHeader;            ///< Image packets carry the 8-byte line header (0/1)
+    uint32_t frames;                ///< Frames to grab (0 = until hubx_acq_stop())
+} hubx_acq_config_t;
+
+/**
+ * @brief Create a device handle; nothing is opened yet
+ * @return Handle, or NULL on invalid parameters or out of memory
+ */
+hubx_device_t* hubx_device_create(const hubx_detector_config_t* config);
+
+/**
+ * @brief Stop, close and destroy
+ * @note Waits for held frames to be released
+ */
+void hubx_device_destroy(hubx_device_t* handle);
+
+/**
+ * @brief Open the command channel
+ */
+int hubx_device_open(hubx_device_t* handle);
+
+/**
+ * @brief Stop acquisition and close the command channel
+ */
+void hubx_device_close(hubx_device_t* handle);
+
+/**
+ * @brief Read a parameter (XControl::XCode)
+ * @param index DM index (0xFF for all, 0 for none)
+ */
+int hubx_control_read(hubx_device_t* handle, int code, uint8_t index, uint64_t* value);
+
+/**
+ * @brief Write a parameter (XControl::XCode)
+ * @param index DM index (0xFF for all, 0 for none)
+ */
+int hubx_control_write(hubx_device_t* handle, int code, uint64_t value, uint8_t index);
+
+/**
+ * @brief Execute an operation (XINIT, XRESTORE, XSAVE, XFRAME_TR_GEN)
+ */
+int hubx_control_operate(hubx_device_t* handle, int code, uint64_t data);
+
+/**
+ * @brief Set the callbacks; must be called while not acquiring
+ */
+int hubx_acq_set_callbacks(hubx_device_t* handle, const hubx_callbacks_t* callbacks);
+
+/**
+ * @brief Open the image channel and start grabbing
+ */
+int hubx_acq_start(hubx_device_t* handle, const hubx_acq_config_t* config);
+
+/**
+ * @brief Stop delivering frames, then stop grabbing
+ * @param timeoutMs How long to wait for held frames to be released
+ * @return 0 once stopped; HUBX_ERROR_BUSY (-7) if frames are still held
+ *         after the timeout: no more are delivered, and a later call
+ *         finishes the stop once they are released
+ * @note Do not call from the frame callback
+ */
+int hubx_acq_stop(hubx_device_t* handle, uint32_t timeoutMs);
+
+/**
+ * @brief Give a frame's buffer back to the pool
+ * @param token hubx_frame_t::token of a delivered frame
+ */
+int hubx_frame_release(hubx_device_t* handle, void* token);
+
+/**
+ * @brief Pool buffers neither assembling nor held
+ */
+uint32_t hubx_acq_free_buffers(hubx_device_t* handle);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HUBX_CAPI_H
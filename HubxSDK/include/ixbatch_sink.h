@@ -0,0 +1,74 @@
+// ============================================================================
+
+/**
+ * @file ixbatch_sink.h
+ * @brief IXBatchSink interface - Inference batch callbacks
+ * @version 2.1.0
+ */
+
+#ifndef IXBATCH_SINK_H
+#define IXBATCH_SINK_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace HX {
+
+/**
+ * @brief Where one batch item came from
+ */
+struct XBatchItem {
+    uint64_t sequence;      ///< XFrameInfo::sequence of the frame
+    uint64_t hostNs;        ///< XFrameInfo::hostNs of the frame
+    uint32_t detectorId;    ///< XFrameInfo::detectorId of the frame
+    uint32_t x;             ///< Frame column of the item's first column
+    uint32_t y;             ///< Frame row of the item's first row
+    uint32_t width;         ///< Columns taken from the frame; the rest is 0
+    uint32_t height;        ///< Rows taken from the frame; the rest is 0
+    uint32_t reserved;
+};
+
+/**
+ * @brief One batch, an N x 1 x H x W tensor
+ *
+ * Items are height rows of width values, one after another; values are
+ * IEEE binary16 or float32 as set with XBatcher::SetOutputType().
+ */
+struct XBatch {
+    void*             data;         ///< count * itemBytes bytes, page aligned
+    const XBatchItem* items;        ///< count entries
+    uint32_t          buffer;       ///< Buffer index, 0..XBatcher::GetBufferCount()-1
+    uint32_t          count;        ///< Items filled: the batch size, or fewer when flushed
+    uint32_t          batchSize;    ///< Items the buffer holds
+    uint32_t          width;        ///< Values per item row
+    uint32_t          height;       ///< Rows per item
+    uint32_t          bytesPerValue;///< 2 (float16) or 4 (float32)
+    size_t            itemBytes;    ///< width * height * bytesPerValue
+    uint64_t          index;        ///< Batches handed off since Start(), from 0
+};
+
+/**
+ * @class IXBatchSink
+ * @brief Receives the batches of XBatcher
+ */
+class IXBatchSink {
+public:
+    virtual ~IXBatchSink() {}
+
+    /**
+     * @brief A batch is full, flushed or timed out
+     * @param batch Batch; its buffer stays valid until XBatcher::Release()
+     *
+     * @note Called on the batcher's hand-off thread, one batch at a time
+     *       and in order, so a call may block on the inference engine
+     *       without holding up OnFrameReady. Buffers are allocated once in
+     *       Start() and reused, so a runtime that registers host memory
+     *       (cudaHostRegister, CL_MEM_USE_HOST_PTR) can do it on the first
+     *       batch of each buffer index.
+     */
+    virtual void OnBatchReady(const XBatch& batch) = 0;
+};
+
+} // namespace HX
+
+#endif // IXBATCH_SINK_H
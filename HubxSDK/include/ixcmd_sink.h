@@ -14,6 +14,8 @@
 
 namespace HX {
 
+class XDetector;
+
 /**
  * @class IXCmdSink
  * @brief Abstract interface for command event callbacks
@@ -30,6 +32,10 @@ public:
      * @brief Error event callback
      * @param err_id Error code
      * @param err_msg_ Error message
+     * 
+     * @note Called from the SDK notifier thread, not the thread that hit
+     *       the error. Repeats of an id before it was delivered come as one
+     *       call, with " (repeated N times)" appended to the first message.
      */
     virtual void OnXError(uint32_t err_id, const char* err_msg_) = 0;
     
@@ -37,8 +43,41 @@ public:
      * @brief Event callback
      * @param event_id Event code
      * @param data Event data
+     * 
+     * @note Called from the SDK notifier thread, one call per event, in the
+     *       order they were raised. Stop()/Close() and SetSink() return once
+     *       the errors and events raised before them were delivered.
      */
     virtual void OnXEvent(uint32_t event_id, float data) = 0;
+
+    /**
+     * @brief Asynchronous command completion callback
+     * @param ticket Ticket returned by XControl::ReadAsync/WriteAsync
+     * @param result Same as the synchronous call (-1 on error or timeout)
+     * @param val Value read (0 for writes and failures)
+     *
+     * @note Called from the XControl receive thread; do not issue
+     *       synchronous commands from it
+     */
+    virtual void OnXComplete(uint32_t ticket, int32_t result, uint64_t val) {
+        (void)ticket;
+        (void)result;
+        (void)val;
+    }
+    
+    /**
+     * @brief Detector found by XAdaptor::Discover, or changed since the
+     *        inventory loaded by XAdaptor::LoadInventory
+     * @param det Detector, also available from XAdaptor::GetDetector
+     * @param adapterIP Local adapter it answered on
+     *
+     * @note Called from the thread running Discover(), or the background
+     *       check started by XAdaptor::LoadInventory, one at a time
+     */
+    virtual void OnXDetector(const XDetector& det, const char* adapterIP) {
+        (void)det;
+        (void)adapterIP;
+    }
 };
 
 } // namespace HX
@@ -34,6 +34,10 @@ public:
      * @brief Error event callback
      * @param err_id Error code
      * @param err_msg_ Error message
+     * 
+     * @note Called from the SDK notifier thread, not the thread that hit
+     *       the error. Repeats of an id before it was delivered come as one
+     *       call, with " (repeated N times)" appended to the first message.
      */
     virtual void OnXError(uint32_t err_id, const char* err_msg_) = 0;
     
@@ -41,6 +45,10 @@ public:
      * @brief Event callback
      * @param event_id Event code
      * @param data Event data
+     * 
+     * @note Called from the SDK notifier thread, one call per event, in the
+     *       order they were raised. Stop()/Close() and SetSink() return once
+     *       the errors and events raised before them were delivered.
      */
     virtual void OnXEvent(uint32_t event_id, uint32_t data) = 0;
     
@@ -49,8 +57,29 @@ public:
      * @param image_ Pointer to frame image data
      * 
      * @note This function should return quickly to avoid buffer overflow
+     * @note When the XFrame pool holds more than one buffer, the image stays
+     *       valid until it is returned with XFrame::Release()
+     * @note Sinks added with XFrame::AddSink() are called on a thread of
+     *       their own and do not release the image
+     * @note image_->_info holds the frame's sequence number, first line,
+     *       missing rows, first row time and flags (see XFrameInfo)
      */
     virtual void OnFrameReady(XImage* image_) = 0;
+    
+    /**
+     * @brief Lines ready callback (optional, see XFrame::SetStripLines)
+     * @param strip View of the rows inside the frame being assembled
+     * @param firstLine Row of the strip's first line within the frame
+     * @param count Number of rows in the strip
+     * 
+     * @note Zero-copy: the strip points into the frame buffer and is only
+     *       valid during the callback. Runs on the assembly thread.
+     */
+    virtual void OnLinesReady(const XImage* strip, uint32_t firstLine, uint32_t count) {
+        (void)strip;
+        (void)firstLine;
+        (void)count;
+    }
 };
 
 } // namespace HX
@@ -0,0 +1,43 @@
+// ============================================================================
+
+/**
+ * @file ixline_filter.h
+ * @brief IXLineFilter interface - Per-line processing during frame assembly
+ * @version 2.1.0
+ */
+
+#ifndef IXLINE_FILTER_H
+#define IXLINE_FILTER_H
+
+#include <cstdint>
+
+namespace HX {
+
+/**
+ * @class IXLineFilter
+ * @brief Abstract interface for processing lines as XFrame places them
+ * 
+ * Derive from this class to correct lines while they are still in cache,
+ * see XFrame::AddLineFilter().
+ */
+class IXLineFilter {
+public:
+    virtual ~IXLineFilter() {}
+    
+    /**
+     * @brief Process one line
+     * @param src Line as received
+     * @param dst Frame row to write; equals src when processing in place
+     * @param width Pixels in the line
+     * @param pixelDepth Bits per pixel
+     * @param row Frame row (line number since Start() with overlapping frames)
+     * 
+     * @note Runs on the assembly thread. Must write every pixel of dst.
+     */
+    virtual void OnLine(const uint8_t* src, uint8_t* dst, uint32_t width,
+                        uint8_t pixelDepth, uint32_t row) = 0;
+};
+
+} // namespace HX
+
+#endif // IXLINE_FILTER_H
@@ -0,0 +1,39 @@
+// ============================================================================
+
+/**
+ * @file ixlog_sink.h
+ * @brief IXLogSink interface - SDK log output
+ * @version 2.1.0
+ */
+
+#ifndef IXLOG_SINK_H
+#define IXLOG_SINK_H
+
+#include <cstdint>
+
+namespace HX {
+
+/**
+ * @class IXLogSink
+ * @brief Receives the SDK log instead of the console
+ *
+ * Install with XFactory::SetLogSink(). SDK threads only queue their
+ * messages; the sink is called from the SDK's log thread, one message at
+ * a time, so a slow sink delays the log and never acquisition.
+ */
+class IXLogSink {
+public:
+    virtual ~IXLogSink() {}
+
+    /**
+     * @brief Log message callback
+     * @param level XFactory::LogLevel of the message
+     * @param component Reporting class, e.g. "XGrabber"
+     * @param message Text without the "[component]" prefix or a newline
+     */
+    virtual void OnXLog(uint32_t level, const char* component, const char* message) = 0;
+};
+
+} // namespace HX
+
+#endif // IXLOG_SINK_H
@@ -12,6 +12,8 @@
 
 namespace HX {
 
+class IXLogSink;
+
 /**
  * @class XFactory
  * @brief Manages system resources and initialization
@@ -24,12 +26,298 @@ namespace HX {
  */
 class XFactory {
 public:
+    /**
+     * @brief SDK thread roles that accept a scheduling policy
+     */
+    enum ThreadRole {
+        THREAD_RECEIVE = 0,     ///< XGrabber packet receive threads
+        THREAD_ASSEMBLY,        ///< XGrabber line assembly thread
+        THREAD_HEARTBEAT,       ///< XControl heartbeat and command receive threads
+        THREAD_CORRECTION,      ///< Shared correction worker pool
+        THREAD_RECORDER,        ///< XRecorder disk writer thread
+        THREAD_SERVICE,         ///< Shared service loop (SetServiceThreads)
+        THREAD_ROLE_COUNT
+    };
+    
+    /**
+     * @brief Scheduling policy applied when a thread of a role starts
+     */
+    struct ThreadPolicy {
+        uint64_t cpuMask;       ///< Bit n = may run on CPU n, 0 = OS default
+        bool     realtime;      ///< SCHED_FIFO / THREAD_PRIORITY_TIME_CRITICAL
+        int32_t  priority;      ///< SCHED_FIFO priority (1-99, Linux only)
+        
+        ThreadPolicy() : cpuMask(0), realtime(false), priority(50) {}
+    };
+    
+    /**
+     * @brief Priority of parallel work submitted by a thread
+     */
+    enum TaskPriority {
+        TASK_HIGH = 0,          ///< Live acquisition path
+        TASK_NORMAL,            ///< Default
+        TASK_LOW,               ///< Batch reprocessing, background work
+        TASK_PRIORITY_COUNT
+    };
+    
+    /**
+     * @brief Shared scheduler that runs all data-parallel SDK work
+     */
+    struct SchedulerConfig {
+        uint32_t threads;       ///< Threads per job including the caller (0 = one per
+                                ///< CPU of cpuMask, else per hardware thread)
+        uint64_t cpuMask;       ///< Core set: worker n is pinned to the n-th CPU of the
+                                ///< mask (0 = THREAD_CORRECTION affinity, not pinned)
+        bool     numaAware;     ///< Idle workers steal from their own NUMA node first
+        uint32_t bandPixels;    ///< Largest row band, so a band's rows stay in cache
+                                ///< (0 = one band per thread, the default; else >= 64K)
+        
+        SchedulerConfig() : threads(0), cpuMask(0), numaAware(true), bandPixels(0) {}
+    };
+    
+    /**
+     * @brief How much work the pipeline sheds to keep up
+     */
+    enum OverloadLevel {
+        OVERLOAD_NONE = 0,      ///< Everything runs
+        OVERLOAD_PREVIEW,       ///< XShow and XPreviewServer drop frames
+        OVERLOAD_OPTIONAL,      ///< Optional stages are skipped (fusion median, adaptive fusion)
+        OVERLOAD_FRAMES,        ///< XFrame drops whole frames before delivery
+        OVERLOAD_LEVEL_COUNT
+    };
+    
+    /**
+     * @brief Backlog thresholds of the overload levels
+     *
+     * The backlog is the fullest of every XGrabber receive ring (packets
+     * waiting for assembly) and every XFrame pool (buffers still held by
+     * the sink), 0 to 1. A level is entered when the backlog reaches its
+     * threshold and left once it is hysteresis below it.
+     */
+    struct OverloadPolicy {
+        bool  enabled;          ///< false: nothing is shed (default)
+        float previewAt;        ///< OVERLOAD_PREVIEW from this backlog
+        float optionalAt;       ///< OVERLOAD_OPTIONAL from this backlog
+        float framesAt;         ///< OVERLOAD_FRAMES from this backlog
+        float hysteresis;
+        
+        OverloadPolicy()
+            : enabled(false), previewAt(0.5f), optionalAt(0.7f), framesAt(0.85f), hysteresis(0.1f) {}
+    };
+    
+    /**
+     * @brief Overload state and shed work since ResetOverloadStats()
+     */
+    struct OverloadStats {
+        OverloadLevel level;
+        float    backlog;           ///< Current backlog, 0 to 1
+        float    peakBacklog;
+        uint64_t levelChanges;
+        uint64_t previewDropped;    ///< Frames XShow/XPreviewServer did not take
+        uint64_t stagesSkipped;     ///< Optional stages skipped, one per stage and frame
+        uint64_t framesDropped;     ///< Whole frames XFrame did not deliver
+        
+        OverloadStats()
+            : level(OVERLOAD_NONE), backlog(0), peakBacklog(0), levelChanges(0),
+              previewDropped(0), stagesSkipped(0), framesDropped(0) {}
+    };
+    
+    /// Huge page sizes accepted by AllocOptions::pageSize
+    static const uint32_t PAGE_2MB = 2u * 1024 * 1024;
+    static const uint32_t PAGE_1GB = 1024u * 1024 * 1024;
+    
+    /**
+     * @brief Placement options for AllocateEx()
+     */
+    struct AllocOptions {
+        int32_t  numaNode;      ///< NUMA node to bind pages to (-1 = first touch)
+        uint32_t pageSize;      ///< 0, PAGE_2MB or PAGE_1GB
+        bool     prefault;      ///< Touch every page before returning
+        bool     lock;          ///< Pin the pages in RAM (mlock / VirtualLock), for device DMA
+        
+        AllocOptions() : numaNode(-1), pageSize(0), prefault(false), lock(false) {}
+    };
+    
+    /**
+     * @brief Stages timed by latency tracing
+     *
+     * Times come from a monotonic clock; a line is stamped when its receive
+     * call returns.
+     */
+    enum TraceStage {
+        TRACE_RING = 0,         ///< Line received -> taken off the XGrabber ring
+        TRACE_LINE,             ///< Taken off the ring -> placed in XFrame
+        TRACE_ASSEMBLY,         ///< First line of a frame received -> last line received
+        TRACE_END_TO_END,       ///< Last line of a frame received -> OnFrameReady called
+        TRACE_SINK,             ///< Time spent in OnFrameReady
+        TRACE_CORRECT_OG,       ///< hubx_xog_apply
+        TRACE_CORRECT_MOG,      ///< hubx_xmog_apply
+        TRACE_CORRECT_PIPELINE, ///< hubx_pipeline_run (all stages)
+        TRACE_STAGE_COUNT
+    };
+    
+    /**
+     * @brief Latency distribution of one trace stage
+     *
+     * Percentiles come from a log-linear histogram and are within 1/16
+     * (about 6%) of the exact value.
+     */
+    struct TraceStats {
+        uint64_t count;         ///< Samples
+        uint64_t meanNs;
+        uint64_t p50Ns;
+        uint64_t p99Ns;
+        uint64_t p999Ns;        ///< 99.9th percentile
+        uint64_t maxNs;
+        
+        TraceStats() : count(0), meanNs(0), p50Ns(0), p99Ns(0), p999Ns(0), maxNs(0) {}
+    };
+    
+    /**
+     * @brief Subsystems memory profiling attributes buffers to
+     */
+    enum MemoryTag {
+        MEM_FRAME_POOL = 0,     ///< XFrame frame buffers, reorder and window rows
+        MEM_RECEIVE,            ///< XGrabber receive rings and queues
+        MEM_CALIBRATION,        ///< Correction tables and calibration frames
+        MEM_DISPLAY,            ///< XShow and XPreviewServer buffers
+        MEM_RECORDER,           ///< XRecorder queue, XFlightRecorder ring
+        MEM_IMAGE,              ///< Other XImage pixel buffers
+        MEM_OTHER,              ///< Other Allocate()/AllocateEx() blocks
+        MEM_TAG_COUNT
+    };
+    
+    /**
+     * @brief Memory held under one tag
+     *
+     * Counters and rates cover the time since profiling was enabled or
+     * ResetMemoryStats(); live bytes are buffers charged in that time and
+     * not yet freed.
+     */
+    struct MemoryStats {
+        uint64_t liveBytes;
+        uint64_t highWaterBytes;    ///< Largest liveBytes seen
+        uint64_t allocations;       ///< Allocations and growths
+        uint64_t allocatedBytes;    ///< Bytes allocated, freed or not
+        double allocationsPerSecond;
+        double bytesPerSecond;
+        
+        MemoryStats()
+            : liveBytes(0), highWaterBytes(0), allocations(0), allocatedBytes(0),
+              allocationsPerSecond(0), bytesPerSecond(0) {}
+    };
+    
+    /**
+     * @brief Memory budget state; counters cover the time since
+     *        SetMemoryBudget()
+     */
+    struct MemoryBudgetStats {
+        uint64_t limitBytes;        ///< 0 = no budget
+        uint64_t usedBytes;         ///< Bytes held under every tag
+        uint64_t peakBytes;         ///< Largest usedBytes seen
+        uint64_t reclaims;          ///< Times optional caches were shrunk
+        uint64_t reclaimedBytes;    ///< Bytes they gave up
+        uint64_t rejected;          ///< Starts refused because buffers did not fit
+        
+        MemoryBudgetStats()
+            : limitBytes(0), usedBytes(0), peakBytes(0), reclaims(0), reclaimedBytes(0),
+              rejected(0) {}
+    };
+    
+    /**
+     * @brief Code regions measured by hardware performance counters
+     *
+     * Counts are exclusive: a region nested in another (the sink inside
+     * frame assembly) is subtracted from the outer one.
+     */
+    enum PerfStage {
+        PERF_FRAME_ASSEMBLY = 0, ///< Placing one line in XFrame, frame completion included
+        PERF_SINK,              ///< OnFrameReady
+        PERF_CORRECT_OG,        ///< hubx_xog_apply
+        PERF_CORRECT_MOG,       ///< hubx_xmog_apply
+        PERF_CORRECT_PIPELINE,  ///< hubx_pipeline_run (all stages)
+        PERF_STAGE_COUNT
+    };
+    
+    /**
+     * @brief Hardware counter totals of one perf stage (user space only)
+     *
+     * A counter the CPU or hypervisor does not provide stays 0.
+     */
+    struct PerfStats {
+        uint64_t samples;       ///< Regions measured
+        uint64_t cycles;
+        uint64_t instructions;
+        uint64_t llcMisses;     ///< Last-level cache misses
+        
+        PerfStats() : samples(0), cycles(0), instructions(0), llcMisses(0) {}
+    };
+    
+    /**
+     * @brief Severity of SDK log messages
+     */
+    enum LogLevel {
+        LOG_DEBUG = 0,          ///< Per-frame and per-thread detail
+        LOG_INFO,               ///< Open/close, start/stop (default threshold)
+        LOG_WARNING,            ///< Degraded operation, e.g. a policy not applied
+        LOG_ERROR,              ///< Errors, also reported to the component's sink
+        LOG_OFF                 ///< SetLogLevel() only: log nothing
+    };
+    
+    /**
+     * @brief Instruction sets the SDK has kernels for (bit mask)
+     *
+     * CPU_AVX2 includes FMA; CPU_AVX512 is AVX-512 F and BW.
+     */
+    enum CpuFeature {
+        CPU_SSE42   = 1u << 0,
+        CPU_AVX2    = 1u << 1,
+        CPU_AVX512  = 1u << 2,
+        CPU_NEON    = 1u << 3,
+        CPU_ALL     = 0xFu
+    };
+    
+    /**
+     * @brief Pipeline settings tuned for one host, e.g. by hx_ratebench --tune
+     *
+     * Zero fields keep the built-in default. The acquisition settings are
+     * defaults for objects created afterwards; calls on an object still
+     * override them.
+     */
+    struct HostProfile {
+        uint32_t ringDepth;         ///< XGrabber::SetRingDepth() default (built-in 4096)
+        uint32_t batchSize;         ///< XGrabber::SetBatchSize() default (built-in 32)
+        uint32_t poolSize;          ///< XFrame pool for AddSink() sinks when SetPoolSize()
+                                    ///< was not called (built-in: Start() fails)
+        uint32_t correctionThreads; ///< SetCorrectionThreads()
+        uint32_t bandPixels;        ///< SchedulerConfig::bandPixels
+        uint32_t cpuFeatureMask;    ///< SetCpuFeatureMask() (CPU_ALL = no restriction)
+        double   lineRate;          ///< Loss-free lines/s measured with it, for reference
+        
+        HostProfile()
+            : ringDepth(0), batchSize(0), poolSize(0), correctionThreads(0), bandPixels(0),
+              cpuFeatureMask(CPU_ALL), lineRate(0.0) {}
+    };
+    
+    /**
+     * @brief Text formats of GetMetrics()
+     */
+    enum MetricsFormat {
+        METRICS_PROMETHEUS = 0, ///< Prometheus text exposition format 0.0.4
+        METRICS_JSON            ///< {"metrics":[{"name","type","help","samples":[...]}]}
+    };
+    
     XFactory();
     ~XFactory();
     
     /**
      * @brief Initialize the factory and xlibdll proxy
      * @return true on success
+     * 
+     * @note Loads the host profile named by the HUBX_PROFILE environment
+     *       variable, else hubx_profile.conf in the working directory, if
+     *       the file exists (see LoadHostProfile()); an empty HUBX_PROFILE
+     *       loads none. A profile that cannot be read is logged and skipped.
      */
     bool Initialize();
     
@@ -47,15 +335,59 @@ public:
      * @brief Allocate memory with tracking
      * @param size Size in bytes
      * @return Pointer to allocated memory, or nullptr on failure
+     * 
+     * @note Blocks come from power-of-two size-class pools with a cache per
+     *       thread; freed blocks are reused rather than returned to the OS
      */
     void* Allocate(size_t size);
     
+    /**
+     * @brief Allocate memory on a NUMA node and/or huge pages
+     * @param size Size in bytes
+     * @param options Placement options
+     * @return Pointer to allocated memory, or nullptr on failure
+     * 
+     * @note Maps its own pages (MAP_HUGETLB / VirtualAlloc MEM_LARGE_PAGES);
+     *       without reserved huge pages it falls back to transparent huge
+     *       pages on Linux and 4 KB pages on Windows. The block starts on
+     *       a page boundary and takes size rounded up to whole pages.
+     *       Release with Free(). Intended for long-lived buffers such as
+     *       XFrame pools.
+     * @note Locked pages count against RLIMIT_MEMLOCK (the working set on
+     *       Windows); if they cannot be locked the block is still returned
+     *       and a warning logged.
+     */
+    void* AllocateEx(size_t size, const AllocOptions& options);
+    
     /**
      * @brief Free allocated memory
-     * @param ptr Pointer to memory
+     * @param ptr Pointer returned by Allocate() or AllocateEx() (any thread)
      */
     void Free(void* ptr);
     
+    /**
+     * @brief Record every Nth allocation in the leak-tracking map
+     * @param rate Sample rate (1 = every block, 0 = counters only, default 64)
+     * 
+     * @note Byte and block counters always cover every allocation
+     */
+    void SetTrackingSampleRate(uint32_t rate);
+    
+    /**
+     * @brief Get leak-tracking sample rate
+     */
+    uint32_t GetTrackingSampleRate() const;
+    
+    /**
+     * @brief Release pooled blocks back to the OS
+     * @return Bytes released
+     *
+     * @note Covers the shared free lists and the calling thread's cache.
+     *       Other threads cache only blocks of 1 MB or less, and hand
+     *       them to the shared lists when they exit.
+     */
+    static uint64_t TrimMemory();
+    
     /**
      * @brief Get total allocated memory
      */
@@ -101,6 +433,387 @@ public:
      */
     static void DestroyGlobalInstance();
     
+    /**
+     * @brief Set the scheduling policy for an SDK thread role
+     * @param role Thread role
+     * @param policy Affinity mask and priority
+     * @return false if role is invalid
+     * @note Process-wide. Takes effect the next time a thread of the role
+     *       starts (XGrabber::Grab, XControl::EnableHeartbeat,
+     *       XRecorder::Start). Real-time
+     *       scheduling needs CAP_SYS_NICE on Linux; failures are logged
+     *       and the thread keeps running with default scheduling.
+     */
+    static bool SetThreadPolicy(ThreadRole role, const ThreadPolicy& policy);
+    
+    /**
+     * @brief Get the configured scheduling policy for a role
+     */
+    static ThreadPolicy GetThreadPolicy(ThreadRole role);
+    
+    /**
+     * @brief Get the affinity in effect for the most recently started thread of a role
+     * @return CPU mask reported by the OS, 0 if no thread of the role has run
+     */
+    static uint64_t GetEffectiveAffinity(ThreadRole role);
+    
+    /**
+     * @brief Check if the most recently started thread of a role runs real-time
+     */
+    static bool IsRealtimeActive(ThreadRole role);
+    
+    /**
+     * @brief Set threads the correction modules split full frames across
+     * @param count Threads including the caller (0 = one per hardware
+     *              thread, the default; 1 = single-threaded)
+     * @note Process-wide. Frames are cut into fixed row bands, so output
+     *       does not depend on the thread count or scheduling. Pool
+     *       threads use the THREAD_CORRECTION policy.
+     */
+    static void SetCorrectionThreads(uint32_t count);
+    
+    /**
+     * @brief Get threads used per correction call
+     */
+    static uint32_t GetCorrectionThreads();
+    
+    /**
+     * @brief Configure the shared work-stealing scheduler
+     * @param config Thread count, core set and NUMA awareness
+     * @note Process-wide. Corrections, XMOG, fusion, batch reprocessing,
+     *       XFile encoding and display scaling are all split into jobs on
+     *       this one set of workers, so concurrent detectors share cores
+     *       instead of each adding threads. Waits for running jobs;
+     *       SetCorrectionThreads() sets config.threads only.
+     */
+    static void SetScheduler(const SchedulerConfig& config);
+    
+    /**
+     * @brief Get the scheduler configuration
+     */
+    static SchedulerConfig GetScheduler();
+    
+    /**
+     * @brief Set the priority of SDK work the calling thread submits
+     * @param priority TASK_HIGH for the live path, TASK_LOW for batch jobs
+     * @note Per thread, TASK_NORMAL by default. Idle workers take queued
+     *       work of higher priority first; work already running is not
+     *       preempted. Nested work inherits the priority of its job.
+     */
+    static void SetTaskPriority(TaskPriority priority);
+    
+    /**
+     * @brief Get the calling thread's task priority
+     */
+    static TaskPriority GetTaskPriority();
+    
+    /**
+     * @brief Shed work in a fixed order when processing falls behind
+     * @param policy Thresholds; 0 < previewAt <= optionalAt <= framesAt <= 1
+     * @return false if the thresholds are out of order
+     * @note Process-wide. Without a policy an overloaded pipeline loses
+     *       lines wherever a buffer overflows first, typically the
+     *       socket. With one, previews go first, then the optional
+     *       stages, then whole frames (XFrame event 118), so the frames
+     *       that are delivered stay complete. Every decision is counted
+     *       in GetOverloadStats() and the hubx_overload_* metrics.
+     */
+    static bool SetOverloadPolicy(const OverloadPolicy& policy);
+    
+    /**
+     * @brief Get the overload policy
+     */
+    static OverloadPolicy GetOverloadPolicy();
+    
+    /**
+     * @brief Get the overload level and the work shed so far
+     */
+    static void GetOverloadStats(OverloadStats& stats);
+    
+    /**
+     * @brief Reset the shed counters and the peak backlog
+     */
+    static void ResetOverloadStats();
+    
+    /**
+     * @brief Service all detectors of the process from a fixed set of threads
+     * @param count Loop threads (0 = off, the default: every XControl runs
+     *              its own command receive and heartbeat thread, every
+     *              XGrabber its own assembly thread)
+     * @return false if count is 0 while objects still run on the loop
+     * @note Process-wide. Applies to XControl objects opened and XGrabber
+     *       acquisitions started afterwards; packet receive keeps one
+     *       thread per grabber, and zero-copy and multi-queue grabbers
+     *       assemble on their receive threads as before. Loop threads use
+     *       the THREAD_SERVICE policy.
+     */
+    static bool SetServiceThreads(uint32_t count);
+    
+    /**
+     * @brief Get service loop threads (0 = off)
+     */
+    static uint32_t GetServiceThreads();
+    
+    /**
+     * @brief Enable latency tracing
+     * @note Process-wide, off by default. While off each trace point costs
+     *       one relaxed load. Samples accumulate until ResetTraceStats().
+     */
+    static void SetTracing(bool enable);
+    
+    /**
+     * @brief Check if latency tracing is enabled
+     */
+    static bool GetTracing();
+    
+    /**
+     * @brief Get the latency distribution of a stage
+     * @return false if stage is invalid
+     */
+    static bool GetTraceStats(TraceStage stage, TraceStats& stats);
+    
+    /**
+     * @brief Clear the latency distributions of all stages
+     */
+    static void ResetTraceStats();
+    
+    /**
+     * @brief Keep individual trace events for WriteTraceCapture()
+     * @param events Capacity; once full the oldest events are overwritten
+     * @return false if events is 0 or the buffer cannot be allocated
+     * @note Also enables tracing. Restarting discards the current capture.
+     */
+    static bool StartTraceCapture(uint32_t events);
+    
+    /**
+     * @brief Stop keeping trace events (the capture stays readable)
+     */
+    static void StopTraceCapture();
+    
+    /**
+     * @brief Write the captured events as a Chrome trace
+     * @param file JSON output, opened by chrome://tracing or ui.perfetto.dev
+     * @return false if nothing was captured or the file cannot be written
+     * @note Threads are named after their XFactory thread role
+     */
+    static bool WriteTraceCapture(const std::string& file);
+    
+    /**
+     * @brief Read every SDK metric
+     * @param format Prometheus text or JSON
+     * @return Current values of all open XGrabber, XControl, XFrame and
+     *         XFactory instances, and the trace percentiles while tracing
+     *
+     * @note Process-wide. Names start with hubx_; instances are told apart
+     *       by a detector label (IP address) or an instance number label.
+     */
+    static std::string GetMetrics(MetricsFormat format = METRICS_PROMETHEUS);
+    
+    /**
+     * @brief Read one metric
+     * @param name Metric name, e.g. hubx_grabber_packets_lost_total
+     * @param value Summed over all label sets (histograms: sample count)
+     * @return false if no instance publishes the metric
+     */
+    static bool GetMetric(const std::string& name, double& value);
+    
+    /**
+     * @brief Serve the metrics over HTTP
+     * @param port TCP port (0 = any free port, see GetMetricsPort())
+     * @return true on success
+     *
+     * @note GET /metrics answers in Prometheus text, GET /metrics.json in
+     *       JSON. Requests are answered one at a time on a server thread.
+     */
+    static bool StartMetricsServer(uint16_t port);
+    
+    /**
+     * @brief Stop the metrics HTTP server
+     */
+    static void StopMetricsServer();
+    
+    /**
+     * @brief Get the metrics server port
+     * @return Port, 0 if not running
+     */
+    static uint16_t GetMetricsPort();
+    
+    /**
+     * @brief Set the lowest level that is logged
+     * @param level LOG_DEBUG .. LOG_OFF (default LOG_INFO)
+     * @note Process-wide. Messages below the level cost one relaxed load.
+     */
+    static void SetLogLevel(LogLevel level);
+    
+    /**
+     * @brief Get the lowest level that is logged
+     */
+    static LogLevel GetLogLevel();
+    
+    /**
+     * @brief Send the SDK log to a sink instead of stdout/stderr
+     * @param sink Callback handler (nullptr = console, the default)
+     * @note Messages are queued by the SDK threads and passed on by a log
+     *       thread; FlushLog() waits for them. The sink must stay valid
+     *       until it is replaced.
+     */
+    static void SetLogSink(IXLogSink* sink);
+    
+    /**
+     * @brief Limit how often one message is logged
+     * @param perSecond Messages per second from one call site or error id
+     *                  (0 = no limit, default 20)
+     * @note The first message after a suppressed burst carries the count
+     *       of messages dropped
+     */
+    static void SetLogRateLimit(uint32_t perSecond);
+    
+    /**
+     * @brief Wait until every queued log message has been written
+     */
+    static void FlushLog();
+    
+    /**
+     * @brief Get messages dropped because the log queue was full
+     */
+    static uint64_t GetLogDropped();
+    
+    /**
+     * @brief Attribute SDK buffers to subsystems (off by default)
+     * @note Process-wide, covers XImage pixels, Allocate() blocks and the
+     *       correction, display and recorder tables. Enabling starts a new
+     *       measurement window; buffers allocated while off are not counted.
+     */
+    static void SetMemoryProfiling(bool enable);
+    
+    /**
+     * @brief Check whether memory profiling is on
+     */
+    static bool GetMemoryProfiling();
+    
+    /**
+     * @brief Get the memory held under one tag
+     * @return false if tag is out of range
+     */
+    static bool GetMemoryStats(MemoryTag tag, MemoryStats& stats);
+    
+    /**
+     * @brief Restart counters, rates and high-water marks at the live bytes
+     */
+    static void ResetMemoryStats();
+    
+    /**
+     * @brief Limit the bytes SDK buffers hold across the process
+     * @param bytes Budget (0 = none, the default)
+     * @param reclaimAt Share of the budget from which optional caches are
+     *                  shrunk, 0 < reclaimAt <= 1 (default 0.9)
+     * @return false if reclaimAt is out of range
+     * @note Counts what memory profiling counts, which stays on while a
+     *       budget is set; buffers allocated before are not counted, so
+     *       set it before the first Start(). Past reclaimAt a background
+     *       thread shrinks the optional caches: XPreviewServer copies (it
+     *       skips frames meanwhile), XCorrectedView bands, then unpinned
+     *       calibration cache entries. XFrame, XGrabber and XBatcher fail
+     *       to Start() when their buffers would not fit even after that,
+     *       so a new pipeline is refused instead of the node swapping
+     *       during a scan.
+     */
+    static bool SetMemoryBudget(uint64_t bytes, float reclaimAt = 0.9f);
+    
+    /**
+     * @brief Get the memory budget (0 = none)
+     */
+    static uint64_t GetMemoryBudget();
+    
+    /**
+     * @brief Get the bytes held against the budget and what it did
+     */
+    static void GetMemoryBudgetStats(MemoryBudgetStats& stats);
+    
+    /**
+     * @brief Count cycles, instructions and LLC misses per perf stage
+     * @return false if the SDK was built without HUBX_WITH_PERF_COUNTERS
+     *         or the kernel refuses the counters (perf_event_paranoid)
+     * @note Process-wide, off by default, Linux only. Each measured region
+     *       costs two counter reads, so keep it to tuning runs; builds
+     *       without the option compile the regions out entirely.
+     */
+    static bool SetPerfCounters(bool enable);
+    
+    /**
+     * @brief Check whether perf counters are being collected
+     */
+    static bool GetPerfCounters();
+    
+    /**
+     * @brief Get the counter totals of a stage
+     * @return false if stage is invalid or the SDK has no perf counters
+     */
+    static bool GetPerfStats(PerfStage stage, PerfStats& stats);
+    
+    /**
+     * @brief Clear the counter totals of all stages
+     */
+    static void ResetPerfStats();
+    
+    /**
+     * @brief Get the instruction sets of this CPU and OS
+     * @return CpuFeature bits, detected once per process
+     * @note Initialize() logs them with the kernel each family is bound to
+     */
+    static uint32_t GetCpuFeatures();
+    
+    /**
+     * @brief Restrict the instruction sets kernels may use, e.g. to test
+     *        the AVX2 or portable paths on an AVX-512 machine
+     * @param mask CpuFeature bits allowed (CPU_ALL = everything detected,
+     *        0 = portable C++ only)
+     * @note Process-wide. Correction, fusion, median and temporal kernels
+     *       are chosen per call; XShow, XPreviewServer and line binning
+     *       choose when they are created or started.
+     */
+    static void SetCpuFeatureMask(uint32_t mask);
+    
+    /**
+     * @brief Get the mask set by SetCpuFeatureMask() (CPU_ALL by default)
+     */
+    static uint32_t GetCpuFeatureMask();
+    
+    /**
+     * @brief Describe which implementation every kernel family runs
+     * @return One line per family, "name isa (available isas)", where isa
+     *         is sse4.2, avx2, avx512, neon or scalar
+     */
+    static std::string GetKernelDispatch();
+    
+    /**
+     * @brief Apply a host profile
+     * @param profile Settings; zero fields keep the built-in defaults
+     * @return false if a field is out of range, nothing is applied then
+     * @note Process-wide. Sets the correction threads (when non-zero), the
+     *       scheduler's band size and the CPU feature mask now, and the
+     *       XGrabber and XFrame defaults for objects created from now on.
+     */
+    static bool SetHostProfile(const HostProfile& profile);
+    
+    /**
+     * @brief Get the profile last applied (all defaults if none)
+     */
+    static HostProfile GetHostProfile();
+    
+    /**
+     * @brief Read a profile file and apply it
+     * @param file Text file of "key value" lines, as SaveHostProfile() writes
+     * @return false if the file cannot be read or holds an invalid value
+     */
+    static bool LoadHostProfile(const std::string& file);
+    
+    /**
+     * @brief Write a profile file that LoadHostProfile() reads
+     * @return false if the file cannot be written
+     */
+    static bool SaveHostProfile(const std::string& file, const HostProfile& profile);
+    
 private:
     class Impl;
     Impl* m_impl;
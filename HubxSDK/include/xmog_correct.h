@@ -0,0 +1,118 @@
+// ============================================================================
+
+/**
+ * @file xmog_correct.h
+ * @brief Multi-detector offset/gain correction - C API
+ * @version 2.1.0
+ */
+
+#ifndef XMOG_CORRECT_H
+#define XMOG_CORRECT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Independent XMOGCorrect instance
+ *
+ * Calls on one handle are serialized; give each pipeline thread its own.
+ * Functions return 0 on success and a negative HUBX_ERROR_* code otherwise.
+ */
+typedef struct hubx_xmog_t hubx_xmog_t;
+
+/**
+ * @brief Create an instance
+ * @return Handle, or NULL if out of memory
+ */
+hubx_xmog_t* hubx_xmog_create(void);
+
+/**
+ * @brief Destroy an instance created by hubx_xmog_create()
+ */
+void hubx_xmog_destroy(hubx_xmog_t* handle);
+
+/**
+ * @brief Load calibration written by SaveMultiDetectorCalibration()
+ * @param handle Instance
+ * @param file Calibration file; sets detector count and sizes
+ */
+int hubx_xmog_load(hubx_xmog_t* handle, const char* file);
+
+/**
+ * @brief Get number of detectors
+ * @return Detector count, or a negative error code
+ */
+int hubx_xmog_detector_count(hubx_xmog_t* handle);
+
+/**
+ * @brief Get the frame size of one detector
+ */
+int hubx_xmog_get_detector_size(hubx_xmog_t* handle, int detector, int* width, int* height);
+
+/**
+ * @brief Save calibration and detector positions
+ * @param handle Instance
+ * @param file Calibration file, readable by hubx_xmog_load()
+ */
+int hubx_xmog_save(hubx_xmog_t* handle, const char* file);
+
+/**
+ * @brief Get where a detector sits in the stitched image
+ */
+int hubx_xmog_get_detector_position(hubx_xmog_t* handle, int detector, int* x, int* y);
+
+/**
+ * @brief Place a detector in the stitched image by hand
+ */
+int hubx_xmog_set_detector_position(hubx_xmog_t* handle, int detector, int x, int y);
+
+/**
+ * @brief Measure detector positions from overlapping calibration scans
+ * @param handle Instance
+ * @param scans One scan of the same object per detector, at its frame size
+ * @param searchWidth Columns compared at each seam (at least 8); must
+ *                    exceed the overlap between neighbouring detectors
+ * @param minScore Lowest normalized cross-correlation accepted per seam (e.g. 0.8)
+ * @param scores Receives the score of each seam, detector count - 1 values (may be NULL)
+ * @return 0 when every seam registered; positions are unchanged otherwise
+ *
+ * Detectors are ordered left to right. Each seam is found by phase
+ * correlation, and its strongest peaks are checked by cross-correlation
+ * over the overlap. Positions chain from detector 0, cost milliseconds
+ * per seam, and are cached in the file written by hubx_xmog_save().
+ */
+int hubx_xmog_register(hubx_xmog_t* handle, const unsigned short* const* scans,
+                       int searchWidth, float minScore, float* scores);
+
+/**
+ * @brief In-place complex FFT used by hubx_xmog_register()
+ * @param data n interleaved (re, im) pairs
+ * @param n Length, a power of two
+ * @param inverse Nonzero for the inverse transform, unscaled either way
+ * @param user Pointer given to hubx_xmog_set_fft()
+ * @note Called from several threads at once
+ */
+typedef void (*hubx_fft_fn)(float* data, int n, int inverse, void* user);
+
+/**
+ * @brief Replace the built-in radix-2 FFT, process-wide
+ * @param fft Transform (e.g. wrapping FFTW or MKL), or NULL for the built-in one
+ * @param user Passed to every call
+ */
+void hubx_xmog_set_fft(hubx_fft_fn fft, void* user);
+
+/**
+ * @brief Correct one frame from every detector
+ * @param handle Instance
+ * @param inputs One frame per detector
+ * @param outputs One corrected frame per detector; may equal inputs
+ */
+int hubx_xmog_apply(hubx_xmog_t* handle, const unsigned short* const* inputs,
+                    unsigned short* const* outputs);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // XMOG_CORRECT_H
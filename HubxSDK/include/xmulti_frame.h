@@ -0,0 +1,183 @@
+/**
+ * @file xmulti_frame.h
+ * @brief XMultiFrame class - Line-aligned frame assembly across detectors
+ * @version 2.1.0
+ */
+
+#ifndef XMULTI_FRAME_H
+#define XMULTI_FRAME_H
+
+#include "XFrame.h"
+#include <cstdint>
+
+namespace HX {
+
+class IXImgSink;
+class XImage;
+
+/**
+ * @class XMultiFrame
+ * @brief Combines lines from several detectors into one frame per scan window
+ *
+ * Each XGrabber feeds one detector (XGrabber::SetMultiFrame). Lines with
+ * the same lineId form one combined row; a line whose timestamp is too
+ * far from the row's first line is rejected. Lines are copied once, into
+ * the detector's plane of a shared frame buffer:
+ *
+ *   plane 0: GetLines() x width(0) pixels, then plane 1, ...
+ *
+ * which is the layout XMOGCorrect takes (see GetPlanes()), so frames need
+ * no per-detector copy and stitch before correction.
+ */
+class XMultiFrame {
+public:
+    /**
+     * @brief Alignment counters
+     */
+    struct Statistics {
+        uint64_t frames;            ///< Frames delivered
+        uint64_t missingLines;      ///< Detector lines zero-filled at delivery
+        uint64_t lateLines;         ///< Lines for frames already delivered
+        uint64_t skewedLines;       ///< Lines rejected by the timestamp check
+        uint64_t maxSkewUs;         ///< Largest accepted timestamp skew
+    };
+
+    XMultiFrame();
+    ~XMultiFrame();
+
+    /**
+     * @brief Set number of detectors and their line widths
+     * @param count Detectors (1-16)
+     * @param widths Pixels per line of each detector
+     * @return true on success, false if running or a width is 0
+     */
+    bool SetDetectors(uint32_t count, const uint32_t* widths);
+
+    /**
+     * @brief Get number of detectors
+     */
+    uint32_t GetDetectors() const;
+
+    /**
+     * @brief Get line width of one detector
+     * @return Pixels per line, 0 for an unknown detector
+     */
+    uint32_t GetDetectorWidth(uint32_t detector) const;
+
+    /**
+     * @brief Set number of combined lines per frame
+     * @return true on success, false if running or lines is 0
+     */
+    bool SetLines(uint32_t lines);
+
+    /**
+     * @brief Get number of combined lines per frame
+     */
+    uint32_t GetLines() const;
+
+    /**
+     * @brief Set how far detectors may drift apart, in lines
+     * @param lines Skew window (at most GetLines(), default 64)
+     * @return true on success, false if running
+     *
+     * @note A frame is delivered once every detector sent all of its
+     *       lines, or once any detector is this many lines past its end;
+     *       lines still missing then read zero.
+     */
+    bool SetSkewWindow(uint32_t lines);
+
+    /**
+     * @brief Get skew window in lines
+     */
+    uint32_t GetSkewWindow() const;
+
+    /**
+     * @brief Set largest timestamp difference within one combined row
+     * @param us Tolerance in microseconds (0 = do not check timestamps)
+     * @return true on success, false if running
+     */
+    bool SetTimestampTolerance(uint32_t us);
+
+    /**
+     * @brief Get timestamp tolerance in microseconds
+     */
+    uint32_t GetTimestampTolerance() const;
+
+    /**
+     * @brief Set event callback sink
+     * @param sink_ Callback handler
+     *
+     * @note OnFrameReady runs on the thread whose line completed the frame.
+     *       The image is only valid during the callback.
+     */
+    void SetSink(IXImgSink* sink_);
+
+    /**
+     * @brief Start assembly
+     * @param pixelDepth Bits per pixel (9-16, one 16-bit container per pixel)
+     * @return true on success
+     */
+    bool Start(uint8_t pixelDepth);
+
+    /**
+     * @brief Stop assembly; a partly filled frame is delivered first
+     */
+    void Stop();
+
+    /**
+     * @brief Check if assembly is running
+     */
+    bool IsRunning() const;
+
+    /**
+     * @brief Add one detector line (any thread)
+     * @param detector Detector index
+     * @param lineData Line pixels, GetDetectorWidth(detector) 16-bit values
+     * @param lineLen Line length in bytes
+     * @param lineId Line identifier, shared by the lines of one combined row
+     * @param timestamp Line timestamp in microseconds (XLibPacketHeader)
+     */
+    void AddLine(uint32_t detector, const uint8_t* lineData, uint32_t lineLen,
+                 uint32_t lineId, uint32_t timestamp);
+
+    /**
+     * @brief Add one detector line with its full acquisition time (any thread)
+     * @param detector Detector index
+     * @param lineData Line pixels, GetDetectorWidth(detector) 16-bit values
+     * @param lineLen Line length in bytes
+     * @param lineId Line identifier, shared by the lines of one combined row
+     * @param time Line time; the skew check uses hostNs when the detector
+     *             clock is correlated, so unrelated counters still align
+     */
+    void AddLine(uint32_t detector, const uint8_t* lineData, uint32_t lineLen,
+                 uint32_t lineId, const XFrame::LineTime& time);
+
+    /**
+     * @brief Get the detector planes of a delivered frame
+     * @param image Frame passed to OnFrameReady
+     * @param planes Output, one plane pointer per detector
+     * @param count Size of planes (at least GetDetectors())
+     * @return true on success
+     *
+     * @note Pass planes straight to XMOGCorrect::ApplyMultiDetectorCorrection
+     *       or ApplyStitchedCorrection
+     */
+    bool GetPlanes(const XImage* image, const unsigned short** planes, uint32_t count) const;
+
+    /**
+     * @brief Get alignment counters
+     */
+    void GetStatistics(Statistics& stats) const;
+
+private:
+    class Impl;
+    Impl* m_impl;
+
+    // Non-copyable
+    XMultiFrame(const XMultiFrame&) = delete;
+    XMultiFrame& operator=(const XMultiFrame&) = delete;
+};
+
+} // namespace HX
+
+#endif // XMULTI_FRAME_H
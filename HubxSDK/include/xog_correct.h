@@ -0,0 +1,261 @@
+// ============================================================================
+
+/**
+ * @file xog_correct.h
+ * @brief Single-detector offset/gain correction - C API
+ * @version 2.1.0
+ */
+
+#ifndef XOG_CORRECT_H
+#define XOG_CORRECT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Independent XOGCorrect instance
+ *
+ * Calibration calls on one handle are serialized. hubx_xog_apply() does not
+ * wait for them: each calibration change is published as a new immutable
+ * snapshot that applies pick up from the next frame, so a detector can be
+ * recalibrated during acquisition. Applies on one handle may also run
+ * concurrently.
+ * Functions return 0 on success and a negative HUBX_ERROR_* code otherwise.
+ */
+typedef struct hubx_xog_t hubx_xog_t;
+
+/**
+ * @brief Create an instance
+ * @return Handle, or NULL if out of memory
+ */
+hubx_xog_t* hubx_xog_create(void);
+
+/**
+ * @brief Destroy an instance created by hubx_xog_create()
+ */
+void hubx_xog_destroy(hubx_xog_t* handle);
+
+/**
+ * @brief Load calibration written by SaveCalibrationData()
+ * @param handle Instance
+ * @param file Calibration file; sets the frame size and bit depth
+ */
+int hubx_xog_load(hubx_xog_t* handle, const char* file);
+
+/**
+ * @brief Start a new calibration, discarding the loaded one
+ * @param handle Instance
+ * @param width Frame width in pixels
+ * @param height Frame height in rows
+ * @param bitDepth Bit depth of the data (corrected output is clamped to it)
+ */
+int hubx_xog_init(hubx_xog_t* handle, int width, int height, int bitDepth);
+
+/**
+ * @brief Add one dark frame to the running offset mean
+ * @note Memory stays O(pixels) however many frames are added
+ */
+int hubx_xog_add_dark(hubx_xog_t* handle, const unsigned short* frame);
+
+/**
+ * @brief Store the running dark mean as the offset map and start over
+ */
+int hubx_xog_finalize_offset(hubx_xog_t* handle);
+
+/**
+ * @brief Add one bright (flat-field) frame to the running bright mean
+ */
+int hubx_xog_add_bright(hubx_xog_t* handle, const unsigned short* frame);
+
+/**
+ * @brief Gain map from the running bright mean and the offset map
+ * @param handle Instance
+ * @param target Level every pixel of the offset-corrected bright mean maps to
+ */
+int hubx_xog_finalize_gain(hubx_xog_t* handle, unsigned short target);
+
+/**
+ * @brief Drop dark and bright frames added since the last finalize
+ * @note The offset and gain maps already finalized are kept
+ */
+int hubx_xog_discard_frames(hubx_xog_t* handle);
+
+/**
+ * @brief Write the offset and gain maps for hubx_xog_load()
+ */
+int hubx_xog_save(hubx_xog_t* handle, const char* file);
+
+/**
+ * @brief Get the frame size of the loaded calibration
+ */
+int hubx_xog_get_size(hubx_xog_t* handle, int* width, int* height);
+
+/**
+ * @brief Correct one frame
+ * @param handle Instance
+ * @param input Frame of the calibrated size
+ * @param output Corrected frame; may be input
+ * @note The whole frame uses the calibration published when the call began
+ */
+int hubx_xog_apply(hubx_xog_t* handle, const unsigned short* input, unsigned short* output);
+
+/**
+ * @brief Get the version of the published calibration
+ * @param handle Instance
+ * @param version Receives a number that grows with every load, finalize
+ *        or init, so callers can tell which calibration a frame used
+ * @return HUBX_ERROR_NOT_CALIBRATED (version 0) if nothing is published
+ */
+int hubx_xog_get_version(hubx_xog_t* handle, unsigned long long* version);
+
+/**
+ * @brief Store coefficients as 16-bit fixed point, halving their memory traffic
+ * @param handle Instance
+ * @param maxError Largest difference from float coefficients accepted, in
+ *        output counts; 0 keeps the 32-bit coefficients. Calibrations whose
+ *        bound exceeds it (wide gain spread, high bit depth) keep them too.
+ * @note Applies to every calibration published from now on
+ */
+int hubx_xog_set_compact(hubx_xog_t* handle, int maxError);
+
+/**
+ * @brief Get how far the published calibration's coefficient format may
+ *        move a pixel from the float computation
+ * @param handle Instance
+ * @param counts Receives the bound in output counts (0 for float coefficients)
+ */
+int hubx_xog_get_error_bound(hubx_xog_t* handle, int* counts);
+
+/**
+ * @brief Make hubx_xog_finalize_gain() reject bright frames with transients
+ * @param handle Instance
+ * @param groups Bright frames are dealt round-robin into this many groups
+ *        (at most 15) and each pixel takes the median of its group means,
+ *        so a cosmic hit in up to (groups - 1) / 2 of the groups is ignored;
+ *        below 2 the plain mean of all frames is used (the default)
+ * @note Discards bright frames added so far. Memory is 4 bytes per pixel
+ *       and group however many frames are added; add at least one frame
+ *       per group.
+ */
+int hubx_xog_set_robust_gain(hubx_xog_t* handle, int groups);
+
+/**
+ * @brief Get which pixels stay linear at the calibrated operating point
+ * @param handle Instance
+ * @param map Receives 4 bits per pixel, two pixels per byte with the even
+ *        pixel in the low nibble: code c means the corrected output is
+ *        linear for raw values below c / 15 of full scale, where the ADC
+ *        saturates or the correction clips. 15 is the whole range; 0 means
+ *        no linear range (the bright field saturated, the pixel did not
+ *        respond, or its gain was clamped).
+ * @param size Bytes at map, at least (width * height + 1) / 2
+ * @note Built by every hubx_xog_finalize_gain() with the target and
+ *       correction mode of that moment. Pixels whose gain was loaded or
+ *       set rather than calibrated read 15. The map is not saved with the
+ *       calibration.
+ */
+int hubx_xog_get_saturation_map(hubx_xog_t* handle, unsigned char* map, int size);
+
+/**
+ * @brief Count the pixels with each hubx_xog_get_saturation_map() code
+ * @param handle Instance
+ * @param counts Receives 16 counts; counts[0] is the saturated pixels
+ */
+int hubx_xog_get_saturation_counts(hubx_xog_t* handle, unsigned long long* counts);
+
+/**
+ * @brief Split the calibration into detector modules
+ * @param handle Instance
+ * @param modulePixels Pixels per module (XDM_PIX_NUM); module m is columns
+ *        [m * modulePixels, (m + 1) * modulePixels) of every row, the
+ *        moduleId of its packets. 0 = one calibration for the whole width.
+ * @return HUBX_ERROR_INVALID_PARAM if the width is not a multiple of it
+ * @note Files saved from now on store each module separately, so
+ *       hubx_xog_save_module() can rewrite one; hubx_xog_load() of such a
+ *       file sets the module size it was saved with
+ */
+int hubx_xog_set_modules(hubx_xog_t* handle, int modulePixels);
+
+/**
+ * @brief Limit the finalize calls to one module
+ * @param handle Instance
+ * @param module Module whose maps hubx_xog_finalize_offset() and
+ *        hubx_xog_finalize_gain() write, or -1 for the whole detector
+ * @note Frames are still added whole. A finalize in module scope
+ *       republishes only that module's coefficients; the others keep theirs.
+ */
+int hubx_xog_set_module_scope(hubx_xog_t* handle, int module);
+
+/**
+ * @brief Track each line's offset with the shielded pixels of its module
+ * @param handle Instance
+ * @param leadPixels Dark reference pixels at the start of each module
+ * @param trailPixels Dark reference pixels at the end of each module
+ * @return HUBX_ERROR_INVALID_PARAM if they do not leave pixels in a module
+ * @note Modules are those of hubx_xog_set_modules(), or the whole line
+ *       without them. Every corrected line first has each module shifted
+ *       by how far the mean of its reference pixels lies from their mean
+ *       in the offset map (from 0 with offset correction off), in the same
+ *       pass as the offset/gain correction. 0, 0 = off (the default).
+ */
+int hubx_xog_set_dark_reference(hubx_xog_t* handle, int leadPixels, int trailPixels);
+
+/**
+ * @brief Write one module's maps into a file saved with modules
+ * @param handle Instance
+ * @param file File from hubx_xog_save() with the same size and modules
+ * @param module Module to rewrite; the rest of the file is not touched
+ * @note The file is updated in place: if interrupted, its checksums no
+ *       longer match and hubx_xog_load() rejects it
+ */
+int hubx_xog_save_module(hubx_xog_t* handle, const char* file, int module);
+
+/**
+ * @brief Replace one module's calibration from a file saved with modules
+ * @param handle Instance
+ * @param file File with the same height and module size, e.g. the
+ *        calibration that came with a replacement module
+ * @param module Module to take from the file and replace
+ * @note Takes effect from the next frame, like every calibration change
+ */
+int hubx_xog_load_module(hubx_xog_t* handle, const char* file, int module);
+
+/**
+ * @brief Save only what changed since a calibration file was saved
+ * @param handle Instance
+ * @param file Delta file to write
+ * @param baseFile Full file saved earlier with the same module layout
+ * @note Holds the changed modules (or maps, without modules) and nothing
+ *       else, so stations that run the base need only this file. It names
+ *       its base by content: any copy of the base file will do.
+ */
+int hubx_xog_save_delta(hubx_xog_t* handle, const char* file, const char* baseFile);
+
+/**
+ * @brief Load a full file with a delta saved against it
+ * @param handle Instance
+ * @param baseFile Full file the delta was saved against
+ * @param deltaFile File from hubx_xog_save_delta()
+ * @note Like hubx_xog_load() of the file hubx_xog_save() would have written
+ *       when the delta was saved; fails if the delta belongs to another base
+ */
+int hubx_xog_load_delta(hubx_xog_t* handle, const char* baseFile, const char* deltaFile);
+
+/**
+ * @brief Take the changes of a delta into the loaded calibration
+ * @param handle Instance
+ * @param deltaFile File from hubx_xog_save_delta() whose base is the file
+ *        last loaded (or the delta last applied)
+ * @return HUBX_ERROR_INVALID_PARAM if the calibration was changed since,
+ *         the delta has another base, or it changes the size or modules
+ * @note Only the delta is read and only the modules it holds are
+ *       republished; the rest keep their coefficients
+ */
+int hubx_xog_apply_delta(hubx_xog_t* handle, const char* deltaFile);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // XOG_CORRECT_H
@@ -0,0 +1,610 @@
+// ============================================================================
+// hubx_py.cpp - Python module over hubx_capi and hubx_xog
+// ============================================================================
+
+/**
+ * @file hubx_py.cpp
+ * @brief pyhubx - frames as NumPy arrays over the pooled XImage buffers
+ * @version 2.1.0
+ *
+ * A Frame exports its pool buffer through the buffer protocol, so
+ * numpy.asarray(frame) and Frame.array are views, not copies. The buffer
+ * is the caller's until Frame.release() (or until the Frame object is
+ * collected); arrays taken from a frame must not be used after that.
+ *
+ * The receive thread never takes the GIL: frames are queued natively and
+ * picked up by Device.next_frame(), which waits without the GIL. Stopping
+ * and correcting release the GIL as well.
+ *
+ *     import pyhubx, numpy
+ *     dev = pyhubx.Device("192.168.1.2", pixel_count=2048, module_count=4)
+ *     dev.open()
+ *     dev.start(lines_per_frame=512)
+ *     for frame in dev:
+ *         with frame:
+ *             print(frame.sequence, numpy.asarray(frame).mean())
+ */
+
+#include "hubx_capi.h"
+#include "xog_correct.h"
+#include "XControl.h"
+#include <pybind11/numpy.h>
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace py = pybind11;
+
+namespace {
+
+const int ERROR_BUSY = -7;
+const size_t MAX_ERRORS = 64;
+
+/// Raised for negative C API results (pyhubx.HubxError)
+class Error : public std::runtime_error {
+public:
+    Error(const std::string& what_, int code)
+        : std::runtime_error(what_ + " failed (error " + std::to_string(code) + ")"),
+          m_code(code)
+    {
+    }
+
+    int code() const { return m_code; }
+
+private:
+    int m_code;
+};
+
+void check(int result, const char* what_) {
+    if (result < 0) {
+        throw Error(what_, result);
+    }
+}
+
+uint32_t milliseconds(double seconds) {
+    if (seconds <= 0.0) {
+        return 0;
+    }
+    double ms = seconds * 1000.0;
+    return ms >= 4294967295.0 ? 0xFFFFFFFFu : static_cast<uint32_t>(ms);
+}
+
+class Device;
+
+/**
+ * @brief One delivered frame, owning its pool buffer until released
+ */
+class Frame {
+public:
+    Frame(std::shared_ptr<Device> device, const hubx_frame_t& info)
+        : m_device(std::move(device)),
+          m_info(info),
+          m_released(false)
+    {
+    }
+
+    ~Frame() { release(); }
+
+    void release();
+
+    bool released() const { return m_released; }
+    const hubx_frame_t& info() const { return m_info; }
+
+    /// Pixels, or an error once released
+    void* data() const {
+        if (m_released) {
+            throw std::runtime_error("frame already released");
+        }
+        return const_cast<void*>(m_info.data);
+    }
+
+    bool packed() const { return m_info.stride == m_info.width * m_info.bytesPerPixel; }
+
+private:
+    Frame(const Frame&) = delete;
+    Frame& operator=(const Frame&) = delete;
+
+    std::shared_ptr<Device> m_device;
+    hubx_frame_t m_info;
+    std::atomic<bool> m_released;
+};
+
+/**
+ * @brief hubx_device_t plus the queue between receive thread and Python
+ *
+ * Queued frames are held (they count against the pool) until Python takes
+ * them; stop() gives the untaken ones back before it waits.
+ */
+class Device : public std::enable_shared_from_this<Device> {
+public:
+    Device(const std::string& ip, uint32_t pixelCount, uint32_t moduleCount, uint32_t pixelDepth,
+           uint16_t cmdPort, uint16_t imgPort, const std::vector<uint8_t>& mac, const std::string& serial)
+        : m_handle(nullptr),
+          m_running(false),
+          m_stopping(false)
+    {
+        if (!mac.empty() && mac.size() != 6) {
+            throw std::invalid_argument("mac must have 6 bytes");
+        }
+        hubx_detector_config_t config;
+        std::memset(&config, 0, sizeof(config));
+        config.ip = ip.c_str();
+        config.cmdPort = cmdPort;
+        config.imgPort = imgPort;
+        if (!mac.empty()) {
+            std::memcpy(config.mac, mac.data(), 6);
+        }
+        config.serial = serial.c_str();
+        config.pixelCount = pixelCount;
+        config.moduleCount = moduleCount;
+        config.pixelDepth = pixelDepth;
+        m_handle = hubx_device_create(&config);
+        if (!m_handle) {
+            throw std::invalid_argument("invalid detector configuration");
+        }
+    }
+
+    /// Runs once no Frame refers to the device any more
+    ~Device() {
+        drain();
+        hubx_device_destroy(m_handle);
+    }
+
+    void open() { check(hubx_device_open(m_handle), "open"); }
+
+    /**
+     * @brief Stop and close the command channel
+     * @throws Error if frames are still held after the timeout
+     */
+    void close(double timeout) {
+        if (!stop(timeout)) {
+            throw Error("close: frames are still held,", ERROR_BUSY);
+        }
+        py::gil_scoped_release nogil;
+        hubx_device_close(m_handle);
+    }
+
+    uint64_t read(HX::XControl::XCode code, uint8_t index) {
+        uint64_t value = 0;
+        check(hubx_control_read(m_handle, static_cast<int>(code), index, &value), "read");
+        return value;
+    }
+
+    void write(HX::XControl::XCode code, uint64_t value, uint8_t index) {
+        check(hubx_control_write(m_handle, static_cast<int>(code), value, index), "write");
+    }
+
+    void operate(HX::XControl::XCode code, uint64_t data) {
+        check(hubx_control_operate(m_handle, static_cast<int>(code), data), "operate");
+    }
+
+    void start(uint32_t linesPerFrame, uint32_t poolSize, uint32_t segments, bool lineHeader, uint32_t frames) {
+        hubx_callbacks_t callbacks;
+        callbacks.frame = &Device::onFrame;
+        callbacks.error = &Device::onError;
+        callbacks.event = nullptr;
+        callbacks.user = this;
+        check(hubx_acq_set_callbacks(m_handle, &callbacks), "start");
+
+        hubx_acq_config_t config;
+        config.linesPerFrame = linesPerFrame;
+        config.poolSize = poolSize;
+        config.segments = segments;
+        config.lineHeader = lineHeader ? 1u : 0u;
+        config.frames = frames;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = false;
+            m_running = true;
+        }
+        int result = hubx_acq_start(m_handle, &config);
+        if (result < 0) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_running = false;
+        }
+        check(result, "start");
+    }
+
+    /**
+     * @brief Stop delivering frames, then stop grabbing once all are released
+     * @return false if frames taken by Python are still held after the timeout
+     */
+    bool stop(double timeout) {
+        py::gil_scoped_release nogil;
+        drain();
+        int result = hubx_acq_stop(m_handle, milliseconds(timeout));
+        if (result == ERROR_BUSY) {
+            return false;
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_running = false;
+            m_stopping = false;
+        }
+        m_ready.notify_all();
+        check(result, "stop");
+        return true;
+    }
+
+    /**
+     * @brief Next frame, waiting without the GIL
+     * @param timeout Seconds to wait, negative for no limit
+     * @return Frame, or None on timeout or once stopped
+     */
+    py::object nextFrame(double timeout) {
+        typedef std::chrono::steady_clock Clock;
+        const bool forever = timeout < 0.0;
+        const Clock::time_point deadline = Clock::now() +
+            std::chrono::microseconds(forever ? 0 : static_cast<int64_t>(timeout * 1e6));
+        for (;;) {
+            hubx_frame_t info;
+            bool got = false;
+            bool done = false;
+            {
+                py::gil_scoped_release nogil;
+                std::unique_lock<std::mutex> lock(m_mutex);
+                // Short slices, so Ctrl-C is noticed while waiting
+                Clock::time_point until = Clock::now() + std::chrono::milliseconds(100);
+                if (!forever && deadline < until) {
+                    until = deadline;
+                }
+                m_ready.wait_until(lock, until, [this] { return !m_queue.empty() || !m_running; });
+                if (!m_queue.empty()) {
+                    info = m_queue.front();
+                    m_queue.pop_front();
+                    got = true;
+                }
+                done = !m_running || (!forever && Clock::now() >= deadline);
+            }
+            if (got) {
+                return py::cast(std::make_shared<Frame>(shared_from_this(), info));
+            }
+            if (PyErr_CheckSignals() != 0) {
+                throw py::error_already_set();
+            }
+            if (done) {
+                return py::none();
+            }
+        }
+    }
+
+    bool running() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_running;
+    }
+
+    size_t queued() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_queue.size();
+    }
+
+    uint32_t freeBuffers() { return hubx_acq_free_buffers(m_handle); }
+
+    /// Errors reported since the last call, oldest first
+    std::vector<std::pair<uint32_t, std::string> > takeErrors() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::vector<std::pair<uint32_t, std::string> > errors(m_errors.begin(), m_errors.end());
+        m_errors.clear();
+        return errors;
+    }
+
+    void releaseFrame(void* token) { hubx_frame_release(m_handle, token); }
+
+private:
+    Device(const Device&) = delete;
+    Device& operator=(const Device&) = delete;
+
+    static void onFrame(const hubx_frame_t* frame, void* user) {
+        Device* device = static_cast<Device*>(user);
+        {
+            std::lock_guard<std::mutex> lock(device->m_mutex);
+            if (!device->m_stopping) {
+                device->m_queue.push_back(*frame);
+                device->m_ready.notify_one();
+                return;
+            }
+        }
+        hubx_frame_release(device->m_handle, frame->token);
+    }
+
+    static void onError(uint32_t id, const char* message, void* user) {
+        Device* device = static_cast<Device*>(user);
+        std::lock_guard<std::mutex> lock(device->m_mutex);
+        if (device->m_errors.size() >= MAX_ERRORS) {
+            device->m_errors.pop_front();
+        }
+        device->m_errors.push_back(std::make_pair(id, std::string(message)));
+    }
+
+    /// Refuse new frames and give the queued ones back
+    void drain() {
+        std::deque<hubx_frame_t> queued;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = true;
+            queued.swap(m_queue);
+        }
+        for (size_t i = 0; i < queued.size(); ++i) {
+            hubx_frame_release(m_handle, queued[i].token);
+        }
+    }
+
+    hubx_device_t* m_handle;
+    std::mutex m_mutex;
+    std::condition_variable m_ready;
+    std::deque<hubx_frame_t> m_queue;
+    std::deque<std::pair<uint32_t, std::string> > m_errors;
+    bool m_running;
+    bool m_stopping;                    ///< Frames are released on arrival
+};
+
+void Frame::release() {
+    if (!m_released.exchange(true)) {
+        m_device->releaseFrame(m_info.token);
+    }
+}
+
+/**
+ * @brief Offset/gain correction (hubx_xog_t) of frames and uint16 arrays
+ *
+ * Frames with padded rows are packed into a scratch buffer first; packed
+ * frames and C-contiguous arrays are corrected in place.
+ */
+class Correction {
+public:
+    Correction()
+        : m_handle(hubx_xog_create())
+    {
+        if (!m_handle) {
+            throw std::bad_alloc();
+        }
+    }
+
+    ~Correction() { hubx_xog_destroy(m_handle); }
+
+    void load(const std::string& file) { check(hubx_xog_load(m_handle, file.c_str()), "load"); }
+    void save(const std::string& file) { check(hubx_xog_save(m_handle, file.c_str()), "save"); }
+
+    void init(int width, int height, int bitDepth) {
+        check(hubx_xog_init(m_handle, width, height, bitDepth), "init");
+    }
+
+    std::pair<int, int> size() {
+        int width = 0;
+        int height = 0;
+        check(hubx_xog_get_size(m_handle, &width, &height), "size");
+        return std::make_pair(width, height);
+    }
+
+    void addDark(Frame& frame) { run(frame, &Correction::darkStep, "add_dark"); }
+    void addBright(Frame& frame) { run(frame, &Correction::brightStep, "add_bright"); }
+    void apply(Frame& frame) { run(frame, &Correction::applyStep, "apply"); }
+
+    void addDarkArray(py::array array) { run(array, &Correction::darkStep, "add_dark"); }
+    void addBrightArray(py::array array) { run(array, &Correction::brightStep, "add_bright"); }
+    void applyArray(py::array array) { run(array, &Correction::applyStep, "apply"); }
+
+    void finalizeOffset() {
+        py::gil_scoped_release nogil;
+        check(hubx_xog_finalize_offset(m_handle), "finalize_offset");
+    }
+
+    void finalizeGain(unsigned short target) {
+        py::gil_scoped_release nogil;
+        check(hubx_xog_finalize_gain(m_handle, target), "finalize_gain");
+    }
+
+    void discardFrames() { check(hubx_xog_discard_frames(m_handle), "discard_frames"); }
+
+private:
+    Correction(const Correction&) = delete;
+    Correction& operator=(const Correction&) = delete;
+
+    typedef int (*Step)(hubx_xog_t*, unsigned short*);
+
+    static int darkStep(hubx_xog_t* handle, unsigned short* pixels) { return hubx_xog_add_dark(handle, pixels); }
+    static int brightStep(hubx_xog_t* handle, unsigned short* pixels) { return hubx_xog_add_bright(handle, pixels); }
+    static int applyStep(hubx_xog_t* handle, unsigned short* pixels) { return hubx_xog_apply(handle, pixels, pixels); }
+
+    /// Calibrated size, for calls after init() or load(); 0x0 before
+    void checkSize(size_t width, size_t height) {
+        int w = 0;
+        int h = 0;
+        if (hubx_xog_get_size(m_handle, &w, &h) == 0 && w > 0 &&
+            (static_cast<size_t>(w) != width || static_cast<size_t>(h) != height)) {
+            throw std::invalid_argument("frame is " + std::to_string(width) + "x" + std::to_string(height) +
+                                        ", correction is " + std::to_string(w) + "x" + std::to_string(h));
+        }
+    }
+
+    void run(Frame& frame, Step step, const char* what_) {
+        const hubx_frame_t& info = frame.info();
+        unsigned short* pixels = static_cast<unsigned short*>(frame.data());
+        if (info.bytesPerPixel != 2) {
+            throw std::invalid_argument("correction takes 16-bit frames");
+        }
+        checkSize(info.width, info.height);
+
+        py::gil_scoped_release nogil;
+        if (frame.packed()) {
+            check(step(m_handle, pixels), what_);
+            return;
+        }
+        const size_t rowBytes = info.width * sizeof(unsigned short);
+        m_scratch.resize(static_cast<size_t>(info.width) * info.height);
+        for (uint32_t row = 0; row < info.height; ++row) {
+            std::memcpy(&m_scratch[row * info.width], reinterpret_cast<const char*>(pixels) + row * info.stride, rowBytes);
+        }
+        check(step(m_handle, m_scratch.data()), what_);
+        if (step == &Correction::applyStep) {
+            for (uint32_t row = 0; row < info.height; ++row) {
+                std::memcpy(reinterpret_cast<char*>(pixels) + row * info.stride, &m_scratch[row * info.width], rowBytes);
+            }
+        }
+    }
+
+    void run(py::array& array, Step step, const char* what_) {
+        if (!py::isinstance<py::array_t<uint16_t> >(array) || array.ndim() != 2 ||
+            !(array.flags() & py::array::c_style)) {
+            throw std::invalid_argument("expected a C-contiguous 2-D uint16 array");
+        }
+        if (step == &Correction::applyStep && !array.writeable()) {
+            throw std::invalid_argument("apply corrects in place, the array must be writeable");
+        }
+        checkSize(static_cast<size_t>(array.shape(1)), static_cast<size_t>(array.shape(0)));
+        unsigned short* pixels = static_cast<unsigned short*>(array.mutable_data());
+
+        py::gil_scoped_release nogil;
+        check(step(m_handle, pixels), what_);
+    }
+
+    hubx_xog_t* m_handle;
+    std::vector<unsigned short> m_scratch;
+};
+
+std::string formatOf(uint32_t bytesPerPixel) {
+    switch (bytesPerPixel) {
+    case 1: return py::format_descriptor<uint8_t>::format();
+    case 4: return py::format_descriptor<uint32_t>::format();
+    default: return py::format_descriptor<uint16_t>::format();
+    }
+}
+
+} // anonymous namespace
+
+PYBIND11_MODULE(pyhubx, m) {
+    m.doc() = "Hubx detector acquisition with zero-copy NumPy frames";
+
+    py::register_exception<Error>(m, "HubxError");
+
+    py::enum_<HX::XControl::XCode>(m, "XCode")
+        .value("INIT", HX::XControl::XINIT)
+        .value("RESTORE", HX::XControl::XRESTORE)
+        .value("SAVE", HX::XControl::XSAVE)
+        .value("FRAME_TR_GEN", HX::XControl::XFRAME_TR_GEN)
+        .value("INT_TIME", HX::XControl::XINT_TIME)
+        .value("NON_INTTIME", HX::XControl::XNON_INTTIME)
+        .value("OPERATION", HX::XControl::XOPERATION)
+        .value("DM_GAIN", HX::XControl::XDM_GAIN)
+        .value("HL_MODE", HX::XControl::XHL_MODE)
+        .value("CHANNEL", HX::XControl::XCHANNEL)
+        .value("BASE_COR", HX::XControl::XBASE_COR)
+        .value("BASE_LINE", HX::XControl::XBASE_LINE)
+        .value("BIN", HX::XControl::XBIN)
+        .value("AVERAGE", HX::XControl::XAVERAGE)
+        .value("SUM", HX::XControl::XSUM)
+        .value("SCALE", HX::XControl::XSCALE)
+        .value("OFFSET_AVG", HX::XControl::XOFFSET_AVG)
+        .value("LINE_TR_MODE", HX::XControl::XLINE_TR_MODE)
+        .value("LINE_TRIGGER", HX::XControl::XLINE_TRIGGER)
+        .value("LINE_TR_FINE_DELAY", HX::XControl::XLINE_TR_FINE_DELAY)
+        .value("LINE_TR_RAW_DELAY", HX::XControl::XLINE_TR_RAW_DELAY)
+        .value("FRAME_TR_MODE", HX::XControl::XFRAME_TR_MODE)
+        .value("FRAME_TRIGGER", HX::XControl::XFRAME_TRIGGER)
+        .value("FRAME_TR_DELAY", HX::XControl::XFRAME_TR_DELAY)
+        .value("LINE_TR_PARITY", HX::XControl::XLINE_TR_PARITY)
+        .value("PIXEL_NUM", HX::XControl::XPIXEL_NUM)
+        .value("PIXEL_SIZE", HX::XControl::XPIXEL_SIZE)
+        .value("PIXEL_DEPTH", HX::XControl::XPIXEL_DEPTH)
+        .value("CU_VER", HX::XControl::XCU_VER)
+        .value("DM_VER", HX::XControl::XDM_VER)
+        .value("CU_TEST", HX::XControl::XCU_TEST)
+        .value("DM_TEST", HX::XControl::XDM_TEST)
+        .value("DM_PIX_NUM", HX::XControl::XDM_PIX_NUM)
+        .value("DM_TYPE", HX::XControl::XDM_TYPE)
+        .value("LED", HX::XControl::XLED)
+        .value("CU_TYPE", HX::XControl::XCU_TYPE)
+        .value("CU_SN", HX::XControl::XCU_SN)
+        .value("DM_SN", HX::XControl::XDM_SN);
+
+    py::class_<Frame, std::shared_ptr<Frame> >(m, "Frame", py::buffer_protocol(),
+        "A frame in a pool buffer; the buffer protocol exports it without copying")
+        .def_buffer([](Frame& frame) -> py::buffer_info {
+            const hubx_frame_t& info = frame.info();
+            if (frame.released()) {
+                // Exceptions cannot cross the buffer protocol: export nothing
+                return py::buffer_info(nullptr, info.bytesPerPixel, formatOf(info.bytesPerPixel), 2,
+                                       { 0, 0 }, { 0, 0 });
+            }
+            return py::buffer_info(const_cast<void*>(info.data), info.bytesPerPixel, formatOf(info.bytesPerPixel), 2,
+                                   { static_cast<py::ssize_t>(info.height), static_cast<py::ssize_t>(info.width) },
+                                   { static_cast<py::ssize_t>(info.stride), static_cast<py::ssize_t>(info.bytesPerPixel) });
+        })
+        .def_property_readonly("array", [](py::object self) {
+            Frame& frame = self.cast<Frame&>();
+            const hubx_frame_t& info = frame.info();
+            return py::array(py::dtype(formatOf(info.bytesPerPixel)),
+                             { static_cast<py::ssize_t>(info.height), static_cast<py::ssize_t>(info.width) },
+                             { static_cast<py::ssize_t>(info.stride), static_cast<py::ssize_t>(info.bytesPerPixel) },
+                             frame.data(), self);
+        }, "(height, width) view of the pool buffer, valid until release()")
+        .def_property_readonly("width", [](const Frame& frame) { return frame.info().width; })
+        .def_property_readonly("height", [](const Frame& frame) { return frame.info().height; })
+        .def_property_readonly("stride", [](const Frame& frame) { return frame.info().stride; },
+            "Bytes from one row to the next")
+        .def_property_readonly("pixel_depth", [](const Frame& frame) { return frame.info().pixelDepth; })
+        .def_property_readonly("sequence", [](const Frame& frame) { return frame.info().sequence; })
+        .def_property_readonly("released", &Frame::released)
+        .def("release", &Frame::release, "Give the buffer back to the pool")
+        .def("__enter__", [](py::object self) { return self; })
+        .def("__exit__", [](Frame& frame, py::args) { frame.release(); });
+
+    py::class_<Device, std::shared_ptr<Device> >(m, "Device",
+        "Detector, command channel and acquisition; frames keep the device alive")
+        .def(py::init<const std::string&, uint32_t, uint32_t, uint32_t, uint16_t, uint16_t,
+                      const std::vector<uint8_t>&, const std::string&>(),
+             py::arg("ip"), py::arg("pixel_count"), py::arg("module_count"), py::arg("pixel_depth") = 16,
+             py::arg("cmd_port") = 3000, py::arg("img_port") = 4001,
+             py::arg("mac") = std::vector<uint8_t>(), py::arg("serial") = "")
+        .def("open", &Device::open)
+        .def("close", &Device::close, py::arg("timeout") = 1.0,
+             "Stop and close; raises HubxError if frames are still held after the timeout")
+        .def("read", &Device::read, py::arg("code"), py::arg("index") = 0)
+        .def("write", &Device::write, py::arg("code"), py::arg("value"), py::arg("index") = 0)
+        .def("operate", &Device::operate, py::arg("code"), py::arg("data") = 0)
+        .def("start", &Device::start, py::arg("lines_per_frame") = 512, py::arg("pool_size") = 8,
+             py::arg("segments") = 1, py::arg("line_header") = true, py::arg("frames") = 0)
+        .def("stop", &Device::stop, py::arg("timeout") = 1.0,
+             "Stop acquisition; False if frames are still held after the timeout (call again once released)")
+        .def("next_frame", &Device::nextFrame, py::arg("timeout") = -1.0,
+             "Next frame (waits without the GIL), or None on timeout or once stopped")
+        .def("__iter__", [](py::object self) { return self; })
+        .def("__next__", [](Device& device) {
+            py::object frame = device.nextFrame(-1.0);
+            if (frame.is_none()) {
+                throw py::stop_iteration();
+            }
+            return frame;
+        })
+        .def("errors", &Device::takeErrors, "(id, message) pairs reported since the last call")
+        .def_property_readonly("running", &Device::running)
+        .def_property_readonly("queued", &Device::queued, "Frames received and not yet taken")
+        .def_property_readonly("free_buffers", &Device::freeBuffers);
+
+    py::class_<Correction>(m, "Correction",
+        "Offset/gain correction; frames and arrays are corrected in place, without the GIL")
+        .def(py::init<>())
+        .def("load", &Correction::load)
+        .def("save", &Correction::save)
+        .def("init", &Correction::init, py::arg("width"), py::arg("height"), py::arg("bit_depth") = 16)
+        .def_property_readonly("size", &Correction::size)
+        .def("add_dark", &Correction::addDark)
+        .def("add_dark", &Correction::addDarkArray)
+        .def("finalize_offset", &Correction::finalizeOffset)
+        .def("add_bright", &Correction::addBright)
+        .def("add_bright", &Correction::addBrightArray)
+        .def("finalize_gain", &Correction::finalizeGain, py::arg("target"))
+        .def("discard_frames", &Correction::discardFrames)
+        .def("apply", &Correction::apply)
+        .def("apply", &Correction::applyArray);
+}
@@ -15,27 +15,103 @@
 #include "XAdaptor.h"
 #include "XDetector.h"
 #include "ixcmd_sink.h"
+#include "xfactory.h"
 #include "xlibdll_wrapper/xlibdll_interface.h"
+#include "utils/logger.h"
+#include "utils/network_utils.h"
+#include "utils/notifier.h"
 #include <iostream>
 #include <vector>
 #include <cstring>
 #include <mutex>
 #include <chrono>
 #include <thread>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <algorithm>
+#include <functional>
+#include <fstream>
+#include <sstream>
 
 #ifdef _WIN32
     #include <winsock2.h>
     #include <ws2tcpip.h>
+    #include <iphlpapi.h>
     #pragma comment(lib, "ws2_32.lib")
+    #pragma comment(lib, "iphlpapi.lib")
 #else
     #include <sys/socket.h>
     #include <netinet/in.h>
     #include <arpa/inet.h>
     #include <unistd.h>
+    #include <ifaddrs.h>
+    #include <net/if.h>
 #endif
 
 namespace HX {
 
+// ============================================================================
+// Adapter Enumeration
+// ============================================================================
+
+namespace {
+
+/**
+ * @brief List the IPv4 addresses of local adapters that are up
+ * @note Loopback adapters are skipped
+ */
+void listAdapters(std::vector<std::string>& adapters) {
+    adapters.clear();
+    char ip[INET_ADDRSTRLEN];
+#ifdef _WIN32
+    ULONG size = 16 * 1024;
+    std::vector<uint8_t> buffer;
+    ULONG result = ERROR_BUFFER_OVERFLOW;
+    for (int attempt = 0; attempt < 3 && result == ERROR_BUFFER_OVERFLOW; ++attempt) {
+        buffer.resize(size);
+        result = GetAdaptersAddresses(AF_INET,
+            GAA_FLAG_SKIP_ANYCAST | GAA_FLAG_SKIP_MULTICAST | GAA_FLAG_SKIP_DNS_SERVER,
+            nullptr, reinterpret_cast<IP_ADAPTER_ADDRESSES*>(buffer.data()), &size);
+    }
+    if (result != NO_ERROR) {
+        return;
+    }
+    for (IP_ADAPTER_ADDRESSES* adapter = reinterpret_cast<IP_ADAPTER_ADDRESSES*>(buffer.data());
+         adapter; adapter = adapter->Next) {
+        if (adapter->OperStatus != IfOperStatusUp ||
+            adapter->IfType == IF_TYPE_SOFTWARE_LOOPBACK) {
+            continue;
+        }
+        for (IP_ADAPTER_UNICAST_ADDRESS* address = adapter->FirstUnicastAddress;
+             address; address = address->Next) {
+            const sockaddr_in* in = reinterpret_cast<const sockaddr_in*>(address->Address.lpSockaddr);
+            if (in->sin_family == AF_INET && inet_ntop(AF_INET, &in->sin_addr, ip, sizeof(ip))) {
+                adapters.push_back(ip);
+            }
+        }
+    }
+#else
+    struct ifaddrs* list = nullptr;
+    if (getifaddrs(&list) != 0) {
+        return;
+    }
+    for (struct ifaddrs* entry = list; entry; entry = entry->ifa_next) {
+        if (!entry->ifa_addr || entry->ifa_addr->sa_family != AF_INET ||
+            !(entry->ifa_flags & IFF_UP) || (entry->ifa_flags & IFF_LOOPBACK)) {
+            continue;
+        }
+        const sockaddr_in* in = reinterpret_cast<const sockaddr_in*>(entry->ifa_addr);
+        if (inet_ntop(AF_INET, &in->sin_addr, ip, sizeof(ip))) {
+            adapters.push_back(ip);
+        }
+    }
+    freeifaddrs(list);
+#endif
+}
+
+} // anonymous namespace
+
 // ============================================================================
 // Internal Implementation
 // ============================================================================
@@ -52,17 +128,34 @@ public:
     bool isOpen() const { return m_opened; }
     
     int32_t connect();
+    int32_t discover(uint32_t timeout, bool allAdapters, uint32_t expected);
     XDetector getDetector(uint32_t index);
+    std::string getDetectorAdapter(uint32_t index);
     int32_t configDetector(const XDetector& det);
     int32_t restore();
+    bool saveInventory(const std::string& file);
+    int32_t loadInventory(const std::string& file, uint32_t timeout);
+    int32_t inspectNetwork(const XDetector& det, double lineRate, std::vector<XAdaptor::NetworkReport>& reports,
+                           uint32_t recvBufferSize, bool allAdapters);
     
-    void setSink(IXCmdSink* sink) { m_sink = sink; }
+    void setSink(IXCmdSink* sink) {
+        m_sink = sink;
+        m_notify.setSink(sink);
+    }
+    void setRebootTimeout(uint32_t timeout) { m_rebootTimeout = timeout; }
     
 private:
     void reportError(uint32_t errorId, const char* message);
     void reportEvent(uint32_t eventId, float data);
     
     bool validateIP(const std::string& ip) const;
+    XDetector toDetector(const Internal::XLibDeviceInfo& info) const;
+    uint32_t waitReady(std::vector<Internal::XLibDeviceInfo>& devices, std::vector<bool>& ready);
+    void refreshDevice(const Internal::XLibDeviceInfo& info);
+    int32_t collect(const std::vector<std::string>& adapters, uint32_t timeout, uint32_t expected,
+                    const std::function<bool(const Internal::XLibDeviceInfo&, size_t)>& onReply);
+    void validateInventory(std::vector<std::string> adapters, uint32_t timeout);
+    void stopValidation();
     bool initializeNetwork();
     void cleanupNetwork();
     
@@ -70,11 +163,19 @@ private:
     bool m_opened;
     bool m_networkInitialized;
     IXCmdSink* m_sink;
+    Internal::NotifySource m_notify;    ///< Delivers OnXError/OnXEvent off the discovery threads
+    uint32_t m_rebootTimeout;   // ms allowed for a device to come back
     
     // Discovered devices
     std::vector<Internal::XLibDeviceInfo> m_discoveredDevices;
+    std::vector<std::string> m_discoveredAdapters;  // Adapter each one answered on
     mutable std::mutex m_mutex;
     
+    // Background check of a loaded inventory
+    std::thread m_validationThread;
+    std::mutex m_validationMutex;   // Guards m_validationThread
+    std::atomic<bool> m_cancel;     // Stops collect() early
+    
     // Network state
     int m_broadcastSocket;
 };
@@ -83,6 +184,8 @@ XAdaptor::Impl::Impl()
     : m_opened(false)
     , m_networkInitialized(false)
     , m_sink(nullptr)
+    , m_rebootTimeout(10000)
+    , m_cancel(false)
     , m_broadcastSocket(-1)
 {
 }
@@ -92,6 +195,8 @@ XAdaptor::Impl::Impl(const std::string& adapterIP)
     , m_opened(false)
     , m_networkInitialized(false)
     , m_sink(nullptr)
+    , m_rebootTimeout(10000)
+    , m_cancel(false)
     , m_broadcastSocket(-1)
 {
 }
@@ -181,6 +286,7 @@ bool XAdaptor::Impl::open() {
     
     m_opened = true;
     m_discoveredDevices.clear();
+    m_discoveredAdapters.clear();
     
     std::cout << "[XAdaptor] Opened successfully on " << m_adapterIP << std::endl;
     
@@ -188,6 +294,8 @@ bool XAdaptor::Impl::open() {
 }
 
 void XAdaptor::Impl::close() {
+    stopValidation();
+    
     std::lock_guard<std::mutex> lock(m_mutex);
     
     if (!m_opened) {
@@ -197,6 +305,7 @@ void XAdaptor::Impl::close() {
     std::cout << "[XAdaptor] Closing..." << std::endl;
     
     m_discoveredDevices.clear();
+    m_discoveredAdapters.clear();
     cleanupNetwork();
     
     m_opened = false;
@@ -205,6 +314,8 @@ void XAdaptor::Impl::close() {
 }
 
 int32_t XAdaptor::Impl::connect() {
+    stopValidation();
+    
     std::lock_guard<std::mutex> lock(m_mutex);
     
     if (!m_opened) {
@@ -216,6 +327,7 @@ int32_t XAdaptor::Impl::connect() {
     
     // Clear previous discoveries
     m_discoveredDevices.clear();
+    m_discoveredAdapters.clear();
     
     // Use xlibdll proxy to discover devices
     int32_t deviceCount = Internal::XLibProxy_DiscoverDevices(m_adapterIP.c_str());
@@ -234,6 +346,7 @@ int32_t XAdaptor::Impl::connect() {
         
         if (Internal::XLibProxy_GetDeviceInfo(i, &deviceInfo) == 0) {
             m_discoveredDevices.push_back(deviceInfo);
+            m_discoveredAdapters.push_back(m_adapterIP);
             
             char macStr[18];
             Internal::XLib_MACToString(deviceInfo.mac, macStr);
@@ -248,17 +361,187 @@ int32_t XAdaptor::Impl::connect() {
     return static_cast<int32_t>(m_discoveredDevices.size());
 }
 
+int32_t XAdaptor::Impl::discover(uint32_t timeout, bool allAdapters, uint32_t expected) {
+    stopValidation();
+    
+    std::vector<std::string> adapters;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        
+        if (!m_opened) {
+            reportError(8, "XAdaptor not opened");
+            return -1;
+        }
+        
+        m_discoveredDevices.clear();
+        m_discoveredAdapters.clear();
+        
+        // The bound adapter first, so its replies win duplicates
+        adapters.push_back(m_adapterIP);
+        if (allAdapters) {
+            std::vector<std::string> local;
+            listAdapters(local);
+            for (size_t i = 0; i < local.size(); ++i) {
+                if (local[i] != m_adapterIP) {
+                    adapters.push_back(local[i]);
+                }
+            }
+        }
+    }
+    
+    std::cout << "[XAdaptor] Discovering devices on " << adapters.size() << " adapter(s)..." << std::endl;
+    
+    int32_t found = collect(adapters, timeout, expected,
+                            [&](const Internal::XLibDeviceInfo& info, size_t adapter) {
+        bool duplicate = false;
+        size_t count = 0;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (size_t i = 0; i < m_discoveredDevices.size() && !duplicate; ++i) {
+                duplicate = memcmp(m_discoveredDevices[i].mac, info.mac, 6) == 0;
+            }
+            if (!duplicate) {
+                m_discoveredDevices.push_back(info);
+                m_discoveredAdapters.push_back(adapters[adapter]);
+                count = m_discoveredDevices.size();
+            }
+        }
+        if (duplicate) {
+            return false;
+        }
+        
+        char macStr[18];
+        Internal::XLib_MACToString(info.mac, macStr);
+        std::cout << "[XAdaptor] Device " << count << ": " << info.ip
+                  << " (MAC: " << macStr << ") on " << adapters[adapter] << std::endl;
+        
+        if (m_sink) {
+            m_sink->OnXDetector(toDetector(info), adapters[adapter].c_str());
+        }
+        return true;
+    });
+    
+    if (found < 0) {
+        reportError(5, "Discovery failed on all adapters");
+        return -1;
+    }
+    
+    std::cout << "[XAdaptor] Found " << found << " device(s)" << std::endl;
+    reportEvent(101, static_cast<float>(found));
+    
+    return found;
+}
+
+int32_t XAdaptor::Impl::collect(const std::vector<std::string>& adapters, uint32_t timeout,
+                                uint32_t expected,
+                                const std::function<bool(const Internal::XLibDeviceInfo&, size_t)>& onReply) {
+    // Replies from the adapter threads, handed to this thread
+    struct Reply {
+        Internal::XLibDeviceInfo info;
+        size_t adapter;
+    };
+    std::deque<Reply> replies;
+    std::mutex replyMutex;
+    std::condition_variable replyCv;
+    size_t running = adapters.size();
+    size_t failed = 0;
+    std::atomic<bool> done(false);
+    
+    const std::chrono::steady_clock::time_point deadline =
+        std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout);
+    
+    std::vector<std::thread> threads;
+    for (size_t a = 0; a < adapters.size(); ++a) {
+        threads.push_back(std::thread([&, a] {
+            int32_t session = Internal::XLibProxy_OpenDiscovery(adapters[a].c_str());
+            bool ok = session >= 0;
+            while (ok && !done && !m_cancel) {
+                const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+                if (now >= deadline) {
+                    break;
+                }
+                
+                // Short waits so an early stop is noticed
+                const int64_t left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now).count();
+                Reply reply;
+                reply.adapter = a;
+                int32_t result = Internal::XLibProxy_ReceiveDiscovery(
+                    session, &reply.info, static_cast<uint32_t>(left < 100 ? left : 100));
+                if (result > 0) {
+                    std::lock_guard<std::mutex> lock(replyMutex);
+                    replies.push_back(reply);
+                    replyCv.notify_all();
+                } else if (result != Internal::XLIB_ERROR_TIMEOUT) {
+                    std::cerr << "[XAdaptor] Discovery on " << adapters[a] << " failed: "
+                              << Internal::XLibProxy_GetErrorMessage(result) << std::endl;
+                    break;
+                }
+            }
+            if (session >= 0) {
+                Internal::XLibProxy_CloseDiscovery(session);
+            }
+            
+            std::lock_guard<std::mutex> lock(replyMutex);
+            if (!ok) {
+                ++failed;
+            }
+            --running;
+            replyCv.notify_all();
+        }));
+    }
+    
+    // Hand each reply over from this thread, one at a time
+    uint32_t accepted = 0;
+    std::unique_lock<std::mutex> lock(replyMutex);
+    for (;;) {
+        replyCv.wait(lock, [&] { return !replies.empty() || running == 0; });
+        if (replies.empty()) {
+            break;
+        }
+        Reply reply = replies.front();
+        replies.pop_front();
+        lock.unlock();
+        
+        if (onReply(reply.info, reply.adapter)) {
+            ++accepted;
+            if (expected > 0 && accepted >= expected) {
+                done = true;
+            }
+        }
+        lock.lock();
+    }
+    const bool allFailed = failed == adapters.size();
+    lock.unlock();
+    
+    for (size_t i = 0; i < threads.size(); ++i) {
+        threads[i].join();
+    }
+    
+    return allFailed ? -1 : static_cast<int32_t>(accepted);
+}
+
 XDetector XAdaptor::Impl::getDetector(uint32_t index) {
     std::lock_guard<std::mutex> lock(m_mutex);
     
-    XDetector detector;
-    
     if (index >= m_discoveredDevices.size()) {
         reportError(5, "Device index out of range");
-        return detector;
+        return XDetector();
     }
     
-    const Internal::XLibDeviceInfo& info = m_discoveredDevices[index];
+    return toDetector(m_discoveredDevices[index]);
+}
+
+std::string XAdaptor::Impl::getDetectorAdapter(uint32_t index) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    if (index >= m_discoveredAdapters.size()) {
+        return std::string();
+    }
+    return m_discoveredAdapters[index];
+}
+
+XDetector XAdaptor::Impl::toDetector(const Internal::XLibDeviceInfo& info) const {
+    XDetector detector;
     
     // Convert XLibDeviceInfo to XDetector
     detector.SetIP(info.ip);
@@ -274,6 +557,8 @@ XDetector XAdaptor::Impl::getDetector(uint32_t index) {
 }
 
 int32_t XAdaptor::Impl::configDetector(const XDetector& det) {
+    stopValidation();
+    
     std::lock_guard<std::mutex> lock(m_mutex);
     
     if (!m_opened) {
@@ -319,15 +604,31 @@ int32_t XAdaptor::Impl::configDetector(const XDetector& det) {
     }
     
     std::cout << "[XAdaptor] Device configured successfully" << std::endl;
-    std::cout << "[XAdaptor] Please wait for device to reboot..." << std::endl;
+    std::cout << "[XAdaptor] Waiting for device to reboot..." << std::endl;
+    
+    // Ready once it answers with the new settings
+    std::vector<Internal::XLibDeviceInfo> devices(1);
+    memset(&devices[0], 0, sizeof(Internal::XLibDeviceInfo));
+    memcpy(devices[0].mac, mac, 6);
+    snprintf(devices[0].ip, sizeof(devices[0].ip), "%s", det.GetIP().c_str());
+    devices[0].cmdPort = det.GetCmdPort();
+    devices[0].imgPort = det.GetImgPort();
+    
+    std::vector<bool> ready;
+    if (waitReady(devices, ready) == 0) {
+        reportError(7, "Device did not answer on its new address");
+        return -1;
+    }
+    refreshDevice(devices[0]);
     
-    // Wait for device reboot
-    std::this_thread::sleep_for(std::chrono::seconds(3));
+    std::cout << "[XAdaptor] Device ready on " << det.GetIP() << std::endl;
     
     return 1;
 }
 
 int32_t XAdaptor::Impl::restore() {
+    stopValidation();
+    
     std::lock_guard<std::mutex> lock(m_mutex);
     
     if (!m_opened) {
@@ -344,6 +645,9 @@ int32_t XAdaptor::Impl::restore() {
     
     int32_t successCount = 0;
     
+    // Devices reset, with the settings they come back with
+    std::vector<Internal::XLibDeviceInfo> restored;
+    
     for (const auto& device : m_discoveredDevices) {
         char macStr[18];
         Internal::XLib_MACToString(device.mac, macStr);
@@ -355,6 +659,12 @@ int32_t XAdaptor::Impl::restore() {
         if (result == 0) {
             successCount++;
             std::cout << "[XAdaptor] Device restored successfully" << std::endl;
+            
+            Internal::XLibDeviceInfo expected = device;
+            snprintf(expected.ip, sizeof(expected.ip), "%s", "192.168.1.2");
+            expected.cmdPort = 3000;
+            expected.imgPort = 4001;
+            restored.push_back(expected);
         } else {
             const char* errorMsg = Internal::XLibProxy_GetErrorMessage(result);
             std::cerr << "[XAdaptor] Failed to restore device: " << errorMsg << std::endl;
@@ -367,27 +677,348 @@ int32_t XAdaptor::Impl::restore() {
         std::cout << "[XAdaptor] Default Cmd Port: 3000" << std::endl;
         std::cout << "[XAdaptor] Default Img Port: 4001" << std::endl;
         
-        // Wait for devices to reboot
-        std::this_thread::sleep_for(std::chrono::seconds(3));
+        // All reboot at once; wait for them together
+        std::vector<bool> ready;
+        const uint32_t readyCount = waitReady(restored, ready);
+        for (size_t i = 0; i < restored.size(); ++i) {
+            if (ready[i]) {
+                refreshDevice(restored[i]);
+            }
+        }
+        if (readyCount < restored.size()) {
+            reportError(7, "Device did not answer after restore");
+        }
+        std::cout << "[XAdaptor] " << readyCount << " of " << restored.size()
+                  << " device(s) ready" << std::endl;
     }
     
     return (successCount > 0) ? 1 : -1;
 }
 
-void XAdaptor::Impl::reportError(uint32_t errorId, const char* message) {
-    std::cerr << "[XAdaptor] ERROR " << errorId << ": " << message << std::endl;
+uint32_t XAdaptor::Impl::waitReady(std::vector<Internal::XLibDeviceInfo>& devices,
+                                   std::vector<bool>& ready) {
+    // Replies right after the command may still come from the old firmware
+    // state, so give the reboot a moment to start
+    const std::chrono::milliseconds REBOOT_GRACE(500);
+    const uint32_t ROUND_MS = 250;
+    
+    ready.assign(devices.size(), false);
+    uint32_t readyCount = 0;
+    
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    const std::chrono::steady_clock::time_point deadline =
+        start + std::chrono::milliseconds(m_rebootTimeout);
+    std::this_thread::sleep_until(std::min(start + REBOOT_GRACE, deadline));
     
-    if (m_sink) {
-        m_sink->OnXError(errorId, message);
+    // One broadcast per round; a device still booting misses the ones before
+    while (readyCount < devices.size() && std::chrono::steady_clock::now() < deadline) {
+        const std::chrono::steady_clock::time_point roundEnd =
+            std::min(std::chrono::steady_clock::now() + std::chrono::milliseconds(ROUND_MS), deadline);
+        
+        int32_t session = Internal::XLibProxy_OpenDiscovery(m_adapterIP.c_str());
+        if (session < 0) {
+            std::this_thread::sleep_until(roundEnd);
+            continue;
+        }
+        
+        for (;;) {
+            const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+            if (now >= roundEnd || readyCount == devices.size()) {
+                break;
+            }
+            Internal::XLibDeviceInfo reply;
+            const int64_t left = std::chrono::duration_cast<std::chrono::milliseconds>(roundEnd - now).count();
+            int32_t result = Internal::XLibProxy_ReceiveDiscovery(session, &reply,
+                                                                  static_cast<uint32_t>(left));
+            if (result <= 0) {
+                if (result != Internal::XLIB_ERROR_TIMEOUT) {
+                    std::this_thread::sleep_until(roundEnd);
+                }
+                break;
+            }
+            for (size_t i = 0; i < devices.size(); ++i) {
+                if (!ready[i] && memcmp(devices[i].mac, reply.mac, 6) == 0 &&
+                    strcmp(devices[i].ip, reply.ip) == 0 &&
+                    devices[i].cmdPort == reply.cmdPort && devices[i].imgPort == reply.imgPort) {
+                    devices[i] = reply;
+                    ready[i] = true;
+                    ++readyCount;
+                }
+            }
+        }
+        Internal::XLibProxy_CloseDiscovery(session);
     }
+    
+    return readyCount;
 }
 
-void XAdaptor::Impl::reportEvent(uint32_t eventId, float data) {
-    if (m_sink) {
-        m_sink->OnXEvent(eventId, data);
+void XAdaptor::Impl::refreshDevice(const Internal::XLibDeviceInfo& info) {
+    for (size_t i = 0; i < m_discoveredDevices.size(); ++i) {
+        if (memcmp(m_discoveredDevices[i].mac, info.mac, 6) == 0) {
+            m_discoveredDevices[i] = info;
+        }
     }
 }
 
+bool XAdaptor::Impl::saveInventory(const std::string& file) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    std::ofstream out(file.c_str(), std::ios::trunc);
+    if (!out) {
+        reportError(9, "Cannot write inventory file");
+        return false;
+    }
+    
+    // One device per line; the serial number last, as it may hold spaces
+    out << "HXINV 1\n";
+    for (size_t i = 0; i < m_discoveredDevices.size(); ++i) {
+        const Internal::XLibDeviceInfo& info = m_discoveredDevices[i];
+        char macStr[18];
+        Internal::XLib_MACToString(info.mac, macStr);
+        out << macStr << ' ' << info.ip << ' ' << info.cmdPort << ' ' << info.imgPort << ' '
+            << m_discoveredAdapters[i] << ' ' << info.pixelCount << ' '
+            << static_cast<uint32_t>(info.moduleCount) << ' '
+            << static_cast<uint32_t>(info.cardType) << ' ' << info.firmwareVersion << ' '
+            << info.serialNumber << '\n';
+    }
+    
+    out.flush();
+    if (!out) {
+        reportError(9, "Cannot write inventory file");
+        return false;
+    }
+    
+    std::cout << "[XAdaptor] Saved " << m_discoveredDevices.size() << " device(s) to " << file << std::endl;
+    return true;
+}
+
+int32_t XAdaptor::Impl::loadInventory(const std::string& file, uint32_t timeout) {
+    stopValidation();
+    
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    if (!m_opened) {
+        reportError(8, "XAdaptor not opened");
+        return -1;
+    }
+    
+    std::ifstream in(file.c_str());
+    if (!in) {
+        reportError(9, "Cannot open inventory file");
+        return -1;
+    }
+    
+    std::string line;
+    if (!std::getline(in, line) || line != "HXINV 1") {
+        reportError(9, "Invalid inventory file");
+        return -1;
+    }
+    
+    std::vector<Internal::XLibDeviceInfo> devices;
+    std::vector<std::string> deviceAdapters;
+    while (std::getline(in, line)) {
+        if (line.empty()) {
+            continue;
+        }
+        std::istringstream fields(line);
+        std::string mac, ip, adapter, serial;
+        uint32_t cmdPort = 0, imgPort = 0, pixelCount = 0, moduleCount = 0, cardType = 0, firmware = 0;
+        fields >> mac >> ip >> cmdPort >> imgPort >> adapter >> pixelCount >> moduleCount
+               >> cardType >> firmware;
+        std::getline(fields, serial);
+        if (!serial.empty() && serial[0] == ' ') {
+            serial.erase(0, 1);
+        }
+        
+        Internal::XLibDeviceInfo info;
+        memset(&info, 0, sizeof(info));
+        if (fields.bad() || !Internal::XLib_StringToMAC(mac.c_str(), info.mac) ||
+            !validateIP(ip) || !validateIP(adapter) || cmdPort == 0 || cmdPort > 0xFFFF ||
+            imgPort == 0 || imgPort > 0xFFFF || serial.size() >= sizeof(info.serialNumber)) {
+            reportError(9, "Invalid inventory file");
+            return -1;
+        }
+        snprintf(info.ip, sizeof(info.ip), "%s", ip.c_str());
+        snprintf(info.serialNumber, sizeof(info.serialNumber), "%s", serial.c_str());
+        info.cmdPort = static_cast<uint16_t>(cmdPort);
+        info.imgPort = static_cast<uint16_t>(imgPort);
+        info.pixelCount = pixelCount;
+        info.moduleCount = static_cast<uint8_t>(moduleCount);
+        info.cardType = static_cast<uint8_t>(cardType);
+        info.firmwareVersion = static_cast<uint16_t>(firmware);
+        devices.push_back(info);
+        deviceAdapters.push_back(adapter);
+    }
+    
+    m_discoveredDevices.swap(devices);
+    m_discoveredAdapters = deviceAdapters;
+    
+    std::cout << "[XAdaptor] Loaded " << m_discoveredDevices.size() << " device(s) from " << file << std::endl;
+    reportEvent(101, static_cast<float>(m_discoveredDevices.size()));
+    
+    if (timeout > 0) {
+        // Check on the adapters the inventory names, the bound one first
+        std::vector<std::string> adapters(1, m_adapterIP);
+        for (size_t i = 0; i < deviceAdapters.size(); ++i) {
+            if (std::find(adapters.begin(), adapters.end(), deviceAdapters[i]) == adapters.end()) {
+                adapters.push_back(deviceAdapters[i]);
+            }
+        }
+        std::lock_guard<std::mutex> validation(m_validationMutex);
+        m_validationThread = std::thread(&XAdaptor::Impl::validateInventory, this, adapters, timeout);
+    }
+    
+    return static_cast<int32_t>(m_discoveredDevices.size());
+}
+
+void XAdaptor::Impl::validateInventory(std::vector<std::string> adapters, uint32_t timeout) {
+    std::vector<Internal::XLibDeviceInfo> known;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        known = m_discoveredDevices;
+    }
+    std::vector<bool> seen(known.size(), false);
+    
+    // Stop once every inventoried device answered
+    int32_t answered = collect(adapters, timeout, static_cast<uint32_t>(known.size()),
+                               [&](const Internal::XLibDeviceInfo& info, size_t adapter) {
+        size_t k = 0;
+        while (k < known.size() && memcmp(known[k].mac, info.mac, 6) != 0) {
+            ++k;
+        }
+        if (k < known.size() && seen[k]) {
+            return false;
+        }
+        
+        // Unchanged devices are left alone; moved or new ones are published
+        const bool changed = k == known.size() || strcmp(known[k].ip, info.ip) != 0 ||
+            known[k].cmdPort != info.cmdPort || known[k].imgPort != info.imgPort ||
+            strcmp(known[k].serialNumber, info.serialNumber) != 0 ||
+            known[k].pixelCount != info.pixelCount || known[k].moduleCount != info.moduleCount ||
+            known[k].cardType != info.cardType || known[k].firmwareVersion != info.firmwareVersion;
+        if (changed) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            size_t i = 0;
+            while (i < m_discoveredDevices.size() && memcmp(m_discoveredDevices[i].mac, info.mac, 6) != 0) {
+                ++i;
+            }
+            if (i == m_discoveredDevices.size()) {
+                m_discoveredDevices.push_back(info);
+                m_discoveredAdapters.push_back(adapters[adapter]);
+            } else {
+                m_discoveredDevices[i] = info;
+                m_discoveredAdapters[i] = adapters[adapter];
+            }
+        }
+        if (changed && m_sink) {
+            m_sink->OnXDetector(toDetector(info), adapters[adapter].c_str());
+        }
+        
+        if (k == known.size()) {
+            known.push_back(info);
+            seen.push_back(true);
+            return false;
+        }
+        seen[k] = true;
+        return true;
+    });
+    
+    if (answered < 0) {
+        if (!m_cancel) {
+            reportError(5, "Inventory validation failed on all adapters");
+        }
+        return;
+    }
+    if (m_cancel) {
+        return;
+    }
+    
+    uint32_t missing = 0;
+    for (size_t k = 0; k < known.size(); ++k) {
+        if (!seen[k]) {
+            char macStr[18];
+            Internal::XLib_MACToString(known[k].mac, macStr);
+            std::cerr << "[XAdaptor] Inventoried device " << macStr << " did not answer" << std::endl;
+            ++missing;
+        }
+    }
+    std::cout << "[XAdaptor] Inventory validated, " << missing << " device(s) missing" << std::endl;
+    reportEvent(102, static_cast<float>(missing));
+}
+
+int32_t XAdaptor::Impl::inspectNetwork(const XDetector& det, double lineRate,
+                                       std::vector<XAdaptor::NetworkReport>& reports,
+                                       uint32_t recvBufferSize, bool allAdapters) {
+    reports.clear();
+    if (!(lineRate > 0.0) || det.GetPixelCount() == 0) {
+        reportError(4, "Line rate and pixel count must be positive");
+        return -1;
+    }
+    
+    std::vector<std::string> adapters;
+    if (allAdapters) {
+        listAdapters(adapters);
+    } else {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_adapterIP.empty()) {
+            adapters.push_back(m_adapterIP);
+        }
+    }
+    if (adapters.empty()) {
+        reportError(4, allAdapters ? "No network adapter is up" : "Adapter IP not set");
+        return -1;
+    }
+    
+    Internal::NetRequirement need;
+    need.lineRate = lineRate;
+    need.packetBytes = det.GetPixelCount() * ((det.GetPixelDepth() + 7) / 8) +
+                       Internal::XLIB_PACKET_HEADER_SIZE;
+    need.recvBufferBytes = recvBufferSize;
+    need.receiveCpus = XFactory::GetThreadPolicy(XFactory::THREAD_RECEIVE).cpuMask;
+    need.detectorIP = det.GetIP();
+    
+    int32_t failed = 0;
+    for (size_t i = 0; i < adapters.size(); ++i) {
+        XAdaptor::NetworkReport report;
+        if (!Internal::NetInspectAdapter(adapters[i], need, report)) {
+            HX_LOG_WARNING("XAdaptor") << "No interface has address " << adapters[i];
+        }
+        for (size_t c = 0; c < report.checks.size(); ++c) {
+            const XAdaptor::NetworkCheck& check = report.checks[c];
+            if (check.status == XAdaptor::CHECK_FAIL || check.status == XAdaptor::CHECK_WARN) {
+                HX_LOG_WARNING("XAdaptor") << report.adapter << " (" << report.interfaceName << ") "
+                                           << check.name << " " << check.value << ", needs "
+                                           << check.required;
+            }
+        }
+        if (!report.pass) {
+            ++failed;
+        }
+        reports.push_back(report);
+    }
+    HX_LOG_INFO("XAdaptor") << "Network inspected at " << lineRate << " lines/s: " << failed
+                            << " of " << adapters.size() << " adapter(s) failed";
+    return failed;
+}
+
+void XAdaptor::Impl::stopValidation() {
+    std::lock_guard<std::mutex> validation(m_validationMutex);
+    if (m_validationThread.joinable()) {
+        m_cancel = true;
+        m_validationThread.join();
+        m_cancel = false;
+    }
+}
+
+void XAdaptor::Impl::reportError(uint32_t errorId, const char* message) {
+    HX_LOG_ID(::HX::XFactory::LOG_ERROR, "XAdaptor", errorId) << "ERROR " << errorId << ": " << message;
+    m_notify.error(errorId, message);
+}
+
+void XAdaptor::Impl::reportEvent(uint32_t eventId, float data) {
+    m_notify.event(eventId, data);
+}
+
 // ============================================================================
 // XAdaptor Public Interface Implementation
 // ============================================================================
@@ -426,6 +1057,7 @@ bool XAdaptor::Open() {
 void XAdaptor::Close() {
     if (m_impl) {
         m_impl->close();
+        Internal::NotifyFlush();
     }
 }
 
@@ -443,6 +1075,13 @@ int32_t XAdaptor::Connect() {
     return m_impl->connect();
 }
 
+int32_t XAdaptor::Discover(uint32_t timeout, bool allAdapters, uint32_t expected) {
+    if (!m_impl) {
+        return -1;
+    }
+    return m_impl->discover(timeout, allAdapters, expected);
+}
+
 XDetector XAdaptor::GetDetector(uint32_t index) {
     if (!m_impl) {
         return XDetector();
@@ -450,6 +1089,13 @@ XDetector XAdaptor::GetDetector(uint32_t index) {
     return m_impl->getDetector(index);
 }
 
+std::string XAdaptor::GetDetectorAdapter(uint32_t index) {
+    if (!m_impl) {
+        return std::string();
+    }
+    return m_impl->getDetectorAdapter(index);
+}
+
 int32_t XAdaptor::ConfigDetector(const XDetector& det) {
     if (!m_impl) {
         return -1;
@@ -470,4 +1116,37 @@ void XAdaptor::SetSink(IXCmdSink* sink_) {
     }
 }
 
+bool XAdaptor::SaveInventory(const std::string& file) {
+    if (!m_impl) {
+        return false;
+    }
+    return m_impl->saveInventory(file);
+}
+
+int32_t XAdaptor::LoadInventory(const std::string& file, uint32_t timeout) {
+    if (!m_impl) {
+        return -1;
+    }
+    return m_impl->loadInventory(file, timeout);
+}
+
+int32_t XAdaptor::InspectNetwork(const XDetector& det, double lineRate, std::vector<NetworkReport>& reports,
+                                 uint32_t recvBufferSize, bool allAdapters) {
+    if (!m_impl) {
+        reports.clear();
+        return -1;
+    }
+    return m_impl->inspectNetwork(det, lineRate, reports, recvBufferSize, allAdapters);
+}
+
+std::string XAdaptor::NetworkReportJson(const std::vector<NetworkReport>& reports) {
+    return Internal::NetReportJson(reports);
+}
+
+void XAdaptor::SetRebootTimeout(uint32_t timeout) {
+    if (m_impl) {
+        m_impl->setRebootTimeout(timeout);
+    }
+}
+
 } // namespace HX
\ No newline at end of file
@@ -0,0 +1,137 @@
+// ============================================================================
+// XArchiveIndex.cpp - Capture directory metadata index
+// ============================================================================
+
+/**
+ * @file XArchiveIndex.cpp
+ * @brief XArchiveIndex implementation - queries over hxindex.dat
+ * @version 2.1.0
+ */
+
+#include "XArchiveIndex.h"
+#include "utils/archive_index.h"
+#include "utils/logger.h"
+#include <climits>
+#include <map>
+#include <vector>
+
+namespace HX {
+
+const char* const XArchiveIndex::FILE_NAME = "hxindex.dat";
+
+XArchiveIndex::Record::Record()
+    : cols(0), rows(0), depth(0), dmNum(0), dmType(0), dmPix(0), opMode(0)
+    , intTime(0), energy(0), bin(0), temp(0.0f), humidity(0.0f)
+    , compression(0), tileSize(0), dataOffset(0), fileSize(0)
+{
+}
+
+XArchiveIndex::Query::Query()
+    : intTimeMin(0), intTimeMax(UINT_MAX)
+{
+}
+
+class XArchiveIndex::Impl {
+public:
+    bool open(const std::string& directory);
+    uint32_t getCount() const;
+    bool getRecord(uint32_t index, Record& record) const;
+    uint32_t find(const Query& query, uint32_t start) const;
+
+private:
+    static bool matches(const Record& record, const Query& query);
+
+    std::vector<Record> m_records;
+};
+
+bool XArchiveIndex::Impl::open(const std::string& directory) {
+    std::vector<Record> records;
+    if (!Internal::LoadArchiveRecords(directory, records)) {
+        HX_LOG_WARNING("XArchiveIndex") << "No index in " << directory;
+        m_records.clear();
+        return false;
+    }
+
+    // A rewritten file keeps its first position and takes its latest record
+    std::map<std::string, size_t> position;
+    m_records.clear();
+    for (size_t i = 0; i < records.size(); ++i) {
+        std::map<std::string, size_t>::iterator it = position.find(records[i].file);
+        if (it == position.end()) {
+            position[records[i].file] = m_records.size();
+            m_records.push_back(records[i]);
+        } else {
+            m_records[it->second] = records[i];
+        }
+    }
+    return true;
+}
+
+uint32_t XArchiveIndex::Impl::getCount() const {
+    return static_cast<uint32_t>(m_records.size());
+}
+
+bool XArchiveIndex::Impl::getRecord(uint32_t index, Record& record) const {
+    if (index >= m_records.size()) {
+        return false;
+    }
+    record = m_records[index];
+    return true;
+}
+
+bool XArchiveIndex::Impl::matches(const Record& record, const Query& query) {
+    if (!query.serialNum.empty() && record.serialNum != query.serialNum) {
+        return false;
+    }
+    if (!query.dateFrom.empty() && record.dateTime < query.dateFrom) {
+        return false;
+    }
+    if (!query.dateTo.empty() && record.dateTime >= query.dateTo) {
+        return false;
+    }
+    return record.intTime >= query.intTimeMin && record.intTime <= query.intTimeMax;
+}
+
+uint32_t XArchiveIndex::Impl::find(const Query& query, uint32_t start) const {
+    for (size_t i = start; i < m_records.size(); ++i) {
+        if (matches(m_records[i], query)) {
+            return static_cast<uint32_t>(i);
+        }
+    }
+    return getCount();
+}
+
+// ============================================================================
+// Public interface
+// ============================================================================
+
+XArchiveIndex::XArchiveIndex()
+    : m_impl(new Impl())
+{
+}
+
+XArchiveIndex::~XArchiveIndex() {
+    delete m_impl;
+}
+
+bool XArchiveIndex::Open(const std::string& directory) {
+    if (!m_impl) return false;
+    return m_impl->open(directory);
+}
+
+uint32_t XArchiveIndex::GetCount() const {
+    if (!m_impl) return 0;
+    return m_impl->getCount();
+}
+
+bool XArchiveIndex::GetRecord(uint32_t index, Record& record) const {
+    if (!m_impl) return false;
+    return m_impl->getRecord(index, record);
+}
+
+uint32_t XArchiveIndex::Find(const Query& query, uint32_t start) const {
+    if (!m_impl) return 0;
+    return m_impl->find(query, start);
+}
+
+} // namespace HX
@@ -0,0 +1,743 @@
+// ============================================================================
+// XBatcher.cpp - Inference batches of frames or tiles
+// ============================================================================
+
+/**
+ * @file XBatcher.cpp
+ * @brief XBatcher implementation - tiling, float16 conversion, batch hand-off
+ * @version 2.1.0
+ */
+
+#include "XBatcher.h"
+#include "XImage.h"
+#include "ixbatch_sink.h"
+#include "iximg_sink.h"
+#include "utils/half_float.h"
+#include "utils/logger.h"
+#include "utils/mem_budget.h"
+#include "utils/thread_pool.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+namespace HX {
+
+namespace {
+
+/// Buffer alignment and size granularity
+const size_t PAGE_BYTES = 4096;
+
+const uint32_t MAX_BATCH_SIZE = 1024;
+const uint32_t MIN_BUFFERS = 2;
+const uint32_t MAX_BUFFERS = 64;
+
+/// Hand-off thread wake-up while a flush timeout is set
+const uint32_t MAX_POLL_MS = 100;
+
+uint8_t* pageAlloc(size_t size) {
+#ifdef _WIN32
+    return static_cast<uint8_t*>(_aligned_malloc(size, PAGE_BYTES));
+#else
+    void* ptr = nullptr;
+    if (posix_memalign(&ptr, PAGE_BYTES, size) != 0) {
+        return nullptr;
+    }
+    return static_cast<uint8_t*>(ptr);
+#endif
+}
+
+void pageFree(uint8_t* ptr) {
+#ifdef _WIN32
+    _aligned_free(ptr);
+#else
+    free(ptr);
+#endif
+}
+
+/**
+ * @brief Item origins along one axis
+ *
+ * Steps of item - overlap, the last origin moved back so the item ends at
+ * the frame's edge; a frame no longer than the item has one origin, 0.
+ */
+void tileOrigins(uint32_t frame, uint32_t item, uint32_t overlap, std::vector<uint32_t>& origins) {
+    origins.clear();
+    if (frame <= item) {
+        origins.push_back(0);
+        return;
+    }
+    const uint32_t step = item - overlap;
+    const uint32_t last = frame - item;
+    for (uint32_t origin = 0;; origin += step) {
+        if (origin >= last) {
+            origins.push_back(last);
+            break;
+        }
+        origins.push_back(origin);
+    }
+}
+
+uint64_t nowNs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+} // anonymous namespace
+
+class XBatcher::Impl {
+public:
+    Impl();
+    ~Impl();
+
+    void setSink(IXImgSink* sink_) { m_sink = sink_; }
+    bool setBatchSink(IXBatchSink* sink_);
+    bool setBatchSize(uint32_t items);
+    bool setBufferCount(uint32_t count);
+    uint32_t getBufferCount() const;
+    bool setTileOverlap(uint32_t pixels);
+    bool setOutputType(XOutputType type);
+    bool setNormalization(float offset, float scale);
+    bool setFlushTimeout(uint32_t ms);
+    bool setAllocator(XFactory* factory, const XFactory::AllocOptions& options);
+
+    bool start(uint32_t itemWidth, uint32_t itemHeight);
+    void stop();
+    bool isRunning() const;
+    bool submit(const XImage* image);
+    bool flush();
+    bool release(uint32_t buffer);
+    Statistics getStatistics() const;
+
+private:
+    enum BufferState {
+        BUFFER_FREE = 0,
+        BUFFER_FILLING,
+        BUFFER_QUEUED,      ///< Waiting for the hand-off thread
+        BUFFER_HELD         ///< Handed to the sink, not yet released
+    };
+
+    struct Buffer {
+        uint8_t* data;
+        uint64_t charged;               ///< Bytes charged to memory profiling
+        std::vector<XBatchItem> items;
+        uint32_t count;
+        BufferState state;
+    };
+
+    template <typename Value>
+    void convertItems(const XImage& image, const std::vector<uint32_t>& xs,
+                      const std::vector<uint32_t>& ys, uint32_t first, uint32_t count,
+                      uint8_t* out, float offset, float scale);
+    bool takeBuffer();
+    bool finishFilling(bool partial);
+    void handoffThread();
+    void freeBuffers();
+    void reportError(uint32_t errorId, const char* message);
+    void reportEvent(uint32_t eventId, uint32_t data);
+
+    IXImgSink* m_sink;
+    IXBatchSink* m_batchSink;
+
+    // Settings, fixed while running
+    uint32_t m_batchSize;
+    uint32_t m_bufferCount;
+    uint32_t m_overlap;
+    XOutputType m_type;
+    float m_offset;
+    float m_scale;                      ///< 0 = from the frame's depth
+    uint32_t m_flushMs;
+    XFactory* m_factory;
+    XFactory::AllocOptions m_allocOptions;
+    uint32_t m_itemWidth;
+    uint32_t m_itemHeight;
+    size_t m_itemBytes;
+
+    // Filling buffer, guarded by m_submitMutex
+    std::mutex m_submitMutex;
+    int m_filling;                      ///< Buffer index, -1 = none
+    uint64_t m_fillStartNs;             ///< First item of the filling buffer
+    std::vector<uint32_t> m_originsX;
+    std::vector<uint32_t> m_originsY;
+
+    // Buffer states, queue and counters, guarded by m_mutex
+    mutable std::mutex m_mutex;
+    std::condition_variable m_workCv;
+    std::vector<Buffer> m_buffers;
+    std::deque<uint32_t> m_queue;
+    std::thread m_thread;
+    bool m_running;
+    bool m_stopping;
+    uint64_t m_batchIndex;
+    Statistics m_stats;
+};
+
+XBatcher::Impl::Impl()
+    : m_sink(nullptr)
+    , m_batchSink(nullptr)
+    , m_batchSize(8)
+    , m_bufferCount(4)
+    , m_overlap(0)
+    , m_type(XBATCH_FLOAT16)
+    , m_offset(0.0f)
+    , m_scale(0.0f)
+    , m_flushMs(0)
+    , m_factory(nullptr)
+    , m_itemWidth(0)
+    , m_itemHeight(0)
+    , m_itemBytes(0)
+    , m_filling(-1)
+    , m_fillStartNs(0)
+    , m_running(false)
+    , m_stopping(false)
+    , m_batchIndex(0)
+{
+    memset(&m_stats, 0, sizeof(m_stats));
+}
+
+XBatcher::Impl::~Impl() {
+    stop();
+    freeBuffers();
+}
+
+bool XBatcher::Impl::setBatchSink(IXBatchSink* sink_) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_running) {
+        return false;
+    }
+    m_batchSink = sink_;
+    return true;
+}
+
+bool XBatcher::Impl::setBatchSize(uint32_t items) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_running || items == 0 || items > MAX_BATCH_SIZE) {
+        return false;
+    }
+    m_batchSize = items;
+    return true;
+}
+
+bool XBatcher::Impl::setBufferCount(uint32_t count) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_running || count < MIN_BUFFERS || count > MAX_BUFFERS) {
+        return false;
+    }
+    m_bufferCount = count;
+    return true;
+}
+
+uint32_t XBatcher::Impl::getBufferCount() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_bufferCount;
+}
+
+bool XBatcher::Impl::setTileOverlap(uint32_t pixels) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_running) {
+        return false;
+    }
+    m_overlap = pixels;
+    return true;
+}
+
+bool XBatcher::Impl::setOutputType(XOutputType type) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_running || (type != XBATCH_FLOAT16 && type != XBATCH_FLOAT32)) {
+        return false;
+    }
+    m_type = type;
+    return true;
+}
+
+bool XBatcher::Impl::setNormalization(float offset, float scale) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_running) {
+        return false;
+    }
+    m_offset = offset;
+    m_scale = scale;
+    return true;
+}
+
+bool XBatcher::Impl::setFlushTimeout(uint32_t ms) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_running) {
+        return false;
+    }
+    m_flushMs = ms;
+    return true;
+}
+
+bool XBatcher::Impl::setAllocator(XFactory* factory, const XFactory::AllocOptions& options) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_running) {
+        return false;
+    }
+    m_factory = factory;
+    m_allocOptions = options;
+    return true;
+}
+
+bool XBatcher::Impl::start(uint32_t itemWidth, uint32_t itemHeight) {
+    std::lock_guard<std::mutex> submitLock(m_submitMutex);
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (m_running || !m_batchSink || itemWidth == 0 || itemHeight == 0 ||
+        m_overlap >= std::min(itemWidth, itemHeight)) {
+        return false;
+    }
+
+    lock.unlock();
+    freeBuffers();
+    lock.lock();
+    m_itemWidth = itemWidth;
+    m_itemHeight = itemHeight;
+    m_itemBytes = static_cast<size_t>(itemWidth) * itemHeight * (m_type == XBATCH_FLOAT16 ? 2 : 4);
+    const size_t bytes = (m_itemBytes * m_batchSize + PAGE_BYTES - 1) & ~(PAGE_BYTES - 1);
+    if (!Internal::MemBudgetAdmit(static_cast<uint64_t>(bytes) * m_bufferCount)) {
+        lock.unlock();
+        reportError(50, "Batch buffers do not fit the memory budget");
+        return false;
+    }
+    m_buffers.resize(m_bufferCount);
+    for (size_t i = 0; i < m_buffers.size(); ++i) {
+        Buffer& buffer = m_buffers[i];
+        buffer.charged = 0;
+        if (m_factory) {
+            buffer.data = static_cast<uint8_t*>(m_factory->AllocateEx(bytes, m_allocOptions));
+        } else {
+            buffer.data = pageAlloc(bytes);
+            if (buffer.data && Internal::MemProfiling()) {
+                buffer.charged = bytes;
+                Internal::MemProfileAlloc(XFactory::MEM_OTHER, bytes);
+            }
+        }
+        buffer.items.assign(m_batchSize, XBatchItem());
+        buffer.count = 0;
+        buffer.state = BUFFER_FREE;
+        if (!buffer.data) {
+            m_buffers.resize(i);
+            lock.unlock();
+            freeBuffers();
+            reportError(50, "Out of memory for batch buffers");
+            return false;
+        }
+    }
+
+    m_queue.clear();
+    m_filling = -1;
+    m_batchIndex = 0;
+    memset(&m_stats, 0, sizeof(m_stats));
+    m_stats.buffersFree = m_bufferCount;
+    m_stopping = false;
+    m_running = true;
+    m_thread = std::thread(&Impl::handoffThread, this);
+
+    HX_LOG_INFO("XBatcher") << "Started: " << m_batchSize << " x " << itemWidth << "x" << itemHeight
+                            << (m_type == XBATCH_FLOAT16 ? " float16" : " float32") << ", "
+                            << m_bufferCount << " buffers of " << (bytes >> 10) << " KB";
+    return true;
+}
+
+void XBatcher::Impl::stop() {
+    {
+        std::lock_guard<std::mutex> submitLock(m_submitMutex);
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!m_running) {
+                return;
+            }
+        }
+        finishFilling(true);
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_workCv.notify_all();
+    m_thread.join();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_running = false;
+    m_stopping = false;
+}
+
+bool XBatcher::Impl::isRunning() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_running;
+}
+
+void XBatcher::Impl::freeBuffers() {
+    for (size_t i = 0; i < m_buffers.size(); ++i) {
+        Buffer& buffer = m_buffers[i];
+        if (!buffer.data) {
+            continue;
+        }
+        if (m_factory) {
+            m_factory->Free(buffer.data);
+        } else {
+            pageFree(buffer.data);
+            if (buffer.charged > 0) {
+                Internal::MemProfileFree(XFactory::MEM_OTHER, buffer.charged);
+            }
+        }
+        buffer.data = nullptr;
+    }
+    m_buffers.clear();
+}
+
+bool XBatcher::Impl::takeBuffer() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (size_t i = 0; i < m_buffers.size(); ++i) {
+        if (m_buffers[i].state == BUFFER_FREE) {
+            m_buffers[i].state = BUFFER_FILLING;
+            m_buffers[i].count = 0;
+            m_stats.buffersFree--;
+            m_filling = static_cast<int>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool XBatcher::Impl::finishFilling(bool partial) {
+    // Caller holds m_submitMutex
+    if (m_filling < 0) {
+        return false;
+    }
+    std::unique_lock<std::mutex> lock(m_mutex);
+    Buffer& buffer = m_buffers[m_filling];
+    if (buffer.count == 0) {
+        return false;
+    }
+    buffer.state = BUFFER_QUEUED;
+    m_queue.push_back(static_cast<uint32_t>(m_filling));
+    if (partial && buffer.count < m_batchSize) {
+        m_stats.batchesPartial++;
+    }
+    m_filling = -1;
+    lock.unlock();
+    m_workCv.notify_one();
+    return true;
+}
+
+template <typename Value>
+void XBatcher::Impl::convertItems(const XImage& image, const std::vector<uint32_t>& xs,
+                                  const std::vector<uint32_t>& ys, uint32_t first, uint32_t count,
+                                  uint8_t* out, float offset, float scale) {
+    const uint32_t itemWidth = m_itemWidth;
+    const uint32_t itemHeight = m_itemHeight;
+    const uint32_t bytesPerPixel = (image._pixel_depth + 7) / 8;
+    const uint32_t columns = static_cast<uint32_t>(xs.size());
+    const size_t itemValues = static_cast<size_t>(itemWidth) * itemHeight;
+    const Internal::HalfRowKernel halfKernel = Internal::selectHalfKernel(bytesPerPixel);
+    const Internal::FloatRowKernel floatKernel = Internal::selectFloatKernel(bytesPerPixel);
+
+    // One pool row per item row, the items one after another
+    Internal::ThreadPool::instance().parallelRows(
+        static_cast<int>(count * itemHeight), static_cast<int>(itemWidth),
+        [&](int firstRow, int endRow) {
+            for (int r = firstRow; r < endRow; ++r) {
+                const uint32_t item = static_cast<uint32_t>(r) / itemHeight;
+                const uint32_t row = static_cast<uint32_t>(r) % itemHeight;
+                const uint32_t tile = first + item;
+                const uint32_t x = xs[tile % columns];
+                const uint32_t y = ys[tile / columns];
+                Value* dst = reinterpret_cast<Value*>(out) + item * itemValues +
+                             static_cast<size_t>(row) * itemWidth;
+
+                const uint32_t valid = std::min(itemWidth, image._width - x);
+                if (y + row >= image._height) {
+                    memset(dst, 0, itemWidth * sizeof(Value));
+                    continue;
+                }
+                const uint8_t* src = image._data_ + image._data_offset +
+                                     static_cast<size_t>(y + row) * image._stride +
+                                     static_cast<size_t>(x) * bytesPerPixel;
+                if (sizeof(Value) == 2) {
+                    halfKernel(src, reinterpret_cast<uint16_t*>(dst), valid, offset, scale);
+                } else {
+                    floatKernel(src, reinterpret_cast<float*>(dst), valid, offset, scale);
+                }
+                if (valid < itemWidth) {
+                    memset(dst + valid, 0, (itemWidth - valid) * sizeof(Value));
+                }
+            }
+        });
+}
+
+bool XBatcher::Impl::submit(const XImage* image) {
+    if (!image || !image->_data_ || image->_width == 0 || image->_height == 0 ||
+        image->_pixel_depth == 0 || image->_pixel_depth > 16) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> submitLock(m_submitMutex);
+    uint32_t available = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_running || m_stopping) {
+            return false;
+        }
+        m_stats.framesSubmitted++;
+        available = m_stats.buffersFree;
+    }
+
+    tileOrigins(image->_width, m_itemWidth, m_overlap, m_originsX);
+    tileOrigins(image->_height, m_itemHeight, m_overlap, m_originsY);
+    const uint32_t tiles = static_cast<uint32_t>(m_originsX.size() * m_originsY.size());
+
+    // The whole frame or none of it: room left in the filling buffer,
+    // then whole free buffers
+    const uint32_t room = (m_filling >= 0) ? m_batchSize - m_buffers[m_filling].count : 0;
+    const uint64_t needed = (tiles > room) ? (tiles - room + m_batchSize - 1) / m_batchSize : 0;
+    if (needed > available) {
+        uint64_t dropped = 0;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            dropped = ++m_stats.framesDropped;
+        }
+        reportEvent(122, static_cast<uint32_t>(dropped));
+        return false;
+    }
+
+    const float offset = m_offset;
+    const float scale = (m_scale != 0.0f) ? m_scale
+        : 1.0f / static_cast<float>((1u << image->_pixel_depth) - 1);
+    const uint32_t columns = static_cast<uint32_t>(m_originsX.size());
+    uint32_t done = 0;
+    while (done < tiles) {
+        if (m_filling < 0) {
+            takeBuffer();
+            m_fillStartNs = nowNs();
+        }
+        Buffer& buffer = m_buffers[m_filling];
+        const uint32_t count = std::min(tiles - done, m_batchSize - buffer.count);
+        uint8_t* out = buffer.data + buffer.count * m_itemBytes;
+        if (m_type == XBATCH_FLOAT16) {
+            convertItems<uint16_t>(*image, m_originsX, m_originsY, done, count, out, offset, scale);
+        } else {
+            convertItems<float>(*image, m_originsX, m_originsY, done, count, out, offset, scale);
+        }
+        for (uint32_t i = 0; i < count; ++i) {
+            XBatchItem& item = buffer.items[buffer.count + i];
+            const uint32_t tile = done + i;
+            item.sequence = image->_info.sequence;
+            item.hostNs = image->_info.hostNs;
+            item.detectorId = image->_info.detectorId;
+            item.x = m_originsX[tile % columns];
+            item.y = m_originsY[tile / columns];
+            item.width = std::min(m_itemWidth, image->_width - item.x);
+            item.height = std::min(m_itemHeight, image->_height - item.y);
+            item.reserved = 0;
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            buffer.count += count;
+            m_stats.itemsBatched += count;
+        }
+        done += count;
+        if (buffer.count == m_batchSize) {
+            finishFilling(false);
+        }
+    }
+    return true;
+}
+
+bool XBatcher::Impl::flush() {
+    std::lock_guard<std::mutex> submitLock(m_submitMutex);
+    return finishFilling(true);
+}
+
+bool XBatcher::Impl::release(uint32_t buffer) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (buffer >= m_buffers.size() || m_buffers[buffer].state != BUFFER_HELD) {
+        return false;
+    }
+    m_buffers[buffer].state = BUFFER_FREE;
+    m_stats.buffersFree++;
+    return true;
+}
+
+void XBatcher::Impl::handoffThread() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;) {
+        if (!m_queue.empty()) {
+            const uint32_t index = m_queue.front();
+            m_queue.pop_front();
+            Buffer& buffer = m_buffers[index];
+            buffer.state = BUFFER_HELD;
+            m_stats.batchesReady++;
+
+            XBatch batch;
+            batch.data = buffer.data;
+            batch.items = buffer.items.data();
+            batch.buffer = index;
+            batch.count = buffer.count;
+            batch.batchSize = m_batchSize;
+            batch.width = m_itemWidth;
+            batch.height = m_itemHeight;
+            batch.bytesPerValue = (m_type == XBATCH_FLOAT16) ? 2 : 4;
+            batch.itemBytes = m_itemBytes;
+            batch.index = m_batchIndex++;
+            lock.unlock();
+            m_batchSink->OnBatchReady(batch);
+            lock.lock();
+            continue;
+        }
+        if (m_stopping) {
+            break;
+        }
+        if (m_flushMs == 0) {
+            m_workCv.wait(lock);
+            continue;
+        }
+
+        // Partial batches age out; Submit() may be converting into it
+        m_workCv.wait_for(lock, std::chrono::milliseconds(std::min(m_flushMs, MAX_POLL_MS)));
+        if (!m_queue.empty() || m_stopping) {
+            continue;
+        }
+        lock.unlock();
+        {
+            std::unique_lock<std::mutex> submitLock(m_submitMutex, std::try_to_lock);
+            if (submitLock.owns_lock() && m_filling >= 0 &&
+                nowNs() - m_fillStartNs >= static_cast<uint64_t>(m_flushMs) * 1000000) {
+                finishFilling(true);
+            }
+        }
+        lock.lock();
+    }
+}
+
+XBatcher::Statistics XBatcher::Impl::getStatistics() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+void XBatcher::Impl::reportError(uint32_t errorId, const char* message) {
+    HX_LOG_ID(::HX::XFactory::LOG_ERROR, "XBatcher", errorId) << "ERROR " << errorId << ": " << message;
+
+    if (m_sink) {
+        m_sink->OnXError(errorId, message);
+    }
+}
+
+void XBatcher::Impl::reportEvent(uint32_t eventId, uint32_t data) {
+    if (m_sink) {
+        m_sink->OnXEvent(eventId, data);
+    }
+}
+
+// ============================================================================
+// Public interface
+// ============================================================================
+
+XBatcher::XBatcher()
+    : m_impl(new Impl())
+{
+}
+
+XBatcher::~XBatcher() {
+    delete m_impl;
+}
+
+void XBatcher::SetSink(IXImgSink* sink_) {
+    if (m_impl) {
+        m_impl->setSink(sink_);
+    }
+}
+
+bool XBatcher::SetBatchSink(IXBatchSink* sink_) {
+    if (!m_impl) return false;
+    return m_impl->setBatchSink(sink_);
+}
+
+bool XBatcher::SetBatchSize(uint32_t items) {
+    if (!m_impl) return false;
+    return m_impl->setBatchSize(items);
+}
+
+bool XBatcher::SetBufferCount(uint32_t count) {
+    if (!m_impl) return false;
+    return m_impl->setBufferCount(count);
+}
+
+uint32_t XBatcher::GetBufferCount() const {
+    if (!m_impl) return 0;
+    return m_impl->getBufferCount();
+}
+
+bool XBatcher::SetTileOverlap(uint32_t pixels) {
+    if (!m_impl) return false;
+    return m_impl->setTileOverlap(pixels);
+}
+
+bool XBatcher::SetOutputType(XOutputType type) {
+    if (!m_impl) return false;
+    return m_impl->setOutputType(type);
+}
+
+bool XBatcher::SetNormalization(float offset, float scale) {
+    if (!m_impl) return false;
+    return m_impl->setNormalization(offset, scale);
+}
+
+bool XBatcher::SetFlushTimeout(uint32_t ms) {
+    if (!m_impl) return false;
+    return m_impl->setFlushTimeout(ms);
+}
+
+bool XBatcher::SetAllocator(XFactory* factory, const XFactory::AllocOptions& options) {
+    if (!m_impl) return false;
+    return m_impl->setAllocator(factory, options);
+}
+
+bool XBatcher::Start(uint32_t itemWidth, uint32_t itemHeight) {
+    if (!m_impl) return false;
+    return m_impl->start(itemWidth, itemHeight);
+}
+
+void XBatcher::Stop() {
+    if (m_impl) {
+        m_impl->stop();
+    }
+}
+
+bool XBatcher::IsRunning() const {
+    if (!m_impl) return false;
+    return m_impl->isRunning();
+}
+
+bool XBatcher::Submit(const XImage* image) {
+    if (!m_impl) return false;
+    return m_impl->submit(image);
+}
+
+bool XBatcher::Flush() {
+    if (!m_impl) return false;
+    return m_impl->flush();
+}
+
+bool XBatcher::Release(uint32_t buffer) {
+    if (!m_impl) return false;
+    return m_impl->release(buffer);
+}
+
+XBatcher::Statistics XBatcher::GetStatistics() const {
+    if (!m_impl) {
+        Statistics stats;
+        memset(&stats, 0, sizeof(stats));
+        return stats;
+    }
+    return m_impl->getStatistics();
+}
+
+} // namespace HX
@@ -19,12 +19,20 @@
 #include "xfactory.h"
 #include "ixcmd_sink.h"
 #include "xlibdll_wrapper/xlibdll_interface.h"
-#include <iostream>
+#include "utils/thread_policy.h"
+#include "utils/link_listener.h"
+#include "utils/service_loop.h"
+#include "utils/metrics.h"
+#include "utils/logger.h"
+#include "utils/notifier.h"
 #include <cstring>
 #include <mutex>
 #include <thread>
 #include <atomic>
 #include <chrono>
+#include <condition_variable>
+#include <map>
+#include <vector>
 
 namespace HX {
 
@@ -95,6 +103,9 @@ namespace CommandCode {
     const uint8_t ENERGY_MODE = 0x7B;
     const uint8_t GAIN_TABLE_ID = 0x7C;
     const uint8_t MTU_SIZE = 0x7E;
+    
+    // Transactions (data: sub-commands, response data: sub-responses)
+    const uint8_t BATCH = 0x7F;
 }
 
 namespace Operation {
@@ -104,11 +115,167 @@ namespace Operation {
     const uint8_t LOAD = 0x04;
 }
 
+// ============================================================================
+// Parameter Layout
+// ============================================================================
+
+namespace {
+
+/**
+ * @brief Where a numeric parameter lives in the command set
+ *
+ * Values are big-endian and follow the 4-byte command/response header.
+ */
+struct Field {
+    uint8_t cmd;        // Command code
+    uint8_t bytes;      // Value bytes
+    uint8_t minLen;     // Shortest read response that holds the value
+    bool indexed;       // Addressed to the DM given by index
+    bool all;           // Index 0xFF (all DMs) accepted
+    bool text;          // String of the response's data length
+};
+
+Field makeField(uint8_t cmd, uint8_t bytes, uint8_t minLen,
+                bool indexed = false, bool all = false) {
+    Field field;
+    field.cmd = cmd;
+    field.bytes = bytes;
+    field.minLen = minLen;
+    field.indexed = indexed;
+    field.all = all;
+    field.text = false;
+    return field;
+}
+
+bool readField(XControl::XCode code, Field& field) {
+    switch (code) {
+        case XControl::XINT_TIME:      field = makeField(CommandCode::INTEGRATION_TIME, 4, 8); return true;
+        case XControl::XNON_INTTIME:   field = makeField(CommandCode::NON_INT_TIME, 2, 6); return true;
+        case XControl::XOPERATION:     field = makeField(CommandCode::OPERATION_MODE, 1, 5); return true;
+        case XControl::XDM_GAIN:       field = makeField(CommandCode::DM_GAIN, 2, 6, true); return true;
+        case XControl::XCHANNEL:       field = makeField(CommandCode::CHANNEL_CONFIG, 4, 9); return true;
+        case XControl::XPIXEL_NUM:     field = makeField(CommandCode::PIXEL_NUMBER, 2, 6); return true;
+        case XControl::XPIXEL_SIZE:    field = makeField(CommandCode::PIXEL_SIZE, 1, 5); return true;
+        case XControl::XCU_VER:        field = makeField(CommandCode::GCU_FIRMWARE, 2, 6); return true;
+        case XControl::XLED:           field = makeField(CommandCode::LED_CONTROL, 1, 5); return true;
+        case XControl::XLINE_TRIGGER:  field = makeField(CommandCode::ENABLE_LINE_TRIGGER, 1, 5); return true;
+        case XControl::XFRAME_TRIGGER: field = makeField(CommandCode::ENABLE_FRAME_TRIGGER, 2, 6); return true;
+        default:                       return false;
+    }
+}
+
+bool writeField(XControl::XCode code, Field& field) {
+    switch (code) {
+        case XControl::XINT_TIME:      field = makeField(CommandCode::INTEGRATION_TIME, 4, 4); return true;
+        case XControl::XNON_INTTIME:   field = makeField(CommandCode::NON_INT_TIME, 2, 4); return true;
+        case XControl::XOPERATION:     field = makeField(CommandCode::OPERATION_MODE, 1, 4); return true;
+        case XControl::XDM_GAIN:       field = makeField(CommandCode::DM_GAIN, 2, 4, true); return true;
+        case XControl::XBASE_LINE:     field = makeField(CommandCode::BASELINE_VALUE, 2, 4, true, true); return true;
+        case XControl::XLED:           field = makeField(CommandCode::LED_CONTROL, 1, 4); return true;
+        case XControl::XLINE_TRIGGER:  field = makeField(CommandCode::ENABLE_LINE_TRIGGER, 1, 4); return true;
+        case XControl::XFRAME_TRIGGER: field = makeField(CommandCode::ENABLE_FRAME_TRIGGER, 2, 4); return true;
+        case XControl::XLINE_TR_MODE:  field = makeField(CommandCode::LINE_TRIGGER_MODE, 1, 4); return true;
+        case XControl::XFRAME_TR_MODE: field = makeField(CommandCode::FRAME_TRIGGER_MODE, 1, 4); return true;
+        default:                       return false;
+    }
+}
+
+bool stringField(XControl::XCode code, Field& field) {
+    switch (code) {
+        case XControl::XCU_SN:         field = makeField(CommandCode::GCU_SERIAL, 0, 5); break;
+        case XControl::XDM_SN:         field = makeField(CommandCode::DM_SERIAL, 0, 5, true); break;
+        default:                       return false;
+    }
+    field.text = true;
+    return true;
+}
+
+/**
+ * @brief Whether a parameter is fixed for the life of the device
+ */
+bool isStatic(XControl::XCode code) {
+    switch (code) {
+        case XControl::XPIXEL_NUM:
+        case XControl::XPIXEL_SIZE:
+        case XControl::XCU_VER:
+        case XControl::XDM_VER:
+        case XControl::XDM_PIX_NUM:
+        case XControl::XDM_TYPE:
+        case XControl::XCU_TYPE:
+        case XControl::XCU_SN:
+        case XControl::XDM_SN:
+            return true;
+        default:
+            return false;
+    }
+}
+
+uint8_t encodeField(const Field& field, uint64_t val, uint8_t* data) {
+    for (uint8_t i = 0; i < field.bytes; ++i) {
+        data[i] = static_cast<uint8_t>(val >> (8 * (field.bytes - 1 - i)));
+    }
+    return field.bytes;
+}
+
+uint64_t decodeField(const Field& field, const uint8_t* response) {
+    uint64_t val = 0;
+    for (uint8_t i = 0; i < field.bytes; ++i) {
+        val = (val << 8) | response[4 + i];
+    }
+    return val;
+}
+
+/**
+ * @brief Command an operation code sends (see XControl::Impl::operate)
+ */
+bool operateCommand(XControl::XCode code, uint8_t& cmd) {
+    switch (code) {
+        case XControl::XINIT:          cmd = CommandCode::LOAD_SETTINGS; return true;
+        case XControl::XRESTORE:       cmd = CommandCode::LOAD_DEFAULT; return true;
+        case XControl::XSAVE:          cmd = CommandCode::SAVE_SETTINGS; return true;
+        case XControl::XFRAME_TR_GEN:  cmd = CommandCode::SEND_FRAME_TRIGGER; return true;
+        default:                       return false;
+    }
+}
+
+void addRoundTrip(XControl::CommandStatistics& stats, uint64_t us) {
+    ++stats.commands;
+    stats.totalUs += us;
+    if (us > stats.maxUs) {
+        stats.maxUs = static_cast<uint32_t>(us < 0xFFFFFFFFu ? us : 0xFFFFFFFFu);
+    }
+    uint32_t bucket = 0;
+    while (bucket + 1 < XControl::LATENCY_BUCKETS && (us >> (bucket + 1)) != 0) {
+        ++bucket;
+    }
+    ++stats.histogram[bucket];
+}
+
+void accumulate(XControl::CommandStatistics& into, const XControl::CommandStatistics& from) {
+    into.commands += from.commands;
+    into.timeouts += from.timeouts;
+    into.deviceErrors += from.deviceErrors;
+    into.totalUs += from.totalUs;
+    if (from.maxUs > into.maxUs) {
+        into.maxUs = from.maxUs;
+    }
+    for (uint32_t i = 0; i < XControl::LATENCY_BUCKETS; ++i) {
+        into.histogram[i] += from.histogram[i];
+    }
+}
+
+uint64_t elapsedUs(std::chrono::steady_clock::time_point since) {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - since).count());
+}
+
+} // anonymous namespace
+
 // ============================================================================
 // Internal Implementation
 // ============================================================================
 
-class XControl::Impl {
+class XControl::Impl : public Internal::MetricsCollector {
 public:
     Impl();
     ~Impl();
@@ -118,30 +285,113 @@ public:
     bool isOpen() const { return m_opened; }
     
     int32_t operate(XCode code, uint64_t data);
-    int32_t read(XCode code, uint64_t& val, uint8_t index);
-    int32_t read(XCode code, std::string& val, uint8_t index);
+    int32_t read(XCode code, uint64_t& val, uint8_t index, bool cached = true);
+    int32_t read(XCode code, std::string& val, uint8_t index, bool cached = true);
     int32_t write(XCode code, uint64_t val, uint8_t index);
     
-    void setSink(IXCmdSink* sink) { m_sink = sink; }
+    uint32_t readAsync(XCode code, uint8_t index);
+    uint32_t writeAsync(XCode code, uint64_t val, uint8_t index);
+    bool waitAsync(uint32_t timeout);
+    void setMaxInFlight(uint32_t count);
+    
+    int32_t transact(XItem* items, uint32_t count, bool write);
+    
+    void setSink(IXCmdSink* sink) {
+        m_sink = sink;
+        m_notify.setSink(sink);
+    }
     void setFactory(XFactory& fac) { m_factory = &fac; }
     void setTimeout(uint32_t time) { m_timeout = time; }
     bool enableHeartbeat(bool enable);
+    bool setHeartbeatPeriod(uint32_t period);
+    bool getTelemetry(float& temperature, float& humidity);
+    void setAutoReconnect(bool enable, uint32_t retry);
+    
+    void addLinkListener(Internal::LinkListener* listener);
+    void removeLinkListener(Internal::LinkListener* listener);
+    
+    void enableCache(bool enable);
+    void invalidateCache(bool keepStatic);
+    
+    void getStatistics(XControl::Statistics& stats) const;
+    bool getStatistics(XCode code, XControl::CommandStatistics& stats) const;
+    void resetStatistics();
+    
+    void collectMetrics(Internal::MetricsWriter& out) override;
     
 private:
+    /**
+     * @brief Synchronous caller waiting for its response
+     */
+    struct Waiter {
+        bool done;
+        int32_t result;
+        uint8_t* response;
+        uint32_t* responseLen;
+        uint8_t* status;    // Takes a device error code instead of reporting it
+    };
+    
+    /**
+     * @brief Command sent and not yet answered
+     */
+    struct Pending {
+        Field field;        // Layout of the value read (bytes 0 for writes)
+        std::chrono::steady_clock::time_point deadline;
+        Waiter* waiter;     // nullptr for asynchronous commands
+        bool heartbeat;     // Outside the window, never waited for
+        uint32_t timeout;   // ms, 0 for SetTimeout()
+        uint8_t cmd;        // Command code, for the statistics
+        std::chrono::steady_clock::time_point sent;
+        
+        Pending() : waiter(nullptr), heartbeat(false), timeout(0), cmd(0) {}
+    };
+    
     int32_t sendCommand(uint8_t cmd, uint8_t op, uint8_t dmId, 
                        const uint8_t* data, uint8_t dataLen,
-                       uint8_t* response, uint32_t* responseLen);
+                       uint8_t* response, uint32_t* responseLen,
+                       uint8_t* status = nullptr, uint32_t timeout = 0);
+    int32_t post(std::unique_lock<std::mutex>& lock,
+                 uint8_t cmd, uint8_t op, uint8_t dmId,
+                 const uint8_t* data, uint8_t dataLen,
+                 Pending& pending, uint16_t& sequence);
+    void complete(uint16_t sequence, int32_t result,
+                  const uint8_t* response, uint32_t responseLen);
+    void expire(bool all);
+    bool asyncIdle() const;
+    void lockCommands(std::unique_lock<std::mutex>& lock);
+    XControl::CommandStatistics& statsFor(const Pending& pending);
+    
+    bool batchField(const XItem& item, bool write, Field& field);
+    bool sendBatch(XItem* items, const std::vector<uint32_t>& batch,
+                   const std::vector<Field>& fields, bool write);
+    void single(XItem& item, bool write);
+    
+    bool cacheLookup(XCode code, uint8_t index, uint64_t* val, std::string* str);
+    void cacheRead(XCode code, uint8_t index, uint64_t val, const std::string* str);
+    void cacheWritten(XCode code, uint8_t index, uint64_t val, int32_t result);
     
     void reportError(uint32_t errorId, const char* message);
     void reportEvent(uint32_t eventId, float data);
     
     void heartbeatThread();
+    bool heartbeatPoll();
     void startHeartbeat();
     void stopHeartbeat();
+    void postHeartbeat();
+    void heartbeatMissed();
+    void reconnect();
+    bool reopen();
+    void restoreWritten();
+    
+    void receiveThread();
+    bool channelPoll();
+    void startChannel();
+    void stopChannel();
     
     XDetector m_detector;
     bool m_opened;
     IXCmdSink* m_sink;
+    Internal::NotifySource m_notify;    ///< Delivers OnXError/OnXEvent off the heartbeat thread
     XFactory* m_factory;
     uint32_t m_timeout;
     
@@ -150,6 +400,70 @@ private:
     std::atomic<bool> m_heartbeatRunning;
     std::thread m_heartbeatThread;
     std::atomic<int32_t> m_missedHeartbeats;
+    std::atomic<uint32_t> m_heartbeatPeriod;    // ms, also the heartbeat's timeout
+    std::mutex m_heartbeatMutex;
+    std::condition_variable m_heartbeatCv;      // Wakes the thread to stop
+    uint16_t m_heartbeatSequence;               // Heartbeat in flight, 0 if none
+    
+    // Heartbeat on the service loop (SetServiceThreads); m_heartbeatThread
+    // then only runs reconnect()
+    Internal::ServiceCall m_heartbeatTask;
+    bool m_heartbeatShared;
+    bool m_reconnecting;                        // Guarded by m_heartbeatMutex
+    std::chrono::steady_clock::time_point m_nextBeat;
+    
+    // Auto-reconnect, run by the heartbeat thread
+    std::atomic<bool> m_autoReconnect;
+    std::atomic<uint32_t> m_reconnectRetry;     // ms between attempts
+    bool m_linkLost;                            // Guarded by m_heartbeatMutex
+    std::chrono::steady_clock::time_point m_lastAnswer; // Guarded by m_cmdMutex
+    std::vector<Internal::LinkListener*> m_linkListeners;
+    std::mutex m_linkMutex;                     // Held while listeners are called
+    
+    // Registry metrics of the detector opened last (set by open())
+    Internal::MetricLabels m_metricLabels;
+    Internal::MetricCounter* m_heartbeatsMissedTotal;
+    Internal::MetricCounter* m_linkLostTotal;
+    Internal::MetricCounter* m_reconnectsTotal;
+    
+    // Last GCU telemetry, guarded by m_cmdMutex
+    bool m_telemetryValid;
+    float m_temperature;
+    float m_humidity;
+    
+    // Command channel (responses matched by sequence number)
+    std::atomic<bool> m_channelRunning;
+    std::thread m_receiveThread;
+    Internal::ServiceCall m_channelTask;        // Replaces m_receiveThread when shared
+    bool m_channelShared;
+    std::chrono::steady_clock::time_point m_nextExpire;
+    std::map<uint16_t, Pending> m_pending;
+    std::condition_variable m_cmdCv;
+    uint32_t m_completing; // OnXComplete calls running
+    uint16_t m_sequence;
+    uint32_t m_maxInFlight;
+    
+    // Batch command support: unknown until the first batch is answered
+    enum BatchMode { BATCH_UNKNOWN = 0, BATCH_SUPPORTED, BATCH_UNSUPPORTED };
+    std::atomic<int32_t> m_batchMode;
+    
+    // Parameter cache, keyed by code << 8 | index
+    struct CacheEntry {
+        uint64_t val;
+        std::string str;
+    };
+    std::map<uint32_t, CacheEntry> m_cache;
+    std::atomic<bool> m_cacheEnabled;
+    std::mutex m_cacheMutex;
+    
+    // Command-path statistics, guarded by m_cmdMutex
+    std::vector<XControl::CommandStatistics> m_cmdStats;   // By command code
+    XControl::CommandStatistics m_heartbeatStats;
+    uint64_t m_lockWaits;
+    uint64_t m_lockWaitUs;
+    uint32_t m_lockMaxUs;
+    uint64_t m_windowWaits;
+    uint64_t m_windowWaitUs;
     
     mutable std::mutex m_mutex;
     mutable std::mutex m_cmdMutex; // Separate mutex for commands
@@ -163,7 +477,30 @@ XControl::Impl::Impl()
     , m_heartbeatEnabled(true)
     , m_heartbeatRunning(false)
     , m_missedHeartbeats(0)
+    , m_heartbeatPeriod(1000)
+    , m_heartbeatSequence(0)
+    , m_heartbeatTask([this] { return heartbeatPoll(); })
+    , m_heartbeatShared(false)
+    , m_reconnecting(false)
+    , m_autoReconnect(false)
+    , m_reconnectRetry(1000)
+    , m_linkLost(false)
+    , m_heartbeatsMissedTotal(nullptr)
+    , m_linkLostTotal(nullptr)
+    , m_reconnectsTotal(nullptr)
+    , m_telemetryValid(false)
+    , m_temperature(0.0f)
+    , m_humidity(0.0f)
+    , m_channelRunning(false)
+    , m_channelTask([this] { return channelPoll(); })
+    , m_channelShared(false)
+    , m_completing(0)
+    , m_sequence(0)
+    , m_maxInFlight(8)
+    , m_batchMode(BATCH_UNKNOWN)
+    , m_cacheEnabled(true)
 {
+    resetStatistics();
 }
 
 XControl::Impl::~Impl() {
@@ -174,11 +511,11 @@ bool XControl::Impl::open(XDetector& det) {
     std::lock_guard<std::mutex> lock(m_mutex);
     
     if (m_opened) {
-        std::cout << "[XControl] Already opened" << std::endl;
+        HX_LOG_INFO("XControl") << "Already opened";
         return true;
     }
     
-    std::cout << "[XControl] Opening connection to " << det.GetIP() << std::endl;
+    HX_LOG_INFO("XControl") << "Opening connection to " << det.GetIP();
     
     // Validate detector info
     if (det.GetIP().empty()) {
@@ -205,10 +542,28 @@ bool XControl::Impl::open(XDetector& det) {
     }
     
     m_detector = det;
+    
+    // Counters live in the registry, so they keep counting across reopens
+    Internal::MetricsRegistry& metrics = Internal::MetricsRegistry::instance();
+    m_metricLabels = Internal::MetricLabels("detector", det.GetIP());
+    m_heartbeatsMissedTotal = &metrics.counter("hubx_control_heartbeats_missed_total",
+                                               "Heartbeats not answered in time", m_metricLabels);
+    m_linkLostTotal = &metrics.counter("hubx_control_link_lost_total",
+                                       "Links declared lost after 10 missed heartbeats", m_metricLabels);
+    m_reconnectsTotal = &metrics.counter("hubx_control_reconnects_total",
+                                         "Successful automatic reconnects", m_metricLabels);
+    metrics.addCollector(this);
+    
     m_opened = true;
     m_missedHeartbeats = 0;
+    m_linkLost = false;
+    m_lastAnswer = std::chrono::steady_clock::now();
+    m_batchMode = BATCH_UNKNOWN;
+    invalidateCache(false);
     
-    std::cout << "[XControl] Connection opened successfully" << std::endl;
+    startChannel();
+    
+    HX_LOG_INFO("XControl") << "Connection opened successfully";
     
     // Start heartbeat monitoring if enabled
     if (m_heartbeatEnabled) {
@@ -225,25 +580,78 @@ void XControl::Impl::close() {
         return;
     }
     
-    std::cout << "[XControl] Closing connection..." << std::endl;
+    HX_LOG_INFO("XControl") << "Closing connection...";
     
     // Stop heartbeat monitoring
     stopHeartbeat();
     
+    // Fail pending commands
+    stopChannel();
+    
     // Close network connection
     Internal::XLibProxy_CloseNetwork();
     
+    Internal::MetricsRegistry::instance().removeCollector(this);
     m_opened = false;
+    invalidateCache(false);
     
-    std::cout << "[XControl] Connection closed" << std::endl;
+    HX_LOG_INFO("XControl") << "Connection closed";
 }
 
 int32_t XControl::Impl::sendCommand(uint8_t cmd, uint8_t op, uint8_t dmId,
                                      const uint8_t* data, uint8_t dataLen,
-                                     uint8_t* response, uint32_t* responseLen) {
-    std::lock_guard<std::mutex> lock(m_cmdMutex);
+                                     uint8_t* response, uint32_t* responseLen,
+                                     uint8_t* status, uint32_t timeout) {
+    Waiter waiter;
+    waiter.done = false;
+    waiter.result = -1;
+    waiter.response = response;
+    waiter.responseLen = responseLen;
+    waiter.status = status;
     
-    if (!m_opened) {
+    Pending pending;
+    pending.field = Field();
+    pending.waiter = &waiter;
+    pending.timeout = timeout;
+    
+    std::unique_lock<std::mutex> lock(m_cmdMutex, std::defer_lock);
+    lockCommands(lock);
+    uint16_t sequence = 0;
+    if (post(lock, cmd, op, dmId, data, dataLen, pending, sequence) < 0) {
+        return -1;
+    }
+    
+    // The receive thread, expiry or close always completes it
+    m_cmdCv.wait(lock, [&] { return waiter.done; });
+    return waiter.result;
+}
+
+int32_t XControl::Impl::post(std::unique_lock<std::mutex>& lock,
+                             uint8_t cmd, uint8_t op, uint8_t dmId,
+                             const uint8_t* data, uint8_t dataLen,
+                             Pending& pending, uint16_t& sequence) {
+    if (!m_opened || !m_channelRunning) {
+        reportError(19, "XControl not opened");
+        return -1;
+    }
+    
+    // Wait for a free slot in the window; the heartbeat has its own
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    const std::chrono::steady_clock::time_point deadline = start + std::chrono::milliseconds(m_timeout);
+    auto slotFree = [this] {
+        const size_t used = m_pending.size() - (m_heartbeatSequence != 0 ? 1 : 0);
+        return !m_channelRunning || used < m_maxInFlight;
+    };
+    if (!pending.heartbeat && !slotFree()) {
+        ++m_windowWaits;
+        const bool freed = m_cmdCv.wait_until(lock, deadline, slotFree);
+        m_windowWaitUs += elapsedUs(start);
+        if (!freed) {
+            reportError(15, "Command window full");
+            return -1;
+        }
+    }
+    if (!m_channelRunning) {
         reportError(19, "XControl not opened");
         return -1;
     }
@@ -262,32 +670,372 @@ int32_t XControl::Impl::sendCommand(uint8_t cmd, uint8_t op, uint8_t dmId,
         packetLen += dataLen;
     }
     
+    // 0 is never used, so it can mean "no ticket"; skip numbers still pending
+    do {
+        sequence = ++m_sequence;
+    } while (sequence == 0 || m_pending.count(sequence) != 0);
+    
+    // Registered before sending so the response always finds it
+    pending.cmd = cmd;
+    pending.sent = std::chrono::steady_clock::now();
+    pending.deadline = pending.sent + std::chrono::milliseconds(
+        pending.heartbeat ? m_heartbeatPeriod.load() :
+        pending.timeout > 0 ? pending.timeout : m_timeout);
+    m_pending[sequence] = pending;
+    
     // Send command through proxy
-    int32_t result = Internal::XLibProxy_SendCommand(
-        cmdPacket, packetLen,
-        response, responseLen,
-        m_timeout
-    );
+    int32_t result = Internal::XLibProxy_PostCommand(cmdPacket, packetLen, sequence);
     
     if (result < 0) {
+        m_pending.erase(sequence);
+        m_cmdCv.notify_all();
         const char* errorMsg = Internal::XLibProxy_GetErrorMessage(result);
         reportError(15, errorMsg);
         return -1;
     }
     
+    return 0;
+}
+
+void XControl::Impl::complete(uint16_t sequence, int32_t result,
+                              const uint8_t* response, uint32_t responseLen) {
+    std::unique_lock<std::mutex> lock(m_cmdMutex, std::defer_lock);
+    lockCommands(lock);
+    
+    std::map<uint16_t, Pending>::iterator it = m_pending.find(sequence);
+    if (it == m_pending.end()) {
+        return; // Late answer to a command that already timed out
+    }
+    Pending pending = it->second;
+    m_pending.erase(it);
+    
     // Verify response
-    if (*responseLen < 4) {
-        reportError(16, "Invalid response length");
-        return -1;
+    uint32_t errorId = 0;
+    const char* message = nullptr;
+    if (responseLen < 4) {
+        errorId = 16;
+        message = "Invalid response length";
+    } else if (response[2] != 0) { // Error code is at byte 2
+        errorId = 17;
+        message = "Device returned error code";
+        if (pending.waiter && pending.waiter->status) {
+            *pending.waiter->status = response[2];
+            message = nullptr;
+        }
+    }
+    if (errorId != 0) {
+        result = -1;
     }
     
-    // Check for error code in response
-    if (response[2] != 0) { // Error code is at byte 2
-        reportError(17, "Device returned error code");
-        return -1;
+    XControl::CommandStatistics& stats = statsFor(pending);
+    addRoundTrip(stats, elapsedUs(pending.sent));
+    if (errorId == 17) {
+        ++stats.deviceErrors;
     }
     
-    return result;
+    // Any answer proves the link
+    if (result > 0) {
+        m_missedHeartbeats = 0;
+        m_lastAnswer = std::chrono::steady_clock::now();
+    }
+    
+    uint64_t val = 0;
+    bool telemetry = false;
+    float temperature = 0.0f;
+    float humidity = 0.0f;
+    if (pending.heartbeat) {
+        m_heartbeatSequence = 0;
+        
+        // Parse temperature and humidity if available
+        if (result > 0 && responseLen >= 10) {
+            m_temperature = static_cast<float>(response[4] | (response[5] << 8)) / 10.0f;
+            m_humidity = static_cast<float>(response[6] | (response[7] << 8)) / 10.0f;
+            m_telemetryValid = true;
+            telemetry = true;
+            temperature = m_temperature;
+            humidity = m_humidity;
+        }
+    } else if (pending.waiter) {
+        // The waiter only lives until done is seen, so nothing touches it after
+        const uint32_t copied = responseLen < *pending.waiter->responseLen ?
+            responseLen : *pending.waiter->responseLen;
+        memcpy(pending.waiter->response, response, copied);
+        *pending.waiter->responseLen = copied;
+        pending.waiter->result = result;
+        pending.waiter->done = true;
+    } else {
+        if (result > 0 && pending.field.bytes > 0 && responseLen >= pending.field.minLen) {
+            val = decodeField(pending.field, response);
+        }
+        ++m_completing;
+    }
+    m_cmdCv.notify_all();
+    lock.unlock();
+    
+    // Outside the lock: the sink may queue further commands
+    if (message) {
+        reportError(errorId, message);
+    }
+    if (telemetry) {
+        reportEvent(107, temperature);  // Temperature event
+        reportEvent(108, humidity);     // Humidity event
+    }
+    if (!pending.waiter && !pending.heartbeat) {
+        if (m_sink) {
+            m_sink->OnXComplete(sequence, result, val);
+        }
+        lock.lock();
+        --m_completing;
+        m_cmdCv.notify_all();
+    }
+}
+
+void XControl::Impl::expire(bool all) {
+    std::vector<uint16_t> expired;
+    uint32_t timedOut = 0;
+    bool heartbeatLost = false;
+    {
+        std::unique_lock<std::mutex> lock(m_cmdMutex, std::defer_lock);
+        lockCommands(lock);
+        
+        const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        std::map<uint16_t, Pending>::iterator it = m_pending.begin();
+        while (it != m_pending.end()) {
+            if (!all && it->second.deadline > now) {
+                ++it;
+                continue;
+            }
+            if (!all) {
+                ++statsFor(it->second).timeouts;
+            }
+            if (it->second.heartbeat) {
+                m_heartbeatSequence = 0;
+                heartbeatLost = !all;
+            } else if (it->second.waiter) {
+                it->second.waiter->result = -1;
+                it->second.waiter->done = true;
+                ++timedOut;
+            } else {
+                expired.push_back(it->first);
+                ++m_completing;
+                ++timedOut;
+            }
+            m_pending.erase(it++);
+        }
+        m_cmdCv.notify_all();
+    }
+    
+    if (heartbeatLost) {
+        heartbeatMissed();
+    }
+    if (timedOut > 0 && !all) {
+        reportError(15, "Command timed out");
+    }
+    if (expired.empty()) {
+        return;
+    }
+    if (m_sink) {
+        for (size_t i = 0; i < expired.size(); ++i) {
+            m_sink->OnXComplete(expired[i], -1, 0);
+        }
+    }
+    std::lock_guard<std::mutex> lock(m_cmdMutex);
+    m_completing -= static_cast<uint32_t>(expired.size());
+    m_cmdCv.notify_all();
+}
+
+void XControl::Impl::lockCommands(std::unique_lock<std::mutex>& lock) {
+    // Only a contended acquisition is timed
+    if (lock.try_lock()) {
+        return;
+    }
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    lock.lock();
+    const uint64_t waited = elapsedUs(start);
+    ++m_lockWaits;
+    m_lockWaitUs += waited;
+    if (waited > m_lockMaxUs) {
+        m_lockMaxUs = static_cast<uint32_t>(waited < 0xFFFFFFFFu ? waited : 0xFFFFFFFFu);
+    }
+}
+
+XControl::CommandStatistics& XControl::Impl::statsFor(const Pending& pending) {
+    return pending.heartbeat ? m_heartbeatStats : m_cmdStats[pending.cmd];
+}
+
+void XControl::Impl::getStatistics(XControl::Statistics& stats) const {
+    memset(&stats, 0, sizeof(stats));
+    
+    std::lock_guard<std::mutex> lock(m_cmdMutex);
+    for (size_t cmd = 0; cmd < m_cmdStats.size(); ++cmd) {
+        accumulate(cmd == CommandCode::BATCH ? stats.batch : stats.commands, m_cmdStats[cmd]);
+    }
+    stats.heartbeat = m_heartbeatStats;
+    stats.lockWaits = m_lockWaits;
+    stats.lockWaitUs = m_lockWaitUs;
+    stats.lockMaxUs = m_lockMaxUs;
+    stats.windowWaits = m_windowWaits;
+    stats.windowWaitUs = m_windowWaitUs;
+}
+
+void XControl::Impl::collectMetrics(Internal::MetricsWriter& out) {
+    XControl::Statistics stats;
+    getStatistics(stats);
+    
+    // Bucket i holds [2^i, 2^(i+1)) µs, the last one everything longer
+    double bounds[XControl::LATENCY_BUCKETS - 1];
+    for (uint32_t b = 0; b + 1 < XControl::LATENCY_BUCKETS; ++b) {
+        bounds[b] = static_cast<double>(uint64_t(2) << b) * 1e-6;
+    }
+    
+    const XControl::CommandStatistics* kinds[] = { &stats.commands, &stats.heartbeat, &stats.batch };
+    static const char* const names[] = { "command", "heartbeat", "batch" };
+    for (int k = 0; k < 3; ++k) {
+        Internal::MetricLabels labels = m_metricLabels;
+        labels.add("kind", names[k]);
+        out.counter("hubx_control_commands_total", "Commands answered", labels, kinds[k]->commands);
+        out.counter("hubx_control_timeouts_total", "Commands not answered in time", labels, kinds[k]->timeouts);
+        out.counter("hubx_control_device_errors_total", "Answers carrying a device error code",
+                    labels, kinds[k]->deviceErrors);
+        out.histogram("hubx_control_round_trip_seconds", "Command round trip, network and device",
+                      labels, bounds, kinds[k]->histogram, XControl::LATENCY_BUCKETS - 1,
+                      static_cast<double>(kinds[k]->totalUs) * 1e-6);
+    }
+    out.counter("hubx_control_lock_waits_total", "Command lock acquisitions that had to wait",
+                m_metricLabels, stats.lockWaits);
+    out.counter("hubx_control_window_waits_total", "Commands that found the in-flight window full",
+                m_metricLabels, stats.windowWaits);
+    out.gauge("hubx_control_heartbeats_missed", "Consecutive heartbeats missed now",
+              m_metricLabels, m_missedHeartbeats.load());
+}
+
+bool XControl::Impl::getStatistics(XCode code, XControl::CommandStatistics& stats) const {
+    Field field;
+    uint8_t cmd = 0;
+    if (readField(code, field) || writeField(code, field) || stringField(code, field)) {
+        cmd = field.cmd;
+    } else if (!operateCommand(code, cmd)) {
+        return false;
+    }
+    
+    std::lock_guard<std::mutex> lock(m_cmdMutex);
+    stats = m_cmdStats[cmd];
+    return true;
+}
+
+void XControl::Impl::resetStatistics() {
+    XControl::CommandStatistics zero;
+    memset(&zero, 0, sizeof(zero));
+    
+    std::lock_guard<std::mutex> lock(m_cmdMutex);
+    m_cmdStats.assign(256, zero);
+    m_heartbeatStats = zero;
+    m_lockWaits = 0;
+    m_lockWaitUs = 0;
+    m_lockMaxUs = 0;
+    m_windowWaits = 0;
+    m_windowWaitUs = 0;
+}
+
+bool XControl::Impl::asyncIdle() const {
+    if (m_completing > 0) {
+        return false;
+    }
+    for (std::map<uint16_t, Pending>::const_iterator it = m_pending.begin();
+         it != m_pending.end(); ++it) {
+        if (!it->second.waiter && !it->second.heartbeat) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void XControl::Impl::startChannel() {
+    if (m_channelRunning) {
+        return;
+    }
+    
+    m_channelRunning = true;
+    m_nextExpire = std::chrono::steady_clock::now();
+    m_channelShared = Internal::ServiceLoop::instance().add(&m_channelTask);
+    if (!m_channelShared) {
+        m_receiveThread = std::thread(&Impl::receiveThread, this);
+    }
+}
+
+void XControl::Impl::stopChannel() {
+    if (!m_channelRunning) {
+        return;
+    }
+    
+    {
+        // Under the lock so a caller waiting for a slot sees it
+        std::lock_guard<std::mutex> lock(m_cmdMutex);
+        m_channelRunning = false;
+        m_cmdCv.notify_all();
+    }
+    
+    if (m_channelShared) {
+        Internal::ServiceLoop::instance().remove(&m_channelTask);
+        m_channelShared = false;
+    }
+    if (m_receiveThread.joinable()) {
+        m_receiveThread.join();
+    }
+    
+    // Nobody will answer the rest
+    expire(true);
+}
+
+void XControl::Impl::receiveThread() {
+    Internal::ApplyThreadPolicy(XFactory::THREAD_HEARTBEAT);
+    
+    uint8_t response[Internal::XLIB_MAX_RESPONSE_SIZE];
+    
+    while (m_channelRunning) {
+        uint16_t sequence = 0;
+        uint32_t responseLen = sizeof(response);
+        
+        // Short timeout so stop and command expiry are noticed promptly
+        int32_t result = Internal::XLibProxy_ReceiveCommandResponse(
+            &sequence, response, &responseLen, 50);
+        
+        if (result >= 0) {
+            complete(sequence, result, response, responseLen);
+        } else if (result != Internal::XLIB_ERROR_TIMEOUT) {
+            // Socket error: pending commands fail by timeout, avoid spinning
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        
+        expire(false);
+    }
+}
+
+bool XControl::Impl::channelPoll() {
+    uint8_t response[Internal::XLIB_MAX_RESPONSE_SIZE];
+    
+    // A bounded batch so other detectors on the loop get their turn
+    bool received = false;
+    for (int i = 0; i < 16 && m_channelRunning; ++i) {
+        uint16_t sequence = 0;
+        uint32_t responseLen = sizeof(response);
+        int32_t result = Internal::XLibProxy_ReceiveCommandResponse(
+            &sequence, response, &responseLen, 0);
+        if (result < 0) {
+            // Timeout or socket error: pending commands fail by expiry
+            break;
+        }
+        complete(sequence, result, response, responseLen);
+        received = true;
+    }
+    
+    // Expiry has millisecond resolution; no need to take the lock every poll
+    const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    if (received || now >= m_nextExpire) {
+        m_nextExpire = now + std::chrono::milliseconds(1);
+        expire(false);
+    }
+    return received;
 }
 
 int32_t XControl::Impl::operate(XCode code, uint64_t data) {
@@ -296,10 +1044,13 @@ int32_t XControl::Impl::operate(XCode code, uint64_t data) {
     
     switch (code) {
         case XControl::XINIT:
+            // Settings change even if the response is lost
+            invalidateCache(true);
             return sendCommand(CommandCode::LOAD_SETTINGS, Operation::LOAD, 0x00,
                              nullptr, 0, response, &responseLen);
             
         case XControl::XRESTORE:
+            invalidateCache(true);
             return sendCommand(CommandCode::LOAD_DEFAULT, Operation::LOAD, 0x00,
                              nullptr, 0, response, &responseLen);
             
@@ -317,237 +1068,423 @@ int32_t XControl::Impl::operate(XCode code, uint64_t data) {
     }
 }
 
-int32_t XControl::Impl::read(XCode code, uint64_t& val, uint8_t index) {
+int32_t XControl::Impl::read(XCode code, uint64_t& val, uint8_t index, bool cached) {
+    if (code == XControl::XPIXEL_DEPTH) {
+        // Pixel depth is typically 16, 18, or 20 bits
+        val = 16; // Default, should be read from device
+        return 1;
+    }
+    if (cached && cacheLookup(code, index, &val, nullptr)) {
+        return 1;
+    }
+    
+    Field field;
+    if (!readField(code, field)) {
+        reportError(11, "Unsupported read code");
+        return 0;
+    }
+    if (field.indexed && !field.all && index == 0xFF) {
+        reportError(4, "DM index cannot be 0xFF for read");
+        return -1;
+    }
+    
+    uint8_t response[256];
+    uint32_t responseLen = sizeof(response);
+    int32_t result = sendCommand(field.cmd, Operation::READ, field.indexed ? index : 0x00,
+                                 nullptr, 0, response, &responseLen);
+    if (result > 0 && responseLen >= field.minLen) {
+        val = decodeField(field, response);
+        cacheRead(code, index, val, nullptr);
+    }
+    return result;
+}
+
+int32_t XControl::Impl::read(XCode code, std::string& val, uint8_t index, bool cached) {
+    if (cached && cacheLookup(code, index, nullptr, &val)) {
+        return 1;
+    }
+    
     uint8_t response[256];
     uint32_t responseLen = sizeof(response);
     int32_t result;
     
     switch (code) {
-        case XControl::XINT_TIME:
-            result = sendCommand(CommandCode::INTEGRATION_TIME, Operation::READ, 0x00,
-                               nullptr, 0, response, &responseLen);
-            if (result > 0 && responseLen >= 8) {
-                val = (uint64_t(response[4]) << 24) | (uint64_t(response[5]) << 16) |
-                      (uint64_t(response[6]) << 8) | uint64_t(response[7]);
-            }
-            return result;
-            
-        case XControl::XNON_INTTIME:
-            result = sendCommand(CommandCode::NON_INT_TIME, Operation::READ, 0x00,
-                               nullptr, 0, response, &responseLen);
-            if (result > 0 && responseLen >= 6) {
-                val = (uint64_t(response[4]) << 8) | uint64_t(response[5]);
-            }
-            return result;
-            
-        case XControl::XOPERATION:
-            result = sendCommand(CommandCode::OPERATION_MODE, Operation::READ, 0x00,
+        case XControl::XCU_SN:
+            result = sendCommand(CommandCode::GCU_SERIAL, Operation::READ, 0x00,
                                nullptr, 0, response, &responseLen);
             if (result > 0 && responseLen >= 5) {
-                val = response[4];
+                uint8_t strLen = response[3]; // Data length
+                if (strLen > 0 && responseLen >= (4 + strLen)) {
+                    val = std::string(reinterpret_cast<char*>(&response[4]), strLen);
+                }
             }
-            return result;
+            break;
             
-        case XControl::XDM_GAIN:
+        case XControl::XDM_SN:
             if (index == 0xFF) {
                 reportError(4, "DM index cannot be 0xFF for read");
                 return -1;
             }
-            result = sendCommand(CommandCode::DM_GAIN, Operation::READ, index,
-                               nullptr, 0, response, &responseLen);
-            if (result > 0 && responseLen >= 6) {
-                val = (uint64_t(response[4]) << 8) | uint64_t(response[5]);
-            }
-            return result;
-            
-        case XControl::XCHANNEL:
-            result = sendCommand(CommandCode::CHANNEL_CONFIG, Operation::READ, 0x00,
-                               nullptr, 0, response, &responseLen);
-            if (result > 0 && responseLen >= 9) {
-                val = (uint64_t(response[4]) << 24) | (uint64_t(response[5]) << 16) |
-                      (uint64_t(response[6]) << 8) | uint64_t(response[7]);
-            }
-            return result;
-            
-        case XControl::XPIXEL_NUM:
-            result = sendCommand(CommandCode::PIXEL_NUMBER, Operation::READ, 0x00,
-                               nullptr, 0, response, &responseLen);
-            if (result > 0 && responseLen >= 6) {
-                val = (uint64_t(response[4]) << 8) | uint64_t(response[5]);
-            }
-            return result;
-            
-        case XControl::XPIXEL_SIZE:
-            result = sendCommand(CommandCode::PIXEL_SIZE, Operation::READ, 0x00,
+            result = sendCommand(CommandCode::DM_SERIAL, Operation::READ, index,
                                nullptr, 0, response, &responseLen);
             if (result > 0 && responseLen >= 5) {
-                val = response[4];
+                uint8_t strLen = response[3];
+                if (strLen > 0 && responseLen >= (4 + strLen)) {
+                    val = std::string(reinterpret_cast<char*>(&response[4]), strLen);
+                }
             }
-            return result;
-            
-        case XControl::XPIXEL_DEPTH:
-            // Pixel depth is typically 16, 18, or 20 bits
-            val = 16; // Default, should be read from device
-            return 1;
-            
-        case XControl::XCU_VER:
-            result = sendCommand(CommandCode::GCU_FIRMWARE, Operation::READ, 0x00,
-                               nullptr, 0, response, &responseLen);
-            if (result > 0 && responseLen >= 6) {
-                val = (uint64_t(response[4]) << 8) | uint64_t(response[5]);
-            }
-            return result;
-            
-        case XControl::XLED:
-            result = sendCommand(CommandCode::LED_CONTROL, Operation::READ, 0x00,
-                               nullptr, 0, response, &responseLen);
-            if (result > 0 && responseLen >= 5) {
-                val = response[4];
-            }
-            return result;
-            
-        case XControl::XLINE_TRIGGER:
-            result = sendCommand(CommandCode::ENABLE_LINE_TRIGGER, Operation::READ, 0x00,
-                               nullptr, 0, response, &responseLen);
-            if (result > 0 && responseLen >= 5) {
-                val = response[4];
-            }
-            return result;
-            
-        case XControl::XFRAME_TRIGGER:
-            result = sendCommand(CommandCode::ENABLE_FRAME_TRIGGER, Operation::READ, 0x00,
-                               nullptr, 0, response, &responseLen);
-            if (result > 0 && responseLen >= 6) {
-                val = (uint64_t(response[4]) << 8) | uint64_t(response[5]);
-            }
-            return result;
+            break;
             
         default:
-            reportError(11, "Unsupported read code");
+            reportError(11, "Unsupported string read code");
             return 0;
     }
+    
+    if (result > 0) {
+        cacheRead(code, index, 0, &val);
+    }
+    return result;
 }
 
-int32_t XControl::Impl::read(XCode code, std::string& val, uint8_t index) {
+int32_t XControl::Impl::write(XCode code, uint64_t val, uint8_t index) {
+    Field field;
+    if (!writeField(code, field)) {
+        reportError(11, "Unsupported write code");
+        return 0;
+    }
+    if (field.indexed && !field.all && index == 0xFF) {
+        reportError(4, "DM index cannot be 0xFF for write");
+        return -1;
+    }
+    
+    uint8_t data[8];
+    uint8_t dataLen = encodeField(field, val, data);
     uint8_t response[256];
     uint32_t responseLen = sizeof(response);
-    int32_t result;
+    int32_t result = sendCommand(field.cmd, Operation::WRITE, field.indexed ? index : 0x00,
+                                 data, dataLen, response, &responseLen);
+    cacheWritten(code, index, val, result);
+    return result;
+}
+
+uint32_t XControl::Impl::readAsync(XCode code, uint8_t index) {
+    Field field;
+    if (!readField(code, field)) {
+        reportError(11, "Unsupported async read code");
+        return 0;
+    }
+    if (field.indexed && !field.all && index == 0xFF) {
+        reportError(4, "DM index cannot be 0xFF for read");
+        return 0;
+    }
     
-    switch (code) {
-        case XControl::XCU_SN:
-            result = sendCommand(CommandCode::GCU_SERIAL, Operation::READ, 0x00,
-                               nullptr, 0, response, &responseLen);
-            if (result > 0 && responseLen >= 5) {
-                uint8_t strLen = response[3]; // Data length
-                if (strLen > 0 && responseLen >= (4 + strLen)) {
-                    val = std::string(reinterpret_cast<char*>(&response[4]), strLen);
-                }
-            }
-            return result;
-            
-        case XControl::XDM_SN:
-            if (index == 0xFF) {
-                reportError(4, "DM index cannot be 0xFF for read");
-                return -1;
-            }
-            result = sendCommand(CommandCode::DM_SERIAL, Operation::READ, index,
-                               nullptr, 0, response, &responseLen);
-            if (result > 0 && responseLen >= 5) {
-                uint8_t strLen = response[3];
-                if (strLen > 0 && responseLen >= (4 + strLen)) {
-                    val = std::string(reinterpret_cast<char*>(&response[4]), strLen);
-                }
-            }
-            return result;
-            
-        default:
-            reportError(11, "Unsupported string read code");
-            return 0;
+    Pending pending;
+    pending.field = field;
+    pending.waiter = nullptr;
+    pending.heartbeat = false;
+    
+    std::unique_lock<std::mutex> lock(m_cmdMutex, std::defer_lock);
+    lockCommands(lock);
+    uint16_t sequence = 0;
+    if (post(lock, field.cmd, Operation::READ, field.indexed ? index : 0x00,
+             nullptr, 0, pending, sequence) < 0) {
+        return 0;
     }
+    return sequence;
 }
 
-int32_t XControl::Impl::write(XCode code, uint64_t val, uint8_t index) {
+uint32_t XControl::Impl::writeAsync(XCode code, uint64_t val, uint8_t index) {
+    Field field;
+    if (!writeField(code, field)) {
+        reportError(11, "Unsupported write code");
+        return 0;
+    }
+    if (field.indexed && !field.all && index == 0xFF) {
+        reportError(4, "DM index cannot be 0xFF for write");
+        return 0;
+    }
+    
     uint8_t data[8];
-    uint8_t dataLen = 0;
-    uint8_t response[256];
+    uint8_t dataLen = encodeField(field, val, data);
+    
+    // The outcome is only known to the sink
+    cacheWritten(code, index, val, -1);
+    
+    Pending pending;
+    pending.field = Field(); // Nothing to decode
+    pending.waiter = nullptr;
+    pending.heartbeat = false;
+    
+    std::unique_lock<std::mutex> lock(m_cmdMutex, std::defer_lock);
+    lockCommands(lock);
+    uint16_t sequence = 0;
+    if (post(lock, field.cmd, Operation::WRITE, field.indexed ? index : 0x00,
+             data, dataLen, pending, sequence) < 0) {
+        return 0;
+    }
+    return sequence;
+}
+
+bool XControl::Impl::waitAsync(uint32_t timeout) {
+    std::unique_lock<std::mutex> lock(m_cmdMutex);
+    return m_cmdCv.wait_for(lock, std::chrono::milliseconds(timeout),
+                            [this] { return asyncIdle(); });
+}
+
+void XControl::Impl::setMaxInFlight(uint32_t count) {
+    std::lock_guard<std::mutex> lock(m_cmdMutex);
+    m_maxInFlight = count > 0 ? count : 1;
+    m_cmdCv.notify_all();
+}
+
+bool XControl::Impl::batchField(const XItem& item, bool write, Field& field) {
+    const bool known = write ? writeField(item.code, field) :
+        (readField(item.code, field) || stringField(item.code, field));
+    
+    // Invalid indices take the single path, which reports them
+    return known && !(field.indexed && !field.all && item.index == 0xFF);
+}
+
+void XControl::Impl::single(XItem& item, bool write) {
+    Field field;
+    if (write) {
+        item.result = this->write(item.code, item.val, item.index);
+    } else if (stringField(item.code, field)) {
+        item.result = read(item.code, item.str, item.index);
+    } else {
+        item.result = read(item.code, item.val, item.index);
+    }
+}
+
+int32_t XControl::Impl::transact(XItem* items, uint32_t count, bool write) {
+    if (!items && count > 0) {
+        reportError(4, "Invalid transaction items");
+        return -1;
+    }
+    
+    // Both the command and its response carry at most 255 data bytes
+    const uint32_t BATCH_DATA = 255;
+    const uint32_t TEXT_RESPONSE = 4 + Internal::XLIB_MAX_SERIAL_LENGTH;
+    
+    std::vector<uint32_t> batch;
+    std::vector<Field> fields;
+    uint32_t commandBytes = 0;
+    uint32_t responseBytes = 0;
+    
+    auto flush = [&] {
+        if (batch.empty()) {
+            return;
+        }
+        if (!sendBatch(items, batch, fields, write)) {
+            for (size_t k = 0; k < batch.size(); ++k) {
+                single(items[batch[k]], write);
+            }
+        }
+        batch.clear();
+        fields.clear();
+        commandBytes = 0;
+        responseBytes = 0;
+    };
+    
+    for (uint32_t i = 0; i < count; ++i) {
+        XItem& item = items[i];
+        item.result = 0;
+        
+        if (!write && cacheLookup(item.code, item.index, &item.val, &item.str)) {
+            item.result = 1;
+            continue;
+        }
+        
+        Field field;
+        if (m_batchMode == BATCH_UNSUPPORTED || !batchField(item, write, field)) {
+            // Earlier items go first so writes keep their order
+            flush();
+            single(item, write);
+            continue;
+        }
+        
+        const uint32_t command = 4 + (write ? field.bytes : 0);
+        const uint32_t response = write ? 4 : (field.text ? TEXT_RESPONSE : field.minLen);
+        if (commandBytes + command > BATCH_DATA || responseBytes + response > BATCH_DATA) {
+            flush();
+        }
+        batch.push_back(i);
+        fields.push_back(field);
+        commandBytes += command;
+        responseBytes += response;
+    }
+    flush();
+    
+    int32_t succeeded = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        XItem& item = items[i];
+        if (write) {
+            cacheWritten(item.code, item.index, item.val, item.result);
+        } else if (item.result > 0) {
+            cacheRead(item.code, item.index, item.val, &item.str);
+        }
+        if (item.result > 0) {
+            ++succeeded;
+        }
+    }
+    return succeeded;
+}
+
+bool XControl::Impl::sendBatch(XItem* items, const std::vector<uint32_t>& batch,
+                               const std::vector<Field>& fields, bool write) {
+    // Sub-commands back to back, each with its own 4-byte header
+    uint8_t data[255];
+    uint32_t dataLen = 0;
+    for (size_t k = 0; k < batch.size(); ++k) {
+        const XItem& item = items[batch[k]];
+        const Field& field = fields[k];
+        data[dataLen++] = field.cmd;
+        data[dataLen++] = write ? Operation::WRITE : Operation::READ;
+        data[dataLen++] = field.indexed ? item.index : 0x00;
+        data[dataLen++] = write ? field.bytes : 0;
+        if (write) {
+            dataLen += encodeField(field, item.val, &data[dataLen]);
+        }
+    }
+    
+    uint8_t response[Internal::XLIB_MAX_RESPONSE_SIZE];
     uint32_t responseLen = sizeof(response);
+    uint8_t status = 0;
+    int32_t result = sendCommand(CommandCode::BATCH, Operation::EXECUTE, 0x00,
+                                 data, static_cast<uint8_t>(dataLen),
+                                 response, &responseLen, &status);
     
-    switch (code) {
-        case XControl::XINT_TIME:
-            data[0] = (val >> 24) & 0xFF;
-            data[1] = (val >> 16) & 0xFF;
-            data[2] = (val >> 8) & 0xFF;
-            data[3] = val & 0xFF;
-            dataLen = 4;
-            return sendCommand(CommandCode::INTEGRATION_TIME, Operation::WRITE, 0x00,
-                             data, dataLen, response, &responseLen);
-            
-        case XControl::XNON_INTTIME:
-            data[0] = (val >> 8) & 0xFF;
-            data[1] = val & 0xFF;
-            dataLen = 2;
-            return sendCommand(CommandCode::NON_INT_TIME, Operation::WRITE, 0x00,
-                             data, dataLen, response, &responseLen);
-            
-        case XControl::XOPERATION:
-            data[0] = val & 0xFF;
-            dataLen = 1;
-            return sendCommand(CommandCode::OPERATION_MODE, Operation::WRITE, 0x00,
-                             data, dataLen, response, &responseLen);
-            
-        case XControl::XDM_GAIN:
-            if (index == 0xFF) {
-                reportError(4, "DM index cannot be 0xFF for write");
-                return -1;
+    if (result < 0 && status != 0) {
+        // Refused as a whole: older firmware has no batch command
+        if (m_batchMode == BATCH_UNKNOWN) {
+            m_batchMode = BATCH_UNSUPPORTED;
+            HX_LOG_INFO("XControl") << "Batch commands not supported, using single commands";
+        }
+        return false;
+    }
+    if (result < 0) {
+        // Transport failure, already reported
+        for (size_t k = 0; k < batch.size(); ++k) {
+            items[batch[k]].result = -1;
+        }
+        return true;
+    }
+    m_batchMode = BATCH_SUPPORTED;
+    
+    // Sub-responses in command order, after the batch response header
+    uint32_t offset = 4;
+    bool malformed = false;
+    for (size_t k = 0; k < batch.size(); ++k) {
+        XItem& item = items[batch[k]];
+        const Field& field = fields[k];
+        const uint8_t* sub = &response[offset];
+        if (malformed || offset + 4 > responseLen ||
+            offset + 4 + sub[3] > responseLen || sub[0] != field.cmd) {
+            malformed = true;
+            item.result = -1;
+            continue;
+        }
+        
+        const uint32_t subLen = 4 + sub[3];
+        offset += subLen;
+        if (sub[2] != 0) {
+            reportError(17, "Device returned error code");
+            item.result = -1;
+            continue;
+        }
+        
+        item.result = static_cast<int32_t>(subLen);
+        if (write) {
+            continue;
+        }
+        if (field.text) {
+            if (sub[3] > 0) {
+                item.str = std::string(reinterpret_cast<const char*>(&sub[4]), sub[3]);
             }
-            data[0] = (val >> 8) & 0xFF;
-            data[1] = val & 0xFF;
-            dataLen = 2;
-            return sendCommand(CommandCode::DM_GAIN, Operation::WRITE, index,
-                             data, dataLen, response, &responseLen);
-            
-        case XControl::XBASE_LINE:
-            data[0] = (val >> 8) & 0xFF;
-            data[1] = val & 0xFF;
-            dataLen = 2;
-            return sendCommand(CommandCode::BASELINE_VALUE, Operation::WRITE, index,
-                             data, dataLen, response, &responseLen);
-            
-        case XControl::XLED:
-            data[0] = val & 0xFF;
-            dataLen = 1;
-            return sendCommand(CommandCode::LED_CONTROL, Operation::WRITE, 0x00,
-                             data, dataLen, response, &responseLen);
-            
-        case XControl::XLINE_TRIGGER:
-            data[0] = val & 0xFF;
-            dataLen = 1;
-            return sendCommand(CommandCode::ENABLE_LINE_TRIGGER, Operation::WRITE, 0x00,
-                             data, dataLen, response, &responseLen);
-            
-        case XControl::XFRAME_TRIGGER:
-            data[0] = (val >> 8) & 0xFF;
-            data[1] = val & 0xFF;
-            dataLen = 2;
-            return sendCommand(CommandCode::ENABLE_FRAME_TRIGGER, Operation::WRITE, 0x00,
-                             data, dataLen, response, &responseLen);
-            
-        case XControl::XLINE_TR_MODE:
-            data[0] = val & 0xFF;
-            dataLen = 1;
-            return sendCommand(CommandCode::LINE_TRIGGER_MODE, Operation::WRITE, 0x00,
-                             data, dataLen, response, &responseLen);
-            
-        case XControl::XFRAME_TR_MODE:
-            data[0] = val & 0xFF;
-            dataLen = 1;
-            return sendCommand(CommandCode::FRAME_TRIGGER_MODE, Operation::WRITE, 0x00,
-                             data, dataLen, response, &responseLen);
-            
-        default:
-            reportError(11, "Unsupported write code");
-            return 0;
+        } else if (subLen >= field.minLen) {
+            item.val = decodeField(field, sub);
+        }
+    }
+    if (malformed) {
+        reportError(16, "Invalid batch response");
+    }
+    return true;
+}
+
+void XControl::Impl::enableCache(bool enable) {
+    m_cacheEnabled = enable;
+    if (!enable) {
+        invalidateCache(false);
+    }
+}
+
+void XControl::Impl::invalidateCache(bool keepStatic) {
+    std::lock_guard<std::mutex> lock(m_cacheMutex);
+    if (!keepStatic) {
+        m_cache.clear();
+        return;
+    }
+    std::map<uint32_t, CacheEntry>::iterator it = m_cache.begin();
+    while (it != m_cache.end()) {
+        if (isStatic(static_cast<XCode>(it->first >> 8))) {
+            ++it;
+        } else {
+            m_cache.erase(it++);
+        }
+    }
+}
+
+bool XControl::Impl::cacheLookup(XCode code, uint8_t index, uint64_t* val, std::string* str) {
+    if (!m_cacheEnabled) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(m_cacheMutex);
+    std::map<uint32_t, CacheEntry>::const_iterator it =
+        m_cache.find((static_cast<uint32_t>(code) << 8) | index);
+    if (it == m_cache.end()) {
+        return false;
+    }
+    if (val) {
+        *val = it->second.val;
+    }
+    if (str) {
+        *str = it->second.str;
+    }
+    return true;
+}
+
+void XControl::Impl::cacheRead(XCode code, uint8_t index, uint64_t val, const std::string* str) {
+    if (!m_cacheEnabled) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(m_cacheMutex);
+    const uint32_t key = (static_cast<uint32_t>(code) << 8) | index;
+    
+    // Static values are kept once read; others only refresh what was written
+    if (!isStatic(code) && m_cache.find(key) == m_cache.end()) {
+        return;
+    }
+    CacheEntry& entry = m_cache[key];
+    entry.val = val;
+    entry.str = str ? *str : std::string();
+}
+
+void XControl::Impl::cacheWritten(XCode code, uint8_t index, uint64_t val, int32_t result) {
+    Field field;
+    if (!readField(code, field)) {
+        return; // Write-only parameter
+    }
+    std::lock_guard<std::mutex> lock(m_cacheMutex);
+    const uint32_t key = (static_cast<uint32_t>(code) << 8) | index;
+    if (result <= 0 || !m_cacheEnabled) {
+        m_cache.erase(key);
+        return;
     }
+    
+    // As read back: only the bytes the command carries
+    CacheEntry& entry = m_cache[key];
+    entry.val = field.bytes < 8 ? val & ((uint64_t(1) << (8 * field.bytes)) - 1) : val;
+    entry.str.clear();
 }
 
 bool XControl::Impl::enableHeartbeat(bool enable) {
@@ -578,9 +1515,14 @@ void XControl::Impl::startHeartbeat() {
     m_heartbeatRunning = true;
     m_missedHeartbeats = 0;
     
-    m_heartbeatThread = std::thread(&Impl::heartbeatThread, this);
+    m_nextBeat = std::chrono::steady_clock::now() +
+                 std::chrono::milliseconds(m_heartbeatPeriod.load());
+    m_heartbeatShared = Internal::ServiceLoop::instance().add(&m_heartbeatTask);
+    if (!m_heartbeatShared) {
+        m_heartbeatThread = std::thread(&Impl::heartbeatThread, this);
+    }
     
-    std::cout << "[XControl] Heartbeat monitoring started" << std::endl;
+    HX_LOG_INFO("XControl") << "Heartbeat monitoring started";
 }
 
 void XControl::Impl::stopHeartbeat() {
@@ -588,71 +1530,288 @@ void XControl::Impl::stopHeartbeat() {
         return;
     }
     
-    m_heartbeatRunning = false;
+    {
+        std::lock_guard<std::mutex> lock(m_heartbeatMutex);
+        m_heartbeatRunning = false;
+        m_heartbeatCv.notify_all();
+    }
     
+    if (m_heartbeatShared) {
+        Internal::ServiceLoop::instance().remove(&m_heartbeatTask);
+        m_heartbeatShared = false;
+    }
+    // The heartbeat thread, or when shared a reconnect still running
     if (m_heartbeatThread.joinable()) {
         m_heartbeatThread.join();
     }
+    m_reconnecting = false;
     
-    std::cout << "[XControl] Heartbeat monitoring stopped" << std::endl;
+    HX_LOG_INFO("XControl") << "Heartbeat monitoring stopped";
+}
+
+bool XControl::Impl::setHeartbeatPeriod(uint32_t period) {
+    if (period == 0) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(m_heartbeatMutex);
+    m_heartbeatPeriod = period;
+    m_heartbeatCv.notify_all();
+    m_nextBeat = std::chrono::steady_clock::now(); // Same as waking the thread
+    return true;
+}
+
+bool XControl::Impl::getTelemetry(float& temperature, float& humidity) {
+    std::lock_guard<std::mutex> lock(m_cmdMutex);
+    if (!m_telemetryValid) {
+        return false;
+    }
+    temperature = m_temperature;
+    humidity = m_humidity;
+    return true;
 }
 
 void XControl::Impl::heartbeatThread() {
-    std::cout << "[XControl] Heartbeat thread started" << std::endl;
+    Internal::ApplyThreadPolicy(XFactory::THREAD_HEARTBEAT);
+    
+    HX_LOG_DEBUG("XControl") << "Heartbeat thread started";
     
+    std::unique_lock<std::mutex> lock(m_heartbeatMutex);
     while (m_heartbeatRunning) {
-        std::this_thread::sleep_for(std::chrono::seconds(1));
+        // A period change applies from the next beat
+        if (!m_linkLost) {
+            m_heartbeatCv.wait_for(lock, std::chrono::milliseconds(m_heartbeatPeriod.load()));
+        }
         
         if (!m_heartbeatRunning) {
             break;
         }
         
-        // Send heartbeat request (read GCU info)
-        uint8_t response[256];
-        uint32_t responseLen = sizeof(response);
-        
-        int32_t result = sendCommand(CommandCode::GCU_INFO, Operation::READ, 0x00,
-                                     nullptr, 0, response, &responseLen);
+        if (m_linkLost) {
+            lock.unlock();
+            reconnect();
+            lock.lock();
+            continue;
+        }
         
-        if (result > 0) {
-            // Heartbeat successful
-            m_missedHeartbeats = 0;
-            
-            // Parse temperature and humidity if available
-            if (responseLen >= 10) {
-                float temp = static_cast<float>(response[4] | (response[5] << 8)) / 10.0f;
-                float humidity = static_cast<float>(response[6] | (response[7] << 8)) / 10.0f;
-                
-                reportEvent(107, temp);    // Temperature event
-                reportEvent(108, humidity); // Humidity event
+        lock.unlock();
+        postHeartbeat();
+        lock.lock();
+    }
+    
+    HX_LOG_DEBUG("XControl") << "Heartbeat thread stopped";
+}
+
+bool XControl::Impl::heartbeatPoll() {
+    std::unique_lock<std::mutex> lock(m_heartbeatMutex);
+    if (!m_heartbeatRunning) {
+        return false;
+    }
+    
+    // Reconnecting blocks for whole retry periods, so it gets a thread of
+    // its own rather than stalling every detector on the loop
+    if (m_linkLost) {
+        if (!m_reconnecting) {
+            if (m_heartbeatThread.joinable()) {
+                m_heartbeatThread.join(); // The previous reconnect, done
             }
-        } else {
-            // Heartbeat failed
-            m_missedHeartbeats++;
-            
-            if (m_missedHeartbeats >= 10) {
-                reportError(39, "Heartbeat failed - 10 consecutive misses");
-                std::cerr << "[XControl] WARNING: Connection may be lost" << std::endl;
-                m_missedHeartbeats = 0; // Reset to avoid spam
+            m_reconnecting = true;
+            m_heartbeatThread = std::thread([this] {
+                Internal::ApplyThreadPolicy(XFactory::THREAD_HEARTBEAT);
+                reconnect();
+                std::lock_guard<std::mutex> done(m_heartbeatMutex);
+                m_reconnecting = false;
+                m_nextBeat = std::chrono::steady_clock::now() +
+                             std::chrono::milliseconds(m_heartbeatPeriod.load());
+            });
+        }
+        return false;
+    }
+    if (m_reconnecting) {
+        return false;
+    }
+    
+    const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    if (now < m_nextBeat) {
+        return false;
+    }
+    // A period change applies from the next beat
+    m_nextBeat = now + std::chrono::milliseconds(m_heartbeatPeriod.load());
+    lock.unlock();
+    postHeartbeat();
+    return false;
+}
+
+void XControl::Impl::postHeartbeat() {
+    std::unique_lock<std::mutex> lock(m_cmdMutex, std::defer_lock);
+    lockCommands(lock);
+    
+    // The previous one is still in flight: its expiry counts the miss
+    if (!m_channelRunning || m_heartbeatSequence != 0) {
+        return;
+    }
+    
+    // Send heartbeat request (read GCU info); the receive thread handles the answer
+    Pending pending;
+    pending.field = Field();
+    pending.waiter = nullptr;
+    pending.heartbeat = true;
+    
+    uint16_t sequence = 0;
+    if (post(lock, CommandCode::GCU_INFO, Operation::READ, 0x00,
+             nullptr, 0, pending, sequence) == 0) {
+        m_heartbeatSequence = sequence;
+    } else {
+        lock.unlock();
+        heartbeatMissed();
+    }
+}
+
+void XControl::Impl::heartbeatMissed() {
+    if (m_heartbeatsMissedTotal) {
+        m_heartbeatsMissedTotal->add();
+    }
+    if (++m_missedHeartbeats >= 10) {
+        if (m_linkLostTotal) {
+            m_linkLostTotal->add();
+        }
+        reportError(39, "Heartbeat failed - 10 consecutive misses");
+        HX_LOG_WARNING("XControl") << "Connection may be lost";
+        m_missedHeartbeats = 0; // Reset to avoid spam
+        
+        if (m_autoReconnect) {
+            std::lock_guard<std::mutex> lock(m_heartbeatMutex);
+            m_linkLost = true;
+            m_heartbeatCv.notify_all();
+        }
+    }
+}
+
+void XControl::Impl::setAutoReconnect(bool enable, uint32_t retry) {
+    m_autoReconnect = enable;
+    m_reconnectRetry = retry > 0 ? retry : 1;
+}
+
+void XControl::Impl::reconnect() {
+    std::chrono::steady_clock::time_point lastAnswer;
+    {
+        std::lock_guard<std::mutex> lock(m_cmdMutex);
+        lastAnswer = m_lastAnswer;
+    }
+    
+    HX_LOG_WARNING("XControl") << "Link lost, reconnecting to " << m_detector.GetIP();
+    
+    // Grabbers let go of their sockets before the network closes
+    {
+        std::lock_guard<std::mutex> lock(m_linkMutex);
+        for (size_t i = 0; i < m_linkListeners.size(); ++i) {
+            m_linkListeners[i]->onLinkLost();
+        }
+    }
+    
+    uint32_t attempts = 0;
+    for (;;) {
+        stopChannel();
+        Internal::XLibProxy_CloseNetwork();
+        
+        ++attempts;
+        if (reopen()) {
+            break;
+        }
+        
+        std::unique_lock<std::mutex> lock(m_heartbeatMutex);
+        m_heartbeatCv.wait_for(lock, std::chrono::milliseconds(m_reconnectRetry.load()),
+                               [this] { return !m_heartbeatRunning; });
+        if (!m_heartbeatRunning) {
+            return; // Closed meanwhile; close() finishes the teardown
+        }
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(m_heartbeatMutex);
+        m_linkLost = false;
+    }
+    m_missedHeartbeats = 0;
+    m_reconnectsTotal->add();
+    
+    restoreWritten();
+    
+    const uint32_t gap = static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - lastAnswer).count());
+    HX_LOG_INFO("XControl") << "Reconnected after " << gap << " ms (" << attempts
+                            << " attempt(s))";
+    reportEvent(109, static_cast<float>(gap));
+    
+    std::lock_guard<std::mutex> lock(m_linkMutex);
+    for (size_t i = 0; i < m_linkListeners.size(); ++i) {
+        m_linkListeners[i]->onLinkRestored(gap);
+    }
+}
+
+bool XControl::Impl::reopen() {
+    if (Internal::XLibProxy_InitNetwork(m_detector.GetIP().c_str(), m_detector.GetCmdPort()) < 0) {
+        return false;
+    }
+    startChannel();
+    
+    // Up once the detector answers; waiting a beat keeps retries on the period
+    uint8_t response[256];
+    uint32_t responseLen = sizeof(response);
+    return sendCommand(CommandCode::GCU_INFO, Operation::READ, 0x00, nullptr, 0,
+                       response, &responseLen, nullptr, m_heartbeatPeriod.load()) > 0;
+}
+
+void XControl::Impl::restoreWritten() {
+    // Every cached value that is not static was written by this client
+    std::vector<XItem> items;
+    {
+        std::lock_guard<std::mutex> lock(m_cacheMutex);
+        for (std::map<uint32_t, CacheEntry>::const_iterator it = m_cache.begin();
+             it != m_cache.end(); ++it) {
+            const XCode code = static_cast<XCode>(it->first >> 8);
+            if (isStatic(code)) {
+                continue;
             }
+            XItem item;
+            item.code = code;
+            item.index = static_cast<uint8_t>(it->first & 0xFF);
+            item.val = it->second.val;
+            item.result = 0;
+            items.push_back(item);
         }
     }
+    if (items.empty()) {
+        return;
+    }
     
-    std::cout << "[XControl] Heartbeat thread stopped" << std::endl;
+    const int32_t written = transact(items.data(), static_cast<uint32_t>(items.size()), true);
+    HX_LOG_INFO("XControl") << "Restored " << written << " of " << items.size()
+                            << " written parameter(s)";
+}
+
+void XControl::Impl::addLinkListener(Internal::LinkListener* listener) {
+    std::lock_guard<std::mutex> lock(m_linkMutex);
+    m_linkListeners.push_back(listener);
+}
+
+void XControl::Impl::removeLinkListener(Internal::LinkListener* listener) {
+    // Waits for a notification in progress
+    std::lock_guard<std::mutex> lock(m_linkMutex);
+    for (size_t i = 0; i < m_linkListeners.size(); ++i) {
+        if (m_linkListeners[i] == listener) {
+            m_linkListeners.erase(m_linkListeners.begin() + i);
+            break;
+        }
+    }
 }
 
 void XControl::Impl::reportError(uint32_t errorId, const char* message) {
-    std::cerr << "[XControl] ERROR " << errorId << ": " << message << std::endl;
+    HX_LOG_ID(::HX::XFactory::LOG_ERROR, "XControl", errorId) << "ERROR " << errorId << ": " << message;
     
-    if (m_sink) {
-        m_sink->OnXError(errorId, message);
-    }
+    m_notify.error(errorId, message);
 }
 
 void XControl::Impl::reportEvent(uint32_t eventId, float data) {
-    if (m_sink) {
-        m_sink->OnXEvent(eventId, data);
-    }
+    m_notify.event(eventId, data);
 }
 
 // ============================================================================
@@ -682,6 +1841,7 @@ bool XControl::Open(XDetector& dec) {
 void XControl::Close() {
     if (m_impl) {
         m_impl->close();
+        Internal::NotifyFlush();
     }
 }
 
@@ -699,18 +1859,18 @@ int32_t XControl::Operate(XCode code, uint64_t data) {
     return m_impl->operate(code, data);
 }
 
-int32_t XControl::Read(XCode code, uint64_t& val, uint8_t index) {
+int32_t XControl::Read(XCode code, uint64_t& val, uint8_t index, bool cached) {
     if (!m_impl) {
         return -1;
     }
-    return m_impl->read(code, val, index);
+    return m_impl->read(code, val, index, cached);
 }
 
-int32_t XControl::Read(XCode code, std::string& val, uint8_t index) {
+int32_t XControl::Read(XCode code, std::string& val, uint8_t index, bool cached) {
     if (!m_impl) {
         return -1;
     }
-    return m_impl->read(code, val, index);
+    return m_impl->read(code, val, index, cached);
 }
 
 int32_t XControl::Write(XCode code, uint64_t val, uint8_t index) {
@@ -720,6 +1880,47 @@ int32_t XControl::Write(XCode code, uint64_t val, uint8_t index) {
     return m_impl->write(code, val, index);
 }
 
+uint32_t XControl::ReadAsync(XCode code, uint8_t index) {
+    if (!m_impl) {
+        return 0;
+    }
+    return m_impl->readAsync(code, index);
+}
+
+uint32_t XControl::WriteAsync(XCode code, uint64_t val, uint8_t index) {
+    if (!m_impl) {
+        return 0;
+    }
+    return m_impl->writeAsync(code, val, index);
+}
+
+bool XControl::WaitAsync(uint32_t timeout) {
+    if (!m_impl) {
+        return false;
+    }
+    return m_impl->waitAsync(timeout);
+}
+
+void XControl::SetMaxInFlight(uint32_t count) {
+    if (m_impl) {
+        m_impl->setMaxInFlight(count);
+    }
+}
+
+int32_t XControl::ReadMany(XItem* items, uint32_t count) {
+    if (!m_impl) {
+        return -1;
+    }
+    return m_impl->transact(items, count, false);
+}
+
+int32_t XControl::WriteMany(XItem* items, uint32_t count) {
+    if (!m_impl) {
+        return -1;
+    }
+    return m_impl->transact(items, count, true);
+}
+
 void XControl::SetSink(IXCmdSink* sink_) {
     if (m_impl) {
         m_impl->setSink(sink_);
@@ -738,6 +1939,18 @@ void XControl::SetTimeout(uint32_t time) {
     }
 }
 
+void XControl::EnableCache(bool enable) {
+    if (m_impl) {
+        m_impl->enableCache(enable);
+    }
+}
+
+void XControl::InvalidateCache() {
+    if (m_impl) {
+        m_impl->invalidateCache(false);
+    }
+}
+
 bool XControl::EnableHeartbeat(bool enable) {
     if (!m_impl) {
         return false;
@@ -745,4 +1958,55 @@ bool XControl::EnableHeartbeat(bool enable) {
     return m_impl->enableHeartbeat(enable);
 }
 
+bool XControl::SetHeartbeatPeriod(uint32_t period) {
+    if (!m_impl) {
+        return false;
+    }
+    return m_impl->setHeartbeatPeriod(period);
+}
+
+bool XControl::GetTelemetry(float& temperature, float& humidity) {
+    if (!m_impl) {
+        return false;
+    }
+    return m_impl->getTelemetry(temperature, humidity);
+}
+
+void XControl::GetStatistics(Statistics& stats) {
+    if (m_impl) {
+        m_impl->getStatistics(stats);
+    }
+}
+
+bool XControl::GetStatistics(XCode code, CommandStatistics& stats) {
+    if (!m_impl) {
+        return false;
+    }
+    return m_impl->getStatistics(code, stats);
+}
+
+void XControl::ResetStatistics() {
+    if (m_impl) {
+        m_impl->resetStatistics();
+    }
+}
+
+void XControl::SetAutoReconnect(bool enable, uint32_t retry) {
+    if (m_impl) {
+        m_impl->setAutoReconnect(enable, retry);
+    }
+}
+
+void XControl::addLinkListener(Internal::LinkListener* listener) {
+    if (m_impl) {
+        m_impl->addLinkListener(listener);
+    }
+}
+
+void XControl::removeLinkListener(Internal::LinkListener* listener) {
+    if (m_impl) {
+        m_impl->removeLinkListener(listener);
+    }
+}
+
 } // namespace HX
\ No newline at end of file
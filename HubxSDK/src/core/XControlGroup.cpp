@@ -0,0 +1,232 @@
+// ============================================================================
+// XControlGroup.cpp
+// ============================================================================
+
+/**
+ * @file XControlGroup.cpp
+ * @brief XControlGroup implementation - Commands fanned out to several detectors
+ * @version 2.1.0
+ */
+
+#include "XControlGroup.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace HX {
+
+class XControlGroup::Impl {
+public:
+    Impl() : m_lastSkew(0) {}
+
+    bool add(XControl& control);
+    void clear();
+    uint32_t count() const;
+
+    int32_t operate(XControl::XCode code, uint64_t data, int32_t* results);
+    int32_t write(XControl::XCode code, uint64_t val, uint8_t index, int32_t* results);
+    int32_t writeMany(const XControl::XItem* items, uint32_t count, int32_t* results);
+    uint32_t lastSkew() const;
+
+private:
+    void fanOut(const std::function<int32_t(XControl&)>& command, std::vector<int32_t>& results);
+
+    std::vector<XControl*> m_controls;
+    uint32_t m_lastSkew;            // Microseconds, last fanOut()
+    mutable std::mutex m_mutex;     // One group call at a time
+};
+
+bool XControlGroup::Impl::add(XControl& control) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (std::find(m_controls.begin(), m_controls.end(), &control) != m_controls.end()) {
+        return false;
+    }
+    m_controls.push_back(&control);
+    return true;
+}
+
+void XControlGroup::Impl::clear() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_controls.clear();
+}
+
+uint32_t XControlGroup::Impl::count() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return static_cast<uint32_t>(m_controls.size());
+}
+
+uint32_t XControlGroup::Impl::lastSkew() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_lastSkew;
+}
+
+void XControlGroup::Impl::fanOut(const std::function<int32_t(XControl&)>& command,
+                                 std::vector<int32_t>& results) {
+    const size_t n = m_controls.size();
+    results.assign(n, -1);
+    std::vector<std::chrono::steady_clock::time_point> started(n);
+    std::atomic<size_t> ready(0);
+    std::atomic<bool> go(false);
+
+    // Threads are parked before the release so start-up cost is not skew
+    std::vector<std::thread> threads;
+    threads.reserve(n);
+    for (size_t d = 0; d < n; ++d) {
+        threads.push_back(std::thread([&, d] {
+            ++ready;
+            while (!go) {
+                std::this_thread::yield();
+            }
+            started[d] = std::chrono::steady_clock::now();
+            results[d] = command(*m_controls[d]);
+        }));
+    }
+    while (ready < n) {
+        std::this_thread::yield();
+    }
+    go = true;
+
+    for (size_t d = 0; d < n; ++d) {
+        threads[d].join();
+    }
+
+    m_lastSkew = 0;
+    if (n > 1) {
+        const std::chrono::steady_clock::time_point first =
+            *std::min_element(started.begin(), started.end());
+        const std::chrono::steady_clock::time_point last =
+            *std::max_element(started.begin(), started.end());
+        m_lastSkew = static_cast<uint32_t>(
+            std::chrono::duration_cast<std::chrono::microseconds>(last - first).count());
+    }
+}
+
+int32_t XControlGroup::Impl::operate(XControl::XCode code, uint64_t data, int32_t* results) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    std::vector<int32_t> outcome;
+    fanOut([&](XControl& control) { return control.Operate(code, data); }, outcome);
+
+    int32_t succeeded = 0;
+    for (size_t d = 0; d < outcome.size(); ++d) {
+        if (results) {
+            results[d] = outcome[d];
+        }
+        if (outcome[d] > 0) {
+            ++succeeded;
+        }
+    }
+    return succeeded;
+}
+
+int32_t XControlGroup::Impl::write(XControl::XCode code, uint64_t val, uint8_t index,
+                                   int32_t* results) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    std::vector<int32_t> outcome;
+    fanOut([&](XControl& control) { return control.Write(code, val, index); }, outcome);
+
+    int32_t succeeded = 0;
+    for (size_t d = 0; d < outcome.size(); ++d) {
+        if (results) {
+            results[d] = outcome[d];
+        }
+        if (outcome[d] > 0) {
+            ++succeeded;
+        }
+    }
+    return succeeded;
+}
+
+int32_t XControlGroup::Impl::writeMany(const XControl::XItem* items, uint32_t count,
+                                       int32_t* results) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    // WriteMany() fills in per-item results, so each detector gets a copy
+    std::vector<int32_t> outcome;
+    fanOut([&](XControl& control) {
+        std::vector<XControl::XItem> copy(items, items + (items ? count : 0));
+        return control.WriteMany(copy.empty() ? nullptr : copy.data(), count);
+    }, outcome);
+
+    int32_t succeeded = 0;
+    for (size_t d = 0; d < outcome.size(); ++d) {
+        if (results) {
+            results[d] = outcome[d];
+        }
+        if (outcome[d] >= 0 && static_cast<uint32_t>(outcome[d]) == count) {
+            ++succeeded;
+        }
+    }
+    return succeeded;
+}
+
+// ============================================================================
+// XControlGroup Public Interface Implementation
+// ============================================================================
+
+XControlGroup::XControlGroup()
+    : m_impl(new Impl())
+{
+}
+
+XControlGroup::~XControlGroup() {
+    if (m_impl) {
+        delete m_impl;
+        m_impl = nullptr;
+    }
+}
+
+bool XControlGroup::Add(XControl& control) {
+    if (!m_impl) {
+        return false;
+    }
+    return m_impl->add(control);
+}
+
+void XControlGroup::Clear() {
+    if (m_impl) {
+        m_impl->clear();
+    }
+}
+
+uint32_t XControlGroup::GetCount() {
+    if (!m_impl) {
+        return 0;
+    }
+    return m_impl->count();
+}
+
+int32_t XControlGroup::Operate(XControl::XCode code, uint64_t data, int32_t* results) {
+    if (!m_impl) {
+        return -1;
+    }
+    return m_impl->operate(code, data, results);
+}
+
+int32_t XControlGroup::Write(XControl::XCode code, uint64_t val, uint8_t index, int32_t* results) {
+    if (!m_impl) {
+        return -1;
+    }
+    return m_impl->write(code, val, index, results);
+}
+
+int32_t XControlGroup::WriteMany(const XControl::XItem* items, uint32_t count, int32_t* results) {
+    if (!m_impl) {
+        return -1;
+    }
+    return m_impl->writeMany(items, count, results);
+}
+
+uint32_t XControlGroup::GetLastSkew() {
+    if (!m_impl) {
+        return 0;
+    }
+    return m_impl->lastSkew();
+}
+
+} // namespace HX
@@ -0,0 +1,425 @@
+// ============================================================================
+// XCorrectedView.cpp - Raw frames corrected on demand
+// ============================================================================
+
+/**
+ * @file XCorrectedView.cpp
+ * @brief XCorrectedView implementation - band-wise correction with an LRU band cache
+ * @version 2.1.0
+ */
+
+#include "XCorrectedView.h"
+#include "XImage.h"
+#include "ixline_filter.h"
+#include "utils/mem_budget.h"
+#include <algorithm>
+#include <cstring>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace HX {
+
+namespace {
+
+const uint32_t DEFAULT_TILE_ROWS = 64;
+const uint32_t MAX_TILE_ROWS = 4096;
+const uint32_t DEFAULT_CACHE_BANDS = 64;
+const uint32_t MAX_CACHE_BANDS = 65536;
+
+} // anonymous namespace
+
+class XCorrectedView::Impl {
+public:
+    Impl();
+    ~Impl();
+
+    bool setSource(const XImage* raw, uint32_t firstRow);
+    bool addLineFilter(IXLineFilter* filter);
+    void clearLineFilters();
+    void setCalibrationVersion(uint64_t version);
+    uint64_t getCalibrationVersion() const;
+    bool setTileRows(uint32_t rows);
+    bool setCacheSize(uint32_t bands);
+    bool getRegion(uint32_t x, uint32_t y, uint32_t width, uint32_t height, XImage* out);
+    bool getPixel(uint32_t row, uint32_t col, uint32_t& value);
+    void invalidate();
+    Statistics getStatistics() const;
+
+private:
+    struct Band {
+        std::vector<uint8_t> pixels;    ///< Rows of rowBytes, back to back
+        std::list<uint32_t>::iterator lruPos;
+    };
+
+    // Called with m_mutex held
+    void drop();
+    const uint8_t* band(uint32_t index);
+    void correct(uint32_t index, std::vector<uint8_t>& pixels);
+    void trim();
+    void charge();
+
+    /// Drop least recently used bands for the memory budget
+    uint64_t release(uint64_t bytes);
+
+    mutable std::mutex m_mutex;
+    const XImage* m_raw;
+    uint32_t m_firstRow;
+    size_t m_rowBytes;
+    std::vector<IXLineFilter*> m_filters;
+    uint64_t m_version;
+    uint32_t m_tileRows;
+    uint32_t m_cacheBands;
+
+    std::map<uint32_t, std::unique_ptr<Band> > m_bands;
+    std::list<uint32_t> m_lru;          // Cached bands, most recent first
+    std::vector<std::unique_ptr<Band> > m_spare;   // Evicted, kept for their buffers
+    Statistics m_stats;
+    Internal::MemCharge m_memory;
+    Internal::MemReclaimer m_reclaimer;
+};
+
+XCorrectedView::Impl::Impl()
+    : m_raw(nullptr)
+    , m_firstRow(0)
+    , m_rowBytes(0)
+    , m_version(0)
+    , m_tileRows(DEFAULT_TILE_ROWS)
+    , m_cacheBands(DEFAULT_CACHE_BANDS)
+    , m_stats()
+    , m_memory(XFactory::MEM_DISPLAY)
+    , m_reclaimer(Internal::MemReclaimer::RECLAIM_VIEW,
+                  [this](uint64_t bytes) { return release(bytes); })
+{
+    m_reclaimer.add();
+}
+
+XCorrectedView::Impl::~Impl() {
+    m_reclaimer.remove();
+}
+
+bool XCorrectedView::Impl::setSource(const XImage* raw, uint32_t firstRow) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (raw && (!raw->_data_ || raw->_width == 0 || raw->_height == 0 ||
+                raw->_pixel_depth == 0 || raw->_pixel_depth > 16)) {
+        return false;
+    }
+    m_raw = raw;
+    m_firstRow = firstRow;
+    m_rowBytes = raw ? static_cast<size_t>(raw->_width) * ((raw->_pixel_depth + 7) / 8) : 0;
+    m_spare.clear();
+    drop();
+    m_stats = Statistics();
+    return true;
+}
+
+bool XCorrectedView::Impl::addLineFilter(IXLineFilter* filter) {
+    if (!filter) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_filters.push_back(filter);
+    drop();
+    return true;
+}
+
+void XCorrectedView::Impl::clearLineFilters() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_filters.clear();
+    drop();
+}
+
+void XCorrectedView::Impl::setCalibrationVersion(uint64_t version) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (version != m_version) {
+        m_version = version;
+        drop();
+    }
+}
+
+uint64_t XCorrectedView::Impl::getCalibrationVersion() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_version;
+}
+
+bool XCorrectedView::Impl::setTileRows(uint32_t rows) {
+    if (rows == 0 || rows > MAX_TILE_ROWS) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (rows != m_tileRows) {
+        m_tileRows = rows;
+        m_spare.clear();
+        drop();
+    }
+    return true;
+}
+
+bool XCorrectedView::Impl::setCacheSize(uint32_t bands) {
+    if (bands == 0 || bands > MAX_CACHE_BANDS) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_cacheBands = bands;
+    trim();
+    return true;
+}
+
+void XCorrectedView::Impl::invalidate() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    drop();
+}
+
+void XCorrectedView::Impl::drop() {
+    for (std::map<uint32_t, std::unique_ptr<Band> >::iterator it = m_bands.begin();
+         it != m_bands.end(); ++it) {
+        m_spare.push_back(std::move(it->second));
+    }
+    m_bands.clear();
+    m_lru.clear();
+    if (m_spare.size() > 1) {
+        m_spare.resize(1);
+    }
+    m_stats.bandsCached = 0;
+    charge();
+}
+
+void XCorrectedView::Impl::trim() {
+    // Over the memory budget only the band just corrected is kept
+    const size_t keep = Internal::MemOverBudget() ? 1 : m_cacheBands;
+    while (m_bands.size() > keep) {
+        const uint32_t oldest = m_lru.back();
+        m_lru.pop_back();
+        std::map<uint32_t, std::unique_ptr<Band> >::iterator it = m_bands.find(oldest);
+        m_spare.push_back(std::move(it->second));
+        m_bands.erase(it);
+    }
+    // One spare buffer is enough to correct the next band into
+    if (m_spare.size() > 1) {
+        m_spare.resize(1);
+    }
+    m_stats.bandsCached = static_cast<uint32_t>(m_bands.size());
+    charge();
+}
+
+void XCorrectedView::Impl::charge() {
+    m_memory.set(static_cast<uint64_t>(m_bands.size() + m_spare.size()) * m_rowBytes * m_tileRows);
+}
+
+uint64_t XCorrectedView::Impl::release(uint64_t bytes) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const uint64_t bandBytes = static_cast<uint64_t>(m_rowBytes) * m_tileRows;
+    uint64_t released = 0;
+    if (!m_spare.empty()) {
+        released += bandBytes * m_spare.size();
+        m_spare.clear();
+    }
+    while (released < bytes && !m_lru.empty()) {
+        m_bands.erase(m_lru.back());
+        m_lru.pop_back();
+        released += bandBytes;
+    }
+    m_stats.bandsCached = static_cast<uint32_t>(m_bands.size());
+    charge();
+    return released;
+}
+
+void XCorrectedView::Impl::correct(uint32_t index, std::vector<uint8_t>& pixels) {
+    const XImage& raw = *m_raw;
+    const uint32_t first = index * m_tileRows;
+    const uint32_t rows = std::min(m_tileRows, raw._height - first);
+    pixels.resize(m_rowBytes * rows);
+
+    // As XFrame does: the first filter writes the row, the rest run in place
+    for (uint32_t r = 0; r < rows; ++r) {
+        const uint8_t* src = raw._data_ + raw._data_offset + static_cast<size_t>(first + r) * raw._stride;
+        uint8_t* dst = pixels.data() + m_rowBytes * r;
+        const uint32_t row = m_firstRow + first + r;
+        if (m_filters.empty()) {
+            std::memcpy(dst, src, m_rowBytes);
+            continue;
+        }
+        m_filters[0]->OnLine(src, dst, raw._width, raw._pixel_depth, row);
+        for (size_t i = 1; i < m_filters.size(); ++i) {
+            m_filters[i]->OnLine(dst, dst, raw._width, raw._pixel_depth, row);
+        }
+    }
+    m_stats.rowsCorrected += rows;
+}
+
+const uint8_t* XCorrectedView::Impl::band(uint32_t index) {
+    std::map<uint32_t, std::unique_ptr<Band> >::iterator it = m_bands.find(index);
+    if (it != m_bands.end()) {
+        ++m_stats.bandHits;
+        m_lru.splice(m_lru.begin(), m_lru, it->second->lruPos);
+        return it->second->pixels.data();
+    }
+
+    ++m_stats.bandMisses;
+    std::unique_ptr<Band> entry;
+    if (!m_spare.empty()) {
+        entry = std::move(m_spare.back());
+        m_spare.pop_back();
+    } else {
+        entry.reset(new Band());
+    }
+    correct(index, entry->pixels);
+    m_lru.push_front(index);
+    entry->lruPos = m_lru.begin();
+    const uint8_t* pixels = entry->pixels.data();
+    m_bands[index] = std::move(entry);
+    trim();
+    return pixels;
+}
+
+bool XCorrectedView::Impl::getRegion(uint32_t x, uint32_t y, uint32_t width, uint32_t height,
+                                     XImage* out) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_raw || !out || x >= m_raw->_width || y >= m_raw->_height || width == 0 || height == 0) {
+        return false;
+    }
+    width = std::min(width, m_raw->_width - x);
+    height = std::min(height, m_raw->_height - y);
+    const uint8_t depth = static_cast<uint8_t>(m_raw->_pixel_depth);
+    if (out->_width != width || out->_height != height || out->_pixel_depth != depth || !out->_data_) {
+        if (!out->Allocate(width, height, depth)) {
+            return false;
+        }
+    }
+
+    const size_t pixelBytes = (depth + 7) / 8;
+    const size_t copyBytes = static_cast<size_t>(width) * pixelBytes;
+    uint8_t* target = out->_data_ + out->_data_offset;
+    for (uint32_t row = y; row < y + height;) {
+        const uint32_t index = row / m_tileRows;
+        const uint8_t* pixels = band(index);
+        const uint32_t bandEnd = std::min((index + 1) * m_tileRows, y + height);
+        for (; row < bandEnd; ++row) {
+            std::memcpy(target + static_cast<size_t>(row - y) * out->_stride,
+                        pixels + m_rowBytes * (row - index * m_tileRows) + x * pixelBytes,
+                        copyBytes);
+        }
+    }
+    out->_info = m_raw->_info;
+    out->_info.calibrationVersion = m_version;
+    return true;
+}
+
+bool XCorrectedView::Impl::getPixel(uint32_t row, uint32_t col, uint32_t& value) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_raw || row >= m_raw->_height || col >= m_raw->_width) {
+        return false;
+    }
+    const uint8_t* pixels = band(row / m_tileRows) + m_rowBytes * (row % m_tileRows);
+    if (m_raw->_pixel_depth <= 8) {
+        value = pixels[col];
+    } else {
+        uint16_t pixel;
+        std::memcpy(&pixel, pixels + static_cast<size_t>(col) * 2, sizeof(pixel));
+        value = pixel;
+    }
+    return true;
+}
+
+XCorrectedView::Statistics XCorrectedView::Impl::getStatistics() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+// ============================================================================
+// XCorrectedView public interface
+// ============================================================================
+
+XCorrectedView::XCorrectedView()
+    : m_impl(new Impl())
+{
+}
+
+XCorrectedView::~XCorrectedView() {
+    if (m_impl) {
+        delete m_impl;
+        m_impl = nullptr;
+    }
+}
+
+bool XCorrectedView::SetSource(const XImage* raw, uint32_t firstRow) {
+    if (!m_impl) {
+        return false;
+    }
+    return m_impl->setSource(raw, firstRow);
+}
+
+bool XCorrectedView::AddLineFilter(IXLineFilter* filter) {
+    if (!m_impl) {
+        return false;
+    }
+    return m_impl->addLineFilter(filter);
+}
+
+void XCorrectedView::ClearLineFilters() {
+    if (!m_impl) {
+        return;
+    }
+    m_impl->clearLineFilters();
+}
+
+void XCorrectedView::SetCalibrationVersion(uint64_t version) {
+    if (!m_impl) {
+        return;
+    }
+    m_impl->setCalibrationVersion(version);
+}
+
+uint64_t XCorrectedView::GetCalibrationVersion() const {
+    if (!m_impl) {
+        return 0;
+    }
+    return m_impl->getCalibrationVersion();
+}
+
+bool XCorrectedView::SetTileRows(uint32_t rows) {
+    if (!m_impl) {
+        return false;
+    }
+    return m_impl->setTileRows(rows);
+}
+
+bool XCorrectedView::SetCacheSize(uint32_t bands) {
+    if (!m_impl) {
+        return false;
+    }
+    return m_impl->setCacheSize(bands);
+}
+
+bool XCorrectedView::GetRegion(uint32_t x, uint32_t y, uint32_t width, uint32_t height, XImage* out) {
+    if (!m_impl) {
+        return false;
+    }
+    return m_impl->getRegion(x, y, width, height, out);
+}
+
+bool XCorrectedView::GetPixel(uint32_t row, uint32_t col, uint32_t& value) {
+    if (!m_impl) {
+        return false;
+    }
+    return m_impl->getPixel(row, col, value);
+}
+
+void XCorrectedView::Invalidate() {
+    if (!m_impl) {
+        return;
+    }
+    m_impl->invalidate();
+}
+
+XCorrectedView::Statistics XCorrectedView::GetStatistics() const {
+    if (!m_impl) {
+        Statistics empty = {};
+        return empty;
+    }
+    return m_impl->getStatistics();
+}
+
+} // namespace HX
@@ -12,13 +12,292 @@
 #include "XFile.h"
 #include "XImage.h"
 #include "XDetector.h"
+#include "XFrame.h"
+#include "utils/archive_index.h"
+#include "utils/clahe.h"
+#include "utils/delta_pack.h"
+#include "utils/thread_pool.h"
+#include "utils/tiff_writer.h"
+#include <algorithm>
+#include <climits>
+#include <cstdio>
 #include <fstream>
 #include <cstring>
 #include <ctime>
 #include <iostream>
+#include <memory>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
 
 namespace HX {
 
+using namespace Internal;
+
+namespace {
+
+uint32_t typeSize(uint16_t type) {
+    switch (type) {
+        case 1: case TIFF_ASCII: case 6: case 7: return 1;
+        case TIFF_SHORT: case 8: return 2;
+        case TIFF_LONG: case 9: case TIFF_FLOAT: case 13: return 4;
+        case 5: case 10: case 12: case TIFF_LONG8: case 17: case 18: return 8;
+        default: return 0;
+    }
+}
+
+/**
+ * @brief One parsed IFD entry (classic or BigTIFF)
+ */
+struct TiffEntry {
+    uint16_t tag;
+    uint16_t type;
+    uint64_t count;
+    uint8_t raw[8];
+    bool big;
+
+    TiffEntry(const uint8_t* p, bool big_) : big(big_) {
+        tag = loadLE<uint16_t>(p);
+        type = loadLE<uint16_t>(p + 2);
+        count = big ? loadLE<uint64_t>(p + 4) : loadLE<uint32_t>(p + 4);
+        std::memset(raw, 0, sizeof(raw));
+        std::memcpy(raw, p + (big ? 12 : 8), big ? 8 : 4);
+    }
+
+    /// Fetch the value bytes, inline or from the file
+    bool load(std::ifstream& file, std::vector<uint8_t>& value) const {
+        const uint32_t size = typeSize(type);
+        if (size == 0 || count > (64u << 20) / size) {
+            value.clear();
+            return true;    // Unknown type or implausible size: ignore the tag
+        }
+        value.resize(static_cast<size_t>(count * size));
+        if (value.size() <= (big ? 8u : 4u)) {
+            std::memcpy(value.data(), raw, value.size());
+            return true;
+        }
+        const uint64_t offset = big ? loadLE<uint64_t>(raw) : loadLE<uint32_t>(raw);
+        file.seekg(static_cast<std::streamoff>(offset));
+        file.read(reinterpret_cast<char*>(value.data()), value.size());
+        return file.good();
+    }
+
+    uint64_t integer(const std::vector<uint8_t>& value, size_t i) const {
+        const uint32_t size = typeSize(type);
+        if (size == 0 || (i + 1) * size > value.size()) {
+            return 0;
+        }
+        const uint8_t* p = value.data() + i * size;
+        switch (type) {
+            case TIFF_SHORT: return loadLE<uint16_t>(p);
+            case TIFF_LONG: return loadLE<uint32_t>(p);
+            case TIFF_LONG8: return loadLE<uint64_t>(p);
+            case 1: return p[0];
+            default: return 0;
+        }
+    }
+
+    void integers(const std::vector<uint8_t>& value, std::vector<uint64_t>& out) const {
+        out.resize(static_cast<size_t>(value.empty() ? 0 : count));
+        for (size_t i = 0; i < out.size(); ++i) {
+            out[i] = integer(value, i);
+        }
+    }
+
+    float real(const std::vector<uint8_t>& value) const {
+        if (type != TIFF_FLOAT || value.size() < 4) {
+            return 0.0f;
+        }
+        uint32_t bits = loadLE<uint32_t>(value.data());
+        float f;
+        std::memcpy(&f, &bits, sizeof(f));
+        return f;
+    }
+
+    std::string ascii(const std::vector<uint8_t>& value) const {
+        if (type != TIFF_ASCII) {
+            return std::string();
+        }
+        const char* p = reinterpret_cast<const char*>(value.data());
+        return std::string(p, strnlen(p, value.size()));
+    }
+};
+
+/// "YYYY-MM-DD HH:MM:SS" <-> TIFF "YYYY:MM:DD HH:MM:SS"
+std::string toTiffDate(std::string date) {
+    if (date.size() == 19 && date[4] == '-' && date[7] == '-') {
+        date[4] = ':';
+        date[7] = ':';
+    }
+    return date;
+}
+
+std::string fromTiffDate(std::string date) {
+    if (date.size() == 19 && date[4] == ':' && date[7] == ':') {
+        date[4] = '-';
+        date[7] = '-';
+    }
+    return date;
+}
+
+/**
+ * @brief Image geometry and strip table of a parsed TIFF
+ */
+struct TiffLayout {
+    uint32_t width;
+    uint32_t height;
+    uint32_t bits;              ///< BitsPerSample (container size)
+    uint32_t depth;             ///< Significant bits (HX_TAG_DEPTH, 0 if absent)
+    uint32_t compression;       ///< TIFF_COMPRESSION_NONE or an HX_COMPRESSION_*
+    uint32_t rowsPerStrip;      ///< 0 if absent (one strip)
+    uint32_t tileWidth;         ///< 0 for strips; offsets/counts are then per tile
+    uint32_t tileLength;
+    std::vector<uint64_t> stripOffsets;
+    std::vector<uint64_t> stripCounts;
+    std::string reference;      ///< HX_TAG_REFERENCE of temporal residuals
+
+    TiffLayout()
+        : width(0), height(0), bits(0), depth(0)
+        , compression(TIFF_COMPRESSION_NONE), rowsPerStrip(0)
+        , tileWidth(0), tileLength(0) {}
+
+    uint64_t pixelBytes() const {
+        return static_cast<uint64_t>(width) * (bits / 8) * height;
+    }
+
+    /// True if all strips follow each other, i.e. the pixels are one block
+    bool contiguous() const {
+        for (size_t i = 1; i < stripOffsets.size(); ++i) {
+            if (stripOffsets[i] != stripOffsets[i - 1] + stripCounts[i - 1]) {
+                return false;
+            }
+        }
+        return !stripOffsets.empty();
+    }
+};
+
+/// Longest chain of temporal files read back to their keyframe
+const uint32_t MAX_REFERENCE_CHAIN = 4096;
+
+/// Directory part of a path, with its separator ("" for a bare name)
+std::string directoryOf(const std::string& path) {
+    const size_t slash = path.find_last_of("/\\");
+    return slash == std::string::npos ? std::string() : path.substr(0, slash + 1);
+}
+
+/// One image of a tiled pyramid; level 0 points at the caller's pixels
+struct PyramidLevel {
+    uint32_t width;
+    uint32_t height;
+    size_t stride;
+    const uint8_t* pixels;
+    std::vector<uint8_t> storage;
+
+    PyramidLevel() : width(0), height(0), stride(0), pixels(nullptr) {}
+};
+
+/**
+ * @brief 2x2 box average of rows [firstRow, endRow) of dst
+ *
+ * An odd last column or row is repeated, so edge pixels average only the
+ * source pixels they cover.
+ */
+template <typename T>
+void halveRows(const PyramidLevel& src, PyramidLevel& dst, uint32_t firstRow, uint32_t endRow) {
+    for (uint32_t y = firstRow; y < endRow; ++y) {
+        const uint32_t y1 = std::min(2 * y + 1, src.height - 1);
+        const T* a = reinterpret_cast<const T*>(src.pixels + static_cast<size_t>(2 * y) * src.stride);
+        const T* b = reinterpret_cast<const T*>(src.pixels + static_cast<size_t>(y1) * src.stride);
+        T* out = reinterpret_cast<T*>(dst.storage.data() + static_cast<size_t>(y) * dst.stride);
+        for (uint32_t x = 0; x < dst.width; ++x) {
+            const uint32_t x0 = 2 * x;
+            const uint32_t x1 = std::min(x0 + 1, src.width - 1);
+            const uint64_t sum = static_cast<uint64_t>(a[x0]) + a[x1] + b[x0] + b[x1];
+            out[x] = static_cast<T>((sum + 2) / 4);
+        }
+    }
+}
+
+struct IoChunk {
+    const uint8_t* data;
+    size_t size;
+
+    IoChunk(const uint8_t* data_, size_t size_) : data(data_), size(size_) {}
+};
+
+/**
+ * @brief Write chunks to a new file with as few system calls as possible
+ *
+ * One writev() for header and contiguous pixels; padded images need one
+ * iovec per row, batched by IOV_MAX.
+ */
+bool writeChunks(const std::string& file, const std::vector<IoChunk>& chunks) {
+#ifdef _WIN32
+    FILE* f = fopen(file.c_str(), "wb");
+    if (!f) {
+        return false;
+    }
+    bool ok = true;
+    for (size_t i = 0; ok && i < chunks.size(); ++i) {
+        ok = fwrite(chunks[i].data, 1, chunks[i].size, f) == chunks[i].size;
+    }
+    ok = (fclose(f) == 0) && ok;
+    return ok;
+#else
+#ifdef IOV_MAX
+    const size_t maxIov = IOV_MAX;
+#else
+    const size_t maxIov = 1024;
+#endif
+    int fd = ::open(file.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        return false;
+    }
+
+    std::vector<struct iovec> iov(chunks.size());
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        iov[i].iov_base = const_cast<uint8_t*>(chunks[i].data);
+        iov[i].iov_len = chunks[i].size;
+    }
+
+    bool ok = true;
+    size_t first = 0;
+    while (ok && first < iov.size()) {
+        const int count = static_cast<int>(std::min(maxIov, iov.size() - first));
+        ssize_t written = ::writev(fd, &iov[first], count);
+        if (written < 0) {
+            ok = false;
+            break;
+        }
+        // Skip what was written; a short write resumes mid-chunk
+        size_t left = static_cast<size_t>(written);
+        while (first < iov.size() && left >= iov[first].iov_len) {
+            left -= iov[first].iov_len;
+            ++first;
+        }
+        if (left > 0) {
+            iov[first].iov_base = static_cast<uint8_t*>(iov[first].iov_base) + left;
+            iov[first].iov_len -= left;
+        }
+        while (first < iov.size() && iov[first].iov_len == 0) {
+            ++first;
+        }
+    }
+    ok = (::close(fd) == 0) && ok;
+    return ok;
+#endif
+}
+
+} // namespace
+
 class XFile::Impl {
 public:
     Impl();
@@ -26,7 +305,16 @@ public:
     ~Impl();
     
     bool read(const std::string& file);
+    bool map(const std::string& file);
+    XImage* image() const { return m_image; }
     bool write(const std::string& file);
+    void setCompression(XFCompression mode);
+    XFCompression getCompression() const;
+    void setReference(const XImage* reference, const std::string& file);
+    bool setTiling(uint32_t tileSize, uint32_t levels);
+    void setPyramidSource(const XFrame* frame) { m_pyramidSource = frame; }
+    void setIndexing(bool enable);
+    bool setContrastEnhancement(bool enable, uint32_t tiles, float clipLimit);
     
     bool get(XFCode code, uint32_t& data);
     bool get(XFCode code, float& data);
@@ -37,10 +325,28 @@ public:
     bool set(XFCode code, uint8_t* data_);
     
 private:
-    bool writeTIFFHeader(std::ofstream& file);
-    bool readTIFFHeader(std::ifstream& file);
+    bool writeStrips(const std::string& file, const XImage& image);
+    bool writeTiled(const std::string& file, const XImage& image);
+    void indexFile(const std::string& file, XFCompression compression, uint64_t dataOffset,
+                   uint64_t fileSize);
+    bool usableReference(const XImage& image) const;
+    bool parseTiff(std::ifstream& file, TiffLayout& layout);
+    bool readTiff(std::ifstream& file, const std::string& path);
+    bool readDeltaStrips(std::ifstream& file, const TiffLayout& layout, const std::string& path);
+    bool readTiles(std::ifstream& file, const TiffLayout& layout);
+    bool readLegacy(std::ifstream& file);
+    bool mapFile(const std::string& file, uint64_t offset, uint64_t bytes);
+    void unmap();
     
     XImage* m_image;
+    bool m_ownsImage;           ///< m_image was allocated by read() or map()
+    
+    // Read-only file mapping behind m_image after map()
+    uint8_t* m_mapBase;
+    size_t m_mapSize;
+#ifdef _WIN32
+    HANDLE m_mapHandle;
+#endif
     
     // Metadata
     uint32_t m_cols;
@@ -57,10 +363,30 @@ private:
     float m_humidity;
     std::string m_serialNum;
     std::string m_dateTime;
+    
+    XFCompression m_compression;
+    const XImage* m_reference;  ///< Frame of the temporal residuals (not owned)
+    std::string m_referenceFile;
+    uint32_t m_chainDepth;      ///< Files after this one in a reference chain read
+    uint32_t m_tileSize;        ///< 0 = strips
+    uint32_t m_tileLevels;      ///< Reduced levels, 0 = down to one tile
+    const XFrame* m_pyramidSource;  ///< Frames' own levels for writeTiled() (not owned)
+    bool m_indexing;
+    
+    // Export filter
+    bool m_enhance;
+    Internal::Clahe m_clahe;
+    XImage m_enhanced;          ///< Equalized copy of m_image written instead
 };
 
 XFile::Impl::Impl()
     : m_image(nullptr)
+    , m_ownsImage(false)
+    , m_mapBase(nullptr)
+    , m_mapSize(0)
+#ifdef _WIN32
+    , m_mapHandle(nullptr)
+#endif
     , m_cols(0)
     , m_rows(0)
     , m_depth(16)
@@ -73,11 +399,25 @@ XFile::Impl::Impl()
     , m_bin(0)
     , m_temp(0.0f)
     , m_humidity(0.0f)
+    , m_compression(XF_COMPRESS_NONE)
+    , m_reference(nullptr)
+    , m_chainDepth(0)
+    , m_tileSize(0)
+    , m_tileLevels(0)
+    , m_pyramidSource(nullptr)
+    , m_indexing(false)
+    , m_enhance(false)
 {
-    // Get current date/time
+    // Get current date/time (reentrant: files are opened from many threads)
     time_t now = time(nullptr);
+    struct tm local;
+#ifdef _WIN32
+    localtime_s(&local, &now);
+#else
+    localtime_r(&now, &local);
+#endif
     char timeStr[32];
-    strftime(timeStr, sizeof(timeStr), "%Y-%m-%d %H:%M:%S", localtime(&now));
+    strftime(timeStr, sizeof(timeStr), "%Y-%m-%d %H:%M:%S", &local);
     m_dateTime = timeStr;
 }
 
@@ -96,6 +436,10 @@ XFile::Impl::Impl(XImage* image, XDetector& det)
 }
 
 XFile::Impl::~Impl() {
+    unmap();
+    if (m_ownsImage) {
+        delete m_image;
+    }
 }
 
 bool XFile::Impl::write(const std::string& file) {
@@ -104,48 +448,546 @@ bool XFile::Impl::write(const std::string& file) {
         return false;
     }
     
-    std::ofstream outFile(file, std::ios::binary);
-    if (!outFile.is_open()) {
-        std::cerr << "[XFile] Failed to open file: " << file << std::endl;
-        return false;
+    const XImage* image = m_image;
+    if (m_enhance) {
+        if (!m_clahe.enhance(*m_image, m_enhanced)) {
+            std::cerr << "[XFile] Contrast enhancement needs 1-16 bit pixels" << std::endl;
+            return false;
+        }
+        image = &m_enhanced;
     }
+    return m_tileSize ? writeTiled(file, *image) : writeStrips(file, *image);
+}
+
+bool XFile::Impl::writeStrips(const std::string& file, const XImage& image) {
+    const uint32_t bytesPerPixel = (image._pixel_depth + 7) / 8;
+    const uint32_t rowBytes = image._width * bytesPerPixel;
+    const uint64_t pixelBytes = static_cast<uint64_t>(rowBytes) * image._height;
     
-    // Simple TIFF header (basic implementation)
-    // For production, use libtiff library
+    // Compressed strips are encoded first: their sizes go into the IFD.
+    // Without a usable reference a temporal file is a keyframe.
+    TiffStrips strips;
+    std::vector<std::vector<uint8_t> > encoded;
+    uint64_t storedBytes = pixelBytes;
+    XFCompression stored = XF_COMPRESS_NONE;
+    if (m_compression == XF_COMPRESS_DELTA || m_compression == XF_COMPRESS_TEMPORAL) {
+        const bool temporal = m_compression == XF_COMPRESS_TEMPORAL && usableReference(image);
+        const XImage* ref = temporal ? m_reference : nullptr;
+        stored = temporal ? XF_COMPRESS_TEMPORAL : XF_COMPRESS_DELTA;
+        strips.compression = temporal ? HX_COMPRESSION_TEMPORAL : HX_COMPRESSION_DELTA;
+        strips.rowsPerStrip = DeltaPackStripRows(image._width);
+        DeltaPackEncodeStrips(image._data_ + image._data_offset, image._stride,
+                              ref ? ref->_data_ + ref->_data_offset : nullptr, ref ? ref->_stride : 0,
+                              image._width, image._height, bytesPerPixel, strips.rowsPerStrip, encoded);
+        storedBytes = 0;
+        for (size_t i = 0; i < encoded.size(); ++i) {
+            strips.bytes.push_back(encoded[i].size());
+            storedBytes += encoded[i].size();
+        }
+    }
     
-    // Write custom metadata header
-    outFile << "FXIMAGE_TIFF" << std::endl;
-    outFile << "Width=" << m_cols << std::endl;
-    outFile << "Height=" << m_rows << std::endl;
-    outFile << "Depth=" << m_depth << std::endl;
-    outFile << "DMNum=" << m_dmNum << std::endl;
-    outFile << "DMType=" << m_dmType << std::endl;
-    outFile << "OpMode=" << m_opMode << std::endl;
-    outFile << "IntTime=" << m_intTime << std::endl;
-    outFile << "SerialNum=" << m_serialNum << std::endl;
-    outFile << "DateTime=" << m_dateTime << std::endl;
-    outFile << "Temperature=" << m_temp << std::endl;
-    outFile << "Humidity=" << m_humidity << std::endl;
-    outFile << "DATA_START" << std::endl;
+    // Header, IFD and tag values go in one buffer ahead of the pixels
+    TiffBuilder tiff(storedBytes + 64 * 1024 > 0xFFFFFFFFull);
+    tiff.addImageTags(image._width, image._height, bytesPerPixel, m_depth,
+                      toTiffDate(m_dateTime), encoded.empty() ? nullptr : &strips);
+    if (stored == XF_COMPRESS_TEMPORAL) {
+        tiff.addAscii(HX_TAG_REFERENCE, m_referenceFile);
+    }
+    tiff.addLong(HX_TAG_DM_NUM, m_dmNum);
+    tiff.addLong(HX_TAG_DM_TYPE, m_dmType);
+    tiff.addLong(HX_TAG_DM_PIX, m_dmPix);
+    tiff.addLong(HX_TAG_OP_MODE, m_opMode);
+    tiff.addLong(HX_TAG_INT_TIME, m_intTime);
+    tiff.addLong(HX_TAG_ENERGY, m_energy);
+    tiff.addLong(HX_TAG_BIN, m_bin);
+    tiff.addFloat(HX_TAG_TEMP, m_temp);
+    tiff.addFloat(HX_TAG_HUM, m_humidity);
+    tiff.addAscii(HX_TAG_SN, m_serialNum);
+    const std::vector<uint8_t>& header = tiff.finish();
     
-    // Write image data
-    outFile.write(reinterpret_cast<const char*>(m_image->_data_), m_image->_size);
+    // Pixel rows, dropping any row padding
+    const uint8_t* pixels = image._data_ + image._data_offset;
+    std::vector<IoChunk> chunks;
+    chunks.push_back(IoChunk(header.data(), header.size()));
+    if (!encoded.empty()) {
+        for (size_t i = 0; i < encoded.size(); ++i) {
+            chunks.push_back(IoChunk(encoded[i].data(), encoded[i].size()));
+        }
+    } else if (image._stride == rowBytes) {
+        chunks.push_back(IoChunk(pixels, static_cast<size_t>(pixelBytes)));
+    } else {
+        for (uint32_t row = 0; row < image._height; ++row) {
+            chunks.push_back(IoChunk(pixels + static_cast<size_t>(row) * image._stride, rowBytes));
+        }
+    }
     
-    outFile.close();
+    if (!writeChunks(file, chunks)) {
+        std::cerr << "[XFile] Failed to write file: " << file << std::endl;
+        return false;
+    }
+    if (m_indexing) {
+        indexFile(file, stored, header.size(), header.size() + storedBytes);
+    }
     
     std::cout << "[XFile] Saved to " << file << std::endl;
     
     return true;
 }
 
+bool XFile::Impl::writeTiled(const std::string& file, const XImage& image) {
+    const uint32_t bytesPerPixel = (image._pixel_depth + 7) / 8;
+    if (bytesPerPixel != 1 && bytesPerPixel != 2 && bytesPerPixel != 4) {
+        std::cerr << "[XFile] Tiled output needs 8, 16 or 32-bit pixels" << std::endl;
+        return false;
+    }
+    const uint32_t tile = m_tileSize;
+    const size_t tileBytes = static_cast<size_t>(tile) * tile * bytesPerPixel;
+    
+    // Full image, then halve until it fits in one tile (or the level count)
+    std::vector<PyramidLevel> levels(1);
+    levels.reserve(33);
+    levels[0].width = image._width;
+    levels[0].height = image._height;
+    levels[0].stride = image._stride;
+    levels[0].pixels = image._data_ + image._data_offset;
+    for (;;) {
+        const PyramidLevel& prev = levels.back();
+        const bool more = m_tileLevels ? levels.size() <= m_tileLevels
+                                       : (prev.width > tile || prev.height > tile);
+        if (!more || (prev.width == 1 && prev.height == 1)) {
+            break;
+        }
+        levels.push_back(PyramidLevel());
+        const PyramidLevel& src = levels[levels.size() - 2];
+        PyramidLevel& dst = levels.back();
+        dst.width = (src.width + 1) / 2;
+        dst.height = (src.height + 1) / 2;
+        
+        // Means of the frame's pyramid are these levels, reduced while it was assembled
+        const XImage* reduced = m_pyramidSource ?
+            m_pyramidSource->GetPyramid(&image, static_cast<uint32_t>(levels.size() - 1), XFrame::PYRAMID_MEAN) :
+            nullptr;
+        if (reduced && reduced->_width == dst.width && reduced->_height == dst.height &&
+            reduced->_pixel_depth == image._pixel_depth) {
+            dst.stride = reduced->_stride;
+            dst.pixels = reduced->_data_ + reduced->_data_offset;
+            continue;
+        }
+        dst.stride = static_cast<size_t>(dst.width) * bytesPerPixel;
+        dst.storage.resize(dst.stride * dst.height);
+        dst.pixels = dst.storage.data();
+        Internal::ThreadPool::instance().parallelRows(
+            static_cast<int>(dst.height), static_cast<int>(dst.width), [&](int r0, int r1) {
+            const uint32_t first = static_cast<uint32_t>(r0);
+            const uint32_t end = static_cast<uint32_t>(r1);
+            switch (bytesPerPixel) {
+                case 1: halveRows<uint8_t>(src, dst, first, end); break;
+                case 2: halveRows<uint16_t>(src, dst, first, end); break;
+                default: halveRows<uint32_t>(src, dst, first, end); break;
+            }
+        });
+    }
+    
+    uint64_t totalBytes = 0;
+    uint64_t totalTiles = 0;
+    for (size_t l = 0; l < levels.size(); ++l) {
+        const uint64_t tiles = static_cast<uint64_t>((levels[l].width + tile - 1) / tile) *
+                               ((levels[l].height + tile - 1) / tile);
+        totalTiles += tiles;
+        totalBytes += tiles * tileBytes;
+    }
+    const bool big = totalBytes + totalTiles * 16 + levels.size() * 64 * 1024 > 0xFFFFFFFFull;
+    
+    FILE* f = fopen(file.c_str(), "wb");
+    if (!f) {
+        std::cerr << "[XFile] Failed to write file: " << file << std::endl;
+        return false;
+    }
+    
+    // Each level: its directory, then its tiles one tile row at a time.
+    // The tiles of a row are gathered in parallel and written in one call.
+    bool ok = true;
+    uint64_t base = 0;
+    uint64_t dataOffset = 0;
+    std::vector<uint8_t> band;
+    for (size_t l = 0; ok && l < levels.size(); ++l) {
+        const PyramidLevel& level = levels[l];
+        const uint32_t across = (level.width + tile - 1) / tile;
+        const uint32_t down = (level.height + tile - 1) / tile;
+        const uint64_t dataBytes = static_cast<uint64_t>(across) * down * tileBytes;
+        
+        TiffBuilder tiff(big);
+        tiff.addTileTags(level.width, level.height, bytesPerPixel, tile, l > 0);
+        if (l == 0) {
+            tiff.addAscii(TIFF_SOFTWARE, "HubxSDK 2.1.0");
+            tiff.addAscii(TIFF_DATE_TIME, toTiffDate(m_dateTime));
+            tiff.addLong(HX_TAG_DEPTH, m_depth);
+            tiff.addLong(HX_TAG_DM_NUM, m_dmNum);
+            tiff.addLong(HX_TAG_DM_TYPE, m_dmType);
+            tiff.addLong(HX_TAG_DM_PIX, m_dmPix);
+            tiff.addLong(HX_TAG_OP_MODE, m_opMode);
+            tiff.addLong(HX_TAG_INT_TIME, m_intTime);
+            tiff.addLong(HX_TAG_ENERGY, m_energy);
+            tiff.addLong(HX_TAG_BIN, m_bin);
+            tiff.addFloat(HX_TAG_TEMP, m_temp);
+            tiff.addFloat(HX_TAG_HUM, m_humidity);
+            tiff.addAscii(HX_TAG_SN, m_serialNum);
+        }
+        const std::vector<uint8_t>& header = tiff.finishAt(base, 64, dataBytes, l + 1 < levels.size());
+        ok = fwrite(header.data(), 1, header.size(), f) == header.size();
+        if (l == 0) {
+            dataOffset = header.size();
+        }
+        
+        band.resize(static_cast<size_t>(across) * tileBytes);
+        const size_t tileRowBytes = static_cast<size_t>(tile) * bytesPerPixel;
+        for (uint32_t ty = 0; ok && ty < down; ++ty) {
+            const uint32_t y0 = ty * tile;
+            const uint32_t rows = std::min(tile, level.height - y0);
+            Internal::ThreadPool::instance().run(static_cast<int>(across), [&](int tx) {
+                const uint32_t x0 = static_cast<uint32_t>(tx) * tile;
+                const size_t used = static_cast<size_t>(std::min(tile, level.width - x0)) * bytesPerPixel;
+                uint8_t* out = band.data() + static_cast<size_t>(tx) * tileBytes;
+                for (uint32_t r = 0; r < tile; ++r, out += tileRowBytes) {
+                    if (r < rows) {
+                        std::memcpy(out, level.pixels + static_cast<size_t>(y0 + r) * level.stride +
+                                    static_cast<size_t>(x0) * bytesPerPixel, used);
+                        std::memset(out + used, 0, tileRowBytes - used);
+                    } else {
+                        std::memset(out, 0, tileRowBytes);
+                    }
+                }
+            });
+            ok = fwrite(band.data(), 1, band.size(), f) == band.size();
+        }
+        base += header.size() + dataBytes;
+    }
+    ok = (fclose(f) == 0) && ok;
+    
+    if (!ok) {
+        std::cerr << "[XFile] Failed to write file: " << file << std::endl;
+        return false;
+    }
+    if (m_indexing) {
+        indexFile(file, XF_COMPRESS_NONE, dataOffset, base);
+    }
+    
+    std::cout << "[XFile] Saved to " << file << " (" << levels.size() << " levels)" << std::endl;
+    
+    return true;
+}
+
+bool XFile::Impl::usableReference(const XImage& image) const {
+    return m_reference && m_reference->_data_ && !m_referenceFile.empty() &&
+           m_reference->_width == image._width && m_reference->_height == image._height &&
+           (m_reference->_pixel_depth + 7) / 8 == (image._pixel_depth + 7) / 8;
+}
+
+void XFile::Impl::indexFile(const std::string& file, XFCompression compression, uint64_t dataOffset,
+                            uint64_t fileSize) {
+    XArchiveIndex::Record record;
+    record.serialNum = m_serialNum;
+    record.dateTime = m_dateTime;
+    record.cols = m_image->_width;
+    record.rows = m_image->_height;
+    record.depth = m_depth;
+    record.dmNum = m_dmNum;
+    record.dmType = m_dmType;
+    record.dmPix = m_dmPix;
+    record.opMode = m_opMode;
+    record.intTime = m_intTime;
+    record.energy = m_energy;
+    record.bin = m_bin;
+    record.temp = m_temp;
+    record.humidity = m_humidity;
+    record.compression = compression;
+    record.tileSize = m_tileSize;
+    record.dataOffset = dataOffset;
+    record.fileSize = fileSize;
+    // The image itself is on disk; a missing record only slows queries down
+    if (!AppendArchiveRecord(file, record)) {
+        std::cerr << "[XFile] Failed to index file: " << file << std::endl;
+    }
+}
+
 bool XFile::Impl::read(const std::string& file) {
+    if (m_mapBase) {
+        // The image points into the old mapping; give it its own pixels again
+        unmap();
+        m_image->_data_ = nullptr;
+        m_image->Allocate(m_image->_width, m_image->_height, m_image->_pixel_depth);
+    }
+    
     std::ifstream inFile(file, std::ios::binary);
     if (!inFile.is_open()) {
         std::cerr << "[XFile] Failed to open file: " << file << std::endl;
         return false;
     }
     
-    // Read metadata
+    char magic[4] = {};
+    inFile.read(magic, sizeof(magic));
+    inFile.seekg(0);
+    
+    bool ok;
+    if (magic[0] == 'I' && magic[1] == 'I') {
+        ok = readTiff(inFile, file);
+    } else if (std::memcmp(magic, "FXIM", 4) == 0) {
+        ok = readLegacy(inFile);
+    } else {
+        std::cerr << "[XFile] Not a TIFF file: " << file << std::endl;
+        return false;
+    }
+    
+    inFile.close();
+    
+    if (!ok) {
+        std::cerr << "[XFile] Failed to read file: " << file << std::endl;
+        return false;
+    }
+    
+    std::cout << "[XFile] Loaded from " << file << std::endl;
+    
+    return true;
+}
+
+bool XFile::Impl::parseTiff(std::ifstream& inFile, TiffLayout& layout) {
+    uint8_t header[16];
+    inFile.read(reinterpret_cast<char*>(header), sizeof(header));
+    if (!inFile.good()) {
+        return false;
+    }
+    
+    const uint16_t version = loadLE<uint16_t>(header + 2);
+    const bool big = (version == 43);
+    if (version != 42 && !(big && loadLE<uint16_t>(header + 4) == 8)) {
+        return false;
+    }
+    const uint64_t ifdOffset = big ? loadLE<uint64_t>(header + 8) : loadLE<uint32_t>(header + 4);
+    
+    // Directory entry count, then the entries themselves
+    uint8_t countBytes[8];
+    inFile.seekg(static_cast<std::streamoff>(ifdOffset));
+    inFile.read(reinterpret_cast<char*>(countBytes), big ? 8 : 2);
+    if (!inFile.good()) {
+        return false;
+    }
+    const uint64_t entryCount = big ? loadLE<uint64_t>(countBytes) : loadLE<uint16_t>(countBytes);
+    const size_t entrySize = big ? 20 : 12;
+    if (entryCount == 0 || entryCount > 4096) {
+        return false;
+    }
+    std::vector<uint8_t> ifd(static_cast<size_t>(entryCount) * entrySize);
+    inFile.read(reinterpret_cast<char*>(ifd.data()), ifd.size());
+    if (!inFile.good()) {
+        return false;
+    }
+    
+    uint32_t samples = 1;
+    for (uint64_t i = 0; i < entryCount; ++i) {
+        TiffEntry entry(ifd.data() + i * entrySize, big);
+        std::vector<uint8_t> value;
+        if (!entry.load(inFile, value)) {
+            return false;
+        }
+        switch (entry.tag) {
+            case TIFF_IMAGE_WIDTH: layout.width = static_cast<uint32_t>(entry.integer(value, 0)); break;
+            case TIFF_IMAGE_LENGTH: layout.height = static_cast<uint32_t>(entry.integer(value, 0)); break;
+            case TIFF_BITS_PER_SAMPLE: layout.bits = static_cast<uint32_t>(entry.integer(value, 0)); break;
+            case TIFF_COMPRESSION: layout.compression = static_cast<uint32_t>(entry.integer(value, 0)); break;
+            case TIFF_SAMPLES_PER_PIXEL: samples = static_cast<uint32_t>(entry.integer(value, 0)); break;
+            case TIFF_ROWS_PER_STRIP: layout.rowsPerStrip = static_cast<uint32_t>(entry.integer(value, 0)); break;
+            case TIFF_STRIP_OFFSETS: entry.integers(value, layout.stripOffsets); break;
+            case TIFF_STRIP_BYTE_COUNTS: entry.integers(value, layout.stripCounts); break;
+            case TIFF_TILE_WIDTH: layout.tileWidth = static_cast<uint32_t>(entry.integer(value, 0)); break;
+            case TIFF_TILE_LENGTH: layout.tileLength = static_cast<uint32_t>(entry.integer(value, 0)); break;
+            case TIFF_TILE_OFFSETS: entry.integers(value, layout.stripOffsets); break;
+            case TIFF_TILE_BYTE_COUNTS: entry.integers(value, layout.stripCounts); break;
+            case TIFF_DATE_TIME: m_dateTime = fromTiffDate(entry.ascii(value)); break;
+            case HX_TAG_DEPTH: layout.depth = static_cast<uint32_t>(entry.integer(value, 0)); break;
+            case HX_TAG_DM_NUM: m_dmNum = static_cast<uint32_t>(entry.integer(value, 0)); break;
+            case HX_TAG_DM_TYPE: m_dmType = static_cast<uint32_t>(entry.integer(value, 0)); break;
+            case HX_TAG_DM_PIX: m_dmPix = static_cast<uint32_t>(entry.integer(value, 0)); break;
+            case HX_TAG_OP_MODE: m_opMode = static_cast<uint32_t>(entry.integer(value, 0)); break;
+            case HX_TAG_INT_TIME: m_intTime = static_cast<uint32_t>(entry.integer(value, 0)); break;
+            case HX_TAG_ENERGY: m_energy = static_cast<uint32_t>(entry.integer(value, 0)); break;
+            case HX_TAG_BIN: m_bin = static_cast<uint32_t>(entry.integer(value, 0)); break;
+            case HX_TAG_TEMP: m_temp = entry.real(value); break;
+            case HX_TAG_HUM: m_humidity = entry.real(value); break;
+            case HX_TAG_SN: m_serialNum = entry.ascii(value); break;
+            case HX_TAG_REFERENCE: layout.reference = entry.ascii(value); break;
+            default: break;
+        }
+    }
+    
+    // Grayscale, uncompressed or in the SDK's own codec
+    if (layout.width == 0 || layout.height == 0 || samples != 1 ||
+        (layout.compression != TIFF_COMPRESSION_NONE && layout.compression != HX_COMPRESSION_DELTA &&
+         layout.compression != HX_COMPRESSION_TEMPORAL) ||
+        (layout.compression == HX_COMPRESSION_TEMPORAL && layout.reference.empty()) ||
+        (layout.bits != 8 && layout.bits != 16 && layout.bits != 32) ||
+        layout.stripOffsets.empty() || layout.stripOffsets.size() != layout.stripCounts.size() ||
+        (layout.tileWidth && (layout.tileLength == 0 || layout.compression != TIFF_COMPRESSION_NONE))) {
+        return false;
+    }
+    
+    m_cols = layout.width;
+    m_rows = layout.height;
+    m_depth = layout.depth ? layout.depth : layout.bits;
+    m_compression = layout.compression == HX_COMPRESSION_DELTA ? XF_COMPRESS_DELTA :
+                    layout.compression == HX_COMPRESSION_TEMPORAL ? XF_COMPRESS_TEMPORAL : XF_COMPRESS_NONE;
+    return true;
+}
+
+bool XFile::Impl::readTiff(std::ifstream& inFile, const std::string& path) {
+    TiffLayout layout;
+    if (!parseTiff(inFile, layout)) {
+        return false;
+    }
+    const uint32_t width = layout.width;
+    const uint32_t height = layout.height;
+    const uint32_t bits = layout.bits;
+    const std::vector<uint64_t>& stripOffsets = layout.stripOffsets;
+    const std::vector<uint64_t>& stripCounts = layout.stripCounts;
+    
+    // Allocate image buffer
+    if (!m_image) {
+        m_image = new XImage(m_cols, m_rows, static_cast<uint8_t>(m_depth));
+        m_ownsImage = true;
+    }
+    const uint32_t rowBytes = width * (bits / 8);
+    if (!m_image->_data_ || m_image->_width != width || m_image->_height != height ||
+        static_cast<uint32_t>(m_image->_pixel_depth + 7) / 8 != bits / 8) {
+        return false;
+    }
+    if (layout.compression != TIFF_COMPRESSION_NONE) {
+        return readDeltaStrips(inFile, layout, path);
+    }
+    if (layout.tileWidth) {
+        return readTiles(inFile, layout);
+    }
+    
+    // Strips hold whole rows back to back; copy them row by row so padded
+    // image strides work as well
+    uint8_t* pixels = m_image->_data_ + m_image->_data_offset;
+    std::vector<uint8_t> rowBuffer(rowBytes);
+    uint64_t remaining = static_cast<uint64_t>(rowBytes) * height;
+    uint64_t filled = 0;
+    for (size_t strip = 0; strip < stripOffsets.size() && remaining > 0; ++strip) {
+        const uint64_t count = std::min<uint64_t>(stripCounts[strip], remaining);
+        inFile.seekg(static_cast<std::streamoff>(stripOffsets[strip]));
+        for (uint64_t done = 0; done < count;) {
+            const uint32_t row = static_cast<uint32_t>(filled / rowBytes);
+            const uint32_t col = static_cast<uint32_t>(filled % rowBytes);
+            const size_t chunk = static_cast<size_t>(std::min<uint64_t>(rowBytes - col, count - done));
+            inFile.read(reinterpret_cast<char*>(pixels) + static_cast<size_t>(row) * m_image->_stride + col,
+                        chunk);
+            if (!inFile.good()) {
+                return false;
+            }
+            done += chunk;
+            filled += chunk;
+        }
+        remaining -= count;
+    }
+    return remaining == 0;
+}
+
+bool XFile::Impl::readDeltaStrips(std::ifstream& inFile, const TiffLayout& layout,
+                                  const std::string& path) {
+    const uint32_t width = layout.width;
+    const uint32_t height = layout.height;
+    const uint32_t bytesPerPixel = layout.bits / 8;
+    const uint32_t rowsPerStrip = (layout.rowsPerStrip && layout.rowsPerStrip < height)
+                                  ? layout.rowsPerStrip : height;
+    const size_t count = (height + rowsPerStrip - 1) / rowsPerStrip;
+    if (layout.stripOffsets.size() < count) {
+        return false;
+    }
+    
+    // Read serially, decode in parallel
+    std::vector<std::vector<uint8_t> > encoded(count);
+    const size_t bound = DeltaPackBound(static_cast<size_t>(width) * rowsPerStrip);
+    for (size_t strip = 0; strip < count; ++strip) {
+        if (layout.stripCounts[strip] > bound) {
+            return false;
+        }
+        encoded[strip].resize(static_cast<size_t>(layout.stripCounts[strip]));
+        inFile.seekg(static_cast<std::streamoff>(layout.stripOffsets[strip]));
+        inFile.read(reinterpret_cast<char*>(encoded[strip].data()), encoded[strip].size());
+        if (!inFile.good()) {
+            return false;
+        }
+    }
+    
+    uint8_t* pixels = m_image->_data_ + m_image->_data_offset;
+    const uint8_t* ref = nullptr;
+    uint32_t refStride = 0;
+    if (layout.compression == HX_COMPRESSION_TEMPORAL) {
+        if (usableReference(*m_image) && m_referenceFile == layout.reference) {
+            ref = m_reference->_data_ + m_reference->_data_offset;
+            refStride = m_reference->_stride;
+        } else {
+            // Rebuild the reference in place, back from the last keyframe
+            if (m_chainDepth >= MAX_REFERENCE_CHAIN) {
+                std::cerr << "[XFile] Reference chain too long: " << path << std::endl;
+                return false;
+            }
+            std::unique_ptr<Impl> chain(new Impl());
+            chain->m_image = m_image;
+            chain->m_chainDepth = m_chainDepth + 1;
+            if (!chain->read(directoryOf(path) + layout.reference)) {
+                return false;
+            }
+            ref = pixels;
+            refStride = m_image->_stride;
+        }
+    }
+    return DeltaPackDecodeStrips(encoded, ref, refStride, width, height, bytesPerPixel, rowsPerStrip,
+                                 m_image->_stride, pixels);
+}
+
+bool XFile::Impl::readTiles(std::ifstream& inFile, const TiffLayout& layout) {
+    const uint32_t bytesPerPixel = layout.bits / 8;
+    const uint32_t tileWidth = layout.tileWidth;
+    const uint32_t tileLength = layout.tileLength;
+    const uint64_t tileBytes = static_cast<uint64_t>(tileWidth) * tileLength * bytesPerPixel;
+    const uint32_t across = (layout.width + tileWidth - 1) / tileWidth;
+    const uint32_t down = (layout.height + tileLength - 1) / tileLength;
+    if (tileBytes > (1u << 30) || layout.stripOffsets.size() < static_cast<uint64_t>(across) * down) {
+        return false;
+    }
+    
+    // Copy the part of each tile that lies inside the image
+    uint8_t* pixels = m_image->_data_ + m_image->_data_offset;
+    std::vector<uint8_t> tile(static_cast<size_t>(tileBytes));
+    const size_t tileRowBytes = static_cast<size_t>(tileWidth) * bytesPerPixel;
+    for (uint32_t ty = 0; ty < down; ++ty) {
+        const uint32_t y0 = ty * tileLength;
+        const uint32_t rows = std::min(tileLength, layout.height - y0);
+        for (uint32_t tx = 0; tx < across; ++tx) {
+            const size_t index = static_cast<size_t>(ty) * across + tx;
+            if (layout.stripCounts[index] < tileBytes) {
+                return false;
+            }
+            inFile.seekg(static_cast<std::streamoff>(layout.stripOffsets[index]));
+            inFile.read(reinterpret_cast<char*>(tile.data()), tile.size());
+            if (!inFile.good()) {
+                return false;
+            }
+            const uint32_t x0 = tx * tileWidth;
+            const size_t used = static_cast<size_t>(std::min(tileWidth, layout.width - x0)) * bytesPerPixel;
+            for (uint32_t r = 0; r < rows; ++r) {
+                std::memcpy(pixels + static_cast<size_t>(y0 + r) * m_image->_stride +
+                            static_cast<size_t>(x0) * bytesPerPixel,
+                            tile.data() + r * tileRowBytes, used);
+            }
+        }
+    }
+    return true;
+}
+
+bool XFile::Impl::readLegacy(std::ifstream& inFile) {
+    // Text header written by SDK versions before the binary TIFF writer
     std::string line;
     while (std::getline(inFile, line)) {
         if (line == "DATA_START") {
@@ -169,20 +1011,139 @@ bool XFile::Impl::read(const std::string& file) {
     // Allocate image buffer
     if (!m_image) {
         m_image = new XImage(m_cols, m_rows, static_cast<uint8_t>(m_depth));
+        m_ownsImage = true;
     }
     
     // Read image data
     if (m_image && m_image->_data_) {
-        inFile.read(reinterpret_cast<char*>(m_image->_data_), m_image->_size);
+        uint32_t rowBytes = m_image->_width * ((m_image->_pixel_depth + 7) / 8);
+        if (m_image->_stride == rowBytes) {
+            inFile.read(reinterpret_cast<char*>(m_image->_data_), m_image->_size);
+        } else {
+            for (uint32_t row = 0; row < m_image->_height; ++row) {
+                inFile.read(reinterpret_cast<char*>(m_image->_data_) +
+                            static_cast<size_t>(row) * m_image->_stride, rowBytes);
+            }
+        }
+    }
+    return true;
+}
+
+bool XFile::Impl::map(const std::string& file) {
+    std::ifstream inFile(file, std::ios::binary);
+    if (!inFile.is_open()) {
+        std::cerr << "[XFile] Failed to open file: " << file << std::endl;
+        return false;
     }
     
+    char magic[2] = {};
+    inFile.read(magic, sizeof(magic));
+    inFile.seekg(0);
+    
+    TiffLayout layout;
+    if (magic[0] != 'I' || magic[1] != 'I' || !parseTiff(inFile, layout) ||
+        layout.compression != TIFF_COMPRESSION_NONE || layout.tileWidth ||
+        !layout.contiguous() || layout.pixelBytes() > 0xFFFFFFFFull) {
+        // Older text format, tiles, scattered or compressed strips: copy instead
+        inFile.close();
+        return read(file);
+    }
     inFile.close();
     
-    std::cout << "[XFile] Loaded from " << file << std::endl;
+    if (!mapFile(file, layout.stripOffsets[0], layout.pixelBytes())) {
+        std::cerr << "[XFile] Failed to map file: " << file << std::endl;
+        return false;
+    }
+    
+    if (!m_image) {
+        m_image = new XImage();
+        m_ownsImage = true;
+    }
+    m_image->SetData(m_mapBase + layout.stripOffsets[0], layout.width, layout.height,
+                     static_cast<uint8_t>(m_depth), false);
+    m_image->_data_offset = 0;
+    
+    std::cout << "[XFile] Mapped " << file << std::endl;
     
     return true;
 }
 
+bool XFile::Impl::mapFile(const std::string& file, uint64_t offset, uint64_t bytes) {
+    // The previous mapping is only dropped once the new one exists
+#ifdef _WIN32
+    HANDLE handle = CreateFileA(file.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                                OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (handle == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(handle, &size) ||
+        static_cast<uint64_t>(size.QuadPart) < offset + bytes) {
+        CloseHandle(handle);
+        return false;
+    }
+    // Copy-on-write: pixels can be modified in memory, never in the file
+    HANDLE mapping = CreateFileMappingA(handle, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+    CloseHandle(handle);
+    if (!mapping) {
+        return false;
+    }
+    uint8_t* base = static_cast<uint8_t*>(MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0));
+    if (!base) {
+        CloseHandle(mapping);
+        return false;
+    }
+    unmap();
+    m_mapHandle = mapping;
+    m_mapBase = base;
+    m_mapSize = static_cast<size_t>(size.QuadPart);
+#else
+    int fd = ::open(file.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<uint64_t>(st.st_size) < offset + bytes) {
+        ::close(fd);
+        return false;
+    }
+    // Copy-on-write: pixels can be modified in memory, never in the file
+    void* base = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (base == MAP_FAILED) {
+        return false;
+    }
+    unmap();
+    m_mapBase = static_cast<uint8_t*>(base);
+    m_mapSize = static_cast<size_t>(st.st_size);
+    
+    // Pixels are usually scanned top to bottom: read ahead aggressively
+    const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    const size_t first = static_cast<size_t>(offset) / page * page;
+    posix_madvise(m_mapBase + first, static_cast<size_t>(offset + bytes) - first,
+                  POSIX_MADV_SEQUENTIAL);
+    posix_madvise(m_mapBase + first, static_cast<size_t>(offset + bytes) - first,
+                  POSIX_MADV_WILLNEED);
+#endif
+    return true;
+}
+
+void XFile::Impl::unmap() {
+    if (!m_mapBase) {
+        return;
+    }
+#ifdef _WIN32
+    UnmapViewOfFile(m_mapBase);
+    CloseHandle(m_mapHandle);
+    m_mapHandle = nullptr;
+#else
+    munmap(m_mapBase, m_mapSize);
+#endif
+    m_mapBase = nullptr;
+    m_mapSize = 0;
+}
+
 bool XFile::Impl::get(XFCode code, uint32_t& data) {
     switch (code) {
         case XF_COLS: data = m_cols; return true;
@@ -287,6 +1248,42 @@ XFile::~XFile() {
     }
 }
 
+void XFile::Impl::setCompression(XFCompression mode) {
+    m_compression = mode;
+}
+
+XFile::XFCompression XFile::Impl::getCompression() const {
+    return m_compression;
+}
+
+void XFile::Impl::setReference(const XImage* reference, const std::string& file) {
+    m_reference = reference;
+    m_referenceFile = reference ? file : std::string();
+}
+
+bool XFile::Impl::setTiling(uint32_t tileSize, uint32_t levels) {
+    if (tileSize % 16 != 0) {
+        std::cerr << "[XFile] Tile size must be a multiple of 16" << std::endl;
+        return false;
+    }
+    m_tileSize = tileSize;
+    m_tileLevels = levels;
+    return true;
+}
+
+void XFile::Impl::setIndexing(bool enable) {
+    m_indexing = enable;
+}
+
+bool XFile::Impl::setContrastEnhancement(bool enable, uint32_t tiles, float clipLimit) {
+    if (!m_clahe.configure(tiles, clipLimit)) {
+        std::cerr << "[XFile] Contrast enhancement needs 1-32 tiles and a clip limit >= 1" << std::endl;
+        return false;
+    }
+    m_enhance = enable;
+    return true;
+}
+
 bool XFile::Read(const std::string& file) {
     if (!m_impl) {
         return false;
@@ -294,6 +1291,20 @@ bool XFile::Read(const std::string& file) {
     return m_impl->read(file);
 }
 
+bool XFile::Map(const std::string& file) {
+    if (!m_impl) {
+        return false;
+    }
+    return m_impl->map(file);
+}
+
+XImage* XFile::GetImage() const {
+    if (!m_impl) {
+        return nullptr;
+    }
+    return m_impl->image();
+}
+
 bool XFile::Write(const std::string& file) {
     if (!m_impl) {
         return false;
@@ -301,6 +1312,55 @@ bool XFile::Write(const std::string& file) {
     return m_impl->write(file);
 }
 
+void XFile::SetCompression(XFCompression mode) {
+    if (!m_impl) {
+        return;
+    }
+    m_impl->setCompression(mode);
+}
+
+XFile::XFCompression XFile::GetCompression() const {
+    if (!m_impl) {
+        return XF_COMPRESS_NONE;
+    }
+    return m_impl->getCompression();
+}
+
+void XFile::SetReference(const XImage* reference, const std::string& file) {
+    if (!m_impl) {
+        return;
+    }
+    m_impl->setReference(reference, file);
+}
+
+bool XFile::SetTiling(uint32_t tileSize, uint32_t levels) {
+    if (!m_impl) {
+        return false;
+    }
+    return m_impl->setTiling(tileSize, levels);
+}
+
+void XFile::SetPyramidSource(const XFrame* frame) {
+    if (!m_impl) {
+        return;
+    }
+    m_impl->setPyramidSource(frame);
+}
+
+void XFile::SetIndexing(bool enable) {
+    if (!m_impl) {
+        return;
+    }
+    m_impl->setIndexing(enable);
+}
+
+bool XFile::SetContrastEnhancement(bool enable, uint32_t tiles, float clipLimit) {
+    if (!m_impl) {
+        return false;
+    }
+    return m_impl->setContrastEnhancement(enable, tiles, clipLimit);
+}
+
 bool XFile::Get(XFCode code, uint32_t& data) {
     if (!m_impl) {
         return false;
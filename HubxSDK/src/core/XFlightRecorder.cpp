@@ -0,0 +1,579 @@
+// ============================================================================
+// XFlightRecorder.cpp - Pre-trigger raw line ring
+// ============================================================================
+
+/**
+ * @file XFlightRecorder.cpp
+ * @brief XFlightRecorder implementation - memory-mapped circular line file
+ * @version 2.1.0
+ */
+
+#include "XFlightRecorder.h"
+#include "XStreamFile.h"
+#include "iximg_sink.h"
+#include "utils/logger.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace HX {
+
+namespace {
+
+/*
+ * Ring file layout:
+ *
+ *   RingHeader        64 bytes, magic "HXFLRNG\0", padded to RING_DATA_OFFSET
+ *   slot 0            SlotHeader + lineBytes payload, padded to 8 bytes
+ *   slot 1 ...
+ *
+ * Line n (counting from 0 since Open) lives in slot n % slotCount. Its
+ * header's seq is cleared before the payload is written and set to n + 1
+ * after, so a slot with seq 0 or a seq that changed while it was read is
+ * skipped.
+ */
+
+const char RING_MAGIC[8] = { 'H', 'X', 'F', 'L', 'R', 'N', 'G', '\0' };
+const uint32_t RING_VERSION = 1;
+
+/// Slots start on a page so the header page is the only one shared
+const uint64_t RING_DATA_OFFSET = 4096;
+
+#pragma pack(push, 1)
+
+struct RingHeader {
+    char     magic[8];
+    uint32_t version;
+    uint32_t headerSize;        ///< Offset of slot 0
+    uint32_t width;
+    uint32_t pixelDepth;
+    uint32_t lineBytes;
+    uint32_t slotBytes;
+    uint32_t slotCount;
+    uint32_t lineRate;
+    uint64_t created;           ///< Wall clock at Open(), microseconds
+    uint8_t  reserved[16];
+};
+
+struct SlotHeader {
+    uint64_t seq;               ///< Line number + 1, 0 while being written
+    uint64_t timeUs;            ///< Wall clock when recorded
+    uint32_t lineId;
+    uint32_t length;            ///< Payload bytes stored
+};
+
+#pragma pack(pop)
+
+static_assert(sizeof(std::atomic<uint64_t>) == sizeof(uint64_t),
+              "slot sequence is accessed in place");
+
+uint64_t nowUs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+}
+
+inline std::atomic<uint64_t>* slotSeq(uint8_t* slot) {
+    return reinterpret_cast<std::atomic<uint64_t>*>(slot + offsetof(SlotHeader, seq));
+}
+
+inline const std::atomic<uint64_t>* slotSeq(const uint8_t* slot) {
+    return reinterpret_cast<const std::atomic<uint64_t>*>(slot + offsetof(SlotHeader, seq));
+}
+
+/**
+ * @brief Shared file mapping, writable when created, read-only when opened
+ */
+class RingMapping {
+public:
+    RingMapping()
+        : m_base(nullptr)
+        , m_size(0)
+#ifdef _WIN32
+        , m_file(INVALID_HANDLE_VALUE)
+        , m_mapping(nullptr)
+#else
+        , m_fd(-1)
+#endif
+    {
+    }
+
+    ~RingMapping() {
+        unmap();
+    }
+
+    bool create(const std::string& file, uint64_t size) {
+        unmap();
+#ifdef _WIN32
+        m_file = CreateFileA(file.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ,
+                             nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (m_file == INVALID_HANDLE_VALUE) {
+            return false;
+        }
+        m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READWRITE,
+                                       static_cast<DWORD>(size >> 32),
+                                       static_cast<DWORD>(size & 0xFFFFFFFFu), nullptr);
+        if (m_mapping) {
+            m_base = static_cast<uint8_t*>(MapViewOfFile(m_mapping, FILE_MAP_WRITE, 0, 0, 0));
+        }
+#else
+        m_fd = ::open(file.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (m_fd < 0) {
+            return false;
+        }
+        // Reserve the blocks now; a sparse file would fault on a full disk
+#ifdef __linux__
+        if (posix_fallocate(m_fd, 0, static_cast<off_t>(size)) != 0) {
+            unmap();
+            return false;
+        }
+#else
+        if (ftruncate(m_fd, static_cast<off_t>(size)) != 0) {
+            unmap();
+            return false;
+        }
+#endif
+        void* p = mmap(nullptr, static_cast<size_t>(size), PROT_READ | PROT_WRITE,
+                       MAP_SHARED, m_fd, 0);
+        m_base = (p == MAP_FAILED) ? nullptr : static_cast<uint8_t*>(p);
+#endif
+        if (!m_base) {
+            unmap();
+            return false;
+        }
+        m_size = size;
+        return true;
+    }
+
+    bool openRead(const std::string& file) {
+        unmap();
+#ifdef _WIN32
+        m_file = CreateFileA(file.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE,
+                             nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        LARGE_INTEGER length;
+        if (m_file == INVALID_HANDLE_VALUE || !GetFileSizeEx(m_file, &length) ||
+            length.QuadPart <= 0) {
+            unmap();
+            return false;
+        }
+        m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (m_mapping) {
+            m_base = static_cast<uint8_t*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+        }
+        m_size = static_cast<uint64_t>(length.QuadPart);
+#else
+        m_fd = ::open(file.c_str(), O_RDONLY);
+        struct stat st;
+        if (m_fd < 0 || fstat(m_fd, &st) != 0 || st.st_size <= 0) {
+            unmap();
+            return false;
+        }
+        void* p = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, m_fd, 0);
+        m_base = (p == MAP_FAILED) ? nullptr : static_cast<uint8_t*>(p);
+        m_size = static_cast<uint64_t>(st.st_size);
+#endif
+        if (!m_base) {
+            unmap();
+            return false;
+        }
+        return true;
+    }
+
+    /// Schedule dirty pages for writing; wait = also wait for the disk
+    void flush(bool wait) {
+        if (!m_base) {
+            return;
+        }
+#ifdef _WIN32
+        FlushViewOfFile(m_base, 0);
+        if (wait) {
+            FlushFileBuffers(m_file);
+        }
+#else
+        msync(m_base, static_cast<size_t>(m_size), wait ? MS_SYNC : MS_ASYNC);
+#endif
+    }
+
+    void unmap() {
+#ifdef _WIN32
+        if (m_base) {
+            UnmapViewOfFile(m_base);
+        }
+        if (m_mapping) {
+            CloseHandle(m_mapping);
+            m_mapping = nullptr;
+        }
+        if (m_file != INVALID_HANDLE_VALUE) {
+            CloseHandle(m_file);
+            m_file = INVALID_HANDLE_VALUE;
+        }
+#else
+        if (m_base) {
+            munmap(m_base, static_cast<size_t>(m_size));
+        }
+        if (m_fd >= 0) {
+            ::close(m_fd);
+            m_fd = -1;
+        }
+#endif
+        m_base = nullptr;
+        m_size = 0;
+    }
+
+    uint8_t* data() const { return m_base; }
+    uint64_t size() const { return m_size; }
+
+private:
+    uint8_t* m_base;
+    uint64_t m_size;
+#ifdef _WIN32
+    HANDLE m_file;
+    HANDLE m_mapping;
+#else
+    int m_fd;
+#endif
+};
+
+/**
+ * @brief Validate a mapped ring and return its header
+ */
+bool readHeader(const uint8_t* base, uint64_t size, RingHeader& header) {
+    if (size < RING_DATA_OFFSET) {
+        return false;
+    }
+    std::memcpy(&header, base, sizeof(header));
+    return std::memcmp(header.magic, RING_MAGIC, sizeof(header.magic)) == 0 &&
+           header.version >= 1 && header.version <= RING_VERSION &&
+           header.headerSize >= sizeof(RingHeader) && header.slotCount > 0 &&
+           header.width > 0 && header.lineBytes > 0 &&
+           header.slotBytes >= sizeof(SlotHeader) + header.lineBytes &&
+           header.headerSize + static_cast<uint64_t>(header.slotCount) * header.slotBytes <= size;
+}
+
+/**
+ * @brief Copy the valid slots of a ring to a stream file, oldest first
+ */
+bool writeWindow(const uint8_t* base, uint64_t size, const std::string& file, uint64_t& lines) {
+    lines = 0;
+    RingHeader header;
+    if (!readHeader(base, size, header)) {
+        return false;
+    }
+    const uint8_t* slots = base + header.headerSize;
+
+    // Order by sequence; a slot holds only the latest line written to it
+    std::vector<std::pair<uint64_t, uint32_t> > order;
+    order.reserve(header.slotCount);
+    for (uint32_t i = 0; i < header.slotCount; ++i) {
+        const uint64_t seq = slotSeq(slots + static_cast<size_t>(i) * header.slotBytes)
+                                 ->load(std::memory_order_relaxed);
+        if (seq != 0) {
+            order.push_back(std::make_pair(seq, i));
+        }
+    }
+    std::sort(order.begin(), order.end());
+
+    XStreamFile stream;
+    if (!stream.Create(file, header.width, static_cast<uint8_t>(header.pixelDepth))) {
+        return false;
+    }
+    std::vector<uint8_t> line(header.lineBytes);
+    for (size_t k = 0; k < order.size(); ++k) {
+        const uint8_t* slot = slots + static_cast<size_t>(order[k].second) * header.slotBytes;
+        const uint64_t seq = slotSeq(slot)->load(std::memory_order_acquire);
+        SlotHeader h;
+        std::memcpy(&h, slot, sizeof(h));
+        const uint32_t length = std::min(h.length, header.lineBytes);
+        std::memcpy(line.data(), slot + sizeof(SlotHeader), length);
+        std::memset(line.data() + length, 0, header.lineBytes - length);
+        std::atomic_thread_fence(std::memory_order_acquire);
+
+        // Overwritten since the scan, or torn: the writer moved on
+        if (seq != order[k].first || slotSeq(slot)->load(std::memory_order_relaxed) != seq) {
+            continue;
+        }
+        if (!stream.AppendLines(line.data(), 1, 0, h.lineId, h.timeUs)) {
+            return false;
+        }
+        ++lines;
+    }
+    return stream.Close();
+}
+
+} // namespace
+
+class XFlightRecorder::Impl {
+public:
+    Impl();
+    ~Impl();
+
+    void setSink(IXImgSink* sink) { m_sink = sink; }
+    bool open(const std::string& file, uint32_t width, uint8_t pixelDepth,
+              uint32_t lineRate, uint32_t seconds);
+    void close();
+    bool isOpen() const { return m_slots != nullptr; }
+    void setSyncInterval(uint32_t ms);
+    void addLine(const uint8_t* data, uint32_t length, uint32_t lineId);
+    uint32_t getCapacity() const { return m_slotCount; }
+    uint64_t getLineCount() const { return m_claimed.load(std::memory_order_relaxed); }
+    bool trigger(const std::string& file);
+
+private:
+    void syncThread();
+    void reportError(uint32_t errorId, const std::string& message);
+
+    IXImgSink* m_sink;
+    RingMapping m_mapping;
+    std::string m_fileName;
+
+    // Fixed while open, read by AddLine() without locking
+    uint8_t* m_slots;
+    uint32_t m_slotCount;
+    uint32_t m_slotBytes;
+    uint32_t m_lineBytes;
+    std::atomic<uint64_t> m_claimed;
+
+    // Periodic flush
+    std::thread m_syncThread;
+    std::mutex m_syncMutex;
+    std::condition_variable m_syncCv;
+    uint32_t m_syncMs;
+    bool m_syncStop;
+};
+
+XFlightRecorder::Impl::Impl()
+    : m_sink(nullptr)
+    , m_slots(nullptr)
+    , m_slotCount(0)
+    , m_slotBytes(0)
+    , m_lineBytes(0)
+    , m_claimed(0)
+    , m_syncMs(1000)
+    , m_syncStop(false)
+{
+}
+
+XFlightRecorder::Impl::~Impl() {
+    close();
+}
+
+bool XFlightRecorder::Impl::open(const std::string& file, uint32_t width, uint8_t pixelDepth,
+                                 uint32_t lineRate, uint32_t seconds) {
+    close();
+
+    const uint64_t slots = static_cast<uint64_t>(lineRate) * seconds;
+    if (width == 0 || pixelDepth == 0 || pixelDepth > 32 || slots == 0 || slots > 0xFFFFFFFFu) {
+        reportError(44, "Invalid flight recorder geometry");
+        return false;
+    }
+    const uint32_t lineBytes = width * ((pixelDepth + 7) / 8);
+    const uint32_t slotBytes = static_cast<uint32_t>((sizeof(SlotHeader) + lineBytes + 7) & ~7u);
+    const uint64_t size = RING_DATA_OFFSET + slots * slotBytes;
+
+    if (!m_mapping.create(file, size)) {
+        reportError(44, "Cannot create ring file " + file);
+        return false;
+    }
+
+    RingHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, RING_MAGIC, sizeof(header.magic));
+    header.version = RING_VERSION;
+    header.headerSize = static_cast<uint32_t>(RING_DATA_OFFSET);
+    header.width = width;
+    header.pixelDepth = pixelDepth;
+    header.lineBytes = lineBytes;
+    header.slotBytes = slotBytes;
+    header.slotCount = static_cast<uint32_t>(slots);
+    header.lineRate = lineRate;
+    header.created = nowUs();
+    std::memcpy(m_mapping.data(), &header, sizeof(header));
+    m_mapping.flush(false);
+
+    m_fileName = file;
+    m_slots = m_mapping.data() + RING_DATA_OFFSET;
+    m_slotCount = header.slotCount;
+    m_slotBytes = slotBytes;
+    m_lineBytes = lineBytes;
+    m_claimed = 0;
+
+    m_syncStop = false;
+    m_syncThread = std::thread(&Impl::syncThread, this);
+
+    HX_LOG_INFO("XFlightRecorder") << m_slotCount << " lines (" << (size >> 20)
+                                   << " MB) in " << file;
+    return true;
+}
+
+void XFlightRecorder::Impl::close() {
+    if (m_syncThread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(m_syncMutex);
+            m_syncStop = true;
+        }
+        m_syncCv.notify_all();
+        m_syncThread.join();
+    }
+    if (m_slots) {
+        m_mapping.flush(true);
+    }
+    m_mapping.unmap();
+    m_slots = nullptr;
+    m_slotCount = 0;
+}
+
+void XFlightRecorder::Impl::setSyncInterval(uint32_t ms) {
+    {
+        std::lock_guard<std::mutex> lock(m_syncMutex);
+        m_syncMs = ms;
+    }
+    m_syncCv.notify_all();
+}
+
+void XFlightRecorder::Impl::syncThread() {
+    std::unique_lock<std::mutex> lock(m_syncMutex);
+    while (!m_syncStop) {
+        if (m_syncMs == 0) {
+            m_syncCv.wait(lock);
+            continue;
+        }
+        if (!m_syncCv.wait_for(lock, std::chrono::milliseconds(m_syncMs),
+                               [this] { return m_syncStop; })) {
+            // Non-blocking: queues the dirty pages, the writers never wait
+            m_mapping.flush(false);
+        }
+    }
+}
+
+void XFlightRecorder::Impl::addLine(const uint8_t* data, uint32_t length, uint32_t lineId) {
+    if (!m_slots || !data) {
+        return;
+    }
+    const uint64_t n = m_claimed.fetch_add(1, std::memory_order_relaxed);
+    uint8_t* slot = m_slots + static_cast<size_t>(n % m_slotCount) * m_slotBytes;
+
+    slotSeq(slot)->store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    const uint32_t bytes = std::min(length, m_lineBytes);
+    SlotHeader* h = reinterpret_cast<SlotHeader*>(slot);
+    h->timeUs = nowUs();
+    h->lineId = lineId;
+    h->length = bytes;
+    std::memcpy(slot + sizeof(SlotHeader), data, bytes);
+
+    slotSeq(slot)->store(n + 1, std::memory_order_release);
+}
+
+bool XFlightRecorder::Impl::trigger(const std::string& file) {
+    if (!m_slots) {
+        reportError(45, "Flight recorder is not open");
+        return false;
+    }
+    uint64_t lines = 0;
+    if (!writeWindow(m_mapping.data(), m_mapping.size(), file, lines)) {
+        reportError(45, "Cannot write snapshot " + file);
+        return false;
+    }
+    HX_LOG_INFO("XFlightRecorder") << lines << " lines saved to " << file;
+    return true;
+}
+
+void XFlightRecorder::Impl::reportError(uint32_t errorId, const std::string& message) {
+    HX_LOG_ID(::HX::XFactory::LOG_ERROR, "XFlightRecorder", errorId) << "ERROR " << errorId << ": " << message;
+
+    if (m_sink) {
+        m_sink->OnXError(errorId, message.c_str());
+    }
+}
+
+// ============================================================================
+// Public interface
+// ============================================================================
+
+XFlightRecorder::XFlightRecorder()
+    : m_impl(new Impl())
+{
+}
+
+XFlightRecorder::~XFlightRecorder() {
+    delete m_impl;
+}
+
+void XFlightRecorder::SetSink(IXImgSink* sink_) {
+    if (!m_impl) return;
+    m_impl->setSink(sink_);
+}
+
+bool XFlightRecorder::Open(const std::string& file, uint32_t width, uint8_t pixelDepth,
+                           uint32_t lineRate, uint32_t seconds) {
+    if (!m_impl) return false;
+    return m_impl->open(file, width, pixelDepth, lineRate, seconds);
+}
+
+void XFlightRecorder::Close() {
+    if (!m_impl) return;
+    m_impl->close();
+}
+
+bool XFlightRecorder::IsOpen() const {
+    if (!m_impl) return false;
+    return m_impl->isOpen();
+}
+
+void XFlightRecorder::SetSyncInterval(uint32_t ms) {
+    if (!m_impl) return;
+    m_impl->setSyncInterval(ms);
+}
+
+void XFlightRecorder::AddLine(const uint8_t* data, uint32_t length, uint32_t lineId) {
+    if (!m_impl) return;
+    m_impl->addLine(data, length, lineId);
+}
+
+uint32_t XFlightRecorder::GetCapacity() const {
+    if (!m_impl) return 0;
+    return m_impl->getCapacity();
+}
+
+uint64_t XFlightRecorder::GetLineCount() const {
+    if (!m_impl) return 0;
+    return m_impl->getLineCount();
+}
+
+bool XFlightRecorder::Trigger(const std::string& file) {
+    if (!m_impl) return false;
+    return m_impl->trigger(file);
+}
+
+bool XFlightRecorder::Recover(const std::string& ringFile, const std::string& file) {
+    RingMapping mapping;
+    if (!mapping.openRead(ringFile)) {
+        HX_LOG_WARNING("XFlightRecorder") << "Cannot open ring file " << ringFile;
+        return false;
+    }
+    uint64_t lines = 0;
+    if (!writeWindow(mapping.data(), mapping.size(), file, lines)) {
+        HX_LOG_WARNING("XFlightRecorder") << "Cannot recover " << ringFile;
+        return false;
+    }
+    HX_LOG_INFO("XFlightRecorder") << lines << " lines recovered to " << file;
+    return true;
+}
+
+} // namespace HX
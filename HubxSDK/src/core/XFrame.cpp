@@ -9,15 +9,70 @@
  */
 
 #include "XFrame.h"
+#include "XFrameBus.h"
 #include "XImage.h"
 #include "iximg_sink.h"
-#include <iostream>
+#include "ixline_filter.h"
+#include "utils/pixel_unpack.h"
+#include "utils/line_binning.h"
+#include "utils/line_resampler.h"
+#include "utils/row_aligner.h"
+#include "utils/temporal_filter.h"
+#include "utils/frame_pyramid.h"
+#include "utils/burst_packer.h"
+#include "utils/latency_trace.h"
+#include "utils/frame_listener.h"
+#include "utils/metrics.h"
+#include "utils/mem_budget.h"
+#include "utils/perf_counters.h"
+#include "utils/overload.h"
+#include "utils/logger.h"
+#include "utils/notifier.h"
+#include <cmath>
 #include <cstring>
+#include <sstream>
 #include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <deque>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <atomic>
+#include <new>
 
 namespace HX {
 
-class XFrame::Impl {
+/**
+ * @brief Takes the frame mutex on the line path only when it is shared
+ *
+ * With a single producer the acquisition thread owns the frame while it
+ * runs, so steady-state lines need no lock.
+ */
+class LineLock {
+public:
+    LineLock(std::mutex& mutex, bool enabled)
+        : m_mutex(enabled ? &mutex : nullptr)
+    {
+        if (m_mutex) {
+            m_mutex->lock();
+        }
+    }
+    
+    ~LineLock() {
+        if (m_mutex) {
+            m_mutex->unlock();
+        }
+    }
+    
+private:
+    std::mutex* m_mutex;
+    
+    LineLock(const LineLock&) = delete;
+    LineLock& operator=(const LineLock&) = delete;
+};
+
+class XFrame::Impl : public Internal::MetricsCollector {
 public:
     Impl(uint32_t lines);
     ~Impl();
@@ -25,44 +80,616 @@ public:
     void setLines(uint32_t lines);
     uint32_t getLines() const { return m_linesPerFrame; }
     
-    void setSink(IXImgSink* sink) { m_sink = sink; }
+    void setSink(IXImgSink* sink) {
+        m_sink = sink;
+        m_notify.setSink(sink);
+    }
+    bool setRawSink(IXImgSink* sink);
+    void setFrameListener(Internal::FrameListener* listener, uint32_t frameLimit);
     
     bool start(uint32_t width, uint8_t pixelDepth);
     void stop();
+    bool prepare(uint32_t width, uint8_t pixelDepth);
+    bool startLocked(uint32_t width, uint8_t pixelDepth);
+    void stopLocked();
+    bool reusePool(uint32_t width, uint32_t height, uint8_t pixelDepth);
     bool isRunning() const { return m_running; }
     
-    void addLine(const uint8_t* lineData, uint32_t lineLen, uint32_t lineId);
+    void addLine(const uint8_t* lineData, uint32_t lineLen, uint32_t lineId, const uint32_t* timestampUs,
+                 const XFrame::LineTime* time);
+    uint8_t* getLineBuffer(uint32_t lineId, uint32_t& lineLen);
+    void commitLine(uint8_t* buffer, uint32_t lineLen, uint32_t lineId, const uint32_t* timestampUs,
+                    const XFrame::LineTime* time);
+    
+    bool setPoolSize(uint32_t count);
+    uint32_t getPoolSize() const { return m_poolSize; }
+    uint32_t getFreeBuffers() const;
+    void collectMetrics(Internal::MetricsWriter& out) override;
+    void release(XImage* image);
+    
+    bool addSink(IXImgSink* sink, uint32_t queueFrames, XFrame::SinkPolicy policy);
+    bool removeSink(IXImgSink* sink);
+    uint64_t getSinkDropped(IXImgSink* sink) const;
+    bool setSinkWatchdog(float fraction, uint32_t framePeriodUs);
+    bool getSinkLatency(IXImgSink* sink, XFrame::SinkLatency& latency) const;
+    
+    bool setBurst(uint32_t frames);
+    uint32_t getBurst() const { return m_burstFrames; }
+    uint32_t getBurstFrames() const { return burstPacked() ? m_packer.frames() : m_burstCount.load(); }
+    XImage* getBurstFrame(uint32_t index) const;
+    void releaseBurst();
+    bool setBurstCompression(uint64_t arenaBytes, uint32_t workers);
+    bool getBurstStats(XFrame::BurstStats& stats) const;
+    
+    bool setReorderWindow(uint32_t lines);
+    uint32_t getReorderWindow() const { return m_reorderWindow; }
+    void setFrameTimeout(uint32_t ms) { m_frameTimeout = ms; }
+    uint32_t getFrameTimeout() const { return m_frameTimeout; }
+    void poll();
+    uint32_t getMissingLines(const XImage* image, uint8_t* mask, uint32_t maskBytes) const;
+    uint32_t getLineTimes(const XImage* image, XFrame::LineTime* times, uint32_t count) const;
+    bool getFrameTime(const XImage* image, XFrame::LineTime& time) const;
+    bool setPyramid(uint32_t levels);
+    uint32_t getPyramid() const { return m_pyramidLevels; }
+    const XImage* getPyramidImage(const XImage* image, uint32_t level, XFrame::PyramidStat stat) const;
+    
+    bool setSegments(uint32_t count);
+    uint32_t getSegments() const { return m_segments; }
+    void addSegment(const uint8_t* data, uint32_t len, uint32_t lineId, uint32_t segment,
+                    const XFrame::LineTime* time);
+    
+    bool setDualEnergy(bool enable);
+    bool getDualEnergy() const { return m_dualEnergy; }
+    void addEnergyLine(const uint8_t* data, uint32_t len, uint32_t lineId, uint8_t energyFlag,
+                       const XFrame::LineTime* time);
+    bool getEnergyPlanes(const XImage* image, const unsigned short** high,
+                         const unsigned short** low) const;
+    bool setEnergyAlignment(double lowOffset);
+    double getEnergyAlignment() const;
+    
+    bool setStripLines(uint32_t lines);
+    uint32_t getStripLines() const { return m_stripLines; }
+    
+    bool setStride(uint32_t lines);
+    uint32_t getStride() const { return m_stride; }
+    
+    bool setAllocator(XFactory* factory, const XFactory::AllocOptions& options);
+    bool setFrameBus(XFrameBus* bus);
+    
+    bool addLineFilter(IXLineFilter* filter);
+    bool clearLineFilters();
+    
+    bool setUnpack(XFrame::UnpackMode mode);
+    XFrame::UnpackMode getUnpack() const { return m_unpack; }
+    
+    bool setROI(uint32_t firstColumn, uint32_t columns, uint32_t decimation);
+    void getROI(uint32_t* firstColumn, uint32_t* columns, uint32_t* decimation) const;
+    
+    bool setBinning(uint32_t columns, uint32_t lines, XFrame::BinMode mode);
+    void getBinning(uint32_t* columns, uint32_t* lines, XFrame::BinMode* mode) const;
+    
+    bool setScanResample(double pitch, double encoderRate);
+    double getScanResample() const;
+    void setEncoderRate(double rate) { m_encoderRate.store(rate, std::memory_order_relaxed); }
+    double getEncoderRate() const { return m_encoderRate.load(std::memory_order_relaxed); }
+    
+    bool setTemporalAverage(XFrame::TemporalMode mode, uint32_t frames, bool everyFrame);
+    void getTemporalAverage(XFrame::TemporalMode* mode, uint32_t* frames, bool* everyFrame) const;
+    void resetTemporalAverage() { m_temporalReset = true; }
+    
+    bool setEmptyDetect(uint32_t threshold, uint32_t minPixels, uint32_t step, bool skip);
+    void getEmptyDetect(uint32_t* threshold, uint32_t* minPixels, uint32_t* step, bool* skip) const;
+    bool isEmpty(const XImage* image) const;
+    
+    bool setObjectFraming(uint32_t threshold, uint32_t minPixels, uint32_t preLines, uint32_t postLines);
+    void getObjectFraming(uint32_t* threshold, uint32_t* minPixels,
+                          uint32_t* preLines, uint32_t* postLines) const;
+    bool setFrameTrigger(bool enable);
+    bool getFrameTrigger() const { return m_frameTrigger; }
+    void trigger(uint32_t lineId);
+    uint64_t getUntriggeredLines() const { return m_linesUntriggered; }
+    void setDetectorId(uint32_t id) { m_detectorId = id; }
+    uint32_t getDetectorId() const { return m_detectorId; }
+    
+    bool setProducerThreads(uint32_t count);
+    uint32_t getProducerThreads() const { return m_producerThreads; }
+    
+    void setClearPolicy(XFrame::ClearPolicy policy) { m_clearPolicy = policy; }
+    XFrame::ClearPolicy getClearPolicy() const { return m_clearPolicy; }
     
 private:
+    void placeLine(const uint8_t* data, uint32_t lineId, uint32_t offset, uint32_t len, uint64_t segMask);
+    const uint8_t* unpackLine(const uint8_t* wire);
+    const uint8_t* cropLine(const uint8_t* line);
+    void reshapeLine(const uint8_t* line, uint32_t lineId, const uint32_t* timestampUs);
+    void resampleLine(const uint8_t* line, const uint32_t* timestampUs);
+    void alignEnergyLine(const uint8_t* data, uint32_t lineId);
+    void binLine(const uint8_t* line, uint32_t lineId);
+    void flushBin();
+    void filterLine(const uint8_t* src, uint8_t* dst, uint32_t row);
+    void writeRow(uint32_t row, const uint8_t* data, uint32_t offset, uint32_t len, uint64_t segMask,
+                  const XFrame::LineTime& time);
+    uint8_t* rowAddress(uint8_t* base, uint32_t row, uint32_t offset) const;
+    void resetRowState();
+    void drainStash();
+    void emitStrips(bool flush);
+    void advancePyramid();
+    void placeWindowLine(const uint8_t* data, uint32_t lineId);
+    void placeObjectLine(const uint8_t* data);
+    bool isObjectLine(const uint8_t* line) const;
+    void openObject();
+    void emitObject(bool continues);
+    void emitWindow();
+    void compactWindow();
+    void resyncWindow(uint32_t line);
+    void fillMissingRows(uint8_t* data);
+    void recycle(XImage* image);
     void assembleFrame();
+    void traceRow();
+    void deliverFrame(XImage* image);
+    void shareFrame(XImage* image);
+    void frameDone();
+    bool sequenceDone() const { return m_frameLimit > 0 && m_sequenceFrames >= m_frameLimit; }
+    bool allocateBurst(uint32_t width, uint8_t pixelDepth);
+    void storeBurstFrame(uint64_t sequence, uint32_t missing);
+    bool burstFull() const {
+        return m_burstFrames > 0 && (m_burstCount >= m_burstFrames || m_packer.full());
+    }
+    bool burstPacked() const { return m_burstFrames > 0 && m_burstArenaBytes > 0; }
+    void reportArenaFull();
+    bool inTriggeredFrame(uint32_t lineId) const {
+        return !m_frameTrigger || (m_triggerArmed && lineId - m_lineOrigin < m_linesPerFrame);
+    }
+    bool untriggered(uint32_t lineId) {
+        if (inTriggeredFrame(lineId)) {
+            return false;
+        }
+        m_linesUntriggered++;
+        return true;
+    }
+    bool averageFrame(XImage* image);
+    bool tagEmpty(const XImage* image);
+    void stampInfo(XImage* image, uint64_t sequence, uint32_t missing, uint32_t firstLineId,
+                   const std::vector<XFrame::LineTime>& times, bool empty);
+    void freePool();
+    bool releaseHeld(XImage* image);
+    int poolIndex(const XImage* image) const;
     void reportError(uint32_t errorId, const char* message);
     void reportEvent(uint32_t eventId, uint32_t data);
+    bool shedFrame();
     
     uint32_t m_linesPerFrame;
     uint32_t m_imageWidth;
     uint8_t m_pixelDepth;
+    uint32_t m_lineBytes;
     
     XImage* m_currentFrame;
-    uint32_t m_currentLine;
-    bool m_running;
+    uint32_t m_currentLine;     ///< Rows received in the current frame
+    std::atomic<bool> m_running;
+    
+    // More than one line producer: the line path serializes on m_mutex
+    uint32_t m_producerThreads;
+    bool m_sharedLines;
     
     IXImgSink* m_sink;
+    Internal::NotifySource m_notify;        ///< Delivers OnXError/OnXEvent off the line path
+    
+    /// One AddSink() consumer: frames wait here for its delivery thread
+    /// OnFrameReady timing of one sink; written by the thread calling it
+    struct SinkTiming {
+        Internal::LatencyHistogram histogram;
+        std::atomic<uint64_t> slow;
+        uint64_t warnedNs;                  ///< Last event 123, 0 = none yet
+        
+        SinkTiming() : slow(0), warnedNs(0) {}
+        void reset() {
+            histogram.reset();
+            slow = 0;
+            warnedNs = 0;
+        }
+    };
+    SinkTiming m_sinkTiming;                ///< SetSink() sink
+    
+    // SetRawSink(): lines are also kept as they arrived, in a second pool buffer
+    IXImgSink* m_rawSink;
+    XImage* m_currentRaw;                   ///< Raw twin of m_currentFrame
+    SinkTiming m_rawTiming;
+    uint64_t m_rawDropped;                  ///< Raw frames without a free buffer, for event 124
+    void callSink(IXImgSink* sink, SinkTiming& timing, XImage* image);
+    
+    // Watchdog: limit = fraction of the frame period, given or measured
+    float m_watchdogFraction;
+    uint32_t m_watchdogPeriodUs;
+    std::atomic<uint64_t> m_watchdogLimitNs;    ///< 0 = off
+    std::atomic<uint64_t> m_framePeriodNs;
+    uint64_t m_periodStampNs;                   ///< Previous frame's time
+    uint64_t m_periodSequence;
+    bool m_periodDevice;                        ///< ... from detector time
+    void measurePeriod(const XImage* image);
+    void updateWatchdog();
+    void sinkMetrics(Internal::MetricsWriter& out, const SinkTiming& timing, const std::string& sink);
+    
+    struct AddedSink {
+        IXImgSink* sink;
+        uint32_t depth;
+        XFrame::SinkPolicy policy;
+        std::deque<XImage*> queue;
+        std::mutex mutex;
+        std::condition_variable workCv;     ///< Queue gained a frame or stopping
+        std::condition_variable spaceCv;    ///< Queue lost a frame or stopping
+        bool stopping;
+        std::atomic<uint64_t> dropped;
+        SinkTiming timing;
+        std::thread thread;
+    };
+    std::vector<AddedSink*> m_addedSinks;   ///< Changed only while stopped
+    std::atomic<uint64_t> m_sinkDrops;      ///< Over all added sinks, for event 121
+    bool hasSink() const { return m_sink || !m_addedSinks.empty(); }
+    AddedSink* findSink(IXImgSink* sink) const;
+    void startSinks();
+    void stopSinks();
+    void sinkThread(AddedSink* added);
+    void queueFrame(AddedSink& added, XImage* image);
     mutable std::mutex m_mutex;
+    
+    // Grab(frames) sequence: lines after the last frame are dropped
+    Internal::FrameListener* m_frameListener;
+    uint32_t m_frameLimit;                  ///< 0 = no limit
+    uint32_t m_sequenceFrames;              ///< Finished since start()
+    
+    // Frame buffer pool (size 1 = single buffer reused after OnFrameReady)
+    uint32_t m_poolSize;
+    bool m_poolSizeSet;                     ///< SetPoolSize() called
+    std::vector<XImage*> m_pool;
+    std::vector<XImage*> m_freeList;
+    bool m_prepared;                        ///< Prepare(): keep the pool across stop()
+    // Counters are atomic, metrics scrapes read them from another thread
+    std::atomic<uint32_t> m_framesDropped;
+    std::atomic<uint64_t> m_framesDelivered;
+    std::atomic<uint64_t> m_framesShed;     ///< Dropped by the overload policy
+    mutable std::mutex m_poolMutex;
+    Internal::OverloadSource m_overload;    ///< Buffers held by the sink
+    
+    // Pool pixels from XFactory::AllocateEx instead of the heap (optional)
+    XFactory* m_factory;
+    XFactory::AllocOptions m_allocOptions;
+    std::vector<uint8_t*> m_poolData;
+    
+    // Pool buffers are the slots of a shared-memory bus (optional)
+    XFrameBus* m_bus;
+    
+    // Burst: the pool is one block of m_burstFrames frames, filled in order
+    uint32_t m_burstFrames;
+    std::atomic<uint32_t> m_burstCount;     ///< Frames complete, readable
+    std::vector<uint8_t> m_burstData;       ///< The block without an allocator
+    
+    // Compressed burst: the pool is a few staging frames, m_packer keeps
+    // the frames packed in the arena
+    uint64_t m_burstArenaBytes;             ///< 0 = burst frames stay raw
+    uint32_t m_burstWorkers;
+    uint8_t* m_burstArena;                  ///< In m_poolData, or m_burstArenaData without an allocator
+    std::vector<uint8_t> m_burstArenaData;
+    std::vector<XFrameInfo> m_burstInfo;    ///< Per burst frame, stamped at assembly
+    Internal::BurstPacker m_packer;
+    mutable XImage m_burstView;             ///< GetBurstFrame() unpacks here
+    mutable std::vector<uint8_t> m_burstViewData;
+    mutable int m_burstViewIndex;           ///< Frame in m_burstView, -1 = none
+    bool m_arenaFullReported;               ///< Event 120 raised for a full arena
+    
+    // Line placement by lineId: row = (lineId - origin) mod linesPerFrame
+    bool m_frameOpen;
+    uint32_t m_lineOrigin;
+    uint64_t m_frameSequence;               ///< Frames finished since start(), for XFrameInfo
+    uint32_t m_detectorId;
+    uint32_t m_frameIndex;
+    std::vector<uint64_t> m_rowMask;                 ///< Rows received, current frame
+    std::vector<std::vector<uint64_t> > m_poolMasks; ///< Rows received, per pool buffer
+    
+    // Acquisition time per row, kept with the buffer like the masks
+    XFrame::LineTime m_lineTime;                     ///< Time of the line being placed
+    std::vector<XFrame::LineTime> m_rowTimes;
+    std::vector<std::vector<XFrame::LineTime> > m_poolTimes;
+    std::atomic<uint32_t> m_linesLate;
+    std::atomic<uint32_t> m_framesIncomplete;
+    Internal::MetricLabels m_metricLabels;
+    
+    // Early lines of the next frame held back while the current one completes
+    uint32_t m_reorderWindow;
+    std::vector<uint8_t> m_stash;
+    std::vector<uint64_t> m_stashSegMask;            ///< Segments held per stashed row
+    std::vector<XFrame::LineTime> m_stashTimes;
+    uint32_t m_stashCount;
+    
+    // Lines delivered in module segments; a row is complete when all arrive
+    uint32_t m_segments;
+    uint32_t m_rowSegments;                          ///< Parts per row (2 in dual-energy mode)
+    uint32_t m_segmentBytes;
+    uint64_t m_fullSegMask;
+    std::vector<uint64_t> m_rowSegMask;              ///< Segments received per row
+    
+    // Dual-energy: a row is its high and low line, stored in separate planes
+    bool m_dualEnergy;
+    size_t m_planeBytes;                             ///< Bytes of one energy plane
+    
+    // Energy alignment: lines of the trailing plane are delayed by m_energyOffset
+    double m_energyOffset;                           ///< Low behind high in lines (0 = off)
+    uint32_t m_alignedSegment;                       ///< Plane delayed: 0 high, 1 low
+    Internal::RowAligner m_aligner;
+    std::vector<uint8_t> m_alignedLine;              ///< Interpolated row handed on
+    
+    // What to zero when a buffer is reused (missing rows only by default)
+    XFrame::ClearPolicy m_clearPolicy;
+    
+    // Partial frame emission when lines stop arriving
+    uint32_t m_frameTimeout;
+    std::chrono::steady_clock::time_point m_lastLineTime;
+    
+    // Receive stamps of the first and last row of the frame (tracing only)
+    uint64_t m_traceFirstNs;
+    uint64_t m_traceLastNs;
+    
+    // Landing row for zero-copy lines that fall outside the current frame
+    std::vector<uint8_t> m_scratchLine;
+    
+    // OnLinesReady every m_stripLines contiguous rows (0 = off)
+    uint32_t m_stripLines;
+    uint32_t m_stripNext;       ///< First row not yet reported
+    XImage m_strip;             ///< View into the current frame buffer
+    
+    // Reduced levels, built as rows arrive and kept with the buffer (0 = off)
+    uint32_t m_pyramidLevels;
+    bool m_pyramidIncremental;  ///< Rows are reduced in writeRow(), not only at delivery
+    uint32_t m_pyramidRows;     ///< Rows received in order from the top
+    Internal::FramePyramid m_pyramid;                   ///< Current frame
+    std::vector<Internal::FramePyramid> m_poolPyramids; ///< Per pool buffer, empty if off
+    
+    // Overlapping frames: frame k is lines [k*stride, k*stride + linesPerFrame)
+    uint32_t m_stride;                  ///< Lines between frame starts (0 = disjoint)
+    std::vector<uint8_t> m_window;      ///< Line buffer, frames are views into it
+    std::vector<uint8_t> m_windowRows;  ///< 1 = buffer row received
+    uint32_t m_windowCapacity;          ///< Buffer size in rows
+    uint32_t m_windowBase;              ///< Line held in buffer row 0
+    uint32_t m_windowFrame;             ///< First line of the frame being assembled
+    uint32_t m_windowCount;             ///< Rows of that frame received
+    std::vector<uint64_t> m_windowMask; ///< Rows received, last emitted view
+    std::vector<XFrame::LineTime> m_windowTimes;     ///< Per buffer row
+    std::vector<XFrame::LineTime> m_windowViewTimes; ///< Rows of the last emitted view
+    XImage m_windowView;
+    
+    // Applied in order as lines are placed; the first one does the copy
+    std::vector<IXLineFilter*> m_filters;
+    
+    // Packed wire lines are widened into m_unpacked before placement
+    XFrame::UnpackMode m_unpack;
+    uint8_t m_wireBits;                 ///< Bits per pixel on the wire
+    uint32_t m_wireLineBytes;           ///< Line length as received
+    std::vector<uint8_t> m_wireLine;    ///< Staging line for GetLineBuffer
+    bool m_reshape;                     ///< Lines go through reshapeLine()
+    std::vector<uint8_t> m_unpacked;    ///< One working line, stays in L1
+    
+    // Column ROI: frames are m_roiColumns wide, gathered from full lines
+    uint32_t m_wireWidth;               ///< Pixels per line as received
+    uint32_t m_roiFirst;
+    uint32_t m_roiColumns;              ///< 0 = whole line
+    uint32_t m_roiStep;
+    std::vector<uint8_t> m_cropped;     ///< Gathered line when m_roiStep > 1
+    
+    // Scan-axis resampling: rows every m_resamplePitch of belt travel
+    double m_resamplePitch;             ///< Encoder units per row (0 = off)
+    std::atomic<double> m_encoderRate;  ///< Encoder units per second, set from any thread
+    Internal::LineResampler m_resampler;
+    std::vector<uint8_t> m_resampled;   ///< Interpolated row handed on
+    
+    // Software binning: groups of m_binLines lines become one frame row
+    uint32_t m_binColumns;
+    uint32_t m_binLines;
+    XFrame::BinMode m_binMode;
+    bool m_binning;                     ///< Either factor above 1
+    bool m_binOpen;
+    uint32_t m_binOrigin;               ///< lineId that starts group 0
+    uint32_t m_binGroup;                ///< Group being accumulated, its row id
+    Internal::LineBinner m_binner;
+    XFrame::LineTime m_binTime;         ///< Time of the group's first line
+    std::vector<uint8_t> m_binned;      ///< Reduced row handed to placeLine
+    
+    // Temporal averaging of completed frames, in place in the pool buffer
+    XFrame::TemporalMode m_temporalMode;
+    uint32_t m_temporalFrames;
+    bool m_temporalEvery;               ///< Deliver every frame, not every K-th
+    std::atomic<bool> m_temporalReset;  ///< Set from any thread, applied on the line path
+    Internal::TemporalFilter m_temporal;
+    
+    // Empty-belt detection on a sparse grid of the delivered frame
+    uint32_t m_emptyThreshold;          ///< Content is below this value (0 = off)
+    uint32_t m_emptyMinPixels;
+    uint32_t m_emptyStep;
+    bool m_emptySkip;                   ///< Drop empty frames instead of tagging
+    std::vector<uint8_t> m_poolEmpty;   ///< Tag per pool buffer
+    std::vector<uint32_t> m_poolRefs;   ///< Sinks still holding each delivered buffer
+    
+    // Buffers a sink still held when the pool was freed; each goes on its last Release()
+    struct HeldBuffer {
+        XImage* image;
+        uint8_t* data;                  ///< From factory, or nullptr if the image owns it
+        XFactory* factory;
+        uint32_t refs;
+    };
+    std::vector<HeldBuffer> m_heldBuffers;
+    static void freeHeld(const HeldBuffer& held);
+    bool m_windowEmpty;                 ///< Tag of the last window view
+    std::atomic<uint64_t> m_framesEmpty;
+    
+    // Object framing: frames open and close on line content, not line counts
+    uint32_t m_objectThreshold;         ///< Content is below this value (0 = off)
+    uint32_t m_objectMinPixels;
+    uint32_t m_objectPre;
+    uint32_t m_objectPost;
+    bool m_objectOpen;                  ///< A frame is collecting an object
+    uint32_t m_objectQuiet;             ///< Content-free lines since the last object line
+    std::vector<uint8_t> m_objectRing;  ///< Last m_objectPre lines plus the current one
+    std::vector<XFrame::LineTime> m_objectRingTimes;
+    uint32_t m_objectRingNext;          ///< Ring slot of the next idle line
+    uint32_t m_objectRingCount;         ///< Lines held, at most m_objectPre
+    
+    // Frame trigger: a frame is the m_linesPerFrame lines from a Trigger()
+    bool m_frameTrigger;
+    bool m_triggerArmed;                ///< A triggered frame is collecting
+    std::atomic<uint64_t> m_linesUntriggered;
+    
+    // Line buffers above, for memory profiling; pool pixels charge themselves
+    Internal::MemCharge m_memory;
+    void chargeMemory();
 };
 
+// Frames a window buffer holds; the overlap is compacted once per pass
+static const uint32_t WINDOW_FRAMES = 4;
+
 XFrame::Impl::Impl(uint32_t lines)
     : m_linesPerFrame(lines)
     , m_imageWidth(0)
     , m_pixelDepth(16)
+    , m_lineBytes(0)
     , m_currentFrame(nullptr)
     , m_currentLine(0)
     , m_running(false)
+    , m_producerThreads(1)
+    , m_sharedLines(false)
     , m_sink(nullptr)
+    , m_rawSink(nullptr)
+    , m_currentRaw(nullptr)
+    , m_rawDropped(0)
+    , m_watchdogFraction(0.0f)
+    , m_watchdogPeriodUs(0)
+    , m_watchdogLimitNs(0)
+    , m_framePeriodNs(0)
+    , m_periodStampNs(0)
+    , m_periodSequence(0)
+    , m_periodDevice(false)
+    , m_sinkDrops(0)
+    , m_frameListener(nullptr)
+    , m_frameLimit(0)
+    , m_sequenceFrames(0)
+    , m_poolSize(1)
+    , m_poolSizeSet(false)
+    , m_prepared(false)
+    , m_framesDropped(0)
+    , m_framesDelivered(0)
+    , m_framesShed(0)
+    , m_factory(nullptr)
+    , m_bus(nullptr)
+    , m_burstFrames(0)
+    , m_burstCount(0)
+    , m_burstArenaBytes(0)
+    , m_burstWorkers(2)
+    , m_burstArena(nullptr)
+    , m_burstViewIndex(-1)
+    , m_arenaFullReported(false)
+    , m_frameOpen(false)
+    , m_lineOrigin(0)
+    , m_frameSequence(0)
+    , m_detectorId(0)
+    , m_frameIndex(0)
+    , m_linesLate(0)
+    , m_framesIncomplete(0)
+    , m_metricLabels("frame", std::to_string(Internal::MetricsRegistry::instance().nextInstance()))
+    , m_reorderWindow(16)
+    , m_stashCount(0)
+    , m_segments(1)
+    , m_rowSegments(1)
+    , m_segmentBytes(0)
+    , m_fullSegMask(1)
+    , m_dualEnergy(false)
+    , m_planeBytes(0)
+    , m_energyOffset(0.0)
+    , m_alignedSegment(1)
+    , m_clearPolicy(XFrame::CLEAR_MISSING)
+    , m_frameTimeout(0)
+    , m_traceFirstNs(0)
+    , m_traceLastNs(0)
+    , m_stripLines(0)
+    , m_stripNext(0)
+    , m_pyramidLevels(0)
+    , m_pyramidIncremental(false)
+    , m_pyramidRows(0)
+    , m_stride(0)
+    , m_windowCapacity(0)
+    , m_windowBase(0)
+    , m_windowFrame(0)
+    , m_windowCount(0)
+    , m_unpack(XFrame::UNPACK_NONE)
+    , m_wireBits(0)
+    , m_wireLineBytes(0)
+    , m_reshape(false)
+    , m_wireWidth(0)
+    , m_roiFirst(0)
+    , m_roiColumns(0)
+    , m_roiStep(1)
+    , m_resamplePitch(0.0)
+    , m_encoderRate(0.0)
+    , m_binColumns(1)
+    , m_binLines(1)
+    , m_binMode(XFrame::BIN_AVERAGE)
+    , m_binning(false)
+    , m_binOpen(false)
+    , m_binOrigin(0)
+    , m_binGroup(0)
+    , m_temporalMode(XFrame::TEMPORAL_OFF)
+    , m_temporalFrames(2)
+    , m_temporalEvery(false)
+    , m_temporalReset(false)
+    , m_emptyThreshold(0)
+    , m_emptyMinPixels(1)
+    , m_emptyStep(8)
+    , m_emptySkip(false)
+    , m_windowEmpty(false)
+    , m_framesEmpty(0)
+    , m_objectThreshold(0)
+    , m_objectMinPixels(1)
+    , m_objectPre(0)
+    , m_objectPost(0)
+    , m_objectOpen(false)
+    , m_objectQuiet(0)
+    , m_objectRingNext(0)
+    , m_objectRingCount(0)
+    , m_frameTrigger(false)
+    , m_triggerArmed(false)
+    , m_linesUntriggered(0)
+    , m_memory(XFactory::MEM_FRAME_POOL)
 {
 }
 
 XFrame::Impl::~Impl() {
     stop();
+    freePool();
+    // The sink outlived its frames: they go with the XFrame
+    for (size_t i = 0; i < m_heldBuffers.size(); ++i) {
+        freeHeld(m_heldBuffers[i]);
+    }
+    for (size_t i = 0; i < m_addedSinks.size(); ++i) {
+        delete m_addedSinks[i];
+    }
+}
+
+void XFrame::Impl::chargeMemory() {
+    uint64_t bytes = Internal::MemBytes(m_window) + Internal::MemBytes(m_windowRows) +
+                     Internal::MemBytes(m_stash) + Internal::MemBytes(m_scratchLine) +
+                     Internal::MemBytes(m_wireLine) + Internal::MemBytes(m_unpacked) +
+                     Internal::MemBytes(m_cropped) + Internal::MemBytes(m_resampled) + m_resampler.bytes() +
+                     Internal::MemBytes(m_alignedLine) + m_aligner.bytes() +
+                     Internal::MemBytes(m_binned) + m_binner.bytes() + m_temporal.bytes() +
+                     Internal::MemBytes(m_objectRing) +
+                     Internal::MemBytes(m_rowMask) + Internal::MemBytes(m_rowSegMask) +
+                     Internal::MemBytes(m_rowTimes) + Internal::MemBytes(m_stashTimes) +
+                     Internal::MemBytes(m_windowTimes) + Internal::MemBytes(m_windowViewTimes) +
+                     Internal::MemBytes(m_objectRingTimes);
+    for (size_t i = 0; i < m_poolMasks.size(); ++i) {
+        bytes += Internal::MemBytes(m_poolMasks[i]) + Internal::MemBytes(m_poolTimes[i]);
+    }
+    bytes += m_pyramid.bytes();
+    for (size_t i = 0; i < m_poolPyramids.size(); ++i) {
+        bytes += m_poolPyramids[i].bytes();
+    }
+    m_memory.set(bytes);
 }
 
 void XFrame::Impl::setLines(uint32_t lines) {
@@ -78,168 +705,3542 @@ void XFrame::Impl::setLines(uint32_t lines) {
 
 bool XFrame::Impl::start(uint32_t width, uint8_t pixelDepth) {
     std::lock_guard<std::mutex> lock(m_mutex);
-    
+    return startLocked(width, pixelDepth);
+}
+
+bool XFrame::Impl::startLocked(uint32_t width, uint8_t pixelDepth) {
     if (m_running) {
         return true;
     }
     
+    if (m_linesPerFrame == 0) {
+        reportError(33, "Lines per frame is zero");
+        return false;
+    }
+    
+    if (m_burstFrames > 0 && (m_stride > 0 || m_stripLines > 0 || m_objectThreshold > 0 ||
+                              m_temporalMode != XFrame::TEMPORAL_OFF || m_bus)) {
+        reportError(33, "Burst needs no stride, strips, object framing, temporal averaging or frame bus");
+        return false;
+    }
+    
+    if (m_unpack != XFrame::UNPACK_NONE) {
+        if (pixelDepth < 17 || pixelDepth > 24 || m_segments > 1) {
+            reportError(33, "Unpacking needs 17-24 bit pixels and whole lines");
+            return false;
+        }
+        m_wireBits = pixelDepth;
+        m_wireLineBytes = Internal::packedLineBytes(width, pixelDepth);
+        pixelDepth = (m_unpack == XFrame::UNPACK_32) ? 32 : 16;
+    }
+    
+    // Lines keep the detector width, frames only the ROI
+    m_wireWidth = width;
+    if (m_roiColumns > 0) {
+        if (m_segments > 1 || m_dualEnergy ||
+            m_roiFirst + static_cast<uint64_t>(m_roiColumns - 1) * m_roiStep >= width) {
+            reportError(33, "ROI must lie inside the line, with whole lines and no dual-energy");
+            return false;
+        }
+        width = m_roiColumns;
+    }
+    
+    // Resampled rows replace lines before binning sees them
+    if (m_resamplePitch > 0.0) {
+        if (m_segments > 1 || m_dualEnergy ||
+            !m_resampler.configure(width, (pixelDepth + 7) / 8, m_resamplePitch)) {
+            reportError(33, "Resampling needs 8, 16 or 32-bit whole lines and no dual-energy");
+            return false;
+        }
+        m_resampled.assign(static_cast<size_t>(width) * ((pixelDepth + 7) / 8), 0);
+    }
+    
+    if (m_binning) {
+        if (m_segments > 1 || m_dualEnergy ||
+            !m_binner.configure(width, (pixelDepth + 7) / 8, m_binColumns, m_binLines,
+                                m_binMode == XFrame::BIN_AVERAGE, pixelDepth)) {
+            reportError(33, "Binning needs 8, 16 or 32-bit whole lines and no dual-energy");
+            return false;
+        }
+        width = m_binner.outWidth();
+    }
+    
     m_imageWidth = width;
     m_pixelDepth = pixelDepth;
+    m_lineBytes = width * ((pixelDepth + 7) / 8);
+    if (m_unpack == XFrame::UNPACK_NONE) {
+        m_wireLineBytes = m_wireWidth * ((pixelDepth + 7) / 8);
+    }
+    
+    if (m_dualEnergy) {
+        if (m_segments > 1 || m_stride > 0 || m_stripLines > 0 || m_unpack != XFrame::UNPACK_NONE) {
+            reportError(33, "Dual-energy frames need whole lines, no stride, strips or unpacking");
+            return false;
+        }
+        // Internally a row is two segments: the high line, then the low line
+        m_wireLineBytes = m_lineBytes;
+        m_lineBytes *= 2;
+        m_planeBytes = static_cast<size_t>(m_wireLineBytes) * m_linesPerFrame;
+        
+        if (m_energyOffset != 0.0) {
+            // The last rows of a frame complete while the next one is stashed
+            const double offset = std::fabs(m_energyOffset);
+            const uint32_t span = static_cast<uint32_t>(std::ceil(offset)) + 1;
+            if (std::min(m_reorderWindow, m_linesPerFrame - 1) < span ||
+                !m_aligner.configure(width, (pixelDepth + 7) / 8, offset, m_reorderWindow)) {
+                reportError(33, "Energy alignment needs 8, 16 or 32-bit pixels and a reorder "
+                                "window past the offset");
+                return false;
+            }
+            m_alignedSegment = (m_energyOffset > 0.0) ? 1 : 0;
+            m_alignedLine.assign(m_wireLineBytes, 0);
+        }
+    }
+    m_rowSegments = m_dualEnergy ? 2 : m_segments;
+    
+    if (m_lineBytes % m_rowSegments != 0) {
+        reportError(33, "Line size not divisible by segment count");
+        return false;
+    }
+    m_segmentBytes = m_lineBytes / m_rowSegments;
+    m_fullSegMask = (m_rowSegments >= 64) ? ~uint64_t(0) : ((uint64_t(1) << m_rowSegments) - 1);
+    
+    if (m_bus) {
+        if (m_stride > 0 || !m_bus->GetSlotData(0) ||
+            m_bus->GetSlotBytes() < static_cast<uint64_t>(m_lineBytes) * m_linesPerFrame) {
+            reportError(33, "Frame bus must be published here, hold whole frames and no stride");
+            return false;
+        }
+        m_poolSize = m_bus->GetSlots();
+    }
+    
+    if (!m_addedSinks.empty() && !m_bus && !m_poolSizeSet && m_burstFrames == 0 && m_stride == 0) {
+        const uint32_t profilePool = XFactory::GetHostProfile().poolSize;
+        if (profilePool >= 2) {
+            m_poolSize = profilePool;
+        }
+    }
+    
+    if (!m_addedSinks.empty() && m_burstFrames == 0 && (m_poolSize <= 1 || m_stride > 0)) {
+        reportError(33, "Added sinks need a pool of two or more buffers and no stride");
+        return false;
+    }
+    
+    if (m_rawSink && (!hasSink() || m_filters.empty() || m_poolSize < 4 || m_bus || m_stride > 0 ||
+                      m_burstFrames > 0 || m_objectThreshold > 0 || m_temporalMode != XFrame::TEMPORAL_OFF)) {
+        reportError(33, "Raw sink needs a frame sink, line filters and a pool of four or more "
+                        "buffers, without bus, stride, burst, object framing or averaging");
+        return false;
+    }
+    
+    // Reshaped lines are no longer the lines as received
+    if (m_rawSink && (m_unpack != XFrame::UNPACK_NONE || m_roiColumns > 0 ||
+                      m_resamplePitch > 0.0 || m_binning)) {
+        reportError(33, "Raw sink cannot be combined with unpacking, ROI, resampling or binning");
+        return false;
+    }
+    
+    if (m_stride > 0) {
+        if (m_stride >= m_linesPerFrame || m_segments > 1) {
+            reportError(33, "Stride must be below lines per frame, with whole lines");
+            return false;
+        }
+        
+        // Room for the frame plus WINDOW_FRAMES strides of lines ahead of it
+        m_windowCapacity = m_linesPerFrame + m_stride * WINDOW_FRAMES;
+        m_window.assign(static_cast<size_t>(m_windowCapacity) * m_lineBytes, 0);
+        m_windowRows.assign(m_windowCapacity, 0);
+        m_windowMask.assign((m_linesPerFrame + 63) / 64, 0);
+        m_windowTimes.assign(m_windowCapacity, XFrame::LineTime());
+        m_windowViewTimes.assign(m_linesPerFrame, XFrame::LineTime());
+        m_windowBase = 0;
+        m_windowFrame = 0;
+        m_windowCount = 0;
+        m_windowView.SetData(m_window.data(), width, m_linesPerFrame, pixelDepth, false);
+        m_currentFrame = &m_windowView;
+    } else if (m_burstFrames > 0) {
+        if (!allocateBurst(width, pixelDepth)) {
+            reportError(33, "Failed to allocate burst buffer");
+            return false;
+        }
+    } else if (!reusePool(width, m_dualEnergy ? m_linesPerFrame * 2 : m_linesPerFrame, pixelDepth)) {
+        // Allocate all frame buffers up front; dual-energy planes are stacked
+        freePool();
+        const uint64_t levelBytes = (m_pyramidLevels > 0) ?
+            Internal::FramePyramid::bytesFor(width, m_dualEnergy ? m_linesPerFrame * 2 : m_linesPerFrame,
+                                             pixelDepth, m_pyramidLevels) : 0;
+        if (!m_bus && !Internal::MemBudgetAdmit(static_cast<uint64_t>(m_poolSize) *
+                                                (static_cast<uint64_t>(m_lineBytes) * m_linesPerFrame +
+                                                 levelBytes) + levelBytes)) {
+            reportError(33, "Frame pool does not fit the memory budget");
+            return false;
+        }
+        std::lock_guard<std::mutex> poolLock(m_poolMutex);
+        Internal::MemTagScope memTag(XFactory::MEM_FRAME_POOL);
+        const uint32_t height = m_dualEnergy ? m_linesPerFrame * 2 : m_linesPerFrame;
+        
+        for (uint32_t i = 0; i < m_poolSize; ++i) {
+            XImage* image = nullptr;
+            if (m_bus) {
+                image = new XImage();
+                image->SetData(m_bus->GetSlotData(i), width, height, pixelDepth, false);
+            } else if (m_factory) {
+                size_t bytes = static_cast<size_t>(m_lineBytes) * m_linesPerFrame;
+                uint8_t* data = static_cast<uint8_t*>(m_factory->AllocateEx(bytes, m_allocOptions));
+                image = new XImage();
+                if (data) {
+                    memset(data, 0, bytes);
+                    image->SetData(data, width, height, pixelDepth, false);
+                    m_poolData.push_back(data);
+                }
+            } else {
+                image = new XImage(width, height, pixelDepth);
+            }
+            if (!image->_data_) {
+                delete image;
+                for (size_t j = 0; j < m_pool.size(); ++j) {
+                    delete m_pool[j];
+                }
+                m_pool.clear();
+                m_freeList.clear();
+                for (size_t j = 0; j < m_poolData.size(); ++j) {
+                    m_factory->Free(m_poolData[j]);
+                }
+                m_poolData.clear();
+                reportError(33, "Failed to allocate frame buffer");
+                return false;
+            }
+            m_pool.push_back(image);
+        }
+        
+        m_freeList.assign(m_pool.begin() + 1, m_pool.end());
+        m_currentFrame = m_pool[0];
+        if (m_bus) {
+            // A previous run may have published this slot
+            m_bus->RetireSlot(0);
+        }
+    }
+    
+    if (m_rawSink) {
+        // The raw lines of the current frame go into a buffer of their own
+        std::lock_guard<std::mutex> poolLock(m_poolMutex);
+        m_currentRaw = m_freeList.back();
+        m_freeList.pop_back();
+    }
+    
+    const size_t maskWords = (m_linesPerFrame + 63) / 64;
+    // A compressed burst keeps the rows of every frame, not of each staging frame
+    const size_t buffers = burstPacked() ? m_burstFrames : (m_pool.empty() ? m_poolSize : m_pool.size());
+    m_rowMask.assign(maskWords, 0);
+    m_rowSegMask.assign(m_linesPerFrame, 0);
+    m_poolMasks.assign(buffers, std::vector<uint64_t>(maskWords, 0));
+    m_rowTimes.assign(m_linesPerFrame, XFrame::LineTime());
+    m_poolTimes.assign(buffers, std::vector<XFrame::LineTime>(m_linesPerFrame));
+    m_lineTime = XFrame::LineTime();
+    m_poolEmpty.assign(buffers, 0);
+    m_poolRefs.assign(buffers, 0);
+    m_windowEmpty = false;
+    
+    // Levels need whole frames in pool buffers
+    const bool pyramid = m_pyramidLevels > 0 && m_stride == 0 && m_burstFrames == 0;
+    std::vector<Internal::FramePyramid>(pyramid ? buffers : 0).swap(m_poolPyramids);
+    if (pyramid) {
+        const uint32_t height = m_dualEnergy ? m_linesPerFrame * 2 : m_linesPerFrame;
+        bool allocated = m_pyramid.configure(width, height, pixelDepth, m_pyramidLevels);
+        for (size_t i = 0; i < m_poolPyramids.size() && allocated; ++i) {
+            allocated = m_poolPyramids[i].configure(width, height, pixelDepth, m_pyramidLevels);
+        }
+        if (!allocated) {
+            m_poolPyramids.clear();
+            reportError(33, "Failed to allocate pyramid levels");
+            return false;
+        }
+    } else {
+        Internal::FramePyramid().swap(m_pyramid);
+    }
+    // Energy rows are placed per plane, and averaged frames are reduced after averaging
+    m_pyramidIncremental = pyramid && !m_dualEnergy && m_temporalMode == XFrame::TEMPORAL_OFF;
+    m_pyramidRows = 0;
     
-    // Allocate frame buffer
-    m_currentFrame = new XImage(width, m_linesPerFrame, pixelDepth);
-    if (!m_currentFrame || !m_currentFrame->_data_) {
-        reportError(33, "Failed to allocate frame buffer");
-        delete m_currentFrame;
-        m_currentFrame = nullptr;
+    uint32_t window = std::min(m_reorderWindow, m_linesPerFrame - 1);
+    m_stash.assign(static_cast<size_t>(window) * m_lineBytes, 0);
+    m_stashSegMask.assign(window, 0);
+    m_stashTimes.assign(window, XFrame::LineTime());
+    m_stashCount = 0;
+    m_scratchLine.assign(m_lineBytes, 0);
+    m_reshape = (m_unpack != XFrame::UNPACK_NONE || m_roiColumns > 0 ||
+                 m_resamplePitch > 0.0 || m_binning);
+    if (m_reshape) {
+        m_wireLine.assign(m_wireLineBytes, 0);
+    }
+    if (m_unpack != XFrame::UNPACK_NONE) {
+        m_unpacked.assign(static_cast<size_t>(m_wireWidth) * ((pixelDepth + 7) / 8), 0);
+    }
+    if (m_roiStep > 1) {
+        m_cropped.assign(static_cast<size_t>(m_roiColumns) * ((pixelDepth + 7) / 8), 0);
+    }
+    if (m_binning) {
+        m_binned.assign(m_lineBytes, 0);
+    }
+    m_binOpen = false;
+    m_binGroup = 0;
+    if (m_objectThreshold > 0) {
+        if (m_segments > 1 || m_dualEnergy || m_stride > 0 || m_stripLines > 0 ||
+            m_temporalMode != XFrame::TEMPORAL_OFF ||
+            m_objectPre + static_cast<uint64_t>(m_objectPost) >= m_linesPerFrame) {
+            reportError(33, "Object framing needs whole lines, no dual-energy, stride, strips "
+                            "or temporal averaging, and margins below lines per frame");
+            return false;
+        }
+        m_objectRing.assign(static_cast<size_t>(m_objectPre + 1) * m_lineBytes, 0);
+        m_objectRingTimes.assign(m_objectPre + 1, XFrame::LineTime());
+    }
+    m_objectOpen = false;
+    m_objectQuiet = 0;
+    m_objectRingNext = 0;
+    m_objectRingCount = 0;
+    if (m_frameTrigger && (m_stride > 0 || m_objectThreshold > 0 || m_binning || m_resamplePitch > 0.0)) {
+        reportError(33, "Frame trigger needs no stride, object framing, binning or resampling");
         return false;
     }
+    m_triggerArmed = false;
+    m_linesUntriggered = 0;
+    if (m_temporalMode != XFrame::TEMPORAL_OFF) {
+        if (pixelDepth <= 8 || pixelDepth > 16 || m_stride > 0) {
+            reportError(33, "Temporal averaging needs 9-16 bit pixels and no stride");
+            return false;
+        }
+        const uint32_t height = m_dualEnergy ? m_linesPerFrame * 2 : m_linesPerFrame;
+        m_temporal.configure(static_cast<size_t>(m_imageWidth) * height, m_temporalFrames,
+                             m_temporalMode == XFrame::TEMPORAL_RECURSIVE, m_temporalEvery);
+        m_temporalReset = false;
+    }
     
     m_currentLine = 0;
+    m_stripNext = 0;
+    m_framesDropped = 0;
+    m_framesDelivered = 0;
+    m_sequenceFrames = 0;
+    m_framesShed = 0;
+    m_framesEmpty = 0;
+    m_frameOpen = false;
+    m_frameIndex = 0;
+    m_frameSequence = 0;
+    m_linesLate = 0;
+    m_framesIncomplete = 0;
+    m_sinkTiming.reset();
+    m_rawTiming.reset();
+    m_rawDropped = 0;
+    m_periodStampNs = 0;
+    m_framePeriodNs = m_watchdogPeriodUs * uint64_t(1000);
+    updateWatchdog();
+    m_lastLineTime = std::chrono::steady_clock::now();
+    m_sharedLines = (m_producerThreads > 1);
     m_running = true;
+    startSinks();
+    if (burstPacked()) {
+        m_burstInfo.assign(m_burstFrames, XFrameInfo());
+        m_burstViewIndex = -1;
+        m_arenaFullReported = false;
+        m_packer.start(m_burstArena, static_cast<size_t>(m_burstArenaBytes),
+                       static_cast<uint32_t>(m_pool.size()), m_burstWorkers, m_burstFrames);
+    }
+    chargeMemory();
+    Internal::MetricsRegistry::instance().addCollector(this);
     
-    std::cout << "[XFrame] Started: " << width << "x" << m_linesPerFrame 
-              << " @ " << static_cast<int>(pixelDepth) << " bits" << std::endl;
+    std::ostringstream summary;
+    summary << "Started: " << width << "x" << m_linesPerFrame 
+            << " @ " << static_cast<int>(pixelDepth) << " bits, ";
+    if (m_roiColumns > 0) {
+        summary << "columns " << m_roiFirst << "+" << m_roiColumns;
+        if (m_roiStep > 1) {
+            summary << "/" << m_roiStep;
+        }
+        summary << " of " << m_wireWidth << ", ";
+    }
+    if (m_resamplePitch > 0.0) {
+        summary << "resampled every " << m_resamplePitch << " encoder units, ";
+    }
+    if (m_binning) {
+        summary << "binned " << m_binColumns << "x" << m_binLines
+                << (m_binMode == XFrame::BIN_AVERAGE ? " (average), " : " (sum), ");
+    }
+    if (m_objectThreshold > 0) {
+        summary << "objects below " << m_objectThreshold << " (margins " << m_objectPre
+                << "/" << m_objectPost << "), ";
+    }
+    if (m_bus) {
+        summary << "frame bus, ";
+    }
+    if (!m_addedSinks.empty()) {
+        summary << m_addedSinks.size() << " added sink(s), ";
+    }
+    if (m_stride > 0) {
+        summary << "stride " << m_stride << " (overlap "
+                << (m_linesPerFrame - m_stride) << ")";
+    } else {
+        summary << m_poolSize << " buffer(s)";
+    }
+    HX_LOG_INFO("XFrame") << summary.str();
     
     return true;
 }
 
 void XFrame::Impl::stop() {
     std::lock_guard<std::mutex> lock(m_mutex);
-    
+    stopLocked();
+}
+
+void XFrame::Impl::stopLocked() {
     if (!m_running) {
         return;
     }
     
-    if (m_currentFrame) {
-        delete m_currentFrame;
-        m_currentFrame = nullptr;
+    // Added sinks still hold queued frames; they are delivered first
+    stopSinks();
+    if (burstPacked()) {
+        // Frames still being packed are part of the burst
+        m_packer.finish();
+        Internal::BurstPacker::Stats packed;
+        m_packer.stats(packed);
+        if (packed.submitted > 0) {
+            HX_LOG_INFO("XFrame") << "Burst packed: " << packed.packed << " of " << packed.submitted
+                                  << " frame(s), " << (packed.packedBytes >> 20) << " of "
+                                  << (packed.arenaBytes >> 20) << " MB";
+        }
+    }
+    
+    // No scrape may look at the pool once it is freed; a burst stays for
+    // the application until the next Start(), a prepared pool for reuse
+    Internal::MetricsRegistry::instance().removeCollector(this);
+    if (m_burstFrames == 0 && !m_prepared) {
+        freePool();
     }
+    m_currentFrame = nullptr;
+    m_currentRaw = nullptr;
+    std::vector<uint8_t>().swap(m_window);
+    std::vector<uint8_t>().swap(m_windowRows);
+    std::vector<uint8_t>().swap(m_wireLine);
+    std::vector<uint8_t>().swap(m_unpacked);
+    std::vector<uint8_t>().swap(m_resampled);
+    std::vector<uint8_t>().swap(m_objectRing);
+    chargeMemory();
+    m_overload.clear();
     
     m_running = false;
     m_currentLine = 0;
     
-    std::cout << "[XFrame] Stopped" << std::endl;
+    std::ostringstream summary;
+    summary << "Stopped";
+    if (m_framesDropped > 0) {
+        summary << " (" << m_framesDropped << " frame(s) dropped, pool exhausted)";
+    }
+    if (m_framesShed > 0) {
+        summary << " (" << m_framesShed << " frame(s) shed under overload)";
+    }
+    if (m_sinkDrops > 0) {
+        summary << " (" << m_sinkDrops << " frame(s) dropped by added sink queues)";
+    }
+    if (m_rawDropped > 0) {
+        summary << " (" << m_rawDropped << " raw frame(s) dropped, pool exhausted)";
+    }
+    if (m_framesIncomplete > 0 || m_linesLate > 0) {
+        summary << " (" << m_framesIncomplete << " incomplete frame(s), "
+                << m_linesLate << " late line(s))";
+    }
+    HX_LOG_INFO("XFrame") << summary.str();
 }
 
-void XFrame::Impl::addLine(const uint8_t* lineData, uint32_t lineLen, uint32_t lineId) {
+bool XFrame::Impl::prepare(uint32_t width, uint8_t pixelDepth) {
     std::lock_guard<std::mutex> lock(m_mutex);
     
-    if (!m_running || !m_currentFrame) {
+    if (m_running) {
+        reportError(32, "Cannot prepare while running");
+        return false;
+    }
+    
+    const std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+    m_prepared = (m_stride == 0 && !m_bus);
+    if (!startLocked(width, pixelDepth)) {
+        return false;
+    }
+    stopLocked();
+    
+    const int64_t elapsedUs = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - begin).count();
+    HX_LOG_INFO("XFrame") << "Prepared " << m_pool.size() << " buffer(s) in " << elapsedUs << " us";
+    return true;
+}
+
+bool XFrame::Impl::reusePool(uint32_t width, uint32_t height, uint8_t pixelDepth) {
+    // A pool kept by Prepare() is faulted in already; reuse it as it is
+    if (!m_prepared || m_bus || m_pool.size() != m_poolSize || m_pool[0]->_width != width ||
+        m_pool[0]->_height != height || m_pool[0]->_pixel_depth != pixelDepth) {
+        return false;
+    }
+    std::lock_guard<std::mutex> poolLock(m_poolMutex);
+    if (std::find_if(m_poolRefs.begin(), m_poolRefs.end(),
+                     [](uint32_t refs) { return refs > 0; }) != m_poolRefs.end()) {
+        // A sink still holds a frame of the last run; it keeps it, the pool is new
+        return false;
+    }
+    m_freeList.assign(m_pool.begin() + 1, m_pool.end());
+    m_currentFrame = m_pool[0];
+    return true;
+}
+
+void XFrame::Impl::addLine(const uint8_t* lineData, uint32_t lineLen, uint32_t lineId,
+                           const uint32_t* timestampUs, const XFrame::LineTime* time) {
+    LineLock lock(m_mutex, m_sharedLines);
+    
+    if (!m_running || !m_currentFrame || untriggered(lineId)) {
         return;
     }
+    m_lineTime = time ? *time : XFrame::LineTime();
     
-    // Calculate expected line length
-    uint32_t bytesPerPixel = (m_pixelDepth + 7) / 8;
-    uint32_t expectedLen = m_imageWidth * bytesPerPixel;
+    if (lineLen != m_wireLineBytes || m_dualEnergy) {
+        reportError(101, m_dualEnergy ? "Dual-energy lines need an energy flag" : "Line length mismatch");
+        return;
+    }
     
-    if (lineLen != expectedLen) {
-        reportError(101, "Line length mismatch");
+    if (m_reshape) {
+        reshapeLine(lineData, lineId, timestampUs);
         return;
     }
+    placeLine(lineData, lineId, 0, m_lineBytes, m_fullSegMask);
+}
+
+uint8_t* XFrame::Impl::getLineBuffer(uint32_t lineId, uint32_t& lineLen) {
+    LineLock lock(m_mutex, m_sharedLines);
     
-    // Copy line data to frame buffer
-    uint32_t lineOffset = m_currentLine * m_imageWidth * bytesPerPixel;
-    if (lineOffset + lineLen <= m_currentFrame->_size) {
-        memcpy(m_currentFrame->_data_ + lineOffset, lineData, lineLen);
+    lineLen = 0;
+    if (!m_running || !m_currentFrame || m_dualEnergy) {
+        return nullptr;
     }
     
-    m_currentLine++;
+    lineLen = m_wireLineBytes;
     
-    // Check if frame is complete
-    if (m_currentLine >= m_linesPerFrame) {
-        assembleFrame();
+    // Packed, cropped, resampled or binned lines cannot land in place, they are reshaped on commit
+    if (m_reshape) {
+        return m_wireLine.data();
+    }
+    
+    // Window rows move on compaction, so overlapping frames copy from scratch;
+    // a full burst keeps its last frame as the current one
+    if (m_stride > 0 || burstFull() || !inTriggeredFrame(lineId)) {
+        return m_scratchLine.data();
+    }
+    
+    // Predicted line belongs to the current frame: receive it in place
+    if (!m_frameOpen) {
+        return m_currentFrame->_data_;
+    }
+    uint32_t rel = lineId - m_lineOrigin;
+    if (static_cast<int32_t>(rel) >= 0 && rel / m_linesPerFrame == m_frameIndex) {
+        uint32_t row = rel % m_linesPerFrame;
+        // Never let a mispredicted receive clobber a row that already arrived
+        if (!(m_rowMask[row >> 6] & (uint64_t(1) << (row & 63)))) {
+            return m_currentFrame->_data_ + static_cast<size_t>(row) * m_lineBytes;
+        }
     }
+    
+    return m_scratchLine.data();
 }
 
-void XFrame::Impl::assembleFrame() {
-    if (!m_sink || !m_currentFrame) {
+void XFrame::Impl::commitLine(uint8_t* buffer, uint32_t lineLen, uint32_t lineId,
+                              const uint32_t* timestampUs, const XFrame::LineTime* time) {
+    LineLock lock(m_mutex, m_sharedLines);
+    
+    if (!m_running || !m_currentFrame || !buffer || m_dualEnergy || untriggered(lineId)) {
         return;
     }
+    m_lineTime = time ? *time : XFrame::LineTime();
     
-    // Notify frame ready
-    m_sink->OnFrameReady(m_currentFrame);
+    if (lineLen != m_wireLineBytes) {
+        reportError(101, "Line length mismatch");
+        return;
+    }
     
-    // Reset for next frame
-    m_currentLine = 0;
-    m_currentFrame->Clear();
+    if (m_reshape) {
+        reshapeLine(buffer, lineId, timestampUs);
+        return;
+    }
+    
+    // writeRow skips the copy when the line already sits in its row
+    placeLine(buffer, lineId, 0, m_lineBytes, m_fullSegMask);
 }
 
-void XFrame::Impl::reportError(uint32_t errorId, const char* message) {
-    std::cerr << "[XFrame] ERROR " << errorId << ": " << message << std::endl;
-    
-    if (m_sink) {
-        m_sink->OnXError(errorId, message);
+void XFrame::Impl::filterLine(const uint8_t* src, uint8_t* dst, uint32_t row) {
+    m_filters[0]->OnLine(src, dst, m_imageWidth, m_pixelDepth, row);
+    for (size_t i = 1; i < m_filters.size(); ++i) {
+        m_filters[i]->OnLine(dst, dst, m_imageWidth, m_pixelDepth, row);
     }
 }
 
-void XFrame::Impl::reportEvent(uint32_t eventId, uint32_t data) {
-    if (m_sink) {
-        m_sink->OnXEvent(eventId, data);
+const uint8_t* XFrame::Impl::unpackLine(const uint8_t* wire) {
+    // Widen into one working line; placeLine then copies it like any other
+    if (m_unpack == XFrame::UNPACK_32) {
+        Internal::unpackLine(wire, m_wireLineBytes, reinterpret_cast<uint32_t*>(m_unpacked.data()),
+                             m_wireWidth, m_wireBits, 0xFFFFFFFFu);
+    } else {
+        Internal::unpackLine(wire, m_wireLineBytes, reinterpret_cast<uint16_t*>(m_unpacked.data()),
+                             m_wireWidth, m_wireBits, 0xFFFFu);
     }
+    return m_unpacked.data();
 }
 
-// XFrame public interface
-XFrame::XFrame()
-    : m_impl(new Impl(1024))
-{
+const uint8_t* XFrame::Impl::cropLine(const uint8_t* line) {
+    const uint32_t bpp = (m_pixelDepth + 7) / 8;
+    const uint8_t* src = line + static_cast<size_t>(m_roiFirst) * bpp;
+    
+    // A contiguous range is placed straight from the line, no extra copy
+    if (m_roiStep == 1) {
+        return src;
+    }
+    
+    uint8_t* dst = m_cropped.data();
+    const size_t step = static_cast<size_t>(m_roiStep) * bpp;
+    if (bpp == 2) {
+        const uint16_t* in = reinterpret_cast<const uint16_t*>(src);
+        uint16_t* out = reinterpret_cast<uint16_t*>(dst);
+        for (uint32_t x = 0; x < m_roiColumns; ++x) {
+            out[x] = in[static_cast<size_t>(x) * m_roiStep];
+        }
+    } else {
+        for (uint32_t x = 0; x < m_roiColumns; ++x) {
+            memcpy(dst + static_cast<size_t>(x) * bpp, src + x * step, bpp);
+        }
+    }
+    return dst;
 }
 
-XFrame::XFrame(uint32_t lines)
-    : m_impl(new Impl(lines))
-{
+void XFrame::Impl::reshapeLine(const uint8_t* line, uint32_t lineId, const uint32_t* timestampUs) {
+    // Unpack, crop, resample, then bin; each step reads the previous one's output
+    if (m_unpack != XFrame::UNPACK_NONE) {
+        line = unpackLine(line);
+    }
+    if (m_roiColumns > 0) {
+        line = cropLine(line);
+    }
+    if (m_resamplePitch > 0.0) {
+        resampleLine(line, timestampUs);
+        return;
+    }
+    if (m_binning) {
+        binLine(line, lineId);
+        return;
+    }
+    placeLine(line, lineId, 0, m_lineBytes, m_fullSegMask);
 }
 
-XFrame::~XFrame() {
-    if (m_impl) {
-        delete m_impl;
-        m_impl = nullptr;
+void XFrame::Impl::resampleLine(const uint8_t* line, const uint32_t* timestampUs) {
+    // Lines without a header timestamp are stamped on arrival
+    uint32_t now;
+    if (timestampUs) {
+        now = *timestampUs;
+    } else {
+        now = static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+    if (!m_resampler.add(line, now, m_encoderRate.load(std::memory_order_relaxed))) {
+        m_linesLate++;
+        return;
+    }
+    
+    // Row numbers replace lineIds from here on, as binned groups do
+    uint32_t row;
+    while (m_resampler.emit(m_resampled.data(), row)) {
+        if (m_binning) {
+            binLine(m_resampled.data(), row);
+        } else {
+            placeLine(m_resampled.data(), row, 0, m_lineBytes, m_fullSegMask);
+        }
     }
 }
 
-void XFrame::SetLines(uint32_t lines) {
-    if (m_impl) {
-        m_impl->setLines(lines);
+void XFrame::Impl::binLine(const uint8_t* line, uint32_t lineId) {
+    if (!m_binOpen) {
+        // First line of the run starts group 0
+        m_binOrigin = lineId;
+        m_binGroup = 0;
+        m_binOpen = true;
+    }
+    
+    uint32_t rel = lineId - m_binOrigin;
+    uint32_t group = rel / m_binLines;
+    if (static_cast<int32_t>(rel) < 0 || group < m_binGroup) {
+        // Its group was already reduced and placed
+        m_linesLate++;
+        return;
+    }
+    
+    if (group > m_binGroup) {
+        // Lines of the open group went missing: place what it has
+        if (m_binner.count() > 0) {
+            flushBin();
+        }
+        m_binGroup = group;
+    }
+    
+    if (m_binner.count() == 0) {
+        m_binTime = m_lineTime;
+    }
+    m_binner.add(line);
+    if (m_binner.count() == m_binLines) {
+        flushBin();
+        m_binGroup++;
     }
 }
 
-uint32_t XFrame::GetLines() const {
-    if (!m_impl) {
-        return 0;
-    }
-    return m_impl->getLines();
+void XFrame::Impl::flushBin() {
+    // Group numbers are the row ids, so placement works on binned rows
+    m_binner.emit(m_binned.data());
+    const XFrame::LineTime time = m_lineTime;
+    m_lineTime = m_binTime;
+    placeLine(m_binned.data(), m_binGroup, 0, m_lineBytes, m_fullSegMask);
+    m_lineTime = time;
 }
 
-void XFrame::SetSink(IXImgSink* sink_) {
-    if (m_impl) {
-        m_impl->setSink(sink_);
+void XFrame::Impl::addSegment(const uint8_t* data, uint32_t len, uint32_t lineId, uint32_t segment,
+                              const XFrame::LineTime* time) {
+    LineLock lock(m_mutex, m_sharedLines);
+    
+    if (!m_running || !m_currentFrame || !data || untriggered(lineId)) {
+        return;
     }
+    m_lineTime = time ? *time : XFrame::LineTime();
+    
+    if (m_dualEnergy || segment >= m_segments || len != m_segmentBytes) {
+        reportError(101, "Line segment mismatch");
+        return;
+    }
+    
+    placeLine(data, lineId, segment * m_segmentBytes, len, uint64_t(1) << segment);
 }
 
-bool XFrame::Start(uint32_t width, uint8_t pixelDepth) {
-    if (!m_impl) {
-        return false;
+void XFrame::Impl::addEnergyLine(const uint8_t* data, uint32_t len, uint32_t lineId, uint8_t energyFlag,
+                                 const XFrame::LineTime* time) {
+    LineLock lock(m_mutex, m_sharedLines);
+    
+    if (!m_running || !m_currentFrame || !data || untriggered(lineId)) {
+        return;
     }
-    return m_impl->start(width, pixelDepth);
+    m_lineTime = time ? *time : XFrame::LineTime();
+    
+    if (!m_dualEnergy || energyFlag > 1 || len != m_segmentBytes) {
+        reportError(101, "Energy line mismatch");
+        return;
+    }
+    
+    // High (flag 1) is segment 0, so its plane comes first
+    uint32_t segment = (energyFlag == 1) ? 0 : 1;
+    if (m_energyOffset != 0.0 && segment == m_alignedSegment) {
+        alignEnergyLine(data, lineId);
+        return;
+    }
+    placeLine(data, lineId, segment * m_segmentBytes, len, uint64_t(1) << segment);
 }
 
-void XFrame::Stop() {
-    if (m_impl) {
-        m_impl->stop();
+void XFrame::Impl::alignEnergyLine(const uint8_t* data, uint32_t lineId) {
+    // A line completes up to two rows of its plane, those it is the later line of
+    m_aligner.add(data, lineId);
+    uint32_t row;
+    while (m_aligner.emit(m_alignedLine.data(), row)) {
+        placeLine(m_alignedLine.data(), row, m_alignedSegment * m_segmentBytes, m_segmentBytes,
+                  uint64_t(1) << m_alignedSegment);
     }
 }
 
-bool XFrame::IsRunning() const {
+void XFrame::Impl::placeLine(const uint8_t* data, uint32_t lineId, uint32_t offset,
+                             uint32_t len, uint64_t segMask) {
+    Internal::PerfScope perf(XFactory::PERF_FRAME_ASSEMBLY);
+    if (sequenceDone() || burstFull()) {
+        if (m_packer.full()) {
+            // Workers found the arena full after the frame was queued
+            reportArenaFull();
+        }
+        return;
+    }
+    if (m_stride > 0) {
+        placeWindowLine(data, lineId);
+        return;
+    }
+    if (m_objectThreshold > 0) {
+        placeObjectLine(data);
+        return;
+    }
+    
+    m_lastLineTime = std::chrono::steady_clock::now();
+    
+    if (!m_frameOpen) {
+        // First line of the run defines the frame origin
+        m_lineOrigin = lineId;
+        m_frameIndex = 0;
+        m_frameOpen = true;
+    }
+    
+    uint32_t rel = lineId - m_lineOrigin;
+    if (static_cast<int32_t>(rel) < 0) {
+        m_linesLate++;
+        return;
+    }
+    
+    uint32_t frameIdx = rel / m_linesPerFrame;
+    uint32_t row = rel % m_linesPerFrame;
+    
+    if (frameIdx < m_frameIndex) {
+        // Belongs to a frame that was already emitted
+        m_linesLate++;
+        return;
+    }
+    
+    if (frameIdx == m_frameIndex + 1 && row < m_stashSegMask.size()) {
+        // Early line of the next frame: hold it inside the reorder window
+        if (m_stashSegMask[row] == 0) {
+            m_stashCount++;
+            m_stashTimes[row] = m_lineTime;
+        }
+        m_stashSegMask[row] |= segMask;
+        memcpy(m_stash.data() + static_cast<size_t>(row) * m_lineBytes + offset, data, len);
+        return;
+    }
+    
+    if (frameIdx > m_frameIndex) {
+        // Next frame has clearly begun: emit what we have
+        bool contiguous = (frameIdx == m_frameIndex + 1);
+        if (m_currentLine > 0) {
+            assembleFrame();
+        }
+        if (contiguous) {
+            m_frameIndex = frameIdx;
+            drainStash();
+        } else {
+            m_frameIndex = frameIdx;
+            m_linesLate += m_stashCount;
+            std::fill(m_stashSegMask.begin(), m_stashSegMask.end(), 0);
+            m_stashCount = 0;
+        }
+    }
+    
+    writeRow(row, data, offset, len, segMask, m_lineTime);
+    
+    // Check if frame is complete
+    while (m_currentLine >= m_linesPerFrame) {
+        assembleFrame();
+        if (m_frameTrigger) {
+            // Nothing follows until the next trigger
+            m_triggerArmed = false;
+            break;
+        }
+        m_frameIndex++;
+        drainStash();
+    }
+}
+
+void XFrame::Impl::writeRow(uint32_t row, const uint8_t* data, uint32_t offset,
+                            uint32_t len, uint64_t segMask, const XFrame::LineTime& time) {
+    uint8_t* dst = rowAddress(m_currentFrame->_data_, row, offset);
+    if (m_currentRaw) {
+        // Kept before the filters run, possibly in place on dst
+        memcpy(rowAddress(m_currentRaw->_data_, row, offset), data, len);
+    }
+    // Each energy line is a whole line of its plane
+    const bool wholeLine = (len == m_lineBytes) || m_dualEnergy;
+    if (!m_filters.empty() && wholeLine) {
+        filterLine(data, dst, row);
+    } else if (dst != data) {
+        memcpy(dst, data, len);
+    }
+    
+    if (m_rowSegMask[row] == 0) {
+        m_rowTimes[row] = time;
+    }
+    m_rowSegMask[row] |= segMask;
+    if (m_rowSegMask[row] != m_fullSegMask) {
+        return;
+    }
+    
+    if (!m_filters.empty() && !wholeLine) {
+        uint8_t* line = dst - offset;
+        filterLine(line, line, row);
+    }
+    
+    uint64_t bit = uint64_t(1) << (row & 63);
+    if (!(m_rowMask[row >> 6] & bit)) {
+        m_rowMask[row >> 6] |= bit;
+        m_currentLine++;
+        
+        if (Internal::TraceEnabled()) {
+            traceRow();
+        }
+        
+        if (m_stripLines > 0 && row == m_stripNext) {
+            emitStrips(false);
+        }
+        if (m_pyramidIncremental && row == m_pyramidRows) {
+            advancePyramid();
+        }
+    }
+}
+
+uint8_t* XFrame::Impl::rowAddress(uint8_t* base, uint32_t row, uint32_t offset) const {
+    if (m_dualEnergy) {
+        // offset selects the plane, rows are contiguous within it
+        return base + (offset / m_segmentBytes) * m_planeBytes + static_cast<size_t>(row) * m_segmentBytes;
+    }
+    return base + static_cast<size_t>(row) * m_lineBytes + offset;
+}
+
+void XFrame::Impl::resetRowState() {
+    std::fill(m_rowMask.begin(), m_rowMask.end(), 0);
+    std::fill(m_rowSegMask.begin(), m_rowSegMask.end(), 0);
+    std::fill(m_rowTimes.begin(), m_rowTimes.end(), XFrame::LineTime());
+    m_stripNext = 0;
+    m_pyramidRows = 0;
+    m_pyramid.reset();
+}
+
+void XFrame::Impl::emitStrips(bool flush) {
+    if (!m_sink || !m_currentFrame) {
+        return;
+    }
+    
+    for (;;) {
+        // Extend the run of received rows that starts at m_stripNext
+        uint32_t end = m_stripNext;
+        while (end < m_linesPerFrame && end - m_stripNext < m_stripLines &&
+               (m_rowMask[end >> 6] & (uint64_t(1) << (end & 63)))) {
+            end++;
+        }
+        
+        uint32_t count = end - m_stripNext;
+        if (flush) {
+            // Frame is closing: hand over the rest, holes included
+            count = m_linesPerFrame - m_stripNext;
+            if (count > m_stripLines) {
+                count = m_stripLines;
+            }
+        }
+        if (count == 0 || (!flush && count < m_stripLines && end < m_linesPerFrame)) {
+            return;
+        }
+        
+        m_strip.SetData(m_currentFrame->_data_ + static_cast<size_t>(m_stripNext) * m_lineBytes,
+                        m_imageWidth, count, m_pixelDepth, false);
+        
+        uint32_t first = m_stripNext;
+        m_stripNext += count;
+        m_sink->OnLinesReady(&m_strip, first, count);
+    }
+}
+
+void XFrame::Impl::advancePyramid() {
+    // Extend the run of received rows from the top, then reduce its new pairs
+    while (m_pyramidRows < m_linesPerFrame &&
+           (m_rowMask[m_pyramidRows >> 6] & (uint64_t(1) << (m_pyramidRows & 63)))) {
+        m_pyramidRows++;
+    }
+    m_pyramid.advance(*m_currentFrame, m_pyramidRows);
+}
+
+void XFrame::Impl::drainStash() {
+    if (m_stashCount == 0) {
+        return;
+    }
+    
+    for (uint32_t row = 0; row < m_stashSegMask.size(); ++row) {
+        uint64_t segMask = m_stashSegMask[row];
+        if (segMask == 0) {
+            continue;
+        }
+        
+        const uint8_t* src = m_stash.data() + static_cast<size_t>(row) * m_lineBytes;
+        if (segMask == m_fullSegMask && !m_dualEnergy) {
+            writeRow(row, src, 0, m_lineBytes, segMask, m_stashTimes[row]);
+        } else {
+            for (uint32_t seg = 0; seg < m_rowSegments; ++seg) {
+                if (segMask & (uint64_t(1) << seg)) {
+                    writeRow(row, src + seg * m_segmentBytes, seg * m_segmentBytes,
+                             m_segmentBytes, uint64_t(1) << seg, m_stashTimes[row]);
+                }
+            }
+        }
+        m_stashSegMask[row] = 0;
+    }
+    m_stashCount = 0;
+}
+
+void XFrame::Impl::poll() {
+    LineLock lock(m_mutex, m_sharedLines);
+    
+    if (!m_running || !m_currentFrame || m_frameTimeout == 0 || sequenceDone() || burstFull()) {
+        return;
+    }
+    
+    const bool binPending = m_binning && m_binner.count() > 0;
+    if (!binPending && (m_stride > 0 ? (m_windowCount == 0) : (m_currentLine == 0 && m_stashCount == 0))) {
+        return;
+    }
+    
+    std::chrono::steady_clock::duration idle = std::chrono::steady_clock::now() - m_lastLineTime;
+    if (std::chrono::duration_cast<std::chrono::milliseconds>(idle).count() < m_frameTimeout) {
+        return;
+    }
+    
+    if (binPending) {
+        // Place the short group first; it may complete the frame by itself
+        flushBin();
+        m_binGroup++;
+        if (m_stride > 0 ? (m_windowCount == 0) : (m_currentLine == 0 && m_stashCount == 0)) {
+            return;
+        }
+    }
+    
+    if (m_stride > 0) {
+        emitWindow();
+        m_lastLineTime = std::chrono::steady_clock::now();
+        return;
+    }
+    
+    if (m_objectThreshold > 0) {
+        // The belt stopped under an object: close it where it is
+        emitObject(false);
+        m_lastLineTime = std::chrono::steady_clock::now();
+        return;
+    }
+    
+    // Lines stopped arriving: emit the partial frame with its missing mask
+    if (m_currentLine > 0) {
+        assembleFrame();
+    }
+    m_triggerArmed = false;
+    m_frameIndex++;
+    drainStash();
+    m_lastLineTime = std::chrono::steady_clock::now();
+}
+
+void XFrame::Impl::placeWindowLine(const uint8_t* data, uint32_t lineId) {
+    m_lastLineTime = std::chrono::steady_clock::now();
+    
+    if (!m_frameOpen) {
+        // First line of the run defines the frame origin
+        m_lineOrigin = lineId;
+        m_frameOpen = true;
+        resyncWindow(0);
+    }
+    
+    uint32_t line = lineId - m_lineOrigin;
+    if (static_cast<int32_t>(line) < 0 || line < m_windowFrame) {
+        m_linesLate++;
+        return;
+    }
+    
+    if (line - m_windowFrame >= m_windowCapacity) {
+        // Line is beyond anything the buffer can hold: restart around it
+        if (m_windowCount > 0) {
+            emitWindow();
+        }
+        resyncWindow(line);
+    }
+    
+    if (line - m_windowBase >= m_windowCapacity) {
+        compactWindow();
+    }
+    
+    uint32_t row = line - m_windowBase;
+    uint8_t* dst = m_window.data() + static_cast<size_t>(row) * m_lineBytes;
+    if (m_filters.empty()) {
+        memcpy(dst, data, m_lineBytes);
+    } else {
+        filterLine(data, dst, line);
+    }
+    
+    if (!m_windowRows[row]) {
+        m_windowRows[row] = 1;
+        m_windowTimes[row] = m_lineTime;
+        if (Internal::TraceEnabled()) {
+            traceRow();
+        }
+        if (line < m_windowFrame + m_linesPerFrame) {
+            m_windowCount++;
+        }
+    }
+    
+    while (m_windowCount >= m_linesPerFrame) {
+        emitWindow();
+    }
+}
+
+// Pixels below threshold in one row, sampled every step from first
+template <typename T>
+static uint32_t rowContent(const uint8_t* row, uint32_t width, uint32_t first, uint32_t step,
+                           uint32_t threshold) {
+    const T* pixels = reinterpret_cast<const T*>(row);
+    uint32_t count = 0;
+    for (uint32_t col = first; col < width; col += step) {
+        count += (pixels[col] < threshold) ? 1 : 0;
+    }
+    return count;
+}
+
+bool XFrame::Impl::isObjectLine(const uint8_t* line) const {
+    uint32_t content;
+    if (m_pixelDepth <= 8) {
+        content = rowContent<uint8_t>(line, m_imageWidth, 0, 1, m_objectThreshold);
+    } else if (m_pixelDepth <= 16) {
+        content = rowContent<uint16_t>(line, m_imageWidth, 0, 1, m_objectThreshold);
+    } else {
+        content = rowContent<uint32_t>(line, m_imageWidth, 0, 1, m_objectThreshold);
+    }
+    return content >= m_objectMinPixels;
+}
+
+void XFrame::Impl::placeObjectLine(const uint8_t* data) {
+    m_lastLineTime = std::chrono::steady_clock::now();
+    
+    // Lines are classified after the filters, on corrected pixels
+    uint8_t* dst;
+    if (m_objectOpen) {
+        dst = m_currentFrame->_data_ + static_cast<size_t>(m_currentLine) * m_lineBytes;
+        m_rowTimes[m_currentLine] = m_lineTime;
+    } else {
+        dst = m_objectRing.data() + static_cast<size_t>(m_objectRingNext) * m_lineBytes;
+    }
+    m_objectRingTimes[m_objectRingNext] = m_lineTime;
+    if (m_filters.empty()) {
+        memcpy(dst, data, m_lineBytes);
+    } else {
+        filterLine(data, dst, m_currentLine);
+    }
+    const bool object = isObjectLine(dst);
+    
+    if (m_objectOpen && !object && m_objectQuiet == m_objectPost) {
+        // Trailing margin is complete: the line goes back to the belt
+        memcpy(m_objectRing.data() + static_cast<size_t>(m_objectRingNext) * m_lineBytes, dst, m_lineBytes);
+        emitObject(false);
+    }
+    
+    if (!m_objectOpen) {
+        if (!object) {
+            // Belt line: keep it as a possible leading margin
+            m_objectRingNext = (m_objectRingNext + 1) % (m_objectPre + 1);
+            m_objectRingCount = std::min(m_objectRingCount + 1, m_objectPre);
+            return;
+        }
+        openObject();
+    } else {
+        m_rowMask[m_currentLine >> 6] |= uint64_t(1) << (m_currentLine & 63);
+        m_currentLine++;
+        if (Internal::TraceEnabled()) {
+            traceRow();
+        }
+        m_objectQuiet = object ? 0 : m_objectQuiet + 1;
+    }
+    if (m_pyramidIncremental) {
+        advancePyramid();
+    }
+    
+    if (m_currentLine == m_linesPerFrame) {
+        emitObject(true);
+    }
+}
+
+void XFrame::Impl::openObject() {
+    // Margin lines oldest first, then the line that opened the object
+    const uint32_t slots = m_objectPre + 1;
+    uint32_t slot = (m_objectRingNext + slots - m_objectRingCount) % slots;
+    for (uint32_t i = 0; i <= m_objectRingCount; ++i) {
+        memcpy(m_currentFrame->_data_ + static_cast<size_t>(i) * m_lineBytes,
+               m_objectRing.data() + static_cast<size_t>(slot) * m_lineBytes, m_lineBytes);
+        m_rowTimes[i] = m_objectRingTimes[slot];
+        slot = (slot + 1) % slots;
+    }
+    
+    m_currentLine = m_objectRingCount + 1;
+    for (uint32_t row = 0; row < m_currentLine; ++row) {
+        m_rowMask[row >> 6] |= uint64_t(1) << (row & 63);
+    }
+    if (Internal::TraceEnabled()) {
+        traceRow();
+    }
+    m_objectOpen = true;
+    m_objectQuiet = 0;
+    m_objectRingNext = 0;
+    m_objectRingCount = 0;
+}
+
+void XFrame::Impl::emitObject(bool continues) {
+    if (m_currentLine == 0) {
+        return;
+    }
+    
+    // The frame is as tall as its object; recycle() restores the buffer
+    const uint32_t rows = m_currentLine;
+    m_currentFrame->_height = rows;
+    m_currentFrame->_size = m_currentFrame->_stride * rows;
+    if (continues) {
+        reportEvent(116, rows);
+    }
+    m_objectOpen = continues;
+    if (!continues) {
+        m_objectQuiet = 0;
+    }
+    assembleFrame();
+}
+
+void XFrame::Impl::emitWindow() {
+    if (m_windowFrame + m_linesPerFrame - m_windowBase > m_windowCapacity) {
+        compactWindow();
+    }
+    
+    uint32_t first = m_windowFrame - m_windowBase;
+    uint32_t missing = m_linesPerFrame - m_windowCount;
+    
+    {
+        std::lock_guard<std::mutex> poolLock(m_poolMutex);
+        std::fill(m_windowMask.begin(), m_windowMask.end(), 0);
+        for (uint32_t row = 0; row < m_linesPerFrame; ++row) {
+            if (m_windowRows[first + row]) {
+                m_windowMask[row >> 6] |= uint64_t(1) << (row & 63);
+            }
+        }
+        std::copy(m_windowTimes.begin() + first, m_windowTimes.begin() + first + m_linesPerFrame,
+                  m_windowViewTimes.begin());
+    }
+    
+    // The frame is a view: rows shared with the next frame stay where they are
+    m_windowView.SetData(m_window.data() + static_cast<size_t>(first) * m_lineBytes,
+                         m_imageWidth, m_linesPerFrame, m_pixelDepth, false);
+    
+    if (missing > 0) {
+        m_framesIncomplete++;
+        reportEvent(111, missing);
+    }
+    
+    const uint64_t sequence = m_frameSequence++;
+    if (m_sink && !shedFrame() && !tagEmpty(&m_windowView)) {
+        stampInfo(&m_windowView, sequence, missing, m_lineOrigin + m_windowFrame, m_windowViewTimes,
+                  m_windowEmpty);
+        deliverFrame(&m_windowView);
+    }
+    
+    // Advance one stride; the overlap rows are already counted
+    m_windowFrame += m_stride;
+    m_windowCount = 0;
+    for (uint32_t line = m_windowFrame; line < m_windowFrame + m_linesPerFrame; ++line) {
+        uint32_t row = line - m_windowBase;
+        if (row < m_windowCapacity && m_windowRows[row]) {
+            m_windowCount++;
+        }
+    }
+}
+
+void XFrame::Impl::compactWindow() {
+    // Drop rows before the current frame; runs once per WINDOW_FRAMES strides
+    uint32_t shift = m_windowFrame - m_windowBase;
+    if (shift == 0) {
+        return;
+    }
+    
+    uint32_t keep = m_windowCapacity - shift;
+    memmove(m_window.data(), m_window.data() + static_cast<size_t>(shift) * m_lineBytes,
+            static_cast<size_t>(keep) * m_lineBytes);
+    memset(m_window.data() + static_cast<size_t>(keep) * m_lineBytes, 0,
+           static_cast<size_t>(shift) * m_lineBytes);
+    memmove(m_windowRows.data(), m_windowRows.data() + shift, keep);
+    memset(m_windowRows.data() + keep, 0, shift);
+    std::copy(m_windowTimes.begin() + shift, m_windowTimes.end(), m_windowTimes.begin());
+    std::fill(m_windowTimes.begin() + keep, m_windowTimes.end(), XFrame::LineTime());
+    
+    m_windowBase = m_windowFrame;
+}
+
+void XFrame::Impl::resyncWindow(uint32_t line) {
+    // Earliest frame that contains the line
+    uint32_t frame = (line < m_linesPerFrame) ? 0 : (line - m_linesPerFrame) / m_stride + 1;
+    
+    m_windowFrame = frame * m_stride;
+    m_windowBase = m_windowFrame;
+    m_windowCount = 0;
+    std::fill(m_window.begin(), m_window.end(), 0);
+    std::fill(m_windowRows.begin(), m_windowRows.end(), 0);
+    std::fill(m_windowTimes.begin(), m_windowTimes.end(), XFrame::LineTime());
+}
+
+void XFrame::Impl::assembleFrame() {
+    if (!m_currentFrame) {
+        return;
+    }
+    
+    // Object frames are trimmed to the rows they hold
+    const uint32_t rows = (m_objectThreshold > 0) ? m_currentFrame->_height : m_linesPerFrame;
+    uint32_t missing = rows - m_currentLine;
+    m_currentLine = 0;
+    const uint64_t sequence = m_frameSequence++;
+    
+    if (missing > 0 && ((hasSink() && m_clearPolicy == XFrame::CLEAR_MISSING) || burstPacked())) {
+        // Every other row was overwritten by this frame's lines; staging
+        // frames of a compressed burst are reused, so they are cleared too
+        fillMissingRows(m_currentFrame->_data_);
+        if (m_currentRaw) {
+            fillMissingRows(m_currentRaw->_data_);
+        }
+    }
+    
+    if (m_stripLines > 0) {
+        // Rows behind a hole were held back; report them before the frame
+        emitStrips(true);
+    }
+    
+    if (m_burstFrames > 0) {
+        storeBurstFrame(sequence, missing);
+        return;
+    }
+    
+    if (!hasSink()) {
+        resetRowState();
+        recycle(m_currentFrame);
+        frameDone();
+        return;
+    }
+    
+    XImage* completed = m_currentFrame;
+    XImage* raw = nullptr;
+    
+    if (m_poolSize > 1) {
+        // Take the next buffer before handing the completed one off
+        XImage* next = nullptr;
+        XImage* nextRaw = nullptr;
+        const uint32_t assembling = m_currentRaw ? 2 : 1;
+        uint32_t held = 0;
+        {
+            std::lock_guard<std::mutex> poolLock(m_poolMutex);
+            if (!m_freeList.empty() && m_bus) {
+                // Oldest first, so subscribers keep as many frames as possible
+                next = m_freeList.front();
+                m_freeList.erase(m_freeList.begin());
+            } else if (!m_freeList.empty()) {
+                next = m_freeList.back();
+                m_freeList.pop_back();
+            }
+            if (next && m_currentRaw && !m_freeList.empty()) {
+                // The corrected frame has the first claim on a free buffer
+                nextRaw = m_freeList.back();
+                m_freeList.pop_back();
+            }
+            held = m_poolSize - assembling - static_cast<uint32_t>(m_freeList.size());
+        }
+        
+        // Buffers the sinks have not released yet, the current ones aside
+        m_overload.report(held, m_poolSize - assembling);
+        
+        if (!next) {
+            // Every buffer is still held by the sink: drop this frame and reuse it
+            m_framesDropped++;
+            reportError(34, "Frame pool exhausted, frame dropped");
+            if (m_currentRaw) {
+                // ... and its raw twin with it
+                reportEvent(124, static_cast<uint32_t>(++m_rawDropped));
+                recycle(m_currentRaw);
+            }
+            resetRowState();
+            recycle(m_currentFrame);
+            return;
+        }
+        
+        if (m_bus) {
+            m_bus->RetireSlot(static_cast<uint32_t>(poolIndex(next)));
+        }
+        recycle(next);
+        m_currentFrame = next;
+        
+        if (nextRaw) {
+            raw = m_currentRaw;
+            recycle(nextRaw);
+            m_currentRaw = nextRaw;
+        } else if (m_currentRaw) {
+            // The raw sink still holds its buffers: only the raw frame is lost
+            reportEvent(124, static_cast<uint32_t>(++m_rawDropped));
+            recycle(m_currentRaw);
+        }
+    }
+    
+    // Keep the received-rows mask with the buffer for GetMissingLines()
+    int index = poolIndex(completed);
+    if (index >= 0) {
+        m_poolMasks[index].swap(m_rowMask);
+        m_poolTimes[index].swap(m_rowTimes);
+        if (!m_poolPyramids.empty()) {
+            // Rows behind a hole and an odd last row are the only ones left
+            if (m_temporalMode == XFrame::TEMPORAL_OFF) {
+                m_pyramid.advance(*completed, completed->_height);
+            }
+            m_poolPyramids[index].swap(m_pyramid);
+        }
+    }
+    const int rawIndex = raw ? poolIndex(raw) : -1;
+    if (index >= 0 && rawIndex >= 0) {
+        m_poolMasks[rawIndex] = m_poolMasks[index];
+        m_poolTimes[rawIndex] = m_poolTimes[index];
+        if (!m_poolPyramids.empty()) {
+            m_poolPyramids[rawIndex].reset();
+            m_poolPyramids[rawIndex].advance(*raw, raw->_height);
+        }
+    }
+    resetRowState();
+    
+    if (missing > 0) {
+        m_framesIncomplete++;
+        reportEvent(111, missing);
+    }
+    
+    if (shedFrame()) {
+        // Whole frame, so the sink never sees one with lines cut out
+        if (m_poolSize > 1) {
+            std::lock_guard<std::mutex> poolLock(m_poolMutex);
+            m_freeList.push_back(completed);
+            if (raw) {
+                m_freeList.push_back(raw);
+            }
+        } else {
+            recycle(m_currentFrame);
+        }
+        return;
+    }
+    
+    if (m_temporalMode != XFrame::TEMPORAL_OFF && !averageFrame(completed)) {
+        // Folded into the average only: the buffer goes straight back
+        if (m_poolSize > 1) {
+            std::lock_guard<std::mutex> poolLock(m_poolMutex);
+            m_freeList.push_back(completed);
+            if (raw) {
+                m_freeList.push_back(raw);
+            }
+        } else {
+            recycle(m_currentFrame);
+        }
+        return;
+    }
+    
+    if (m_temporalMode != XFrame::TEMPORAL_OFF && index >= 0 && !m_poolPyramids.empty()) {
+        // Reduce the average that is delivered, not the frame folded into it
+        m_poolPyramids[index].advance(*completed, completed->_height);
+    }
+    
+    if (tagEmpty(completed)) {
+        if (m_poolSize > 1) {
+            std::lock_guard<std::mutex> poolLock(m_poolMutex);
+            m_freeList.push_back(completed);
+            if (raw) {
+                m_freeList.push_back(raw);
+            }
+        } else {
+            recycle(m_currentFrame);
+        }
+        return;
+    }
+    
+    if (index >= 0) {
+        const uint32_t firstLineId = (m_objectThreshold > 0) ? 0 :
+                                     m_lineOrigin + m_frameIndex * m_linesPerFrame;
+        stampInfo(completed, sequence, missing, firstLineId, m_poolTimes[index], m_poolEmpty[index] != 0);
+        if (rawIndex >= 0) {
+            m_poolEmpty[rawIndex] = m_poolEmpty[index];
+            stampInfo(raw, sequence, missing, firstLineId, m_poolTimes[rawIndex], m_poolEmpty[index] != 0);
+        }
+    }
+    
+    if (m_bus && index >= 0) {
+        m_bus->PublishSlot(static_cast<uint32_t>(index), completed->_width, completed->_height,
+                           m_pixelDepth, missing, m_poolEmpty[index] != 0);
+    }
+    
+    if (rawIndex >= 0) {
+        // Raw first, so a recorder has it by the time the corrected frame is seen
+        {
+            std::lock_guard<std::mutex> poolLock(m_poolMutex);
+            m_poolRefs[rawIndex] = 1;
+        }
+        Internal::PerfScope perf(XFactory::PERF_SINK);
+        callSink(m_rawSink, m_rawTiming, raw);
+    }
+    
+    // With a pool the sink owns the frame until it calls XFrame::Release()
+    deliverFrame(completed);
+    
+    if (m_poolSize <= 1) {
+        // Single buffer: the sink must be done with it when the callback returns
+        recycle(m_currentFrame);
+    }
+}
+
+bool XFrame::Impl::allocateBurst(uint32_t width, uint8_t pixelDepth) {
+    const uint32_t height = m_dualEnergy ? m_linesPerFrame * 2 : m_linesPerFrame;
+    const size_t frameBytes = static_cast<size_t>(m_lineBytes) * m_linesPerFrame;
+    const bool packed = burstPacked();
+    const uint32_t frames = packed ? m_burstWorkers * 2 + 1 : m_burstFrames;
+    const size_t bytes = frameBytes * frames;
+    m_burstCount = 0;
+    
+    // The block kept from the previous burst is reused when it fits: its
+    // pages are faulted in already, so only the zeroing is left to do
+    if (m_pool.size() == frames && m_pool[0]->_width == width &&
+        m_pool[0]->_height == height && m_pool[0]->_pixel_depth == pixelDepth &&
+        (m_burstArena != nullptr) == packed) {
+        m_packer.reset();
+        memset(m_pool[0]->_data_, 0, bytes);
+        m_currentFrame = m_pool[0];
+        return true;
+    }
+    freePool();
+    
+    std::lock_guard<std::mutex> poolLock(m_poolMutex);
+    Internal::MemTagScope memTag(XFactory::MEM_FRAME_POOL);
+    
+    // Zeroed up front, so no page is first touched during the burst
+    uint8_t* block = nullptr;
+    if (m_factory) {
+        block = static_cast<uint8_t*>(m_factory->AllocateEx(bytes, m_allocOptions));
+        if (!block) {
+            return false;
+        }
+        memset(block, 0, bytes);
+        m_poolData.push_back(block);
+    } else {
+        try {
+            m_burstData.assign(bytes, 0);
+        } catch (const std::bad_alloc&) {
+            return false;
+        }
+        block = m_burstData.data();
+    }
+    
+    if (packed) {
+        // Faulted in now too: workers append to it while lines arrive
+        const size_t arenaBytes = static_cast<size_t>(m_burstArenaBytes);
+        if (m_factory) {
+            m_burstArena = static_cast<uint8_t*>(m_factory->AllocateEx(arenaBytes, m_allocOptions));
+            if (!m_burstArena) {
+                return false;
+            }
+            m_poolData.push_back(m_burstArena);
+        } else {
+            try {
+                m_burstArenaData.assign(arenaBytes, 0);
+            } catch (const std::bad_alloc&) {
+                return false;
+            }
+            m_burstArena = m_burstArenaData.data();
+        }
+        memset(m_burstArena, 0, arenaBytes);
+    }
+    
+    for (uint32_t i = 0; i < frames; ++i) {
+        XImage* image = new XImage();
+        image->SetData(block + frameBytes * i, width, height, pixelDepth, false);
+        m_pool.push_back(image);
+    }
+    m_currentFrame = m_pool[0];
+    
+    if (packed) {
+        HX_LOG_INFO("XFrame") << "Burst of " << m_burstFrames << " frame(s) packed into "
+                              << (m_burstArenaBytes >> 20) << " MB, " << frames
+                              << " staging frame(s) of " << (frameBytes >> 10) << " KB";
+    } else {
+        HX_LOG_INFO("XFrame") << "Burst of " << m_burstFrames << " frame(s), "
+                              << (bytes >> 20) << " MB";
+    }
+    return true;
+}
+
+void XFrame::Impl::storeBurstFrame(uint64_t sequence, uint32_t missing) {
+    // The rows of the frame go with it; readers may look at earlier frames
+    {
+        std::lock_guard<std::mutex> poolLock(m_poolMutex);
+        m_poolMasks[m_burstCount].swap(m_rowMask);
+        m_poolTimes[m_burstCount].swap(m_rowTimes);
+    }
+    resetRowState();
+    stampInfo(m_currentFrame, sequence, missing, m_lineOrigin + m_frameIndex * m_linesPerFrame,
+              m_poolTimes[m_burstCount], false);
+    if (missing > 0) {
+        m_framesIncomplete++;
+    }
+    
+    const bool packed = burstPacked();
+    if (packed) {
+        m_burstInfo[m_burstCount] = m_currentFrame->_info;
+        m_packer.submit(static_cast<uint32_t>(poolIndex(m_currentFrame)), m_currentFrame->_data_,
+                        m_currentFrame->_width, m_currentFrame->_height, m_currentFrame->_stride,
+                        (m_pixelDepth + 7) / 8);
+    }
+    
+    const uint32_t count = ++m_burstCount;
+    if (packed && m_packer.full()) {
+        // Lines are dropped from here on, as after the last frame
+        reportArenaFull();
+    } else if (count < m_burstFrames) {
+        if (packed) {
+            bool stalled = false;
+            m_currentFrame = m_pool[m_packer.acquire(stalled)];
+            if (stalled) {
+                reportEvent(125, static_cast<uint32_t>(m_packer.stalls()));
+            }
+        } else {
+            m_currentFrame = m_pool[count];
+        }
+    } else {
+        HX_LOG_INFO("XFrame") << "Burst complete: " << count << " frame(s)";
+        reportEvent(120, count);
+    }
+    frameDone();
+}
+
+void XFrame::Impl::traceRow() {
+    // Lines added by the application carry no receive stamp
+    const Internal::TraceLineStamp& stamp = Internal::TraceLine();
+    const uint64_t now = Internal::TraceNow();
+    if (stamp.dequeuedNs) {
+        Internal::TraceRecord(XFactory::TRACE_LINE, stamp.dequeuedNs, now);
+    }
+    const uint64_t received = stamp.receivedNs ? stamp.receivedNs : now;
+    if (m_traceFirstNs == 0) {
+        m_traceFirstNs = received;
+    }
+    m_traceLastNs = received;
+}
+
+void XFrame::Impl::deliverFrame(XImage* image) {
+    m_framesDelivered++;
+    measurePeriod(image);
+    shareFrame(image);
+    if (!Internal::TraceEnabled() || m_traceLastNs == 0) {
+        // Tracing is off or was switched on in the middle of this frame
+        m_traceFirstNs = 0;
+        m_traceLastNs = 0;
+        {
+            Internal::PerfScope perf(XFactory::PERF_SINK);
+            if (m_sink) {
+                callSink(m_sink, m_sinkTiming, image);
+            }
+        }
+        frameDone();
+        return;
+    }
+    
+    const uint64_t ready = Internal::TraceNow();
+    Internal::TraceRecord(XFactory::TRACE_ASSEMBLY, m_traceFirstNs, m_traceLastNs);
+    Internal::TraceRecord(XFactory::TRACE_END_TO_END, m_traceLastNs, ready);
+    m_traceFirstNs = 0;
+    m_traceLastNs = 0;
+    
+    {
+        Internal::PerfScope perf(XFactory::PERF_SINK);
+        if (m_sink) {
+            callSink(m_sink, m_sinkTiming, image);
+        }
+    }
+    Internal::TraceRecord(XFactory::TRACE_SINK, ready, Internal::TraceNow());
+    frameDone();
+}
+
+void XFrame::Impl::callSink(IXImgSink* sink, SinkTiming& timing, XImage* image) {
+    const uint64_t start = Internal::TraceNow();
+    sink->OnFrameReady(image);
+    const uint64_t end = Internal::TraceNow();
+    const uint64_t ns = end - start;
+    timing.histogram.add(ns);
+    
+    const uint64_t limit = m_watchdogLimitNs.load(std::memory_order_relaxed);
+    if (limit == 0 || ns <= limit) {
+        return;
+    }
+    timing.slow.fetch_add(1, std::memory_order_relaxed);
+    if (timing.warnedNs != 0 && end - timing.warnedNs < 1000000000ull) {
+        return;
+    }
+    timing.warnedNs = end;
+    const uint64_t us = ns / 1000;
+    HX_LOG_WARNING("XFrame") << (&timing == &m_sinkTiming ? "Sink" :
+                                 &timing == &m_rawTiming ? "Raw sink" : "Added sink")
+                             << " spent " << us << " us in OnFrameReady, limit "
+                             << limit / 1000 << " us (" << timing.slow.load() << " slow calls)";
+    reportEvent(123, static_cast<uint32_t>(std::min<uint64_t>(us, UINT32_MAX)));
+}
+
+void XFrame::Impl::measurePeriod(const XImage* image) {
+    if (m_watchdogFraction <= 0.0f || m_watchdogPeriodUs > 0) {
+        return;
+    }
+    // Acquisition times, not delivery times, so a slow sink cannot
+    // stretch its own limit
+    const XFrameInfo& info = image->_info;
+    const bool device = info.deviceUs != 0;
+    const uint64_t stamp = device ? info.deviceUs * 1000 : info.hostNs;
+    if (stamp == 0) {
+        return;
+    }
+    if (m_periodStampNs != 0 && device == m_periodDevice && stamp > m_periodStampNs &&
+        info.sequence > m_periodSequence) {
+        const uint64_t period = (stamp - m_periodStampNs) / (info.sequence - m_periodSequence);
+        const uint64_t previous = m_framePeriodNs.load(std::memory_order_relaxed);
+        m_framePeriodNs.store(previous ? previous - previous / 8 + period / 8 : period,
+                              std::memory_order_relaxed);
+        updateWatchdog();
+    }
+    m_periodStampNs = stamp;
+    m_periodSequence = info.sequence;
+    m_periodDevice = device;
+}
+
+void XFrame::Impl::updateWatchdog() {
+    m_watchdogLimitNs.store(static_cast<uint64_t>(m_framePeriodNs.load(std::memory_order_relaxed) *
+                                                  static_cast<double>(m_watchdogFraction)),
+                            std::memory_order_relaxed);
+}
+
+bool XFrame::Impl::setSinkWatchdog(float fraction, uint32_t framePeriodUs) {
+    if (!(fraction >= 0.0f)) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_running) {
+        reportError(32, "Cannot change the sink watchdog while running");
+        return false;
+    }
+    m_watchdogFraction = fraction;
+    m_watchdogPeriodUs = framePeriodUs;
+    return true;
+}
+
+bool XFrame::Impl::getSinkLatency(IXImgSink* sink, XFrame::SinkLatency& latency) const {
+    // The list only changes while stopped, so no lock against the line path
+    const SinkTiming* timing = nullptr;
+    if (sink && sink == m_sink) {
+        timing = &m_sinkTiming;
+    } else if (const AddedSink* added = findSink(sink)) {
+        timing = &added->timing;
+    }
+    if (!timing) {
+        return false;
+    }
+    XFactory::TraceStats stats;
+    timing->histogram.get(stats);
+    latency.calls = stats.count;
+    latency.slowCalls = timing->slow.load(std::memory_order_relaxed);
+    latency.meanNs = stats.meanNs;
+    latency.p50Ns = stats.p50Ns;
+    latency.p99Ns = stats.p99Ns;
+    latency.p999Ns = stats.p999Ns;
+    latency.maxNs = stats.maxNs;
+    latency.framePeriodNs = m_framePeriodNs.load(std::memory_order_relaxed);
+    return true;
+}
+
+void XFrame::Impl::shareFrame(XImage* image) {
+    const int index = (m_poolSize > 1) ? poolIndex(image) : -1;
+    if (index < 0) {
+        return;
+    }
+    
+    // Every holder releases once; the buffer is free after the last one,
+    // so the count is set before any of them can see the frame
+    {
+        std::lock_guard<std::mutex> poolLock(m_poolMutex);
+        m_poolRefs[index] = (m_sink ? 1 : 0) + static_cast<uint32_t>(m_addedSinks.size());
+    }
+    for (size_t i = 0; i < m_addedSinks.size(); ++i) {
+        queueFrame(*m_addedSinks[i], image);
+    }
+}
+
+void XFrame::Impl::queueFrame(AddedSink& added, XImage* image) {
+    XImage* dropped = nullptr;
+    {
+        std::unique_lock<std::mutex> lock(added.mutex);
+        if (added.queue.size() >= added.depth && added.policy == XFrame::SINK_BLOCK) {
+            added.spaceCv.wait(lock, [&added] {
+                return added.stopping || added.queue.size() < added.depth;
+            });
+        }
+        if (added.queue.size() < added.depth) {
+            added.queue.push_back(image);
+        } else if (added.policy == XFrame::SINK_DROP_OLDEST) {
+            dropped = added.queue.front();
+            added.queue.pop_front();
+            added.queue.push_back(image);
+        } else {
+            dropped = image;
+        }
+    }
+    
+    if (dropped != image) {
+        added.workCv.notify_one();
+    }
+    if (dropped) {
+        added.dropped++;
+        const uint64_t total = ++m_sinkDrops;
+        reportEvent(121, static_cast<uint32_t>(total));
+        release(dropped);
+    }
+}
+
+void XFrame::Impl::sinkThread(AddedSink* added) {
+    for (;;) {
+        XImage* image = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(added->mutex);
+            added->workCv.wait(lock, [added] { return added->stopping || !added->queue.empty(); });
+            if (added->queue.empty()) {
+                // Stopping, and everything queued was delivered
+                return;
+            }
+            image = added->queue.front();
+            added->queue.pop_front();
+        }
+        added->spaceCv.notify_one();
+        
+        callSink(added->sink, added->timing, image);
+        release(image);
+    }
+}
+
+void XFrame::Impl::startSinks() {
+    m_sinkDrops = 0;
+    for (size_t i = 0; i < m_addedSinks.size(); ++i) {
+        AddedSink* added = m_addedSinks[i];
+        added->stopping = false;
+        added->dropped = 0;
+        added->timing.reset();
+        added->thread = std::thread(&Impl::sinkThread, this, added);
+    }
+}
+
+void XFrame::Impl::stopSinks() {
+    for (size_t i = 0; i < m_addedSinks.size(); ++i) {
+        AddedSink* added = m_addedSinks[i];
+        {
+            std::lock_guard<std::mutex> lock(added->mutex);
+            added->stopping = true;
+        }
+        added->workCv.notify_all();
+        added->spaceCv.notify_all();
+        if (added->thread.joinable()) {
+            added->thread.join();
+        }
+    }
+}
+
+XFrame::Impl::AddedSink* XFrame::Impl::findSink(IXImgSink* sink) const {
+    for (size_t i = 0; i < m_addedSinks.size(); ++i) {
+        if (m_addedSinks[i]->sink == sink) {
+            return m_addedSinks[i];
+        }
+    }
+    return nullptr;
+}
+
+bool XFrame::Impl::addSink(IXImgSink* sink, uint32_t queueFrames, XFrame::SinkPolicy policy) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    if (m_running) {
+        reportError(32, "Cannot add sinks while running");
+        return false;
+    }
+    if (!sink || queueFrames == 0 || findSink(sink)) {
+        reportError(32, "Invalid or duplicate sink");
+        return false;
+    }
+    
+    AddedSink* added = new AddedSink();
+    added->sink = sink;
+    added->depth = queueFrames;
+    added->policy = policy;
+    added->stopping = false;
+    added->dropped = 0;
+    m_addedSinks.push_back(added);
+    return true;
+}
+
+bool XFrame::Impl::removeSink(IXImgSink* sink) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    if (m_running) {
+        reportError(32, "Cannot remove sinks while running");
+        return false;
+    }
+    for (size_t i = 0; i < m_addedSinks.size(); ++i) {
+        if (m_addedSinks[i]->sink == sink) {
+            delete m_addedSinks[i];
+            m_addedSinks.erase(m_addedSinks.begin() + i);
+            return true;
+        }
+    }
+    return false;
+}
+
+uint64_t XFrame::Impl::getSinkDropped(IXImgSink* sink) const {
+    // The list only changes while stopped, so no lock against the line path
+    const AddedSink* added = findSink(sink);
+    return added ? added->dropped.load() : 0;
+}
+
+bool XFrame::Impl::setRawSink(IXImgSink* sink) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    if (m_running) {
+        reportError(32, "Cannot change the raw sink while running");
+        return false;
+    }
+    
+    m_rawSink = sink;
+    return true;
+}
+
+void XFrame::Impl::setFrameListener(Internal::FrameListener* listener, uint32_t frameLimit) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_frameListener = listener;
+    m_frameLimit = listener ? frameLimit : 0;
+    m_sequenceFrames = 0;
+}
+
+void XFrame::Impl::frameDone() {
+    if (!m_frameListener) {
+        return;
+    }
+    m_sequenceFrames++;
+    m_frameListener->onFrameDone(m_sequenceFrames);
+}
+
+bool XFrame::Impl::averageFrame(XImage* image) {
+    if (m_temporalReset.exchange(false)) {
+        m_temporal.reset();
+    }
+    Internal::PerfScope perf(XFactory::PERF_FRAME_ASSEMBLY);
+    return m_temporal.add(reinterpret_cast<uint16_t*>(image->_data_));
+}
+
+// Sampled pixels below threshold, counting stops at limit
+template <typename T>
+static uint32_t countContent(const XImage* image, uint32_t step, uint32_t threshold, uint32_t limit) {
+    const uint8_t* base = image->_data_ + image->_data_offset;
+    uint32_t count = 0;
+    
+    for (uint32_t row = step / 2; row < image->_height && count < limit; row += step) {
+        count += rowContent<T>(base + static_cast<size_t>(row) * image->_stride, image->_width,
+                               step / 2, step, threshold);
+    }
+    return count;
+}
+
+bool XFrame::Impl::tagEmpty(const XImage* image) {
+    if (m_emptyThreshold == 0) {
+        return false;
+    }
+    
+    uint32_t content = 0;
+    {
+        Internal::PerfScope perf(XFactory::PERF_FRAME_ASSEMBLY);
+        if (m_pixelDepth <= 8) {
+            content = countContent<uint8_t>(image, m_emptyStep, m_emptyThreshold, m_emptyMinPixels);
+        } else if (m_pixelDepth <= 16) {
+            content = countContent<uint16_t>(image, m_emptyStep, m_emptyThreshold, m_emptyMinPixels);
+        } else {
+            content = countContent<uint32_t>(image, m_emptyStep, m_emptyThreshold, m_emptyMinPixels);
+        }
+    }
+    
+    const bool empty = content < m_emptyMinPixels;
+    if (empty) {
+        m_framesEmpty++;
+    }
+    
+    {
+        std::lock_guard<std::mutex> poolLock(m_poolMutex);
+        if (image == &m_windowView) {
+            m_windowEmpty = empty;
+        } else {
+            int index = poolIndex(image);
+            if (index >= 0) {
+                m_poolEmpty[index] = empty ? 1 : 0;
+            }
+        }
+    }
+    return empty && m_emptySkip;
+}
+
+void XFrame::Impl::stampInfo(XImage* image, uint64_t sequence, uint32_t missing, uint32_t firstLineId,
+                             const std::vector<XFrame::LineTime>& times, bool empty) {
+    XFrameInfo info;
+    info.sequence = sequence;
+    info.firstLineId = firstLineId;
+    info.missingLines = missing;
+    info.detectorId = m_detectorId;
+    
+    // Same as getFrameTime(): the first row that was received
+    const uint32_t rows = std::min(m_linesPerFrame, image->_height);
+    for (uint32_t row = 0; row < rows && row < times.size(); ++row) {
+        const XFrame::LineTime& t = times[row];
+        if (t.deviceUs || t.hostNs || t.receiveNs) {
+            info.deviceUs = t.deviceUs;
+            info.hostNs = t.hostNs ? t.hostNs : t.receiveNs;
+            break;
+        }
+    }
+    
+    if (missing > 0) {
+        info.flags |= XFrameInfo::FLAG_INCOMPLETE;
+    }
+    if (empty) {
+        info.flags |= XFrameInfo::FLAG_EMPTY;
+    }
+    if (m_dualEnergy) {
+        info.flags |= XFrameInfo::FLAG_DUAL_ENERGY;
+    }
+    if (m_temporalMode != XFrame::TEMPORAL_OFF) {
+        info.flags |= XFrameInfo::FLAG_AVERAGED;
+    }
+    if (m_frameTrigger) {
+        info.flags |= XFrameInfo::FLAG_TRIGGERED;
+    }
+    if (m_objectThreshold > 0) {
+        info.flags |= XFrameInfo::FLAG_OBJECT;
+    }
+    image->_info = info;
+}
+
+bool XFrame::Impl::isEmpty(const XImage* image) const {
+    std::lock_guard<std::mutex> poolLock(m_poolMutex);
+    
+    if (m_emptyThreshold == 0) {
+        return false;
+    }
+    if (image == &m_windowView) {
+        return m_windowEmpty;
+    }
+    int index = poolIndex(image);
+    return index >= 0 && m_poolEmpty[index] != 0;
+}
+
+void XFrame::Impl::recycle(XImage* image) {
+    if (m_objectThreshold > 0) {
+        image->_height = m_linesPerFrame;
+        image->_size = image->_stride * m_linesPerFrame;
+    }
+    if (m_clearPolicy == XFrame::CLEAR_FULL) {
+        image->Clear();
+    }
+}
+
+void XFrame::Impl::fillMissingRows(uint8_t* data) {
+    for (uint32_t word = 0; word < m_rowMask.size(); ++word) {
+        if (m_rowMask[word] == ~uint64_t(0)) {
+            continue;
+        }
+        
+        uint32_t end = std::min(m_linesPerFrame, (word + 1) * 64);
+        for (uint32_t row = word * 64; row < end; ++row) {
+            if (m_rowMask[word] & (uint64_t(1) << (row & 63))) {
+                continue;
+            }
+            
+            uint64_t segMask = m_rowSegMask[row];
+            if (segMask == 0 && !m_dualEnergy) {
+                memset(data + static_cast<size_t>(row) * m_lineBytes, 0, m_lineBytes);
+                continue;
+            }
+            
+            // Keep the module segments (or energy line) of a partial row that did arrive
+            for (uint32_t seg = 0; seg < m_rowSegments; ++seg) {
+                if (!(segMask & (uint64_t(1) << seg))) {
+                    memset(rowAddress(data, row, seg * m_segmentBytes), 0, m_segmentBytes);
+                }
+            }
+        }
+    }
+}
+
+int XFrame::Impl::poolIndex(const XImage* image) const {
+    if (image == &m_burstView) {
+        // Rows and times of a compressed burst are kept per frame
+        return m_burstViewIndex;
+    }
+    for (size_t i = 0; i < m_pool.size(); ++i) {
+        if (m_pool[i] == image) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+uint32_t XFrame::Impl::getMissingLines(const XImage* image, uint8_t* mask, uint32_t maskBytes) const {
+    std::lock_guard<std::mutex> poolLock(m_poolMutex);
+    
+    const std::vector<uint64_t>* source = nullptr;
+    if (image == &m_windowView) {
+        source = &m_windowMask;
+    } else {
+        int index = poolIndex(image);
+        if (index < 0) {
+            return 0;
+        }
+        source = &m_poolMasks[index];
+    }
+    
+    const std::vector<uint64_t>& received = *source;
+    uint32_t missing = 0;
+    
+    if (mask && maskBytes > 0) {
+        memset(mask, 0, maskBytes);
+    }
+    
+    // Object frames end at their last row
+    const uint32_t rows = std::min(m_linesPerFrame, image->_height);
+    for (uint32_t row = 0; row < rows; ++row) {
+        if (!(received[row >> 6] & (uint64_t(1) << (row & 63)))) {
+            missing++;
+            if (mask && (row >> 3) < maskBytes) {
+                mask[row >> 3] |= static_cast<uint8_t>(1u << (row & 7));
+            }
+        }
+    }
+    
+    return missing;
+}
+
+uint32_t XFrame::Impl::getLineTimes(const XImage* image, XFrame::LineTime* times, uint32_t count) const {
+    std::lock_guard<std::mutex> poolLock(m_poolMutex);
+    
+    const std::vector<XFrame::LineTime>* source = nullptr;
+    if (image == &m_windowView) {
+        source = &m_windowViewTimes;
+    } else {
+        int index = poolIndex(image);
+        if (index < 0) {
+            return 0;
+        }
+        source = &m_poolTimes[index];
+    }
+    if (!times) {
+        return 0;
+    }
+    
+    const uint32_t rows = std::min(std::min(m_linesPerFrame, image->_height), count);
+    std::copy(source->begin(), source->begin() + rows, times);
+    return rows;
+}
+
+bool XFrame::Impl::getFrameTime(const XImage* image, XFrame::LineTime& time) const {
+    std::lock_guard<std::mutex> poolLock(m_poolMutex);
+    
+    time = XFrame::LineTime();
+    const std::vector<XFrame::LineTime>* source = nullptr;
+    if (image == &m_windowView) {
+        source = &m_windowViewTimes;
+    } else {
+        int index = poolIndex(image);
+        if (index < 0) {
+            return false;
+        }
+        source = &m_poolTimes[index];
+    }
+    
+    const uint32_t rows = std::min(m_linesPerFrame, image->_height);
+    for (uint32_t row = 0; row < rows; ++row) {
+        const XFrame::LineTime& t = (*source)[row];
+        if (t.deviceUs || t.hostNs || t.receiveNs) {
+            time = t;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool XFrame::Impl::setPyramid(uint32_t levels) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    if (m_running) {
+        reportError(32, "Cannot change pyramid levels while running");
+        return false;
+    }
+    if (levels > Internal::FramePyramid::MAX_LEVELS) {
+        reportError(32, "Pyramid levels must be 0-3");
+        return false;
+    }
+    
+    m_pyramidLevels = levels;
+    return true;
+}
+
+const XImage* XFrame::Impl::getPyramidImage(const XImage* image, uint32_t level,
+                                            XFrame::PyramidStat stat) const {
+    std::lock_guard<std::mutex> poolLock(m_poolMutex);
+    
+    const int index = poolIndex(image);
+    if (index < 0 || static_cast<size_t>(index) >= m_poolPyramids.size()) {
+        return nullptr;
+    }
+    return m_poolPyramids[index].image(level, static_cast<Internal::FramePyramid::Stat>(stat));
+}
+
+bool XFrame::Impl::setReorderWindow(uint32_t lines) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    if (m_running) {
+        reportError(32, "Cannot change reorder window while running");
+        return false;
+    }
+    
+    m_reorderWindow = lines;
+    return true;
+}
+
+bool XFrame::Impl::setSegments(uint32_t count) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    if (m_running) {
+        reportError(32, "Cannot change segments while running");
+        return false;
+    }
+    
+    if (count == 0 || count > 64) {
+        reportError(32, "Invalid segment count");
+        return false;
+    }
+    
+    m_segments = count;
+    return true;
+}
+
+bool XFrame::Impl::setDualEnergy(bool enable) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    if (m_running) {
+        reportError(32, "Cannot change dual-energy mode while running");
+        return false;
+    }
+    
+    m_dualEnergy = enable;
+    return true;
+}
+
+bool XFrame::Impl::setFrameTrigger(bool enable) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    if (m_running) {
+        reportError(32, "Cannot change frame trigger while running");
+        return false;
+    }
+    
+    m_frameTrigger = enable;
+    return true;
+}
+
+void XFrame::Impl::trigger(uint32_t lineId) {
+    if (!m_frameTrigger) {
+        return;
+    }
+    LineLock lock(m_mutex, m_sharedLines);
+    
+    if (!m_running || !m_currentFrame || (m_triggerArmed && lineId == m_lineOrigin)) {
+        return;
+    }
+    
+    if (m_triggerArmed && m_currentLine > 0) {
+        // Triggered again before the frame filled: it ends here
+        assembleFrame();
+    }
+    
+    // Lines of the next frame were never stashed: they were untriggered
+    m_lineOrigin = lineId;
+    m_frameIndex = 0;
+    m_frameOpen = true;
+    m_triggerArmed = true;
+    m_lastLineTime = std::chrono::steady_clock::now();
+}
+
+bool XFrame::Impl::getEnergyPlanes(const XImage* image, const unsigned short** high,
+                                   const unsigned short** low) const {
+    if (!m_dualEnergy || !image || !image->_data_ || !high || !low ||
+        image->_pixel_depth <= 8 || image->_pixel_depth > 16 ||
+        image->_height != m_linesPerFrame * 2) {
+        return false;
+    }
+    
+    const uint8_t* base = image->_data_ + image->_data_offset;
+    *high = reinterpret_cast<const unsigned short*>(base);
+    *low = reinterpret_cast<const unsigned short*>(base + m_planeBytes);
+    return true;
+}
+
+bool XFrame::Impl::setEnergyAlignment(double lowOffset) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    if (m_running) {
+        reportError(32, "Cannot change energy alignment while running");
+        return false;
+    }
+    
+    if (!(std::fabs(lowOffset) <= Internal::RowAligner::MAX_OFFSET)) {
+        reportError(32, "Invalid energy alignment offset");
+        return false;
+    }
+    
+    m_energyOffset = lowOffset;
+    return true;
+}
+
+double XFrame::Impl::getEnergyAlignment() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_energyOffset;
+}
+
+bool XFrame::Impl::setStripLines(uint32_t lines) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    if (m_running) {
+        reportError(32, "Cannot change strip lines while running");
+        return false;
+    }
+    
+    m_stripLines = lines;
+    return true;
+}
+
+bool XFrame::Impl::setAllocator(XFactory* factory, const XFactory::AllocOptions& options) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    if (m_running) {
+        reportError(32, "Cannot change allocator while running");
+        return false;
+    }
+    
+    // Kept buffers go back to the factory they came from
+    freePool();
+    chargeMemory();
+    m_factory = factory;
+    m_allocOptions = options;
+    return true;
+}
+
+bool XFrame::Impl::setFrameBus(XFrameBus* bus) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    if (m_running) {
+        reportError(32, "Cannot change frame bus while running");
+        return false;
+    }
+    
+    m_bus = bus;
+    return true;
+}
+
+bool XFrame::Impl::setProducerThreads(uint32_t count) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    if (m_running) {
+        reportError(32, "Cannot change producer threads while running");
+        return false;
+    }
+    
+    if (count == 0) {
+        reportError(32, "Invalid producer thread count");
+        return false;
+    }
+    
+    m_producerThreads = count;
+    return true;
+}
+
+bool XFrame::Impl::setStride(uint32_t lines) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    if (m_running) {
+        reportError(32, "Cannot change stride while running");
+        return false;
+    }
+    
+    m_stride = lines;
+    return true;
+}
+
+bool XFrame::Impl::addLineFilter(IXLineFilter* filter) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    if (m_running) {
+        reportError(32, "Cannot change line filters while running");
+        return false;
+    }
+    
+    if (!filter) {
+        return false;
+    }
+    
+    m_filters.push_back(filter);
+    return true;
+}
+
+bool XFrame::Impl::clearLineFilters() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    if (m_running) {
+        reportError(32, "Cannot change line filters while running");
+        return false;
+    }
+    
+    m_filters.clear();
+    return true;
+}
+
+bool XFrame::Impl::setUnpack(XFrame::UnpackMode mode) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    if (m_running) {
+        reportError(32, "Cannot change unpack mode while running");
+        return false;
+    }
+    
+    m_unpack = mode;
+    return true;
+}
+
+bool XFrame::Impl::setROI(uint32_t firstColumn, uint32_t columns, uint32_t decimation) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    if (m_running) {
+        reportError(32, "Cannot change ROI while running");
+        return false;
+    }
+    
+    if (decimation == 0) {
+        reportError(32, "Invalid ROI decimation");
+        return false;
+    }
+    
+    m_roiFirst = columns ? firstColumn : 0;
+    m_roiColumns = columns;
+    m_roiStep = columns ? decimation : 1;
+    return true;
+}
+
+void XFrame::Impl::getROI(uint32_t* firstColumn, uint32_t* columns, uint32_t* decimation) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    if (firstColumn) {
+        *firstColumn = m_roiFirst;
+    }
+    if (columns) {
+        *columns = m_roiColumns;
+    }
+    if (decimation) {
+        *decimation = m_roiStep;
+    }
+}
+
+bool XFrame::Impl::setBinning(uint32_t columns, uint32_t lines, XFrame::BinMode mode) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    if (m_running) {
+        reportError(32, "Cannot change binning while running");
+        return false;
+    }
+    
+    if ((columns != 1 && columns != 2 && columns != 4) ||
+        lines == 0 || lines > Internal::LineBinner::MAX_LINES) {
+        reportError(32, "Invalid binning factors");
+        return false;
+    }
+    
+    m_binColumns = columns;
+    m_binLines = lines;
+    m_binMode = mode;
+    m_binning = (columns > 1 || lines > 1);
+    return true;
+}
+
+void XFrame::Impl::getBinning(uint32_t* columns, uint32_t* lines, XFrame::BinMode* mode) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    if (columns) {
+        *columns = m_binColumns;
+    }
+    if (lines) {
+        *lines = m_binLines;
+    }
+    if (mode) {
+        *mode = m_binMode;
+    }
+}
+
+bool XFrame::Impl::setScanResample(double pitch, double encoderRate) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    if (m_running) {
+        reportError(32, "Cannot change resampling while running");
+        return false;
+    }
+    
+    if (!(pitch >= 0.0) || !(encoderRate >= 0.0)) {
+        reportError(32, "Invalid resampling pitch or encoder rate");
+        return false;
+    }
+    
+    m_resamplePitch = pitch;
+    m_encoderRate.store(encoderRate, std::memory_order_relaxed);
+    return true;
+}
+
+double XFrame::Impl::getScanResample() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_resamplePitch;
+}
+
+bool XFrame::Impl::setTemporalAverage(XFrame::TemporalMode mode, uint32_t frames, bool everyFrame) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    if (m_running) {
+        reportError(32, "Cannot change temporal averaging while running");
+        return false;
+    }
+    
+    if (mode != XFrame::TEMPORAL_OFF &&
+        (frames < 2 || frames > Internal::TemporalFilter::MAX_FRAMES)) {
+        reportError(32, "Invalid temporal averaging frame count");
+        return false;
+    }
+    
+    m_temporalMode = mode;
+    m_temporalFrames = frames;
+    m_temporalEvery = everyFrame;
+    return true;
+}
+
+void XFrame::Impl::getTemporalAverage(XFrame::TemporalMode* mode, uint32_t* frames, bool* everyFrame) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    if (mode) {
+        *mode = m_temporalMode;
+    }
+    if (frames) {
+        *frames = m_temporalFrames;
+    }
+    if (everyFrame) {
+        *everyFrame = m_temporalEvery;
+    }
+}
+
+bool XFrame::Impl::setEmptyDetect(uint32_t threshold, uint32_t minPixels, uint32_t step, bool skip) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    if (m_running) {
+        reportError(32, "Cannot change empty-frame detection while running");
+        return false;
+    }
+    
+    if (minPixels == 0 || step == 0 || step > 256) {
+        reportError(32, "Invalid empty-frame detection settings");
+        return false;
+    }
+    
+    m_emptyThreshold = threshold;
+    m_emptyMinPixels = minPixels;
+    m_emptyStep = step;
+    m_emptySkip = skip;
+    return true;
+}
+
+void XFrame::Impl::getEmptyDetect(uint32_t* threshold, uint32_t* minPixels, uint32_t* step, bool* skip) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    if (threshold) {
+        *threshold = m_emptyThreshold;
+    }
+    if (minPixels) {
+        *minPixels = m_emptyMinPixels;
+    }
+    if (step) {
+        *step = m_emptyStep;
+    }
+    if (skip) {
+        *skip = m_emptySkip;
+    }
+}
+
+bool XFrame::Impl::setObjectFraming(uint32_t threshold, uint32_t minPixels,
+                                    uint32_t preLines, uint32_t postLines) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    if (m_running) {
+        reportError(32, "Cannot change object framing while running");
+        return false;
+    }
+    
+    if (minPixels == 0) {
+        reportError(32, "Invalid object framing settings");
+        return false;
+    }
+    
+    m_objectThreshold = threshold;
+    m_objectMinPixels = minPixels;
+    m_objectPre = preLines;
+    m_objectPost = postLines;
+    return true;
+}
+
+void XFrame::Impl::getObjectFraming(uint32_t* threshold, uint32_t* minPixels,
+                                    uint32_t* preLines, uint32_t* postLines) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    if (threshold) {
+        *threshold = m_objectThreshold;
+    }
+    if (minPixels) {
+        *minPixels = m_objectMinPixels;
+    }
+    if (preLines) {
+        *preLines = m_objectPre;
+    }
+    if (postLines) {
+        *postLines = m_objectPost;
+    }
+}
+
+void XFrame::Impl::freePool() {
+    std::lock_guard<std::mutex> poolLock(m_poolMutex);
+    
+    std::vector<uint8_t>().swap(m_burstData);
+    m_burstCount = 0;
+    m_packer.reset();
+    m_burstArena = nullptr;
+    std::vector<uint8_t>().swap(m_burstArenaData);
+    std::vector<XFrameInfo>().swap(m_burstInfo);
+    std::vector<uint8_t>().swap(m_burstViewData);
+    m_burstViewIndex = -1;
+    for (size_t i = 0; i < m_pool.size(); ++i) {
+        const uint32_t refs = (m_burstFrames == 0 && i < m_poolRefs.size()) ? m_poolRefs[i] : 0;
+        if (refs == 0) {
+            delete m_pool[i];
+            continue;
+        }
+        // Still valid until the sink returns it with Release()
+        HeldBuffer held = { m_pool[i], nullptr, m_factory, refs };
+        std::vector<uint8_t*>::iterator data = std::find(m_poolData.begin(), m_poolData.end(),
+                                                         m_pool[i]->_data_);
+        if (data != m_poolData.end()) {
+            held.data = *data;
+            m_poolData.erase(data);
+        }
+        m_heldBuffers.push_back(held);
+    }
+    for (size_t i = 0; i < m_poolData.size(); ++i) {
+        m_factory->Free(m_poolData[i]);
+    }
+    m_pool.clear();
+    m_poolData.clear();
+    m_freeList.clear();
+    m_poolMasks.clear();
+    m_poolTimes.clear();
+    m_poolPyramids.clear();
+    m_poolEmpty.clear();
+    m_poolRefs.clear();
+}
+
+bool XFrame::Impl::setPoolSize(uint32_t count) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    if (m_running) {
+        reportError(32, "Cannot change pool size while running");
+        return false;
+    }
+    
+    if (count == 0) {
+        reportError(32, "Invalid pool size");
+        return false;
+    }
+    
+    m_poolSize = count;
+    m_poolSizeSet = true;
+    return true;
+}
+
+uint32_t XFrame::Impl::getFreeBuffers() const {
+    std::lock_guard<std::mutex> poolLock(m_poolMutex);
+    return static_cast<uint32_t>(m_freeList.size());
+}
+
+void XFrame::Impl::collectMetrics(Internal::MetricsWriter& out) {
+    out.counter("hubx_frame_frames_total", "Frames handed to OnFrameReady",
+                m_metricLabels, m_framesDelivered);
+    out.counter("hubx_frame_frames_incomplete_total", "Frames emitted with missing rows",
+                m_metricLabels, m_framesIncomplete);
+    out.counter("hubx_frame_frames_dropped_total", "Frames dropped because the pool was exhausted",
+                m_metricLabels, m_framesDropped);
+    out.counter("hubx_frame_frames_shed_total", "Frames dropped by the overload policy",
+                m_metricLabels, m_framesShed);
+    if (!m_addedSinks.empty()) {
+        out.counter("hubx_frame_frames_sink_dropped_total", "Frames added sinks lost to their queue policy",
+                    m_metricLabels, m_sinkDrops);
+    }
+    if (m_sink) {
+        sinkMetrics(out, m_sinkTiming, "main");
+    }
+    if (m_rawSink) {
+        out.counter("hubx_frame_raw_dropped_total", "Raw frames dropped because the pool was exhausted",
+                    m_metricLabels, m_rawDropped);
+        sinkMetrics(out, m_rawTiming, "raw");
+    }
+    for (size_t i = 0; i < m_addedSinks.size(); ++i) {
+        sinkMetrics(out, m_addedSinks[i]->timing, "added" + std::to_string(i));
+    }
+    if (burstPacked()) {
+        XFrame::BurstStats burst;
+        getBurstStats(burst);
+        out.gauge("hubx_frame_burst_ratio", "Raw to packed size of the burst frames packed so far",
+                  m_metricLabels, burst.ratio);
+        out.gauge("hubx_frame_burst_backlog", "Burst frames waiting to be packed",
+                  m_metricLabels, burst.backlog);
+        out.counter("hubx_frame_burst_stalls_total", "Burst frames that waited for a staging buffer",
+                    m_metricLabels, burst.stalls);
+    }
+    if (m_emptyThreshold > 0) {
+        out.counter("hubx_frame_frames_empty_total", "Frames tagged as empty belt",
+                    m_metricLabels, m_framesEmpty);
+    }
+    out.counter("hubx_frame_lines_late_total", "Lines that arrived after their frame was emitted",
+                m_metricLabels, m_linesLate);
+    if (m_frameTrigger) {
+        out.counter("hubx_frame_lines_untriggered_total", "Lines dropped outside triggered frames",
+                    m_metricLabels, m_linesUntriggered);
+    }
+    if (m_poolSize > 1 && m_stride == 0) {
+        out.gauge("hubx_frame_pool_free", "Frame buffers not held by the sink",
+                  m_metricLabels, getFreeBuffers());
+        out.gauge("hubx_frame_pool_size", "Frame buffers in the pool", m_metricLabels, m_poolSize);
+    }
+}
+
+void XFrame::Impl::sinkMetrics(Internal::MetricsWriter& out, const SinkTiming& timing,
+                               const std::string& sink) {
+    XFactory::TraceStats stats;
+    timing.histogram.get(stats);
+    if (stats.count == 0) {
+        return;
+    }
+    static const double quantiles[] = { 0.5, 0.99, 0.999 };
+    const double values[] = { stats.p50Ns * 1e-9, stats.p99Ns * 1e-9, stats.p999Ns * 1e-9 };
+    Internal::MetricLabels labels = m_metricLabels;
+    labels.add("sink", sink);
+    out.summary("hubx_frame_sink_seconds", "Time spent in OnFrameReady", labels, quantiles, values, 3,
+                stats.count, static_cast<double>(stats.meanNs) * 1e-9 * stats.count);
+    if (m_watchdogLimitNs.load(std::memory_order_relaxed) > 0) {
+        out.counter("hubx_frame_sink_slow_total", "OnFrameReady calls over the sink watchdog limit",
+                    labels, timing.slow.load(std::memory_order_relaxed));
+    }
+}
+
+void XFrame::Impl::freeHeld(const HeldBuffer& held) {
+    if (held.data) {
+        held.factory->Free(held.data);
+    }
+    delete held.image;
+}
+
+bool XFrame::Impl::releaseHeld(XImage* image) {
+    for (size_t i = 0; i < m_heldBuffers.size(); ++i) {
+        if (m_heldBuffers[i].image != image) {
+            continue;
+        }
+        if (--m_heldBuffers[i].refs == 0) {
+            freeHeld(m_heldBuffers[i]);
+            m_heldBuffers.erase(m_heldBuffers.begin() + i);
+        }
+        return true;
+    }
+    return false;
+}
+
+void XFrame::Impl::release(XImage* image) {
+    if (!image) {
+        return;
+    }
+    
+    std::lock_guard<std::mutex> poolLock(m_poolMutex);
+    
+    // Held across Stop() or a pool change: freed, not reused
+    if (releaseHeld(image) || m_poolSize <= 1 || m_burstFrames > 0) {
+        return;
+    }
+    
+    // Ignore frames that are not ours or already returned
+    const int index = poolIndex(image);
+    if (index < 0 || m_poolRefs[index] == 0) {
+        return;
+    }
+    if (std::find(m_freeList.begin(), m_freeList.end(), image) != m_freeList.end()) {
+        return;
+    }
+    
+    // Free once the last sink holding it is done
+    if (--m_poolRefs[index] == 0) {
+        m_freeList.push_back(image);
+    }
+}
+
+bool XFrame::Impl::setBurst(uint32_t frames) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    if (m_running) {
+        reportError(32, "Cannot change burst while running");
+        return false;
+    }
+    
+    freePool();
+    chargeMemory();
+    m_burstFrames = frames;
+    return true;
+}
+
+XImage* XFrame::Impl::getBurstFrame(uint32_t index) const {
+    std::lock_guard<std::mutex> poolLock(m_poolMutex);
+    
+    if (burstPacked()) {
+        if (index >= m_packer.frames() || m_pool.empty()) {
+            return nullptr;
+        }
+        if (m_burstViewIndex != static_cast<int>(index)) {
+            const XImage* staging = m_pool[0];
+            if (m_burstViewData.empty()) {
+                m_burstViewData.assign(static_cast<size_t>(m_lineBytes) * m_linesPerFrame, 0);
+                m_burstView.SetData(m_burstViewData.data(), staging->_width, staging->_height,
+                                    staging->_pixel_depth, false);
+            }
+            m_burstViewIndex = -1;
+            if (!m_packer.decode(index, m_burstView._stride, m_burstViewData.data())) {
+                return nullptr;
+            }
+            m_burstView._info = m_burstInfo[index];
+            m_burstViewIndex = static_cast<int>(index);
+        }
+        return &m_burstView;
+    }
+    
+    if (m_burstFrames == 0 || index >= m_burstCount || index >= m_pool.size()) {
+        return nullptr;
+    }
+    return m_pool[index];
+}
+
+bool XFrame::Impl::setBurstCompression(uint64_t arenaBytes, uint32_t workers) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    if (m_running) {
+        reportError(32, "Cannot change burst compression while running");
+        return false;
+    }
+    if (workers == 0) {
+        reportError(32, "Burst compression needs a worker");
+        return false;
+    }
+    
+    freePool();
+    chargeMemory();
+    m_burstArenaBytes = arenaBytes;
+    m_burstWorkers = workers;
+    return true;
+}
+
+void XFrame::Impl::reportArenaFull() {
+    if (m_arenaFullReported) {
+        return;
+    }
+    m_arenaFullReported = true;
+    HX_LOG_INFO("XFrame") << "Burst arena full: " << m_packer.frames() << " frame(s) packed";
+    reportEvent(120, m_packer.frames());
+}
+
+bool XFrame::Impl::getBurstStats(XFrame::BurstStats& stats) const {
+    stats = XFrame::BurstStats();
+    if (!burstPacked()) {
+        return false;
+    }
+    
+    Internal::BurstPacker::Stats packed;
+    m_packer.stats(packed);
+    stats.framesCaptured = packed.submitted;
+    stats.framesPacked = packed.packed;
+    stats.backlog = packed.backlog;
+    stats.backlogPeak = packed.backlogPeak;
+    stats.rawBytes = packed.rawBytes;
+    stats.packedBytes = packed.packedBytes;
+    stats.arenaBytes = packed.arenaBytes;
+    stats.stalls = packed.stalls;
+    stats.ratio = packed.packedBytes > 0 ? static_cast<double>(packed.rawBytes) / packed.packedBytes : 0.0;
+    stats.arenaFull = packed.full;
+    stats.keepingUp = packed.stalls == 0;
+    return true;
+}
+
+void XFrame::Impl::releaseBurst() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    if (m_running || m_burstFrames == 0) {
+        return;
+    }
+    freePool();
+    chargeMemory();
+}
+
+void XFrame::Impl::reportError(uint32_t errorId, const char* message) {
+    HX_LOG_ID(::HX::XFactory::LOG_ERROR, "XFrame", errorId) << "ERROR " << errorId << ": " << message;
+    
+    m_notify.error(errorId, message);
+}
+
+void XFrame::Impl::reportEvent(uint32_t eventId, uint32_t data) {
+    m_notify.event(eventId, data);
+}
+
+bool XFrame::Impl::shedFrame() {
+    if (!Internal::OverloadShed(XFactory::OVERLOAD_FRAMES)) {
+        return false;
+    }
+    reportEvent(118, static_cast<uint32_t>(++m_framesShed));
+    return true;
+}
+
+// XFrame public interface
+XFrame::XFrame()
+    : m_impl(new Impl(1024))
+{
+}
+
+XFrame::XFrame(uint32_t lines)
+    : m_impl(new Impl(lines))
+{
+}
+
+XFrame::~XFrame() {
+    if (m_impl) {
+        delete m_impl;
+        m_impl = nullptr;
+    }
+}
+
+void XFrame::SetLines(uint32_t lines) {
+    if (m_impl) {
+        m_impl->setLines(lines);
+    }
+}
+
+uint32_t XFrame::GetLines() const {
+    if (!m_impl) {
+        return 0;
+    }
+    return m_impl->getLines();
+}
+
+void XFrame::SetSink(IXImgSink* sink_) {
+    if (m_impl) {
+        m_impl->setSink(sink_);
+    }
+}
+
+bool XFrame::SetRawSink(IXImgSink* sink_) {
+    if (!m_impl) {
+        return false;
+    }
+    return m_impl->setRawSink(sink_);
+}
+
+void XFrame::setFrameListener(Internal::FrameListener* listener, uint32_t frameLimit) {
+    if (m_impl) {
+        m_impl->setFrameListener(listener, frameLimit);
+    }
+}
+
+bool XFrame::Start(uint32_t width, uint8_t pixelDepth) {
+    if (!m_impl) {
+        return false;
+    }
+    return m_impl->start(width, pixelDepth);
+}
+
+bool XFrame::Prepare(uint32_t width, uint8_t pixelDepth) {
+    if (!m_impl) {
+        return false;
+    }
+    return m_impl->prepare(width, pixelDepth);
+}
+
+void XFrame::Stop() {
+    if (m_impl) {
+        m_impl->stop();
+        Internal::NotifyFlush();
+    }
+}
+
+bool XFrame::IsRunning() const {
+    if (!m_impl) {
+        return false;
+    }
+    return m_impl->isRunning();
+}
+
+void XFrame::AddLine(const uint8_t* lineData, uint32_t lineLen, uint32_t lineId) {
+    if (m_impl) {
+        m_impl->addLine(lineData, lineLen, lineId, nullptr, nullptr);
+    }
+}
+
+void XFrame::AddLine(const uint8_t* lineData, uint32_t lineLen, uint32_t lineId, uint32_t timestampUs) {
+    if (m_impl) {
+        m_impl->addLine(lineData, lineLen, lineId, &timestampUs, nullptr);
+    }
+}
+
+void XFrame::AddLine(const uint8_t* lineData, uint32_t lineLen, uint32_t lineId, const LineTime& time) {
+    if (m_impl) {
+        const uint32_t timestampUs = static_cast<uint32_t>(time.deviceUs);
+        m_impl->addLine(lineData, lineLen, lineId, time.deviceUs ? &timestampUs : nullptr, &time);
+    }
+}
+
+uint8_t* XFrame::GetLineBuffer(uint32_t lineId, uint32_t& lineLen) {
+    if (!m_impl) {
+        lineLen = 0;
+        return nullptr;
+    }
+    return m_impl->getLineBuffer(lineId, lineLen);
+}
+
+void XFrame::CommitLine(uint8_t* buffer, uint32_t lineLen, uint32_t lineId) {
+    if (m_impl) {
+        m_impl->commitLine(buffer, lineLen, lineId, nullptr, nullptr);
+    }
+}
+
+void XFrame::CommitLine(uint8_t* buffer, uint32_t lineLen, uint32_t lineId, uint32_t timestampUs) {
+    if (m_impl) {
+        m_impl->commitLine(buffer, lineLen, lineId, &timestampUs, nullptr);
+    }
+}
+
+void XFrame::CommitLine(uint8_t* buffer, uint32_t lineLen, uint32_t lineId, const LineTime& time) {
+    if (m_impl) {
+        const uint32_t timestampUs = static_cast<uint32_t>(time.deviceUs);
+        m_impl->commitLine(buffer, lineLen, lineId, time.deviceUs ? &timestampUs : nullptr, &time);
+    }
+}
+
+bool XFrame::SetPoolSize(uint32_t count) {
+    if (!m_impl) {
+        return false;
+    }
+    return m_impl->setPoolSize(count);
+}
+
+uint32_t XFrame::GetPoolSize() const {
+    if (!m_impl) {
+        return 0;
+    }
+    return m_impl->getPoolSize();
+}
+
+uint32_t XFrame::GetFreeBuffers() const {
+    if (!m_impl) {
+        return 0;
+    }
+    return m_impl->getFreeBuffers();
+}
+
+void XFrame::Release(XImage* image) {
+    if (m_impl) {
+        m_impl->release(image);
+    }
+}
+
+bool XFrame::AddSink(IXImgSink* sink_, uint32_t queueFrames, SinkPolicy policy) {
+    if (!m_impl) {
+        return false;
+    }
+    return m_impl->addSink(sink_, queueFrames, policy);
+}
+
+bool XFrame::RemoveSink(IXImgSink* sink_) {
+    if (!m_impl) {
+        return false;
+    }
+    return m_impl->removeSink(sink_);
+}
+
+uint64_t XFrame::GetSinkDropped(IXImgSink* sink_) const {
+    if (!m_impl) {
+        return 0;
+    }
+    return m_impl->getSinkDropped(sink_);
+}
+
+bool XFrame::SetSinkWatchdog(float fraction, uint32_t framePeriodUs) {
+    if (!m_impl) {
+        return false;
+    }
+    return m_impl->setSinkWatchdog(fraction, framePeriodUs);
+}
+
+bool XFrame::GetSinkLatency(IXImgSink* sink_, SinkLatency& latency) const {
+    if (!m_impl) {
+        return false;
+    }
+    return m_impl->getSinkLatency(sink_, latency);
+}
+
+bool XFrame::SetBurst(uint32_t frames) {
+    if (!m_impl) {
+        return false;
+    }
+    return m_impl->setBurst(frames);
+}
+
+uint32_t XFrame::GetBurst() const {
+    if (!m_impl) {
+        return 0;
+    }
+    return m_impl->getBurst();
+}
+
+bool XFrame::SetBurstCompression(uint64_t arenaBytes, uint32_t workers) {
+    if (!m_impl) {
+        return false;
+    }
+    return m_impl->setBurstCompression(arenaBytes, workers);
+}
+
+bool XFrame::GetBurstStats(BurstStats& stats) const {
+    if (!m_impl) {
+        stats = BurstStats();
+        return false;
+    }
+    return m_impl->getBurstStats(stats);
+}
+
+uint32_t XFrame::GetBurstFrames() const {
+    if (!m_impl) {
+        return 0;
+    }
+    return m_impl->getBurstFrames();
+}
+
+XImage* XFrame::GetBurstFrame(uint32_t index) const {
+    if (!m_impl) {
+        return nullptr;
+    }
+    return m_impl->getBurstFrame(index);
+}
+
+void XFrame::ReleaseBurst() {
+    if (m_impl) {
+        m_impl->releaseBurst();
+    }
+}
+
+bool XFrame::SetReorderWindow(uint32_t lines) {
+    if (!m_impl) {
+        return false;
+    }
+    return m_impl->setReorderWindow(lines);
+}
+
+uint32_t XFrame::GetReorderWindow() const {
+    if (!m_impl) {
+        return 0;
+    }
+    return m_impl->getReorderWindow();
+}
+
+void XFrame::SetFrameTimeout(uint32_t ms) {
+    if (m_impl) {
+        m_impl->setFrameTimeout(ms);
+    }
+}
+
+uint32_t XFrame::GetFrameTimeout() const {
+    if (!m_impl) {
+        return 0;
+    }
+    return m_impl->getFrameTimeout();
+}
+
+void XFrame::Poll() {
+    if (m_impl) {
+        m_impl->poll();
+    }
+}
+
+uint32_t XFrame::GetMissingLines(const XImage* image, uint8_t* mask, uint32_t maskBytes) const {
+    if (!m_impl) {
+        return 0;
+    }
+    return m_impl->getMissingLines(image, mask, maskBytes);
+}
+
+uint32_t XFrame::GetLineTimes(const XImage* image, LineTime* times, uint32_t count) const {
+    if (!m_impl) {
+        return 0;
+    }
+    return m_impl->getLineTimes(image, times, count);
+}
+
+bool XFrame::GetFrameTime(const XImage* image, LineTime& time) const {
     if (!m_impl) {
+        time = LineTime();
         return false;
     }
-    return m_impl->isRunning();
+    return m_impl->getFrameTime(image, time);
 }
 
-void XFrame::AddLine(const uint8_t* lineData, uint32_t lineLen, uint32_t lineId) {
+bool XFrame::SetPyramid(uint32_t levels) {
+    if (!m_impl) {
+        return false;
+    }
+    return m_impl->setPyramid(levels);
+}
+
+uint32_t XFrame::GetPyramid() const {
+    if (!m_impl) {
+        return 0;
+    }
+    return m_impl->getPyramid();
+}
+
+const XImage* XFrame::GetPyramid(const XImage* image, uint32_t level, PyramidStat stat) const {
+    if (!m_impl) {
+        return nullptr;
+    }
+    return m_impl->getPyramidImage(image, level, stat);
+}
+
+bool XFrame::SetSegments(uint32_t count) {
+    if (!m_impl) {
+        return false;
+    }
+    return m_impl->setSegments(count);
+}
+
+uint32_t XFrame::GetSegments() const {
+    if (!m_impl) {
+        return 0;
+    }
+    return m_impl->getSegments();
+}
+
+void XFrame::AddSegment(const uint8_t* data, uint32_t len, uint32_t lineId, uint32_t segment) {
+    if (m_impl) {
+        m_impl->addSegment(data, len, lineId, segment, nullptr);
+    }
+}
+
+void XFrame::AddSegment(const uint8_t* data, uint32_t len, uint32_t lineId, uint32_t segment,
+                        const LineTime& time) {
+    if (m_impl) {
+        m_impl->addSegment(data, len, lineId, segment, &time);
+    }
+}
+
+bool XFrame::SetDualEnergy(bool enable) {
+    if (!m_impl) {
+        return false;
+    }
+    return m_impl->setDualEnergy(enable);
+}
+
+bool XFrame::GetDualEnergy() const {
+    if (!m_impl) {
+        return false;
+    }
+    return m_impl->getDualEnergy();
+}
+
+void XFrame::AddEnergyLine(const uint8_t* data, uint32_t len, uint32_t lineId, uint8_t energyFlag) {
+    if (m_impl) {
+        m_impl->addEnergyLine(data, len, lineId, energyFlag, nullptr);
+    }
+}
+
+void XFrame::AddEnergyLine(const uint8_t* data, uint32_t len, uint32_t lineId, uint8_t energyFlag,
+                           const LineTime& time) {
+    if (m_impl) {
+        m_impl->addEnergyLine(data, len, lineId, energyFlag, &time);
+    }
+}
+
+bool XFrame::SetEnergyAlignment(double lowOffset) {
+    if (!m_impl) {
+        return false;
+    }
+    return m_impl->setEnergyAlignment(lowOffset);
+}
+
+double XFrame::GetEnergyAlignment() const {
+    if (!m_impl) {
+        return 0.0;
+    }
+    return m_impl->getEnergyAlignment();
+}
+
+bool XFrame::GetEnergyPlanes(const XImage* image, const unsigned short** high,
+                             const unsigned short** low) const {
+    if (!m_impl) {
+        return false;
+    }
+    return m_impl->getEnergyPlanes(image, high, low);
+}
+
+bool XFrame::SetStripLines(uint32_t lines) {
+    if (!m_impl) {
+        return false;
+    }
+    return m_impl->setStripLines(lines);
+}
+
+uint32_t XFrame::GetStripLines() const {
+    if (!m_impl) {
+        return 0;
+    }
+    return m_impl->getStripLines();
+}
+
+bool XFrame::SetStride(uint32_t lines) {
+    if (!m_impl) {
+        return false;
+    }
+    return m_impl->setStride(lines);
+}
+
+uint32_t XFrame::GetStride() const {
+    if (!m_impl) {
+        return 0;
+    }
+    return m_impl->getStride();
+}
+
+void XFrame::SetClearPolicy(ClearPolicy policy) {
+    if (m_impl) {
+        m_impl->setClearPolicy(policy);
+    }
+}
+
+XFrame::ClearPolicy XFrame::GetClearPolicy() const {
+    if (!m_impl) {
+        return CLEAR_FULL;
+    }
+    return m_impl->getClearPolicy();
+}
+
+bool XFrame::SetProducerThreads(uint32_t count) {
+    if (!m_impl) {
+        return false;
+    }
+    return m_impl->setProducerThreads(count);
+}
+
+uint32_t XFrame::GetProducerThreads() const {
+    if (!m_impl) {
+        return 0;
+    }
+    return m_impl->getProducerThreads();
+}
+
+bool XFrame::SetAllocator(XFactory* factory, const XFactory::AllocOptions& options) {
+    if (!m_impl) {
+        return false;
+    }
+    return m_impl->setAllocator(factory, options);
+}
+
+bool XFrame::SetFrameBus(XFrameBus* bus) {
+    if (!m_impl) {
+        return false;
+    }
+    return m_impl->setFrameBus(bus);
+}
+
+bool XFrame::AddLineFilter(IXLineFilter* filter) {
+    if (!m_impl) {
+        return false;
+    }
+    return m_impl->addLineFilter(filter);
+}
+
+bool XFrame::ClearLineFilters() {
+    if (!m_impl) {
+        return false;
+    }
+    return m_impl->clearLineFilters();
+}
+
+bool XFrame::SetUnpack(UnpackMode mode) {
+    if (!m_impl) {
+        return false;
+    }
+    return m_impl->setUnpack(mode);
+}
+
+XFrame::UnpackMode XFrame::GetUnpack() const {
+    if (!m_impl) {
+        return UNPACK_NONE;
+    }
+    return m_impl->getUnpack();
+}
+
+bool XFrame::SetROI(uint32_t firstColumn, uint32_t columns, uint32_t decimation) {
+    if (!m_impl) {
+        return false;
+    }
+    return m_impl->setROI(firstColumn, columns, decimation);
+}
+
+void XFrame::GetROI(uint32_t* firstColumn, uint32_t* columns, uint32_t* decimation) const {
+    if (!m_impl) {
+        return;
+    }
+    m_impl->getROI(firstColumn, columns, decimation);
+}
+
+bool XFrame::SetBinning(uint32_t columns, uint32_t lines, BinMode mode) {
+    if (!m_impl) {
+        return false;
+    }
+    return m_impl->setBinning(columns, lines, mode);
+}
+
+void XFrame::GetBinning(uint32_t* columns, uint32_t* lines, BinMode* mode) const {
+    if (!m_impl) {
+        return;
+    }
+    m_impl->getBinning(columns, lines, mode);
+}
+
+bool XFrame::SetScanResample(double pitch, double encoderRate) {
+    if (!m_impl) {
+        return false;
+    }
+    return m_impl->setScanResample(pitch, encoderRate);
+}
+
+double XFrame::GetScanResample() const {
+    if (!m_impl) {
+        return 0.0;
+    }
+    return m_impl->getScanResample();
+}
+
+void XFrame::SetEncoderRate(double rate) {
+    if (m_impl && rate >= 0.0) {
+        m_impl->setEncoderRate(rate);
+    }
+}
+
+double XFrame::GetEncoderRate() const {
+    if (!m_impl) {
+        return 0.0;
+    }
+    return m_impl->getEncoderRate();
+}
+
+bool XFrame::SetTemporalAverage(TemporalMode mode, uint32_t frames, bool everyFrame) {
+    if (!m_impl) {
+        return false;
+    }
+    return m_impl->setTemporalAverage(mode, frames, everyFrame);
+}
+
+void XFrame::GetTemporalAverage(TemporalMode* mode, uint32_t* frames, bool* everyFrame) const {
+    if (!m_impl) {
+        return;
+    }
+    m_impl->getTemporalAverage(mode, frames, everyFrame);
+}
+
+void XFrame::ResetTemporalAverage() {
+    if (m_impl) {
+        m_impl->resetTemporalAverage();
+    }
+}
+
+bool XFrame::SetEmptyDetect(uint32_t threshold, uint32_t minPixels, uint32_t step, bool skip) {
+    if (!m_impl) {
+        return false;
+    }
+    return m_impl->setEmptyDetect(threshold, minPixels, step, skip);
+}
+
+void XFrame::GetEmptyDetect(uint32_t* threshold, uint32_t* minPixels, uint32_t* step, bool* skip) const {
+    if (!m_impl) {
+        return;
+    }
+    m_impl->getEmptyDetect(threshold, minPixels, step, skip);
+}
+
+bool XFrame::IsEmpty(const XImage* image) const {
+    if (!m_impl) {
+        return false;
+    }
+    return m_impl->isEmpty(image);
+}
+
+bool XFrame::SetObjectFraming(uint32_t threshold, uint32_t minPixels, uint32_t preLines, uint32_t postLines) {
+    if (!m_impl) {
+        return false;
+    }
+    return m_impl->setObjectFraming(threshold, minPixels, preLines, postLines);
+}
+
+void XFrame::GetObjectFraming(uint32_t* threshold, uint32_t* minPixels,
+                              uint32_t* preLines, uint32_t* postLines) const {
+    if (!m_impl) {
+        return;
+    }
+    m_impl->getObjectFraming(threshold, minPixels, preLines, postLines);
+}
+
+bool XFrame::SetFrameTrigger(bool enable) {
+    if (!m_impl) {
+        return false;
+    }
+    return m_impl->setFrameTrigger(enable);
+}
+
+bool XFrame::GetFrameTrigger() const {
+    if (!m_impl) {
+        return false;
+    }
+    return m_impl->getFrameTrigger();
+}
+
+void XFrame::Trigger(uint32_t lineId) {
+    if (m_impl) {
+        m_impl->trigger(lineId);
+    }
+}
+
+uint64_t XFrame::GetUntriggeredLines() const {
+    if (!m_impl) {
+        return 0;
+    }
+    return m_impl->getUntriggeredLines();
+}
+
+void XFrame::SetDetectorId(uint32_t id) {
     if (m_impl) {
-        m_impl->addLine(lineData, lineLen, lineId);
+        m_impl->setDetectorId(id);
+    }
+}
+
+uint32_t XFrame::GetDetectorId() const {
+    if (!m_impl) {
+        return 0;
     }
+    return m_impl->getDetectorId();
 }
 
-} // namespace HX
\ No newline at end of file
+} // namespace HX
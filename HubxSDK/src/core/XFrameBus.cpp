@@ -0,0 +1,857 @@
+// ============================================================================
+// XFrameBus.cpp - Shared-memory frame ring
+// ============================================================================
+
+/**
+ * @file XFrameBus.cpp
+ * @brief XFrameBus implementation - named segment, sequence cursors
+ * @version 2.1.0
+ */
+
+#include "XFrameBus.h"
+#include "XImage.h"
+#include "iximg_sink.h"
+#include "utils/logger.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstddef>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#endif
+
+namespace HX {
+
+namespace {
+
+const char BUS_MAGIC[8] = { 'H', 'X', 'F', 'R', 'B', 'U', 'S', '\0' };
+const uint32_t BUS_VERSION = 1;
+const uint32_t BUS_PAGE = 4096;
+const uint32_t MAX_SLOTS = 1024;
+
+/*
+ * Every field is naturally aligned and the fields written while frames
+ * flow are accessed in place as atomics, so the layout needs no packing.
+ */
+struct BusHeader {
+    char     magic[8];
+    uint32_t version;
+    uint32_t headerSize;        ///< Offset of slot 0
+    uint32_t width;
+    uint32_t height;
+    uint32_t pixelDepth;
+    uint32_t slotCount;
+    uint64_t slotBytes;         ///< SlotHeader + pixels, page aligned
+    uint32_t tableSize;         ///< Publication entries
+    uint32_t publisherPid;
+    uint64_t latest;            ///< Sequence of the newest frame (atomic)
+    uint32_t wake;              ///< Bumped per frame, futex word (atomic)
+    uint32_t waiters;           ///< Readers blocked in Next() (atomic)
+    uint32_t closed;            ///< Set by the publisher's Close() (atomic)
+    uint32_t reserved[7];
+};
+
+struct SubscriberEntry {
+    uint32_t pid;               ///< 0 = free (atomic)
+    uint32_t reserved;
+    uint64_t cursor;            ///< Last sequence taken (atomic)
+    uint64_t lost;              ///< Frames skipped (atomic)
+};
+
+struct Publication {
+    uint64_t seq;               ///< 0 while being written (atomic)
+    uint32_t slot;
+    uint32_t reserved;
+};
+
+struct SlotHeader {
+    uint64_t seq;               ///< Sequence published into the slot, 0 while reused (atomic)
+    uint64_t timeUs;
+    uint32_t width;
+    uint32_t height;
+    uint32_t pixelDepth;
+    uint32_t missingLines;
+    uint32_t empty;
+    uint8_t  reserved[28];
+};
+
+static_assert(sizeof(BusHeader) == 96, "bus header layout");
+static_assert(sizeof(SubscriberEntry) == 24, "subscriber layout");
+static_assert(sizeof(SlotHeader) == 64, "slot header keeps pixels 64-byte aligned");
+static_assert(sizeof(std::atomic<uint64_t>) == sizeof(uint64_t) &&
+              sizeof(std::atomic<uint32_t>) == sizeof(uint32_t),
+              "shared fields are accessed in place");
+
+template <typename T>
+inline std::atomic<T>* shared(T& field) {
+    return reinterpret_cast<std::atomic<T>*>(&field);
+}
+
+template <typename T>
+inline const std::atomic<T>* shared(const T& field) {
+    return reinterpret_cast<const std::atomic<T>*>(&field);
+}
+
+uint64_t nowUs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+}
+
+uint32_t currentPid() {
+#ifdef _WIN32
+    return static_cast<uint32_t>(GetCurrentProcessId());
+#else
+    return static_cast<uint32_t>(getpid());
+#endif
+}
+
+/// A subscriber whose process is gone keeps its entry until someone reclaims it
+bool processGone(uint32_t pid) {
+#ifdef _WIN32
+    HANDLE process = OpenProcess(SYNCHRONIZE, FALSE, pid);
+    if (!process) {
+        return GetLastError() == ERROR_INVALID_PARAMETER;
+    }
+    const bool gone = WaitForSingleObject(process, 0) == WAIT_OBJECT_0;
+    CloseHandle(process);
+    return gone;
+#else
+    return kill(static_cast<pid_t>(pid), 0) != 0 && errno == ESRCH;
+#endif
+}
+
+void waitFor(std::atomic<uint32_t>* word, uint32_t seen, uint32_t ms) {
+#ifdef __linux__
+    // Shared futex: the word lives in the segment, not in this process
+    struct timespec timeout;
+    timeout.tv_sec = ms / 1000;
+    timeout.tv_nsec = static_cast<long>(ms % 1000) * 1000000L;
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAIT, seen, &timeout, nullptr, 0);
+#else
+    (void)seen;
+    (void)word;
+    std::this_thread::sleep_for(std::chrono::milliseconds(std::min<uint32_t>(ms, 1)));
+#endif
+}
+
+void wakeAll(std::atomic<uint32_t>* word) {
+#ifdef __linux__
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+#else
+    (void)word;
+#endif
+}
+
+/**
+ * @brief Named shared-memory segment
+ */
+class BusMapping {
+public:
+    BusMapping()
+        : m_base(nullptr)
+        , m_size(0)
+#ifdef _WIN32
+        , m_mapping(nullptr)
+#endif
+    {
+    }
+
+    ~BusMapping() {
+        unmap();
+    }
+
+    bool create(const std::string& name, uint64_t size) {
+        unmap();
+#ifdef _WIN32
+        m_mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+                                       static_cast<DWORD>(size >> 32),
+                                       static_cast<DWORD>(size & 0xFFFFFFFFu), objectName(name).c_str());
+        if (m_mapping && GetLastError() == ERROR_ALREADY_EXISTS) {
+            // Sections cannot be replaced while mapped: the old one is still in use
+            unmap();
+            return false;
+        }
+        if (m_mapping) {
+            m_base = static_cast<uint8_t*>(MapViewOfFile(m_mapping, FILE_MAP_ALL_ACCESS, 0, 0, 0));
+        }
+#else
+        const std::string object = objectName(name);
+        retire(object);
+        int fd = shm_open(object.c_str(), O_RDWR | O_CREAT | O_EXCL, 0660);
+        if (fd < 0) {
+            return false;
+        }
+        if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+            ::close(fd);
+            shm_unlink(object.c_str());
+            return false;
+        }
+        void* p = mmap(nullptr, static_cast<size_t>(size), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ::close(fd);
+        m_base = (p == MAP_FAILED) ? nullptr : static_cast<uint8_t*>(p);
+        if (!m_base) {
+            shm_unlink(object.c_str());
+        }
+        m_object = object;
+#endif
+        if (!m_base) {
+            unmap();
+            return false;
+        }
+        m_size = size;
+        return true;
+    }
+
+    bool open(const std::string& name) {
+        unmap();
+#ifdef _WIN32
+        m_mapping = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, objectName(name).c_str());
+        if (m_mapping) {
+            m_base = static_cast<uint8_t*>(MapViewOfFile(m_mapping, FILE_MAP_ALL_ACCESS, 0, 0, 0));
+        }
+        MEMORY_BASIC_INFORMATION info;
+        if (m_base && VirtualQuery(m_base, &info, sizeof(info)) == sizeof(info)) {
+            m_size = info.RegionSize;
+        }
+#else
+        int fd = shm_open(objectName(name).c_str(), O_RDWR, 0);
+        struct stat st;
+        if (fd < 0 || fstat(fd, &st) != 0 || st.st_size <= 0) {
+            if (fd >= 0) {
+                ::close(fd);
+            }
+            return false;
+        }
+        void* p = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ | PROT_WRITE,
+                       MAP_SHARED, fd, 0);
+        ::close(fd);
+        m_base = (p == MAP_FAILED) ? nullptr : static_cast<uint8_t*>(p);
+        m_size = static_cast<uint64_t>(st.st_size);
+#endif
+        if (!m_base) {
+            unmap();
+            return false;
+        }
+        return true;
+    }
+
+    /// Remove the name; mappings already made stay valid
+    void unlink() {
+#ifndef _WIN32
+        if (!m_object.empty()) {
+            shm_unlink(m_object.c_str());
+            m_object.clear();
+        }
+#endif
+    }
+
+    void unmap() {
+#ifdef _WIN32
+        if (m_base) {
+            UnmapViewOfFile(m_base);
+        }
+        if (m_mapping) {
+            CloseHandle(m_mapping);
+            m_mapping = nullptr;
+        }
+#else
+        if (m_base) {
+            munmap(m_base, static_cast<size_t>(m_size));
+        }
+#endif
+        m_base = nullptr;
+        m_size = 0;
+    }
+
+    uint8_t* data() const { return m_base; }
+    uint64_t size() const { return m_size; }
+
+private:
+    static std::string objectName(const std::string& name) {
+#ifdef _WIN32
+        return "Local\\hubx." + name;
+#else
+        return "/hubx." + name;
+#endif
+    }
+
+#ifndef _WIN32
+    /// Tell readers of a segment left by an earlier publisher that it is gone
+    static void retire(const std::string& object) {
+        int fd = shm_open(object.c_str(), O_RDWR, 0);
+        if (fd < 0) {
+            return;
+        }
+        struct stat st;
+        if (fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) >= sizeof(BusHeader)) {
+            void* p = mmap(nullptr, sizeof(BusHeader), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            if (p != MAP_FAILED) {
+                BusHeader* header = static_cast<BusHeader*>(p);
+                if (std::memcmp(header->magic, BUS_MAGIC, sizeof(header->magic)) == 0) {
+                    shared(header->closed)->store(1, std::memory_order_release);
+                    shared(header->wake)->fetch_add(1, std::memory_order_release);
+                    wakeAll(shared(header->wake));
+                }
+                munmap(p, sizeof(BusHeader));
+            }
+        }
+        ::close(fd);
+        shm_unlink(object.c_str());
+    }
+#endif
+
+    uint8_t* m_base;
+    uint64_t m_size;
+#ifdef _WIN32
+    HANDLE m_mapping;
+#else
+    std::string m_object;
+#endif
+};
+
+} // namespace
+
+class XFrameBus::Impl {
+public:
+    Impl();
+    ~Impl();
+
+    void setSink(IXImgSink* sink) { m_sink = sink; }
+    bool create(const std::string& name, uint32_t width, uint32_t height,
+                uint8_t pixelDepth, uint32_t slots);
+    bool subscribe(const std::string& name);
+    void close();
+    bool isOpen() const { return m_header != nullptr; }
+    uint32_t getSlots() const { return m_header ? m_header->slotCount : 0; }
+
+    bool next(XFrameBus::Frame& frame, uint32_t timeoutMs);
+    bool isValid(const XFrameBus::Frame& frame) const;
+    bool isClosed() const;
+    uint64_t getLost() const { return m_lost; }
+    uint32_t getSubscribers(XFrameBus::SubscriberInfo* info, uint32_t max) const;
+
+    bool publish(const XImage* image);
+    uint8_t* slotData(uint32_t slot) const;
+    uint64_t slotBytes() const;
+    void retireSlot(uint32_t slot);
+    void publishSlot(uint32_t slot, uint32_t width, uint32_t height, uint8_t pixelDepth,
+                     uint32_t missingLines, bool empty);
+
+private:
+    bool attach(uint8_t* base, uint64_t size);
+    bool take(uint64_t sequence, XFrameBus::Frame& frame) const;
+    SlotHeader* slot(uint32_t index) const {
+        return reinterpret_cast<SlotHeader*>(m_slots + static_cast<size_t>(index) * m_header->slotBytes);
+    }
+    void reportError(uint32_t errorId, const std::string& message);
+
+    IXImgSink* m_sink;
+    BusMapping m_mapping;
+    bool m_publisher;
+
+    // Views into the mapping, fixed while open
+    BusHeader* m_header;
+    SubscriberEntry* m_subscribers;
+    Publication* m_table;
+    uint8_t* m_slots;
+
+    // Publisher
+    uint64_t m_published;
+    uint32_t m_nextSlot;                ///< Publish() copies round-robin
+    std::vector<uint32_t> m_slowPid;    ///< Subscriber already reported behind
+
+    // Subscriber
+    SubscriberEntry* m_entry;
+    uint64_t m_cursor;
+    uint64_t m_lost;
+};
+
+XFrameBus::Impl::Impl()
+    : m_sink(nullptr)
+    , m_publisher(false)
+    , m_header(nullptr)
+    , m_subscribers(nullptr)
+    , m_table(nullptr)
+    , m_slots(nullptr)
+    , m_published(0)
+    , m_nextSlot(0)
+    , m_entry(nullptr)
+    , m_cursor(0)
+    , m_lost(0)
+{
+}
+
+XFrameBus::Impl::~Impl() {
+    close();
+}
+
+bool XFrameBus::Impl::attach(uint8_t* base, uint64_t size) {
+    BusHeader* header = reinterpret_cast<BusHeader*>(base);
+    if (size < sizeof(BusHeader) ||
+        std::memcmp(header->magic, BUS_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version < 1 || header->version > BUS_VERSION ||
+        header->slotCount < 2 || header->slotCount > MAX_SLOTS ||
+        header->tableSize < header->slotCount ||
+        header->headerSize < sizeof(BusHeader) + MAX_SUBSCRIBERS * sizeof(SubscriberEntry) +
+                             static_cast<uint64_t>(header->tableSize) * sizeof(Publication) ||
+        header->slotBytes < sizeof(SlotHeader) ||
+        header->headerSize + header->slotCount * header->slotBytes > size) {
+        return false;
+    }
+    m_header = header;
+    m_subscribers = reinterpret_cast<SubscriberEntry*>(base + sizeof(BusHeader));
+    m_table = reinterpret_cast<Publication*>(m_subscribers + MAX_SUBSCRIBERS);
+    m_slots = base + header->headerSize;
+    return true;
+}
+
+bool XFrameBus::Impl::create(const std::string& name, uint32_t width, uint32_t height,
+                             uint8_t pixelDepth, uint32_t slots) {
+    close();
+
+    if (name.empty() || name.find_first_of("/\\") != std::string::npos ||
+        width == 0 || height == 0 || pixelDepth == 0 || pixelDepth > 32 ||
+        slots < 2 || slots > MAX_SLOTS) {
+        reportError(47, "Invalid frame bus geometry");
+        return false;
+    }
+
+    // Twice as many publications as slots: a lapped reader finds its
+    // entry rewritten rather than pointing at a reused slot
+    const uint32_t tableSize = slots * 2;
+    const uint64_t tables = sizeof(BusHeader) + MAX_SUBSCRIBERS * sizeof(SubscriberEntry) +
+                            static_cast<uint64_t>(tableSize) * sizeof(Publication);
+    const uint64_t headerSize = (tables + BUS_PAGE - 1) / BUS_PAGE * BUS_PAGE;
+    const uint64_t pixels = static_cast<uint64_t>(width) * ((pixelDepth + 7) / 8) * height;
+    const uint64_t slotBytes = (sizeof(SlotHeader) + pixels + BUS_PAGE - 1) / BUS_PAGE * BUS_PAGE;
+    const uint64_t size = headerSize + slotBytes * slots;
+
+    if (!m_mapping.create(name, size)) {
+        reportError(47, "Cannot create frame bus " + name);
+        return false;
+    }
+
+    // The segment starts zeroed: no subscribers, no publications
+    BusHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, BUS_MAGIC, sizeof(header.magic));
+    header.version = BUS_VERSION;
+    header.headerSize = static_cast<uint32_t>(headerSize);
+    header.width = width;
+    header.height = height;
+    header.pixelDepth = pixelDepth;
+    header.slotCount = slots;
+    header.slotBytes = slotBytes;
+    header.tableSize = tableSize;
+    header.publisherPid = currentPid();
+    std::memcpy(m_mapping.data(), &header, sizeof(header));
+    attach(m_mapping.data(), size);
+
+    m_publisher = true;
+    m_published = 0;
+    m_nextSlot = 0;
+    m_slowPid.assign(MAX_SUBSCRIBERS, 0);
+
+    HX_LOG_INFO("XFrameBus") << "Created " << name << ": " << slots << " slots of "
+                             << width << "x" << height << " @ " << static_cast<int>(pixelDepth)
+                             << " bits (" << (size >> 20) << " MB)";
+    return true;
+}
+
+bool XFrameBus::Impl::subscribe(const std::string& name) {
+    close();
+
+    if (!m_mapping.open(name) || !attach(m_mapping.data(), m_mapping.size())) {
+        m_mapping.unmap();
+        m_header = nullptr;
+        reportError(48, "No frame bus " + name);
+        return false;
+    }
+
+    // Claim a free entry, or one whose process has exited
+    const uint32_t pid = currentPid();
+    for (uint32_t i = 0; i < MAX_SUBSCRIBERS && !m_entry; ++i) {
+        std::atomic<uint32_t>* owner = shared(m_subscribers[i].pid);
+        uint32_t current = owner->load(std::memory_order_relaxed);
+        if (current != 0 && !processGone(current)) {
+            continue;
+        }
+        if (owner->compare_exchange_strong(current, pid, std::memory_order_acq_rel)) {
+            m_entry = &m_subscribers[i];
+        }
+    }
+    if (!m_entry) {
+        close();
+        reportError(48, "Frame bus " + name + " has no free subscriber slot");
+        return false;
+    }
+
+    m_cursor = shared(m_header->latest)->load(std::memory_order_acquire);
+    m_lost = 0;
+    shared(m_entry->cursor)->store(m_cursor, std::memory_order_relaxed);
+    shared(m_entry->lost)->store(0, std::memory_order_relaxed);
+    return true;
+}
+
+void XFrameBus::Impl::close() {
+    if (m_header) {
+        if (m_publisher) {
+            shared(m_header->closed)->store(1, std::memory_order_release);
+            shared(m_header->wake)->fetch_add(1, std::memory_order_release);
+            wakeAll(shared(m_header->wake));
+            m_mapping.unlink();
+        } else if (m_entry) {
+            shared(m_entry->pid)->store(0, std::memory_order_release);
+        }
+    }
+    m_mapping.unmap();
+    m_header = nullptr;
+    m_subscribers = nullptr;
+    m_table = nullptr;
+    m_slots = nullptr;
+    m_entry = nullptr;
+    m_publisher = false;
+}
+
+bool XFrameBus::Impl::isClosed() const {
+    return !m_header || shared(m_header->closed)->load(std::memory_order_acquire) != 0;
+}
+
+bool XFrameBus::Impl::take(uint64_t sequence, XFrameBus::Frame& frame) const {
+    // Seqlock reads: an entry or slot rewritten meanwhile fails the second check
+    const Publication& pub = m_table[(sequence - 1) % m_header->tableSize];
+    if (shared(pub.seq)->load(std::memory_order_acquire) != sequence) {
+        return false;
+    }
+    const uint32_t index = pub.slot;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (shared(pub.seq)->load(std::memory_order_relaxed) != sequence || index >= m_header->slotCount) {
+        return false;
+    }
+
+    const SlotHeader* s = slot(index);
+    if (shared(s->seq)->load(std::memory_order_acquire) != sequence) {
+        return false;
+    }
+    frame.data = reinterpret_cast<const uint8_t*>(s) + sizeof(SlotHeader);
+    frame.width = s->width;
+    frame.height = s->height;
+    frame.pixelDepth = static_cast<uint8_t>(s->pixelDepth);
+    frame.sequence = sequence;
+    frame.timeUs = s->timeUs;
+    frame.missingLines = s->missingLines;
+    frame.empty = s->empty != 0;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return shared(s->seq)->load(std::memory_order_relaxed) == sequence;
+}
+
+bool XFrameBus::Impl::next(XFrameBus::Frame& frame, uint32_t timeoutMs) {
+    if (!m_header || m_publisher) {
+        return false;
+    }
+
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    std::atomic<uint32_t>* wake = shared(m_header->wake);
+
+    for (;;) {
+        const uint32_t seen = wake->load(std::memory_order_acquire);
+        if (shared(m_header->closed)->load(std::memory_order_acquire)) {
+            return false;
+        }
+
+        const uint64_t latest = shared(m_header->latest)->load(std::memory_order_acquire);
+        if (latest > m_cursor) {
+            // One slot is always being assembled: older frames are gone
+            uint64_t want = m_cursor + 1;
+            const uint64_t oldest = (latest >= m_header->slotCount - 1) ? latest - m_header->slotCount + 2 : 1;
+            if (want < oldest) {
+                m_lost += oldest - want;
+                want = oldest;
+            }
+            for (; want <= latest; ++want) {
+                if (take(want, frame)) {
+                    break;
+                }
+                m_lost++;
+            }
+            m_cursor = std::min(want, latest);
+            shared(m_entry->cursor)->store(m_cursor, std::memory_order_release);
+            shared(m_entry->lost)->store(m_lost, std::memory_order_relaxed);
+            if (want <= latest) {
+                return true;
+            }
+            continue;
+        }
+
+        const auto now = std::chrono::steady_clock::now();
+        if (now >= deadline) {
+            return false;
+        }
+        const uint32_t left = static_cast<uint32_t>(std::max<int64_t>(1,
+            std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now).count()));
+
+        std::atomic<uint32_t>* waiters = shared(m_header->waiters);
+        waiters->fetch_add(1, std::memory_order_acq_rel);
+        if (shared(m_header->latest)->load(std::memory_order_acquire) == latest) {
+            waitFor(wake, seen, left);
+        }
+        waiters->fetch_sub(1, std::memory_order_acq_rel);
+    }
+}
+
+bool XFrameBus::Impl::isValid(const XFrameBus::Frame& frame) const {
+    if (!m_header || !frame.data || frame.data < m_slots) {
+        return false;
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const size_t index = static_cast<size_t>(frame.data - m_slots) / m_header->slotBytes;
+    return index < m_header->slotCount &&
+           shared(slot(static_cast<uint32_t>(index))->seq)->load(std::memory_order_relaxed) == frame.sequence;
+}
+
+uint32_t XFrameBus::Impl::getSubscribers(XFrameBus::SubscriberInfo* info, uint32_t max) const {
+    if (!m_header) {
+        return 0;
+    }
+    const uint64_t latest = shared(m_header->latest)->load(std::memory_order_acquire);
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < MAX_SUBSCRIBERS; ++i) {
+        const uint32_t pid = shared(m_subscribers[i].pid)->load(std::memory_order_acquire);
+        if (pid == 0) {
+            continue;
+        }
+        if (info && count < max) {
+            XFrameBus::SubscriberInfo& entry = info[count];
+            entry.index = i;
+            entry.pid = pid;
+            entry.cursor = shared(m_subscribers[i].cursor)->load(std::memory_order_relaxed);
+            entry.lag = (latest > entry.cursor) ? latest - entry.cursor : 0;
+            entry.lost = shared(m_subscribers[i].lost)->load(std::memory_order_relaxed);
+        }
+        count++;
+    }
+    return count;
+}
+
+uint8_t* XFrameBus::Impl::slotData(uint32_t index) const {
+    if (!m_publisher || index >= m_header->slotCount) {
+        return nullptr;
+    }
+    return reinterpret_cast<uint8_t*>(slot(index)) + sizeof(SlotHeader);
+}
+
+uint64_t XFrameBus::Impl::slotBytes() const {
+    return m_header ? m_header->slotBytes - sizeof(SlotHeader) : 0;
+}
+
+void XFrameBus::Impl::retireSlot(uint32_t index) {
+    if (!m_publisher || index >= m_header->slotCount) {
+        return;
+    }
+    std::atomic<uint64_t>* seq = shared(slot(index)->seq);
+    const uint64_t old = seq->load(std::memory_order_relaxed);
+    seq->store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    if (old == 0) {
+        return;
+    }
+
+    // Subscribers that never took this frame have fallen a ring behind
+    for (uint32_t i = 0; i < MAX_SUBSCRIBERS; ++i) {
+        const uint32_t pid = shared(m_subscribers[i].pid)->load(std::memory_order_acquire);
+        if (pid == 0 || shared(m_subscribers[i].cursor)->load(std::memory_order_relaxed) >= old) {
+            continue;
+        }
+        if (m_slowPid[i] != pid) {
+            m_slowPid[i] = pid;
+            HX_LOG_WARNING("XFrameBus") << "Subscriber " << i << " (pid " << pid << ") is falling behind";
+            if (m_sink) {
+                m_sink->OnXEvent(117, i);
+            }
+        }
+    }
+}
+
+void XFrameBus::Impl::publishSlot(uint32_t index, uint32_t width, uint32_t height, uint8_t pixelDepth,
+                                  uint32_t missingLines, bool empty) {
+    if (!m_publisher || index >= m_header->slotCount) {
+        return;
+    }
+    const uint64_t sequence = ++m_published;
+
+    SlotHeader* s = slot(index);
+    s->timeUs = nowUs();
+    s->width = width;
+    s->height = height;
+    s->pixelDepth = pixelDepth;
+    s->missingLines = missingLines;
+    s->empty = empty ? 1 : 0;
+    shared(s->seq)->store(sequence, std::memory_order_release);
+
+    Publication& pub = m_table[(sequence - 1) % m_header->tableSize];
+    shared(pub.seq)->store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    pub.slot = index;
+    shared(pub.seq)->store(sequence, std::memory_order_release);
+
+    shared(m_header->latest)->store(sequence, std::memory_order_release);
+    shared(m_header->wake)->fetch_add(1, std::memory_order_release);
+    if (shared(m_header->waiters)->load(std::memory_order_acquire) > 0) {
+        wakeAll(shared(m_header->wake));
+    }
+
+    // A subscriber that caught up may be reported again later
+    for (uint32_t i = 0; i < MAX_SUBSCRIBERS; ++i) {
+        if (m_slowPid[i] != 0 &&
+            shared(m_subscribers[i].cursor)->load(std::memory_order_relaxed) + 1 >= sequence) {
+            m_slowPid[i] = 0;
+        }
+    }
+}
+
+bool XFrameBus::Impl::publish(const XImage* image) {
+    if (!m_publisher || !image || !image->_data_) {
+        return false;
+    }
+    const uint32_t bpp = (image->_pixel_depth + 7) / 8;
+    const size_t rowBytes = static_cast<size_t>(image->_width) * bpp;
+    if (image->_width > m_header->width || image->_height > m_header->height ||
+        bpp > (m_header->pixelDepth + 7) / 8) {
+        reportError(47, "Frame is larger than the bus slots");
+        return false;
+    }
+
+    const uint32_t index = m_nextSlot;
+    m_nextSlot = (m_nextSlot + 1) % m_header->slotCount;
+    retireSlot(index);
+
+    uint8_t* dst = slotData(index);
+    const uint8_t* src = image->_data_ + image->_data_offset;
+    for (uint32_t row = 0; row < image->_height; ++row) {
+        std::memcpy(dst + row * rowBytes, src + static_cast<size_t>(row) * image->_stride, rowBytes);
+    }
+    publishSlot(index, image->_width, image->_height, image->_pixel_depth, 0, false);
+    return true;
+}
+
+void XFrameBus::Impl::reportError(uint32_t errorId, const std::string& message) {
+    HX_LOG_ID(::HX::XFactory::LOG_ERROR, "XFrameBus", errorId) << "ERROR " << errorId << ": " << message;
+
+    if (m_sink) {
+        m_sink->OnXError(errorId, message.c_str());
+    }
+}
+
+// ============================================================================
+// Public interface
+// ============================================================================
+
+XFrameBus::XFrameBus()
+    : m_impl(new Impl())
+{
+}
+
+XFrameBus::~XFrameBus() {
+    delete m_impl;
+}
+
+void XFrameBus::SetSink(IXImgSink* sink_) {
+    if (!m_impl) return;
+    m_impl->setSink(sink_);
+}
+
+bool XFrameBus::Create(const std::string& name, uint32_t width, uint32_t height,
+                       uint8_t pixelDepth, uint32_t slots) {
+    if (!m_impl) return false;
+    return m_impl->create(name, width, height, pixelDepth, slots);
+}
+
+bool XFrameBus::Subscribe(const std::string& name) {
+    if (!m_impl) return false;
+    return m_impl->subscribe(name);
+}
+
+void XFrameBus::Close() {
+    if (!m_impl) return;
+    m_impl->close();
+}
+
+bool XFrameBus::IsOpen() const {
+    if (!m_impl) return false;
+    return m_impl->isOpen();
+}
+
+uint32_t XFrameBus::GetSlots() const {
+    if (!m_impl) return 0;
+    return m_impl->getSlots();
+}
+
+bool XFrameBus::Next(Frame& frame, uint32_t timeoutMs) {
+    if (!m_impl) return false;
+    return m_impl->next(frame, timeoutMs);
+}
+
+bool XFrameBus::IsValid(const Frame& frame) const {
+    if (!m_impl) return false;
+    return m_impl->isValid(frame);
+}
+
+bool XFrameBus::IsClosed() const {
+    if (!m_impl) return true;
+    return m_impl->isClosed();
+}
+
+uint64_t XFrameBus::GetLost() const {
+    if (!m_impl) return 0;
+    return m_impl->getLost();
+}
+
+uint32_t XFrameBus::GetSubscribers(SubscriberInfo* info, uint32_t max) const {
+    if (!m_impl) return 0;
+    return m_impl->getSubscribers(info, max);
+}
+
+bool XFrameBus::Publish(const XImage* image) {
+    if (!m_impl) return false;
+    return m_impl->publish(image);
+}
+
+uint8_t* XFrameBus::GetSlotData(uint32_t slot) const {
+    if (!m_impl) return nullptr;
+    return m_impl->slotData(slot);
+}
+
+uint64_t XFrameBus::GetSlotBytes() const {
+    if (!m_impl) return 0;
+    return m_impl->slotBytes();
+}
+
+void XFrameBus::RetireSlot(uint32_t slot) {
+    if (!m_impl) return;
+    m_impl->retireSlot(slot);
+}
+
+void XFrameBus::PublishSlot(uint32_t slot, uint32_t width, uint32_t height, uint8_t pixelDepth,
+                            uint32_t missingLines, bool empty) {
+    if (!m_impl) return;
+    m_impl->publishSlot(slot, width, height, pixelDepth, missingLines, empty);
+}
+
+} // namespace HX
@@ -0,0 +1,677 @@
+// ============================================================================
+// XFrameDistributor.cpp - Frame sharding to worker nodes
+// ============================================================================
+
+/**
+ * @file XFrameDistributor.cpp
+ * @brief XFrameDistributor implementation - credit-based TCP fan-out
+ * @version 2.1.0
+ */
+
+#include "XFrameDistributor.h"
+#include "XImage.h"
+#include "iximg_sink.h"
+#include "utils/delta_pack.h"
+#include "utils/logger.h"
+#include "utils/mem_profile.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <cerrno>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace HX {
+
+namespace {
+
+#ifdef _WIN32
+typedef SOCKET SocketHandle;
+const SocketHandle NO_SOCKET = INVALID_SOCKET;
+#else
+typedef int SocketHandle;
+const SocketHandle NO_SOCKET = -1;
+#endif
+
+/// How often the accept loop checks for Stop()
+const long ACCEPT_POLL_MS = 100;
+
+/// Frame buffers kept for reuse, so steady streaming does not allocate
+const size_t SPARE_BUFFERS = 16;
+
+#pragma pack(push, 1)
+
+/// Frame header on the wire, see XFrameDistributor.h
+struct FrameHeader {
+    char magic[4];
+    uint16_t version;
+    uint16_t encoding;
+    uint32_t width;
+    uint32_t height;
+    uint32_t pixelDepth;
+    uint32_t detector;
+    uint64_t sequence;
+    uint64_t timeUs;
+    uint32_t payload;
+    uint32_t reserved;
+};
+
+/// Credit grant from a worker
+struct CreditMessage {
+    char magic[4];
+    uint32_t credits;
+};
+
+#pragma pack(pop)
+
+static_assert(sizeof(FrameHeader) == 48, "FrameHeader must be 48 bytes");
+static_assert(sizeof(CreditMessage) == 8, "CreditMessage must be 8 bytes");
+
+void closeSocket(SocketHandle s) {
+#ifdef _WIN32
+    closesocket(s);
+#else
+    close(s);
+#endif
+}
+
+/// Wake a thread blocked on the socket
+void shutdownSocket(SocketHandle s) {
+#ifdef _WIN32
+    shutdown(s, SD_BOTH);
+#else
+    shutdown(s, SHUT_RDWR);
+#endif
+}
+
+bool sendAll(SocketHandle s, const uint8_t* data, size_t size) {
+#ifdef MSG_NOSIGNAL
+    const int flags = MSG_NOSIGNAL;     // A closed peer must not raise SIGPIPE
+#else
+    const int flags = 0;
+#endif
+    while (size > 0) {
+        const int chunk = static_cast<int>(std::min<size_t>(size, 1 << 20));
+        const int sent = static_cast<int>(send(s, reinterpret_cast<const char*>(data), chunk, flags));
+        if (sent <= 0) {
+#ifndef _WIN32
+            if (sent < 0 && errno == EINTR) {
+                continue;
+            }
+#endif
+            return false;
+        }
+        data += sent;
+        size -= static_cast<size_t>(sent);
+    }
+    return true;
+}
+
+bool recvAll(SocketHandle s, uint8_t* data, size_t size) {
+    while (size > 0) {
+        const int got = static_cast<int>(recv(s, reinterpret_cast<char*>(data), static_cast<int>(size), 0));
+        if (got <= 0) {
+#ifndef _WIN32
+            if (got < 0 && errno == EINTR) {
+                continue;
+            }
+#endif
+            return false;
+        }
+        data += got;
+        size -= static_cast<size_t>(got);
+    }
+    return true;
+}
+
+uint64_t nowUs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+}
+
+/// One published frame on its way to a worker
+struct Job {
+    FrameHeader header;
+    std::vector<uint8_t> pixels;        ///< Rows packed, width * bytes per pixel
+};
+
+} // anonymous namespace
+
+class XFrameDistributor::Impl {
+public:
+    Impl();
+    ~Impl();
+
+    void setSink(IXImgSink* sink_) { m_sink = sink_; }
+    bool setEncoding(XEncoding encoding);
+    bool setSharding(XSharding sharding);
+    bool setQueueDepth(uint32_t frames);
+
+    bool start(uint16_t port, uint32_t maxWorkers);
+    void stop();
+    bool isRunning() const { return m_running; }
+    uint16_t getPort() const { return m_port; }
+
+    bool publish(const XImage* image, uint32_t detector);
+    Statistics getStatistics() const;
+
+private:
+    /// One worker connection, its sender and its credit reader
+    struct Worker {
+        SocketHandle socket;
+        std::thread sender;
+        std::thread receiver;
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::deque<std::unique_ptr<Job> > queue;
+        uint64_t credits;
+        bool stop;
+        std::atomic<bool> alive;
+
+        Worker() : socket(NO_SOCKET), credits(0), stop(false), alive(true) {}
+    };
+
+    void acceptThread();
+    void senderThread(Worker* worker);
+    void receiverThread(Worker* worker);
+    void reapWorkers(bool all);
+    Worker* pickWorker(uint32_t detector);
+    std::unique_ptr<Job> takeBuffer();
+    void returnBuffer(std::unique_ptr<Job> job);
+    void reportError(uint32_t errorId, const std::string& message);
+
+    IXImgSink* m_sink;
+    XEncoding m_encoding;
+    XSharding m_sharding;
+    uint32_t m_queueDepth;
+    uint32_t m_maxWorkers;
+
+    std::atomic<bool> m_running;
+    SocketHandle m_listen;
+    uint16_t m_port;
+    std::thread m_acceptThread;
+
+    // Workers in connection order; m_next is the round-robin position
+    mutable std::mutex m_workersMutex;
+    std::vector<std::unique_ptr<Worker> > m_workers;
+    size_t m_next;
+
+    std::mutex m_spareMutex;
+    std::vector<std::unique_ptr<Job> > m_spare;
+
+    // Counters
+    std::atomic<uint64_t> m_published;
+    std::atomic<uint64_t> m_sent;
+    std::atomic<uint64_t> m_dropped;
+    std::atomic<uint64_t> m_bytesSent;
+};
+
+XFrameDistributor::Impl::Impl()
+    : m_sink(nullptr)
+    , m_encoding(XDIST_RAW)
+    , m_sharding(XDIST_ROUND_ROBIN)
+    , m_queueDepth(4)
+    , m_maxWorkers(8)
+    , m_running(false)
+    , m_listen(NO_SOCKET)
+    , m_port(0)
+    , m_next(0)
+    , m_published(0)
+    , m_sent(0)
+    , m_dropped(0)
+    , m_bytesSent(0)
+{
+}
+
+XFrameDistributor::Impl::~Impl() {
+    stop();
+}
+
+bool XFrameDistributor::Impl::setEncoding(XEncoding encoding) {
+    if (m_running) {
+        return false;
+    }
+    m_encoding = encoding;
+    return true;
+}
+
+bool XFrameDistributor::Impl::setSharding(XSharding sharding) {
+    if (m_running) {
+        return false;
+    }
+    m_sharding = sharding;
+    return true;
+}
+
+bool XFrameDistributor::Impl::setQueueDepth(uint32_t frames) {
+    if (m_running || frames == 0 || frames > 64) {
+        return false;
+    }
+    m_queueDepth = frames;
+    return true;
+}
+
+bool XFrameDistributor::Impl::start(uint16_t port, uint32_t maxWorkers) {
+    if (m_running) {
+        return true;
+    }
+    if (maxWorkers == 0) {
+        reportError(49, "maxWorkers must be at least 1");
+        return false;
+    }
+
+#ifdef _WIN32
+    WSADATA wsa;
+    if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0) {
+        reportError(49, "WSAStartup failed");
+        return false;
+    }
+#endif
+
+    SocketHandle s = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (s == NO_SOCKET) {
+        reportError(49, "Cannot create socket");
+#ifdef _WIN32
+        WSACleanup();
+#endif
+        return false;
+    }
+    const int reuse = 1;
+    setsockopt(s, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&reuse), sizeof(reuse));
+
+    sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(port);
+    socklen_t length = sizeof(addr);
+    if (bind(s, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0 ||
+        listen(s, static_cast<int>(maxWorkers)) != 0 ||
+        getsockname(s, reinterpret_cast<sockaddr*>(&addr), &length) != 0) {
+        reportError(49, "Cannot listen on port " + std::to_string(port));
+        closeSocket(s);
+#ifdef _WIN32
+        WSACleanup();
+#endif
+        return false;
+    }
+
+    m_listen = s;
+    m_port = ntohs(addr.sin_port);
+    m_maxWorkers = maxWorkers;
+    m_next = 0;
+    m_published = 0;
+    m_sent = 0;
+    m_dropped = 0;
+    m_bytesSent = 0;
+    m_running = true;
+
+    m_acceptThread = std::thread(&Impl::acceptThread, this);
+
+    HX_LOG_INFO("XFrameDistributor") << "Listening on port " << m_port;
+    return true;
+}
+
+void XFrameDistributor::Impl::stop() {
+    if (!m_running) {
+        return;
+    }
+    m_running = false;
+    m_acceptThread.join();
+
+    reapWorkers(true);
+    closeSocket(m_listen);
+    m_listen = NO_SOCKET;
+    m_port = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_spareMutex);
+        m_spare.clear();
+    }
+#ifdef _WIN32
+    WSACleanup();
+#endif
+
+    HX_LOG_INFO("XFrameDistributor") << "Stopped";
+}
+
+XFrameDistributor::Impl::Worker* XFrameDistributor::Impl::pickWorker(uint32_t detector) {
+    // Under m_workersMutex
+    const size_t count = m_workers.size();
+    if (count == 0) {
+        return nullptr;
+    }
+
+    if (m_sharding == XDIST_BY_DETECTOR) {
+        Worker* worker = m_workers[detector % count].get();
+        std::lock_guard<std::mutex> lock(worker->mutex);
+        return (worker->alive && worker->queue.size() < m_queueDepth) ? worker : nullptr;
+    }
+
+    // First a worker that can send at once, then one with queue room
+    Worker* fallback = nullptr;
+    for (size_t k = 0; k < count; ++k) {
+        const size_t i = (m_next + k) % count;
+        Worker* worker = m_workers[i].get();
+        std::lock_guard<std::mutex> lock(worker->mutex);
+        if (!worker->alive || worker->queue.size() >= m_queueDepth) {
+            continue;
+        }
+        if (worker->credits > worker->queue.size()) {
+            m_next = i + 1;
+            return worker;
+        }
+        if (!fallback) {
+            fallback = worker;
+        }
+    }
+    if (fallback) {
+        m_next = m_next + 1;
+    }
+    return fallback;
+}
+
+std::unique_ptr<Job> XFrameDistributor::Impl::takeBuffer() {
+    {
+        std::lock_guard<std::mutex> lock(m_spareMutex);
+        if (!m_spare.empty()) {
+            std::unique_ptr<Job> job(std::move(m_spare.back()));
+            m_spare.pop_back();
+            return job;
+        }
+    }
+    return std::unique_ptr<Job>(new Job());
+}
+
+void XFrameDistributor::Impl::returnBuffer(std::unique_ptr<Job> job) {
+    std::lock_guard<std::mutex> lock(m_spareMutex);
+    if (m_spare.size() < SPARE_BUFFERS) {
+        m_spare.push_back(std::move(job));
+    }
+}
+
+bool XFrameDistributor::Impl::publish(const XImage* image, uint32_t detector) {
+    if (!m_running || !image || !image->_data_ || image->_width == 0 || image->_height == 0 ||
+        image->_pixel_depth == 0 || image->_pixel_depth > 32) {
+        return false;
+    }
+    const uint64_t sequence = ++m_published;
+
+    std::lock_guard<std::mutex> lock(m_workersMutex);
+    Worker* worker = pickWorker(detector);
+    if (!worker) {
+        ++m_dropped;
+        return false;
+    }
+
+    // Copy once; the sender encodes and sends from this buffer
+    std::unique_ptr<Job> job = takeBuffer();
+    const size_t rowBytes = static_cast<size_t>(image->_width) * ((image->_pixel_depth + 7) / 8);
+    {
+        Internal::MemTagScope memTag(XFactory::MEM_OTHER);
+        job->pixels.resize(rowBytes * image->_height);
+    }
+    for (uint32_t row = 0; row < image->_height; ++row) {
+        std::memcpy(job->pixels.data() + row * rowBytes,
+                    image->_data_ + image->_data_offset + static_cast<size_t>(row) * image->_stride,
+                    rowBytes);
+    }
+
+    FrameHeader& header = job->header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, "HXDF", 4);
+    header.version = 1;
+    header.encoding = static_cast<uint16_t>(m_encoding);
+    header.width = image->_width;
+    header.height = image->_height;
+    header.pixelDepth = image->_pixel_depth;
+    header.detector = detector;
+    header.sequence = sequence;
+    header.timeUs = nowUs();
+
+    {
+        std::lock_guard<std::mutex> workerLock(worker->mutex);
+        worker->queue.push_back(std::move(job));
+    }
+    worker->cv.notify_one();
+    return true;
+}
+
+void XFrameDistributor::Impl::acceptThread() {
+    while (m_running) {
+        fd_set readable;
+        FD_ZERO(&readable);
+        FD_SET(m_listen, &readable);
+        timeval timeout;
+        timeout.tv_sec = 0;
+        timeout.tv_usec = ACCEPT_POLL_MS * 1000;
+        const int ready = select(static_cast<int>(m_listen) + 1, &readable, nullptr, nullptr, &timeout);
+        reapWorkers(false);
+        if (ready <= 0 || !m_running) {
+            continue;
+        }
+
+        SocketHandle s = accept(m_listen, nullptr, nullptr);
+        if (s == NO_SOCKET) {
+            continue;
+        }
+
+        std::lock_guard<std::mutex> lock(m_workersMutex);
+        if (m_workers.size() >= m_maxWorkers) {
+            closeSocket(s);
+            continue;
+        }
+
+        // Headers go out with their payload, credits come back promptly
+        const int noDelay = 1;
+        setsockopt(s, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&noDelay), sizeof(noDelay));
+
+        std::unique_ptr<Worker> worker(new Worker());
+        worker->socket = s;
+        worker->sender = std::thread(&Impl::senderThread, this, worker.get());
+        worker->receiver = std::thread(&Impl::receiverThread, this, worker.get());
+        m_workers.push_back(std::move(worker));
+        HX_LOG_INFO("XFrameDistributor") << "Worker " << m_workers.size() << " connected";
+    }
+}
+
+void XFrameDistributor::Impl::senderThread(Worker* worker) {
+    std::vector<uint8_t> packed;
+    for (;;) {
+        std::unique_ptr<Job> job;
+        {
+            std::unique_lock<std::mutex> lock(worker->mutex);
+            worker->cv.wait(lock, [worker] {
+                return worker->stop || (!worker->queue.empty() && worker->credits > 0);
+            });
+            if (worker->stop) {
+                break;
+            }
+            job = std::move(worker->queue.front());
+            worker->queue.pop_front();
+            worker->credits--;
+        }
+
+        FrameHeader& header = job->header;
+        const uint8_t* payload = job->pixels.data();
+        size_t size = job->pixels.size();
+        if (m_encoding == XDIST_DELTA) {
+            const uint32_t bpp = (header.pixelDepth + 7) / 8;
+            packed.resize(Internal::DeltaPackBound(static_cast<size_t>(header.width) * header.height));
+            size = Internal::DeltaPackEncode(payload, header.width, header.height,
+                                             header.width * bpp, bpp, packed.data());
+            payload = packed.data();
+        }
+        header.payload = static_cast<uint32_t>(size);
+
+        // Only this worker waits on its socket
+        if (!sendAll(worker->socket, reinterpret_cast<const uint8_t*>(&header), sizeof(header)) ||
+            !sendAll(worker->socket, payload, size)) {
+            ++m_dropped;
+            break;
+        }
+        ++m_sent;
+        m_bytesSent += sizeof(header) + size;
+        returnBuffer(std::move(job));
+    }
+    worker->alive = false;
+}
+
+void XFrameDistributor::Impl::receiverThread(Worker* worker) {
+    for (;;) {
+        CreditMessage message;
+        if (!recvAll(worker->socket, reinterpret_cast<uint8_t*>(&message), sizeof(message)) ||
+            std::memcmp(message.magic, "HXDC", 4) != 0) {
+            break;
+        }
+        {
+            std::lock_guard<std::mutex> lock(worker->mutex);
+            worker->credits += message.credits;
+        }
+        worker->cv.notify_one();
+    }
+
+    // Closed or spoke out of turn: the sender stops too
+    {
+        std::lock_guard<std::mutex> lock(worker->mutex);
+        worker->stop = true;
+    }
+    worker->cv.notify_one();
+    worker->alive = false;
+}
+
+void XFrameDistributor::Impl::reapWorkers(bool all) {
+    std::vector<std::unique_ptr<Worker> > done;
+    {
+        std::lock_guard<std::mutex> lock(m_workersMutex);
+        for (size_t i = 0; i < m_workers.size();) {
+            if (all || !m_workers[i]->alive) {
+                done.push_back(std::move(m_workers[i]));
+                m_workers.erase(m_workers.begin() + static_cast<std::ptrdiff_t>(i));
+            } else {
+                ++i;
+            }
+        }
+    }
+
+    // Joined outside the lock; shutdown wakes threads blocked on the socket
+    for (size_t i = 0; i < done.size(); ++i) {
+        Worker* worker = done[i].get();
+        {
+            std::lock_guard<std::mutex> lock(worker->mutex);
+            worker->stop = true;
+            m_dropped += worker->queue.size();
+            worker->queue.clear();
+        }
+        worker->cv.notify_one();
+        shutdownSocket(worker->socket);
+        worker->sender.join();
+        worker->receiver.join();
+        closeSocket(worker->socket);
+    }
+}
+
+XFrameDistributor::Statistics XFrameDistributor::Impl::getStatistics() const {
+    Statistics stats;
+    stats.framesPublished = m_published;
+    stats.framesSent = m_sent;
+    stats.framesDropped = m_dropped;
+    stats.bytesSent = m_bytesSent;
+    stats.credits = 0;
+    std::lock_guard<std::mutex> lock(m_workersMutex);
+    stats.workers = static_cast<uint32_t>(m_workers.size());
+    for (size_t i = 0; i < m_workers.size(); ++i) {
+        std::lock_guard<std::mutex> workerLock(m_workers[i]->mutex);
+        stats.credits += static_cast<uint32_t>(std::min<uint64_t>(m_workers[i]->credits, 0xFFFFFFFFu));
+    }
+    return stats;
+}
+
+void XFrameDistributor::Impl::reportError(uint32_t errorId, const std::string& message) {
+    HX_LOG_ID(::HX::XFactory::LOG_ERROR, "XFrameDistributor", errorId) << "ERROR " << errorId << ": " << message;
+
+    if (m_sink) {
+        m_sink->OnXError(errorId, message.c_str());
+    }
+}
+
+// ============================================================================
+// Public interface
+// ============================================================================
+
+XFrameDistributor::XFrameDistributor()
+    : m_impl(new Impl())
+{
+}
+
+XFrameDistributor::~XFrameDistributor() {
+    delete m_impl;
+}
+
+void XFrameDistributor::SetSink(IXImgSink* sink_) {
+    if (!m_impl) return;
+    m_impl->setSink(sink_);
+}
+
+bool XFrameDistributor::SetEncoding(XEncoding encoding) {
+    if (!m_impl) return false;
+    return m_impl->setEncoding(encoding);
+}
+
+bool XFrameDistributor::SetSharding(XSharding sharding) {
+    if (!m_impl) return false;
+    return m_impl->setSharding(sharding);
+}
+
+bool XFrameDistributor::SetQueueDepth(uint32_t frames) {
+    if (!m_impl) return false;
+    return m_impl->setQueueDepth(frames);
+}
+
+bool XFrameDistributor::Start(uint16_t port, uint32_t maxWorkers) {
+    if (!m_impl) return false;
+    return m_impl->start(port, maxWorkers);
+}
+
+void XFrameDistributor::Stop() {
+    if (!m_impl) return;
+    m_impl->stop();
+}
+
+bool XFrameDistributor::IsRunning() const {
+    if (!m_impl) return false;
+    return m_impl->isRunning();
+}
+
+uint16_t XFrameDistributor::GetPort() const {
+    if (!m_impl) return 0;
+    return m_impl->getPort();
+}
+
+bool XFrameDistributor::Publish(const XImage* image, uint32_t detector) {
+    if (!m_impl) return false;
+    return m_impl->publish(image, detector);
+}
+
+XFrameDistributor::Statistics XFrameDistributor::GetStatistics() const {
+    if (!m_impl) return Statistics();
+    return m_impl->getStatistics();
+}
+
+} // namespace HX
@@ -12,83 +12,383 @@
 #include "XDetector.h"
 #include "XControl.h"
 #include "XFrame.h"
+#include "XFlightRecorder.h"
+#include "xmulti_frame.h"
 #include "xfactory.h"
 #include "iximg_sink.h"
 #include "xlibdll_wrapper/xlibdll_interface.h"
-#include <iostream>
+#include "utils/spsc_ring.h"
+#include "utils/device_clock.h"
+#include "utils/io_ring.h"
+#include "utils/thread_policy.h"
+#include "utils/service_loop.h"
+#include "utils/overload.h"
+#include "utils/link_listener.h"
+#include "utils/frame_listener.h"
+#include "utils/capture_reader.h"
+#include "utils/latency_trace.h"
+#include "utils/metrics.h"
+#include "utils/mem_budget.h"
+#include "utils/logger.h"
+#include "utils/notifier.h"
+#include "utils/line_pattern.h"
+#include <algorithm>
+#include <string>
 #include <thread>
 #include <atomic>
 #include <mutex>
+#include <condition_variable>
 #include <vector>
+#include <chrono>
+#include <cerrno>
+#include <cstring>
 
 namespace HX {
 
-class XGrabber::Impl {
+/**
+ * @brief Descriptor of one received packet held in the receive ring
+ */
+struct PacketDesc {
+    uint32_t slot;      ///< Index into the packet store
+    uint32_t length;    ///< Received bytes (0 = empty slot)
+    uint32_t offset;    ///< Packet start inside the slot (AF_XDP headers, else 0)
+    uint64_t receivedNs; ///< Internal::TraceNow() at receive (0 = not traced)
+    uint64_t hardwareNs; ///< NIC receive stamp, ns since 1970 (0 = none)
+};
+
+/**
+ * @brief 16-bit header lineId extended to a monotonic 32-bit sequence
+ */
+struct LineIdState {
+    bool valid;
+    uint16_t last;
+    uint32_t ext;
+    
+    LineIdState() : valid(false), last(0), ext(0) {}
+};
+
+class XGrabber::Impl : public Internal::LinkListener, public Internal::FrameListener,
+                       public Internal::MetricsCollector {
 public:
     Impl();
     ~Impl();
     
     bool open(XDetector& det, XControl& control);
+    bool open(XDetector& det, XControl& control, XGrabber::NetworkConfig& config);
+    bool openImpl(XDetector& det, XControl& control, XGrabber::NetworkConfig* config);
+    bool openReplay(XDetector& det, const std::string& file);
+    bool setReplaySpeed(double speed);
+    double getReplaySpeed() const { return m_replaySpeed; }
+    void getNetworkConfig(XGrabber::NetworkConfig& config) const;
     void close();
     bool isOpen() const { return m_opened; }
     
     bool grab(uint32_t frames);
     bool snap();
+    bool waitGrab(uint32_t timeoutMs);
+    bool prepare();
+    uint32_t getPrepareTime() const { return m_prepareTime; }
+    uint32_t slotSize(uint32_t lineBytes) const;
     bool stop();
     bool isGrabbing() const { return m_grabbing; }
     
     void setHeader(bool enable) { m_headerMode = enable; }
-    void setSink(IXImgSink* sink) { m_sink = sink; }
+    bool setPacketCheck(bool enable);
+    bool getPacketCheck() const { return m_packetCheck; }
+    bool setPatternCheck(const uint8_t* expected, uint32_t bytes, uint32_t lines);
+    uint32_t getPatternCheck() const { return m_patternLines; }
+    void checkPattern(const uint8_t* data, uint32_t bytes, uint32_t lineId, uint32_t segment) {
+        if (m_pattern.enabled() && !m_pattern.check(data, bytes, lineId, segment)) {
+            reportError(27, "Line differs from the test pattern");
+        }
+    }
+    bool setPacketLayout(const XGrabber::PacketLayout& layout);
+    void getPacketLayout(XGrabber::PacketLayout& layout) const { layout = m_layout; }
+    void setSink(IXImgSink* sink) {
+        m_sink = sink;
+        m_notify.setSink(sink);
+    }
     void setFrame(XFrame& frame);
+    void setMultiFrame(XMultiFrame& multi, uint32_t detector);
+    void setFlightRecorder(XFlightRecorder* recorder);
     void setFactory(XFactory& factory) { m_factory = &factory; }
     void setTimeout(uint32_t time) { m_timeout = time; }
+    bool setBatchSize(uint32_t count);
+    uint32_t getBatchSize() const { return m_batchSize; }
+    bool setRingDepth(uint32_t packets);
+    uint32_t getRingDepth() const { return m_ringDepth; }
+    uint32_t getRingHighWater() const { return m_ring.highWater(); }
+    bool setZeroCopy(bool enable);
+    bool getZeroCopy() const { return m_zeroCopy; }
+    bool setReceiveMode(XGrabber::ReceiveMode mode);
+    XGrabber::ReceiveMode getReceiveMode() const { return m_receiveMode; }
+    bool setBatchDelay(uint32_t maxDelayUs);
+    uint32_t getBatchDelay() const { return m_batchDelayUs; }
+    bool setReceiveQueues(uint32_t count);
+    uint32_t getReceiveQueues() const { return m_queueCount; }
+    bool setKernelBypass(const std::string& interfaceName, uint32_t queueId);
+    bool getKernelBypass() const { return m_xdp >= 0; }
+    bool setIoUring(bool enable);
+    bool getIoUring() const { return m_uringActive; }
+    void getStatistics(XGrabber::Statistics& stats) const;
+    void resetStatistics();
+    void setLossThreshold(double ratio, uint32_t windowMs);
+    
+    void onLinkLost();
+    void onLinkRestored(uint32_t gapMs);
+    void onFrameDone(uint32_t frames) override;
+    
+    void collectMetrics(Internal::MetricsWriter& out) override;
     
 private:
+    bool openNetwork(XGrabber::NetworkConfig* config);
+    void linkTo(XControl& control);
+    bool startGrab(uint32_t frames);
+    void endGrab();
+    void wakeReceivers();
     void grabThread();
-    void processPacket(const uint8_t* packetData, uint32_t packetLen);
+    void replayThread();
+    enum AssemblyState { ASSEMBLY_BUSY = 0, ASSEMBLY_IDLE, ASSEMBLY_DONE };
+    void assemblyThread();
+    bool assemblyPoll();
+    void beginAssembly();
+    AssemblyState assembleSlice(uint32_t budget);
+    void finishAssembly();
+    void joinAssembly();
+    void directThread();
+    void xdpThread();
+    bool openXdp(uint32_t lineBytes);
+    void releaseXdp(std::vector<uint64_t>& frames);
+    void uringThread();
+    bool openUring();
+    void processPacket(const uint8_t* packetData, uint32_t packetLen, uint64_t hardwareNs);
+    bool checkPacket(const uint8_t* packetData, uint32_t& packetLen);
+    const char* layoutError(uint32_t lineBytes) const;
+    void deliverPacket(const uint8_t* packetData, uint32_t packetLen, LineIdState& lineIds,
+                       Internal::DeviceClock& clock, uint64_t hardwareNs, bool trackIds);
+    XFrame::LineTime lineTime(Internal::DeviceClock& clock, const Internal::XLibPacketView& header,
+                              uint64_t hardwareNs);
+    uint32_t unwrapLineId(LineIdState& state, uint16_t lineId);
+    uint32_t receiveTimeout() const;
+    bool isIdleResult(int32_t result) const;
+    int32_t receiveSlots(Internal::XLibPacketSlot* slots, uint64_t* stamps, uint32_t count,
+                         uint32_t timeout);
+    void adaptiveThread();
+    void queueThread(uint32_t queue);
+    void deliverLine(const uint8_t* lineData, uint32_t lineLen, uint32_t lineId,
+                     const Internal::XLibPacketView& header, const XFrame::LineTime& time);
+    bool openQueues(const Internal::XLibNetworkConfig& request);
+    void closeQueues();
+    void trackPacketId(uint32_t packetId, bool corrupt = false);
+    void checkLossRate();
     void reportError(uint32_t errorId, const char* message);
     void reportEvent(uint32_t eventId, uint32_t data);
     
     XDetector m_detector;
     XControl* m_control;
+    XControl* m_linked;                 ///< Control whose reconnects we follow
     XFrame* m_frame;
+    XMultiFrame* m_multi;               ///< Replaces m_frame when set
+    uint32_t m_multiDetector;
     XFactory* m_factory;
     IXImgSink* m_sink;
+    Internal::NotifySource m_notify;    ///< Delivers OnXError/OnXEvent off the receive threads
+    XFlightRecorder* m_flight;          ///< Pre-trigger copy of raw lines
+    Internal::MetricLabels m_metricLabels;  ///< Set while registered with the metrics registry
     
     bool m_opened;
     std::atomic<bool> m_grabbing;
     std::atomic<bool> m_stopRequested;
     uint32_t m_framesToGrab;
-    uint32_t m_framesGrabbed;
+    std::atomic<uint32_t> m_framesGrabbed;  ///< Counted by XFrame, see onFrameDone()
+    
+    // WaitGrab() sleeps until acquisition ends, complete or not
+    std::mutex m_sequenceMutex;
+    std::condition_variable m_sequenceDone;
+    bool m_sequenceComplete;
+    
+    // Suspended by a lost link, to be resumed once XControl reconnects
+    std::atomic<bool> m_resume;
+    bool m_tuned;                       ///< Opened with a NetworkConfig
     
     bool m_headerMode;
+    bool m_packetCheck;                 ///< Verify and strip the CRC16 trailer
+    std::vector<uint8_t> m_patternExpected; ///< SetPatternCheck() reference, empty = learn
+    uint32_t m_patternLines;            ///< Test pattern period, 0 = not checked
+    Internal::LinePattern m_pattern;
+    XGrabber::PacketLayout m_layout;
     uint32_t m_timeout;
+    XGrabber::NetworkConfig m_netConfig;
+    uint32_t m_batchSize;
+    
+    // Receive ring between grab thread (producer) and assembly thread (consumer)
+    Internal::SpscRing<PacketDesc> m_ring;
+    std::vector<uint8_t> m_packetStore;
+    uint8_t* m_store;                   ///< First slot, page aligned when it is the UMEM
+    uint32_t m_ringDepth;
+    uint32_t m_slotSize;
+    uint32_t m_prepareTime;             ///< Microseconds of the last prepare()
+    std::atomic<bool> m_receiving;
+    std::atomic<uint64_t> m_ringOverflows;
+    
+    // Receive payloads straight into frame rows
+    bool m_zeroCopy;
+    
+    // Busy-poll spins on non-blocking receives instead of sleeping in the kernel;
+    // adaptive receive spins only while packets arrive and batches them
+    XGrabber::ReceiveMode m_receiveMode;
+    uint32_t m_batchDelayUs;            ///< Longest a packet waits for its batch
+    std::atomic<uint32_t> m_adaptiveBatch;
+    
+    // AF_XDP receive: the packet store is the UMEM, one frame per ring slot
+    std::string m_xdpInterface;
+    uint32_t m_xdpQueue;
+    std::atomic<int32_t> m_xdp;
+    
+    // io_uring receive: the packet store slots are the provided buffers
+    bool m_ioUring;
+    Internal::IoRing m_uring;
+    std::mutex m_uringMutex;            ///< Closing the ring vs. Stop() waking it
+    std::atomic<bool> m_uringActive;
+    int32_t m_uringSocket;
+    std::atomic<uint64_t> m_uringReleased;  ///< Slots consumed by assembly, ever
     
     std::thread m_grabThread;
+    std::thread m_assemblyThread;
     mutable std::mutex m_mutex;
     
-    // Statistics
-    uint32_t m_packetsReceived;
-    uint32_t m_packetsLost;
-    uint32_t m_linesReceived;
+    // Ring assembly state, kept between slices; with the service loop
+    // (SetServiceThreads) m_assemblyTask runs it instead of m_assemblyThread
+    Internal::ServiceCall m_assemblyTask;
+    bool m_assemblyShared;
+    std::atomic<bool> m_assemblyDone;
+    bool m_assemblyXdp;
+    bool m_assemblyUring;
+    std::vector<uint64_t> m_released;   ///< XDP frames to hand back
+    uint64_t m_consumed;
+    uint32_t m_idleSpins;
+    std::chrono::steady_clock::time_point m_nextFramePoll;
+    Internal::OverloadSource m_overload;    ///< Ring fill, for SetOverloadPolicy
+    
+    // Statistics (written by receive/assembly threads, read by GetStatistics)
+    std::atomic<uint64_t> m_packetsReceived;
+    std::atomic<uint64_t> m_packetsLost;
+    std::atomic<uint64_t> m_linesReceived;
+    std::atomic<uint64_t> m_packetsDuplicate;
+    std::atomic<uint64_t> m_packetsReordered;
+    std::atomic<uint64_t> m_packetsLate;
+    std::atomic<uint64_t> m_sequenceGaps;
+    std::atomic<uint64_t> m_packetsCorrupt;
+    
+    // packetId continuity: highest id seen plus a 64-packet history
+    std::mutex m_packetIdMutex;         ///< Receive queues share the packetId state
+    bool m_packetIdValid;
+    uint32_t m_highestPacketId;
+    uint64_t m_packetIdHistory;
+    
+    // Loss-rate alarm, evaluated once per window
+    double m_lossThreshold;
+    uint32_t m_lossWindowMs;
+    uint32_t m_lossCheckCounter;
+    uint64_t m_windowReceived;
+    uint64_t m_windowLost;
+    std::chrono::steady_clock::time_point m_windowStart;
+    std::chrono::steady_clock::time_point m_lastLossEvent;
+    
+    LineIdState m_lineIdState;
+    Internal::DeviceClock m_deviceClock;    ///< Header timestamps of the assembly thread
+    
+    // Multi-queue receive: one socket and thread per queue
+    uint32_t m_queueCount;
+    std::vector<int32_t> m_queues;
+    std::vector<std::thread> m_queueThreads;
+    std::atomic<uint32_t> m_activeQueues;
+    
+    // Capture replay replaces the network when set
+    Internal::CaptureReader* m_replay;
+    std::string m_replayFile;
+    double m_replaySpeed;
+    
+    // Ring slots and packet store, for memory profiling
+    Internal::MemCharge m_memory;
 };
 
 XGrabber::Impl::Impl()
     : m_control(nullptr)
+    , m_linked(nullptr)
     , m_frame(nullptr)
+    , m_multi(nullptr)
+    , m_multiDetector(0)
     , m_factory(nullptr)
     , m_sink(nullptr)
+    , m_flight(nullptr)
     , m_opened(false)
     , m_grabbing(false)
     , m_stopRequested(false)
     , m_framesToGrab(0)
     , m_framesGrabbed(0)
+    , m_sequenceComplete(false)
+    , m_resume(false)
+    , m_tuned(false)
     , m_headerMode(false)
+    , m_packetCheck(false)
+    , m_patternLines(0)
     , m_timeout(20000)
+    , m_batchSize(32)
+    , m_ring(4096)
+    , m_store(nullptr)
+    , m_ringDepth(4096)
+    , m_slotSize(Internal::XLIB_MAX_IMAGE_PACKET_SIZE)
+    , m_prepareTime(0)
+    , m_receiving(false)
+    , m_ringOverflows(0)
+    , m_zeroCopy(false)
+    , m_receiveMode(XGrabber::RECEIVE_BLOCKING)
+    , m_batchDelayUs(100)
+    , m_adaptiveBatch(0)
+    , m_xdpQueue(0)
+    , m_xdp(-1)
+    , m_ioUring(false)
+    , m_uringActive(false)
+    , m_uringSocket(-1)
+    , m_uringReleased(0)
+    , m_assemblyTask([this] { return assemblyPoll(); })
+    , m_assemblyShared(false)
+    , m_assemblyDone(false)
+    , m_assemblyXdp(false)
+    , m_assemblyUring(false)
+    , m_consumed(0)
+    , m_idleSpins(0)
     , m_packetsReceived(0)
     , m_packetsLost(0)
     , m_linesReceived(0)
+    , m_packetsDuplicate(0)
+    , m_packetsReordered(0)
+    , m_packetsLate(0)
+    , m_sequenceGaps(0)
+    , m_packetsCorrupt(0)
+    , m_packetIdValid(false)
+    , m_highestPacketId(0)
+    , m_packetIdHistory(0)
+    , m_lossThreshold(0.001)
+    , m_lossWindowMs(1000)
+    , m_lossCheckCounter(0)
+    , m_windowReceived(0)
+    , m_windowLost(0)
+    , m_queueCount(1)
+    , m_activeQueues(0)
+    , m_replay(nullptr)
+    , m_replaySpeed(1.0)
+    , m_memory(XFactory::MEM_RECEIVE)
 {
+    // Host profile defaults; SetRingDepth() and SetBatchSize() still override
+    const XFactory::HostProfile profile = XFactory::GetHostProfile();
+    if (profile.ringDepth > 0) {
+        m_ringDepth = profile.ringDepth;
+    }
+    if (profile.batchSize > 0) {
+        m_batchSize = profile.batchSize;
+    }
 }
 
 XGrabber::Impl::~Impl() {
@@ -96,17 +396,36 @@ XGrabber::Impl::~Impl() {
 }
 
 bool XGrabber::Impl::open(XDetector& det, XControl& control) {
+    if (!openImpl(det, control, nullptr)) {
+        return false;
+    }
+    linkTo(control);
+    return true;
+}
+
+bool XGrabber::Impl::open(XDetector& det, XControl& control, XGrabber::NetworkConfig& config) {
+    if (!openImpl(det, control, &config)) {
+        return false;
+    }
+    linkTo(control);
+    return true;
+}
+
+bool XGrabber::Impl::openImpl(XDetector& det, XControl& control, XGrabber::NetworkConfig* config) {
     std::lock_guard<std::mutex> lock(m_mutex);
     
     if (m_opened) {
-        std::cout << "[XGrabber] Already opened" << std::endl;
+        HX_LOG_INFO("XGrabber") << "Already opened";
+        if (config) {
+            *config = m_netConfig;
+        }
         return true;
     }
     
-    std::cout << "[XGrabber] Opening..." << std::endl;
+    HX_LOG_INFO("XGrabber") << "Opening...";
     
     // Validate parameters
-    if (!m_frame) {
+    if (!m_frame && !m_multi) {
         reportError(25, "XFrame not set");
         return false;
     }
@@ -117,61 +436,241 @@ bool XGrabber::Impl::open(XDetector& det, XControl& control) {
         return false;
     }
     
+    if (config && config->dscp > 63) {
+        reportError(25, "Invalid DSCP value");
+        return false;
+    }
+    
     m_detector = det;
     m_control = &control;
     
-    // Initialize network for image reception
-    int32_t result = Internal::XLibProxy_InitNetwork(
-        m_detector.GetIP().c_str(),
-        m_detector.GetImgPort()
-    );
+    if (!openNetwork(config)) {
+        return false;
+    }
+    m_tuned = config != nullptr;
+    
+    m_opened = true;
+    resetStatistics();
+    m_metricLabels = Internal::MetricLabels("detector", m_detector.GetIP());
+    Internal::MetricsRegistry::instance().addCollector(this);
+    
+    HX_LOG_INFO("XGrabber") << "Opened successfully";
+    
+    return true;
+}
+
+bool XGrabber::Impl::openReplay(XDetector& det, const std::string& file) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    if (m_opened) {
+        reportError(25, "Close before opening a replay");
+        return false;
+    }
+    
+    if (!m_frame && !m_multi) {
+        reportError(25, "XFrame not set");
+        return false;
+    }
     
-    if (result < 0) {
-        const char* errorMsg = Internal::XLibProxy_GetErrorMessage(result);
-        reportError(21, errorMsg);
+    Internal::CaptureReader* reader = new Internal::CaptureReader();
+    std::string error;
+    if (!reader->open(file, det.GetImgPort(), error)) {
+        reportError(25, error.c_str());
+        delete reader;
         return false;
     }
     
+    m_detector = det;
+    if (!reader->hasHeaders()) {
+        // A stream file knows its line size
+        if (m_detector.GetPixelCount() == 0) {
+            m_detector.SetPixelCount(reader->width());
+            m_detector.SetPixelDepth(reader->pixelDepth());
+        } else if (m_detector.GetPixelCount() != reader->width() ||
+                   m_detector.GetPixelDepth() != reader->pixelDepth()) {
+            reportError(25, "Stream file does not match the detector width or depth");
+            delete reader;
+            return false;
+        }
+    }
+    
+    m_replay = reader;
+    m_replayFile = file;
+    m_control = nullptr;
+    m_tuned = false;
+    m_netConfig = XGrabber::NetworkConfig();
     m_opened = true;
-    m_packetsReceived = 0;
-    m_packetsLost = 0;
-    m_linesReceived = 0;
+    resetStatistics();
+    m_metricLabels = Internal::MetricLabels("detector", "replay:" + file);
+    Internal::MetricsRegistry::instance().addCollector(this);
+    
+    HX_LOG_INFO("XGrabber") << "Opened replay of " << file;
+    
+    return true;
+}
+
+bool XGrabber::Impl::setReplaySpeed(double speed) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    if (m_grabbing) {
+        reportError(25, "Cannot change replay speed while grabbing");
+        return false;
+    }
     
-    std::cout << "[XGrabber] Opened successfully" << std::endl;
+    if (!(speed >= 0.0)) {
+        reportError(25, "Invalid replay speed");
+        return false;
+    }
+    
+    m_replaySpeed = speed;
+    return true;
+}
+
+bool XGrabber::Impl::openNetwork(XGrabber::NetworkConfig* config) {
+    if (m_queueCount > 1) {
+        // One socket per receive queue
+        Internal::XLibNetworkConfig request;
+        memset(&request, 0, sizeof(request));
+        strncpy(request.remoteIP, m_detector.GetIP().c_str(), sizeof(request.remoteIP) - 1);
+        request.imgPort = m_detector.GetImgPort();
+        request.localPort = m_detector.GetImgPort();
+        request.timeout = m_timeout;
+        if (config) {
+            request.bufferSize = config->recvBufferSize;
+            request.busyPollUs = config->busyPollUs;
+            request.timestamping = config->timestamping ? 1 : 0;
+            request.dscp = config->dscp;
+            m_netConfig = *config;
+        }
+        
+        if (!openQueues(request)) {
+            return false;
+        }
+    } else if (!config) {
+        // Initialize network for image reception
+        int32_t result = Internal::XLibProxy_InitNetwork(
+            m_detector.GetIP().c_str(),
+            m_detector.GetImgPort()
+        );
+        
+        if (result < 0) {
+            const char* errorMsg = Internal::XLibProxy_GetErrorMessage(result);
+            reportError(21, errorMsg);
+            return false;
+        }
+        
+        m_netConfig = XGrabber::NetworkConfig();
+    } else {
+        // Initialize network with explicit socket tuning
+        Internal::XLibNetworkConfig request;
+        memset(&request, 0, sizeof(request));
+        strncpy(request.remoteIP, m_detector.GetIP().c_str(), sizeof(request.remoteIP) - 1);
+        request.imgPort = m_detector.GetImgPort();
+        request.localPort = m_detector.GetImgPort();
+        request.timeout = m_timeout;
+        request.bufferSize = config->recvBufferSize;
+        request.busyPollUs = config->busyPollUs;
+        request.timestamping = config->timestamping ? 1 : 0;
+        request.dscp = config->dscp;
+        
+        Internal::XLibNetworkConfig effective = request;
+        int32_t result = Internal::XLibProxy_InitNetworkEx(&request, &effective);
+        
+        if (result < 0) {
+            const char* errorMsg = Internal::XLibProxy_GetErrorMessage(result);
+            reportError(21, errorMsg);
+            return false;
+        }
+        
+        // Report what the kernel actually granted
+        config->recvBufferSize = effective.bufferSize;
+        config->busyPollUs = effective.busyPollUs;
+        config->timestamping = effective.timestamping != 0;
+        config->dscp = effective.dscp;
+        m_netConfig = *config;
+        
+        if (request.bufferSize > 0 && effective.bufferSize < request.bufferSize) {
+            HX_LOG_INFO("XGrabber") << "Receive buffer clamped: requested " << request.bufferSize
+                                    << ", effective " << effective.bufferSize;
+        }
+    }
     
     return true;
 }
 
+void XGrabber::Impl::linkTo(XControl& control) {
+    // Outside m_mutex: notifications take it while XControl holds its own lock
+    if (m_linked != &control) {
+        if (m_linked) {
+            m_linked->removeLinkListener(this);
+        }
+        control.addLinkListener(this);
+        m_linked = &control;
+    }
+}
+
+void XGrabber::Impl::getNetworkConfig(XGrabber::NetworkConfig& config) const {
+    config = m_netConfig;
+}
+
 void XGrabber::Impl::close() {
+    if (m_linked) {
+        m_linked->removeLinkListener(this);
+        m_linked = nullptr;
+    }
+    Internal::MetricsRegistry::instance().removeCollector(this);
+    
     std::lock_guard<std::mutex> lock(m_mutex);
     
     if (!m_opened) {
         return;
     }
     
-    std::cout << "[XGrabber] Closing..." << std::endl;
+    m_resume = false;
     
-    // Stop grabbing if running
-    if (m_grabbing) {
+    HX_LOG_INFO("XGrabber") << "Closing...";
+    
+    // Stop grabbing if running; a replay that reached its end, or a
+    // Grab(frames) that completed, left its threads to be joined here
+    if (m_grabbing || m_grabThread.joinable() || m_assemblyThread.joinable() || m_assemblyShared ||
+        !m_queueThreads.empty()) {
         m_stopRequested = true;
         if (m_grabThread.joinable()) {
             m_grabThread.join();
         }
+        joinAssembly();
+        for (size_t q = 0; q < m_queueThreads.size(); ++q) {
+            if (m_queueThreads[q].joinable()) {
+                m_queueThreads[q].join();
+            }
+        }
+        m_queueThreads.clear();
+    }
+    if (m_frame) {
+        m_frame->setFrameListener(nullptr, 0);
     }
     
+    closeQueues();
+    delete m_replay;
+    m_replay = nullptr;
     m_opened = false;
     m_control = nullptr;
     
-    std::cout << "[XGrabber] Closed" << std::endl;
-    std::cout << "[XGrabber] Statistics:" << std::endl;
-    std::cout << "  Packets received: " << m_packetsReceived << std::endl;
-    std::cout << "  Packets lost: " << m_packetsLost << std::endl;
-    std::cout << "  Lines received: " << m_linesReceived << std::endl;
+    HX_LOG_INFO("XGrabber") << "Closed: " << m_packetsReceived << " packets received, "
+                            << m_packetsLost << " lost, " << m_linesReceived << " lines, ring high-water "
+                            << m_ring.highWater() << "/" << m_ring.capacity() << ", "
+                            << m_ringOverflows << " ring overflows, " << m_packetsDuplicate
+                            << " duplicates, " << m_packetsReordered << " reordered, "
+                            << m_packetsLate << " late, "
+                            << m_sequenceGaps << " gaps";
 }
 
 bool XGrabber::Impl::grab(uint32_t frames) {
     std::lock_guard<std::mutex> lock(m_mutex);
-    
+    return startGrab(frames);
+}
+
+bool XGrabber::Impl::startGrab(uint32_t frames) {
     if (!m_opened) {
         reportError(25, "XGrabber not opened");
         return false;
@@ -182,59 +681,251 @@ bool XGrabber::Impl::grab(uint32_t frames) {
         return false;
     }
     
-    std::cout << "[XGrabber] Starting acquisition..." << std::endl;
+    // Threads of a run that ended by itself, e.g. at the end of a replay
+    // or of a Grab(frames) sequence
+    if (m_grabThread.joinable()) {
+        m_grabThread.join();
+    }
+    joinAssembly();
+    for (size_t q = 0; q < m_queueThreads.size(); ++q) {
+        if (m_queueThreads[q].joinable()) {
+            m_queueThreads[q].join();
+        }
+    }
+    m_queueThreads.clear();
+    
+    if (m_replay) {
+        if (!m_replay->hasHeaders() && m_headerMode) {
+            reportError(26, "Stream file replay needs header mode off");
+            return false;
+        }
+        
+        // Every replay starts from the beginning of the capture
+        std::string error;
+        if (!m_replay->open(m_replayFile, m_detector.GetImgPort(), error)) {
+            reportError(26, error.c_str());
+            return false;
+        }
+    }
+    
+    HX_LOG_INFO("XGrabber") << "Starting acquisition...";
     
     m_framesToGrab = frames;
     m_framesGrabbed = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_sequenceMutex);
+        m_sequenceComplete = false;
+    }
+    m_lineIdState = LineIdState();
+    m_deviceClock.reset();
+    m_packetIdValid = false;
     m_grabbing = true;
     m_stopRequested = false;
     
-    // Start frame assembly
+    // A wake left over from the previous Stop() would cancel every receive
+    Internal::XLibProxy_ClearImageWake();
+    
+    // Start frame assembly; each receive queue thread adds lines itself
     uint32_t pixelCount = m_detector.GetPixelCount();
     uint8_t pixelDepth = m_detector.GetPixelDepth();
+    uint32_t lineBytes = pixelCount * ((pixelDepth + 7) / 8);
     
-    if (!m_frame->Start(pixelCount, pixelDepth)) {
-        reportError(26, "Failed to start frame assembly");
+    if (const char* error = layoutError(lineBytes)) {
+        reportError(26, error);
         m_grabbing = false;
         return false;
     }
     
-    // Start grab thread
-    m_grabThread = std::thread(&Impl::grabThread, this);
+    if (m_patternLines > 0) {
+        if (m_multi || !m_headerMode || m_frame->GetDualEnergy()) {
+            reportError(26, "Pattern checks need header mode and single-energy XFrame assembly");
+            m_grabbing = false;
+            return false;
+        }
+        if (!m_patternExpected.empty() &&
+            m_patternExpected.size() != static_cast<size_t>(m_patternLines) * lineBytes) {
+            reportError(26, "Test pattern does not hold its lines at this line size");
+            m_grabbing = false;
+            return false;
+        }
+        m_pattern.configure(m_patternExpected.empty() ? nullptr : &m_patternExpected[0], lineBytes,
+                            m_frame->GetSegments(), m_patternLines);
+    } else {
+        m_pattern.configure(nullptr, 0, 1, 0);
+    }
+    
+    if (m_multi) {
+        // The assembler is shared, so it is started once by the application
+        if (!m_multi->IsRunning() || m_multi->GetDetectorWidth(m_multiDetector) != pixelCount) {
+            reportError(26, "Multi-detector assembly not started for this detector");
+            m_grabbing = false;
+            return false;
+        }
+        if (m_zeroCopy || !m_queues.empty()) {
+            reportError(26, "Multi-detector assembly requires the packet ring");
+            m_grabbing = false;
+            return false;
+        }
+    } else {
+        if (m_frame->GetDualEnergy() && (!m_headerMode || m_zeroCopy)) {
+            reportError(26, "Dual-energy frames need header mode without zero-copy");
+            m_grabbing = false;
+            return false;
+        }
+        m_frame->SetProducerThreads(m_queues.empty() ? 1 : static_cast<uint32_t>(m_queues.size()));
+        
+        // XFrame counts the sequence and keeps lines past its last frame out
+        m_frame->setFrameListener(frames > 0 ? this : nullptr, frames);
+        if (!m_frame->Start(pixelCount, pixelDepth)) {
+            reportError(26, "Failed to start frame assembly");
+            m_grabbing = false;
+            return false;
+        }
+    }
+    
+    m_slotSize = slotSize(lineBytes);
+    
+    if (!m_queues.empty()) {
+        if (!m_headerMode) {
+            reportError(26, "Multi-queue receive requires header mode");
+            m_frame->Stop();
+            m_grabbing = false;
+            return false;
+        }
+        
+        // Each queue receives and assembles its own share of the modules
+        m_queueThreads.clear();
+        m_activeQueues = static_cast<uint32_t>(m_queues.size());
+        for (uint32_t q = 0; q < m_queues.size(); ++q) {
+            m_queueThreads.push_back(std::thread(&Impl::queueThread, this, q));
+        }
+        HX_LOG_INFO("XGrabber") << "Acquisition started (" << m_queues.size()
+                                << " receive queues)";
+        return true;
+    }
+    
+    if (m_zeroCopy && !m_replay) {
+        // Single thread receives into frame rows and assembles
+        m_grabThread = std::thread(&Impl::directThread, this);
+        HX_LOG_INFO("XGrabber") << "Acquisition started (zero-copy)";
+        return true;
+    }
+    
+    m_ring.reset(m_ringDepth);
+    if (m_replay || m_xdpInterface.empty() || !openXdp(lineBytes)) {
+        const uint64_t storeBytes = static_cast<uint64_t>(m_ring.capacity()) * m_slotSize;
+        if (storeBytes > m_packetStore.size() &&
+            !Internal::MemBudgetAdmit(storeBytes - m_packetStore.size())) {
+            reportError(26, "Receive ring does not fit the memory budget");
+            if (!m_multi) {
+                m_frame->Stop();
+            }
+            m_grabbing = false;
+            return false;
+        }
+        m_packetStore.resize(static_cast<size_t>(m_ring.capacity()) * m_slotSize);
+        m_store = m_packetStore.data();
+        if (!m_replay && m_ioUring) {
+            openUring();
+        }
+    }
+    m_memory.set(Internal::MemBytes(m_packetStore) +
+                 static_cast<uint64_t>(m_ring.capacity()) * sizeof(PacketDesc));
+    m_receiving = true;
+    
+    // Start assembly (consumer) before receive (producer)
+    beginAssembly();
+    m_assemblyShared = Internal::ServiceLoop::instance().add(&m_assemblyTask);
+    if (!m_assemblyShared) {
+        m_assemblyThread = std::thread(&Impl::assemblyThread, this);
+    }
+    if (m_replay) {
+        m_grabThread = std::thread(&Impl::replayThread, this);
+    } else {
+        const bool adaptive = m_receiveMode == XGrabber::RECEIVE_ADAPTIVE;
+        m_grabThread = std::thread(m_xdp >= 0 ? &Impl::xdpThread :
+                                   m_uringActive ? &Impl::uringThread :
+                                   adaptive ? &Impl::adaptiveThread : &Impl::grabThread, this);
+    }
     
-    std::cout << "[XGrabber] Acquisition started" << std::endl;
+    HX_LOG_INFO("XGrabber") << "Acquisition started"
+                            << (m_xdp >= 0 ? " (AF_XDP)" : m_uringActive ? " (io_uring)" : "");
     
     return true;
 }
 
 void XGrabber::Impl::grabThread() {
-    std::cout << "[XGrabber] Grab thread started" << std::endl;
+    Internal::ApplyThreadPolicy(XFactory::THREAD_RECEIVE);
+    
+    HX_LOG_DEBUG("XGrabber") << "Grab thread started (batch " << m_batchSize 
+                             << ", ring " << m_ring.capacity() << ")";
     
-    const uint32_t BUFFER_SIZE = 65536; // 64KB buffer
-    std::vector<uint8_t> buffer(BUFFER_SIZE);
+    const uint32_t batchSize = m_batchSize;
+    const uint32_t capacity = m_ring.capacity();
+    const uint32_t timeout = receiveTimeout();
+    std::vector<Internal::XLibPacketSlot> slots(batchSize);
+    std::vector<uint64_t> stamps(batchSize, 0);
+    std::vector<uint8_t> scratch(m_slotSize);
+    const bool timestamping = m_netConfig.timestamping;
     
     while (m_grabbing && !m_stopRequested) {
-        // Receive image data packet
-        int32_t bytesReceived = Internal::XLibProxy_ReceiveImageData(
-            buffer.data(),
-            BUFFER_SIZE,
-            m_timeout
-        );
+        uint32_t freeSlots = m_ring.freeSlots();
+        
+        if (freeSlots == 0) {
+            // Assembly is behind: drain the socket and drop rather than stall it
+            int32_t dropped = Internal::XLibProxy_ReceiveImageData(
+                scratch.data(),
+                m_slotSize,
+                timeout
+            );
+            if (dropped > 0) {
+                m_packetsReceived++;
+                m_ringOverflows++;
+            }
+            continue;
+        }
+        
+        // Slots must be contiguous in the packet store
+        uint32_t start = m_ring.nextIndex();
+        uint32_t count = batchSize;
+        if (count > freeSlots) count = freeSlots;
+        if (count > capacity - start) count = capacity - start;
+        
+        for (uint32_t i = 0; i < count; ++i) {
+            slots[i].buffer = m_packetStore.data() + static_cast<size_t>(start + i) * m_slotSize;
+            slots[i].bufferSize = m_slotSize;
+            slots[i].length = 0;
+        }
+        
+        const int32_t received = receiveSlots(slots.data(), stamps.data(), count, timeout);
         
-        if (bytesReceived < 0) {
-            if (bytesReceived == Internal::XLIB_ERROR_TIMEOUT) {
-                // Timeout is normal, continue
+        if (received < 0) {
+            if (isIdleResult(received)) {
+                // Timeout, empty poll or stop wake: re-check the loop condition
                 continue;
             } else {
-                const char* errorMsg = Internal::XLibProxy_GetErrorMessage(bytesReceived);
+                const char* errorMsg = Internal::XLibProxy_GetErrorMessage(received);
                 reportError(23, errorMsg);
                 break;
             }
         }
         
-        if (bytesReceived > 0) {
-            m_packetsReceived++;
-            processPacket(buffer.data(), static_cast<uint32_t>(bytesReceived));
+        // One stamp per receive call; a batch arrived together
+        const uint64_t receivedNs = Internal::TraceEnabled() ? Internal::TraceNow() : 0;
+        
+        // Publish every filled slot, empty ones too, to keep store and ring in step
+        for (int32_t i = 0; i < received; ++i) {
+            PacketDesc desc;
+            desc.slot = start + i;
+            desc.length = slots[i].length;
+            desc.offset = 0;
+            desc.receivedNs = receivedNs;
+            desc.hardwareNs = (count > 1 && timestamping) ? stamps[i] : 0;
+            m_ring.push(desc);
+            
+            if (desc.length > 0) {
+                m_packetsReceived++;
+            }
         }
         
         // Check if we've grabbed enough frames
@@ -243,103 +934,1585 @@ void XGrabber::Impl::grabThread() {
         }
     }
     
-    // Stop frame assembly
-    m_frame->Stop();
-    
-    m_grabbing = false;
+    m_receiving = false;
     
-    std::cout << "[XGrabber] Grab thread stopped" << std::endl;
+    HX_LOG_DEBUG("XGrabber") << "Grab thread stopped";
 }
 
-void XGrabber::Impl::processPacket(const uint8_t* packetData, uint32_t packetLen) {
-    // Extract packet header if in header mode
-    if (m_headerMode && packetLen >= 8) {
-        Internal::XLibPacketHeader header;
-        if (Internal::XLibProxy_ExtractPacketHeader(packetData, &header) == 0) {
-            // Process line data with header info
-            const uint8_t* lineData = packetData + 8; // Skip header
-            uint32_t lineLen = packetLen - 8;
-            
-            m_frame->AddLine(lineData, lineLen, header.lineId);
-            m_linesReceived++;
-        }
-    } else {
-        // Process raw line data without header
-        m_frame->AddLine(packetData, packetLen, m_linesReceived);
-        m_linesReceived++;
+int32_t XGrabber::Impl::receiveSlots(Internal::XLibPacketSlot* slots, uint64_t* stamps,
+                                     uint32_t count, uint32_t timeout) {
+    if (count > 1 && m_netConfig.timestamping) {
+        // Same batch, plus the NIC's receive time of every packet
+        return Internal::XLibProxy_ReceiveImageBatchTimed(slots, stamps, count, timeout);
     }
-}
-
-bool XGrabber::Impl::snap() {
-    if (!grab(1)) {
-        return false;
+    if (count > 1) {
+        // Receive up to count packets with a single call
+        return Internal::XLibProxy_ReceiveImageBatch(slots, count, timeout);
     }
-    
-    // Wait for frame to complete
-    while (m_grabbing && m_framesGrabbed < 1) {
-        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    int32_t received = Internal::XLibProxy_ReceiveImageData(slots[0].buffer, m_slotSize, timeout);
+    if (received > 0) {
+        slots[0].length = static_cast<uint32_t>(received);
+        received = 1;
     }
-    
-    stop();
-    
-    return true;
+    return received;
 }
 
-bool XGrabber::Impl::stop() {
-    if (!m_grabbing) {
-        return true;
-    }
+void XGrabber::Impl::adaptiveThread() {
+    Internal::ApplyThreadPolicy(XFactory::THREAD_RECEIVE);
     
-    std::cout << "[XGrabber] Stopping acquisition..." << std::endl;
+    HX_LOG_DEBUG("XGrabber") << "Adaptive grab thread started (batch up to " << m_batchSize
+                             << ", delay " << m_batchDelayUs << " us, ring " << m_ring.capacity() << ")";
     
-    m_stopRequested = true;
+    const uint32_t maxBatch = m_batchSize;
+    const uint32_t capacity = m_ring.capacity();
+    const uint64_t maxDelayNs = static_cast<uint64_t>(m_batchDelayUs) * 1000;
+    std::vector<Internal::XLibPacketSlot> slots(maxBatch);
+    std::vector<uint64_t> stamps(maxBatch, 0);
+    std::vector<uint8_t> scratch(m_slotSize);
+    const bool timestamping = m_netConfig.timestamping;
     
-    if (m_grabThread.joinable()) {
-        m_grabThread.join();
-    }
+    // Received packets not yet on the ring, in the slots after nextIndex()
+    std::vector<PacketDesc> pending;
+    pending.reserve(maxBatch);
+    uint64_t pendingSinceNs = 0;
+    uint64_t lastPacketNs = 0;
+    uint32_t target = 1;
+    m_adaptiveBatch = target;
     
-    m_grabbing = false;
+    while (m_grabbing && !m_stopRequested) {
+        const uint32_t freeSlots = m_ring.freeSlots();
+        if (freeSlots == 0) {
+            // Assembly is behind: drain the socket and drop rather than stall it
+            int32_t dropped = Internal::XLibProxy_ReceiveImageData(scratch.data(), m_slotSize, m_timeout);
+            if (dropped > 0) {
+                m_packetsReceived++;
+                m_ringOverflows++;
+            }
+            continue;
+        }
+        
+        // Slots must be contiguous in the packet store
+        const uint32_t start = m_ring.nextIndex() + static_cast<uint32_t>(pending.size());
+        uint32_t room = std::min(freeSlots, capacity - m_ring.nextIndex()) -
+                        static_cast<uint32_t>(pending.size());
+        room = std::min(room, maxBatch - static_cast<uint32_t>(pending.size()));
+        
+        int32_t received = 0;
+        uint64_t now = Internal::TraceNow();
+        if (room > 0) {
+            for (uint32_t i = 0; i < room; ++i) {
+                slots[i].buffer = m_packetStore.data() + static_cast<size_t>(start + i) * m_slotSize;
+                slots[i].bufferSize = m_slotSize;
+                slots[i].length = 0;
+            }
+            // Poll while a batch is open or the line was busy a moment
+            // ago, else sleep in the kernel until the next packet
+            const bool spin = !pending.empty() || (lastPacketNs && now - lastPacketNs < maxDelayNs);
+            received = receiveSlots(slots.data(), stamps.data(), room, spin ? 0 : m_timeout);
+            if (received < 0 && !isIdleResult(received)) {
+                reportError(23, Internal::XLibProxy_GetErrorMessage(received));
+                break;
+            }
+            now = Internal::TraceNow();
+        }
+        
+        if (received > 0) {
+            if (pending.empty()) {
+                pendingSinceNs = now;
+            }
+            lastPacketNs = now;
+            const uint64_t receivedNs = Internal::TraceEnabled() ? now : 0;
+            for (int32_t i = 0; i < received; ++i) {
+                PacketDesc desc;
+                desc.slot = start + i;
+                desc.length = slots[i].length;
+                desc.offset = 0;
+                desc.receivedNs = receivedNs;
+                desc.hardwareNs = (room > 1 && timestamping) ? stamps[i] : 0;
+                pending.push_back(desc);
+                if (desc.length > 0) {
+                    m_packetsReceived++;
+                }
+            }
+        }
+        
+        if (pending.empty()) {
+            if (received <= 0 && lastPacketNs && now - lastPacketNs < maxDelayNs) {
+                std::this_thread::yield();
+            }
+            continue;
+        }
+        
+        // Hand the batch on once it is full, or its first packet has
+        // waited the longest allowed
+        const uint32_t size = static_cast<uint32_t>(pending.size());
+        const bool full = size >= target || room == 0 || received == static_cast<int32_t>(room);
+        if (!full && now - pendingSinceNs < maxDelayNs) {
+            std::this_thread::yield();
+            continue;
+        }
+        for (uint32_t i = 0; i < size; ++i) {
+            m_ring.push(pending[i]);
+        }
+        pending.clear();
+        
+        // Grow while the socket holds more than a batch, shrink to what
+        // arrives within the delay
+        if (full && size > target) {
+            target = std::min(maxBatch, target * 2);
+        } else if (!full) {
+            target = size;
+        }
+        m_adaptiveBatch = target;
+        
+        // Check if we've grabbed enough frames
+        if (m_framesToGrab > 0 && m_framesGrabbed >= m_framesToGrab) {
+            break;
+        }
+    }
     
-    std::cout << "[XGrabber] Acquisition stopped" << std::endl;
+    // Lines already received still go to assembly
+    for (size_t i = 0; i < pending.size(); ++i) {
+        m_ring.push(pending[i]);
+    }
+    m_receiving = false;
     
-    return true;
+    HX_LOG_DEBUG("XGrabber") << "Adaptive grab thread stopped";
 }
 
-void XGrabber::Impl::setFrame(XFrame& frame) {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    
-    if (m_grabbing) {
-        reportError(25, "Cannot set frame while grabbing");
-        return;
+bool XGrabber::Impl::openXdp(uint32_t lineBytes) {
+    const uint32_t frameSize = Internal::XLIB_XDP_FRAME_SIZE;
+    const uint32_t packetBytes = lineBytes + (m_headerMode ? 8 : 0);
+    if (lineBytes == 0 || packetBytes > frameSize - Internal::XLIB_XDP_PAYLOAD_OFFSET) {
+        HX_LOG_WARNING("XGrabber") << "Line packets of " << packetBytes
+                                   << " bytes do not fit an AF_XDP frame, using the socket";
+        return false;
     }
     
-    m_frame = &frame;
-}
-
-void XGrabber::Impl::reportError(uint32_t errorId, const char* message) {
-    std::cerr << "[XGrabber] ERROR " << errorId << ": " << message << std::endl;
+    // One frame per ring slot, page aligned inside the store
+    const uint64_t umemSize = static_cast<uint64_t>(m_ring.capacity()) * frameSize;
+    m_packetStore.resize(static_cast<size_t>(umemSize) + frameSize);
+    const uintptr_t base = reinterpret_cast<uintptr_t>(m_packetStore.data());
+    uint8_t* umem = m_packetStore.data() + ((frameSize - base % frameSize) % frameSize);
     
-    if (m_sink) {
-        m_sink->OnXError(errorId, message);
-    }
-}
-
-void XGrabber::Impl::reportEvent(uint32_t eventId, uint32_t data) {
-    if (m_sink) {
-        m_sink->OnXEvent(eventId, data);
+    Internal::XLibXdpConfig config;
+    memset(&config, 0, sizeof(config));
+    strncpy(config.interfaceName, m_xdpInterface.c_str(), sizeof(config.interfaceName) - 1);
+    strncpy(config.remoteIP, m_detector.GetIP().c_str(), sizeof(config.remoteIP) - 1);
+    config.queueId = m_xdpQueue;
+    config.imgPort = m_detector.GetImgPort();
+    config.frameSize = frameSize;
+    config.flags = (m_receiveMode == XGrabber::RECEIVE_BUSY_POLL) ? Internal::XLIB_XDP_BUSY_POLL : 0;
+    
+    const int32_t handle = Internal::XLibProxy_OpenImageXdp(&config, umem, umemSize);
+    if (handle < 0) {
+        HX_LOG_WARNING("XGrabber") << "AF_XDP on " << m_xdpInterface << " queue " << m_xdpQueue
+                                   << " unavailable (" << Internal::XLibProxy_GetErrorMessage(handle)
+                                   << "), using the socket";
+        return false;
     }
+    
+    m_xdp = handle;
+    m_store = umem;
+    m_slotSize = frameSize;
+    return true;
 }
 
-// XGrabber public interface
-XGrabber::XGrabber()
-    : m_impl(new Impl())
-{
+void XGrabber::Impl::releaseXdp(std::vector<uint64_t>& frames) {
+    Internal::XLibProxy_ReleaseImageXdp(m_xdp, frames.data(), static_cast<uint32_t>(frames.size()));
+    frames.clear();
 }
 
-XGrabber::~XGrabber() {
-    if (m_impl) {
-        delete m_impl;
-        m_impl = nullptr;
+void XGrabber::Impl::xdpThread() {
+    Internal::ApplyThreadPolicy(XFactory::THREAD_RECEIVE);
+    
+    HX_LOG_DEBUG("XGrabber") << "AF_XDP receive thread started (batch " << m_batchSize
+                             << ", " << m_ring.capacity() << " frames)";
+    
+    const uint32_t batchSize = m_batchSize;
+    const uint32_t timeout = receiveTimeout();
+    const int32_t handle = m_xdp;
+    std::vector<Internal::XLibXdpDesc> descs(batchSize);
+    
+    while (m_grabbing && !m_stopRequested) {
+        // Frames still with the kernel never outnumber the free ring slots,
+        // since each one maps to its own slot
+        const uint32_t count = std::min(batchSize, m_ring.freeSlots());
+        if (count == 0) {
+            std::this_thread::yield();
+            continue;
+        }
+        
+        int32_t received = Internal::XLibProxy_ReceiveImageXdp(handle, descs.data(), count, timeout);
+        
+        if (received < 0) {
+            if (isIdleResult(received)) {
+                continue;
+            }
+            reportError(23, Internal::XLibProxy_GetErrorMessage(received));
+            break;
+        }
+        
+        const uint64_t receivedNs = Internal::TraceEnabled() ? Internal::TraceNow() : 0;
+        
+        for (int32_t i = 0; i < received; ++i) {
+            PacketDesc desc;
+            desc.slot = static_cast<uint32_t>(descs[i].addr / m_slotSize);
+            desc.offset = static_cast<uint32_t>(descs[i].addr % m_slotSize);
+            desc.length = descs[i].length;
+            desc.receivedNs = receivedNs;
+            desc.hardwareNs = 0;
+            m_ring.push(desc);
+            m_packetsReceived++;
+        }
+        
+        // Check if we've grabbed enough frames
+        if (m_framesToGrab > 0 && m_framesGrabbed >= m_framesToGrab) {
+            break;
+        }
+    }
+    
+    m_receiving = false;
+    
+    HX_LOG_DEBUG("XGrabber") << "AF_XDP receive thread stopped";
+}
+
+bool XGrabber::Impl::openUring() {
+    // Buffer ids are 16 bits
+    if (m_ring.capacity() > 32768) {
+        HX_LOG_WARNING("XGrabber") << "Ring depth " << m_ring.capacity()
+                                   << " exceeds the io_uring buffer ids, using the socket";
+        return false;
+    }
+    
+    const int32_t socket = Internal::XLibProxy_GetImageSocket();
+    if (socket < 0) {
+        HX_LOG_WARNING("XGrabber") << "Image socket not available for io_uring ("
+                                   << Internal::XLibProxy_GetErrorMessage(socket)
+                                   << "), using the socket receive calls";
+        return false;
+    }
+    
+    std::lock_guard<std::mutex> lock(m_uringMutex);
+    if (!m_uring.open(256)) {
+        Internal::XLibProxy_ReleaseImageSocket();
+        HX_LOG_WARNING("XGrabber") << "io_uring unavailable, using the socket receive calls";
+        return false;
+    }
+    
+    m_uringSocket = socket;
+    m_uringReleased = 0;
+    m_uringActive = true;
+    return true;
+}
+
+void XGrabber::Impl::uringThread() {
+    Internal::ApplyThreadPolicy(XFactory::THREAD_RECEIVE);
+    
+    HX_LOG_DEBUG("XGrabber") << "io_uring receive thread started (" << m_ring.capacity()
+                             << " buffers)";
+    
+    enum { TAG_RECEIVE = 1, TAG_BUFFERS, TAG_WAKE };
+    
+    const uint32_t capacity = m_ring.capacity();
+    const bool busyPoll = m_receiveMode == XGrabber::RECEIVE_BUSY_POLL;
+    const uint32_t timeout = receiveTimeout();
+    Internal::IoRing& ring = m_uring;
+    std::vector<Internal::IoCompletion> completions(256);
+    
+    // Buffers handed to the kernel and buffers it has filled, ever; each
+    // filled one is a ring slot, so the ring cannot overflow
+    uint64_t provided = 0;
+    uint64_t filled = 0;
+    bool armed = false;
+    bool failed = false;
+    
+    ring.pollWake(TAG_WAKE);
+    
+    while (m_grabbing && !m_stopRequested && !failed) {
+        // The kernel fills buffers in the order they were provided and
+        // assembly frees them in the order they were filled, so the freed
+        // ones are always the next run of slot numbers
+        const uint64_t released = m_uringReleased.load(std::memory_order_acquire);
+        while (provided < released + capacity && ring.spaceLeft() > 1) {
+            const uint32_t first = static_cast<uint32_t>(provided % capacity);
+            const uint32_t count = static_cast<uint32_t>(
+                std::min<uint64_t>(released + capacity - provided, capacity - first));
+            ring.provideBuffers(m_store, static_cast<uint16_t>(first), count, m_slotSize, TAG_BUFFERS);
+            provided += count;
+        }
+        
+        // A multishot receive ends when it runs out of buffers
+        const bool starved = provided == filled;
+        if (!armed && !starved) {
+            armed = ring.receiveMultishot(m_uringSocket, TAG_RECEIVE);
+        }
+        
+        const int submitted = ring.submit((busyPoll || starved) ? 0 : 1, timeout);
+        if (submitted < 0 && submitted != -ETIME && submitted != -EINTR && submitted != -EBUSY) {
+            reportError(23, strerror(-submitted));
+            break;
+        }
+        
+        const uint32_t count = ring.reap(completions.data(), static_cast<uint32_t>(completions.size()));
+        if (count == 0) {
+            if (starved) {
+                // Assembly is behind; the socket buffer absorbs the burst
+                std::this_thread::yield();
+            }
+            continue;
+        }
+        
+        const uint64_t receivedNs = Internal::TraceEnabled() ? Internal::TraceNow() : 0;
+        
+        for (uint32_t i = 0; i < count; ++i) {
+            const Internal::IoCompletion& c = completions[i];
+            if (c.tag == TAG_RECEIVE) {
+                if (c.buffer() >= 0) {
+                    PacketDesc desc;
+                    desc.slot = static_cast<uint32_t>(c.buffer());
+                    desc.length = c.result > 0 ? static_cast<uint32_t>(c.result) : 0;
+                    desc.offset = 0;
+                    desc.receivedNs = receivedNs;
+                    desc.hardwareNs = 0;
+                    m_ring.push(desc);
+                    ++filled;
+                    if (desc.length > 0) {
+                        m_packetsReceived++;
+                    }
+                }
+                if (!c.more()) {
+                    armed = false;
+                    if (c.result < 0 && c.result != -ENOBUFS && c.result != -ECANCELED) {
+                        reportError(23, strerror(-c.result));
+                        failed = true;
+                    }
+                }
+            } else if (c.tag == TAG_BUFFERS && c.result < 0) {
+                reportError(23, strerror(-c.result));
+                failed = true;
+            }
+            // TAG_WAKE: Stop() has set m_stopRequested already
+        }
+        
+        // Check if we've grabbed enough frames
+        if (m_framesToGrab > 0 && m_framesGrabbed >= m_framesToGrab) {
+            break;
+        }
+    }
+    
+    // Closing the ring cancels the receive; the slots stay with assembly
+    {
+        std::lock_guard<std::mutex> lock(m_uringMutex);
+        ring.close();
+        m_uringActive = false;
+    }
+    Internal::XLibProxy_ReleaseImageSocket();
+    m_uringSocket = -1;
+    m_receiving = false;
+    
+    HX_LOG_DEBUG("XGrabber") << "io_uring receive thread stopped";
+}
+
+void XGrabber::Impl::replayThread() {
+    Internal::ApplyThreadPolicy(XFactory::THREAD_RECEIVE);
+    
+    HX_LOG_DEBUG("XGrabber") << "Replay thread started (speed " << m_replaySpeed 
+                             << ", ring " << m_ring.capacity() << ")";
+    
+    typedef std::chrono::steady_clock Clock;
+    const double speed = m_replaySpeed;
+    Clock::time_point start;
+    uint64_t firstUs = 0;
+    uint64_t replayed = 0;
+    bool finished = false;
+    
+    while (m_grabbing && !m_stopRequested) {
+        if (m_ring.freeSlots() == 0) {
+            // Unlike the network, a replay waits for the assembly
+            std::this_thread::sleep_for(std::chrono::microseconds(20));
+            continue;
+        }
+        
+        const uint32_t slot = m_ring.nextIndex();
+        uint64_t timeUs = 0;
+        const int32_t length = m_replay->next(
+            m_packetStore.data() + static_cast<size_t>(slot) * m_slotSize, m_slotSize, timeUs);
+        
+        if (length == 0) {
+            finished = true;
+            break;
+        }
+        if (length < 0) {
+            reportError(23, "Capture read failed");
+            break;
+        }
+        
+        if (speed > 0.0) {
+            // Release each packet at its capture time, scaled by the speed
+            if (replayed == 0) {
+                firstUs = timeUs;
+                start = Clock::now();
+            } else if (timeUs > firstUs) {
+                const Clock::time_point due = start + std::chrono::duration_cast<Clock::duration>(
+                    std::chrono::duration<double, std::micro>((timeUs - firstUs) / speed));
+                while (!m_stopRequested && Clock::now() < due) {
+                    std::this_thread::sleep_until(
+                        std::min(due, Clock::now() + std::chrono::milliseconds(10)));
+                }
+            }
+        }
+        
+        PacketDesc desc;
+        desc.slot = slot;
+        desc.length = static_cast<uint32_t>(length);
+        desc.offset = 0;
+        desc.receivedNs = Internal::TraceEnabled() ? Internal::TraceNow() : 0;
+        desc.hardwareNs = 0;
+        m_ring.push(desc);
+        m_packetsReceived++;
+        replayed++;
+        
+        if (m_framesToGrab > 0 && m_framesGrabbed >= m_framesToGrab) {
+            break;
+        }
+    }
+    
+    m_receiving = false;
+    
+    if (m_replay->oversized() > 0) {
+        HX_LOG_WARNING("XGrabber") << "Replay skipped " << m_replay->oversized()
+                                   << " packets larger than a receive slot";
+    }
+    HX_LOG_DEBUG("XGrabber") << "Replay thread stopped after " << replayed << " packets";
+    
+    if (finished) {
+        reportEvent(115, static_cast<uint32_t>(replayed));
+    }
+}
+
+void XGrabber::Impl::assemblyThread() {
+    Internal::ApplyThreadPolicy(XFactory::THREAD_ASSEMBLY);
+    
+    HX_LOG_DEBUG("XGrabber") << "Assembly thread started";
+    
+    for (;;) {
+        const AssemblyState state = assembleSlice(256);
+        if (state == ASSEMBLY_BUSY) {
+            continue;
+        }
+        if (state == ASSEMBLY_DONE) {
+            break;
+        }
+        
+        // Spin briefly, then back off so an idle line does not burn a core
+        if (++m_idleSpins < 1000) {
+            std::this_thread::yield();
+        } else if (m_receiveMode == XGrabber::RECEIVE_BUSY_POLL) {
+            // Dedicated core: keep spinning, only check for stalled frames
+            if (!m_multi) {
+                m_frame->Poll();
+            }
+            m_idleSpins = 0;
+        } else {
+            if (!m_multi) {
+                m_frame->Poll();
+            }
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+    }
+    
+    finishAssembly();
+}
+
+bool XGrabber::Impl::assemblyPoll() {
+    if (m_assemblyDone) {
+        return false;
+    }
+    
+    const AssemblyState state = assembleSlice(256);
+    if (state == ASSEMBLY_BUSY) {
+        return true;
+    }
+    if (state == ASSEMBLY_DONE) {
+        finishAssembly();
+        m_assemblyDone = true;
+        return true;
+    }
+    
+    // The loop does the backing off; stalled frames are checked each millisecond
+    if (!m_multi) {
+        const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        if (now >= m_nextFramePoll) {
+            m_nextFramePoll = now + std::chrono::milliseconds(1);
+            m_frame->Poll();
+        }
+    }
+    return false;
+}
+
+void XGrabber::Impl::beginAssembly() {
+    m_assemblyDone = false;
+    m_assemblyXdp = m_xdp >= 0;
+    m_assemblyUring = m_uringActive;
+    m_released.clear();
+    m_consumed = 0;
+    m_idleSpins = 0;
+    m_nextFramePoll = std::chrono::steady_clock::now();
+}
+
+XGrabber::Impl::AssemblyState XGrabber::Impl::assembleSlice(uint32_t budget) {
+    // Lines waiting for assembly are the first sign of a slow pipeline
+    m_overload.report(m_ring.size(), m_ring.capacity());
+    
+    PacketDesc desc;
+    for (uint32_t n = 0; n < budget; ++n) {
+        if (!m_ring.peek(desc)) {
+            break;
+        }
+        uint8_t* packet = m_store + static_cast<size_t>(desc.slot) * m_slotSize;
+        if (desc.length > 0) {
+            uint64_t dequeuedNs = 0;
+            if (desc.receivedNs) {
+                dequeuedNs = Internal::TraceNow();
+                Internal::TraceRecord(XFactory::TRACE_RING, desc.receivedNs, dequeuedNs);
+            }
+            Internal::TraceSetLine(desc.receivedNs, dequeuedNs);
+            processPacket(packet + desc.offset, desc.length, desc.hardwareNs);
+        }
+        m_ring.consume();
+        m_idleSpins = 0;
+        
+        // The line is copied out; hand the frame back to the NIC
+        if (m_assemblyXdp) {
+            m_released.push_back(static_cast<uint64_t>(packet - m_store));
+            if (m_released.size() >= 64) {
+                releaseXdp(m_released);
+            }
+        } else if (m_assemblyUring && ++m_consumed % 64 == 0) {
+            m_uringReleased.store(m_consumed, std::memory_order_release);
+        }
+        if (n + 1 == budget) {
+            return ASSEMBLY_BUSY;
+        }
+    }
+    
+    if (!m_released.empty()) {
+        releaseXdp(m_released);
+    }
+    if (m_assemblyUring) {
+        m_uringReleased.store(m_consumed, std::memory_order_release);
+    }
+    
+    // Receiver finished and ring drained
+    if (!m_receiving && m_ring.empty()) {
+        return ASSEMBLY_DONE;
+    }
+    return ASSEMBLY_IDLE;
+}
+
+void XGrabber::Impl::finishAssembly() {
+    m_overload.clear();
+    
+    // Ring drained, so no frame of the UMEM is in use any more
+    if (m_assemblyXdp) {
+        Internal::XLibProxy_CloseImageXdp(m_xdp);
+        m_xdp = -1;
+    }
+    
+    // Stop frame assembly; a shared assembler is stopped by its owner
+    if (!m_multi) {
+        m_frame->Stop();
+    }
+    
+    endGrab();
+    
+    HX_LOG_DEBUG("XGrabber") << "Assembly stopped";
+}
+
+void XGrabber::Impl::joinAssembly() {
+    if (m_assemblyThread.joinable()) {
+        m_assemblyThread.join();
+    }
+    if (m_assemblyShared) {
+        // Drains like the thread would once the receiver has finished
+        while (!m_assemblyDone) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        Internal::ServiceLoop::instance().remove(&m_assemblyTask);
+        m_assemblyShared = false;
+    }
+}
+
+void XGrabber::Impl::directThread() {
+    // Receive and assembly share this thread in zero-copy mode
+    Internal::ApplyThreadPolicy(XFactory::THREAD_RECEIVE);
+    
+    HX_LOG_DEBUG("XGrabber") << "Direct receive thread started";
+    
+    uint8_t header[Internal::XLIB_UDP_HEADER_SIZE];
+    uint32_t headerSize = m_headerMode ? Internal::XLIB_PACKET_HEADER_SIZE : 0;
+    uint32_t nextLineId = 0;
+    const uint32_t timeout = receiveTimeout();
+    uint32_t idlePolls = 0;
+    Internal::DeviceClock clock;
+    
+    while (m_grabbing && !m_stopRequested) {
+        // Predict the next row so the payload lands in place
+        uint32_t lineLen = 0;
+        uint8_t* row = m_frame->GetLineBuffer(nextLineId, lineLen);
+        if (!row) {
+            reportError(23, "Frame buffer not available");
+            break;
+        }
+        
+        int32_t received = Internal::XLibProxy_ReceiveImageScatter(
+            header,
+            headerSize,
+            row,
+            lineLen,
+            timeout
+        );
+        
+        if (received < 0) {
+            if (isIdleResult(received)) {
+                // Nothing queued, flush a stalled partial frame
+                if (timeout > 0 || (++idlePolls & 1023) == 0) {
+                    m_frame->Poll();
+                }
+                continue;
+            } else if (received == Internal::XLIB_ERROR_BUFFER_OVERFLOW) {
+                // Oversized packet, the row is reused by the next receive
+                m_packetsReceived++;
+                reportError(23, "Packet larger than frame line");
+                continue;
+            } else {
+                const char* errorMsg = Internal::XLibProxy_GetErrorMessage(received);
+                reportError(23, errorMsg);
+                break;
+            }
+        }
+        
+        if (static_cast<uint32_t>(received) < headerSize) {
+            continue;
+        }
+        
+        m_packetsReceived++;
+        
+        if (Internal::TraceEnabled()) {
+            // No ring: the line is placed by the thread that received it
+            const uint64_t now = Internal::TraceNow();
+            Internal::TraceSetLine(now, now);
+        }
+        
+        uint32_t lineId = static_cast<uint32_t>(m_linesReceived);
+        const Internal::XLibPacketView h(header);
+        if (m_headerMode) {
+            trackPacketId(h.packetId());
+            lineId = unwrapLineId(m_lineIdState, h.lineId());
+        }
+        
+        if (m_flight) {
+            m_flight->AddLine(row, static_cast<uint32_t>(received) - headerSize, lineId);
+        }
+        if (m_headerMode) {
+            checkPattern(row, static_cast<uint32_t>(received) - headerSize, lineId, 0);
+            if (h.frameTrigger()) {
+                m_frame->Trigger(lineId);
+            }
+            // The scatter receive carries no hardware stamp
+            m_frame->CommitLine(row, static_cast<uint32_t>(received) - headerSize, lineId,
+                                lineTime(clock, h, 0));
+        } else {
+            m_frame->CommitLine(row, static_cast<uint32_t>(received) - headerSize, lineId);
+        }
+        m_linesReceived++;
+        nextLineId = lineId + 1;
+        
+        // Check if we've grabbed enough frames
+        if (m_framesToGrab > 0 && m_framesGrabbed >= m_framesToGrab) {
+            break;
+        }
+    }
+    
+    // Stop frame assembly
+    m_frame->Stop();
+    
+    endGrab();
+    
+    HX_LOG_DEBUG("XGrabber") << "Direct receive thread stopped";
+}
+
+bool XGrabber::Impl::checkPacket(const uint8_t* packetData, uint32_t& packetLen) {
+    if (!m_packetCheck) {
+        return true;
+    }
+    if (packetLen < Internal::XLIB_PACKET_CRC_SIZE || !Internal::XLib_VerifyCRC16(packetData, packetLen)) {
+        m_packetsCorrupt++;
+        return false;
+    }
+    packetLen -= Internal::XLIB_PACKET_CRC_SIZE;
+    return true;
+}
+
+const char* XGrabber::Impl::layoutError(uint32_t lineBytes) const {
+    const bool packed = m_layout.linesPerPacket > 1 || m_layout.fragmentBytes > 0;
+    if (packed && !m_headerMode) {
+        return "Packet layouts need header mode";
+    }
+    if ((packed || m_packetCheck) && m_zeroCopy && !m_replay) {
+        return "Packet layouts and checksums need the packet ring or receive queues";
+    }
+    if (m_layout.fragmentBytes > 0) {
+        if (m_multi || m_frame->GetDualEnergy()) {
+            return "Split lines need single-energy XFrame assembly";
+        }
+        if (lineBytes % m_layout.fragmentBytes != 0 ||
+            lineBytes / m_layout.fragmentBytes != m_frame->GetSegments()) {
+            return "XFrame segments must be line bytes / fragmentBytes";
+        }
+    }
+    return nullptr;
+}
+
+void XGrabber::Impl::deliverPacket(const uint8_t* packetData, uint32_t packetLen, LineIdState& lineIds,
+                                   Internal::DeviceClock& clock, uint64_t hardwareNs, bool trackIds) {
+    const uint32_t records = m_layout.linesPerPacket;
+    const uint32_t headerSize = m_layout.fragmentBytes ? Internal::XLIB_FRAGMENT_HEADER_SIZE
+                                                       : Internal::XLIB_PACKET_HEADER_SIZE;
+    if (packetLen % records != 0 || packetLen / records < headerSize) {
+        return;
+    }
+    const uint32_t recordLen = packetLen / records;
+    
+    for (uint32_t r = 0; r < records; ++r) {
+        // The header is read where it was received
+        const uint8_t* record = packetData + static_cast<size_t>(r) * recordLen;
+        const Internal::XLibPacketView header(record);
+        const uint8_t* lineData = record + headerSize;
+        const uint32_t lineLen = recordLen - headerSize;
+        
+        if (trackIds && r == 0) {
+            trackPacketId(header.packetId());
+        }
+        const uint32_t lineId = unwrapLineId(lineIds, header.lineId());
+        const XFrame::LineTime time = lineTime(clock, header, hardwareNs);
+        if (m_flight) {
+            m_flight->AddLine(lineData, lineLen, lineId);
+        }
+        if (m_multi) {
+            m_multi->AddLine(m_multiDetector, lineData, lineLen, lineId, time);
+        } else {
+            deliverLine(lineData, lineLen, lineId, header, time);
+        }
+        m_linesReceived++;
+    }
+}
+
+void XGrabber::Impl::processPacket(const uint8_t* packetData, uint32_t packetLen, uint64_t hardwareNs) {
+    if (!checkPacket(packetData, packetLen)) {
+        if (m_headerMode && packetLen >= Internal::XLIB_PACKET_HEADER_SIZE) {
+            // Already counted as corrupt, so not as lost as well
+            trackPacketId(Internal::XLibPacketView(packetData).packetId(), true);
+        }
+        return;
+    }
+    
+    if (m_headerMode && packetLen >= Internal::XLIB_PACKET_HEADER_SIZE) {
+        deliverPacket(packetData, packetLen, m_lineIdState, m_deviceClock, hardwareNs, true);
+    } else if (m_multi) {
+        if (m_flight) {
+            m_flight->AddLine(packetData, packetLen, static_cast<uint32_t>(m_linesReceived));
+        }
+        // Without headers detectors can only be aligned by line count
+        m_multi->AddLine(m_multiDetector, packetData, packetLen,
+                         static_cast<uint32_t>(m_linesReceived), 0);
+        m_linesReceived++;
+    } else {
+        // Process raw line data without header
+        if (m_flight) {
+            m_flight->AddLine(packetData, packetLen, static_cast<uint32_t>(m_linesReceived));
+        }
+        m_frame->AddLine(packetData, packetLen, static_cast<uint32_t>(m_linesReceived));
+        m_linesReceived++;
+    }
+}
+
+uint32_t XGrabber::Impl::receiveTimeout() const {
+    // Zero asks the proxy to poll the socket once and return immediately
+    return (m_receiveMode == XGrabber::RECEIVE_BUSY_POLL) ? 0 : m_timeout;
+}
+
+bool XGrabber::Impl::isIdleResult(int32_t result) const {
+    return result == Internal::XLIB_ERROR_TIMEOUT ||
+           result == Internal::XLIB_ERROR_CANCELLED;
+}
+
+uint32_t XGrabber::Impl::unwrapLineId(LineIdState& state, uint16_t lineId) {
+    if (!state.valid) {
+        state.ext = lineId;
+        state.valid = true;
+    } else {
+        // Signed 16-bit distance handles both wrap-around and reordering
+        state.ext += static_cast<int16_t>(static_cast<uint16_t>(lineId - state.last));
+    }
+    state.last = lineId;
+    return state.ext;
+}
+
+XFrame::LineTime XGrabber::Impl::lineTime(Internal::DeviceClock& clock,
+                                          const Internal::XLibPacketView& header,
+                                          uint64_t hardwareNs) {
+    XFrame::LineTime time;
+    time.receiveNs = hardwareNs;
+    
+    // Without a NIC stamp the host clock now is the reference; the filter absorbs the delay
+    const uint64_t referenceNs = hardwareNs ? hardwareNs : Internal::HostTimeNs();
+    time.deviceUs = clock.unwrap(header.timestamp());
+    if (time.deviceUs) {
+        clock.observe(time.deviceUs, referenceNs);
+        time.hostNs = clock.toReference(time.deviceUs);
+    } else {
+        // Detector sends no timestamps: the line is timed by its arrival
+        time.hostNs = referenceNs;
+    }
+    return time;
+}
+
+void XGrabber::Impl::deliverLine(const uint8_t* lineData, uint32_t lineLen, uint32_t lineId,
+                                 const Internal::XLibPacketView& header, const XFrame::LineTime& time) {
+    if (header.frameTrigger()) {
+        // Opens a frame only with SetFrameTrigger(); every module's packet carries it
+        m_frame->Trigger(lineId);
+    }
+    if (m_frame->GetDualEnergy()) {
+        // Interleaved high/low lines land in their own planes
+        m_frame->AddEnergyLine(lineData, lineLen, lineId, header.energyFlag(), time);
+    } else if (m_layout.fragmentBytes > 0 && m_frame->GetSegments() > 1) {
+        // Packet carries one fragment; misplaced offsets are dropped, not clamped
+        const uint32_t offset = header.fragmentOffset();
+        if (offset % m_layout.fragmentBytes == 0) {
+            checkPattern(lineData, lineLen, lineId, offset / m_layout.fragmentBytes);
+            m_frame->AddSegment(lineData, lineLen, lineId, offset / m_layout.fragmentBytes, time);
+        }
+    } else if (m_frame->GetSegments() > 1) {
+        // Packet carries one DM module's share of the line
+        checkPattern(lineData, lineLen, lineId, header.moduleId());
+        m_frame->AddSegment(lineData, lineLen, lineId, header.moduleId(), time);
+    } else {
+        checkPattern(lineData, lineLen, lineId, 0);
+        m_frame->AddLine(lineData, lineLen, lineId, time);
+    }
+}
+
+bool XGrabber::Impl::openQueues(const Internal::XLibNetworkConfig& request) {
+    for (uint32_t q = 0; q < m_queueCount; ++q) {
+        int32_t handle = Internal::XLibProxy_OpenImageQueue(&request, q, m_queueCount);
+        if (handle < 0) {
+            reportError(21, Internal::XLibProxy_GetErrorMessage(handle));
+            closeQueues();
+            return false;
+        }
+        m_queues.push_back(handle);
+    }
+    return true;
+}
+
+void XGrabber::Impl::closeQueues() {
+    for (size_t q = 0; q < m_queues.size(); ++q) {
+        Internal::XLibProxy_CloseImageQueue(m_queues[q]);
+    }
+    m_queues.clear();
+}
+
+void XGrabber::Impl::queueThread(uint32_t queue) {
+    Internal::ApplyThreadPolicy(XFactory::THREAD_RECEIVE);
+    
+    const uint32_t batchSize = m_batchSize;
+    const int32_t handle = m_queues[queue];
+    const uint32_t timeout = receiveTimeout();
+    uint32_t idlePolls = 0;
+    
+    std::vector<uint8_t> buffer(static_cast<size_t>(m_slotSize) * batchSize);
+    std::vector<Internal::XLibPacketSlot> slots(batchSize);
+    std::vector<uint8_t> corrupt(batchSize);
+    LineIdState lineIds;
+    Internal::DeviceClock clock;
+    
+    while (m_grabbing && !m_stopRequested) {
+        for (uint32_t i = 0; i < batchSize; ++i) {
+            slots[i].buffer = buffer.data() + static_cast<size_t>(i) * m_slotSize;
+            slots[i].bufferSize = m_slotSize;
+            slots[i].length = 0;
+        }
+        
+        int32_t received = Internal::XLibProxy_ReceiveImageQueue(
+            handle,
+            slots.data(),
+            batchSize,
+            timeout
+        );
+        
+        if (received < 0) {
+            if (isIdleResult(received)) {
+                if (timeout > 0 || (++idlePolls & 1023) == 0) {
+                    m_frame->Poll();
+                }
+                continue;
+            }
+            reportError(23, Internal::XLibProxy_GetErrorMessage(received));
+            break;
+        }
+        
+        if (Internal::TraceEnabled()) {
+            const uint64_t now = Internal::TraceNow();
+            Internal::TraceSetLine(now, now);
+        }
+        
+        for (int32_t i = 0; i < received; ++i) {
+            if (slots[i].length < Internal::XLIB_PACKET_HEADER_SIZE) {
+                slots[i].length = 0;
+                corrupt[i] = 0;
+                continue;
+            }
+            m_packetsReceived++;
+            
+            uint32_t length = slots[i].length;
+            corrupt[i] = !checkPacket(slots[i].buffer, length);
+            slots[i].length = corrupt[i] ? 0 : length;
+        }
+        
+        {
+            // One packetId sequence is spread over the queues; lock once per batch
+            std::lock_guard<std::mutex> lock(m_packetIdMutex);
+            for (int32_t i = 0; i < received; ++i) {
+                if (slots[i].length > 0 || corrupt[i]) {
+                    trackPacketId(Internal::XLibPacketView(slots[i].buffer).packetId(), corrupt[i] != 0);
+                }
+            }
+        }
+        
+        for (int32_t i = 0; i < received; ++i) {
+            if (slots[i].length > 0) {
+                // Modules write disjoint ranges of the same row
+                deliverPacket(slots[i].buffer, slots[i].length, lineIds, clock, 0, false);
+            }
+        }
+        
+        // Check if we've grabbed enough frames
+        if (m_framesToGrab > 0 && m_framesGrabbed >= m_framesToGrab) {
+            break;
+        }
+    }
+    
+    // Last queue out stops frame assembly
+    if (--m_activeQueues == 0) {
+        m_frame->Stop();
+        endGrab();
+        HX_LOG_INFO("XGrabber") << "Receive queues stopped";
+    }
+}
+
+void XGrabber::Impl::trackPacketId(uint32_t packetId, bool corrupt) {
+    if (!m_packetIdValid) {
+        m_highestPacketId = packetId;
+        m_packetIdHistory = 1;
+        m_packetIdValid = true;
+        return;
+    }
+    
+    int32_t delta = static_cast<int32_t>(packetId - m_highestPacketId);
+    
+    if (delta > 0) {
+        // New highest id; anything skipped is presumed lost until it shows up
+        if (delta > 1) {
+            m_packetsLost += static_cast<uint32_t>(delta - 1);
+            m_windowLost += static_cast<uint32_t>(delta - 1);
+            m_sequenceGaps++;
+        }
+        m_packetIdHistory = (delta >= 64) ? 0 : (m_packetIdHistory << delta);
+        m_packetIdHistory |= 1;
+        m_highestPacketId = packetId;
+    } else if (-static_cast<int64_t>(delta) >= 64) {
+        // Behind the history: a late packet cannot be told from a
+        // duplicate, so its id stays counted as lost
+        m_packetsLate++;
+    } else {
+        const uint64_t bit = uint64_t(1) << static_cast<uint32_t>(-delta);
+        
+        if (m_packetIdHistory & bit) {
+            if (!corrupt) {
+                m_packetsDuplicate++;
+            }
+        } else {
+            // Late arrival of a packet already counted as lost
+            m_packetIdHistory |= bit;
+            if (!corrupt) {
+                m_packetsReordered++;
+            }
+            if (m_packetsLost > 0) {
+                m_packetsLost--;
+            }
+            if (m_windowLost > 0) {
+                m_windowLost--;
+            }
+        }
+    }
+    
+    // A corrupt packet is seen but its data is lost all the same
+    if (corrupt) {
+        m_windowLost++;
+    } else {
+        m_windowReceived++;
+    }
+    
+    // Look at the clock only every 256 packets
+    if ((++m_lossCheckCounter & 0xFF) == 0) {
+        checkLossRate();
+    }
+}
+
+void XGrabber::Impl::checkLossRate() {
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    
+    if (now - m_windowStart < std::chrono::milliseconds(m_lossWindowMs)) {
+        return;
+    }
+    
+    uint64_t total = m_windowReceived + m_windowLost;
+    if (m_lossThreshold > 0.0 && total > 0) {
+        double ratio = static_cast<double>(m_windowLost) / static_cast<double>(total);
+        
+        // At most one alarm per window
+        if (ratio > m_lossThreshold &&
+            now - m_lastLossEvent >= std::chrono::milliseconds(m_lossWindowMs)) {
+            m_lastLossEvent = now;
+            reportEvent(112, static_cast<uint32_t>(m_windowLost));
+        }
+    }
+    
+    m_windowStart = now;
+    m_windowReceived = 0;
+    m_windowLost = 0;
+}
+
+void XGrabber::Impl::getStatistics(XGrabber::Statistics& stats) const {
+    stats.packetsReceived = m_packetsReceived;
+    stats.packetsLost = m_packetsLost;
+    stats.packetsDuplicate = m_packetsDuplicate;
+    stats.packetsReordered = m_packetsReordered;
+    stats.packetsLate = m_packetsLate;
+    stats.sequenceGaps = m_sequenceGaps;
+    stats.linesReceived = m_linesReceived;
+    stats.ringOverflows = m_ringOverflows;
+    stats.packetsCorrupt = m_packetsCorrupt;
+    stats.patternChecked = m_pattern.checked();
+    stats.patternMismatched = m_pattern.mismatched();
+    stats.ringHighWater = m_ring.highWater();
+    stats.receiveBatch = m_adaptiveBatch;
+}
+
+void XGrabber::Impl::collectMetrics(Internal::MetricsWriter& out) {
+    // Loss rate = rate(packets_lost) / (rate(packets_received) + rate(packets_lost))
+    out.counter("hubx_grabber_packets_received_total", "Image packets taken off the socket",
+                m_metricLabels, m_packetsReceived);
+    out.counter("hubx_grabber_packets_lost_total", "packetId gaps not filled by late packets",
+                m_metricLabels, m_packetsLost);
+    out.counter("hubx_grabber_packets_duplicate_total", "Packets whose packetId was already seen",
+                m_metricLabels, m_packetsDuplicate);
+    out.counter("hubx_grabber_packets_reordered_total", "Packets that arrived after a higher packetId",
+                m_metricLabels, m_packetsReordered);
+    out.counter("hubx_grabber_packets_late_total", "Packets too far behind the highest packetId to be matched",
+                m_metricLabels, m_packetsLate);
+    out.counter("hubx_grabber_sequence_gaps_total", "packetId discontinuities",
+                m_metricLabels, m_sequenceGaps);
+    out.counter("hubx_grabber_lines_received_total", "Lines passed to XFrame",
+                m_metricLabels, m_linesReceived);
+    out.counter("hubx_grabber_ring_overflows_total", "Packets dropped because the receive ring was full",
+                m_metricLabels, m_ringOverflows);
+    out.counter("hubx_grabber_packets_corrupt_total", "Packets dropped by a bad CRC16 trailer",
+                m_metricLabels, m_packetsCorrupt);
+    if (m_pattern.enabled()) {
+        out.counter("hubx_grabber_pattern_checked_total", "Line segments compared with the test pattern",
+                    m_metricLabels, m_pattern.checked());
+        out.counter("hubx_grabber_pattern_mismatched_total", "Line segments that differed from it",
+                    m_metricLabels, m_pattern.mismatched());
+    }
+    out.gauge("hubx_grabber_ring_depth", "Packets waiting in the receive ring",
+              m_metricLabels, m_ring.size());
+    out.gauge("hubx_grabber_ring_high_water", "Highest receive ring occupancy",
+              m_metricLabels, m_ring.highWater());
+    if (m_receiveMode == XGrabber::RECEIVE_ADAPTIVE) {
+        out.gauge("hubx_grabber_receive_batch", "Packets the adaptive receive batches now",
+                  m_metricLabels, m_adaptiveBatch);
+    }
+    out.gauge("hubx_grabber_grabbing", "1 while acquisition runs",
+              m_metricLabels, m_grabbing ? 1 : 0);
+}
+
+void XGrabber::Impl::resetStatistics() {
+    m_packetsReceived = 0;
+    m_packetsLost = 0;
+    m_linesReceived = 0;
+    m_packetsDuplicate = 0;
+    m_packetsReordered = 0;
+    m_packetsLate = 0;
+    m_sequenceGaps = 0;
+    m_packetsCorrupt = 0;
+    m_ringOverflows = 0;
+    m_pattern.resetCounters();
+    m_windowReceived = 0;
+    m_windowLost = 0;
+    m_windowStart = std::chrono::steady_clock::now();
+    m_lastLossEvent = std::chrono::steady_clock::time_point();
+}
+
+void XGrabber::Impl::setLossThreshold(double ratio, uint32_t windowMs) {
+    m_lossThreshold = ratio;
+    m_lossWindowMs = (windowMs > 0) ? windowMs : 1000;
+}
+
+bool XGrabber::Impl::snap() {
+    if (!grab(1)) {
+        return false;
+    }
+    
+    // The receivers stop on their own after the frame
+    const bool complete = waitGrab(0);
+    
+    stop();
+    
+    return complete;
+}
+
+uint32_t XGrabber::Impl::slotSize(uint32_t lineBytes) const {
+    if (lineBytes == 0) {
+        return Internal::XLIB_MAX_IMAGE_PACKET_SIZE;
+    }
+    
+    // Room for the packet's lines plus headers, rounded to a cache line
+    const uint64_t packetBytes = static_cast<uint64_t>(m_layout.linesPerPacket) *
+                                 (lineBytes + Internal::XLIB_PACKET_HEADER_SIZE);
+    return static_cast<uint32_t>(std::min<uint64_t>(((packetBytes + 64 + 63) / 64) * 64,
+                                                    Internal::XLIB_MAX_IMAGE_PACKET_SIZE));
+}
+
+bool XGrabber::Impl::prepare() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    if (!m_opened) {
+        reportError(25, "XGrabber not opened");
+        return false;
+    }
+    
+    if (m_grabbing) {
+        reportError(26, "Already grabbing");
+        return false;
+    }
+    
+    const std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+    const uint32_t pixelCount = m_detector.GetPixelCount();
+    const uint8_t pixelDepth = m_detector.GetPixelDepth();
+    const uint32_t lineBytes = pixelCount * ((pixelDepth + 7) / 8);
+    
+    if (!m_multi && !m_frame->Prepare(pixelCount, pixelDepth)) {
+        reportError(26, "Failed to prepare frame assembly");
+        return false;
+    }
+    
+    // The ring path keeps its store across runs; startGrab() finds it sized.
+    // assign() writes every byte, so the pages are faulted in here
+    if (m_queues.empty() && (m_replay || (!m_zeroCopy && m_xdpInterface.empty()))) {
+        m_slotSize = slotSize(lineBytes);
+        m_ring.reset(m_ringDepth);
+        m_packetStore.assign(static_cast<size_t>(m_ring.capacity()) * m_slotSize, 0);
+        m_memory.set(Internal::MemBytes(m_packetStore) +
+                     static_cast<uint64_t>(m_ring.capacity()) * sizeof(PacketDesc));
+    }
+    
+    // The slice-by-8 tables are built on first use
+    if (m_packetCheck) {
+        const uint8_t probe[8] = {0};
+        Internal::XLib_CalculateCRC16(probe, sizeof(probe));
+    }
+    
+    m_prepareTime = static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - begin).count());
+    HX_LOG_INFO("XGrabber") << "Prepared in " << m_prepareTime << " us";
+    return true;
+}
+
+bool XGrabber::Impl::waitGrab(uint32_t timeoutMs) {
+    std::unique_lock<std::mutex> lock(m_sequenceMutex);
+    
+    // Continuous acquisition has no last frame to wait for
+    if (m_framesToGrab == 0 && m_grabbing) {
+        return false;
+    }
+    
+    // The receivers end right after the last frame, so this is soon after it
+    if (timeoutMs == 0) {
+        m_sequenceDone.wait(lock, [this] { return !m_grabbing; });
+    } else if (!m_sequenceDone.wait_for(lock, std::chrono::milliseconds(timeoutMs),
+                                        [this] { return !m_grabbing; })) {
+        return false;
+    }
+    return m_sequenceComplete;
+}
+
+void XGrabber::Impl::onFrameDone(uint32_t frames) {
+    m_framesGrabbed = frames;
+    if (frames < m_framesToGrab) {
+        return;
+    }
+    
+    // The receivers leave their loops now; the assembly drains what they
+    // already took, and XFrame drops it
+    m_stopRequested = true;
+    wakeReceivers();
+    
+    {
+        std::lock_guard<std::mutex> lock(m_sequenceMutex);
+        m_sequenceComplete = true;
+    }
+    
+    HX_LOG_DEBUG("XGrabber") << "Sequence of " << frames << " frame(s) complete";
+    reportEvent(119, frames);
+}
+
+void XGrabber::Impl::endGrab() {
+    {
+        // Under the lock, so a WaitGrab() cannot miss it between test and sleep
+        std::lock_guard<std::mutex> lock(m_sequenceMutex);
+        m_grabbing = false;
+    }
+    m_sequenceDone.notify_all();
+}
+
+void XGrabber::Impl::wakeReceivers() {
+    // Kick receivers out of a blocking wait instead of waiting for the timeout
+    Internal::XLibProxy_WakeImageReceive();
+    std::lock_guard<std::mutex> lock(m_uringMutex);
+    if (m_uring.isOpen()) {
+        m_uring.wake();
+    }
+}
+
+bool XGrabber::Impl::stop() {
+    // A stop while the link is down cancels the resume
+    m_resume = false;
+    
+    if (!m_grabbing) {
+        return true;
+    }
+    
+    HX_LOG_INFO("XGrabber") << "Stopping acquisition...";
+    
+    m_stopRequested = true;
+    wakeReceivers();
+    
+    if (m_grabThread.joinable()) {
+        m_grabThread.join();
+    }
+    joinAssembly();
+    for (size_t q = 0; q < m_queueThreads.size(); ++q) {
+        if (m_queueThreads[q].joinable()) {
+            m_queueThreads[q].join();
+        }
+    }
+    m_queueThreads.clear();
+    
+    endGrab();
+    
+    HX_LOG_INFO("XGrabber") << "Acquisition stopped";
+    
+    return true;
+}
+
+bool XGrabber::Impl::setBatchSize(uint32_t count) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    if (m_grabbing) {
+        reportError(25, "Cannot change batch size while grabbing");
+        return false;
+    }
+    
+    if (count == 0 || count > 1024) {
+        reportError(25, "Invalid batch size");
+        return false;
+    }
+    
+    m_batchSize = count;
+    return true;
+}
+
+bool XGrabber::Impl::setRingDepth(uint32_t packets) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    if (m_grabbing) {
+        reportError(25, "Cannot change ring depth while grabbing");
+        return false;
+    }
+    
+    if (packets < 2 || packets > (1u << 20)) {
+        reportError(25, "Invalid ring depth");
+        return false;
+    }
+    
+    m_ringDepth = packets;
+    return true;
+}
+
+bool XGrabber::Impl::setReceiveQueues(uint32_t count) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    if (m_opened) {
+        reportError(25, "Set receive queues before Open");
+        return false;
+    }
+    
+    if (count == 0 || count > 64) {
+        reportError(25, "Invalid receive queue count");
+        return false;
+    }
+    
+    m_queueCount = count;
+    return true;
+}
+
+bool XGrabber::Impl::setKernelBypass(const std::string& interfaceName, uint32_t queueId) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    if (m_grabbing) {
+        reportError(25, "Cannot change receive backend while grabbing");
+        return false;
+    }
+    
+    if (interfaceName.size() >= sizeof(Internal::XLibXdpConfig().interfaceName)) {
+        reportError(25, "Invalid interface name");
+        return false;
+    }
+    
+    m_xdpInterface = interfaceName;
+    m_xdpQueue = queueId;
+    return true;
+}
+
+bool XGrabber::Impl::setIoUring(bool enable) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    if (m_grabbing) {
+        reportError(25, "Cannot change receive backend while grabbing");
+        return false;
+    }
+    
+    m_ioUring = enable;
+    return true;
+}
+
+bool XGrabber::Impl::setPacketCheck(bool enable) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    if (m_grabbing) {
+        reportError(25, "Cannot change packet checking while grabbing");
+        return false;
+    }
+    
+    m_packetCheck = enable;
+    return true;
+}
+
+bool XGrabber::Impl::setPatternCheck(const uint8_t* expected, uint32_t bytes, uint32_t lines) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    if (m_grabbing) {
+        reportError(25, "Cannot change pattern checking while grabbing");
+        return false;
+    }
+    
+    m_patternLines = lines;
+    if (lines > 0 && expected && bytes > 0) {
+        m_patternExpected.assign(expected, expected + bytes);
+    } else {
+        std::vector<uint8_t>().swap(m_patternExpected);
+    }
+    return true;
+}
+
+bool XGrabber::Impl::setPacketLayout(const XGrabber::PacketLayout& layout) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    if (m_grabbing) {
+        reportError(25, "Cannot change packet layout while grabbing");
+        return false;
+    }
+    if (layout.linesPerPacket < 1 || layout.linesPerPacket > 256 ||
+        (layout.linesPerPacket > 1 && layout.fragmentBytes > 0)) {
+        return false;
+    }
+    
+    m_layout = layout;
+    return true;
+}
+
+bool XGrabber::Impl::setZeroCopy(bool enable) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    if (m_grabbing) {
+        reportError(25, "Cannot change receive mode while grabbing");
+        return false;
+    }
+    
+    m_zeroCopy = enable;
+    return true;
+}
+
+bool XGrabber::Impl::setReceiveMode(XGrabber::ReceiveMode mode) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    if (m_grabbing) {
+        reportError(25, "Cannot change receive mode while grabbing");
+        return false;
+    }
+    
+    if (mode != XGrabber::RECEIVE_BLOCKING && mode != XGrabber::RECEIVE_BUSY_POLL &&
+        mode != XGrabber::RECEIVE_ADAPTIVE) {
+        reportError(25, "Invalid receive mode");
+        return false;
+    }
+    
+    m_receiveMode = mode;
+    return true;
+}
+
+bool XGrabber::Impl::setBatchDelay(uint32_t maxDelayUs) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    if (m_grabbing) {
+        reportError(25, "Cannot change batch delay while grabbing");
+        return false;
+    }
+    
+    if (maxDelayUs == 0 || maxDelayUs > 100000) {
+        reportError(25, "Invalid batch delay");
+        return false;
+    }
+    
+    m_batchDelayUs = maxDelayUs;
+    return true;
+}
+
+void XGrabber::Impl::setFrame(XFrame& frame) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    if (m_grabbing) {
+        reportError(25, "Cannot set frame while grabbing");
+        return;
+    }
+    
+    if (m_frame && m_frame != &frame) {
+        m_frame->setFrameListener(nullptr, 0);
+    }
+    m_frame = &frame;
+    m_multi = nullptr;
+}
+
+void XGrabber::Impl::setMultiFrame(XMultiFrame& multi, uint32_t detector) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    if (m_grabbing) {
+        reportError(25, "Cannot set frame while grabbing");
+        return;
+    }
+    
+    m_multi = &multi;
+    m_multiDetector = detector;
+}
+
+void XGrabber::Impl::setFlightRecorder(XFlightRecorder* recorder) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    if (m_grabbing) {
+        reportError(25, "Cannot set flight recorder while grabbing");
+        return;
+    }
+    
+    m_flight = recorder;
+}
+
+void XGrabber::Impl::onLinkLost() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    if (!m_opened) {
+        return;
+    }
+    
+    const bool grabbing = m_grabbing;
+    if (grabbing) {
+        HX_LOG_WARNING("XGrabber") << "Link lost, acquisition suspended";
+        
+        // The partial frame is flushed as the assembly stops
+        stop();
+    }
+    m_resume = grabbing;
+    
+    // XControl closes the shared network; the queues are ours to close
+    closeQueues();
+}
+
+void XGrabber::Impl::onLinkRestored(uint32_t gapMs) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    if (!m_opened) {
+        return;
+    }
+    
+    XGrabber::NetworkConfig config = m_netConfig;
+    if (!openNetwork(m_tuned ? &config : nullptr)) {
+        m_resume = false;
+        return;
+    }
+    
+    // Stop() or Grab() meanwhile took over from the suspended acquisition
+    if (!m_resume || m_grabbing) {
+        m_resume = false;
+        return;
+    }
+    m_resume = false;
+    
+    uint32_t frames = m_framesToGrab;
+    if (frames > 0) {
+        if (m_framesGrabbed >= frames) {
+            return;
+        }
+        frames -= m_framesGrabbed;
+    }
+    
+    if (startGrab(frames)) {
+        HX_LOG_INFO("XGrabber") << "Acquisition resumed after " << gapMs << " ms";
+        reportEvent(114, gapMs);
+    }
+}
+
+void XGrabber::Impl::reportError(uint32_t errorId, const char* message) {
+    HX_LOG_ID(::HX::XFactory::LOG_ERROR, "XGrabber", errorId) << "ERROR " << errorId << ": " << message;
+    m_notify.error(errorId, message);
+}
+
+void XGrabber::Impl::reportEvent(uint32_t eventId, uint32_t data) {
+    m_notify.event(eventId, data);
+}
+
+// XGrabber public interface
+XGrabber::XGrabber()
+    : m_impl(new Impl())
+{
+}
+
+XGrabber::~XGrabber() {
+    if (m_impl) {
+        delete m_impl;
+        m_impl = nullptr;
     }
 }
 
@@ -350,9 +2523,44 @@ bool XGrabber::Open(XDetector& dec, XControl& control) {
     return m_impl->open(dec, control);
 }
 
+bool XGrabber::Open(XDetector& dec, XControl& control, NetworkConfig& config) {
+    if (!m_impl) {
+        return false;
+    }
+    return m_impl->open(dec, control, config);
+}
+
+bool XGrabber::OpenReplay(XDetector& dec, const std::string& file) {
+    if (!m_impl) {
+        return false;
+    }
+    return m_impl->openReplay(dec, file);
+}
+
+bool XGrabber::SetReplaySpeed(double speed) {
+    if (!m_impl) {
+        return false;
+    }
+    return m_impl->setReplaySpeed(speed);
+}
+
+double XGrabber::GetReplaySpeed() {
+    if (!m_impl) {
+        return 0.0;
+    }
+    return m_impl->getReplaySpeed();
+}
+
+void XGrabber::GetNetworkConfig(NetworkConfig& config) {
+    if (m_impl) {
+        m_impl->getNetworkConfig(config);
+    }
+}
+
 void XGrabber::Close() {
     if (m_impl) {
         m_impl->close();
+        Internal::NotifyFlush();
     }
 }
 
@@ -377,11 +2585,31 @@ bool XGrabber::Snap() {
     return m_impl->snap();
 }
 
+bool XGrabber::Prepare() {
+    if (!m_impl) {
+        return false;
+    }
+    return m_impl->prepare();
+}
+
+uint32_t XGrabber::GetPrepareTime() {
+    return m_impl ? m_impl->getPrepareTime() : 0;
+}
+
+bool XGrabber::WaitGrab(uint32_t timeoutMs) {
+    if (!m_impl) {
+        return false;
+    }
+    return m_impl->waitGrab(timeoutMs);
+}
+
 bool XGrabber::Stop() {
     if (!m_impl) {
         return false;
     }
-    return m_impl->stop();
+    const bool stopped = m_impl->stop();
+    Internal::NotifyFlush();
+    return stopped;
 }
 
 bool XGrabber::IsGrabbing() {
@@ -397,6 +2625,47 @@ void XGrabber::SetHeader(bool enable) {
     }
 }
 
+bool XGrabber::SetPacketLayout(const PacketLayout& layout) {
+    if (!m_impl) {
+        return false;
+    }
+    return m_impl->setPacketLayout(layout);
+}
+
+void XGrabber::GetPacketLayout(PacketLayout& layout) {
+    if (m_impl) {
+        m_impl->getPacketLayout(layout);
+    }
+}
+
+bool XGrabber::SetPacketCheck(bool enable) {
+    if (!m_impl) {
+        return false;
+    }
+    return m_impl->setPacketCheck(enable);
+}
+
+bool XGrabber::GetPacketCheck() {
+    if (!m_impl) {
+        return false;
+    }
+    return m_impl->getPacketCheck();
+}
+
+bool XGrabber::SetPatternCheck(const uint8_t* expected, uint32_t bytes, uint32_t lines) {
+    if (!m_impl) {
+        return false;
+    }
+    return m_impl->setPatternCheck(expected, bytes, lines);
+}
+
+uint32_t XGrabber::GetPatternCheck() {
+    if (!m_impl) {
+        return 0;
+    }
+    return m_impl->getPatternCheck();
+}
+
 void XGrabber::SetSink(IXImgSink* sink_) {
     if (m_impl) {
         m_impl->setSink(sink_);
@@ -409,6 +2678,18 @@ void XGrabber::SetFrame(XFrame& frame) {
     }
 }
 
+void XGrabber::SetMultiFrame(XMultiFrame& multi, uint32_t detector) {
+    if (m_impl) {
+        m_impl->setMultiFrame(multi, detector);
+    }
+}
+
+void XGrabber::SetFlightRecorder(XFlightRecorder* recorder) {
+    if (m_impl) {
+        m_impl->setFlightRecorder(recorder);
+    }
+}
+
 void XGrabber::SetFactory(XFactory& factory) {
     if (m_impl) {
         m_impl->setFactory(factory);
@@ -421,4 +2702,141 @@ void XGrabber::SetTimeout(uint32_t time) {
     }
 }
 
+bool XGrabber::SetBatchSize(uint32_t count) {
+    if (!m_impl) {
+        return false;
+    }
+    return m_impl->setBatchSize(count);
+}
+
+uint32_t XGrabber::GetBatchSize() {
+    if (!m_impl) {
+        return 0;
+    }
+    return m_impl->getBatchSize();
+}
+
+bool XGrabber::SetRingDepth(uint32_t packets) {
+    if (!m_impl) {
+        return false;
+    }
+    return m_impl->setRingDepth(packets);
+}
+
+uint32_t XGrabber::GetRingDepth() {
+    if (!m_impl) {
+        return 0;
+    }
+    return m_impl->getRingDepth();
+}
+
+uint32_t XGrabber::GetRingHighWater() {
+    if (!m_impl) {
+        return 0;
+    }
+    return m_impl->getRingHighWater();
+}
+
+bool XGrabber::SetZeroCopy(bool enable) {
+    if (!m_impl) {
+        return false;
+    }
+    return m_impl->setZeroCopy(enable);
+}
+
+bool XGrabber::GetZeroCopy() {
+    if (!m_impl) {
+        return false;
+    }
+    return m_impl->getZeroCopy();
+}
+
+bool XGrabber::SetReceiveQueues(uint32_t count) {
+    if (!m_impl) {
+        return false;
+    }
+    return m_impl->setReceiveQueues(count);
+}
+
+uint32_t XGrabber::GetReceiveQueues() {
+    if (!m_impl) {
+        return 0;
+    }
+    return m_impl->getReceiveQueues();
+}
+
+bool XGrabber::SetKernelBypass(const std::string& interfaceName, uint32_t queueId) {
+    if (!m_impl) {
+        return false;
+    }
+    return m_impl->setKernelBypass(interfaceName, queueId);
+}
+
+bool XGrabber::GetKernelBypass() {
+    if (!m_impl) {
+        return false;
+    }
+    return m_impl->getKernelBypass();
+}
+
+bool XGrabber::SetIoUring(bool enable) {
+    if (!m_impl) {
+        return false;
+    }
+    return m_impl->setIoUring(enable);
+}
+
+bool XGrabber::GetIoUring() {
+    if (!m_impl) {
+        return false;
+    }
+    return m_impl->getIoUring();
+}
+
+bool XGrabber::SetReceiveMode(ReceiveMode mode) {
+    if (!m_impl) {
+        return false;
+    }
+    return m_impl->setReceiveMode(mode);
+}
+
+XGrabber::ReceiveMode XGrabber::GetReceiveMode() {
+    if (!m_impl) {
+        return RECEIVE_BLOCKING;
+    }
+    return m_impl->getReceiveMode();
+}
+
+bool XGrabber::SetBatchDelay(uint32_t maxDelayUs) {
+    if (!m_impl) {
+        return false;
+    }
+    return m_impl->setBatchDelay(maxDelayUs);
+}
+
+uint32_t XGrabber::GetBatchDelay() {
+    if (!m_impl) {
+        return 0;
+    }
+    return m_impl->getBatchDelay();
+}
+
+void XGrabber::GetStatistics(Statistics& stats) {
+    if (m_impl) {
+        m_impl->getStatistics(stats);
+    }
+}
+
+void XGrabber::ResetStatistics() {
+    if (m_impl) {
+        m_impl->resetStatistics();
+    }
+}
+
+void XGrabber::SetLossThreshold(double ratio, uint32_t windowMs) {
+    if (m_impl) {
+        m_impl->setLossThreshold(ratio, windowMs);
+    }
+}
+
 } // namespace HX
\ No newline at end of file
@@ -9,12 +9,98 @@
  */
 
 #include "XImage.h"
+#include "utils/mem_profile.h"
 #include <cstring>
 #include <fstream>
 #include <iostream>
+#include <cstdlib>
+#include <string>
+
+#ifdef _WIN32
+#include <malloc.h>
+#else
+#include <sys/mman.h>
+#endif
 
 namespace HX {
 
+namespace {
+
+uint8_t* alignedAlloc(size_t size, size_t alignment) {
+#ifdef _WIN32
+    return static_cast<uint8_t*>(_aligned_malloc(size, alignment));
+#else
+    void* ptr = nullptr;
+    if (posix_memalign(&ptr, alignment, size) != 0) {
+        return nullptr;
+    }
+#ifdef MADV_HUGEPAGE
+    if (alignment >= XImage::HUGE_PAGE_ALIGNMENT) {
+        madvise(ptr, size, MADV_HUGEPAGE);
+    }
+#endif
+    return static_cast<uint8_t*>(ptr);
+#endif
+}
+
+void alignedFree(uint8_t* ptr) {
+#ifdef _WIN32
+    _aligned_free(ptr);
+#else
+    free(ptr);
+#endif
+}
+
+void arrayFree(uint8_t* ptr) {
+    delete[] ptr;
+}
+
+/// Frees a buffer charged to a profiling tag and credits the tag
+struct ProfiledFree {
+    void (*release)(uint8_t*);
+    XFactory::MemoryTag tag;
+    uint64_t bytes;
+    
+    void operator()(uint8_t* ptr) const {
+        release(ptr);
+        Internal::MemProfileFree(tag, bytes);
+    }
+};
+
+/// Hand an owned buffer to a shared_ptr, charged if profiling is on
+void ownBuffer(std::shared_ptr<uint8_t>& buffer, uint8_t* data, void (*release)(uint8_t*),
+               uint64_t bytes) {
+    if (Internal::MemProfiling()) {
+        ProfiledFree deleter = { release, Internal::MemCurrentTag(XFactory::MEM_IMAGE), bytes };
+        Internal::MemProfileAlloc(deleter.tag, bytes);
+        buffer.reset(data, deleter);
+    } else {
+        buffer.reset(data, release);
+    }
+}
+
+const char DUMP_MAGIC[8] = { 'H', 'X', 'I', 'M', 'A', 'G', 'E', '\0' };
+
+#pragma pack(push, 1)
+
+/// Header of SAVE_BINARY files
+struct DumpHeader {
+    char     magic[8];          ///< "HXIMAGE\0"
+    uint32_t version;
+    uint32_t headerSize;
+    uint32_t width;
+    uint32_t height;
+    uint32_t pixelDepth;
+    uint32_t bytesPerPixel;
+};
+
+#pragma pack(pop)
+
+} // namespace
+
+const uint32_t XImage::DEFAULT_ALIGNMENT;
+const uint32_t XImage::HUGE_PAGE_ALIGNMENT;
+
 XImage::XImage()
     : _data_(nullptr)
     , _data_offset(0)
@@ -22,7 +108,7 @@ XImage::XImage()
     , _width(0)
     , _pixel_depth(16)
     , _size(0)
-    , m_ownsData(false)
+    , _stride(0)
 {
 }
 
@@ -33,7 +119,7 @@ XImage::XImage(uint32_t width, uint32_t height, uint8_t pixelDepth)
     , _width(width)
     , _pixel_depth(pixelDepth)
     , _size(0)
-    , m_ownsData(true)
+    , _stride(0)
 {
     allocateMemory();
 }
@@ -42,25 +128,56 @@ XImage::~XImage() {
     freeMemory();
 }
 
-void XImage::allocateMemory() {
+bool XImage::Allocate(uint32_t width, uint32_t height, uint8_t pixelDepth,
+                      uint32_t rowAlign, uint32_t baseAlign) {
+    if (baseAlign < DEFAULT_ALIGNMENT || (baseAlign & (baseAlign - 1)) != 0) {
+        std::cerr << "[XImage] Invalid alignment: " << baseAlign << std::endl;
+        return false;
+    }
+    
+    freeMemory();
+    _data_ = nullptr;
+    _data_offset = 0;
+    _width = width;
+    _height = height;
+    _pixel_depth = pixelDepth;
+    
+    allocateMemory(rowAlign, baseAlign);
+    return _data_ != nullptr || _size == 0;
+}
+
+void XImage::allocateMemory(uint32_t rowAlign, uint32_t baseAlign) {
     freeMemory();
     
     uint32_t bytesPerPixel = (_pixel_depth + 7) / 8;
-    _size = _width * _height * bytesPerPixel;
+    _stride = _width * bytesPerPixel;
+    if (rowAlign > 1) {
+        _stride = ((_stride + rowAlign - 1) / rowAlign) * rowAlign;
+    }
+    _size = _stride * _height;
     
     if (_size > 0) {
-        _data_ = new uint8_t[_size];
-        memset(_data_, 0, _size);
-        m_ownsData = true;
+        // Round up so the tail of the last row can take a full vector load
+        size_t capacity = ((static_cast<size_t>(_size) + baseAlign - 1) / baseAlign) * baseAlign;
+        uint8_t* data = alignedAlloc(capacity, baseAlign);
+        if (!data) {
+            std::cerr << "[XImage] Failed to allocate " << capacity << " bytes" << std::endl;
+            _data_ = nullptr;
+            _size = 0;
+            return;
+        }
+        ownBuffer(m_buffer, data, alignedFree, capacity);
+        _data_ = data;
+        memset(_data_, 0, capacity);
     }
 }
 
 void XImage::freeMemory() {
-    if (m_ownsData && _data_) {
-        delete[] _data_;
+    if (m_buffer) {
+        // Other images may still share the allocation
+        m_buffer.reset();
         _data_ = nullptr;
     }
-    m_ownsData = false;
     _size = 0;
 }
 
@@ -74,9 +191,12 @@ void XImage::SetData(uint8_t* data, uint32_t width, uint32_t height,
     _pixel_depth = pixelDepth;
     
     uint32_t bytesPerPixel = (_pixel_depth + 7) / 8;
-    _size = _width * _height * bytesPerPixel;
+    _stride = _width * bytesPerPixel;
+    _size = _stride * _height;
     
-    m_ownsData = takeOwnership;
+    if (takeOwnership && data) {
+        ownBuffer(m_buffer, data, arrayFree, _size);
+    }
 }
 
 uint32_t XImage::GetPixelVal(uint32_t row, uint32_t col) const {
@@ -85,14 +205,14 @@ uint32_t XImage::GetPixelVal(uint32_t row, uint32_t col) const {
     }
     
     uint32_t bytesPerPixel = (_pixel_depth + 7) / 8;
-    uint32_t offset = _data_offset + (row * _width + col) * bytesPerPixel;
+    const uint8_t* pixel = _data_ + _data_offset + row * _stride + col * bytesPerPixel;
     
-    uint32_t value = 0;
-    for (uint32_t i = 0; i < bytesPerPixel && i < 4; ++i) {
-        value |= (uint32_t(_data_[offset + i]) << (i * 8));
+    switch (bytesPerPixel) {
+        case 1: return XPixelAccess<1>::Load(pixel);
+        case 2: return XPixelAccess<2>::Load(pixel);
+        case 3: return XPixelAccess<3>::Load(pixel);
+        default: return XPixelAccess<4>::Load(pixel);
     }
-    
-    return value;
 }
 
 void XImage::SetPixelVal(uint32_t row, uint32_t col, uint32_t pixel_value) {
@@ -101,48 +221,133 @@ void XImage::SetPixelVal(uint32_t row, uint32_t col, uint32_t pixel_value) {
     }
     
     uint32_t bytesPerPixel = (_pixel_depth + 7) / 8;
-    uint32_t offset = _data_offset + (row * _width + col) * bytesPerPixel;
+    uint8_t* pixel = _data_ + _data_offset + row * _stride + col * bytesPerPixel;
     
-    for (uint32_t i = 0; i < bytesPerPixel && i < 4; ++i) {
-        _data_[offset + i] = (pixel_value >> (i * 8)) & 0xFF;
+    switch (bytesPerPixel) {
+        case 1: XPixelAccess<1>::Store(pixel, pixel_value); break;
+        case 2: XPixelAccess<2>::Store(pixel, pixel_value); break;
+        case 3: XPixelAccess<3>::Store(pixel, pixel_value); break;
+        default: XPixelAccess<4>::Store(pixel, pixel_value); break;
     }
 }
 
 bool XImage::Save(const char* file_name_) const {
+    return Save(file_name_, SAVE_TEXT);
+}
+
+bool XImage::Save(const char* file_name_, SaveFormat format) const {
     if (!_data_ || !file_name_) {
         return false;
     }
     
-    std::ofstream file(file_name_, std::ios::out);
+    std::ofstream file(file_name_, format == SAVE_TEXT ? std::ios::out
+                                                       : std::ios::out | std::ios::binary);
     if (!file.is_open()) {
         std::cerr << "[XImage] Failed to open file: " << file_name_ << std::endl;
         return false;
     }
     
-    // Write header
-    file << "Width: " << _width << std::endl;
-    file << "Height: " << _height << std::endl;
-    file << "PixelDepth: " << static_cast<int>(_pixel_depth) << std::endl;
-    file << "Data:" << std::endl;
+    const uint8_t* pixels = _data_ + _data_offset;
+    const uint32_t rowBytes = _width * ((_pixel_depth + 7) / 8);
     
-    // Write pixel data
-    for (uint32_t row = 0; row < _height; ++row) {
-        for (uint32_t col = 0; col < _width; ++col) {
-            uint32_t value = GetPixelVal(row, col);
-            file << value;
-            if (col < _width - 1) {
-                file << " ";
+    if (format == SAVE_TEXT) {
+        // Write header
+        file << "Width: " << _width << std::endl;
+        file << "Height: " << _height << std::endl;
+        file << "PixelDepth: " << static_cast<int>(_pixel_depth) << std::endl;
+        file << "Data:" << std::endl;
+        
+        // Write pixel data, formatted a row at a time
+        std::string line;
+        line.reserve(static_cast<size_t>(_width) * 11);
+        char digits[10];
+        for (uint32_t row = 0; row < _height; ++row) {
+            line.clear();
+            for (uint32_t col = 0; col < _width; ++col) {
+                uint32_t value = GetPixelVal(row, col);
+                int n = 0;
+                do {
+                    digits[n++] = static_cast<char>('0' + value % 10);
+                    value /= 10;
+                } while (value);
+                while (n > 0) {
+                    line.push_back(digits[--n]);
+                }
+                line.push_back(col < _width - 1 ? ' ' : '\n');
+            }
+            file.write(line.data(), static_cast<std::streamsize>(line.size()));
+        }
+    } else {
+        if (format == SAVE_BINARY) {
+            DumpHeader header;
+            std::memset(&header, 0, sizeof(header));
+            std::memcpy(header.magic, DUMP_MAGIC, sizeof(header.magic));
+            header.version = 1;
+            header.headerSize = sizeof(DumpHeader);
+            header.width = _width;
+            header.height = _height;
+            header.pixelDepth = _pixel_depth;
+            header.bytesPerPixel = (_pixel_depth + 7) / 8;
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        }
+        if (_stride == rowBytes) {
+            file.write(reinterpret_cast<const char*>(pixels),
+                       static_cast<std::streamsize>(rowBytes) * _height);
+        } else {
+            for (uint32_t row = 0; row < _height; ++row) {
+                file.write(reinterpret_cast<const char*>(pixels) + static_cast<size_t>(row) * _stride,
+                           rowBytes);
             }
         }
-        file << std::endl;
     }
     
     file.close();
+    if (file.fail()) {
+        std::cerr << "[XImage] Failed to write file: " << file_name_ << std::endl;
+        return false;
+    }
     std::cout << "[XImage] Saved to " << file_name_ << std::endl;
     
     return true;
 }
 
+bool XImage::Load(const char* file_name_) {
+    if (!file_name_) {
+        return false;
+    }
+    
+    std::ifstream file(file_name_, std::ios::in | std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "[XImage] Failed to open file: " << file_name_ << std::endl;
+        return false;
+    }
+    
+    DumpHeader header;
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!file.good() || std::memcmp(header.magic, DUMP_MAGIC, sizeof(header.magic)) != 0 ||
+        header.headerSize < sizeof(DumpHeader) || header.width == 0 || header.height == 0 ||
+        header.pixelDepth == 0 || header.pixelDepth > 32 ||
+        header.bytesPerPixel != (header.pixelDepth + 7) / 8) {
+        std::cerr << "[XImage] Not an image dump: " << file_name_ << std::endl;
+        return false;
+    }
+    
+    if (!Allocate(header.width, header.height, static_cast<uint8_t>(header.pixelDepth))) {
+        return false;
+    }
+    file.seekg(header.headerSize);
+    file.read(reinterpret_cast<char*>(_data_ + _data_offset),
+              static_cast<std::streamsize>(_stride) * _height);
+    if (!file.good()) {
+        std::cerr << "[XImage] Truncated image dump: " << file_name_ << std::endl;
+        return false;
+    }
+    
+    std::cout << "[XImage] Loaded from " << file_name_ << std::endl;
+    
+    return true;
+}
+
 void XImage::Clear() {
     if (_data_ && _size > 0) {
         memset(_data_, 0, _size);
@@ -154,13 +359,49 @@ XImage* XImage::Clone() const {
         return nullptr;
     }
     
-    XImage* clone = new XImage(_width, _height, _pixel_depth);
-    if (clone->_data_) {
+    XImage* clone = new XImage();
+    uint32_t bytesPerPixel = (_pixel_depth + 7) / 8;
+    uint32_t padding = _stride - _width * bytesPerPixel;
+    clone->Allocate(_width, _height, _pixel_depth, padding > 0 ? _stride : 0);
+    if (clone->_data_ && clone->_size == _size) {
         memcpy(clone->_data_, _data_, _size);
         clone->_data_offset = _data_offset;
     }
+    clone->_info = _info;
     
     return clone;
 }
 
-} // namespace HX
\ No newline at end of file
+XImage* XImage::Share() const {
+    if (!_data_) {
+        return nullptr;
+    }
+    
+    XImage* shared = new XImage();
+    shared->m_buffer = m_buffer;
+    shared->_data_ = _data_;
+    shared->_data_offset = _data_offset;
+    shared->_height = _height;
+    shared->_width = _width;
+    shared->_pixel_depth = _pixel_depth;
+    shared->_size = _size;
+    shared->_stride = _stride;
+    shared->_info = _info;
+    
+    return shared;
+}
+
+uint32_t XImage::GetShareCount() const {
+    return static_cast<uint32_t>(m_buffer.use_count());
+}
+
+XImageView XImage::View() const {
+    uint8_t* origin = _data_ ? _data_ + _data_offset : nullptr;
+    return XImageView(origin, _width, _height, _stride, _pixel_depth);
+}
+
+XImageView XImage::View(uint32_t x, uint32_t y, uint32_t width, uint32_t height) const {
+    return View().Sub(x, y, width, height);
+}
+
+} // namespace HX
@@ -0,0 +1,89 @@
+// ============================================================================
+// XImageView.cpp
+// ============================================================================
+
+/**
+ * @file XImageView.cpp
+ * @brief XImageView implementation - Non-owning view of image rows
+ * @version 2.1.0
+ */
+
+#include "XImageView.h"
+#include <cstddef>
+
+namespace HX {
+
+XImageView::XImageView()
+    : m_data(nullptr)
+    , m_width(0)
+    , m_height(0)
+    , m_stride(0)
+    , m_pixelDepth(16)
+{
+}
+
+XImageView::XImageView(uint8_t* data, uint32_t width, uint32_t height,
+                       uint32_t stride, uint8_t pixelDepth)
+    : m_data(data)
+    , m_width(width)
+    , m_height(height)
+    , m_stride(stride)
+    , m_pixelDepth(pixelDepth)
+{
+}
+
+XImageView XImageView::Sub(uint32_t x, uint32_t y, uint32_t width, uint32_t height) const {
+    if (!m_data || x >= m_width || y >= m_height) {
+        return XImageView();
+    }
+    
+    if (width > m_width - x) {
+        width = m_width - x;
+    }
+    if (height > m_height - y) {
+        height = m_height - y;
+    }
+    
+    uint32_t bytesPerPixel = (m_pixelDepth + 7) / 8;
+    uint8_t* origin = m_data + static_cast<size_t>(y) * m_stride + x * bytesPerPixel;
+    
+    return XImageView(origin, width, height, m_stride, m_pixelDepth);
+}
+
+uint8_t* XImageView::Row(uint32_t row) const {
+    if (!m_data || row >= m_height) {
+        return nullptr;
+    }
+    return m_data + static_cast<size_t>(row) * m_stride;
+}
+
+uint32_t XImageView::GetPixelVal(uint32_t row, uint32_t col) const {
+    if (!m_data || row >= m_height || col >= m_width) {
+        return 0;
+    }
+    
+    uint32_t bytesPerPixel = (m_pixelDepth + 7) / 8;
+    const uint8_t* pixel = m_data + static_cast<size_t>(row) * m_stride + col * bytesPerPixel;
+    
+    uint32_t value = 0;
+    for (uint32_t i = 0; i < bytesPerPixel && i < 4; ++i) {
+        value |= (uint32_t(pixel[i]) << (i * 8));
+    }
+    
+    return value;
+}
+
+void XImageView::SetPixelVal(uint32_t row, uint32_t col, uint32_t pixel_value) {
+    if (!m_data || row >= m_height || col >= m_width) {
+        return;
+    }
+    
+    uint32_t bytesPerPixel = (m_pixelDepth + 7) / 8;
+    uint8_t* pixel = m_data + static_cast<size_t>(row) * m_stride + col * bytesPerPixel;
+    
+    for (uint32_t i = 0; i < bytesPerPixel && i < 4; ++i) {
+        pixel[i] = (pixel_value >> (i * 8)) & 0xFF;
+    }
+}
+
+} // namespace HX
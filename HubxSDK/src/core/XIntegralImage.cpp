@@ -0,0 +1,97 @@
+// ============================================================================
+// XIntegralImage.cpp - Constant-time ROI statistics
+// ============================================================================
+
+/**
+ * @file XIntegralImage.cpp
+ * @brief XIntegralImage implementation - summed-area tables of a frame
+ * @version 2.1.0
+ */
+
+#include "XIntegralImage.h"
+#include "XImage.h"
+#include "utils/box_filter.h"
+#include <algorithm>
+#include <cstring>
+
+namespace HX {
+
+class XIntegralImage::Impl {
+public:
+    bool build(const XImage* image);
+    bool getStatistics(uint32_t x, uint32_t y, uint32_t width, uint32_t height,
+                       XRoiStats& stats) const;
+    uint32_t getWidth() const { return static_cast<uint32_t>(m_tables.width()); }
+    uint32_t getHeight() const { return static_cast<uint32_t>(m_tables.height()); }
+
+private:
+    Internal::IntegralMoments m_tables;
+};
+
+bool XIntegralImage::Impl::build(const XImage* image) {
+    if (!image || !image->_data_ || image->_width == 0 || image->_height == 0 ||
+        image->_pixel_depth == 0 || image->_pixel_depth > 16) {
+        return false;
+    }
+    m_tables.build(image->_data_ + image->_data_offset, image->_stride,
+                   (image->_pixel_depth + 7) / 8, static_cast<int>(image->_width),
+                   static_cast<int>(image->_height));
+    return m_tables.width() > 0;
+}
+
+bool XIntegralImage::Impl::getStatistics(uint32_t x, uint32_t y, uint32_t width, uint32_t height,
+                                         XRoiStats& stats) const {
+    memset(&stats, 0, sizeof(stats));
+    const uint32_t cols = getWidth();
+    const uint32_t rows = getHeight();
+    if (x >= cols || y >= rows) {
+        return false;
+    }
+    const uint32_t x1 = x + std::min(width, cols - x);
+    const uint32_t y1 = y + std::min(height, rows - y);
+    if (x1 == x || y1 == y) {
+        return false;
+    }
+
+    m_tables.window(static_cast<int>(x), static_cast<int>(y), static_cast<int>(x1),
+                    static_cast<int>(y1), stats.sum, stats.sumSquares);
+    stats.pixels = static_cast<uint64_t>(x1 - x) * (y1 - y);
+    const double n = static_cast<double>(stats.pixels);
+    stats.mean = static_cast<double>(stats.sum) / n;
+    const double variance = static_cast<double>(stats.sumSquares) / n - stats.mean * stats.mean;
+    stats.variance = std::max(0.0, variance);
+    return true;
+}
+
+// XIntegralImage public interface
+XIntegralImage::XIntegralImage()
+    : m_impl(new Impl())
+{
+}
+
+XIntegralImage::~XIntegralImage() {
+    delete m_impl;
+}
+
+bool XIntegralImage::Build(const XImage* image) {
+    if (!m_impl) return false;
+    return m_impl->build(image);
+}
+
+bool XIntegralImage::GetStatistics(uint32_t x, uint32_t y, uint32_t width, uint32_t height,
+                                   XRoiStats& stats) const {
+    if (!m_impl) return false;
+    return m_impl->getStatistics(x, y, width, height, stats);
+}
+
+uint32_t XIntegralImage::GetWidth() const {
+    if (!m_impl) return 0;
+    return m_impl->getWidth();
+}
+
+uint32_t XIntegralImage::GetHeight() const {
+    if (!m_impl) return 0;
+    return m_impl->getHeight();
+}
+
+} // namespace HX
@@ -0,0 +1,814 @@
+// ============================================================================
+// XPreviewServer.cpp - Live preview streaming
+// ============================================================================
+
+/**
+ * @file XPreviewServer.cpp
+ * @brief XPreviewServer implementation - reduced 8-bit frames over TCP
+ * @version 2.1.0
+ */
+
+#include "XPreviewServer.h"
+#include "XImage.h"
+#include "XPixel.h"
+#include "iximg_sink.h"
+#include "utils/delta_pack.h"
+#include "utils/thread_pool.h"
+#include "utils/window_level.h"
+#include "utils/logger.h"
+#include "utils/mem_budget.h"
+#include "utils/overload.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <cerrno>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace HX {
+
+namespace {
+
+#ifdef _WIN32
+typedef SOCKET SocketHandle;
+const SocketHandle NO_SOCKET = INVALID_SOCKET;
+#else
+typedef int SocketHandle;
+const SocketHandle NO_SOCKET = -1;
+#endif
+
+/// How often the accept loop checks for Stop()
+const long ACCEPT_POLL_MS = 100;
+
+#pragma pack(push, 1)
+
+/// Frame header on the wire, see XPreviewServer.h
+struct PreviewHeader {
+    char magic[4];
+    uint16_t version;
+    uint16_t encoding;
+    uint32_t width;
+    uint32_t height;
+    uint32_t sourceWidth;
+    uint32_t sourceHeight;
+    uint32_t windowLow;
+    uint32_t windowHigh;
+    uint64_t frame;
+    uint32_t payload;
+    uint32_t reserved;
+};
+
+#pragma pack(pop)
+
+static_assert(sizeof(PreviewHeader) == 48, "PreviewHeader must be 48 bytes");
+
+void closeSocket(SocketHandle s) {
+#ifdef _WIN32
+    closesocket(s);
+#else
+    close(s);
+#endif
+}
+
+/// Wake a thread blocked on the socket
+void shutdownSocket(SocketHandle s) {
+#ifdef _WIN32
+    shutdown(s, SD_BOTH);
+#else
+    shutdown(s, SHUT_RDWR);
+#endif
+}
+
+bool sendAll(SocketHandle s, const uint8_t* data, size_t size) {
+#ifdef MSG_NOSIGNAL
+    const int flags = MSG_NOSIGNAL;     // A closed peer must not raise SIGPIPE
+#else
+    const int flags = 0;
+#endif
+    while (size > 0) {
+        const int chunk = static_cast<int>(std::min<size_t>(size, 1 << 20));
+        const int sent = static_cast<int>(send(s, reinterpret_cast<const char*>(data), chunk, flags));
+        if (sent <= 0) {
+#ifndef _WIN32
+            if (sent < 0 && errno == EINTR) {
+                continue;
+            }
+#endif
+            return false;
+        }
+        data += sent;
+        size -= static_cast<size_t>(sent);
+    }
+    return true;
+}
+
+typedef std::shared_ptr<const std::vector<uint8_t> > Packet;
+
+} // anonymous namespace
+
+class XPreviewServer::Impl {
+public:
+    Impl();
+    ~Impl();
+
+    void setSink(IXImgSink* sink_) { m_sink = sink_; }
+    bool setEncoding(XEncoding encoding);
+    bool setMaxSize(uint32_t width, uint32_t height);
+    void setMaxFps(uint32_t fps);
+    bool setWindow(uint32_t low, uint32_t high);
+    void setAutoWindow(bool enable, float clip);
+
+    bool start(uint16_t port, uint32_t maxClients);
+    void stop();
+    bool isRunning() const { return m_running; }
+    uint16_t getPort() const { return m_port; }
+
+    bool publish(const XImage* image);
+    Statistics getStatistics() const;
+
+private:
+    /// One subscriber and its sender thread
+    struct Client {
+        SocketHandle socket;
+        std::thread thread;
+        std::mutex mutex;
+        std::condition_variable cv;
+        Packet pending;                 ///< Newest frame not yet sent
+        bool stop;
+        std::atomic<bool> alive;
+
+        Client() : socket(NO_SOCKET), stop(false), alive(true) {}
+    };
+
+    // Binds reduce<Bytes> for XDispatchPixelBytes
+    struct ReduceKernel {
+        Impl* self;
+        const XImage* image;
+        uint32_t factor;
+        std::vector<uint8_t>* levels;
+
+        template <uint32_t Bytes>
+        void run() { self->reduce<Bytes>(image, factor, *levels); }
+    };
+
+    // Binds autoWindowRange<Bytes> for XDispatchPixelBytes
+    struct AutoWindowKernel {
+        Impl* self;
+        const XImage* image;
+
+        template <uint32_t Bytes>
+        void run() {
+            Internal::autoWindowRange<Bytes>(image, image->_pixel_depth, self->m_autoClip,
+                                             self->m_windowLow, self->m_windowHigh);
+        }
+    };
+
+    void acceptThread();
+    void encodeThread();
+    void clientThread(Client* client);
+    void reapClients(bool all);
+    /// Free the mailbox copies not in use, for the memory budget
+    uint64_t release(uint64_t bytes);
+
+    Packet encode(const XImage* image);
+    template <uint32_t Bytes>
+    void reduce(const XImage* image, uint32_t factor, std::vector<uint8_t>& levels);
+    void reportError(uint32_t errorId, const std::string& message);
+
+    IXImgSink* m_sink;
+    XEncoding m_encoding;
+    uint32_t m_maxWidth;
+    uint32_t m_maxHeight;
+    std::atomic<uint32_t> m_maxFps;
+    uint32_t m_maxClients;
+    const Internal::WindowKernel m_windowKernel;
+
+    // Window settings, under m_windowMutex; read by the encoder
+    mutable std::mutex m_windowMutex;
+    uint32_t m_windowLow;
+    uint32_t m_windowHigh;
+    bool m_autoWindow;
+    float m_autoClip;
+    Internal::WindowParams m_window;    ///< Encoder thread only
+
+    std::atomic<bool> m_running;
+    bool m_stopping;
+    SocketHandle m_listen;
+    uint16_t m_port;
+    std::thread m_acceptThread;
+    std::thread m_encodeThread;
+
+    // Latest-frame-wins mailbox: Publish() fills m_writeImage and swaps it
+    // with m_readyImage, the encoder swaps that with m_encodeImage
+    XImage m_mailbox[3];
+    XImage* m_writeImage;
+    XImage* m_readyImage;
+    XImage* m_encodeImage;
+    bool m_fresh;
+    std::mutex m_publishMutex;
+    std::mutex m_mailboxMutex;
+    std::condition_variable m_mailboxCv;
+    std::chrono::steady_clock::time_point m_lastPublish;
+
+    mutable std::mutex m_clientsMutex;
+    std::vector<std::unique_ptr<Client> > m_clients;
+
+    // Counters
+    std::atomic<uint64_t> m_published;
+    std::atomic<uint64_t> m_skipped;
+    std::atomic<uint64_t> m_encoded;
+    std::atomic<uint64_t> m_dropped;
+    std::atomic<uint64_t> m_bytesSent;
+
+    Internal::MemReclaimer m_reclaimer;
+};
+
+XPreviewServer::Impl::Impl()
+    : m_sink(nullptr)
+    , m_encoding(XPREVIEW_DELTA)
+    , m_maxWidth(1024)
+    , m_maxHeight(1024)
+    , m_maxFps(15)
+    , m_maxClients(8)
+    , m_windowKernel(Internal::selectWindowKernel())
+    , m_windowLow(0)
+    , m_windowHigh(0)
+    , m_autoWindow(false)
+    , m_autoClip(0.005f)
+    , m_running(false)
+    , m_stopping(false)
+    , m_listen(NO_SOCKET)
+    , m_port(0)
+    , m_writeImage(&m_mailbox[0])
+    , m_readyImage(&m_mailbox[1])
+    , m_encodeImage(&m_mailbox[2])
+    , m_fresh(false)
+    , m_published(0)
+    , m_skipped(0)
+    , m_encoded(0)
+    , m_dropped(0)
+    , m_bytesSent(0)
+    , m_reclaimer(Internal::MemReclaimer::RECLAIM_PREVIEW,
+                  [this](uint64_t bytes) { return release(bytes); })
+{
+    std::memset(&m_window, 0, sizeof(m_window));
+    m_reclaimer.add();
+}
+
+XPreviewServer::Impl::~Impl() {
+    m_reclaimer.remove();
+    stop();
+}
+
+bool XPreviewServer::Impl::setEncoding(XEncoding encoding) {
+    if (m_running) {
+        return false;
+    }
+    m_encoding = encoding;
+    return true;
+}
+
+bool XPreviewServer::Impl::setMaxSize(uint32_t width, uint32_t height) {
+    if (m_running || width == 0 || height == 0) {
+        return false;
+    }
+    m_maxWidth = width;
+    m_maxHeight = height;
+    return true;
+}
+
+void XPreviewServer::Impl::setMaxFps(uint32_t fps) {
+    m_maxFps = fps;
+}
+
+bool XPreviewServer::Impl::setWindow(uint32_t low, uint32_t high) {
+    if (low >= high) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(m_windowMutex);
+    m_windowLow = low;
+    m_windowHigh = high;
+    m_autoWindow = false;
+    return true;
+}
+
+void XPreviewServer::Impl::setAutoWindow(bool enable, float clip) {
+    std::lock_guard<std::mutex> lock(m_windowMutex);
+    m_autoWindow = enable;
+    m_autoClip = std::max(0.0f, std::min(clip, 0.49f));
+}
+
+bool XPreviewServer::Impl::start(uint16_t port, uint32_t maxClients) {
+    if (m_running) {
+        return true;
+    }
+    if (maxClients == 0) {
+        reportError(46, "maxClients must be at least 1");
+        return false;
+    }
+
+#ifdef _WIN32
+    WSADATA wsa;
+    if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0) {
+        reportError(46, "WSAStartup failed");
+        return false;
+    }
+#endif
+
+    SocketHandle s = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (s == NO_SOCKET) {
+        reportError(46, "Cannot create socket");
+#ifdef _WIN32
+        WSACleanup();
+#endif
+        return false;
+    }
+    const int reuse = 1;
+    setsockopt(s, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&reuse), sizeof(reuse));
+
+    sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(port);
+    socklen_t length = sizeof(addr);
+    if (bind(s, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0 ||
+        listen(s, static_cast<int>(maxClients)) != 0 ||
+        getsockname(s, reinterpret_cast<sockaddr*>(&addr), &length) != 0) {
+        reportError(46, "Cannot listen on port " + std::to_string(port));
+        closeSocket(s);
+#ifdef _WIN32
+        WSACleanup();
+#endif
+        return false;
+    }
+
+    m_listen = s;
+    m_port = ntohs(addr.sin_port);
+    m_maxClients = maxClients;
+    m_stopping = false;
+    m_fresh = false;
+    m_lastPublish = std::chrono::steady_clock::time_point();
+    m_published = 0;
+    m_skipped = 0;
+    m_encoded = 0;
+    m_dropped = 0;
+    m_bytesSent = 0;
+    m_running = true;
+
+    m_encodeThread = std::thread(&Impl::encodeThread, this);
+    m_acceptThread = std::thread(&Impl::acceptThread, this);
+
+    HX_LOG_INFO("XPreviewServer") << "Listening on port " << m_port;
+    return true;
+}
+
+void XPreviewServer::Impl::stop() {
+    if (!m_running) {
+        return;
+    }
+    m_running = false;
+    {
+        std::lock_guard<std::mutex> lock(m_mailboxMutex);
+        m_stopping = true;
+    }
+    m_mailboxCv.notify_one();
+    m_encodeThread.join();
+    m_acceptThread.join();
+
+    reapClients(true);
+    closeSocket(m_listen);
+    m_listen = NO_SOCKET;
+    m_port = 0;
+#ifdef _WIN32
+    WSACleanup();
+#endif
+
+    HX_LOG_INFO("XPreviewServer") << "Stopped";
+}
+
+bool XPreviewServer::Impl::publish(const XImage* image) {
+    if (!m_running || !image || !image->_data_ || image->_width == 0 || image->_height == 0) {
+        return false;
+    }
+    ++m_published;
+
+    // Preview is the first thing to go when the pipeline falls behind
+    if (Internal::OverloadShed(XFactory::OVERLOAD_PREVIEW)) {
+        ++m_skipped;
+        return false;
+    }
+    // ... and when the memory budget runs short
+    if (Internal::MemOverBudget()) {
+        ++m_skipped;
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(m_publishMutex);
+
+    // Skip before copying, so the rate limit also bounds the caller's cost
+    const uint32_t fps = m_maxFps;
+    const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    if (fps > 0 && now - m_lastPublish < std::chrono::microseconds(1000000 / fps)) {
+        ++m_skipped;
+        return false;
+    }
+    m_lastPublish = now;
+
+    XImage* copy = m_writeImage;
+    if (copy->_width != image->_width || copy->_height != image->_height ||
+        copy->_pixel_depth != image->_pixel_depth) {
+        Internal::MemTagScope memTag(XFactory::MEM_DISPLAY);
+        if (!copy->Allocate(image->_width, image->_height, image->_pixel_depth)) {
+            return false;
+        }
+    }
+    const size_t rowBytes = static_cast<size_t>(image->_width) * ((image->_pixel_depth + 7) / 8);
+    for (uint32_t row = 0; row < image->_height; ++row) {
+        std::memcpy(copy->_data_ + copy->_data_offset + static_cast<size_t>(row) * copy->_stride,
+                    image->_data_ + image->_data_offset + static_cast<size_t>(row) * image->_stride,
+                    rowBytes);
+    }
+
+    {
+        std::lock_guard<std::mutex> mailboxLock(m_mailboxMutex);
+        if (m_fresh) {
+            // The encoder never got to the previous frame
+            ++m_skipped;
+        }
+        std::swap(m_writeImage, m_readyImage);
+        m_fresh = true;
+    }
+    m_mailboxCv.notify_one();
+    return true;
+}
+
+uint64_t XPreviewServer::Impl::release(uint64_t) {
+    uint64_t released = 0;
+    std::lock_guard<std::mutex> lock(m_publishMutex);
+    released += m_writeImage->_size;
+    m_writeImage->SetData(nullptr, 0, 0, 0);
+
+    // The encoder only takes the ready copy while it is fresh
+    std::lock_guard<std::mutex> mailboxLock(m_mailboxMutex);
+    if (!m_fresh) {
+        released += m_readyImage->_size;
+        m_readyImage->SetData(nullptr, 0, 0, 0);
+    }
+    return released;
+}
+
+void XPreviewServer::Impl::encodeThread() {
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(m_mailboxMutex);
+            m_mailboxCv.wait(lock, [this] { return m_fresh || m_stopping; });
+            if (m_stopping) {
+                break;
+            }
+            std::swap(m_readyImage, m_encodeImage);
+            m_fresh = false;
+        }
+
+        Packet packet = encode(m_encodeImage);
+        if (!packet) {
+            continue;
+        }
+        ++m_encoded;
+
+        // Hand over without waiting: a client still sending drops its last frame
+        std::lock_guard<std::mutex> lock(m_clientsMutex);
+        for (size_t i = 0; i < m_clients.size(); ++i) {
+            Client* client = m_clients[i].get();
+            if (!client->alive) {
+                continue;
+            }
+            {
+                std::lock_guard<std::mutex> clientLock(client->mutex);
+                if (client->pending) {
+                    ++m_dropped;
+                }
+                client->pending = packet;
+            }
+            client->cv.notify_one();
+        }
+    }
+}
+
+Packet XPreviewServer::Impl::encode(const XImage* image) {
+    const uint32_t depth = image->_pixel_depth;
+    if (depth == 0 || depth > 32) {
+        return Packet();
+    }
+
+    // Fix the window for this frame
+    {
+        std::lock_guard<std::mutex> lock(m_windowMutex);
+        if (m_autoWindow) {
+            AutoWindowKernel kernel = { this, image };
+            XDispatchPixelBytes(depth, kernel);
+        }
+        m_window = Internal::makeWindow(m_windowLow, m_windowHigh, depth);
+    }
+
+    // Smallest whole factor that fits the preview bounds
+    const uint32_t fx = (image->_width + m_maxWidth - 1) / m_maxWidth;
+    const uint32_t fy = (image->_height + m_maxHeight - 1) / m_maxHeight;
+    const uint32_t factor = std::max(1u, std::max(fx, fy));
+    const uint32_t width = (image->_width + factor - 1) / factor;
+    const uint32_t height = (image->_height + factor - 1) / factor;
+    const size_t pixels = static_cast<size_t>(width) * height;
+
+    std::vector<uint8_t> levels;
+    ReduceKernel kernel = { this, image, factor, &levels };
+    XDispatchPixelBytes(depth, kernel);
+
+    std::vector<uint8_t>* buffer = new std::vector<uint8_t>();
+    Packet packet(buffer);
+    size_t payload = pixels;
+    if (m_encoding == XPREVIEW_DELTA) {
+        buffer->resize(sizeof(PreviewHeader) + Internal::DeltaPackBound(pixels));
+        payload = Internal::DeltaPackEncode(levels.data(), width, height, width, 1,
+                                            buffer->data() + sizeof(PreviewHeader));
+        buffer->resize(sizeof(PreviewHeader) + payload);
+    } else {
+        buffer->resize(sizeof(PreviewHeader) + pixels);
+        std::memcpy(buffer->data() + sizeof(PreviewHeader), levels.data(), pixels);
+    }
+
+    PreviewHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, "HXPV", 4);
+    header.version = 1;
+    header.encoding = static_cast<uint16_t>(m_encoding);
+    header.width = width;
+    header.height = height;
+    header.sourceWidth = image->_width;
+    header.sourceHeight = image->_height;
+    header.windowLow = m_window.low;
+    header.windowHigh = m_window.low + m_window.range;
+    header.frame = m_encoded;
+    header.payload = static_cast<uint32_t>(payload);
+    std::memcpy(buffer->data(), &header, sizeof(header));
+    return packet;
+}
+
+template <uint32_t Bytes>
+void XPreviewServer::Impl::reduce(const XImage* image, uint32_t factor, std::vector<uint8_t>& levels) {
+    const uint32_t rows = image->_height;
+    const uint32_t cols = image->_width;
+    const uint32_t outRows = (rows + factor - 1) / factor;
+    const uint32_t outCols = (cols + factor - 1) / factor;
+    const Internal::WindowParams window = m_window;
+    const Internal::WindowKernel windowKernel = m_windowKernel;
+    levels.resize(static_cast<size_t>(outRows) * outCols);
+    uint8_t* dst = levels.data();
+
+    Internal::ThreadPool::instance().parallelRows(
+        static_cast<int>(outRows), static_cast<int>(cols) * static_cast<int>(factor),
+        [&](int firstRow, int endRow) {
+            std::vector<uint8_t> line(cols);
+            std::vector<uint8_t> blockMin(outCols);
+            std::vector<uint8_t> blockMax(outCols);
+            std::vector<uint32_t> blockSum(outCols);
+            for (int outRow = firstRow; outRow < endRow; ++outRow) {
+                uint8_t* out = dst + static_cast<size_t>(outRow) * outCols;
+                std::fill(blockMin.begin(), blockMin.end(), 255);
+                std::fill(blockMax.begin(), blockMax.end(), 0);
+                std::fill(blockSum.begin(), blockSum.end(), 0);
+
+                const uint32_t row0 = static_cast<uint32_t>(outRow) * factor;
+                const uint32_t row1 = std::min(row0 + factor, rows);
+                for (uint32_t row = row0; row < row1; ++row) {
+                    XPixelRow<Bytes> pixels = image->Row<Bytes>(row);
+                    uint8_t* target = (factor == 1) ? out : line.data();
+                    if (Bytes == 2) {
+                        windowKernel(pixels.Data(), target, cols, window);
+                    } else {
+                        for (uint32_t col = 0; col < cols; ++col) {
+                            target[col] = Internal::windowLevel(pixels.Get(col), window);
+                        }
+                    }
+                    if (factor == 1) {
+                        continue;
+                    }
+                    for (uint32_t col = 0; col < cols; ++col) {
+                        const uint32_t block = col / factor;
+                        const uint8_t level = line[col];
+                        blockMin[block] = std::min(blockMin[block], level);
+                        blockMax[block] = std::max(blockMax[block], level);
+                        blockSum[block] += level;
+                    }
+                }
+                if (factor == 1) {
+                    continue;
+                }
+
+                // Keep the block extreme farther from its mean, as XShow does,
+                // so a single dark or bright defect survives the reduction
+                const uint32_t blockRows = row1 - row0;
+                for (uint32_t block = 0; block < outCols; ++block) {
+                    const uint32_t count = blockRows * (std::min((block + 1) * factor, cols) - block * factor);
+                    const uint32_t sum = blockSum[block];
+                    out[block] = (blockMax[block] * count - sum > sum - blockMin[block] * count)
+                               ? blockMax[block] : blockMin[block];
+                }
+            }
+        });
+}
+
+void XPreviewServer::Impl::acceptThread() {
+    while (m_running) {
+        fd_set readable;
+        FD_ZERO(&readable);
+        FD_SET(m_listen, &readable);
+        timeval timeout;
+        timeout.tv_sec = 0;
+        timeout.tv_usec = ACCEPT_POLL_MS * 1000;
+        const int ready = select(static_cast<int>(m_listen) + 1, &readable, nullptr, nullptr, &timeout);
+        reapClients(false);
+        if (ready <= 0 || !m_running) {
+            continue;
+        }
+
+        SocketHandle s = accept(m_listen, nullptr, nullptr);
+        if (s == NO_SOCKET) {
+            continue;
+        }
+
+        std::lock_guard<std::mutex> lock(m_clientsMutex);
+        if (m_clients.size() >= m_maxClients) {
+            closeSocket(s);
+            continue;
+        }
+
+        // Small frames go out at once instead of waiting for a full segment
+        const int noDelay = 1;
+        setsockopt(s, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&noDelay), sizeof(noDelay));
+
+        std::unique_ptr<Client> client(new Client());
+        client->socket = s;
+        client->thread = std::thread(&Impl::clientThread, this, client.get());
+        m_clients.push_back(std::move(client));
+    }
+}
+
+void XPreviewServer::Impl::clientThread(Client* client) {
+    for (;;) {
+        Packet packet;
+        {
+            std::unique_lock<std::mutex> lock(client->mutex);
+            client->cv.wait(lock, [client] { return client->pending || client->stop; });
+            if (client->stop) {
+                break;
+            }
+            packet.swap(client->pending);
+        }
+
+        // Only this client waits on its socket
+        if (!sendAll(client->socket, packet->data(), packet->size())) {
+            break;
+        }
+        m_bytesSent += packet->size();
+    }
+    client->alive = false;
+}
+
+void XPreviewServer::Impl::reapClients(bool all) {
+    std::vector<std::unique_ptr<Client> > done;
+    {
+        std::lock_guard<std::mutex> lock(m_clientsMutex);
+        for (size_t i = 0; i < m_clients.size();) {
+            if (all || !m_clients[i]->alive) {
+                done.push_back(std::move(m_clients[i]));
+                m_clients.erase(m_clients.begin() + static_cast<std::ptrdiff_t>(i));
+            } else {
+                ++i;
+            }
+        }
+    }
+
+    // Joined outside the lock; shutdown wakes a sender blocked in send()
+    for (size_t i = 0; i < done.size(); ++i) {
+        Client* client = done[i].get();
+        {
+            std::lock_guard<std::mutex> lock(client->mutex);
+            client->stop = true;
+        }
+        client->cv.notify_one();
+        shutdownSocket(client->socket);
+        client->thread.join();
+        closeSocket(client->socket);
+    }
+}
+
+XPreviewServer::Statistics XPreviewServer::Impl::getStatistics() const {
+    Statistics stats;
+    stats.framesPublished = m_published;
+    stats.framesSkipped = m_skipped;
+    stats.framesEncoded = m_encoded;
+    stats.framesDropped = m_dropped;
+    stats.bytesSent = m_bytesSent;
+    std::lock_guard<std::mutex> lock(m_clientsMutex);
+    stats.clients = static_cast<uint32_t>(m_clients.size());
+    return stats;
+}
+
+void XPreviewServer::Impl::reportError(uint32_t errorId, const std::string& message) {
+    HX_LOG_ID(::HX::XFactory::LOG_ERROR, "XPreviewServer", errorId) << "ERROR " << errorId << ": " << message;
+
+    if (m_sink) {
+        m_sink->OnXError(errorId, message.c_str());
+    }
+}
+
+// ============================================================================
+// Public interface
+// ============================================================================
+
+XPreviewServer::XPreviewServer()
+    : m_impl(new Impl())
+{
+}
+
+XPreviewServer::~XPreviewServer() {
+    delete m_impl;
+}
+
+void XPreviewServer::SetSink(IXImgSink* sink_) {
+    if (!m_impl) return;
+    m_impl->setSink(sink_);
+}
+
+bool XPreviewServer::SetEncoding(XEncoding encoding) {
+    if (!m_impl) return false;
+    return m_impl->setEncoding(encoding);
+}
+
+bool XPreviewServer::SetMaxSize(uint32_t width, uint32_t height) {
+    if (!m_impl) return false;
+    return m_impl->setMaxSize(width, height);
+}
+
+void XPreviewServer::SetMaxFps(uint32_t fps) {
+    if (!m_impl) return;
+    m_impl->setMaxFps(fps);
+}
+
+bool XPreviewServer::SetWindow(uint32_t low, uint32_t high) {
+    if (!m_impl) return false;
+    return m_impl->setWindow(low, high);
+}
+
+void XPreviewServer::SetAutoWindow(bool enable, float clip) {
+    if (!m_impl) return;
+    m_impl->setAutoWindow(enable, clip);
+}
+
+bool XPreviewServer::Start(uint16_t port, uint32_t maxClients) {
+    if (!m_impl) return false;
+    return m_impl->start(port, maxClients);
+}
+
+void XPreviewServer::Stop() {
+    if (!m_impl) return;
+    m_impl->stop();
+}
+
+bool XPreviewServer::IsRunning() const {
+    if (!m_impl) return false;
+    return m_impl->isRunning();
+}
+
+uint16_t XPreviewServer::GetPort() const {
+    if (!m_impl) return 0;
+    return m_impl->getPort();
+}
+
+bool XPreviewServer::Publish(const XImage* image) {
+    if (!m_impl) return false;
+    return m_impl->publish(image);
+}
+
+XPreviewServer::Statistics XPreviewServer::GetStatistics() const {
+    if (!m_impl) return Statistics();
+    return m_impl->getStatistics();
+}
+
+} // namespace HX
@@ -0,0 +1,1311 @@
+// ============================================================================
+// XRecorder.cpp - Write-behind frame recording
+// ============================================================================
+
+/**
+ * @file XRecorder.cpp
+ * @brief XRecorder implementation - queued, unbuffered TIFF writing
+ * @version 2.1.0
+ */
+
+#include "XRecorder.h"
+#include "XFrame.h"
+#include "XImage.h"
+#include "iximg_sink.h"
+#include "utils/archive_index.h"
+#include "utils/delta_pack.h"
+#include "utils/io_ring.h"
+#include "utils/thread_policy.h"
+#include "utils/tiff_writer.h"
+#include "utils/logger.h"
+#include "utils/mem_profile.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <malloc.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace HX {
+
+namespace {
+
+/// Unbuffered I/O granularity: buffer address, file offset and length
+const size_t IO_ALIGN = 4096;
+
+/// Bounce buffer for headers, padded rows and the unaligned tail
+const size_t STAGE_BYTES = 4 * 1024 * 1024;
+
+/// Files written at once by the io_uring writer
+const uint32_t URING_FILES = 4;
+
+/// Largest single io_uring write, a multiple of IO_ALIGN
+const uint64_t URING_CHUNK = 1u << 30;
+
+inline uint64_t alignIo(uint64_t value) {
+    return (value + IO_ALIGN - 1) & ~static_cast<uint64_t>(IO_ALIGN - 1);
+}
+
+uint8_t* ioAlloc(size_t size) {
+#ifdef _WIN32
+    return static_cast<uint8_t*>(_aligned_malloc(size, IO_ALIGN));
+#else
+    void* ptr = nullptr;
+    if (posix_memalign(&ptr, IO_ALIGN, size) != 0) {
+        return nullptr;
+    }
+    return static_cast<uint8_t*>(ptr);
+#endif
+}
+
+void ioFree(uint8_t* ptr) {
+#ifdef _WIN32
+    _aligned_free(ptr);
+#else
+    free(ptr);
+#endif
+}
+
+/// ioAlloc / ioFree charged to MEM_RECORDER; charged is 0 for buffers
+/// allocated while memory profiling was off
+uint8_t* recorderAlloc(size_t size, uint64_t& charged) {
+    uint8_t* ptr = ioAlloc(size);
+    charged = (ptr && Internal::MemProfiling()) ? size : 0;
+    if (charged > 0) {
+        Internal::MemProfileAlloc(XFactory::MEM_RECORDER, charged);
+    }
+    return ptr;
+}
+
+void recorderFree(uint8_t* ptr, uint64_t& charged) {
+    ioFree(ptr);
+    if (charged > 0) {
+        Internal::MemProfileFree(XFactory::MEM_RECORDER, charged);
+        charged = 0;
+    }
+}
+
+/// Acquisition time in TIFF DateTime format
+std::string tiffNow() {
+    time_t now = time(nullptr);
+    struct tm local;
+#ifdef _WIN32
+    localtime_s(&local, &now);
+#else
+    localtime_r(&now, &local);
+#endif
+    char timeStr[32];
+    strftime(timeStr, sizeof(timeStr), "%Y:%m:%d %H:%M:%S", &local);
+    return timeStr;
+}
+
+bool directoryExists(const std::string& path) {
+#ifdef _WIN32
+    DWORD attributes = GetFileAttributesA(path.c_str());
+    return attributes != INVALID_FILE_ATTRIBUTES && (attributes & FILE_ATTRIBUTE_DIRECTORY);
+#else
+    struct stat st;
+    return stat(path.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+#endif
+}
+
+/**
+ * @brief Output file opened for unbuffered writing where possible
+ *
+ * In direct mode every write() must start at an IO_ALIGN-aligned address
+ * and offset and cover a multiple of IO_ALIGN; finish() trims the padding.
+ */
+class OutputFile {
+public:
+    OutputFile()
+#ifdef _WIN32
+        : m_handle(INVALID_HANDLE_VALUE)
+#else
+        : m_fd(-1)
+#endif
+        , m_direct(false)
+    {
+    }
+
+    ~OutputFile() {
+        close();
+    }
+
+    bool open(const std::string& path, bool direct) {
+        m_direct = false;
+#ifdef _WIN32
+        if (direct) {
+            m_handle = CreateFileA(path.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS,
+                                   FILE_ATTRIBUTE_NORMAL | FILE_FLAG_NO_BUFFERING, nullptr);
+            m_direct = m_handle != INVALID_HANDLE_VALUE;
+        }
+        if (m_handle == INVALID_HANDLE_VALUE) {
+            m_handle = CreateFileA(path.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS,
+                                   FILE_ATTRIBUTE_NORMAL, nullptr);
+        }
+        return m_handle != INVALID_HANDLE_VALUE;
+#else
+        const int flags = O_WRONLY | O_CREAT | O_TRUNC;
+#ifdef O_DIRECT
+        if (direct) {
+            // tmpfs and some network file systems reject O_DIRECT here
+            m_fd = ::open(path.c_str(), flags | O_DIRECT, 0644);
+            m_direct = m_fd >= 0;
+        }
+#endif
+        if (m_fd < 0) {
+            m_fd = ::open(path.c_str(), flags, 0644);
+        }
+#if !defined(O_DIRECT) && defined(F_NOCACHE)
+        if (direct && m_fd >= 0) {
+            m_direct = fcntl(m_fd, F_NOCACHE, 1) != -1;
+        }
+#endif
+        return m_fd >= 0;
+#endif
+    }
+
+    bool write(const uint8_t* data, size_t size) {
+#ifdef _WIN32
+        while (size > 0) {
+            // Stay a multiple of IO_ALIGN per call
+            const DWORD chunk = static_cast<DWORD>(std::min<size_t>(size, 1u << 30));
+            DWORD written = 0;
+            if (!WriteFile(m_handle, data, chunk, &written, nullptr) || written == 0) {
+                return false;
+            }
+            data += written;
+            size -= written;
+        }
+        return true;
+#else
+        while (size > 0) {
+            ssize_t written = ::write(m_fd, data, size);
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                // Accepted at open() but not for this I/O: go buffered
+                if (errno == EINVAL && dropDirect()) {
+                    continue;
+                }
+                return false;
+            }
+            data += written;
+            size -= static_cast<size_t>(written);
+        }
+        return true;
+#endif
+    }
+
+    /// Cut the file to its real length and close it
+    bool finish(uint64_t length) {
+#ifdef _WIN32
+        LARGE_INTEGER end;
+        end.QuadPart = static_cast<LONGLONG>(length);
+        bool ok = SetFilePointerEx(m_handle, end, nullptr, FILE_BEGIN) && SetEndOfFile(m_handle);
+#else
+        bool ok = ftruncate(m_fd, static_cast<off_t>(length)) == 0;
+#endif
+        return close() && ok;
+    }
+
+    bool close() {
+#ifdef _WIN32
+        if (m_handle == INVALID_HANDLE_VALUE) {
+            return true;
+        }
+        bool ok = CloseHandle(m_handle) != 0;
+        m_handle = INVALID_HANDLE_VALUE;
+#else
+        if (m_fd < 0) {
+            return true;
+        }
+        bool ok = ::close(m_fd) == 0;
+        m_fd = -1;
+#endif
+        return ok;
+    }
+
+    bool direct() const { return m_direct; }
+
+#ifndef _WIN32
+    int descriptor() const { return m_fd; }
+
+    /// Switch an O_DIRECT descriptor to buffered writes
+    bool dropDirect() {
+#ifdef O_DIRECT
+        const int flags = m_direct ? fcntl(m_fd, F_GETFL) : -1;
+        if (flags != -1 && fcntl(m_fd, F_SETFL, flags & ~O_DIRECT) == 0) {
+            m_direct = false;
+            return true;
+        }
+#endif
+        return false;
+    }
+#endif
+
+private:
+#ifdef _WIN32
+    HANDLE m_handle;
+#else
+    int m_fd;
+#endif
+    bool m_direct;
+};
+
+/**
+ * @brief Collects small pieces into aligned, padded writes
+ */
+class Stager {
+public:
+    Stager(OutputFile& file, uint8_t* buffer, size_t capacity)
+        : m_file(file), m_buffer(buffer), m_capacity(capacity), m_used(0) {}
+
+    bool append(const uint8_t* data, size_t size) {
+        while (size > 0) {
+            const size_t n = std::min(size, m_capacity - m_used);
+            std::memcpy(m_buffer + m_used, data, n);
+            m_used += n;
+            data += n;
+            size -= n;
+            if (m_used == m_capacity && !flush()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /// Write what is staged, zero-padded to IO_ALIGN
+    bool flush() {
+        if (m_used == 0) {
+            return true;
+        }
+        const size_t padded = static_cast<size_t>(alignIo(m_used));
+        std::memset(m_buffer + m_used, 0, padded - m_used);
+        m_used = 0;
+        return m_file.write(m_buffer, padded);
+    }
+
+private:
+    OutputFile& m_file;
+    uint8_t* m_buffer;
+    size_t m_capacity;
+    size_t m_used;
+};
+
+} // namespace
+
+class XRecorder::Impl {
+public:
+    Impl();
+    ~Impl();
+
+    void setSink(IXImgSink* sink_);
+    bool setQueueDepth(uint32_t frames);
+    uint32_t getQueueDepth() const;
+    void setQueuePolicy(QueuePolicy policy, uint32_t blockTimeoutMs);
+    QueuePolicy getQueuePolicy() const;
+    bool setDirectIO(bool enable);
+    bool setIndexing(bool enable);
+    bool setIoUring(bool enable);
+    bool setCompression(XFile::XFCompression mode, uint32_t keyframeInterval);
+
+    bool start(const std::string& directory, const std::string& prefix);
+    void stop();
+    bool isRunning() const;
+
+    bool submit(XImage* image, XFrame* pool);
+    Statistics getStatistics() const;
+
+private:
+    /// Recorder-owned copy buffer
+    struct Slot {
+        uint8_t* data;
+        size_t capacity;
+        uint64_t charged;
+
+        Slot() : data(nullptr), capacity(0), charged(0) {}
+    };
+
+    struct Job {
+        XImage* image;          ///< Pool frame, nullptr for copied frames
+        XFrame* pool;
+        int slot;               ///< Copy buffer, -1 for pool frames
+        const uint8_t* pixels;
+        uint32_t stride;
+        uint32_t width;
+        uint32_t height;
+        uint32_t depth;
+        uint64_t index;
+        std::string date;
+    };
+
+    /// One file written through io_uring
+    struct UringFile {
+        Job job;
+        OutputFile file;
+        std::string path;
+        Slot stage;                 ///< Header, then the padded tail
+        size_t headerBytes;
+        uint32_t pending;           ///< Writes in flight
+        bool failed;
+        std::chrono::steady_clock::time_point begin;
+    };
+
+    /// One write in flight; its index is the io_uring tag
+    struct UringWrite {
+        uint32_t file;
+        const uint8_t* data;
+        uint32_t length;
+        uint64_t offset;
+        int fixed;
+    };
+
+    /// io_uring writer state, writer thread only
+    struct Uring {
+        Internal::IoRing ring;
+        std::vector<UringFile> files;
+        std::vector<UringWrite> writes;
+        std::vector<uint32_t> freeWrites;
+        std::vector<std::pair<const uint8_t*, size_t> > registered;  ///< Fixed buffer table
+        bool fixed;
+    };
+
+    void writerThread();
+    bool nextJob(Job& job, bool wait);
+    void completeJob(const Job& job, bool ok, uint64_t bytes, bool direct, double seconds,
+                     double busySeconds);
+    std::string jobPath(const Job& job) const;
+    bool writeJob(const Job& job, uint64_t& bytes, bool& direct);
+    bool writeCompressed(const Job& job, const std::string& path, uint64_t& bytes, bool& direct);
+    bool finishFile(const Job& job, OutputFile& file, const std::string& path,
+                    size_t headerBytes, uint64_t dataBytes, XFile::XFCompression stored, bool ok);
+#ifndef _WIN32
+    void uringWriter(Uring& uring);
+    bool uringStart(Uring& uring, uint32_t index, const Job& job);
+    int uringBuffer(Uring& uring, uint32_t index, const uint8_t* data, size_t size);
+    void uringQueue(Uring& uring, uint32_t file, const uint8_t* data, uint64_t length,
+                    uint64_t offset, int fixed);
+    void uringSubmit(Uring& uring, const UringWrite& write, uint32_t tag);
+#endif
+    bool isFull() const;
+    void dropped(std::unique_lock<std::mutex>& lock);
+    void reportError(uint32_t errorId, const std::string& message);
+    void reportEvent(uint32_t eventId, uint32_t data);
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_workCv;       ///< Queue gained a job or stopping
+    std::condition_variable m_spaceCv;      ///< Queue lost a job or stopping
+    std::deque<Job> m_queue;
+    uint32_t m_reserved;                    ///< Copies in progress, counted as queued
+    std::vector<Slot> m_slots;
+    std::vector<int> m_freeSlots;
+    std::thread m_thread;
+    bool m_running;
+    bool m_stopping;
+
+    IXImgSink* m_sink;
+    uint32_t m_queueDepth;
+    QueuePolicy m_policy;
+    uint32_t m_blockTimeoutMs;
+    bool m_directIO;
+    bool m_indexing;
+    bool m_ioUring;
+    XFile::XFCompression m_compression;
+    uint32_t m_keyframeInterval;
+    std::string m_directory;
+    std::string m_prefix;
+    uint64_t m_nextIndex;
+    uint8_t* m_stage;                       ///< Writer thread only
+    uint64_t m_stageCharged;
+
+    // Last frame written, the reference of the next temporal file; writer thread only
+    Slot m_previous;
+    std::string m_previousName;             ///< Its file name, "" = next file is a keyframe
+    uint32_t m_previousWidth;
+    uint32_t m_previousHeight;
+    uint32_t m_previousDepth;
+    uint32_t m_sinceKeyframe;               ///< Temporal files since the last keyframe
+
+    // Statistics, under m_mutex
+    Statistics m_stats;
+    std::chrono::steady_clock::time_point m_startTime;
+    double m_writeSeconds;
+};
+
+XRecorder::Impl::Impl()
+    : m_reserved(0)
+    , m_running(false)
+    , m_stopping(false)
+    , m_sink(nullptr)
+    , m_queueDepth(16)
+    , m_policy(QUEUE_DROP_NEWEST)
+    , m_blockTimeoutMs(100)
+    , m_directIO(true)
+    , m_indexing(false)
+    , m_ioUring(false)
+    , m_compression(XFile::XF_COMPRESS_NONE)
+    , m_keyframeInterval(30)
+    , m_nextIndex(0)
+    , m_stage(nullptr)
+    , m_stageCharged(0)
+    , m_previousWidth(0)
+    , m_previousHeight(0)
+    , m_previousDepth(0)
+    , m_sinceKeyframe(0)
+    , m_writeSeconds(0.0)
+{
+    std::memset(&m_stats, 0, sizeof(m_stats));
+}
+
+XRecorder::Impl::~Impl() {
+    stop();
+    for (size_t i = 0; i < m_slots.size(); ++i) {
+        recorderFree(m_slots[i].data, m_slots[i].charged);
+    }
+    recorderFree(m_stage, m_stageCharged);
+    recorderFree(m_previous.data, m_previous.charged);
+}
+
+void XRecorder::Impl::setSink(IXImgSink* sink_) {
+    m_sink = sink_;
+}
+
+bool XRecorder::Impl::setQueueDepth(uint32_t frames) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_running || frames == 0) {
+        return false;
+    }
+    m_queueDepth = frames;
+    return true;
+}
+
+uint32_t XRecorder::Impl::getQueueDepth() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_queueDepth;
+}
+
+void XRecorder::Impl::setQueuePolicy(QueuePolicy policy, uint32_t blockTimeoutMs) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_policy = policy;
+    m_blockTimeoutMs = blockTimeoutMs;
+}
+
+XRecorder::QueuePolicy XRecorder::Impl::getQueuePolicy() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_policy;
+}
+
+bool XRecorder::Impl::setDirectIO(bool enable) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_running) {
+        return false;
+    }
+    m_directIO = enable;
+    return true;
+}
+
+bool XRecorder::Impl::setIndexing(bool enable) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_running) {
+        return false;
+    }
+    m_indexing = enable;
+    return true;
+}
+
+bool XRecorder::Impl::setIoUring(bool enable) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_running) {
+        return false;
+    }
+    m_ioUring = enable;
+    return true;
+}
+
+bool XRecorder::Impl::setCompression(XFile::XFCompression mode, uint32_t keyframeInterval) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_running || keyframeInterval == 0 || keyframeInterval > 1000 ||
+        (mode != XFile::XF_COMPRESS_NONE && mode != XFile::XF_COMPRESS_DELTA &&
+         mode != XFile::XF_COMPRESS_TEMPORAL)) {
+        return false;
+    }
+    m_compression = mode;
+    m_keyframeInterval = keyframeInterval;
+    return true;
+}
+
+bool XRecorder::Impl::start(const std::string& directory, const std::string& prefix) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_running) {
+        return false;
+    }
+    if (!directoryExists(directory)) {
+        HX_LOG_ID(::HX::XFactory::LOG_ERROR, "XRecorder", 41) << "ERROR 41: Output directory not found: " << directory;
+        if (m_sink) {
+            m_sink->OnXError(41, "Output directory not found");
+        }
+        return false;
+    }
+    if (!m_stage) {
+        m_stage = recorderAlloc(STAGE_BYTES, m_stageCharged);
+        if (!m_stage) {
+            return false;
+        }
+    }
+
+    // The writer holds one slot while the queue holds the rest
+    if (m_slots.size() != m_queueDepth + 1) {
+        for (size_t i = 0; i < m_slots.size(); ++i) {
+            recorderFree(m_slots[i].data, m_slots[i].charged);
+        }
+        m_slots.assign(m_queueDepth + 1, Slot());
+    }
+    m_freeSlots.clear();
+    for (size_t i = 0; i < m_slots.size(); ++i) {
+        m_freeSlots.push_back(static_cast<int>(i));
+    }
+
+    m_directory = directory;
+    m_prefix = prefix;
+    m_nextIndex = 0;
+    m_previousName.clear();
+    std::memset(&m_stats, 0, sizeof(m_stats));
+    m_writeSeconds = 0.0;
+    m_startTime = std::chrono::steady_clock::now();
+
+    m_stopping = false;
+    m_running = true;
+    m_thread = std::thread(&Impl::writerThread, this);
+
+    HX_LOG_INFO("XRecorder") << "Recording to " << directory << " (queue " << m_queueDepth
+                             << ", " << (m_directIO ? "unbuffered" : "buffered")
+                             << (m_ioUring ? ", io_uring" : "")
+                             << (m_compression == XFile::XF_COMPRESS_TEMPORAL ? ", temporal" :
+                                 m_compression == XFile::XF_COMPRESS_DELTA ? ", delta" : "") << ")";
+    return true;
+}
+
+void XRecorder::Impl::stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_running || m_stopping) {
+            return;
+        }
+        m_stopping = true;
+    }
+    m_workCv.notify_all();
+    m_spaceCv.notify_all();
+
+    // The writer drains the queue before it exits
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_running = false;
+    m_stopping = false;
+    HX_LOG_INFO("XRecorder") << "Stopped: " << m_stats.framesWritten << " written, "
+                             << m_stats.framesDropped << " dropped";
+}
+
+bool XRecorder::Impl::isRunning() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_running && !m_stopping;
+}
+
+bool XRecorder::Impl::isFull() const {
+    return m_queue.size() + m_reserved >= m_queueDepth;
+}
+
+void XRecorder::Impl::dropped(std::unique_lock<std::mutex>& lock) {
+    const uint64_t total = ++m_stats.framesDropped;
+    lock.unlock();
+    reportEvent(113, static_cast<uint32_t>(total));
+    lock.lock();
+}
+
+bool XRecorder::Impl::submit(XImage* image, XFrame* pool) {
+    if (!image || !image->_data_) {
+        if (image && pool) {
+            pool->Release(image);
+        }
+        return false;
+    }
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (!m_running || m_stopping) {
+        lock.unlock();
+        if (pool) {
+            pool->Release(image);
+        }
+        return false;
+    }
+    ++m_stats.framesSubmitted;
+
+    if (isFull() && m_policy == QUEUE_BLOCK) {
+        const std::chrono::milliseconds timeout(m_blockTimeoutMs);
+        auto room = [this]() { return !isFull() || m_stopping; };
+        if (m_blockTimeoutMs == 0) {
+            m_spaceCv.wait(lock, room);
+        } else {
+            m_spaceCv.wait_for(lock, timeout, room);
+        }
+    }
+
+    if (isFull() && m_policy == QUEUE_DROP_OLDEST && !m_queue.empty()) {
+        Job oldest = m_queue.front();
+        m_queue.pop_front();
+        if (oldest.slot >= 0) {
+            m_freeSlots.push_back(oldest.slot);
+        }
+        dropped(lock);
+        if (oldest.pool) {
+            lock.unlock();
+            oldest.pool->Release(oldest.image);
+            lock.lock();
+        }
+    }
+
+    if (isFull() || m_stopping) {
+        dropped(lock);
+        lock.unlock();
+        if (pool) {
+            pool->Release(image);
+        }
+        return false;
+    }
+
+    const uint32_t bytesPerPixel = (image->_pixel_depth + 7) / 8;
+    const uint32_t rowBytes = image->_width * bytesPerPixel;
+
+    Job job;
+    job.image = pool ? image : nullptr;
+    job.pool = pool;
+    job.slot = -1;
+    job.pixels = image->_data_ + image->_data_offset;
+    job.stride = image->_stride ? image->_stride : rowBytes;
+    job.width = image->_width;
+    job.height = image->_height;
+    job.depth = image->_pixel_depth;
+    job.index = m_nextIndex++;
+    job.date = tiffNow();
+
+    if (!pool) {
+        // Reserve the queue place and a slot, then copy without the lock
+        job.slot = m_freeSlots.back();
+        m_freeSlots.pop_back();
+        ++m_reserved;
+        lock.unlock();
+
+        Slot& slot = m_slots[job.slot];
+        const size_t pixelBytes = static_cast<size_t>(rowBytes) * job.height;
+        bool ok = true;
+        if (slot.capacity < pixelBytes) {
+            recorderFree(slot.data, slot.charged);
+            slot.capacity = static_cast<size_t>(alignIo(pixelBytes));
+            slot.data = recorderAlloc(slot.capacity, slot.charged);
+            if (!slot.data) {
+                slot.capacity = 0;
+                ok = false;
+            }
+        }
+        if (ok) {
+            if (job.stride == rowBytes) {
+                std::memcpy(slot.data, job.pixels, pixelBytes);
+            } else {
+                for (uint32_t row = 0; row < job.height; ++row) {
+                    std::memcpy(slot.data + static_cast<size_t>(row) * rowBytes,
+                                job.pixels + static_cast<size_t>(row) * job.stride, rowBytes);
+                }
+            }
+            job.pixels = slot.data;
+            job.stride = rowBytes;
+        }
+
+        lock.lock();
+        --m_reserved;
+        if (!ok) {
+            m_freeSlots.push_back(job.slot);
+            ++m_stats.writeErrors;
+            lock.unlock();
+            m_spaceCv.notify_all();
+            m_workCv.notify_one();
+            reportError(40, "Out of memory for frame copy");
+            return false;
+        }
+    }
+
+    m_queue.push_back(job);
+    const uint32_t queued = static_cast<uint32_t>(m_queue.size());
+    m_stats.queueHighWater = std::max(m_stats.queueHighWater, queued);
+    lock.unlock();
+    m_workCv.notify_one();
+    return true;
+}
+
+void XRecorder::Impl::writerThread() {
+    Internal::ApplyThreadPolicy(XFactory::THREAD_RECORDER);
+
+#ifndef _WIN32
+    // Compressed files are as large as they encode to; they go through the stager
+    if (m_ioUring && m_compression == XFile::XF_COMPRESS_NONE) {
+        Uring uring;
+        if (uring.ring.open(64)) {
+            uringWriter(uring);
+            return;
+        }
+        HX_LOG_WARNING("XRecorder") << "io_uring unavailable, writing synchronously";
+    }
+#endif
+
+    Job job;
+    while (nextJob(job, true)) {
+        const std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+        uint64_t bytes = 0;
+        bool direct = false;
+        const bool ok = writeJob(job, bytes, direct);
+        const double seconds = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - begin).count();
+        completeJob(job, ok, bytes, direct, seconds, seconds);
+    }
+}
+
+bool XRecorder::Impl::nextJob(Job& job, bool wait) {
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (wait) {
+            m_workCv.wait(lock, [this]() {
+                return !m_queue.empty() || (m_stopping && m_reserved == 0);
+            });
+        }
+        if (m_queue.empty()) {
+            return false;
+        }
+        job = m_queue.front();
+        m_queue.pop_front();
+    }
+    m_spaceCv.notify_one();
+    return true;
+}
+
+void XRecorder::Impl::completeJob(const Job& job, bool ok, uint64_t bytes, bool direct,
+                                  double seconds, double busySeconds) {
+    if (job.pool) {
+        job.pool->Release(job.image);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (job.slot >= 0) {
+            m_freeSlots.push_back(job.slot);
+        }
+        if (ok) {
+            ++m_stats.framesWritten;
+            m_stats.bytesWritten += bytes;
+            m_stats.pixelBytes += static_cast<uint64_t>(job.width) * ((job.depth + 7) / 8) * job.height;
+            m_stats.directIO = direct;
+            m_stats.maxWriteMs = std::max(m_stats.maxWriteMs, seconds * 1000.0);
+        } else {
+            ++m_stats.writeErrors;
+        }
+        m_writeSeconds += busySeconds;
+    }
+    if (job.slot >= 0) {
+        m_spaceCv.notify_one();
+    }
+}
+
+std::string XRecorder::Impl::jobPath(const Job& job) const {
+    char name[32];
+    snprintf(name, sizeof(name), "_%06llu.tif", static_cast<unsigned long long>(job.index));
+    return m_directory + "/" + m_prefix + name;
+}
+
+bool XRecorder::Impl::writeJob(const Job& job, uint64_t& bytes, bool& direct) {
+    const std::string path = jobPath(job);
+    if (m_compression != XFile::XF_COMPRESS_NONE) {
+        return writeCompressed(job, path, bytes, direct);
+    }
+
+    const uint32_t bytesPerPixel = (job.depth + 7) / 8;
+    const uint32_t rowBytes = job.width * bytesPerPixel;
+    const uint64_t pixelBytes = static_cast<uint64_t>(rowBytes) * job.height;
+
+    Internal::TiffBuilder tiff(pixelBytes + 64 * 1024 > 0xFFFFFFFFull);
+    tiff.addImageTags(job.width, job.height, bytesPerPixel, job.depth, job.date);
+    const std::vector<uint8_t>& header = tiff.finish(IO_ALIGN);
+
+    OutputFile file;
+    if (!file.open(path, m_directIO)) {
+        reportError(40, "Cannot create " + path);
+        return false;
+    }
+
+    Stager stage(file, m_stage, STAGE_BYTES);
+    bool ok = stage.append(header.data(), header.size());
+    if (job.stride == rowBytes &&
+        (reinterpret_cast<uintptr_t>(job.pixels) & (IO_ALIGN - 1)) == 0) {
+        // Pixels go to disk straight from the frame; only the tail is staged
+        const size_t body = static_cast<size_t>(pixelBytes & ~static_cast<uint64_t>(IO_ALIGN - 1));
+        ok = ok && stage.flush() && file.write(job.pixels, body) &&
+             stage.append(job.pixels + body, static_cast<size_t>(pixelBytes) - body);
+    } else {
+        for (uint32_t row = 0; ok && row < job.height; ++row) {
+            ok = stage.append(job.pixels + static_cast<size_t>(row) * job.stride, rowBytes);
+        }
+    }
+    ok = ok && stage.flush();
+    direct = file.direct();
+
+    bytes = header.size() + pixelBytes;
+    return finishFile(job, file, path, header.size(), pixelBytes, XFile::XF_COMPRESS_NONE, ok);
+}
+
+bool XRecorder::Impl::writeCompressed(const Job& job, const std::string& path, uint64_t& bytes,
+                                      bool& direct) {
+    const uint32_t bytesPerPixel = (job.depth + 7) / 8;
+    const uint32_t rowBytes = job.width * bytesPerPixel;
+    const uint64_t pixelBytes = static_cast<uint64_t>(rowBytes) * job.height;
+
+    // Residuals against the file before, unless a keyframe is due, the
+    // geometry changed or that file was not written
+    const bool tracking = m_compression == XFile::XF_COMPRESS_TEMPORAL;
+    const bool temporal = tracking && !m_previousName.empty() &&
+                          m_sinceKeyframe + 1 < m_keyframeInterval &&
+                          m_previousWidth == job.width && m_previousHeight == job.height &&
+                          (m_previousDepth + 7) / 8 == bytesPerPixel;
+
+    Internal::TiffStrips strips;
+    strips.compression = temporal ? Internal::HX_COMPRESSION_TEMPORAL : Internal::HX_COMPRESSION_DELTA;
+    strips.rowsPerStrip = Internal::DeltaPackStripRows(job.width);
+    std::vector<std::vector<uint8_t> > encoded;
+    Internal::DeltaPackEncodeStrips(job.pixels, job.stride, temporal ? m_previous.data : nullptr, rowBytes,
+                                    job.width, job.height, bytesPerPixel, strips.rowsPerStrip, encoded);
+    uint64_t storedBytes = 0;
+    for (size_t i = 0; i < encoded.size(); ++i) {
+        strips.bytes.push_back(encoded[i].size());
+        storedBytes += encoded[i].size();
+    }
+
+    Internal::TiffBuilder tiff(storedBytes + 64 * 1024 > 0xFFFFFFFFull);
+    tiff.addImageTags(job.width, job.height, bytesPerPixel, job.depth, job.date, &strips);
+    if (temporal) {
+        tiff.addAscii(Internal::HX_TAG_REFERENCE, m_previousName);
+    }
+    const std::vector<uint8_t>& header = tiff.finish(IO_ALIGN);
+
+    OutputFile file;
+    if (!file.open(path, m_directIO)) {
+        m_previousName.clear();
+        reportError(40, "Cannot create " + path);
+        return false;
+    }
+    Stager stage(file, m_stage, STAGE_BYTES);
+    bool ok = stage.append(header.data(), header.size());
+    for (size_t i = 0; ok && i < encoded.size(); ++i) {
+        ok = stage.append(encoded[i].data(), encoded[i].size());
+    }
+    ok = ok && stage.flush();
+    direct = file.direct();
+    bytes = header.size() + storedBytes;
+    if (!finishFile(job, file, path, header.size(), storedBytes,
+                    temporal ? XFile::XF_COMPRESS_TEMPORAL : XFile::XF_COMPRESS_DELTA, ok)) {
+        m_previousName.clear();
+        return false;
+    }
+    if (!temporal) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_stats.keyframesWritten;
+    }
+
+    if (tracking) {
+        // Keep the pixels as written for the next file
+        if (m_previous.capacity < pixelBytes) {
+            recorderFree(m_previous.data, m_previous.charged);
+            m_previous.data = recorderAlloc(static_cast<size_t>(pixelBytes), m_previous.charged);
+            m_previous.capacity = m_previous.data ? static_cast<size_t>(pixelBytes) : 0;
+        }
+        if (m_previous.data) {
+            for (uint32_t row = 0; row < job.height; ++row) {
+                std::memcpy(m_previous.data + static_cast<size_t>(row) * rowBytes,
+                            job.pixels + static_cast<size_t>(row) * job.stride, rowBytes);
+            }
+            m_previousName = path.substr(path.find_last_of('/') + 1);
+            m_previousWidth = job.width;
+            m_previousHeight = job.height;
+            m_previousDepth = job.depth;
+            m_sinceKeyframe = temporal ? m_sinceKeyframe + 1 : 0;
+        } else {
+            m_previousName.clear();
+        }
+    }
+    return true;
+}
+
+bool XRecorder::Impl::finishFile(const Job& job, OutputFile& file, const std::string& path,
+                                 size_t headerBytes, uint64_t dataBytes, XFile::XFCompression stored,
+                                 bool ok) {
+    const uint64_t bytes = headerBytes + dataBytes;
+    ok = file.finish(bytes) && ok;
+    if (!ok) {
+        remove(path.c_str());
+        reportError(40, "Failed to write " + path);
+        return false;
+    }
+
+    if (m_indexing) {
+        XArchiveIndex::Record record;
+        record.dateTime = job.date;
+        record.cols = job.width;
+        record.rows = job.height;
+        record.depth = job.depth;
+        record.compression = stored;
+        record.dataOffset = headerBytes;
+        record.fileSize = bytes;
+        if (!Internal::AppendArchiveRecord(path, record)) {
+            reportError(42, "Failed to index " + path);
+        }
+    }
+    return true;
+}
+
+#ifndef _WIN32
+
+void XRecorder::Impl::uringWriter(Uring& uring) {
+    typedef std::chrono::steady_clock Clock;
+    const uint32_t slotCount = static_cast<uint32_t>(m_slots.size());
+    uring.files.resize(URING_FILES);
+    for (uint32_t i = 0; i < URING_FILES; ++i) {
+        uring.files[i].pending = 0;
+    }
+    // Copy slots first, then one header/tail buffer per file
+    uring.registered.assign(slotCount + URING_FILES, std::make_pair(nullptr, 0));
+    uring.fixed = uring.ring.reserveBuffers(slotCount + URING_FILES);
+
+    std::vector<Internal::IoCompletion> completions(64);
+    uint32_t active = 0;
+    Clock::time_point mark;
+
+    for (;;) {
+        // Keep up to URING_FILES files in flight; block for work only when idle
+        while (active < URING_FILES) {
+            Job job;
+            if (!nextJob(job, active == 0)) {
+                break;
+            }
+            const uint32_t rowBytes = job.width * ((job.depth + 7) / 8);
+            if (job.stride != rowBytes || (reinterpret_cast<uintptr_t>(job.pixels) & (IO_ALIGN - 1)) != 0) {
+                // Padded or unaligned pool frames go through the bounce buffer
+                const Clock::time_point begin = Clock::now();
+                uint64_t bytes = 0;
+                bool direct = false;
+                const bool ok = writeJob(job, bytes, direct);
+                const double seconds = std::chrono::duration<double>(Clock::now() - begin).count();
+                completeJob(job, ok, bytes, direct, seconds, active == 0 ? seconds : 0.0);
+                continue;
+            }
+            uint32_t index = 0;
+            while (uring.files[index].pending > 0) {
+                ++index;
+            }
+            if (!uringStart(uring, index, job)) {
+                completeJob(job, false, 0, false, 0.0, 0.0);
+                continue;
+            }
+            if (active++ == 0) {
+                mark = uring.files[index].begin;
+            }
+        }
+        if (active == 0) {
+            break;
+        }
+
+        const int submitted = uring.ring.submit(1, 0);
+        if (submitted < 0 && submitted != -EINTR && submitted != -EBUSY) {
+            reportError(40, std::string("io_uring submit failed: ") + strerror(-submitted));
+        }
+
+        const uint32_t count = uring.ring.reap(completions.data(), static_cast<uint32_t>(completions.size()));
+        for (uint32_t i = 0; i < count; ++i) {
+            const uint32_t tag = static_cast<uint32_t>(completions[i].tag);
+            const int32_t result = completions[i].result;
+            UringWrite& write = uring.writes[tag];
+            UringFile& file = uring.files[write.file];
+
+            if (result == -EINTR || result == -EAGAIN ||
+                (result == -EINVAL && file.file.dropDirect())) {
+                uringSubmit(uring, write, tag);
+                continue;
+            }
+            if (result > 0 && static_cast<uint32_t>(result) < write.length) {
+                // Short write: queue the rest
+                write.data += result;
+                write.length -= static_cast<uint32_t>(result);
+                write.offset += static_cast<uint32_t>(result);
+                uringSubmit(uring, write, tag);
+                continue;
+            }
+            if (result <= 0) {
+                file.failed = true;
+            }
+            uring.freeWrites.push_back(tag);
+            if (--file.pending > 0) {
+                continue;
+            }
+
+            const bool direct = file.file.direct();
+            const uint64_t pixelBytes = static_cast<uint64_t>(file.job.width) *
+                                        ((file.job.depth + 7) / 8) * file.job.height;
+            const bool ok = finishFile(file.job, file.file, file.path, file.headerBytes, pixelBytes,
+                                       XFile::XF_COMPRESS_NONE, !file.failed);
+            const Clock::time_point now = Clock::now();
+            const uint64_t bytes = file.headerBytes +
+                static_cast<uint64_t>(file.job.width) * ((file.job.depth + 7) / 8) * file.job.height;
+            // Busy time counts once however many files overlap
+            completeJob(file.job, ok, bytes, direct,
+                        std::chrono::duration<double>(now - file.begin).count(),
+                        std::chrono::duration<double>(now - mark).count());
+            mark = now;
+            --active;
+        }
+    }
+
+    for (uint32_t i = 0; i < URING_FILES; ++i) {
+        recorderFree(uring.files[i].stage.data, uring.files[i].stage.charged);
+    }
+}
+
+bool XRecorder::Impl::uringStart(Uring& uring, uint32_t index, const Job& job) {
+    UringFile& file = uring.files[index];
+    file.job = job;
+    file.path = jobPath(job);
+    file.failed = false;
+    file.begin = std::chrono::steady_clock::now();
+
+    const uint32_t bytesPerPixel = (job.depth + 7) / 8;
+    const uint64_t pixelBytes = static_cast<uint64_t>(job.width) * bytesPerPixel * job.height;
+    Internal::TiffBuilder tiff(pixelBytes + 64 * 1024 > 0xFFFFFFFFull);
+    tiff.addImageTags(job.width, job.height, bytesPerPixel, job.depth, job.date);
+    const std::vector<uint8_t>& header = tiff.finish(IO_ALIGN);
+    file.headerBytes = header.size();
+
+    const uint64_t body = pixelBytes & ~static_cast<uint64_t>(IO_ALIGN - 1);
+    const size_t tail = static_cast<size_t>(pixelBytes - body);
+    const size_t stageBytes = header.size() + static_cast<size_t>(alignIo(tail));
+    if (file.stage.capacity < stageBytes) {
+        recorderFree(file.stage.data, file.stage.charged);
+        file.stage.capacity = stageBytes;
+        file.stage.data = recorderAlloc(stageBytes, file.stage.charged);
+        if (!file.stage.data) {
+            file.stage.capacity = 0;
+            reportError(40, "Out of memory for " + file.path);
+            return false;
+        }
+    }
+
+    if (!file.file.open(file.path, m_directIO)) {
+        reportError(40, "Cannot create " + file.path);
+        return false;
+    }
+
+    // Header and tail share the stage buffer; the body goes from the frame
+    uint8_t* stage = file.stage.data;
+    std::memcpy(stage, header.data(), header.size());
+    std::memcpy(stage + header.size(), job.pixels + body, tail);
+    std::memset(stage + header.size() + tail, 0, stageBytes - header.size() - tail);
+
+    const uint32_t slotCount = static_cast<uint32_t>(m_slots.size());
+    const int stageFixed = uringBuffer(uring, slotCount + index, stage, file.stage.capacity);
+    const int bodyFixed = job.slot >= 0 ?
+        uringBuffer(uring, static_cast<uint32_t>(job.slot), m_slots[job.slot].data,
+                    m_slots[job.slot].capacity) : -1;
+
+    file.pending = 0;
+    uringQueue(uring, index, stage, header.size(), 0, stageFixed);
+    uringQueue(uring, index, job.pixels, body, header.size(), bodyFixed);
+    uringQueue(uring, index, stage + header.size(), stageBytes - header.size(),
+               header.size() + body, stageFixed);
+    return true;
+}
+
+int XRecorder::Impl::uringBuffer(Uring& uring, uint32_t index, const uint8_t* data, size_t size) {
+    if (!uring.fixed) {
+        return -1;
+    }
+    std::pair<const uint8_t*, size_t>& entry = uring.registered[index];
+    if (entry.first != data || entry.second != size) {
+        // Buffers the kernel cannot pin (RLIMIT_MEMLOCK) are written unregistered
+        if (!uring.ring.setBuffer(index, data, size)) {
+            entry = std::make_pair(nullptr, 0);
+            return -1;
+        }
+        entry = std::make_pair(data, size);
+    }
+    return static_cast<int>(index);
+}
+
+void XRecorder::Impl::uringQueue(Uring& uring, uint32_t file, const uint8_t* data, uint64_t length,
+                                 uint64_t offset, int fixed) {
+    while (length > 0) {
+        UringWrite write;
+        write.file = file;
+        write.data = data;
+        write.length = static_cast<uint32_t>(std::min(length, URING_CHUNK));
+        write.offset = offset;
+        write.fixed = fixed;
+
+        uint32_t tag;
+        if (uring.freeWrites.empty()) {
+            tag = static_cast<uint32_t>(uring.writes.size());
+            uring.writes.push_back(write);
+        } else {
+            tag = uring.freeWrites.back();
+            uring.freeWrites.pop_back();
+            uring.writes[tag] = write;
+        }
+        uringSubmit(uring, write, tag);
+        ++uring.files[file].pending;
+
+        data += write.length;
+        offset += write.length;
+        length -= write.length;
+    }
+}
+
+void XRecorder::Impl::uringSubmit(Uring& uring, const UringWrite& write, uint32_t tag) {
+    const int fd = uring.files[write.file].file.descriptor();
+    // A full submission queue is handed to the kernel to make room
+    while (!uring.ring.write(fd, write.data, write.length, write.offset, tag, write.fixed)) {
+        uring.ring.submit(0, 0);
+    }
+}
+
+#endif // _WIN32
+
+XRecorder::Statistics XRecorder::Impl::getStatistics() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Statistics stats = m_stats;
+    stats.queued = static_cast<uint32_t>(m_queue.size()) + m_reserved;
+    const double elapsed = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - m_startTime).count();
+    const double mb = static_cast<double>(m_stats.bytesWritten) / (1024.0 * 1024.0);
+    stats.averageMBps = elapsed > 0.0 ? mb / elapsed : 0.0;
+    stats.diskMBps = m_writeSeconds > 0.0 ? mb / m_writeSeconds : 0.0;
+    return stats;
+}
+
+void XRecorder::Impl::reportError(uint32_t errorId, const std::string& message) {
+    HX_LOG_ID(::HX::XFactory::LOG_ERROR, "XRecorder", errorId) << "ERROR " << errorId << ": " << message;
+
+    if (m_sink) {
+        m_sink->OnXError(errorId, message.c_str());
+    }
+}
+
+void XRecorder::Impl::reportEvent(uint32_t eventId, uint32_t data) {
+    if (m_sink) {
+        m_sink->OnXEvent(eventId, data);
+    }
+}
+
+// ============================================================================
+// Public interface
+// ============================================================================
+
+XRecorder::XRecorder()
+    : m_impl(new Impl())
+{
+}
+
+XRecorder::~XRecorder() {
+    delete m_impl;
+}
+
+void XRecorder::SetSink(IXImgSink* sink_) {
+    if (!m_impl) return;
+    m_impl->setSink(sink_);
+}
+
+bool XRecorder::SetQueueDepth(uint32_t frames) {
+    if (!m_impl) return false;
+    return m_impl->setQueueDepth(frames);
+}
+
+uint32_t XRecorder::GetQueueDepth() const {
+    if (!m_impl) return 0;
+    return m_impl->getQueueDepth();
+}
+
+void XRecorder::SetQueuePolicy(QueuePolicy policy, uint32_t blockTimeoutMs) {
+    if (!m_impl) return;
+    m_impl->setQueuePolicy(policy, blockTimeoutMs);
+}
+
+XRecorder::QueuePolicy XRecorder::GetQueuePolicy() const {
+    if (!m_impl) return QUEUE_DROP_NEWEST;
+    return m_impl->getQueuePolicy();
+}
+
+bool XRecorder::SetDirectIO(bool enable) {
+    if (!m_impl) return false;
+    return m_impl->setDirectIO(enable);
+}
+
+bool XRecorder::SetIndexing(bool enable) {
+    if (!m_impl) return false;
+    return m_impl->setIndexing(enable);
+}
+
+bool XRecorder::SetIoUring(bool enable) {
+    if (!m_impl) return false;
+    return m_impl->setIoUring(enable);
+}
+
+bool XRecorder::SetCompression(XFile::XFCompression mode, uint32_t keyframeInterval) {
+    if (!m_impl) return false;
+    return m_impl->setCompression(mode, keyframeInterval);
+}
+
+bool XRecorder::Start(const std::string& directory, const std::string& prefix) {
+    if (!m_impl) return false;
+    return m_impl->start(directory, prefix);
+}
+
+void XRecorder::Stop() {
+    if (!m_impl) return;
+    m_impl->stop();
+}
+
+bool XRecorder::IsRunning() const {
+    if (!m_impl) return false;
+    return m_impl->isRunning();
+}
+
+bool XRecorder::Submit(XImage* image, XFrame* pool) {
+    if (!m_impl) return false;
+    return m_impl->submit(image, pool);
+}
+
+XRecorder::Statistics XRecorder::GetStatistics() const {
+    if (!m_impl) return Statistics();
+    return m_impl->getStatistics();
+}
+
+} // namespace HX
@@ -0,0 +1,595 @@
+// ============================================================================
+// XSequenceReader.cpp - Frame sequences for playback and scrubbing
+// ============================================================================
+
+/**
+ * @file XSequenceReader.cpp
+ * @brief XSequenceReader implementation - step prediction, prefetch workers, frame cache
+ * @version 2.1.0
+ */
+
+#include "XSequenceReader.h"
+#include "XFile.h"
+#include "XImage.h"
+#include "XStreamFile.h"
+#include "utils/thread_pool.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#endif
+
+namespace HX {
+
+namespace {
+
+const uint32_t DEFAULT_PREFETCH = 8;
+const uint32_t DEFAULT_THREADS = 2;
+const uint32_t MAX_THREADS = 16;
+
+/// Largest prefetch depth; 2 * 256 cached frames is already a lot of memory
+const uint32_t MAX_PREFETCH = 256;
+
+const size_t PAGE_BYTES = 4096;
+
+/**
+ * @brief Bring a frame's pixels into memory
+ *
+ * For a mapped capture the advice starts the kernel's read-ahead over the
+ * whole frame at once; touching a byte per page then waits for it, so the
+ * frame is resident before it is requested.
+ */
+void pageIn(const XImage& image) {
+    const uint8_t* pixels = image._data_ + image._data_offset;
+    const size_t bytes = static_cast<size_t>(image._stride) * image._height;
+    if (!image._data_ || bytes == 0) {
+        return;
+    }
+#ifndef _WIN32
+    const uintptr_t begin = reinterpret_cast<uintptr_t>(pixels) & ~static_cast<uintptr_t>(PAGE_BYTES - 1);
+    const uintptr_t end = reinterpret_cast<uintptr_t>(pixels) + bytes;
+    madvise(reinterpret_cast<void*>(begin), end - begin, MADV_WILLNEED);
+#endif
+    volatile uint8_t sink = 0;
+    for (size_t offset = 0; offset < bytes; offset += PAGE_BYTES) {
+        sink = static_cast<uint8_t>(sink ^ pixels[offset]);
+    }
+    sink = static_cast<uint8_t>(sink ^ pixels[bytes - 1]);
+}
+
+} // anonymous namespace
+
+class XSequenceReader::Impl {
+public:
+    Impl();
+    ~Impl();
+
+    bool setPrefetch(uint32_t frames, uint32_t threads);
+    bool openFiles(const std::vector<std::string>& files);
+    bool openStream(const std::string& file, uint32_t linesPerFrame);
+    void close();
+    bool isOpen() const { return m_frameCount > 0; }
+    uint32_t getFrameCount() const { return m_frameCount; }
+    const XImage* getFrame(uint32_t index);
+    Statistics getStatistics() const;
+
+private:
+    enum SlotState {
+        SLOT_EMPTY = 0,
+        SLOT_LOADING,
+        SLOT_READY,
+        SLOT_FAILED
+    };
+
+    struct Slot {
+        std::unique_ptr<XFile> file;    ///< Mapping or decoded capture (file sequences)
+        std::unique_ptr<XImage> image;  ///< Lines read (stream sequences)
+        const XImage* frame;
+        uint32_t index;
+        SlotState state;
+        uint64_t lastUse;
+        bool prefetched;                ///< Loaded by a worker ...
+        bool used;                      ///< ... and requested since
+        uint32_t readers;               ///< Loads decoding against this frame
+    };
+
+    void start();
+    void workerThread();
+    bool load(Slot& slot, uint32_t index, XStreamFile* stream, bool ahead);
+    Slot* acquireReference(uint32_t index);
+    void releaseReference(Slot* slot);
+
+    // Called with m_mutex held
+    void predict(uint32_t index);
+    void schedule(uint32_t index);
+    bool inWindow(uint32_t index) const;
+    Slot* find(uint32_t index);
+    Slot* claim(uint32_t index, bool anyFrame);
+    void finish(Slot& slot, bool ok, bool ahead);
+
+    // Configuration
+    uint32_t m_prefetch;
+    uint32_t m_threads;
+
+    // Sequence, fixed while open
+    std::vector<std::string> m_files;
+    std::string m_streamName;
+    uint32_t m_linesPerFrame;
+    uint32_t m_frameCount;
+    std::unique_ptr<XStreamFile> m_stream;  ///< Calling thread's handle
+    std::atomic<bool> m_temporal;           ///< A file held XF_COMPRESS_TEMPORAL residuals
+
+    // Cache and prediction, guarded by m_mutex
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wake;         ///< Workers: queue changed or stop
+    std::condition_variable m_loaded;       ///< GetFrame(): a slot finished loading
+    std::vector<std::unique_ptr<Slot> > m_slots;
+    std::deque<uint32_t> m_queue;
+    Slot* m_pinned;                         ///< Frame returned by the last GetFrame()
+    uint32_t m_last;
+    int64_t m_step;
+    bool m_haveLast;
+    uint64_t m_clock;
+    bool m_stop;
+    Statistics m_stats;
+
+    std::vector<std::thread> m_workers;
+};
+
+XSequenceReader::Impl::Impl()
+    : m_prefetch(DEFAULT_PREFETCH)
+    , m_threads(DEFAULT_THREADS)
+    , m_linesPerFrame(0)
+    , m_frameCount(0)
+    , m_temporal(false)
+    , m_pinned(nullptr)
+    , m_last(0)
+    , m_step(1)
+    , m_haveLast(false)
+    , m_clock(0)
+    , m_stop(false)
+    , m_stats()
+{
+}
+
+XSequenceReader::Impl::~Impl() {
+    close();
+}
+
+bool XSequenceReader::Impl::setPrefetch(uint32_t frames, uint32_t threads) {
+    if (isOpen() || frames > MAX_PREFETCH || threads == 0 || threads > MAX_THREADS) {
+        return false;
+    }
+    m_prefetch = frames;
+    m_threads = threads;
+    return true;
+}
+
+bool XSequenceReader::Impl::openFiles(const std::vector<std::string>& files) {
+    close();
+    if (files.empty()) {
+        return false;
+    }
+    m_files = files;
+    m_frameCount = static_cast<uint32_t>(std::min<size_t>(files.size(), UINT32_MAX));
+    start();
+
+    // Fail early on a sequence that cannot be read at all
+    if (!getFrame(0)) {
+        std::cerr << "[XSequenceReader] Failed to read " << files[0] << std::endl;
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool XSequenceReader::Impl::openStream(const std::string& file, uint32_t linesPerFrame) {
+    close();
+    if (linesPerFrame == 0) {
+        return false;
+    }
+    std::unique_ptr<XStreamFile> stream(new XStreamFile());
+    if (!stream->Open(file)) {
+        return false;
+    }
+    const uint64_t frames = (stream->GetLineCount() + linesPerFrame - 1) / linesPerFrame;
+    if (frames == 0 || frames > UINT32_MAX) {
+        std::cerr << "[XSequenceReader] Stream holds no frames: " << file << std::endl;
+        return false;
+    }
+    m_stream.swap(stream);
+    m_streamName = file;
+    m_linesPerFrame = linesPerFrame;
+    m_frameCount = static_cast<uint32_t>(frames);
+    start();
+    return true;
+}
+
+void XSequenceReader::Impl::start() {
+    // Every worker loading, the pinned frame and twice the window still
+    // leave GetFrame() a slot to load into
+    const uint32_t slots = 2 * m_prefetch + m_threads + 1;
+    m_slots.clear();
+    for (uint32_t i = 0; i < slots; ++i) {
+        std::unique_ptr<Slot> slot(new Slot());
+        slot->frame = nullptr;
+        slot->index = 0;
+        slot->state = SLOT_EMPTY;
+        slot->lastUse = 0;
+        slot->prefetched = false;
+        slot->used = false;
+        slot->readers = 0;
+        if (m_stream) {
+            slot->image.reset(new XImage());
+        }
+        m_slots.push_back(std::move(slot));
+    }
+    m_stats = Statistics();
+    m_pinned = nullptr;
+    m_haveLast = false;
+    m_step = 1;
+    m_clock = 0;
+    m_stop = false;
+    if (m_prefetch > 0) {
+        for (uint32_t i = 0; i < m_threads; ++i) {
+            m_workers.push_back(std::thread(&Impl::workerThread, this));
+        }
+    }
+}
+
+void XSequenceReader::Impl::close() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+        m_queue.clear();
+    }
+    m_wake.notify_all();
+    for (size_t i = 0; i < m_workers.size(); ++i) {
+        m_workers[i].join();
+    }
+    m_workers.clear();
+    m_slots.clear();
+    m_pinned = nullptr;
+    m_stream.reset();
+    m_files.clear();
+    m_streamName.clear();
+    m_linesPerFrame = 0;
+    m_frameCount = 0;
+    m_temporal = false;
+}
+
+bool XSequenceReader::Impl::load(Slot& slot, uint32_t index, XStreamFile* stream, bool ahead) {
+    if (!m_files.empty()) {
+        // A fresh XFile each time: Read() keeps the size of an image it reuses
+        std::unique_ptr<XFile> file(new XFile());
+        // Temporal residuals decode against the frame before when it is
+        // cached; otherwise XFile reads back from the last keyframe
+        Slot* reference = index > 0 ? acquireReference(index - 1) : nullptr;
+        if (reference) {
+            const std::string& name = m_files[index - 1];
+            file->SetReference(reference->frame, name.substr(name.find_last_of("/\\") + 1));
+        }
+        const bool ok = file->Map(m_files[index]) && file->GetImage();
+        releaseReference(reference);
+        if (!ok) {
+            return false;
+        }
+        if (file->GetCompression() == XFile::XF_COMPRESS_TEMPORAL) {
+            m_temporal = true;
+        }
+        if (ahead) {
+            pageIn(*file->GetImage());
+        }
+        slot.file.swap(file);
+        slot.frame = slot.file->GetImage();
+        return true;
+    }
+    if (!stream) {
+        return false;
+    }
+    const uint64_t firstLine = static_cast<uint64_t>(index) * m_linesPerFrame;
+    if (!stream->ReadLines(firstLine, m_linesPerFrame, slot.image.get())) {
+        return false;
+    }
+    slot.frame = slot.image.get();
+    return true;
+}
+
+XSequenceReader::Impl::Slot* XSequenceReader::Impl::acquireReference(uint32_t index) {
+    if (!m_temporal) {
+        return nullptr;
+    }
+    std::unique_lock<std::mutex> lock(m_mutex);
+    Slot* slot = find(index);
+    // A frame still loading is the cheapest reference there is; it only
+    // waits on lower indexes, so loads never wait in a circle
+    while (slot && slot->state == SLOT_LOADING && !m_stop) {
+        m_loaded.wait(lock);
+        slot = find(index);
+    }
+    if (!slot || slot->state != SLOT_READY || !slot->frame) {
+        return nullptr;
+    }
+    ++slot->readers;
+    return slot;
+}
+
+void XSequenceReader::Impl::releaseReference(Slot* slot) {
+    if (slot) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        --slot->readers;
+    }
+}
+
+void XSequenceReader::Impl::workerThread() {
+    // Prefetched strips decode behind live corrections
+    Internal::ThreadPool::setPriority(Internal::ThreadPool::PRIORITY_COUNT - 1);
+
+    std::unique_ptr<XStreamFile> stream;
+    if (!m_streamName.empty()) {
+        stream.reset(new XStreamFile());
+        if (!stream->Open(m_streamName)) {
+            stream.reset();
+        }
+    }
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_stop) {
+        if (m_queue.empty()) {
+            m_wake.wait(lock);
+            continue;
+        }
+        const uint32_t index = m_queue.front();
+        m_queue.pop_front();
+        if (find(index)) {
+            continue;
+        }
+        Slot* slot = claim(index, false);
+        if (!slot) {
+            // The window is cached or loading; nothing to make room for
+            m_queue.clear();
+            continue;
+        }
+        lock.unlock();
+        const bool ok = load(*slot, index, stream.get(), true);
+        lock.lock();
+        finish(*slot, ok, true);
+    }
+}
+
+void XSequenceReader::Impl::predict(uint32_t index) {
+    // A short step sets the step; a longer jump, a seek, keeps its size
+    // and takes the jump's direction
+    if (m_haveLast && index != m_last) {
+        const int64_t delta = static_cast<int64_t>(index) - static_cast<int64_t>(m_last);
+        const int64_t span = static_cast<int64_t>(std::max(m_prefetch, 1u));
+        if (delta >= -span && delta <= span) {
+            m_step = delta;
+        } else if ((delta > 0) != (m_step > 0)) {
+            m_step = -m_step;
+        }
+    }
+    m_last = index;
+    m_haveLast = true;
+}
+
+void XSequenceReader::Impl::schedule(uint32_t index) {
+    m_queue.clear();
+    for (uint32_t k = 1; k <= m_prefetch; ++k) {
+        const int64_t next = static_cast<int64_t>(index) + m_step * k;
+        if (next < 0 || next >= static_cast<int64_t>(m_frameCount)) {
+            break;
+        }
+        if (!find(static_cast<uint32_t>(next))) {
+            m_queue.push_back(static_cast<uint32_t>(next));
+        }
+    }
+    if (!m_queue.empty()) {
+        m_wake.notify_all();
+    }
+}
+
+bool XSequenceReader::Impl::inWindow(uint32_t index) const {
+    const int64_t delta = static_cast<int64_t>(index) - static_cast<int64_t>(m_last);
+    if (delta % m_step != 0) {
+        return false;
+    }
+    const int64_t k = delta / m_step;
+    return k >= 0 && k <= static_cast<int64_t>(m_prefetch);
+}
+
+XSequenceReader::Impl::Slot* XSequenceReader::Impl::find(uint32_t index) {
+    for (size_t i = 0; i < m_slots.size(); ++i) {
+        Slot* slot = m_slots[i].get();
+        if (slot->index == index && (slot->state == SLOT_LOADING || slot->state == SLOT_READY)) {
+            return slot;
+        }
+    }
+    return nullptr;
+}
+
+XSequenceReader::Impl::Slot* XSequenceReader::Impl::claim(uint32_t index, bool anyFrame) {
+    // Empty or failed slots first, then the least recently used frame
+    // outside the predicted window; GetFrame() may take one inside it
+    Slot* best = nullptr;
+    for (size_t i = 0; i < m_slots.size(); ++i) {
+        Slot* slot = m_slots[i].get();
+        if (slot == m_pinned || slot->state == SLOT_LOADING || slot->readers > 0) {
+            continue;
+        }
+        if (slot->state != SLOT_READY) {
+            best = slot;
+            break;
+        }
+        if (!anyFrame && inWindow(slot->index)) {
+            continue;
+        }
+        if (!best || slot->lastUse < best->lastUse) {
+            best = slot;
+        }
+    }
+    if (!best) {
+        return nullptr;
+    }
+    if (best->state == SLOT_READY && best->prefetched && !best->used) {
+        ++m_stats.unused;
+    }
+    if (best->state == SLOT_READY) {
+        --m_stats.cached;
+    }
+    best->index = index;
+    best->state = SLOT_LOADING;
+    best->frame = nullptr;
+    best->prefetched = false;
+    best->used = false;
+    return best;
+}
+
+void XSequenceReader::Impl::finish(Slot& slot, bool ok, bool ahead) {
+    slot.state = ok ? SLOT_READY : SLOT_FAILED;
+    slot.lastUse = ++m_clock;
+    slot.prefetched = ahead;
+    if (ok) {
+        ++m_stats.cached;
+        if (ahead) {
+            ++m_stats.prefetched;
+        }
+    } else {
+        slot.file.reset();
+        ++m_stats.failed;
+    }
+    m_loaded.notify_all();
+}
+
+const XImage* XSequenceReader::Impl::getFrame(uint32_t index) {
+    if (index >= m_frameCount) {
+        return nullptr;
+    }
+    std::unique_lock<std::mutex> lock(m_mutex);
+    ++m_stats.requests;
+    m_pinned = nullptr;
+    predict(index);
+
+    Slot* slot = find(index);
+    if (slot && slot->state == SLOT_READY) {
+        ++m_stats.hits;
+        schedule(index);
+    } else if (slot) {
+        ++m_stats.waits;
+        schedule(index);
+        while (slot->state == SLOT_LOADING) {
+            m_loaded.wait(lock);
+        }
+        if (slot->state != SLOT_READY) {
+            return nullptr;
+        }
+    } else {
+        ++m_stats.misses;
+        slot = claim(index, true);
+        if (!slot) {
+            return nullptr;
+        }
+        // The workers start on the frames after this one while it loads
+        schedule(index);
+        lock.unlock();
+        const bool ok = load(*slot, index, m_stream.get(), false);
+        lock.lock();
+        finish(*slot, ok, false);
+        if (!ok) {
+            return nullptr;
+        }
+    }
+
+    slot->lastUse = ++m_clock;
+    slot->used = true;
+    m_pinned = slot;
+    return slot->frame;
+}
+
+XSequenceReader::Statistics XSequenceReader::Impl::getStatistics() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+// ============================================================================
+// XSequenceReader public interface
+// ============================================================================
+
+XSequenceReader::XSequenceReader()
+    : m_impl(new Impl())
+{
+}
+
+XSequenceReader::~XSequenceReader() {
+    if (m_impl) {
+        delete m_impl;
+        m_impl = nullptr;
+    }
+}
+
+bool XSequenceReader::SetPrefetch(uint32_t frames, uint32_t threads) {
+    if (!m_impl) {
+        return false;
+    }
+    return m_impl->setPrefetch(frames, threads);
+}
+
+bool XSequenceReader::OpenFiles(const std::vector<std::string>& files) {
+    if (!m_impl) {
+        return false;
+    }
+    return m_impl->openFiles(files);
+}
+
+bool XSequenceReader::OpenStream(const std::string& file, uint32_t linesPerFrame) {
+    if (!m_impl) {
+        return false;
+    }
+    return m_impl->openStream(file, linesPerFrame);
+}
+
+void XSequenceReader::Close() {
+    if (!m_impl) {
+        return;
+    }
+    m_impl->close();
+}
+
+bool XSequenceReader::IsOpen() const {
+    if (!m_impl) {
+        return false;
+    }
+    return m_impl->isOpen();
+}
+
+uint32_t XSequenceReader::GetFrameCount() const {
+    if (!m_impl) {
+        return 0;
+    }
+    return m_impl->getFrameCount();
+}
+
+const XImage* XSequenceReader::GetFrame(uint32_t index) {
+    if (!m_impl) {
+        return nullptr;
+    }
+    return m_impl->getFrame(index);
+}
+
+XSequenceReader::Statistics XSequenceReader::GetStatistics() const {
+    if (!m_impl) {
+        Statistics empty = {};
+        return empty;
+    }
+    return m_impl->getStatistics();
+}
+
+} // namespace HX
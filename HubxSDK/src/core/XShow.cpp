@@ -1,25 +1,154 @@
 // ============================================================================
-// XShow.cpp - Display functionality (Windows only)
+// XShow.cpp - Display functionality (Windows, X11)
 // ============================================================================
 
 /**
  * @file XShow.cpp
- * @brief XShow implementation - Image display (Windows only)
+ * @brief XShow implementation - Image display (Windows, X11)
  * @version 2.1.0
  */
 
 #include "XShow.h"
 #include "XImage.h"
 #include "XDetector.h"
+#include "XPixel.h"
+#include "utils/clahe.h"
+#include "utils/gl_display.h"
+#include "utils/material_class.h"
+#include "utils/mem_profile.h"
+#include "utils/overload.h"
+#include "utils/thread_pool.h"
+#include "utils/window_level.h"
+#include "utils/x11_display.h"
 #include <iostream>
 #include <cmath>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 #ifdef _WIN32
 #include <windows.h>
 #endif
 
+// Builds with a presentation path; elsewhere Open() fails
+#if defined(_WIN32) || defined(HUBX_WITH_X11)
+#define HX_XSHOW_DISPLAY 1
+#endif
+
 namespace HX {
 
+using Internal::MaterialModel;
+using Internal::WindowKernel;
+using Internal::WindowParams;
+using Internal::windowLevel;
+
+namespace {
+
+/// Screen rectangle of the presented buffer, half-open
+struct OverlayRect {
+    int32_t x0;
+    int32_t y0;
+    int32_t x1;
+    int32_t y1;
+    
+    bool empty() const { return x0 >= x1 || y0 >= y1; }
+};
+
+OverlayRect unite(const OverlayRect& a, const OverlayRect& b) {
+    if (a.empty()) return b;
+    if (b.empty()) return a;
+    OverlayRect r = { std::min(a.x0, b.x0), std::min(a.y0, b.y0),
+                      std::max(a.x1, b.x1), std::max(a.y1, b.y1) };
+    return r;
+}
+
+/**
+ * @brief Copy the rows of a frame, reallocating on a new geometry
+ */
+bool copyFrame(XImage& copy, const XImage& image) {
+    if (copy._width != image._width || copy._height != image._height ||
+        copy._pixel_depth != image._pixel_depth) {
+        Internal::MemTagScope memTag(XFactory::MEM_DISPLAY);
+        if (!copy.Allocate(image._width, image._height, image._pixel_depth)) {
+            return false;
+        }
+    }
+    const size_t rowBytes = static_cast<size_t>(image._width) * ((image._pixel_depth + 7) / 8);
+    for (uint32_t row = 0; row < image._height; ++row) {
+        memcpy(copy._data_ + copy._data_offset + static_cast<size_t>(row) * copy._stride,
+               image._data_ + image._data_offset + static_cast<size_t>(row) * image._stride,
+               rowBytes);
+    }
+    copy._info = image._info;
+    return true;
+}
+
+/// Widest histogram; deeper pixels share bins
+const uint32_t STATS_BITS = 16;
+
+/**
+ * @brief Histogram and exact sums of one band of rows
+ *
+ * Up to 16 bits a bin is a value and min/max/mean come from the
+ * histogram; deeper pixels also track their min, max and sum directly.
+ */
+struct StatsBand {
+    std::vector<uint32_t> histogram;
+    uint32_t min;
+    uint32_t max;
+    uint64_t sum;
+    
+    explicit StatsBand(uint32_t bins)
+        : histogram(bins, 0), min(0xFFFFFFFFu), max(0), sum(0) {}
+    
+    template <uint32_t Bytes>
+    void add(const XPixelRow<Bytes>& pixels, uint32_t col0, uint32_t col1, uint32_t shift) {
+        uint32_t* bins = histogram.data();
+        for (uint32_t col = col0; col < col1; ++col) {
+            const uint32_t value = pixels.Get(col);
+            ++bins[value >> shift];
+            if (Bytes > 2) {
+                min = std::min(min, value);
+                max = std::max(max, value);
+                sum += value;
+            }
+        }
+    }
+    
+    void merge(const StatsBand& other) {
+        for (size_t i = 0; i < histogram.size(); ++i) {
+            histogram[i] += other.histogram[i];
+        }
+        min = std::min(min, other.min);
+        max = std::max(max, other.max);
+        sum += other.sum;
+    }
+};
+
+/**
+ * @brief One job's share of the statistics, merged band by band
+ */
+struct StatsPass {
+    bool enabled;
+    uint32_t shift;
+    uint32_t bins;
+    uint32_t roiX0;
+    uint32_t roiY0;
+    uint32_t roiX1;
+    uint32_t roiY1;
+    std::mutex mutex;
+    std::unique_ptr<StatsBand> total;
+    std::unique_ptr<StatsBand> roi;
+};
+
+} // namespace
+
 class XShow::Impl {
 public:
     Impl();
@@ -32,14 +161,151 @@ public:
     bool isOpen() const { return m_opened; }
     
     void show(XImage* img_);
+    void show(XImage* high, XImage* low);
+    void showLines(const XImage* strip, uint32_t count);
     
     void setGama(float gama);
     float getGama() const { return m_gamma; }
+    bool setWindow(uint32_t low, uint32_t high);
+    void getWindow(uint32_t& low, uint32_t& high) const;
+    void setAutoWindow(bool enable, float clip);
+    bool setContrastEnhancement(bool enable, uint32_t tiles, float clipLimit);
+    void setMaterialColors(uint32_t organic, uint32_t inorganic, uint32_t metal);
+    bool setMaterialModel(const MaterialModel& model);
+    bool setBackend(XBackend backend);
+    XBackend getBackend() const;
+    bool setAsync(bool enable, uint32_t maxFps);
+    uint64_t getDroppedFrames() const { return m_droppedFrames.load(); }
+    
+    uint32_t addOverlay(XOverlay type, int32_t x0, int32_t y0, int32_t x1, int32_t y1,
+                        uint32_t rgb);
+    bool moveOverlay(uint32_t id, int32_t x0, int32_t y0, int32_t x1, int32_t y1);
+    bool removeOverlay(uint32_t id);
+    void clearOverlays();
+    
+    void setStatistics(bool enable);
+    bool setStatisticsRoi(uint32_t x, uint32_t y, uint32_t width, uint32_t height);
+    bool getStatistics(XStatistics& stats, XStatistics* roi) const;
+    uint32_t getHistogram(uint32_t* bins, uint32_t count, bool roi) const;
     
 private:
-    void applyColorMap(uint8_t* displayBuffer, const uint8_t* imageData, 
-                       uint32_t pixelCount);
+    struct Overlay {
+        uint32_t id;
+        XOverlay type;
+        int32_t x0;
+        int32_t y0;
+        int32_t x1;
+        int32_t y1;
+        uint8_t bgr[3];
+    };
+    
+    // A mailbox slot: one frame, or a dual-energy pair
+    struct Pending {
+        XImage image;
+        XImage low;
+        bool pair;
+    };
+    
+    void render(const XImage* img_, const XImage* low);
+    bool selectBackend(XBackend backend);
+    void submit(const XImage* img_, const XImage* low);
+    void renderThread(uint32_t maxFps);
+    void stopRenderThread();
+    void prepare(const XImage* image);
+    bool presentGl(const XImage* image, uint32_t firstRow, uint32_t rows,
+                   uint32_t texRow, uint32_t topRow);
+    bool clientSize(uint32_t& width, uint32_t& height);
+    void present(uint32_t width, uint32_t rows, size_t stride, uint32_t split);
+    void presentRect(const OverlayRect& rect);
+    void compose(uint32_t width, uint32_t rows, size_t stride, uint32_t split, uint32_t factor);
+    void eraseOverlays();
+    void refreshOverlays(const OverlayRect& rect);
+    void restoreRect(const OverlayRect& rect);
+    void drawOverlay(const Overlay& overlay, const OverlayRect& clip);
+    OverlayRect overlayBounds(const Overlay& overlay) const;
+    uint8_t* shownPixel(uint8_t* buffer, int32_t x, int32_t y) const;
+    void applyColorMap(uint8_t* displayBuffer, const XImage* image,
+                       uint32_t factor, size_t stride,
+                       uint32_t firstRow = 0, uint32_t outRow = 0,
+                       const uint8_t* frameLevels = nullptr);
+    template <uint32_t Bytes>
+    void applyColorMapRows(uint8_t* displayBuffer, const XImage* image, size_t stride,
+                           uint32_t firstRow, uint32_t outRow, const uint8_t* frameLevels);
+    void applyMaterialMap(uint8_t* displayBuffer, const XImage* high, const XImage* low,
+                          uint32_t factor, size_t stride, const uint8_t* frameLevels);
+    template <uint32_t Bytes>
+    void applyMaterialMapRows(uint8_t* displayBuffer, const XImage* high, const XImage* low,
+                              size_t stride, const uint8_t* frameLevels);
+    template <uint32_t Bytes>
+    void applyMaterialMapDecimated(uint8_t* displayBuffer, const XImage* high, const XImage* low,
+                                   uint32_t factor, size_t stride, const uint8_t* frameLevels);
+    void beginStatistics(StatsPass& pass, uint32_t cols);
+    template <uint32_t Bytes>
+    void accumulateRow(StatsPass& pass, StatsBand* band[2], const XPixelRow<Bytes>& pixels,
+                       uint32_t row, uint32_t cols);
+    void mergeStatistics(StatsPass& pass, StatsBand* band[2]);
+    void endStatistics(StatsPass& pass);
+    template <uint32_t Bytes>
+    void applyColorMapDecimated(uint8_t* displayBuffer, const XImage* image,
+                                uint32_t factor, size_t stride, const uint8_t* frameLevels);
+    void mapColor(uint8_t normalized, uint8_t& r, uint8_t& g, uint8_t& b) const;
     uint8_t applyGamma(uint8_t value);
+    void buildLut();
+    WindowParams windowParams() const;
+    template <uint32_t Bytes>
+    void autoWindow(const XImage* image);
+    
+    // Binds applyColorMapRows<Bytes> for XDispatchPixelBytes
+    struct ColorMapKernel {
+        Impl* self;
+        uint8_t* displayBuffer;
+        const XImage* image;
+        uint32_t factor;
+        size_t stride;
+        uint32_t firstRow;
+        uint32_t outRow;
+        const uint8_t* frameLevels;
+        
+        template <uint32_t Bytes>
+        void run() {
+            if (factor > 1) {
+                self->applyColorMapDecimated<Bytes>(displayBuffer, image, factor, stride, frameLevels);
+            } else {
+                self->applyColorMapRows<Bytes>(displayBuffer, image, stride, firstRow, outRow,
+                                               frameLevels);
+            }
+        }
+    };
+    
+    // Binds applyMaterialMapRows<Bytes> for XDispatchPixelBytes
+    struct MaterialMapKernel {
+        Impl* self;
+        uint8_t* displayBuffer;
+        const XImage* high;
+        const XImage* low;
+        uint32_t factor;
+        size_t stride;
+        const uint8_t* frameLevels;
+        
+        template <uint32_t Bytes>
+        void run() {
+            if (factor > 1) {
+                self->applyMaterialMapDecimated<Bytes>(displayBuffer, high, low, factor, stride,
+                                                       frameLevels);
+            } else {
+                self->applyMaterialMapRows<Bytes>(displayBuffer, high, low, stride, frameLevels);
+            }
+        }
+    };
+    
+    // Binds autoWindow<Bytes> for XDispatchPixelBytes
+    struct AutoWindowKernel {
+        Impl* self;
+        const XImage* image;
+        
+        template <uint32_t Bytes>
+        void run() { self->autoWindow<Bytes>(image); }
+    };
     
     uint32_t m_width;
     uint32_t m_height;
@@ -49,9 +315,92 @@ private:
     float m_gamma;
     bool m_opened;
     
+    // BGR per 8-bit level; rebuilt when the color map or gamma changes
+    std::vector<uint8_t> m_lut;
+    bool m_lutValid;
+    
+    // Show(high, low): (high, low) cell -> class, and BGR per class and
+    // level, built with m_lut
+    MaterialModel m_materialModel;
+    std::vector<uint16_t> m_materialTable;
+    bool m_materialTableValid;          ///< Built for m_materialModel and m_pixelDepth
+    uint32_t m_materialRgb[3];          ///< Organic, inorganic, metal
+    std::vector<uint8_t> m_materialLut;
+    
+    // Display window; high = 0 is the full 0..2^depth-1 range
+    uint32_t m_windowLow;
+    uint32_t m_windowHigh;
+    bool m_autoWindow;
+    float m_autoClip;
+    WindowKernel m_windowKernel;
+    
+    // Local contrast stage, in place of the window
+    bool m_claheEnabled;
+    Internal::Clahe m_clahe;
+    
+    // Shader presentation; the display buffer stays as the GDI fallback
+    XBackend m_backend;
+    Internal::GlDisplay m_gl;
+    bool m_glLutValid;
+    
+    // Waterfall: display rows form a ring, the next line goes to m_waterfallHead
+    uint32_t m_waterfallHead;
+    
+    // Display state shared by callers and the render thread
+    mutable std::mutex m_renderMutex;
+    
+    // Latest-frame-wins mailbox: Show() fills m_writeImage and swaps it
+    // with m_readyImage, the render thread swaps that with m_renderImage
+    Pending m_mailbox[3];
+    Pending* m_writeImage;
+    Pending* m_readyImage;
+    Pending* m_renderImage;
+    bool m_fresh;
+    bool m_renderStop;
+    std::mutex m_submitMutex;
+    std::mutex m_mailboxMutex;
+    std::condition_variable m_mailboxCv;
+    std::thread m_renderThread;
+    std::atomic<uint64_t> m_droppedFrames;
+    
+    // Converted frame: an owned DIB on Windows, the X image itself on X11
+    uint8_t* m_displayBuffer;
+    size_t m_displayStride;             ///< DIB rows are DWORD aligned
+    uint32_t m_displayPixelBytes;       ///< 3 (BGR) or 4 (BGRX)
+    Internal::X11Display m_x11;
+    
+    // Overlay layer: markers are drawn into the display buffer and
+    // m_cleanBuffer keeps the converted pixels, so a marker can be moved
+    // by restoring and re-blitting its rectangle alone
+    std::vector<Overlay> m_overlays;
+    uint32_t m_nextOverlayId;
+    std::vector<uint8_t> m_cleanBuffer;
+    bool m_overlaysDrawn;               ///< m_cleanBuffer matches the last frame
+    
+    // Layout of the last presented buffer (rows 0 = none, or OpenGL)
+    uint32_t m_shownWidth;
+    uint32_t m_shownRows;
+    size_t m_shownStride;
+    uint32_t m_shownSplit;
+    uint32_t m_shownFactor;
+    
+    // Statistics of the last converted image, a by-product of conversion
+    bool m_statsEnabled;
+    uint32_t m_roiX;
+    uint32_t m_roiY;
+    uint32_t m_roiWidth;
+    uint32_t m_roiHeight;
+    mutable std::mutex m_statsMutex;    ///< Guards the results below only
+    XStatistics m_stats;
+    XStatistics m_roiStats;
+    std::vector<uint32_t> m_histogram;
+    std::vector<uint32_t> m_roiHistogram;
+    
 #ifdef _WIN32
+    void blit(HDC hdc, const uint8_t* bits, uint32_t width, uint32_t x, uint32_t columns,
+              uint32_t rows, int y);
+    
     BITMAPINFO m_bitmapInfo;
-    uint8_t* m_displayBuffer;
 #endif
 };
 
@@ -63,24 +412,66 @@ XShow::Impl::Impl()
     , m_colorMode(XCOLOR_GRAY)
     , m_gamma(1.0f)
     , m_opened(false)
-#ifdef _WIN32
+    , m_lutValid(false)
+    , m_materialTableValid(false)
+    , m_windowLow(0)
+    , m_windowHigh(0)
+    , m_autoWindow(false)
+    , m_autoClip(0.005f)
+    , m_windowKernel(Internal::selectWindowKernel())
+    , m_claheEnabled(false)
+    , m_backend(XBACKEND_GDI)
+    , m_glLutValid(false)
+    , m_waterfallHead(0)
+    , m_writeImage(&m_mailbox[0])
+    , m_readyImage(&m_mailbox[1])
+    , m_renderImage(&m_mailbox[2])
+    , m_fresh(false)
+    , m_renderStop(false)
+    , m_droppedFrames(0)
     , m_displayBuffer(nullptr)
-#endif
+    , m_displayStride(0)
+    , m_displayPixelBytes(3)
+    , m_nextOverlayId(1)
+    , m_overlaysDrawn(false)
+    , m_shownWidth(0)
+    , m_shownRows(0)
+    , m_shownStride(0)
+    , m_shownSplit(0)
+    , m_shownFactor(1)
+    , m_statsEnabled(false)
+    , m_roiX(0)
+    , m_roiY(0)
+    , m_roiWidth(0)
+    , m_roiHeight(0)
 {
+    memset(&m_stats, 0, sizeof(m_stats));
+    memset(&m_roiStats, 0, sizeof(m_roiStats));
+    m_materialRgb[0] = 0xFF9000;
+    m_materialRgb[1] = 0x30C030;
+    m_materialRgb[2] = 0x3070FF;
 }
 
 XShow::Impl::~Impl() {
+    stopRenderThread();
     close();
 }
 
 bool XShow::Impl::open(uint32_t cols, uint32_t rows, uint32_t pixel_depth,
                        void* hwnd, XColor color) {
+    std::lock_guard<std::mutex> lock(m_renderMutex);
+    
     if (m_opened) {
         return true;
     }
     
-#ifndef _WIN32
-    std::cerr << "[XShow] Only available on Windows" << std::endl;
+#ifndef HX_XSHOW_DISPLAY
+    (void)cols;
+    (void)rows;
+    (void)pixel_depth;
+    (void)hwnd;
+    (void)color;
+    std::cerr << "[XShow] Only available on Windows and X11 builds" << std::endl;
     return false;
 #else
     
@@ -89,9 +480,16 @@ bool XShow::Impl::open(uint32_t cols, uint32_t rows, uint32_t pixel_depth,
     m_pixelDepth = pixel_depth;
     m_windowHandle = hwnd;
     m_colorMode = color;
+    m_waterfallHead = 0;
+    m_materialTableValid = false;
     
+    // Built now rather than on the first Show()
+    buildLut();
+    
+#ifdef _WIN32
     // Allocate display buffer (24-bit RGB)
-    uint32_t bufferSize = m_width * m_height * 3;
+    m_displayStride = (static_cast<size_t>(m_width) * 3 + 3) & ~static_cast<size_t>(3);
+    size_t bufferSize = m_displayStride * m_height;
     m_displayBuffer = new uint8_t[bufferSize];
     memset(m_displayBuffer, 0, bufferSize);
     
@@ -103,9 +501,23 @@ bool XShow::Impl::open(uint32_t cols, uint32_t rows, uint32_t pixel_depth,
     m_bitmapInfo.bmiHeader.biPlanes = 1;
     m_bitmapInfo.bmiHeader.biBitCount = 24;
     m_bitmapInfo.bmiHeader.biCompression = BI_RGB;
+#else
+    // Frames are converted straight into the (shared) X image
+    if (!m_x11.create(hwnd, m_width, m_height)) {
+        std::cerr << "[XShow] ERROR: X11 display unavailable" << std::endl;
+        return false;
+    }
+    m_displayBuffer = m_x11.buffer();
+    m_displayStride = m_x11.stride();
+    m_displayPixelBytes = 4;
+#endif
     
     m_opened = true;
     
+    if (m_backend == XBACKEND_OPENGL && !selectBackend(XBACKEND_OPENGL)) {
+        std::cerr << "[XShow] WARNING: OpenGL unavailable, using GDI" << std::endl;
+    }
+    
     std::cout << "[XShow] Opened: " << m_width << "x" << m_height << std::endl;
     
     return true;
@@ -117,16 +529,22 @@ bool XShow::Impl::open(XDetector& det, uint32_t rows, void* hwnd, XColor color)
 }
 
 void XShow::Impl::close() {
+    std::lock_guard<std::mutex> lock(m_renderMutex);
+    
     if (!m_opened) {
         return;
     }
     
+    m_gl.destroy();
+    
 #ifdef _WIN32
-    if (m_displayBuffer) {
-        delete[] m_displayBuffer;
-        m_displayBuffer = nullptr;
-    }
+    delete[] m_displayBuffer;
+#else
+    m_x11.destroy();
 #endif
+    m_displayBuffer = nullptr;
+    m_shownRows = 0;
+    m_overlaysDrawn = false;
     
     m_opened = false;
     
@@ -134,108 +552,1125 @@ void XShow::Impl::close() {
 }
 
 void XShow::Impl::show(XImage* img_) {
-    if (!m_opened || !img_ || !img_->_data_) {
+    if (!img_ || !img_->_data_) {
+        return;
+    }
+    
+    // Preview is the first thing to go when the pipeline falls behind
+    if (Internal::OverloadShed(XFactory::OVERLOAD_PREVIEW)) {
+        return;
+    }
+    
+    if (m_renderThread.joinable()) {
+        submit(img_, nullptr);
+        return;
+    }
+    
+    std::lock_guard<std::mutex> lock(m_renderMutex);
+    render(img_, nullptr);
+}
+
+void XShow::Impl::show(XImage* high, XImage* low) {
+    if (!high || !high->_data_ || !low || !low->_data_) {
+        return;
+    }
+    if (low->_width != high->_width || low->_height != high->_height ||
+        low->_pixel_depth != high->_pixel_depth) {
+        return;
+    }
+    
+    if (Internal::OverloadShed(XFactory::OVERLOAD_PREVIEW)) {
         return;
     }
     
+    if (m_renderThread.joinable()) {
+        submit(high, low);
+        return;
+    }
+    
+    std::lock_guard<std::mutex> lock(m_renderMutex);
+    render(high, low);
+}
+
+void XShow::Impl::submit(const XImage* img_, const XImage* low) {
+    std::lock_guard<std::mutex> lock(m_submitMutex);
+    
+    // Copy now: the caller's frame buffer is reused after OnFrameReady
+    Pending* copy = m_writeImage;
+    if (!copyFrame(copy->image, *img_) || (low && !copyFrame(copy->low, *low))) {
+        return;
+    }
+    copy->pair = (low != nullptr);
+    
+    {
+        std::lock_guard<std::mutex> mailboxLock(m_mailboxMutex);
+        if (m_fresh) {
+            // The previous frame was never shown
+            ++m_droppedFrames;
+        }
+        std::swap(m_writeImage, m_readyImage);
+        m_fresh = true;
+    }
+    m_mailboxCv.notify_one();
+}
+
+void XShow::Impl::renderThread(uint32_t maxFps) {
+    uint32_t fps = maxFps;
 #ifdef _WIN32
+    if (fps == 0) {
+        // Values 0 and 1 mean the hardware default
+        HDC hdc = GetDC(nullptr);
+        if (hdc) {
+            const int refresh = GetDeviceCaps(hdc, VREFRESH);
+            fps = (refresh > 1) ? static_cast<uint32_t>(refresh) : 0;
+            ReleaseDC(nullptr, hdc);
+        }
+    }
+#endif
+    if (fps == 0) {
+        fps = 60;
+    }
+    const std::chrono::microseconds interval(1000000 / fps);
+    std::chrono::steady_clock::time_point next = std::chrono::steady_clock::now();
+    
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(m_mailboxMutex);
+            m_mailboxCv.wait(lock, [this] { return m_fresh || m_renderStop; });
+            if (m_renderStop) {
+                break;
+            }
+            std::swap(m_readyImage, m_renderImage);
+            m_fresh = false;
+        }
+        
+        {
+            std::lock_guard<std::mutex> lock(m_renderMutex);
+            render(&m_renderImage->image, m_renderImage->pair ? &m_renderImage->low : nullptr);
+        }
+        
+        // At most one frame per interval; frames arriving meanwhile replace each other
+        next += interval;
+        const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        if (next < now) {
+            next = now;
+        }
+        std::this_thread::sleep_until(next);
+    }
+}
+
+void XShow::Impl::stopRenderThread() {
+    if (!m_renderThread.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mailboxMutex);
+        m_renderStop = true;
+    }
+    m_mailboxCv.notify_one();
+    m_renderThread.join();
+    m_renderStop = false;
+    m_fresh = false;
+}
+
+bool XShow::Impl::setAsync(bool enable, uint32_t maxFps) {
+    // A new rate restarts the thread
+    stopRenderThread();
+    if (enable) {
+        m_renderThread = std::thread(&Impl::renderThread, this, maxFps);
+    }
+    return true;
+}
+
+void XShow::Impl::render(const XImage* img_, const XImage* low) {
+    if (!m_opened || !img_ || !img_->_data_) {
+        return;
+    }
+    
+#ifdef HX_XSHOW_DISPLAY
     if (!m_displayBuffer || !m_windowHandle) {
         return;
     }
     
+    const uint32_t cols = std::min(m_width, img_->_width);
+    const uint32_t rows = std::min(m_height, img_->_height);
+    
+    // Equalized levels replace the window; kept while the frame is the same
+    const uint8_t* frameLevels = m_claheEnabled ? m_clahe.levels(*img_) : nullptr;
+    
+    // The shader windows, colors and scales; GDI takes what it cannot,
+    // and pairs and equalized frames, whose lookups it does not do
+    if (!low && !frameLevels && m_gl.isValid() && presentGl(img_, 0, rows, 0, 0)) {
+        m_waterfallHead = 0;
+        m_shownRows = 0;
+        return;
+    }
+    
+    // Shrink by a whole factor until the frame fits the client area
+    uint32_t factor = 1;
+    uint32_t clientWidth = 0;
+    uint32_t clientHeight = 0;
+    if (clientSize(clientWidth, clientHeight) && clientWidth > 0 && clientHeight > 0) {
+        const uint32_t fx = (cols + clientWidth - 1) / clientWidth;
+        const uint32_t fy = (rows + clientHeight - 1) / clientHeight;
+        factor = std::max(1u, std::max(fx, fy));
+    }
+    
     // Convert image data to display buffer
-    applyColorMap(m_displayBuffer, img_->_data_, m_width * m_height);
+    uint32_t outWidth = m_width;
+    uint32_t outHeight = m_height;
+    size_t stride = m_displayStride;
+    if (factor > 1) {
+        outWidth = (cols + factor - 1) / factor;
+        outHeight = (rows + factor - 1) / factor;
+#ifdef _WIN32
+        // DIB rows are DWORD aligned; the X image keeps its pitch
+        stride = (static_cast<size_t>(outWidth) * 3 + 3) & ~static_cast<size_t>(3);
+#endif
+    }
+    eraseOverlays();
+    if (low) {
+        applyMaterialMap(m_displayBuffer, img_, low, factor, stride, frameLevels);
+    } else {
+        applyColorMap(m_displayBuffer, img_, factor, stride, 0, 0, frameLevels);
+    }
+    
+    // A full frame replaces the waterfall
+    m_waterfallHead = 0;
+    
+    compose(outWidth, outHeight, stride, 0, factor);
+    present(outWidth, outHeight, stride, 0);
+#else
+    (void)low;
+#endif
+}
+
+void XShow::Impl::showLines(const XImage* strip, uint32_t count) {
+    if (Internal::OverloadShed(XFactory::OVERLOAD_PREVIEW)) {
+        return;
+    }
+    
+    std::lock_guard<std::mutex> lock(m_renderMutex);
+    
+    if (!m_opened || !strip || !strip->_data_ || m_height == 0) {
+        return;
+    }
+    
+#ifdef HX_XSHOW_DISPLAY
+    if (!m_displayBuffer || !m_windowHandle) {
+        return;
+    }
+    
+    // Only the newest m_height lines can be on screen
+    count = std::min(count, strip->_height);
+    const uint32_t skip = (count > m_height) ? count - m_height : 0;
+    if (count == skip) {
+        return;
+    }
     
-    // Display using Windows GDI
+    if (m_gl.isValid()) {
+        const uint32_t head = (m_waterfallHead + count - skip) % m_height;
+        if (presentGl(strip, skip, count - skip, m_waterfallHead, head)) {
+            m_waterfallHead = head;
+            m_shownRows = 0;
+            return;
+        }
+    }
+    
+    // Markers stay put on screen while the lines scroll under them
+    eraseOverlays();
+    
+    // Convert just the new lines into the ring
+    applyColorMap(m_displayBuffer, strip, 1, m_displayStride, skip, m_waterfallHead);
+    m_waterfallHead = (m_waterfallHead + count - skip) % m_height;
+    
+    // Oldest rows (head..end) on top, newest (0..head) below
+    compose(m_width, m_height, m_displayStride, m_waterfallHead, 1);
+    present(m_width, m_height, m_displayStride, m_waterfallHead);
+#else
+    (void)count;
+#endif
+}
+
+bool XShow::Impl::clientSize(uint32_t& width, uint32_t& height) {
+#if defined(_WIN32)
+    RECT client;
+    if (!GetClientRect(static_cast<HWND>(m_windowHandle), &client)) {
+        return false;
+    }
+    width = (client.right > 0) ? static_cast<uint32_t>(client.right) : 0;
+    height = (client.bottom > 0) ? static_cast<uint32_t>(client.bottom) : 0;
+    return true;
+#else
+    return m_x11.windowSize(width, height);
+#endif
+}
+
+void XShow::Impl::present(uint32_t width, uint32_t rows, size_t stride, uint32_t split) {
+    // Display rows split..rows go on top, rows 0..split below them
+    const uint32_t older = rows - split;
+#if defined(_WIN32)
     HDC hdc = GetDC(static_cast<HWND>(m_windowHandle));
-    if (hdc) {
-        SetDIBitsToDevice(
-            hdc,
-            0, 0, m_width, m_height,
-            0, 0, 0, m_height,
-            m_displayBuffer,
-            &m_bitmapInfo,
-            DIB_RGB_COLORS
-        );
-        ReleaseDC(static_cast<HWND>(m_windowHandle), hdc);
+    if (!hdc) {
+        return;
+    }
+    blit(hdc, m_displayBuffer + split * stride, width, 0, width, older, 0);
+    if (split > 0) {
+        blit(hdc, m_displayBuffer, width, 0, width, split, static_cast<int>(older));
+    }
+    ReleaseDC(static_cast<HWND>(m_windowHandle), hdc);
+#else
+    // Rows are addressed in the X image, whose pitch is fixed
+    (void)stride;
+    m_x11.put(0, split, width, older, 0);
+    if (split > 0) {
+        m_x11.put(0, 0, width, split, older);
     }
+    m_x11.flush();
 #endif
 }
 
-void XShow::Impl::applyColorMap(uint8_t* displayBuffer, const uint8_t* imageData,
-                                uint32_t pixelCount) {
-    uint32_t bytesPerPixel = (m_pixelDepth + 7) / 8;
+#ifdef _WIN32
+void XShow::Impl::blit(HDC hdc, const uint8_t* bits, uint32_t width, uint32_t x, uint32_t columns,
+                       uint32_t rows, int y) {
+    // Each blit describes its rows as a DIB of their own
+    BITMAPINFO info = m_bitmapInfo;
+    info.bmiHeader.biWidth = width;
+    info.bmiHeader.biHeight = -static_cast<int32_t>(rows); // Top-down
     
-    for (uint32_t i = 0; i < pixelCount; ++i) {
-        // Extract pixel value
-        uint32_t pixelValue = 0;
-        for (uint32_t j = 0; j < bytesPerPixel && j < 4; ++j) {
-            pixelValue |= (imageData[i * bytesPerPixel + j] << (j * 8));
+    SetDIBitsToDevice(
+        hdc,
+        x, y, columns, rows,
+        x, 0, 0, rows,
+        bits,
+        &info,
+        DIB_RGB_COLORS
+    );
+}
+#endif
+
+void XShow::Impl::presentRect(const OverlayRect& rect) {
+    // Screen rows map to ring rows from m_shownSplit; a band may wrap once
+    const uint32_t x = static_cast<uint32_t>(rect.x0);
+    const uint32_t columns = static_cast<uint32_t>(rect.x1 - rect.x0);
+    uint32_t y = static_cast<uint32_t>(rect.y0);
+    uint32_t remaining = static_cast<uint32_t>(rect.y1 - rect.y0);
+#if defined(_WIN32)
+    HDC hdc = GetDC(static_cast<HWND>(m_windowHandle));
+    if (!hdc) {
+        return;
+    }
+#endif
+    while (remaining > 0) {
+        const uint32_t row = (m_shownSplit + y) % m_shownRows;
+        const uint32_t rows = std::min(remaining, m_shownRows - row);
+#if defined(_WIN32)
+        blit(hdc, m_displayBuffer + row * m_shownStride, m_shownWidth, x, columns, rows,
+             static_cast<int>(y));
+#else
+        m_x11.put(x, row, columns, rows, y);
+#endif
+        y += rows;
+        remaining -= rows;
+    }
+#if defined(_WIN32)
+    ReleaseDC(static_cast<HWND>(m_windowHandle), hdc);
+#else
+    m_x11.flush();
+#endif
+}
+
+void XShow::Impl::compose(uint32_t width, uint32_t rows, size_t stride, uint32_t split,
+                          uint32_t factor) {
+    m_shownWidth = width;
+    m_shownRows = rows;
+    m_shownStride = stride;
+    m_shownSplit = split;
+    m_shownFactor = factor;
+    
+    m_overlaysDrawn = false;
+    if (m_overlays.empty()) {
+        return;
+    }
+    const size_t bytes = static_cast<size_t>(rows) * stride;
+    m_cleanBuffer.resize(bytes);
+    memcpy(m_cleanBuffer.data(), m_displayBuffer, bytes);
+    m_overlaysDrawn = true;
+    
+    const OverlayRect all = { 0, 0, static_cast<int32_t>(width), static_cast<int32_t>(rows) };
+    for (size_t i = 0; i < m_overlays.size(); ++i) {
+        drawOverlay(m_overlays[i], all);
+    }
+}
+
+void XShow::Impl::eraseOverlays() {
+    if (!m_overlaysDrawn) {
+        return;
+    }
+    for (size_t i = 0; i < m_overlays.size(); ++i) {
+        restoreRect(overlayBounds(m_overlays[i]));
+    }
+    m_overlaysDrawn = false;
+}
+
+void XShow::Impl::refreshOverlays(const OverlayRect& rect) {
+    if (m_shownRows == 0 || !m_displayBuffer) {
+        return;
+    }
+    if (!m_overlaysDrawn) {
+        // No marker on screen yet: the buffer itself is clean
+        const size_t bytes = static_cast<size_t>(m_shownRows) * m_shownStride;
+        m_cleanBuffer.resize(bytes);
+        memcpy(m_cleanBuffer.data(), m_displayBuffer, bytes);
+        m_overlaysDrawn = true;
+    }
+    
+    const OverlayRect shown = { 0, 0, static_cast<int32_t>(m_shownWidth),
+                                static_cast<int32_t>(m_shownRows) };
+    OverlayRect clip = { std::max(rect.x0, shown.x0), std::max(rect.y0, shown.y0),
+                         std::min(rect.x1, shown.x1), std::min(rect.y1, shown.y1) };
+    if (clip.empty()) {
+        return;
+    }
+    restoreRect(clip);
+    for (size_t i = 0; i < m_overlays.size(); ++i) {
+        drawOverlay(m_overlays[i], clip);
+    }
+    presentRect(clip);
+}
+
+void XShow::Impl::restoreRect(const OverlayRect& rect) {
+    const int32_t x0 = std::max(rect.x0, 0);
+    const int32_t x1 = std::min(rect.x1, static_cast<int32_t>(m_shownWidth));
+    const int32_t y0 = std::max(rect.y0, 0);
+    const int32_t y1 = std::min(rect.y1, static_cast<int32_t>(m_shownRows));
+    if (x0 >= x1 || y0 >= y1 || m_cleanBuffer.empty()) {
+        return;
+    }
+    const size_t bytes = static_cast<size_t>(x1 - x0) * m_displayPixelBytes;
+    for (int32_t y = y0; y < y1; ++y) {
+        const size_t offset = static_cast<size_t>(shownPixel(m_displayBuffer, x0, y) - m_displayBuffer);
+        memcpy(m_displayBuffer + offset, m_cleanBuffer.data() + offset, bytes);
+    }
+}
+
+uint8_t* XShow::Impl::shownPixel(uint8_t* buffer, int32_t x, int32_t y) const {
+    const uint32_t row = (m_shownSplit + static_cast<uint32_t>(y)) % m_shownRows;
+    return buffer + row * m_shownStride + static_cast<size_t>(x) * m_displayPixelBytes;
+}
+
+OverlayRect XShow::Impl::overlayBounds(const Overlay& overlay) const {
+    // Image pixels to screen pixels of the last frame, one pixel wide outline
+    const int32_t f = static_cast<int32_t>(m_shownFactor);
+    OverlayRect r = { std::min(overlay.x0, overlay.x1) / f, std::min(overlay.y0, overlay.y1) / f,
+                      std::max(overlay.x0, overlay.x1) / f + 1, std::max(overlay.y0, overlay.y1) / f + 1 };
+    return r;
+}
+
+void XShow::Impl::drawOverlay(const Overlay& overlay, const OverlayRect& clip) {
+    const int32_t f = static_cast<int32_t>(m_shownFactor);
+    const int32_t x0 = overlay.x0 / f;
+    const int32_t y0 = overlay.y0 / f;
+    const int32_t x1 = overlay.x1 / f;
+    const int32_t y1 = overlay.y1 / f;
+    
+    // Plot one pixel if it is inside the clip and the buffer
+    const int32_t cx0 = std::max(clip.x0, 0);
+    const int32_t cy0 = std::max(clip.y0, 0);
+    const int32_t cx1 = std::min(clip.x1, static_cast<int32_t>(m_shownWidth));
+    const int32_t cy1 = std::min(clip.y1, static_cast<int32_t>(m_shownRows));
+    auto plot = [&](int32_t x, int32_t y) {
+        if (x >= cx0 && x < cx1 && y >= cy0 && y < cy1) {
+            uint8_t* pixel = shownPixel(m_displayBuffer, x, y);
+            pixel[0] = overlay.bgr[0];
+            pixel[1] = overlay.bgr[1];
+            pixel[2] = overlay.bgr[2];
         }
-        
-        // Normalize to 8-bit
-        uint8_t normalized = static_cast<uint8_t>(
-            (pixelValue * 255) / ((1 << m_pixelDepth) - 1)
-        );
-        
-        // Apply gamma correction
-        normalized = applyGamma(normalized);
-        
-        // Apply color map
-        uint8_t r, g, b;
-        
-        switch (m_colorMode) {
-            case XCOLOR_GRAY:
-                r = g = b = normalized;
-                break;
+    };
+    
+    if (overlay.type == XOVERLAY_RECT) {
+        const int32_t left = std::min(x0, x1);
+        const int32_t right = std::max(x0, x1);
+        const int32_t top = std::min(y0, y1);
+        const int32_t bottom = std::max(y0, y1);
+        for (int32_t x = std::max(left, cx0); x <= std::min(right, cx1 - 1); ++x) {
+            plot(x, top);
+            plot(x, bottom);
+        }
+        for (int32_t y = std::max(top, cy0); y <= std::min(bottom, cy1 - 1); ++y) {
+            plot(left, y);
+            plot(right, y);
+        }
+        return;
+    }
+    
+    // Bresenham line
+    const int32_t dx = std::abs(x1 - x0);
+    const int32_t dy = -std::abs(y1 - y0);
+    const int32_t sx = (x0 < x1) ? 1 : -1;
+    const int32_t sy = (y0 < y1) ? 1 : -1;
+    int32_t err = dx + dy;
+    int32_t x = x0;
+    int32_t y = y0;
+    for (;;) {
+        plot(x, y);
+        if (x == x1 && y == y1) {
+            break;
+        }
+        const int32_t e2 = 2 * err;
+        if (e2 >= dy) {
+            err += dy;
+            x += sx;
+        }
+        if (e2 <= dx) {
+            err += dx;
+            y += sy;
+        }
+    }
+}
+
+uint32_t XShow::Impl::addOverlay(XOverlay type, int32_t x0, int32_t y0, int32_t x1, int32_t y1,
+                                 uint32_t rgb) {
+    if (type != XOVERLAY_RECT && type != XOVERLAY_LINE) {
+        return 0;
+    }
+    std::lock_guard<std::mutex> lock(m_renderMutex);
+    Overlay overlay;
+    overlay.id = m_nextOverlayId++;
+    overlay.type = type;
+    overlay.x0 = x0;
+    overlay.y0 = y0;
+    overlay.x1 = x1;
+    overlay.y1 = y1;
+    overlay.bgr[0] = static_cast<uint8_t>(rgb);
+    overlay.bgr[1] = static_cast<uint8_t>(rgb >> 8);
+    overlay.bgr[2] = static_cast<uint8_t>(rgb >> 16);
+    m_overlays.push_back(overlay);
+    refreshOverlays(overlayBounds(overlay));
+    return overlay.id;
+}
+
+bool XShow::Impl::moveOverlay(uint32_t id, int32_t x0, int32_t y0, int32_t x1, int32_t y1) {
+    std::lock_guard<std::mutex> lock(m_renderMutex);
+    for (size_t i = 0; i < m_overlays.size(); ++i) {
+        Overlay& overlay = m_overlays[i];
+        if (overlay.id != id) {
+            continue;
+        }
+        const OverlayRect before = overlayBounds(overlay);
+        overlay.x0 = x0;
+        overlay.y0 = y0;
+        overlay.x1 = x1;
+        overlay.y1 = y1;
+        refreshOverlays(unite(before, overlayBounds(overlay)));
+        return true;
+    }
+    return false;
+}
+
+bool XShow::Impl::removeOverlay(uint32_t id) {
+    std::lock_guard<std::mutex> lock(m_renderMutex);
+    for (size_t i = 0; i < m_overlays.size(); ++i) {
+        if (m_overlays[i].id != id) {
+            continue;
+        }
+        const OverlayRect before = overlayBounds(m_overlays[i]);
+        m_overlays.erase(m_overlays.begin() + static_cast<std::ptrdiff_t>(i));
+        refreshOverlays(before);
+        return true;
+    }
+    return false;
+}
+
+void XShow::Impl::clearOverlays() {
+    std::lock_guard<std::mutex> lock(m_renderMutex);
+    OverlayRect all = { 0, 0, 0, 0 };
+    for (size_t i = 0; i < m_overlays.size(); ++i) {
+        all = unite(all, overlayBounds(m_overlays[i]));
+    }
+    m_overlays.clear();
+    refreshOverlays(all);
+}
+
+bool XShow::Impl::presentGl(const XImage* image, uint32_t firstRow, uint32_t rows,
+                            uint32_t texRow, uint32_t topRow) {
+    const uint32_t bytes = (m_pixelDepth + 7) / 8;
+    if ((bytes != 1 && bytes != 2) || !m_gl.begin()) {
+        return false;
+    }
+    prepare(image);
+    if (!m_glLutValid) {
+        m_gl.setLut(m_lut.data());
+        m_glLutValid = true;
+    }
+    
+    // Rows past the end of the ring wrap to its start
+    const uint32_t cols = std::min(m_width, image->_width);
+    const size_t stride = image->_stride;
+    const uint8_t* data = image->_data_ + image->_data_offset + static_cast<size_t>(firstRow) * stride;
+    const uint32_t first = std::min(rows, m_height - texRow);
+    bool ok = m_gl.upload(data, stride, cols, first, bytes, m_height, texRow);
+    if (ok && rows > first) {
+        ok = m_gl.upload(data + static_cast<size_t>(first) * stride, stride, cols, rows - first,
+                         bytes, m_height, 0);
+    }
+    if (ok) {
+        // Texture values are normalized to the container range
+        const WindowParams w = windowParams();
+        const float full = (bytes == 2) ? 65535.0f : 255.0f;
+        m_gl.draw(w.low / full, w.range / full, topRow);
+    }
+    m_gl.end();
+    return ok;
+}
+
+void XShow::Impl::prepare(const XImage* image) {
+    if (!m_lutValid) {
+        buildLut();
+    }
+    
+    // Select the container width once per frame, not once per pixel
+    if (m_autoWindow) {
+        AutoWindowKernel windowKernel;
+        windowKernel.self = this;
+        windowKernel.image = image;
+        XDispatchPixelBytes(m_pixelDepth, windowKernel);
+    }
+}
+
+void XShow::Impl::applyColorMap(uint8_t* displayBuffer, const XImage* image,
+                                uint32_t factor, size_t stride,
+                                uint32_t firstRow, uint32_t outRow,
+                                const uint8_t* frameLevels) {
+    prepare(image);
+    
+    ColorMapKernel kernel;
+    kernel.self = this;
+    kernel.displayBuffer = displayBuffer;
+    kernel.image = image;
+    kernel.factor = factor;
+    kernel.stride = stride;
+    kernel.firstRow = firstRow;
+    kernel.outRow = outRow;
+    kernel.frameLevels = frameLevels;
+    XDispatchPixelBytes(m_pixelDepth, kernel);
+}
+
+template <uint32_t Bytes>
+void XShow::Impl::applyColorMapRows(uint8_t* displayBuffer, const XImage* image, size_t stride,
+                                    uint32_t firstRow, uint32_t outRow,
+                                    const uint8_t* frameLevels) {
+    // Image rows firstRow.. go to display rows outRow.., wrapping at m_height
+    if (firstRow >= image->_height) {
+        return;
+    }
+    const uint32_t rows = std::min(m_height, image->_height - firstRow);
+    const uint32_t cols = std::min(m_width, image->_width);
+    const uint8_t* lut = m_lut.data();
+    const WindowParams window = windowParams();
+    const WindowKernel windowKernel = m_windowKernel;
+    const uint32_t pixelBytes = m_displayPixelBytes;
+    StatsPass stats;
+    beginStatistics(stats, cols);
+    
+    Internal::ThreadPool::instance().parallelRows(
+        static_cast<int>(rows), static_cast<int>(cols),
+        [&](int bandRow, int endRow) {
+            std::vector<uint8_t> levels(cols);
+            StatsBand* band[2] = { nullptr, nullptr };
+            for (int row = bandRow; row < endRow; ++row) {
+                XPixelRow<Bytes> pixels = image->Row<Bytes>(firstRow + static_cast<uint32_t>(row));
+                accumulateRow(stats, band, pixels, firstRow + static_cast<uint32_t>(row), cols);
+                uint8_t* out = displayBuffer +
+                    static_cast<size_t>((outRow + static_cast<uint32_t>(row)) % m_height) * stride;
                 
-            case XCOLOR_HOT:
-                // Hot color map (black -> red -> yellow -> white)
-                if (normalized < 85) {
-                    r = normalized * 3;
-                    g = 0;
-                    b = 0;
-                } else if (normalized < 170) {
-                    r = 255;
-                    g = (normalized - 85) * 3;
-                    b = 0;
+                // Window to 8-bit levels, vectorized for 16-bit containers
+                const uint8_t* rowLevels = levels.data();
+                if (frameLevels) {
+                    rowLevels = frameLevels +
+                        static_cast<size_t>(firstRow + static_cast<uint32_t>(row)) * image->_width;
+                } else if (Bytes == 2) {
+                    windowKernel(pixels.Data(), levels.data(), cols, window);
                 } else {
-                    r = 255;
-                    g = 255;
-                    b = (normalized - 170) * 3;
+                    for (uint32_t col = 0; col < cols; ++col) {
+                        levels[col] = windowLevel(pixels.Get(col), window);
+                    }
                 }
-                break;
                 
-            case XCOLOR_JET:
-                // Jet color map (blue -> cyan -> yellow -> red)
-                if (normalized < 64) {
-                    r = 0;
-                    g = 0;
-                    b = 128 + normalized * 2;
-                } else if (normalized < 128) {
-                    r = 0;
-                    g = (normalized - 64) * 4;
-                    b = 255;
-                } else if (normalized < 192) {
-                    r = (normalized - 128) * 4;
-                    g = 255;
-                    b = 255 - (normalized - 128) * 4;
+                // Stored in BGR order; X11 pixels carry a fourth byte left as is
+                for (uint32_t col = 0; col < cols; ++col) {
+                    const uint8_t* bgr = lut + static_cast<size_t>(rowLevels[col]) * 3;
+                    uint8_t* pixel = out + col * pixelBytes;
+                    pixel[0] = bgr[0];
+                    pixel[1] = bgr[1];
+                    pixel[2] = bgr[2];
+                }
+            }
+            mergeStatistics(stats, band);
+        });
+    endStatistics(stats);
+}
+
+template <uint32_t Bytes>
+void XShow::Impl::applyColorMapDecimated(uint8_t* displayBuffer, const XImage* image,
+                                         uint32_t factor, size_t stride,
+                                         const uint8_t* frameLevels) {
+    const uint32_t rows = std::min(m_height, image->_height);
+    const uint32_t cols = std::min(m_width, image->_width);
+    const uint32_t outRows = (rows + factor - 1) / factor;
+    const uint32_t outCols = (cols + factor - 1) / factor;
+    const uint8_t* lut = m_lut.data();
+    const WindowParams window = windowParams();
+    const WindowKernel windowKernel = m_windowKernel;
+    const uint32_t pixelBytes = m_displayPixelBytes;
+    StatsPass stats;
+    beginStatistics(stats, cols);
+    
+    Internal::ThreadPool::instance().parallelRows(
+        static_cast<int>(outRows), static_cast<int>(cols) * static_cast<int>(factor),
+        [&](int firstRow, int endRow) {
+            std::vector<uint8_t> levels(cols);
+            StatsBand* band[2] = { nullptr, nullptr };
+            std::vector<uint8_t> blockMin(outCols);
+            std::vector<uint8_t> blockMax(outCols);
+            std::vector<uint32_t> blockSum(outCols);
+            for (int outRow = firstRow; outRow < endRow; ++outRow) {
+                std::fill(blockMin.begin(), blockMin.end(), 255);
+                std::fill(blockMax.begin(), blockMax.end(), 0);
+                std::fill(blockSum.begin(), blockSum.end(), 0);
+                
+                const uint32_t row0 = static_cast<uint32_t>(outRow) * factor;
+                const uint32_t row1 = std::min(row0 + factor, rows);
+                for (uint32_t row = row0; row < row1; ++row) {
+                    XPixelRow<Bytes> pixels = image->Row<Bytes>(row);
+                    accumulateRow(stats, band, pixels, row, cols);
+                    const uint8_t* rowLevels = levels.data();
+                    if (frameLevels) {
+                        rowLevels = frameLevels + static_cast<size_t>(row) * image->_width;
+                    } else if (Bytes == 2) {
+                        windowKernel(pixels.Data(), levels.data(), cols, window);
+                    } else {
+                        for (uint32_t col = 0; col < cols; ++col) {
+                            levels[col] = windowLevel(pixels.Get(col), window);
+                        }
+                    }
+                    for (uint32_t col = 0; col < cols; ++col) {
+                        const uint32_t block = col / factor;
+                        const uint8_t level = rowLevels[col];
+                        blockMin[block] = std::min(blockMin[block], level);
+                        blockMax[block] = std::max(blockMax[block], level);
+                        blockSum[block] += level;
+                    }
+                }
+                
+                // Show the block extreme farther from its mean, so a single
+                // dark or bright defect survives the reduction
+                uint8_t* out = displayBuffer + static_cast<size_t>(outRow) * stride;
+                const uint32_t blockRows = row1 - row0;
+                for (uint32_t block = 0; block < outCols; ++block) {
+                    const uint32_t count = blockRows * (std::min((block + 1) * factor, cols) - block * factor);
+                    const uint32_t sum = blockSum[block];
+                    const uint8_t level = (blockMax[block] * count - sum > sum - blockMin[block] * count)
+                                        ? blockMax[block] : blockMin[block];
+                    const uint8_t* bgr = lut + static_cast<size_t>(level) * 3;
+                    uint8_t* pixel = out + block * pixelBytes;
+                    pixel[0] = bgr[0];
+                    pixel[1] = bgr[1];
+                    pixel[2] = bgr[2];
+                }
+            }
+            mergeStatistics(stats, band);
+        });
+    endStatistics(stats);
+}
+
+void XShow::Impl::applyMaterialMap(uint8_t* displayBuffer, const XImage* high, const XImage* low,
+                                   uint32_t factor, size_t stride, const uint8_t* frameLevels) {
+    // The table covers up to 16 bits a value
+    if (m_pixelDepth > 16) {
+        applyColorMap(displayBuffer, high, factor, stride, 0, 0, frameLevels);
+        return;
+    }
+    prepare(high);
+    if (!m_materialTableValid) {
+        Internal::BuildMaterialTable(m_materialModel, static_cast<int>(m_pixelDepth), m_materialTable);
+        m_materialTableValid = true;
+    }
+    
+    MaterialMapKernel kernel;
+    kernel.self = this;
+    kernel.displayBuffer = displayBuffer;
+    kernel.high = high;
+    kernel.low = low;
+    kernel.factor = factor;
+    kernel.stride = stride;
+    kernel.frameLevels = frameLevels;
+    XDispatchPixelBytes(m_pixelDepth, kernel);
+}
+
+template <uint32_t Bytes>
+void XShow::Impl::applyMaterialMapRows(uint8_t* displayBuffer, const XImage* high, const XImage* low,
+                                       size_t stride, const uint8_t* frameLevels) {
+    const uint32_t rows = std::min(m_height, high->_height);
+    const uint32_t cols = std::min(m_width, high->_width);
+    const uint8_t* lut = m_materialLut.data();
+    const uint16_t* table = m_materialTable.data();
+    const uint32_t bits = static_cast<uint32_t>(Internal::MaterialTableBits(m_materialModel,
+                                                                            static_cast<int>(m_pixelDepth)));
+    const uint32_t shift = m_pixelDepth - bits;
+    const uint32_t limit = Internal::windowMaxValue(m_pixelDepth);
+    const WindowParams window = windowParams();
+    const WindowKernel windowKernel = m_windowKernel;
+    const uint32_t pixelBytes = m_displayPixelBytes;
+    StatsPass stats;
+    beginStatistics(stats, cols);
+    
+    Internal::ThreadPool::instance().parallelRows(
+        static_cast<int>(rows), static_cast<int>(cols) * 2,
+        [&](int firstRow, int endRow) {
+            std::vector<uint8_t> levels(cols);
+            StatsBand* band[2] = { nullptr, nullptr };
+            for (int row = firstRow; row < endRow; ++row) {
+                XPixelRow<Bytes> highPixels = high->Row<Bytes>(static_cast<uint32_t>(row));
+                XPixelRow<Bytes> lowPixels = low->Row<Bytes>(static_cast<uint32_t>(row));
+                accumulateRow(stats, band, highPixels, static_cast<uint32_t>(row), cols);
+                uint8_t* out = displayBuffer + static_cast<size_t>(row) * stride;
+                
+                // Brightness from the high image
+                const uint8_t* rowLevels = levels.data();
+                if (frameLevels) {
+                    rowLevels = frameLevels + static_cast<size_t>(row) * high->_width;
+                } else if (Bytes == 2) {
+                    windowKernel(highPixels.Data(), levels.data(), cols, window);
                 } else {
-                    r = 255;
-                    g = 255 - (normalized - 192) * 4;
-                    b = 0;
+                    for (uint32_t col = 0; col < cols; ++col) {
+                        levels[col] = windowLevel(highPixels.Get(col), window);
+                    }
                 }
-                break;
                 
-            default:
-                r = g = b = normalized;
-                break;
+                // Hue from the pair's cell; values above the depth fall in the top cell
+                for (uint32_t col = 0; col < cols; ++col) {
+                    const uint32_t h = std::min(highPixels.Get(col), limit) >> shift;
+                    const uint32_t l = std::min(lowPixels.Get(col), limit) >> shift;
+                    const uint32_t materialClass = table[(h << bits) | l] >> Internal::MATERIAL_CLASS_SHIFT;
+                    const uint8_t* bgr = lut + (static_cast<size_t>(materialClass) * 256 + rowLevels[col]) * 3;
+                    uint8_t* pixel = out + col * pixelBytes;
+                    pixel[0] = bgr[0];
+                    pixel[1] = bgr[1];
+                    pixel[2] = bgr[2];
+                }
+            }
+            mergeStatistics(stats, band);
+        });
+    endStatistics(stats);
+}
+
+template <uint32_t Bytes>
+void XShow::Impl::applyMaterialMapDecimated(uint8_t* displayBuffer, const XImage* high,
+                                            const XImage* low, uint32_t factor, size_t stride,
+                                            const uint8_t* frameLevels) {
+    const uint32_t rows = std::min(m_height, high->_height);
+    const uint32_t cols = std::min(m_width, high->_width);
+    const uint32_t outRows = (rows + factor - 1) / factor;
+    const uint32_t outCols = (cols + factor - 1) / factor;
+    const uint8_t* lut = m_materialLut.data();
+    const uint16_t* table = m_materialTable.data();
+    const uint32_t bits = static_cast<uint32_t>(Internal::MaterialTableBits(m_materialModel,
+                                                                            static_cast<int>(m_pixelDepth)));
+    const uint32_t shift = m_pixelDepth - bits;
+    const uint32_t limit = Internal::windowMaxValue(m_pixelDepth);
+    const WindowParams window = windowParams();
+    const uint32_t pixelBytes = m_displayPixelBytes;
+    StatsPass stats;
+    beginStatistics(stats, cols);
+    
+    Internal::ThreadPool::instance().parallelRows(
+        static_cast<int>(outRows), static_cast<int>(cols) * static_cast<int>(factor) * 2,
+        [&](int firstRow, int endRow) {
+            StatsBand* band[2] = { nullptr, nullptr };
+            std::vector<uint64_t> highSum(outCols);
+            std::vector<uint64_t> lowSum(outCols);
+            std::vector<uint32_t> levelSum(frameLevels ? outCols : 0);
+            for (int outRow = firstRow; outRow < endRow; ++outRow) {
+                std::fill(highSum.begin(), highSum.end(), 0);
+                std::fill(lowSum.begin(), lowSum.end(), 0);
+                std::fill(levelSum.begin(), levelSum.end(), 0);
+                
+                const uint32_t row0 = static_cast<uint32_t>(outRow) * factor;
+                const uint32_t row1 = std::min(row0 + factor, rows);
+                for (uint32_t row = row0; row < row1; ++row) {
+                    XPixelRow<Bytes> highPixels = high->Row<Bytes>(row);
+                    XPixelRow<Bytes> lowPixels = low->Row<Bytes>(row);
+                    accumulateRow(stats, band, highPixels, row, cols);
+                    for (uint32_t col = 0; col < cols; ++col) {
+                        highSum[col / factor] += std::min(highPixels.Get(col), limit);
+                        lowSum[col / factor] += std::min(lowPixels.Get(col), limit);
+                    }
+                    if (frameLevels) {
+                        const uint8_t* rowLevels = frameLevels + static_cast<size_t>(row) * high->_width;
+                        for (uint32_t col = 0; col < cols; ++col) {
+                            levelSum[col / factor] += rowLevels[col];
+                        }
+                    }
+                }
+                
+                // A block shows the material of its mean pair: unlike a
+                // level, a class has no extreme to keep
+                uint8_t* out = displayBuffer + static_cast<size_t>(outRow) * stride;
+                const uint32_t blockRows = row1 - row0;
+                for (uint32_t block = 0; block < outCols; ++block) {
+                    const uint32_t count = blockRows * (std::min((block + 1) * factor, cols) - block * factor);
+                    const uint32_t h = static_cast<uint32_t>(highSum[block] / count);
+                    const uint32_t l = static_cast<uint32_t>(lowSum[block] / count);
+                    const uint32_t materialClass =
+                        table[((h >> shift) << bits) | (l >> shift)] >> Internal::MATERIAL_CLASS_SHIFT;
+                    const uint32_t level = frameLevels ? levelSum[block] / count : windowLevel(h, window);
+                    const uint8_t* bgr = lut + (static_cast<size_t>(materialClass) * 256 + level) * 3;
+                    uint8_t* pixel = out + block * pixelBytes;
+                    pixel[0] = bgr[0];
+                    pixel[1] = bgr[1];
+                    pixel[2] = bgr[2];
+                }
+            }
+            mergeStatistics(stats, band);
+        });
+    endStatistics(stats);
+}
+
+void XShow::Impl::beginStatistics(StatsPass& pass, uint32_t cols) {
+    pass.enabled = m_statsEnabled;
+    if (!pass.enabled) {
+        return;
+    }
+    pass.shift = (m_pixelDepth > STATS_BITS) ? m_pixelDepth - STATS_BITS : 0;
+    pass.bins = 1u << (std::min(m_pixelDepth, 32u) - pass.shift);
+    pass.roiX0 = std::min(m_roiX, cols);
+    pass.roiX1 = std::min(m_roiX + m_roiWidth, cols);
+    pass.roiY0 = m_roiY;
+    pass.roiY1 = m_roiY + m_roiHeight;
+    pass.total.reset(new StatsBand(pass.bins));
+    if (pass.roiX0 < pass.roiX1 && pass.roiY0 < pass.roiY1) {
+        pass.roi.reset(new StatsBand(pass.bins));
+    }
+}
+
+template <uint32_t Bytes>
+void XShow::Impl::accumulateRow(StatsPass& pass, StatsBand* band[2], const XPixelRow<Bytes>& pixels,
+                                uint32_t row, uint32_t cols) {
+    // The row was just read for conversion, so this does not touch memory again
+    if (!pass.enabled) {
+        return;
+    }
+    if (!band[0]) {
+        band[0] = new StatsBand(pass.bins);
+    }
+    band[0]->add(pixels, 0, cols, pass.shift);
+    if (pass.roi && row >= pass.roiY0 && row < pass.roiY1) {
+        if (!band[1]) {
+            band[1] = new StatsBand(pass.bins);
         }
-        
-        // Store RGB values (BGR format for Windows)
-        displayBuffer[i * 3 + 0] = b;
-        displayBuffer[i * 3 + 1] = g;
-        displayBuffer[i * 3 + 2] = r;
+        band[1]->add(pixels, pass.roiX0, pass.roiX1, pass.shift);
+    }
+}
+
+void XShow::Impl::mergeStatistics(StatsPass& pass, StatsBand* band[2]) {
+    if (!band[0]) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(pass.mutex);
+        pass.total->merge(*band[0]);
+        if (band[1]) {
+            pass.roi->merge(*band[1]);
+        }
+    }
+    delete band[0];
+    delete band[1];
+}
+
+namespace {
+
+void summarize(const StatsBand& band, uint32_t shift, uint64_t frame, XShow::XStatistics& stats) {
+    // Bins are exact values up to 16 bits, else their centers stand in
+    const double half = shift ? static_cast<double>(1u << (shift - 1)) : 0.0;
+    uint64_t count = 0;
+    double sum = 0.0;
+    double sumSquares = 0.0;
+    uint32_t first = 0xFFFFFFFFu;
+    uint32_t last = 0;
+    for (size_t b = 0; b < band.histogram.size(); ++b) {
+        const uint32_t n = band.histogram[b];
+        if (n == 0) {
+            continue;
+        }
+        const double value = static_cast<double>(static_cast<uint64_t>(b) << shift) + half;
+        count += n;
+        sum += value * n;
+        sumSquares += value * value * n;
+        first = std::min(first, static_cast<uint32_t>(b));
+        last = static_cast<uint32_t>(b);
+    }
+    
+    memset(&stats, 0, sizeof(stats));
+    stats.frame = frame;
+    stats.pixels = count;
+    stats.binShift = shift;
+    if (count == 0) {
+        return;
+    }
+    if (shift) {
+        stats.min = band.min;
+        stats.max = band.max;
+        stats.mean = static_cast<double>(band.sum) / count;
+    } else {
+        stats.min = first;
+        stats.max = last;
+        stats.mean = sum / count;
+    }
+    const double variance = sumSquares / count - (sum / count) * (sum / count);
+    stats.stddev = std::sqrt(std::max(0.0, variance));
+}
+
+} // namespace
+
+void XShow::Impl::endStatistics(StatsPass& pass) {
+    if (!pass.enabled) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(m_statsMutex);
+    const uint64_t frame = m_stats.frame + 1;
+    summarize(*pass.total, pass.shift, frame, m_stats);
+    m_histogram.swap(pass.total->histogram);
+    if (pass.roi) {
+        summarize(*pass.roi, pass.shift, frame, m_roiStats);
+        m_roiHistogram.swap(pass.roi->histogram);
+    } else {
+        memset(&m_roiStats, 0, sizeof(m_roiStats));
+        m_roiStats.frame = frame;
+        m_roiHistogram.clear();
+    }
+}
+
+void XShow::Impl::setStatistics(bool enable) {
+    std::lock_guard<std::mutex> lock(m_renderMutex);
+    m_statsEnabled = enable;
+}
+
+bool XShow::Impl::setStatisticsRoi(uint32_t x, uint32_t y, uint32_t width, uint32_t height) {
+    if ((width == 0) != (height == 0)) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(m_renderMutex);
+    m_roiX = x;
+    m_roiY = y;
+    m_roiWidth = width;
+    m_roiHeight = height;
+    return true;
+}
+
+bool XShow::Impl::getStatistics(XStatistics& stats, XStatistics* roi) const {
+    std::lock_guard<std::mutex> lock(m_statsMutex);
+    stats = m_stats;
+    if (roi) {
+        *roi = m_roiStats;
+    }
+    return m_stats.frame > 0;
+}
+
+uint32_t XShow::Impl::getHistogram(uint32_t* bins, uint32_t count, bool roi) const {
+    std::lock_guard<std::mutex> lock(m_statsMutex);
+    const std::vector<uint32_t>& histogram = roi ? m_roiHistogram : m_histogram;
+    if (bins && count > 0) {
+        const size_t n = std::min<size_t>(count, histogram.size());
+        std::copy(histogram.begin(), histogram.begin() + static_cast<std::ptrdiff_t>(n), bins);
+    }
+    return static_cast<uint32_t>(histogram.size());
+}
+
+template <uint32_t Bytes>
+void XShow::Impl::autoWindow(const XImage* image) {
+    Internal::autoWindowRange<Bytes>(image, m_pixelDepth, m_autoClip, m_windowLow, m_windowHigh);
+}
+
+WindowParams XShow::Impl::windowParams() const {
+    return Internal::makeWindow(m_windowLow, m_windowHigh, m_pixelDepth);
+}
+
+void XShow::Impl::buildLut() {
+    m_lut.resize(256 * 3);
+    for (uint32_t i = 0; i < 256; ++i) {
+        uint8_t r, g, b;
+        mapColor(applyGamma(static_cast<uint8_t>(i)), r, g, b);
+        m_lut[i * 3 + 0] = b;
+        m_lut[i * 3 + 1] = g;
+        m_lut[i * 3 + 2] = r;
+    }
+    
+    // Material colors scaled by the level; the other classes are gray
+    m_materialLut.resize(Internal::MATERIAL_CLASSES * 256 * 3);
+    for (uint32_t c = 0; c < Internal::MATERIAL_CLASSES; ++c) {
+        const bool colored = (c == Internal::MATERIAL_ORGANIC || c == Internal::MATERIAL_INORGANIC ||
+                              c == Internal::MATERIAL_METAL);
+        const uint32_t rgb = colored ? m_materialRgb[c - Internal::MATERIAL_ORGANIC] : 0xFFFFFF;
+        for (uint32_t i = 0; i < 256; ++i) {
+            const uint32_t level = applyGamma(static_cast<uint8_t>(i));
+            uint8_t* bgr = &m_materialLut[(c * 256 + i) * 3];
+            bgr[0] = static_cast<uint8_t>((rgb & 0xFF) * level / 255);
+            bgr[1] = static_cast<uint8_t>(((rgb >> 8) & 0xFF) * level / 255);
+            bgr[2] = static_cast<uint8_t>(((rgb >> 16) & 0xFF) * level / 255);
+        }
+    }
+    m_lutValid = true;
+    m_glLutValid = false;
+}
+
+void XShow::Impl::mapColor(uint8_t normalized, uint8_t& r, uint8_t& g, uint8_t& b) const {
+    switch (m_colorMode) {
+        case XCOLOR_GRAY:
+            r = g = b = normalized;
+            break;
+            
+        case XCOLOR_HOT:
+            // Hot color map (black -> red -> yellow -> white)
+            if (normalized < 85) {
+                r = normalized * 3;
+                g = 0;
+                b = 0;
+            } else if (normalized < 170) {
+                r = 255;
+                g = (normalized - 85) * 3;
+                b = 0;
+            } else {
+                r = 255;
+                g = 255;
+                b = (normalized - 170) * 3;
+            }
+            break;
+            
+        case XCOLOR_JET:
+            // Jet color map (blue -> cyan -> yellow -> red)
+            if (normalized < 64) {
+                r = 0;
+                g = 0;
+                b = 128 + normalized * 2;
+            } else if (normalized < 128) {
+                r = 0;
+                g = (normalized - 64) * 4;
+                b = 255;
+            } else if (normalized < 192) {
+                r = (normalized - 128) * 4;
+                g = 255;
+                b = 255 - (normalized - 128) * 4;
+            } else {
+                r = 255;
+                g = 255 - (normalized - 192) * 4;
+                b = 0;
+            }
+            break;
+            
+        default:
+            r = g = b = normalized;
+            break;
     }
 }
 
@@ -250,13 +1685,88 @@ uint8_t XShow::Impl::applyGamma(uint8_t value) {
 }
 
 void XShow::Impl::setGama(float gama) {
-    if (gama >= 1.0f && gama <= 4.0f) {
+    std::lock_guard<std::mutex> lock(m_renderMutex);
+    if (gama >= 1.0f && gama <= 4.0f && gama != m_gamma) {
         m_gamma = gama;
+        m_lutValid = false;
+    }
+}
+
+bool XShow::Impl::setWindow(uint32_t low, uint32_t high) {
+    std::lock_guard<std::mutex> lock(m_renderMutex);
+    if (low >= high) {
+        return false;
+    }
+    m_windowLow = low;
+    m_windowHigh = high;
+    m_autoWindow = false;
+    return true;
+}
+
+void XShow::Impl::getWindow(uint32_t& low, uint32_t& high) const {
+    std::lock_guard<std::mutex> lock(m_renderMutex);
+    const WindowParams w = windowParams();
+    low = w.low;
+    high = w.low + w.range;
+}
+
+void XShow::Impl::setMaterialColors(uint32_t organic, uint32_t inorganic, uint32_t metal) {
+    std::lock_guard<std::mutex> lock(m_renderMutex);
+    m_materialRgb[0] = organic & 0xFFFFFF;
+    m_materialRgb[1] = inorganic & 0xFFFFFF;
+    m_materialRgb[2] = metal & 0xFFFFFF;
+    m_lutValid = false;
+}
+
+bool XShow::Impl::setMaterialModel(const MaterialModel& model) {
+    if (!model.valid()) {
+        return false;
     }
+    std::lock_guard<std::mutex> lock(m_renderMutex);
+    m_materialModel = model;
+    m_materialTableValid = false;
+    return true;
+}
+
+bool XShow::Impl::setBackend(XBackend backend) {
+    std::lock_guard<std::mutex> lock(m_renderMutex);
+    return selectBackend(backend);
+}
+
+XShow::XBackend XShow::Impl::getBackend() const {
+    std::lock_guard<std::mutex> lock(m_renderMutex);
+    return m_gl.isValid() ? XBACKEND_OPENGL : XBACKEND_GDI;
+}
+
+bool XShow::Impl::selectBackend(XBackend backend) {
+    m_backend = backend;
+    if (!m_opened) {
+        return true;
+    }
+    if (backend == XBACKEND_GDI) {
+        m_gl.destroy();
+        return true;
+    }
+    if (m_gl.isValid()) {
+        return true;
+    }
+    m_glLutValid = false;
+    return m_gl.create(m_windowHandle);
+}
+
+void XShow::Impl::setAutoWindow(bool enable, float clip) {
+    std::lock_guard<std::mutex> lock(m_renderMutex);
+    m_autoWindow = enable;
+    m_autoClip = std::min(std::max(clip, 0.0f), 0.49f);
 }
 
-float XShow::Impl::getGama() const {
-    return m_gamma;
+bool XShow::Impl::setContrastEnhancement(bool enable, uint32_t tiles, float clipLimit) {
+    std::lock_guard<std::mutex> lock(m_renderMutex);
+    if (!m_clahe.configure(tiles, clipLimit)) {
+        return false;
+    }
+    m_claheEnabled = enable;
+    return true;
 }
 
 // XShow public interface
@@ -306,6 +1816,19 @@ void XShow::Show(XImage* img_) {
     }
 }
 
+void XShow::Show(XImage* high, XImage* low) {
+    if (m_impl) {
+        m_impl->show(high, low);
+    }
+}
+
+void XShow::ShowLines(const XImage* strip, uint32_t firstLine, uint32_t count) {
+    (void)firstLine;
+    if (m_impl) {
+        m_impl->showLines(strip, count);
+    }
+}
+
 void XShow::SetGama(float gama) {
     if (m_impl) {
         m_impl->setGama(gama);
@@ -319,4 +1842,134 @@ float XShow::GetGama() {
     return m_impl->getGama();
 }
 
-} // namespace HX
\ No newline at end of file
+bool XShow::SetWindow(uint32_t low, uint32_t high) {
+    if (!m_impl) {
+        return false;
+    }
+    return m_impl->setWindow(low, high);
+}
+
+void XShow::GetWindow(uint32_t& low, uint32_t& high) {
+    if (m_impl) {
+        m_impl->getWindow(low, high);
+    }
+}
+
+void XShow::SetAutoWindow(bool enable, float clip) {
+    if (m_impl) {
+        m_impl->setAutoWindow(enable, clip);
+    }
+}
+
+bool XShow::SetContrastEnhancement(bool enable, uint32_t tiles, float clipLimit) {
+    if (!m_impl) {
+        return false;
+    }
+    return m_impl->setContrastEnhancement(enable, tiles, clipLimit);
+}
+
+void XShow::SetMaterialColors(uint32_t organic, uint32_t inorganic, uint32_t metal) {
+    if (m_impl) {
+        m_impl->setMaterialColors(organic, inorganic, metal);
+    }
+}
+
+bool XShow::SetMaterialModel(float z0, float z1, float z2, float organicMaxZ, float metalMinZ,
+                             uint32_t lutBits) {
+    if (!m_impl) {
+        return false;
+    }
+    MaterialModel model;
+    model.z0 = z0;
+    model.z1 = z1;
+    model.z2 = z2;
+    model.organicMaxZ = organicMaxZ;
+    model.metalMinZ = metalMinZ;
+    model.lutBits = static_cast<int>(std::min(lutBits, 32u));
+    return m_impl->setMaterialModel(model);
+}
+
+bool XShow::SetBackend(XBackend backend) {
+    if (!m_impl) {
+        return false;
+    }
+    return m_impl->setBackend(backend);
+}
+
+XShow::XBackend XShow::GetBackend() {
+    if (!m_impl) {
+        return XBACKEND_GDI;
+    }
+    return m_impl->getBackend();
+}
+
+bool XShow::SetAsync(bool enable, uint32_t maxFps) {
+    if (!m_impl) {
+        return false;
+    }
+    return m_impl->setAsync(enable, maxFps);
+}
+
+uint64_t XShow::GetDroppedFrames() {
+    if (!m_impl) {
+        return 0;
+    }
+    return m_impl->getDroppedFrames();
+}
+
+uint32_t XShow::AddOverlay(XOverlay type, int32_t x0, int32_t y0, int32_t x1, int32_t y1,
+                           uint32_t rgb) {
+    if (!m_impl) {
+        return 0;
+    }
+    return m_impl->addOverlay(type, x0, y0, x1, y1, rgb);
+}
+
+bool XShow::MoveOverlay(uint32_t id, int32_t x0, int32_t y0, int32_t x1, int32_t y1) {
+    if (!m_impl) {
+        return false;
+    }
+    return m_impl->moveOverlay(id, x0, y0, x1, y1);
+}
+
+bool XShow::RemoveOverlay(uint32_t id) {
+    if (!m_impl) {
+        return false;
+    }
+    return m_impl->removeOverlay(id);
+}
+
+void XShow::ClearOverlays() {
+    if (m_impl) {
+        m_impl->clearOverlays();
+    }
+}
+
+void XShow::SetStatistics(bool enable) {
+    if (m_impl) {
+        m_impl->setStatistics(enable);
+    }
+}
+
+bool XShow::SetStatisticsRoi(uint32_t x, uint32_t y, uint32_t width, uint32_t height) {
+    if (!m_impl) {
+        return false;
+    }
+    return m_impl->setStatisticsRoi(x, y, width, height);
+}
+
+bool XShow::GetStatistics(XStatistics& stats, XStatistics* roi) {
+    if (!m_impl) {
+        return false;
+    }
+    return m_impl->getStatistics(stats, roi);
+}
+
+uint32_t XShow::GetHistogram(uint32_t* bins, uint32_t count, bool roi) {
+    if (!m_impl) {
+        return 0;
+    }
+    return m_impl->getHistogram(bins, count, roi);
+}
+
+} // namespace HX
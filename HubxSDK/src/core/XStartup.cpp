@@ -0,0 +1,415 @@
+// ============================================================================
+// XStartup.cpp - Concurrent SDK startup
+// ============================================================================
+
+/**
+ * @file XStartup.cpp
+ * @brief XStartup implementation - step threads, library gate, timeline
+ * @version 2.1.0
+ */
+
+#include "XStartup.h"
+#include "XAdaptor.h"
+#include "XFrame.h"
+#include "xfactory.h"
+#include "utils/calib_file.h"
+#include "utils/logger.h"
+#include "utils/thread_policy.h"
+#include "utils/thread_pool.h"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <future>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace HX {
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+/// Read size while warming a calibration file
+const size_t WARM_CHUNK = 1024 * 1024;
+
+bool fileExists(const std::string& file) {
+    std::ifstream in(file.c_str(), std::ios::binary);
+    return in.good();
+}
+
+/**
+ * @brief Read a file once so later loads come from the page cache
+ * @return false if the file cannot be read
+ */
+bool warmFile(const std::string& file, std::string& error) {
+#ifndef _WIN32
+    const int fd = open(file.c_str(), O_RDONLY);
+    if (fd < 0) {
+        error = "cannot open " + file;
+        return false;
+    }
+    // Let the kernel read ahead of us across the whole file
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+    std::vector<char> chunk(WARM_CHUNK);
+    ssize_t got = 0;
+    while ((got = read(fd, chunk.data(), chunk.size())) > 0) {
+    }
+    close(fd);
+    if (got < 0) {
+        error = "cannot read " + file;
+        return false;
+    }
+#else
+    std::ifstream in(file.c_str(), std::ios::binary);
+    if (!in) {
+        error = "cannot open " + file;
+        return false;
+    }
+    std::vector<char> chunk(WARM_CHUNK);
+    while (in.read(chunk.data(), chunk.size()) || in.gcount() > 0) {
+    }
+#endif
+    if (Internal::CalibFile::IsContainer(file.c_str())) {
+        Internal::CalibFile calibration;
+        if (!calibration.Open(file.c_str())) {
+            error = file + ": " + calibration.Error();
+            return false;
+        }
+    }
+    return true;
+}
+
+} // anonymous namespace
+
+// ============================================================================
+// Internal Implementation
+// ============================================================================
+
+class XStartup::Impl {
+public:
+    Impl(XFactory& factory, XAdaptor& adaptor);
+
+    void setInventory(const std::string& file, uint32_t timeout) {
+        m_inventory = file;
+        m_inventoryTimeout = timeout;
+    }
+    void setDiscovery(uint32_t timeout, uint32_t expected, bool allAdapters) {
+        m_discoveryTimeout = timeout;
+        m_expected = expected;
+        m_allAdapters = allAdapters;
+    }
+    void addCalibration(const std::string& file) { m_calibrations.push_back(file); }
+    void addFrame(XFrame& frame, uint32_t width, uint8_t pixelDepth);
+    void addTask(const std::string& name, const std::function<bool()>& task, bool needsLibrary);
+
+    bool run();
+    std::vector<XStartup::Step> getTimeline() const;
+    uint64_t getStartupTime() const;
+
+private:
+    struct Frame {
+        XFrame* frame;
+        uint32_t width;
+        uint8_t pixelDepth;
+    };
+
+    struct Task {
+        std::string name;
+        std::function<bool()> task;
+        bool needsLibrary;
+    };
+
+    typedef std::function<bool(std::string&)> Body;
+
+    /// Time a step and add it to the timeline
+    bool runStep(const std::string& name, const Body& body);
+    void skipStep(const std::string& name);
+    uint64_t elapsedUs() const;
+
+    bool loadLibrary(std::string& error);
+    bool discover(std::string& error);
+    bool prepareFrame(const Frame& frame, std::string& error);
+    bool startThreads(std::string& error);
+
+    XFactory& m_factory;
+    XAdaptor& m_adaptor;
+
+    std::string m_inventory;
+    uint32_t m_inventoryTimeout;
+    uint32_t m_discoveryTimeout;
+    uint32_t m_expected;
+    bool m_allAdapters;
+    std::vector<std::string> m_calibrations;
+    std::vector<Frame> m_frames;
+    std::vector<Task> m_tasks;
+
+    mutable std::mutex m_mutex;         // Guards the timeline
+    Clock::time_point m_start;
+    std::vector<XStartup::Step> m_timeline;
+    uint64_t m_totalUs;
+};
+
+XStartup::Impl::Impl(XFactory& factory, XAdaptor& adaptor)
+    : m_factory(factory)
+    , m_adaptor(adaptor)
+    , m_inventoryTimeout(1000)
+    , m_discoveryTimeout(1000)
+    , m_expected(0)
+    , m_allAdapters(true)
+    , m_totalUs(0)
+{
+}
+
+void XStartup::Impl::addFrame(XFrame& frame, uint32_t width, uint8_t pixelDepth) {
+    Frame entry = { &frame, width, pixelDepth };
+    m_frames.push_back(entry);
+}
+
+void XStartup::Impl::addTask(const std::string& name, const std::function<bool()>& task, bool needsLibrary) {
+    Task entry = { name, task, needsLibrary };
+    m_tasks.push_back(entry);
+}
+
+uint64_t XStartup::Impl::elapsedUs() const {
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - m_start).count());
+}
+
+bool XStartup::Impl::runStep(const std::string& name, const Body& body) {
+    Internal::ApplyThreadPolicy(XFactory::THREAD_SERVICE);
+
+    XStartup::Step step;
+    step.name = name;
+    step.startUs = elapsedUs();
+    step.ok = body(step.error);
+    step.durationUs = elapsedUs() - step.startUs;
+    if (!step.ok) {
+        HX_LOG_ERROR("XStartup") << name << " failed: " << step.error;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_timeline.push_back(step);
+    return step.ok;
+}
+
+void XStartup::Impl::skipStep(const std::string& name) {
+    XStartup::Step step;
+    step.name = name;
+    step.startUs = elapsedUs();
+    step.error = "skipped, the library did not load";
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_timeline.push_back(step);
+}
+
+bool XStartup::Impl::loadLibrary(std::string& error) {
+    if (!m_factory.IsInitialized() && !m_factory.Initialize()) {
+        error = "XFactory::Initialize() failed";
+        return false;
+    }
+    return true;
+}
+
+bool XStartup::Impl::discover(std::string& error) {
+    if (!m_adaptor.IsOpen() && !m_adaptor.Open()) {
+        error = "cannot open the adaptor";
+        return false;
+    }
+
+    if (!m_inventory.empty() && fileExists(m_inventory)) {
+        const int32_t loaded = m_adaptor.LoadInventory(m_inventory, m_inventoryTimeout);
+        if (loaded >= 0) {
+            HX_LOG_INFO("XStartup") << loaded << " detector(s) from " << m_inventory;
+            return true;
+        }
+        HX_LOG_WARNING("XStartup") << "Inventory " << m_inventory << " not usable, discovering";
+    }
+
+    const int32_t found = m_adaptor.Discover(m_discoveryTimeout, m_allAdapters, m_expected);
+    if (found < 0) {
+        error = "discovery failed";
+        return false;
+    }
+    HX_LOG_INFO("XStartup") << found << " detector(s) discovered";
+    if (!m_inventory.empty() && found > 0 && !m_adaptor.SaveInventory(m_inventory)) {
+        HX_LOG_WARNING("XStartup") << "Cannot write inventory " << m_inventory;
+    }
+    return true;
+}
+
+bool XStartup::Impl::prepareFrame(const Frame& frame, std::string& error) {
+    if (!frame.frame->Prepare(frame.width, frame.pixelDepth)) {
+        error = "XFrame::Prepare() failed";
+        return false;
+    }
+    return true;
+}
+
+bool XStartup::Impl::startThreads(std::string& error) {
+    (void)error;
+    // The pool starts its workers on the first job
+    Internal::ThreadPool& pool = Internal::ThreadPool::instance();
+    pool.run(static_cast<int>(std::max(1u, pool.threadCount())), [](int) {});
+    return true;
+}
+
+bool XStartup::Impl::run() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_timeline.clear();
+        m_totalUs = 0;
+    }
+    m_start = Clock::now();
+
+    std::promise<bool> library;
+    std::shared_future<bool> loaded = library.get_future().share();
+    std::vector<std::thread> threads;
+
+    threads.push_back(std::thread([this, &library] {
+        library.set_value(runStep("library", [this](std::string& error) { return loadLibrary(error); }));
+    }));
+    threads.push_back(std::thread([this, loaded] {
+        if (!loaded.get()) {
+            skipStep("discovery");
+            return;
+        }
+        runStep("discovery", [this](std::string& error) { return discover(error); });
+    }));
+    for (size_t i = 0; i < m_calibrations.size(); ++i) {
+        const std::string file = m_calibrations[i];
+        threads.push_back(std::thread([this, file] {
+            runStep("calibration:" + file, [&file](std::string& error) { return warmFile(file, error); });
+        }));
+    }
+    for (size_t i = 0; i < m_frames.size(); ++i) {
+        const Frame frame = m_frames[i];
+        std::ostringstream out;
+        out << "pool:" << i;
+        const std::string name = out.str();
+        threads.push_back(std::thread([this, frame, name] {
+            runStep(name, [this, &frame](std::string& error) { return prepareFrame(frame, error); });
+        }));
+    }
+    threads.push_back(std::thread([this] {
+        runStep("threads", [this](std::string& error) { return startThreads(error); });
+    }));
+    for (size_t i = 0; i < m_tasks.size(); ++i) {
+        const Task task = m_tasks[i];
+        threads.push_back(std::thread([this, task, loaded] {
+            if (task.needsLibrary && !loaded.get()) {
+                skipStep(task.name);
+                return;
+            }
+            runStep(task.name, [&task](std::string& error) {
+                if (!task.task()) {
+                    error = "task returned false";
+                    return false;
+                }
+                return true;
+            });
+        }));
+    }
+
+    for (size_t i = 0; i < threads.size(); ++i) {
+        threads[i].join();
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::stable_sort(m_timeline.begin(), m_timeline.end(),
+                     [](const XStartup::Step& a, const XStartup::Step& b) { return a.startUs < b.startUs; });
+    bool ok = true;
+    std::ostringstream summary;
+    for (size_t i = 0; i < m_timeline.size(); ++i) {
+        const XStartup::Step& step = m_timeline[i];
+        m_totalUs = std::max(m_totalUs, step.startUs + step.durationUs);
+        ok = ok && step.ok;
+        summary << (i ? ", " : "") << step.name << " " << step.startUs / 1000 << "+"
+                << step.durationUs / 1000 << " ms" << (step.ok ? "" : " FAILED");
+    }
+    HX_LOG_INFO("XStartup") << "Started in " << m_totalUs / 1000 << " ms: " << summary.str();
+    return ok;
+}
+
+std::vector<XStartup::Step> XStartup::Impl::getTimeline() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_timeline;
+}
+
+uint64_t XStartup::Impl::getStartupTime() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_totalUs;
+}
+
+// ============================================================================
+// Public Interface
+// ============================================================================
+
+XStartup::XStartup(XFactory& factory, XAdaptor& adaptor)
+    : m_impl(new Impl(factory, adaptor))
+{
+}
+
+XStartup::~XStartup() {
+    delete m_impl;
+}
+
+void XStartup::SetInventory(const std::string& file, uint32_t timeout) {
+    if (m_impl) {
+        m_impl->setInventory(file, timeout);
+    }
+}
+
+void XStartup::SetDiscovery(uint32_t timeout, uint32_t expected, bool allAdapters) {
+    if (m_impl) {
+        m_impl->setDiscovery(timeout, expected, allAdapters);
+    }
+}
+
+void XStartup::AddCalibration(const std::string& file) {
+    if (m_impl) {
+        m_impl->addCalibration(file);
+    }
+}
+
+void XStartup::AddFrame(XFrame& frame, uint32_t width, uint8_t pixelDepth) {
+    if (m_impl) {
+        m_impl->addFrame(frame, width, pixelDepth);
+    }
+}
+
+void XStartup::AddTask(const std::string& name, const std::function<bool()>& task, bool needsLibrary) {
+    if (m_impl) {
+        m_impl->addTask(name, task, needsLibrary);
+    }
+}
+
+bool XStartup::Run() {
+    if (!m_impl) {
+        return false;
+    }
+    return m_impl->run();
+}
+
+std::vector<XStartup::Step> XStartup::GetTimeline() const {
+    if (!m_impl) {
+        return std::vector<Step>();
+    }
+    return m_impl->getTimeline();
+}
+
+uint64_t XStartup::GetStartupTime() const {
+    if (!m_impl) {
+        return 0;
+    }
+    return m_impl->getStartupTime();
+}
+
+} // namespace HX
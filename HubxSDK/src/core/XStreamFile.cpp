@@ -0,0 +1,665 @@
+// ============================================================================
+// XStreamFile.cpp - Line-scan stream container
+// ============================================================================
+
+/**
+ * @file XStreamFile.cpp
+ * @brief XStreamFile implementation - chunked, indexed line streams
+ * @version 2.1.0
+ */
+
+#include "XStreamFile.h"
+#include "XImage.h"
+#include "utils/calib_file.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+namespace HX {
+
+namespace {
+
+/*
+ * File layout:
+ *
+ *   StreamHeader      64 bytes, magic "HXSTRM\0\0"
+ *   chunk 0           ChunkHeader + lineCount * lineBytes pixels
+ *   chunk 1 ...
+ *   index             IndexEntry per chunk
+ *   StreamTrailer     40 bytes, magic "HXSTIDX\0", locates the index
+ *
+ * The index duplicates the chunk headers so a reader never has to walk
+ * the file; without a trailer it walks the chunk headers instead.
+ */
+
+const char STREAM_MAGIC[8]  = { 'H', 'X', 'S', 'T', 'R', 'M', '\0', '\0' };
+const char TRAILER_MAGIC[8] = { 'H', 'X', 'S', 'T', 'I', 'D', 'X', '\0' };
+const uint32_t CHUNK_MAGIC = 0x4B4E4843;        ///< "CHNK"
+const uint32_t STREAM_VERSION = 1;
+
+/// Default chunk payload when Create() gets chunkLines = 0
+const uint64_t DEFAULT_CHUNK_BYTES = 4 * 1024 * 1024;
+
+#pragma pack(push, 1)
+
+struct StreamHeader {
+    char     magic[8];
+    uint32_t version;
+    uint32_t headerSize;
+    uint32_t width;
+    uint32_t pixelDepth;
+    uint32_t lineBytes;
+    uint32_t chunkLines;
+    uint64_t created;           ///< Wall clock at Create(), microseconds
+    uint8_t  reserved[24];
+};
+
+struct ChunkHeader {
+    uint32_t magic;             ///< CHUNK_MAGIC
+    uint32_t lineCount;
+    uint64_t firstLine;
+    uint32_t firstLineId;
+    uint32_t lastLineId;
+    uint64_t firstTime;
+    uint64_t lastTime;
+    uint32_t crc;               ///< CRC-32 of the pixel data
+    uint32_t lastTimeLine;      ///< Line within the chunk that lastTime belongs to
+};
+
+struct IndexEntry {
+    uint64_t offset;            ///< File offset of the ChunkHeader
+    ChunkHeader chunk;
+};
+
+struct StreamTrailer {
+    char     magic[8];
+    uint64_t indexOffset;
+    uint64_t chunkCount;
+    uint64_t lineCount;
+    uint32_t indexCrc;
+    uint32_t reserved;
+};
+
+#pragma pack(pop)
+
+uint64_t nowUs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+}
+
+} // namespace
+
+class XStreamFile::Impl {
+public:
+    Impl();
+    ~Impl();
+
+    bool create(const std::string& file, uint32_t width, uint8_t pixelDepth, uint32_t chunkLines);
+    bool appendLines(const uint8_t* data, uint32_t count, uint32_t stride,
+                     uint32_t firstLineId, uint64_t timestampUs);
+    bool append(const XImage* image, uint32_t firstLineId, uint64_t timestampUs);
+    bool flush();
+    bool close();
+
+    bool open(const std::string& file);
+    uint32_t getWidth() const { return m_width; }
+    uint8_t getPixelDepth() const { return m_pixelDepth; }
+    uint64_t getLineCount() const { return m_lineCount; }
+    uint32_t getChunkCount() const { return static_cast<uint32_t>(m_index.size()); }
+    bool getChunkInfo(uint32_t index, ChunkInfo& info) const;
+    bool readLines(uint64_t firstLine, uint32_t count, XImage* image);
+    uint64_t findTime(uint64_t timestampUs) const;
+    bool verify();
+
+private:
+    enum Mode { MODE_CLOSED = 0, MODE_WRITE, MODE_READ };
+
+    bool writeChunk();
+    bool loadIndex(uint64_t fileSize);
+    bool recoverIndex(uint64_t fileSize);
+    size_t findChunk(uint64_t line) const;
+    void reset();
+
+    Mode m_mode;
+    std::string m_fileName;
+    std::ofstream m_out;
+    std::ifstream m_in;
+
+    uint32_t m_width;
+    uint8_t m_pixelDepth;
+    uint32_t m_lineBytes;
+    uint32_t m_chunkLines;
+    uint32_t m_headerSize;
+    uint64_t m_lineCount;               ///< Lines in written chunks
+    std::vector<IndexEntry> m_index;
+
+    // Chunk being filled (write mode)
+    std::vector<uint8_t> m_chunk;
+    ChunkHeader m_pending;
+    uint64_t m_writeOffset;
+};
+
+XStreamFile::Impl::Impl()
+    : m_mode(MODE_CLOSED)
+{
+    reset();
+}
+
+XStreamFile::Impl::~Impl() {
+    close();
+}
+
+void XStreamFile::Impl::reset() {
+    m_width = 0;
+    m_pixelDepth = 0;
+    m_lineBytes = 0;
+    m_chunkLines = 0;
+    m_headerSize = sizeof(StreamHeader);
+    m_lineCount = 0;
+    m_index.clear();
+    m_chunk.clear();
+    std::memset(&m_pending, 0, sizeof(m_pending));
+    m_writeOffset = 0;
+}
+
+bool XStreamFile::Impl::create(const std::string& file, uint32_t width, uint8_t pixelDepth,
+                               uint32_t chunkLines) {
+    close();
+    if (width == 0 || pixelDepth == 0 || pixelDepth > 32) {
+        std::cerr << "[XStreamFile] Invalid line format" << std::endl;
+        return false;
+    }
+
+    m_out.open(file.c_str(), std::ios::binary | std::ios::trunc);
+    if (!m_out.is_open()) {
+        std::cerr << "[XStreamFile] Failed to create file: " << file << std::endl;
+        return false;
+    }
+
+    m_width = width;
+    m_pixelDepth = pixelDepth;
+    m_lineBytes = width * ((pixelDepth + 7) / 8);
+    m_chunkLines = chunkLines ? chunkLines
+                              : static_cast<uint32_t>(std::max<uint64_t>(1, DEFAULT_CHUNK_BYTES / m_lineBytes));
+    m_chunk.resize(static_cast<size_t>(m_chunkLines) * m_lineBytes);
+
+    StreamHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, STREAM_MAGIC, sizeof(header.magic));
+    header.version = STREAM_VERSION;
+    header.headerSize = sizeof(StreamHeader);
+    header.width = m_width;
+    header.pixelDepth = m_pixelDepth;
+    header.lineBytes = m_lineBytes;
+    header.chunkLines = m_chunkLines;
+    header.created = nowUs();
+    m_out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    if (!m_out.good()) {
+        std::cerr << "[XStreamFile] Failed to write file: " << file << std::endl;
+        m_out.close();
+        reset();
+        return false;
+    }
+
+    m_fileName = file;
+    m_writeOffset = sizeof(header);
+    m_mode = MODE_WRITE;
+    return true;
+}
+
+bool XStreamFile::Impl::appendLines(const uint8_t* data, uint32_t count, uint32_t stride,
+                                    uint32_t firstLineId, uint64_t timestampUs) {
+    if (m_mode != MODE_WRITE || !data) {
+        return false;
+    }
+    if (stride == 0) {
+        stride = m_lineBytes;
+    }
+    if (timestampUs == 0) {
+        timestampUs = nowUs();
+    }
+
+    uint32_t done = 0;
+    while (done < count) {
+        if (m_pending.lineCount == 0) {
+            m_pending.firstLineId = firstLineId + done;
+            m_pending.firstTime = timestampUs;
+        }
+        const uint32_t n = std::min(count - done, m_chunkLines - m_pending.lineCount);
+        uint8_t* dst = m_chunk.data() + static_cast<size_t>(m_pending.lineCount) * m_lineBytes;
+        const uint8_t* src = data + static_cast<size_t>(done) * stride;
+        if (stride == m_lineBytes) {
+            std::memcpy(dst, src, static_cast<size_t>(n) * m_lineBytes);
+        } else {
+            for (uint32_t i = 0; i < n; ++i) {
+                std::memcpy(dst + static_cast<size_t>(i) * m_lineBytes,
+                            src + static_cast<size_t>(i) * stride, m_lineBytes);
+            }
+        }
+        m_pending.lastTimeLine = m_pending.lineCount;
+        m_pending.lineCount += n;
+        m_pending.lastLineId = firstLineId + done + n - 1;
+        m_pending.lastTime = timestampUs;
+        done += n;
+
+        if (m_pending.lineCount == m_chunkLines && !writeChunk()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool XStreamFile::Impl::append(const XImage* image, uint32_t firstLineId, uint64_t timestampUs) {
+    if (!image || !image->_data_) {
+        return false;
+    }
+    if (image->_width != m_width || image->_pixel_depth != m_pixelDepth) {
+        std::cerr << "[XStreamFile] Image format does not match the stream" << std::endl;
+        return false;
+    }
+    return appendLines(image->_data_ + image->_data_offset, image->_height, image->_stride,
+                       firstLineId, timestampUs);
+}
+
+bool XStreamFile::Impl::writeChunk() {
+    if (m_pending.lineCount == 0) {
+        return true;
+    }
+    const size_t bytes = static_cast<size_t>(m_pending.lineCount) * m_lineBytes;
+
+    IndexEntry entry;
+    entry.offset = m_writeOffset;
+    entry.chunk = m_pending;
+    entry.chunk.magic = CHUNK_MAGIC;
+    entry.chunk.firstLine = m_lineCount;
+    entry.chunk.crc = Internal::Crc32(m_chunk.data(), bytes);
+
+    m_out.write(reinterpret_cast<const char*>(&entry.chunk), sizeof(entry.chunk));
+    m_out.write(reinterpret_cast<const char*>(m_chunk.data()), bytes);
+    if (!m_out.good()) {
+        std::cerr << "[XStreamFile] Failed to write chunk to " << m_fileName << std::endl;
+        return false;
+    }
+
+    m_index.push_back(entry);
+    m_writeOffset += sizeof(entry.chunk) + bytes;
+    m_lineCount += m_pending.lineCount;
+    std::memset(&m_pending, 0, sizeof(m_pending));
+    return true;
+}
+
+bool XStreamFile::Impl::flush() {
+    if (m_mode != MODE_WRITE) {
+        return false;
+    }
+    if (!writeChunk()) {
+        return false;
+    }
+    m_out.flush();
+    return m_out.good();
+}
+
+bool XStreamFile::Impl::close() {
+    bool ok = true;
+    if (m_mode == MODE_WRITE) {
+        ok = writeChunk();
+
+        StreamTrailer trailer;
+        std::memset(&trailer, 0, sizeof(trailer));
+        std::memcpy(trailer.magic, TRAILER_MAGIC, sizeof(trailer.magic));
+        trailer.indexOffset = m_writeOffset;
+        trailer.chunkCount = m_index.size();
+        trailer.lineCount = m_lineCount;
+        trailer.indexCrc = Internal::Crc32(m_index.data(), m_index.size() * sizeof(IndexEntry));
+
+        if (ok) {
+            m_out.write(reinterpret_cast<const char*>(m_index.data()),
+                        m_index.size() * sizeof(IndexEntry));
+            m_out.write(reinterpret_cast<const char*>(&trailer), sizeof(trailer));
+            ok = m_out.good();
+        }
+        m_out.close();
+        ok = ok && !m_out.fail();
+        if (!ok) {
+            std::cerr << "[XStreamFile] Failed to finish " << m_fileName << std::endl;
+        }
+    } else if (m_mode == MODE_READ) {
+        m_in.close();
+    }
+    m_mode = MODE_CLOSED;
+    reset();
+    return ok;
+}
+
+bool XStreamFile::Impl::open(const std::string& file) {
+    close();
+    m_in.open(file.c_str(), std::ios::binary);
+    if (!m_in.is_open()) {
+        std::cerr << "[XStreamFile] Failed to open file: " << file << std::endl;
+        return false;
+    }
+    m_in.seekg(0, std::ios::end);
+    const uint64_t fileSize = static_cast<uint64_t>(m_in.tellg());
+    m_in.seekg(0, std::ios::beg);
+
+    StreamHeader header;
+    m_in.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!m_in.good() || std::memcmp(header.magic, STREAM_MAGIC, sizeof(header.magic)) != 0) {
+        std::cerr << "[XStreamFile] Not a stream file: " << file << std::endl;
+        m_in.close();
+        return false;
+    }
+    if (header.version == 0 || header.version > STREAM_VERSION ||
+        header.headerSize < sizeof(StreamHeader) || header.width == 0 ||
+        header.pixelDepth == 0 || header.pixelDepth > 32 ||
+        header.lineBytes != header.width * ((header.pixelDepth + 7) / 8)) {
+        std::cerr << "[XStreamFile] Unsupported stream header: " << file << std::endl;
+        m_in.close();
+        return false;
+    }
+
+    m_fileName = file;
+    m_width = header.width;
+    m_pixelDepth = static_cast<uint8_t>(header.pixelDepth);
+    m_lineBytes = header.lineBytes;
+    m_chunkLines = header.chunkLines;
+    m_headerSize = header.headerSize;
+
+    if (!loadIndex(fileSize)) {
+        // Writer did not reach Close(): walk the chunks
+        if (!recoverIndex(fileSize)) {
+            m_in.close();
+            reset();
+            return false;
+        }
+        std::cerr << "[XStreamFile] Index missing, recovered " << m_index.size()
+                  << " chunks (" << m_lineCount << " lines) from " << file << std::endl;
+    }
+
+    m_mode = MODE_READ;
+    return true;
+}
+
+bool XStreamFile::Impl::loadIndex(uint64_t fileSize) {
+    if (fileSize < m_headerSize + sizeof(StreamTrailer)) {
+        return false;
+    }
+    StreamTrailer trailer;
+    m_in.clear();
+    m_in.seekg(static_cast<std::streamoff>(fileSize - sizeof(trailer)));
+    m_in.read(reinterpret_cast<char*>(&trailer), sizeof(trailer));
+    if (!m_in.good() || std::memcmp(trailer.magic, TRAILER_MAGIC, sizeof(trailer.magic)) != 0) {
+        return false;
+    }
+    if (trailer.indexOffset < m_headerSize || trailer.indexOffset > fileSize ||
+        trailer.chunkCount > (fileSize - trailer.indexOffset) / sizeof(IndexEntry) ||
+        trailer.indexOffset + trailer.chunkCount * sizeof(IndexEntry) + sizeof(trailer) != fileSize) {
+        return false;
+    }
+
+    m_index.resize(static_cast<size_t>(trailer.chunkCount));
+    m_in.seekg(static_cast<std::streamoff>(trailer.indexOffset));
+    m_in.read(reinterpret_cast<char*>(m_index.data()), m_index.size() * sizeof(IndexEntry));
+    if (!m_in.good() ||
+        Internal::Crc32(m_index.data(), m_index.size() * sizeof(IndexEntry)) != trailer.indexCrc) {
+        m_index.clear();
+        return false;
+    }
+
+    // Chunks must tile the line range and lie before the index
+    uint64_t line = 0;
+    for (size_t i = 0; i < m_index.size(); ++i) {
+        const IndexEntry& e = m_index[i];
+        if (e.chunk.firstLine != line || e.chunk.lineCount == 0 ||
+            e.offset + sizeof(ChunkHeader) + static_cast<uint64_t>(e.chunk.lineCount) * m_lineBytes >
+                trailer.indexOffset) {
+            m_index.clear();
+            return false;
+        }
+        line += e.chunk.lineCount;
+    }
+    if (line != trailer.lineCount) {
+        m_index.clear();
+        return false;
+    }
+    m_lineCount = line;
+    return true;
+}
+
+bool XStreamFile::Impl::recoverIndex(uint64_t fileSize) {
+    m_index.clear();
+    m_lineCount = 0;
+    uint64_t offset = m_headerSize;
+    while (offset + sizeof(ChunkHeader) <= fileSize) {
+        IndexEntry entry;
+        entry.offset = offset;
+        m_in.clear();
+        m_in.seekg(static_cast<std::streamoff>(offset));
+        m_in.read(reinterpret_cast<char*>(&entry.chunk), sizeof(entry.chunk));
+        const uint64_t bytes = static_cast<uint64_t>(entry.chunk.lineCount) * m_lineBytes;
+        if (!m_in.good() || entry.chunk.magic != CHUNK_MAGIC || entry.chunk.lineCount == 0 ||
+            entry.chunk.firstLine != m_lineCount ||
+            bytes > fileSize - offset - sizeof(ChunkHeader)) {
+            break;      // Torn chunk at the end of an interrupted write
+        }
+        m_index.push_back(entry);
+        m_lineCount += entry.chunk.lineCount;
+        offset += sizeof(ChunkHeader) + bytes;
+    }
+    m_in.clear();
+    return true;
+}
+
+bool XStreamFile::Impl::getChunkInfo(uint32_t index, ChunkInfo& info) const {
+    if (index >= m_index.size()) {
+        return false;
+    }
+    const ChunkHeader& c = m_index[index].chunk;
+    info.firstLine = c.firstLine;
+    info.lineCount = c.lineCount;
+    info.firstLineId = c.firstLineId;
+    info.lastLineId = c.lastLineId;
+    info.firstTime = c.firstTime;
+    info.lastTime = c.lastTime;
+    return true;
+}
+
+size_t XStreamFile::Impl::findChunk(uint64_t line) const {
+    // Last chunk whose first line is <= line
+    size_t lo = 0;
+    size_t hi = m_index.size();
+    while (hi - lo > 1) {
+        const size_t mid = lo + (hi - lo) / 2;
+        if (m_index[mid].chunk.firstLine <= line) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+bool XStreamFile::Impl::readLines(uint64_t firstLine, uint32_t count, XImage* image) {
+    if (m_mode != MODE_READ || !image || firstLine >= m_lineCount || count == 0) {
+        return false;
+    }
+    count = static_cast<uint32_t>(std::min<uint64_t>(count, m_lineCount - firstLine));
+
+    if (!image->_data_ || image->_width != m_width || image->_height != count ||
+        image->_pixel_depth != m_pixelDepth) {
+        if (!image->Allocate(m_width, count, m_pixelDepth)) {
+            return false;
+        }
+    }
+    uint8_t* out = image->_data_ + image->_data_offset;
+    const uint32_t stride = image->_stride ? image->_stride : m_lineBytes;
+
+    uint32_t done = 0;
+    size_t chunk = findChunk(firstLine);
+    m_in.clear();
+    while (done < count && chunk < m_index.size()) {
+        const IndexEntry& e = m_index[chunk];
+        const uint64_t line = firstLine + done;
+        const uint32_t skip = static_cast<uint32_t>(line - e.chunk.firstLine);
+        const uint32_t n = std::min(count - done, e.chunk.lineCount - skip);
+
+        m_in.seekg(static_cast<std::streamoff>(e.offset + sizeof(ChunkHeader) +
+                                               static_cast<uint64_t>(skip) * m_lineBytes));
+        uint8_t* dst = out + static_cast<size_t>(done) * stride;
+        if (stride == m_lineBytes) {
+            m_in.read(reinterpret_cast<char*>(dst), static_cast<std::streamsize>(n) * m_lineBytes);
+        } else {
+            for (uint32_t i = 0; i < n; ++i) {
+                m_in.read(reinterpret_cast<char*>(dst + static_cast<size_t>(i) * stride), m_lineBytes);
+            }
+        }
+        if (!m_in.good()) {
+            std::cerr << "[XStreamFile] Failed to read lines from " << m_fileName << std::endl;
+            m_in.clear();
+            return false;
+        }
+        done += n;
+        ++chunk;
+    }
+    return done == count;
+}
+
+uint64_t XStreamFile::Impl::findTime(uint64_t timestampUs) const {
+    // First chunk whose last line is not older than the time
+    size_t lo = 0;
+    size_t hi = m_index.size();
+    while (lo < hi) {
+        const size_t mid = lo + (hi - lo) / 2;
+        if (m_index[mid].chunk.lastTime < timestampUs) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if (lo == m_index.size()) {
+        return m_lineCount;
+    }
+
+    const ChunkHeader& c = m_index[lo].chunk;
+    if (timestampUs <= c.firstTime || c.lastTimeLine == 0 || c.lastTime <= c.firstTime) {
+        return c.firstLine;
+    }
+    // Timestamps are known for line 0 and line lastTimeLine of the chunk
+    const double span = static_cast<double>(c.lastTime - c.firstTime);
+    const double pos = static_cast<double>(timestampUs - c.firstTime) / span * c.lastTimeLine;
+    uint64_t offset = static_cast<uint64_t>(pos);
+    if (static_cast<double>(offset) < pos) {
+        ++offset;
+    }
+    return c.firstLine + std::min<uint64_t>(offset, c.lastTimeLine);
+}
+
+bool XStreamFile::Impl::verify() {
+    if (m_mode != MODE_READ) {
+        return false;
+    }
+    std::vector<uint8_t> buffer;
+    m_in.clear();
+    for (size_t i = 0; i < m_index.size(); ++i) {
+        const IndexEntry& e = m_index[i];
+        buffer.resize(static_cast<size_t>(e.chunk.lineCount) * m_lineBytes);
+        m_in.seekg(static_cast<std::streamoff>(e.offset + sizeof(ChunkHeader)));
+        m_in.read(reinterpret_cast<char*>(buffer.data()), buffer.size());
+        if (!m_in.good() || Internal::Crc32(buffer.data(), buffer.size()) != e.chunk.crc) {
+            std::cerr << "[XStreamFile] Chunk " << i << " is corrupt in " << m_fileName << std::endl;
+            m_in.clear();
+            return false;
+        }
+    }
+    return true;
+}
+
+// ============================================================================
+// Public interface
+// ============================================================================
+
+XStreamFile::XStreamFile()
+    : m_impl(new Impl())
+{
+}
+
+XStreamFile::~XStreamFile() {
+    delete m_impl;
+}
+
+bool XStreamFile::Create(const std::string& file, uint32_t width, uint8_t pixelDepth,
+                         uint32_t chunkLines) {
+    if (!m_impl) return false;
+    return m_impl->create(file, width, pixelDepth, chunkLines);
+}
+
+bool XStreamFile::AppendLines(const uint8_t* data, uint32_t count, uint32_t stride,
+                              uint32_t firstLineId, uint64_t timestampUs) {
+    if (!m_impl) return false;
+    return m_impl->appendLines(data, count, stride, firstLineId, timestampUs);
+}
+
+bool XStreamFile::Append(const XImage* image, uint32_t firstLineId, uint64_t timestampUs) {
+    if (!m_impl) return false;
+    return m_impl->append(image, firstLineId, timestampUs);
+}
+
+bool XStreamFile::Flush() {
+    if (!m_impl) return false;
+    return m_impl->flush();
+}
+
+bool XStreamFile::Close() {
+    if (!m_impl) return false;
+    return m_impl->close();
+}
+
+bool XStreamFile::Open(const std::string& file) {
+    if (!m_impl) return false;
+    return m_impl->open(file);
+}
+
+uint32_t XStreamFile::GetWidth() const {
+    if (!m_impl) return 0;
+    return m_impl->getWidth();
+}
+
+uint8_t XStreamFile::GetPixelDepth() const {
+    if (!m_impl) return 0;
+    return m_impl->getPixelDepth();
+}
+
+uint64_t XStreamFile::GetLineCount() const {
+    if (!m_impl) return 0;
+    return m_impl->getLineCount();
+}
+
+uint32_t XStreamFile::GetChunkCount() const {
+    if (!m_impl) return 0;
+    return m_impl->getChunkCount();
+}
+
+bool XStreamFile::GetChunkInfo(uint32_t index, ChunkInfo& info) const {
+    if (!m_impl) return false;
+    return m_impl->getChunkInfo(index, info);
+}
+
+bool XStreamFile::ReadLines(uint64_t firstLine, uint32_t count, XImage* image) {
+    if (!m_impl) return false;
+    return m_impl->readLines(firstLine, count, image);
+}
+
+uint64_t XStreamFile::FindTime(uint64_t timestampUs) const {
+    if (!m_impl) return 0;
+    return m_impl->findTime(timestampUs);
+}
+
+bool XStreamFile::Verify() {
+    if (!m_impl) return false;
+    return m_impl->verify();
+}
+
+} // namespace HX
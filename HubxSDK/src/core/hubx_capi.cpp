@@ -0,0 +1,300 @@
+// ============================================================================
+// hubx_capi.cpp - C API over XDetector, XControl, XGrabber and XFrame
+// ============================================================================
+
+/**
+ * @file hubx_capi.cpp
+ * @brief hubx_device_t implementation - zero-copy frame delivery by function pointer
+ * @version 2.1.0
+ */
+
+#include "hubx_capi.h"
+#include "XControl.h"
+#include "XDetector.h"
+#include "XFrame.h"
+#include "XGrabber.h"
+#include "XImage.h"
+#include "iximg_sink.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <new>
+
+// Error codes
+#define HUBX_SUCCESS 0
+#define HUBX_ERROR_INVALID_PARAM -1
+#define HUBX_ERROR_NULL_POINTER -2
+#define HUBX_ERROR_DEVICE -6
+#define HUBX_ERROR_BUSY -7
+
+namespace {
+
+/// XControl results (1 success, 0 unsupported, -1 error) as C API codes
+int controlResult(int32_t result) {
+    if (result > 0) {
+        return HUBX_SUCCESS;
+    }
+    return result == 0 ? HUBX_ERROR_INVALID_PARAM : HUBX_ERROR_DEVICE;
+}
+
+bool validCode(int code) {
+    return code >= HX::XControl::XINIT && code <= HX::XControl::XDM_SN;
+}
+
+} // anonymous namespace
+
+/**
+ * @brief Detector, command channel and acquisition behind a C API handle
+ *
+ * The receive thread hands each pool buffer to the frame callback and
+ * counts it as held until hubx_frame_release(); XFrame frees its pool
+ * when the grabber stops, so stopping waits for the count to reach zero.
+ */
+struct hubx_device_t : public HX::IXImgSink {
+    std::mutex mutex;                   ///< Open/close, start/stop, callbacks
+    HX::XDetector detector;
+    HX::XControl control;
+    HX::XFrame frame;                   ///< Declared before the grabber, which uses it
+    HX::XGrabber grabber;
+    hubx_callbacks_t callbacks;
+    bool acquiring;                     ///< Grabber running or stop not finished
+    std::atomic<bool> accepting;        ///< Frames go to the callback
+    std::atomic<uint64_t> sequence;
+
+    std::mutex heldMutex;
+    std::condition_variable released;
+    uint32_t held;                      ///< Frames delivered and not released
+
+    hubx_device_t()
+        : acquiring(false),
+          accepting(false),
+          sequence(0),
+          held(0)
+    {
+        callbacks.frame = nullptr;
+        callbacks.error = nullptr;
+        callbacks.event = nullptr;
+        callbacks.user = nullptr;
+    }
+
+    void OnXError(uint32_t err_id, const char* err_msg_) override {
+        if (callbacks.error) {
+            callbacks.error(err_id, err_msg_ ? err_msg_ : "", callbacks.user);
+        }
+    }
+
+    void OnXEvent(uint32_t event_id, uint32_t data) override {
+        if (callbacks.event) {
+            callbacks.event(event_id, data, callbacks.user);
+        }
+    }
+
+    void OnFrameReady(HX::XImage* image_) override {
+        if (!accepting || !callbacks.frame) {
+            frame.Release(image_);
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(heldMutex);
+            held++;
+        }
+        hubx_frame_t info;
+        info.data = image_->_data_ + image_->_data_offset;
+        info.token = image_;
+        info.sequence = sequence++;
+        info.width = image_->_width;
+        info.height = image_->_height;
+        info.stride = image_->_stride;
+        info.pixelDepth = image_->_pixel_depth;
+        info.bytesPerPixel = (image_->_pixel_depth + 7u) / 8u;
+        info.reserved = 0;
+        callbacks.frame(&info, callbacks.user);
+    }
+
+    void release(HX::XImage* image) {
+        frame.Release(image);
+        std::lock_guard<std::mutex> lock(heldMutex);
+        if (held > 0) {
+            held--;
+        }
+        if (held == 0) {
+            released.notify_all();
+        }
+    }
+
+    /// Caller holds mutex
+    int stop(uint32_t timeoutMs) {
+        if (!acquiring) {
+            return HUBX_SUCCESS;
+        }
+        accepting = false;
+        {
+            std::unique_lock<std::mutex> lock(heldMutex);
+            if (!released.wait_for(lock, std::chrono::milliseconds(timeoutMs),
+                                   [this] { return held == 0; })) {
+                return HUBX_ERROR_BUSY;
+            }
+        }
+        grabber.Stop();
+        grabber.Close();
+        acquiring = false;
+        return HUBX_SUCCESS;
+    }
+};
+
+// C-style API
+extern "C" {
+
+hubx_device_t* hubx_device_create(const hubx_detector_config_t* config) {
+    if (!config || !config->ip || config->pixelCount == 0 || config->moduleCount == 0 ||
+        config->moduleCount > 0xFF || config->pixelDepth == 0 || config->pixelDepth > 32) {
+        return nullptr;
+    }
+    hubx_device_t* handle = new (std::nothrow) hubx_device_t();
+    if (!handle) {
+        return nullptr;
+    }
+    handle->detector.SetIP(config->ip);
+    handle->detector.SetCmdPort(config->cmdPort);
+    handle->detector.SetImgPort(config->imgPort);
+    handle->detector.SetMAC(config->mac);
+    handle->detector.SetSerialNum(config->serial ? config->serial : "");
+    handle->detector.SetPixelCount(config->pixelCount);
+    handle->detector.SetModuleCount(static_cast<uint8_t>(config->moduleCount));
+    handle->detector.SetPixelDepth(static_cast<uint8_t>(config->pixelDepth));
+    return handle;
+}
+
+void hubx_device_destroy(hubx_device_t* handle) {
+    if (!handle) {
+        return;
+    }
+    hubx_device_close(handle);
+    delete handle;
+}
+
+int hubx_device_open(hubx_device_t* handle) {
+    if (!handle) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    if (handle->control.IsOpen()) {
+        return HUBX_SUCCESS;
+    }
+    return handle->control.Open(handle->detector) ? HUBX_SUCCESS : HUBX_ERROR_DEVICE;
+}
+
+void hubx_device_close(hubx_device_t* handle) {
+    if (!handle) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    while (handle->stop(1000) == HUBX_ERROR_BUSY) {
+        // Frames still held by the caller: the pool must outlive them
+    }
+    handle->control.Close();
+}
+
+int hubx_control_read(hubx_device_t* handle, int code, uint8_t index, uint64_t* value) {
+    if (!handle || !value) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    if (!validCode(code)) {
+        return HUBX_ERROR_INVALID_PARAM;
+    }
+    return controlResult(handle->control.Read(static_cast<HX::XControl::XCode>(code), *value, index));
+}
+
+int hubx_control_write(hubx_device_t* handle, int code, uint64_t value, uint8_t index) {
+    if (!handle) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    if (!validCode(code)) {
+        return HUBX_ERROR_INVALID_PARAM;
+    }
+    return controlResult(handle->control.Write(static_cast<HX::XControl::XCode>(code), value, index));
+}
+
+int hubx_control_operate(hubx_device_t* handle, int code, uint64_t data) {
+    if (!handle) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    if (!validCode(code)) {
+        return HUBX_ERROR_INVALID_PARAM;
+    }
+    return controlResult(handle->control.Operate(static_cast<HX::XControl::XCode>(code), data));
+}
+
+int hubx_acq_set_callbacks(hubx_device_t* handle, const hubx_callbacks_t* callbacks) {
+    if (!handle || !callbacks) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    if (handle->acquiring) {
+        return HUBX_ERROR_BUSY;
+    }
+    handle->callbacks = *callbacks;
+    return HUBX_SUCCESS;
+}
+
+int hubx_acq_start(hubx_device_t* handle, const hubx_acq_config_t* config) {
+    if (!handle || !config) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    if (config->linesPerFrame == 0 || config->poolSize < 2 || config->segments == 0) {
+        return HUBX_ERROR_INVALID_PARAM;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    if (handle->acquiring) {
+        return HUBX_ERROR_BUSY;
+    }
+    if (!handle->control.IsOpen()) {
+        return HUBX_ERROR_DEVICE;
+    }
+
+    handle->frame.SetLines(config->linesPerFrame);
+    if (!handle->frame.SetPoolSize(config->poolSize) || !handle->frame.SetSegments(config->segments)) {
+        return HUBX_ERROR_INVALID_PARAM;
+    }
+    handle->frame.SetSink(handle);
+    handle->grabber.SetSink(handle);
+    handle->grabber.SetFrame(handle->frame);
+    handle->grabber.SetHeader(config->lineHeader != 0);
+
+    handle->sequence = 0;
+    handle->accepting = true;
+    if (!handle->grabber.Open(handle->detector, handle->control)) {
+        handle->accepting = false;
+        return HUBX_ERROR_DEVICE;
+    }
+    if (!handle->grabber.Grab(config->frames)) {
+        handle->accepting = false;
+        handle->grabber.Close();
+        return HUBX_ERROR_DEVICE;
+    }
+    handle->acquiring = true;
+    return HUBX_SUCCESS;
+}
+
+int hubx_acq_stop(hubx_device_t* handle, uint32_t timeoutMs) {
+    if (!handle) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    return handle->stop(timeoutMs);
+}
+
+int hubx_frame_release(hubx_device_t* handle, void* token) {
+    if (!handle || !token) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    handle->release(static_cast<HX::XImage*>(token));
+    return HUBX_SUCCESS;
+}
+
+uint32_t hubx_acq_free_buffers(hubx_device_t* handle) {
+    return handle ? handle->frame.GetFreeBuffers() : 0;
+}
+
+} // extern "C"
@@ -11,20 +11,320 @@
 
 #include "xfactory.h"
 #include "xlibdll_wrapper/xlibdll_interface.h"
+#include "utils/cpu_features.h"
+#include "utils/thread_policy.h"
+#include "utils/thread_pool.h"
+#include "utils/host_profile.h"
+#include "utils/service_loop.h"
+#include "utils/overload.h"
+#include "utils/latency_trace.h"
+#include "utils/metrics.h"
+#include "utils/logger.h"
+#include "utils/mem_profile.h"
+#include "utils/mem_budget.h"
+#include "utils/perf_counters.h"
 #include <iostream>
 #include <memory>
 #include <mutex>
 #include <map>
 #include <vector>
 #include <cstring>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstdio>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
 
 namespace HX {
 
+// ============================================================================
+// Size-Class Block Pool
+// ============================================================================
+
+namespace {
+    // Payload capacity of class c is 64 << c bytes (64 B .. 128 MB)
+    const uint32_t NUM_SIZE_CLASSES = 22;
+    const uint16_t LARGE_BLOCK = 0xFFFF;
+    const uint16_t MAPPED_BLOCK = 0xFFFE;     // AllocateEx: own pages, never pooled, header on the side
+    
+    const uint32_t BLOCK_MAGIC = 0x48584D42;   // "HXMB"
+    const uint32_t FREED_MAGIC = 0x48584644;   // "HXFD"
+    
+    /**
+     * @brief Header in front of every XFactory block
+     *
+     * 64 bytes so payloads keep malloc alignment and never share the
+     * header's cache line. Freeing needs nothing but the header.
+     */
+    struct BlockHeader {
+        uint32_t magic;
+        uint16_t sizeClass;
+        uint8_t  sampled;       ///< Recorded in the owner's tracking map
+        uint8_t  memTag;        ///< Profiling tag + 1, 0 = not charged
+        uint64_t size;          ///< Requested size
+        uint64_t mappedBytes;   ///< Mapping length (MAPPED_BLOCK only)
+        uint8_t  pad[40];
+    };
+    
+    static_assert(sizeof(BlockHeader) == 64, "BlockHeader must be one cache line");
+    
+    uint16_t sizeClassFor(size_t size) {
+        size_t capacity = 64;
+        for (uint16_t c = 0; c < NUM_SIZE_CLASSES; ++c, capacity <<= 1) {
+            if (size <= capacity) {
+                return c;
+            }
+        }
+        return LARGE_BLOCK;
+    }
+    
+    size_t classCapacity(uint16_t sizeClass) {
+        return size_t(64) << sizeClass;
+    }
+    
+    // Blocks a thread keeps per class before handing them to the shared pool;
+    // larger ones go straight there, where TrimMemory() can reach them
+    size_t threadCacheLimit(uint16_t sizeClass) {
+        size_t capacity = classCapacity(sizeClass);
+        if (capacity <= 64 * 1024) return 32;
+        if (capacity <= 1024 * 1024) return 8;
+        return 0;
+    }
+    
+    /**
+     * @brief Process-wide free lists, one lock per size class
+     */
+    struct SharedPool {
+        struct Bin {
+            std::mutex mutex;
+            std::vector<BlockHeader*> blocks;
+        };
+        Bin bins[NUM_SIZE_CLASSES];
+    };
+    
+    SharedPool& sharedPool() {
+        // Never destroyed: thread caches may flush into it during exit
+        static SharedPool* pool = new SharedPool();
+        return *pool;
+    }
+    
+    /**
+     * @brief Per-thread free lists; steady-state reuse takes no lock
+     */
+    struct ThreadCache {
+        std::vector<BlockHeader*> bins[NUM_SIZE_CLASSES];
+        uint32_t sampleTick;
+        
+        ThreadCache() : sampleTick(0) {}
+        
+        ~ThreadCache() {
+            SharedPool& pool = sharedPool();
+            for (uint32_t c = 0; c < NUM_SIZE_CLASSES; ++c) {
+                if (bins[c].empty()) {
+                    continue;
+                }
+                std::lock_guard<std::mutex> lock(pool.bins[c].mutex);
+                pool.bins[c].blocks.insert(pool.bins[c].blocks.end(),
+                                           bins[c].begin(), bins[c].end());
+            }
+        }
+    };
+    
+    ThreadCache& threadCache() {
+        static thread_local ThreadCache cache;
+        return cache;
+    }
+    
+    BlockHeader* takeBlock(uint16_t sizeClass, size_t size) {
+        if (sizeClass == LARGE_BLOCK) {
+            return static_cast<BlockHeader*>(malloc(sizeof(BlockHeader) + size));
+        }
+        
+        std::vector<BlockHeader*>& local = threadCache().bins[sizeClass];
+        if (!local.empty()) {
+            BlockHeader* block = local.back();
+            local.pop_back();
+            return block;
+        }
+        
+        SharedPool::Bin& bin = sharedPool().bins[sizeClass];
+        {
+            std::lock_guard<std::mutex> lock(bin.mutex);
+            if (!bin.blocks.empty()) {
+                BlockHeader* block = bin.blocks.back();
+                bin.blocks.pop_back();
+                return block;
+            }
+        }
+        
+        return static_cast<BlockHeader*>(malloc(sizeof(BlockHeader) + classCapacity(sizeClass)));
+    }
+    
+    /// Charge a new block to the allocating thread's profiling tag
+    void chargeBlock(BlockHeader* block) {
+        block->memTag = 0;
+        if (Internal::MemProfiling()) {
+            XFactory::MemoryTag tag = Internal::MemCurrentTag(XFactory::MEM_OTHER);
+            Internal::MemProfileAlloc(tag, block->size);
+            block->memTag = static_cast<uint8_t>(tag + 1);
+        }
+    }
+    
+    void unmapBlock(void* base, size_t mapped) {
+#ifdef _WIN32
+        (void)mapped;
+        VirtualFree(base, 0, MEM_RELEASE);
+#else
+        munmap(base, mapped);
+#endif
+    }
+    
+    /**
+     * @brief Map pages for AllocateEx with the requested placement
+     * @param bytes Payload; it starts at the mapping base, on a page boundary
+     * @param options Page size, NUMA node and pre-fault request
+     * @param mapped Output mapping length
+     * @return Mapping base, nullptr on failure
+     */
+    void* mapBlock(size_t bytes, const XFactory::AllocOptions& options, size_t& mapped) {
+        size_t page = (options.pageSize > 0) ? options.pageSize : 4096;
+        mapped = ((bytes + page - 1) / page) * page;
+        void* base = nullptr;
+        
+#ifdef _WIN32
+        DWORD type = MEM_RESERVE | MEM_COMMIT;
+        if (options.pageSize > 0) {
+            // Needs SeLockMemoryPrivilege; sizes must be large-page multiples
+            SIZE_T large = GetLargePageMinimum();
+            if (large > 0) {
+                mapped = ((bytes + large - 1) / large) * large;
+                type |= MEM_LARGE_PAGES;
+            }
+        }
+        if (options.numaNode >= 0) {
+            base = VirtualAllocExNuma(GetCurrentProcess(), NULL, mapped, type,
+                                      PAGE_READWRITE, static_cast<DWORD>(options.numaNode));
+        } else {
+            base = VirtualAlloc(NULL, mapped, type, PAGE_READWRITE);
+        }
+        if (!base && (type & MEM_LARGE_PAGES)) {
+            HX_LOG_WARNING("XFactory") << "Large pages unavailable, using 4 KB pages";
+            mapped = ((bytes + 4095) / 4096) * 4096;
+            type &= ~MEM_LARGE_PAGES;
+            base = (options.numaNode >= 0)
+                ? VirtualAllocExNuma(GetCurrentProcess(), NULL, mapped, type,
+                                     PAGE_READWRITE, static_cast<DWORD>(options.numaNode))
+                : VirtualAlloc(NULL, mapped, type, PAGE_READWRITE);
+        }
+        if (!base) {
+            return nullptr;
+        }
+#else
+        int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+        
+#ifdef MAP_HUGETLB
+        if (options.pageSize > 0) {
+            int shift = 0;
+            while ((size_t(1) << shift) < page) {
+                ++shift;
+            }
+            // MAP_HUGE_SHIFT encoding: log2 of the huge page size
+            base = mmap(NULL, mapped, PROT_READ | PROT_WRITE,
+                        flags | MAP_HUGETLB | (shift << 26), -1, 0);
+            if (base == MAP_FAILED) {
+                HX_LOG_WARNING("XFactory") << "No " << (page >> 20)
+                                           << " MB huge pages reserved, using transparent huge pages";
+                base = nullptr;
+            }
+        }
+#endif
+        
+        if (!base) {
+            mapped = ((bytes + 4095) / 4096) * 4096;
+            base = mmap(NULL, mapped, PROT_READ | PROT_WRITE, flags, -1, 0);
+            if (base == MAP_FAILED) {
+                return nullptr;
+            }
+#ifdef MADV_HUGEPAGE
+            if (options.pageSize > 0) {
+                madvise(base, mapped, MADV_HUGEPAGE);
+            }
+#endif
+        }
+        
+#ifdef SYS_mbind
+        if (options.numaNode >= 0 && options.numaNode < 64) {
+            // MPOL_BIND before first touch so every page lands on the node
+            const int MPOL_BIND_MODE = 2;
+            unsigned long nodemask = 1UL << options.numaNode;
+            if (syscall(SYS_mbind, base, mapped, MPOL_BIND_MODE, &nodemask,
+                        sizeof(nodemask) * 8, 0) != 0) {
+                HX_LOG_WARNING("XFactory") << "Failed to bind memory to NUMA node "
+                                           << options.numaNode;
+            }
+        }
+#endif
+#endif
+        
+        if (options.prefault) {
+            // Take every page fault now instead of on the acquisition path
+            volatile uint8_t* bytesOut = static_cast<uint8_t*>(base);
+            for (size_t offset = 0; offset < mapped; offset += 4096) {
+                bytesOut[offset] = 0;
+            }
+        }
+        
+        if (options.lock) {
+            // Unlocked pages still work, only slower to hand to a device
+#ifdef _WIN32
+            const bool locked = VirtualLock(base, mapped) != 0;
+#else
+            const bool locked = mlock(base, mapped) == 0;
+#endif
+            if (!locked) {
+                HX_LOG_WARNING("XFactory") << "Failed to lock " << (mapped >> 10)
+                                           << " KB in memory, pages stay pageable";
+            }
+        }
+        
+        return base;
+    }
+    
+    void returnBlock(BlockHeader* block) {
+        uint16_t sizeClass = block->sizeClass;
+        if (sizeClass == LARGE_BLOCK) {
+            free(block);
+            return;
+        }
+        
+        std::vector<BlockHeader*>& local = threadCache().bins[sizeClass];
+        if (local.size() < threadCacheLimit(sizeClass)) {
+            local.push_back(block);
+            return;
+        }
+        
+        SharedPool::Bin& bin = sharedPool().bins[sizeClass];
+        std::lock_guard<std::mutex> lock(bin.mutex);
+        bin.blocks.push_back(block);
+    }
+}
+
 // ============================================================================
 // Internal Implementation (PIMPL Pattern)
 // ============================================================================
 
-class XFactory::Impl {
+class XFactory::Impl : public Internal::MetricsCollector {
 public:
     Impl();
     ~Impl();
@@ -35,31 +335,44 @@ public:
     
     // Memory pool management
     void* allocateMemory(size_t size);
+    void* allocateMemory(size_t size, const XFactory::AllocOptions& options);
     void freeMemory(void* ptr);
+    bool freeMapped(void* ptr);
+    void releaseBlock(void* ptr, const BlockHeader& block);
+    static uint64_t trimPools();
     
     // Statistics
     uint64_t getTotalAllocatedMemory() const { return m_totalAllocated; }
     uint32_t getAllocationCount() const { return m_allocationCount; }
+    void setTrackingSampleRate(uint32_t rate) { m_sampleRate = rate; }
+    uint32_t getTrackingSampleRate() const { return m_sampleRate; }
     
     // Resource tracking
     void registerResource(const std::string& name, void* resource);
     void unregisterResource(const std::string& name);
     bool hasResource(const std::string& name) const;
     void* getResource(const std::string& name);
+    
+    void collectMetrics(Internal::MetricsWriter& out) override;
 
 private:
     bool m_initialized;
     mutable std::mutex m_mutex;
     
-    // Memory tracking
+    // Memory tracking: counters for every block, map for sampled blocks only
     struct MemoryBlock {
         size_t size;
         void* ptr;
         uint64_t allocTime;
     };
     std::map<void*, MemoryBlock> m_allocations;
-    uint64_t m_totalAllocated;
-    uint32_t m_allocationCount;
+    
+    // AllocateEx blocks: headers kept here, so payloads start on a page
+    std::mutex m_mappedMutex;
+    std::map<void*, BlockHeader> m_mapped;
+    std::atomic<uint64_t> m_totalAllocated;
+    std::atomic<uint32_t> m_allocationCount;
+    std::atomic<uint32_t> m_sampleRate;     ///< Record 1 in N blocks (0 = none)
     
     // Resource registry
     std::map<std::string, void*> m_resources;
@@ -67,46 +380,74 @@ private:
     // Configuration
     size_t m_maxMemoryLimit;
     bool m_enableMemoryTracking;
+    
+    Internal::MetricLabels m_metricLabels;
 };
 
 XFactory::Impl::Impl()
     : m_initialized(false)
     , m_totalAllocated(0)
     , m_allocationCount(0)
+    , m_sampleRate(64)
     , m_maxMemoryLimit(0) // 0 means unlimited
     , m_enableMemoryTracking(true)
 {
+    m_metricLabels.add("factory", std::to_string(Internal::MetricsRegistry::instance().nextInstance()));
+    Internal::MetricsRegistry::instance().addCollector(this);
 }
 
 XFactory::Impl::~Impl() {
+    Internal::MetricsRegistry::instance().removeCollector(this);
     cleanup();
 }
 
+void XFactory::Impl::collectMetrics(Internal::MetricsWriter& out) {
+    out.gauge("hubx_memory_allocated_bytes", "Bytes allocated through an XFactory and not freed",
+              m_metricLabels, static_cast<double>(m_totalAllocated.load()));
+    out.gauge("hubx_memory_allocations", "Live XFactory allocations",
+              m_metricLabels, m_allocationCount.load());
+}
+
 bool XFactory::Impl::initialize() {
     std::lock_guard<std::mutex> lock(m_mutex);
     
     if (m_initialized) {
-        std::cout << "[XFactory] Already initialized" << std::endl;
+        HX_LOG_INFO("XFactory") << "Already initialized";
         return true;
     }
     
-    std::cout << "[XFactory] Initializing..." << std::endl;
+    HX_LOG_INFO("XFactory") << "Initializing...";
     
     // Initialize xlibdll proxy - THIS IS CRITICAL
     if (!Internal::XLibProxy_Initialize()) {
-        std::cerr << "[XFactory] ERROR: Failed to initialize xlibdll proxy" << std::endl;
-        std::cerr << "[XFactory] Make sure xlibdll.dll is in the correct path" << std::endl;
+        HX_LOG_ERROR("XFactory") << "Failed to initialize xlibdll proxy";
+        HX_LOG_ERROR("XFactory") << "Make sure xlibdll.dll is in the correct path";
         return false;
     }
     
-    std::cout << "[XFactory] xlibdll proxy initialized successfully" << std::endl;
-    std::cout << "[XFactory] xlibdll.dll is now hidden and encapsulated" << std::endl;
+    HX_LOG_INFO("XFactory") << "xlibdll proxy initialized successfully";
+    HX_LOG_INFO("XFactory") << "xlibdll.dll is now hidden and encapsulated";
+    
+    // Settings tuned for this host, before anything is dispatched
+    const char* profileFile = std::getenv(Internal::HOST_PROFILE_ENV);
+    if (!profileFile) {
+        profileFile = Internal::HOST_PROFILE_FILE;
+    }
+    std::FILE* profile = profileFile[0] ? std::fopen(profileFile, "r") : nullptr;
+    if (profile) {
+        std::fclose(profile);
+        // A profile that fails to load leaves the built-in defaults
+        XFactory::LoadHostProfile(profileFile);
+    }
+    
+    // Detect once here rather than on the first frame
+    Internal::CpuDispatchLog();
     
     m_initialized = true;
     m_totalAllocated = 0;
     m_allocationCount = 0;
     
-    std::cout << "[XFactory] Initialization complete" << std::endl;
+    HX_LOG_INFO("XFactory") << "Initialization complete";
     
     return true;
 }
@@ -118,41 +459,39 @@ void XFactory::Impl::cleanup() {
         return;
     }
     
-    std::cout << "[XFactory] Cleaning up..." << std::endl;
+    HX_LOG_INFO("XFactory") << "Cleaning up...";
     
-    // Report memory leaks
-    if (!m_allocations.empty()) {
-        std::cerr << "[XFactory] WARNING: " << m_allocations.size() 
-                  << " memory blocks not freed!" << std::endl;
-        std::cerr << "[XFactory] Total leaked memory: " 
-                  << m_totalAllocated << " bytes" << std::endl;
+    // Report memory leaks; blocks may still be in use, so they are not freed
+    if (m_allocationCount > 0) {
+        HX_LOG_WARNING("XFactory") << m_allocationCount
+                                   << " memory blocks not freed!";
+        HX_LOG_WARNING("XFactory") << "Total leaked memory: " 
+                                   << m_totalAllocated << " bytes";
         
-        // Force cleanup of leaked memory
         for (auto& pair : m_allocations) {
-            std::cerr << "[XFactory] Freeing leaked block: " 
-                      << pair.second.size << " bytes at " 
-                      << pair.first << std::endl;
-            free(pair.first);
+            HX_LOG_WARNING("XFactory") << "Leaked block (sampled): " 
+                                       << pair.second.size << " bytes at " 
+                                       << pair.first;
         }
         m_allocations.clear();
     }
     
     // Clear resource registry
     if (!m_resources.empty()) {
-        std::cerr << "[XFactory] WARNING: " << m_resources.size() 
-                  << " resources still registered" << std::endl;
+        HX_LOG_WARNING("XFactory") << m_resources.size() 
+                                   << " resources still registered";
         m_resources.clear();
     }
     
     // Cleanup xlibdll proxy
     Internal::XLibProxy_Cleanup();
-    std::cout << "[XFactory] xlibdll proxy cleaned up" << std::endl;
+    HX_LOG_INFO("XFactory") << "xlibdll proxy cleaned up";
     
     m_initialized = false;
     m_totalAllocated = 0;
     m_allocationCount = 0;
     
-    std::cout << "[XFactory] Cleanup complete" << std::endl;
+    HX_LOG_INFO("XFactory") << "Cleanup complete";
 }
 
 void* XFactory::Impl::allocateMemory(size_t size) {
@@ -160,66 +499,176 @@ void* XFactory::Impl::allocateMemory(size_t size) {
         return nullptr;
     }
     
-    std::lock_guard<std::mutex> lock(m_mutex);
-    
-    // Check memory limit
-    if (m_maxMemoryLimit > 0 && 
-        (m_totalAllocated + size) > m_maxMemoryLimit) {
-        std::cerr << "[XFactory] ERROR: Memory limit exceeded" << std::endl;
+    // Reserve against the limit without taking a lock
+    uint64_t previous = m_totalAllocated.fetch_add(size, std::memory_order_relaxed);
+    if (m_maxMemoryLimit > 0 && previous + size > m_maxMemoryLimit) {
+        m_totalAllocated.fetch_sub(size, std::memory_order_relaxed);
+        HX_LOG_ERROR("XFactory") << "Memory limit exceeded";
         return nullptr;
     }
     
-    // Allocate memory
-    void* ptr = malloc(size);
-    if (!ptr) {
-        std::cerr << "[XFactory] ERROR: Failed to allocate " 
-                  << size << " bytes" << std::endl;
+    uint16_t sizeClass = sizeClassFor(size);
+    BlockHeader* block = takeBlock(sizeClass, size);
+    if (!block) {
+        m_totalAllocated.fetch_sub(size, std::memory_order_relaxed);
+        HX_LOG_ERROR("XFactory") << "Failed to allocate " 
+                                 << size << " bytes";
         return nullptr;
     }
     
-    // Track allocation
-    if (m_enableMemoryTracking) {
-        MemoryBlock block;
-        block.size = size;
-        block.ptr = ptr;
-        block.allocTime = std::chrono::system_clock::now().time_since_epoch().count();
+    block->magic = BLOCK_MAGIC;
+    block->sizeClass = sizeClass;
+    block->size = size;
+    block->sampled = 0;
+    chargeBlock(block);
+    
+    void* ptr = block + 1;
+    m_allocationCount.fetch_add(1, std::memory_order_relaxed);
+    
+    // Only sampled blocks pay for the map and the lock
+    uint32_t rate = m_sampleRate.load(std::memory_order_relaxed);
+    if (m_enableMemoryTracking && rate > 0 && (threadCache().sampleTick++ % rate) == 0) {
+        MemoryBlock info;
+        info.size = size;
+        info.ptr = ptr;
+        info.allocTime = std::chrono::steady_clock::now().time_since_epoch().count();
         
-        m_allocations[ptr] = block;
-        m_totalAllocated += size;
-        m_allocationCount++;
+        block->sampled = 1;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_allocations[ptr] = info;
     }
     
     return ptr;
 }
 
+void* XFactory::Impl::allocateMemory(size_t size, const XFactory::AllocOptions& options) {
+    if (options.numaNode < 0 && options.pageSize == 0 && !options.prefault) {
+        return allocateMemory(size);
+    }
+    
+    if (size == 0) {
+        return nullptr;
+    }
+    
+    if (options.pageSize != 0 && options.pageSize != XFactory::PAGE_2MB &&
+        options.pageSize != XFactory::PAGE_1GB) {
+        HX_LOG_ERROR("XFactory") << "Unsupported page size " << options.pageSize;
+        return nullptr;
+    }
+    
+    uint64_t previous = m_totalAllocated.fetch_add(size, std::memory_order_relaxed);
+    if (m_maxMemoryLimit > 0 && previous + size > m_maxMemoryLimit) {
+        m_totalAllocated.fetch_sub(size, std::memory_order_relaxed);
+        HX_LOG_ERROR("XFactory") << "Memory limit exceeded";
+        return nullptr;
+    }
+    
+    size_t mapped = 0;
+    void* base = mapBlock(size, options, mapped);
+    if (!base) {
+        m_totalAllocated.fetch_sub(size, std::memory_order_relaxed);
+        HX_LOG_ERROR("XFactory") << "Failed to map " 
+                                 << size << " bytes";
+        return nullptr;
+    }
+    
+    BlockHeader block = BlockHeader();
+    block.magic = BLOCK_MAGIC;
+    block.sizeClass = MAPPED_BLOCK;
+    block.size = size;
+    block.mappedBytes = mapped;
+    block.sampled = 0;
+    chargeBlock(&block);
+    {
+        std::lock_guard<std::mutex> lock(m_mappedMutex);
+        m_mapped[base] = block;
+    }
+    
+    m_allocationCount.fetch_add(1, std::memory_order_relaxed);
+    return base;
+}
+
+bool XFactory::Impl::freeMapped(void* ptr) {
+    BlockHeader block;
+    {
+        std::lock_guard<std::mutex> lock(m_mappedMutex);
+        std::map<void*, BlockHeader>::iterator it = m_mapped.find(ptr);
+        if (it == m_mapped.end()) {
+            return false;
+        }
+        block = it->second;
+        m_mapped.erase(it);
+    }
+    releaseBlock(ptr, block);
+    unmapBlock(ptr, block.mappedBytes);
+    return true;
+}
+
+void XFactory::Impl::releaseBlock(void* ptr, const BlockHeader& block) {
+    if (block.sampled) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_allocations.erase(ptr);
+    }
+    
+    m_totalAllocated.fetch_sub(block.size, std::memory_order_relaxed);
+    m_allocationCount.fetch_sub(1, std::memory_order_relaxed);
+    if (block.memTag) {
+        Internal::MemProfileFree(static_cast<XFactory::MemoryTag>(block.memTag - 1), block.size);
+    }
+}
+
 void XFactory::Impl::freeMemory(void* ptr) {
     if (!ptr) {
         return;
     }
     
-    std::lock_guard<std::mutex> lock(m_mutex);
+    // Only a page-aligned pointer can be an AllocateEx block
+    if ((reinterpret_cast<uintptr_t>(ptr) & 4095) == 0 && freeMapped(ptr)) {
+        return;
+    }
     
-    // Update tracking
-    if (m_enableMemoryTracking) {
-        auto it = m_allocations.find(ptr);
-        if (it != m_allocations.end()) {
-            m_totalAllocated -= it->second.size;
-            m_allocations.erase(it);
-        } else {
-            std::cerr << "[XFactory] WARNING: Freeing untracked memory at " 
-                      << ptr << std::endl;
+    BlockHeader* block = static_cast<BlockHeader*>(ptr) - 1;
+    if (block->magic != BLOCK_MAGIC) {
+        HX_LOG_WARNING("XFactory") << "Freeing "
+                                   << (block->magic == FREED_MAGIC ? "already freed" : "untracked")
+                                   << " memory at " << ptr;
+        return;
+    }
+    
+    releaseBlock(ptr, *block);
+    block->magic = FREED_MAGIC;
+    returnBlock(block);
+}
+
+uint64_t XFactory::Impl::trimPools() {
+    // Other threads' caches stay with them; the caller's goes with the shared lists
+    SharedPool& pool = sharedPool();
+    ThreadCache& local = threadCache();
+    uint64_t released = 0;
+    
+    for (uint16_t c = 0; c < NUM_SIZE_CLASSES; ++c) {
+        std::vector<BlockHeader*> blocks;
+        blocks.swap(local.bins[c]);
+        {
+            std::lock_guard<std::mutex> lock(pool.bins[c].mutex);
+            blocks.insert(blocks.end(), pool.bins[c].blocks.begin(), pool.bins[c].blocks.end());
+            pool.bins[c].blocks.clear();
+        }
+        for (size_t i = 0; i < blocks.size(); ++i) {
+            free(blocks[i]);
         }
+        released += blocks.size() * (sizeof(BlockHeader) + classCapacity(c));
     }
     
-    free(ptr);
+    return released;
 }
 
 void XFactory::Impl::registerResource(const std::string& name, void* resource) {
     std::lock_guard<std::mutex> lock(m_mutex);
     
     if (m_resources.find(name) != m_resources.end()) {
-        std::cerr << "[XFactory] WARNING: Resource '" << name 
-                  << "' already registered, overwriting" << std::endl;
+        HX_LOG_WARNING("XFactory") << "Resource '" << name 
+                                   << "' already registered, overwriting";
     }
     
     m_resources[name] = resource;
@@ -254,6 +703,9 @@ void* XFactory::Impl::getResource(const std::string& name) {
 // XFactory Public Interface Implementation
 // ============================================================================
 
+const uint32_t XFactory::PAGE_2MB;
+const uint32_t XFactory::PAGE_1GB;
+
 XFactory::XFactory()
     : m_impl(new Impl())
 {
@@ -294,6 +746,13 @@ void* XFactory::Allocate(size_t size) {
     return m_impl->allocateMemory(size);
 }
 
+void* XFactory::AllocateEx(size_t size, const AllocOptions& options) {
+    if (!m_impl) {
+        return nullptr;
+    }
+    return m_impl->allocateMemory(size, options);
+}
+
 void XFactory::Free(void* ptr) {
     if (m_impl) {
         m_impl->freeMemory(ptr);
@@ -340,6 +799,23 @@ void* XFactory::GetResource(const std::string& name) {
     return m_impl->getResource(name);
 }
 
+void XFactory::SetTrackingSampleRate(uint32_t rate) {
+    if (m_impl) {
+        m_impl->setTrackingSampleRate(rate);
+    }
+}
+
+uint32_t XFactory::GetTrackingSampleRate() const {
+    if (!m_impl) {
+        return 0;
+    }
+    return m_impl->getTrackingSampleRate();
+}
+
+uint64_t XFactory::TrimMemory() {
+    return Impl::trimPools();
+}
+
 void XFactory::PrintStatistics() const {
     if (!m_impl) {
         return;
@@ -385,4 +861,456 @@ void XFactory::DestroyGlobalInstance() {
     }
 }
 
+// ============================================================================
+// Thread Policy (process-wide)
+// ============================================================================
+
+namespace {
+    struct ThreadRoleState {
+        XFactory::ThreadPolicy policy;
+        uint64_t effectiveMask;
+        bool realtimeActive;
+        
+        ThreadRoleState() : effectiveMask(0), realtimeActive(false) {}
+    };
+    
+    ThreadRoleState g_threadRoles[XFactory::THREAD_ROLE_COUNT];
+    std::mutex g_threadPolicyMutex;
+    
+    const char* threadRoleName(XFactory::ThreadRole role) {
+        switch (role) {
+            case XFactory::THREAD_RECEIVE:   return "receive";
+            case XFactory::THREAD_ASSEMBLY:  return "assembly";
+            case XFactory::THREAD_HEARTBEAT: return "heartbeat";
+            case XFactory::THREAD_CORRECTION: return "correction";
+            case XFactory::THREAD_RECORDER:  return "recorder";
+            case XFactory::THREAD_SERVICE:   return "service";
+            default:                         return "unknown";
+        }
+    }
+}
+
+bool XFactory::SetThreadPolicy(ThreadRole role, const ThreadPolicy& policy) {
+    if (role < 0 || role >= THREAD_ROLE_COUNT) {
+        return false;
+    }
+    
+    std::lock_guard<std::mutex> lock(g_threadPolicyMutex);
+    g_threadRoles[role].policy = policy;
+    return true;
+}
+
+XFactory::ThreadPolicy XFactory::GetThreadPolicy(ThreadRole role) {
+    if (role < 0 || role >= THREAD_ROLE_COUNT) {
+        return ThreadPolicy();
+    }
+    
+    std::lock_guard<std::mutex> lock(g_threadPolicyMutex);
+    return g_threadRoles[role].policy;
+}
+
+uint64_t XFactory::GetEffectiveAffinity(ThreadRole role) {
+    if (role < 0 || role >= THREAD_ROLE_COUNT) {
+        return 0;
+    }
+    
+    std::lock_guard<std::mutex> lock(g_threadPolicyMutex);
+    return g_threadRoles[role].effectiveMask;
+}
+
+bool XFactory::IsRealtimeActive(ThreadRole role) {
+    if (role < 0 || role >= THREAD_ROLE_COUNT) {
+        return false;
+    }
+    
+    std::lock_guard<std::mutex> lock(g_threadPolicyMutex);
+    return g_threadRoles[role].realtimeActive;
+}
+
+void XFactory::SetCorrectionThreads(uint32_t count) {
+    Internal::ThreadPool::instance().setThreadCount(count);
+}
+
+uint32_t XFactory::GetCorrectionThreads() {
+    return Internal::ThreadPool::instance().threadCount();
+}
+
+void XFactory::SetScheduler(const SchedulerConfig& config) {
+    Internal::ThreadPool::instance().configure(config.threads, config.cpuMask, config.numaAware);
+    Internal::ThreadPool::instance().setBandPixels(config.bandPixels);
+}
+
+XFactory::SchedulerConfig XFactory::GetScheduler() {
+    SchedulerConfig config;
+    Internal::ThreadPool::instance().configuration(config.threads, config.cpuMask, config.numaAware);
+    config.bandPixels = Internal::ThreadPool::instance().bandPixels();
+    return config;
+}
+
+void XFactory::SetTaskPriority(TaskPriority priority) {
+    if (priority >= 0 && priority < TASK_PRIORITY_COUNT) {
+        Internal::ThreadPool::setPriority(static_cast<int>(priority));
+    }
+}
+
+XFactory::TaskPriority XFactory::GetTaskPriority() {
+    return static_cast<TaskPriority>(Internal::ThreadPool::priority());
+}
+
+bool XFactory::SetOverloadPolicy(const OverloadPolicy& policy) {
+    return Internal::OverloadSetPolicy(policy);
+}
+
+XFactory::OverloadPolicy XFactory::GetOverloadPolicy() {
+    return Internal::OverloadGetPolicy();
+}
+
+void XFactory::GetOverloadStats(OverloadStats& stats) {
+    Internal::OverloadGetStats(stats);
+}
+
+void XFactory::ResetOverloadStats() {
+    Internal::OverloadResetStats();
+}
+
+bool XFactory::SetServiceThreads(uint32_t count) {
+    return Internal::ServiceLoop::instance().setThreadCount(count);
+}
+
+uint32_t XFactory::GetServiceThreads() {
+    return Internal::ServiceLoop::instance().threadCount();
+}
+
+void XFactory::SetTracing(bool enable) {
+    Internal::TraceSetEnabled(enable);
+}
+
+bool XFactory::GetTracing() {
+    return Internal::TraceEnabled();
+}
+
+bool XFactory::GetTraceStats(TraceStage stage, TraceStats& stats) {
+    return Internal::TraceGetStats(stage, stats);
+}
+
+void XFactory::ResetTraceStats() {
+    Internal::TraceResetStats();
+}
+
+bool XFactory::StartTraceCapture(uint32_t events) {
+    return Internal::TraceStartCapture(events);
+}
+
+void XFactory::StopTraceCapture() {
+    Internal::TraceStopCapture();
+}
+
+bool XFactory::WriteTraceCapture(const std::string& file) {
+    return Internal::TraceWriteCapture(file);
+}
+
+std::string XFactory::GetMetrics(MetricsFormat format) {
+    return Internal::MetricsRegistry::instance().render(format);
+}
+
+bool XFactory::GetMetric(const std::string& name, double& value) {
+    return Internal::MetricsRegistry::instance().value(name, value);
+}
+
+bool XFactory::StartMetricsServer(uint16_t port) {
+    return Internal::MetricsRegistry::instance().startServer(port);
+}
+
+void XFactory::StopMetricsServer() {
+    Internal::MetricsRegistry::instance().stopServer();
+}
+
+uint16_t XFactory::GetMetricsPort() {
+    return Internal::MetricsRegistry::instance().serverPort();
+}
+
+void XFactory::SetLogLevel(LogLevel level) {
+    Internal::g_logLevel.store(level, std::memory_order_relaxed);
+}
+
+XFactory::LogLevel XFactory::GetLogLevel() {
+    return static_cast<LogLevel>(Internal::g_logLevel.load(std::memory_order_relaxed));
+}
+
+void XFactory::SetLogSink(IXLogSink* sink) {
+    Internal::LogSetSink(sink);
+}
+
+void XFactory::SetLogRateLimit(uint32_t perSecond) {
+    Internal::LogSetRateLimit(perSecond);
+}
+
+void XFactory::FlushLog() {
+    Internal::LogFlush();
+}
+
+uint64_t XFactory::GetLogDropped() {
+    return Internal::LogDropped();
+}
+
+void XFactory::SetMemoryProfiling(bool enable) {
+    Internal::MemSetProfiling(enable);
+}
+
+bool XFactory::GetMemoryProfiling() {
+    return Internal::MemGetProfiling();
+}
+
+bool XFactory::GetMemoryStats(MemoryTag tag, MemoryStats& stats) {
+    return Internal::MemGetStats(tag, stats);
+}
+
+void XFactory::ResetMemoryStats() {
+    Internal::MemResetStats();
+}
+
+bool XFactory::SetMemoryBudget(uint64_t bytes, float reclaimAt) {
+    return Internal::MemBudgetSet(bytes, reclaimAt);
+}
+
+uint64_t XFactory::GetMemoryBudget() {
+    return Internal::MemBudgetGet();
+}
+
+void XFactory::GetMemoryBudgetStats(MemoryBudgetStats& stats) {
+    Internal::MemBudgetGetStats(stats);
+}
+
+bool XFactory::SetPerfCounters(bool enable) {
+    return Internal::PerfSetEnabled(enable);
+}
+
+bool XFactory::GetPerfCounters() {
+    return Internal::PerfEnabled();
+}
+
+bool XFactory::GetPerfStats(PerfStage stage, PerfStats& stats) {
+    return Internal::PerfGetStats(stage, stats);
+}
+
+void XFactory::ResetPerfStats() {
+    Internal::PerfResetStats();
+}
+
+uint32_t XFactory::GetCpuFeatures() {
+    return Internal::CpuDetected();
+}
+
+void XFactory::SetCpuFeatureMask(uint32_t mask) {
+    Internal::g_cpuMask.store(mask & CPU_ALL, std::memory_order_relaxed);
+    HX_LOG_INFO("XFactory") << "CPU feature mask 0x" << std::hex << (mask & CPU_ALL) << std::dec;
+}
+
+uint32_t XFactory::GetCpuFeatureMask() {
+    return Internal::g_cpuMask.load(std::memory_order_relaxed);
+}
+
+std::string XFactory::GetKernelDispatch() {
+    return Internal::CpuDispatchReport();
+}
+
+bool XFactory::SetHostProfile(const HostProfile& profile) {
+    std::string error;
+    if (!Internal::HostProfileValid(profile, error)) {
+        HX_LOG_ERROR("XFactory") << "Host profile rejected: " << error;
+        return false;
+    }
+    if (profile.correctionThreads > 0) {
+        SetCorrectionThreads(profile.correctionThreads);
+    }
+    Internal::ThreadPool::instance().setBandPixels(profile.bandPixels);
+    SetCpuFeatureMask(profile.cpuFeatureMask);
+    Internal::HostProfileSet(profile);
+    return true;
+}
+
+XFactory::HostProfile XFactory::GetHostProfile() {
+    return Internal::HostProfileGet();
+}
+
+bool XFactory::LoadHostProfile(const std::string& file) {
+    HostProfile profile;
+    std::string error;
+    if (!Internal::HostProfileRead(file, profile, error)) {
+        HX_LOG_ERROR("XFactory") << "Host profile not loaded: " << error;
+        return false;
+    }
+    if (!SetHostProfile(profile)) {
+        return false;
+    }
+    HX_LOG_INFO("XFactory") << "Host profile " << file << ": ring " << profile.ringDepth
+                            << ", batch " << profile.batchSize << ", pool " << profile.poolSize
+                            << ", threads " << profile.correctionThreads
+                            << ", band " << profile.bandPixels << " px";
+    return true;
+}
+
+bool XFactory::SaveHostProfile(const std::string& file, const HostProfile& profile) {
+    if (!Internal::HostProfileWrite(file, profile)) {
+        HX_LOG_ERROR("XFactory") << "Cannot write host profile " << file;
+        return false;
+    }
+    return true;
+}
+
+namespace Internal {
+
+bool ApplyThreadPolicy(XFactory::ThreadRole role) {
+    return ApplyThreadPolicy(role, 0);
+}
+
+bool ApplyThreadPolicy(XFactory::ThreadRole role, uint64_t cpuMask) {
+    if (role < 0 || role >= XFactory::THREAD_ROLE_COUNT) {
+        return false;
+    }
+    
+    XFactory::ThreadPolicy policy = XFactory::GetThreadPolicy(role);
+    if (cpuMask != 0) {
+        policy.cpuMask = cpuMask;
+    }
+    bool ok = true;
+    bool realtime = false;
+    uint64_t effective = 0;
+    
+#ifdef _WIN32
+    HANDLE thread = GetCurrentThread();
+    
+    if (policy.cpuMask != 0) {
+        if (SetThreadAffinityMask(thread, static_cast<DWORD_PTR>(policy.cpuMask)) == 0) {
+            HX_LOG_WARNING("XFactory") << "Failed to set " << threadRoleName(role)
+                                       << " thread affinity";
+            ok = false;
+        }
+    }
+    
+    // Windows has no per-thread affinity getter; set/restore reads it back
+    DWORD_PTR processMask = 0;
+    DWORD_PTR systemMask = 0;
+    if (GetProcessAffinityMask(GetCurrentProcess(), &processMask, &systemMask)) {
+        DWORD_PTR previous = SetThreadAffinityMask(thread, processMask);
+        if (previous != 0) {
+            SetThreadAffinityMask(thread, previous);
+            effective = static_cast<uint64_t>(previous);
+        }
+    }
+    
+    if (policy.realtime) {
+        if (SetThreadPriority(thread, THREAD_PRIORITY_TIME_CRITICAL)) {
+            realtime = true;
+        } else {
+            HX_LOG_WARNING("XFactory") << "Failed to set " << threadRoleName(role)
+                                       << " thread to TIME_CRITICAL";
+            ok = false;
+        }
+    }
+#else
+    pthread_t thread = pthread_self();
+    
+    if (policy.cpuMask != 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int cpu = 0; cpu < 64 && cpu < CPU_SETSIZE; ++cpu) {
+            if (policy.cpuMask & (1ULL << cpu)) {
+                CPU_SET(cpu, &set);
+            }
+        }
+        if (pthread_setaffinity_np(thread, sizeof(set), &set) != 0) {
+            HX_LOG_WARNING("XFactory") << "Failed to set " << threadRoleName(role)
+                                       << " thread affinity";
+            ok = false;
+        }
+    }
+    
+    cpu_set_t current;
+    CPU_ZERO(&current);
+    if (pthread_getaffinity_np(thread, sizeof(current), &current) == 0) {
+        for (int cpu = 0; cpu < 64 && cpu < CPU_SETSIZE; ++cpu) {
+            if (CPU_ISSET(cpu, &current)) {
+                effective |= (1ULL << cpu);
+            }
+        }
+    }
+    
+    if (policy.realtime) {
+        int minPrio = sched_get_priority_min(SCHED_FIFO);
+        int maxPrio = sched_get_priority_max(SCHED_FIFO);
+        
+        sched_param param;
+        std::memset(&param, 0, sizeof(param));
+        param.sched_priority = std::max(minPrio, std::min(maxPrio, static_cast<int>(policy.priority)));
+        
+        if (pthread_setschedparam(thread, SCHED_FIFO, &param) == 0) {
+            realtime = true;
+        } else {
+            HX_LOG_WARNING("XFactory") << "Failed to set " << threadRoleName(role)
+                                       << " thread to SCHED_FIFO (needs CAP_SYS_NICE)";
+            ok = false;
+        }
+    }
+#endif
+    
+    {
+        std::lock_guard<std::mutex> lock(g_threadPolicyMutex);
+        g_threadRoles[role].effectiveMask = effective;
+        g_threadRoles[role].realtimeActive = realtime;
+    }
+    
+    // Trace captures show the role instead of a bare thread number
+    TraceThreadName(threadRoleName(role));
+    
+    if (policy.cpuMask != 0 || policy.realtime) {
+        HX_LOG_INFO("XFactory") << threadRoleName(role) << " thread: affinity=0x"
+                                << std::hex << effective << std::dec
+                                << " realtime=" << (realtime ? "on" : "off");
+    }
+    
+    return ok;
+}
+
+int32_t CurrentCpu() {
+#ifdef _WIN32
+    return static_cast<int32_t>(GetCurrentProcessorNumber());
+#else
+    return sched_getcpu();
+#endif
+}
+
+int32_t CpuNode(int32_t cpu) {
+    if (cpu < 0) {
+        return -1;
+    }
+#ifdef _WIN32
+    UCHAR node = 0;
+    if (cpu > 255 || !GetNumaProcessorNode(static_cast<UCHAR>(cpu), &node)) {
+        return -1;
+    }
+    return node;
+#else
+    // The cpu directory links the node it belongs to as nodeN
+    char path[64];
+    std::snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d", cpu);
+    DIR* dir = opendir(path);
+    if (!dir) {
+        return -1;
+    }
+    int32_t node = -1;
+    while (dirent* entry = readdir(dir)) {
+        if (std::strncmp(entry->d_name, "node", 4) == 0 &&
+            entry->d_name[4] >= '0' && entry->d_name[4] <= '9') {
+            node = std::atoi(entry->d_name + 4);
+            break;
+        }
+    }
+    closedir(dir);
+    return node;
+#endif
+}
+
+} // namespace Internal
+
 } // namespace HX
\ No newline at end of file
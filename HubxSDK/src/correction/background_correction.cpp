@@ -8,12 +8,20 @@
  * Copyright (c) 2025
  */
 
+#include <cstdint>
+#include <cstdio>
 #include <cstring>
 #include <cmath>
 #include <algorithm>
+#include <atomic>
 #include <vector>
 #include <stdexcept>
 #include <memory>
+#include <mutex>
+#include <new>
+#include "../utils/calib_file.h"
+#include "../utils/thread_pool.h"
+#include "../utils/welford.h"
 
 // Error codes
 #define HUBX_SUCCESS 0
@@ -21,17 +29,35 @@
 #define HUBX_ERROR_NULL_POINTER -2
 #define HUBX_ERROR_BUFFER_SIZE -3
 #define HUBX_ERROR_CALCULATION -4
+#define HUBX_ERROR_NOT_CALIBRATED -5
 
 namespace HubxSDK {
 namespace Correction {
 
+namespace {
+
+// Calibration container tags (see utils/calib_file.h)
+const uint32_t CALIB_MODULE = HX::Internal::CalibTag('B', 'K', 'G', 'D');
+const uint32_t CALIB_META   = HX::Internal::CalibTag('M', 'E', 'T', 'A');
+const uint32_t CALIB_OFFSET = HX::Internal::CalibTag('O', 'F', 'F', 'S');
+
+} // namespace
+
 /**
  * @class BackgroundCorrection
  * @brief Handles background/offset correction for detector images
  */
 class BackgroundCorrection {
 public:
-    BackgroundCorrection() : m_initialized(false), m_width(0), m_height(0) {}
+    BackgroundCorrection()
+        : m_initialized(false), m_width(0), m_height(0), m_pixelCount(0),
+          m_driftEnabled(false), m_driftAlpha(0.0f), m_driftRowFirst(0),
+          m_driftRowCount(0), m_driftGap(0.0f), m_driftPending(false),
+          m_driftActive(0), m_driftSamples(0)
+    {
+        m_driftReaders[0] = 0;
+        m_driftReaders[1] = 0;
+    }
     
     ~BackgroundCorrection() {
         release();
@@ -54,6 +80,10 @@ public:
         
         // Allocate background offset buffer
         m_backgroundOffset.resize(m_pixelCount, 0.0f);
+
+        disableDriftTracking();
+        m_driftBuffers[0].assign(width, 0.0f);
+        m_driftBuffers[1].assign(width, 0.0f);
         
         m_initialized = true;
         return HUBX_SUCCESS;
@@ -99,6 +129,7 @@ public:
                 m_backgroundOffset[i] = static_cast<float>(accumulator[i] * invFrameCount);
             }
 
+            offsetChanged();
             return HUBX_SUCCESS;
         }
         catch (const std::exception&) {
@@ -147,6 +178,7 @@ public:
                 }
             }
 
+            offsetChanged();
             return HUBX_SUCCESS;
         }
         catch (const std::exception&) {
@@ -154,6 +186,93 @@ public:
         }
     }
 
+    /**
+     * @brief Add one background frame to the running average (streaming calibration)
+     * @param frame Frame data, width x height pixels
+     * @return HUBX_SUCCESS on success, error code otherwise
+     *
+     * @note Frames can be pushed straight from the frame callback; memory
+     *       stays at two doubles per pixel. Lines and frames cannot be mixed
+     *       before the next finalize.
+     */
+    int addBackgroundOffsetFrame(const unsigned short* frame) {
+        std::lock_guard<std::mutex> lock(m_accumulatorMutex);
+        if (!m_initialized) {
+            return HUBX_ERROR_INVALID_PARAM;
+        }
+        if (frame == nullptr) {
+            return HUBX_ERROR_NULL_POINTER;
+        }
+        if (!prepareAccumulator(m_pixelCount)) {
+            return HUBX_ERROR_INVALID_PARAM;
+        }
+
+        m_accumulator.add(frame);
+        return HUBX_SUCCESS;
+    }
+
+    /**
+     * @brief Add background lines to the running per-column average
+     * @param lines Contiguous line data, lineCount x lineWidth pixels
+     * @param lineCount Number of lines
+     * @param lineWidth Width of each line (must equal the image width)
+     * @return HUBX_SUCCESS on success, error code otherwise
+     */
+    int addBackgroundOffsetLines(const unsigned short* lines, int lineCount, int lineWidth) {
+        std::lock_guard<std::mutex> lock(m_accumulatorMutex);
+        if (!m_initialized || lineWidth != m_width || lineCount < 0) {
+            return HUBX_ERROR_INVALID_PARAM;
+        }
+        if (lines == nullptr) {
+            return HUBX_ERROR_NULL_POINTER;
+        }
+        if (!prepareAccumulator(m_width)) {
+            return HUBX_ERROR_INVALID_PARAM;
+        }
+
+        for (int line = 0; line < lineCount; ++line) {
+            m_accumulator.add(lines + static_cast<size_t>(line) * lineWidth);
+        }
+        return HUBX_SUCCESS;
+    }
+
+    /**
+     * @brief Store the running average as the offset and start a new calibration
+     * @return HUBX_SUCCESS on success, HUBX_ERROR_NOT_CALIBRATED if nothing was added
+     *
+     * @note A line average is replicated across the height
+     */
+    int finalizeBackgroundOffset() {
+        std::lock_guard<std::mutex> lock(m_accumulatorMutex);
+        if (!m_initialized) {
+            return HUBX_ERROR_INVALID_PARAM;
+        }
+        if (m_accumulator.count() == 0) {
+            return HUBX_ERROR_NOT_CALIBRATED;
+        }
+
+        const bool perLine = m_accumulator.pixels() != static_cast<size_t>(m_pixelCount);
+        for (int row = 0; row < m_height; ++row) {
+            for (int col = 0; col < m_width; ++col) {
+                int idx = row * m_width + col;
+                float mean = static_cast<float>(m_accumulator.mean(perLine ? col : idx));
+                m_backgroundOffset[idx] = mean;
+            }
+        }
+
+        m_accumulator.clear();
+        offsetChanged();
+        return HUBX_SUCCESS;
+    }
+
+    /**
+     * @brief Number of frames or lines added since the last finalize
+     */
+    int getBackgroundOffsetSampleCount() {
+        std::lock_guard<std::mutex> lock(m_accumulatorMutex);
+        return static_cast<int>(m_accumulator.count());
+    }
+
     /**
      * @brief Apply background correction to an image
      * @param input Input image data
@@ -175,22 +294,34 @@ public:
 
         const int maxValue = (1 << bitDepth) - 1;
 
+        // Offset drift published by the tracker, zero while tracking is off
+        DriftView drift(*this);
+
         try {
-            for (int i = 0; i < m_pixelCount; ++i) {
-                // Apply formula: y = k(x - x₀) + b
-                float corrected = gain * (static_cast<float>(input[i]) - m_backgroundOffset[i]) + bias;
-                
-                // Clamp to valid range
-                corrected = std::max(0.0f, std::min(static_cast<float>(maxValue), corrected));
-                
-                output[i] = static_cast<unsigned short>(corrected + 0.5f); // Round to nearest
-            }
+            // Row bands on the shared pool, pixels are independent
+            HX::Internal::ThreadPool::instance().parallelRows(m_height, m_width, [&](int first_row, int end_row) {
+                for (int row = first_row; row < end_row; ++row) {
+                    const size_t base = static_cast<size_t>(row) * m_width;
+                    for (int col = 0; col < m_width; ++col) {
+                        const size_t i = base + col;
+                        // Apply formula: y = k(x - x₀) + b
+                        float offset = m_backgroundOffset[i] + drift.values[col];
+                        float corrected = gain * (static_cast<float>(input[i]) - offset) + bias;
 
-            return HUBX_SUCCESS;
+                        // Clamp to valid range
+                        corrected = std::max(0.0f, std::min(static_cast<float>(maxValue), corrected));
+
+                        output[i] = static_cast<unsigned short>(corrected + 0.5f); // Round to nearest
+                    }
+                }
+            });
         }
         catch (const std::exception&) {
             return HUBX_ERROR_CALCULATION;
         }
+
+        trackFrame(input, drift.values);
+        return HUBX_SUCCESS;
     }
 
     /**
@@ -214,22 +345,125 @@ public:
 
         const int maxValue = (1 << bitDepth) - 1;
 
+        DriftView drift(*this);
+
         try {
-            for (int i = 0; i < m_pixelCount; ++i) {
-                // Apply formula with per-pixel gain: y = k[i](x - x₀[i]) + b
-                float corrected = gainMap[i] * (static_cast<float>(input[i]) - m_backgroundOffset[i]) + bias;
-                
-                // Clamp to valid range
-                corrected = std::max(0.0f, std::min(static_cast<float>(maxValue), corrected));
-                
-                output[i] = static_cast<unsigned short>(corrected + 0.5f);
-            }
+            // Row bands on the shared pool, pixels are independent
+            HX::Internal::ThreadPool::instance().parallelRows(m_height, m_width, [&](int first_row, int end_row) {
+                for (int row = first_row; row < end_row; ++row) {
+                    const size_t base = static_cast<size_t>(row) * m_width;
+                    for (int col = 0; col < m_width; ++col) {
+                        const size_t i = base + col;
+                        // Apply formula with per-pixel gain: y = k[i](x - x₀[i]) + b
+                        float offset = m_backgroundOffset[i] + drift.values[col];
+                        float corrected = gainMap[i] * (static_cast<float>(input[i]) - offset) + bias;
 
-            return HUBX_SUCCESS;
+                        // Clamp to valid range
+                        corrected = std::max(0.0f, std::min(static_cast<float>(maxValue), corrected));
+
+                        output[i] = static_cast<unsigned short>(corrected + 0.5f);
+                    }
+                }
+            });
         }
         catch (const std::exception&) {
             return HUBX_ERROR_CALCULATION;
         }
+
+        trackFrame(input, drift.values);
+        return HUBX_SUCCESS;
+    }
+
+    /**
+     * @brief Track slow offset drift (e.g. temperature) during acquisition
+     * @param alpha Weight of each new dark line in the moving average (0 < alpha <= 1)
+     * @param darkRowFirst First dark row in every corrected frame
+     * @param darkRowCount Dark rows per frame, shielded or beam-off (0 = none)
+     * @param gapThreshold Also use rows whose every pixel is within this many
+     *                     counts of the current offset, i.e. beam-off gaps
+     *                     between objects (0 = off)
+     * @return HUBX_SUCCESS on success, error code otherwise
+     *
+     * @note The calibrated offset is kept; a per-column drift is averaged on
+     *       top of it and added during apply. Dark rows are read from frames
+     *       passed to the apply calls, or pushed with addDriftLines(). The
+     *       apply path never waits for the tracker: it reads a published
+     *       copy, and skips feeding samples if an update is in progress.
+     */
+    int enableDriftTracking(float alpha, int darkRowFirst, int darkRowCount, float gapThreshold) {
+        if (!m_initialized || !(alpha > 0.0f && alpha <= 1.0f) ||
+            darkRowFirst < 0 || darkRowCount < 0 || gapThreshold < 0.0f ||
+            darkRowFirst + darkRowCount > m_height) {
+            return HUBX_ERROR_INVALID_PARAM;
+        }
+
+        std::lock_guard<std::mutex> lock(m_driftMutex);
+        m_driftAlpha = alpha;
+        m_driftRowFirst = darkRowFirst;
+        m_driftRowCount = darkRowCount;
+        m_driftGap = gapThreshold;
+        if (!m_driftEnabled) {
+            resetDriftLocked();
+        }
+        m_driftEnabled = true;
+        return HUBX_SUCCESS;
+    }
+
+    /**
+     * @brief Stop drift tracking and drop the tracked drift
+     */
+    void disableDriftTracking() {
+        std::lock_guard<std::mutex> lock(m_driftMutex);
+        m_driftEnabled = false;
+        resetDriftLocked();
+    }
+
+    /**
+     * @brief Feed dark lines captured outside the corrected frames
+     * @param lines Contiguous line data, lineCount x lineWidth pixels
+     * @param lineCount Number of lines
+     * @param lineWidth Width of each line (must equal the image width)
+     * @return HUBX_SUCCESS on success, error code otherwise
+     *
+     * @note May run on another thread while frames are being corrected
+     */
+    int addDriftLines(const unsigned short* lines, int lineCount, int lineWidth) {
+        if (lines == nullptr) {
+            return HUBX_ERROR_NULL_POINTER;
+        }
+        std::lock_guard<std::mutex> lock(m_driftMutex);
+        if (!m_driftEnabled || lineWidth != m_width || lineCount < 0) {
+            return HUBX_ERROR_INVALID_PARAM;
+        }
+
+        for (int line = 0; line < lineCount; ++line) {
+            updateDriftLocked(lines + static_cast<size_t>(line) * lineWidth, m_baseColumnMean.data());
+        }
+        publishDriftLocked();
+        return HUBX_SUCCESS;
+    }
+
+    /**
+     * @brief Get the drift currently applied, one value per column
+     * @param drift Output buffer
+     * @param bufferSize Size of output buffer (at least the image width)
+     * @param samples Output, dark lines averaged so far (may be nullptr)
+     * @return HUBX_SUCCESS on success, error code otherwise
+     */
+    int getDrift(float* drift, int bufferSize, uint64_t* samples) {
+        if (!m_initialized) {
+            return HUBX_ERROR_INVALID_PARAM;
+        }
+        if (drift == nullptr || bufferSize < m_width) {
+            return HUBX_ERROR_BUFFER_SIZE;
+        }
+
+        DriftView view(*this);
+        std::memcpy(drift, view.values, m_width * sizeof(float));
+        if (samples) {
+            *samples = m_driftSamples;
+        }
+        return HUBX_SUCCESS;
     }
 
     /**
@@ -248,6 +482,7 @@ public:
         }
 
         std::memcpy(m_backgroundOffset.data(), offsetData, dataSize * sizeof(float));
+        offsetChanged();
         return HUBX_SUCCESS;
     }
 
@@ -280,20 +515,12 @@ public:
             return HUBX_ERROR_INVALID_PARAM;
         }
 
-        FILE* file = fopen(filename, "wb");
-        if (file == nullptr) {
-            return HUBX_ERROR_INVALID_PARAM;
-        }
-
-        // Write header
-        fwrite(&m_width, sizeof(int), 1, file);
-        fwrite(&m_height, sizeof(int), 1, file);
-
-        // Write offset data
-        fwrite(m_backgroundOffset.data(), sizeof(float), m_pixelCount, file);
-
-        fclose(file);
-        return HUBX_SUCCESS;
+        const int32_t meta[2] = { m_width, m_height };
+        HX::Internal::CalibFileWriter writer(CALIB_MODULE);
+        writer.AddSection(CALIB_META, meta, sizeof(meta), sizeof(int32_t));
+        writer.AddSection(CALIB_OFFSET, m_backgroundOffset.data(),
+                          m_pixelCount * sizeof(float), sizeof(float));
+        return writer.Write(filename) ? HUBX_SUCCESS : HUBX_ERROR_INVALID_PARAM;
     }
 
     /**
@@ -306,29 +533,36 @@ public:
             return HUBX_ERROR_INVALID_PARAM;
         }
 
-        FILE* file = fopen(filename, "rb");
-        if (file == nullptr) {
+        if (!HX::Internal::CalibFile::IsContainer(filename)) {
+            return loadLegacyFile(filename);
+        }
+
+        HX::Internal::CalibFile file;
+        if (!file.Open(filename, CALIB_MODULE)) {
             return HUBX_ERROR_INVALID_PARAM;
         }
 
-        // Read header
-        int width, height;
-        fread(&width, sizeof(int), 1, file);
-        fread(&height, sizeof(int), 1, file);
+        const int32_t* meta = static_cast<const int32_t*>(
+            file.SectionExact(CALIB_META, 2 * sizeof(int32_t)));
+        if (meta == nullptr || meta[0] <= 0 || meta[1] <= 0) {
+            return HUBX_ERROR_INVALID_PARAM;
+        }
+        const size_t pixels = static_cast<size_t>(meta[0]) * meta[1];
+        const void* offset = file.SectionExact(CALIB_OFFSET, pixels * sizeof(float));
+        if (offset == nullptr) {
+            return HUBX_ERROR_INVALID_PARAM;
+        }
 
         // Initialize if needed
-        if (!m_initialized || width != m_width || height != m_height) {
-            int result = initialize(width, height);
+        if (!m_initialized || meta[0] != m_width || meta[1] != m_height) {
+            int result = initialize(meta[0], meta[1]);
             if (result != HUBX_SUCCESS) {
-                fclose(file);
                 return result;
             }
         }
 
-        // Read offset data
-        fread(m_backgroundOffset.data(), sizeof(float), m_pixelCount, file);
-
-        fclose(file);
+        std::memcpy(m_backgroundOffset.data(), offset, pixels * sizeof(float));
+        offsetChanged();
         return HUBX_SUCCESS;
     }
 
@@ -336,6 +570,11 @@ public:
      * @brief Release resources
      */
     void release() {
+        {
+            std::lock_guard<std::mutex> lock(m_accumulatorMutex);
+            m_accumulator.clear();
+        }
+        disableDriftTracking();
         m_backgroundOffset.clear();
         m_initialized = false;
         m_width = 0;
@@ -344,41 +583,484 @@ public:
     }
 
 private:
+    /**
+     * @brief Pins the published drift buffer for the duration of one apply
+     *
+     * Lock-free: the tracker only rewrites the buffer no reader holds.
+     */
+    struct DriftView {
+        DriftView(BackgroundCorrection& owner) : m_owner(owner) {
+            for (;;) {
+                m_slot = owner.m_driftActive.load();
+                ++owner.m_driftReaders[m_slot];
+                if (owner.m_driftActive.load() == m_slot) {
+                    break;
+                }
+                --owner.m_driftReaders[m_slot];
+            }
+            values = owner.m_driftBuffers[m_slot].data();
+        }
+        ~DriftView() { --m_owner.m_driftReaders[m_slot]; }
+
+        const float* values;
+
+    private:
+        BackgroundCorrection& m_owner;
+        int m_slot;
+    };
+
+    /**
+     * @brief Restart tracking against a new calibrated offset
+     */
+    void offsetChanged() {
+        std::lock_guard<std::mutex> lock(m_driftMutex);
+        resetDriftLocked();
+    }
+
+    void resetDriftLocked() {
+        m_driftEma.assign(m_width, 0.0f);
+        m_baseColumnMean.assign(m_width, 0.0f);
+        for (int row = 0; row < m_height; ++row) {
+            const float* offset = m_backgroundOffset.data() + static_cast<size_t>(row) * m_width;
+            for (int col = 0; col < m_width; ++col) {
+                m_baseColumnMean[col] += offset[col];
+            }
+        }
+        for (int col = 0; col < m_width && m_height > 0; ++col) {
+            m_baseColumnMean[col] /= static_cast<float>(m_height);
+        }
+        m_driftSamples = 0;
+        m_driftPending = true;
+        publishDriftLocked();
+    }
+
+    /**
+     * @brief Blend one dark line, measured against @p offset, into the average
+     */
+    void updateDriftLocked(const unsigned short* line, const float* offset) {
+        for (int col = 0; col < m_width; ++col) {
+            float delta = static_cast<float>(line[col]) - offset[col];
+            m_driftEma[col] += m_driftAlpha * (delta - m_driftEma[col]);
+        }
+        ++m_driftSamples;
+        m_driftPending = true;
+    }
+
+    /**
+     * @brief Copy the average into the idle buffer and make it current
+     *
+     * If an apply still holds the idle buffer the copy is retried on the next update.
+     */
+    void publishDriftLocked() {
+        if (!m_driftPending) {
+            return;
+        }
+        const int target = 1 - m_driftActive.load();
+        if (m_driftReaders[target].load() != 0 ||
+            m_driftBuffers[target].size() != m_driftEma.size()) {
+            return;
+        }
+        std::copy(m_driftEma.begin(), m_driftEma.end(), m_driftBuffers[target].begin());
+        m_driftActive.store(target);
+        m_driftPending = false;
+    }
+
+    /**
+     * @brief Feed the dark rows of a corrected frame to the tracker
+     * @param input Raw frame
+     * @param drift Drift the frame was corrected with
+     */
+    void trackFrame(const unsigned short* input, const float* drift) {
+        if (!m_driftEnabled) {
+            return;
+        }
+        std::unique_lock<std::mutex> lock(m_driftMutex, std::try_to_lock);
+        if (!lock.owns_lock() || !m_driftEnabled) {
+            return;
+        }
+
+        for (int row = 0; row < m_height; ++row) {
+            const size_t base = static_cast<size_t>(row) * m_width;
+            const bool darkRow = row >= m_driftRowFirst && row < m_driftRowFirst + m_driftRowCount;
+            if (!darkRow && !(m_driftGap > 0.0f && isGapRow(input + base, base, drift))) {
+                continue;
+            }
+            updateDriftLocked(input + base, m_backgroundOffset.data() + base);
+        }
+        publishDriftLocked();
+    }
+
+    /**
+     * @brief True if every pixel of a row is within the gap threshold of its offset
+     */
+    bool isGapRow(const unsigned short* line, size_t base, const float* drift) const {
+        for (int col = 0; col < m_width; ++col) {
+            float residual = static_cast<float>(line[col]) - (m_backgroundOffset[base + col] + drift[col]);
+            if (std::fabs(residual) > m_driftGap) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief Load the pre-container layout: width, height, offsets
+     */
+    int loadLegacyFile(const char* filename) {
+        FILE* file = fopen(filename, "rb");
+        if (file == nullptr) {
+            return HUBX_ERROR_INVALID_PARAM;
+        }
+
+        int width = 0, height = 0;
+        if (fread(&width, sizeof(int), 1, file) != 1 ||
+            fread(&height, sizeof(int), 1, file) != 1 ||
+            width <= 0 || height <= 0) {
+            fclose(file);
+            return HUBX_ERROR_INVALID_PARAM;
+        }
+
+        const size_t pixels = static_cast<size_t>(width) * height;
+        std::vector<float> offset(pixels);
+        bool ok = fread(offset.data(), sizeof(float), pixels, file) == pixels;
+        fclose(file);
+        if (!ok) {
+            return HUBX_ERROR_INVALID_PARAM;
+        }
+
+        if (!m_initialized || width != m_width || height != m_height) {
+            int result = initialize(width, height);
+            if (result != HUBX_SUCCESS) {
+                return result;
+            }
+        }
+        m_backgroundOffset.swap(offset);
+        offsetChanged();
+        return HUBX_SUCCESS;
+    }
+
+    /**
+     * @brief Size the accumulator for the first sample; false on a mode mix
+     */
+    bool prepareAccumulator(int pixels) {
+        if (m_accumulator.count() == 0) {
+            if (m_accumulator.pixels() != static_cast<size_t>(pixels)) {
+                m_accumulator.reset(pixels);
+            }
+            return true;
+        }
+        return m_accumulator.pixels() == static_cast<size_t>(pixels);
+    }
+
     bool m_initialized;
     int m_width;
     int m_height;
     int m_pixelCount;
     std::vector<float> m_backgroundOffset;
-};
+    std::mutex m_accumulatorMutex;                  ///< Guards m_accumulator
+    HX::Internal::WelfordAccumulator m_accumulator; ///< Streaming calibration
 
-// Global instance for C-style API
-static BackgroundCorrection g_backgroundCorrection;
+    // Online drift tracking; m_driftMutex guards the average and settings,
+    // the apply path only touches the published buffers through DriftView
+    std::mutex m_driftMutex;
+    std::atomic<bool> m_driftEnabled;
+    float m_driftAlpha;
+    int m_driftRowFirst;
+    int m_driftRowCount;
+    float m_driftGap;
+    std::vector<float> m_driftEma;                  ///< Per-column drift being averaged
+    std::vector<float> m_baseColumnMean;            ///< Column offsets for addDriftLines()
+    bool m_driftPending;                            ///< m_driftEma not yet published
+    std::vector<float> m_driftBuffers[2];           ///< Published drift, double-buffered
+    std::atomic<int> m_driftActive;
+    std::atomic<int> m_driftReaders[2];
+    std::atomic<uint64_t> m_driftSamples;
+};
 
 } // namespace Correction
 } // namespace HubxSDK
 
+/**
+ * @brief Background correction instance behind a C API handle
+ *
+ * Calls on one handle are serialized; give each pipeline thread its own
+ * handle to correct several detectors or channels concurrently.
+ */
+struct hubx_background_t {
+    std::mutex mutex;
+    HubxSDK::Correction::BackgroundCorrection correction;
+};
+
+// Default instance for the handle-less C API
+static hubx_background_t g_backgroundCorrection;
+
 // C-style API for compatibility
 extern "C" {
 
+/**
+ * @brief Create an independent background correction instance
+ * @return Handle, or NULL if out of memory
+ */
+hubx_background_t* hubx_background_create() {
+    return new (std::nothrow) hubx_background_t();
+}
+
+/**
+ * @brief Destroy an instance created by hubx_background_create()
+ */
+void hubx_background_destroy(hubx_background_t* handle) {
+    delete handle;
+}
+
+/**
+ * @brief Initialize background correction module (handle)
+ */
+int hubx_background_init_ex(hubx_background_t* handle, int width, int height) {
+    if (!handle) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    return handle->correction.initialize(width, height);
+}
+
+/**
+ * @brief Calculate background offset from frames (handle)
+ */
+int hubx_background_calculate_ex(hubx_background_t* handle,
+                                 const unsigned short** frames,
+                                 int frameCount,
+                                 int bitDepth) {
+    if (!handle) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    return handle->correction.calculateBackgroundOffset(frames, frameCount, bitDepth);
+}
+
+/**
+ * @brief Calculate background offset from line data (handle)
+ */
+int hubx_background_calculate_lines_ex(hubx_background_t* handle,
+                                       const unsigned short** lines,
+                                       int lineCount,
+                                       int lineWidth,
+                                       int bitDepth) {
+    if (!handle) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    return handle->correction.calculateBackgroundOffsetFromLines(lines, lineCount, lineWidth, bitDepth);
+}
+
+/**
+ * @brief Apply background correction (handle)
+ */
+int hubx_background_apply_ex(hubx_background_t* handle,
+                             const unsigned short* input,
+                             unsigned short* output,
+                             float gain,
+                             float bias,
+                             int bitDepth) {
+    if (!handle) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    return handle->correction.applyCorrection(input, output, gain, bias, bitDepth);
+}
+
+/**
+ * @brief Apply background correction to a batch of frames (handle)
+ * @param inputs frameCount input frames
+ * @param outputs frameCount output frames
+ * @param threads Frames corrected concurrently (0 = pool size, 1 = in order)
+ * @param results Per-frame status, may be NULL
+ * @return HUBX_SUCCESS, or the status of the first frame that failed
+ *
+ * The handle is locked once for the whole batch. With drift tracking on,
+ * concurrent frames feed the tracker in completion order.
+ */
+int hubx_background_apply_batch_ex(hubx_background_t* handle,
+                                   const unsigned short* const* inputs,
+                                   unsigned short* const* outputs,
+                                   int frameCount,
+                                   float gain,
+                                   float bias,
+                                   int bitDepth,
+                                   int threads,
+                                   int* results) {
+    if (!handle || !inputs || !outputs) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    if (frameCount < 0 || threads < 0) {
+        return HUBX_ERROR_INVALID_PARAM;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    return HX::Internal::ThreadPool::instance().runBatch(frameCount, threads, [&](int frame) {
+        int result = handle->correction.applyCorrection(inputs[frame], outputs[frame], gain, bias, bitDepth);
+        if (results) {
+            results[frame] = result;
+        }
+        return result;
+    });
+}
+
+/**
+ * @brief Apply background correction with gain map (handle)
+ */
+int hubx_background_apply_gainmap_ex(hubx_background_t* handle,
+                                     const unsigned short* input,
+                                     unsigned short* output,
+                                     const float* gainMap,
+                                     float bias,
+                                     int bitDepth) {
+    if (!handle) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    return handle->correction.applyCorrectionWithGainMap(input, output, gainMap, bias, bitDepth);
+}
+
+/**
+ * @brief Add one frame to the streaming background calibration (handle)
+ */
+int hubx_background_add_frame_ex(hubx_background_t* handle, const unsigned short* frame) {
+    if (!handle) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    return handle->correction.addBackgroundOffsetFrame(frame);
+}
+
+/**
+ * @brief Add lines to the streaming background calibration (handle)
+ */
+int hubx_background_add_lines_ex(hubx_background_t* handle,
+                                 const unsigned short* lines,
+                                 int lineCount,
+                                 int lineWidth) {
+    if (!handle) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    return handle->correction.addBackgroundOffsetLines(lines, lineCount, lineWidth);
+}
+
+/**
+ * @brief Finish the streaming background calibration (handle)
+ */
+int hubx_background_finalize_ex(hubx_background_t* handle) {
+    if (!handle) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    return handle->correction.finalizeBackgroundOffset();
+}
+
+/**
+ * @brief Enable online offset drift tracking (handle)
+ */
+int hubx_background_drift_enable_ex(hubx_background_t* handle, float alpha,
+                                    int darkRowFirst, int darkRowCount, float gapThreshold) {
+    if (!handle) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    return handle->correction.enableDriftTracking(alpha, darkRowFirst, darkRowCount, gapThreshold);
+}
+
+/**
+ * @brief Disable drift tracking and drop the tracked drift (handle)
+ */
+int hubx_background_drift_disable_ex(hubx_background_t* handle) {
+    if (!handle) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    handle->correction.disableDriftTracking();
+    return HUBX_SUCCESS;
+}
+
+/**
+ * @brief Feed dark lines to the drift tracker (handle)
+ *
+ * Does not take the handle lock, so a capture thread can feed dark lines
+ * while another thread applies corrections. Must not overlap init, load
+ * or release on the same handle.
+ */
+int hubx_background_drift_add_lines_ex(hubx_background_t* handle,
+                                       const unsigned short* lines,
+                                       int lineCount,
+                                       int lineWidth) {
+    if (!handle) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    return handle->correction.addDriftLines(lines, lineCount, lineWidth);
+}
+
+/**
+ * @brief Get the tracked per-column drift (handle)
+ */
+int hubx_background_drift_get_ex(hubx_background_t* handle, float* drift,
+                                 int bufferSize, uint64_t* samples) {
+    if (!handle) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    return handle->correction.getDrift(drift, bufferSize, samples);
+}
+
+/**
+ * @brief Save background offset to file (handle)
+ */
+int hubx_background_save_ex(hubx_background_t* handle, const char* filename) {
+    if (!handle) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    return handle->correction.saveToFile(filename);
+}
+
+/**
+ * @brief Load background offset from file (handle)
+ */
+int hubx_background_load_ex(hubx_background_t* handle, const char* filename) {
+    if (!handle) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    return handle->correction.loadFromFile(filename);
+}
+
+/**
+ * @brief Release background correction resources (handle)
+ */
+void hubx_background_release_ex(hubx_background_t* handle) {
+    if (!handle) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    handle->correction.release();
+}
+
 /**
  * @brief Initialize background correction module
  */
 int hubx_background_init(int width, int height) {
-    return HubxSDK::Correction::g_backgroundCorrection.initialize(width, height);
+    return hubx_background_init_ex(&g_backgroundCorrection, width, height);
 }
 
 /**
  * @brief Calculate background offset from frames
  */
 int hubx_background_calculate(const unsigned short** frames, int frameCount, int bitDepth) {
-    return HubxSDK::Correction::g_backgroundCorrection.calculateBackgroundOffset(frames, frameCount, bitDepth);
+    return hubx_background_calculate_ex(&g_backgroundCorrection, frames, frameCount, bitDepth);
 }
 
 /**
  * @brief Calculate background offset from line data
  */
 int hubx_background_calculate_lines(const unsigned short** lines, int lineCount, int lineWidth, int bitDepth) {
-    return HubxSDK::Correction::g_backgroundCorrection.calculateBackgroundOffsetFromLines(lines, lineCount, lineWidth, bitDepth);
+    return hubx_background_calculate_lines_ex(&g_backgroundCorrection, lines, lineCount, lineWidth, bitDepth);
 }
 
 /**
@@ -386,7 +1068,7 @@ int hubx_background_calculate_lines(const unsigned short** lines, int lineCount,
  */
 int hubx_background_apply(const unsigned short* input, unsigned short* output,
                          float gain, float bias, int bitDepth) {
-    return HubxSDK::Correction::g_backgroundCorrection.applyCorrection(input, output, gain, bias, bitDepth);
+    return hubx_background_apply_ex(&g_backgroundCorrection, input, output, gain, bias, bitDepth);
 }
 
 /**
@@ -394,28 +1076,88 @@ int hubx_background_apply(const unsigned short* input, unsigned short* output,
  */
 int hubx_background_apply_gainmap(const unsigned short* input, unsigned short* output,
                                  const float* gainMap, float bias, int bitDepth) {
-    return HubxSDK::Correction::g_backgroundCorrection.applyCorrectionWithGainMap(input, output, gainMap, bias, bitDepth);
+    return hubx_background_apply_gainmap_ex(&g_backgroundCorrection, input, output, gainMap, bias, bitDepth);
+}
+
+/**
+ * @brief Apply background correction to a batch of frames
+ */
+int hubx_background_apply_batch(const unsigned short* const* inputs, unsigned short* const* outputs,
+                                int frameCount, float gain, float bias, int bitDepth,
+                                int threads, int* results) {
+    return hubx_background_apply_batch_ex(&g_backgroundCorrection, inputs, outputs, frameCount,
+                                          gain, bias, bitDepth, threads, results);
+}
+
+/**
+ * @brief Add one frame to the streaming background calibration
+ */
+int hubx_background_add_frame(const unsigned short* frame) {
+    return hubx_background_add_frame_ex(&g_backgroundCorrection, frame);
+}
+
+/**
+ * @brief Add lines to the streaming background calibration
+ */
+int hubx_background_add_lines(const unsigned short* lines, int lineCount, int lineWidth) {
+    return hubx_background_add_lines_ex(&g_backgroundCorrection, lines, lineCount, lineWidth);
+}
+
+/**
+ * @brief Finish the streaming background calibration
+ */
+int hubx_background_finalize() {
+    return hubx_background_finalize_ex(&g_backgroundCorrection);
+}
+
+/**
+ * @brief Enable online offset drift tracking
+ */
+int hubx_background_drift_enable(float alpha, int darkRowFirst, int darkRowCount, float gapThreshold) {
+    return hubx_background_drift_enable_ex(&g_backgroundCorrection, alpha, darkRowFirst,
+                                           darkRowCount, gapThreshold);
+}
+
+/**
+ * @brief Disable drift tracking
+ */
+int hubx_background_drift_disable() {
+    return hubx_background_drift_disable_ex(&g_backgroundCorrection);
+}
+
+/**
+ * @brief Feed dark lines to the drift tracker
+ */
+int hubx_background_drift_add_lines(const unsigned short* lines, int lineCount, int lineWidth) {
+    return hubx_background_drift_add_lines_ex(&g_backgroundCorrection, lines, lineCount, lineWidth);
+}
+
+/**
+ * @brief Get the tracked per-column drift
+ */
+int hubx_background_drift_get(float* drift, int bufferSize, uint64_t* samples) {
+    return hubx_background_drift_get_ex(&g_backgroundCorrection, drift, bufferSize, samples);
 }
 
 /**
  * @brief Save background offset to file
  */
 int hubx_background_save(const char* filename) {
-    return HubxSDK::Correction::g_backgroundCorrection.saveToFile(filename);
+    return hubx_background_save_ex(&g_backgroundCorrection, filename);
 }
 
 /**
  * @brief Load background offset from file
  */
 int hubx_background_load(const char* filename) {
-    return HubxSDK::Correction::g_backgroundCorrection.loadFromFile(filename);
+    return hubx_background_load_ex(&g_backgroundCorrection, filename);
 }
 
 /**
  * @brief Release background correction resources
  */
 void hubx_background_release() {
-    HubxSDK::Correction::g_backgroundCorrection.release();
+    hubx_background_release_ex(&g_backgroundCorrection);
 }
 
 } // extern "C"
\ No newline at end of file
@@ -8,12 +8,20 @@
  * Copyright (c) 2025
  */
 
+#include <cstdint>
+#include <cstdio>
 #include <cstring>
 #include <cmath>
 #include <algorithm>
 #include <vector>
 #include <stdexcept>
 #include <memory>
+#include <mutex>
+#include <new>
+
+#include "../utils/calib_file.h"
+#include "../utils/thread_pool.h"
+#include "../utils/welford.h"
 
 // Error codes
 #define HUBX_SUCCESS 0
@@ -26,6 +34,23 @@
 namespace HubxSDK {
 namespace Correction {
 
+namespace {
+
+// Calibration container tags (see utils/calib_file.h)
+const uint32_t CALIB_MODULE       = HX::Internal::CalibTag('B', 'S', 'L', 'N');
+const uint32_t CALIB_META         = HX::Internal::CalibTag('M', 'E', 'T', 'A');
+const uint32_t CALIB_VALUES       = HX::Internal::CalibTag('B', 'V', 'A', 'L');
+const uint32_t CALIB_COEFFICIENTS = HX::Internal::CalibTag('B', 'C', 'O', 'F');
+
+/// META section payload
+struct BaselineMeta {
+    int32_t width;
+    int32_t height;
+    float targetBaseline;
+};
+
+} // namespace
+
 /**
  * @class BaselineCorrection
  * @brief Handles baseline/reference value correction for detector calibration
@@ -37,7 +62,8 @@ public:
           m_calibrated(false),
           m_width(0), 
           m_height(0),
-          m_targetBaseline(2048.0f) // Default target for 12-bit (middle of range)
+          m_targetBaseline(2048.0f), // Default target for 12-bit (middle of range)
+          m_integerValid(false)
     {}
     
     ~BaselineCorrection() {
@@ -132,6 +158,7 @@ public:
             for (int i = 0; i < m_pixelCount; ++i) {
                 m_baselineCoefficients[i] = m_targetBaseline - m_baselineValues[i];
             }
+            updateIntegerCoefficients();
 
             m_calibrated = true;
             return HUBX_SUCCESS;
@@ -182,6 +209,7 @@ public:
                     m_baselineCoefficients[idx] = m_targetBaseline - m_baselineValues[idx];
                 }
             }
+            updateIntegerCoefficients();
 
             m_calibrated = true;
             return HUBX_SUCCESS;
@@ -191,6 +219,95 @@ public:
         }
     }
 
+    /**
+     * @brief Add one dark frame to the running average (streaming calibration)
+     * @param frame Frame data, width x height pixels
+     * @return HUBX_SUCCESS on success, error code otherwise
+     *
+     * @note Frames can be pushed straight from the frame callback; memory
+     *       stays at two doubles per pixel. Lines and frames cannot be mixed
+     *       before the next finalize.
+     */
+    int addBaselineFrame(const unsigned short* frame) {
+        std::lock_guard<std::mutex> lock(m_accumulatorMutex);
+        if (!m_initialized) {
+            return HUBX_ERROR_INVALID_PARAM;
+        }
+        if (frame == nullptr) {
+            return HUBX_ERROR_NULL_POINTER;
+        }
+        if (!prepareAccumulator(m_pixelCount)) {
+            return HUBX_ERROR_INVALID_PARAM;
+        }
+
+        m_accumulator.add(frame);
+        return HUBX_SUCCESS;
+    }
+
+    /**
+     * @brief Add dark lines to the running per-column average
+     * @param lines Contiguous line data, lineCount x lineWidth pixels
+     * @param lineCount Number of lines
+     * @param lineWidth Width of each line (must equal the image width)
+     * @return HUBX_SUCCESS on success, error code otherwise
+     */
+    int addBaselineLines(const unsigned short* lines, int lineCount, int lineWidth) {
+        std::lock_guard<std::mutex> lock(m_accumulatorMutex);
+        if (!m_initialized || lineWidth != m_width || lineCount < 0) {
+            return HUBX_ERROR_INVALID_PARAM;
+        }
+        if (lines == nullptr) {
+            return HUBX_ERROR_NULL_POINTER;
+        }
+        if (!prepareAccumulator(m_width)) {
+            return HUBX_ERROR_INVALID_PARAM;
+        }
+
+        for (int line = 0; line < lineCount; ++line) {
+            m_accumulator.add(lines + static_cast<size_t>(line) * lineWidth);
+        }
+        return HUBX_SUCCESS;
+    }
+
+    /**
+     * @brief Store the running average as the baseline and start a new calibration
+     * @return HUBX_SUCCESS on success, HUBX_ERROR_NOT_CALIBRATED if nothing was added
+     *
+     * @note A line average is replicated across the height
+     */
+    int finalizeBaseline() {
+        std::lock_guard<std::mutex> lock(m_accumulatorMutex);
+        if (!m_initialized) {
+            return HUBX_ERROR_INVALID_PARAM;
+        }
+        if (m_accumulator.count() == 0) {
+            return HUBX_ERROR_NOT_CALIBRATED;
+        }
+
+        const bool perLine = m_accumulator.pixels() != static_cast<size_t>(m_pixelCount);
+        for (int row = 0; row < m_height; ++row) {
+            for (int col = 0; col < m_width; ++col) {
+                int idx = row * m_width + col;
+                float mean = static_cast<float>(m_accumulator.mean(perLine ? col : idx));
+                m_baselineValues[idx] = mean;
+                m_baselineCoefficients[idx] = m_targetBaseline - mean;
+            }
+        }
+
+        m_accumulator.clear();
+        updateIntegerCoefficients();
+        m_calibrated = true;
+        return HUBX_SUCCESS;
+    }
+
+    /**
+     * @brief Number of frames or lines added since the last finalize
+     */
+    int getBaselineSampleCount() {
+        std::lock_guard<std::mutex> lock(m_accumulatorMutex);
+        return static_cast<int>(m_accumulator.count());
+    }
+
     /**
      * @brief Apply baseline correction to an image
      * @param input Input image data
@@ -209,6 +326,11 @@ public:
 
         const int maxValue = (1 << bitDepth) - 1;
 
+        if (m_integerValid && bitDepth <= 16) {
+            applyInteger(input, output, maxValue);
+            return HUBX_SUCCESS;
+        }
+
         try {
             for (int i = 0; i < m_pixelCount; ++i) {
                 // Apply baseline correction: y = x + (target - baseline)
@@ -244,6 +366,11 @@ public:
 
         const int maxValue = (1 << bitDepth) - 1;
 
+        if (m_integerValid && bitDepth <= 16) {
+            applyInteger(data, data, maxValue);
+            return HUBX_SUCCESS;
+        }
+
         try {
             for (int i = 0; i < m_pixelCount; ++i) {
                 float corrected = static_cast<float>(data[i]) + m_baselineCoefficients[i];
@@ -346,6 +473,7 @@ public:
         }
 
         std::memcpy(m_baselineCoefficients.data(), coefficients, dataSize * sizeof(float));
+        updateIntegerCoefficients();
         m_calibrated = true;
         return HUBX_SUCCESS;
     }
@@ -379,22 +507,17 @@ public:
             return HUBX_ERROR_INVALID_PARAM;
         }
 
-        FILE* file = fopen(filename, "wb");
-        if (file == nullptr) {
-            return HUBX_ERROR_INVALID_PARAM;
-        }
-
-        // Write header
-        fwrite(&m_width, sizeof(int), 1, file);
-        fwrite(&m_height, sizeof(int), 1, file);
-        fwrite(&m_targetBaseline, sizeof(float), 1, file);
-
-        // Write baseline data
-        fwrite(m_baselineValues.data(), sizeof(float), m_pixelCount, file);
-        fwrite(m_baselineCoefficients.data(), sizeof(float), m_pixelCount, file);
-
-        fclose(file);
-        return HUBX_SUCCESS;
+        BaselineMeta meta;
+        meta.width = m_width;
+        meta.height = m_height;
+        meta.targetBaseline = m_targetBaseline;
+
+        const size_t bytes = m_pixelCount * sizeof(float);
+        HX::Internal::CalibFileWriter writer(CALIB_MODULE);
+        writer.AddSection(CALIB_META, &meta, sizeof(meta));
+        writer.AddSection(CALIB_VALUES, m_baselineValues.data(), bytes, sizeof(float));
+        writer.AddSection(CALIB_COEFFICIENTS, m_baselineCoefficients.data(), bytes, sizeof(float));
+        return writer.Write(filename) ? HUBX_SUCCESS : HUBX_ERROR_INVALID_PARAM;
     }
 
     /**
@@ -407,34 +530,44 @@ public:
             return HUBX_ERROR_INVALID_PARAM;
         }
 
-        FILE* file = fopen(filename, "rb");
-        if (file == nullptr) {
+        if (!HX::Internal::CalibFile::IsContainer(filename)) {
+            return loadLegacyFile(filename);
+        }
+
+        HX::Internal::CalibFile file;
+        if (!file.Open(filename, CALIB_MODULE)) {
             return HUBX_ERROR_INVALID_PARAM;
         }
 
-        // Read header
-        int width, height;
-        float targetBaseline;
-        fread(&width, sizeof(int), 1, file);
-        fread(&height, sizeof(int), 1, file);
-        fread(&targetBaseline, sizeof(float), 1, file);
+        const void* metaData = file.SectionExact(CALIB_META, sizeof(BaselineMeta));
+        if (metaData == nullptr) {
+            return HUBX_ERROR_INVALID_PARAM;
+        }
+        BaselineMeta meta;
+        std::memcpy(&meta, metaData, sizeof(meta));
+        if (meta.width <= 0 || meta.height <= 0) {
+            return HUBX_ERROR_INVALID_PARAM;
+        }
+
+        const size_t bytes = static_cast<size_t>(meta.width) * meta.height * sizeof(float);
+        const void* values = file.SectionExact(CALIB_VALUES, bytes);
+        const void* coefficients = file.SectionExact(CALIB_COEFFICIENTS, bytes);
+        if (values == nullptr || coefficients == nullptr) {
+            return HUBX_ERROR_INVALID_PARAM;
+        }
 
         // Initialize if needed
-        if (!m_initialized || width != m_width || height != m_height) {
-            int result = initialize(width, height);
+        if (!m_initialized || meta.width != m_width || meta.height != m_height) {
+            int result = initialize(meta.width, meta.height);
             if (result != HUBX_SUCCESS) {
-                fclose(file);
                 return result;
             }
         }
 
-        m_targetBaseline = targetBaseline;
-
-        // Read baseline data
-        fread(m_baselineValues.data(), sizeof(float), m_pixelCount, file);
-        fread(m_baselineCoefficients.data(), sizeof(float), m_pixelCount, file);
-
-        fclose(file);
+        m_targetBaseline = meta.targetBaseline;
+        std::memcpy(m_baselineValues.data(), values, bytes);
+        std::memcpy(m_baselineCoefficients.data(), coefficients, bytes);
+        updateIntegerCoefficients();
         m_calibrated = true;
         return HUBX_SUCCESS;
     }
@@ -451,8 +584,14 @@ public:
      * @brief Release resources
      */
     void release() {
+        {
+            std::lock_guard<std::mutex> lock(m_accumulatorMutex);
+            m_accumulator.clear();
+        }
         m_baselineValues.clear();
         m_baselineCoefficients.clear();
+        m_integerCoefficients.clear();
+        m_integerValid = false;
         m_initialized = false;
         m_calibrated = false;
         m_width = 0;
@@ -461,6 +600,94 @@ public:
     }
 
 private:
+    /**
+     * @brief Load the pre-container layout: width, height, target, values, coefficients
+     */
+    int loadLegacyFile(const char* filename) {
+        FILE* file = fopen(filename, "rb");
+        if (file == nullptr) {
+            return HUBX_ERROR_INVALID_PARAM;
+        }
+
+        int width = 0, height = 0;
+        float targetBaseline = 0.0f;
+        if (fread(&width, sizeof(int), 1, file) != 1 ||
+            fread(&height, sizeof(int), 1, file) != 1 ||
+            fread(&targetBaseline, sizeof(float), 1, file) != 1 ||
+            width <= 0 || height <= 0) {
+            fclose(file);
+            return HUBX_ERROR_INVALID_PARAM;
+        }
+
+        const size_t pixels = static_cast<size_t>(width) * height;
+        std::vector<float> values(pixels);
+        std::vector<float> coefficients(pixels);
+        bool ok = fread(values.data(), sizeof(float), pixels, file) == pixels &&
+                  fread(coefficients.data(), sizeof(float), pixels, file) == pixels;
+        fclose(file);
+        if (!ok) {
+            return HUBX_ERROR_INVALID_PARAM;
+        }
+
+        if (!m_initialized || width != m_width || height != m_height) {
+            int result = initialize(width, height);
+            if (result != HUBX_SUCCESS) {
+                return result;
+            }
+        }
+
+        m_targetBaseline = targetBaseline;
+        m_baselineValues.swap(values);
+        m_baselineCoefficients.swap(coefficients);
+        updateIntegerCoefficients();
+        m_calibrated = true;
+        return HUBX_SUCCESS;
+    }
+
+    /**
+     * @brief Size the accumulator for the first sample; false on a mode mix
+     */
+    bool prepareAccumulator(int pixels) {
+        if (m_accumulator.count() == 0) {
+            if (m_accumulator.pixels() != static_cast<size_t>(pixels)) {
+                m_accumulator.reset(pixels);
+            }
+            return true;
+        }
+        return m_accumulator.pixels() == static_cast<size_t>(pixels);
+    }
+
+    /**
+     * @brief Round the coefficients for the integer apply path
+     *
+     * x is an integer, so floor(x + c + 0.5) == x + floor(c + 0.5) and the
+     * integer path matches the float one without any error bound.
+     */
+    void updateIntegerCoefficients() {
+        m_integerCoefficients.resize(m_pixelCount);
+        m_integerValid = true;
+        for (int i = 0; i < m_pixelCount; ++i) {
+            const float c = m_baselineCoefficients[i];
+            if (!(std::fabs(c) < 1048576.0f)) {
+                m_integerValid = false;     // NaN or out of range, keep float
+                return;
+            }
+            m_integerCoefficients[i] = static_cast<int32_t>(std::floor(c + 0.5f));
+        }
+    }
+
+    /**
+     * @brief y = clamp(x + round(coeff)); input and output may alias
+     */
+    void applyInteger(const unsigned short* input, unsigned short* output, int maxValue) const {
+        const int32_t* coeffs = m_integerCoefficients.data();
+        for (int i = 0; i < m_pixelCount; ++i) {
+            int32_t corrected = static_cast<int32_t>(input[i]) + coeffs[i];
+            corrected = std::max(0, std::min(maxValue, corrected));
+            output[i] = static_cast<unsigned short>(corrected);
+        }
+    }
+
     bool m_initialized;
     bool m_calibrated;
     int m_width;
@@ -469,99 +696,377 @@ private:
     float m_targetBaseline;
     std::vector<float> m_baselineValues;
     std::vector<float> m_baselineCoefficients;
+    std::vector<int32_t> m_integerCoefficients;     ///< Rounded coefficients
+    bool m_integerValid;
+    std::mutex m_accumulatorMutex;                  ///< Guards m_accumulator
+    HX::Internal::WelfordAccumulator m_accumulator; ///< Streaming calibration
 };
 
-// Global instance for C-style API
-static BaselineCorrection g_baselineCorrection;
-
 } // namespace Correction
 } // namespace HubxSDK
 
+/**
+ * @brief Baseline correction instance behind a C API handle
+ *
+ * Calls on one handle are serialized; give each pipeline thread its own
+ * handle to correct several detectors or channels concurrently.
+ */
+struct hubx_baseline_t {
+    std::mutex mutex;
+    HubxSDK::Correction::BaselineCorrection correction;
+};
+
+// Default instance for the handle-less C API
+static hubx_baseline_t g_baselineCorrection;
+
 // C-style API for compatibility
 extern "C" {
 
+/**
+ * @brief Create an independent baseline correction instance
+ * @return Handle, or NULL if out of memory
+ */
+hubx_baseline_t* hubx_baseline_create() {
+    return new (std::nothrow) hubx_baseline_t();
+}
+
+/**
+ * @brief Destroy an instance created by hubx_baseline_create()
+ */
+void hubx_baseline_destroy(hubx_baseline_t* handle) {
+    delete handle;
+}
+
+/**
+ * @brief Initialize baseline correction module (handle)
+ */
+int hubx_baseline_init_ex(hubx_baseline_t* handle, int width, int height) {
+    if (!handle) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    return handle->correction.initialize(width, height);
+}
+
+/**
+ * @brief Set target baseline value (handle)
+ */
+int hubx_baseline_set_target_ex(hubx_baseline_t* handle, float targetValue, int bitDepth) {
+    if (!handle) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    return handle->correction.setTargetBaseline(targetValue, bitDepth);
+}
+
+/**
+ * @brief Calculate baseline from frames (handle)
+ */
+int hubx_baseline_calculate_ex(hubx_baseline_t* handle,
+                               const unsigned short** frames,
+                               int frameCount,
+                               int bitDepth) {
+    if (!handle) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    return handle->correction.calculateBaseline(frames, frameCount, bitDepth);
+}
+
+/**
+ * @brief Calculate baseline from line data (handle)
+ */
+int hubx_baseline_calculate_lines_ex(hubx_baseline_t* handle,
+                                     const unsigned short** lines,
+                                     int lineCount,
+                                     int lineWidth,
+                                     int bitDepth) {
+    if (!handle) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    return handle->correction.calculateBaselineFromLines(lines, lineCount, lineWidth, bitDepth);
+}
+
+/**
+ * @brief Add one frame to the streaming baseline calibration (handle)
+ */
+int hubx_baseline_add_frame_ex(hubx_baseline_t* handle, const unsigned short* frame) {
+    if (!handle) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    return handle->correction.addBaselineFrame(frame);
+}
+
+/**
+ * @brief Add lines to the streaming baseline calibration (handle)
+ */
+int hubx_baseline_add_lines_ex(hubx_baseline_t* handle,
+                               const unsigned short* lines,
+                               int lineCount,
+                               int lineWidth) {
+    if (!handle) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    return handle->correction.addBaselineLines(lines, lineCount, lineWidth);
+}
+
+/**
+ * @brief Finish the streaming baseline calibration (handle)
+ */
+int hubx_baseline_finalize_ex(hubx_baseline_t* handle) {
+    if (!handle) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    return handle->correction.finalizeBaseline();
+}
+
+/**
+ * @brief Apply baseline correction (handle)
+ */
+int hubx_baseline_apply_ex(hubx_baseline_t* handle,
+                           const unsigned short* input,
+                           unsigned short* output,
+                           int bitDepth) {
+    if (!handle) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    return handle->correction.applyCorrection(input, output, bitDepth);
+}
+
+/**
+ * @brief Apply baseline correction to a batch of frames (handle)
+ * @param inputs frameCount input frames
+ * @param outputs frameCount output frames (may be the inputs)
+ * @param threads Frames corrected concurrently (0 = pool size, 1 = in order)
+ * @param results Per-frame status, may be NULL
+ * @return HUBX_SUCCESS, or the status of the first frame that failed
+ *
+ * The handle is locked once for the whole batch.
+ */
+int hubx_baseline_apply_batch_ex(hubx_baseline_t* handle,
+                                 const unsigned short* const* inputs,
+                                 unsigned short* const* outputs,
+                                 int frameCount,
+                                 int bitDepth,
+                                 int threads,
+                                 int* results) {
+    if (!handle || !inputs || !outputs) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    if (frameCount < 0 || threads < 0) {
+        return HUBX_ERROR_INVALID_PARAM;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    return HX::Internal::ThreadPool::instance().runBatch(frameCount, threads, [&](int frame) {
+        int result = handle->correction.applyCorrection(inputs[frame], outputs[frame], bitDepth);
+        if (results) {
+            results[frame] = result;
+        }
+        return result;
+    });
+}
+
+/**
+ * @brief Apply baseline correction in-place (handle)
+ */
+int hubx_baseline_apply_inplace_ex(hubx_baseline_t* handle, unsigned short* data, int bitDepth) {
+    if (!handle) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    return handle->correction.applyCorrectionInPlace(data, bitDepth);
+}
+
+/**
+ * @brief Apply baseline correction with scaling (handle)
+ */
+int hubx_baseline_apply_scale_ex(hubx_baseline_t* handle,
+                                 const unsigned short* input,
+                                 unsigned short* output,
+                                 float scale,
+                                 int bitDepth) {
+    if (!handle) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    return handle->correction.applyCorrectionWithScale(input, output, scale, bitDepth);
+}
+
+/**
+ * @brief Get baseline statistics (handle)
+ */
+int hubx_baseline_statistics_ex(hubx_baseline_t* handle,
+                                float* minBaseline,
+                                float* maxBaseline,
+                                float* avgBaseline) {
+    if (!handle) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    return handle->correction.getStatistics(minBaseline, maxBaseline, avgBaseline);
+}
+
+/**
+ * @brief Save baseline data to file (handle)
+ */
+int hubx_baseline_save_ex(hubx_baseline_t* handle, const char* filename) {
+    if (!handle) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    return handle->correction.saveToFile(filename);
+}
+
+/**
+ * @brief Load baseline data from file (handle)
+ */
+int hubx_baseline_load_ex(hubx_baseline_t* handle, const char* filename) {
+    if (!handle) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    return handle->correction.loadFromFile(filename);
+}
+
+/**
+ * @brief Check if calibrated (handle)
+ */
+int hubx_baseline_is_calibrated_ex(hubx_baseline_t* handle) {
+    if (!handle) {
+        return 0;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    return handle->correction.isCalibrated() ? 1 : 0;
+}
+
+/**
+ * @brief Release baseline correction resources (handle)
+ */
+void hubx_baseline_release_ex(hubx_baseline_t* handle) {
+    if (!handle) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    handle->correction.release();
+}
+
 /**
  * @brief Initialize baseline correction module
  */
 int hubx_baseline_init(int width, int height) {
-    return HubxSDK::Correction::g_baselineCorrection.initialize(width, height);
+    return hubx_baseline_init_ex(&g_baselineCorrection, width, height);
 }
 
 /**
  * @brief Set target baseline value
  */
 int hubx_baseline_set_target(float targetValue, int bitDepth) {
-    return HubxSDK::Correction::g_baselineCorrection.setTargetBaseline(targetValue, bitDepth);
+    return hubx_baseline_set_target_ex(&g_baselineCorrection, targetValue, bitDepth);
 }
 
 /**
  * @brief Calculate baseline from frames
  */
 int hubx_baseline_calculate(const unsigned short** frames, int frameCount, int bitDepth) {
-    return HubxSDK::Correction::g_baselineCorrection.calculateBaseline(frames, frameCount, bitDepth);
+    return hubx_baseline_calculate_ex(&g_baselineCorrection, frames, frameCount, bitDepth);
 }
 
 /**
  * @brief Calculate baseline from line data
  */
 int hubx_baseline_calculate_lines(const unsigned short** lines, int lineCount, int lineWidth, int bitDepth) {
-    return HubxSDK::Correction::g_baselineCorrection.calculateBaselineFromLines(lines, lineCount, lineWidth, bitDepth);
+    return hubx_baseline_calculate_lines_ex(&g_baselineCorrection, lines, lineCount, lineWidth, bitDepth);
+}
+
+/**
+ * @brief Add one frame to the streaming baseline calibration
+ */
+int hubx_baseline_add_frame(const unsigned short* frame) {
+    return hubx_baseline_add_frame_ex(&g_baselineCorrection, frame);
+}
+
+/**
+ * @brief Add lines to the streaming baseline calibration
+ */
+int hubx_baseline_add_lines(const unsigned short* lines, int lineCount, int lineWidth) {
+    return hubx_baseline_add_lines_ex(&g_baselineCorrection, lines, lineCount, lineWidth);
+}
+
+/**
+ * @brief Finish the streaming baseline calibration
+ */
+int hubx_baseline_finalize() {
+    return hubx_baseline_finalize_ex(&g_baselineCorrection);
 }
 
 /**
  * @brief Apply baseline correction
  */
 int hubx_baseline_apply(const unsigned short* input, unsigned short* output, int bitDepth) {
-    return HubxSDK::Correction::g_baselineCorrection.applyCorrection(input, output, bitDepth);
+    return hubx_baseline_apply_ex(&g_baselineCorrection, input, output, bitDepth);
+}
+
+/**
+ * @brief Apply baseline correction to a batch of frames
+ */
+int hubx_baseline_apply_batch(const unsigned short* const* inputs, unsigned short* const* outputs,
+                              int frameCount, int bitDepth, int threads, int* results) {
+    return hubx_baseline_apply_batch_ex(&g_baselineCorrection, inputs, outputs, frameCount,
+                                        bitDepth, threads, results);
 }
 
 /**
  * @brief Apply baseline correction in-place
  */
 int hubx_baseline_apply_inplace(unsigned short* data, int bitDepth) {
-    return HubxSDK::Correction::g_baselineCorrection.applyCorrectionInPlace(data, bitDepth);
+    return hubx_baseline_apply_inplace_ex(&g_baselineCorrection, data, bitDepth);
 }
 
 /**
  * @brief Apply baseline correction with scaling
  */
 int hubx_baseline_apply_scale(const unsigned short* input, unsigned short* output, float scale, int bitDepth) {
-    return HubxSDK::Correction::g_baselineCorrection.applyCorrectionWithScale(input, output, scale, bitDepth);
+    return hubx_baseline_apply_scale_ex(&g_baselineCorrection, input, output, scale, bitDepth);
 }
 
 /**
  * @brief Get baseline statistics
  */
 int hubx_baseline_statistics(float* minBaseline, float* maxBaseline, float* avgBaseline) {
-    return HubxSDK::Correction::g_baselineCorrection.getStatistics(minBaseline, maxBaseline, avgBaseline);
+    return hubx_baseline_statistics_ex(&g_baselineCorrection, minBaseline, maxBaseline, avgBaseline);
 }
 
 /**
  * @brief Save baseline data to file
  */
 int hubx_baseline_save(const char* filename) {
-    return HubxSDK::Correction::g_baselineCorrection.saveToFile(filename);
+    return hubx_baseline_save_ex(&g_baselineCorrection, filename);
 }
 
 /**
  * @brief Load baseline data from file
  */
 int hubx_baseline_load(const char* filename) {
-    return HubxSDK::Correction::g_baselineCorrection.loadFromFile(filename);
+    return hubx_baseline_load_ex(&g_baselineCorrection, filename);
 }
 
 /**
  * @brief Check if calibrated
  */
 int hubx_baseline_is_calibrated() {
-    return HubxSDK::Correction::g_baselineCorrection.isCalibrated() ? 1 : 0;
+    return hubx_baseline_is_calibrated_ex(&g_baselineCorrection);
 }
 
 /**
  * @brief Release baseline correction resources
  */
 void hubx_baseline_release() {
-    HubxSDK::Correction::g_baselineCorrection.release();
+    hubx_baseline_release_ex(&g_baselineCorrection);
 }
 
 } // extern "C"
\ No newline at end of file
@@ -0,0 +1,572 @@
+/**
+ * @file calibration_cache.cpp
+ * @brief In-memory cache of loaded calibration sets keyed by detector operating point
+ * @details Changing integration time, DM gain, energy mode or binning through
+ *          XControl invalidates the loaded offset and gain tables. The cache
+ *          keeps the tables of recently used operating points resident, so
+ *          switching back to a known mode is a lookup instead of a file
+ *          reload. Entries are whatever the loader callback returns, typically
+ *          correction handles (hubx_background_create() and friends) already
+ *          loaded from their calibration files. Least recently used entries are
+ *          evicted once the entry or byte budget is exceeded; entries in use are
+ *          never evicted. Prefetch loads an operating point on a background
+ *          thread before it is needed. Under a memory budget
+ *          (XFactory::SetMemoryBudget()) entries not in use are evicted
+ *          last of the optional caches.
+ *
+ *          The key fields map to XControl reads: XCU_SN, XINT_TIME, XDM_GAIN,
+ *          XHL_MODE and XBIN.
+ *
+ * FXImage 2.1.0 - HubxSDK
+ * Copyright (c) 2025
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../../include/calibration_cache.h"
+#include "../utils/mem_budget.h"
+#include "../utils/thread_policy.h"
+
+// Error codes
+#define HUBX_SUCCESS 0
+#define HUBX_ERROR_INVALID_PARAM -1
+#define HUBX_ERROR_NULL_POINTER -2
+
+namespace HubxSDK {
+namespace Correction {
+
+/**
+ * @struct OperatingPoint
+ * @brief Cache key
+ */
+struct OperatingPoint {
+    std::string serial;
+    uint32_t integrationTime;
+    uint32_t gain;
+    uint32_t energyMode;
+    uint32_t binning;
+
+    explicit OperatingPoint(const hubx_operating_point_t& point)
+        : serial(point.serial ? point.serial : ""),
+          integrationTime(point.integrationTime),
+          gain(point.gain),
+          energyMode(point.energyMode),
+          binning(point.binning) {}
+
+    bool operator<(const OperatingPoint& other) const {
+        if (integrationTime != other.integrationTime) return integrationTime < other.integrationTime;
+        if (gain != other.gain) return gain < other.gain;
+        if (energyMode != other.energyMode) return energyMode < other.energyMode;
+        if (binning != other.binning) return binning < other.binning;
+        return serial < other.serial;
+    }
+
+    hubx_operating_point_t toC() const {
+        hubx_operating_point_t point;
+        point.serial = serial.c_str();
+        point.integrationTime = integrationTime;
+        point.gain = gain;
+        point.energyMode = energyMode;
+        point.binning = binning;
+        return point;
+    }
+};
+
+/**
+ * @class CalibrationCache
+ * @brief LRU cache of calibration sets with background prefetch
+ *
+ * All methods are thread-safe. Loader and free callbacks run without the
+ * cache lock held, so a slow load never blocks hits on other entries.
+ */
+class CalibrationCache {
+public:
+    CalibrationCache(hubx_calib_load_fn load, hubx_calib_free_fn release, void* user)
+        : m_load(load), m_free(release), m_user(user),
+          m_maxEntries(8), m_maxBytes(0), m_bytes(0), m_stopping(false),
+          m_reclaimer(HX::Internal::MemReclaimer::RECLAIM_CALIBRATION,
+                      [this](uint64_t bytes) { return reclaim(bytes); })
+    {
+        resetStatistics();
+        m_reclaimer.add();
+    }
+
+    ~CalibrationCache() {
+        m_reclaimer.remove();
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = true;
+            m_queue.clear();
+        }
+        m_cond.notify_all();
+        if (m_worker.joinable()) {
+            m_worker.join();
+        }
+
+        // Entries still in use are freed too; callers must be done by now
+        for (EntryMap::iterator it = m_entries.begin(); it != m_entries.end(); ++it) {
+            if (it->second->data && m_free) {
+                m_free(it->second->data, m_user);
+            }
+        }
+    }
+
+    /**
+     * @brief Set the eviction budget
+     * @param maxEntries Resident entries allowed (at least 1)
+     * @param maxBytes Resident bytes allowed (0 = no byte limit)
+     * @return HUBX_SUCCESS on success, error code otherwise
+     */
+    int setCapacity(int maxEntries, size_t maxBytes) {
+        if (maxEntries < 1) {
+            return HUBX_ERROR_INVALID_PARAM;
+        }
+        std::vector<void*> evicted;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_maxEntries = static_cast<size_t>(maxEntries);
+            m_maxBytes = maxBytes;
+            evictLocked(evicted);
+        }
+        freeEntries(evicted);
+        return HUBX_SUCCESS;
+    }
+
+    /**
+     * @brief Get the entry of an operating point, loading it on a miss
+     * @return Entry, or nullptr if loading failed; release() it when done
+     *
+     * @note An entry whose prefetch is still running is waited for, not loaded twice.
+     */
+    void* acquire(const OperatingPoint& key) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        for (;;) {
+            EntryMap::iterator it = m_entries.find(key);
+            if (it == m_entries.end()) {
+                break;
+            }
+            Entry* entry = it->second.get();
+            if (entry->loading) {
+                // Prefetch or another acquire is loading it; the entry is
+                // erased again if that load fails, hence the lookup loop
+                m_cond.wait(lock);
+                continue;
+            }
+            ++entry->pins;
+            m_lru.splice(m_lru.begin(), m_lru, entry->lruPos);
+            ++m_stats.hits;
+            return entry->data;
+        }
+
+        ++m_stats.misses;
+        Entry* entry = insertLoadingLocked(key);
+        lock.unlock();
+
+        size_t bytes = 0;
+        void* data = callLoader(key, bytes);
+
+        std::vector<void*> evicted;
+        lock.lock();
+        if (!finishLoadLocked(key, entry, data, bytes, true)) {
+            lock.unlock();
+            m_cond.notify_all();
+            return nullptr;
+        }
+        evictLocked(evicted);
+        lock.unlock();
+        m_cond.notify_all();
+        freeEntries(evicted);
+        return data;
+    }
+
+    /**
+     * @brief Release an entry returned by acquire()
+     * @return HUBX_SUCCESS on success, error code if the entry is unknown
+     */
+    int release(void* data) {
+        if (!data) {
+            return HUBX_ERROR_NULL_POINTER;
+        }
+        std::vector<void*> evicted;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            std::map<void*, Entry*>::iterator it = m_byData.find(data);
+            if (it == m_byData.end() || it->second->pins == 0) {
+                return HUBX_ERROR_INVALID_PARAM;
+            }
+            --it->second->pins;
+            evictLocked(evicted);
+        }
+        freeEntries(evicted);
+        return HUBX_SUCCESS;
+    }
+
+    /**
+     * @brief Load an operating point in the background
+     * @return HUBX_SUCCESS if queued or already resident
+     */
+    int prefetch(const OperatingPoint& key) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_stopping) {
+                return HUBX_ERROR_INVALID_PARAM;
+            }
+            if (m_entries.find(key) != m_entries.end()) {
+                return HUBX_SUCCESS;
+            }
+            insertLoadingLocked(key);
+            m_queue.push_back(key);
+            ++m_stats.prefetches;
+            if (!m_worker.joinable()) {
+                m_worker = std::thread(&CalibrationCache::prefetchThread, this);
+            }
+        }
+        m_cond.notify_all();
+        return HUBX_SUCCESS;
+    }
+
+    /**
+     * @brief Drop one operating point
+     * @return HUBX_SUCCESS if dropped or absent, error code if in use or loading
+     */
+    int evict(const OperatingPoint& key) {
+        void* data = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            EntryMap::iterator it = m_entries.find(key);
+            if (it == m_entries.end()) {
+                return HUBX_SUCCESS;
+            }
+            if (it->second->loading || it->second->pins > 0) {
+                return HUBX_ERROR_INVALID_PARAM;
+            }
+            data = removeLocked(it);
+        }
+        freeEntries(std::vector<void*>(1, data));
+        return HUBX_SUCCESS;
+    }
+
+    /**
+     * @brief Drop every entry not in use
+     */
+    void clear() {
+        std::vector<void*> evicted;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            EntryMap::iterator it = m_entries.begin();
+            while (it != m_entries.end()) {
+                EntryMap::iterator next = it;
+                ++next;
+                if (!it->second->loading && it->second->pins == 0) {
+                    evicted.push_back(removeLocked(it));
+                }
+                it = next;
+            }
+        }
+        freeEntries(evicted);
+    }
+
+    void getStatistics(hubx_calib_cache_stats_t& stats) const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        stats = m_stats;
+        stats.entries = static_cast<uint32_t>(m_lru.size());
+        stats.bytes = m_bytes;
+    }
+
+private:
+    struct Entry {
+        void* data;
+        size_t bytes;
+        uint32_t pins;
+        bool loading;
+        std::list<OperatingPoint>::iterator lruPos;
+
+        Entry() : data(nullptr), bytes(0), pins(0), loading(true) {}
+    };
+
+    typedef std::map<OperatingPoint, std::unique_ptr<Entry> > EntryMap;
+
+    void resetStatistics() {
+        m_stats.hits = 0;
+        m_stats.misses = 0;
+        m_stats.prefetches = 0;
+        m_stats.evictions = 0;
+        m_stats.loadFailures = 0;
+        m_stats.entries = 0;
+        m_stats.bytes = 0;
+    }
+
+    Entry* insertLoadingLocked(const OperatingPoint& key) {
+        Entry* entry = new Entry();
+        m_entries[key].reset(entry);
+        return entry;
+    }
+
+    void* callLoader(const OperatingPoint& key, size_t& bytes) {
+        if (!m_load) {
+            return nullptr;
+        }
+        hubx_operating_point_t point = key.toC();
+        return m_load(&point, m_user, &bytes);
+    }
+
+    /**
+     * @brief Publish a finished load; erases the entry if the load failed
+     */
+    bool finishLoadLocked(const OperatingPoint& key, Entry* entry, void* data, size_t bytes, bool pin) {
+        if (!data) {
+            ++m_stats.loadFailures;
+            m_entries.erase(key);
+            return false;
+        }
+        entry->data = data;
+        entry->bytes = bytes;
+        entry->loading = false;
+        entry->pins = pin ? 1 : 0;
+        m_lru.push_front(key);
+        entry->lruPos = m_lru.begin();
+        m_byData[data] = entry;
+        m_bytes += bytes;
+        return true;
+    }
+
+    void* removeLocked(EntryMap::iterator it) {
+        Entry* entry = it->second.get();
+        void* data = entry->data;
+        m_bytes -= entry->bytes;
+        m_lru.erase(entry->lruPos);
+        m_byData.erase(data);
+        m_entries.erase(it);
+        return data;
+    }
+
+    /**
+     * @brief Evict least recently used entries not in use until within budget
+     */
+    void evictLocked(std::vector<void*>& evicted) {
+        std::list<OperatingPoint>::iterator pos = m_lru.end();
+        while ((m_lru.size() > m_maxEntries || (m_maxBytes && m_bytes > m_maxBytes)) &&
+               pos != m_lru.begin()) {
+            --pos;
+            EntryMap::iterator it = m_entries.find(*pos);
+            if (it->second->pins > 0) {
+                continue;
+            }
+            std::list<OperatingPoint>::iterator prev = pos;
+            ++prev;
+            evicted.push_back(removeLocked(it));
+            ++m_stats.evictions;
+            pos = prev;
+        }
+    }
+
+    /**
+     * @brief Evict least recently used entries not in use for the memory budget
+     * @return Bytes of the evicted entries, as the loader reported them
+     */
+    uint64_t reclaim(uint64_t bytes) {
+        std::vector<void*> evicted;
+        uint64_t released = 0;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            std::list<OperatingPoint>::iterator pos = m_lru.end();
+            while (released < bytes && pos != m_lru.begin()) {
+                --pos;
+                EntryMap::iterator it = m_entries.find(*pos);
+                if (it->second->pins > 0) {
+                    continue;
+                }
+                std::list<OperatingPoint>::iterator prev = pos;
+                ++prev;
+                released += it->second->bytes;
+                evicted.push_back(removeLocked(it));
+                ++m_stats.evictions;
+                pos = prev;
+            }
+        }
+        freeEntries(evicted);
+        return released;
+    }
+
+    void freeEntries(const std::vector<void*>& entries) {
+        if (!m_free) {
+            return;
+        }
+        for (size_t i = 0; i < entries.size(); ++i) {
+            m_free(entries[i], m_user);
+        }
+    }
+
+    void prefetchThread() {
+        HX::Internal::ApplyThreadPolicy(HX::XFactory::THREAD_CORRECTION);
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        for (;;) {
+            m_cond.wait(lock, [this] { return m_stopping || !m_queue.empty(); });
+            if (m_stopping) {
+                return;
+            }
+            OperatingPoint key = m_queue.front();
+            m_queue.pop_front();
+            Entry* entry = m_entries[key].get();
+            lock.unlock();
+
+            size_t bytes = 0;
+            void* data = callLoader(key, bytes);
+
+            std::vector<void*> evicted;
+            lock.lock();
+            if (finishLoadLocked(key, entry, data, bytes, false)) {
+                evictLocked(evicted);
+            }
+            m_cond.notify_all();
+            if (!evicted.empty()) {
+                lock.unlock();
+                freeEntries(evicted);
+                lock.lock();
+            }
+        }
+    }
+
+    hubx_calib_load_fn m_load;
+    hubx_calib_free_fn m_free;
+    void* m_user;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_cond;     // Load finished, or prefetch queued
+    EntryMap m_entries;
+    std::map<void*, Entry*> m_byData;
+    std::list<OperatingPoint> m_lru;    // Resident entries, most recent first
+    size_t m_maxEntries;
+    size_t m_maxBytes;
+    uint64_t m_bytes;
+    hubx_calib_cache_stats_t m_stats;
+
+    std::deque<OperatingPoint> m_queue; // Keys waiting for the prefetch thread
+    std::thread m_worker;
+    bool m_stopping;
+    HX::Internal::MemReclaimer m_reclaimer;
+};
+
+} // namespace Correction
+} // namespace HubxSDK
+
+/**
+ * @brief Calibration cache behind a C API handle; calls are thread-safe
+ */
+struct hubx_calib_cache_t {
+    HubxSDK::Correction::CalibrationCache cache;
+
+    hubx_calib_cache_t(hubx_calib_load_fn load, hubx_calib_free_fn release, void* user)
+        : cache(load, release, user) {}
+};
+
+// C-style API
+extern "C" {
+
+/**
+ * @brief Create a calibration cache
+ * @param load Loader called on a miss or prefetch
+ * @param release Called for every entry the cache drops
+ * @param user Passed to both callbacks
+ * @return Handle, or NULL on invalid parameters or out of memory
+ */
+hubx_calib_cache_t* hubx_calib_cache_create(hubx_calib_load_fn load,
+                                            hubx_calib_free_fn release,
+                                            void* user) {
+    if (!load) {
+        return nullptr;
+    }
+    return new (std::nothrow) hubx_calib_cache_t(load, release, user);
+}
+
+/**
+ * @brief Destroy a cache and free every entry, including ones still acquired
+ */
+void hubx_calib_cache_destroy(hubx_calib_cache_t* handle) {
+    delete handle;
+}
+
+/**
+ * @brief Set entry and byte budget (default 8 entries, no byte limit)
+ */
+int hubx_calib_cache_set_capacity(hubx_calib_cache_t* handle, int maxEntries, size_t maxBytes) {
+    if (!handle) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    return handle->cache.setCapacity(maxEntries, maxBytes);
+}
+
+/**
+ * @brief Get the calibration set of an operating point
+ * @return Entry, or NULL if loading failed; pass it to hubx_calib_cache_release()
+ */
+void* hubx_calib_cache_acquire(hubx_calib_cache_t* handle, const hubx_operating_point_t* point) {
+    if (!handle || !point) {
+        return nullptr;
+    }
+    return handle->cache.acquire(HubxSDK::Correction::OperatingPoint(*point));
+}
+
+/**
+ * @brief Release an acquired entry
+ */
+int hubx_calib_cache_release(hubx_calib_cache_t* handle, void* entry) {
+    if (!handle) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    return handle->cache.release(entry);
+}
+
+/**
+ * @brief Load an operating point in the background
+ */
+int hubx_calib_cache_prefetch(hubx_calib_cache_t* handle, const hubx_operating_point_t* point) {
+    if (!handle || !point) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    return handle->cache.prefetch(HubxSDK::Correction::OperatingPoint(*point));
+}
+
+/**
+ * @brief Drop one operating point, e.g. after recalibrating it
+ */
+int hubx_calib_cache_evict(hubx_calib_cache_t* handle, const hubx_operating_point_t* point) {
+    if (!handle || !point) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    return handle->cache.evict(HubxSDK::Correction::OperatingPoint(*point));
+}
+
+/**
+ * @brief Drop every entry not currently acquired
+ */
+void hubx_calib_cache_clear(hubx_calib_cache_t* handle) {
+    if (handle) {
+        handle->cache.clear();
+    }
+}
+
+/**
+ * @brief Get cache counters
+ */
+int hubx_calib_cache_get_stats(hubx_calib_cache_t* handle, hubx_calib_cache_stats_t* stats) {
+    if (!handle || !stats) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    handle->cache.getStatistics(*stats);
+    return HUBX_SUCCESS;
+}
+
+} // extern "C"
@@ -0,0 +1,1672 @@
+/**
+ * @file correction_pipeline.cpp
+ * @brief Ordered correction stages executed in fused passes over row bands
+ * @details Pointwise stages (background, baseline, gain, multi-gain) and
+ *          row-local remaps (PDC, defect replacement) run back to back on one row held in a float
+ *          buffer, so a frame is read and written once per pass rather than
+ *          once per stage. Only stages that need neighbouring rows (smoothing)
+ *          end a pass. The same passes can run on an OpenCL device
+ *          (setDevice()), with the coefficients kept on the device.
+ *          Common stage lists at the installed detector widths run a
+ *          pass compiled for that width, depth and stage set instead.
+ *
+ * FXImage 2.1.0 - HubxSDK
+ * Copyright (c) 2025
+ */
+
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <utility>
+
+#include "../utils/box_filter.h"
+#include "../utils/latency_trace.h"
+#include "../utils/opencl_api.h"
+#include "../utils/perf_counters.h"
+#include "../utils/thread_pool.h"
+
+// Error codes
+#define HUBX_SUCCESS 0
+#define HUBX_ERROR_INVALID_PARAM -1
+#define HUBX_ERROR_NULL_POINTER -2
+#define HUBX_ERROR_BUFFER_SIZE -3
+#define HUBX_ERROR_CALCULATION -4
+#define HUBX_ERROR_DEVICE -6
+
+namespace HubxSDK {
+namespace Correction {
+
+/**
+ * @enum StageType
+ * @brief Correction stages a pipeline can hold
+ */
+enum StageType {
+    STAGE_BACKGROUND = 0,   // y = k(x - x0) + b, x0 float map, k scalar or map
+    STAGE_BASELINE,         // y = x + c
+    STAGE_GAIN,             // y = k(x - x0) + b, x0 16-bit map (single gain)
+    STAGE_MULTI_GAIN,       // Per-pixel gain mode selected by thresholds
+    STAGE_REMAP,            // Row resample, out[x] = lerp(in[i], in[i + 1], w)
+    STAGE_DEFECT,           // row[d] = sum w * row[n] over a defect's row neighbours
+    STAGE_SMOOTH            // Box mean, needs neighbouring rows
+};
+
+/**
+ * @struct PipelineStage
+ * @brief One stage; maps are not copied and must outlive the pipeline
+ */
+struct PipelineStage {
+    StageType type;
+    int inputWidth;                     // Row width entering the stage
+    int outputWidth;                    // Row width leaving the stage
+    const float* offsetMap;             // BACKGROUND
+    const float* gainMap;               // BACKGROUND (optional), GAIN
+    const unsigned short* offset16;     // GAIN (optional)
+    const float* coefficients;          // BASELINE
+    float gain;
+    float bias;
+    int numGains;                       // MULTI_GAIN
+    unsigned short thresholds[8];
+    const unsigned short* modeOffsets[8];
+    const float* modeGains[8];
+    const unsigned short* baseline16;   // MULTI_GAIN (optional)
+    const int* sourceIndex;             // REMAP
+    const float* weight;
+    int radius;                         // SMOOTH
+    int defectRows;                     // DEFECT: map rows, 1 = same list every row
+    const int* defectIndex;             // Map pixel of each defect
+    const int* defectFirst;             // Neighbours of defect e: [first[e], first[e + 1])
+    const int* defectNeighbor;
+    const float* defectWeight;
+    std::vector<int> defectRowStart;    // First defect of each map row, plus the end
+
+    PipelineStage()
+        : type(STAGE_BASELINE), inputWidth(0), outputWidth(0),
+          offsetMap(nullptr), gainMap(nullptr), offset16(nullptr), coefficients(nullptr),
+          gain(1.0f), bias(0.0f), numGains(0), baseline16(nullptr),
+          sourceIndex(nullptr), weight(nullptr), radius(0), defectRows(0),
+          defectIndex(nullptr), defectFirst(nullptr), defectNeighbor(nullptr), defectWeight(nullptr)
+    {
+        std::memset(thresholds, 0, sizeof(thresholds));
+        std::memset(modeOffsets, 0, sizeof(modeOffsets));
+        std::memset(modeGains, 0, sizeof(modeGains));
+    }
+};
+
+/// Command queues a frame is spread over; copies on one overlap compute on the others
+const int GPU_LANES = 3;
+
+/// Fewest rows per band, so a band is worth a transfer
+const int GPU_MIN_BAND_ROWS = 16;
+
+/**
+ * @brief Stage kernels; each one stores as the CPU stage does
+ *
+ * Contraction is off so every multiply and add rounds on its own, as
+ * they do on the CPU, and the frames match bit for bit.
+ */
+const char* const GPU_KERNELS =
+    "#pragma OPENCL FP_CONTRACT OFF\n"
+    "inline float store(float v, float maxValue) {\n"
+    "    v = fmax(0.0f, fmin(maxValue, v));\n"
+    "    return (float)(int)(v + 0.5f);\n"
+    "}\n"
+    "__kernel void load16(__global const ushort* in, __global float* row, int width) {\n"
+    "    size_t i = get_global_id(1) * width + get_global_id(0);\n"
+    "    row[i] = (float)in[i];\n"
+    "}\n"
+    "__kernel void store16(__global const float* row, __global ushort* out, int width) {\n"
+    "    size_t i = get_global_id(1) * width + get_global_id(0);\n"
+    "    out[i] = (ushort)row[i];\n"
+    "}\n"
+    "__kernel void background(__global float* row, __global const float* x0, __global const float* k,\n"
+    "                         int hasGainMap, float gain, float bias, int width, int y0, float maxValue) {\n"
+    "    size_t i = get_global_id(1) * width + get_global_id(0);\n"
+    "    size_t m = (y0 + get_global_id(1)) * (size_t)width + get_global_id(0);\n"
+    "    float g = hasGainMap ? k[m] : gain;\n"
+    "    row[i] = store(g * (row[i] - x0[m]) + bias, maxValue);\n"
+    "}\n"
+    "__kernel void baseline(__global float* row, __global const float* c, int width, int y0,\n"
+    "                       float maxValue) {\n"
+    "    size_t i = get_global_id(1) * width + get_global_id(0);\n"
+    "    size_t m = (y0 + get_global_id(1)) * (size_t)width + get_global_id(0);\n"
+    "    row[i] = store(row[i] + c[m], maxValue);\n"
+    "}\n"
+    "__kernel void gain(__global float* row, __global const float* k, __global const ushort* x0,\n"
+    "                   int hasOffset, float bias, int width, int y0, float maxValue) {\n"
+    "    size_t i = get_global_id(1) * width + get_global_id(0);\n"
+    "    size_t m = (y0 + get_global_id(1)) * (size_t)width + get_global_id(0);\n"
+    "    float v = hasOffset ? row[i] - (float)x0[m] : row[i];\n"
+    "    row[i] = store(k[m] * v + bias, maxValue);\n"
+    "}\n"
+    "__kernel void multiGain(__global float* row, __global const ushort* offsets,\n"
+    "                        __global const float* gains, __global const ushort* base, int hasBase,\n"
+    "                        __constant ushort* thresholds, int numGains, ulong pixels, int width,\n"
+    "                        int y0, float maxValue) {\n"
+    "    size_t i = get_global_id(1) * width + get_global_id(0);\n"
+    "    size_t m = (y0 + get_global_id(1)) * (size_t)width + get_global_id(0);\n"
+    "    float v = row[i];\n"
+    "    int mode = numGains - 1;\n"
+    "    for (int g = 0; g < numGains - 1; ++g) {\n"
+    "        if (v < (float)thresholds[g]) { mode = g; break; }\n"
+    "    }\n"
+    "    float result = v - (float)offsets[mode * pixels + m];\n"
+    "    result -= hasBase ? (float)base[m] : 0.0f;\n"
+    "    result *= gains[mode * pixels + m];\n"
+    "    row[i] = store(result, maxValue);\n"
+    "}\n"
+    "__kernel void remap(__global const float* in, __global float* out, __global const int* source,\n"
+    "                    __global const float* weight, int inWidth, int outWidth, float maxValue) {\n"
+    "    size_t x = get_global_id(0);\n"
+    "    size_t r = get_global_id(1);\n"
+    "    float v0 = in[r * inWidth + source[x]];\n"
+    "    float v1 = in[r * inWidth + source[x] + 1];\n"
+    "    out[r * outWidth + x] = store(v0 + weight[x] * (v1 - v0), maxValue);\n"
+    "}\n"
+    "__kernel void defects(__global float* row, __global const int* index, __global const int* first,\n"
+    "                      __global const int* neighbor, __global const float* weight, int width,\n"
+    "                      int y0, int everyRow, int e0, float maxValue) {\n"
+    "    int e = e0 + (int)get_global_id(0);\n"
+    "    int mapRow = everyRow ? 0 : index[e] / width;\n"
+    "    int r = everyRow ? (int)get_global_id(1) : mapRow - y0;\n"
+    "    __global float* line = row + (size_t)r * width;\n"
+    "    int base = mapRow * width;\n"
+    "    float sum = 0.0f;\n"
+    "    for (int k = first[e]; k < first[e + 1]; ++k) {\n"
+    "        sum += weight[k] * line[neighbor[k] - base];\n"
+    "    }\n"
+    "    line[index[e] - base] = store(sum, maxValue);\n"
+    "}\n";
+
+/**
+ * @class GpuExecutor
+ * @brief Runs the fused stages on an OpenCL device
+ *
+ * Coefficient maps are copied to the device once per stage list and stay
+ * there. A frame is cut into row bands dealt round-robin to GPU_LANES
+ * in-order queues; each band is uploaded, corrected and read back on its
+ * own queue, so one band's transfers overlap the next band's kernels.
+ * Buffers from allocHost() are pinned, which lets the driver DMA straight
+ * from them instead of staging the frame.
+ */
+class GpuExecutor {
+public:
+    GpuExecutor()
+        : m_cl(HX::Internal::LoadOpenCL()),
+          m_context(nullptr),
+          m_program(nullptr),
+          m_width(0),
+          m_height(0),
+          m_maxValue(0.0f),
+          m_bandRows(0),
+          m_uploadFailed(false),
+          m_failed(false)
+    {
+        std::memset(m_kernels, 0, sizeof(m_kernels));
+        std::memset(m_lanes, 0, sizeof(m_lanes));
+    }
+
+    ~GpuExecutor() {
+        close();
+    }
+
+    /**
+     * @brief Number of usable devices
+     */
+    static int deviceCount() {
+        return HX::Internal::ListOpenCLDevices(nullptr, 0);
+    }
+
+    /**
+     * @brief Name of device index
+     */
+    static int deviceName(int index, char* name, int size) {
+        const HX::Internal::OpenCLApi* cl = HX::Internal::LoadOpenCL();
+        HX::Internal::cl_device_id device = findDevice(index);
+        if (!cl || !device) {
+            return HUBX_ERROR_INVALID_PARAM;
+        }
+        if (cl->getDeviceInfo(device, HX::Internal::HX_CL_DEVICE_NAME, size, name, nullptr) !=
+            HX::Internal::HX_CL_SUCCESS) {
+            return HUBX_ERROR_BUFFER_SIZE;
+        }
+        return HUBX_SUCCESS;
+    }
+
+    /**
+     * @brief Create context, queues and kernels on device index
+     */
+    int open(int index) {
+        using namespace HX::Internal;
+        close();
+        cl_device_id device = findDevice(index);
+        if (!m_cl || !device) {
+            return HUBX_ERROR_DEVICE;
+        }
+
+        cl_int error = HX_CL_SUCCESS;
+        m_context = m_cl->createContext(nullptr, 1, &device, nullptr, nullptr, &error);
+        if (!m_context) {
+            return HUBX_ERROR_DEVICE;
+        }
+        for (int l = 0; l < GPU_LANES; ++l) {
+            m_lanes[l].queue = m_cl->createCommandQueue(m_context, device, 0, &error);
+            if (!m_lanes[l].queue) {
+                close();
+                return HUBX_ERROR_DEVICE;
+            }
+        }
+
+        const char* source = GPU_KERNELS;
+        m_program = m_cl->createProgramWithSource(m_context, 1, &source, nullptr, &error);
+        if (!m_program || m_cl->buildProgram(m_program, 1, &device, "", nullptr, nullptr) != HX_CL_SUCCESS) {
+            close();
+            return HUBX_ERROR_DEVICE;
+        }
+        static const char* const names[KERNEL_COUNT] = {
+            "load16", "store16", "background", "baseline", "gain", "multiGain", "remap", "defects"
+        };
+        for (int k = 0; k < KERNEL_COUNT; ++k) {
+            m_kernels[k] = m_cl->createKernel(m_program, names[k], &error);
+            if (!m_kernels[k]) {
+                close();
+                return HUBX_ERROR_DEVICE;
+            }
+        }
+        return HUBX_SUCCESS;
+    }
+
+    void close() {
+        releaseStages();
+        releaseLaneBuffers();
+        while (!m_hostBuffers.empty()) {
+            freeHost(m_hostBuffers.back().first);
+        }
+        if (!m_cl) {
+            return;
+        }
+        for (int k = 0; k < KERNEL_COUNT; ++k) {
+            if (m_kernels[k]) {
+                m_cl->releaseKernel(m_kernels[k]);
+                m_kernels[k] = nullptr;
+            }
+        }
+        if (m_program) {
+            m_cl->releaseProgram(m_program);
+            m_program = nullptr;
+        }
+        for (int l = 0; l < GPU_LANES; ++l) {
+            if (m_lanes[l].queue) {
+                m_cl->releaseCommandQueue(m_lanes[l].queue);
+                m_lanes[l].queue = nullptr;
+            }
+        }
+        if (m_context) {
+            m_cl->releaseContext(m_context);
+            m_context = nullptr;
+        }
+    }
+
+    /**
+     * @brief Copy the coefficients of every stage to the device
+     */
+    int prepare(int width, int height, float maxValue, const std::vector<PipelineStage>& stages) {
+        releaseStages();
+        releaseLaneBuffers();
+        m_width = width;
+        m_height = height;
+        m_maxValue = maxValue;
+        m_stages = stages;
+        m_buffers.assign(stages.size(), StageBuffers());
+
+        int maxWidth = width;
+        for (size_t s = 0; s < stages.size(); ++s) {
+            const PipelineStage& stage = stages[s];
+            const size_t pixels = static_cast<size_t>(stage.inputWidth) * height;
+            HX::Internal::cl_mem* maps = m_buffers[s].maps;
+            maxWidth = std::max(maxWidth, stage.outputWidth);
+
+            switch (stage.type) {
+                case STAGE_BACKGROUND:
+                    maps[0] = upload(stage.offsetMap, pixels * sizeof(float));
+                    maps[1] = stage.gainMap ? upload(stage.gainMap, pixels * sizeof(float)) : nullptr;
+                    break;
+                case STAGE_BASELINE:
+                    maps[0] = upload(stage.coefficients, pixels * sizeof(float));
+                    break;
+                case STAGE_GAIN:
+                    maps[0] = upload(stage.gainMap, pixels * sizeof(float));
+                    maps[1] = stage.offset16 ? upload(stage.offset16, pixels * sizeof(unsigned short)) : nullptr;
+                    break;
+                case STAGE_MULTI_GAIN: {
+                    // Modes back to back, mode m at m * pixels
+                    std::vector<unsigned short> offsets(pixels * stage.numGains);
+                    std::vector<float> gains(pixels * stage.numGains);
+                    for (int m = 0; m < stage.numGains; ++m) {
+                        std::memcpy(&offsets[m * pixels], stage.modeOffsets[m], pixels * sizeof(unsigned short));
+                        std::memcpy(&gains[m * pixels], stage.modeGains[m], pixels * sizeof(float));
+                    }
+                    maps[0] = upload(offsets.data(), offsets.size() * sizeof(unsigned short));
+                    maps[1] = upload(gains.data(), gains.size() * sizeof(float));
+                    maps[2] = stage.baseline16 ? upload(stage.baseline16, pixels * sizeof(unsigned short)) : nullptr;
+                    maps[3] = upload(stage.thresholds, sizeof(stage.thresholds));
+                    break;
+                }
+                case STAGE_REMAP:
+                    maps[0] = upload(stage.sourceIndex, stage.outputWidth * sizeof(int));
+                    maps[1] = upload(stage.weight, stage.outputWidth * sizeof(float));
+                    break;
+                case STAGE_DEFECT: {
+                    const int count = stage.defectRowStart.back();
+                    if (count > 0) {
+                        const size_t links = static_cast<size_t>(stage.defectFirst[count]);
+                        maps[0] = upload(stage.defectIndex, count * sizeof(int));
+                        maps[1] = upload(stage.defectFirst, (count + 1) * sizeof(int));
+                        maps[2] = upload(stage.defectNeighbor, std::max<size_t>(links, 1) * sizeof(int));
+                        maps[3] = upload(stage.defectWeight, std::max<size_t>(links, 1) * sizeof(float));
+                    }
+                    break;
+                }
+                default:
+                    // A smooth needs whole frames; setDevice() keeps it out
+                    return HUBX_ERROR_INVALID_PARAM;
+            }
+            if (m_uploadFailed) {
+                releaseStages();
+                return HUBX_ERROR_DEVICE;
+            }
+        }
+
+        // Enough bands for every lane to have a few
+        m_bandRows = std::max(GPU_MIN_BAND_ROWS, (height + GPU_LANES * 2 - 1) / (GPU_LANES * 2));
+        m_bandRows = std::min(m_bandRows, height);
+        const int outWidth = stages.empty() ? width : stages.back().outputWidth;
+        for (int l = 0; l < GPU_LANES; ++l) {
+            Lane& lane = m_lanes[l];
+            lane.input = allocate(static_cast<size_t>(m_bandRows) * width * sizeof(unsigned short));
+            lane.rowA = allocate(static_cast<size_t>(m_bandRows) * maxWidth * sizeof(float));
+            lane.rowB = allocate(static_cast<size_t>(m_bandRows) * maxWidth * sizeof(float));
+            lane.output = allocate(static_cast<size_t>(m_bandRows) * outWidth * sizeof(unsigned short));
+            if (!lane.input || !lane.rowA || !lane.rowB || !lane.output) {
+                releaseStages();
+                releaseLaneBuffers();
+                return HUBX_ERROR_DEVICE;
+            }
+        }
+        return HUBX_SUCCESS;
+    }
+
+    /**
+     * @brief Correct one frame, band by band over the lanes
+     */
+    int run(const unsigned short* input, unsigned short* output) {
+        using namespace HX::Internal;
+        const int outWidth = m_stages.empty() ? m_width : m_stages.back().outputWidth;
+        m_failed = false;
+
+        for (int y0 = 0, band = 0; y0 < m_height; y0 += m_bandRows, ++band) {
+            Lane& lane = m_lanes[band % GPU_LANES];
+            const int rows = std::min(m_bandRows, m_height - y0);
+
+            check(m_cl->enqueueWriteBuffer(lane.queue, lane.input, HX_CL_FALSE, 0,
+                                           static_cast<size_t>(rows) * m_width * sizeof(unsigned short),
+                                           input + static_cast<size_t>(y0) * m_width, 0, nullptr, nullptr));
+
+            cl_mem row = lane.rowA;
+            cl_mem spare = lane.rowB;
+            cl_kernel load = m_kernels[KERNEL_LOAD];
+            setArgs(load, lane.input, row, m_width);
+            enqueue(lane.queue, load, m_width, rows);
+
+            for (size_t s = 0; s < m_stages.size(); ++s) {
+                if (enqueueStage(lane.queue, s, y0, rows, row, spare)) {
+                    std::swap(row, spare);
+                }
+            }
+
+            cl_kernel store = m_kernels[KERNEL_STORE];
+            setArgs(store, row, lane.output, outWidth);
+            enqueue(lane.queue, store, outWidth, rows);
+            check(m_cl->enqueueReadBuffer(lane.queue, lane.output, HX_CL_FALSE, 0,
+                                          static_cast<size_t>(rows) * outWidth * sizeof(unsigned short),
+                                          output + static_cast<size_t>(y0) * outWidth, 0, nullptr, nullptr));
+            m_cl->flush(lane.queue);
+        }
+
+        for (int l = 0; l < GPU_LANES; ++l) {
+            check(m_cl->finish(m_lanes[l].queue));
+        }
+        return m_failed ? HUBX_ERROR_DEVICE : HUBX_SUCCESS;
+    }
+
+    /**
+     * @brief Pinned host buffer, e.g. for frame pools feeding run()
+     */
+    void* allocHost(size_t bytes) {
+        using namespace HX::Internal;
+        if (!m_context || bytes == 0) {
+            return nullptr;
+        }
+        cl_int error = HX_CL_SUCCESS;
+        cl_mem buffer = m_cl->createBuffer(m_context, HX_CL_MEM_READ_WRITE | HX_CL_MEM_ALLOC_HOST_PTR,
+                                           bytes, nullptr, &error);
+        if (!buffer) {
+            return nullptr;
+        }
+        void* host = m_cl->enqueueMapBuffer(m_lanes[0].queue, buffer, HX_CL_TRUE,
+                                            HX_CL_MAP_READ | HX_CL_MAP_WRITE, 0, bytes,
+                                            0, nullptr, nullptr, &error);
+        if (!host) {
+            m_cl->releaseMemObject(buffer);
+            return nullptr;
+        }
+        m_hostBuffers.push_back(std::make_pair(host, buffer));
+        return host;
+    }
+
+    int freeHost(void* host) {
+        for (size_t i = 0; i < m_hostBuffers.size(); ++i) {
+            if (m_hostBuffers[i].first == host) {
+                HX::Internal::cl_mem buffer = m_hostBuffers[i].second;
+                m_cl->enqueueUnmapMemObject(m_lanes[0].queue, buffer, host, 0, nullptr, nullptr);
+                m_cl->finish(m_lanes[0].queue);
+                m_cl->releaseMemObject(buffer);
+                m_hostBuffers.erase(m_hostBuffers.begin() + i);
+                return HUBX_SUCCESS;
+            }
+        }
+        return HUBX_ERROR_INVALID_PARAM;
+    }
+
+private:
+    enum Kernel {
+        KERNEL_LOAD = 0, KERNEL_STORE, KERNEL_BACKGROUND, KERNEL_BASELINE, KERNEL_GAIN,
+        KERNEL_MULTI_GAIN, KERNEL_REMAP, KERNEL_DEFECTS, KERNEL_COUNT
+    };
+
+    /// Device copies of one stage's maps, by stage type (see prepare())
+    struct StageBuffers {
+        HX::Internal::cl_mem maps[4];
+        StageBuffers() { std::memset(maps, 0, sizeof(maps)); }
+    };
+
+    /// One queue and the band buffers only it uses
+    struct Lane {
+        HX::Internal::cl_command_queue queue;
+        HX::Internal::cl_mem input;
+        HX::Internal::cl_mem rowA;
+        HX::Internal::cl_mem rowB;
+        HX::Internal::cl_mem output;
+    };
+
+    static HX::Internal::cl_device_id findDevice(int index) {
+        const int count = HX::Internal::ListOpenCLDevices(nullptr, 0);
+        if (index < 0 || index >= count) {
+            return nullptr;
+        }
+        std::vector<HX::Internal::cl_device_id> devices(count);
+        HX::Internal::ListOpenCLDevices(devices.data(), count);
+        return devices[index];
+    }
+
+    HX::Internal::cl_mem upload(const void* data, size_t bytes) {
+        HX::Internal::cl_int error = HX::Internal::HX_CL_SUCCESS;
+        HX::Internal::cl_mem buffer = m_cl->createBuffer(
+            m_context, HX::Internal::HX_CL_MEM_READ_ONLY | HX::Internal::HX_CL_MEM_COPY_HOST_PTR,
+            bytes, const_cast<void*>(data), &error);
+        m_uploadFailed = m_uploadFailed || !buffer;
+        return buffer;
+    }
+
+    HX::Internal::cl_mem allocate(size_t bytes) {
+        HX::Internal::cl_int error = HX::Internal::HX_CL_SUCCESS;
+        return m_cl->createBuffer(m_context, HX::Internal::HX_CL_MEM_READ_WRITE, bytes, nullptr, &error);
+    }
+
+    void releaseStages() {
+        for (size_t s = 0; s < m_buffers.size(); ++s) {
+            for (int m = 0; m < 4; ++m) {
+                if (m_buffers[s].maps[m]) {
+                    m_cl->releaseMemObject(m_buffers[s].maps[m]);
+                }
+            }
+        }
+        m_buffers.clear();
+        m_stages.clear();
+        m_uploadFailed = false;
+    }
+
+    void releaseLaneBuffers() {
+        for (int l = 0; l < GPU_LANES; ++l) {
+            HX::Internal::cl_mem* buffers[4] = {
+                &m_lanes[l].input, &m_lanes[l].rowA, &m_lanes[l].rowB, &m_lanes[l].output
+            };
+            for (int b = 0; b < 4; ++b) {
+                if (*buffers[b]) {
+                    m_cl->releaseMemObject(*buffers[b]);
+                    *buffers[b] = nullptr;
+                }
+            }
+        }
+    }
+
+    void check(HX::Internal::cl_int result) {
+        m_failed = m_failed || result != HX::Internal::HX_CL_SUCCESS;
+    }
+
+    template <typename T>
+    void setArg(HX::Internal::cl_kernel kernel, HX::Internal::cl_uint index, const T& value) {
+        check(m_cl->setKernelArg(kernel, index, sizeof(T), &value));
+    }
+
+    template <typename A, typename B, typename C>
+    void setArgs(HX::Internal::cl_kernel kernel, const A& a, const B& b, const C& c) {
+        setArg(kernel, 0, a);
+        setArg(kernel, 1, b);
+        setArg(kernel, 2, c);
+    }
+
+    void enqueue(HX::Internal::cl_command_queue queue, HX::Internal::cl_kernel kernel,
+                 size_t columns, size_t rows) {
+        const size_t global[2] = { columns, rows };
+        check(m_cl->enqueueNDRangeKernel(queue, kernel, 2, nullptr, global, nullptr, 0, nullptr, nullptr));
+    }
+
+    /**
+     * @brief Enqueue stage s on rows [y0, y0 + rows) held in row
+     * @return true if the result was written to spare
+     */
+    bool enqueueStage(HX::Internal::cl_command_queue queue, size_t s, int y0, int rows,
+                      HX::Internal::cl_mem row, HX::Internal::cl_mem spare) {
+        using namespace HX::Internal;
+        const PipelineStage& stage = m_stages[s];
+        cl_mem* maps = m_buffers[s].maps;
+        const int width = stage.inputWidth;
+
+        switch (stage.type) {
+            case STAGE_BACKGROUND: {
+                cl_kernel k = m_kernels[KERNEL_BACKGROUND];
+                setArgs(k, row, maps[0], maps[1]);
+                setArg(k, 3, static_cast<int>(stage.gainMap != nullptr));
+                setArg(k, 4, stage.gain);
+                setArg(k, 5, stage.bias);
+                setArg(k, 6, width);
+                setArg(k, 7, y0);
+                setArg(k, 8, m_maxValue);
+                enqueue(queue, k, width, rows);
+                return false;
+            }
+
+            case STAGE_BASELINE: {
+                cl_kernel k = m_kernels[KERNEL_BASELINE];
+                setArgs(k, row, maps[0], width);
+                setArg(k, 3, y0);
+                setArg(k, 4, m_maxValue);
+                enqueue(queue, k, width, rows);
+                return false;
+            }
+
+            case STAGE_GAIN: {
+                cl_kernel k = m_kernels[KERNEL_GAIN];
+                setArgs(k, row, maps[0], maps[1]);
+                setArg(k, 3, static_cast<int>(stage.offset16 != nullptr));
+                setArg(k, 4, stage.bias);
+                setArg(k, 5, width);
+                setArg(k, 6, y0);
+                setArg(k, 7, m_maxValue);
+                enqueue(queue, k, width, rows);
+                return false;
+            }
+
+            case STAGE_MULTI_GAIN: {
+                cl_kernel k = m_kernels[KERNEL_MULTI_GAIN];
+                setArgs(k, row, maps[0], maps[1]);
+                setArg(k, 3, maps[2]);
+                setArg(k, 4, static_cast<int>(stage.baseline16 != nullptr));
+                setArg(k, 5, maps[3]);
+                setArg(k, 6, stage.numGains);
+                setArg(k, 7, static_cast<cl_ulong>(width) * m_height);
+                setArg(k, 8, width);
+                setArg(k, 9, y0);
+                setArg(k, 10, m_maxValue);
+                enqueue(queue, k, width, rows);
+                return false;
+            }
+
+            case STAGE_REMAP: {
+                cl_kernel k = m_kernels[KERNEL_REMAP];
+                setArgs(k, row, spare, maps[0]);
+                setArg(k, 3, maps[1]);
+                setArg(k, 4, width);
+                setArg(k, 5, stage.outputWidth);
+                setArg(k, 6, m_maxValue);
+                enqueue(queue, k, stage.outputWidth, rows);
+                return true;
+            }
+
+            case STAGE_DEFECT: {
+                // One work item per defect; neighbours are never defects
+                const bool everyRow = stage.defectRows == 1;
+                const int e0 = everyRow ? 0 : stage.defectRowStart[y0];
+                const int e1 = everyRow ? stage.defectRowStart[1] : stage.defectRowStart[y0 + rows];
+                if (e1 == e0) {
+                    return false;
+                }
+                cl_kernel k = m_kernels[KERNEL_DEFECTS];
+                setArgs(k, row, maps[0], maps[1]);
+                setArg(k, 3, maps[2]);
+                setArg(k, 4, maps[3]);
+                setArg(k, 5, width);
+                setArg(k, 6, y0);
+                setArg(k, 7, static_cast<int>(everyRow));
+                setArg(k, 8, e0);
+                setArg(k, 9, m_maxValue);
+                enqueue(queue, k, e1 - e0, everyRow ? rows : 1);
+                return false;
+            }
+
+            default:
+                return false;
+        }
+    }
+
+    const HX::Internal::OpenCLApi* m_cl;
+    HX::Internal::cl_context m_context;
+    HX::Internal::cl_program m_program;
+    HX::Internal::cl_kernel m_kernels[KERNEL_COUNT];
+    Lane m_lanes[GPU_LANES];
+    std::vector<PipelineStage> m_stages;
+    std::vector<StageBuffers> m_buffers;
+    std::vector<std::pair<void*, HX::Internal::cl_mem> > m_hostBuffers;
+    int m_width;
+    int m_height;
+    float m_maxValue;
+    int m_bandRows;
+    bool m_uploadFailed;
+    bool m_failed;
+};
+
+/**
+ * @enum SpecializedStage
+ * @brief Stages a prebuilt pass can hold, in the order they must appear
+ */
+enum SpecializedStage {
+    SPEC_BACKGROUND = 1,    // STAGE_BACKGROUND with a scalar gain
+    SPEC_GAIN       = 2,    // STAGE_GAIN with a 16-bit offset map
+    SPEC_BASELINE   = 4,    // STAGE_BASELINE
+    SPEC_DEFECT     = 8     // STAGE_DEFECT
+};
+
+/**
+ * @brief One row through a prebuilt pass
+ * @param stages The pipeline's stages, one per bit of the pass's set
+ * @param row Scratch row of the pass's width
+ */
+typedef void (*SpecializedRowFn)(const PipelineStage* stages, int y,
+                                 const unsigned short* input, unsigned short* output, float* row);
+
+inline float storeValue(float value, float maxValue) {
+    value = std::max(0.0f, std::min(maxValue, value));
+    return static_cast<float>(static_cast<int>(value + 0.5f));
+}
+
+/**
+ * @brief A fused pass with width, depth and stage set fixed at compile time
+ *
+ * The stage tests are constants, so each instance keeps only its own
+ * stages: one loop of constant trip count per row with no stage switch
+ * and no float row between pointwise stages. It computes exactly what
+ * the generic pass does, stage by stage and rounding alike.
+ */
+template <int Width, int BitDepth, unsigned Stages>
+void specializedRow(const PipelineStage* stages, int y,
+                    const unsigned short* input, unsigned short* output, float* row) {
+    const float maxValue = static_cast<float>((1 << BitDepth) - 1);
+    const size_t offset = static_cast<size_t>(y) * Width;
+    const unsigned short* in = input + offset;
+    unsigned short* out = output + offset;
+
+    int next = 0;
+    const PipelineStage* background = (Stages & SPEC_BACKGROUND) ? &stages[next++] : nullptr;
+    const PipelineStage* gain = (Stages & SPEC_GAIN) ? &stages[next++] : nullptr;
+    const PipelineStage* baseline = (Stages & SPEC_BASELINE) ? &stages[next++] : nullptr;
+    const PipelineStage* defect = (Stages & SPEC_DEFECT) ? &stages[next++] : nullptr;
+
+    const float* backgroundOffset = background ? background->offsetMap + offset : nullptr;
+    const float backgroundGain = background ? background->gain : 0.0f;
+    const float backgroundBias = background ? background->bias : 0.0f;
+    const float* gainMap = gain ? gain->gainMap + offset : nullptr;
+    const unsigned short* gainOffset = gain ? gain->offset16 + offset : nullptr;
+    const float gainBias = gain ? gain->bias : 0.0f;
+    const float* coefficients = baseline ? baseline->coefficients + offset : nullptr;
+
+    for (int x = 0; x < Width; ++x) {
+        float value = static_cast<float>(in[x]);
+        if (Stages & SPEC_BACKGROUND) {
+            value = storeValue(backgroundGain * (value - backgroundOffset[x]) + backgroundBias, maxValue);
+        }
+        if (Stages & SPEC_GAIN) {
+            value = storeValue(gainMap[x] * (value - static_cast<float>(gainOffset[x])) + gainBias,
+                               maxValue);
+        }
+        if (Stages & SPEC_BASELINE) {
+            value = storeValue(value + coefficients[x], maxValue);
+        }
+        if (Stages & SPEC_DEFECT) {
+            row[x] = value;
+        } else {
+            out[x] = static_cast<unsigned short>(value);
+        }
+    }
+
+    if (Stages & SPEC_DEFECT) {
+        const int mapRow = (defect->defectRows == 1) ? 0 : y;
+        const int base = mapRow * Width;
+        for (int e = defect->defectRowStart[mapRow]; e < defect->defectRowStart[mapRow + 1]; ++e) {
+            float sum = 0.0f;
+            for (int k = defect->defectFirst[e]; k < defect->defectFirst[e + 1]; ++k) {
+                sum += defect->defectWeight[k] * row[defect->defectNeighbor[k] - base];
+            }
+            row[defect->defectIndex[e] - base] = storeValue(sum, maxValue);
+        }
+        for (int x = 0; x < Width; ++x) {
+            out[x] = static_cast<unsigned short>(row[x]);
+        }
+    }
+}
+
+/**
+ * @brief A prebuilt pass and the pipelines it runs
+ */
+struct SpecializedPass {
+    int width;
+    int bitDepth;
+    unsigned stages;
+    SpecializedRowFn row;
+};
+
+#define HUBX_SPECIALIZED_GEOMETRY(width, depth) \
+    { width, depth, SPEC_GAIN, &specializedRow<width, depth, SPEC_GAIN> }, \
+    { width, depth, SPEC_GAIN | SPEC_BASELINE, &specializedRow<width, depth, SPEC_GAIN | SPEC_BASELINE> }, \
+    { width, depth, SPEC_GAIN | SPEC_DEFECT, &specializedRow<width, depth, SPEC_GAIN | SPEC_DEFECT> }, \
+    { width, depth, SPEC_GAIN | SPEC_BASELINE | SPEC_DEFECT, \
+      &specializedRow<width, depth, SPEC_GAIN | SPEC_BASELINE | SPEC_DEFECT> }, \
+    { width, depth, SPEC_BACKGROUND, &specializedRow<width, depth, SPEC_BACKGROUND> }, \
+    { width, depth, SPEC_BACKGROUND | SPEC_DEFECT, &specializedRow<width, depth, SPEC_BACKGROUND | SPEC_DEFECT> }
+
+/**
+ * @brief Prebuilt passes for the installed detector geometries
+ *
+ * Width is modules x XDM_PIX_NUM; a geometry added here gets all six
+ * stage sets. Pipelines that match none run the generic pass.
+ */
+const SpecializedPass SPECIALIZED_PASSES[] = {
+    HUBX_SPECIALIZED_GEOMETRY(1024, 16),
+    HUBX_SPECIALIZED_GEOMETRY(2048, 16),
+    HUBX_SPECIALIZED_GEOMETRY(4096, 16)
+};
+
+#undef HUBX_SPECIALIZED_GEOMETRY
+
+/**
+ * @class CorrectionPipeline
+ * @brief Ordered list of correction stages with a fused executor
+ *
+ * Every stage clamps to the bit depth and rounds to an integer, exactly as
+ * its stand-alone function does when it writes 16-bit output, so a pipeline
+ * produces the same frame as calling the stages one after another.
+ */
+class CorrectionPipeline {
+public:
+    CorrectionPipeline()
+        : m_width(0),
+          m_height(0),
+          m_bitDepth(0),
+          m_maxValue(0.0f),
+          m_gpuStale(true),
+          m_specializeEnabled(true),
+          m_specialized(nullptr),
+          m_specializedStale(true)
+    {}
+
+    /**
+     * @brief Set frame geometry and remove all stages
+     * @param width Input width in pixels
+     * @param height Frame height in rows
+     * @param bitDepth Bit depth of data
+     * @return HUBX_SUCCESS on success, error code otherwise
+     */
+    int initialize(int width, int height, int bitDepth) {
+        if (width <= 0 || height <= 0 || bitDepth < 1 || bitDepth > 16) {
+            return HUBX_ERROR_INVALID_PARAM;
+        }
+
+        m_width = width;
+        m_height = height;
+        m_bitDepth = bitDepth;
+        m_maxValue = static_cast<float>((1 << bitDepth) - 1);
+        clear();
+        return HUBX_SUCCESS;
+    }
+
+    /**
+     * @brief Remove all stages
+     */
+    void clear() {
+        m_stages.clear();
+        m_gpuStale = true;
+        m_specializedStale = true;
+        std::vector<float>().swap(m_frameA);
+        std::vector<float>().swap(m_frameB);
+    }
+
+    /**
+     * @brief Run on a GPU or on the CPU
+     * @param device Index below GpuExecutor::deviceCount(), or -1 for the CPU
+     * @return HUBX_SUCCESS, HUBX_ERROR_INVALID_PARAM if the pipeline has a
+     *         smooth, HUBX_ERROR_DEVICE if the device cannot be opened
+     *
+     * @note Buffers from allocHost() are freed when the device changes
+     */
+    int setDevice(int device) {
+        if (device < 0) {
+            m_gpu.reset();
+            return HUBX_SUCCESS;
+        }
+        for (size_t s = 0; s < m_stages.size(); ++s) {
+            if (m_stages[s].type == STAGE_SMOOTH) {
+                return HUBX_ERROR_INVALID_PARAM;
+            }
+        }
+        std::unique_ptr<GpuExecutor> gpu(new GpuExecutor());
+        const int result = gpu->open(device);
+        if (result != HUBX_SUCCESS) {
+            return result;
+        }
+        m_gpu.swap(gpu);
+        m_gpuStale = true;
+        return HUBX_SUCCESS;
+    }
+
+    /**
+     * @brief Allow prebuilt passes (on by default)
+     * @param enable false = always run the generic pass
+     */
+    void setSpecialized(bool enable) {
+        m_specializeEnabled = enable;
+        m_specializedStale = true;
+    }
+
+    /**
+     * @brief Check if runs on the CPU take a prebuilt pass
+     */
+    bool isSpecialized() {
+        return !m_gpu && specialized() != nullptr;
+    }
+
+    /**
+     * @brief Pinned host buffer for frames run on the GPU
+     * @return Buffer, or nullptr if no GPU is set or out of memory
+     */
+    void* allocHost(size_t bytes) {
+        return m_gpu ? m_gpu->allocHost(bytes) : nullptr;
+    }
+
+    int freeHost(void* host) {
+        return m_gpu ? m_gpu->freeHost(host) : HUBX_ERROR_INVALID_PARAM;
+    }
+
+    /**
+     * @brief Row width after all stages
+     */
+    int outputWidth() const {
+        return m_stages.empty() ? m_width : m_stages.back().outputWidth;
+    }
+
+    /**
+     * @brief Number of passes over frame memory one run takes
+     */
+    int passCount() const {
+        int passes = 1;
+        size_t first = 0;
+        for (size_t s = 0; s < m_stages.size(); ++s) {
+            if (m_stages[s].type == STAGE_SMOOTH) {
+                // The smooth, plus the pass that feeds it unless a smooth does
+                passes += (s > first || s == 0) ? 2 : 1;
+                first = s + 1;
+            }
+        }
+        return passes;
+    }
+
+    /**
+     * @brief Append background correction, y = k(x - x0) + b
+     * @param offsetMap Background offset per pixel
+     * @param gainMap Per-pixel gain, or nullptr to use gain
+     * @param gain Global gain when gainMap is nullptr
+     * @param bias Bias added after the gain
+     */
+    int addBackground(const float* offsetMap, const float* gainMap, float gain, float bias) {
+        if (offsetMap == nullptr) {
+            return HUBX_ERROR_NULL_POINTER;
+        }
+        PipelineStage stage = makeStage(STAGE_BACKGROUND);
+        stage.offsetMap = offsetMap;
+        stage.gainMap = gainMap;
+        stage.gain = gain;
+        stage.bias = bias;
+        return append(stage);
+    }
+
+    /**
+     * @brief Append baseline correction, y = x + c
+     * @param coefficients Per-pixel target - baseline
+     */
+    int addBaseline(const float* coefficients) {
+        if (coefficients == nullptr) {
+            return HUBX_ERROR_NULL_POINTER;
+        }
+        PipelineStage stage = makeStage(STAGE_BASELINE);
+        stage.coefficients = coefficients;
+        return append(stage);
+    }
+
+    /**
+     * @brief Append single-gain correction, y = k(x - x0) + b
+     * @param offset Per-pixel offset, or nullptr for none
+     * @param gainMap Per-pixel gain coefficients
+     * @param baseline Baseline added after the gain
+     */
+    int addGain(const unsigned short* offset, const float* gainMap, float baseline) {
+        if (gainMap == nullptr) {
+            return HUBX_ERROR_NULL_POINTER;
+        }
+        PipelineStage stage = makeStage(STAGE_GAIN);
+        stage.offset16 = offset;
+        stage.gainMap = gainMap;
+        stage.bias = baseline;
+        return append(stage);
+    }
+
+    /**
+     * @brief Append multi-gain correction, y = k[m](x - x0[m] - base)
+     * @param numGains Gain modes (1-8)
+     * @param thresholds Mode m is used below thresholds[m], the last above all
+     * @param offsets Per-pixel offset of each mode
+     * @param gains Per-pixel gain of each mode
+     * @param baseline Per-pixel baseline, or nullptr for none
+     */
+    int addMultiGain(int numGains, const unsigned short* thresholds,
+                     const unsigned short* const* offsets, const float* const* gains,
+                     const unsigned short* baseline) {
+        if (numGains <= 0 || numGains > 8) {
+            return HUBX_ERROR_INVALID_PARAM;
+        }
+        if (thresholds == nullptr || offsets == nullptr || gains == nullptr) {
+            return HUBX_ERROR_NULL_POINTER;
+        }
+        PipelineStage stage = makeStage(STAGE_MULTI_GAIN);
+        stage.numGains = numGains;
+        for (int m = 0; m < numGains; ++m) {
+            if (offsets[m] == nullptr || gains[m] == nullptr) {
+                return HUBX_ERROR_NULL_POINTER;
+            }
+            stage.thresholds[m] = thresholds[m];
+            stage.modeOffsets[m] = offsets[m];
+            stage.modeGains[m] = gains[m];
+        }
+        stage.baseline16 = baseline;
+        return append(stage);
+    }
+
+    /**
+     * @brief Append a row resample such as a PDC plan
+     * @param outputWidth Output row width
+     * @param sourceIndex Left tap of each output column (at most input width - 2)
+     * @param weight Right tap weight of each output column
+     */
+    int addRemap(int outputWidth, const int* sourceIndex, const float* weight) {
+        if (sourceIndex == nullptr || weight == nullptr) {
+            return HUBX_ERROR_NULL_POINTER;
+        }
+        PipelineStage stage = makeStage(STAGE_REMAP);
+        if (outputWidth <= 0 || stage.inputWidth < 2) {
+            return HUBX_ERROR_INVALID_PARAM;
+        }
+        for (int x = 0; x < outputWidth; ++x) {
+            if (sourceIndex[x] < 0 || sourceIndex[x] > stage.inputWidth - 2) {
+                return HUBX_ERROR_INVALID_PARAM;
+            }
+        }
+        stage.outputWidth = outputWidth;
+        stage.sourceIndex = sourceIndex;
+        stage.weight = weight;
+        return append(stage);
+    }
+
+    /**
+     * @brief Append defect replacement from a compiled defect map
+     * @param rows Map rows: 1 (applied to every row) or the frame height
+     * @param count Defects in the list
+     * @param index Map pixel of each defect, ascending
+     * @param first Neighbour range of each defect, count + 1 entries
+     * @param neighbor Map pixel of each neighbour, in the defect's row
+     * @param weight Weight of each neighbour
+     */
+    int addDefects(int rows, int count, const int* index, const int* first,
+                   const int* neighbor, const float* weight) {
+        if (count < 0 || (rows != 1 && rows != m_height)) {
+            return HUBX_ERROR_INVALID_PARAM;
+        }
+        if (count > 0 && (index == nullptr || first == nullptr || neighbor == nullptr || weight == nullptr)) {
+            return HUBX_ERROR_NULL_POINTER;
+        }
+        PipelineStage stage = makeStage(STAGE_DEFECT);
+        const int width = stage.inputWidth;
+        const long long pixels = static_cast<long long>(width) * rows;
+
+        // The fused pass holds one row, so every neighbour must be in it
+        stage.defectRowStart.assign(rows + 1, count);
+        int row = 0;
+        for (int e = 0; e < count; ++e) {
+            if (index[e] < 0 || index[e] >= pixels || (e > 0 && index[e] <= index[e - 1]) ||
+                first[e] < 0 || first[e + 1] < first[e]) {
+                return HUBX_ERROR_INVALID_PARAM;
+            }
+            for (int k = first[e]; k < first[e + 1]; ++k) {
+                if (neighbor[k] < 0 || neighbor[k] / width != index[e] / width) {
+                    return HUBX_ERROR_INVALID_PARAM;
+                }
+            }
+            while (row <= index[e] / width) {
+                stage.defectRowStart[row++] = e;
+            }
+        }
+        stage.defectRows = rows;
+        stage.defectIndex = index;
+        stage.defectFirst = first;
+        stage.defectNeighbor = neighbor;
+        stage.defectWeight = weight;
+        return append(stage);
+    }
+
+    /**
+     * @brief Append a box-mean smooth, windows clipped at the border
+     * @param kernelSize Window size (odd, >= 3; even sizes round up)
+     */
+    int addSmooth(int kernelSize) {
+        if (kernelSize < 3) {
+            return HUBX_ERROR_INVALID_PARAM;
+        }
+        PipelineStage stage = makeStage(STAGE_SMOOTH);
+        stage.radius = kernelSize / 2;
+        return append(stage);
+    }
+
+    /**
+     * @brief Run all stages on one frame
+     * @param input Input frame (width x height)
+     * @param output Output frame (outputWidth() x height)
+     * @return HUBX_SUCCESS on success, error code otherwise
+     */
+    int run(const unsigned short* input, unsigned short* output) {
+        if (m_width <= 0) {
+            return HUBX_ERROR_INVALID_PARAM;
+        }
+        if (input == nullptr || output == nullptr) {
+            return HUBX_ERROR_NULL_POINTER;
+        }
+        if (m_gpu) {
+            if (m_gpuStale) {
+                const int result = m_gpu->prepare(m_width, m_height, m_maxValue, m_stages);
+                if (result != HUBX_SUCCESS) {
+                    return result;
+                }
+                m_gpuStale = false;
+            }
+            return m_gpu->run(input, output);
+        }
+        if (SpecializedRowFn row = specialized()) {
+            runSpecialized(row, input, output);
+            return HUBX_SUCCESS;
+        }
+
+        // Between passes the frame is held as float in m_frameA/m_frameB
+        const float* frameIn = nullptr;
+        size_t first = 0;
+        for (;;) {
+            size_t end = first;
+            while (end < m_stages.size() && m_stages[end].type != STAGE_SMOOTH) {
+                ++end;
+            }
+            if (end == m_stages.size()) {
+                // Last fused pass writes the output frame
+                runFused(first, end, input, frameIn, output, nullptr);
+                break;
+            }
+
+            // Stages before the smooth in one pass, then the smooth on its own
+            const PipelineStage& stage = m_stages[end];
+            const float* before = frameIn;
+            if (end > first) {
+                float* frame = scratchFrame(frameIn, stage.inputWidth);
+                runFused(first, end, input, frameIn, nullptr, frame);
+                before = frame;
+            } else if (!before) {
+                float* frame = scratchFrame(nullptr, stage.inputWidth);
+                const size_t count = static_cast<size_t>(stage.inputWidth) * m_height;
+                for (size_t i = 0; i < count; ++i) {
+                    frame[i] = static_cast<float>(input[i]);
+                }
+                before = frame;
+            }
+
+            float* smoothed = scratchFrame(before, stage.inputWidth);
+            HX::Internal::boxMean(before, stage.inputWidth, m_height, stage.radius, smoothed);
+            frameIn = smoothed;
+            first = end + 1;
+        }
+
+        return HUBX_SUCCESS;
+    }
+
+private:
+    PipelineStage makeStage(StageType type) const {
+        PipelineStage stage;
+        stage.type = type;
+        stage.inputWidth = outputWidth();
+        stage.outputWidth = stage.inputWidth;
+        return stage;
+    }
+
+    int append(const PipelineStage& stage) {
+        if (m_width <= 0 || (m_gpu && stage.type == STAGE_SMOOTH)) {
+            return HUBX_ERROR_INVALID_PARAM;
+        }
+        m_stages.push_back(stage);
+        m_gpuStale = true;
+        m_specializedStale = true;
+        return HUBX_SUCCESS;
+    }
+
+    /**
+     * @brief Prebuilt pass for the geometry and stage list, nullptr if none
+     */
+    SpecializedRowFn specialized() {
+        if (!m_specializedStale) {
+            return m_specialized;
+        }
+        m_specializedStale = false;
+        m_specialized = nullptr;
+        if (!m_specializeEnabled) {
+            return nullptr;
+        }
+
+        // Each stage once, in SpecializedStage order, with the maps it expects
+        unsigned stages = 0;
+        unsigned last = 0;
+        for (size_t s = 0; s < m_stages.size(); ++s) {
+            const PipelineStage& stage = m_stages[s];
+            unsigned bit = 0;
+            switch (stage.type) {
+                case STAGE_BACKGROUND: bit = stage.gainMap ? 0 : SPEC_BACKGROUND; break;
+                case STAGE_GAIN:       bit = stage.offset16 ? SPEC_GAIN : 0; break;
+                case STAGE_BASELINE:   bit = SPEC_BASELINE; break;
+                case STAGE_DEFECT:     bit = SPEC_DEFECT; break;
+                default:               break;
+            }
+            if (bit <= last) {
+                return nullptr;
+            }
+            stages |= bit;
+            last = bit;
+        }
+        for (size_t i = 0; i < sizeof(SPECIALIZED_PASSES) / sizeof(SPECIALIZED_PASSES[0]); ++i) {
+            const SpecializedPass& pass = SPECIALIZED_PASSES[i];
+            if (pass.width == m_width && pass.bitDepth == m_bitDepth && pass.stages == stages) {
+                m_specialized = pass.row;
+                break;
+            }
+        }
+        return m_specialized;
+    }
+
+    void runSpecialized(SpecializedRowFn rowFn, const unsigned short* input, unsigned short* output) {
+        const PipelineStage* stages = m_stages.data();
+        HX::Internal::ThreadPool::instance().parallelRows(m_height, m_width, [&](int first_row, int end_row) {
+            std::vector<float> row(static_cast<size_t>(m_width));
+            for (int y = first_row; y < end_row; ++y) {
+                rowFn(stages, y, input, output, row.data());
+            }
+        });
+    }
+
+    int stageWidth(size_t index) const {
+        return index < m_stages.size() ? m_stages[index].inputWidth : outputWidth();
+    }
+
+    /**
+     * @brief Float frame buffer that is not the one in use
+     */
+    float* scratchFrame(const float* inUse, int width) {
+        std::vector<float>& frame = (inUse == m_frameA.data() && !m_frameA.empty()) ? m_frameB : m_frameA;
+        frame.resize(static_cast<size_t>(width) * m_height);
+        return frame.data();
+    }
+
+    inline float store(float value) const {
+        // Clamp and round as a 16-bit store would
+        value = std::max(0.0f, std::min(m_maxValue, value));
+        return static_cast<float>(static_cast<int>(value + 0.5f));
+    }
+
+    /**
+     * @brief Stages [first, end) on every row; source and destination are
+     *        the 16-bit frames when the float frame pointers are null
+     */
+    void runFused(size_t first, size_t end,
+                  const unsigned short* input, const float* frameIn,
+                  unsigned short* output, float* frameOut) {
+        const int inWidth = stageWidth(first);
+        const int outWidth = stageWidth(end);
+        int maxWidth = inWidth;
+        for (size_t s = first; s < end; ++s) {
+            maxWidth = std::max(maxWidth, m_stages[s].outputWidth);
+        }
+
+        HX::Internal::ThreadPool::instance().parallelRows(m_height, maxWidth, [&](int first_row, int end_row) {
+            // Two rows per band, ping-ponged by width-changing stages
+            std::vector<float> rows(static_cast<size_t>(maxWidth) * 2);
+            for (int y = first_row; y < end_row; ++y) {
+                float* row = rows.data();
+                float* spare = row + maxWidth;
+
+                const size_t inOffset = static_cast<size_t>(y) * inWidth;
+                if (frameIn) {
+                    // A smoothed frame is rounded here, as its 16-bit store would be
+                    for (int x = 0; x < inWidth; ++x) {
+                        row[x] = store(frameIn[inOffset + x]);
+                    }
+                } else {
+                    for (int x = 0; x < inWidth; ++x) {
+                        row[x] = static_cast<float>(input[inOffset + x]);
+                    }
+                }
+
+                for (size_t s = first; s < end; ++s) {
+                    if (applyStage(m_stages[s], y, row, spare)) {
+                        std::swap(row, spare);
+                    }
+                }
+
+                const size_t outOffset = static_cast<size_t>(y) * outWidth;
+                if (frameOut) {
+                    std::memcpy(frameOut + outOffset, row, outWidth * sizeof(float));
+                } else {
+                    for (int x = 0; x < outWidth; ++x) {
+                        output[outOffset + x] = static_cast<unsigned short>(row[x]);
+                    }
+                }
+            }
+        });
+    }
+
+    /**
+     * @brief Apply one stage to row y
+     * @return true if the result was written to spare
+     */
+    bool applyStage(const PipelineStage& stage, int y, float* row, float* spare) const {
+        const int width = stage.inputWidth;
+        const size_t offset = static_cast<size_t>(y) * width;
+
+        switch (stage.type) {
+            case STAGE_BACKGROUND: {
+                const float* x0 = stage.offsetMap + offset;
+                if (stage.gainMap) {
+                    const float* k = stage.gainMap + offset;
+                    for (int x = 0; x < width; ++x) {
+                        row[x] = store(k[x] * (row[x] - x0[x]) + stage.bias);
+                    }
+                } else {
+                    for (int x = 0; x < width; ++x) {
+                        row[x] = store(stage.gain * (row[x] - x0[x]) + stage.bias);
+                    }
+                }
+                return false;
+            }
+
+            case STAGE_BASELINE: {
+                const float* c = stage.coefficients + offset;
+                for (int x = 0; x < width; ++x) {
+                    row[x] = store(row[x] + c[x]);
+                }
+                return false;
+            }
+
+            case STAGE_GAIN: {
+                const float* k = stage.gainMap + offset;
+                if (stage.offset16) {
+                    const unsigned short* x0 = stage.offset16 + offset;
+                    for (int x = 0; x < width; ++x) {
+                        row[x] = store(k[x] * (row[x] - static_cast<float>(x0[x])) + stage.bias);
+                    }
+                } else {
+                    for (int x = 0; x < width; ++x) {
+                        row[x] = store(k[x] * row[x] + stage.bias);
+                    }
+                }
+                return false;
+            }
+
+            case STAGE_MULTI_GAIN: {
+                for (int x = 0; x < width; ++x) {
+                    const size_t i = offset + x;
+                    int mode = stage.numGains - 1;
+                    for (int m = 0; m < stage.numGains - 1; ++m) {
+                        if (row[x] < stage.thresholds[m]) {
+                            mode = m;
+                            break;
+                        }
+                    }
+                    float result = row[x] - static_cast<float>(stage.modeOffsets[mode][i]);
+                    result -= stage.baseline16 ? static_cast<float>(stage.baseline16[i]) : 0.0f;
+                    result *= stage.modeGains[mode][i];
+                    row[x] = store(result);
+                }
+                return false;
+            }
+
+            case STAGE_DEFECT: {
+                // Neighbours are never defects, so replacing in place is order-free
+                const int mapRow = (stage.defectRows == 1) ? 0 : y;
+                const int base = mapRow * width;
+                for (int e = stage.defectRowStart[mapRow]; e < stage.defectRowStart[mapRow + 1]; ++e) {
+                    float sum = 0.0f;
+                    for (int k = stage.defectFirst[e]; k < stage.defectFirst[e + 1]; ++k) {
+                        sum += stage.defectWeight[k] * row[stage.defectNeighbor[k] - base];
+                    }
+                    row[stage.defectIndex[e] - base] = store(sum);
+                }
+                return false;
+            }
+
+            case STAGE_REMAP: {
+                for (int x = 0; x < stage.outputWidth; ++x) {
+                    const float v0 = row[stage.sourceIndex[x]];
+                    const float v1 = row[stage.sourceIndex[x] + 1];
+                    spare[x] = store(v0 + stage.weight[x] * (v1 - v0));
+                }
+                return true;
+            }
+
+            default:
+                return false;
+        }
+    }
+
+    int m_width;
+    int m_height;
+    int m_bitDepth;
+    float m_maxValue;
+    std::vector<PipelineStage> m_stages;
+    std::vector<float> m_frameA;    // Frames between passes
+    std::vector<float> m_frameB;
+    std::unique_ptr<GpuExecutor> m_gpu;
+    bool m_gpuStale;                // Stages changed since the GPU last saw them
+    bool m_specializeEnabled;
+    SpecializedRowFn m_specialized; // Prebuilt pass, valid unless m_specializedStale
+    bool m_specializedStale;
+};
+
+} // namespace Correction
+} // namespace HubxSDK
+
+/**
+ * @brief Correction pipeline behind a C API handle
+ *
+ * Calls on one handle are serialized; give each pipeline thread its own.
+ */
+struct hubx_pipeline_t {
+    std::mutex mutex;
+    HubxSDK::Correction::CorrectionPipeline pipeline;
+};
+
+// C-style API
+extern "C" {
+
+/**
+ * @brief Create a pipeline for frames of the given size
+ * @return Handle, or NULL on invalid parameters or out of memory
+ */
+hubx_pipeline_t* hubx_pipeline_create(int width, int height, int bitDepth) {
+    hubx_pipeline_t* handle = new (std::nothrow) hubx_pipeline_t();
+    if (handle && handle->pipeline.initialize(width, height, bitDepth) != HUBX_SUCCESS) {
+        delete handle;
+        handle = nullptr;
+    }
+    return handle;
+}
+
+/**
+ * @brief Destroy a pipeline created by hubx_pipeline_create()
+ */
+void hubx_pipeline_destroy(hubx_pipeline_t* handle) {
+    delete handle;
+}
+
+/**
+ * @brief Remove all stages
+ */
+int hubx_pipeline_clear(hubx_pipeline_t* handle) {
+    if (!handle) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    handle->pipeline.clear();
+    return HUBX_SUCCESS;
+}
+
+/**
+ * @brief Append background correction
+ */
+int hubx_pipeline_add_background(hubx_pipeline_t* handle, const float* offsetMap,
+                                 const float* gainMap, float gain, float bias) {
+    if (!handle) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    return handle->pipeline.addBackground(offsetMap, gainMap, gain, bias);
+}
+
+/**
+ * @brief Append baseline correction
+ */
+int hubx_pipeline_add_baseline(hubx_pipeline_t* handle, const float* coefficients) {
+    if (!handle) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    return handle->pipeline.addBaseline(coefficients);
+}
+
+/**
+ * @brief Append single-gain correction
+ */
+int hubx_pipeline_add_gain(hubx_pipeline_t* handle, const unsigned short* offset,
+                           const float* gainMap, float baseline) {
+    if (!handle) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    return handle->pipeline.addGain(offset, gainMap, baseline);
+}
+
+/**
+ * @brief Append multi-gain correction
+ */
+int hubx_pipeline_add_multigain(hubx_pipeline_t* handle, int numGains,
+                                const unsigned short* thresholds,
+                                const unsigned short* const* offsets,
+                                const float* const* gains,
+                                const unsigned short* baseline) {
+    if (!handle) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    return handle->pipeline.addMultiGain(numGains, thresholds, offsets, gains, baseline);
+}
+
+/**
+ * @brief Append a row resample (PDC plan)
+ */
+int hubx_pipeline_add_remap(hubx_pipeline_t* handle, int outputWidth,
+                            const int* sourceIndex, const float* weight) {
+    if (!handle) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    return handle->pipeline.addRemap(outputWidth, sourceIndex, weight);
+}
+
+/**
+ * @brief Append defect replacement (list from hubx_defect_get_plan())
+ */
+int hubx_pipeline_add_defects(hubx_pipeline_t* handle, int rows, int count, const int* index,
+                              const int* first, const int* neighbor, const float* weight) {
+    if (!handle) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    return handle->pipeline.addDefects(rows, count, index, first, neighbor, weight);
+}
+
+/**
+ * @brief Append a box-mean smooth (ends the current fused pass)
+ */
+int hubx_pipeline_add_smooth(hubx_pipeline_t* handle, int kernelSize) {
+    if (!handle) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    return handle->pipeline.addSmooth(kernelSize);
+}
+
+/**
+ * @brief Get output row width after all stages
+ */
+int hubx_pipeline_output_width(hubx_pipeline_t* handle) {
+    if (!handle) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    return handle->pipeline.outputWidth();
+}
+
+/**
+ * @brief Get passes over frame memory per run
+ */
+int hubx_pipeline_pass_count(hubx_pipeline_t* handle) {
+    if (!handle) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    return handle->pipeline.passCount();
+}
+
+/**
+ * @brief Allow prebuilt passes for fixed geometries (on by default)
+ * @param enable 0 = always run the generic pass
+ */
+int hubx_pipeline_set_specialized(hubx_pipeline_t* handle, int enable) {
+    if (!handle) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    handle->pipeline.setSpecialized(enable != 0);
+    return HUBX_SUCCESS;
+}
+
+/**
+ * @brief Check if runs take a pass prebuilt for this geometry and stage list
+ * @return 1 if so, 0 for the generic pass or a GPU
+ */
+int hubx_pipeline_is_specialized(hubx_pipeline_t* handle) {
+    if (!handle) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    return handle->pipeline.isSpecialized() ? 1 : 0;
+}
+
+/**
+ * @brief Get GPU devices a pipeline can run on
+ * @return Devices, 0 without an OpenCL runtime
+ */
+int hubx_gpu_device_count(void) {
+    return HubxSDK::Correction::GpuExecutor::deviceCount();
+}
+
+/**
+ * @brief Get the name of a GPU device
+ */
+int hubx_gpu_device_name(int index, char* name, int size) {
+    if (!name) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    if (size <= 0) {
+        return HUBX_ERROR_BUFFER_SIZE;
+    }
+    return HubxSDK::Correction::GpuExecutor::deviceName(index, name, size);
+}
+
+/**
+ * @brief Run the pipeline on GPU device (-1 for the CPU)
+ */
+int hubx_pipeline_set_device(hubx_pipeline_t* handle, int device) {
+    if (!handle) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    return handle->pipeline.setDevice(device);
+}
+
+/**
+ * @brief Allocate a pinned frame buffer on the pipeline's GPU
+ */
+void* hubx_pipeline_alloc_host(hubx_pipeline_t* handle, size_t bytes) {
+    if (!handle) {
+        return nullptr;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    return handle->pipeline.allocHost(bytes);
+}
+
+/**
+ * @brief Free a buffer from hubx_pipeline_alloc_host()
+ */
+int hubx_pipeline_free_host(hubx_pipeline_t* handle, void* host) {
+    if (!handle) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    return handle->pipeline.freeHost(host);
+}
+
+/**
+ * @brief Run all stages on one frame
+ */
+int hubx_pipeline_run(hubx_pipeline_t* handle, const unsigned short* input, unsigned short* output) {
+    if (!handle) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    // Stages run fused per row band, so the pipeline is timed as a whole
+    HX::Internal::TraceScope trace(HX::XFactory::TRACE_CORRECT_PIPELINE);
+    HX::Internal::PerfScope perf(HX::XFactory::PERF_CORRECT_PIPELINE);
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    return handle->pipeline.run(input, output);
+}
+
+} // extern "C"
@@ -0,0 +1,700 @@
+/**
+ * @file defect_correction.cpp
+ * @brief Dead/hot pixel map built from calibration statistics
+ * @details Defective pixels are found from dark and flat-field statistics
+ *          (or an existing gain map), then compiled into a sparse list of
+ *          (pixel, good neighbours, weights). Correction replaces each
+ *          defect with the weighted mean of its neighbours, so it costs
+ *          O(defects) per frame rather than O(pixels).
+ *
+ *          A map one row high describes detector columns and is applied to
+ *          every row, which is what a line-scan frame needs: a bad column
+ *          is bad in every line, so only its row neighbours are good.
+ *
+ * FXImage 2.1.0 - HubxSDK
+ * Copyright (c) 2025
+ */
+
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include <vector>
+#include <mutex>
+#include <new>
+#include "../utils/calib_file.h"
+#include "../utils/thread_pool.h"
+#include "../utils/welford.h"
+
+// Error codes
+#define HUBX_SUCCESS 0
+#define HUBX_ERROR_INVALID_PARAM -1
+#define HUBX_ERROR_NULL_POINTER -2
+#define HUBX_ERROR_BUFFER_SIZE -3
+#define HUBX_ERROR_CALCULATION -4
+#define HUBX_ERROR_NOT_CALIBRATED -5
+
+namespace HubxSDK {
+namespace Correction {
+
+namespace {
+
+// Calibration container tags (see utils/calib_file.h)
+const uint32_t CALIB_MODULE = HX::Internal::CalibTag('D', 'E', 'F', 'M');
+const uint32_t CALIB_META   = HX::Internal::CalibTag('M', 'E', 'T', 'A');
+const uint32_t CALIB_MASK   = HX::Internal::CalibTag('M', 'A', 'S', 'K');
+
+// Largest neighbourhood radius compile() searches
+const int MAX_RADIUS = 3;
+
+/**
+ * @brief Median of a copy of values (upper median for even counts)
+ */
+double Median(std::vector<double> values) {
+    if (values.empty()) {
+        return 0.0;
+    }
+    std::vector<double>::iterator mid = values.begin() + values.size() / 2;
+    std::nth_element(values.begin(), mid, values.end());
+    return *mid;
+}
+
+/**
+ * @brief Median and MAD-based sigma of values
+ */
+void RobustStats(const std::vector<double>& values, double& median, double& sigma) {
+    median = Median(values);
+    std::vector<double> deviation(values.size());
+    for (size_t i = 0; i < values.size(); ++i) {
+        deviation[i] = std::fabs(values[i] - median);
+    }
+    // 1.4826 * MAD estimates the standard deviation of normal data
+    sigma = 1.4826 * Median(deviation);
+}
+
+} // namespace
+
+/**
+ * @class DefectMap
+ * @brief Defect mask, its calibration statistics and the compiled list
+ */
+class DefectMap {
+public:
+    DefectMap() : m_width(0), m_height(0), m_unresolved(0), m_rowOnly(false), m_compiled(false) {}
+
+    /**
+     * @brief Start a new, empty map
+     * @param width Detector columns
+     * @param height Map rows (1 = one entry per column, applied to every row)
+     * @return HUBX_SUCCESS on success, error code otherwise
+     */
+    int initialize(int width, int height) {
+        if (width <= 0 || height <= 0) {
+            return HUBX_ERROR_INVALID_PARAM;
+        }
+        m_width = width;
+        m_height = height;
+        m_mask.assign(pixels(), 0);
+        m_dark.clear();
+        m_bright.clear();
+        clearPlan();
+        return HUBX_SUCCESS;
+    }
+
+    /**
+     * @brief Mark one pixel defective
+     */
+    int mark(int x, int y) {
+        if (m_width <= 0) {
+            return HUBX_ERROR_NOT_CALIBRATED;
+        }
+        if (x < 0 || x >= m_width || y < 0 || y >= m_height) {
+            return HUBX_ERROR_INVALID_PARAM;
+        }
+        m_mask[static_cast<size_t>(y) * m_width + x] = 1;
+        m_compiled = false;
+        return HUBX_SUCCESS;
+    }
+
+    /**
+     * @brief Add a mask, nonzero = defective, to the map
+     */
+    int addMask(const unsigned char* mask) {
+        if (m_width <= 0) {
+            return HUBX_ERROR_NOT_CALIBRATED;
+        }
+        if (mask == nullptr) {
+            return HUBX_ERROR_NULL_POINTER;
+        }
+        for (size_t i = 0; i < pixels(); ++i) {
+            m_mask[i] |= (mask[i] != 0) ? 1 : 0;
+        }
+        m_compiled = false;
+        return HUBX_SUCCESS;
+    }
+
+    /**
+     * @brief Copy the mask out, 1 = defective
+     */
+    int getMask(unsigned char* mask) const {
+        if (m_width <= 0) {
+            return HUBX_ERROR_NOT_CALIBRATED;
+        }
+        if (mask == nullptr) {
+            return HUBX_ERROR_NULL_POINTER;
+        }
+        std::memcpy(mask, m_mask.data(), pixels());
+        return HUBX_SUCCESS;
+    }
+
+    /**
+     * @brief Add a dark or bright calibration frame to the statistics
+     * @param frame width x rows pixels
+     * @param rows Rows in frame; the map height, or any count for a
+     *             one-row map (every row is one sample of the columns)
+     */
+    int addFrame(bool bright, const unsigned short* frame, int rows) {
+        if (m_width <= 0) {
+            return HUBX_ERROR_NOT_CALIBRATED;
+        }
+        if (frame == nullptr) {
+            return HUBX_ERROR_NULL_POINTER;
+        }
+        if (rows <= 0 || (m_height > 1 && rows != m_height)) {
+            return HUBX_ERROR_BUFFER_SIZE;
+        }
+
+        HX::Internal::WelfordAccumulator& acc = bright ? m_bright : m_dark;
+        if (acc.pixels() != pixels()) {
+            acc.reset(pixels());
+        }
+        const int samples = (m_height == 1) ? rows : 1;
+        for (int s = 0; s < samples; ++s) {
+            acc.add(frame + pixels() * s);
+        }
+        return HUBX_SUCCESS;
+    }
+
+    /**
+     * @brief Mark defects from the dark and bright statistics
+     * @param hotSigmas Dark level this many robust sigmas from the median is hot
+     * @param noiseFactor Dark noise above this times the median noise is noisy
+     * @param minResponse Bright response below this fraction of the median is dead
+     * @param maxResponse Bright response above this fraction of the median is defective
+     * @return Number of pixels newly marked, or a negative error code
+     *
+     * @note A criterion is skipped when its parameter is <= 0 or its frames
+     *       are missing; noise needs two dark frames. Response is bright
+     *       minus dark mean when dark frames were added.
+     */
+    int detect(float hotSigmas, float noiseFactor, float minResponse, float maxResponse) {
+        if (m_width <= 0) {
+            return HUBX_ERROR_NOT_CALIBRATED;
+        }
+        const bool haveDark = m_dark.count() > 0;
+        const bool haveBright = m_bright.count() > 0;
+        if (!haveDark && !haveBright) {
+            return HUBX_ERROR_NOT_CALIBRATED;
+        }
+
+        const size_t count = pixels();
+        std::vector<unsigned char> found(count, 0);
+        std::vector<double> values(count);
+
+        if (haveDark && hotSigmas > 0.0f) {
+            for (size_t i = 0; i < count; ++i) {
+                values[i] = m_dark.mean(i);
+            }
+            double median = 0.0;
+            double sigma = 0.0;
+            RobustStats(values, median, sigma);
+            // A perfectly flat dark (simulated data) still keeps one count of slack
+            const double limit = std::max(sigma * hotSigmas, 1.0);
+            for (size_t i = 0; i < count; ++i) {
+                found[i] |= (std::fabs(values[i] - median) > limit) ? 1 : 0;
+            }
+        }
+
+        if (haveDark && m_dark.count() > 1 && noiseFactor > 0.0f) {
+            for (size_t i = 0; i < count; ++i) {
+                values[i] = std::sqrt(m_dark.variance(i));
+            }
+            const double limit = std::max(Median(values) * noiseFactor, 1.0);
+            for (size_t i = 0; i < count; ++i) {
+                found[i] |= (values[i] > limit) ? 1 : 0;
+            }
+        }
+
+        if (haveBright && (minResponse > 0.0f || maxResponse > 0.0f)) {
+            for (size_t i = 0; i < count; ++i) {
+                values[i] = m_bright.mean(i) - (haveDark ? m_dark.mean(i) : 0.0);
+            }
+            const double median = Median(values);
+            if (median <= 0.0) {
+                return HUBX_ERROR_CALCULATION;
+            }
+            for (size_t i = 0; i < count; ++i) {
+                const double response = values[i] / median;
+                if ((minResponse > 0.0f && response < minResponse) ||
+                    (maxResponse > 0.0f && response > maxResponse)) {
+                    found[i] = 1;
+                }
+            }
+        }
+
+        return merge(found);
+    }
+
+    /**
+     * @brief Mark pixels whose gain is non-finite or outside [minGain, maxGain]
+     * @return Number of pixels newly marked, or a negative error code
+     *
+     * @note ValidateGainData() rejects a map with too many such pixels;
+     *       this keeps the map and corrects them instead
+     */
+    int detectGain(const float* gain, float minGain, float maxGain) {
+        if (m_width <= 0) {
+            return HUBX_ERROR_NOT_CALIBRATED;
+        }
+        if (gain == nullptr) {
+            return HUBX_ERROR_NULL_POINTER;
+        }
+        if (!(minGain < maxGain)) {
+            return HUBX_ERROR_INVALID_PARAM;
+        }
+
+        std::vector<unsigned char> found(pixels(), 0);
+        for (size_t i = 0; i < pixels(); ++i) {
+            const float k = gain[i];
+            found[i] = (!std::isfinite(k) || k < minGain || k > maxGain) ? 1 : 0;
+        }
+        return merge(found);
+    }
+
+    /**
+     * @brief Compile the mask into the sparse correction list
+     * @param radius Largest neighbourhood searched (1-3); the smallest ring
+     *               holding a good pixel is used
+     * @param rowOnly Use neighbours of the same row only (always true for a
+     *                one-row map); required by the fused pipeline
+     * @return Number of defects, or a negative error code
+     *
+     * @note Weights are inverse distance, normalized to 1. Defects with no
+     *       good pixel within radius are left as they are and counted as
+     *       unresolved.
+     */
+    int compile(int radius, bool rowOnly) {
+        if (m_width <= 0) {
+            return HUBX_ERROR_NOT_CALIBRATED;
+        }
+        if (radius < 1 || radius > MAX_RADIUS) {
+            return HUBX_ERROR_INVALID_PARAM;
+        }
+        rowOnly = rowOnly || m_height == 1;
+
+        clearPlan();
+        m_first.push_back(0);
+        for (size_t i = 0; i < pixels(); ++i) {
+            if (!m_mask[i]) {
+                continue;
+            }
+            const int x = static_cast<int>(i % m_width);
+            const int y = static_cast<int>(i / m_width);
+            const size_t start = m_neighbor.size();
+
+            for (int r = 1; r <= radius && m_neighbor.size() == start; ++r) {
+                const int rows = rowOnly ? 0 : r;
+                for (int dy = -rows; dy <= rows; ++dy) {
+                    for (int dx = -r; dx <= r; ++dx) {
+                        // Only the ring at distance r; inner rings had no good pixel
+                        if (std::max(std::abs(dx), std::abs(dy)) != r) {
+                            continue;
+                        }
+                        const int nx = x + dx;
+                        const int ny = y + dy;
+                        if (nx < 0 || nx >= m_width || ny < 0 || ny >= m_height) {
+                            continue;
+                        }
+                        const size_t n = static_cast<size_t>(ny) * m_width + nx;
+                        if (!m_mask[n]) {
+                            m_neighbor.push_back(static_cast<int>(n));
+                            m_weight.push_back(1.0f / std::sqrt(static_cast<float>(dx * dx + dy * dy)));
+                        }
+                    }
+                }
+            }
+
+            if (m_neighbor.size() == start) {
+                m_unresolved++;
+                continue;
+            }
+
+            float total = 0.0f;
+            for (size_t k = start; k < m_weight.size(); ++k) {
+                total += m_weight[k];
+            }
+            for (size_t k = start; k < m_weight.size(); ++k) {
+                m_weight[k] /= total;
+            }
+            m_index.push_back(static_cast<int>(i));
+            m_first.push_back(static_cast<int>(m_neighbor.size()));
+        }
+
+        m_rowOnly = rowOnly;
+        m_compiled = true;
+        return static_cast<int>(m_index.size()) + m_unresolved;
+    }
+
+    /**
+     * @brief Replace every compiled defect in place
+     * @param frame width x rows pixels
+     * @param rows Map height, or any count for a one-row map
+     */
+    int apply(unsigned short* frame, int rows) const {
+        if (!m_compiled) {
+            return HUBX_ERROR_NOT_CALIBRATED;
+        }
+        if (frame == nullptr) {
+            return HUBX_ERROR_NULL_POINTER;
+        }
+        if (rows <= 0 || (m_height > 1 && rows != m_height)) {
+            return HUBX_ERROR_BUFFER_SIZE;
+        }
+        if (m_index.empty()) {
+            return HUBX_SUCCESS;
+        }
+
+        // Neighbours are never defects, so entries are independent of each other
+        const int entries = static_cast<int>(m_index.size());
+        const int repeats = (m_height == 1) ? rows : 1;
+        HX::Internal::ThreadPool::instance().parallelRows(repeats, entries, [&](int first, int end) {
+            for (int r = first; r < end; ++r) {
+                unsigned short* data = frame + static_cast<size_t>(r) * m_width;
+                for (int e = 0; e < entries; ++e) {
+                    float sum = 0.0f;
+                    for (int k = m_first[e]; k < m_first[e + 1]; ++k) {
+                        sum += m_weight[k] * static_cast<float>(data[m_neighbor[k]]);
+                    }
+                    data[m_index[e]] = static_cast<unsigned short>(std::min(sum + 0.5f, 65535.0f));
+                }
+            }
+        });
+        return HUBX_SUCCESS;
+    }
+
+    /**
+     * @brief Compiled list for hubx_pipeline_add_defects()
+     */
+    int getPlan(int* height, int* count, const int** index, const int** first,
+                const int** neighbor, const float** weight) const {
+        if (!m_compiled) {
+            return HUBX_ERROR_NOT_CALIBRATED;
+        }
+        if (!height || !count || !index || !first || !neighbor || !weight) {
+            return HUBX_ERROR_NULL_POINTER;
+        }
+        if (!m_rowOnly) {
+            // A fused pass holds one row; 2-D neighbours are not in it
+            return HUBX_ERROR_INVALID_PARAM;
+        }
+        *height = m_height;
+        *count = static_cast<int>(m_index.size());
+        *index = m_index.data();
+        *first = m_first.data();
+        *neighbor = m_neighbor.data();
+        *weight = m_weight.data();
+        return HUBX_SUCCESS;
+    }
+
+    int getCounts(int* defects, int* unresolved) const {
+        if (m_width <= 0) {
+            return HUBX_ERROR_NOT_CALIBRATED;
+        }
+        if (defects) {
+            int marked = 0;
+            for (size_t i = 0; i < pixels(); ++i) {
+                marked += m_mask[i];
+            }
+            *defects = marked;
+        }
+        if (unresolved) {
+            *unresolved = m_compiled ? m_unresolved : 0;
+        }
+        return HUBX_SUCCESS;
+    }
+
+    int saveToFile(const char* filename) const {
+        if (m_width <= 0 || filename == nullptr) {
+            return HUBX_ERROR_INVALID_PARAM;
+        }
+
+        const int32_t meta[2] = { m_width, m_height };
+        HX::Internal::CalibFileWriter writer(CALIB_MODULE);
+        writer.AddSection(CALIB_META, meta, sizeof(meta), sizeof(int32_t));
+        writer.AddSection(CALIB_MASK, m_mask.data(), m_mask.size());
+        return writer.Write(filename) ? HUBX_SUCCESS : HUBX_ERROR_INVALID_PARAM;
+    }
+
+    /**
+     * @brief Load a mask written by saveToFile(); compile() it before use
+     */
+    int loadFromFile(const char* filename) {
+        if (filename == nullptr) {
+            return HUBX_ERROR_INVALID_PARAM;
+        }
+
+        HX::Internal::CalibFile file;
+        if (!file.Open(filename, CALIB_MODULE)) {
+            return HUBX_ERROR_INVALID_PARAM;
+        }
+
+        const int32_t* meta = static_cast<const int32_t*>(
+            file.SectionExact(CALIB_META, 2 * sizeof(int32_t)));
+        if (meta == nullptr || meta[0] <= 0 || meta[1] <= 0) {
+            return HUBX_ERROR_INVALID_PARAM;
+        }
+        const size_t count = static_cast<size_t>(meta[0]) * meta[1];
+        const unsigned char* mask = static_cast<const unsigned char*>(file.SectionExact(CALIB_MASK, count));
+        if (mask == nullptr) {
+            return HUBX_ERROR_INVALID_PARAM;
+        }
+
+        initialize(meta[0], meta[1]);
+        return addMask(mask);
+    }
+
+private:
+    size_t pixels() const {
+        return static_cast<size_t>(m_width) * m_height;
+    }
+
+    int merge(const std::vector<unsigned char>& found) {
+        int added = 0;
+        for (size_t i = 0; i < found.size(); ++i) {
+            if (found[i] && !m_mask[i]) {
+                m_mask[i] = 1;
+                added++;
+            }
+        }
+        if (added > 0) {
+            m_compiled = false;
+        }
+        return added;
+    }
+
+    void clearPlan() {
+        m_index.clear();
+        m_first.clear();
+        m_neighbor.clear();
+        m_weight.clear();
+        m_unresolved = 0;
+        m_rowOnly = false;
+        m_compiled = false;
+    }
+
+    int m_width;
+    int m_height;
+    std::vector<unsigned char> m_mask;      // 1 = defective
+    HX::Internal::WelfordAccumulator m_dark;
+    HX::Internal::WelfordAccumulator m_bright;
+
+    // Compiled list: defect m_index[e] takes neighbours [m_first[e], m_first[e + 1])
+    std::vector<int> m_index;
+    std::vector<int> m_first;
+    std::vector<int> m_neighbor;
+    std::vector<float> m_weight;
+    int m_unresolved;
+    bool m_rowOnly;
+    bool m_compiled;
+};
+
+} // namespace Correction
+} // namespace HubxSDK
+
+/**
+ * @brief Defect map behind a C API handle
+ *
+ * Calls on one handle are serialized; the compiled list passed to a
+ * pipeline stays valid until the next compile, init or load.
+ */
+struct hubx_defect_t {
+    std::mutex mutex;
+    HubxSDK::Correction::DefectMap map;
+};
+
+// C-style API
+extern "C" {
+
+/**
+ * @brief Create an empty defect map
+ * @return Handle, or NULL if out of memory
+ */
+hubx_defect_t* hubx_defect_create() {
+    return new (std::nothrow) hubx_defect_t();
+}
+
+/**
+ * @brief Destroy a map created by hubx_defect_create()
+ */
+void hubx_defect_destroy(hubx_defect_t* handle) {
+    delete handle;
+}
+
+/**
+ * @brief Start a new map (height 1 = per column, applied to every row)
+ */
+int hubx_defect_init(hubx_defect_t* handle, int width, int height) {
+    if (!handle) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    return handle->map.initialize(width, height);
+}
+
+/**
+ * @brief Mark one pixel defective
+ */
+int hubx_defect_mark(hubx_defect_t* handle, int x, int y) {
+    if (!handle) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    return handle->map.mark(x, y);
+}
+
+/**
+ * @brief Add a mask (nonzero = defective) to the map
+ */
+int hubx_defect_add_mask(hubx_defect_t* handle, const unsigned char* mask) {
+    if (!handle) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    return handle->map.addMask(mask);
+}
+
+/**
+ * @brief Copy the mask out (width x height bytes, 1 = defective)
+ */
+int hubx_defect_get_mask(hubx_defect_t* handle, unsigned char* mask) {
+    if (!handle) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    return handle->map.getMask(mask);
+}
+
+/**
+ * @brief Add a dark frame to the statistics
+ */
+int hubx_defect_add_dark(hubx_defect_t* handle, const unsigned short* frame, int rows) {
+    if (!handle) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    return handle->map.addFrame(false, frame, rows);
+}
+
+/**
+ * @brief Add a flat-field frame to the statistics
+ */
+int hubx_defect_add_bright(hubx_defect_t* handle, const unsigned short* frame, int rows) {
+    if (!handle) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    return handle->map.addFrame(true, frame, rows);
+}
+
+/**
+ * @brief Mark hot, noisy and dead pixels; returns pixels newly marked
+ */
+int hubx_defect_detect(hubx_defect_t* handle, float hotSigmas, float noiseFactor,
+                       float minResponse, float maxResponse) {
+    if (!handle) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    return handle->map.detect(hotSigmas, noiseFactor, minResponse, maxResponse);
+}
+
+/**
+ * @brief Mark pixels with out-of-range gain; returns pixels newly marked
+ */
+int hubx_defect_detect_gain(hubx_defect_t* handle, const float* gain, float minGain, float maxGain) {
+    if (!handle) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    return handle->map.detectGain(gain, minGain, maxGain);
+}
+
+/**
+ * @brief Compile the map; returns the number of defects
+ */
+int hubx_defect_compile(hubx_defect_t* handle, int radius, int rowOnly) {
+    if (!handle) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    return handle->map.compile(radius, rowOnly != 0);
+}
+
+/**
+ * @brief Get marked and (after compile) unresolved defect counts
+ */
+int hubx_defect_get_counts(hubx_defect_t* handle, int* defects, int* unresolved) {
+    if (!handle) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    return handle->map.getCounts(defects, unresolved);
+}
+
+/**
+ * @brief Correct defects in place, typically after gain correction
+ */
+int hubx_defect_apply(hubx_defect_t* handle, unsigned short* frame, int rows) {
+    if (!handle) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    return handle->map.apply(frame, rows);
+}
+
+/**
+ * @brief Get the compiled list for hubx_pipeline_add_defects()
+ * @return HUBX_ERROR_INVALID_PARAM if it was compiled with 2-D neighbours
+ */
+int hubx_defect_get_plan(hubx_defect_t* handle, int* height, int* count, const int** index,
+                         const int** first, const int** neighbor, const float** weight) {
+    if (!handle) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    return handle->map.getPlan(height, count, index, first, neighbor, weight);
+}
+
+/**
+ * @brief Save the mask
+ */
+int hubx_defect_save(hubx_defect_t* handle, const char* filename) {
+    if (!handle) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    return handle->map.saveToFile(filename);
+}
+
+/**
+ * @brief Load a mask saved by hubx_defect_save(); compile before applying
+ */
+int hubx_defect_load(hubx_defect_t* handle, const char* filename) {
+    if (!handle) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    return handle->map.loadFromFile(filename);
+}
+
+} // extern "C"
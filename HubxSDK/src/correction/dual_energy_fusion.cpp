@@ -14,6 +14,15 @@
 #include <vector>
 #include <stdexcept>
 #include <memory>
+#include <mutex>
+#include <new>
+
+#include "../utils/box_filter.h"
+#include "../utils/cpu_features.h"
+#include "../utils/material_class.h"
+#include "../utils/median_filter.h"
+#include "../utils/overload.h"
+#include "../utils/thread_pool.h"
 
 // Error codes
 #define HUBX_SUCCESS 0
@@ -38,6 +47,164 @@ enum FusionMode {
     FUSION_CUSTOM                    // Custom user-defined fusion
 };
 
+// Classes, model and table entry layout are shared with XShow
+using HX::Internal::MaterialModel;
+using HX::Internal::MATERIAL_CLASS_SHIFT;
+using HX::Internal::MATERIAL_ZEFF_MASK;
+
+namespace {
+
+/**
+ * @brief Adaptive blend of pixels [first, end) of one row
+ *
+ * Weights are each image's share of the summed local variance. All kernels
+ * use the same operation order, so results do not depend on the CPU.
+ */
+typedef void (*AdaptiveBlendKernel)(const unsigned short* high, const unsigned short* low,
+                                    const float* varHigh, const float* varLow,
+                                    unsigned short* output, int first, int end, float maxValue);
+
+void AdaptiveBlendScalar(const unsigned short* high, const unsigned short* low,
+                         const float* varHigh, const float* varLow,
+                         unsigned short* output, int first, int end, float maxValue) {
+    for (int x = first; x < end; ++x) {
+        float totalVar = varHigh[x] + varLow[x] + 1e-6f;
+        float adaptiveHighWeight = varHigh[x] / totalVar;
+        float adaptiveLowWeight = varLow[x] / totalVar;
+
+        float fused = adaptiveHighWeight * high[x] + adaptiveLowWeight * low[x];
+        fused = std::max(0.0f, std::min(maxValue, fused));
+        output[x] = static_cast<unsigned short>(fused + 0.5f);
+    }
+}
+
+#if defined(HX_ARCH_X86)
+HX_TARGET("avx2")
+void AdaptiveBlendAVX2(const unsigned short* high, const unsigned short* low,
+                       const float* varHigh, const float* varLow,
+                       unsigned short* output, int first, int end, float maxValue) {
+    const __m256 epsilon = _mm256_set1_ps(1e-6f);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 limit = _mm256_set1_ps(maxValue);
+    const __m256 half = _mm256_set1_ps(0.5f);
+
+    int x = first;
+    for (; x + 8 <= end; x += 8) {
+        __m256 h = _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(high + x))));
+        __m256 l = _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(low + x))));
+        __m256 vh = _mm256_loadu_ps(varHigh + x);
+        __m256 vl = _mm256_loadu_ps(varLow + x);
+
+        __m256 total = _mm256_add_ps(_mm256_add_ps(vh, vl), epsilon);
+        __m256 wh = _mm256_div_ps(vh, total);
+        __m256 wl = _mm256_div_ps(vl, total);
+        __m256 fused = _mm256_add_ps(_mm256_mul_ps(wh, h), _mm256_mul_ps(wl, l));
+        fused = _mm256_max_ps(zero, _mm256_min_ps(limit, fused));
+
+        __m256i v = _mm256_cvttps_epi32(_mm256_add_ps(fused, half));
+        __m128i packed = _mm_packus_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(output + x), packed);
+    }
+    AdaptiveBlendScalar(high, low, varHigh, varLow, output, x, end, maxValue);
+}
+#endif
+
+const HX::Internal::KernelFamily g_adaptiveKernels("fusion_adaptive", HX::XFactory::CPU_AVX2);
+
+AdaptiveBlendKernel selectAdaptiveBlend() {
+#if defined(HX_ARCH_X86)
+    if (g_adaptiveKernels.isa() == HX::XFactory::CPU_AVX2) {
+        return AdaptiveBlendAVX2;
+    }
+#endif
+    return AdaptiveBlendScalar;
+}
+
+/**
+ * @brief One per-pixel output: (a * high + b * low) + k * (high - low)
+ *
+ * Weighted average, material decomposition and both decomposition images
+ * are all this form, evaluated in their original operation order.
+ */
+struct LinearTerm {
+    float a;
+    float b;
+    float k;
+};
+
+/**
+ * @brief Evaluate up to two LinearTerms over pixels [first, end) in one pass
+ */
+typedef void (*LinearFuseKernel)(const unsigned short* high, const unsigned short* low,
+                                 const LinearTerm* terms, unsigned short* const* outputs, int count,
+                                 size_t first, size_t end, float maxValue);
+
+void LinearFuseScalar(const unsigned short* high, const unsigned short* low,
+                      const LinearTerm* terms, unsigned short* const* outputs, int count,
+                      size_t first, size_t end, float maxValue) {
+    for (size_t i = first; i < end; ++i) {
+        const float h = static_cast<float>(high[i]);
+        const float l = static_cast<float>(low[i]);
+        for (int t = 0; t < count; ++t) {
+            float fused = (terms[t].a * h + terms[t].b * l) + terms[t].k * (h - l);
+            fused = std::max(0.0f, std::min(maxValue, fused));
+            outputs[t][i] = static_cast<unsigned short>(fused + 0.5f);
+        }
+    }
+}
+
+#if defined(HX_ARCH_X86)
+HX_TARGET("avx2")
+void LinearFuseAVX2(const unsigned short* high, const unsigned short* low,
+                    const LinearTerm* terms, unsigned short* const* outputs, int count,
+                    size_t first, size_t end, float maxValue) {
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 limit = _mm256_set1_ps(maxValue);
+    const __m256 half = _mm256_set1_ps(0.5f);
+    __m256 a[2], b[2], k[2];
+    for (int t = 0; t < count; ++t) {
+        a[t] = _mm256_set1_ps(terms[t].a);
+        b[t] = _mm256_set1_ps(terms[t].b);
+        k[t] = _mm256_set1_ps(terms[t].k);
+    }
+
+    size_t i = first;
+    for (; i + 8 <= end; i += 8) {
+        __m256 h = _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(high + i))));
+        __m256 l = _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(low + i))));
+        __m256 diff = _mm256_sub_ps(h, l);
+
+        for (int t = 0; t < count; ++t) {
+            __m256 fused = _mm256_add_ps(_mm256_mul_ps(a[t], h), _mm256_mul_ps(b[t], l));
+            fused = _mm256_add_ps(fused, _mm256_mul_ps(k[t], diff));
+            fused = _mm256_max_ps(zero, _mm256_min_ps(limit, fused));
+
+            __m256i v = _mm256_cvttps_epi32(_mm256_add_ps(fused, half));
+            __m128i packed = _mm_packus_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(outputs[t] + i), packed);
+        }
+    }
+    LinearFuseScalar(high, low, terms, outputs, count, i, end, maxValue);
+}
+#endif
+
+const HX::Internal::KernelFamily g_linearKernels("fusion_linear", HX::XFactory::CPU_AVX2);
+
+LinearFuseKernel selectLinearFuse() {
+#if defined(HX_ARCH_X86)
+    if (g_linearKernels.isa() == HX::XFactory::CPU_AVX2) {
+        return LinearFuseAVX2;
+    }
+#endif
+    return LinearFuseScalar;
+}
+
+} // namespace
+
 /**
  * @class DualEnergyFusion
  * @brief Handles dual-energy X-ray image fusion
@@ -50,7 +217,9 @@ public:
           m_height(0),
           m_highEnergyWeight(0.5f),
           m_lowEnergyWeight(0.5f),
-          m_fusionMode(FUSION_WEIGHTED_AVERAGE)
+          m_fusionMode(FUSION_WEIGHTED_AVERAGE),
+          m_medianRadius(0),
+          m_classDepth(0)
     {}
     
     ~DualEnergyFusion() {
@@ -114,6 +283,42 @@ public:
         return HUBX_SUCCESS;
     }
 
+    /**
+     * @brief Get fusion mode
+     */
+    FusionMode getFusionMode() const {
+        return m_fusionMode;
+    }
+
+    /**
+     * @brief Median-filter every fused output
+     * @param kernelSize Odd window width, 3 to 101 (0 or 1 = off)
+     * @return HUBX_SUCCESS on success, error code otherwise
+     *
+     * 3x3 and 5x5 run a sorting network, larger windows a sliding
+     * histogram. Edge pixels see the nearest edge pixel repeated.
+     */
+    int setMedian(int kernelSize) {
+        if (kernelSize == 0 || kernelSize == 1) {
+            m_medianRadius = 0;
+            m_medianBuffer.clear();
+            return HUBX_SUCCESS;
+        }
+        if (kernelSize < 3 || kernelSize % 2 == 0 ||
+            kernelSize / 2 > HX::Internal::MEDIAN_MAX_RADIUS) {
+            return HUBX_ERROR_INVALID_PARAM;
+        }
+        m_medianRadius = kernelSize / 2;
+        return HUBX_SUCCESS;
+    }
+
+    /**
+     * @brief Median window width, 0 when off
+     */
+    int getMedian() const {
+        return m_medianRadius > 0 ? 2 * m_medianRadius + 1 : 0;
+    }
+
     /**
      * @brief Perform weighted average fusion (default mode)
      * @param highEnergy High-energy image data
@@ -134,24 +339,10 @@ public:
             return HUBX_ERROR_NULL_POINTER;
         }
 
-        const int maxValue = (1 << bitDepth) - 1;
-
-        try {
-            for (int i = 0; i < m_pixelCount; ++i) {
-                // Weighted average: fused = w_h * I_h + w_l * I_l
-                float fused = m_highEnergyWeight * static_cast<float>(highEnergy[i]) +
-                             m_lowEnergyWeight * static_cast<float>(lowEnergy[i]);
-                
-                // Clamp to valid range
-                fused = std::max(0.0f, std::min(static_cast<float>(maxValue), fused));
-                output[i] = static_cast<unsigned short>(fused + 0.5f);
-            }
-
-            return HUBX_SUCCESS;
-        }
-        catch (const std::exception&) {
-            return HUBX_ERROR_CALCULATION;
-        }
+        // Weighted average: fused = w_h * I_h + w_l * I_l
+        const LinearTerm term = { m_highEnergyWeight, m_lowEnergyWeight, 0.0f };
+        fuseLinear(highEnergy, lowEnergy, &term, &output, 1, bitDepth);
+        return HUBX_SUCCESS;
     }
 
     /**
@@ -176,28 +367,11 @@ public:
             return HUBX_ERROR_NULL_POINTER;
         }
 
-        const int maxValue = (1 << bitDepth) - 1;
-
-        try {
-            for (int i = 0; i < m_pixelCount; ++i) {
-                float high = static_cast<float>(highEnergy[i]);
-                float low = static_cast<float>(lowEnergy[i]);
-                
-                // Material decomposition: emphasize differences
-                // fused = (I_h + materialCoeff * (I_h - I_l))
-                float difference = high - low;
-                float fused = high + materialCoeff * difference;
-                
-                // Clamp to valid range
-                fused = std::max(0.0f, std::min(static_cast<float>(maxValue), fused));
-                output[i] = static_cast<unsigned short>(fused + 0.5f);
-            }
-
-            return HUBX_SUCCESS;
-        }
-        catch (const std::exception&) {
-            return HUBX_ERROR_CALCULATION;
-        }
+        // Material decomposition: emphasize differences
+        // fused = (I_h + materialCoeff * (I_h - I_l))
+        const LinearTerm term = { 1.0f, 0.0f, materialCoeff };
+        fuseLinear(highEnergy, lowEnergy, &term, &output, 1, bitDepth);
+        return HUBX_SUCCESS;
     }
 
     /**
@@ -275,65 +449,29 @@ public:
         const int halfWindow = windowSize / 2;
 
         try {
-            // Calculate local variance and adapt weights
-            for (int y = 0; y < m_height; ++y) {
-                for (int x = 0; x < m_width; ++x) {
-                    int idx = y * m_width + x;
-                    
-                    // Calculate local variance for both images
-                    float varHigh = 0.0f, varLow = 0.0f;
-                    float meanHigh = 0.0f, meanLow = 0.0f;
-                    int count = 0;
-
-                    for (int wy = -halfWindow; wy <= halfWindow; ++wy) {
-                        for (int wx = -halfWindow; wx <= halfWindow; ++wx) {
-                            int ny = y + wy;
-                            int nx = x + wx;
-                            
-                            if (ny >= 0 && ny < m_height && nx >= 0 && nx < m_width) {
-                                int nidx = ny * m_width + nx;
-                                meanHigh += highEnergy[nidx];
-                                meanLow += lowEnergy[nidx];
-                                count++;
-                            }
-                        }
-                    }
-
-                    meanHigh /= count;
-                    meanLow /= count;
-
-                    // Calculate variance
-                    for (int wy = -halfWindow; wy <= halfWindow; ++wy) {
-                        for (int wx = -halfWindow; wx <= halfWindow; ++wx) {
-                            int ny = y + wy;
-                            int nx = x + wx;
-                            
-                            if (ny >= 0 && ny < m_height && nx >= 0 && nx < m_width) {
-                                int nidx = ny * m_width + nx;
-                                float diffHigh = highEnergy[nidx] - meanHigh;
-                                float diffLow = lowEnergy[nidx] - meanLow;
-                                varHigh += diffHigh * diffHigh;
-                                varLow += diffLow * diffLow;
-                            }
-                        }
-                    }
-
-                    varHigh /= count;
-                    varLow /= count;
-
-                    // Adaptive weight based on local variance
-                    float totalVar = varHigh + varLow + 1e-6f;
-                    float adaptiveHighWeight = varHigh / totalVar;
-                    float adaptiveLowWeight = varLow / totalVar;
-
-                    // Fuse with adaptive weights
-                    float fused = adaptiveHighWeight * highEnergy[idx] +
-                                 adaptiveLowWeight * lowEnergy[idx];
-                    
-                    fused = std::max(0.0f, std::min(static_cast<float>(maxValue), fused));
-                    output[idx] = static_cast<unsigned short>(fused + 0.5f);
+            // Summed-area tables of both images, built once per frame pair
+            HX::Internal::ThreadPool& pool = HX::Internal::ThreadPool::instance();
+            pool.run(2, [&](int band) {
+                if (band == 0) {
+                    m_integralHigh.build(highEnergy, m_width, m_height);
+                } else {
+                    m_integralLow.build(lowEnergy, m_width, m_height);
                 }
-            }
+            });
+
+            const AdaptiveBlendKernel blend = selectAdaptiveBlend();
+            pool.parallelRows(m_height, m_width, [&](int first_row, int end_row) {
+                // Local variances of one row, windows clipped at the border
+                std::vector<float> varHigh(m_width);
+                std::vector<float> varLow(m_width);
+                for (int y = first_row; y < end_row; ++y) {
+                    const size_t offset = static_cast<size_t>(y) * m_width;
+                    m_integralHigh.varianceRow(y, halfWindow, varHigh.data());
+                    m_integralLow.varianceRow(y, halfWindow, varLow.data());
+                    blend(highEnergy + offset, lowEnergy + offset, varHigh.data(), varLow.data(),
+                          output + offset, 0, m_width, static_cast<float>(maxValue));
+                }
+            });
 
             return HUBX_SUCCESS;
         }
@@ -348,32 +486,63 @@ public:
      * @param lowEnergy Low-energy image data
      * @param output Output fused image
      * @param bitDepth Bit depth of data
+     * @param sheddable true to leave out the median and adaptive fusion
+     *        while XFactory::SetOverloadPolicy() skips optional stages
      * @return HUBX_SUCCESS on success, error code otherwise
      */
     int fuse(const unsigned short* highEnergy,
             const unsigned short* lowEnergy,
             unsigned short* output,
-            int bitDepth) {
+            int bitDepth,
+            bool sheddable = false) {
         if (!m_initialized) {
             return HUBX_ERROR_INVALID_PARAM;
         }
+        const bool shed = sheddable && (m_medianRadius > 0 || m_fusionMode == FUSION_ADAPTIVE) &&
+                          HX::Internal::OverloadShed(HX::XFactory::OVERLOAD_OPTIONAL);
+        if (shed && m_fusionMode == FUSION_ADAPTIVE) {
+            // Weighted average needs no local statistics
+            return fuseWeightedAverage(highEnergy, lowEnergy, output, bitDepth);
+        }
+        if (shed || m_medianRadius == 0) {
+            return fuseSelected(highEnergy, lowEnergy, output, bitDepth);
+        }
+        if (!output) {
+            return HUBX_ERROR_NULL_POINTER;
+        }
 
-        switch (m_fusionMode) {
-            case FUSION_WEIGHTED_AVERAGE:
-                return fuseWeightedAverage(highEnergy, lowEnergy, output, bitDepth);
-            
-            case FUSION_MATERIAL_DECOMPOSITION:
-                return fuseMaterialDecomposition(highEnergy, lowEnergy, output, bitDepth);
-            
-            case FUSION_ADAPTIVE:
-                return fuseAdaptive(highEnergy, lowEnergy, output, bitDepth);
-            
-            case FUSION_LOGARITHMIC:
-                return fuseLogarithmic(highEnergy, lowEnergy, output, bitDepth);
-            
-            default:
-                return fuseWeightedAverage(highEnergy, lowEnergy, output, bitDepth);
+        // Fuse into scratch, then filter into the caller's buffer
+        m_medianBuffer.resize(m_pixelCount);
+        int result = fuseSelected(highEnergy, lowEnergy, m_medianBuffer.data(), bitDepth);
+        if (result != HUBX_SUCCESS) {
+            return result;
+        }
+        if (!HX::Internal::medianFilter(m_medianBuffer.data(), output, m_width, m_height, m_medianRadius)) {
+            return HUBX_ERROR_INVALID_PARAM;
         }
+        return HUBX_SUCCESS;
+    }
+
+    /**
+     * @brief Median-filter any image, independent of the fusion settings
+     * @param input Input image, width * height values
+     * @param output Output image; must not overlap input
+     * @param width Image width
+     * @param height Image height
+     * @param kernelSize Odd window width, 3 to 101
+     * @return HUBX_SUCCESS on success, error code otherwise
+     */
+    static int median(const unsigned short* input, unsigned short* output,
+                      int width, int height, int kernelSize) {
+        if (!input || !output) {
+            return HUBX_ERROR_NULL_POINTER;
+        }
+        if (width <= 0 || height <= 0 || kernelSize < 3 || kernelSize % 2 == 0 ||
+            kernelSize / 2 > HX::Internal::MEDIAN_MAX_RADIUS || input == output) {
+            return HUBX_ERROR_INVALID_PARAM;
+        }
+        HX::Internal::medianFilter(input, output, width, height, kernelSize / 2);
+        return HUBX_SUCCESS;
     }
 
     /**
@@ -459,31 +628,94 @@ public:
             return HUBX_ERROR_NULL_POINTER;
         }
 
-        const int maxValue = (1 << bitDepth) - 1;
+        // Both images in one pass over the inputs
+        const LinearTerm terms[2] = {
+            // Organic materials: more absorption at low energy
+            // organic = I_l - 0.5 * I_h
+            { -0.5f, 1.0f, 0.0f },
+            // Inorganic materials: relatively uniform absorption
+            // inorganic = I_h - 0.3 * (I_h - I_l)
+            { 1.0f, 0.0f, -0.3f }
+        };
+        unsigned short* const outputs[2] = { organicOutput, inorganicOutput };
+        fuseLinear(highEnergy, lowEnergy, terms, outputs, 2, bitDepth);
+        return HUBX_SUCCESS;
+    }
 
-        try {
-            for (int i = 0; i < m_pixelCount; ++i) {
-                float high = static_cast<float>(highEnergy[i]);
-                float low = static_cast<float>(lowEnergy[i]);
-                
-                // Organic materials: more absorption at low energy
-                // Emphasis on low energy difference
-                float organic = low - 0.5f * high;
-                organic = std::max(0.0f, std::min(static_cast<float>(maxValue), organic));
-                organicOutput[i] = static_cast<unsigned short>(organic + 0.5f);
-                
-                // Inorganic materials: relatively uniform absorption
-                // Emphasis on high energy
-                float inorganic = high - 0.3f * (high - low);
-                inorganic = std::max(0.0f, std::min(static_cast<float>(maxValue), inorganic));
-                inorganicOutput[i] = static_cast<unsigned short>(inorganic + 0.5f);
-            }
+    /**
+     * @brief Set the material classification coefficients
+     * @param model Z-effective curve, class limits and table size
+     * @return HUBX_SUCCESS on success, error code otherwise
+     *
+     * The lookup table is rebuilt on the next classifyMaterials().
+     */
+    int setMaterialModel(const MaterialModel& model) {
+        if (!model.valid()) {
+            return HUBX_ERROR_INVALID_PARAM;
+        }
+        m_materialModel = model;
+        m_classDepth = 0;
+        return HUBX_SUCCESS;
+    }
 
-            return HUBX_SUCCESS;
+    const MaterialModel& getMaterialModel() const {
+        return m_materialModel;
+    }
+
+    /**
+     * @brief Classify every pixel by its (high, low) pair
+     * @param highEnergy High-energy image data
+     * @param lowEnergy Low-energy image data
+     * @param classes Output MaterialClass per pixel
+     * @param zeff Output Z-effective * 100 per pixel, may be NULL
+     * @param bitDepth Bit depth of data
+     * @return HUBX_SUCCESS on success, error code otherwise
+     *
+     * The class and Z-effective of a pixel depend on its pair alone, so
+     * both come from a 2-D table on the top lutBits bits of each value,
+     * built once per model and bit depth at the centre of each cell. A
+     * pixel then costs one table load.
+     */
+    int classifyMaterials(const unsigned short* highEnergy,
+                          const unsigned short* lowEnergy,
+                          unsigned char* classes,
+                          unsigned short* zeff,
+                          int bitDepth) {
+        if (!m_initialized || bitDepth < 1 || bitDepth > 16) {
+            return HUBX_ERROR_INVALID_PARAM;
         }
-        catch (const std::exception&) {
+
+        if (highEnergy == nullptr || lowEnergy == nullptr || classes == nullptr) {
+            return HUBX_ERROR_NULL_POINTER;
+        }
+
+        try {
+            buildClassTable(bitDepth);
+        }
+        catch (const std::bad_alloc&) {
             return HUBX_ERROR_CALCULATION;
         }
+
+        const int bits = HX::Internal::MaterialTableBits(m_materialModel, bitDepth);
+        const int shift = bitDepth - bits;
+        const unsigned short limit = static_cast<unsigned short>((1 << bitDepth) - 1);
+        const unsigned short* table = m_classTable.data();
+        const size_t width = static_cast<size_t>(m_width);
+
+        HX::Internal::ThreadPool::instance().parallelRows(m_height, m_width, [&](int first_row, int end_row) {
+            const size_t end = end_row * width;
+            for (size_t i = first_row * width; i < end; ++i) {
+                // Values above the bit depth fall in the top cell
+                const unsigned int h = std::min(highEnergy[i], limit) >> shift;
+                const unsigned int l = std::min(lowEnergy[i], limit) >> shift;
+                const unsigned short entry = table[(h << bits) | l];
+                classes[i] = static_cast<unsigned char>(entry >> MATERIAL_CLASS_SHIFT);
+                if (zeff) {
+                    zeff[i] = entry & MATERIAL_ZEFF_MASK;
+                }
+            }
+        });
+        return HUBX_SUCCESS;
     }
 
     /**
@@ -507,6 +739,11 @@ public:
      */
     void release() {
         m_tempBuffer.clear();
+        m_medianBuffer.clear();
+        m_integralHigh = HX::Internal::IntegralMoments();
+        m_integralLow = HX::Internal::IntegralMoments();
+        std::vector<unsigned short>().swap(m_classTable);
+        m_classDepth = 0;
         m_initialized = false;
         m_width = 0;
         m_height = 0;
@@ -514,6 +751,62 @@ public:
     }
 
 private:
+    /**
+     * @brief Run the fusion selected by setFusionMode()
+     */
+    int fuseSelected(const unsigned short* highEnergy,
+                     const unsigned short* lowEnergy,
+                     unsigned short* output,
+                     int bitDepth) {
+        switch (m_fusionMode) {
+            case FUSION_WEIGHTED_AVERAGE:
+                return fuseWeightedAverage(highEnergy, lowEnergy, output, bitDepth);
+            
+            case FUSION_MATERIAL_DECOMPOSITION:
+                return fuseMaterialDecomposition(highEnergy, lowEnergy, output, bitDepth);
+            
+            case FUSION_ADAPTIVE:
+                return fuseAdaptive(highEnergy, lowEnergy, output, bitDepth);
+            
+            case FUSION_LOGARITHMIC:
+                return fuseLogarithmic(highEnergy, lowEnergy, output, bitDepth);
+            
+            default:
+                return fuseWeightedAverage(highEnergy, lowEnergy, output, bitDepth);
+        }
+    }
+
+    /**
+     * @brief Fill the class table for the current model, unless it holds it
+     */
+    void buildClassTable(int bitDepth) {
+        if (m_classDepth == bitDepth) {
+            return;
+        }
+
+        HX::Internal::BuildMaterialTable(m_materialModel, bitDepth, m_classTable);
+        m_classDepth = bitDepth;
+    }
+
+    /**
+     * @brief Evaluate linear terms over the whole image on the shared pool
+     */
+    void fuseLinear(const unsigned short* highEnergy,
+                    const unsigned short* lowEnergy,
+                    const LinearTerm* terms,
+                    unsigned short* const* outputs,
+                    int count,
+                    int bitDepth) {
+        const float maxValue = static_cast<float>((1 << bitDepth) - 1);
+        const LinearFuseKernel kernel = selectLinearFuse();
+        const size_t width = static_cast<size_t>(m_width);
+
+        HX::Internal::ThreadPool::instance().parallelRows(m_height, m_width, [&](int first_row, int end_row) {
+            kernel(highEnergy, lowEnergy, terms, outputs, count,
+                   first_row * width, end_row * width, maxValue);
+        });
+    }
+
     bool m_initialized;
     int m_width;
     int m_height;
@@ -521,38 +814,347 @@ private:
     float m_highEnergyWeight;
     float m_lowEnergyWeight;
     FusionMode m_fusionMode;
+    int m_medianRadius;                            // 0 = no median after fusion
     std::vector<float> m_tempBuffer;
+    std::vector<unsigned short> m_medianBuffer;    // fused image before the median
+    HX::Internal::IntegralMoments m_integralHigh;  // adaptive fusion statistics
+    HX::Internal::IntegralMoments m_integralLow;
+    MaterialModel m_materialModel;
+    std::vector<unsigned short> m_classTable;      // (high, low) cell -> class and Z-effective
+    int m_classDepth;                              // Bit depth m_classTable was built for, 0 = stale
 };
 
-// Global instance for C-style API
-static DualEnergyFusion g_dualEnergyFusion;
-
 } // namespace Correction
 } // namespace HubxSDK
 
+/**
+ * @brief Dual-energy fusion instance behind a C API handle
+ *
+ * Calls on one handle are serialized; give each pipeline thread its own
+ * handle to correct several detectors or channels concurrently.
+ */
+struct hubx_dualenergy_t {
+    std::mutex mutex;
+    HubxSDK::Correction::DualEnergyFusion correction;
+};
+
+// Default instance for the handle-less C API
+static hubx_dualenergy_t g_dualEnergyFusion;
+
 // C-style API for compatibility
 extern "C" {
 
+/**
+ * @brief Create an independent dual-energy fusion instance
+ * @return Handle, or NULL if out of memory
+ */
+hubx_dualenergy_t* hubx_dualenergy_create() {
+    return new (std::nothrow) hubx_dualenergy_t();
+}
+
+/**
+ * @brief Destroy an instance created by hubx_dualenergy_create()
+ */
+void hubx_dualenergy_destroy(hubx_dualenergy_t* handle) {
+    delete handle;
+}
+
+/**
+ * @brief Initialize dual-energy fusion module (handle)
+ */
+int hubx_dualenergy_init_ex(hubx_dualenergy_t* handle, int width, int height) {
+    if (!handle) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    return handle->correction.initialize(width, height);
+}
+
+/**
+ * @brief Set fusion weights (handle)
+ */
+int hubx_dualenergy_set_weights_ex(hubx_dualenergy_t* handle, float highWeight, float lowWeight) {
+    if (!handle) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    return handle->correction.setFusionWeights(highWeight, lowWeight);
+}
+
+/**
+ * @brief Set fusion mode (handle)
+ */
+int hubx_dualenergy_set_mode_ex(hubx_dualenergy_t* handle, int mode) {
+    if (!handle) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    return handle->correction.setFusionMode(
+        static_cast<HubxSDK::Correction::FusionMode>(mode));
+}
+
+/**
+ * @brief Median-filter fused outputs (handle)
+ * @param kernelSize Odd window width, 3 to 101 (0 = off)
+ */
+int hubx_dualenergy_set_median_ex(hubx_dualenergy_t* handle, int kernelSize) {
+    if (!handle) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    return handle->correction.setMedian(kernelSize);
+}
+
+/**
+ * @brief Perform fusion with current settings (handle)
+ *
+ * Under overload the median and adaptive fusion are left out, see
+ * XFactory::SetOverloadPolicy(); batches are always fused in full.
+ */
+int hubx_dualenergy_fuse_ex(hubx_dualenergy_t* handle,
+                            const unsigned short* highEnergy,
+                            const unsigned short* lowEnergy,
+                            unsigned short* output,
+                            int bitDepth) {
+    if (!handle) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    return handle->correction.fuse(highEnergy, lowEnergy, output, bitDepth, true);
+}
+
+/**
+ * @brief Fuse a batch of frame pairs with current settings (handle)
+ * @param highEnergy frameCount high-energy frames
+ * @param lowEnergy frameCount low-energy frames
+ * @param output frameCount output frames
+ * @param threads Frame pairs fused concurrently (0 = pool size, 1 = in order)
+ * @param results Per-pair status, may be NULL
+ * @return HUBX_SUCCESS, or the status of the first pair that failed
+ *
+ * The handle is locked once for the whole batch. Adaptive fusion and the
+ * median keep per-frame scratch in the handle, so with either one pairs
+ * are fused in order, each one spread over the pool.
+ */
+int hubx_dualenergy_fuse_batch_ex(hubx_dualenergy_t* handle,
+                                  const unsigned short* const* highEnergy,
+                                  const unsigned short* const* lowEnergy,
+                                  unsigned short* const* output,
+                                  int frameCount,
+                                  int bitDepth,
+                                  int threads,
+                                  int* results) {
+    if (!handle || !highEnergy || !lowEnergy || !output) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    if (frameCount < 0 || threads < 0) {
+        return HUBX_ERROR_INVALID_PARAM;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    if (handle->correction.getFusionMode() == HubxSDK::Correction::FUSION_ADAPTIVE ||
+        handle->correction.getMedian() != 0) {
+        threads = 1;
+    }
+    return HX::Internal::ThreadPool::instance().runBatch(frameCount, threads, [&](int frame) {
+        int result = handle->correction.fuse(highEnergy[frame], lowEnergy[frame], output[frame], bitDepth);
+        if (results) {
+            results[frame] = result;
+        }
+        return result;
+    });
+}
+
+/**
+ * @brief Perform weighted average fusion (handle)
+ */
+int hubx_dualenergy_fuse_weighted_ex(hubx_dualenergy_t* handle,
+                                     const unsigned short* highEnergy,
+                                     const unsigned short* lowEnergy,
+                                     unsigned short* output,
+                                     int bitDepth) {
+    if (!handle) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    return handle->correction.fuseWeightedAverage(
+        highEnergy, lowEnergy, output, bitDepth);
+}
+
+/**
+ * @brief Perform material decomposition fusion (handle)
+ */
+int hubx_dualenergy_fuse_material_ex(hubx_dualenergy_t* handle,
+                                     const unsigned short* highEnergy,
+                                     const unsigned short* lowEnergy,
+                                     unsigned short* output,
+                                     int bitDepth,
+                                     float materialCoeff) {
+    if (!handle) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    return handle->correction.fuseMaterialDecomposition(
+        highEnergy, lowEnergy, output, bitDepth, materialCoeff);
+}
+
+/**
+ * @brief Perform adaptive fusion (handle)
+ */
+int hubx_dualenergy_fuse_adaptive_ex(hubx_dualenergy_t* handle,
+                                     const unsigned short* highEnergy,
+                                     const unsigned short* lowEnergy,
+                                     unsigned short* output,
+                                     int bitDepth,
+                                     int windowSize) {
+    if (!handle) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    return handle->correction.fuseAdaptive(
+        highEnergy, lowEnergy, output, bitDepth, windowSize);
+}
+
+/**
+ * @brief Calculate optimal fusion weights (handle)
+ */
+int hubx_dualenergy_calc_weights_ex(hubx_dualenergy_t* handle,
+                                    const unsigned short* highEnergy,
+                                    const unsigned short* lowEnergy,
+                                    float* optimalHighWeight,
+                                    float* optimalLowWeight) {
+    if (!handle) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    return handle->correction.calculateOptimalWeights(
+        highEnergy, lowEnergy, optimalHighWeight, optimalLowWeight);
+}
+
+/**
+ * @brief Decompose materials (handle)
+ */
+int hubx_dualenergy_decompose_ex(hubx_dualenergy_t* handle,
+                                 const unsigned short* highEnergy,
+                                 const unsigned short* lowEnergy,
+                                 unsigned short* organicOutput,
+                                 unsigned short* inorganicOutput,
+                                 int bitDepth) {
+    if (!handle) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    return handle->correction.decomposeMaterials(
+        highEnergy, lowEnergy, organicOutput, inorganicOutput, bitDepth);
+}
+
+/**
+ * @brief Set the material classification coefficients (handle)
+ * @param z0 Z-effective curve z0 + z1 R + z2 R^2 of the attenuation ratio R
+ * @param z1 See z0
+ * @param z2 See z0
+ * @param organicMaxZ Organic below this Z-effective
+ * @param metalMinZ Metal from this Z-effective up
+ * @param lutBits Bits of high and of low in the table index, 6 to 12
+ */
+int hubx_dualenergy_set_classification_ex(hubx_dualenergy_t* handle,
+                                          float z0, float z1, float z2,
+                                          float organicMaxZ, float metalMinZ,
+                                          int lutBits) {
+    if (!handle) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    HubxSDK::Correction::MaterialModel model = handle->correction.getMaterialModel();
+    model.z0 = z0;
+    model.z1 = z1;
+    model.z2 = z2;
+    model.organicMaxZ = organicMaxZ;
+    model.metalMinZ = metalMinZ;
+    model.lutBits = lutBits;
+    return handle->correction.setMaterialModel(model);
+}
+
+/**
+ * @brief Classify materials (handle)
+ * @param classes Output class per pixel: 0 background, 1 organic,
+ *                2 inorganic, 3 metal, 4 impenetrable
+ * @param zeff Output Z-effective * 100 per pixel, may be NULL
+ */
+int hubx_dualenergy_classify_ex(hubx_dualenergy_t* handle,
+                                const unsigned short* highEnergy,
+                                const unsigned short* lowEnergy,
+                                unsigned char* classes,
+                                unsigned short* zeff,
+                                int bitDepth) {
+    if (!handle) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    return handle->correction.classifyMaterials(highEnergy, lowEnergy, classes, zeff, bitDepth);
+}
+
+/**
+ * @brief Get current fusion weights (handle)
+ */
+int hubx_dualenergy_get_weights_ex(hubx_dualenergy_t* handle, float* highWeight, float* lowWeight) {
+    if (!handle) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    return handle->correction.getFusionWeights(highWeight, lowWeight);
+}
+
+/**
+ * @brief Release dual-energy fusion resources (handle)
+ */
+void hubx_dualenergy_release_ex(hubx_dualenergy_t* handle) {
+    if (!handle) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    handle->correction.release();
+}
+
 /**
  * @brief Initialize dual-energy fusion module
  */
 int hubx_dualenergy_init(int width, int height) {
-    return HubxSDK::Correction::g_dualEnergyFusion.initialize(width, height);
+    return hubx_dualenergy_init_ex(&g_dualEnergyFusion, width, height);
 }
 
 /**
  * @brief Set fusion weights
  */
 int hubx_dualenergy_set_weights(float highWeight, float lowWeight) {
-    return HubxSDK::Correction::g_dualEnergyFusion.setFusionWeights(highWeight, lowWeight);
+    return hubx_dualenergy_set_weights_ex(&g_dualEnergyFusion, highWeight, lowWeight);
 }
 
 /**
  * @brief Set fusion mode
  */
 int hubx_dualenergy_set_mode(int mode) {
-    return HubxSDK::Correction::g_dualEnergyFusion.setFusionMode(
-        static_cast<HubxSDK::Correction::FusionMode>(mode));
+    return hubx_dualenergy_set_mode_ex(&g_dualEnergyFusion, mode);
+}
+
+/**
+ * @brief Median-filter fused outputs
+ */
+int hubx_dualenergy_set_median(int kernelSize) {
+    return hubx_dualenergy_set_median_ex(&g_dualEnergyFusion, kernelSize);
+}
+
+/**
+ * @brief Median-filter an image, e.g. a fused or decomposed output
+ * @param input Input image, width * height values
+ * @param output Output image; must not overlap input
+ * @param kernelSize Odd window width, 3 to 101
+ */
+int hubx_dualenergy_median(const unsigned short* input,
+                           unsigned short* output,
+                           int width,
+                           int height,
+                           int kernelSize) {
+    return HubxSDK::Correction::DualEnergyFusion::median(input, output, width, height, kernelSize);
 }
 
 /**
@@ -562,7 +1164,7 @@ int hubx_dualenergy_fuse(const unsigned short* highEnergy,
                          const unsigned short* lowEnergy,
                          unsigned short* output,
                          int bitDepth) {
-    return HubxSDK::Correction::g_dualEnergyFusion.fuse(highEnergy, lowEnergy, output, bitDepth);
+    return hubx_dualenergy_fuse_ex(&g_dualEnergyFusion, highEnergy, lowEnergy, output, bitDepth);
 }
 
 /**
@@ -572,8 +1174,7 @@ int hubx_dualenergy_fuse_weighted(const unsigned short* highEnergy,
                                   const unsigned short* lowEnergy,
                                   unsigned short* output,
                                   int bitDepth) {
-    return HubxSDK::Correction::g_dualEnergyFusion.fuseWeightedAverage(
-        highEnergy, lowEnergy, output, bitDepth);
+    return hubx_dualenergy_fuse_weighted_ex(&g_dualEnergyFusion, highEnergy, lowEnergy, output, bitDepth);
 }
 
 /**
@@ -584,8 +1185,7 @@ int hubx_dualenergy_fuse_material(const unsigned short* highEnergy,
                                   unsigned short* output,
                                   int bitDepth,
                                   float materialCoeff) {
-    return HubxSDK::Correction::g_dualEnergyFusion.fuseMaterialDecomposition(
-        highEnergy, lowEnergy, output, bitDepth, materialCoeff);
+    return hubx_dualenergy_fuse_material_ex(&g_dualEnergyFusion, highEnergy, lowEnergy, output, bitDepth, materialCoeff);
 }
 
 /**
@@ -596,8 +1196,21 @@ int hubx_dualenergy_fuse_adaptive(const unsigned short* highEnergy,
                                   unsigned short* output,
                                   int bitDepth,
                                   int windowSize) {
-    return HubxSDK::Correction::g_dualEnergyFusion.fuseAdaptive(
-        highEnergy, lowEnergy, output, bitDepth, windowSize);
+    return hubx_dualenergy_fuse_adaptive_ex(&g_dualEnergyFusion, highEnergy, lowEnergy, output, bitDepth, windowSize);
+}
+
+/**
+ * @brief Fuse a batch of frame pairs with current settings
+ */
+int hubx_dualenergy_fuse_batch(const unsigned short* const* highEnergy,
+                               const unsigned short* const* lowEnergy,
+                               unsigned short* const* output,
+                               int frameCount,
+                               int bitDepth,
+                               int threads,
+                               int* results) {
+    return hubx_dualenergy_fuse_batch_ex(&g_dualEnergyFusion, highEnergy, lowEnergy, output,
+                                         frameCount, bitDepth, threads, results);
 }
 
 /**
@@ -607,8 +1220,7 @@ int hubx_dualenergy_calc_weights(const unsigned short* highEnergy,
                                  const unsigned short* lowEnergy,
                                  float* optimalHighWeight,
                                  float* optimalLowWeight) {
-    return HubxSDK::Correction::g_dualEnergyFusion.calculateOptimalWeights(
-        highEnergy, lowEnergy, optimalHighWeight, optimalLowWeight);
+    return hubx_dualenergy_calc_weights_ex(&g_dualEnergyFusion, highEnergy, lowEnergy, optimalHighWeight, optimalLowWeight);
 }
 
 /**
@@ -619,22 +1231,41 @@ int hubx_dualenergy_decompose(const unsigned short* highEnergy,
                               unsigned short* organicOutput,
                               unsigned short* inorganicOutput,
                               int bitDepth) {
-    return HubxSDK::Correction::g_dualEnergyFusion.decomposeMaterials(
-        highEnergy, lowEnergy, organicOutput, inorganicOutput, bitDepth);
+    return hubx_dualenergy_decompose_ex(&g_dualEnergyFusion, highEnergy, lowEnergy, organicOutput, inorganicOutput, bitDepth);
+}
+
+/**
+ * @brief Set the material classification coefficients
+ */
+int hubx_dualenergy_set_classification(float z0, float z1, float z2,
+                                       float organicMaxZ, float metalMinZ, int lutBits) {
+    return hubx_dualenergy_set_classification_ex(&g_dualEnergyFusion, z0, z1, z2,
+                                                 organicMaxZ, metalMinZ, lutBits);
+}
+
+/**
+ * @brief Classify materials
+ */
+int hubx_dualenergy_classify(const unsigned short* highEnergy,
+                             const unsigned short* lowEnergy,
+                             unsigned char* classes,
+                             unsigned short* zeff,
+                             int bitDepth) {
+    return hubx_dualenergy_classify_ex(&g_dualEnergyFusion, highEnergy, lowEnergy, classes, zeff, bitDepth);
 }
 
 /**
  * @brief Get current fusion weights
  */
 int hubx_dualenergy_get_weights(float* highWeight, float* lowWeight) {
-    return HubxSDK::Correction::g_dualEnergyFusion.getFusionWeights(highWeight, lowWeight);
+    return hubx_dualenergy_get_weights_ex(&g_dualEnergyFusion, highWeight, lowWeight);
 }
 
 /**
  * @brief Release dual-energy fusion resources
  */
 void hubx_dualenergy_release() {
-    HubxSDK::Correction::g_dualEnergyFusion.release();
+    hubx_dualenergy_release_ex(&g_dualEnergyFusion);
 }
 
 } // extern "C"
\ No newline at end of file
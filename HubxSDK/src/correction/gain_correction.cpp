@@ -9,6 +9,10 @@
 
 #include "../../include/xog_correct.h"
 #include "../../include/xmg_correct.h"
+#include "../utils/box_filter.h"
+#include "../utils/calib_report.h"
+#include "../utils/median_of_means.h"
+#include "../utils/thread_pool.h"
 #include <cstring>
 #include <cmath>
 #include <algorithm>
@@ -75,6 +79,47 @@ bool CalculateGainCoefficients(const unsigned short* raw_data,
     return true;
 }
 
+/**
+ * @brief Calculate gain coefficients from several bright frames, robust to transients
+ * @param frames Bright-field frames
+ * @param num_frames Number of frames (at least groups for full protection)
+ * @param width Image width
+ * @param height Image height
+ * @param target_value Target output value
+ * @param gain_coeffs Output gain coefficients
+ * @param groups Frames are dealt into this many groups; each pixel uses the
+ *        median of its group means, so a cosmic hit in a minority of the
+ *        groups does not bias its gain
+ * @return true on success, false on failure
+ *
+ * One pass over the frames; memory is groups sums per pixel, not frames.
+ */
+bool CalculateRobustGainCoefficients(const unsigned short* const* frames,
+                                     int num_frames,
+                                     int width,
+                                     int height,
+                                     unsigned short target_value,
+                                     float* gain_coeffs,
+                                     int groups = 5)
+{
+    if (!frames || num_frames <= 0 || !gain_coeffs || width <= 0 || height <= 0) {
+        return false;
+    }
+
+    const size_t total_pixels = static_cast<size_t>(width) * height;
+    HX::Internal::MedianOfMeansAccumulator accumulator;
+    accumulator.reset(total_pixels, groups);
+    for (int f = 0; f < num_frames; ++f) {
+        if (!frames[f] || !accumulator.add(frames[f])) {
+            return false;
+        }
+    }
+
+    std::vector<unsigned short> bright(total_pixels);
+    accumulator.estimates(bright.data());
+    return CalculateGainCoefficients(bright.data(), width, height, target_value, gain_coeffs);
+}
+
 /**
  * @brief Apply single-gain correction to image data
  * @param input_data Input raw image data
@@ -147,39 +192,41 @@ bool ApplyGainCorrection(const unsigned short* input_data,
         return false;
     }
 
-    const int total_pixels = width * height;
     const unsigned short max_value = (1 << params.bit_depth) - 1;
 
-    for (int i = 0; i < total_pixels; ++i) {
-        float corrected = static_cast<float>(input_data[i]);
+    // Row bands on the shared pool, each pixel depends only on itself
+    HX::Internal::ThreadPool::instance().parallelRows(height, width, [&](int first_row, int end_row) {
+        for (int i = first_row * width; i < end_row * width; ++i) {
+            float corrected = static_cast<float>(input_data[i]);
 
-        // Step 1: Apply offset correction if enabled
-        if (params.enable_offset && params.offset_data) {
-            corrected -= static_cast<float>(params.offset_data[i]);
-        }
+            // Step 1: Apply offset correction if enabled
+            if (params.enable_offset && params.offset_data) {
+                corrected -= static_cast<float>(params.offset_data[i]);
+            }
 
-        // Step 2: Apply baseline correction if enabled
-        if (params.enable_baseline && params.baseline_data) {
-            corrected -= static_cast<float>(params.baseline_data[i]);
-        }
+            // Step 2: Apply baseline correction if enabled
+            if (params.enable_baseline && params.baseline_data) {
+                corrected -= static_cast<float>(params.baseline_data[i]);
+            }
 
-        // Step 3: Apply gain correction if enabled
-        if (params.enable_gain && params.gain_coeffs) {
-            corrected *= params.gain_coeffs[i];
-        }
+            // Step 3: Apply gain correction if enabled
+            if (params.enable_gain && params.gain_coeffs) {
+                corrected *= params.gain_coeffs[i];
+            }
 
-        // Step 4: Add target baseline
-        corrected += static_cast<float>(params.target_baseline);
+            // Step 4: Add target baseline
+            corrected += static_cast<float>(params.target_baseline);
 
-        // Step 5: Clamp to valid range
-        if (corrected < 0.0f) {
-            output_data[i] = 0;
-        } else if (corrected > max_value) {
-            output_data[i] = max_value;
-        } else {
-            output_data[i] = static_cast<unsigned short>(corrected + 0.5f);
+            // Step 5: Clamp to valid range
+            if (corrected < 0.0f) {
+                output_data[i] = 0;
+            } else if (corrected > max_value) {
+                output_data[i] = max_value;
+            } else {
+                output_data[i] = static_cast<unsigned short>(corrected + 0.5f);
+            }
         }
-    }
+    });
 
     return true;
 }
@@ -197,20 +244,11 @@ bool ValidateGainData(const float* gain_coeffs, int width, int height)
         return false;
     }
 
-    const int total_pixels = width * height;
-    int invalid_count = 0;
-
-    for (int i = 0; i < total_pixels; ++i) {
-        if (std::isnan(gain_coeffs[i]) || std::isinf(gain_coeffs[i])) {
-            invalid_count++;
-        }
-        if (gain_coeffs[i] <= 0.0f || gain_coeffs[i] > 100.0f) {
-            invalid_count++;
-        }
-    }
-
-    // Allow up to 0.1% invalid pixels
-    return invalid_count < (total_pixels / 1000);
+    // Allow up to 0.1% invalid pixels; each counts once, however it fails
+    HX::Internal::CalibrationReport report;
+    HX::Internal::BuildCalibrationReport(NULL, gain_coeffs, NULL,
+                                         static_cast<size_t>(width) * height, report);
+    return report.valid();
 }
 
 /**
@@ -218,7 +256,10 @@ bool ValidateGainData(const float* gain_coeffs, int width, int height)
  * @param gain_coeffs Input/output gain coefficients
  * @param width Image width
  * @param height Image height
- * @param kernel_size Smoothing kernel size (3, 5, or 7)
+ * @param kernel_size Smoothing kernel size (odd, >= 3; even sizes round up)
+ *
+ * Box mean with the window clipped at the image border, so border pixels
+ * are smoothed too. Cost per pixel does not depend on the kernel size.
  */
 void SmoothGainCoefficients(float* gain_coeffs, int width, int height, int kernel_size)
 {
@@ -226,31 +267,14 @@ void SmoothGainCoefficients(float* gain_coeffs, int width, int height, int kerne
         return;
     }
 
-    if (kernel_size != 3 && kernel_size != 5 && kernel_size != 7) {
+    if (kernel_size < 3) {
         kernel_size = 3;
     }
 
-    std::vector<float> temp(width * height);
-    std::memcpy(temp.data(), gain_coeffs, width * height * sizeof(float));
-
-    const int half_kernel = kernel_size / 2;
-
-    for (int y = half_kernel; y < height - half_kernel; ++y) {
-        for (int x = half_kernel; x < width - half_kernel; ++x) {
-            float sum = 0.0f;
-            int count = 0;
+    std::vector<float> temp(static_cast<size_t>(width) * height);
+    std::memcpy(temp.data(), gain_coeffs, temp.size() * sizeof(float));
 
-            for (int ky = -half_kernel; ky <= half_kernel; ++ky) {
-                for (int kx = -half_kernel; kx <= half_kernel; ++kx) {
-                    int idx = (y + ky) * width + (x + kx);
-                    sum += temp[idx];
-                    count++;
-                }
-            }
-
-            gain_coeffs[y * width + x] = sum / count;
-        }
-    }
+    HX::Internal::boxMean(temp.data(), width, height, kernel_size / 2, gain_coeffs);
 }
 
 /**
@@ -262,6 +286,8 @@ void SmoothGainCoefficients(float* gain_coeffs, int width, int height, int kerne
  * @param std_dev Output standard deviation
  * @param min_val Output minimum value
  * @param max_val Output maximum value
+ *
+ * Non-finite gains are left out; ValidateGainData() counts them.
  */
 void CalculateGainStatistics(const float* gain_coeffs,
                             int width,
@@ -277,27 +303,13 @@ void CalculateGainStatistics(const float* gain_coeffs,
         return;
     }
 
-    const int total_pixels = width * height;
-    
-    mean = 0.0f;
-    min_val = gain_coeffs[0];
-    max_val = gain_coeffs[0];
-
-    // Calculate mean, min, max
-    for (int i = 0; i < total_pixels; ++i) {
-        mean += gain_coeffs[i];
-        if (gain_coeffs[i] < min_val) min_val = gain_coeffs[i];
-        if (gain_coeffs[i] > max_val) max_val = gain_coeffs[i];
-    }
-    mean /= total_pixels;
-
-    // Calculate standard deviation
-    std_dev = 0.0f;
-    for (int i = 0; i < total_pixels; ++i) {
-        float diff = gain_coeffs[i] - mean;
-        std_dev += diff * diff;
-    }
-    std_dev = std::sqrt(std_dev / total_pixels);
+    HX::Internal::CalibrationReport report;
+    HX::Internal::BuildCalibrationReport(NULL, gain_coeffs, NULL,
+                                         static_cast<size_t>(width) * height, report);
+    mean = static_cast<float>(report.gain.mean);
+    std_dev = static_cast<float>(report.gain.stdDev());
+    min_val = report.gain.minValue;
+    max_val = report.gain.maxValue;
 }
 
 } // namespace fximage
\ No newline at end of file
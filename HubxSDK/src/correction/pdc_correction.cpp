@@ -7,9 +7,15 @@
  * @date 2025
  */
 
+#include "../../include/ixline_filter.h"
+#include "../utils/cpu_features.h"
+#include "../utils/thread_pool.h"
 #include <cstring>
 #include <cmath>
 #include <algorithm>
+#include <map>
+#include <mutex>
+#include <string>
 #include <vector>
 
 namespace fximage {
@@ -26,6 +32,40 @@ struct PDCCorrectionParams {
     int num_gaps;                       // Number of gaps
 };
 
+/**
+ * @brief Resampling plan for one detector geometry
+ *
+ * Output column x reads input columns source_index[x] and source_index[x] + 1:
+ * out = v0 + weight[x] * (v1 - v0). Build it once with BuildPDCPlan() and
+ * reuse it for every frame of the same width and gap layout.
+ */
+struct PDCPlan {
+    int input_width;
+    int output_width;
+    std::vector<int> source_index;      // Left tap, at most input_width - 2
+    std::vector<float> weight;          // Right tap weight (0.0 to 1.0)
+
+    PDCPlan() : input_width(0), output_width(0) {}
+};
+
+/**
+ * @brief Gap fill compiled for one detector geometry
+ *
+ * Entry i writes row[column[i]] = row[left[i]] + weight[i] * (row[right[i]] - row[left[i]]).
+ * Entries run in order and in place, so a gap bordering an earlier one
+ * reads its filled values, as FillGapsWithInterpolation() always did.
+ * Build it once with BuildPDCGapPlan() and run it per row or per line.
+ */
+struct PDCGapPlan {
+    int width;
+    std::vector<int> column;            // Column filled
+    std::vector<int> left;              // Boundary columns, outside the gap
+    std::vector<int> right;
+    std::vector<float> weight;          // Right boundary weight (0.0 to 1.0)
+
+    PDCGapPlan() : width(0) {}
+};
+
 /**
  * @brief Linear interpolation between two values
  * @param v0 First value
@@ -142,34 +182,92 @@ int DetectGapPositions(const unsigned short* data,
     return gap_count;
 }
 
+namespace {
+
+typedef void (*PDCRowKernel)(const PDCPlan& plan, const unsigned short* src, unsigned short* dst,
+                             int first, int last);
+
 /**
- * @brief Apply PDC correction using linear interpolation resampling
- * @param input_data Input image data with discontinuities
- * @param output_data Output corrected image data
- * @param width Image width in pixels
- * @param height Image height in pixels
- * @param params PDC correction parameters
- * @return true on success, false on failure
+ * @brief Two-tap gather over output columns [first, last) of one row
  */
-bool ApplyPDCCorrection(const unsigned short* input_data,
-                       unsigned short* output_data,
-                       int width,
-                       int height,
-                       const PDCCorrectionParams& params)
+void PDCRowScalar(const PDCPlan& plan, const unsigned short* src, unsigned short* dst,
+                  int first, int last)
 {
-    if (!input_data || !output_data || width <= 0 || height <= 0) {
-        return false;
+    const int* index = plan.source_index.data();
+    const float* weight = plan.weight.data();
+
+    for (int x = first; x < last; ++x) {
+        float v0 = static_cast<float>(src[index[x]]);
+        float v1 = static_cast<float>(src[index[x] + 1]);
+        float value = LinearInterpolate(v0, v1, weight[x]);
+        dst[x] = static_cast<unsigned short>(value + 0.5f);
     }
+}
 
-    if (params.num_gaps == 0 || !params.gap_positions) {
-        // No gaps, just copy data
-        std::memcpy(output_data, input_data, width * height * sizeof(unsigned short));
-        return true;
+#if defined(HX_ARCH_X86)
+
+/**
+ * @brief AVX2 gather: one 32-bit load at the left tap carries both taps
+ *
+ * The load covers bytes [2 * index, 2 * index + 4), inside the row since
+ * index <= input_width - 2. Same operation order as the scalar kernel.
+ */
+HX_TARGET("avx2")
+void PDCRowAVX2(const PDCPlan& plan, const unsigned short* src, unsigned short* dst,
+                int first, int last)
+{
+    const int* index = plan.source_index.data();
+    const float* weight = plan.weight.data();
+    const int* base = reinterpret_cast<const int*>(src);
+    const __m256i low_mask = _mm256_set1_epi32(0xFFFF);
+    const __m256 half = _mm256_set1_ps(0.5f);
+
+    int x = first;
+    for (; x + 8 <= last; x += 8) {
+        __m256i taps = _mm256_i32gather_epi32(base, _mm256_loadu_si256(
+            reinterpret_cast<const __m256i*>(index + x)), 2);
+        __m256 v0 = _mm256_cvtepi32_ps(_mm256_and_si256(taps, low_mask));
+        __m256 v1 = _mm256_cvtepi32_ps(_mm256_srli_epi32(taps, 16));
+        __m256 t = _mm256_loadu_ps(weight + x);
+
+        __m256 value = _mm256_add_ps(v0, _mm256_mul_ps(t, _mm256_sub_ps(v1, v0)));
+        __m256i v = _mm256_cvttps_epi32(_mm256_add_ps(value, half));
+        __m128i packed = _mm_packus_epi32(_mm256_castsi256_si128(v),
+                                          _mm256_extracti128_si256(v, 1));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x), packed);
     }
+    PDCRowScalar(plan, src, dst, x, last);
+}
 
-    // Calculate total gap width
-    int total_gap_width = params.num_gaps * params.gap_width;
-    int corrected_width = width - total_gap_width;
+#endif // HX_ARCH_X86
+
+const HX::Internal::KernelFamily g_pdcKernels("pdc_correct", HX::XFactory::CPU_AVX2);
+
+PDCRowKernel SelectPDCRowKernel()
+{
+#if defined(HX_ARCH_X86)
+    if (g_pdcKernels.isa() == HX::XFactory::CPU_AVX2) return &PDCRowAVX2;
+#endif
+    return &PDCRowScalar;
+}
+
+} // namespace
+
+/**
+ * @brief Build the resampling plan for a detector geometry
+ * @param width Input image width in pixels
+ * @param params PDC correction parameters
+ * @param plan Output plan
+ * @return true on success, false if the gaps leave no columns
+ */
+bool BuildPDCPlan(int width, const PDCCorrectionParams& params, PDCPlan& plan)
+{
+    if (width < 2) {
+        return false;
+    }
+
+    const int num_gaps = params.gap_positions ? params.num_gaps : 0;
+    const int corrected_width = width - num_gaps * params.gap_width;
 
     if (corrected_width <= 0) {
         return false;
@@ -177,15 +275,13 @@ bool ApplyPDCCorrection(const unsigned short* input_data,
 
     // Build mapping from output coordinates to input coordinates
     std::vector<float> x_mapping(corrected_width);
-    
     int output_x = 0;
-    float accumulated_gap = 0.0f;
 
     for (int x = 0; x < width && output_x < corrected_width; ++x) {
         // Check if current position is in a gap
         bool in_gap = false;
-        for (int g = 0; g < params.num_gaps; ++g) {
-            if (x >= params.gap_positions[g] && 
+        for (int g = 0; g < num_gaps; ++g) {
+            if (x >= params.gap_positions[g] &&
                 x < params.gap_positions[g] + params.gap_width) {
                 in_gap = true;
                 break;
@@ -198,27 +294,94 @@ bool ApplyPDCCorrection(const unsigned short* input_data,
         }
     }
 
-    // Apply correction with interpolation
-    for (int y = 0; y < height; ++y) {
-        for (int x = 0; x < corrected_width; ++x) {
-            if (params.enable_interpolation) {
-                // Use bilinear interpolation
-                float value = BilinearInterpolate(input_data, width, height,
-                                                 x_mapping[x], static_cast<float>(y));
-                output_data[y * corrected_width + x] = 
-                    static_cast<unsigned short>(value + 0.5f);
-            } else {
-                // Nearest neighbor
-                int src_x = static_cast<int>(x_mapping[x] + 0.5f);
-                output_data[y * corrected_width + x] = 
-                    input_data[y * width + src_x];
-            }
-        }
+    plan.input_width = width;
+    plan.output_width = corrected_width;
+    plan.source_index.assign(corrected_width, 0);
+    plan.weight.assign(corrected_width, 0.0f);
+
+    for (int x = 0; x < corrected_width; ++x) {
+        // Nearest neighbour is the same gather with the position rounded
+        float position = params.enable_interpolation ? x_mapping[x]
+                                                     : std::floor(x_mapping[x] + 0.5f);
+        position = std::max(0.0f, std::min(static_cast<float>(width - 1), position));
+
+        // Keep both taps in the row; the last column reads the right tap
+        int left = std::min(static_cast<int>(position), width - 2);
+        plan.source_index[x] = left;
+        plan.weight[x] = position - static_cast<float>(left);
     }
 
     return true;
 }
 
+/**
+ * @brief Resample a frame with a prebuilt plan
+ * @param plan Plan from BuildPDCPlan()
+ * @param input_data Input image, plan.input_width x height
+ * @param output_data Output image, plan.output_width x height
+ * @param height Image height in pixels
+ * @return true on success, false on failure
+ *
+ * @note Rows are independent and run in bands on the correction thread pool
+ */
+bool ApplyPDCPlan(const PDCPlan& plan,
+                  const unsigned short* input_data,
+                  unsigned short* output_data,
+                  int height)
+{
+    if (!input_data || !output_data || height <= 0 || plan.output_width <= 0 ||
+        static_cast<int>(plan.source_index.size()) != plan.output_width) {
+        return false;
+    }
+
+    const PDCRowKernel kernel = SelectPDCRowKernel();
+    HX::Internal::ThreadPool::instance().parallelRows(height, plan.output_width, [&](int first_row, int end_row) {
+        for (int y = first_row; y < end_row; ++y) {
+            kernel(plan,
+                   input_data + static_cast<size_t>(y) * plan.input_width,
+                   output_data + static_cast<size_t>(y) * plan.output_width,
+                   0, plan.output_width);
+        }
+    });
+
+    return true;
+}
+
+/**
+ * @brief Apply PDC correction using linear interpolation resampling
+ * @param input_data Input image data with discontinuities
+ * @param output_data Output corrected image data
+ * @param width Image width in pixels
+ * @param height Image height in pixels
+ * @param params PDC correction parameters
+ * @return true on success, false on failure
+ *
+ * @note Builds a plan on every call; keep a PDCPlan for repeated frames
+ */
+bool ApplyPDCCorrection(const unsigned short* input_data,
+                       unsigned short* output_data,
+                       int width,
+                       int height,
+                       const PDCCorrectionParams& params)
+{
+    if (!input_data || !output_data || width <= 0 || height <= 0) {
+        return false;
+    }
+
+    if (params.num_gaps == 0 || !params.gap_positions) {
+        // No gaps, just copy data
+        std::memcpy(output_data, input_data, width * height * sizeof(unsigned short));
+        return true;
+    }
+
+    PDCPlan plan;
+    if (!BuildPDCPlan(width, params, plan)) {
+        return false;
+    }
+
+    return ApplyPDCPlan(plan, input_data, output_data, height);
+}
+
 /**
  * @brief Apply PDC correction for standard detector configuration
  * @param input_data Input image data
@@ -265,6 +428,95 @@ bool ApplyStandardPDCCorrection(const unsigned short* input_data,
     return ApplyPDCCorrection(input_data, output_data, width, height, params);
 }
 
+/**
+ * @brief Compile gap filling for a detector geometry
+ * @param width Row width in pixels
+ * @param gap_positions Array of gap center positions
+ * @param gap_widths Array of gap widths
+ * @param num_gaps Number of gaps
+ * @param plan Output plan
+ * @return true on success, false on failure
+ *
+ * @note Gaps whose boundary columns would fall outside the row are skipped
+ */
+bool BuildPDCGapPlan(int width,
+                     const int* gap_positions,
+                     const int* gap_widths,
+                     int num_gaps,
+                     PDCGapPlan& plan)
+{
+    if (width <= 0 || num_gaps < 0 || (num_gaps > 0 && (!gap_positions || !gap_widths))) {
+        return false;
+    }
+
+    plan.width = width;
+    plan.column.clear();
+    plan.left.clear();
+    plan.right.clear();
+    plan.weight.clear();
+
+    for (int g = 0; g < num_gaps; ++g) {
+        int gap_center = gap_positions[g];
+        int gap_width = gap_widths[g];
+        int gap_start = gap_center - gap_width / 2;
+        int gap_end = gap_center + gap_width / 2;
+
+        if (gap_start < 1 || gap_end >= width - 1) continue;
+
+        for (int x = gap_start; x <= gap_end; ++x) {
+            plan.column.push_back(x);
+            plan.left.push_back(gap_start - 1);
+            plan.right.push_back(gap_end + 1);
+            plan.weight.push_back(static_cast<float>(x - gap_start) / (gap_end - gap_start + 1));
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief Fill the gaps of one row in place
+ * @param plan Plan from BuildPDCGapPlan()
+ * @param row Row of plan.width pixels
+ */
+void ApplyPDCGapPlanLine(const PDCGapPlan& plan, unsigned short* row)
+{
+    const size_t count = plan.column.size();
+    for (size_t i = 0; i < count; ++i) {
+        float interpolated = LinearInterpolate(
+            static_cast<float>(row[plan.left[i]]),
+            static_cast<float>(row[plan.right[i]]),
+            plan.weight[i]
+        );
+        row[plan.column[i]] = static_cast<unsigned short>(interpolated + 0.5f);
+    }
+}
+
+/**
+ * @brief Fill the gaps of a frame in place with a prebuilt plan
+ * @param plan Plan from BuildPDCGapPlan()
+ * @param data Image, plan.width x height
+ * @param height Image height in pixels
+ * @return true on success, false on failure
+ */
+bool ApplyPDCGapPlan(const PDCGapPlan& plan, unsigned short* data, int height)
+{
+    if (!data || height <= 0 || plan.width <= 0) {
+        return false;
+    }
+    if (plan.column.empty()) {
+        return true;
+    }
+
+    HX::Internal::ThreadPool::instance().parallelRows(height, plan.width, [&](int first_row, int end_row) {
+        for (int y = first_row; y < end_row; ++y) {
+            ApplyPDCGapPlanLine(plan, data + static_cast<size_t>(y) * plan.width);
+        }
+    });
+
+    return true;
+}
+
 /**
  * @brief Fill gaps with interpolated values instead of removing them
  * @param data Input/output image data
@@ -274,6 +526,8 @@ bool ApplyStandardPDCCorrection(const unsigned short* input_data,
  * @param gap_widths Array of gap widths
  * @param num_gaps Number of gaps
  * @return true on success, false on failure
+ *
+ * @note Builds a plan on every call; keep a PDCGapPlan for repeated frames
  */
 bool FillGapsWithInterpolation(unsigned short* data,
                                int width,
@@ -286,35 +540,185 @@ bool FillGapsWithInterpolation(unsigned short* data,
         return false;
     }
 
-    for (int y = 0; y < height; ++y) {
-        for (int g = 0; g < num_gaps; ++g) {
-            int gap_center = gap_positions[g];
-            int gap_width = gap_widths[g];
-            int gap_start = gap_center - gap_width / 2;
-            int gap_end = gap_center + gap_width / 2;
-
-            if (gap_start < 0 || gap_end >= width) continue;
-
-            // Get left and right boundary values
-            unsigned short left_value = data[y * width + gap_start - 1];
-            unsigned short right_value = data[y * width + gap_end + 1];
-
-            // Linear interpolation across the gap
-            for (int x = gap_start; x <= gap_end; ++x) {
-                float t = static_cast<float>(x - gap_start) / (gap_end - gap_start + 1);
-                float interpolated = LinearInterpolate(
-                    static_cast<float>(left_value),
-                    static_cast<float>(right_value),
-                    t
-                );
-                data[y * width + x] = static_cast<unsigned short>(interpolated + 0.5f);
-            }
+    PDCGapPlan plan;
+    if (!BuildPDCGapPlan(width, gap_positions, gap_widths, num_gaps, plan)) {
+        return false;
+    }
+    return ApplyPDCGapPlan(plan, data, height);
+}
+
+/**
+ * @brief Detect gaps on a calibration frame and compile their fill
+ * @param calibration Flat-field frame, width x height
+ * @param width Image width
+ * @param height Image height
+ * @param gap_width Width of every gap in pixels
+ * @param max_gaps Maximum number of gaps to detect
+ * @param plan Output plan
+ * @return Number of gaps detected, or -1 on failure
+ */
+int DetectPDCGapPlan(const unsigned short* calibration,
+                     int width,
+                     int height,
+                     int gap_width,
+                     int max_gaps,
+                     PDCGapPlan& plan)
+{
+    if (!calibration || width <= 0 || height <= 0 || gap_width <= 0 || max_gaps <= 0) {
+        return -1;
+    }
+
+    std::vector<float> found(max_gaps);
+    const int count = DetectGapPositions(calibration, width, height, found.data(), max_gaps);
+
+    std::vector<int> positions(count);
+    std::vector<int> widths(count, gap_width);
+    for (int g = 0; g < count; ++g) {
+        positions[g] = static_cast<int>(found[g] + 0.5f);
+    }
+    if (!BuildPDCGapPlan(width, positions.data(), widths.data(), count, plan)) {
+        return -1;
+    }
+    return count;
+}
+
+namespace {
+
+/**
+ * @brief Detected gap plans by detector serial number
+ */
+struct CachedGapPlan {
+    int gap_width;
+    int gaps;
+    PDCGapPlan plan;
+};
+
+std::mutex g_gap_plan_mutex;
+std::map<std::string, CachedGapPlan> g_gap_plans;
+
+} // namespace
+
+/**
+ * @brief DetectPDCGapPlan() once per detector, cached by serial number
+ * @param serial Detector serial number (XCU_SN)
+ * @param calibration Flat-field frame, width x height; only read on a miss
+ * @param width Image width
+ * @param height Image height
+ * @param gap_width Width of every gap in pixels
+ * @param max_gaps Maximum number of gaps to detect
+ * @param plan Output plan
+ * @return Number of gaps detected, or -1 on failure
+ *
+ * @note A cached plan is reused while width and gap width match; call
+ *       ClearPDCGapPlans() after recalibrating
+ */
+int DetectPDCGapPlanCached(const char* serial,
+                           const unsigned short* calibration,
+                           int width,
+                           int height,
+                           int gap_width,
+                           int max_gaps,
+                           PDCGapPlan& plan)
+{
+    if (!serial) {
+        return -1;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(g_gap_plan_mutex);
+        std::map<std::string, CachedGapPlan>::const_iterator it = g_gap_plans.find(serial);
+        if (it != g_gap_plans.end() && it->second.plan.width == width &&
+            it->second.gap_width == gap_width) {
+            plan = it->second.plan;
+            return it->second.gaps;
         }
     }
 
+    // Detect without the lock; a concurrent miss on the same serial just detects twice
+    CachedGapPlan entry;
+    entry.gap_width = gap_width;
+    entry.gaps = DetectPDCGapPlan(calibration, width, height, gap_width, max_gaps, entry.plan);
+    if (entry.gaps < 0) {
+        return -1;
+    }
+
+    plan = entry.plan;
+    std::lock_guard<std::mutex> lock(g_gap_plan_mutex);
+    g_gap_plans[serial] = entry;
+    return entry.gaps;
+}
+
+/**
+ * @brief Get the cached plan of a detector
+ * @param serial Detector serial number
+ * @param plan Output plan
+ * @return true if a plan is cached for the serial
+ */
+bool FindPDCGapPlan(const char* serial, PDCGapPlan& plan)
+{
+    if (!serial) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(g_gap_plan_mutex);
+    std::map<std::string, CachedGapPlan>::const_iterator it = g_gap_plans.find(serial);
+    if (it == g_gap_plans.end()) {
+        return false;
+    }
+    plan = it->second.plan;
     return true;
 }
 
+/**
+ * @brief Drop cached plans
+ * @param serial Detector serial number, or NULL for all detectors
+ */
+void ClearPDCGapPlans(const char* serial)
+{
+    std::lock_guard<std::mutex> lock(g_gap_plan_mutex);
+    if (serial) {
+        g_gap_plans.erase(serial);
+    } else {
+        g_gap_plans.clear();
+    }
+}
+
+/**
+ * @brief Runs a PDCGapPlan on lines as XFrame places them
+ *
+ * Every row gets the same fill, so it suits line-scan frames of any
+ * height. Lines that do not match the plan width or are not 9-16 bit
+ * are copied unchanged.
+ */
+class PDCGapLineFilter : public HX::IXLineFilter {
+public:
+    explicit PDCGapLineFilter(const PDCGapPlan& plan) : m_plan(plan) {}
+
+    void OnLine(const uint8_t* src, uint8_t* dst, uint32_t width,
+                uint8_t pixelDepth, uint32_t row)
+    {
+        (void)row;
+        if (src != dst) {
+            std::memcpy(dst, src, static_cast<size_t>(width) * ((pixelDepth + 7) / 8));
+        }
+        if (static_cast<int>(width) == m_plan.width && (pixelDepth + 7) / 8 == 2) {
+            ApplyPDCGapPlanLine(m_plan, reinterpret_cast<unsigned short*>(dst));
+        }
+    }
+
+private:
+    PDCGapPlan m_plan;
+};
+
+HX::IXLineFilter* CreatePDCGapLineFilter(const PDCGapPlan& plan)
+{
+    return plan.width > 0 ? new PDCGapLineFilter(plan) : nullptr;
+}
+
+void DestroyPDCGapLineFilter(HX::IXLineFilter* filter)
+{
+    delete filter;
+}
+
 /**
  * @brief Calculate PDC correction quality metrics
  * @param original_data Original uncorrected data
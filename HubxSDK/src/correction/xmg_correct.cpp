@@ -8,10 +8,18 @@
  */
 
 #include "../../include/xmg_correct.h"
+#include "../utils/thread_pool.h"
+#include "../utils/cpu_features.h"
+#include "../utils/pixel_histogram.h"
+#include "../utils/calib_report.h"
+#include "../utils/saturation_map.h"
+#include <cstdint>
 #include <cstring>
 #include <cmath>
 #include <algorithm>
 #include <vector>
+#include <memory>
+#include <mutex>
 
 namespace fximage {
 
@@ -26,6 +34,7 @@ struct MultiGainParams {
     unsigned short* baseline_data;      // Baseline correction data
     int bit_depth;                      // Output bit depth
     bool auto_switch;                   // Automatic gain mode switching
+    uint8_t** saturation_maps;          // Per-mode linear ceilings (saturation_map.h), NULL = none
 };
 
 /**
@@ -48,6 +57,7 @@ bool InitMultiGainCorrection(MultiGainParams& params,
     params.num_gains = num_gains;
     params.bit_depth = 14; // Default 14-bit
     params.auto_switch = true;
+    params.saturation_maps = nullptr;
 
     // Allocate threshold array
     params.thresholds = new unsigned short[num_gains];
@@ -115,6 +125,14 @@ void ReleaseMultiGainCorrection(MultiGainParams& params)
         delete[] params.baseline_data;
         params.baseline_data = nullptr;
     }
+
+    if (params.saturation_maps) {
+        for (int i = 0; i < params.num_gains; ++i) {
+            delete[] params.saturation_maps[i];
+        }
+        delete[] params.saturation_maps;
+        params.saturation_maps = nullptr;
+    }
 }
 
 /**
@@ -136,6 +154,309 @@ inline int SelectGainMode(unsigned short value,
     return num_gains - 1; // Highest gain mode
 }
 
+namespace {
+
+/**
+ * @brief Raw value -> gain mode lookup for one threshold set
+ *
+ * Entry bits 0-7 hold the pixel's mode, bits 8-15 the mode it blends
+ * towards and bits 16-31 the partner weight in Q16 (0 = no blend), so
+ * result = c[mode] + (c[partner] - c[mode]) * weight with no branches.
+ */
+struct GainModeTable {
+    std::vector<unsigned short> thresholds;
+    int num_gains;
+    int blend_width;
+    std::vector<uint32_t> entries;      ///< 65536 entries, 256 KB
+};
+
+/**
+ * @brief Table entry of one raw value for a threshold set
+ */
+uint32_t GainModeEntry(unsigned short input_val, const unsigned short* thresholds,
+                       int num_gains, int blend_width)
+{
+    const int mode = SelectGainMode(input_val, thresholds, num_gains);
+
+    // Same blend zones as the per-pixel search used to find
+    int partner = mode;
+    float blend_factor = 0.0f;
+    if (blend_width > 0) {
+        if (mode > 0) {
+            int dist_to_lower = input_val - thresholds[mode - 1];
+            if (dist_to_lower < blend_width && dist_to_lower >= 0) {
+                blend_factor = static_cast<float>(dist_to_lower) / blend_width;
+                partner = mode - 1;
+            }
+        }
+        if (mode < num_gains - 1 && partner == mode) {
+            int dist_to_upper = thresholds[mode] - input_val;
+            if (dist_to_upper < blend_width && dist_to_upper >= 0) {
+                blend_factor = static_cast<float>(dist_to_upper) / blend_width;
+                partner = mode + 1;
+            }
+        }
+    }
+
+    uint32_t weight = 0;
+    if (partner != mode && blend_factor > 0.0f) {
+        // Own mode keeps blend_factor, the partner gets the rest
+        weight = static_cast<uint32_t>(std::floor((1.0f - blend_factor) * 65536.0f + 0.5f));
+        weight = std::min<uint32_t>(weight, 65535);
+    } else {
+        partner = mode;
+    }
+
+    return static_cast<uint32_t>(mode) | (static_cast<uint32_t>(partner) << 8) | (weight << 16);
+}
+
+std::shared_ptr<const GainModeTable> BuildGainModeTable(const MultiGainParams& params, int blend_width)
+{
+    std::shared_ptr<GainModeTable> table = std::make_shared<GainModeTable>();
+    table->thresholds.assign(params.thresholds, params.thresholds + std::max(0, params.num_gains - 1));
+    table->num_gains = params.num_gains;
+    table->blend_width = blend_width;
+    table->entries.resize(65536);
+
+    for (int value = 0; value < 65536; ++value) {
+        table->entries[value] = GainModeEntry(static_cast<unsigned short>(value), params.thresholds,
+                                              params.num_gains, blend_width);
+    }
+
+    return table;
+}
+
+/**
+ * @brief Table for a threshold set, rebuilt only when the set changes
+ */
+std::shared_ptr<const GainModeTable> GetGainModeTable(const MultiGainParams& params, int blend_width)
+{
+    static std::mutex cache_mutex;
+    static std::vector<std::shared_ptr<const GainModeTable> > cache;
+    const size_t CACHE_SIZE = 4;
+
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    for (size_t i = 0; i < cache.size(); ++i) {
+        const GainModeTable& t = *cache[i];
+        if (t.num_gains == params.num_gains && t.blend_width == blend_width &&
+            std::equal(t.thresholds.begin(), t.thresholds.end(), params.thresholds)) {
+            return cache[i];
+        }
+    }
+
+    std::shared_ptr<const GainModeTable> table = BuildGainModeTable(params, blend_width);
+    if (cache.size() >= CACHE_SIZE) {
+        cache.erase(cache.begin());
+    }
+    cache.push_back(table);
+    return table;
+}
+
+/**
+ * @brief Inputs of one table-driven correction run over pixels [first, end)
+ */
+struct MultiGainRun {
+    const unsigned short* input;
+    unsigned short* output;
+    const uint32_t* entries;
+    unsigned short* const* offset;
+    float* const* gain;
+    const unsigned short* baseline;
+    int num_gains;
+    int first;
+    int end;
+    float max_value;
+};
+
+inline unsigned short StoreCorrected(float result, float max_value)
+{
+    if (result < 0.0f) return 0;
+    if (result > max_value) return static_cast<unsigned short>(max_value);
+    return static_cast<unsigned short>(result + 0.5f);
+}
+
+template <bool Blend>
+void MultiGainScalarRange(const MultiGainRun& run, int first, int end)
+{
+    for (int i = first; i < end; ++i) {
+        const unsigned short input_val = run.input[i];
+        const uint32_t entry = run.entries[input_val];
+        const int mode = entry & 0xFF;
+        const float base = run.baseline ? static_cast<float>(run.baseline[i]) : 0.0f;
+
+        float result = static_cast<float>(input_val) - static_cast<float>(run.offset[mode][i]);
+        result -= base;
+        result *= run.gain[mode][i];
+
+        if (Blend) {
+            const int partner = (entry >> 8) & 0xFF;
+            float other = static_cast<float>(input_val) - static_cast<float>(run.offset[partner][i]);
+            other -= base;
+            other *= run.gain[partner][i];
+            result += (other - result) * (static_cast<float>(entry >> 16) * (1.0f / 65536.0f));
+        }
+
+        run.output[i] = StoreCorrected(result, run.max_value);
+    }
+}
+
+template <bool Blend>
+void MultiGainScalar(const MultiGainRun& run)
+{
+    MultiGainScalarRange<Blend>(run, run.first, run.end);
+}
+
+/**
+ * @brief Blended correction where each pixel leaves a mode at the lower of
+ *        the mode's threshold and the pixel's linear ceiling in that mode
+ *
+ * Pixels whose ceilings are all at or above the thresholds take the shared
+ * table entry; the others get an entry for their own threshold set.
+ */
+void MultiGainSaturationRange(const MultiGainRun& run, const uint8_t* const* maps,
+                              const unsigned short* thresholds, int blend_width, double full_scale)
+{
+    const int limits = run.num_gains - 1;
+    unsigned short own[255];
+    for (int i = run.first; i < run.end; ++i) {
+        const unsigned short input_val = run.input[i];
+        uint32_t entry = run.entries[input_val];
+
+        bool limited = false;
+        for (int k = 0; k < limits; ++k) {
+            own[k] = thresholds[k];
+            if (maps[k]) {
+                const int code = HX::Internal::GetSaturationCode(maps[k], static_cast<size_t>(i));
+                const double ceiling = HX::Internal::SaturationCeiling(code, full_scale);
+                if (ceiling < own[k]) {
+                    own[k] = static_cast<unsigned short>(ceiling);
+                    limited = true;
+                }
+            }
+        }
+        if (limited) {
+            entry = GainModeEntry(input_val, own, run.num_gains, blend_width);
+        }
+
+        const int mode = entry & 0xFF;
+        const int partner = (entry >> 8) & 0xFF;
+        const float base = run.baseline ? static_cast<float>(run.baseline[i]) : 0.0f;
+
+        float result = static_cast<float>(input_val) - static_cast<float>(run.offset[mode][i]);
+        result -= base;
+        result *= run.gain[mode][i];
+
+        float other = static_cast<float>(input_val) - static_cast<float>(run.offset[partner][i]);
+        other -= base;
+        other *= run.gain[partner][i];
+        result += (other - result) * (static_cast<float>(entry >> 16) * (1.0f / 65536.0f));
+
+        run.output[i] = StoreCorrected(result, run.max_value);
+    }
+}
+
+#if defined(HX_ARCH_X86)
+
+/**
+ * @brief AVX2: gather table entries, then pick each pixel's coefficients
+ *        from the per-mode rows with compare/blend instead of branches
+ */
+template <bool Blend>
+HX_TARGET("avx2")
+void MultiGainAVX2(const MultiGainRun& run)
+{
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 max_value = _mm256_set1_ps(run.max_value);
+    const __m256 half = _mm256_set1_ps(0.5f);
+    const __m256 weight_scale = _mm256_set1_ps(1.0f / 65536.0f);
+    const __m256i byte_mask = _mm256_set1_epi32(0xFF);
+    const int* entries = reinterpret_cast<const int*>(run.entries);
+
+    int i = run.first;
+    for (; i + 8 <= run.end; i += 8) {
+        __m256i idx = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(run.input + i)));
+        __m256i entry = _mm256_i32gather_epi32(entries, idx, 4);
+        __m256i mode = _mm256_and_si256(entry, byte_mask);
+        __m256i partner = _mm256_and_si256(_mm256_srli_epi32(entry, 8), byte_mask);
+
+        __m256 off_m = zero, gain_m = zero, off_p = zero, gain_p = zero;
+        for (int k = 0; k < run.num_gains; ++k) {
+            __m256 off = _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(run.offset[k] + i))));
+            __m256 gain = _mm256_loadu_ps(run.gain[k] + i);
+            __m256i kk = _mm256_set1_epi32(k);
+            __m256 is_mode = _mm256_castsi256_ps(_mm256_cmpeq_epi32(mode, kk));
+            off_m = _mm256_blendv_ps(off_m, off, is_mode);
+            gain_m = _mm256_blendv_ps(gain_m, gain, is_mode);
+            if (Blend) {
+                __m256 is_partner = _mm256_castsi256_ps(_mm256_cmpeq_epi32(partner, kk));
+                off_p = _mm256_blendv_ps(off_p, off, is_partner);
+                gain_p = _mm256_blendv_ps(gain_p, gain, is_partner);
+            }
+        }
+
+        __m256 in = _mm256_cvtepi32_ps(idx);
+        __m256 base = run.baseline
+            ? _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(
+                  _mm_loadu_si128(reinterpret_cast<const __m128i*>(run.baseline + i))))
+            : zero;
+
+        __m256 result = _mm256_mul_ps(_mm256_sub_ps(_mm256_sub_ps(in, off_m), base), gain_m);
+        if (Blend) {
+            __m256 other = _mm256_mul_ps(_mm256_sub_ps(_mm256_sub_ps(in, off_p), base), gain_p);
+            __m256 weight = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(entry, 16)), weight_scale);
+            result = _mm256_add_ps(result, _mm256_mul_ps(_mm256_sub_ps(other, result), weight));
+        }
+
+        // Values above max_value clamp; values below zero store 0
+        result = _mm256_min_ps(_mm256_max_ps(result, zero), max_value);
+        __m256i out = _mm256_cvttps_epi32(_mm256_add_ps(result, half));
+        out = _mm256_permute4x64_epi64(_mm256_packus_epi32(out, out), 0x08);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(run.output + i), _mm256_castsi256_si128(out));
+    }
+
+    MultiGainScalarRange<Blend>(run, i, run.end);
+}
+
+#endif // HX_ARCH_X86
+
+const HX::Internal::KernelFamily g_multiGainKernels("xmg_correct", HX::XFactory::CPU_AVX2);
+
+template <bool Blend>
+void ApplyMultiGainTable(const MultiGainRun& run)
+{
+#if defined(HX_ARCH_X86)
+    if (g_multiGainKernels.isa() == HX::XFactory::CPU_AVX2) {
+        MultiGainAVX2<Blend>(run);
+        return;
+    }
+#endif
+    MultiGainScalar<Blend>(run);
+}
+
+/**
+ * @brief Table-driven correction of a whole frame in row bands
+ */
+template <bool Blend>
+void ApplyMultiGainFrame(const unsigned short* input_data,
+                         unsigned short* output_data,
+                         int width,
+                         int height,
+                         const MultiGainParams& params,
+                         const GainModeTable& table)
+{
+    const float max_value = static_cast<float>((1 << params.bit_depth) - 1);
+
+    HX::Internal::ThreadPool::instance().parallelRows(height, width, [&](int first_row, int end_row) {
+        MultiGainRun run = { input_data, output_data, table.entries.data(),
+                             params.offset_data, params.gain_coeffs, params.baseline_data,
+                             params.num_gains, first_row * width, end_row * width, max_value };
+        ApplyMultiGainTable<Blend>(run);
+    });
+}
+
+} // namespace
+
 /**
  * @brief Apply multi-gain correction to image data
  * @param input_data Input raw image data
@@ -161,47 +482,57 @@ bool ApplyMultiGainCorrection(const unsigned short* input_data,
         return false;
     }
 
-    const int total_pixels = width * height;
+    // Automatic selection goes through the value -> mode table
+    if (!(gain_mode >= 0 && gain_mode < params.num_gains) && params.auto_switch &&
+        params.thresholds && params.num_gains <= 255) {
+        std::shared_ptr<const GainModeTable> table = GetGainModeTable(params, 0);
+        ApplyMultiGainFrame<false>(input_data, output_data, width, height, params, *table);
+        return true;
+    }
+
     const unsigned short max_value = (1 << params.bit_depth) - 1;
 
-    for (int i = 0; i < total_pixels; ++i) {
-        int selected_mode;
+    // Row bands on the shared pool, pixels are independent
+    HX::Internal::ThreadPool::instance().parallelRows(height, width, [&](int first_row, int end_row) {
+        for (int i = first_row * width; i < end_row * width; ++i) {
+            int selected_mode;
         
-        // Determine gain mode
-        if (gain_mode >= 0 && gain_mode < params.num_gains) {
-            // Use fixed gain mode
-            selected_mode = gain_mode;
-        } else if (params.auto_switch) {
-            // Automatic gain mode selection based on pixel value
-            selected_mode = SelectGainMode(input_data[i], params.thresholds, params.num_gains);
-        } else {
-            // Default to first gain mode
-            selected_mode = 0;
-        }
+            // Determine gain mode
+            if (gain_mode >= 0 && gain_mode < params.num_gains) {
+                // Use fixed gain mode
+                selected_mode = gain_mode;
+            } else if (params.auto_switch) {
+                // Automatic gain mode selection based on pixel value
+                selected_mode = SelectGainMode(input_data[i], params.thresholds, params.num_gains);
+            } else {
+                // Default to first gain mode
+                selected_mode = 0;
+            }
 
-        // Apply correction: y = k(x - x₀ - baseline) + target
-        float corrected = static_cast<float>(input_data[i]);
+            // Apply correction: y = k(x - x₀ - baseline) + target
+            float corrected = static_cast<float>(input_data[i]);
         
-        // Subtract offset
-        corrected -= static_cast<float>(params.offset_data[selected_mode][i]);
+            // Subtract offset
+            corrected -= static_cast<float>(params.offset_data[selected_mode][i]);
         
-        // Subtract baseline if available
-        if (params.baseline_data) {
-            corrected -= static_cast<float>(params.baseline_data[i]);
-        }
+            // Subtract baseline if available
+            if (params.baseline_data) {
+                corrected -= static_cast<float>(params.baseline_data[i]);
+            }
         
-        // Apply gain
-        corrected *= params.gain_coeffs[selected_mode][i];
+            // Apply gain
+            corrected *= params.gain_coeffs[selected_mode][i];
         
-        // Clamp to valid range
-        if (corrected < 0.0f) {
-            output_data[i] = 0;
-        } else if (corrected > max_value) {
-            output_data[i] = max_value;
-        } else {
-            output_data[i] = static_cast<unsigned short>(corrected + 0.5f);
+            // Clamp to valid range
+            if (corrected < 0.0f) {
+                output_data[i] = 0;
+            } else if (corrected > max_value) {
+                output_data[i] = max_value;
+            } else {
+                output_data[i] = static_cast<unsigned short>(corrected + 0.5f);
+            }
         }
-    }
+    });
 
     return true;
 }
@@ -283,97 +614,104 @@ bool ApplyMultiGainWithBlending(const unsigned short* input_data,
         return ApplyMultiGainCorrection(input_data, output_data, width, height, params, -1);
     }
 
-    const int total_pixels = width * height;
-    const unsigned short max_value = (1 << params.bit_depth) - 1;
+    if (!params.gain_coeffs || !params.offset_data || !params.thresholds || params.num_gains > 255) {
+        return false;
+    }
 
-    for (int i = 0; i < total_pixels; ++i) {
-        unsigned short input_val = input_data[i];
-        
-        // Find appropriate gain mode
-        int mode = SelectGainMode(input_val, params.thresholds, params.num_gains);
-        
-        // Check if we're in a blending region
-        float blend_factor = 0.0f;
-        int blend_mode = -1;
-        
-        if (mode > 0) {
-            // Check lower threshold
-            int dist_to_lower = input_val - params.thresholds[mode - 1];
-            if (dist_to_lower < blend_width && dist_to_lower >= 0) {
-                blend_factor = static_cast<float>(dist_to_lower) / blend_width;
-                blend_mode = mode - 1;
-            }
-        }
-        
-        if (mode < params.num_gains - 1 && blend_mode < 0) {
-            // Check upper threshold
-            int dist_to_upper = params.thresholds[mode] - input_val;
-            if (dist_to_upper < blend_width && dist_to_upper >= 0) {
-                blend_factor = static_cast<float>(dist_to_upper) / blend_width;
-                blend_mode = mode + 1;
-            }
-        }
-        
-        float result;
-        
-        if (blend_mode >= 0 && blend_factor > 0.0f) {
-            // Apply correction with two gain modes and blend
-            float corrected1 = static_cast<float>(input_val) - 
-                              static_cast<float>(params.offset_data[mode][i]);
-            if (params.baseline_data) {
-                corrected1 -= static_cast<float>(params.baseline_data[i]);
-            }
-            corrected1 *= params.gain_coeffs[mode][i];
-            
-            float corrected2 = static_cast<float>(input_val) - 
-                              static_cast<float>(params.offset_data[blend_mode][i]);
-            if (params.baseline_data) {
-                corrected2 -= static_cast<float>(params.baseline_data[i]);
-            }
-            corrected2 *= params.gain_coeffs[blend_mode][i];
-            
-            // Linear blend between the two corrections
-            result = corrected1 * blend_factor + corrected2 * (1.0f - blend_factor);
-        } else {
-            // Standard single-mode correction
-            result = static_cast<float>(input_val) - 
-                    static_cast<float>(params.offset_data[mode][i]);
-            if (params.baseline_data) {
-                result -= static_cast<float>(params.baseline_data[i]);
-            }
-            result *= params.gain_coeffs[mode][i];
-        }
-        
-        // Clamp and store
-        if (result < 0.0f) {
-            output_data[i] = 0;
-        } else if (result > max_value) {
-            output_data[i] = max_value;
-        } else {
-            output_data[i] = static_cast<unsigned short>(result + 0.5f);
-        }
+    // Mode, blend partner and weight come from one table lookup per pixel
+    std::shared_ptr<const GainModeTable> table = GetGainModeTable(params, blend_width);
+    if (!params.saturation_maps) {
+        ApplyMultiGainFrame<true>(input_data, output_data, width, height, params, *table);
+        return true;
     }
 
+    // Per-pixel ceilings move the mode boundaries, and their blend zones, down
+    const float max_value = static_cast<float>((1 << params.bit_depth) - 1);
+    HX::Internal::ThreadPool::instance().parallelRows(height, width, [&](int first_row, int end_row) {
+        MultiGainRun run = { input_data, output_data, table->entries.data(),
+                             params.offset_data, params.gain_coeffs, params.baseline_data,
+                             params.num_gains, first_row * width, end_row * width, max_value };
+        MultiGainSaturationRange(run, params.saturation_maps, params.thresholds, blend_width, max_value);
+    });
+
     return true;
 }
 
 /**
- * @brief Optimize gain mode thresholds based on histogram analysis
- * @param histogram Histogram of image data
- * @param histogram_size Size of histogram array
- * @param num_gains Number of gain modes
- * @param thresholds Output optimized threshold values
+ * @brief Build each mode's linear-ceiling map from its calibration data
+ * @param calibration_data Bright field of each gain mode, as given to
+ *        CalculateMultiGainCoefficients()
+ * @param width Image width
+ * @param height Image height
+ * @param params Multi-gain parameters with that calibration applied;
+ *        receives saturation_maps, which ApplyMultiGainWithBlending() then
+ *        uses to move each pixel's blend zones below its ceilings
  * @return true on success, false on failure
+ * @note Same format as XOGCorrect::GetSaturationMap(), so a mode map can
+ *       also be copied in from a single-gain calibration of that mode
  */
-bool OptimizeGainThresholds(const unsigned int* histogram,
-                           int histogram_size,
-                           int num_gains,
-                           unsigned short* thresholds)
+bool CalculateMultiGainSaturation(const unsigned short** calibration_data,
+                                  int width,
+                                  int height,
+                                  MultiGainParams& params)
 {
-    if (!histogram || !thresholds || histogram_size <= 0 || num_gains <= 1) {
+    if (!calibration_data || !params.gain_coeffs || !params.offset_data ||
+        width <= 0 || height <= 0 || params.num_gains <= 0) {
         return false;
     }
+    for (int mode = 0; mode < params.num_gains; ++mode) {
+        if (!calibration_data[mode] || !params.gain_coeffs[mode] || !params.offset_data[mode]) {
+            return false;
+        }
+    }
+
+    const size_t total_pixels = static_cast<size_t>(width) * height;
+    const size_t bytes = HX::Internal::SaturationMapBytes(total_pixels);
+    if (!params.saturation_maps) {
+        params.saturation_maps = new uint8_t*[params.num_gains]();
+    }
+
+    const double full_scale = (1 << params.bit_depth) - 1;
+    for (int mode = 0; mode < params.num_gains; ++mode) {
+        if (!params.saturation_maps[mode]) {
+            params.saturation_maps[mode] = new uint8_t[bytes];
+        }
+        uint8_t* map = params.saturation_maps[mode];
+        const unsigned short* bright = calibration_data[mode];
+        const unsigned short* offset = params.offset_data[mode];
+        const float* gain = params.gain_coeffs[mode];
+
+        // Bands cover whole bytes, so no two write the same one
+        const int chunk = 4096;
+        const int chunks = static_cast<int>((total_pixels + chunk - 1) / chunk);
+        HX::Internal::ThreadPool::instance().parallelRows(chunks, chunk, [&](int first, int end) {
+            const size_t last = std::min(total_pixels, static_cast<size_t>(end) * chunk);
+            for (size_t i = static_cast<size_t>(first) * chunk; i < last; ++i) {
+                // (in - off - base) * g clips at full scale for in = off + base + full / g
+                const double base = params.baseline_data ? params.baseline_data[i] : 0.0;
+                const double g = gain[i];
+                int code = 0;
+                if (bright[i] > offset[i] + base && gain[i] > 0.1f && gain[i] < 10.0f &&
+                    !HX::Internal::IsSaturatedLevel(bright[i], full_scale)) {
+                    code = HX::Internal::SaturationCode(std::min(full_scale, offset[i] + base + full_scale / g),
+                                                        full_scale);
+                }
+                HX::Internal::SetSaturationCode(map, i, code);
+            }
+        });
+    }
+    return true;
+}
+
+namespace {
 
+/**
+ * @brief Thresholds at equal percentiles of a cumulative count
+ */
+template <typename Count>
+bool SplitAtPercentiles(const Count* histogram, int histogram_size, int num_gains,
+                        unsigned short* thresholds)
+{
     // Calculate cumulative histogram
     std::vector<unsigned long long> cumulative(histogram_size);
     cumulative[0] = histogram[0];
@@ -407,6 +745,75 @@ bool OptimizeGainThresholds(const unsigned int* histogram,
     return true;
 }
 
+} // namespace
+
+/**
+ * @brief Optimize gain mode thresholds based on histogram analysis
+ * @param histogram Histogram of image data
+ * @param histogram_size Size of histogram array
+ * @param num_gains Number of gain modes
+ * @param thresholds Output optimized threshold values
+ * @return true on success, false on failure
+ */
+bool OptimizeGainThresholds(const unsigned int* histogram,
+                           int histogram_size,
+                           int num_gains,
+                           unsigned short* thresholds)
+{
+    if (!histogram || !thresholds || histogram_size <= 0 || num_gains <= 1) {
+        return false;
+    }
+
+    return SplitAtPercentiles(histogram, histogram_size, num_gains, thresholds);
+}
+
+/**
+ * @brief Optimize gain mode thresholds from a frame histogram
+ * @param histogram Histogram built once per frame (see PixelHistogram::build)
+ * @param num_gains Number of gain modes
+ * @param thresholds Output optimized threshold values
+ * @return true on success, false on failure
+ * @note Reads the 65536 bins, not the pixels, so it is cheap to repeat
+ *       while tuning num_gains
+ */
+bool OptimizeGainThresholds(const HX::Internal::PixelHistogram& histogram,
+                           int num_gains,
+                           unsigned short* thresholds)
+{
+    if (!thresholds || num_gains <= 1) {
+        return false;
+    }
+
+    return SplitAtPercentiles(histogram.bins().data(), HX::Internal::PixelHistogram::BINS,
+                              num_gains, thresholds);
+}
+
+/**
+ * @brief Count the pixels of a frame histogram each gain mode would take
+ * @param histogram Histogram built once per frame
+ * @param params Multi-gain parameters; only thresholds and num_gains are read
+ * @param mode_histogram Output pixels per mode (num_gains entries)
+ * @return true on success, false on failure
+ * @note Reads the bins, not the pixels, so a candidate threshold set is
+ *       evaluated without another pass over the frame
+ */
+bool CountGainModes(const HX::Internal::PixelHistogram& histogram,
+                   const MultiGainParams& params,
+                   unsigned int* mode_histogram)
+{
+    if (!mode_histogram || params.num_gains <= 0 || (params.num_gains > 1 && !params.thresholds)) {
+        return false;
+    }
+
+    // Same split as SelectGainMode(): the first threshold a value is below
+    std::vector<uint64_t> counts(params.num_gains);
+    histogram.classCounts(params.thresholds, params.num_gains, counts.data());
+    for (int mode = 0; mode < params.num_gains; ++mode) {
+        mode_histogram[mode] = static_cast<unsigned int>(std::min<uint64_t>(counts[mode], 0xFFFFFFFFu));
+    }
+    return true;
+}
+
 /**
  * @brief Validate multi-gain correction data
  * @param params Multi-gain parameters
@@ -434,24 +841,20 @@ bool ValidateMultiGainData(const MultiGainParams& params, int width, int height)
     }
 
     // Validate gain coefficients
-    int invalid_count = 0;
+    uint64_t invalid_count = 0;
     for (int mode = 0; mode < params.num_gains; ++mode) {
         if (!params.gain_coeffs[mode] || !params.offset_data[mode]) {
             return false;
         }
 
-        for (int i = 0; i < total_pixels; ++i) {
-            if (std::isnan(params.gain_coeffs[mode][i]) || 
-                std::isinf(params.gain_coeffs[mode][i]) ||
-                params.gain_coeffs[mode][i] <= 0.0f ||
-                params.gain_coeffs[mode][i] > 100.0f) {
-                invalid_count++;
-            }
-        }
+        HX::Internal::CalibrationReport report;
+        HX::Internal::BuildCalibrationReport(NULL, params.gain_coeffs[mode], NULL,
+                                             static_cast<size_t>(total_pixels), report);
+        invalid_count += report.gainDefects;
     }
 
     // Allow up to 0.1% invalid pixels per mode
-    return invalid_count < (total_pixels * params.num_gains / 1000);
+    return invalid_count < static_cast<uint64_t>(total_pixels) * params.num_gains / 1000;
 }
 
 /**
@@ -479,26 +882,13 @@ void CalculateGainModeStatistics(const MultiGainParams& params,
         return;
     }
 
-    const int total_pixels = width * height;
-    const float* gain_data = params.gain_coeffs[mode];
-
-    mean = 0.0f;
-    min_val = gain_data[0];
-    max_val = gain_data[0];
-
-    for (int i = 0; i < total_pixels; ++i) {
-        mean += gain_data[i];
-        if (gain_data[i] < min_val) min_val = gain_data[i];
-        if (gain_data[i] > max_val) max_val = gain_data[i];
-    }
-    mean /= total_pixels;
-
-    std_dev = 0.0f;
-    for (int i = 0; i < total_pixels; ++i) {
-        float diff = gain_data[i] - mean;
-        std_dev += diff * diff;
-    }
-    std_dev = std::sqrt(std_dev / total_pixels);
+    HX::Internal::CalibrationReport report;
+    HX::Internal::BuildCalibrationReport(NULL, params.gain_coeffs[mode], NULL,
+                                         static_cast<size_t>(width) * height, report);
+    mean = static_cast<float>(report.gain.mean);
+    std_dev = static_cast<float>(report.gain.stdDev());
+    min_val = report.gain.minValue;
+    max_val = report.gain.maxValue;
 }
 
 /**
@@ -520,17 +910,10 @@ bool CreateGainModeHistogram(const unsigned short* input_data,
         return false;
     }
 
-    // Initialize histogram
-    std::fill_n(mode_histogram, params.num_gains, 0);
-
-    const int total_pixels = width * height;
-
-    for (int i = 0; i < total_pixels; ++i) {
-        int mode = SelectGainMode(input_data[i], params.thresholds, params.num_gains);
-        mode_histogram[mode]++;
-    }
-
-    return true;
+    // Threaded value histogram, then modes from its bins
+    HX::Internal::PixelHistogram histogram;
+    histogram.build(input_data, static_cast<uint32_t>(width), static_cast<uint32_t>(height));
+    return CountGainModes(histogram, params, mode_histogram);
 }
 
 } // namespace fximage
\ No newline at end of file
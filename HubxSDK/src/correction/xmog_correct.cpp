@@ -10,11 +10,36 @@
 
 #include "../../include/xmog_correct.h"
 #include "../../include/xog_correct.h"
+#include "../utils/calib_file.h"
+#include "../utils/calib_report.h"
+#include "../utils/latency_trace.h"
+#include "../utils/mem_profile.h"
+#include "../utils/perf_counters.h"
+#include "../utils/phase_correlation.h"
+#include "../utils/snapshot.h"
+#include "../utils/thread_pool.h"
+#include "../utils/welford.h"
+#include <cstdint>
 #include <cstring>
 #include <cmath>
 #include <algorithm>
+#include <atomic>
 #include <vector>
 #include <fstream>
+#include <mutex>
+#include <new>
+#ifdef _WIN32
+#include <malloc.h>
+#else
+#include <cstdlib>
+#endif
+
+// Error codes
+#define HUBX_SUCCESS 0
+#define HUBX_ERROR_INVALID_PARAM -1
+#define HUBX_ERROR_NULL_POINTER -2
+#define HUBX_ERROR_CALCULATION -4
+#define HUBX_ERROR_NOT_CALIBRATED -5
 
 namespace fximage {
 
@@ -34,6 +59,100 @@ struct DetectorCorrectionData {
     float normalization_factor;         // For cross-detector normalization
 };
 
+namespace {
+
+// Calibration container tags (see utils/calib_file.h); pixel sections
+// hold every detector's table back to back in detector order
+const uint32_t CALIB_MODULE    = HX::Internal::CalibTag('X', 'M', 'O', 'G');
+const uint32_t CALIB_META      = HX::Internal::CalibTag('M', 'E', 'T', 'A');
+const uint32_t CALIB_DETECTORS = HX::Internal::CalibTag('D', 'E', 'T', 'S');
+const uint32_t CALIB_OFFSET    = HX::Internal::CalibTag('O', 'F', 'F', 'S');
+const uint32_t CALIB_GAIN      = HX::Internal::CalibTag('G', 'A', 'I', 'N');
+const uint32_t CALIB_BASELINE  = HX::Internal::CalibTag('B', 'A', 'S', 'E');
+
+// Each detector's maps start on their own page, so the pool thread that
+// first touches them places them on its NUMA node
+const size_t ARENA_ALIGN = 4096;
+const size_t MAP_ALIGN = 64;
+
+inline size_t AlignUp(size_t bytes, size_t alignment)
+{
+    return (bytes + alignment - 1) / alignment * alignment;
+}
+
+uint8_t* ArenaAlloc(size_t size)
+{
+#ifdef _WIN32
+    return static_cast<uint8_t*>(_aligned_malloc(size, ARENA_ALIGN));
+#else
+    void* ptr = nullptr;
+    if (posix_memalign(&ptr, ARENA_ALIGN, size) != 0) {
+        return nullptr;
+    }
+    return static_cast<uint8_t*>(ptr);
+#endif
+}
+
+void ArenaFree(uint8_t* ptr)
+{
+#ifdef _WIN32
+    _aligned_free(ptr);
+#else
+    free(ptr);
+#endif
+}
+
+/// DETS section entry, one per detector
+struct DetectorRecord {
+    int32_t detector_id;
+    int32_t width;
+    int32_t height;
+    int32_t x_offset;
+    int32_t y_offset;
+    int32_t is_active;
+    float normalization_factor;
+};
+
+} // namespace
+
+/**
+ * @brief Precomputed stitching weights of one detector
+ *
+ * columns[mask][x] is the weight of detector column x in the stitched
+ * image, where mask bit 0 / bit 1 say whether the left / right neighbour
+ * also covers the current row. Weights of overlapping detectors sum to 1.
+ */
+struct DetectorStitchWeights {
+    std::vector<float> columns[4];
+};
+
+/**
+ * @brief One detector row of the stitched coefficient table
+ *
+ * Segments of a stitched row are in detector order, i.e. left to right,
+ * and their coefficients follow each other, so a stitched pass reads the
+ * table front to back.
+ */
+struct StitchSegment {
+    int det_id;
+    int det_x;                          ///< First detector column
+    int out_x;                          ///< Its stitched column
+    int count;
+    size_t input;                       ///< Index of the first pixel in the detector frame
+    size_t coeff;                       ///< Index of its {scale, bias} pair
+};
+
+/**
+ * @brief Published cross-detector normalization, one factor per detector
+ *
+ * Never changed once published, so an apply uses one consistent set of
+ * factors for the whole frame.
+ */
+struct NormalizationSnapshot {
+    uint64_t version;
+    std::vector<float> factors;
+};
+
 /**
  * @brief XMOGCorrect class for multi-detector correction
  */
@@ -51,6 +170,8 @@ public:
     bool SetDetectorActive(int detector_id, bool active);
     bool SetDetectorPosition(int detector_id, int x_offset, int y_offset);
     bool SetDetectorNormalization(int detector_id, float normalization_factor);
+    bool RegisterDetectors(const unsigned short** calibration_scans, int search_width,
+                           float min_score, float* scores);
     
     int GetNumDetectors() const { return m_num_detectors; }
     bool GetDetectorInfo(int detector_id, int& width, int& height, 
@@ -68,9 +189,13 @@ public:
     // Multi-detector calibration
     bool CalculateMultiDetectorOffset(const unsigned short*** line_data, 
                                      int num_lines);
+    bool AddMultiDetectorOffsetFrame(const unsigned short** detector_frames);
+    bool FinalizeMultiDetectorOffset();
     bool CalculateMultiDetectorGain(const unsigned short** bright_field_data,
                                    unsigned short target_value);
     bool CalculateCrossDetectorNormalization();
+    // Incremented by every normalization publish
+    uint64_t GetNormalizationVersion() const;
 
     // Correction operations
     bool ApplyMultiDetectorCorrection(const unsigned short** input_data,
@@ -82,7 +207,7 @@ public:
 
     // Configuration
     void SetCorrectionMode(bool enable_offset, bool enable_gain, bool enable_baseline);
-    void SetTargetBaseline(unsigned short baseline) { m_target_baseline = baseline; }
+    void SetTargetBaseline(unsigned short baseline) { m_target_baseline = baseline; m_stitch_dirty = true; }
     void SetStitchingMode(bool enable) { m_enable_stitching = enable; }
     void SetOverlapBlending(bool enable, int overlap_width = 0);
 
@@ -91,6 +216,8 @@ public:
     bool LoadMultiDetectorCalibration(const char* filename);
 
     // Validation and statistics
+    bool GetDetectorReport(int detector_id, HX::Internal::CalibrationReport& report);
+    bool GetMultiDetectorReport(std::vector<HX::Internal::CalibrationReport>& reports);
     bool ValidateMultiDetectorData();
     bool GetDetectorStatistics(int detector_id, float& offset_mean, float& gain_mean,
                               float& offset_std, float& gain_std);
@@ -103,6 +230,8 @@ private:
     unsigned short m_max_value;
 
     std::vector<DetectorCorrectionData> m_detectors;
+    uint8_t* m_arena;                   ///< Every detector's maps, one page-aligned section each
+    size_t m_arena_bytes;
 
     // Correction flags
     bool m_enable_offset;
@@ -115,12 +244,44 @@ private:
     bool m_enable_overlap_blending;
     int m_overlap_width;
 
+    // Blend weights and stitched coefficients, rebuilt on the next stitch
+    // after geometry, blending, maps or correction settings change.
+    // Coefficients fold offset, gain, normalization, baseline and target:
+    // corrected = in * scale + bias.
+    std::vector<DetectorStitchWeights> m_stitch_weights;
+    std::vector<float> m_stitch_coeffs;             ///< {scale, bias} pairs in stitched order
+    std::vector<StitchSegment> m_stitch_segments;
+    std::vector<size_t> m_stitch_rows;              ///< First segment of each stitched row, plus end
+    std::atomic<bool> m_stitch_dirty;
+
+    // Sum of each detector's gain map, kept up to date by every call that
+    // writes one, so normalization costs O(detectors) instead of a pass
+    std::vector<double> m_gain_sums;
+
+    // Factors applies read; det.normalization_factor is the working copy
+    HX::Internal::SnapshotSlot<NormalizationSnapshot> m_normalization;
+    uint64_t m_normalization_version;
+    uint64_t m_stitch_normalization;        ///< Version the stitch table folds
+
+    // Streaming offset calibration, one accumulator per detector
+    std::mutex m_calib_mutex;
+    std::vector<HX::Internal::WelfordAccumulator> m_offset_accs;
+
+    // Tables and stitch weights, for memory profiling
+    HX::Internal::MemCharge m_memory;
+
     // Helper methods
-    bool AllocateDetectorMemory(int detector_id);
-    void FreeDetectorMemory(int detector_id);
+    bool AllocateArena();
+    void ResetDetectorMaps(int detector_id);
     void FreeAllMemory();
     float CalculateBlendWeight(int position, int overlap_start, int overlap_end);
+    void UpdateStitchTable();
+    void UpdateMemoryCharge();
+    void UpdateGainSum(int detector_id);
+    void PublishNormalization();
+    bool BlendRamp(int left_id, int right_id, int& ramp_start, int& ramp_end) const;
     bool ValidateDetectorId(int detector_id) const;
+    bool LoadLegacyCalibration(const char* filename);
 };
 
 // Constructor
@@ -129,6 +290,8 @@ XMOGCorrect::XMOGCorrect()
     , m_num_detectors(0)
     , m_bit_depth(14)
     , m_max_value(16383)
+    , m_arena(nullptr)
+    , m_arena_bytes(0)
     , m_enable_offset(true)
     , m_enable_gain(true)
     , m_enable_baseline(false)
@@ -136,6 +299,10 @@ XMOGCorrect::XMOGCorrect()
     , m_enable_stitching(false)
     , m_enable_overlap_blending(false)
     , m_overlap_width(0)
+    , m_stitch_dirty(true)
+    , m_normalization_version(0)
+    , m_stitch_normalization(0)
+    , m_memory(HX::XFactory::MEM_CALIBRATION)
 {
 }
 
@@ -184,24 +351,40 @@ bool XMOGCorrect::Initialize(int num_detectors, const int* widths,
         m_detectors[i].offset_data = nullptr;
         m_detectors[i].gain_data = nullptr;
         m_detectors[i].baseline_data = nullptr;
+    }
 
-        if (!AllocateDetectorMemory(i)) {
-            Release();
-            return false;
-        }
+    // Each detector's section is first touched by the pool thread that
+    // processes that detector, so it is placed on its NUMA node
+    if (!AllocateArena()) {
+        Release();
+        return false;
     }
+    m_gain_sums.assign(num_detectors, 0.0);
+    HX::Internal::ThreadPool::instance().runPinned(num_detectors, [&](int det_id) {
+        ResetDetectorMaps(det_id);
+    });
+    UpdateMemoryCharge();
 
+    m_stitch_dirty = true;
     m_initialized = true;
+    PublishNormalization();
     return true;
 }
 
 // Release all resources
 bool XMOGCorrect::Release()
 {
+    {
+        std::lock_guard<std::mutex> lock(m_calib_mutex);
+        m_offset_accs.clear();
+    }
     FreeAllMemory();
     m_detectors.clear();
+    m_gain_sums.clear();
+    m_normalization.publish(std::shared_ptr<const NormalizationSnapshot>());
     m_initialized = false;
     m_num_detectors = 0;
+    UpdateMemoryCharge();
     return true;
 }
 
@@ -211,61 +394,110 @@ bool XMOGCorrect::ValidateDetectorId(int detector_id) const
     return detector_id >= 0 && detector_id < m_num_detectors;
 }
 
-// Allocate memory for single detector
-bool XMOGCorrect::AllocateDetectorMemory(int detector_id)
+// Lay out every detector's maps in one allocation: per detector the gain,
+// offset and baseline maps, each cache-line aligned, in a page-aligned section
+bool XMOGCorrect::AllocateArena()
 {
-    if (!ValidateDetectorId(detector_id)) {
-        return false;
+    std::vector<size_t> sections(m_num_detectors);
+    size_t total = 0;
+    for (int i = 0; i < m_num_detectors; ++i) {
+        const size_t pixels = static_cast<size_t>(m_detectors[i].width) * m_detectors[i].height;
+        sections[i] = total;
+        total += AlignUp(AlignUp(pixels * sizeof(float), MAP_ALIGN) +
+                         AlignUp(pixels * sizeof(unsigned short), MAP_ALIGN) +
+                         pixels * sizeof(unsigned short), ARENA_ALIGN);
     }
 
-    DetectorCorrectionData& det = m_detectors[detector_id];
-    const size_t total_pixels = det.width * det.height;
+    m_arena = ArenaAlloc(total);
+    if (!m_arena) {
+        return false;
+    }
+    m_arena_bytes = total;
 
-    try {
-        det.offset_data = new unsigned short[total_pixels];
-        det.gain_data = new float[total_pixels];
-        det.baseline_data = new unsigned short[total_pixels];
+    for (int i = 0; i < m_num_detectors; ++i) {
+        DetectorCorrectionData& det = m_detectors[i];
+        const size_t pixels = static_cast<size_t>(det.width) * det.height;
+        uint8_t* section = m_arena + sections[i];
+        det.gain_data = reinterpret_cast<float*>(section);
+        section += AlignUp(pixels * sizeof(float), MAP_ALIGN);
+        det.offset_data = reinterpret_cast<unsigned short*>(section);
+        section += AlignUp(pixels * sizeof(unsigned short), MAP_ALIGN);
+        det.baseline_data = reinterpret_cast<unsigned short*>(section);
+    }
+    return true;
+}
 
-        std::fill_n(det.offset_data, total_pixels, 0);
-        std::fill_n(det.gain_data, total_pixels, 1.0f);
-        std::fill_n(det.baseline_data, total_pixels, 0);
+// Default maps of one detector
+void XMOGCorrect::ResetDetectorMaps(int detector_id)
+{
+    DetectorCorrectionData& det = m_detectors[detector_id];
+    const size_t total_pixels = static_cast<size_t>(det.width) * det.height;
+    std::fill_n(det.offset_data, total_pixels, 0);
+    std::fill_n(det.gain_data, total_pixels, 1.0f);
+    std::fill_n(det.baseline_data, total_pixels, 0);
+    m_gain_sums[detector_id] = static_cast<double>(total_pixels);
+}
 
-        return true;
-    } catch (const std::bad_alloc&) {
-        FreeDetectorMemory(detector_id);
-        return false;
+// Re-sum one detector's gain map after it was replaced
+void XMOGCorrect::UpdateGainSum(int detector_id)
+{
+    const DetectorCorrectionData& det = m_detectors[detector_id];
+    const size_t total_pixels = static_cast<size_t>(det.width) * det.height;
+    double sum = 0.0;
+    for (size_t i = 0; i < total_pixels; ++i) {
+        sum += det.gain_data[i];
     }
+    m_gain_sums[detector_id] = sum;
 }
 
-// Free memory for single detector
-void XMOGCorrect::FreeDetectorMemory(int detector_id)
+// Publish the working normalization factors as one snapshot
+void XMOGCorrect::PublishNormalization()
 {
-    if (!ValidateDetectorId(detector_id)) {
-        return;
+    std::shared_ptr<NormalizationSnapshot> snapshot = std::make_shared<NormalizationSnapshot>();
+    snapshot->version = ++m_normalization_version;
+    snapshot->factors.resize(m_detectors.size());
+    for (size_t det_id = 0; det_id < m_detectors.size(); ++det_id) {
+        snapshot->factors[det_id] = m_detectors[det_id].normalization_factor;
     }
+    m_normalization.publish(snapshot);
+}
 
-    DetectorCorrectionData& det = m_detectors[detector_id];
+uint64_t XMOGCorrect::GetNormalizationVersion() const
+{
+    const std::shared_ptr<const NormalizationSnapshot> snapshot = m_normalization.acquire();
+    return snapshot ? snapshot->version : 0;
+}
 
-    if (det.offset_data) {
-        delete[] det.offset_data;
-        det.offset_data = nullptr;
-    }
-    if (det.gain_data) {
-        delete[] det.gain_data;
-        det.gain_data = nullptr;
-    }
-    if (det.baseline_data) {
-        delete[] det.baseline_data;
-        det.baseline_data = nullptr;
+void XMOGCorrect::UpdateMemoryCharge()
+{
+    uint64_t bytes = m_arena_bytes + HX::Internal::MemBytes(m_stitch_coeffs) +
+                     HX::Internal::MemBytes(m_stitch_segments) + HX::Internal::MemBytes(m_stitch_rows);
+    for (size_t i = 0; i < m_stitch_weights.size(); ++i) {
+        for (int mask = 0; mask < 4; ++mask) {
+            bytes += HX::Internal::MemBytes(m_stitch_weights[i].columns[mask]);
+        }
     }
+    m_memory.set(bytes);
 }
 
 // Free all detector memory
 void XMOGCorrect::FreeAllMemory()
 {
-    for (int i = 0; i < m_num_detectors; ++i) {
-        FreeDetectorMemory(i);
+    for (size_t i = 0; i < m_detectors.size(); ++i) {
+        m_detectors[i].offset_data = nullptr;
+        m_detectors[i].gain_data = nullptr;
+        m_detectors[i].baseline_data = nullptr;
     }
+    if (m_arena) {
+        ArenaFree(m_arena);
+        m_arena = nullptr;
+    }
+    m_arena_bytes = 0;
+    std::vector<float>().swap(m_stitch_coeffs);
+    std::vector<StitchSegment>().swap(m_stitch_segments);
+    std::vector<size_t>().swap(m_stitch_rows);
+    m_stitch_weights.clear();
+    m_stitch_dirty = true;
 }
 
 // Set detector active state
@@ -276,6 +508,7 @@ bool XMOGCorrect::SetDetectorActive(int detector_id, bool active)
     }
 
     m_detectors[detector_id].is_active = active;
+    m_stitch_dirty = true;
     return true;
 }
 
@@ -288,6 +521,81 @@ bool XMOGCorrect::SetDetectorPosition(int detector_id, int x_offset, int y_offse
 
     m_detectors[detector_id].x_offset = x_offset;
     m_detectors[detector_id].y_offset = y_offset;
+    m_stitch_dirty = true;
+    return true;
+}
+
+/**
+ * @brief Measure detector positions from overlapping calibration scans
+ * @param calibration_scans One scan per detector, width x height of that detector
+ * @param search_width Columns compared at each seam; must exceed the overlap
+ * @param min_score Lowest cross-correlation accepted per seam (e.g. 0.8)
+ * @param scores Output: cross-correlation per seam, num_detectors - 1 values (may be NULL)
+ * @return true if every seam registered; positions are unchanged otherwise
+ *
+ * Detector i + 1 sits to the right of detector i. The right search_width
+ * columns of scan i are phase-correlated with the left ones of scan i + 1
+ * over the rows both have, and positions are chained from detector 0's.
+ * The positions are saved with SaveMultiDetectorCalibration().
+ */
+bool XMOGCorrect::RegisterDetectors(const unsigned short** calibration_scans, int search_width,
+                                    float min_score, float* scores)
+{
+    if (!m_initialized || !calibration_scans || search_width < 8) {
+        return false;
+    }
+    for (int i = 0; i < m_num_detectors; ++i) {
+        if (!calibration_scans[i]) {
+            return false;
+        }
+    }
+
+    std::vector<int> x_offsets(m_num_detectors), y_offsets(m_num_detectors);
+    x_offsets[0] = m_detectors[0].x_offset;
+    y_offsets[0] = m_detectors[0].y_offset;
+    bool registered = true;
+
+    for (int i = 0; i + 1 < m_num_detectors; ++i) {
+        const DetectorCorrectionData& left = m_detectors[i];
+        const DetectorCorrectionData& right = m_detectors[i + 1];
+        const int strip = std::min(search_width, std::min(left.width, right.width));
+        const int rows = std::min(left.height, right.height);
+
+        std::vector<float> a(static_cast<size_t>(strip) * rows), b(a.size());
+        for (int y = 0; y < rows; ++y) {
+            const unsigned short* la = calibration_scans[i] + static_cast<size_t>(y) * left.width + left.width - strip;
+            const unsigned short* rb = calibration_scans[i + 1] + static_cast<size_t>(y) * right.width;
+            for (int x = 0; x < strip; ++x) {
+                a[static_cast<size_t>(y) * strip + x] = la[x];
+                b[static_cast<size_t>(y) * strip + x] = rb[x];
+            }
+        }
+
+        // A seam must share at least an eighth of the strip over half the rows
+        HX::Internal::ImageShift shift;
+        const int min_overlap = std::max(4, strip / 8) * std::max(1, rows / 2);
+        bool ok = HX::Internal::registerImages(a.data(), b.data(), strip, rows, min_overlap, shift);
+        if (scores) {
+            scores[i] = ok ? shift.ncc : -1.0f;
+        }
+        if (!ok || shift.ncc < min_score) {
+            registered = false;
+            continue;
+        }
+
+        // Strip b shows the scene strip a shows, moved by (dx, dy)
+        x_offsets[i + 1] = x_offsets[i] + left.width - strip - shift.dx;
+        y_offsets[i + 1] = y_offsets[i] - shift.dy;
+    }
+
+    if (!registered) {
+        return false;
+    }
+    for (int i = 0; i < m_num_detectors; ++i) {
+        m_detectors[i].x_offset = x_offsets[i];
+        m_detectors[i].y_offset = y_offsets[i];
+    }
+    m_stitch_dirty = true;
     return true;
 }
 
@@ -303,6 +611,7 @@ bool XMOGCorrect::SetDetectorNormalization(int detector_id, float normalization_
     }
 
     m_detectors[detector_id].normalization_factor = normalization_factor;
+    PublishNormalization();
     return true;
 }
 
@@ -332,6 +641,7 @@ bool XMOGCorrect::SetDetectorOffsetData(int detector_id, const unsigned short* o
     DetectorCorrectionData& det = m_detectors[detector_id];
     std::memcpy(det.offset_data, offset_data, 
                det.width * det.height * sizeof(unsigned short));
+    m_stitch_dirty = true;
     return true;
 }
 
@@ -345,6 +655,8 @@ bool XMOGCorrect::SetDetectorGainData(int detector_id, const float* gain_data)
     DetectorCorrectionData& det = m_detectors[detector_id];
     std::memcpy(det.gain_data, gain_data, 
                det.width * det.height * sizeof(float));
+    UpdateGainSum(detector_id);
+    m_stitch_dirty = true;
     return true;
 }
 
@@ -358,6 +670,7 @@ bool XMOGCorrect::SetDetectorBaselineData(int detector_id, const unsigned short*
     DetectorCorrectionData& det = m_detectors[detector_id];
     std::memcpy(det.baseline_data, baseline_data, 
                det.width * det.height * sizeof(unsigned short));
+    m_stitch_dirty = true;
     return true;
 }
 
@@ -400,18 +713,28 @@ bool XMOGCorrect::CalculateMultiDetectorOffset(const unsigned short*** line_data
         if (!m_detectors[det_id].is_active) {
             continue;
         }
+        if (!line_data[det_id]) {
+            return false;
+        }
+        for (int line = 0; line < num_lines; ++line) {
+            if (!line_data[det_id][line]) {
+                return false;
+            }
+        }
+    }
 
+    // Detectors are independent; each runs on its pinned pool thread
+    HX::Internal::ThreadPool::instance().runPinned(m_num_detectors, [&](int det_id) {
         DetectorCorrectionData& det = m_detectors[det_id];
-        const int total_pixels = det.width * det.height;
+        if (!det.is_active) {
+            return;
+        }
 
+        const int total_pixels = det.width * det.height;
         std::vector<unsigned long long> accumulator(total_pixels, 0);
 
         // Accumulate line data for this detector
         for (int line = 0; line < num_lines; ++line) {
-            if (!line_data[det_id] || !line_data[det_id][line]) {
-                return false;
-            }
-
             for (int i = 0; i < total_pixels; ++i) {
                 accumulator[i] += line_data[det_id][line][i];
             }
@@ -423,8 +746,72 @@ bool XMOGCorrect::CalculateMultiDetectorOffset(const unsigned short*** line_data
                 (accumulator[i] + num_lines / 2) / num_lines
             );
         }
+    });
+
+    m_stitch_dirty = true;
+    return true;
+}
+
+// Add one synchronized dark frame per detector to the running offsets
+bool XMOGCorrect::AddMultiDetectorOffsetFrame(const unsigned short** detector_frames)
+{
+    std::lock_guard<std::mutex> lock(m_calib_mutex);
+    if (!m_initialized || !detector_frames) {
+        return false;
     }
 
+    for (int det_id = 0; det_id < m_num_detectors; ++det_id) {
+        if (m_detectors[det_id].is_active && !detector_frames[det_id]) {
+            return false;
+        }
+    }
+
+    if (m_offset_accs.size() != static_cast<size_t>(m_num_detectors)) {
+        m_offset_accs.assign(m_num_detectors, HX::Internal::WelfordAccumulator());
+    }
+
+    HX::Internal::ThreadPool::instance().runPinned(m_num_detectors, [&](int det_id) {
+        const DetectorCorrectionData& det = m_detectors[det_id];
+        if (!det.is_active) {
+            return;
+        }
+
+        HX::Internal::WelfordAccumulator& acc = m_offset_accs[det_id];
+        const size_t total_pixels = static_cast<size_t>(det.width) * det.height;
+        if (acc.pixels() != total_pixels) {
+            acc.reset(total_pixels);
+        }
+        acc.add(detector_frames[det_id]);
+    });
+
+    return true;
+}
+
+// Store the running offsets of every detector that received frames
+bool XMOGCorrect::FinalizeMultiDetectorOffset()
+{
+    std::lock_guard<std::mutex> lock(m_calib_mutex);
+    if (!m_initialized || m_offset_accs.empty()) {
+        return false;
+    }
+
+    for (int det_id = 0; det_id < m_num_detectors; ++det_id) {
+        HX::Internal::WelfordAccumulator& acc = m_offset_accs[det_id];
+        DetectorCorrectionData& det = m_detectors[det_id];
+        if (acc.count() == 0 || !det.offset_data) {
+            continue;
+        }
+
+        const size_t total_pixels = acc.pixels();
+        for (size_t i = 0; i < total_pixels; ++i) {
+            double value = std::floor(acc.mean(i) + 0.5);
+            det.offset_data[i] = static_cast<unsigned short>(
+                std::max(0.0, std::min(65535.0, value)));
+        }
+    }
+
+    m_offset_accs.clear();
+    m_stitch_dirty = true;
     return true;
 }
 
@@ -437,16 +824,19 @@ bool XMOGCorrect::CalculateMultiDetectorGain(const unsigned short** bright_field
     }
 
     for (int det_id = 0; det_id < m_num_detectors; ++det_id) {
-        if (!m_detectors[det_id].is_active) {
-            continue;
-        }
-
-        if (!bright_field_data[det_id]) {
+        if (m_detectors[det_id].is_active && !bright_field_data[det_id]) {
             return false;
         }
+    }
 
+    HX::Internal::ThreadPool::instance().runPinned(m_num_detectors, [&](int det_id) {
         DetectorCorrectionData& det = m_detectors[det_id];
+        if (!det.is_active) {
+            return;
+        }
+
         const int total_pixels = det.width * det.height;
+        double sum = 0.0;
 
         for (int i = 0; i < total_pixels; ++i) {
             int corrected = static_cast<int>(bright_field_data[det_id][i]) -
@@ -462,9 +852,12 @@ bool XMOGCorrect::CalculateMultiDetectorGain(const unsigned short** bright_field
             // Clamp gain
             if (det.gain_data[i] < 0.1f) det.gain_data[i] = 0.1f;
             if (det.gain_data[i] > 10.0f) det.gain_data[i] = 10.0f;
+            sum += det.gain_data[i];
         }
-    }
+        m_gain_sums[det_id] = sum;
+    });
 
+    m_stitch_dirty = true;
     return true;
 }
 
@@ -475,7 +868,7 @@ bool XMOGCorrect::CalculateCrossDetectorNormalization()
         return false;
     }
 
-    // Calculate mean gain for each detector
+    // Mean gain of each detector, from the maintained sums
     std::vector<float> detector_means(m_num_detectors);
 
     for (int det_id = 0; det_id < m_num_detectors; ++det_id) {
@@ -484,14 +877,9 @@ bool XMOGCorrect::CalculateCrossDetectorNormalization()
             continue;
         }
 
-        DetectorCorrectionData& det = m_detectors[det_id];
-        const int total_pixels = det.width * det.height;
-
-        double sum = 0.0;
-        for (int i = 0; i < total_pixels; ++i) {
-            sum += det.gain_data[i];
-        }
-        detector_means[det_id] = static_cast<float>(sum / total_pixels);
+        const DetectorCorrectionData& det = m_detectors[det_id];
+        const double total_pixels = static_cast<double>(det.width) * det.height;
+        detector_means[det_id] = static_cast<float>(m_gain_sums[det_id] / total_pixels);
     }
 
     // Calculate global mean
@@ -517,6 +905,7 @@ bool XMOGCorrect::CalculateCrossDetectorNormalization()
         }
     }
 
+    PublishNormalization();
     return true;
 }
 
@@ -529,15 +918,24 @@ bool XMOGCorrect::ApplyMultiDetectorCorrection(const unsigned short** input_data
     }
 
     for (int det_id = 0; det_id < m_num_detectors; ++det_id) {
-        if (!m_detectors[det_id].is_active) {
-            continue;
+        if (m_detectors[det_id].is_active && (!input_data[det_id] || !output_data[det_id])) {
+            return false;
         }
+    }
 
-        if (!input_data[det_id] || !output_data[det_id]) {
-            return false;
+    // One set of factors for the whole frame
+    const std::shared_ptr<const NormalizationSnapshot> normalization = m_normalization.acquire();
+    if (!normalization || normalization->factors.size() != static_cast<size_t>(m_num_detectors)) {
+        return false;
+    }
+
+    HX::Internal::ThreadPool::instance().runPinned(m_num_detectors, [&](int det_id) {
+        if (!m_detectors[det_id].is_active) {
+            return;
         }
 
-        DetectorCorrectionData& det = m_detectors[det_id];
+        const DetectorCorrectionData& det = m_detectors[det_id];
+        const float normalization_factor = normalization->factors[det_id];
         const int total_pixels = det.width * det.height;
 
         for (int i = 0; i < total_pixels; ++i) {
@@ -554,7 +952,7 @@ bool XMOGCorrect::ApplyMultiDetectorCorrection(const unsigned short** input_data
             }
 
             // Apply cross-detector normalization
-            corrected *= det.normalization_factor;
+            corrected *= normalization_factor;
 
             // Apply baseline correction
             if (m_enable_baseline) {
@@ -573,7 +971,7 @@ bool XMOGCorrect::ApplyMultiDetectorCorrection(const unsigned short** input_data
                 output_data[det_id][i] = static_cast<unsigned short>(corrected + 0.5f);
             }
         }
-    }
+    });
 
     return true;
 }
@@ -594,103 +992,202 @@ float XMOGCorrect::CalculateBlendWeight(int position, int overlap_start, int ove
 }
 
 // Apply correction and stitch detectors into single image
-bool XMOGCorrect::ApplyStitchedCorrection(const unsigned short** input_data,
-                                         unsigned short* stitched_output,
-                                         int stitched_width,
-                                         int stitched_height)
+// Columns where detector left_id hands over to right_id, false if they
+// do not overlap. Without blending the right detector takes the whole
+// overlap (an empty ramp at its start).
+bool XMOGCorrect::BlendRamp(int left_id, int right_id, int& ramp_start, int& ramp_end) const
 {
-    if (!m_initialized || !input_data || !stitched_output) {
+    if (left_id < 0 || right_id >= m_num_detectors) {
         return false;
     }
 
-    if (stitched_width <= 0 || stitched_height <= 0) {
+    const DetectorCorrectionData& left = m_detectors[left_id];
+    const DetectorCorrectionData& right = m_detectors[right_id];
+    if (!left.is_active || !right.is_active) {
         return false;
     }
 
-    // Initialize output with zeros
-    std::fill_n(stitched_output, stitched_width * stitched_height, 0);
+    const int overlap_start = right.x_offset;
+    const int overlap_end = left.x_offset + left.width;
+    if (overlap_start >= overlap_end) {
+        return false;
+    }
+
+    // A narrower configured width blends around the middle of the overlap
+    ramp_start = overlap_start;
+    ramp_end = overlap_end;
+    if (!m_enable_overlap_blending) {
+        ramp_end = overlap_start;
+    } else if (m_overlap_width > 0 && m_overlap_width < overlap_end - overlap_start) {
+        ramp_start = overlap_start + (overlap_end - overlap_start - m_overlap_width) / 2;
+        ramp_end = ramp_start + m_overlap_width;
+    }
+    return true;
+}
+
+// Precompute per-column blend weights of every detector and the folded
+// coefficients of every stitched row
+void XMOGCorrect::UpdateStitchTable()
+{
+    m_stitch_weights.assign(m_num_detectors, DetectorStitchWeights());
 
-    // Process each detector
     for (int det_id = 0; det_id < m_num_detectors; ++det_id) {
-        if (!m_detectors[det_id].is_active || !input_data[det_id]) {
-            continue;
-        }
+        const DetectorCorrectionData& det = m_detectors[det_id];
+        int left_start = 0, left_end = 0, right_start = 0, right_end = 0;
+        const bool has_left = BlendRamp(det_id - 1, det_id, left_start, left_end);
+        const bool has_right = BlendRamp(det_id, det_id + 1, right_start, right_end);
 
-        DetectorCorrectionData& det = m_detectors[det_id];
+        for (int mask = 0; mask < 4; ++mask) {
+            std::vector<float>& weights = m_stitch_weights[det_id].columns[mask];
+            weights.assign(det.width, 1.0f);
 
-        // Check if detector overlaps with next detector
-        bool has_overlap = false;
-        int overlap_start_x = 0;
-        int overlap_width = 0;
-
-        if (m_enable_overlap_blending && det_id < m_num_detectors - 1) {
-            int next_det_x = m_detectors[det_id + 1].x_offset;
-            int this_det_end = det.x_offset + det.width;
-            
-            if (next_det_x < this_det_end) {
-                has_overlap = true;
-                overlap_start_x = next_det_x;
-                overlap_width = this_det_end - next_det_x;
+            for (int x = 0; x < det.width; ++x) {
+                const int out_x = det.x_offset + x;
+                // Incoming ramp from the left neighbour is the complement of its outgoing one
+                if (has_left && (mask & 1) && out_x < left_end) {
+                    weights[x] = (out_x < left_start) ? 0.0f
+                               : 1.0f - CalculateBlendWeight(out_x, left_start, left_end);
+                }
+                if (has_right && (mask & 2) && out_x >= right_start) {
+                    weights[x] *= (out_x < right_end)
+                               ? CalculateBlendWeight(out_x, right_start, right_end) : 0.0f;
+                }
             }
         }
+    }
+
+    // Rows in stitched order; per row the active detectors covering it in
+    // detector order, each with the columns that land at x >= 0
+    int stitched_rows = 0;
+    for (int det_id = 0; det_id < m_num_detectors; ++det_id) {
+        const DetectorCorrectionData& det = m_detectors[det_id];
+        if (det.is_active) {
+            stitched_rows = std::max(stitched_rows, det.y_offset + det.height);
+        }
+    }
 
-        // Process each pixel in detector
-        for (int y = 0; y < det.height; ++y) {
-            int out_y = det.y_offset + y;
-            if (out_y < 0 || out_y >= stitched_height) {
+    m_stitch_segments.clear();
+    m_stitch_rows.assign(1, 0);
+    size_t coeffs = 0;
+    for (int out_y = 0; out_y < stitched_rows; ++out_y) {
+        for (int det_id = 0; det_id < m_num_detectors; ++det_id) {
+            const DetectorCorrectionData& det = m_detectors[det_id];
+            const int det_x = std::max(0, -det.x_offset);
+            if (!det.is_active || out_y < det.y_offset || out_y >= det.y_offset + det.height ||
+                det_x >= det.width) {
                 continue;
             }
+            StitchSegment segment;
+            segment.det_id = det_id;
+            segment.det_x = det_x;
+            segment.out_x = det.x_offset + det_x;
+            segment.count = det.width - det_x;
+            segment.input = static_cast<size_t>(out_y - det.y_offset) * det.width + det_x;
+            segment.coeff = coeffs;
+            coeffs += segment.count;
+            m_stitch_segments.push_back(segment);
+        }
+        m_stitch_rows.push_back(m_stitch_segments.size());
+    }
 
-            for (int x = 0; x < det.width; ++x) {
-                int out_x = det.x_offset + x;
-                if (out_x < 0 || out_x >= stitched_width) {
-                    continue;
-                }
+    // ((in - off) * g) * n - base + target  ==  in * (g * n) + (target - base - off * g * n)
+    const std::shared_ptr<const NormalizationSnapshot> normalization = m_normalization.acquire();
+    m_stitch_normalization = normalization ? normalization->version : 0;
+    m_stitch_coeffs.resize(coeffs * 2);
+    for (size_t s = 0; s < m_stitch_segments.size(); ++s) {
+        const StitchSegment& segment = m_stitch_segments[s];
+        const DetectorCorrectionData& det = m_detectors[segment.det_id];
+        float* c = &m_stitch_coeffs[segment.coeff * 2];
+        for (int k = 0; k < segment.count; ++k) {
+            const size_t i = segment.input + k;
+            const float gain = m_enable_gain ? det.gain_data[i] : 1.0f;
+            const float scale = gain * (normalization ? normalization->factors[segment.det_id] : 1.0f);
+            float bias = static_cast<float>(m_target_baseline);
+            if (m_enable_offset) bias -= static_cast<float>(det.offset_data[i]) * scale;
+            if (m_enable_baseline) bias -= static_cast<float>(det.baseline_data[i]);
+            c[2 * k] = scale;
+            c[2 * k + 1] = bias;
+        }
+    }
 
-                int in_idx = y * det.width + x;
-                int out_idx = out_y * stitched_width + out_x;
+    m_stitch_dirty = false;
+    UpdateMemoryCharge();
+}
 
-                // Apply correction
-                float corrected = static_cast<float>(input_data[det_id][in_idx]);
+bool XMOGCorrect::ApplyStitchedCorrection(const unsigned short** input_data,
+                                         unsigned short* stitched_output,
+                                         int stitched_width,
+                                         int stitched_height)
+{
+    if (!m_initialized || !input_data || !stitched_output) {
+        return false;
+    }
 
-                if (m_enable_offset) {
-                    corrected -= static_cast<float>(det.offset_data[in_idx]);
-                }
+    if (stitched_width <= 0 || stitched_height <= 0) {
+        return false;
+    }
 
-                if (m_enable_gain) {
-                    corrected *= det.gain_data[in_idx];
-                }
+    if (m_stitch_dirty || GetNormalizationVersion() != m_stitch_normalization) {
+        UpdateStitchTable();
+    }
 
-                corrected *= det.normalization_factor;
+    // A neighbour only takes part in the blend on rows it covers
+    auto covers_row = [&](int det_id, int out_y) {
+        const DetectorCorrectionData& det = m_detectors[det_id];
+        return det.is_active && input_data[det_id] &&
+               out_y >= det.y_offset && out_y < det.y_offset + det.height;
+    };
+
+    // One pass: every stitched row walks its segments, reading input rows
+    // and the coefficient table front to back, and is stored once
+    const int table_rows = static_cast<int>(m_stitch_rows.size()) - 1;
+    HX::Internal::ThreadPool::instance().parallelRows(stitched_height, stitched_width, [&](int first_row, int end_row) {
+        std::vector<float> row_sum(stitched_width);
+
+        for (int out_y = first_row; out_y < end_row; ++out_y) {
+            std::fill(row_sum.begin(), row_sum.end(), 0.0f);
+
+            const size_t first_segment = out_y < table_rows ? m_stitch_rows[out_y] : 0;
+            const size_t end_segment = out_y < table_rows ? m_stitch_rows[out_y + 1] : 0;
+            for (size_t s = first_segment; s < end_segment; ++s) {
+                const StitchSegment& segment = m_stitch_segments[s];
+                const int det_id = segment.det_id;
+                const int count = std::min(segment.count, stitched_width - segment.out_x);
+                if (!input_data[det_id] || count <= 0) {
+                    continue;
+                }
 
-                if (m_enable_baseline) {
-                    corrected -= static_cast<float>(det.baseline_data[in_idx]);
+                int mask = 0;
+                if (det_id > 0 && covers_row(det_id - 1, out_y)) {
+                    mask |= 1;
+                }
+                if (det_id + 1 < m_num_detectors && covers_row(det_id + 1, out_y)) {
+                    mask |= 2;
                 }
 
-                corrected += static_cast<float>(m_target_baseline);
-
-                // Apply blending if in overlap region
-                if (has_overlap && out_x >= overlap_start_x && 
-                    out_x < overlap_start_x + overlap_width) {
-                    float weight = CalculateBlendWeight(out_x, overlap_start_x,
-                                                       overlap_start_x + overlap_width);
-                    
-                    // Blend with existing value
-                    float existing = static_cast<float>(stitched_output[out_idx]);
-                    corrected = corrected * weight + existing * (1.0f - weight);
+                const unsigned short* input = input_data[det_id] + segment.input;
+                const float* weights = m_stitch_weights[det_id].columns[mask].data() + segment.det_x;
+                const float* c = &m_stitch_coeffs[segment.coeff * 2];
+                float* sum = &row_sum[segment.out_x];
+                for (int k = 0; k < count; ++k) {
+                    sum[k] += weights[k] * (static_cast<float>(input[k]) * c[2 * k] + c[2 * k + 1]);
                 }
+            }
 
-                // Clamp and store
-                if (corrected < 0.0f) {
-                    stitched_output[out_idx] = 0;
-                } else if (corrected > m_max_value) {
-                    stitched_output[out_idx] = m_max_value;
+            // Clamp and store
+            unsigned short* dst = stitched_output + static_cast<size_t>(out_y) * stitched_width;
+            for (int x = 0; x < stitched_width; ++x) {
+                const float value = row_sum[x];
+                if (value < 0.0f) {
+                    dst[x] = 0;
+                } else if (value > m_max_value) {
+                    dst[x] = m_max_value;
                 } else {
-                    stitched_output[out_idx] = static_cast<unsigned short>(corrected + 0.5f);
+                    dst[x] = static_cast<unsigned short>(value + 0.5f);
                 }
             }
         }
-    }
+    });
 
     return true;
 }
@@ -701,6 +1198,7 @@ void XMOGCorrect::SetCorrectionMode(bool enable_offset, bool enable_gain, bool e
     m_enable_offset = enable_offset;
     m_enable_gain = enable_gain;
     m_enable_baseline = enable_baseline;
+    m_stitch_dirty = true;
 }
 
 // Set overlap blending
@@ -710,6 +1208,7 @@ void XMOGCorrect::SetOverlapBlending(bool enable, int overlap_width)
     if (overlap_width >= 0) {
         m_overlap_width = overlap_width;
     }
+    m_stitch_dirty = true;
 }
 
 // Save multi-detector calibration to file
@@ -719,38 +1218,46 @@ bool XMOGCorrect::SaveMultiDetectorCalibration(const char* filename)
         return false;
     }
 
-    std::ofstream file(filename, std::ios::binary);
-    if (!file.is_open()) {
-        return false;
+    const int32_t meta[2] = { m_num_detectors, m_bit_depth };
+    std::vector<DetectorRecord> records(m_num_detectors);
+    size_t total_pixels = 0;
+    for (int det_id = 0; det_id < m_num_detectors; ++det_id) {
+        const DetectorCorrectionData& det = m_detectors[det_id];
+        DetectorRecord& r = records[det_id];
+        r.detector_id = det.detector_id;
+        r.width = det.width;
+        r.height = det.height;
+        r.x_offset = det.x_offset;
+        r.y_offset = det.y_offset;
+        r.is_active = det.is_active ? 1 : 0;
+        r.normalization_factor = det.normalization_factor;
+        total_pixels += static_cast<size_t>(det.width) * det.height;
     }
 
-    // Write header
-    file.write(reinterpret_cast<const char*>(&m_num_detectors), sizeof(int));
-    file.write(reinterpret_cast<const char*>(&m_bit_depth), sizeof(int));
-
-    // Write each detector's data
+    // Gather each table into one contiguous section
+    std::vector<unsigned short> offset(total_pixels);
+    std::vector<float> gain(total_pixels);
+    std::vector<unsigned short> baseline(total_pixels);
+    size_t pos = 0;
     for (int det_id = 0; det_id < m_num_detectors; ++det_id) {
         const DetectorCorrectionData& det = m_detectors[det_id];
-        const int total_pixels = det.width * det.height;
-
-        file.write(reinterpret_cast<const char*>(&det.detector_id), sizeof(int));
-        file.write(reinterpret_cast<const char*>(&det.width), sizeof(int));
-        file.write(reinterpret_cast<const char*>(&det.height), sizeof(int));
-        file.write(reinterpret_cast<const char*>(&det.x_offset), sizeof(int));
-        file.write(reinterpret_cast<const char*>(&det.y_offset), sizeof(int));
-        file.write(reinterpret_cast<const char*>(&det.is_active), sizeof(bool));
-        file.write(reinterpret_cast<const char*>(&det.normalization_factor), sizeof(float));
-
-        file.write(reinterpret_cast<const char*>(det.offset_data),
-                  total_pixels * sizeof(unsigned short));
-        file.write(reinterpret_cast<const char*>(det.gain_data),
-                  total_pixels * sizeof(float));
-        file.write(reinterpret_cast<const char*>(det.baseline_data),
-                  total_pixels * sizeof(unsigned short));
+        const size_t pixels = static_cast<size_t>(det.width) * det.height;
+        std::memcpy(&offset[pos], det.offset_data, pixels * sizeof(unsigned short));
+        std::memcpy(&gain[pos], det.gain_data, pixels * sizeof(float));
+        std::memcpy(&baseline[pos], det.baseline_data, pixels * sizeof(unsigned short));
+        pos += pixels;
     }
 
-    file.close();
-    return true;
+    HX::Internal::CalibFileWriter writer(CALIB_MODULE);
+    writer.AddSection(CALIB_META, meta, sizeof(meta), sizeof(int32_t));
+    writer.AddSection(CALIB_DETECTORS, records.data(),
+                      records.size() * sizeof(DetectorRecord), sizeof(DetectorRecord));
+    writer.AddSection(CALIB_OFFSET, offset.data(),
+                      total_pixels * sizeof(unsigned short), sizeof(unsigned short));
+    writer.AddSection(CALIB_GAIN, gain.data(), total_pixels * sizeof(float), sizeof(float));
+    writer.AddSection(CALIB_BASELINE, baseline.data(),
+                      total_pixels * sizeof(unsigned short), sizeof(unsigned short));
+    return writer.Write(filename);
 }
 
 // Load multi-detector calibration from file
@@ -760,6 +1267,82 @@ bool XMOGCorrect::LoadMultiDetectorCalibration(const char* filename)
         return false;
     }
 
+    if (!HX::Internal::CalibFile::IsContainer(filename)) {
+        return LoadLegacyCalibration(filename);
+    }
+
+    HX::Internal::CalibFile file;
+    if (!file.Open(filename, CALIB_MODULE)) {
+        return false;
+    }
+
+    const int32_t* meta = static_cast<const int32_t*>(
+        file.SectionExact(CALIB_META, 2 * sizeof(int32_t)));
+    if (!meta || meta[0] <= 0 || meta[0] > 16) {
+        return false;
+    }
+    const int num_detectors = meta[0];
+
+    const void* records_data = file.SectionExact(CALIB_DETECTORS,
+                                                 num_detectors * sizeof(DetectorRecord));
+    if (!records_data) {
+        return false;
+    }
+    std::vector<DetectorRecord> records(num_detectors);
+    std::memcpy(records.data(), records_data, records.size() * sizeof(DetectorRecord));
+
+    std::vector<int> widths(num_detectors);
+    std::vector<int> heights(num_detectors);
+    size_t total_pixels = 0;
+    for (int i = 0; i < num_detectors; ++i) {
+        if (records[i].width <= 0 || records[i].height <= 0) {
+            return false;
+        }
+        widths[i] = records[i].width;
+        heights[i] = records[i].height;
+        total_pixels += static_cast<size_t>(widths[i]) * heights[i];
+    }
+
+    const unsigned short* offset = static_cast<const unsigned short*>(
+        file.SectionExact(CALIB_OFFSET, total_pixels * sizeof(unsigned short)));
+    const float* gain = static_cast<const float*>(
+        file.SectionExact(CALIB_GAIN, total_pixels * sizeof(float)));
+    const unsigned short* baseline = static_cast<const unsigned short*>(
+        file.SectionExact(CALIB_BASELINE, total_pixels * sizeof(unsigned short)));
+    if (!offset || !gain || !baseline) {
+        return false;
+    }
+
+    if (!Initialize(num_detectors, widths.data(), heights.data(), meta[1])) {
+        return false;
+    }
+
+    size_t pos = 0;
+    for (int det_id = 0; det_id < num_detectors; ++det_id) {
+        DetectorCorrectionData& det = m_detectors[det_id];
+        const DetectorRecord& r = records[det_id];
+        const size_t pixels = static_cast<size_t>(det.width) * det.height;
+
+        det.detector_id = r.detector_id;
+        det.x_offset = r.x_offset;
+        det.y_offset = r.y_offset;
+        det.is_active = r.is_active != 0;
+        det.normalization_factor = r.normalization_factor;
+        std::memcpy(det.offset_data, offset + pos, pixels * sizeof(unsigned short));
+        std::memcpy(det.gain_data, gain + pos, pixels * sizeof(float));
+        std::memcpy(det.baseline_data, baseline + pos, pixels * sizeof(unsigned short));
+        UpdateGainSum(det_id);
+        pos += pixels;
+    }
+
+    PublishNormalization();
+    m_stitch_dirty = true;
+    return true;
+}
+
+// Load the pre-container layout: per-detector header followed by its tables
+bool XMOGCorrect::LoadLegacyCalibration(const char* filename)
+{
     std::ifstream file(filename, std::ios::binary);
     if (!file.is_open()) {
         return false;
@@ -768,6 +1351,9 @@ bool XMOGCorrect::LoadMultiDetectorCalibration(const char* filename)
     int num_detectors, bit_depth;
     file.read(reinterpret_cast<char*>(&num_detectors), sizeof(int));
     file.read(reinterpret_cast<char*>(&bit_depth), sizeof(int));
+    if (!file.good() || num_detectors <= 0 || num_detectors > 16) {
+        return false;
+    }
 
     // Read detector dimensions
     std::vector<int> widths(num_detectors);
@@ -785,6 +1371,9 @@ bool XMOGCorrect::LoadMultiDetectorCalibration(const char* filename)
         file.seekg(sizeof(int) * 2 + sizeof(bool) + sizeof(float), std::ios::cur);
         int total_pixels = widths[i] * heights[i];
         file.seekg(total_pixels * (sizeof(unsigned short) * 2 + sizeof(float)), std::ios::cur);
+        if (!file.good()) {
+            return false;
+        }
     }
 
     // Reset file position
@@ -815,37 +1404,55 @@ bool XMOGCorrect::LoadMultiDetectorCalibration(const char* filename)
                  total_pixels * sizeof(float));
         file.read(reinterpret_cast<char*>(det.baseline_data),
                  total_pixels * sizeof(unsigned short));
+        UpdateGainSum(det_id);
     }
 
+    PublishNormalization();
+    m_stitch_dirty = true;
     file.close();
     return file.good();
 }
 
-// Validate multi-detector calibration data
-bool XMOGCorrect::ValidateMultiDetectorData()
+// Report of one detector's maps, one pass over them
+bool XMOGCorrect::GetDetectorReport(int detector_id, HX::Internal::CalibrationReport& report)
+{
+    if (!ValidateDetectorId(detector_id)) {
+        return false;
+    }
+
+    const DetectorCorrectionData& det = m_detectors[detector_id];
+    HX::Internal::BuildCalibrationReport(det.offset_data, det.gain_data, det.baseline_data,
+                                         static_cast<size_t>(det.width) * det.height, report);
+    return true;
+}
+
+// Reports of every detector, empty for the inactive ones
+bool XMOGCorrect::GetMultiDetectorReport(std::vector<HX::Internal::CalibrationReport>& reports)
 {
     if (!m_initialized) {
         return false;
     }
 
+    reports.assign(m_num_detectors, HX::Internal::CalibrationReport());
     for (int det_id = 0; det_id < m_num_detectors; ++det_id) {
-        if (!m_detectors[det_id].is_active) {
-            continue;
+        if (m_detectors[det_id].is_active) {
+            GetDetectorReport(det_id, reports[det_id]);
         }
+    }
+    return true;
+}
 
-        const DetectorCorrectionData& det = m_detectors[det_id];
-        const int total_pixels = det.width * det.height;
-        int invalid_count = 0;
-
-        for (int i = 0; i < total_pixels; ++i) {
-            if (std::isnan(det.gain_data[i]) || std::isinf(det.gain_data[i]) ||
-                det.gain_data[i] <= 0.0f || det.gain_data[i] > 100.0f) {
-                invalid_count++;
-            }
-        }
+// Validate multi-detector calibration data
+bool XMOGCorrect::ValidateMultiDetectorData()
+{
+    std::vector<HX::Internal::CalibrationReport> reports;
+    if (!GetMultiDetectorReport(reports)) {
+        return false;
+    }
 
-        // Allow up to 0.1% invalid pixels per detector
-        if (invalid_count >= (total_pixels / 1000)) {
+    // Allow up to 0.1% invalid pixels per detector
+    for (int det_id = 0; det_id < m_num_detectors; ++det_id) {
+        if (m_detectors[det_id].is_active && !reports[det_id].valid()) {
             return false;
         }
     }
@@ -857,64 +1464,32 @@ bool XMOGCorrect::ValidateMultiDetectorData()
 bool XMOGCorrect::GetDetectorStatistics(int detector_id, float& offset_mean, float& gain_mean,
                                        float& offset_std, float& gain_std)
 {
-    if (!ValidateDetectorId(detector_id)) {
+    HX::Internal::CalibrationReport report;
+    if (!GetDetectorReport(detector_id, report)) {
         return false;
     }
 
-    const DetectorCorrectionData& det = m_detectors[detector_id];
-    const int total_pixels = det.width * det.height;
-
-    // Calculate means
-    offset_mean = 0.0f;
-    gain_mean = 0.0f;
-
-    for (int i = 0; i < total_pixels; ++i) {
-        offset_mean += static_cast<float>(det.offset_data[i]);
-        gain_mean += det.gain_data[i];
-    }
-    offset_mean /= total_pixels;
-    gain_mean /= total_pixels;
-
-    // Calculate standard deviations
-    offset_std = 0.0f;
-    gain_std = 0.0f;
-
-    for (int i = 0; i < total_pixels; ++i) {
-        float offset_diff = static_cast<float>(det.offset_data[i]) - offset_mean;
-        float gain_diff = det.gain_data[i] - gain_mean;
-        offset_std += offset_diff * offset_diff;
-        gain_std += gain_diff * gain_diff;
-    }
-    offset_std = std::sqrt(offset_std / total_pixels);
-    gain_std = std::sqrt(gain_std / total_pixels);
-
+    offset_mean = static_cast<float>(report.offset.mean);
+    gain_mean = static_cast<float>(report.gain.mean);
+    offset_std = static_cast<float>(report.offset.stdDev());
+    gain_std = static_cast<float>(report.gain.stdDev());
     return true;
 }
 
 // Calculate cross-detector uniformity metric
 bool XMOGCorrect::GetCrossDetectorUniformity(float& uniformity_metric)
 {
-    if (!m_initialized) {
+    std::vector<HX::Internal::CalibrationReport> reports;
+    if (!GetMultiDetectorReport(reports)) {
         return false;
     }
 
     std::vector<float> detector_means(m_num_detectors);
     int active_count = 0;
-
-    // Calculate mean for each active detector
     for (int det_id = 0; det_id < m_num_detectors; ++det_id) {
-        if (!m_detectors[det_id].is_active) {
-            continue;
-        }
-
-        const DetectorCorrectionData& det = m_detectors[det_id];
-        const int total_pixels = det.width * det.height;
-
-        double sum = 0.0;
-        for (int i = 0; i < total_pixels; ++i) {
-            sum += det.gain_data[i];
+        if (m_detectors[det_id].is_active) {
+            detector_means[active_count++] = static_cast<float>(reports[det_id].gain.mean);
         }
-        detector_means[active_count++] = static_cast<float>(sum / total_pixels);
     }
 
     if (active_count < 2) {
@@ -945,10 +1520,13 @@ bool XMOGCorrect::GetCrossDetectorUniformity(float& uniformity_metric)
 }
 
 // Global instance management
+// Shared instance, created on first use (kept for existing callers)
 static XMOGCorrect* g_xmog_instance = nullptr;
+static std::mutex g_xmog_instance_mutex;
 
 XMOGCorrect* CreateXMOGCorrect()
 {
+    std::lock_guard<std::mutex> lock(g_xmog_instance_mutex);
     if (!g_xmog_instance) {
         g_xmog_instance = new XMOGCorrect();
     }
@@ -957,6 +1535,7 @@ XMOGCorrect* CreateXMOGCorrect()
 
 void DestroyXMOGCorrect()
 {
+    std::lock_guard<std::mutex> lock(g_xmog_instance_mutex);
     if (g_xmog_instance) {
         delete g_xmog_instance;
         g_xmog_instance = nullptr;
@@ -965,7 +1544,138 @@ void DestroyXMOGCorrect()
 
 XMOGCorrect* GetXMOGCorrect()
 {
+    std::lock_guard<std::mutex> lock(g_xmog_instance_mutex);
     return g_xmog_instance;
 }
 
-} // namespace fximage
\ No newline at end of file
+// Independent instances: one per detector or pipeline thread, owned by the caller
+XMOGCorrect* CreateXMOGCorrectInstance()
+{
+    return new (std::nothrow) XMOGCorrect();
+}
+
+void DestroyXMOGCorrectInstance(XMOGCorrect* instance)
+{
+    delete instance;
+}
+
+} // namespace fximage
+
+/**
+ * @brief XMOGCorrect instance behind a C API handle
+ */
+struct hubx_xmog_t {
+    std::mutex mutex;
+    fximage::XMOGCorrect correct;
+};
+
+// C-style API
+extern "C" {
+
+hubx_xmog_t* hubx_xmog_create(void) {
+    return new (std::nothrow) hubx_xmog_t();
+}
+
+void hubx_xmog_destroy(hubx_xmog_t* handle) {
+    delete handle;
+}
+
+int hubx_xmog_load(hubx_xmog_t* handle, const char* file) {
+    if (!handle || !file) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    return handle->correct.LoadMultiDetectorCalibration(file) ? HUBX_SUCCESS : HUBX_ERROR_INVALID_PARAM;
+}
+
+int hubx_xmog_detector_count(hubx_xmog_t* handle) {
+    if (!handle) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    if (!handle->correct.IsInitialized()) {
+        return HUBX_ERROR_NOT_CALIBRATED;
+    }
+    return handle->correct.GetNumDetectors();
+}
+
+int hubx_xmog_get_detector_size(hubx_xmog_t* handle, int detector, int* width, int* height) {
+    if (!handle || !width || !height) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    int x = 0;
+    int y = 0;
+    return handle->correct.GetDetectorInfo(detector, *width, *height, x, y)
+           ? HUBX_SUCCESS : HUBX_ERROR_INVALID_PARAM;
+}
+
+int hubx_xmog_save(hubx_xmog_t* handle, const char* file) {
+    if (!handle || !file) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    if (!handle->correct.IsInitialized()) {
+        return HUBX_ERROR_NOT_CALIBRATED;
+    }
+    return handle->correct.SaveMultiDetectorCalibration(file) ? HUBX_SUCCESS : HUBX_ERROR_INVALID_PARAM;
+}
+
+int hubx_xmog_get_detector_position(hubx_xmog_t* handle, int detector, int* x, int* y) {
+    if (!handle || !x || !y) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    int width = 0;
+    int height = 0;
+    return handle->correct.GetDetectorInfo(detector, width, height, *x, *y)
+           ? HUBX_SUCCESS : HUBX_ERROR_INVALID_PARAM;
+}
+
+int hubx_xmog_set_detector_position(hubx_xmog_t* handle, int detector, int x, int y) {
+    if (!handle) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    return handle->correct.SetDetectorPosition(detector, x, y) ? HUBX_SUCCESS : HUBX_ERROR_INVALID_PARAM;
+}
+
+int hubx_xmog_register(hubx_xmog_t* handle, const unsigned short* const* scans,
+                       int searchWidth, float minScore, float* scores) {
+    if (!handle || !scans) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    if (!handle->correct.IsInitialized()) {
+        return HUBX_ERROR_NOT_CALIBRATED;
+    }
+    if (searchWidth < 8) {
+        return HUBX_ERROR_INVALID_PARAM;
+    }
+    return handle->correct.RegisterDetectors(const_cast<const unsigned short**>(scans),
+                                             searchWidth, minScore, scores)
+           ? HUBX_SUCCESS : HUBX_ERROR_CALCULATION;
+}
+
+void hubx_xmog_set_fft(hubx_fft_fn fft, void* user) {
+    HX::Internal::setFFT(fft, user);
+}
+
+int hubx_xmog_apply(hubx_xmog_t* handle, const unsigned short* const* inputs,
+                    unsigned short* const* outputs) {
+    if (!handle || !inputs || !outputs) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    HX::Internal::TraceScope trace(HX::XFactory::TRACE_CORRECT_MOG);
+    HX::Internal::PerfScope perf(HX::XFactory::PERF_CORRECT_MOG);
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    if (!handle->correct.IsInitialized()) {
+        return HUBX_ERROR_NOT_CALIBRATED;
+    }
+    // Pointwise per detector: outputs may alias inputs
+    return handle->correct.ApplyMultiDetectorCorrection(const_cast<const unsigned short**>(inputs),
+                                                        const_cast<unsigned short**>(outputs))
+           ? HUBX_SUCCESS : HUBX_ERROR_CALCULATION;
+}
+
+} // extern "C"
@@ -9,16 +9,665 @@
  */
 
 #include "../../include/xog_correct.h"
+#include "../../include/ixline_filter.h"
+#include "../utils/calib_file.h"
+#include "../utils/calib_report.h"
+#include "../utils/cpu_features.h"
+#include "../utils/latency_trace.h"
+#include "../utils/median_of_means.h"
+#include "../utils/mem_profile.h"
+#include "../utils/perf_counters.h"
+#include "../utils/snapshot.h"
+#include "../utils/saturation_map.h"
+#include "../utils/thread_pool.h"
+#include "../utils/welford.h"
+#include <cstdint>
+#include <cstdio>
 #include <cstring>
 #include <cmath>
 #include <algorithm>
+#include <atomic>
 #include <vector>
 #include <fstream>
+#include <memory>
+#include <mutex>
+#include <new>
+
+// Error codes
+#define HUBX_SUCCESS 0
+#define HUBX_ERROR_INVALID_PARAM -1
+#define HUBX_ERROR_NULL_POINTER -2
+#define HUBX_ERROR_CALCULATION -4
+#define HUBX_ERROR_NOT_CALIBRATED -5
 
 namespace fximage {
 
+namespace {
+
+// Coefficients are stored in blocks of COEFF_BLOCK gains followed by
+// COEFF_BLOCK biases, so one stream feeds full vectors of either
+const int COEFF_BLOCK = 16;
+
+// Calibration container tags (see utils/calib_file.h)
+const uint32_t CALIB_MODULE   = HX::Internal::CalibTag('X', 'O', 'G', ' ');
+const uint32_t CALIB_META     = HX::Internal::CalibTag('M', 'E', 'T', 'A');
+const uint32_t CALIB_OFFSET   = HX::Internal::CalibTag('O', 'F', 'F', 'S');
+const uint32_t CALIB_GAIN     = HX::Internal::CalibTag('G', 'A', 'I', 'N');
+const uint32_t CALIB_BASELINE = HX::Internal::CalibTag('B', 'A', 'S', 'E');
+const uint32_t CALIB_MODULES  = HX::Internal::CalibTag('M', 'O', 'D', 'S');
+
+// Map slice of one detector module, for files in the per-module layout
+inline uint32_t ModuleTag(char map, int module)
+{
+    return HX::Internal::CalibTag(map, 'M', static_cast<char>(module & 0xFF),
+                                  static_cast<char>((module >> 8) & 0xFF));
+}
+
+// A module slice is columns [x0, x0 + count) of every row, stored row by row
+template <typename T>
+void GatherModule(const T* map, int width, int height, int x0, int count, T* slice)
+{
+    for (int row = 0; row < height; ++row) {
+        std::memcpy(slice + static_cast<size_t>(row) * count,
+                    map + static_cast<size_t>(row) * width + x0, count * sizeof(T));
+    }
+}
+
+template <typename T>
+void ScatterModule(const T* slice, int width, int height, int x0, int count, T* map)
+{
+    for (int row = 0; row < height; ++row) {
+        std::memcpy(map + static_cast<size_t>(row) * width + x0,
+                    slice + static_cast<size_t>(row) * count, count * sizeof(T));
+    }
+}
+
+inline size_t CoeffIndex(size_t pixel)
+{
+    return (pixel / COEFF_BLOCK) * (2 * COEFF_BLOCK) + (pixel % COEFF_BLOCK);
+}
+
+/**
+ * @brief Inputs of one correction run: out = clamp(in * gain + bias, 0, max)
+ */
+struct OGRun {
+    const unsigned short* input;
+    unsigned short* output;
+    const float* coeffs;        ///< Blocked {gain, bias} for the whole frame
+    size_t pixel;               ///< Frame index of input[0]
+    int count;
+    float max_value;
+};
+
+typedef void (*OGKernel)(const OGRun& run);
+
+/**
+ * @brief Scalar kernel over [first, last), also used for the vector heads and tails
+ */
+inline void CorrectScalarRange(const OGRun& run, int first, int last)
+{
+    for (int i = first; i < last; ++i) {
+        const float* c = run.coeffs + CoeffIndex(run.pixel + i);
+        float corrected = static_cast<float>(run.input[i]) * c[0] + c[COEFF_BLOCK];
+
+        if (corrected < 0.0f) {
+            corrected = 0.0f;
+        } else if (corrected > run.max_value) {
+            corrected = run.max_value;
+        }
+        run.output[i] = static_cast<unsigned short>(corrected + 0.5f);
+    }
+}
+
+void CorrectScalar(const OGRun& run)
+{
+    CorrectScalarRange(run, 0, run.count);
+}
+
+/**
+ * @brief Pixels before the first whole coefficient block
+ */
+inline int BlockHead(const OGRun& run)
+{
+    int head = static_cast<int>((COEFF_BLOCK - run.pixel % COEFF_BLOCK) % COEFF_BLOCK);
+    return std::min(head, run.count);
+}
+
+// Vector kernels use fused multiply-add, so a result can differ from the
+// scalar path by one count where in * gain + bias lands on a .5 boundary.
+
+#if defined(HX_ARCH_X86)
+
+HX_TARGET("avx2,fma")
+void CorrectAVX2(const OGRun& run)
+{
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 max_value = _mm256_set1_ps(run.max_value);
+    const __m256 half = _mm256_set1_ps(0.5f);
+
+    int i = BlockHead(run);
+    CorrectScalarRange(run, 0, i);
+
+    for (; i + COEFF_BLOCK <= run.count; i += COEFF_BLOCK) {
+        const float* c = run.coeffs + CoeffIndex(run.pixel + i);
+        __m256i in = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(run.input + i));
+        __m256i packed[2];
+
+        for (int h = 0; h < 2; ++h) {
+            __m256 v = _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(
+                h ? _mm256_extracti128_si256(in, 1) : _mm256_castsi256_si128(in)));
+            v = _mm256_fmadd_ps(v, _mm256_loadu_ps(c + h * 8), _mm256_loadu_ps(c + COEFF_BLOCK + h * 8));
+            v = _mm256_min_ps(_mm256_max_ps(v, zero), max_value);
+            packed[h] = _mm256_cvttps_epi32(_mm256_add_ps(v, half));
+        }
+
+        // packus works per 128-bit lane, restore pixel order afterwards
+        __m256i out = _mm256_permute4x64_epi64(_mm256_packus_epi32(packed[0], packed[1]), 0xD8);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(run.output + i), out);
+    }
+
+    CorrectScalarRange(run, i, run.count);
+}
+
+HX_TARGET("avx512f,avx512bw")
+void CorrectAVX512(const OGRun& run)
+{
+    const __m512 zero = _mm512_setzero_ps();
+    const __m512 max_value = _mm512_set1_ps(run.max_value);
+    const __m512 half = _mm512_set1_ps(0.5f);
+
+    int i = BlockHead(run);
+    CorrectScalarRange(run, 0, i);
+
+    for (; i + COEFF_BLOCK <= run.count; i += COEFF_BLOCK) {
+        const float* c = run.coeffs + CoeffIndex(run.pixel + i);
+        __m512 v = _mm512_cvtepi32_ps(_mm512_cvtepu16_epi32(
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(run.input + i))));
+        v = _mm512_fmadd_ps(v, _mm512_loadu_ps(c), _mm512_loadu_ps(c + COEFF_BLOCK));
+        v = _mm512_min_ps(_mm512_max_ps(v, zero), max_value);
+
+        __m512i out = _mm512_cvttps_epi32(_mm512_add_ps(v, half));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(run.output + i), _mm512_cvtusepi32_epi16(out));
+    }
+
+    CorrectScalarRange(run, i, run.count);
+}
+
+#endif // HX_ARCH_X86
+
+#if defined(HX_ARCH_NEON)
+
+void CorrectNEON(const OGRun& run)
+{
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    const float32x4_t max_value = vdupq_n_f32(run.max_value);
+    const float32x4_t half = vdupq_n_f32(0.5f);
+
+    int i = BlockHead(run);
+    CorrectScalarRange(run, 0, i);
+
+    for (; i + COEFF_BLOCK <= run.count; i += COEFF_BLOCK) {
+        const float* c = run.coeffs + CoeffIndex(run.pixel + i);
+
+        for (int q = 0; q < COEFF_BLOCK; q += 8) {
+            uint16x8_t in = vld1q_u16(run.input + i + q);
+            uint16x4_t packed[2];
+
+            for (int h = 0; h < 2; ++h) {
+                const int lane = q + h * 4;
+                float32x4_t v = vcvtq_f32_u32(vmovl_u16(h ? vget_high_u16(in) : vget_low_u16(in)));
+                v = vfmaq_f32(vld1q_f32(c + COEFF_BLOCK + lane), v, vld1q_f32(c + lane));
+                v = vminq_f32(vmaxq_f32(v, zero), max_value);
+                packed[h] = vqmovn_u32(vcvtq_u32_f32(vaddq_f32(v, half)));
+            }
+
+            vst1q_u16(run.output + i + q, vcombine_u16(packed[0], packed[1]));
+        }
+    }
+
+    CorrectScalarRange(run, i, run.count);
+}
+
+#endif // HX_ARCH_NEON
+
+const HX::Internal::KernelFamily g_ogKernels("xog_correct",
+    HX::XFactory::CPU_AVX512 | HX::XFactory::CPU_AVX2 | HX::XFactory::CPU_NEON);
+
+/**
+ * @brief Pick the widest kernel the CPU supports
+ */
+OGKernel SelectKernel()
+{
+    switch (g_ogKernels.isa()) {
+#if defined(HX_ARCH_X86)
+    case HX::XFactory::CPU_AVX512: return &CorrectAVX512;
+    case HX::XFactory::CPU_AVX2: return &CorrectAVX2;
+#endif
+#if defined(HX_ARCH_NEON)
+    case HX::XFactory::CPU_NEON: return &CorrectNEON;
+#endif
+    default: return &CorrectScalar;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Fixed-point path: gain and bias in Q(bits), int32 multiply-accumulate.
+// out = clamp((min(in, max) * gain_q + bias_q) >> bits, 0, max), where
+// bias_q already carries the rounding half. No int/float conversions.
+// ---------------------------------------------------------------------------
+
+// Fewer fraction bits than this and the float path is used instead
+const int MIN_FIXED_BITS = 10;
+const int MAX_FIXED_BITS = 16;
+
+struct OGFixedRun {
+    const unsigned short* input;
+    unsigned short* output;
+    const int32_t* coeffs;      ///< Blocked {gain_q, bias_q}, same layout as float
+    size_t pixel;
+    int count;
+    int bits;
+    int32_t max_value;
+};
+
+typedef void (*OGFixedKernel)(const OGFixedRun& run);
+
+inline void CorrectFixedScalarRange(const OGFixedRun& run, int first, int last)
+{
+    for (int i = first; i < last; ++i) {
+        const int32_t* c = run.coeffs + CoeffIndex(run.pixel + i);
+        int32_t in = std::min<int32_t>(run.input[i], run.max_value);
+        int32_t v = (in * c[0] + c[COEFF_BLOCK]) >> run.bits;
+        run.output[i] = static_cast<unsigned short>(std::max<int32_t>(0, std::min(v, run.max_value)));
+    }
+}
+
+void CorrectFixedScalar(const OGFixedRun& run)
+{
+    CorrectFixedScalarRange(run, 0, run.count);
+}
+
+inline int BlockHead(const OGFixedRun& run)
+{
+    int head = static_cast<int>((COEFF_BLOCK - run.pixel % COEFF_BLOCK) % COEFF_BLOCK);
+    return std::min(head, run.count);
+}
+
+#if defined(HX_ARCH_X86)
+
+HX_TARGET("avx2")
+void CorrectFixedAVX2(const OGFixedRun& run)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i max_value = _mm256_set1_epi32(run.max_value);
+    const __m256i max_in = _mm256_set1_epi16(static_cast<short>(run.max_value));
+    const __m128i shift = _mm_cvtsi32_si128(run.bits);
+
+    int i = BlockHead(run);
+    CorrectFixedScalarRange(run, 0, i);
+
+    for (; i + COEFF_BLOCK <= run.count; i += COEFF_BLOCK) {
+        const int32_t* c = run.coeffs + CoeffIndex(run.pixel + i);
+        __m256i in = _mm256_min_epu16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(run.input + i)),
+                                      max_in);
+        __m256i packed[2];
+
+        for (int h = 0; h < 2; ++h) {
+            __m256i v = _mm256_cvtepu16_epi32(
+                h ? _mm256_extracti128_si256(in, 1) : _mm256_castsi256_si128(in));
+            v = _mm256_mullo_epi32(v, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(c + h * 8)));
+            v = _mm256_add_epi32(v, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(c + COEFF_BLOCK + h * 8)));
+            v = _mm256_sra_epi32(v, shift);
+            packed[h] = _mm256_min_epi32(_mm256_max_epi32(v, zero), max_value);
+        }
+
+        __m256i out = _mm256_permute4x64_epi64(_mm256_packus_epi32(packed[0], packed[1]), 0xD8);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(run.output + i), out);
+    }
+
+    CorrectFixedScalarRange(run, i, run.count);
+}
+
+HX_TARGET("avx512f,avx512bw")
+void CorrectFixedAVX512(const OGFixedRun& run)
+{
+    const __m512i zero = _mm512_setzero_si512();
+    const __m512i max_value = _mm512_set1_epi32(run.max_value);
+    const __m256i max_in = _mm256_set1_epi16(static_cast<short>(run.max_value));
+    const __m128i shift = _mm_cvtsi32_si128(run.bits);
+
+    int i = BlockHead(run);
+    CorrectFixedScalarRange(run, 0, i);
+
+    for (; i + COEFF_BLOCK <= run.count; i += COEFF_BLOCK) {
+        const int32_t* c = run.coeffs + CoeffIndex(run.pixel + i);
+        __m256i in = _mm256_min_epu16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(run.input + i)),
+                                      max_in);
+        __m512i v = _mm512_cvtepu16_epi32(in);
+        v = _mm512_mullo_epi32(v, _mm512_loadu_si512(c));
+        v = _mm512_add_epi32(v, _mm512_loadu_si512(c + COEFF_BLOCK));
+        v = _mm512_sra_epi32(v, shift);
+        v = _mm512_min_epi32(_mm512_max_epi32(v, zero), max_value);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(run.output + i), _mm512_cvtusepi32_epi16(v));
+    }
+
+    CorrectFixedScalarRange(run, i, run.count);
+}
+
+#endif // HX_ARCH_X86
+
+#if defined(HX_ARCH_NEON)
+
+void CorrectFixedNEON(const OGFixedRun& run)
+{
+    const int32x4_t zero = vdupq_n_s32(0);
+    const int32x4_t max_value = vdupq_n_s32(run.max_value);
+    const uint16x8_t max_in = vdupq_n_u16(static_cast<uint16_t>(run.max_value));
+    const int32x4_t shift = vdupq_n_s32(-run.bits);
+
+    int i = BlockHead(run);
+    CorrectFixedScalarRange(run, 0, i);
+
+    for (; i + COEFF_BLOCK <= run.count; i += COEFF_BLOCK) {
+        const int32_t* c = run.coeffs + CoeffIndex(run.pixel + i);
+
+        for (int q = 0; q < COEFF_BLOCK; q += 8) {
+            uint16x8_t in = vminq_u16(vld1q_u16(run.input + i + q), max_in);
+            uint16x4_t packed[2];
+
+            for (int h = 0; h < 2; ++h) {
+                const int lane = q + h * 4;
+                int32x4_t v = vreinterpretq_s32_u32(vmovl_u16(h ? vget_high_u16(in) : vget_low_u16(in)));
+                v = vmlaq_s32(vld1q_s32(c + COEFF_BLOCK + lane), v, vld1q_s32(c + lane));
+                v = vshlq_s32(v, shift);
+                v = vminq_s32(vmaxq_s32(v, zero), max_value);
+                packed[h] = vmovn_u32(vreinterpretq_u32_s32(v));
+            }
+
+            vst1q_u16(run.output + i + q, vcombine_u16(packed[0], packed[1]));
+        }
+    }
+
+    CorrectFixedScalarRange(run, i, run.count);
+}
+
+#endif // HX_ARCH_NEON
+
+const HX::Internal::KernelFamily g_ogFixedKernels("xog_correct_fixed",
+    HX::XFactory::CPU_AVX512 | HX::XFactory::CPU_AVX2 | HX::XFactory::CPU_NEON);
+
+OGFixedKernel SelectFixedKernel()
+{
+    switch (g_ogFixedKernels.isa()) {
+#if defined(HX_ARCH_X86)
+    case HX::XFactory::CPU_AVX512: return &CorrectFixedAVX512;
+    case HX::XFactory::CPU_AVX2: return &CorrectFixedAVX2;
+#endif
+#if defined(HX_ARCH_NEON)
+    case HX::XFactory::CPU_NEON: return &CorrectFixedNEON;
+#endif
+    default: return &CorrectFixedScalar;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Compact path: 4 bytes per pixel instead of 8. Each block holds
+// COEFF_BLOCK uint16 gains in Q(gain_bits) followed by COEFF_BLOCK uint16
+// references in Q(ref_bits), with ref = offset + baseline / gain:
+// out = clamp(((in << ref_bits) - ref_q) * step * gain_q + target, 0, max),
+// step = 2^-(gain_bits + ref_bits). Everything up to the FMA is exact.
+// ---------------------------------------------------------------------------
+
+// References get at most this many fraction bits
+const int MAX_COMPACT_REF_BITS = 8;
+
+struct OGCompactRun {
+    const unsigned short* input;
+    unsigned short* output;
+    const uint16_t* coeffs;     ///< Blocked {gain_q, ref_q}
+    size_t pixel;
+    int count;
+    int ref_bits;
+    float step;
+    float target;
+    float max_value;
+};
+
+typedef void (*OGCompactKernel)(const OGCompactRun& run);
+
+inline void CorrectCompactScalarRange(const OGCompactRun& run, int first, int last)
+{
+    for (int i = first; i < last; ++i) {
+        const uint16_t* c = run.coeffs + CoeffIndex(run.pixel + i);
+        const int32_t delta = (static_cast<int32_t>(run.input[i]) << run.ref_bits) - c[COEFF_BLOCK];
+        float corrected = static_cast<float>(delta) * run.step * static_cast<float>(c[0]) + run.target;
+
+        if (corrected < 0.0f) {
+            corrected = 0.0f;
+        } else if (corrected > run.max_value) {
+            corrected = run.max_value;
+        }
+        run.output[i] = static_cast<unsigned short>(corrected + 0.5f);
+    }
+}
+
+void CorrectCompactScalar(const OGCompactRun& run)
+{
+    CorrectCompactScalarRange(run, 0, run.count);
+}
+
+inline int BlockHead(const OGCompactRun& run)
+{
+    int head = static_cast<int>((COEFF_BLOCK - run.pixel % COEFF_BLOCK) % COEFF_BLOCK);
+    return std::min(head, run.count);
+}
+
+#if defined(HX_ARCH_X86)
+
+HX_TARGET("avx2,fma")
+void CorrectCompactAVX2(const OGCompactRun& run)
+{
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 max_value = _mm256_set1_ps(run.max_value);
+    const __m256 half = _mm256_set1_ps(0.5f);
+    const __m256 step = _mm256_set1_ps(run.step);
+    const __m256 target = _mm256_set1_ps(run.target);
+    const __m128i shift = _mm_cvtsi32_si128(run.ref_bits);
+
+    int i = BlockHead(run);
+    CorrectCompactScalarRange(run, 0, i);
+
+    for (; i + COEFF_BLOCK <= run.count; i += COEFF_BLOCK) {
+        const uint16_t* c = run.coeffs + CoeffIndex(run.pixel + i);
+        __m256i in = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(run.input + i));
+        __m256i gains = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(c));
+        __m256i refs = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(c + COEFF_BLOCK));
+        __m256i packed[2];
+
+        for (int h = 0; h < 2; ++h) {
+            __m256i delta = _mm256_sub_epi32(
+                _mm256_sll_epi32(_mm256_cvtepu16_epi32(
+                    h ? _mm256_extracti128_si256(in, 1) : _mm256_castsi256_si128(in)), shift),
+                _mm256_cvtepu16_epi32(h ? _mm256_extracti128_si256(refs, 1) : _mm256_castsi256_si128(refs)));
+            __m256 gain = _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(
+                h ? _mm256_extracti128_si256(gains, 1) : _mm256_castsi256_si128(gains)));
+
+            __m256 v = _mm256_fmadd_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(delta), step), gain, target);
+            v = _mm256_min_ps(_mm256_max_ps(v, zero), max_value);
+            packed[h] = _mm256_cvttps_epi32(_mm256_add_ps(v, half));
+        }
+
+        __m256i out = _mm256_permute4x64_epi64(_mm256_packus_epi32(packed[0], packed[1]), 0xD8);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(run.output + i), out);
+    }
+
+    CorrectCompactScalarRange(run, i, run.count);
+}
+
+HX_TARGET("avx512f,avx512bw")
+void CorrectCompactAVX512(const OGCompactRun& run)
+{
+    const __m512 zero = _mm512_setzero_ps();
+    const __m512 max_value = _mm512_set1_ps(run.max_value);
+    const __m512 half = _mm512_set1_ps(0.5f);
+    const __m512 step = _mm512_set1_ps(run.step);
+    const __m512 target = _mm512_set1_ps(run.target);
+    const __m128i shift = _mm_cvtsi32_si128(run.ref_bits);
+
+    int i = BlockHead(run);
+    CorrectCompactScalarRange(run, 0, i);
+
+    for (; i + COEFF_BLOCK <= run.count; i += COEFF_BLOCK) {
+        const uint16_t* c = run.coeffs + CoeffIndex(run.pixel + i);
+        __m512i delta = _mm512_sub_epi32(
+            _mm512_sll_epi32(_mm512_cvtepu16_epi32(
+                _mm256_loadu_si256(reinterpret_cast<const __m256i*>(run.input + i))), shift),
+            _mm512_cvtepu16_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(c + COEFF_BLOCK))));
+        __m512 gain = _mm512_cvtepi32_ps(_mm512_cvtepu16_epi32(
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(c))));
+
+        __m512 v = _mm512_fmadd_ps(_mm512_mul_ps(_mm512_cvtepi32_ps(delta), step), gain, target);
+        v = _mm512_min_ps(_mm512_max_ps(v, zero), max_value);
+        __m512i out = _mm512_cvttps_epi32(_mm512_add_ps(v, half));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(run.output + i), _mm512_cvtusepi32_epi16(out));
+    }
+
+    CorrectCompactScalarRange(run, i, run.count);
+}
+
+#endif // HX_ARCH_X86
+
+#if defined(HX_ARCH_NEON)
+
+void CorrectCompactNEON(const OGCompactRun& run)
+{
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    const float32x4_t max_value = vdupq_n_f32(run.max_value);
+    const float32x4_t half = vdupq_n_f32(0.5f);
+    const float32x4_t step = vdupq_n_f32(run.step);
+    const float32x4_t target = vdupq_n_f32(run.target);
+    const int32x4_t shift = vdupq_n_s32(run.ref_bits);
+
+    int i = BlockHead(run);
+    CorrectCompactScalarRange(run, 0, i);
+
+    for (; i + COEFF_BLOCK <= run.count; i += COEFF_BLOCK) {
+        const uint16_t* c = run.coeffs + CoeffIndex(run.pixel + i);
+
+        for (int q = 0; q < COEFF_BLOCK; q += 8) {
+            uint16x8_t in = vld1q_u16(run.input + i + q);
+            uint16x8_t gains = vld1q_u16(c + q);
+            uint16x8_t refs = vld1q_u16(c + COEFF_BLOCK + q);
+            uint16x4_t packed[2];
+
+            for (int h = 0; h < 2; ++h) {
+                int32x4_t delta = vsubq_s32(
+                    vshlq_s32(vreinterpretq_s32_u32(vmovl_u16(h ? vget_high_u16(in) : vget_low_u16(in))), shift),
+                    vreinterpretq_s32_u32(vmovl_u16(h ? vget_high_u16(refs) : vget_low_u16(refs))));
+                float32x4_t gain = vcvtq_f32_u32(vmovl_u16(h ? vget_high_u16(gains) : vget_low_u16(gains)));
+
+                float32x4_t v = vfmaq_f32(target, vmulq_f32(vcvtq_f32_s32(delta), step), gain);
+                v = vminq_f32(vmaxq_f32(v, zero), max_value);
+                packed[h] = vqmovn_u32(vcvtq_u32_f32(vaddq_f32(v, half)));
+            }
+
+            vst1q_u16(run.output + i + q, vcombine_u16(packed[0], packed[1]));
+        }
+    }
+
+    CorrectCompactScalarRange(run, i, run.count);
+}
+
+#endif // HX_ARCH_NEON
+
+const HX::Internal::KernelFamily g_ogCompactKernels("xog_correct_compact",
+    HX::XFactory::CPU_AVX512 | HX::XFactory::CPU_AVX2 | HX::XFactory::CPU_NEON);
+
+OGCompactKernel SelectCompactKernel()
+{
+    switch (g_ogCompactKernels.isa()) {
+#if defined(HX_ARCH_X86)
+    case HX::XFactory::CPU_AVX512: return &CorrectCompactAVX512;
+    case HX::XFactory::CPU_AVX2: return &CorrectCompactAVX2;
+#endif
+#if defined(HX_ARCH_NEON)
+    case HX::XFactory::CPU_NEON: return &CorrectCompactNEON;
+#endif
+    default: return &CorrectCompactScalar;
+    }
+}
+
+} // namespace
+
+/**
+ * @brief One published calibration: everything an apply reads
+ *
+ * Never changed once published. An apply holds it for the whole frame, so
+ * calibration loaded meanwhile takes effect from the next frame.
+ */
+struct OGCalibration {
+    uint64_t version;
+    int width;
+    int height;
+    unsigned short max_value;
+    std::vector<float> coeffs;          ///< Blocked {gain, bias}
+    bool fixed_active;                  ///< fixed_coeffs fit int32 for every pixel
+    int fixed_bits;
+    std::vector<int32_t> fixed_coeffs;  ///< Same coefficients in Q(fixed_bits)
+    bool compact_active;                ///< compact_coeffs used, coeffs and fixed_coeffs empty
+    int compact_gain_bits;
+    int compact_ref_bits;
+    float compact_step;                 ///< 2^-(gain bits + reference bits)
+    int compact_error;                  ///< Bound from the float path, in output counts
+    float target;
+    std::vector<uint16_t> compact_coeffs;   ///< Blocked {gain_q, ref_q}
+    int ref_module;                     ///< Module width of the dark reference pixels
+    int ref_lead;                       ///< Shielded pixels at the start of each module
+    int ref_trail;                      ///< Shielded pixels at the end of each module
+    std::vector<float> ref_levels;      ///< height x modules offset map mean, empty = off
+};
+
+namespace {
+
+// Remove the drift each module's reference pixels show against their
+// offset map level; returns the line the kernel should read
+const unsigned short* SubtractReferenceDrift(const OGCalibration& calib, const unsigned short* input,
+                                             unsigned short* output, int row)
+{
+    if (calib.ref_levels.empty()) {
+        return input;
+    }
+
+    const int modules = calib.width / calib.ref_module;
+    const float* levels = &calib.ref_levels[static_cast<size_t>(row) * modules];
+    const int count = calib.ref_lead + calib.ref_trail;
+    for (int m = 0; m < modules; ++m) {
+        const int x0 = m * calib.ref_module;
+        const int x1 = x0 + calib.ref_module;
+        uint32_t sum = 0;
+        for (int x = x0; x < x0 + calib.ref_lead; ++x) {
+            sum += input[x];
+        }
+        for (int x = x1 - calib.ref_trail; x < x1; ++x) {
+            sum += input[x];
+        }
+        const int drift = static_cast<int>(std::floor(static_cast<float>(sum) / count - levels[m] + 0.5f));
+        for (int x = x0; x < x1; ++x) {
+            const int value = static_cast<int>(input[x]) - drift;
+            output[x] = static_cast<unsigned short>(value < 0 ? 0 : (value > 65535 ? 65535 : value));
+        }
+    }
+    return output;
+}
+
+} // namespace
+
 /**
  * @brief XOGCorrect class implementation for single-detector correction
+ *
+ * Calibration calls edit the maps under m_calib_mutex and publish a new
+ * OGCalibration when done; ApplyCorrection and ApplyCorrectionLine only read
+ * the published one, so they never wait for, or race with, a recalibration.
  */
 class XOGCorrect {
 public:
@@ -29,6 +678,8 @@ public:
     bool Initialize(int width, int height, int bit_depth = 14);
     bool Release();
     bool IsInitialized() const { return m_initialized; }
+    int GetWidth() const { return m_width; }
+    int GetHeight() const { return m_height; }
 
     // Calibration data management
     bool SetOffsetData(const unsigned short* offset_data);
@@ -45,31 +696,104 @@ public:
                        unsigned short target_value);
     bool CalculateBaseline(const unsigned short** line_data, int num_lines);
 
-    // Correction operations
+    // Streaming calibration: push frames as they arrive (e.g. from
+    // OnFrameReady), then finalize. Memory stays O(pixels); Add* may run on
+    // the acquisition thread while another thread finalizes.
+    bool AddOffsetFrame(const unsigned short* frame);
+    bool FinalizeOffset(float* noise = nullptr);
+    bool AddBaselineFrame(const unsigned short* frame);
+    bool FinalizeBaseline(float* noise = nullptr);
+    bool AddGainFrame(const unsigned short* frame);
+    bool FinalizeGain(unsigned short target_value);
+    int GetOffsetFrameCount();
+    int GetBaselineFrameCount();
+    int GetGainFrameCount();
+    void DiscardCalibrationFrames();
+    // Bright frames are dealt into groups and FinalizeGain takes the
+    // per-pixel median of the group means, so frames with cosmic hits do
+    // not reach the gain map (< 2 = plain mean, the default). Discards the
+    // bright frames added so far.
+    void SetRobustGain(int groups);
+
+    // Correction operations; safe while another thread recalibrates
     bool ApplyCorrection(const unsigned short* input_data,
                         unsigned short* output_data);
     bool ApplyCorrectionLine(const unsigned short* input_line,
                             unsigned short* output_line,
                             int line_index = 0);
+    bool ApplyCorrectionRow(const unsigned short* input_line,
+                            unsigned short* output_line,
+                            int width, uint32_t row);
+
+    // Incremented by every publish; 0 while nothing is calibrated
+    uint64_t GetCalibrationVersion() const;
 
     // Configuration
     void SetCorrectionMode(bool enable_offset, bool enable_gain, bool enable_baseline);
-    void SetTargetBaseline(unsigned short baseline) { m_target_baseline = baseline; }
+    void SetTargetBaseline(unsigned short baseline);
     void SetBitDepth(int bit_depth);
 
+    // Fixed-point correction (on by default, used when the Q format fits)
+    void SetFixedPoint(bool enable);
+    bool IsFixedPointActive();
+    int GetFixedPointErrorBound();
+
+    // 16-bit coefficients (off by default): half the coefficient memory
+    // and traffic, used when the error bound is at most max_error counts
+    void SetCompactCoefficients(bool enable, int max_error = 2);
+    bool IsCompactActive();
+    int GetCompactErrorBound();
+
+    // Bound of whichever format applies run, 0 for the float path
+    int GetErrorBound();
+
+    // Detector modules (XDM_PIX_NUM pixels each, XLibPacketHeader::moduleId):
+    // module m is columns [m * module_pixels, (m + 1) * module_pixels) of
+    // every row. Once set, files are written per module, and a module's
+    // calibration can be replaced without touching the rest. 0 = none.
+    bool SetModuleSegments(int module_pixels);
+    int GetModulePixels() const { return m_module_pixels; }
+    int GetModuleCount() const;
+    // Restrict Calculate* and Finalize* to one module's slice (-1 = all)
+    bool SetCalibrationModule(int module);
+    // Replace one module's maps, height * module_pixels each (NULL keeps one)
+    bool SetModuleData(int module, const unsigned short* offset_data,
+                       const float* gain_data, const unsigned short* baseline_data);
+    // Shielded pixels at the start and end of every module (the whole line
+    // without modules); each line's mean over them, less the offset map's,
+    // is taken off that module before correcting. 0, 0 = off.
+    bool SetDarkReference(int lead_pixels, int trail_pixels);
+
     // File I/O
     bool SaveCalibrationData(const char* filename);
     bool LoadCalibrationData(const char* filename);
+    // Rewrite or read one module's slice of a per-module file
+    bool SaveModuleCalibration(const char* filename, int module);
+    bool LoadModuleCalibration(const char* filename, int module);
+    // Delta files hold only the sections that differ from a base file; a
+    // station that runs the base takes just the changed modules from one
+    bool SaveDeltaCalibration(const char* filename, const char* base_filename);
+    bool LoadDeltaCalibration(const char* base_filename, const char* delta_filename);
+    bool ApplyCalibrationDelta(const char* delta_filename);
 
     // Statistics and validation
+    bool GetCalibrationReport(HX::Internal::CalibrationReport& report);
+
+    // Linear ceiling of every pixel at the operating point of the last
+    // bright-field calibration (saturation_map.h); pixels whose gain came
+    // from elsewhere read as full range
+    size_t GetSaturationMapSize();
+    bool GetSaturationMap(uint8_t* map, size_t size);
+    // Pixels per code, 16 entries
+    bool GetSaturationCounts(uint64_t* counts);
     bool GetOffsetStatistics(float& mean, float& std_dev, float& min_val, float& max_val);
     bool GetGainStatistics(float& mean, float& std_dev, float& min_val, float& max_val);
     bool ValidateCalibrationData();
 
 private:
-    bool m_initialized;
-    int m_width;
-    int m_height;
+    std::atomic<bool> m_initialized;
+    std::atomic<int> m_width;
+    std::atomic<int> m_height;
     int m_bit_depth;
     unsigned short m_max_value;
 
@@ -77,17 +801,67 @@ private:
     unsigned short* m_offset_data;
     float* m_gain_data;
     unsigned short* m_baseline_data;
+    std::vector<uint8_t> m_saturation_map;
 
     // Correction flags
     bool m_enable_offset;
     bool m_enable_gain;
     bool m_enable_baseline;
     unsigned short m_target_baseline;
+    bool m_fixed_enabled;
+    bool m_compact_enabled;
+    int m_compact_max_error;
+    int m_module_pixels;
+    int m_calib_module;
+    int m_ref_lead;
+    int m_ref_trail;
+    uint32_t m_file_identity;           ///< CalibFile identity the maps equal, 0 once they change
+
+    // Maps, settings and streaming calibration, guarded by m_calib_mutex
+    std::mutex m_calib_mutex;
+    HX::Internal::WelfordAccumulator m_offset_acc;
+    HX::Internal::WelfordAccumulator m_baseline_acc;
+    HX::Internal::WelfordAccumulator m_gain_acc;
+    HX::Internal::MedianOfMeansAccumulator m_gain_robust;
+    int m_gain_groups;
+    std::vector<float> m_calib_frame;
+
+    // Published calibration, double-buffered like the background drift
+    HX::Internal::SnapshotSlot<OGCalibration> m_published;
+    uint64_t m_version;
+
+    // Tables and coefficients, for memory profiling
+    HX::Internal::MemCharge m_memory;
 
     // Helper methods
     void ClampValue(float& value);
     bool AllocateMemory();
     void FreeMemory();
+    bool Reset(int width, int height, int bit_depth);
+    std::shared_ptr<const OGCalibration> Acquire() const;
+    void Publish(const std::shared_ptr<const OGCalibration>& calibration);
+    void PublishMaps();
+    void PublishModule(int module);
+    void PublishScope();
+    void FoldPixel(size_t pixel, float* coeffs) const;
+    void BuildReferenceLevels(OGCalibration& calibration) const;
+    int ReferenceModule(int module_pixels) const { return module_pixels > 0 ? module_pixels : m_width.load(); }
+    bool CompactPixel(size_t pixel, double& gain, double& ref) const;
+    bool ModuleColumns(int module, int& x0, int& x1) const;
+    void ClearSaturation(int module);
+    template <typename Fn> void ForEachScopeSpan(Fn fn) const;
+    void BuildFixedCoefficients(OGCalibration& calibration);
+    void BuildCompactCoefficients(OGCalibration& calibration);
+    void UpdateMemoryCharge(const OGCalibration* calibration);
+    bool CalculateGainLocked(const unsigned short* bright_field_data,
+                             unsigned short target_value);
+    bool WriteCalibration(const char* filename, const char* base_filename);
+    bool LoadContainer(const HX::Internal::CalibFile& file);
+    bool LoadLegacyCalibration(const char* filename);
+    bool LoadModuleLayout(const HX::Internal::CalibFile& file,
+                          const int32_t* meta, const int32_t* layout);
+    bool FinalizeMean(HX::Internal::WelfordAccumulator& acc,
+                      unsigned short* target, float* noise);
 };
 
 // Constructor
@@ -104,6 +878,17 @@ XOGCorrect::XOGCorrect()
     , m_enable_gain(true)
     , m_enable_baseline(false)
     , m_target_baseline(0)
+    , m_fixed_enabled(true)
+    , m_compact_enabled(false)
+    , m_compact_max_error(2)
+    , m_module_pixels(0)
+    , m_calib_module(-1)
+    , m_ref_lead(0)
+    , m_ref_trail(0)
+    , m_file_identity(0)
+    , m_gain_groups(0)
+    , m_version(0)
+    , m_memory(HX::XFactory::MEM_CALIBRATION)
 {
 }
 
@@ -116,21 +901,41 @@ XOGCorrect::~XOGCorrect()
 // Initialize correction object
 bool XOGCorrect::Initialize(int width, int height, int bit_depth)
 {
-    if (width <= 0 || height <= 0 || bit_depth < 8 || bit_depth > 16) {
+    std::lock_guard<std::mutex> lock(m_calib_mutex);
+    if (!Reset(width, height, bit_depth)) {
         return false;
     }
+    PublishMaps();
+    return true;
+}
 
-    if (m_initialized) {
-        Release();
+// Allocate default maps for a new size; applies keep the published calibration
+bool XOGCorrect::Reset(int width, int height, int bit_depth)
+{
+    // Called with m_calib_mutex held
+    if (width <= 0 || height <= 0 || bit_depth < 8 || bit_depth > 16) {
+        return false;
     }
 
+    m_offset_acc.clear();
+    m_baseline_acc.clear();
+    m_gain_acc.clear();
+    m_gain_robust.clear();
+    FreeMemory();
+    m_initialized = false;
     m_width = width;
     m_height = height;
     m_bit_depth = bit_depth;
     m_max_value = (1 << bit_depth) - 1;
+    if (m_module_pixels > 0 && width % m_module_pixels != 0) {
+        m_module_pixels = 0;
+    }
+    m_calib_module = -1;
+    m_file_identity = 0;
 
     if (!AllocateMemory()) {
-        Release();
+        m_width = 0;
+        m_height = 0;
         return false;
     }
 
@@ -141,7 +946,14 @@ bool XOGCorrect::Initialize(int width, int height, int bit_depth)
 // Release resources
 bool XOGCorrect::Release()
 {
+    std::lock_guard<std::mutex> lock(m_calib_mutex);
+    m_offset_acc.clear();
+    m_baseline_acc.clear();
+    m_gain_acc.clear();
+    m_gain_robust.clear();
+    std::vector<float>().swap(m_calib_frame);
     FreeMemory();
+    Publish(std::shared_ptr<const OGCalibration>());
     m_initialized = false;
     m_width = 0;
     m_height = 0;
@@ -151,7 +963,7 @@ bool XOGCorrect::Release()
 // Allocate memory for calibration data
 bool XOGCorrect::AllocateMemory()
 {
-    const size_t total_pixels = m_width * m_height;
+    const size_t total_pixels = static_cast<size_t>(m_width) * m_height;
 
     try {
         m_offset_data = new unsigned short[total_pixels];
@@ -162,7 +974,7 @@ bool XOGCorrect::AllocateMemory()
         std::fill_n(m_offset_data, total_pixels, 0);
         std::fill_n(m_gain_data, total_pixels, 1.0f);
         std::fill_n(m_baseline_data, total_pixels, 0);
-
+        m_saturation_map.assign(HX::Internal::SaturationMapBytes(total_pixels), 0xFF);
         return true;
     } catch (const std::bad_alloc&) {
         FreeMemory();
@@ -173,6 +985,7 @@ bool XOGCorrect::AllocateMemory()
 // Free allocated memory
 void XOGCorrect::FreeMemory()
 {
+    std::vector<uint8_t>().swap(m_saturation_map);
     if (m_offset_data) {
         delete[] m_offset_data;
         m_offset_data = nullptr;
@@ -187,109 +1000,478 @@ void XOGCorrect::FreeMemory()
     }
 }
 
-// Set offset data
-bool XOGCorrect::SetOffsetData(const unsigned short* offset_data)
+void XOGCorrect::UpdateMemoryCharge(const OGCalibration* calibration)
 {
-    if (!m_initialized || !offset_data || !m_offset_data) {
-        return false;
+    const uint64_t pixels = m_offset_data ? static_cast<uint64_t>(m_width) * m_height : 0;
+    uint64_t bytes = pixels * (sizeof(unsigned short) * 2 + sizeof(float)) +
+                     HX::Internal::MemBytes(m_saturation_map);
+    if (calibration) {
+        bytes += HX::Internal::MemBytes(calibration->coeffs) + HX::Internal::MemBytes(calibration->fixed_coeffs) +
+                 HX::Internal::MemBytes(calibration->compact_coeffs);
     }
-
-    std::memcpy(m_offset_data, offset_data, m_width * m_height * sizeof(unsigned short));
-    return true;
+    m_memory.set(bytes);
 }
 
-// Set gain data
-bool XOGCorrect::SetGainData(const float* gain_data)
+// Copy the pointer in the active slot
+std::shared_ptr<const OGCalibration> XOGCorrect::Acquire() const
 {
-    if (!m_initialized || !gain_data || !m_gain_data) {
-        return false;
-    }
-
-    std::memcpy(m_gain_data, gain_data, m_width * m_height * sizeof(float));
-    return true;
+    return m_published.acquire();
 }
 
-// Set baseline data
-bool XOGCorrect::SetBaselineData(const unsigned short* baseline_data)
+// Make a calibration current; applies that already hold the old one finish with it
+void XOGCorrect::Publish(const std::shared_ptr<const OGCalibration>& calibration)
 {
-    if (!m_initialized || !baseline_data || !m_baseline_data) {
-        return false;
-    }
-
-    std::memcpy(m_baseline_data, baseline_data, m_width * m_height * sizeof(unsigned short));
-    return true;
+    // Called with m_calib_mutex held
+    m_published.publish(calibration);
+    UpdateMemoryCharge(calibration.get());
 }
 
-// Calculate offset from multiple dark frames (typically 4096 lines)
-bool XOGCorrect::CalculateOffset(const unsigned short** line_data, int num_lines)
+// Fold offset, gain, baseline and target into one {gain, bias} pair per pixel
+void XOGCorrect::PublishMaps()
 {
-    if (!m_initialized || !line_data || num_lines <= 0) {
-        return false;
+    // Called with m_calib_mutex held
+    if (!m_initialized) {
+        return;
     }
 
-    const int total_pixels = m_width * m_height;
-
-    // Accumulate line data
-    std::vector<unsigned long long> accumulator(total_pixels, 0);
+    std::shared_ptr<OGCalibration> calibration = std::make_shared<OGCalibration>();
+    calibration->version = ++m_version;
+    calibration->width = m_width;
+    calibration->height = m_height;
+    calibration->max_value = m_max_value;
 
-    for (int line = 0; line < num_lines; ++line) {
-        if (!line_data[line]) {
-            return false;
-        }
+    const size_t total_pixels = static_cast<size_t>(m_width) * m_height;
+    const size_t blocks = (total_pixels + COEFF_BLOCK - 1) / COEFF_BLOCK;
+    calibration->coeffs.assign(blocks * 2 * COEFF_BLOCK, 0.0f);
 
-        for (int i = 0; i < total_pixels; ++i) {
-            accumulator[i] += line_data[line][i];
-        }
+    for (size_t i = 0; i < total_pixels; ++i) {
+        FoldPixel(i, &calibration->coeffs[CoeffIndex(i)]);
     }
 
-    // Calculate average and store as offset
-    for (int i = 0; i < total_pixels; ++i) {
-        m_offset_data[i] = static_cast<unsigned short>(
-            (accumulator[i] + num_lines / 2) / num_lines
-        );
+    BuildCompactCoefficients(*calibration);
+    if (calibration->compact_active) {
+        std::vector<float>().swap(calibration->coeffs);
+    } else {
+        BuildFixedCoefficients(*calibration);
     }
-
-    return true;
+    BuildReferenceLevels(*calibration);
+    Publish(calibration);
 }
 
-// Calculate gain coefficients from bright field data
-bool XOGCorrect::CalculateGain(const unsigned short* bright_field_data,
-                              unsigned short target_value)
+// Mean offset of each module's reference pixels, per calibration row
+void XOGCorrect::BuildReferenceLevels(OGCalibration& calibration) const
 {
-    if (!m_initialized || !bright_field_data || target_value == 0) {
-        return false;
+    // Called with m_calib_mutex held
+    const int module = ReferenceModule(m_module_pixels);
+    const int count = m_ref_lead + m_ref_trail;
+    calibration.ref_module = module;
+    calibration.ref_lead = m_ref_lead;
+    calibration.ref_trail = m_ref_trail;
+    calibration.ref_levels.clear();
+    if (count == 0 || count >= module) {
+        return;
     }
 
-    const int total_pixels = m_width * m_height;
+    const int modules = m_width / module;
+    calibration.ref_levels.assign(static_cast<size_t>(m_height) * modules, 0.0f);
+    if (!m_enable_offset) {
+        // Without an offset map the reference pixels are the whole offset
+        return;
+    }
+    for (int row = 0; row < m_height; ++row) {
+        const unsigned short* offset = m_offset_data + static_cast<size_t>(row) * m_width;
+        for (int m = 0; m < modules; ++m) {
+            const int x0 = m * module;
+            const int x1 = x0 + module;
+            uint32_t sum = 0;
+            for (int x = x0; x < x0 + m_ref_lead; ++x) {
+                sum += offset[x];
+            }
+            for (int x = x1 - m_ref_trail; x < x1; ++x) {
+                sum += offset[x];
+            }
+            calibration.ref_levels[static_cast<size_t>(row) * modules + m] = static_cast<float>(sum) / count;
+        }
+    }
+}
 
-    for (int i = 0; i < total_pixels; ++i) {
-        // Subtract offset first
-        int corrected = static_cast<int>(bright_field_data[i]) - 
-                       static_cast<int>(m_offset_data[i]);
+// (in - off) * g - base + target  ==  in * g + (target - base - off * g)
+void XOGCorrect::FoldPixel(size_t pixel, float* coeffs) const
+{
+    float gain = m_enable_gain ? m_gain_data[pixel] : 1.0f;
+    float bias = static_cast<float>(m_target_baseline);
+    if (m_enable_offset) bias -= static_cast<float>(m_offset_data[pixel]) * gain;
+    if (m_enable_baseline) bias -= static_cast<float>(m_baseline_data[pixel]);
+    coeffs[0] = gain;
+    coeffs[COEFF_BLOCK] = bias;
+}
+
+// Republish with only one module's coefficients rebuilt. The formats and
+// Q scales of the published calibration are kept; if the module's new
+// values do not fit them, everything is rebuilt instead.
+void XOGCorrect::PublishModule(int module)
+{
+    // Called with m_calib_mutex held
+    int x0 = 0;
+    int x1 = 0;
+    const std::shared_ptr<const OGCalibration> current = Acquire();
+    if (!m_initialized || !ModuleColumns(module, x0, x1) || !current ||
+        current->width != m_width || current->height != m_height ||
+        current->max_value != m_max_value ||
+        static_cast<float>(m_target_baseline) != current->target) {
+        PublishMaps();
+        return;
+    }
 
-        if (corrected > 0) {
-            m_gain_data[i] = static_cast<float>(target_value) / 
-                            static_cast<float>(corrected);
-        } else {
-            m_gain_data[i] = 1.0f;
+    // Unchanged modules are copied, not recomputed
+    std::shared_ptr<OGCalibration> calibration = std::make_shared<OGCalibration>(*current);
+    const double max_value = calibration->max_value;
+    const double gain_scale = static_cast<double>(1 << calibration->compact_gain_bits);
+    const double ref_scale = static_cast<double>(1 << calibration->compact_ref_bits);
+    const double fixed_scale = static_cast<double>(1 << calibration->fixed_bits);
+    const double fixed_half = calibration->fixed_bits > 0 ? fixed_scale / 2.0 : 0.0;
+    double worst = 0.0;
+
+    for (int row = 0; row < m_height; ++row) {
+        for (int col = x0; col < x1; ++col) {
+            const size_t i = static_cast<size_t>(row) * m_width + col;
+            const size_t k = CoeffIndex(i);
+
+            if (calibration->compact_active) {
+                double gain = 0.0;
+                double ref = 0.0;
+                if (!CompactPixel(i, gain, ref) ||
+                    std::floor(gain * gain_scale + 0.5) > 65535.0 ||
+                    std::floor(ref * ref_scale + 0.5) > 65535.0) {
+                    PublishMaps();
+                    return;
+                }
+                const uint16_t gain_q = static_cast<uint16_t>(std::floor(gain * gain_scale + 0.5));
+                const uint16_t ref_q = static_cast<uint16_t>(std::floor(ref * ref_scale + 0.5));
+                const double stored = ref_q / ref_scale;
+                const double span = std::max(stored, max_value - stored);
+                worst = std::max(worst, std::fabs(gain_q / gain_scale - gain) * span +
+                                        gain * std::fabs(stored - ref));
+                calibration->compact_coeffs[k] = gain_q;
+                calibration->compact_coeffs[k + COEFF_BLOCK] = ref_q;
+                continue;
+            }
+
+            float* c = &calibration->coeffs[k];
+            FoldPixel(i, c);
+            if (calibration->fixed_active) {
+                // Same overflow rule BuildFixedCoefficients chose the Q format by
+                if (!(std::fabs(c[0]) < 65536.0f) || !(std::fabs(c[COEFF_BLOCK]) < 16777216.0f) ||
+                    (std::fabs(static_cast<double>(c[0])) * max_value + std::fabs(c[COEFF_BLOCK]) + 1.0) *
+                        fixed_scale >= 2147483647.0) {
+                    PublishMaps();
+                    return;
+                }
+                calibration->fixed_coeffs[k] = static_cast<int32_t>(std::floor(c[0] * fixed_scale + 0.5));
+                calibration->fixed_coeffs[k + COEFF_BLOCK] =
+                    static_cast<int32_t>(std::floor(c[COEFF_BLOCK] * fixed_scale + 0.5 + fixed_half));
+            }
         }
+    }
 
-        // Clamp gain to reasonable range
-        if (m_gain_data[i] < 0.1f) m_gain_data[i] = 0.1f;
-        if (m_gain_data[i] > 10.0f) m_gain_data[i] = 10.0f;
+    if (calibration->compact_active) {
+        const int bound = static_cast<int>(std::floor(worst)) + 1;
+        if (bound > m_compact_max_error) {
+            PublishMaps();
+            return;
+        }
+        calibration->compact_error = std::max(calibration->compact_error, bound);
     }
 
-    return true;
+    BuildReferenceLevels(*calibration);
+    calibration->version = ++m_version;
+    Publish(calibration);
 }
 
-// Calculate baseline from multiple reference frames
-bool XOGCorrect::CalculateBaseline(const unsigned short** line_data, int num_lines)
+// Publish what the calibration calls of the current scope changed
+void XOGCorrect::PublishScope()
 {
-    if (!m_initialized || !line_data || num_lines <= 0) {
-        return false;
+    m_file_identity = 0;
+    if (m_calib_module >= 0) {
+        PublishModule(m_calib_module);
+    } else {
+        PublishMaps();
     }
+}
 
-    const int total_pixels = m_width * m_height;
+// Columns of a module; module -1 is the whole width
+bool XOGCorrect::ModuleColumns(int module, int& x0, int& x1) const
+{
+    if (module < 0) {
+        x0 = 0;
+        x1 = m_width;
+        return true;
+    }
+    if (m_module_pixels <= 0 || module >= GetModuleCount()) {
+        return false;
+    }
+    x0 = module * m_module_pixels;
+    x1 = x0 + m_module_pixels;
+    return true;
+}
+
+// Pixels given a gain other than by bright-field calibration read as full range
+void XOGCorrect::ClearSaturation(int module)
+{
+    // Called with m_calib_mutex held
+    int x0 = 0;
+    int x1 = 0;
+    if (m_saturation_map.empty() || !ModuleColumns(module, x0, x1)) {
+        return;
+    }
+    for (int row = 0; row < m_height; ++row) {
+        const size_t first = static_cast<size_t>(row) * m_width;
+        for (size_t i = first + x0; i < first + x1; ++i) {
+            HX::Internal::SetSaturationCode(m_saturation_map.data(), i, HX::Internal::SATURATION_FULL_RANGE);
+        }
+    }
+}
+
+// Call fn(first, end) for the pixel ranges the calibration scope covers
+template <typename Fn>
+void XOGCorrect::ForEachScopeSpan(Fn fn) const
+{
+    int x0 = 0;
+    int x1 = m_width;
+    ModuleColumns(m_calib_module, x0, x1);
+    if (x0 == 0 && x1 == m_width) {
+        fn(static_cast<size_t>(0), static_cast<size_t>(m_width) * m_height);
+        return;
+    }
+    for (int row = 0; row < m_height; ++row) {
+        const size_t first = static_cast<size_t>(row) * m_width;
+        fn(first + x0, first + x1);
+    }
+}
+
+int XOGCorrect::GetModuleCount() const
+{
+    return m_module_pixels > 0 ? m_width / m_module_pixels : 0;
+}
+
+// Split the width into modules of module_pixels columns
+bool XOGCorrect::SetModuleSegments(int module_pixels)
+{
+    std::lock_guard<std::mutex> lock(m_calib_mutex);
+    if (module_pixels < 0 || (module_pixels > 0 && (!m_initialized || m_width % module_pixels != 0))) {
+        return false;
+    }
+    if (m_ref_lead + m_ref_trail > 0 && m_ref_lead + m_ref_trail >= ReferenceModule(module_pixels)) {
+        return false;
+    }
+    if (module_pixels != m_module_pixels) {
+        m_file_identity = 0;
+    }
+    m_module_pixels = module_pixels;
+    m_calib_module = -1;
+    if (m_ref_lead + m_ref_trail > 0) {
+        // Reference levels are per module
+        PublishMaps();
+    }
+    return true;
+}
+
+// Track each line's dark level with the shielded pixels of its module
+bool XOGCorrect::SetDarkReference(int lead_pixels, int trail_pixels)
+{
+    std::lock_guard<std::mutex> lock(m_calib_mutex);
+    const int module = ReferenceModule(m_module_pixels);
+    if (!m_initialized || lead_pixels < 0 || trail_pixels < 0 || lead_pixels + trail_pixels >= module) {
+        return false;
+    }
+    m_ref_lead = lead_pixels;
+    m_ref_trail = trail_pixels;
+    PublishMaps();
+    return true;
+}
+
+// Limit map-writing calibration calls to one module
+bool XOGCorrect::SetCalibrationModule(int module)
+{
+    std::lock_guard<std::mutex> lock(m_calib_mutex);
+    int x0 = 0;
+    int x1 = 0;
+    if (!m_initialized || !ModuleColumns(module, x0, x1)) {
+        return false;
+    }
+    m_calib_module = module < 0 ? -1 : module;
+    return true;
+}
+
+// Replace the maps of one module and republish just its coefficients
+bool XOGCorrect::SetModuleData(int module, const unsigned short* offset_data,
+                               const float* gain_data, const unsigned short* baseline_data)
+{
+    std::lock_guard<std::mutex> lock(m_calib_mutex);
+    int x0 = 0;
+    int x1 = 0;
+    if (!m_initialized || module < 0 || !ModuleColumns(module, x0, x1)) {
+        return false;
+    }
+
+    if (offset_data) {
+        ScatterModule(offset_data, m_width, m_height, x0, m_module_pixels, m_offset_data);
+    }
+    if (gain_data) {
+        ScatterModule(gain_data, m_width, m_height, x0, m_module_pixels, m_gain_data);
+        ClearSaturation(module);
+    }
+    if (baseline_data) {
+        ScatterModule(baseline_data, m_width, m_height, x0, m_module_pixels, m_baseline_data);
+    }
+    m_file_identity = 0;
+    PublishModule(module);
+    return true;
+}
+
+// Set offset data
+bool XOGCorrect::SetOffsetData(const unsigned short* offset_data)
+{
+    std::lock_guard<std::mutex> lock(m_calib_mutex);
+    if (!m_initialized || !offset_data || !m_offset_data) {
+        return false;
+    }
+
+    std::memcpy(m_offset_data, offset_data, static_cast<size_t>(m_width) * m_height * sizeof(unsigned short));
+    m_file_identity = 0;
+    PublishMaps();
+    return true;
+}
+
+// Set gain data
+bool XOGCorrect::SetGainData(const float* gain_data)
+{
+    std::lock_guard<std::mutex> lock(m_calib_mutex);
+    if (!m_initialized || !gain_data || !m_gain_data) {
+        return false;
+    }
+
+    std::memcpy(m_gain_data, gain_data, static_cast<size_t>(m_width) * m_height * sizeof(float));
+    ClearSaturation(-1);
+    m_file_identity = 0;
+    PublishMaps();
+    return true;
+}
+
+// Set baseline data
+bool XOGCorrect::SetBaselineData(const unsigned short* baseline_data)
+{
+    std::lock_guard<std::mutex> lock(m_calib_mutex);
+    if (!m_initialized || !baseline_data || !m_baseline_data) {
+        return false;
+    }
+
+    std::memcpy(m_baseline_data, baseline_data, static_cast<size_t>(m_width) * m_height * sizeof(unsigned short));
+    m_file_identity = 0;
+    PublishMaps();
+    return true;
+}
+
+// Calculate offset from multiple dark frames (typically 4096 lines)
+bool XOGCorrect::CalculateOffset(const unsigned short** line_data, int num_lines)
+{
+    std::lock_guard<std::mutex> lock(m_calib_mutex);
+    if (!m_initialized || !line_data || num_lines <= 0) {
+        return false;
+    }
+
+    const int total_pixels = m_width * m_height;
+
+    // Accumulate line data
+    std::vector<unsigned long long> accumulator(total_pixels, 0);
+
+    for (int line = 0; line < num_lines; ++line) {
+        if (!line_data[line]) {
+            return false;
+        }
+
+        for (int i = 0; i < total_pixels; ++i) {
+            accumulator[i] += line_data[line][i];
+        }
+    }
+
+    // Calculate average and store as offset
+    ForEachScopeSpan([&](size_t first, size_t end) {
+        for (size_t i = first; i < end; ++i) {
+            m_offset_data[i] = static_cast<unsigned short>(
+                (accumulator[i] + num_lines / 2) / num_lines
+            );
+        }
+    });
+
+    PublishScope();
+    return true;
+}
+
+// Calculate gain coefficients from bright field data
+bool XOGCorrect::CalculateGain(const unsigned short* bright_field_data,
+                              unsigned short target_value)
+{
+    std::lock_guard<std::mutex> lock(m_calib_mutex);
+    return CalculateGainLocked(bright_field_data, target_value);
+}
+
+bool XOGCorrect::CalculateGainLocked(const unsigned short* bright_field_data,
+                                     unsigned short target_value)
+{
+    if (!m_initialized || !bright_field_data || target_value == 0) {
+        return false;
+    }
+
+    const double full_scale = m_max_value;
+    uint8_t* saturation = m_saturation_map.data();
+    ForEachScopeSpan([&](size_t first, size_t end) {
+        for (size_t i = first; i < end; ++i) {
+            // Subtract offset first
+            int corrected = static_cast<int>(bright_field_data[i]) - 
+                           static_cast<int>(m_offset_data[i]);
+
+            if (corrected > 0) {
+                m_gain_data[i] = static_cast<float>(target_value) / 
+                                static_cast<float>(corrected);
+            } else {
+                m_gain_data[i] = 1.0f;
+            }
+
+            // Clamp gain to reasonable range
+            const bool clamped = m_gain_data[i] < 0.1f || m_gain_data[i] > 10.0f;
+            if (m_gain_data[i] < 0.1f) m_gain_data[i] = 0.1f;
+            if (m_gain_data[i] > 10.0f) m_gain_data[i] = 10.0f;
+
+            // Linear up to where the ADC saturates or the folded output
+            // in * g + bias reaches full scale, whichever comes first
+            int code = 0;
+            if (corrected > 0 && !clamped &&
+                !HX::Internal::IsSaturatedLevel(bright_field_data[i], full_scale)) {
+                const double gain = m_enable_gain ? m_gain_data[i] : 1.0;
+                double bias = m_target_baseline;
+                if (m_enable_offset) bias -= m_offset_data[i] * gain;
+                if (m_enable_baseline) bias -= m_baseline_data[i];
+                code = HX::Internal::SaturationCode(std::min(full_scale, (full_scale - bias) / gain),
+                                                    full_scale);
+            }
+            HX::Internal::SetSaturationCode(saturation, i, code);
+        }
+    });
+
+    PublishScope();
+    return true;
+}
+
+// Calculate baseline from multiple reference frames
+bool XOGCorrect::CalculateBaseline(const unsigned short** line_data, int num_lines)
+{
+    std::lock_guard<std::mutex> lock(m_calib_mutex);
+    if (!m_initialized || !line_data || num_lines <= 0) {
+        return false;
+    }
+
+    const int total_pixels = m_width * m_height;
 
     // Accumulate corrected line data
     std::vector<unsigned long long> accumulator(total_pixels, 0);
@@ -312,290 +1494,1123 @@ bool XOGCorrect::CalculateBaseline(const unsigned short** line_data, int num_lin
         }
     }
 
-    // Calculate average baseline
-    for (int i = 0; i < total_pixels; ++i) {
-        m_baseline_data[i] = static_cast<unsigned short>(
-            (accumulator[i] + num_lines / 2) / num_lines
-        );
+    // Calculate average baseline
+    ForEachScopeSpan([&](size_t first, size_t end) {
+        for (size_t i = first; i < end; ++i) {
+            m_baseline_data[i] = static_cast<unsigned short>(
+                (accumulator[i] + num_lines / 2) / num_lines
+            );
+        }
+    });
+
+    PublishScope();
+    return true;
+}
+
+// Add one dark frame to the running offset mean
+bool XOGCorrect::AddOffsetFrame(const unsigned short* frame)
+{
+    std::lock_guard<std::mutex> lock(m_calib_mutex);
+    if (!m_initialized || !frame) {
+        return false;
+    }
+
+    const size_t total_pixels = static_cast<size_t>(m_width) * m_height;
+    if (m_offset_acc.pixels() != total_pixels) {
+        m_offset_acc.reset(total_pixels);
+    }
+    m_offset_acc.add(frame);
+    return true;
+}
+
+// Store the running offset mean and start over
+bool XOGCorrect::FinalizeOffset(float* noise)
+{
+    std::lock_guard<std::mutex> lock(m_calib_mutex);
+    return FinalizeMean(m_offset_acc, m_offset_data, noise);
+}
+
+// Add one reference frame, corrected with the current offset and gain
+bool XOGCorrect::AddBaselineFrame(const unsigned short* frame)
+{
+    std::lock_guard<std::mutex> lock(m_calib_mutex);
+    if (!m_initialized || !frame) {
+        return false;
+    }
+
+    const int total_pixels = m_width * m_height;
+    if (m_baseline_acc.pixels() != static_cast<size_t>(total_pixels)) {
+        m_baseline_acc.reset(total_pixels);
+    }
+    m_calib_frame.resize(total_pixels);
+
+    // Same per-frame rounding as CalculateBaseline
+    for (int i = 0; i < total_pixels; ++i) {
+        int corrected = static_cast<int>(frame[i]) -
+                       static_cast<int>(m_offset_data[i]);
+        float gained = corrected * m_gain_data[i];
+
+        if (gained < 0.0f) gained = 0.0f;
+        if (gained > m_max_value) gained = m_max_value;
+
+        m_calib_frame[i] = std::floor(gained + 0.5f);
+    }
+    m_baseline_acc.add(m_calib_frame.data());
+    return true;
+}
+
+// Store the running baseline mean and start over
+bool XOGCorrect::FinalizeBaseline(float* noise)
+{
+    std::lock_guard<std::mutex> lock(m_calib_mutex);
+    return FinalizeMean(m_baseline_acc, m_baseline_data, noise);
+}
+
+// Add one bright (flat-field) frame to the running bright mean
+bool XOGCorrect::AddGainFrame(const unsigned short* frame)
+{
+    std::lock_guard<std::mutex> lock(m_calib_mutex);
+    if (!m_initialized || !frame) {
+        return false;
+    }
+
+    const size_t total_pixels = static_cast<size_t>(m_width) * m_height;
+    if (m_gain_groups >= 2) {
+        if (m_gain_robust.pixels() != total_pixels || m_gain_robust.groups() != m_gain_groups) {
+            m_gain_robust.reset(total_pixels, m_gain_groups);
+        }
+        return m_gain_robust.add(frame);
+    }
+    if (m_gain_acc.pixels() != total_pixels) {
+        m_gain_acc.reset(total_pixels);
+    }
+    m_gain_acc.add(frame);
+    return true;
+}
+
+// Gain from the running bright mean, as CalculateGain does from one frame
+bool XOGCorrect::FinalizeGain(unsigned short target_value)
+{
+    std::lock_guard<std::mutex> lock(m_calib_mutex);
+    if (target_value == 0) {
+        return false;
+    }
+    if (m_gain_groups >= 2) {
+        if (!m_initialized || m_gain_robust.count() == 0 ||
+            m_gain_robust.pixels() != static_cast<size_t>(m_width) * m_height) {
+            return false;
+        }
+        std::vector<unsigned short> bright(m_gain_robust.pixels());
+        m_gain_robust.estimates(bright.data());
+        m_gain_robust.clear();
+        return CalculateGainLocked(bright.data(), target_value);
+    }
+    std::vector<unsigned short> bright(m_gain_acc.pixels());
+    if (bright.empty() || !FinalizeMean(m_gain_acc, bright.data(), nullptr)) {
+        return false;
+    }
+    return CalculateGainLocked(bright.data(), target_value);
+}
+
+// Frames pushed since the last finalize
+int XOGCorrect::GetOffsetFrameCount()
+{
+    std::lock_guard<std::mutex> lock(m_calib_mutex);
+    return static_cast<int>(m_offset_acc.count());
+}
+
+int XOGCorrect::GetBaselineFrameCount()
+{
+    std::lock_guard<std::mutex> lock(m_calib_mutex);
+    return static_cast<int>(m_baseline_acc.count());
+}
+
+int XOGCorrect::GetGainFrameCount()
+{
+    std::lock_guard<std::mutex> lock(m_calib_mutex);
+    return static_cast<int>(m_gain_groups >= 2 ? m_gain_robust.count() : m_gain_acc.count());
+}
+
+// Drop frames pushed since the last finalize; the maps are kept
+void XOGCorrect::DiscardCalibrationFrames()
+{
+    std::lock_guard<std::mutex> lock(m_calib_mutex);
+    m_offset_acc.clear();
+    m_baseline_acc.clear();
+    m_gain_acc.clear();
+    m_gain_robust.clear();
+}
+
+// Median-of-means bright averaging over the given number of groups
+void XOGCorrect::SetRobustGain(int groups)
+{
+    std::lock_guard<std::mutex> lock(m_calib_mutex);
+    const int max_groups = HX::Internal::MedianOfMeansAccumulator::MAX_GROUPS;
+    m_gain_groups = groups >= 2 ? std::min(groups, max_groups) : 0;
+    m_gain_acc.clear();
+    m_gain_robust.clear();
+}
+
+// Round an accumulated mean into a calibration map, optionally with the
+// per-pixel temporal noise (sample standard deviation)
+bool XOGCorrect::FinalizeMean(HX::Internal::WelfordAccumulator& acc,
+                              unsigned short* target, float* noise)
+{
+    if (!m_initialized || !target || acc.count() == 0 ||
+        acc.pixels() != static_cast<size_t>(m_width) * m_height) {
+        return false;
+    }
+
+    // Outside the calibration scope target and noise are left as they are
+    ForEachScopeSpan([&](size_t first, size_t end) {
+        for (size_t i = first; i < end; ++i) {
+            double value = std::floor(acc.mean(i) + 0.5);
+            if (value < 0.0) value = 0.0;
+            if (value > 65535.0) value = 65535.0;
+            target[i] = static_cast<unsigned short>(value);
+            if (noise) {
+                noise[i] = static_cast<float>(std::sqrt(acc.variance(i)));
+            }
+        }
+    });
+
+    acc.clear();
+    PublishScope();
+    return true;
+}
+
+// Apply full correction to frame
+bool XOGCorrect::ApplyCorrection(const unsigned short* input_data,
+                                unsigned short* output_data)
+{
+    if (!input_data || !output_data) {
+        return false;
+    }
+
+    // Kept for the whole frame, whatever is published meanwhile
+    const std::shared_ptr<const OGCalibration> calibration = Acquire();
+    if (!calibration) {
+        return false;
+    }
+    const OGCalibration& calib = *calibration;
+
+    // Row bands across the shared pool; each band is an independent run,
+    // or a run per row when the dark reference is taken off first
+    const int width = calib.width;
+    const bool perRow = !calib.ref_levels.empty();
+    if (calib.compact_active) {
+        const OGCompactKernel kernel = SelectCompactKernel();
+        HX::Internal::ThreadPool::instance().parallelRows(calib.height, width, [&](int first, int end) {
+            for (int row = first; row < end; row = perRow ? row + 1 : end) {
+                const size_t pixel = static_cast<size_t>(row) * width;
+                const unsigned short* in = SubtractReferenceDrift(calib, input_data + pixel, output_data + pixel, row);
+                OGCompactRun run = { in, output_data + pixel, calib.compact_coeffs.data(), pixel,
+                                     ((perRow ? row + 1 : end) - row) * width, calib.compact_ref_bits,
+                                     calib.compact_step, calib.target, static_cast<float>(calib.max_value) };
+                kernel(run);
+            }
+        });
+        return true;
+    }
+    if (calib.fixed_active) {
+        const OGFixedKernel kernel = SelectFixedKernel();
+        HX::Internal::ThreadPool::instance().parallelRows(calib.height, width, [&](int first, int end) {
+            for (int row = first; row < end; row = perRow ? row + 1 : end) {
+                const size_t pixel = static_cast<size_t>(row) * width;
+                const unsigned short* in = SubtractReferenceDrift(calib, input_data + pixel, output_data + pixel, row);
+                OGFixedRun run = { in, output_data + pixel, calib.fixed_coeffs.data(), pixel,
+                                   ((perRow ? row + 1 : end) - row) * width, calib.fixed_bits, calib.max_value };
+                kernel(run);
+            }
+        });
+        return true;
+    }
+
+    const OGKernel kernel = SelectKernel();
+    HX::Internal::ThreadPool::instance().parallelRows(calib.height, width, [&](int first, int end) {
+        for (int row = first; row < end; row = perRow ? row + 1 : end) {
+            const size_t pixel = static_cast<size_t>(row) * width;
+            const unsigned short* in = SubtractReferenceDrift(calib, input_data + pixel, output_data + pixel, row);
+            OGRun run = { in, output_data + pixel, calib.coeffs.data(), pixel,
+                          ((perRow ? row + 1 : end) - row) * width, static_cast<float>(calib.max_value) };
+            kernel(run);
+        }
+    });
+
+    return true;
+}
+
+// Apply correction to single line (for line-scan mode)
+bool XOGCorrect::ApplyCorrectionLine(const unsigned short* input_line,
+                                    unsigned short* output_line,
+                                    int line_index)
+{
+    if (!input_line || !output_line) {
+        return false;
+    }
+
+    const std::shared_ptr<const OGCalibration> calibration = Acquire();
+    if (!calibration) {
+        return false;
+    }
+    const OGCalibration& calib = *calibration;
+
+    if (line_index < 0 || line_index >= calib.height) {
+        line_index = 0;
+    }
+
+    const int line_offset = line_index * calib.width;
+    input_line = SubtractReferenceDrift(calib, input_line, output_line, line_index);
+
+    if (calib.compact_active) {
+        OGCompactRun run = { input_line, output_line, calib.compact_coeffs.data(),
+                             static_cast<size_t>(line_offset), calib.width, calib.compact_ref_bits,
+                             calib.compact_step, calib.target, static_cast<float>(calib.max_value) };
+        SelectCompactKernel()(run);
+        return true;
+    }
+    if (calib.fixed_active) {
+        OGFixedRun run = { input_line, output_line, calib.fixed_coeffs.data(),
+                           static_cast<size_t>(line_offset), calib.width, calib.fixed_bits, calib.max_value };
+        SelectFixedKernel()(run);
+        return true;
+    }
+
+    OGRun run = { input_line, output_line, calib.coeffs.data(),
+                  static_cast<size_t>(line_offset), calib.width, static_cast<float>(calib.max_value) };
+    SelectKernel()(run);
+
+    return true;
+}
+
+// Correct frame row @p row with calibration row row % height
+bool XOGCorrect::ApplyCorrectionRow(const unsigned short* input_line,
+                                    unsigned short* output_line,
+                                    int width, uint32_t row)
+{
+    const std::shared_ptr<const OGCalibration> calibration = Acquire();
+    if (!calibration || calibration->width != width || !input_line || !output_line) {
+        return false;
+    }
+    const OGCalibration& calib = *calibration;
+    const int calib_row = static_cast<int>(row % static_cast<uint32_t>(calib.height));
+    const size_t line_offset = static_cast<size_t>(calib_row) * calib.width;
+    // Folded into the same pass over the line, while it is still in cache
+    input_line = SubtractReferenceDrift(calib, input_line, output_line, calib_row);
+
+    if (calib.compact_active) {
+        OGCompactRun run = { input_line, output_line, calib.compact_coeffs.data(), line_offset,
+                             calib.width, calib.compact_ref_bits, calib.compact_step,
+                             calib.target, static_cast<float>(calib.max_value) };
+        SelectCompactKernel()(run);
+        return true;
+    }
+    if (calib.fixed_active) {
+        OGFixedRun run = { input_line, output_line, calib.fixed_coeffs.data(),
+                           line_offset, calib.width, calib.fixed_bits, calib.max_value };
+        SelectFixedKernel()(run);
+        return true;
+    }
+
+    OGRun run = { input_line, output_line, calib.coeffs.data(),
+                  line_offset, calib.width, static_cast<float>(calib.max_value) };
+    SelectKernel()(run);
+    return true;
+}
+
+uint64_t XOGCorrect::GetCalibrationVersion() const
+{
+    const std::shared_ptr<const OGCalibration> calibration = Acquire();
+    return calibration ? calibration->version : 0;
+}
+
+// Set correction mode flags
+void XOGCorrect::SetCorrectionMode(bool enable_offset, bool enable_gain, bool enable_baseline)
+{
+    std::lock_guard<std::mutex> lock(m_calib_mutex);
+    m_enable_offset = enable_offset;
+    m_enable_gain = enable_gain;
+    m_enable_baseline = enable_baseline;
+    PublishMaps();
+}
+
+// Set target baseline added after correction
+void XOGCorrect::SetTargetBaseline(unsigned short baseline)
+{
+    std::lock_guard<std::mutex> lock(m_calib_mutex);
+    m_target_baseline = baseline;
+    PublishMaps();
+}
+
+// Set bit depth
+void XOGCorrect::SetBitDepth(int bit_depth)
+{
+    std::lock_guard<std::mutex> lock(m_calib_mutex);
+    if (bit_depth >= 8 && bit_depth <= 16) {
+        m_bit_depth = bit_depth;
+        m_max_value = (1 << bit_depth) - 1;
+        PublishMaps();
+    }
+}
+
+// Enable or disable the fixed-point path
+void XOGCorrect::SetFixedPoint(bool enable)
+{
+    std::lock_guard<std::mutex> lock(m_calib_mutex);
+    m_fixed_enabled = enable;
+    PublishMaps();
+}
+
+// True if applies run the fixed-point kernels
+bool XOGCorrect::IsFixedPointActive()
+{
+    const std::shared_ptr<const OGCalibration> calibration = Acquire();
+    return calibration && calibration->fixed_active;
+}
+
+// Largest difference from the float path, in output counts
+int XOGCorrect::GetFixedPointErrorBound()
+{
+    const std::shared_ptr<const OGCalibration> calibration = Acquire();
+    if (!calibration || !calibration->fixed_active) {
+        return 0;
+    }
+
+    // Gain and bias are each rounded to half a Q step, so the value before
+    // rounding moves by at most (max + 1) / 2^(bits + 1); rounding then
+    // adds at most one count
+    const double drift = (calibration->max_value + 1.0) /
+                         static_cast<double>(1 << (calibration->fixed_bits + 1));
+    return static_cast<int>(std::floor(drift)) + 1;
+}
+
+// Enable or disable 16-bit coefficients
+void XOGCorrect::SetCompactCoefficients(bool enable, int max_error)
+{
+    std::lock_guard<std::mutex> lock(m_calib_mutex);
+    m_compact_enabled = enable;
+    m_compact_max_error = std::max(1, max_error);
+    PublishMaps();
+}
+
+// True if applies run the 16-bit coefficient kernels
+bool XOGCorrect::IsCompactActive()
+{
+    const std::shared_ptr<const OGCalibration> calibration = Acquire();
+    return calibration && calibration->compact_active;
+}
+
+// Largest difference from the float path, in output counts
+int XOGCorrect::GetCompactErrorBound()
+{
+    const std::shared_ptr<const OGCalibration> calibration = Acquire();
+    return calibration && calibration->compact_active ? calibration->compact_error : 0;
+}
+
+int XOGCorrect::GetErrorBound()
+{
+    if (IsCompactActive()) {
+        return GetCompactErrorBound();
+    }
+    return GetFixedPointErrorBound();
+}
+
+// Store each pixel as a Q-format gain and reference level, if the error
+// bound of the finest formats that fit is within m_compact_max_error
+void XOGCorrect::BuildCompactCoefficients(OGCalibration& calibration)
+{
+    calibration.compact_active = false;
+    calibration.compact_gain_bits = 0;
+    calibration.compact_ref_bits = 0;
+    calibration.compact_step = 0.0f;
+    calibration.compact_error = 0;
+    calibration.target = static_cast<float>(m_target_baseline);
+
+    if (!m_compact_enabled) {
+        return;
+    }
+
+    const size_t total_pixels = static_cast<size_t>(calibration.width) * calibration.height;
+    std::vector<double> refs(total_pixels);
+    double max_gain = 0.0;
+    double max_ref = 0.0;
+    for (size_t i = 0; i < total_pixels; ++i) {
+        double gain = 0.0;
+        double ref = 0.0;
+        if (!CompactPixel(i, gain, ref)) {
+            return;
+        }
+        refs[i] = ref;
+        max_gain = std::max(max_gain, gain);
+        max_ref = std::max(max_ref, ref);
+    }
+
+    int gain_bits = 16;
+    while (gain_bits > 0 && std::floor(max_gain * (1 << gain_bits) + 0.5) > 65535.0) {
+        --gain_bits;
+    }
+    int ref_bits = MAX_COMPACT_REF_BITS;
+    while (ref_bits > 0 && std::floor(max_ref * (1 << ref_bits) + 0.5) > 65535.0) {
+        --ref_bits;
+    }
+
+    // Gain rounding moves the result by |dg| * |in - ref| with in in
+    // [0, max], reference rounding by g * |dref|; rounding the result
+    // then adds at most one count
+    const double gain_scale = static_cast<double>(1 << gain_bits);
+    const double ref_scale = static_cast<double>(1 << ref_bits);
+    const double max_value = calibration.max_value;
+    std::vector<uint16_t>& coeffs = calibration.compact_coeffs;
+    coeffs.assign((total_pixels + COEFF_BLOCK - 1) / COEFF_BLOCK * 2 * COEFF_BLOCK, 0);
+    double worst = 0.0;
+    for (size_t i = 0; i < total_pixels; ++i) {
+        const double gain = m_enable_gain ? m_gain_data[i] : 1.0;
+        const uint16_t gain_q = static_cast<uint16_t>(std::floor(gain * gain_scale + 0.5));
+        const uint16_t ref_q = static_cast<uint16_t>(std::floor(refs[i] * ref_scale + 0.5));
+        const double ref = ref_q / ref_scale;
+        const double span = std::max(ref, max_value - ref);
+        worst = std::max(worst, std::fabs(gain_q / gain_scale - gain) * span +
+                                gain * std::fabs(ref - refs[i]));
+
+        const size_t k = CoeffIndex(i);
+        coeffs[k] = gain_q;
+        coeffs[k + COEFF_BLOCK] = ref_q;
+    }
+
+    const int bound = static_cast<int>(std::floor(worst)) + 1;
+    if (bound > m_compact_max_error) {
+        std::vector<uint16_t>().swap(coeffs);
+        return;
+    }
+
+    calibration.compact_gain_bits = gain_bits;
+    calibration.compact_ref_bits = ref_bits;
+    calibration.compact_step = static_cast<float>(1.0 / (gain_scale * ref_scale));
+    calibration.compact_error = bound;
+    calibration.compact_active = true;
+}
+
+// (in - off) * g - base + target  ==  (in - ref) * g + target,
+// ref = off + base / g; false if the pixel has no 16-bit form
+bool XOGCorrect::CompactPixel(size_t pixel, double& gain, double& ref) const
+{
+    gain = m_enable_gain ? m_gain_data[pixel] : 1.0;
+    ref = m_enable_offset ? m_offset_data[pixel] : 0.0;
+    if (!(gain >= 0.0 && gain < 65536.0)) {
+        return false;   // Negative, NaN or out of range
+    }
+    if (m_enable_baseline && m_baseline_data[pixel] != 0) {
+        if (gain == 0.0) {
+            return false;
+        }
+        ref += m_baseline_data[pixel] / gain;
+    }
+    return ref <= 65535.0;
+}
+
+// Quantize the float coefficients to the finest Q format that cannot overflow
+void XOGCorrect::BuildFixedCoefficients(OGCalibration& calibration)
+{
+    calibration.fixed_active = false;
+    calibration.fixed_bits = 0;
+
+    if (!m_fixed_enabled || m_bit_depth > 16) {
+        return;
+    }
+
+    // Inputs are clamped to max_value, so |in * gain + bias| <= worst
+    const std::vector<float>& coeffs = calibration.coeffs;
+    const size_t total_pixels = static_cast<size_t>(calibration.width) * calibration.height;
+    double worst = 0.0;
+    for (size_t i = 0; i < total_pixels; ++i) {
+        const float* c = &coeffs[CoeffIndex(i)];
+        if (!(std::fabs(c[0]) < 65536.0f) || !(std::fabs(c[COEFF_BLOCK]) < 16777216.0f)) {
+            return;     // NaN, inf or far out of range
+        }
+        double v = std::fabs(static_cast<double>(c[0])) * calibration.max_value + std::fabs(c[COEFF_BLOCK]) + 1.0;
+        worst = std::max(worst, v);
+    }
+
+    int bits = MAX_FIXED_BITS;
+    while (bits >= MIN_FIXED_BITS && worst * (1 << bits) >= 2147483647.0) {
+        --bits;
+    }
+    if (bits < MIN_FIXED_BITS) {
+        return;
+    }
+
+    const double scale = static_cast<double>(1 << bits);
+    const double half = static_cast<double>(1 << (bits - 1));
+    calibration.fixed_coeffs.assign(coeffs.size(), 0);
+    for (size_t i = 0; i < total_pixels; ++i) {
+        const size_t k = CoeffIndex(i);
+        calibration.fixed_coeffs[k] = static_cast<int32_t>(std::floor(coeffs[k] * scale + 0.5));
+        calibration.fixed_coeffs[k + COEFF_BLOCK] =
+            static_cast<int32_t>(std::floor(coeffs[k + COEFF_BLOCK] * scale + 0.5 + half));
+    }
+
+    calibration.fixed_bits = bits;
+    calibration.fixed_active = true;
+}
+
+// Clamp value to valid range
+void XOGCorrect::ClampValue(float& value)
+{
+    if (value < 0.0f) {
+        value = 0.0f;
+    } else if (value > m_max_value) {
+        value = static_cast<float>(m_max_value);
+    }
+}
+
+// Save calibration data to file
+bool XOGCorrect::SaveCalibrationData(const char* filename)
+{
+    std::lock_guard<std::mutex> lock(m_calib_mutex);
+    return WriteCalibration(filename, nullptr);
+}
+
+// Save only what changed relative to a file saved earlier
+bool XOGCorrect::SaveDeltaCalibration(const char* filename, const char* base_filename)
+{
+    if (!base_filename) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(m_calib_mutex);
+    return WriteCalibration(filename, base_filename);
+}
+
+// Write the maps as a full file, or as a delta against base_filename
+bool XOGCorrect::WriteCalibration(const char* filename, const char* base_filename)
+{
+    // Called with m_calib_mutex held
+    if (!m_initialized || !filename) {
+        return false;
+    }
+
+    const size_t total_pixels = static_cast<size_t>(m_width) * m_height;
+    const int32_t meta[3] = { m_width, m_height, m_bit_depth };
+    const int modules = m_module_pixels > 0 ? GetModuleCount() : 0;
+    const int32_t layout[2] = { m_module_pixels, modules };
+
+    HX::Internal::CalibFileWriter writer(CALIB_MODULE);
+    writer.AddSection(CALIB_META, meta, sizeof(meta), sizeof(int32_t));
+
+    // Per-module layout: every map slice is its own page-aligned section,
+    // so SaveModuleCalibration() can rewrite one module in place and a
+    // delta carries only the modules that changed
+    std::vector<unsigned short> offset;
+    std::vector<float> gain;
+    std::vector<unsigned short> baseline;
+    if (modules == 0) {
+        writer.AddSection(CALIB_OFFSET, m_offset_data,
+                          total_pixels * sizeof(unsigned short), sizeof(unsigned short));
+        writer.AddSection(CALIB_GAIN, m_gain_data,
+                          total_pixels * sizeof(float), sizeof(float));
+        writer.AddSection(CALIB_BASELINE, m_baseline_data,
+                          total_pixels * sizeof(unsigned short), sizeof(unsigned short));
+    } else {
+        const size_t slice = static_cast<size_t>(m_module_pixels) * m_height;
+        offset.resize(total_pixels);
+        gain.resize(total_pixels);
+        baseline.resize(total_pixels);
+        writer.AddSection(CALIB_MODULES, layout, sizeof(layout), sizeof(int32_t));
+        for (int m = 0; m < modules; ++m) {
+            const int x0 = m * m_module_pixels;
+            GatherModule(m_offset_data, m_width, m_height, x0, m_module_pixels, &offset[m * slice]);
+            GatherModule(m_gain_data, m_width, m_height, x0, m_module_pixels, &gain[m * slice]);
+            GatherModule(m_baseline_data, m_width, m_height, x0, m_module_pixels, &baseline[m * slice]);
+            writer.AddSection(ModuleTag('O', m), &offset[m * slice],
+                              slice * sizeof(unsigned short), sizeof(unsigned short));
+            writer.AddSection(ModuleTag('G', m), &gain[m * slice],
+                              slice * sizeof(float), sizeof(float));
+            writer.AddSection(ModuleTag('B', m), &baseline[m * slice],
+                              slice * sizeof(unsigned short), sizeof(unsigned short));
+        }
+    }
+
+    if (!base_filename) {
+        return writer.Write(filename);
+    }
+
+    // A delta cannot drop sections, so the base must use the same layout
+    HX::Internal::CalibFile base;
+    if (!base.Open(base_filename, CALIB_MODULE, false)) {
+        return false;
+    }
+    const int32_t* base_layout = static_cast<const int32_t*>(
+        base.SectionExact(CALIB_MODULES, sizeof(layout)));
+    if ((modules == 0) != (base_layout == nullptr) ||
+        (base_layout && std::memcmp(base_layout, layout, sizeof(layout)) != 0)) {
+        return false;
+    }
+    return writer.WriteDelta(filename, base);
+}
+
+// Rewrite one module's sections of a file saved in the per-module layout
+bool XOGCorrect::SaveModuleCalibration(const char* filename, int module)
+{
+    std::lock_guard<std::mutex> lock(m_calib_mutex);
+    int x0 = 0;
+    int x1 = 0;
+    if (!m_initialized || !filename || module < 0 || !ModuleColumns(module, x0, x1)) {
+        return false;
+    }
+
+    // The file must describe this detector, not just have sections of the right size
+    {
+        HX::Internal::CalibFile file;
+        if (!file.Open(filename, CALIB_MODULE, false)) {
+            return false;
+        }
+        const int32_t* meta = static_cast<const int32_t*>(
+            file.SectionExact(CALIB_META, 3 * sizeof(int32_t)));
+        const int32_t* layout = static_cast<const int32_t*>(
+            file.SectionExact(CALIB_MODULES, 2 * sizeof(int32_t)));
+        if (!meta || !layout || meta[0] != m_width || meta[1] != m_height ||
+            layout[0] != m_module_pixels) {
+            return false;
+        }
+    }
+
+    const size_t slice = static_cast<size_t>(m_module_pixels) * m_height;
+    std::vector<unsigned short> offset(slice);
+    std::vector<float> gain(slice);
+    std::vector<unsigned short> baseline(slice);
+    GatherModule(m_offset_data, m_width, m_height, x0, m_module_pixels, offset.data());
+    GatherModule(m_gain_data, m_width, m_height, x0, m_module_pixels, gain.data());
+    GatherModule(m_baseline_data, m_width, m_height, x0, m_module_pixels, baseline.data());
+
+    HX::Internal::CalibFileWriter writer(CALIB_MODULE);
+    writer.AddSection(ModuleTag('O', module), offset.data(),
+                      slice * sizeof(unsigned short), sizeof(unsigned short));
+    writer.AddSection(ModuleTag('G', module), gain.data(), slice * sizeof(float), sizeof(float));
+    writer.AddSection(ModuleTag('B', module), baseline.data(),
+                      slice * sizeof(unsigned short), sizeof(unsigned short));
+    return writer.Update(filename);
+}
+
+// Take one module's slice from a per-module file of the same module geometry
+bool XOGCorrect::LoadModuleCalibration(const char* filename, int module)
+{
+    if (!filename || module < 0) {
+        return false;
+    }
+
+    HX::Internal::CalibFile file;
+    if (!file.Open(filename, CALIB_MODULE)) {
+        return false;
+    }
+    const int32_t* meta = static_cast<const int32_t*>(
+        file.SectionExact(CALIB_META, 3 * sizeof(int32_t)));
+    const int32_t* layout = static_cast<const int32_t*>(
+        file.SectionExact(CALIB_MODULES, 2 * sizeof(int32_t)));
+    if (!meta || !layout) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(m_calib_mutex);
+    int x0 = 0;
+    int x1 = 0;
+    if (!m_initialized || !ModuleColumns(module, x0, x1) ||
+        meta[1] != m_height || layout[0] != m_module_pixels) {
+        return false;
+    }
+
+    const size_t slice = static_cast<size_t>(m_module_pixels) * m_height;
+    const unsigned short* offset = static_cast<const unsigned short*>(
+        file.SectionExact(ModuleTag('O', module), slice * sizeof(unsigned short)));
+    const float* gain = static_cast<const float*>(
+        file.SectionExact(ModuleTag('G', module), slice * sizeof(float)));
+    const unsigned short* baseline = static_cast<const unsigned short*>(
+        file.SectionExact(ModuleTag('B', module), slice * sizeof(unsigned short)));
+    if (!offset || !gain || !baseline) {
+        return false;
     }
 
+    ScatterModule(offset, m_width, m_height, x0, m_module_pixels, m_offset_data);
+    ScatterModule(gain, m_width, m_height, x0, m_module_pixels, m_gain_data);
+    ScatterModule(baseline, m_width, m_height, x0, m_module_pixels, m_baseline_data);
+    ClearSaturation(module);
+    m_file_identity = 0;
+    PublishModule(module);
     return true;
 }
 
-// Apply full correction to frame
-bool XOGCorrect::ApplyCorrection(const unsigned short* input_data,
-                                unsigned short* output_data)
+// Load calibration data from file
+bool XOGCorrect::LoadCalibrationData(const char* filename)
 {
-    if (!m_initialized || !input_data || !output_data) {
+    if (!filename) {
         return false;
     }
 
-    const int total_pixels = m_width * m_height;
-
-    for (int i = 0; i < total_pixels; ++i) {
-        float corrected = static_cast<float>(input_data[i]);
-
-        // Step 1: Subtract offset
-        if (m_enable_offset) {
-            corrected -= static_cast<float>(m_offset_data[i]);
-        }
-
-        // Step 2: Apply gain
-        if (m_enable_gain) {
-            corrected *= m_gain_data[i];
-        }
-
-        // Step 3: Subtract baseline
-        if (m_enable_baseline) {
-            corrected -= static_cast<float>(m_baseline_data[i]);
-        }
+    if (!HX::Internal::CalibFile::IsContainer(filename)) {
+        return LoadLegacyCalibration(filename);
+    }
 
-        // Step 4: Add target baseline
-        corrected += static_cast<float>(m_target_baseline);
+    HX::Internal::CalibFile file;
+    if (!file.Open(filename, CALIB_MODULE)) {
+        return false;
+    }
+    return LoadContainer(file);
+}
 
-        // Step 5: Clamp to valid range
-        ClampValue(corrected);
-        output_data[i] = static_cast<unsigned short>(corrected + 0.5f);
+// Load a base file with a delta file laid over it
+bool XOGCorrect::LoadDeltaCalibration(const char* base_filename, const char* delta_filename)
+{
+    if (!base_filename || !delta_filename) {
+        return false;
     }
 
-    return true;
+    HX::Internal::CalibFile file;
+    if (!file.Open(base_filename, CALIB_MODULE) || !file.ApplyDelta(delta_filename)) {
+        return false;
+    }
+    return LoadContainer(file);
 }
 
-// Apply correction to single line (for line-scan mode)
-bool XOGCorrect::ApplyCorrectionLine(const unsigned short* input_line,
-                                    unsigned short* output_line,
-                                    int line_index)
+// Take the changed sections of a delta whose base is the loaded file. Only
+// the delta is read; unchanged modules keep their maps and coefficients.
+bool XOGCorrect::ApplyCalibrationDelta(const char* delta_filename)
 {
-    if (!m_initialized || !input_line || !output_line) {
+    if (!delta_filename) {
         return false;
     }
 
-    if (line_index < 0 || line_index >= m_height) {
-        line_index = 0;
+    HX::Internal::CalibFile file;
+    if (!file.OpenDelta(delta_filename, CALIB_MODULE)) {
+        return false;
     }
 
-    const int line_offset = line_index * m_width;
+    // A new size or module layout needs the whole file
+    if (file.Section(CALIB_META) || file.Section(CALIB_MODULES)) {
+        return false;
+    }
 
-    for (int x = 0; x < m_width; ++x) {
-        int i = line_offset + x;
-        float corrected = static_cast<float>(input_line[x]);
+    std::lock_guard<std::mutex> lock(m_calib_mutex);
+    if (!m_initialized || m_file_identity == 0 || file.BaseIdentity() != m_file_identity) {
+        return false;
+    }
 
-        if (m_enable_offset) {
-            corrected -= static_cast<float>(m_offset_data[i]);
+    // Without modules the whole width is one slice
+    const int modules = m_module_pixels > 0 ? GetModuleCount() : 1;
+    const int width = m_module_pixels > 0 ? m_module_pixels : m_width.load();
+    const size_t slice = static_cast<size_t>(width) * m_height;
+    std::vector<const unsigned short*> offset(modules);
+    std::vector<const float*> gain(modules);
+    std::vector<const unsigned short*> baseline(modules);
+
+    // Every section the delta has must fit before any map changes
+    int changed = 0;
+    int last = -1;
+    for (int m = 0; m < modules; ++m) {
+        const uint32_t tags[3] = {
+            m_module_pixels > 0 ? ModuleTag('O', m) : CALIB_OFFSET,
+            m_module_pixels > 0 ? ModuleTag('G', m) : CALIB_GAIN,
+            m_module_pixels > 0 ? ModuleTag('B', m) : CALIB_BASELINE,
+        };
+        const size_t sizes[3] = {
+            slice * sizeof(unsigned short), slice * sizeof(float), slice * sizeof(unsigned short)
+        };
+        const void* data[3];
+        for (int k = 0; k < 3; ++k) {
+            size_t size = 0;
+            data[k] = file.Section(tags[k], &size);
+            if (data[k] && size != sizes[k]) {
+                return false;
+            }
         }
-
-        if (m_enable_gain) {
-            corrected *= m_gain_data[i];
+        offset[m] = static_cast<const unsigned short*>(data[0]);
+        gain[m] = static_cast<const float*>(data[1]);
+        baseline[m] = static_cast<const unsigned short*>(data[2]);
+        if (data[0] || data[1] || data[2]) {
+            ++changed;
+            last = m;
         }
+    }
 
-        if (m_enable_baseline) {
-            corrected -= static_cast<float>(m_baseline_data[i]);
+    for (int m = 0; m < modules; ++m) {
+        const int x0 = m * width;
+        if (offset[m]) {
+            ScatterModule(offset[m], m_width, m_height, x0, width, m_offset_data);
+        }
+        if (gain[m]) {
+            ScatterModule(gain[m], m_width, m_height, x0, width, m_gain_data);
+            ClearSaturation(m_module_pixels > 0 ? m : -1);
+        }
+        if (baseline[m]) {
+            ScatterModule(baseline[m], m_width, m_height, x0, width, m_baseline_data);
         }
-
-        corrected += static_cast<float>(m_target_baseline);
-
-        ClampValue(corrected);
-        output_line[x] = static_cast<unsigned short>(corrected + 0.5f);
     }
 
+    if (changed == 1 && m_module_pixels > 0) {
+        PublishModule(last);
+    } else if (changed > 0) {
+        PublishMaps();
+    }
+    m_file_identity = file.Identity();
     return true;
 }
 
-// Set correction mode flags
-void XOGCorrect::SetCorrectionMode(bool enable_offset, bool enable_gain, bool enable_baseline)
-{
-    m_enable_offset = enable_offset;
-    m_enable_gain = enable_gain;
-    m_enable_baseline = enable_baseline;
-}
-
-// Set bit depth
-void XOGCorrect::SetBitDepth(int bit_depth)
+// Load the maps of an open container view
+bool XOGCorrect::LoadContainer(const HX::Internal::CalibFile& file)
 {
-    if (bit_depth >= 8 && bit_depth <= 16) {
-        m_bit_depth = bit_depth;
-        m_max_value = (1 << bit_depth) - 1;
+    const int32_t* meta = static_cast<const int32_t*>(
+        file.SectionExact(CALIB_META, 3 * sizeof(int32_t)));
+    if (!meta || meta[0] <= 0 || meta[1] <= 0) {
+        return false;
     }
-}
 
-// Clamp value to valid range
-void XOGCorrect::ClampValue(float& value)
-{
-    if (value < 0.0f) {
-        value = 0.0f;
-    } else if (value > m_max_value) {
-        value = static_cast<float>(m_max_value);
+    const size_t total_pixels = static_cast<size_t>(meta[0]) * meta[1];
+    const int32_t* layout = static_cast<const int32_t*>(
+        file.SectionExact(CALIB_MODULES, 2 * sizeof(int32_t)));
+    if (layout) {
+        return LoadModuleLayout(file, meta, layout);
     }
-}
 
-// Save calibration data to file
-bool XOGCorrect::SaveCalibrationData(const char* filename)
-{
-    if (!m_initialized || !filename) {
+    // Validate every section before touching the current calibration
+    const void* offset = file.SectionExact(CALIB_OFFSET, total_pixels * sizeof(unsigned short));
+    const void* gain = file.SectionExact(CALIB_GAIN, total_pixels * sizeof(float));
+    const void* baseline = file.SectionExact(CALIB_BASELINE, total_pixels * sizeof(unsigned short));
+    if (!offset || !gain || !baseline) {
         return false;
     }
 
-    std::ofstream file(filename, std::ios::binary);
-    if (!file.is_open()) {
+    // Applies run on with the old calibration until the new one is published
+    std::lock_guard<std::mutex> lock(m_calib_mutex);
+    if (!Reset(meta[0], meta[1], meta[2])) {
         return false;
     }
 
-    const int total_pixels = m_width * m_height;
-
-    // Write header
-    file.write(reinterpret_cast<const char*>(&m_width), sizeof(int));
-    file.write(reinterpret_cast<const char*>(&m_height), sizeof(int));
-    file.write(reinterpret_cast<const char*>(&m_bit_depth), sizeof(int));
+    std::memcpy(m_offset_data, offset, total_pixels * sizeof(unsigned short));
+    std::memcpy(m_gain_data, gain, total_pixels * sizeof(float));
+    std::memcpy(m_baseline_data, baseline, total_pixels * sizeof(unsigned short));
+    m_file_identity = file.Identity();
+    PublishMaps();
+    return true;
+}
 
-    // Write offset data
-    file.write(reinterpret_cast<const char*>(m_offset_data), 
-              total_pixels * sizeof(unsigned short));
+// Load a file written per module; its module geometry becomes the current one
+bool XOGCorrect::LoadModuleLayout(const HX::Internal::CalibFile& file,
+                                  const int32_t* meta, const int32_t* layout)
+{
+    const int width = meta[0];
+    const int height = meta[1];
+    const int module_pixels = layout[0];
+    if (module_pixels <= 0 || width % module_pixels != 0 || layout[1] != width / module_pixels) {
+        return false;
+    }
 
-    // Write gain data
-    file.write(reinterpret_cast<const char*>(m_gain_data), 
-              total_pixels * sizeof(float));
+    const int modules = layout[1];
+    const size_t slice = static_cast<size_t>(module_pixels) * height;
+    std::vector<const unsigned short*> offset(modules);
+    std::vector<const float*> gain(modules);
+    std::vector<const unsigned short*> baseline(modules);
+    for (int m = 0; m < modules; ++m) {
+        offset[m] = static_cast<const unsigned short*>(
+            file.SectionExact(ModuleTag('O', m), slice * sizeof(unsigned short)));
+        gain[m] = static_cast<const float*>(file.SectionExact(ModuleTag('G', m), slice * sizeof(float)));
+        baseline[m] = static_cast<const unsigned short*>(
+            file.SectionExact(ModuleTag('B', m), slice * sizeof(unsigned short)));
+        if (!offset[m] || !gain[m] || !baseline[m]) {
+            return false;
+        }
+    }
 
-    // Write baseline data
-    file.write(reinterpret_cast<const char*>(m_baseline_data), 
-              total_pixels * sizeof(unsigned short));
+    std::lock_guard<std::mutex> lock(m_calib_mutex);
+    if (!Reset(width, height, meta[2])) {
+        return false;
+    }
 
-    file.close();
+    m_module_pixels = module_pixels;
+    for (int m = 0; m < modules; ++m) {
+        const int x0 = m * module_pixels;
+        ScatterModule(offset[m], width, height, x0, module_pixels, m_offset_data);
+        ScatterModule(gain[m], width, height, x0, module_pixels, m_gain_data);
+        ScatterModule(baseline[m], width, height, x0, module_pixels, m_baseline_data);
+    }
+    m_file_identity = file.Identity();
+    PublishMaps();
     return true;
 }
 
-// Load calibration data from file
-bool XOGCorrect::LoadCalibrationData(const char* filename)
+// Load the pre-container layout: width, height, bit depth, offset, gain, baseline
+bool XOGCorrect::LoadLegacyCalibration(const char* filename)
 {
-    if (!filename) {
-        return false;
-    }
-
     std::ifstream file(filename, std::ios::binary);
     if (!file.is_open()) {
         return false;
     }
 
-    int width, height, bit_depth;
-
-    // Read header
+    int width = 0, height = 0, bit_depth = 0;
     file.read(reinterpret_cast<char*>(&width), sizeof(int));
     file.read(reinterpret_cast<char*>(&height), sizeof(int));
     file.read(reinterpret_cast<char*>(&bit_depth), sizeof(int));
-
-    // Initialize with loaded dimensions
-    if (!Initialize(width, height, bit_depth)) {
-        file.close();
+    if (!file.good() || width <= 0 || height <= 0) {
         return false;
     }
 
-    const int total_pixels = m_width * m_height;
-
-    // Read offset data
-    file.read(reinterpret_cast<char*>(m_offset_data), 
-             total_pixels * sizeof(unsigned short));
+    const size_t total_pixels = static_cast<size_t>(width) * height;
+    std::vector<unsigned short> offset(total_pixels);
+    std::vector<float> gain(total_pixels);
+    std::vector<unsigned short> baseline(total_pixels);
+    file.read(reinterpret_cast<char*>(offset.data()), total_pixels * sizeof(unsigned short));
+    file.read(reinterpret_cast<char*>(gain.data()), total_pixels * sizeof(float));
+    file.read(reinterpret_cast<char*>(baseline.data()), total_pixels * sizeof(unsigned short));
+    if (!file.good()) {
+        return false;
+    }
 
-    // Read gain data
-    file.read(reinterpret_cast<char*>(m_gain_data), 
-             total_pixels * sizeof(float));
+    std::lock_guard<std::mutex> lock(m_calib_mutex);
+    if (!Reset(width, height, bit_depth)) {
+        return false;
+    }
 
-    // Read baseline data
-    file.read(reinterpret_cast<char*>(m_baseline_data), 
-             total_pixels * sizeof(unsigned short));
+    std::memcpy(m_offset_data, offset.data(), total_pixels * sizeof(unsigned short));
+    std::memcpy(m_gain_data, gain.data(), total_pixels * sizeof(float));
+    std::memcpy(m_baseline_data, baseline.data(), total_pixels * sizeof(unsigned short));
+    PublishMaps();
+    return true;
+}
 
-    file.close();
-    return file.good();
+// Bytes GetSaturationMap() writes
+size_t XOGCorrect::GetSaturationMapSize()
+{
+    std::lock_guard<std::mutex> lock(m_calib_mutex);
+    return m_saturation_map.size();
 }
 
-// Get offset statistics
-bool XOGCorrect::GetOffsetStatistics(float& mean, float& std_dev, 
-                                    float& min_val, float& max_val)
+// Copy the packed linear-ceiling codes
+bool XOGCorrect::GetSaturationMap(uint8_t* map, size_t size)
 {
-    if (!m_initialized || !m_offset_data) {
+    std::lock_guard<std::mutex> lock(m_calib_mutex);
+    if (!m_initialized || !map || size < m_saturation_map.size()) {
         return false;
     }
+    std::memcpy(map, m_saturation_map.data(), m_saturation_map.size());
+    return true;
+}
 
-    const int total_pixels = m_width * m_height;
-    
-    mean = 0.0f;
-    min_val = static_cast<float>(m_offset_data[0]);
-    max_val = static_cast<float>(m_offset_data[0]);
-
-    for (int i = 0; i < total_pixels; ++i) {
-        float val = static_cast<float>(m_offset_data[i]);
-        mean += val;
-        if (val < min_val) min_val = val;
-        if (val > max_val) max_val = val;
+// Histogram of the codes, e.g. how many pixels saturate (code 0)
+bool XOGCorrect::GetSaturationCounts(uint64_t* counts)
+{
+    std::lock_guard<std::mutex> lock(m_calib_mutex);
+    if (!m_initialized || !counts) {
+        return false;
     }
-    mean /= total_pixels;
-
-    std_dev = 0.0f;
-    for (int i = 0; i < total_pixels; ++i) {
-        float diff = static_cast<float>(m_offset_data[i]) - mean;
-        std_dev += diff * diff;
+    std::fill_n(counts, HX::Internal::SATURATION_FULL_RANGE + 1, 0);
+    const size_t total_pixels = static_cast<size_t>(m_width) * m_height;
+    const uint8_t* map = m_saturation_map.data();
+    for (size_t i = 0; i + 1 < total_pixels; i += 2) {
+        ++counts[map[i >> 1] & 0xF];
+        ++counts[map[i >> 1] >> 4];
+    }
+    if (total_pixels & 1) {
+        ++counts[HX::Internal::GetSaturationCode(map, total_pixels - 1)];
     }
-    std_dev = std::sqrt(std_dev / total_pixels);
-
     return true;
 }
 
-// Get gain statistics
-bool XOGCorrect::GetGainStatistics(float& mean, float& std_dev, 
-                                  float& min_val, float& max_val)
+// Offset, gain and baseline statistics and the gain defect count, one pass
+bool XOGCorrect::GetCalibrationReport(HX::Internal::CalibrationReport& report)
 {
-    if (!m_initialized || !m_gain_data) {
+    std::lock_guard<std::mutex> lock(m_calib_mutex);
+    if (!m_initialized) {
         return false;
     }
 
-    const int total_pixels = m_width * m_height;
-    
-    mean = 0.0f;
-    min_val = m_gain_data[0];
-    max_val = m_gain_data[0];
-
-    for (int i = 0; i < total_pixels; ++i) {
-        mean += m_gain_data[i];
-        if (m_gain_data[i] < min_val) min_val = m_gain_data[i];
-        if (m_gain_data[i] > max_val) max_val = m_gain_data[i];
-    }
-    mean /= total_pixels;
+    HX::Internal::BuildCalibrationReport(m_offset_data, m_gain_data, m_baseline_data,
+                                         static_cast<size_t>(m_width) * m_height, report);
+    return true;
+}
 
-    std_dev = 0.0f;
-    for (int i = 0; i < total_pixels; ++i) {
-        float diff = m_gain_data[i] - mean;
-        std_dev += diff * diff;
+// Get offset statistics
+bool XOGCorrect::GetOffsetStatistics(float& mean, float& std_dev, 
+                                    float& min_val, float& max_val)
+{
+    HX::Internal::CalibrationReport report;
+    if (!GetCalibrationReport(report) || report.offset.count == 0) {
+        return false;
     }
-    std_dev = std::sqrt(std_dev / total_pixels);
 
+    mean = static_cast<float>(report.offset.mean);
+    std_dev = static_cast<float>(report.offset.stdDev());
+    min_val = report.offset.minValue;
+    max_val = report.offset.maxValue;
     return true;
 }
 
-// Validate calibration data
-bool XOGCorrect::ValidateCalibrationData()
+// Get gain statistics, over the finite gains
+bool XOGCorrect::GetGainStatistics(float& mean, float& std_dev, 
+                                  float& min_val, float& max_val)
 {
-    if (!m_initialized) {
+    HX::Internal::CalibrationReport report;
+    if (!GetCalibrationReport(report) || report.gain.count == 0) {
         return false;
     }
 
-    const int total_pixels = m_width * m_height;
-    int invalid_count = 0;
+    mean = static_cast<float>(report.gain.mean);
+    std_dev = static_cast<float>(report.gain.stdDev());
+    min_val = report.gain.minValue;
+    max_val = report.gain.maxValue;
+    return true;
+}
 
-    // Check gain data
-    for (int i = 0; i < total_pixels; ++i) {
-        if (std::isnan(m_gain_data[i]) || std::isinf(m_gain_data[i]) ||
-            m_gain_data[i] <= 0.0f || m_gain_data[i] > 100.0f) {
-            invalid_count++;
+// Validate calibration data, allowing up to 0.1% invalid gains
+bool XOGCorrect::ValidateCalibrationData()
+{
+    HX::Internal::CalibrationReport report;
+    return GetCalibrationReport(report) && report.valid();
+}
+
+/**
+ * @brief Runs XOGCorrect::ApplyCorrectionLine on lines as XFrame places them
+ *
+ * Frame row r uses calibration row r % height, so a one-row calibration
+ * corrects every line of a line-scan frame. Lines that do not match the
+ * calibration width or are not 9-16 bit are copied unchanged. A dark
+ * reference (SetDarkReference()) is taken off in the same call.
+ */
+class XOGLineFilter : public HX::IXLineFilter {
+public:
+    explicit XOGLineFilter(XOGCorrect* correct) : m_correct(correct) {}
+
+    void OnLine(const uint8_t* src, uint8_t* dst, uint32_t width,
+                uint8_t pixelDepth, uint32_t row)
+    {
+        // One calibration for the whole line, even if a new one is published
+        if (!m_correct || (pixelDepth + 7) / 8 != 2 ||
+            !m_correct->ApplyCorrectionRow(reinterpret_cast<const unsigned short*>(src),
+                                           reinterpret_cast<unsigned short*>(dst),
+                                           static_cast<int>(width), row)) {
+            if (src != dst) {
+                std::memcpy(dst, src, static_cast<size_t>(width) * ((pixelDepth + 7) / 8));
+            }
         }
     }
 
-    // Allow up to 0.1% invalid pixels
-    return invalid_count < (total_pixels / 1000);
+private:
+    XOGCorrect* m_correct;
+};
+
+HX::IXLineFilter* CreateXOGLineFilter(XOGCorrect* correct)
+{
+    return correct ? new XOGLineFilter(correct) : nullptr;
+}
+
+void DestroyXOGLineFilter(HX::IXLineFilter* filter)
+{
+    delete filter;
 }
 
 // Global instance management functions
+// Shared instance, created on first use (kept for existing callers)
 static XOGCorrect* g_xog_instance = nullptr;
+static std::mutex g_xog_instance_mutex;
 
 XOGCorrect* CreateXOGCorrect()
 {
+    std::lock_guard<std::mutex> lock(g_xog_instance_mutex);
     if (!g_xog_instance) {
         g_xog_instance = new XOGCorrect();
     }
@@ -604,6 +2619,7 @@ XOGCorrect* CreateXOGCorrect()
 
 void DestroyXOGCorrect()
 {
+    std::lock_guard<std::mutex> lock(g_xog_instance_mutex);
     if (g_xog_instance) {
         delete g_xog_instance;
         g_xog_instance = nullptr;
@@ -612,7 +2628,280 @@ void DestroyXOGCorrect()
 
 XOGCorrect* GetXOGCorrect()
 {
+    std::lock_guard<std::mutex> lock(g_xog_instance_mutex);
     return g_xog_instance;
 }
 
-} // namespace fximage
\ No newline at end of file
+// Independent instances: one per detector or pipeline thread, owned by the caller
+XOGCorrect* CreateXOGCorrectInstance()
+{
+    return new (std::nothrow) XOGCorrect();
+}
+
+void DestroyXOGCorrectInstance(XOGCorrect* instance)
+{
+    delete instance;
+}
+
+} // namespace fximage
+
+/**
+ * @brief XOGCorrect instance behind a C API handle
+ */
+struct hubx_xog_t {
+    std::mutex mutex;
+    fximage::XOGCorrect correct;
+};
+
+// C-style API
+extern "C" {
+
+hubx_xog_t* hubx_xog_create(void) {
+    return new (std::nothrow) hubx_xog_t();
+}
+
+void hubx_xog_destroy(hubx_xog_t* handle) {
+    delete handle;
+}
+
+int hubx_xog_load(hubx_xog_t* handle, const char* file) {
+    if (!handle || !file) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    return handle->correct.LoadCalibrationData(file) ? HUBX_SUCCESS : HUBX_ERROR_INVALID_PARAM;
+}
+
+int hubx_xog_init(hubx_xog_t* handle, int width, int height, int bitDepth) {
+    if (!handle) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    return handle->correct.Initialize(width, height, bitDepth) ? HUBX_SUCCESS : HUBX_ERROR_INVALID_PARAM;
+}
+
+int hubx_xog_add_dark(hubx_xog_t* handle, const unsigned short* frame) {
+    if (!handle || !frame) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    return handle->correct.AddOffsetFrame(frame) ? HUBX_SUCCESS : HUBX_ERROR_NOT_CALIBRATED;
+}
+
+int hubx_xog_finalize_offset(hubx_xog_t* handle) {
+    if (!handle) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    return handle->correct.FinalizeOffset() ? HUBX_SUCCESS : HUBX_ERROR_CALCULATION;
+}
+
+int hubx_xog_add_bright(hubx_xog_t* handle, const unsigned short* frame) {
+    if (!handle || !frame) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    return handle->correct.AddGainFrame(frame) ? HUBX_SUCCESS : HUBX_ERROR_NOT_CALIBRATED;
+}
+
+int hubx_xog_finalize_gain(hubx_xog_t* handle, unsigned short target) {
+    if (!handle) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    return handle->correct.FinalizeGain(target) ? HUBX_SUCCESS : HUBX_ERROR_CALCULATION;
+}
+
+int hubx_xog_discard_frames(hubx_xog_t* handle) {
+    if (!handle) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    handle->correct.DiscardCalibrationFrames();
+    return HUBX_SUCCESS;
+}
+
+int hubx_xog_save(hubx_xog_t* handle, const char* file) {
+    if (!handle || !file) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    if (!handle->correct.IsInitialized()) {
+        return HUBX_ERROR_NOT_CALIBRATED;
+    }
+    return handle->correct.SaveCalibrationData(file) ? HUBX_SUCCESS : HUBX_ERROR_CALCULATION;
+}
+
+int hubx_xog_get_size(hubx_xog_t* handle, int* width, int* height) {
+    if (!handle || !width || !height) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    if (!handle->correct.IsInitialized()) {
+        return HUBX_ERROR_NOT_CALIBRATED;
+    }
+    *width = handle->correct.GetWidth();
+    *height = handle->correct.GetHeight();
+    return HUBX_SUCCESS;
+}
+
+int hubx_xog_apply(hubx_xog_t* handle, const unsigned short* input, unsigned short* output) {
+    if (!handle || !input || !output) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    HX::Internal::TraceScope trace(HX::XFactory::TRACE_CORRECT_OG);
+    HX::Internal::PerfScope perf(HX::XFactory::PERF_CORRECT_OG);
+    // No handle lock: the apply reads only the published calibration, so
+    // loading or finalizing on another thread never stalls it.
+    // Pointwise kernels: output may alias input
+    return handle->correct.ApplyCorrection(input, output) ? HUBX_SUCCESS : HUBX_ERROR_NOT_CALIBRATED;
+}
+
+int hubx_xog_get_version(hubx_xog_t* handle, unsigned long long* version) {
+    if (!handle || !version) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    *version = handle->correct.GetCalibrationVersion();
+    return *version != 0 ? HUBX_SUCCESS : HUBX_ERROR_NOT_CALIBRATED;
+}
+
+int hubx_xog_set_compact(hubx_xog_t* handle, int maxError) {
+    if (!handle) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    handle->correct.SetCompactCoefficients(maxError > 0, maxError);
+    return HUBX_SUCCESS;
+}
+
+int hubx_xog_get_error_bound(hubx_xog_t* handle, int* counts) {
+    if (!handle || !counts) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    *counts = handle->correct.GetErrorBound();
+    return handle->correct.GetCalibrationVersion() != 0 ? HUBX_SUCCESS : HUBX_ERROR_NOT_CALIBRATED;
+}
+
+int hubx_xog_get_saturation_map(hubx_xog_t* handle, unsigned char* map, int size) {
+    if (!handle || !map) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    if (!handle->correct.IsInitialized()) {
+        return HUBX_ERROR_NOT_CALIBRATED;
+    }
+    if (size < 0 || !handle->correct.GetSaturationMap(map, static_cast<size_t>(size))) {
+        return HUBX_ERROR_INVALID_PARAM;
+    }
+    return HUBX_SUCCESS;
+}
+
+int hubx_xog_get_saturation_counts(hubx_xog_t* handle, unsigned long long* counts) {
+    if (!handle || !counts) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    if (!handle->correct.IsInitialized()) {
+        return HUBX_ERROR_NOT_CALIBRATED;
+    }
+    uint64_t values[HX::Internal::SATURATION_FULL_RANGE + 1];
+    handle->correct.GetSaturationCounts(values);
+    std::copy(values, values + HX::Internal::SATURATION_FULL_RANGE + 1, counts);
+    return HUBX_SUCCESS;
+}
+
+int hubx_xog_set_robust_gain(hubx_xog_t* handle, int groups) {
+    if (!handle) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    handle->correct.SetRobustGain(groups);
+    return HUBX_SUCCESS;
+}
+
+int hubx_xog_set_modules(hubx_xog_t* handle, int modulePixels) {
+    if (!handle) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    if (!handle->correct.IsInitialized()) {
+        return HUBX_ERROR_NOT_CALIBRATED;
+    }
+    return handle->correct.SetModuleSegments(modulePixels) ? HUBX_SUCCESS : HUBX_ERROR_INVALID_PARAM;
+}
+
+int hubx_xog_set_module_scope(hubx_xog_t* handle, int module) {
+    if (!handle) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    if (!handle->correct.IsInitialized()) {
+        return HUBX_ERROR_NOT_CALIBRATED;
+    }
+    return handle->correct.SetCalibrationModule(module) ? HUBX_SUCCESS : HUBX_ERROR_INVALID_PARAM;
+}
+
+int hubx_xog_set_dark_reference(hubx_xog_t* handle, int leadPixels, int trailPixels) {
+    if (!handle) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    if (!handle->correct.IsInitialized()) {
+        return HUBX_ERROR_NOT_CALIBRATED;
+    }
+    return handle->correct.SetDarkReference(leadPixels, trailPixels) ? HUBX_SUCCESS : HUBX_ERROR_INVALID_PARAM;
+}
+
+int hubx_xog_save_module(hubx_xog_t* handle, const char* file, int module) {
+    if (!handle || !file) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    if (!handle->correct.IsInitialized()) {
+        return HUBX_ERROR_NOT_CALIBRATED;
+    }
+    return handle->correct.SaveModuleCalibration(file, module) ? HUBX_SUCCESS : HUBX_ERROR_INVALID_PARAM;
+}
+
+int hubx_xog_load_module(hubx_xog_t* handle, const char* file, int module) {
+    if (!handle || !file) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    if (!handle->correct.IsInitialized()) {
+        return HUBX_ERROR_NOT_CALIBRATED;
+    }
+    return handle->correct.LoadModuleCalibration(file, module) ? HUBX_SUCCESS : HUBX_ERROR_INVALID_PARAM;
+}
+
+int hubx_xog_save_delta(hubx_xog_t* handle, const char* file, const char* baseFile) {
+    if (!handle || !file || !baseFile) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    if (!handle->correct.IsInitialized()) {
+        return HUBX_ERROR_NOT_CALIBRATED;
+    }
+    return handle->correct.SaveDeltaCalibration(file, baseFile) ? HUBX_SUCCESS : HUBX_ERROR_INVALID_PARAM;
+}
+
+int hubx_xog_load_delta(hubx_xog_t* handle, const char* baseFile, const char* deltaFile) {
+    if (!handle || !baseFile || !deltaFile) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    return handle->correct.LoadDeltaCalibration(baseFile, deltaFile) ? HUBX_SUCCESS : HUBX_ERROR_INVALID_PARAM;
+}
+
+int hubx_xog_apply_delta(hubx_xog_t* handle, const char* deltaFile) {
+    if (!handle || !deltaFile) {
+        return HUBX_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    if (!handle->correct.IsInitialized()) {
+        return HUBX_ERROR_NOT_CALIBRATED;
+    }
+    return handle->correct.ApplyCalibrationDelta(deltaFile) ? HUBX_SUCCESS : HUBX_ERROR_INVALID_PARAM;
+}
+
+} // extern "C"
@@ -0,0 +1,222 @@
+// ============================================================================
+// archive_index.cpp
+// ============================================================================
+
+/**
+ * @file archive_index.cpp
+ * @brief Per-directory metadata index implementation
+ * @version 2.1.0
+ */
+
+#include "archive_index.h"
+#include "calib_file.h"
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace HX {
+namespace Internal {
+
+namespace {
+
+const char INDEX_MAGIC[8] = { 'H', 'X', 'I', 'N', 'D', 'E', 'X', '\0' };
+
+/// Longest string field; longer names are not indexed
+const size_t MAX_FIELD = 0xFFFF;
+
+// Serializes appends from this process; the OS append keeps others whole
+std::mutex g_appendMutex;
+
+void splitPath(const std::string& path, std::string& directory, std::string& name) {
+    const size_t slash = path.find_last_of("/\\");
+    if (slash == std::string::npos) {
+        directory = ".";
+        name = path;
+    } else {
+        directory = path.substr(0, slash ? slash : 1);
+        name = path.substr(slash + 1);
+    }
+}
+
+std::string indexPath(const std::string& directory) {
+    return directory + "/" + XArchiveIndex::FILE_NAME;
+}
+
+/// Append bytes in one call; header is prepended if the file is new
+bool appendBytes(const std::string& file, const std::vector<uint8_t>& record) {
+    IndexFileHeader header;
+    std::memcpy(header.magic, INDEX_MAGIC, sizeof(header.magic));
+    header.version = INDEX_VERSION;
+    header.headerSize = sizeof(IndexFileHeader);
+
+    std::vector<uint8_t> bytes;
+#ifdef _WIN32
+    HANDLE handle = CreateFileA(file.c_str(), FILE_APPEND_DATA, FILE_SHARE_READ | FILE_SHARE_WRITE,
+                                nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (handle == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    LARGE_INTEGER size;
+    const bool empty = GetFileSizeEx(handle, &size) && size.QuadPart == 0;
+#else
+    int fd = ::open(file.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    const bool empty = fstat(fd, &st) == 0 && st.st_size == 0;
+#endif
+    if (empty) {
+        const uint8_t* h = reinterpret_cast<const uint8_t*>(&header);
+        bytes.assign(h, h + sizeof(header));
+    }
+    bytes.insert(bytes.end(), record.begin(), record.end());
+
+#ifdef _WIN32
+    DWORD written = 0;
+    bool ok = WriteFile(handle, bytes.data(), static_cast<DWORD>(bytes.size()), &written, nullptr) &&
+              written == bytes.size();
+    ok = CloseHandle(handle) && ok;
+#else
+    bool ok = ::write(fd, bytes.data(), bytes.size()) == static_cast<ssize_t>(bytes.size());
+    ok = (::close(fd) == 0) && ok;
+#endif
+    return ok;
+}
+
+void appendString(std::vector<uint8_t>& out, const std::string& s) {
+    out.insert(out.end(), s.begin(), s.end());
+}
+
+} // namespace
+
+bool AppendArchiveRecord(const std::string& path, const XArchiveIndex::Record& record) {
+    std::string directory;
+    std::string name;
+    splitPath(path, directory, name);
+
+    std::string date = record.dateTime;
+    if (date.size() == 19 && date[4] == ':' && date[7] == ':') {
+        date[4] = '-';
+        date[7] = '-';
+    }
+    if (name.empty() || name.size() > MAX_FIELD || record.serialNum.size() > MAX_FIELD ||
+        date.size() > MAX_FIELD) {
+        return false;
+    }
+
+    IndexRecordHeader h;
+    std::memset(&h, 0, sizeof(h));
+    h.size = static_cast<uint32_t>(sizeof(h) + name.size() + record.serialNum.size() + date.size());
+    h.dataOffset = record.dataOffset;
+    h.fileSize = record.fileSize;
+    h.cols = record.cols;
+    h.rows = record.rows;
+    h.depth = record.depth;
+    h.dmNum = record.dmNum;
+    h.dmType = record.dmType;
+    h.dmPix = record.dmPix;
+    h.opMode = record.opMode;
+    h.intTime = record.intTime;
+    h.energy = record.energy;
+    h.bin = record.bin;
+    h.temp = record.temp;
+    h.humidity = record.humidity;
+    h.compression = record.compression;
+    h.tileSize = record.tileSize;
+    h.fileBytes = static_cast<uint16_t>(name.size());
+    h.serialBytes = static_cast<uint16_t>(record.serialNum.size());
+    h.dateBytes = static_cast<uint16_t>(date.size());
+
+    std::vector<uint8_t> bytes(sizeof(h));
+    appendString(bytes, name);
+    appendString(bytes, record.serialNum);
+    appendString(bytes, date);
+    const size_t crcStart = offsetof(IndexRecordHeader, dataOffset);
+    std::memcpy(bytes.data(), &h, sizeof(h));
+    h.crc = Crc32(bytes.data() + crcStart, bytes.size() - crcStart);
+    std::memcpy(bytes.data(), &h, sizeof(h));
+
+    std::lock_guard<std::mutex> lock(g_appendMutex);
+    return appendBytes(indexPath(directory), bytes);
+}
+
+bool LoadArchiveRecords(const std::string& directory, std::vector<XArchiveIndex::Record>& records) {
+    records.clear();
+    FILE* f = fopen(indexPath(directory).c_str(), "rb");
+    if (!f) {
+        return false;
+    }
+    std::vector<uint8_t> data;
+    uint8_t buffer[64 * 1024];
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), f)) > 0) {
+        data.insert(data.end(), buffer, buffer + n);
+    }
+    fclose(f);
+
+    IndexFileHeader header;
+    if (data.size() < sizeof(header)) {
+        return false;
+    }
+    std::memcpy(&header, data.data(), sizeof(header));
+    if (std::memcmp(header.magic, INDEX_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version == 0 || header.version > INDEX_VERSION ||
+        header.headerSize < sizeof(header) || header.headerSize > data.size()) {
+        return false;
+    }
+
+    size_t pos = header.headerSize;
+    const size_t crcStart = offsetof(IndexRecordHeader, dataOffset);
+    while (data.size() - pos >= sizeof(IndexRecordHeader)) {
+        // A second header: two writers created the file at the same time
+        if (std::memcmp(data.data() + pos, INDEX_MAGIC, sizeof(INDEX_MAGIC)) == 0) {
+            pos += sizeof(IndexFileHeader);
+            continue;
+        }
+        IndexRecordHeader h;
+        std::memcpy(&h, data.data() + pos, sizeof(h));
+        const size_t strings = static_cast<size_t>(h.fileBytes) + h.serialBytes + h.dateBytes;
+        if (h.size != sizeof(h) + strings || h.size > data.size() - pos ||
+            Crc32(data.data() + pos + crcStart, h.size - crcStart) != h.crc) {
+            break;
+        }
+
+        XArchiveIndex::Record r;
+        const char* s = reinterpret_cast<const char*>(data.data() + pos + sizeof(h));
+        r.file.assign(s, h.fileBytes);
+        r.serialNum.assign(s + h.fileBytes, h.serialBytes);
+        r.dateTime.assign(s + h.fileBytes + h.serialBytes, h.dateBytes);
+        r.cols = h.cols;
+        r.rows = h.rows;
+        r.depth = h.depth;
+        r.dmNum = h.dmNum;
+        r.dmType = h.dmType;
+        r.dmPix = h.dmPix;
+        r.opMode = h.opMode;
+        r.intTime = h.intTime;
+        r.energy = h.energy;
+        r.bin = h.bin;
+        r.temp = h.temp;
+        r.humidity = h.humidity;
+        r.compression = h.compression;
+        r.tileSize = h.tileSize;
+        r.dataOffset = h.dataOffset;
+        r.fileSize = h.fileSize;
+        records.push_back(r);
+        pos += h.size;
+    }
+    return true;
+}
+
+} // namespace Internal
+} // namespace HX
@@ -0,0 +1,98 @@
+// ============================================================================
+// archive_index.h
+// ============================================================================
+
+/**
+ * @file archive_index.h
+ * @brief Per-directory metadata index (hxindex.dat)
+ * @version 2.1.0
+ *
+ * This header is INTERNAL to hubx.dll. The index is append-only:
+ *
+ *   IndexFileHeader   16 bytes, magic "HXINDEX\0"
+ *   record            IndexRecordHeader, then file name, serial number and
+ *   record            date (not terminated), each record CRC-protected
+ *   ...
+ *
+ * Each record is written with one append, so writers in several threads
+ * or processes interleave whole records. Values are in native byte order.
+ */
+
+#ifndef ARCHIVE_INDEX_H
+#define ARCHIVE_INDEX_H
+
+#include "XArchiveIndex.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace HX {
+namespace Internal {
+
+/// Current index version; readers accept versions up to this one
+static const uint32_t INDEX_VERSION = 1;
+
+#pragma pack(push, 1)
+
+/**
+ * @brief File header
+ */
+struct IndexFileHeader {
+    char     magic[8];          ///< "HXINDEX\0"
+    uint32_t version;           ///< INDEX_VERSION at creation
+    uint32_t headerSize;        ///< sizeof(IndexFileHeader)
+};
+
+/**
+ * @brief Fixed part of a record
+ */
+struct IndexRecordHeader {
+    uint32_t size;              ///< Record bytes including the strings
+    uint32_t crc;               ///< CRC-32 of the record after this field
+    uint64_t dataOffset;
+    uint64_t fileSize;
+    uint32_t cols;
+    uint32_t rows;
+    uint32_t depth;
+    uint32_t dmNum;
+    uint32_t dmType;
+    uint32_t dmPix;
+    uint32_t opMode;
+    uint32_t intTime;
+    uint32_t energy;
+    uint32_t bin;
+    float    temp;
+    float    humidity;
+    uint32_t compression;
+    uint32_t tileSize;
+    uint16_t fileBytes;         ///< Length of the file name
+    uint16_t serialBytes;       ///< Length of the serial number
+    uint16_t dateBytes;         ///< Length of the date
+    uint16_t reserved;          ///< Zero
+};
+
+#pragma pack(pop)
+
+/**
+ * @brief Append a record to the index next to a file
+ * @param path Path of the file just written; its directory holds the index
+ *             and record.file is replaced by its name
+ * @param record Metadata (dates in TIFF form "YYYY:MM:DD" are normalized)
+ * @return true if the record reached the index
+ */
+bool AppendArchiveRecord(const std::string& path, const XArchiveIndex::Record& record);
+
+/**
+ * @brief Read every intact record of a directory's index
+ * @param directory Capture directory
+ * @param records Output, in append order
+ * @return false if the index is missing or its header is invalid
+ *
+ * @note Reading stops at the first torn or corrupted record
+ */
+bool LoadArchiveRecords(const std::string& directory, std::vector<XArchiveIndex::Record>& records);
+
+} // namespace Internal
+} // namespace HX
+
+#endif // ARCHIVE_INDEX_H
@@ -0,0 +1,186 @@
+// ============================================================================
+// box_filter.cpp
+// ============================================================================
+
+/**
+ * @file box_filter.cpp
+ * @brief Sliding-sum box filter and summed-area tables
+ * @version 2.1.0
+ *
+ * boxMean() runs a vertical pass that keeps one running column sum per x,
+ * updated with a whole-row add and subtract (vectorized by the compiler),
+ * and a horizontal pass that slides over those column sums.
+ *
+ * IntegralMoments::build() splits the 2-D prefix sum into independent
+ * rows (prefix along x) and independent column blocks (prefix along y),
+ * so both halves run in bands on the shared pool.
+ */
+
+#include "box_filter.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <cstring>
+
+namespace HX {
+namespace Internal {
+
+void boxMean(const float* src, int width, int height, int radius, float* mean) {
+    if (!src || !mean || width <= 0 || height <= 0) {
+        return;
+    }
+    if (radius <= 0) {
+        memcpy(mean, src, static_cast<size_t>(width) * height * sizeof(float));
+        return;
+    }
+
+    std::vector<double> col(width, 0.0);
+    int rows = 0;   // rows in the vertical window
+
+    // Rows [0, radius) are in the window of row 0
+    for (int y = 0; y < std::min(radius, height); ++y) {
+        const float* p = src + static_cast<size_t>(y) * width;
+        for (int x = 0; x < width; ++x) {
+            col[x] += p[x];
+        }
+        ++rows;
+    }
+
+    for (int y = 0; y < height; ++y) {
+        const int enter = y + radius;
+        const int leave = y - radius - 1;
+        if (enter < height) {
+            const float* p = src + static_cast<size_t>(enter) * width;
+            for (int x = 0; x < width; ++x) {
+                col[x] += p[x];
+            }
+            ++rows;
+        }
+        if (leave >= 0) {
+            const float* p = src + static_cast<size_t>(leave) * width;
+            for (int x = 0; x < width; ++x) {
+                col[x] -= p[x];
+            }
+            --rows;
+        }
+
+        // Horizontal slide over the column sums
+        float* out = mean + static_cast<size_t>(y) * width;
+        double sum = 0.0;
+        int cols = 0;
+        for (int x = 0; x < std::min(radius, width); ++x) {
+            sum += col[x];
+            ++cols;
+        }
+        for (int x = 0; x < width; ++x) {
+            const int in = x + radius;
+            const int out_col = x - radius - 1;
+            if (in < width) {
+                sum += col[in];
+                ++cols;
+            }
+            if (out_col >= 0) {
+                sum -= col[out_col];
+                --cols;
+            }
+            out[x] = static_cast<float>(sum / (cols * rows));
+        }
+    }
+}
+
+namespace {
+
+/// Table columns per column band: the rows of a band stay in L1
+const int INTEGRAL_COLUMN_BLOCK = 256;
+
+template <typename Pixel>
+void prefixRow(const uint8_t* src, uint64_t* row, uint64_t* rowSq, int width) {
+    const Pixel* p = reinterpret_cast<const Pixel*>(src);
+    uint64_t run = 0, runSq = 0;
+    row[0] = 0;
+    rowSq[0] = 0;
+    for (int x = 0; x < width; ++x) {
+        const uint64_t v = p[x];
+        run += v;
+        runSq += v * v;
+        row[x + 1] = run;
+        rowSq[x + 1] = runSq;
+    }
+}
+
+} // namespace
+
+void IntegralMoments::build(const uint8_t* src, size_t stride, uint32_t bytesPerPixel,
+                            int width, int height) {
+    if (!src || width <= 0 || height <= 0 || (bytesPerPixel != 1 && bytesPerPixel != 2)) {
+        m_width = 0;
+        m_height = 0;
+        return;
+    }
+
+    m_width = width;
+    m_height = height;
+    const size_t tableStride = static_cast<size_t>(width) + 1;
+    m_sum.resize(tableStride * (height + 1));
+    m_sumSq.resize(tableStride * (height + 1));
+    std::fill(m_sum.begin(), m_sum.begin() + tableStride, 0);
+    std::fill(m_sumSq.begin(), m_sumSq.begin() + tableStride, 0);
+    uint64_t* sum = m_sum.data();
+    uint64_t* sumSq = m_sumSq.data();
+
+    // Prefix along each row
+    ThreadPool& pool = ThreadPool::instance();
+    pool.parallelRows(height, width, [&](int firstRow, int endRow) {
+        for (int y = firstRow; y < endRow; ++y) {
+            const uint8_t* p = src + static_cast<size_t>(y) * stride;
+            uint64_t* row = sum + (y + 1) * tableStride;
+            uint64_t* rowSq = sumSq + (y + 1) * tableStride;
+            if (bytesPerPixel == 1) {
+                prefixRow<uint8_t>(p, row, rowSq, width);
+            } else {
+                prefixRow<uint16_t>(p, row, rowSq, width);
+            }
+        }
+    });
+
+    // Then down each column, a block of columns per band
+    const int blocks = static_cast<int>((tableStride + INTEGRAL_COLUMN_BLOCK - 1) / INTEGRAL_COLUMN_BLOCK);
+    pool.parallelRows(blocks, height * INTEGRAL_COLUMN_BLOCK, [&](int firstBlock, int endBlock) {
+        const size_t x0 = static_cast<size_t>(firstBlock) * INTEGRAL_COLUMN_BLOCK;
+        const size_t x1 = std::min(tableStride, static_cast<size_t>(endBlock) * INTEGRAL_COLUMN_BLOCK);
+        for (int y = 2; y <= height; ++y) {
+            const uint64_t* above = sum + (y - 1) * tableStride;
+            const uint64_t* aboveSq = sumSq + (y - 1) * tableStride;
+            uint64_t* row = sum + y * tableStride;
+            uint64_t* rowSq = sumSq + y * tableStride;
+            for (size_t x = x0; x < x1; ++x) {
+                row[x] += above[x];
+                rowSq[x] += aboveSq[x];
+            }
+        }
+    });
+}
+
+void IntegralMoments::varianceRow(int y, int radius, float* variance) const {
+    const size_t stride = static_cast<size_t>(m_width) + 1;
+    const size_t top = static_cast<size_t>(std::max(0, y - radius)) * stride;
+    const size_t bottom = static_cast<size_t>(std::min(m_height, y + radius + 1)) * stride;
+    const int rows = static_cast<int>((bottom - top) / stride);
+
+    for (int x = 0; x < m_width; ++x) {
+        const int left = std::max(0, x - radius);
+        const int right = std::min(m_width, x + radius + 1);
+
+        const uint64_t s = m_sum[bottom + right] - m_sum[top + right]
+                         - m_sum[bottom + left] + m_sum[top + left];
+        const uint64_t q = m_sumSq[bottom + right] - m_sumSq[top + right]
+                         - m_sumSq[bottom + left] + m_sumSq[top + left];
+
+        const double n = static_cast<double>((right - left) * rows);
+        const double m = static_cast<double>(s) / n;
+        const double v = static_cast<double>(q) / n - m * m;
+        variance[x] = static_cast<float>(v > 0.0 ? v : 0.0);
+    }
+}
+
+} // namespace Internal
+} // namespace HX
@@ -0,0 +1,108 @@
+// ============================================================================
+// box_filter.h
+// ============================================================================
+
+/**
+ * @file box_filter.h
+ * @brief O(1)-per-pixel box mean and local variance over square windows
+ * @version 2.1.0
+ *
+ * This header is INTERNAL to hubx.dll. Windows are clipped at the image
+ * border and divided by the number of pixels actually covered, so border
+ * pixels get the statistics of their valid neighbours rather than being
+ * skipped. Cost does not depend on the window size.
+ */
+
+#ifndef BOX_FILTER_H
+#define BOX_FILTER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace HX {
+namespace Internal {
+
+/**
+ * @brief Mean over a (2 * radius + 1)^2 window
+ * @param src Input image, width * height values
+ * @param width Image width
+ * @param height Image height
+ * @param radius Window radius (0 copies the input)
+ * @param mean Output image; must not overlap src
+ */
+void boxMean(const float* src, int width, int height, int radius, float* mean);
+
+/**
+ * @class IntegralMoments
+ * @brief Summed-area tables of x and x^2 for an 8 or 16-bit image
+ *
+ * Build once per frame, then query any window in four lookups per table.
+ * Sums are exact 64-bit integers; the tables take 16 bytes per pixel and
+ * keep their storage between builds of the same size. Shared by the
+ * adaptive dual-energy fusion and XIntegralImage ROI statistics.
+ */
+class IntegralMoments {
+public:
+    IntegralMoments() : m_width(0), m_height(0) {}
+
+    /**
+     * @brief Build the tables for an image
+     * @param src Input image, width * height values
+     * @param width Image width
+     * @param height Image height
+     */
+    void build(const unsigned short* src, int width, int height) {
+        build(reinterpret_cast<const uint8_t*>(src), static_cast<size_t>(width) * 2, 2, width, height);
+    }
+
+    /**
+     * @brief Build the tables for image rows with a stride
+     * @param src First pixel
+     * @param stride Bytes between the starts of consecutive rows
+     * @param bytesPerPixel 1 or 2
+     * @param width Image width
+     * @param height Image height
+     *
+     * Row prefix sums, then column prefix sums, each on the shared pool.
+     */
+    void build(const uint8_t* src, size_t stride, uint32_t bytesPerPixel, int width, int height);
+
+    /**
+     * @brief Sums over columns [x0, x1) of rows [y0, y1), inside the image
+     */
+    void window(int x0, int y0, int x1, int y1, uint64_t& sum, uint64_t& sumSq) const {
+        const size_t stride = static_cast<size_t>(m_width) + 1;
+        const size_t top = static_cast<size_t>(y0) * stride;
+        const size_t bottom = static_cast<size_t>(y1) * stride;
+        sum = m_sum[bottom + x1] - m_sum[top + x1] - m_sum[bottom + x0] + m_sum[top + x0];
+        sumSq = m_sumSq[bottom + x1] - m_sumSq[top + x1] - m_sumSq[bottom + x0] + m_sumSq[top + x0];
+    }
+
+    /**
+     * @brief Population variance of one row of clipped windows
+     * @param y Row
+     * @param radius Window radius
+     * @param variance Output, width() values
+     */
+    void varianceRow(int y, int radius, float* variance) const;
+
+    int width() const { return m_width; }
+    int height() const { return m_height; }
+
+    /// Table bytes, for memory profiling
+    uint64_t bytes() const {
+        return (m_sum.capacity() + m_sumSq.capacity()) * sizeof(uint64_t);
+    }
+
+private:
+    std::vector<uint64_t> m_sum;    ///< (width + 1) x (height + 1), zero first row/column
+    std::vector<uint64_t> m_sumSq;
+    int m_width;
+    int m_height;
+};
+
+} // namespace Internal
+} // namespace HX
+
+#endif // BOX_FILTER_H
@@ -0,0 +1,219 @@
+// ============================================================================
+// burst_packer.cpp
+// ============================================================================
+
+/**
+ * @file burst_packer.cpp
+ * @brief Packing workers of a compressed burst
+ * @version 2.1.0
+ *
+ * A worker packs its frame into a buffer of its own, so frames are packed
+ * side by side; only the append to the arena goes in capture order. The
+ * arena range is reserved under the lock and the copy runs outside it, so
+ * the assembly thread never waits for a copy to get a staging slot.
+ */
+
+#include "burst_packer.h"
+#include "delta_pack.h"
+#include <algorithm>
+#include <cstring>
+
+namespace HX {
+namespace Internal {
+
+BurstPacker::BurstPacker()
+    : m_arena(nullptr)
+    , m_arenaBytes(0)
+    , m_arenaUsed(0)
+    , m_nextCommit(0)
+    , m_submitted(0)
+    , m_busy(0)
+    , m_busyPeak(0)
+    , m_rawBytes(0)
+    , m_packedBytes(0)
+    , m_stalls(0)
+    , m_stopping(false)
+    , m_committed(0)
+    , m_full(false)
+{
+}
+
+BurstPacker::~BurstPacker() {
+    finish();
+}
+
+void BurstPacker::start(uint8_t* arena, size_t arenaBytes, uint32_t slots, uint32_t workers, uint32_t frames) {
+    finish();
+
+    m_arena = arena;
+    m_arenaBytes = arenaBytes;
+    m_arenaUsed = 0;
+    m_entries.assign(frames, Entry());
+    m_queue.clear();
+    m_freeSlots.clear();
+    for (uint32_t slot = slots; slot-- > 1;) {
+        m_freeSlots.push_back(slot);
+    }
+    m_nextCommit = 0;
+    m_submitted = 0;
+    m_busy = 0;
+    m_busyPeak = 0;
+    m_rawBytes = 0;
+    m_packedBytes = 0;
+    m_stalls = 0;
+    m_stopping = false;
+    m_committed = 0;
+    m_full = false;
+
+    for (uint32_t i = 0; i < std::max(workers, 1u); ++i) {
+        m_threads.push_back(std::thread(&BurstPacker::workerThread, this));
+    }
+}
+
+uint32_t BurstPacker::acquire(bool& stalled) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    stalled = m_freeSlots.empty();
+    if (stalled) {
+        m_stalls++;
+        m_slotCv.wait(lock, [this] { return !m_freeSlots.empty(); });
+    }
+    const uint32_t slot = m_freeSlots.back();
+    m_freeSlots.pop_back();
+    return slot;
+}
+
+void BurstPacker::submit(uint32_t slot, const uint8_t* pixels, uint32_t width, uint32_t rows,
+                         uint32_t stride, uint32_t bytesPerPixel) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        Job job = { slot, m_submitted++, pixels, width, rows, stride, bytesPerPixel };
+        m_queue.push_back(job);
+        m_busy++;
+        m_busyPeak = std::max(m_busyPeak, m_busy);
+    }
+    m_workCv.notify_one();
+}
+
+void BurstPacker::finish() {
+    if (m_threads.empty()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_workCv.notify_all();
+    for (size_t i = 0; i < m_threads.size(); ++i) {
+        m_threads[i].join();
+    }
+    m_threads.clear();
+}
+
+void BurstPacker::reset() {
+    finish();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_arena = nullptr;
+    m_arenaBytes = 0;
+    m_arenaUsed = 0;
+    m_entries.clear();
+    m_committed = 0;
+    m_full = false;
+}
+
+bool BurstPacker::decode(uint32_t index, uint32_t stride, uint8_t* pixels) const {
+    if (index >= frames()) {
+        return false;
+    }
+    // Entries below m_committed are never written again
+    const Entry& entry = m_entries[index];
+    return DeltaPackDecode(m_arena + entry.offset, entry.size, entry.width, entry.rows, stride,
+                           entry.bytesPerPixel, pixels);
+}
+
+uint64_t BurstPacker::stalls() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stalls;
+}
+
+void BurstPacker::stats(Stats& out) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    out.submitted = m_submitted;
+    out.packed = m_committed.load(std::memory_order_relaxed);
+    out.backlog = m_busy;
+    out.backlogPeak = m_busyPeak;
+    out.rawBytes = m_rawBytes;
+    out.packedBytes = m_packedBytes;
+    out.arenaBytes = m_arenaBytes;
+    out.stalls = m_stalls;
+    out.full = m_full.load(std::memory_order_relaxed);
+}
+
+void BurstPacker::workerThread() {
+    std::vector<uint8_t> packed;
+
+    for (;;) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_workCv.wait(lock, [this] { return m_stopping || !m_queue.empty(); });
+            if (m_queue.empty()) {
+                // Stopping, and every queued frame was packed
+                return;
+            }
+            job = m_queue.front();
+            m_queue.pop_front();
+        }
+
+        const size_t rawBytes = static_cast<size_t>(job.width) * job.rows * job.bytesPerPixel;
+        packed.resize(DeltaPackBound(static_cast<size_t>(job.width) * job.rows));
+        const size_t size = DeltaPackEncode(job.pixels, job.width, job.rows, job.stride,
+                                            job.bytesPerPixel, packed.data());
+
+        // Reserve in capture order; the staging frame is free once packed
+        size_t offset = 0;
+        bool kept = false;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_freeSlots.push_back(job.slot);
+            m_slotCv.notify_one();
+
+            m_commitCv.wait(lock, [this, &job] { return m_nextCommit == job.index; });
+            if (!m_full.load(std::memory_order_relaxed) && size > 0 &&
+                job.index < m_entries.size() && size <= m_arenaBytes - m_arenaUsed) {
+                offset = m_arenaUsed;
+                m_arenaUsed += size;
+                Entry entry = { offset, size, job.width, job.rows, job.bytesPerPixel };
+                m_entries[job.index] = entry;
+                kept = true;
+            } else {
+                // Every later frame is dropped too, so the packed ones stay contiguous
+                m_full.store(true, std::memory_order_release);
+            }
+            m_nextCommit++;
+            if (!kept) {
+                m_busy--;
+            }
+        }
+        m_commitCv.notify_all();
+        if (!kept) {
+            continue;
+        }
+
+        memcpy(m_arena + offset, packed.data(), size);
+
+        {
+            // Readable once every earlier frame is copied in as well
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_commitCv.wait(lock, [this, &job] { return m_committed.load(std::memory_order_relaxed) == job.index; });
+            m_committed.store(job.index + 1, std::memory_order_release);
+            m_rawBytes += rawBytes;
+            m_packedBytes += size;
+            m_busy--;
+        }
+        m_commitCv.notify_all();
+    }
+}
+
+} // namespace Internal
+} // namespace HX
@@ -0,0 +1,170 @@
+// ============================================================================
+// burst_packer.h
+// ============================================================================
+
+/**
+ * @file burst_packer.h
+ * @brief Lossless packing of burst frames into a RAM arena while capturing
+ * @version 2.1.0
+ *
+ * This header is INTERNAL to hubx.dll. A compressed burst lands its lines
+ * in a few staging frames; each completed frame is handed to a worker
+ * thread that delta-packs it (delta_pack.h) and appends it to one
+ * preallocated arena, after which its staging frame is free again. Frames
+ * are appended in capture order, so the readable frames are always the
+ * first frames() of the burst; once a frame does not fit, the arena is
+ * full and no later frame is kept.
+ */
+
+#ifndef BURST_PACKER_H
+#define BURST_PACKER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace HX {
+namespace Internal {
+
+/**
+ * @class BurstPacker
+ * @brief Staging slots, packing workers and the arena of one burst
+ */
+class BurstPacker {
+public:
+    BurstPacker();
+    ~BurstPacker();
+
+    /**
+     * @brief Start a burst
+     * @param arena Arena, faulted in already (not owned)
+     * @param arenaBytes Arena size
+     * @param slots Staging frames; slot 0 is taken for the first frame
+     * @param workers Packing threads
+     * @param frames Frames in the burst
+     */
+    void start(uint8_t* arena, size_t arenaBytes, uint32_t slots, uint32_t workers, uint32_t frames);
+
+    /**
+     * @brief Get a free staging slot for the next frame
+     * @param stalled Set if every slot was still being packed and the
+     *        call had to wait for a worker
+     * @return Slot index
+     */
+    uint32_t acquire(bool& stalled);
+
+    /**
+     * @brief Queue a completed frame; it keeps its slot until it is packed
+     * @param slot Slot from acquire() (or slot 0 for the first frame)
+     * @param pixels First row of the frame
+     * @param width Pixels per row
+     * @param rows Rows
+     * @param stride Bytes between row starts
+     * @param bytesPerPixel Container size (1-4)
+     */
+    void submit(uint32_t slot, const uint8_t* pixels, uint32_t width, uint32_t rows,
+                uint32_t stride, uint32_t bytesPerPixel);
+
+    /**
+     * @brief Pack every queued frame and stop the workers
+     */
+    void finish();
+
+    /**
+     * @brief Forget the packed frames (the arena is about to be freed)
+     */
+    void reset();
+
+    bool running() const { return !m_threads.empty(); }
+
+    /// Frames packed and readable, from the first one of the burst
+    uint32_t frames() const { return m_committed.load(std::memory_order_acquire); }
+
+    /// A frame did not fit: the burst is over
+    bool full() const { return m_full.load(std::memory_order_acquire); }
+
+    /// Calls to acquire() that had to wait
+    uint64_t stalls() const;
+
+    /**
+     * @brief Unpack a frame
+     * @param index Frame below frames()
+     * @param stride Bytes between output row starts
+     * @param pixels First output row
+     * @return false past the packed frames or if the data is damaged
+     */
+    bool decode(uint32_t index, uint32_t stride, uint8_t* pixels) const;
+
+    /**
+     * @brief Live counters
+     */
+    struct Stats {
+        uint32_t submitted;
+        uint32_t packed;
+        uint32_t backlog;           ///< Frames queued or being packed now
+        uint32_t backlogPeak;
+        uint64_t rawBytes;          ///< Of the packed frames
+        uint64_t packedBytes;
+        uint64_t arenaBytes;
+        uint64_t stalls;
+        bool full;
+    };
+    void stats(Stats& out) const;
+
+private:
+    struct Job {
+        uint32_t slot;
+        uint32_t index;
+        const uint8_t* pixels;
+        uint32_t width;
+        uint32_t rows;
+        uint32_t stride;
+        uint32_t bytesPerPixel;
+    };
+    struct Entry {
+        size_t offset;
+        size_t size;
+        uint32_t width;
+        uint32_t rows;
+        uint32_t bytesPerPixel;
+    };
+
+    void workerThread();
+
+    uint8_t* m_arena;
+    size_t m_arenaBytes;
+    size_t m_arenaUsed;                     ///< Guarded by m_mutex
+    std::vector<Entry> m_entries;           ///< Per burst frame, valid below m_committed
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_workCv;       ///< Job queued or stopping
+    std::condition_variable m_slotCv;       ///< Slot freed
+    std::condition_variable m_commitCv;     ///< m_nextCommit moved
+    std::deque<Job> m_queue;
+    std::vector<uint32_t> m_freeSlots;
+    uint32_t m_nextCommit;                  ///< Frame whose turn it is to append
+    uint32_t m_submitted;
+    uint32_t m_busy;                        ///< Jobs queued or in a worker
+    uint32_t m_busyPeak;
+    uint64_t m_rawBytes;
+    uint64_t m_packedBytes;
+    uint64_t m_stalls;
+    bool m_stopping;
+    std::atomic<uint32_t> m_committed;
+    std::atomic<bool> m_full;
+    std::vector<std::thread> m_threads;
+
+    // Non-copyable
+    BurstPacker(const BurstPacker&) = delete;
+    BurstPacker& operator=(const BurstPacker&) = delete;
+};
+
+} // namespace Internal
+} // namespace HX
+
+#endif // BURST_PACKER_H
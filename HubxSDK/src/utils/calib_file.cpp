@@ -0,0 +1,648 @@
+// ============================================================================
+// calib_file.cpp
+// ============================================================================
+
+/**
+ * @file calib_file.cpp
+ * @brief Calibration container implementation
+ * @version 2.1.0
+ */
+
+#include "calib_file.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace HX {
+namespace Internal {
+
+namespace {
+
+const char CALIB_MAGIC[8] = { 'H', 'X', 'C', 'A', 'L', 'I', 'B', '\0' };
+
+// Full files keep the first version, which every reader accepts
+const uint32_t CALIB_VERSION_FULL = 1;
+
+struct Crc32Table {
+    uint32_t entries[256];
+
+    Crc32Table() {
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) {
+                c = (c & 1) ? (0xEDB88320u ^ (c >> 1)) : (c >> 1);
+            }
+            entries[i] = c;
+        }
+    }
+};
+
+inline uint64_t alignUp(uint64_t value, uint64_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+uint32_t headerCrc(const CalibFileHeader& header, const CalibSection* toc, uint32_t count) {
+    CalibFileHeader copy = header;
+    copy.headerCrc = 0;
+    uint32_t crc = Crc32(&copy, sizeof(copy));
+    return Crc32(toc, sizeof(CalibSection) * count, crc);
+}
+
+// CRC over tag, element size, size and CRC of every section, in tag order,
+// so it depends on the content only, not on layout or on delta layering
+uint32_t contentIdentity(std::vector<CalibSection> toc) {
+    std::sort(toc.begin(), toc.end(), [](const CalibSection& a, const CalibSection& b) {
+        return a.tag < b.tag;
+    });
+    uint32_t crc = 0;
+    for (size_t i = 0; i < toc.size(); ++i) {
+        crc = Crc32(&toc[i].tag, sizeof(toc[i].tag), crc);
+        crc = Crc32(&toc[i].elementSize, sizeof(toc[i].elementSize), crc);
+        crc = Crc32(&toc[i].size, sizeof(toc[i].size), crc);
+        crc = Crc32(&toc[i].crc, sizeof(toc[i].crc), crc);
+    }
+    return crc;
+}
+
+bool writeAll(FILE* file, const void* data, size_t size) {
+    return size == 0 || fwrite(data, 1, size, file) == size;
+}
+
+bool writeZeros(FILE* file, uint64_t count) {
+    static const uint8_t zeros[CALIB_PAGE] = {};
+    while (count > 0) {
+        size_t chunk = count < CALIB_PAGE ? static_cast<size_t>(count) : CALIB_PAGE;
+        if (!writeAll(file, zeros, chunk)) {
+            return false;
+        }
+        count -= chunk;
+    }
+    return true;
+}
+
+bool seekTo(FILE* file, uint64_t offset) {
+#ifdef _WIN32
+    return _fseeki64(file, static_cast<__int64>(offset), SEEK_SET) == 0;
+#else
+    return fseeko(file, static_cast<off_t>(offset), SEEK_SET) == 0;
+#endif
+}
+
+bool replaceFile(const std::string& from, const char* to) {
+#ifdef _WIN32
+    return MoveFileExA(from.c_str(), to, MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    return rename(from.c_str(), to) == 0;
+#endif
+}
+
+} // namespace
+
+uint32_t Crc32(const void* data, size_t size, uint32_t crc) {
+    static const Crc32Table table;
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    crc = ~crc;
+    for (size_t i = 0; i < size; ++i) {
+        crc = table.entries[(crc ^ p[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+// ============================================================================
+// CalibFileWriter
+// ============================================================================
+
+CalibFileWriter::CalibFileWriter(uint32_t module)
+    : m_module(module)
+{
+}
+
+void CalibFileWriter::AddSection(uint32_t tag, const void* data, size_t size, uint32_t elementSize) {
+    Pending p;
+    p.tag = tag;
+    p.elementSize = elementSize ? elementSize : 1;
+    p.data = data;
+    p.size = data ? size : 0;
+    p.crc = 0;
+    m_sections.push_back(p);
+}
+
+bool CalibFileWriter::Write(const char* filename) const {
+    std::vector<Pending> sections(m_sections);
+    for (size_t i = 0; i < sections.size(); ++i) {
+        sections[i].crc = Crc32(sections[i].data, sections[i].size);
+    }
+    return WriteSections(filename, sections, 0, 0, 0);
+}
+
+bool CalibFileWriter::WriteDelta(const char* filename, const CalibFile& base) const {
+    if (base.Layers() == 0 || base.Module() != m_module) {
+        return false;
+    }
+
+    // The result is the base's table with the changed entries replaced
+    std::vector<CalibSection> result(base.m_toc.size());
+    for (size_t k = 0; k < result.size(); ++k) {
+        result[k] = base.m_toc[k].section;
+    }
+
+    std::vector<Pending> changed;
+    for (size_t i = 0; i < m_sections.size(); ++i) {
+        Pending p = m_sections[i];
+        p.crc = Crc32(p.data, p.size);
+        size_t k = 0;
+        while (k < result.size() && result[k].tag != p.tag) {
+            ++k;
+        }
+        if (k < result.size() && result[k].size == p.size &&
+            result[k].elementSize == p.elementSize && result[k].crc == p.crc) {
+            continue;
+        }
+        if (k == result.size()) {
+            result.push_back(CalibSection());
+        }
+        result[k].tag = p.tag;
+        result[k].elementSize = p.elementSize;
+        result[k].size = p.size;
+        result[k].crc = p.crc;
+        changed.push_back(p);
+    }
+    return WriteSections(filename, changed, CALIB_FLAG_DELTA, base.Identity(), contentIdentity(result));
+}
+
+bool CalibFileWriter::WriteSections(const char* filename, const std::vector<Pending>& sections,
+                                    uint32_t flags, uint32_t baseCrc, uint32_t resultCrc) const {
+    if (!filename) {
+        return false;
+    }
+
+    const uint32_t count = static_cast<uint32_t>(sections.size());
+    std::vector<CalibSection> toc(count);
+
+    uint64_t offset = alignUp(sizeof(CalibFileHeader) + sizeof(CalibSection) * count, CALIB_PAGE);
+    for (uint32_t i = 0; i < count; ++i) {
+        const Pending& p = sections[i];
+        CalibSection& s = toc[i];
+        std::memset(&s, 0, sizeof(s));
+        s.tag = p.tag;
+        s.elementSize = p.elementSize;
+        s.offset = offset;
+        s.size = p.size;
+        s.crc = p.crc;
+        offset = alignUp(offset + p.size, CALIB_PAGE);
+    }
+
+    CalibFileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, CALIB_MAGIC, sizeof(header.magic));
+    header.version = (flags & CALIB_FLAG_DELTA) ? CALIB_VERSION_DELTA : CALIB_VERSION_FULL;
+    header.headerSize = sizeof(CalibFileHeader);
+    header.module = m_module;
+    header.sectionCount = count;
+    header.fileSize = count ? toc[count - 1].offset + toc[count - 1].size : sizeof(CalibFileHeader);
+    header.flags = flags;
+    header.baseCrc = baseCrc;
+    header.resultCrc = (flags & CALIB_FLAG_DELTA) ? resultCrc : contentIdentity(toc);
+    header.headerCrc = headerCrc(header, toc.data(), count);
+
+    const std::string temp = std::string(filename) + ".tmp";
+    FILE* file = fopen(temp.c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+
+    bool ok = writeAll(file, &header, sizeof(header)) &&
+              writeAll(file, toc.data(), sizeof(CalibSection) * count);
+    uint64_t position = sizeof(header) + sizeof(CalibSection) * count;
+    for (uint32_t i = 0; ok && i < count; ++i) {
+        ok = writeZeros(file, toc[i].offset - position) &&
+             writeAll(file, sections[i].data, sections[i].size);
+        position = toc[i].offset + toc[i].size;
+    }
+
+    ok = (fflush(file) == 0) && ok;
+    ok = (fclose(file) == 0) && ok;
+    if (!ok || !replaceFile(temp, filename)) {
+        remove(temp.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool CalibFileWriter::Update(const char* filename) const {
+    if (!filename) {
+        return false;
+    }
+
+    FILE* file = fopen(filename, "r+b");
+    if (!file) {
+        return false;
+    }
+
+    CalibFileHeader header;
+    bool ok = fread(&header, 1, sizeof(header), file) == sizeof(header) &&
+              std::memcmp(header.magic, CALIB_MAGIC, sizeof(header.magic)) == 0 &&
+              header.version != 0 && header.version <= CALIB_VERSION &&
+              header.headerSize >= sizeof(CalibFileHeader) && header.module == m_module &&
+              (header.version < CALIB_VERSION_DELTA || !(header.flags & CALIB_FLAG_DELTA));
+
+    std::vector<CalibSection> toc;
+    if (ok) {
+        toc.resize(header.sectionCount);
+        ok = seekTo(file, header.headerSize) &&
+             (toc.empty() || fread(toc.data(), sizeof(CalibSection), toc.size(), file) == toc.size()) &&
+             headerCrc(header, toc.data(), header.sectionCount) == header.headerCrc;
+    }
+
+    // Every section must exist with its size before one byte is written
+    std::vector<size_t> targets(m_sections.size());
+    for (size_t i = 0; ok && i < m_sections.size(); ++i) {
+        ok = false;
+        for (size_t k = 0; k < toc.size(); ++k) {
+            if (toc[k].tag == m_sections[i].tag) {
+                ok = toc[k].size == m_sections[i].size;
+                targets[i] = k;
+                break;
+            }
+        }
+    }
+
+    for (size_t i = 0; ok && i < m_sections.size(); ++i) {
+        CalibSection& s = toc[targets[i]];
+        ok = seekTo(file, s.offset) && writeAll(file, m_sections[i].data, m_sections[i].size);
+        s.crc = Crc32(m_sections[i].data, m_sections[i].size);
+    }
+
+    // Table and header last, so an interrupted update fails its checksums
+    if (ok) {
+        if (header.version >= CALIB_VERSION_DELTA) {
+            header.resultCrc = contentIdentity(toc);
+        }
+        header.headerCrc = headerCrc(header, toc.data(), header.sectionCount);
+        ok = seekTo(file, header.headerSize) &&
+             writeAll(file, toc.data(), sizeof(CalibSection) * toc.size()) &&
+             seekTo(file, 0) && writeAll(file, &header, sizeof(header));
+    }
+
+    ok = (fflush(file) == 0) && ok;
+    ok = (fclose(file) == 0) && ok;
+    return ok;
+}
+
+// ============================================================================
+// CalibFile
+// ============================================================================
+
+CalibFile::Layer::Layer()
+    : base(nullptr)
+    , size(0)
+    , mapped(false)
+#ifdef _WIN32
+    , fileHandle(nullptr)
+    , mapHandle(nullptr)
+#endif
+{
+}
+
+CalibFile::CalibFile()
+    : m_module(0)
+    , m_version(0)
+    , m_identity(0)
+    , m_baseIdentity(0)
+    , m_verify(true)
+{
+}
+
+CalibFile::~CalibFile() {
+    Close();
+}
+
+bool CalibFile::IsContainer(const char* filename) {
+    if (!filename) {
+        return false;
+    }
+    FILE* file = fopen(filename, "rb");
+    if (!file) {
+        return false;
+    }
+    char magic[8];
+    bool match = fread(magic, 1, sizeof(magic), file) == sizeof(magic) &&
+                 std::memcmp(magic, CALIB_MAGIC, sizeof(magic)) == 0;
+    fclose(file);
+    return match;
+}
+
+bool CalibFile::fail(const char* msg) {
+    Close();
+    m_error = msg;
+    return false;
+}
+
+void CalibFile::closeLayer(Layer& layer) {
+    if (layer.mapped && layer.base) {
+#ifdef _WIN32
+        UnmapViewOfFile(layer.base);
+#else
+        munmap(const_cast<uint8_t*>(layer.base), layer.size);
+#endif
+    }
+#ifdef _WIN32
+    if (layer.mapHandle) {
+        CloseHandle(layer.mapHandle);
+        layer.mapHandle = nullptr;
+    }
+    if (layer.fileHandle) {
+        CloseHandle(layer.fileHandle);
+        layer.fileHandle = nullptr;
+    }
+#endif
+    layer.base = nullptr;
+    layer.size = 0;
+    layer.mapped = false;
+    layer.buffer.clear();
+    layer.buffer.shrink_to_fit();
+}
+
+void CalibFile::Close() {
+    for (size_t i = 0; i < m_layers.size(); ++i) {
+        closeLayer(m_layers[i]);
+    }
+    m_layers.clear();
+    m_toc.clear();
+    m_module = 0;
+    m_version = 0;
+    m_identity = 0;
+    m_baseIdentity = 0;
+}
+
+// Map one file and validate its header and table; on failure the layer is
+// closed, m_error says why and the view is untouched
+bool CalibFile::openLayer(const char* filename, uint32_t module, Layer& layer,
+                          CalibFileHeader& header, std::vector<CalibSection>& toc) {
+    const char* error = nullptr;
+    if (!filename) {
+        m_error = "no file name";
+        return false;
+    }
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, nullptr,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        m_error = "cannot open file";
+        return false;
+    }
+    layer.fileHandle = file;
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize)) {
+        closeLayer(layer);
+        m_error = "cannot stat file";
+        return false;
+    }
+    layer.size = static_cast<size_t>(fileSize.QuadPart);
+    if (layer.size > 0) {
+        layer.mapHandle = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (layer.mapHandle) {
+            layer.base = static_cast<const uint8_t*>(MapViewOfFile(layer.mapHandle, FILE_MAP_READ, 0, 0, 0));
+            layer.mapped = layer.base != nullptr;
+        }
+    }
+#else
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        m_error = "cannot open file";
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        ::close(fd);
+        m_error = "cannot stat file";
+        return false;
+    }
+    layer.size = static_cast<size_t>(st.st_size);
+    if (layer.size > 0) {
+        void* p = mmap(nullptr, layer.size, PROT_READ, MAP_SHARED, fd, 0);
+        if (p != MAP_FAILED) {
+            layer.base = static_cast<const uint8_t*>(p);
+            layer.mapped = true;
+        }
+    }
+    ::close(fd);
+#endif
+
+    if (!layer.mapped && layer.size > 0) {
+        // Read fallback (e.g. file systems without mmap support)
+        const size_t size = layer.size;
+        FILE* f = fopen(filename, "rb");
+        if (f) {
+            layer.buffer.resize(size);
+            if (fread(layer.buffer.data(), 1, size, f) == size) {
+                layer.base = layer.buffer.data();
+            } else {
+                error = "short read";
+            }
+            fclose(f);
+        } else {
+            error = "cannot open file";
+        }
+    }
+
+    if (!error && layer.size < sizeof(CalibFileHeader)) {
+        error = "file too small";
+    }
+    if (!error) {
+        std::memcpy(&header, layer.base, sizeof(header));
+        if (std::memcmp(header.magic, CALIB_MAGIC, sizeof(header.magic)) != 0) {
+            error = "not a calibration container";
+        } else if (header.version == 0 || header.version > CALIB_VERSION) {
+            error = "unsupported container version";
+        } else if (header.headerSize < sizeof(CalibFileHeader)) {
+            error = "bad header size";
+        } else if (module != 0 && header.module != module) {
+            error = "file belongs to another module";
+        } else if (header.fileSize > layer.size) {
+            error = "file truncated";
+        }
+    }
+
+    uint64_t tocEnd = 0;
+    if (!error) {
+        tocEnd = static_cast<uint64_t>(header.headerSize) +
+                 static_cast<uint64_t>(header.sectionCount) * sizeof(CalibSection);
+        if (tocEnd > layer.size) {
+            error = "table of contents truncated";
+        }
+    }
+    if (!error) {
+        toc.resize(header.sectionCount);
+        if (header.sectionCount) {
+            std::memcpy(toc.data(), layer.base + header.headerSize,
+                        sizeof(CalibSection) * header.sectionCount);
+        }
+
+        // Header CRC covers the fields this version knows about plus the table
+        if (headerCrc(header, toc.data(), header.sectionCount) != header.headerCrc) {
+            error = "header checksum mismatch";
+        }
+        if (header.version < CALIB_VERSION_DELTA) {
+            header.flags = 0;
+            header.baseCrc = 0;
+            header.resultCrc = 0;
+        }
+    }
+    for (size_t i = 0; !error && i < toc.size(); ++i) {
+        const CalibSection& s = toc[i];
+        if (s.offset < tocEnd || s.offset > layer.size || s.size > layer.size - s.offset) {
+            error = "section outside file";
+        }
+    }
+
+    if (error) {
+        closeLayer(layer);
+        m_error = error;
+        return false;
+    }
+    return true;
+}
+
+bool CalibFile::Open(const char* filename, uint32_t module, bool verify) {
+    return openView(filename, module, verify, false);
+}
+
+bool CalibFile::OpenDelta(const char* filename, uint32_t module, bool verify) {
+    return openView(filename, module, verify, true);
+}
+
+bool CalibFile::openView(const char* filename, uint32_t module, bool verify, bool delta) {
+    Close();
+    m_error.clear();
+
+    Layer layer;
+    CalibFileHeader header;
+    std::vector<CalibSection> toc;
+    if (!openLayer(filename, module, layer, header, toc)) {
+        return false;
+    }
+    if (((header.flags & CALIB_FLAG_DELTA) != 0) != delta) {
+        closeLayer(layer);
+        return fail(delta ? "not a delta file" : "delta file needs its base");
+    }
+
+    m_toc.resize(toc.size());
+    for (size_t i = 0; i < toc.size(); ++i) {
+        m_toc[i].section = toc[i];
+        m_toc[i].data = layer.base + toc[i].offset;
+        m_toc[i].checked = 0;
+    }
+    m_layers.push_back(std::move(layer));
+    m_module = header.module;
+    m_version = header.version;
+    m_identity = delta ? header.resultCrc : contentIdentity(toc);
+    m_baseIdentity = delta ? header.baseCrc : 0;
+    m_verify = verify;
+    return true;
+}
+
+bool CalibFile::ApplyDelta(const char* filename) {
+    m_error.clear();
+    if (m_layers.empty() || m_baseIdentity != 0) {
+        m_error = "no base file open";
+        return false;
+    }
+
+    Layer layer;
+    CalibFileHeader header;
+    std::vector<CalibSection> toc;
+    if (!openLayer(filename, m_module, layer, header, toc)) {
+        return false;
+    }
+    if (!(header.flags & CALIB_FLAG_DELTA) || header.baseCrc != m_identity) {
+        closeLayer(layer);
+        m_error = (header.flags & CALIB_FLAG_DELTA) ? "delta belongs to another base"
+                                                    : "not a delta file";
+        return false;
+    }
+
+    std::vector<Entry> merged(m_toc);
+    for (size_t i = 0; i < toc.size(); ++i) {
+        Entry entry;
+        entry.section = toc[i];
+        entry.data = layer.base + toc[i].offset;
+        entry.checked = 0;
+        size_t k = 0;
+        while (k < merged.size() && merged[k].section.tag != toc[i].tag) {
+            ++k;
+        }
+        if (k < merged.size()) {
+            merged[k] = entry;
+        } else {
+            merged.push_back(entry);
+        }
+    }
+
+    std::vector<CalibSection> result(merged.size());
+    for (size_t k = 0; k < merged.size(); ++k) {
+        result[k] = merged[k].section;
+    }
+    if (contentIdentity(result) != header.resultCrc) {
+        closeLayer(layer);
+        m_error = "delta does not produce the content it was written for";
+        return false;
+    }
+
+    // Moving the layer keeps its mapping and buffer where they are
+    m_toc.swap(merged);
+    m_layers.push_back(std::move(layer));
+    m_version = std::max(m_version, header.version);
+    m_identity = header.resultCrc;
+    return true;
+}
+
+const CalibFile::Entry* CalibFile::find(uint32_t tag) const {
+    for (size_t i = 0; i < m_toc.size(); ++i) {
+        const Entry& e = m_toc[i];
+        if (e.section.tag != tag) {
+            continue;
+        }
+        if (m_verify && e.checked == 0) {
+            e.checked = Crc32(e.data, static_cast<size_t>(e.section.size)) == e.section.crc ? 1 : -1;
+        }
+        return e.checked < 0 ? nullptr : &e;
+    }
+    return nullptr;
+}
+
+const void* CalibFile::Section(uint32_t tag, size_t* size) const {
+    const Entry* e = find(tag);
+    if (size) {
+        *size = e ? static_cast<size_t>(e->section.size) : 0;
+    }
+    return e ? e->data : nullptr;
+}
+
+const void* CalibFile::SectionExact(uint32_t tag, size_t expectedSize) const {
+    size_t size = 0;
+    const void* data = Section(tag, &size);
+    return (data && size == expectedSize) ? data : nullptr;
+}
+
+bool CalibFile::SectionInfo(uint32_t tag, CalibSection& info) const {
+    const Entry* e = find(tag);
+    if (!e) {
+        return false;
+    }
+    info = e->section;
+    return true;
+}
+
+} // namespace Internal
+} // namespace HX
@@ -0,0 +1,336 @@
+// ============================================================================
+// calib_file.h
+// ============================================================================
+
+/**
+ * @file calib_file.h
+ * @brief Versioned, memory-mappable calibration container
+ * @version 2.1.0
+ *
+ * This header is INTERNAL to hubx.dll. All correction modules store their
+ * tables in one layout:
+ *
+ *   CalibFileHeader   64 bytes, magic "HXCALIB\0"
+ *   CalibSection[n]   table of contents, 32 bytes per entry
+ *   section data      each section starts on a CALIB_PAGE boundary
+ *
+ * Values are stored in native byte order. Every section carries a CRC-32
+ * and the header carries one over itself and the table, so truncated or
+ * corrupted files are rejected instead of silently loading garbage.
+ * Because sections are page aligned, a mapped file can hand out pointers
+ * straight into the page cache; nothing is read until it is touched, and
+ * section CRCs are checked on first lookup, so a load that needs a few
+ * sections of a large file reads only those.
+ *
+ * A delta file has the same layout but holds only the sections that
+ * changed relative to a base. Files are identified by content, a CRC over
+ * the tags and CRCs of their sections, so a delta applies to any file or
+ * view with the base's content: the base itself, the base with earlier
+ * deltas applied, or a full file saved from the same calibration.
+ */
+
+#ifndef CALIB_FILE_H
+#define CALIB_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace HX {
+namespace Internal {
+
+/// Current container version; readers accept versions up to this one
+static const uint32_t CALIB_VERSION = 2;
+
+/// Version delta files are written with; full files are still written as 1
+/// so readers that predate deltas keep loading them
+static const uint32_t CALIB_VERSION_DELTA = 2;
+
+/// CalibFileHeader::flags: the file holds the changes to its base only
+static const uint32_t CALIB_FLAG_DELTA = 1u << 0;
+
+/// Section alignment in the file (a page on every supported platform)
+static const uint32_t CALIB_PAGE = 4096;
+
+/// Build a section tag from four characters, e.g. CalibTag('G','A','I','N')
+inline uint32_t CalibTag(char a, char b, char c, char d) {
+    return static_cast<uint32_t>(static_cast<uint8_t>(a))
+        | (static_cast<uint32_t>(static_cast<uint8_t>(b)) << 8)
+        | (static_cast<uint32_t>(static_cast<uint8_t>(c)) << 16)
+        | (static_cast<uint32_t>(static_cast<uint8_t>(d)) << 24);
+}
+
+#pragma pack(push, 1)
+
+/**
+ * @brief File header
+ */
+struct CalibFileHeader {
+    char     magic[8];          ///< "HXCALIB\0"
+    uint32_t version;           ///< CALIB_VERSION at write time
+    uint32_t headerSize;        ///< sizeof(CalibFileHeader)
+    uint32_t module;            ///< Writing module tag (CalibTag)
+    uint32_t sectionCount;      ///< Entries in the table of contents
+    uint64_t fileSize;          ///< Total file size in bytes
+    uint32_t headerCrc;         ///< CRC-32 of header and table, this field as 0
+    uint32_t flags;             ///< CALIB_FLAG_* (zero before version 2)
+    uint32_t baseCrc;           ///< Delta files: CalibFile::Identity() they apply to
+    uint32_t resultCrc;         ///< Identity() of the content once applied
+    uint8_t  reserved[16];      ///< Zero
+};
+
+/**
+ * @brief Table of contents entry
+ */
+struct CalibSection {
+    uint32_t tag;               ///< Section tag (CalibTag)
+    uint32_t elementSize;       ///< Bytes per element (1 for raw blobs)
+    uint64_t offset;            ///< Byte offset from file start, CALIB_PAGE aligned
+    uint64_t size;              ///< Payload size in bytes
+    uint32_t crc;               ///< CRC-32 of the payload
+    uint32_t reserved;          ///< Zero
+};
+
+#pragma pack(pop)
+
+/**
+ * @brief CRC-32 (IEEE 802.3, reflected)
+ * @param data Input bytes
+ * @param size Number of bytes
+ * @param crc Running value from a previous call, 0 to start
+ */
+uint32_t Crc32(const void* data, size_t size, uint32_t crc = 0);
+
+class CalibFile;
+
+/**
+ * @class CalibFileWriter
+ * @brief Collects sections and writes them as one container
+ *
+ * Section data is referenced, not copied; it must stay valid until Write().
+ */
+class CalibFileWriter {
+public:
+    explicit CalibFileWriter(uint32_t module);
+
+    /**
+     * @brief Add a section
+     * @param tag Section tag, unique within the file
+     * @param data Payload
+     * @param size Payload size in bytes
+     * @param elementSize Bytes per element, recorded for readers
+     */
+    void AddSection(uint32_t tag, const void* data, size_t size, uint32_t elementSize = 1);
+
+    /**
+     * @brief Write the container
+     * @return true if every byte reached the file
+     *
+     * @note The file is written under a temporary name and renamed, so an
+     *       existing calibration survives a failed write.
+     */
+    bool Write(const char* filename) const;
+
+    /**
+     * @brief Write only the sections that differ from @p base
+     * @param base Open view the delta applies to (a file, or a file with deltas)
+     * @return true if every byte reached the file
+     *
+     * A section is left out when @p base has the same tag with the same
+     * size, element size and CRC. Sections of @p base that were not added
+     * stay as they are; a delta cannot remove one.
+     */
+    bool WriteDelta(const char* filename, const CalibFile& base) const;
+
+    /**
+     * @brief Rewrite the added sections inside an existing container
+     * @return true if every section was found with its size and rewritten
+     *
+     * Each added tag must already be in the file with the same payload size;
+     * the file is checked before anything is written, and only those
+     * payloads, the table of contents and the header change. Used to update
+     * one detector module in a large calibration.
+     *
+     * @note Unlike Write() this is in place: an interrupted update leaves a
+     *       file whose checksums no longer match, which Open() rejects.
+     */
+    bool Update(const char* filename) const;
+
+private:
+    struct Pending {
+        uint32_t tag;
+        uint32_t elementSize;
+        const void* data;
+        size_t size;
+        uint32_t crc;
+    };
+
+    bool WriteSections(const char* filename, const std::vector<Pending>& sections,
+                       uint32_t flags, uint32_t baseCrc, uint32_t resultCrc) const;
+
+    uint32_t m_module;
+    std::vector<Pending> m_sections;
+};
+
+/**
+ * @class CalibFile
+ * @brief Read-only view of a container, memory-mapped where possible
+ *
+ * Section pointers stay valid until Close() or destruction. If mapping
+ * fails the file is read into memory instead; callers see no difference.
+ * Lookups record which sections were verified, so one instance must not
+ * be shared between threads.
+ */
+class CalibFile {
+public:
+    CalibFile();
+    ~CalibFile();
+
+    /**
+     * @brief Check whether a file starts with the container magic
+     *
+     * Lets modules fall back to their pre-container layouts.
+     */
+    static bool IsContainer(const char* filename);
+
+    /**
+     * @brief Open and validate a container
+     * @param filename File path
+     * @param module Expected module tag (0 = any)
+     * @param verify Check each section's CRC when it is first looked up;
+     *        a section that fails is reported absent (header CRC is always
+     *        checked at open)
+     * @return true on success; on failure Error() says why
+     *
+     * Delta files cannot be opened on their own; open the base and
+     * ApplyDelta() them.
+     */
+    bool Open(const char* filename, uint32_t module = 0, bool verify = true);
+
+    /**
+     * @brief Lay a delta file over the open view
+     * @return true on success; on failure Error() says why and the view
+     *         is unchanged
+     *
+     * The delta must belong to the same module and name Identity() as its
+     * base, and the result must have the identity it recorded. Its
+     * sections replace those with the same tag; new tags are added. Only
+     * the delta is mapped, the base stays as it was.
+     */
+    bool ApplyDelta(const char* filename);
+
+    /**
+     * @brief Open a delta file by itself, to see what it changes
+     *
+     * Section() then returns only the changed sections. Used by owners
+     * that keep the base in memory rather than mapped.
+     */
+    bool OpenDelta(const char* filename, uint32_t module = 0, bool verify = true);
+
+    /**
+     * @brief Release the mapping
+     */
+    void Close();
+
+    /**
+     * @brief Find a section
+     * @param tag Section tag
+     * @param size Output payload size in bytes (may be nullptr)
+     * @return Payload pointer, nullptr if absent
+     */
+    const void* Section(uint32_t tag, size_t* size = nullptr) const;
+
+    /**
+     * @brief Find a section of an exact size
+     * @return Payload pointer, nullptr if absent or of another size
+     */
+    const void* SectionExact(uint32_t tag, size_t expectedSize) const;
+
+    /**
+     * @brief Container version of the open file
+     */
+    uint32_t Version() const { return m_version; }
+
+    /**
+     * @brief Module tag of the open file
+     */
+    uint32_t Module() const { return m_module; }
+
+    /**
+     * @brief Content identity of the view
+     *
+     * Deltas are written against it and ApplyDelta() checks it. For a
+     * delta opened with OpenDelta() it is the identity once applied.
+     */
+    uint32_t Identity() const { return m_identity; }
+
+    /**
+     * @brief Identity() a delta opened with OpenDelta() applies to, 0 otherwise
+     */
+    uint32_t BaseIdentity() const { return m_baseIdentity; }
+
+    /**
+     * @brief Table of contents entry of a section, verified like Section()
+     * @return false if absent
+     */
+    bool SectionInfo(uint32_t tag, CalibSection& info) const;
+
+    /**
+     * @brief Number of files in the view (the base plus applied deltas)
+     */
+    size_t Layers() const { return m_layers.size(); }
+
+    /**
+     * @brief Reason of the last failed Open()
+     */
+    const std::string& Error() const { return m_error; }
+
+private:
+    /// One mapped (or read) file of the view
+    struct Layer {
+        const uint8_t* base;
+        size_t size;
+        bool mapped;
+        std::vector<uint8_t> buffer;
+#ifdef _WIN32
+        void* fileHandle;
+        void* mapHandle;
+#endif
+        Layer();
+    };
+
+    /// Table of contents entry and the layer its payload lives in
+    struct Entry {
+        CalibSection section;
+        const uint8_t* data;
+        mutable int8_t checked;         ///< 0 not yet, 1 CRC matched, -1 mismatch
+    };
+
+    bool fail(const char* msg);
+    bool openView(const char* filename, uint32_t module, bool verify, bool delta);
+    bool openLayer(const char* filename, uint32_t module, Layer& layer,
+                   CalibFileHeader& header, std::vector<CalibSection>& toc);
+    static void closeLayer(Layer& layer);
+    const Entry* find(uint32_t tag) const;
+
+    std::vector<Layer> m_layers;
+    std::vector<Entry> m_toc;
+    uint32_t m_module;
+    uint32_t m_version;
+    uint32_t m_identity;
+    uint32_t m_baseIdentity;
+    bool m_verify;
+    std::string m_error;
+
+    friend class CalibFileWriter;
+
+    // Non-copyable
+    CalibFile(const CalibFile&) = delete;
+    CalibFile& operator=(const CalibFile&) = delete;
+};
+
+} // namespace Internal
+} // namespace HX
+
+#endif // CALIB_FILE_H
@@ -0,0 +1,155 @@
+// ============================================================================
+// calib_report.cpp
+// ============================================================================
+
+/**
+ * @file calib_report.cpp
+ * @brief Statistics and defect count of calibration maps in one pass
+ * @version 2.1.0
+ */
+
+#include "calib_report.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace HX {
+namespace Internal {
+
+namespace {
+    // Below this a band costs more to schedule than to sum
+    const size_t MIN_BAND_PIXELS = 1u << 16;
+
+    // Sums of values shifted by the first one, so the squares do not
+    // cancel for maps whose spread is tiny next to their level
+    struct ShiftedSums {
+        uint64_t count;
+        double shift;
+        double sum;
+        double sumSquares;
+        float minValue;
+        float maxValue;
+
+        ShiftedSums() : count(0), shift(0.0), sum(0.0), sumSquares(0.0), minValue(0.0f), maxValue(0.0f) {}
+
+        void add(float v) {
+            if (count == 0) {
+                shift = v;
+                minValue = v;
+                maxValue = v;
+            }
+            const double d = v - shift;
+            sum += d;
+            sumSquares += d * d;
+            minValue = std::min(minValue, v);
+            maxValue = std::max(maxValue, v);
+            ++count;
+        }
+
+        MapStatistics statistics() const {
+            MapStatistics s;
+            if (count == 0) {
+                return s;
+            }
+            s.count = count;
+            s.mean = shift + sum / count;
+            s.m2 = std::max(0.0, sumSquares - sum * sum / count);
+            s.minValue = minValue;
+            s.maxValue = maxValue;
+            return s;
+        }
+    };
+
+    struct BandReport {
+        MapStatistics offset;
+        MapStatistics gain;
+        MapStatistics baseline;
+        uint64_t gainDefects;
+
+        BandReport() : gainDefects(0) {}
+    };
+
+    MapStatistics SumMap(const uint16_t* map, size_t begin, size_t end) {
+        ShiftedSums sums;
+        for (size_t i = begin; i < end; ++i) {
+            sums.add(map[i]);
+        }
+        return sums.statistics();
+    }
+}
+
+double MapStatistics::stdDev() const {
+    return count ? std::sqrt(m2 / count) : 0.0;
+}
+
+void MapStatistics::merge(const MapStatistics& other) {
+    if (other.count == 0) {
+        return;
+    }
+    if (count == 0) {
+        *this = other;
+        return;
+    }
+    const double n = static_cast<double>(count + other.count);
+    const double delta = other.mean - mean;
+    mean += delta * other.count / n;
+    m2 += other.m2 + delta * delta * (static_cast<double>(count) * other.count / n);
+    minValue = std::min(minValue, other.minValue);
+    maxValue = std::max(maxValue, other.maxValue);
+    count += other.count;
+}
+
+void BuildCalibrationReport(const uint16_t* offset, const float* gain, const uint16_t* baseline,
+                            size_t pixels, CalibrationReport& report) {
+    report = CalibrationReport();
+    report.pixels = pixels;
+    if (pixels == 0) {
+        return;
+    }
+
+    ThreadPool& pool = ThreadPool::instance();
+    const int bands = static_cast<int>(std::max<size_t>(1, std::min<size_t>(pool.threadCount(),
+                                                                            pixels / MIN_BAND_PIXELS)));
+
+    std::vector<BandReport> partial(bands);
+    pool.run(bands, [&](int band) {
+        BandReport& out = partial[band];
+        const size_t begin = pixels * band / bands;
+        const size_t end = pixels * (band + 1) / bands;
+        if (offset) {
+            out.offset = SumMap(offset, begin, end);
+        }
+        if (baseline) {
+            out.baseline = SumMap(baseline, begin, end);
+        }
+        if (gain) {
+            ShiftedSums sums;
+            uint64_t defects = 0;
+            for (size_t i = begin; i < end; ++i) {
+                const float g = gain[i];
+                if (!std::isfinite(g)) {
+                    ++defects;
+                    continue;
+                }
+                if (g <= 0.0f || g > GAIN_DEFECT_LIMIT) {
+                    ++defects;
+                }
+                sums.add(g);
+            }
+            out.gain = sums.statistics();
+            out.gainDefects = defects;
+        }
+    });
+
+    // Bands merge in order, so the result does not depend on scheduling
+    for (int band = 0; band < bands; ++band) {
+        report.offset.merge(partial[band].offset);
+        report.gain.merge(partial[band].gain);
+        report.baseline.merge(partial[band].baseline);
+        report.gainDefects += partial[band].gainDefects;
+    }
+}
+
+} // namespace Internal
+} // namespace HX
@@ -0,0 +1,77 @@
+// ============================================================================
+// calib_report.h
+// ============================================================================
+
+/**
+ * @file calib_report.h
+ * @brief Statistics and defect count of calibration maps in one pass
+ * @version 2.1.0
+ *
+ * This header is INTERNAL to hubx.dll. The offset, gain and baseline maps
+ * of a calibration are read together, once, across the shared pool; each
+ * band keeps shifted sums and the bands are merged with the parallel
+ * Welford (Chan) update, so the mean and deviation stay exact to double
+ * precision however many pixels there are.
+ */
+
+#ifndef CALIB_REPORT_H
+#define CALIB_REPORT_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace HX {
+namespace Internal {
+
+/// Gains outside (0, GAIN_DEFECT_LIMIT], NaN or infinite count as defects
+const float GAIN_DEFECT_LIMIT = 100.0f;
+
+/**
+ * @brief Count, mean, deviation and extremes of one map
+ */
+struct MapStatistics {
+    uint64_t count;         ///< Values included (gains: the finite ones)
+    double mean;
+    double m2;              ///< Sum of squared deviations from mean
+    float minValue;
+    float maxValue;
+
+    MapStatistics() : count(0), mean(0.0), m2(0.0), minValue(0.0f), maxValue(0.0f) {}
+
+    /// Population standard deviation
+    double stdDev() const;
+
+    /// Fold in statistics of other values (parallel Welford)
+    void merge(const MapStatistics& other);
+};
+
+/**
+ * @brief Everything the QA checks of a calibration need
+ */
+struct CalibrationReport {
+    uint64_t pixels;
+    MapStatistics offset;       ///< Empty if no offset map was given
+    MapStatistics gain;         ///< Finite gains only; defects are counted, not averaged
+    MapStatistics baseline;
+    uint64_t gainDefects;
+
+    CalibrationReport() : pixels(0), gainDefects(0) {}
+
+    /// The 0.1% defect budget every Validate*() call applies
+    bool valid() const { return pixels > 0 && gainDefects < pixels / 1000; }
+};
+
+/**
+ * @brief Build the report of one calibration
+ * @param offset Offset map or NULL
+ * @param gain Gain map or NULL
+ * @param baseline Baseline map or NULL
+ * @param pixels Values per map
+ */
+void BuildCalibrationReport(const uint16_t* offset, const float* gain, const uint16_t* baseline,
+                            size_t pixels, CalibrationReport& report);
+
+} // namespace Internal
+} // namespace HX
+
+#endif // CALIB_REPORT_H
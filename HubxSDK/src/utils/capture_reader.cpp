@@ -0,0 +1,301 @@
+// ============================================================================
+// capture_reader.cpp
+// ============================================================================
+
+/**
+ * @file capture_reader.cpp
+ * @brief Packet capture and stream file reader implementation
+ * @version 2.1.0
+ */
+
+#include "capture_reader.h"
+#include "XImage.h"
+#include "XStreamFile.h"
+#include <cstring>
+
+namespace HX {
+namespace Internal {
+
+namespace {
+
+const uint32_t PCAP_MAGIC_US = 0xA1B2C3D4u;
+const uint32_t PCAP_MAGIC_NS = 0xA1B23C4Du;
+const uint32_t PCAPNG_MAGIC = 0x0A0D0D0Au;
+
+// Link-layer types
+const uint32_t LINK_ETHERNET = 1;
+const uint32_t LINK_RAW = 101;
+const uint32_t LINK_LINUX_SLL = 113;
+
+const uint32_t PCAP_FILE_HEADER = 24;
+const uint32_t PCAP_RECORD_HEADER = 16;
+
+/// Largest record accepted; anything bigger means a corrupt file
+const uint32_t MAX_RECORD = 256 * 1024;
+
+const uint32_t UDP_HEADER = 8;
+
+inline uint32_t swap32(uint32_t v) {
+    return (v >> 24) | ((v >> 8) & 0xFF00u) | ((v << 8) & 0xFF0000u) | (v << 24);
+}
+
+inline uint16_t be16(const uint8_t* p) {
+    return static_cast<uint16_t>(p[0] << 8 | p[1]);
+}
+
+} // namespace
+
+CaptureReader::CaptureReader()
+    : m_file(nullptr)
+    , m_swapped(false)
+    , m_nanoseconds(false)
+    , m_linkType(0)
+    , m_port(0)
+    , m_fragmentKey(0)
+    , m_fragmentBytes(0)
+    , m_stream(nullptr)
+    , m_lines(nullptr)
+    , m_chunk(0)
+    , m_chunkLine(0)
+    , m_chunkFirstTime(0)
+    , m_chunkLastTime(0)
+    , m_width(0)
+    , m_pixelDepth(0)
+    , m_oversized(0)
+{
+}
+
+CaptureReader::~CaptureReader() {
+    close();
+}
+
+bool CaptureReader::open(const std::string& file, uint16_t port, std::string& error) {
+    close();
+
+    FILE* f = fopen(file.c_str(), "rb");
+    if (!f) {
+        error = "Cannot open capture " + file;
+        return false;
+    }
+
+    uint8_t header[PCAP_FILE_HEADER];
+    const size_t got = fread(header, 1, sizeof(header), f);
+    uint32_t magic = 0;
+    memcpy(&magic, header, got >= 4 ? 4 : 0);
+
+    if (got == sizeof(header) &&
+        (magic == PCAP_MAGIC_US || magic == PCAP_MAGIC_NS ||
+         swap32(magic) == PCAP_MAGIC_US || swap32(magic) == PCAP_MAGIC_NS)) {
+        m_swapped = magic != PCAP_MAGIC_US && magic != PCAP_MAGIC_NS;
+        m_nanoseconds = magic == PCAP_MAGIC_NS || swap32(magic) == PCAP_MAGIC_NS;
+        m_linkType = field32(header + 20) & 0xFFFFu;
+        if (m_linkType != LINK_ETHERNET && m_linkType != LINK_RAW && m_linkType != LINK_LINUX_SLL) {
+            fclose(f);
+            error = "Unsupported pcap link type";
+            return false;
+        }
+        m_file = f;
+        m_port = port;
+        m_record.resize(MAX_RECORD);
+        setvbuf(m_file, nullptr, _IOFBF, 1 << 20);
+        return true;
+    }
+    fclose(f);
+
+    if (magic == PCAPNG_MAGIC) {
+        error = "pcapng captures are not supported, convert with editcap -F pcap";
+        return false;
+    }
+
+    // Not a pcap: try a stream file
+    m_stream = new XStreamFile();
+    if (!m_stream->Open(file)) {
+        close();
+        error = "Not a pcap or stream file: " + file;
+        return false;
+    }
+    m_width = m_stream->GetWidth();
+    m_pixelDepth = m_stream->GetPixelDepth();
+    m_lines = new XImage();
+    m_chunk = 0;
+    m_chunkLine = 0;
+    return true;
+}
+
+void CaptureReader::close() {
+    if (m_file) {
+        fclose(m_file);
+        m_file = nullptr;
+    }
+    delete m_lines;
+    m_lines = nullptr;
+    if (m_stream) {
+        m_stream->Close();
+        delete m_stream;
+        m_stream = nullptr;
+    }
+    m_fragmentBytes = 0;
+    m_width = 0;
+    m_pixelDepth = 0;
+    m_oversized = 0;
+}
+
+int32_t CaptureReader::next(uint8_t* buffer, uint32_t size, uint64_t& timeUs) {
+    if (m_file) {
+        return nextPcap(buffer, size, timeUs);
+    }
+    if (m_stream) {
+        return nextLine(buffer, size, timeUs);
+    }
+    return 0;
+}
+
+uint32_t CaptureReader::field32(const uint8_t* p) const {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return m_swapped ? swap32(v) : v;
+}
+
+int32_t CaptureReader::nextPcap(uint8_t* buffer, uint32_t size, uint64_t& timeUs) {
+    for (;;) {
+        uint8_t header[PCAP_RECORD_HEADER];
+        const size_t got = fread(header, 1, sizeof(header), m_file);
+        if (got == 0 && feof(m_file)) {
+            return 0;
+        }
+        if (got != sizeof(header)) {
+            // Truncated by a capture that was killed: treat as the end
+            return feof(m_file) ? 0 : -1;
+        }
+
+        const uint32_t seconds = field32(header);
+        const uint32_t fraction = field32(header + 4);
+        const uint32_t length = field32(header + 8);
+        if (length > MAX_RECORD) {
+            return -1;
+        }
+        if (fread(m_record.data(), 1, length, m_file) != length) {
+            return feof(m_file) ? 0 : -1;
+        }
+        timeUs = static_cast<uint64_t>(seconds) * 1000000u + (m_nanoseconds ? fraction / 1000 : fraction);
+
+        // Strip the link layer down to the IP header
+        const uint8_t* p = m_record.data();
+        uint32_t remaining = length;
+        uint16_t etherType = 0x0800;
+        if (m_linkType == LINK_ETHERNET) {
+            if (remaining < 14) continue;
+            etherType = be16(p + 12);
+            p += 14;
+            remaining -= 14;
+            while (etherType == 0x8100 && remaining >= 4) {
+                // 802.1Q tag
+                etherType = be16(p + 2);
+                p += 4;
+                remaining -= 4;
+            }
+        } else if (m_linkType == LINK_LINUX_SLL) {
+            if (remaining < 16) continue;
+            etherType = be16(p + 14);
+            p += 16;
+            remaining -= 16;
+        }
+        if (etherType != 0x0800) {
+            continue;
+        }
+
+        const int32_t payload = udpPayload(p, remaining, buffer, size);
+        if (payload > 0) {
+            return payload;
+        }
+    }
+}
+
+int32_t CaptureReader::udpPayload(const uint8_t* ip, uint32_t length, uint8_t* buffer, uint32_t size) {
+    if (length < 20 || (ip[0] >> 4) != 4 || ip[9] != 17) {
+        return 0;
+    }
+    const uint32_t ihl = (ip[0] & 0x0F) * 4u;
+    const uint32_t total = be16(ip + 2);
+    if (ihl < 20 || total < ihl || total > length) {
+        return 0;
+    }
+    const uint8_t* data = ip + ihl;
+    uint32_t dataLen = total - ihl;
+
+    const uint16_t flags = be16(ip + 6);
+    const bool moreFragments = (flags & 0x2000) != 0;
+    const uint32_t offset = (flags & 0x1FFFu) * 8u;
+    if (moreFragments || offset > 0) {
+        // Fragments of one datagram arrive back to back on a point-to-point
+        // link; a gap or interleave drops the datagram
+        const uint32_t key = static_cast<uint32_t>(be16(ip + 4)) << 16 | be16(ip + 14);
+        if (offset == 0) {
+            m_fragmentKey = key;
+            m_fragmentBytes = 0;
+        } else if (key != m_fragmentKey || offset != m_fragmentBytes) {
+            m_fragmentBytes = 0;
+            return 0;
+        }
+        if (m_fragment.size() < offset + dataLen) {
+            m_fragment.resize(offset + dataLen);
+        }
+        memcpy(&m_fragment[offset], data, dataLen);
+        m_fragmentBytes = offset + dataLen;
+        if (moreFragments) {
+            return 0;
+        }
+        data = m_fragment.data();
+        dataLen = m_fragmentBytes;
+        m_fragmentBytes = 0;
+    }
+
+    if (dataLen < UDP_HEADER || (m_port != 0 && be16(data + 2) != m_port)) {
+        return 0;
+    }
+    const uint32_t payload = dataLen - UDP_HEADER;
+    if (payload == 0) {
+        return 0;
+    }
+    if (payload > size) {
+        ++m_oversized;
+        return 0;
+    }
+    memcpy(buffer, data + UDP_HEADER, payload);
+    return static_cast<int32_t>(payload);
+}
+
+int32_t CaptureReader::nextLine(uint8_t* buffer, uint32_t size, uint64_t& timeUs) {
+    XStreamFile::ChunkInfo info;
+    if (!m_stream->GetChunkInfo(m_chunk, info)) {
+        return 0;
+    }
+    if (m_chunkLine == 0) {
+        if (!m_stream->ReadLines(info.firstLine, info.lineCount, m_lines)) {
+            return -1;
+        }
+        m_chunkFirstTime = info.firstTime;
+        m_chunkLastTime = info.lastTime > info.firstTime ? info.lastTime : info.firstTime;
+    }
+
+    const uint32_t lineBytes = m_width * ((m_pixelDepth + 7) / 8);
+    if (lineBytes > size) {
+        // Every line has this size, skipping would skip them all
+        ++m_oversized;
+        return -1;
+    }
+    const uint32_t line = m_chunkLine;
+    const uint32_t span = info.lineCount > 1 ? info.lineCount - 1 : 1;
+    timeUs = m_chunkFirstTime + (m_chunkLastTime - m_chunkFirstTime) * line / span;
+    if (++m_chunkLine >= info.lineCount) {
+        m_chunkLine = 0;
+        ++m_chunk;
+    }
+
+    memcpy(buffer, m_lines->_data_ + m_lines->_data_offset + static_cast<size_t>(line) * m_lines->_stride,
+           lineBytes);
+    return static_cast<int32_t>(lineBytes);
+}
+
+} // namespace Internal
+} // namespace HX
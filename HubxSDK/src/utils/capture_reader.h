@@ -0,0 +1,112 @@
+// ============================================================================
+// capture_reader.h
+// ============================================================================
+
+/**
+ * @file capture_reader.h
+ * @brief Recorded image packets for XGrabber replay
+ * @version 2.1.0
+ *
+ * This header is INTERNAL to hubx.dll. Two kinds of capture are read:
+ *
+ * - libpcap files (microsecond or nanosecond, either byte order) of
+ *   Ethernet, Linux cooked or raw IP captures. Every IPv4 UDP datagram to
+ *   the image port is one packet, header included, exactly as the receive
+ *   calls return it; in-order IP fragments are reassembled.
+ * - XStreamFile streams, e.g. written by XFlightRecorder::Trigger(). They
+ *   hold line payloads without packet headers; line times are spread
+ *   evenly between the timestamps of each chunk.
+ *
+ * pcapng is not read; convert with "editcap -F pcap".
+ */
+
+#ifndef CAPTURE_READER_H
+#define CAPTURE_READER_H
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace HX {
+
+class XImage;
+class XStreamFile;
+
+namespace Internal {
+
+/**
+ * @brief Sequential reader of a packet capture or stream file
+ */
+class CaptureReader {
+public:
+    CaptureReader();
+    ~CaptureReader();
+
+    /**
+     * @brief Open a capture
+     * @param file pcap or XStreamFile path
+     * @param port UDP destination port to replay from a pcap (0 = all)
+     * @param error Reason on failure
+     * @return true on success
+     */
+    bool open(const std::string& file, uint16_t port, std::string& error);
+
+    void close();
+
+    /// true for pcap captures, false for stream files (payloads only)
+    bool hasHeaders() const { return m_stream == nullptr; }
+
+    /// Pixels per line and bits per pixel of a stream file (0 for pcap)
+    uint32_t width() const { return m_width; }
+    uint8_t pixelDepth() const { return m_pixelDepth; }
+
+    /**
+     * @brief Read the next packet
+     * @param buffer Destination
+     * @param size Destination size; longer pcap packets are skipped, a
+     *        longer stream line is a read error
+     * @param timeUs Capture time of the packet (us)
+     * @return Packet bytes, 0 at the end of the capture, -1 on a read error
+     */
+    int32_t next(uint8_t* buffer, uint32_t size, uint64_t& timeUs);
+
+    /// Packets skipped because they did not fit the destination
+    uint64_t oversized() const { return m_oversized; }
+
+private:
+    int32_t nextPcap(uint8_t* buffer, uint32_t size, uint64_t& timeUs);
+    int32_t nextLine(uint8_t* buffer, uint32_t size, uint64_t& timeUs);
+    int32_t udpPayload(const uint8_t* ip, uint32_t length, uint8_t* buffer, uint32_t size);
+    uint32_t field32(const uint8_t* p) const;
+
+    // pcap
+    FILE* m_file;
+    bool m_swapped;                 ///< File written on the other byte order
+    bool m_nanoseconds;
+    uint32_t m_linkType;
+    uint16_t m_port;
+    std::vector<uint8_t> m_record;
+
+    // IPv4 reassembly of one datagram at a time
+    std::vector<uint8_t> m_fragment;
+    uint32_t m_fragmentKey;
+    uint32_t m_fragmentBytes;
+
+    // Stream file
+    XStreamFile* m_stream;
+    XImage* m_lines;
+    uint32_t m_chunk;
+    uint32_t m_chunkLine;
+    uint64_t m_chunkFirstTime;
+    uint64_t m_chunkLastTime;
+    uint32_t m_width;
+    uint8_t m_pixelDepth;
+
+    uint64_t m_oversized;
+};
+
+} // namespace Internal
+} // namespace HX
+
+#endif // CAPTURE_READER_H
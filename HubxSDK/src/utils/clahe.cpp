@@ -0,0 +1,296 @@
+// ============================================================================
+// clahe.cpp
+// ============================================================================
+
+/**
+ * @file clahe.cpp
+ * @brief Tiled contrast-limited adaptive histogram equalization
+ * @version 2.1.0
+ */
+
+#include "clahe.h"
+#include "thread_pool.h"
+#include "window_level.h"
+#include "XImage.h"
+#include "XPixel.h"
+#include <algorithm>
+#include <cmath>
+
+namespace HX {
+namespace Internal {
+
+const uint32_t Clahe::MAX_TILES;
+const uint32_t Clahe::MAX_BITS;
+const uint32_t Clahe::MIN_TILE;
+
+Clahe::Clahe()
+    : m_tiles(8)
+    , m_clipLimit(2.5f)
+    , m_tilesX(0)
+    , m_tilesY(0)
+    , m_bins(0)
+    , m_shift(0)
+    , m_key()
+    , m_keyValid(false)
+    , m_levelsValid(false)
+    , m_enhanced(nullptr)
+{
+}
+
+bool Clahe::configure(uint32_t tiles, float clipLimit) {
+    if (tiles == 0 || tiles > MAX_TILES || !(clipLimit >= 1.0f)) {
+        return false;
+    }
+    m_tiles = tiles;
+    m_clipLimit = clipLimit;
+    invalidate();
+    return true;
+}
+
+void Clahe::invalidate() {
+    m_keyValid = false;
+    m_levelsValid = false;
+    m_enhanced = nullptr;
+}
+
+uint64_t Clahe::bytes() const {
+    return m_luts.capacity() * sizeof(float) + m_levels.capacity() +
+           (m_colTile0.capacity() + m_colTile1.capacity()) * sizeof(uint32_t) +
+           m_colWeight.capacity() * sizeof(float);
+}
+
+Clahe::FrameKey Clahe::keyOf(const XImage& image, uint32_t outMax) {
+    FrameKey key;
+    key.data = image._data_ + image._data_offset;
+    key.width = image._width;
+    key.height = image._height;
+    key.stride = image._stride;
+    key.depth = image._pixel_depth;
+    key.sequence = image._info.sequence;
+    key.hostNs = image._info.hostNs;
+    key.detectorId = image._info.detectorId;
+    key.outMax = outMax;
+    return key;
+}
+
+bool Clahe::sameKey(const FrameKey& a, const FrameKey& b) {
+    // Without frame metadata nothing says the pixels are unchanged
+    if (a.sequence == 0 && a.hostNs == 0) {
+        return false;
+    }
+    return a.data == b.data && a.width == b.width && a.height == b.height &&
+           a.stride == b.stride && a.depth == b.depth && a.sequence == b.sequence &&
+           a.hostNs == b.hostNs && a.detectorId == b.detectorId && a.outMax == b.outMax;
+}
+
+bool Clahe::prepare(const XImage& image, uint32_t outMax) {
+    const FrameKey key = keyOf(image, outMax);
+    if (m_keyValid && sameKey(key, m_key)) {
+        return true;
+    }
+    invalidate();
+
+    // Fewer tiles when a tile would get too small to have a histogram
+    m_tilesX = std::max(1u, std::min(m_tiles, image._width / MIN_TILE));
+    m_tilesY = std::max(1u, std::min(m_tiles, image._height / MIN_TILE));
+    const uint32_t bits = std::min<uint32_t>(image._pixel_depth, MAX_BITS);
+    m_bins = 1u << bits;
+    m_shift = image._pixel_depth - bits;
+    m_luts.resize(static_cast<size_t>(m_tilesX) * m_tilesY * m_bins);
+
+    // Column f = (x + 0.5) * tiles / width - 0.5 between tile centres
+    // floor(f) and floor(f) + 1; beyond the outer centres one tile applies
+    const uint32_t width = image._width;
+    m_colTile0.resize(width);
+    m_colTile1.resize(width);
+    m_colWeight.resize(width);
+    for (uint32_t x = 0; x < width; ++x) {
+        const float f = (x + 0.5f) * m_tilesX / width - 0.5f;
+        const int t = static_cast<int>(std::floor(f));
+        const uint32_t t0 = static_cast<uint32_t>(std::max(t, 0));
+        const uint32_t t1 = std::min(static_cast<uint32_t>(std::max(t + 1, 0)), m_tilesX - 1);
+        m_colTile0[x] = std::min(t0, m_tilesX - 1) * m_bins;
+        m_colTile1[x] = t1 * m_bins;
+        m_colWeight[x] = (t < 0 || t0 >= m_tilesX - 1) ? 0.0f : f - static_cast<float>(t);
+    }
+
+    if (image._pixel_depth <= 8) {
+        buildTiles<1>(image, outMax);
+    } else {
+        buildTiles<2>(image, outMax);
+    }
+    m_key = key;
+    m_keyValid = true;
+    return true;
+}
+
+template <uint32_t Bytes>
+void Clahe::buildTiles(const XImage& image, uint32_t outMax) {
+    const uint32_t width = image._width;
+    const uint32_t height = image._height;
+    const uint32_t tilesX = m_tilesX;
+    const uint32_t tilesY = m_tilesY;
+    const uint32_t bins = m_bins;
+    const uint32_t shift = m_shift;
+    const uint32_t limit = windowMaxValue(image._pixel_depth);
+
+    // A band per tile row: its tiles' counters are its own
+    ThreadPool::instance().run(static_cast<int>(tilesY), [&](int ty) {
+        std::vector<uint32_t> counts(static_cast<size_t>(tilesX) * bins, 0);
+        const uint32_t y0 = static_cast<uint32_t>(static_cast<uint64_t>(height) * ty / tilesY);
+        const uint32_t y1 = static_cast<uint32_t>(static_cast<uint64_t>(height) * (ty + 1) / tilesY);
+        for (uint32_t y = y0; y < y1; ++y) {
+            const XPixelRow<Bytes> pixels = image.Row<Bytes>(y);
+            for (uint32_t tx = 0; tx < tilesX; ++tx) {
+                uint32_t* tile = counts.data() + static_cast<size_t>(tx) * bins;
+                const uint32_t x0 = static_cast<uint32_t>(static_cast<uint64_t>(width) * tx / tilesX);
+                const uint32_t x1 = static_cast<uint32_t>(static_cast<uint64_t>(width) * (tx + 1) / tilesX);
+                for (uint32_t x = x0; x < x1; ++x) {
+                    ++tile[std::min(pixels.Get(x), limit) >> shift];
+                }
+            }
+        }
+        for (uint32_t tx = 0; tx < tilesX; ++tx) {
+            const uint32_t x0 = static_cast<uint32_t>(static_cast<uint64_t>(width) * tx / tilesX);
+            const uint32_t x1 = static_cast<uint32_t>(static_cast<uint64_t>(width) * (tx + 1) / tilesX);
+            clipAndMap(counts.data() + static_cast<size_t>(tx) * bins,
+                       m_luts.data() + (static_cast<size_t>(ty) * tilesX + tx) * bins,
+                       (x1 - x0) * (y1 - y0), outMax);
+        }
+    });
+}
+
+void Clahe::clipAndMap(uint32_t* bins, float* lut, uint32_t pixels, uint32_t outMax) const {
+    const uint32_t count = m_bins;
+    const uint32_t limit = std::max<uint32_t>(1, static_cast<uint32_t>(
+        static_cast<double>(m_clipLimit) * pixels / count));
+    uint64_t excess = 0;
+    for (uint32_t b = 0; b < count; ++b) {
+        if (bins[b] > limit) {
+            excess += bins[b] - limit;
+            bins[b] = limit;
+        }
+    }
+
+    // The clipped counts go evenly to every bin, the remainder spread out
+    const uint32_t add = static_cast<uint32_t>(excess / count);
+    uint32_t rest = static_cast<uint32_t>(excess % count);
+    for (uint32_t b = 0; b < count; ++b) {
+        bins[b] += add;
+    }
+    if (rest > 0) {
+        const uint32_t step = std::max(1u, count / rest);
+        for (uint32_t b = 0; b < count && rest > 0; b += step, --rest) {
+            ++bins[b];
+        }
+    }
+
+    const float scale = static_cast<float>(outMax) / pixels;
+    uint64_t cdf = 0;
+    for (uint32_t b = 0; b < count; ++b) {
+        cdf += bins[b];
+        lut[b] = static_cast<float>(cdf) * scale;
+    }
+}
+
+template <uint32_t Bytes, typename Out>
+void Clahe::mapRows(const XImage& image, uint8_t* out, size_t outStride) {
+    const uint32_t width = image._width;
+    const uint32_t height = image._height;
+    const uint32_t tilesX = m_tilesX;
+    const uint32_t tilesY = m_tilesY;
+    const uint32_t shift = m_shift;
+    const uint32_t limit = windowMaxValue(image._pixel_depth);
+    const float* luts = m_luts.data();
+    const uint32_t* col0 = m_colTile0.data();
+    const uint32_t* col1 = m_colTile1.data();
+    const float* weight = m_colWeight.data();
+
+    ThreadPool::instance().parallelRows(static_cast<int>(height), static_cast<int>(width),
+        [&](int firstRow, int endRow) {
+            std::vector<float> values(static_cast<size_t>(width) * 4);
+            float* topLeft = values.data();
+            float* topRight = topLeft + width;
+            float* bottomLeft = topRight + width;
+            float* bottomRight = bottomLeft + width;
+            for (int y = firstRow; y < endRow; ++y) {
+                const float f = (y + 0.5f) * tilesY / height - 0.5f;
+                const int t = static_cast<int>(std::floor(f));
+                const uint32_t t0 = std::min(static_cast<uint32_t>(std::max(t, 0)), tilesY - 1);
+                const uint32_t t1 = std::min(static_cast<uint32_t>(std::max(t + 1, 0)), tilesY - 1);
+                const float wy = (t < 0 || t0 >= tilesY - 1) ? 0.0f : f - static_cast<float>(t);
+                const float* top = luts + static_cast<size_t>(t0) * tilesX * m_bins;
+                const float* bottom = luts + static_cast<size_t>(t1) * tilesX * m_bins;
+
+                // Gather the four tile mappings of each pixel
+                const XPixelRow<Bytes> pixels = image.Row<Bytes>(static_cast<uint32_t>(y));
+                for (uint32_t x = 0; x < width; ++x) {
+                    const uint32_t bin = std::min(pixels.Get(x), limit) >> shift;
+                    topLeft[x] = top[col0[x] + bin];
+                    topRight[x] = top[col1[x] + bin];
+                    bottomLeft[x] = bottom[col0[x] + bin];
+                    bottomRight[x] = bottom[col1[x] + bin];
+                }
+
+                // Blend them: no lookups left, so this loop vectorizes
+                Out* row = reinterpret_cast<Out*>(out + static_cast<size_t>(y) * outStride);
+                for (uint32_t x = 0; x < width; ++x) {
+                    const float upper = topLeft[x] + weight[x] * (topRight[x] - topLeft[x]);
+                    const float lower = bottomLeft[x] + weight[x] * (bottomRight[x] - bottomLeft[x]);
+                    row[x] = static_cast<Out>(upper + wy * (lower - upper) + 0.5f);
+                }
+            }
+        });
+}
+
+const uint8_t* Clahe::levels(const XImage& image) {
+    if (!image._data_ || image._width == 0 || image._height == 0 ||
+        image._pixel_depth == 0 || image._pixel_depth > 16) {
+        return nullptr;
+    }
+    const bool kept = m_keyValid && sameKey(keyOf(image, 255), m_key);
+    if (kept && m_levelsValid) {
+        return m_levels.data();
+    }
+    prepare(image, 255);
+    m_levels.resize(static_cast<size_t>(image._width) * image._height);
+    if (image._pixel_depth <= 8) {
+        mapRows<1, uint8_t>(image, m_levels.data(), image._width);
+    } else {
+        mapRows<2, uint8_t>(image, m_levels.data(), image._width);
+    }
+    m_levelsValid = true;
+    return m_levels.data();
+}
+
+bool Clahe::enhance(const XImage& image, XImage& out) {
+    if (!image._data_ || image._width == 0 || image._height == 0 ||
+        image._pixel_depth == 0 || image._pixel_depth > 16) {
+        return false;
+    }
+    const uint32_t outMax = windowMaxValue(image._pixel_depth);
+    if (out._width != image._width || out._height != image._height ||
+        out._pixel_depth != image._pixel_depth || !out._data_) {
+        if (!out.Allocate(image._width, image._height, static_cast<uint8_t>(image._pixel_depth))) {
+            return false;
+        }
+        m_enhanced = nullptr;
+    }
+    uint8_t* target = out._data_ + out._data_offset;
+    if (m_keyValid && sameKey(keyOf(image, outMax), m_key) && m_enhanced == target) {
+        out._info = image._info;
+        return true;
+    }
+    prepare(image, outMax);
+    if (image._pixel_depth <= 8) {
+        mapRows<1, uint8_t>(image, target, out._stride);
+    } else {
+        mapRows<2, uint16_t>(image, target, out._stride);
+    }
+    out._info = image._info;
+    m_enhanced = target;
+    return true;
+}
+
+} // namespace Internal
+} // namespace HX
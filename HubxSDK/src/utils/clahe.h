@@ -0,0 +1,127 @@
+// ============================================================================
+// clahe.h
+// ============================================================================
+
+/**
+ * @file clahe.h
+ * @brief Tiled contrast-limited adaptive histogram equalization
+ * @version 2.1.0
+ *
+ * This header is INTERNAL to hubx.dll. The frame is cut into a grid of
+ * tiles; each tile's histogram is clipped at a multiple of its mean bin
+ * count, the excess spread over all bins, and its CDF becomes the tile's
+ * mapping. A pixel blends the mappings of the four tiles around it by
+ * its distance to their centres, so tile edges do not show. Tile rows
+ * are counted by separate pool bands, each into its own tiles' bins, as
+ * in PixelHistogram; values deeper than 12 bits share bins. The blend
+ * gathers the four mapped values of a row first, then interpolates them
+ * in a loop the compiler vectorizes.
+ */
+
+#ifndef CLAHE_H
+#define CLAHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace HX {
+
+class XImage;
+
+namespace Internal {
+
+/**
+ * @class Clahe
+ * @brief CLAHE of 1-16 bit frames, kept until the frame changes
+ *
+ * The result of the last frame is kept. A frame counts as the same when
+ * its buffer, geometry and XFrameInfo sequence, host time and detector
+ * match; frames without frame metadata (sequence and hostNs 0) are
+ * processed every time, since their pixels may have changed in place.
+ */
+class Clahe {
+public:
+    static const uint32_t MAX_TILES = 32;   ///< Tiles per axis
+    static const uint32_t MAX_BITS = 12;    ///< Histogram bits per tile
+    static const uint32_t MIN_TILE = 8;     ///< Fewer tiles on smaller images
+
+    Clahe();
+
+    /**
+     * @brief Set the grid and clip limit, dropping any kept result
+     * @param tiles Tiles per axis, 1..MAX_TILES
+     * @param clipLimit Bin limit as a multiple of the mean count (>= 1)
+     * @return false if a parameter is out of range
+     */
+    bool configure(uint32_t tiles, float clipLimit);
+
+    uint32_t tiles() const { return m_tiles; }
+    float clipLimit() const { return m_clipLimit; }
+
+    /**
+     * @brief Equalized 8-bit display levels of a frame
+     * @return Levels, _width per row, valid until the next call; nullptr
+     *         if the image is empty or deeper than 16 bits
+     */
+    const uint8_t* levels(const XImage& image);
+
+    /**
+     * @brief Equalize a frame into an image of the same size and depth
+     * @param out Reallocated if its size or depth differ
+     * @return false if the image is empty or deeper than 16 bits
+     */
+    bool enhance(const XImage& image, XImage& out);
+
+    /// Forget the kept result
+    void invalidate();
+
+    /// Buffer bytes, for memory profiling
+    uint64_t bytes() const;
+
+private:
+    struct FrameKey {
+        const uint8_t* data;
+        uint32_t width;
+        uint32_t height;
+        uint32_t stride;
+        uint32_t depth;
+        uint64_t sequence;
+        uint64_t hostNs;
+        uint32_t detectorId;
+        uint32_t outMax;
+    };
+
+    static FrameKey keyOf(const XImage& image, uint32_t outMax);
+    static bool sameKey(const FrameKey& a, const FrameKey& b);
+    bool prepare(const XImage& image, uint32_t outMax);
+    template <uint32_t Bytes>
+    void buildTiles(const XImage& image, uint32_t outMax);
+    template <uint32_t Bytes, typename Out>
+    void mapRows(const XImage& image, uint8_t* out, size_t outStride);
+    void clipAndMap(uint32_t* bins, float* lut, uint32_t pixels, uint32_t outMax) const;
+
+    uint32_t m_tiles;
+    float m_clipLimit;
+
+    // Grid of the kept frame
+    uint32_t m_tilesX;
+    uint32_t m_tilesY;
+    uint32_t m_bins;
+    uint32_t m_shift;               ///< Value to bin
+    std::vector<float> m_luts;      ///< Tile (ty * m_tilesX + tx) maps bins to 0..outMax
+    std::vector<uint32_t> m_colTile0;   ///< Bin offset of the left tile of a column
+    std::vector<uint32_t> m_colTile1;   ///< ... and of the right one
+    std::vector<float> m_colWeight;     ///< Weight of the right tile
+
+    FrameKey m_key;
+    bool m_keyValid;                ///< m_luts belong to m_key
+    std::vector<uint8_t> m_levels;
+    bool m_levelsValid;             ///< m_levels belong to m_key
+    const uint8_t* m_enhanced;      ///< Buffer enhance() last filled for m_key
+};
+
+} // namespace Internal
+} // namespace HX
+
+#endif // CLAHE_H
@@ -0,0 +1,158 @@
+// ============================================================================
+// cpu_features.cpp
+// ============================================================================
+
+/**
+ * @file cpu_features.cpp
+ * @brief CPU feature detection and the kernel family registry
+ * @version 2.1.0
+ */
+
+#include "cpu_features.h"
+#include "logger.h"
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+namespace HX {
+namespace Internal {
+
+std::atomic<uint32_t> g_cpuMask(XFactory::CPU_ALL);
+
+namespace {
+    uint32_t detect() {
+        uint32_t bits = 0;
+#if defined(HX_ARCH_X86)
+#if defined(_MSC_VER) && !defined(__clang__)
+        int regs[4];
+        __cpuid(regs, 0);
+        int maxLeaf = regs[0];
+        __cpuid(regs, 1);
+        const bool sse42 = (regs[2] & (1 << 20)) != 0;
+        const bool fma = (regs[2] & (1 << 12)) != 0;
+        bool osxsave = (regs[2] & (1 << 27)) != 0;
+        unsigned long long xcr0 = osxsave ? _xgetbv(0) : 0;
+        bool avx2 = false;
+        bool avx512 = false;
+        if (maxLeaf >= 7 && (xcr0 & 0x6) == 0x6) {
+            __cpuidex(regs, 7, 0);
+            avx2 = (regs[1] & (1 << 5)) != 0 && fma;
+            avx512 = (xcr0 & 0xE6) == 0xE6 &&
+                     (regs[1] & (1 << 16)) != 0 && (regs[1] & (1 << 30)) != 0;
+        }
+#else
+        // libgcc also checks that the OS saves the wider registers
+        __builtin_cpu_init();
+        const bool sse42 = __builtin_cpu_supports("sse4.2") != 0;
+        const bool avx2 = __builtin_cpu_supports("avx2") != 0 &&
+                          __builtin_cpu_supports("fma") != 0;
+        const bool avx512 = __builtin_cpu_supports("avx512f") != 0 &&
+                            __builtin_cpu_supports("avx512bw") != 0;
+#endif
+        if (sse42) bits |= XFactory::CPU_SSE42;
+        if (avx2) bits |= XFactory::CPU_AVX2;
+        if (avx512) bits |= XFactory::CPU_AVX512;
+#endif
+#if defined(HX_ARCH_NEON)
+        bits |= XFactory::CPU_NEON;     // mandatory on AArch64
+#endif
+        return bits;
+    }
+
+    // Families register during static initialisation of their translation unit
+    std::mutex& registryMutex() {
+        static std::mutex mutex;
+        return mutex;
+    }
+
+    std::vector<const KernelFamily*>& registry() {
+        static std::vector<const KernelFamily*> families;
+        return families;
+    }
+
+    // Kernels for the other architecture are not compiled in
+    const uint32_t COMPILED_ISAS = 0
+#if defined(HX_ARCH_X86)
+        | XFactory::CPU_SSE42 | XFactory::CPU_AVX2 | XFactory::CPU_AVX512
+#endif
+#if defined(HX_ARCH_NEON)
+        | XFactory::CPU_NEON
+#endif
+        ;
+
+    // Widest first; x86 and NEON bits never occur together
+    const uint32_t ISA_ORDER[] = {
+        XFactory::CPU_AVX512, XFactory::CPU_AVX2, XFactory::CPU_SSE42, XFactory::CPU_NEON
+    };
+
+    std::string isaList(uint32_t isas, const char* last) {
+        std::string list;
+        for (size_t i = 0; i < sizeof(ISA_ORDER) / sizeof(ISA_ORDER[0]); ++i) {
+            if (isas & ISA_ORDER[i]) {
+                list += CpuIsaName(ISA_ORDER[i]);
+                list += ' ';
+            }
+        }
+        return list + last;
+    }
+}
+
+uint32_t CpuDetected() {
+    static const uint32_t bits = detect();
+    return bits;
+}
+
+uint32_t CpuBest(uint32_t isas) {
+    const uint32_t usable = isas & CpuActive();
+    for (size_t i = 0; i < sizeof(ISA_ORDER) / sizeof(ISA_ORDER[0]); ++i) {
+        if (usable & ISA_ORDER[i]) {
+            return ISA_ORDER[i];
+        }
+    }
+    return 0;
+}
+
+KernelFamily::KernelFamily(const char* name, uint32_t isas)
+    : m_name(name)
+    , m_isas(isas & COMPILED_ISAS)
+{
+    std::lock_guard<std::mutex> lock(registryMutex());
+    registry().push_back(this);
+}
+
+const char* CpuIsaName(uint32_t isa) {
+    switch (isa) {
+        case XFactory::CPU_SSE42:  return "sse4.2";
+        case XFactory::CPU_AVX2:   return "avx2";
+        case XFactory::CPU_AVX512: return "avx512";
+        case XFactory::CPU_NEON:   return "neon";
+        default:                   return "scalar";
+    }
+}
+
+std::string CpuDispatchReport() {
+    std::lock_guard<std::mutex> lock(registryMutex());
+    std::ostringstream report;
+    for (size_t i = 0; i < registry().size(); ++i) {
+        const KernelFamily& family = *registry()[i];
+        report << family.name() << ' ' << CpuIsaName(family.isa())
+               << " (" << isaList(family.isas(), "scalar") << ")\n";
+    }
+    return report.str();
+}
+
+void CpuDispatchLog() {
+    const uint32_t detected = CpuDetected();
+    const uint32_t mask = g_cpuMask.load(std::memory_order_relaxed);
+    HX_LOG_INFO("XFactory") << "CPU features: " << isaList(detected, "baseline")
+                            << ((detected & ~mask) ? ", restricted by SetCpuFeatureMask" : "");
+
+    std::lock_guard<std::mutex> lock(registryMutex());
+    for (size_t i = 0; i < registry().size(); ++i) {
+        const KernelFamily& family = *registry()[i];
+        HX_LOG_DEBUG("XFactory") << "Kernel " << family.name() << ": " << CpuIsaName(family.isa());
+    }
+}
+
+} // namespace Internal
+} // namespace HX
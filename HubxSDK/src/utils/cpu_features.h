@@ -0,0 +1,132 @@
+// ============================================================================
+// cpu_features.h
+// ============================================================================
+
+/**
+ * @file cpu_features.h
+ * @brief Runtime CPU feature detection for SIMD kernel selection
+ * @version 2.1.0
+ *
+ * This header is INTERNAL to hubx.dll. Kernels for wider instruction sets
+ * are compiled with per-function target attributes (HX_TARGET) and picked
+ * at run time, so the library itself still runs on a baseline CPU. Every
+ * selector has a KernelFamily, which ties the pick to the features left
+ * by XFactory::SetCpuFeatureMask() and lists it in GetKernelDispatch().
+ */
+
+#ifndef CPU_FEATURES_H
+#define CPU_FEATURES_H
+
+#include "xfactory.h"
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define HX_ARCH_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(__aarch64__) || defined(_M_ARM64) || (defined(__ARM_NEON) && defined(__arm__))
+#define HX_ARCH_NEON 1
+#include <arm_neon.h>
+#endif
+
+// Compile one function for an instruction set the translation unit lacks
+#if defined(__GNUC__) || defined(__clang__)
+#define HX_TARGET(isa) __attribute__((target(isa)))
+#else
+#define HX_TARGET(isa)
+#endif
+
+namespace HX {
+namespace Internal {
+
+/**
+ * @brief Instruction sets kernels may use on this CPU and OS
+ */
+struct CpuFeatures {
+    bool sse42;
+    bool avx2;      ///< AVX2 and FMA
+    bool avx512;    ///< AVX-512 F and BW
+    bool neon;
+};
+
+/// XFactory::CpuFeature bits of this CPU, detected on first use
+uint32_t CpuDetected();
+
+extern std::atomic<uint32_t> g_cpuMask;
+
+/// Detected bits left by XFactory::SetCpuFeatureMask()
+inline uint32_t CpuActive() {
+    return CpuDetected() & g_cpuMask.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Features kernels may use now
+ * @note Read when a kernel is picked, so a new mask applies from the next pick
+ */
+inline CpuFeatures cpuFeatures() {
+    const uint32_t bits = CpuActive();
+    CpuFeatures f;
+    f.sse42 = (bits & XFactory::CPU_SSE42) != 0;
+    f.avx2 = (bits & XFactory::CPU_AVX2) != 0;
+    f.avx512 = (bits & XFactory::CPU_AVX512) != 0;
+    f.neon = (bits & XFactory::CPU_NEON) != 0;
+    return f;
+}
+
+/**
+ * @brief Widest instruction set of @p isas usable now
+ * @return One CpuFeature bit, 0 for the portable kernel
+ */
+uint32_t CpuBest(uint32_t isas);
+
+/**
+ * @class KernelFamily
+ * @brief Kernels for one operation, registered so GetKernelDispatch()
+ *        reports what they run
+ *
+ * Define one per selector at namespace scope and switch on isa():
+ *
+ *   const KernelFamily g_windowKernels("window_level", CPU_AVX2 | CPU_NEON);
+ */
+class KernelFamily {
+public:
+    /**
+     * @param name Reported name
+     * @param isas CpuFeature bits with a kernel besides the portable one
+     */
+    KernelFamily(const char* name, uint32_t isas);
+
+    /// Instruction set to run now, 0 = portable
+    uint32_t isa() const { return CpuBest(m_isas); }
+
+    const char* name() const { return m_name; }
+    uint32_t isas() const { return m_isas; }
+
+private:
+    const char* m_name;
+    uint32_t m_isas;
+
+    // Non-copyable
+    KernelFamily(const KernelFamily&) = delete;
+    KernelFamily& operator=(const KernelFamily&) = delete;
+};
+
+/// Name of one CpuFeature bit ("scalar" for 0)
+const char* CpuIsaName(uint32_t isa);
+
+/// GetKernelDispatch() text
+std::string CpuDispatchReport();
+
+/// Log the detected features and kernel bindings (XFactory::Initialize)
+void CpuDispatchLog();
+
+} // namespace Internal
+} // namespace HX
+
+#endif // CPU_FEATURES_H
@@ -0,0 +1,62 @@
+// ============================================================================
+// crc16.cpp
+// ============================================================================
+
+/**
+ * @file crc16.cpp
+ * @brief Slice-by-8 CRC-16
+ * @version 2.1.0
+ */
+
+#include "crc16.h"
+
+namespace HX {
+namespace Internal {
+
+namespace {
+
+// entries[k][b]: CRC of byte b followed by k zero bytes, so the eight
+// bytes of a step are looked up independently and XORed together
+struct Crc16Tables {
+    uint16_t entries[8][256];
+
+    Crc16Tables() {
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint16_t c = static_cast<uint16_t>(i);
+            for (int k = 0; k < 8; ++k) {
+                c = (c & 1) ? static_cast<uint16_t>((c >> 1) ^ 0xA001) : static_cast<uint16_t>(c >> 1);
+            }
+            entries[0][i] = c;
+        }
+        for (uint32_t i = 0; i < 256; ++i) {
+            for (int k = 1; k < 8; ++k) {
+                const uint16_t c = entries[k - 1][i];
+                entries[k][i] = static_cast<uint16_t>((c >> 8) ^ entries[0][c & 0xFF]);
+            }
+        }
+    }
+};
+
+} // namespace
+
+uint16_t Crc16(const void* data, size_t size, uint16_t crc) {
+    static const Crc16Tables tables;
+    const uint16_t (*t)[256] = tables.entries;
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+
+    // The running CRC only overlaps the first two bytes of a step
+    while (size >= 8) {
+        crc = static_cast<uint16_t>(t[7][(p[0] ^ crc) & 0xFF] ^ t[6][(p[1] ^ (crc >> 8)) & 0xFF] ^
+                                    t[5][p[2]] ^ t[4][p[3]] ^ t[3][p[4]] ^ t[2][p[5]] ^
+                                    t[1][p[6]] ^ t[0][p[7]]);
+        p += 8;
+        size -= 8;
+    }
+    while (size-- > 0) {
+        crc = static_cast<uint16_t>(t[0][(crc ^ *p++) & 0xFF] ^ (crc >> 8));
+    }
+    return crc;
+}
+
+} // namespace Internal
+} // namespace HX
@@ -0,0 +1,54 @@
+// ============================================================================
+// crc16.h
+// ============================================================================
+
+/**
+ * @file crc16.h
+ * @brief Table-driven CRC-16 of the xlibdll packets
+ * @version 2.1.0
+ *
+ * This header is INTERNAL to hubx.dll. The detector's CRC-16 is the
+ * reflected polynomial 0xA001 started at 0xFFFF (CRC-16/MODBUS). Crc16()
+ * folds eight bytes per step through eight 256-entry tables (slice-by-8),
+ * so image packets can be checked at line rate; Crc16Bitwise() is the
+ * bit-at-a-time reference it must agree with.
+ */
+
+#ifndef CRC16_H
+#define CRC16_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace HX {
+namespace Internal {
+
+/// Start value of a CRC-16 over the first bytes
+const uint16_t CRC16_INIT = 0xFFFF;
+
+/**
+ * @brief CRC-16/MODBUS, eight bytes per step
+ * @param data Input bytes
+ * @param size Number of bytes
+ * @param crc Running value from a previous call, CRC16_INIT to start
+ */
+uint16_t Crc16(const void* data, size_t size, uint16_t crc = CRC16_INIT);
+
+/**
+ * @brief CRC-16/MODBUS, one bit per step
+ */
+inline uint16_t Crc16Bitwise(const void* data, size_t size, uint16_t crc = CRC16_INIT) {
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        crc ^= p[i];
+        for (int k = 0; k < 8; ++k) {
+            crc = (crc & 1) ? static_cast<uint16_t>((crc >> 1) ^ 0xA001) : static_cast<uint16_t>(crc >> 1);
+        }
+    }
+    return crc;
+}
+
+} // namespace Internal
+} // namespace HX
+
+#endif // CRC16_H
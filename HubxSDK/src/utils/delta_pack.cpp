@@ -0,0 +1,427 @@
+// ============================================================================
+// delta_pack.cpp
+// ============================================================================
+
+/**
+ * @file delta_pack.cpp
+ * @brief Delta + bit-packing codec implementation
+ * @version 2.1.0
+ */
+
+#include "delta_pack.h"
+#include "cpu_features.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+namespace HX {
+namespace Internal {
+
+namespace {
+
+const uint32_t BLOCK = 32;
+
+/// Pixels per strip: small enough to spread over the pool
+const uint32_t STRIP_PIXELS = 64 * 1024;
+
+const KernelFamily g_residualKernels("temporal_residual", XFactory::CPU_AVX2);
+
+inline uint32_t zigzag(uint32_t d) {
+    return (d << 1) ^ (0u - (d >> 31));
+}
+
+inline uint32_t unzigzag(uint32_t z) {
+    return (z >> 1) ^ (0u - (z & 1));
+}
+
+inline uint32_t bitWidth(uint32_t v) {
+#if defined(__GNUC__)
+    return v ? 32 - static_cast<uint32_t>(__builtin_clz(v)) : 0;
+#else
+    uint32_t n = 0;
+    while (v) {
+        ++n;
+        v >>= 1;
+    }
+    return n;
+#endif
+}
+
+template <uint32_t Bytes>
+inline uint32_t loadPixel(const uint8_t* p) {
+    uint32_t v = 0;
+    std::memcpy(&v, p, Bytes);
+    return v;
+}
+
+template <uint32_t Bytes>
+inline void storePixel(uint8_t* p, uint32_t v) {
+    std::memcpy(p, &v, Bytes);
+}
+
+/// Write one block at its minimal width; returns the output end
+uint8_t* packBlock(const uint32_t* v, uint8_t* out) {
+    uint32_t any = 0;
+    for (uint32_t i = 0; i < BLOCK; ++i) {
+        any |= v[i];
+    }
+    const uint32_t bits = bitWidth(any);
+    *out++ = static_cast<uint8_t>(bits);
+    if (bits == 0) {
+        return out;
+    }
+
+    // 32 values * bits is a whole number of bytes
+    uint64_t acc = 0;
+    uint32_t fill = 0;
+    for (uint32_t i = 0; i < BLOCK; ++i) {
+        acc |= static_cast<uint64_t>(v[i]) << fill;
+        fill += bits;
+        while (fill >= 8) {
+            *out++ = static_cast<uint8_t>(acc);
+            acc >>= 8;
+            fill -= 8;
+        }
+    }
+    return out;
+}
+
+/// Read one block; returns nullptr if it runs past end
+const uint8_t* unpackBlock(const uint8_t* in, const uint8_t* end, uint32_t* v) {
+    if (in >= end) {
+        return nullptr;
+    }
+    const uint32_t bits = *in++;
+    if (bits > 32 || static_cast<size_t>(end - in) < bits * (BLOCK / 8)) {
+        return nullptr;
+    }
+    if (bits == 0) {
+        std::memset(v, 0, BLOCK * sizeof(uint32_t));
+        return in;
+    }
+
+    const uint64_t mask = (1ull << bits) - 1;
+    uint64_t acc = 0;
+    uint32_t fill = 0;
+    for (uint32_t i = 0; i < BLOCK; ++i) {
+        while (fill < bits) {
+            acc |= static_cast<uint64_t>(*in++) << fill;
+            fill += 8;
+        }
+        v[i] = static_cast<uint32_t>(acc & mask);
+        acc >>= bits;
+        fill -= bits;
+    }
+    return in;
+}
+
+template <uint32_t Bytes>
+size_t encode(const uint8_t* src, uint32_t width, uint32_t rows, uint32_t stride, uint8_t* dst) {
+    uint32_t block[BLOCK];
+    uint32_t n = 0;
+    uint8_t* out = dst;
+    uint32_t above = 0;
+
+    for (uint32_t row = 0; row < rows; ++row) {
+        const uint8_t* p = src + static_cast<size_t>(row) * stride;
+        uint32_t prev = above;
+        above = loadPixel<Bytes>(p);
+        for (uint32_t col = 0; col < width; ++col) {
+            const uint32_t x = loadPixel<Bytes>(p + static_cast<size_t>(col) * Bytes);
+            block[n++] = zigzag(x - prev);
+            prev = x;
+            if (n == BLOCK) {
+                out = packBlock(block, out);
+                n = 0;
+            }
+        }
+    }
+    if (n > 0) {
+        std::memset(block + n, 0, (BLOCK - n) * sizeof(uint32_t));
+        out = packBlock(block, out);
+    }
+    return static_cast<size_t>(out - dst);
+}
+
+template <uint32_t Bytes>
+bool decode(const uint8_t* src, size_t size, uint32_t width, uint32_t rows, uint32_t stride,
+            uint8_t* dst) {
+    const uint8_t* in = src;
+    const uint8_t* end = src + size;
+    uint32_t block[BLOCK];
+    uint32_t n = BLOCK;
+    uint32_t above = 0;
+
+    for (uint32_t row = 0; row < rows; ++row) {
+        uint8_t* p = dst + static_cast<size_t>(row) * stride;
+        uint32_t prev = above;
+        for (uint32_t col = 0; col < width; ++col) {
+            if (n == BLOCK) {
+                in = unpackBlock(in, end, block);
+                if (!in) {
+                    return false;
+                }
+                n = 0;
+            }
+            // Wraps like the encoder's subtraction; truncated to the container
+            const uint32_t x = prev + unzigzag(block[n++]);
+            storePixel<Bytes>(p + static_cast<size_t>(col) * Bytes, x);
+            prev = x;
+            if (col == 0) {
+                above = x;
+            }
+        }
+    }
+    return in == end;
+}
+
+/// Zigzag residuals of one row against the reference row
+typedef void (*ResidualKernel)(const uint8_t* src, const uint8_t* ref, uint32_t width, uint32_t* out);
+
+/// Reference row plus residuals, truncated to the container
+typedef void (*RestoreKernel)(const uint32_t* in, const uint8_t* ref, uint32_t width, uint8_t* dst);
+
+template <uint32_t Bytes>
+inline uint32_t wrapDiff(uint32_t x, uint32_t r) {
+    // Sign-extend the difference from the container width, so residuals
+    // never need more bits than the pixels
+    const uint32_t sign = 1u << (8 * Bytes - 1);
+    const uint32_t mask = sign | (sign - 1);
+    return (((x - r) & mask) ^ sign) - sign;
+}
+
+template <uint32_t Bytes>
+void residualScalar(const uint8_t* src, const uint8_t* ref, uint32_t width, uint32_t* out) {
+    for (uint32_t i = 0; i < width; ++i) {
+        out[i] = zigzag(wrapDiff<Bytes>(loadPixel<Bytes>(src + static_cast<size_t>(i) * Bytes),
+                                        loadPixel<Bytes>(ref + static_cast<size_t>(i) * Bytes)));
+    }
+}
+
+template <uint32_t Bytes>
+void restoreScalar(const uint32_t* in, const uint8_t* ref, uint32_t width, uint8_t* dst) {
+    for (uint32_t i = 0; i < width; ++i) {
+        const size_t offset = static_cast<size_t>(i) * Bytes;
+        storePixel<Bytes>(dst + offset, loadPixel<Bytes>(ref + offset) + unzigzag(in[i]));
+    }
+}
+
+#if defined(HX_ARCH_X86)
+HX_TARGET("avx2")
+void residualAVX2(const uint8_t* src, const uint8_t* ref, uint32_t width, uint32_t* out) {
+    uint32_t i = 0;
+    for (; i + 16 <= width; i += 16) {
+        const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i * 2));
+        const __m256i r = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ref + i * 2));
+        // 16-bit wrap and zigzag, equal to the scalar 32-bit one
+        const __m256i d = _mm256_sub_epi16(x, r);
+        const __m256i z = _mm256_xor_si256(_mm256_slli_epi16(d, 1), _mm256_srai_epi16(d, 15));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i),
+                            _mm256_cvtepu16_epi32(_mm256_castsi256_si128(z)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i + 8),
+                            _mm256_cvtepu16_epi32(_mm256_extracti128_si256(z, 1)));
+    }
+    residualScalar<2>(src + i * 2, ref + i * 2, width - i, out + i);
+}
+
+HX_TARGET("avx2")
+void restoreAVX2(const uint32_t* in, const uint8_t* ref, uint32_t width, uint8_t* dst) {
+    const __m256i one = _mm256_set1_epi16(1);
+    const __m256i zero = _mm256_setzero_si256();
+    uint32_t i = 0;
+    for (; i + 16 <= width; i += 16) {
+        // Residuals of well-formed data fit 16 bits; packs keeps the order per lane
+        const __m256i packed = _mm256_packus_epi32(
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i)),
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i + 8)));
+        const __m256i z = _mm256_permute4x64_epi64(packed, 0xD8);
+        const __m256i d = _mm256_xor_si256(_mm256_srli_epi16(z, 1),
+                                           _mm256_sub_epi16(zero, _mm256_and_si256(z, one)));
+        const __m256i r = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ref + i * 2));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i * 2), _mm256_add_epi16(r, d));
+    }
+    restoreScalar<2>(in + i, ref + i * 2, width - i, dst + i * 2);
+}
+#endif
+
+template <uint32_t Bytes>
+ResidualKernel selectResidual() {
+#if defined(HX_ARCH_X86)
+    if (Bytes == 2 && g_residualKernels.isa() == XFactory::CPU_AVX2) {
+        return residualAVX2;
+    }
+#endif
+    return residualScalar<Bytes>;
+}
+
+template <uint32_t Bytes>
+RestoreKernel selectRestore() {
+#if defined(HX_ARCH_X86)
+    if (Bytes == 2 && g_residualKernels.isa() == XFactory::CPU_AVX2) {
+        return restoreAVX2;
+    }
+#endif
+    return restoreScalar<Bytes>;
+}
+
+template <uint32_t Bytes>
+size_t encodeTemporal(const uint8_t* src, uint32_t stride, const uint8_t* ref, uint32_t refStride,
+                      uint32_t width, uint32_t rows, uint8_t* dst) {
+    const ResidualKernel residual = selectResidual<Bytes>();
+
+    // Blocks run on across rows; the part of a block a row leaves over
+    // moves to the front for the next one
+    std::vector<uint32_t> values(static_cast<size_t>(width) + BLOCK);
+    uint32_t n = 0;
+    uint8_t* out = dst;
+    for (uint32_t row = 0; row < rows; ++row) {
+        residual(src + static_cast<size_t>(row) * stride, ref + static_cast<size_t>(row) * refStride,
+                 width, values.data() + n);
+        n += width;
+        uint32_t used = 0;
+        for (; used + BLOCK <= n; used += BLOCK) {
+            out = packBlock(values.data() + used, out);
+        }
+        std::copy(values.begin() + used, values.begin() + n, values.begin());
+        n -= used;
+    }
+    if (n > 0) {
+        std::fill(values.begin() + n, values.begin() + BLOCK, 0u);
+        out = packBlock(values.data(), out);
+    }
+    return static_cast<size_t>(out - dst);
+}
+
+template <uint32_t Bytes>
+bool decodeTemporal(const uint8_t* src, size_t size, const uint8_t* ref, uint32_t refStride,
+                    uint32_t width, uint32_t rows, uint32_t stride, uint8_t* dst) {
+    const RestoreKernel restore = selectRestore<Bytes>();
+    const uint8_t* in = src;
+    const uint8_t* end = src + size;
+
+    std::vector<uint32_t> values(static_cast<size_t>(width) + BLOCK);
+    uint32_t n = 0;
+    for (uint32_t row = 0; row < rows; ++row) {
+        while (n < width) {
+            in = unpackBlock(in, end, values.data() + n);
+            if (!in) {
+                return false;
+            }
+            n += BLOCK;
+        }
+        restore(values.data(), ref + static_cast<size_t>(row) * refStride, width,
+                dst + static_cast<size_t>(row) * stride);
+        std::copy(values.begin() + width, values.begin() + n, values.begin());
+        n -= width;
+    }
+    return in == end;
+}
+
+} // namespace
+
+size_t DeltaPackBound(size_t pixels) {
+    return (pixels + BLOCK - 1) / BLOCK * (1 + BLOCK * sizeof(uint32_t));
+}
+
+size_t DeltaPackEncode(const uint8_t* src, uint32_t width, uint32_t rows, uint32_t stride,
+                       uint32_t bytesPerPixel, uint8_t* dst) {
+    switch (bytesPerPixel) {
+        case 1: return encode<1>(src, width, rows, stride, dst);
+        case 2: return encode<2>(src, width, rows, stride, dst);
+        case 3: return encode<3>(src, width, rows, stride, dst);
+        case 4: return encode<4>(src, width, rows, stride, dst);
+        default: return 0;
+    }
+}
+
+bool DeltaPackDecode(const uint8_t* src, size_t size, uint32_t width, uint32_t rows,
+                     uint32_t stride, uint32_t bytesPerPixel, uint8_t* dst) {
+    switch (bytesPerPixel) {
+        case 1: return decode<1>(src, size, width, rows, stride, dst);
+        case 2: return decode<2>(src, size, width, rows, stride, dst);
+        case 3: return decode<3>(src, size, width, rows, stride, dst);
+        case 4: return decode<4>(src, size, width, rows, stride, dst);
+        default: return false;
+    }
+}
+
+size_t DeltaPackEncodeTemporal(const uint8_t* src, uint32_t stride, const uint8_t* ref,
+                               uint32_t refStride, uint32_t width, uint32_t rows,
+                               uint32_t bytesPerPixel, uint8_t* dst) {
+    switch (bytesPerPixel) {
+        case 1: return encodeTemporal<1>(src, stride, ref, refStride, width, rows, dst);
+        case 2: return encodeTemporal<2>(src, stride, ref, refStride, width, rows, dst);
+        case 3: return encodeTemporal<3>(src, stride, ref, refStride, width, rows, dst);
+        case 4: return encodeTemporal<4>(src, stride, ref, refStride, width, rows, dst);
+        default: return 0;
+    }
+}
+
+bool DeltaPackDecodeTemporal(const uint8_t* src, size_t size, const uint8_t* ref,
+                             uint32_t refStride, uint32_t width, uint32_t rows, uint32_t stride,
+                             uint32_t bytesPerPixel, uint8_t* dst) {
+    switch (bytesPerPixel) {
+        case 1: return decodeTemporal<1>(src, size, ref, refStride, width, rows, stride, dst);
+        case 2: return decodeTemporal<2>(src, size, ref, refStride, width, rows, stride, dst);
+        case 3: return decodeTemporal<3>(src, size, ref, refStride, width, rows, stride, dst);
+        case 4: return decodeTemporal<4>(src, size, ref, refStride, width, rows, stride, dst);
+        default: return false;
+    }
+}
+
+uint32_t DeltaPackStripRows(uint32_t width) {
+    return std::max<uint32_t>(1, STRIP_PIXELS / std::max<uint32_t>(1, width));
+}
+
+bool DeltaPackEncodeStrips(const uint8_t* pixels, uint32_t stride, const uint8_t* ref,
+                           uint32_t refStride, uint32_t width, uint32_t height,
+                           uint32_t bytesPerPixel, uint32_t rowsPerStrip,
+                           std::vector<std::vector<uint8_t> >& strips) {
+    if (bytesPerPixel == 0 || bytesPerPixel > 4 || rowsPerStrip == 0) {
+        return false;
+    }
+    const uint32_t count = (height + rowsPerStrip - 1) / rowsPerStrip;
+    strips.resize(count);
+    ThreadPool::instance().run(static_cast<int>(count), [&](int strip) {
+        const uint32_t first = static_cast<uint32_t>(strip) * rowsPerStrip;
+        const uint32_t rows = std::min(rowsPerStrip, height - first);
+        std::vector<uint8_t>& out = strips[strip];
+        out.resize(DeltaPackBound(static_cast<size_t>(width) * rows));
+        const uint8_t* src = pixels + static_cast<size_t>(first) * stride;
+        const size_t size = ref
+            ? DeltaPackEncodeTemporal(src, stride, ref + static_cast<size_t>(first) * refStride,
+                                      refStride, width, rows, bytesPerPixel, out.data())
+            : DeltaPackEncode(src, width, rows, stride, bytesPerPixel, out.data());
+        out.resize(size);
+    });
+    return true;
+}
+
+bool DeltaPackDecodeStrips(const std::vector<std::vector<uint8_t> >& strips, const uint8_t* ref,
+                           uint32_t refStride, uint32_t width, uint32_t height,
+                           uint32_t bytesPerPixel, uint32_t rowsPerStrip, uint32_t stride,
+                           uint8_t* pixels) {
+    if (rowsPerStrip == 0 || strips.size() < (height + rowsPerStrip - 1) / rowsPerStrip) {
+        return false;
+    }
+    const uint32_t count = (height + rowsPerStrip - 1) / rowsPerStrip;
+    std::atomic<bool> ok(true);
+    ThreadPool::instance().run(static_cast<int>(count), [&](int strip) {
+        const uint32_t first = static_cast<uint32_t>(strip) * rowsPerStrip;
+        const uint32_t rows = std::min(rowsPerStrip, height - first);
+        const std::vector<uint8_t>& in = strips[strip];
+        uint8_t* dst = pixels + static_cast<size_t>(first) * stride;
+        const bool stripOk = ref
+            ? DeltaPackDecodeTemporal(in.data(), in.size(), ref + static_cast<size_t>(first) * refStride,
+                                      refStride, width, rows, stride, bytesPerPixel, dst)
+            : DeltaPackDecode(in.data(), in.size(), width, rows, stride, bytesPerPixel, dst);
+        if (!stripOk) {
+            ok = false;
+        }
+    });
+    return ok;
+}
+
+} // namespace Internal
+} // namespace HX
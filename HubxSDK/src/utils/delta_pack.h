@@ -0,0 +1,140 @@
+// ============================================================================
+// delta_pack.h
+// ============================================================================
+
+/**
+ * @file delta_pack.h
+ * @brief Lossless delta + bit-packing codec for image strips
+ * @version 2.1.0
+ *
+ * This header is INTERNAL to hubx.dll. Each pixel is predicted from its
+ * left neighbour (the first pixel of a row from the pixel above), the
+ * residual is zigzag-mapped and residuals are packed in blocks of 32 at
+ * the smallest bit width that holds the block:
+ *
+ *   [width byte][32 * width bits] [width byte][32 * width bits] ...
+ *
+ * The last block is padded with zero residuals. A strip decodes on its
+ * own, so strips can be encoded and decoded in parallel.
+ *
+ * The temporal variant predicts every pixel from the same pixel of a
+ * reference frame, typically the frame before, with the difference
+ * wrapped to the container size. In a static scene most blocks are then
+ * noise of a few bits or zero (one byte per 32 pixels). The per-row
+ * residual and restore kernels have AVX2 versions for 2-byte pixels.
+ */
+
+#ifndef DELTA_PACK_H
+#define DELTA_PACK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace HX {
+namespace Internal {
+
+/**
+ * @brief Largest encoded size of a strip
+ * @param pixels Pixels in the strip
+ */
+size_t DeltaPackBound(size_t pixels);
+
+/**
+ * @brief Encode a strip
+ * @param src First row
+ * @param width Pixels per row
+ * @param rows Rows in the strip
+ * @param stride Bytes between row starts
+ * @param bytesPerPixel Container size (1-4), native byte order
+ * @param dst Output, at least DeltaPackBound(width * rows) bytes
+ * @return Encoded bytes, 0 if bytesPerPixel is unsupported
+ */
+size_t DeltaPackEncode(const uint8_t* src, uint32_t width, uint32_t rows, uint32_t stride,
+                       uint32_t bytesPerPixel, uint8_t* dst);
+
+/**
+ * @brief Decode a strip
+ * @param src Encoded strip
+ * @param size Encoded bytes
+ * @param width Pixels per row
+ * @param rows Rows in the strip
+ * @param stride Bytes between output row starts
+ * @param bytesPerPixel Container size (1-4)
+ * @param dst First output row
+ * @return false if the data is truncated or malformed
+ */
+bool DeltaPackDecode(const uint8_t* src, size_t size, uint32_t width, uint32_t rows,
+                     uint32_t stride, uint32_t bytesPerPixel, uint8_t* dst);
+
+/**
+ * @brief Encode a strip as residuals against a reference
+ * @param src First row
+ * @param stride Bytes between row starts
+ * @param ref First row of the reference, same geometry
+ * @param refStride Bytes between reference row starts
+ * @param width Pixels per row
+ * @param rows Rows in the strip
+ * @param bytesPerPixel Container size (1-4), native byte order
+ * @param dst Output, at least DeltaPackBound(width * rows) bytes
+ * @return Encoded bytes, 0 if bytesPerPixel is unsupported
+ */
+size_t DeltaPackEncodeTemporal(const uint8_t* src, uint32_t stride, const uint8_t* ref,
+                               uint32_t refStride, uint32_t width, uint32_t rows,
+                               uint32_t bytesPerPixel, uint8_t* dst);
+
+/**
+ * @brief Decode a strip of residuals against a reference
+ * @param src Encoded strip
+ * @param size Encoded bytes
+ * @param ref First row of the reference; may be dst to decode in place
+ * @param refStride Bytes between reference row starts
+ * @param width Pixels per row
+ * @param rows Rows in the strip
+ * @param stride Bytes between output row starts
+ * @param bytesPerPixel Container size (1-4)
+ * @param dst First output row
+ * @return false if the data is truncated or malformed
+ */
+bool DeltaPackDecodeTemporal(const uint8_t* src, size_t size, const uint8_t* ref,
+                             uint32_t refStride, uint32_t width, uint32_t rows, uint32_t stride,
+                             uint32_t bytesPerPixel, uint8_t* dst);
+
+/// Rows per strip that spreads an image of this width over the pool
+uint32_t DeltaPackStripRows(uint32_t width);
+
+/**
+ * @brief Encode an image as strips, in parallel on the processing pool
+ * @param pixels First row
+ * @param stride Bytes between row starts
+ * @param ref Reference frame for the temporal codec, nullptr for the
+ *        spatial one
+ * @param refStride Bytes between reference row starts
+ * @param width Pixels per row
+ * @param height Rows
+ * @param bytesPerPixel Container size (1-4)
+ * @param rowsPerStrip Rows per strip, see DeltaPackStripRows()
+ * @param strips Output, one encoded strip per entry
+ * @return false if bytesPerPixel is unsupported
+ */
+bool DeltaPackEncodeStrips(const uint8_t* pixels, uint32_t stride, const uint8_t* ref,
+                           uint32_t refStride, uint32_t width, uint32_t height,
+                           uint32_t bytesPerPixel, uint32_t rowsPerStrip,
+                           std::vector<std::vector<uint8_t> >& strips);
+
+/**
+ * @brief Decode the strips of an image, in parallel on the processing pool
+ * @param strips Encoded strips, as DeltaPackEncodeStrips() wrote them
+ * @param ref Reference frame for the temporal codec (may be pixels),
+ *        nullptr for the spatial one
+ * @return false if a strip is missing, truncated or malformed
+ */
+bool DeltaPackDecodeStrips(const std::vector<std::vector<uint8_t> >& strips, const uint8_t* ref,
+                           uint32_t refStride, uint32_t width, uint32_t height,
+                           uint32_t bytesPerPixel, uint32_t rowsPerStrip, uint32_t stride,
+                           uint8_t* pixels);
+
+} // namespace Internal
+} // namespace HX
+
+#endif // DELTA_PACK_H
@@ -0,0 +1,169 @@
+// ============================================================================
+// device_clock.h
+// ============================================================================
+
+/**
+ * @file device_clock.h
+ * @brief Detector timestamp unwrapping and correlation to the host clock
+ * @version 2.1.0
+ *
+ * This header is INTERNAL to hubx.dll. XLibPacketHeader::timestamp is a
+ * free-running 32-bit microsecond counter of each detector. DeviceClock
+ * extends it to 64 bits and maps it onto a reference clock - the NIC's
+ * PTP hardware clock when packets carry receive timestamps, the host
+ * clock (CLOCK_REALTIME, PTP-disciplined by phc2sys) otherwise.
+ *
+ * The mapping is a minimum-delay filter: each packet gives the offset
+ * reference - device, which is the true clock offset plus transit and
+ * queueing delay. The smallest offset of each one-second window is the
+ * least delayed packet; two consecutive windows give offset and drift.
+ * One instance per receiving thread, no locking.
+ */
+
+#ifndef DEVICE_CLOCK_H
+#define DEVICE_CLOCK_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+
+namespace HX {
+namespace Internal {
+
+/**
+ * @brief Host wall clock in nanoseconds since 1970
+ */
+inline uint64_t HostTimeNs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+}
+
+/**
+ * @class DeviceClock
+ * @brief One detector's timestamps on the reference clock
+ */
+class DeviceClock {
+public:
+    /// Device time a window covers
+    static const uint64_t WINDOW_US = 1000000;
+
+    /// Largest drift believed between two crystals, in ns per us (500 ppm)
+    static double maxDrift() { return 0.0005; }
+
+    DeviceClock() {
+        reset();
+    }
+
+    void reset() {
+        m_valid = false;
+        m_last = 0;
+        m_ext = 0;
+        m_anchors = 0;
+        m_windowOpen = false;
+        m_windowStart = 0;
+        m_minDevice = 0;
+        m_minOffset = 0;
+        m_anchorDevice = 0;
+        m_anchorOffset = 0;
+        m_drift = 0.0;
+    }
+
+    /**
+     * @brief Extend a 32-bit header timestamp
+     * @return Device microseconds, monotonic across wraps; 0 while the
+     *         detector has only sent zero (no clock)
+     */
+    uint64_t unwrap(uint32_t us) {
+        if (!m_valid) {
+            if (us == 0) {
+                return 0;
+            }
+            m_valid = true;
+            m_ext = us;
+        } else {
+            // Small steps back (reordered packets) are kept signed
+            m_ext += static_cast<int64_t>(static_cast<int32_t>(us - m_last));
+        }
+        m_last = us;
+        return m_ext;
+    }
+
+    /**
+     * @brief Pair a device time with the reference time it arrived at
+     */
+    void observe(uint64_t deviceUs, uint64_t referenceNs) {
+        if (deviceUs == 0 || referenceNs == 0) {
+            return;
+        }
+        const int64_t offset = static_cast<int64_t>(referenceNs - deviceUs * 1000);
+
+        if (m_windowOpen && deviceUs >= m_windowStart + WINDOW_US) {
+            closeWindow();
+        }
+        if (!m_windowOpen) {
+            m_windowOpen = true;
+            m_windowStart = deviceUs;
+            m_minDevice = deviceUs;
+            m_minOffset = offset;
+        } else if (offset < m_minOffset) {
+            m_minDevice = deviceUs;
+            m_minOffset = offset;
+        }
+    }
+
+    /**
+     * @brief Device time on the reference clock
+     * @return Nanoseconds, 0 before the first observation
+     */
+    uint64_t toReference(uint64_t deviceUs) const {
+        if (deviceUs == 0) {
+            return 0;
+        }
+        int64_t offset;
+        if (m_anchors == 0) {
+            if (!m_windowOpen) {
+                return 0;
+            }
+            offset = m_minOffset;
+        } else {
+            offset = m_anchorOffset + static_cast<int64_t>(
+                m_drift * static_cast<double>(static_cast<int64_t>(deviceUs - m_anchorDevice)));
+        }
+        return deviceUs * 1000 + static_cast<uint64_t>(offset);
+    }
+
+private:
+    void closeWindow() {
+        if (m_anchors > 0 && m_minDevice > m_anchorDevice) {
+            const double drift = static_cast<double>(m_minOffset - m_anchorOffset) /
+                                 static_cast<double>(m_minDevice - m_anchorDevice);
+            m_drift = std::max(-maxDrift() * 1000.0, std::min(maxDrift() * 1000.0, drift));
+        }
+        m_anchorDevice = m_minDevice;
+        m_anchorOffset = m_minOffset;
+        ++m_anchors;
+        m_windowOpen = false;
+    }
+
+    // Unwrapping
+    bool m_valid;
+    uint32_t m_last;
+    uint64_t m_ext;
+
+    // Window being filtered
+    uint32_t m_anchors;
+    bool m_windowOpen;
+    uint64_t m_windowStart;
+    uint64_t m_minDevice;
+    int64_t m_minOffset;
+
+    // Fit from the last closed windows: offset(d) = anchor + drift * (d - anchorDevice)
+    uint64_t m_anchorDevice;
+    int64_t m_anchorOffset;
+    double m_drift;                 ///< ns of offset per us of device time
+};
+
+} // namespace Internal
+} // namespace HX
+
+#endif // DEVICE_CLOCK_H
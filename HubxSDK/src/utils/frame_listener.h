@@ -0,0 +1,38 @@
+// ============================================================================
+// frame_listener.h
+// ============================================================================
+
+/**
+ * @file frame_listener.h
+ * @brief Frame completion notifications from XFrame to XGrabber
+ * @version 2.1.0
+ *
+ * This header is INTERNAL to hubx.dll. An XGrabber running Grab(frames)
+ * registers itself with its XFrame so it learns of every finished frame
+ * and can stop the acquisition exactly after the last one.
+ */
+
+#ifndef FRAME_LISTENER_H
+#define FRAME_LISTENER_H
+
+#include <cstdint>
+
+namespace HX {
+namespace Internal {
+
+class FrameListener {
+public:
+    virtual ~FrameListener() {}
+
+    /**
+     * @brief A frame of the sequence was finished
+     * @param frames Frames finished since the listener was set
+     * @note Called from the assembling thread once OnFrameReady() returned
+     */
+    virtual void onFrameDone(uint32_t frames) = 0;
+};
+
+} // namespace Internal
+} // namespace HX
+
+#endif // FRAME_LISTENER_H
@@ -0,0 +1,284 @@
+// ============================================================================
+// frame_pyramid.cpp
+// ============================================================================
+
+/**
+ * @file frame_pyramid.cpp
+ * @brief Row-pair reduction kernels for the frame pyramid
+ * @version 2.1.0
+ *
+ * 16-bit rows take an AVX2 kernel when the CPU has it: the two rows are
+ * combined sixteen pixels at a time, then each 32-bit word holds one
+ * column pair, split with a mask and a shift instead of a shuffle.
+ */
+
+#include "frame_pyramid.h"
+#include "cpu_features.h"
+#include "XPixel.h"
+#include <algorithm>
+#include <new>
+
+namespace HX {
+namespace Internal {
+
+namespace {
+
+const KernelFamily g_pyramidKernels("frame_pyramid", XFactory::CPU_AVX2);
+
+/// Source rows of a pair and output row, per reduced image
+struct PairRows {
+    const uint8_t* top[FramePyramid::STAT_COUNT];
+    const uint8_t* bottom[FramePyramid::STAT_COUNT];
+    uint8_t* out[FramePyramid::STAT_COUNT];
+};
+
+template <uint32_t Bytes>
+void pairScalar(const PairRows& rows, uint32_t first, uint32_t outWidth, uint32_t srcWidth) {
+    typedef XPixelAccess<Bytes> Pixel;
+    for (uint32_t x = first; x < outWidth; ++x) {
+        const size_t x0 = static_cast<size_t>(2 * x) * Bytes;
+        const size_t x1 = static_cast<size_t>(std::min(2 * x + 1, srcWidth - 1)) * Bytes;
+        const size_t o = static_cast<size_t>(x) * Bytes;
+
+        const uint8_t* a = rows.top[FramePyramid::STAT_MIN];
+        const uint8_t* b = rows.bottom[FramePyramid::STAT_MIN];
+        Pixel::Store(rows.out[FramePyramid::STAT_MIN] + o,
+                     std::min(std::min(Pixel::Load(a + x0), Pixel::Load(a + x1)),
+                              std::min(Pixel::Load(b + x0), Pixel::Load(b + x1))));
+
+        a = rows.top[FramePyramid::STAT_MAX];
+        b = rows.bottom[FramePyramid::STAT_MAX];
+        Pixel::Store(rows.out[FramePyramid::STAT_MAX] + o,
+                     std::max(std::max(Pixel::Load(a + x0), Pixel::Load(a + x1)),
+                              std::max(Pixel::Load(b + x0), Pixel::Load(b + x1))));
+
+        a = rows.top[FramePyramid::STAT_MEAN];
+        b = rows.bottom[FramePyramid::STAT_MEAN];
+        const uint64_t sum = static_cast<uint64_t>(Pixel::Load(a + x0)) + Pixel::Load(a + x1) +
+                             Pixel::Load(b + x0) + Pixel::Load(b + x1);
+        Pixel::Store(rows.out[FramePyramid::STAT_MEAN] + o, static_cast<uint32_t>((sum + 2) / 4));
+    }
+}
+
+#if defined(HX_ARCH_X86)
+/// Whole column pairs, 16 outputs at a time; returns the outputs written
+HX_TARGET("avx2")
+uint32_t pair16AVX2(const PairRows& rows, uint32_t outWidth, uint32_t srcWidth) {
+    const __m256i low = _mm256_set1_epi32(0xFFFF);
+    const __m256i two = _mm256_set1_epi32(2);
+    const uint32_t whole = std::min(outWidth, srcWidth / 2);
+    const __m256i* top[FramePyramid::STAT_COUNT];
+    const __m256i* bottom[FramePyramid::STAT_COUNT];
+    __m256i* out[FramePyramid::STAT_COUNT];
+    for (uint32_t s = 0; s < FramePyramid::STAT_COUNT; ++s) {
+        top[s] = reinterpret_cast<const __m256i*>(rows.top[s]);
+        bottom[s] = reinterpret_cast<const __m256i*>(rows.bottom[s]);
+        out[s] = reinterpret_cast<__m256i*>(rows.out[s]);
+    }
+
+    uint32_t x = 0;
+    for (; x + 16 <= whole; x += 16) {
+        // 32 source pixels per row make 16 outputs; i indexes 16-pixel vectors
+        const uint32_t i = x / 8;
+        const uint32_t o = x / 16;
+
+        __m256i m0 = _mm256_min_epu16(_mm256_loadu_si256(top[FramePyramid::STAT_MIN] + i),
+                                      _mm256_loadu_si256(bottom[FramePyramid::STAT_MIN] + i));
+        __m256i m1 = _mm256_min_epu16(_mm256_loadu_si256(top[FramePyramid::STAT_MIN] + i + 1),
+                                      _mm256_loadu_si256(bottom[FramePyramid::STAT_MIN] + i + 1));
+        m0 = _mm256_min_epi32(_mm256_and_si256(m0, low), _mm256_srli_epi32(m0, 16));
+        m1 = _mm256_min_epi32(_mm256_and_si256(m1, low), _mm256_srli_epi32(m1, 16));
+        _mm256_storeu_si256(out[FramePyramid::STAT_MIN] + o,
+                            _mm256_permute4x64_epi64(_mm256_packus_epi32(m0, m1), 0xD8));
+
+        m0 = _mm256_max_epu16(_mm256_loadu_si256(top[FramePyramid::STAT_MAX] + i),
+                              _mm256_loadu_si256(bottom[FramePyramid::STAT_MAX] + i));
+        m1 = _mm256_max_epu16(_mm256_loadu_si256(top[FramePyramid::STAT_MAX] + i + 1),
+                              _mm256_loadu_si256(bottom[FramePyramid::STAT_MAX] + i + 1));
+        m0 = _mm256_max_epi32(_mm256_and_si256(m0, low), _mm256_srli_epi32(m0, 16));
+        m1 = _mm256_max_epi32(_mm256_and_si256(m1, low), _mm256_srli_epi32(m1, 16));
+        _mm256_storeu_si256(out[FramePyramid::STAT_MAX] + o,
+                            _mm256_permute4x64_epi64(_mm256_packus_epi32(m0, m1), 0xD8));
+
+        // Sums of four 16-bit pixels fit the 32-bit words
+        const __m256i a0 = _mm256_loadu_si256(top[FramePyramid::STAT_MEAN] + i);
+        const __m256i a1 = _mm256_loadu_si256(top[FramePyramid::STAT_MEAN] + i + 1);
+        const __m256i b0 = _mm256_loadu_si256(bottom[FramePyramid::STAT_MEAN] + i);
+        const __m256i b1 = _mm256_loadu_si256(bottom[FramePyramid::STAT_MEAN] + i + 1);
+        m0 = _mm256_add_epi32(_mm256_add_epi32(_mm256_and_si256(a0, low), _mm256_srli_epi32(a0, 16)),
+                              _mm256_add_epi32(_mm256_and_si256(b0, low), _mm256_srli_epi32(b0, 16)));
+        m1 = _mm256_add_epi32(_mm256_add_epi32(_mm256_and_si256(a1, low), _mm256_srli_epi32(a1, 16)),
+                              _mm256_add_epi32(_mm256_and_si256(b1, low), _mm256_srli_epi32(b1, 16)));
+        m0 = _mm256_srli_epi32(_mm256_add_epi32(m0, two), 2);
+        m1 = _mm256_srli_epi32(_mm256_add_epi32(m1, two), 2);
+        _mm256_storeu_si256(out[FramePyramid::STAT_MEAN] + o,
+                            _mm256_permute4x64_epi64(_mm256_packus_epi32(m0, m1), 0xD8));
+    }
+    return x;
+}
+#endif
+
+} // namespace
+
+FramePyramid::FramePyramid() : m_levels(0), m_pixelDepth(0) {
+    for (uint32_t l = 0; l < MAX_LEVELS; ++l) {
+        m_done[l] = 0;
+        m_widths[l] = 0;
+        m_heights[l] = 0;
+        m_shown[l] = 0;
+    }
+}
+
+bool FramePyramid::configure(uint32_t width, uint32_t height, uint8_t pixelDepth, uint32_t levels) {
+    const uint32_t bytesPerPixel = (pixelDepth + 7) / 8;
+    if (levels == 0 || levels > MAX_LEVELS || bytesPerPixel == 0 || bytesPerPixel > 4) {
+        return false;
+    }
+    m_levels = levels;
+    m_pixelDepth = pixelDepth;
+    for (uint32_t l = 0; l < MAX_LEVELS; ++l) {
+        width = (width + 1) / 2;
+        height = (height + 1) / 2;
+        const bool used = l < levels;
+        m_widths[l] = used ? width : 0;
+        m_heights[l] = used ? height : 0;
+        m_shown[l] = m_heights[l];
+        for (uint32_t s = 0; s < STAT_COUNT; ++s) {
+            try {
+                m_storage[l][s].assign(static_cast<size_t>(m_widths[l]) * m_heights[l] * bytesPerPixel, 0);
+            } catch (const std::bad_alloc&) {
+                m_levels = 0;
+                return false;
+            }
+        }
+    }
+    reset();
+    bind();
+    return true;
+}
+
+void FramePyramid::reset() {
+    for (uint32_t l = 0; l < MAX_LEVELS; ++l) {
+        m_done[l] = 0;
+    }
+}
+
+void FramePyramid::advance(const XImage& frame, uint32_t rows) {
+    uint32_t srcHeight = frame._height;
+    uint32_t ready = std::min(rows, srcHeight);
+    for (uint32_t l = 0; l < m_levels; ++l) {
+        // A shorter frame (object framing) has fewer rows at every level
+        const uint32_t height = std::min((srcHeight + 1) / 2, m_heights[l]);
+        while (m_done[l] < height) {
+            const uint32_t row = m_done[l];
+            if (std::min(2 * row + 1, srcHeight - 1) >= ready) {
+                break;
+            }
+            reduceRow(l, row, frame, srcHeight);
+            ++m_done[l];
+        }
+        if (m_shown[l] != height) {
+            m_shown[l] = height;
+            for (uint32_t s = 0; s < STAT_COUNT; ++s) {
+                m_images[l][s]._height = height;
+            }
+        }
+        ready = m_done[l];
+        srcHeight = height;
+    }
+}
+
+void FramePyramid::reduceRow(uint32_t level, uint32_t row, const XImage& frame, uint32_t srcHeight) {
+    const uint32_t bytesPerPixel = (m_pixelDepth + 7) / 8;
+    const uint32_t row0 = 2 * row;
+    const uint32_t row1 = std::min(row0 + 1, srcHeight - 1);
+    const uint32_t srcWidth = (level == 0) ? frame._width : m_widths[level - 1];
+    const uint32_t outWidth = m_widths[level];
+
+    PairRows rows;
+    for (uint32_t s = 0; s < STAT_COUNT; ++s) {
+        if (level == 0) {
+            // Every reduced image starts from the frame's own pixels
+            const uint8_t* base = frame._data_ + frame._data_offset;
+            rows.top[s] = base + static_cast<size_t>(row0) * frame._stride;
+            rows.bottom[s] = base + static_cast<size_t>(row1) * frame._stride;
+        } else {
+            const size_t stride = static_cast<size_t>(srcWidth) * bytesPerPixel;
+            const uint8_t* base = m_storage[level - 1][s].data();
+            rows.top[s] = base + row0 * stride;
+            rows.bottom[s] = base + row1 * stride;
+        }
+        rows.out[s] = m_storage[level][s].data() + static_cast<size_t>(row) * outWidth * bytesPerPixel;
+    }
+
+    switch (bytesPerPixel) {
+        case 1: pairScalar<1>(rows, 0, outWidth, srcWidth); break;
+        case 2: {
+            uint32_t first = 0;
+#if defined(HX_ARCH_X86)
+            if (g_pyramidKernels.isa() == XFactory::CPU_AVX2) {
+                first = pair16AVX2(rows, outWidth, srcWidth);
+            }
+#endif
+            pairScalar<2>(rows, first, outWidth, srcWidth);
+            break;
+        }
+        case 3: pairScalar<3>(rows, 0, outWidth, srcWidth); break;
+        default: pairScalar<4>(rows, 0, outWidth, srcWidth); break;
+    }
+}
+
+void FramePyramid::swap(FramePyramid& other) {
+    std::swap(m_levels, other.m_levels);
+    std::swap(m_pixelDepth, other.m_pixelDepth);
+    for (uint32_t l = 0; l < MAX_LEVELS; ++l) {
+        std::swap(m_done[l], other.m_done[l]);
+        std::swap(m_widths[l], other.m_widths[l]);
+        std::swap(m_heights[l], other.m_heights[l]);
+        std::swap(m_shown[l], other.m_shown[l]);
+        for (uint32_t s = 0; s < STAT_COUNT; ++s) {
+            m_storage[l][s].swap(other.m_storage[l][s]);
+        }
+    }
+    bind();
+    other.bind();
+}
+
+const XImage* FramePyramid::image(uint32_t level, Stat stat) const {
+    if (level == 0 || level > m_levels || stat >= STAT_COUNT) {
+        return nullptr;
+    }
+    return &m_images[level - 1][stat];
+}
+
+uint64_t FramePyramid::bytes() const {
+    uint64_t total = 0;
+    for (uint32_t l = 0; l < MAX_LEVELS; ++l) {
+        for (uint32_t s = 0; s < STAT_COUNT; ++s) {
+            total += m_storage[l][s].capacity();
+        }
+    }
+    return total;
+}
+
+uint64_t FramePyramid::bytesFor(uint32_t width, uint32_t height, uint8_t pixelDepth, uint32_t levels) {
+    uint64_t total = 0;
+    for (uint32_t l = 0; l < levels && l < MAX_LEVELS; ++l) {
+        width = (width + 1) / 2;
+        height = (height + 1) / 2;
+        total += static_cast<uint64_t>(width) * height * ((pixelDepth + 7) / 8) * STAT_COUNT;
+    }
+    return total;
+}
+
+void FramePyramid::bind() {
+    for (uint32_t l = 0; l < MAX_LEVELS; ++l) {
+        for (uint32_t s = 0; s < STAT_COUNT; ++s) {
+            m_images[l][s].SetData(m_storage[l][s].empty() ? nullptr : m_storage[l][s].data(),
+                                   m_widths[l], m_shown[l], m_pixelDepth, false);
+        }
+    }
+}
+
+} // namespace Internal
+} // namespace HX
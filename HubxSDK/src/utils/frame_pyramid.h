@@ -0,0 +1,117 @@
+// ============================================================================
+// frame_pyramid.h
+// ============================================================================
+
+/**
+ * @file frame_pyramid.h
+ * @brief Min/max/mean reduced levels of a frame, built as its rows arrive
+ * @version 2.1.0
+ *
+ * This header is INTERNAL to hubx.dll. Level 1 reduces each pair of frame
+ * rows to one row of 2x2 block minima, maxima and means; every further
+ * level reduces pairs of rows of the level before in the same way. Rows
+ * are reduced as soon as both rows of a pair are in, so the reduction
+ * reads frame rows while assembly still has them in cache and the levels
+ * are complete when the last row arrives.
+ *
+ * An odd last row or column is repeated, so edge blocks cover only the
+ * pixels they hold; the means are those of XFile's tiled pyramid.
+ */
+
+#ifndef FRAME_PYRAMID_H
+#define FRAME_PYRAMID_H
+
+#include "XImage.h"
+#include <cstdint>
+#include <vector>
+
+namespace HX {
+namespace Internal {
+
+/**
+ * @class FramePyramid
+ * @brief Reduced levels of one frame buffer
+ */
+class FramePyramid {
+public:
+    /// Levels after the frame: 2x, 4x and 8x
+    static const uint32_t MAX_LEVELS = 3;
+
+    /// Reduced images of a level
+    enum Stat {
+        STAT_MIN = 0,
+        STAT_MAX,
+        STAT_MEAN,
+        STAT_COUNT
+    };
+
+    FramePyramid();
+
+    /**
+     * @brief Size the levels for a frame format
+     * @param width Frame width
+     * @param height Frame height, the most rows a frame holds
+     * @param pixelDepth Bits per pixel (1-32)
+     * @param levels Levels to build (1 - MAX_LEVELS)
+     * @return false if the levels cannot be allocated
+     */
+    bool configure(uint32_t width, uint32_t height, uint8_t pixelDepth, uint32_t levels);
+
+    /**
+     * @brief Start over for the next frame
+     */
+    void reset();
+
+    /**
+     * @brief Reduce every pair of rows that is complete
+     * @param frame Frame being built; its _height sets the level heights
+     * @param rows Rows at the top of the frame that are final
+     *
+     * @note Rows are taken in order: rows already reduced are not read
+     *       again, so call it with the full height once the frame is done
+     */
+    void advance(const XImage& frame, uint32_t rows);
+
+    /**
+     * @brief Exchange levels with another pyramid of the same format
+     */
+    void swap(FramePyramid& other);
+
+    /**
+     * @brief Get a level once the frame is reduced
+     * @param level 1 - levels()
+     * @param stat Reduced image wanted
+     * @return Level image, nullptr if level is out of range
+     */
+    const XImage* image(uint32_t level, Stat stat) const;
+
+    uint32_t levels() const { return m_levels; }
+
+    /// Level bytes, for memory profiling
+    uint64_t bytes() const;
+    
+    /// Level bytes configure() would allocate
+    static uint64_t bytesFor(uint32_t width, uint32_t height, uint8_t pixelDepth, uint32_t levels);
+
+private:
+    void bind();
+    void reduceRow(uint32_t level, uint32_t row, const XImage& frame, uint32_t srcHeight);
+
+    uint32_t m_levels;
+    uint8_t m_pixelDepth;
+    uint32_t m_done[MAX_LEVELS];                            ///< Rows reduced per level
+    std::vector<uint8_t> m_storage[MAX_LEVELS][STAT_COUNT];
+    uint32_t m_widths[MAX_LEVELS];
+    uint32_t m_heights[MAX_LEVELS];                         ///< Allocated rows
+    uint32_t m_shown[MAX_LEVELS];                           ///< Rows of the current frame
+    XImage m_images[MAX_LEVELS][STAT_COUNT];                ///< Views of m_storage
+
+    // Non-copyable
+    FramePyramid(const FramePyramid&) = delete;
+    FramePyramid& operator=(const FramePyramid&) = delete;
+};
+
+} // namespace Internal
+} // namespace HX
+
+#endif // FRAME_PYRAMID_H
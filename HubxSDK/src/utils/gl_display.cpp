@@ -0,0 +1,420 @@
+// ============================================================================
+// gl_display.cpp
+// ============================================================================
+
+/**
+ * @file gl_display.cpp
+ * @brief OpenGL presentation of raw frames (WGL)
+ * @version 2.1.0
+ */
+
+#include "gl_display.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#include <GL/gl.h>
+#include <iostream>
+#endif
+
+namespace HX {
+namespace Internal {
+
+#ifdef _WIN32
+
+namespace {
+
+// OpenGL 2.0 names missing from the Windows 1.1 header
+const GLenum HX_GL_FRAGMENT_SHADER = 0x8B30;
+const GLenum HX_GL_VERTEX_SHADER   = 0x8B31;
+const GLenum HX_GL_COMPILE_STATUS  = 0x8B81;
+const GLenum HX_GL_LINK_STATUS     = 0x8B82;
+const GLenum HX_GL_TEXTURE0        = 0x84C0;
+const GLenum HX_GL_TEXTURE1        = 0x84C1;
+const GLenum HX_GL_CLAMP_TO_EDGE   = 0x812F;
+const GLenum HX_GL_BGR             = 0x80E0;
+
+typedef char GLchar;
+typedef GLuint (APIENTRY *PfnCreateShader)(GLenum type);
+typedef void   (APIENTRY *PfnShaderSource)(GLuint shader, GLsizei count, const GLchar* const* text,
+                                           const GLint* length);
+typedef void   (APIENTRY *PfnCompileShader)(GLuint shader);
+typedef void   (APIENTRY *PfnGetShaderiv)(GLuint shader, GLenum name, GLint* value);
+typedef void   (APIENTRY *PfnDeleteShader)(GLuint shader);
+typedef GLuint (APIENTRY *PfnCreateProgram)();
+typedef void   (APIENTRY *PfnAttachShader)(GLuint program, GLuint shader);
+typedef void   (APIENTRY *PfnLinkProgram)(GLuint program);
+typedef void   (APIENTRY *PfnGetProgramiv)(GLuint program, GLenum name, GLint* value);
+typedef void   (APIENTRY *PfnUseProgram)(GLuint program);
+typedef void   (APIENTRY *PfnDeleteProgram)(GLuint program);
+typedef GLint  (APIENTRY *PfnGetUniformLocation)(GLuint program, const GLchar* name);
+typedef void   (APIENTRY *PfnUniform1i)(GLint location, GLint value);
+typedef void   (APIENTRY *PfnUniform1f)(GLint location, GLfloat value);
+typedef void   (APIENTRY *PfnActiveTexture)(GLenum texture);
+
+/**
+ * @brief OpenGL 2.0 entry points, resolved once a context is current
+ */
+struct GlFunctions {
+    PfnCreateShader createShader;
+    PfnShaderSource shaderSource;
+    PfnCompileShader compileShader;
+    PfnGetShaderiv getShaderiv;
+    PfnDeleteShader deleteShader;
+    PfnCreateProgram createProgram;
+    PfnAttachShader attachShader;
+    PfnLinkProgram linkProgram;
+    PfnGetProgramiv getProgramiv;
+    PfnUseProgram useProgram;
+    PfnDeleteProgram deleteProgram;
+    PfnGetUniformLocation getUniformLocation;
+    PfnUniform1i uniform1i;
+    PfnUniform1f uniform1f;
+    PfnActiveTexture activeTexture;
+};
+
+GlFunctions gl;
+
+template <typename Fn>
+bool resolve(Fn& fn, const char* name) {
+    fn = reinterpret_cast<Fn>(wglGetProcAddress(name));
+    return fn != nullptr;
+}
+
+const char* const VERTEX_SHADER =
+    "varying vec2 texCoord;\n"
+    "void main() {\n"
+    "    texCoord = gl_MultiTexCoord0.xy;\n"
+    "    gl_Position = gl_Vertex;\n"
+    "}\n";
+
+// Window, then the color table; the ring offset rolls a waterfall
+const char* const FRAGMENT_SHADER =
+    "uniform sampler2D image;\n"
+    "uniform sampler2D lut;\n"
+    "uniform float low;\n"
+    "uniform float range;\n"
+    "uniform float offset;\n"
+    "varying vec2 texCoord;\n"
+    "void main() {\n"
+    "    float v = texture2D(image, vec2(texCoord.x, fract(texCoord.y + offset))).r;\n"
+    "    float level = clamp((v - low) / range, 0.0, 1.0);\n"
+    "    gl_FragColor = vec4(texture2D(lut, vec2((level * 255.0 + 0.5) / 256.0, 0.5)).rgb, 1.0);\n"
+    "}\n";
+
+GLuint compileShader(GLenum type, const char* source) {
+    GLuint shader = gl.createShader(type);
+    gl.shaderSource(shader, 1, &source, nullptr);
+    gl.compileShader(shader);
+    GLint ok = 0;
+    gl.getShaderiv(shader, HX_GL_COMPILE_STATUS, &ok);
+    if (!ok) {
+        gl.deleteShader(shader);
+        return 0;
+    }
+    return shader;
+}
+
+} // namespace
+
+GlDisplay::GlDisplay()
+    : m_window(nullptr)
+    , m_dc(nullptr)
+    , m_context(nullptr)
+    , m_program(0)
+    , m_imageTexture(0)
+    , m_lutTexture(0)
+    , m_texWidth(0)
+    , m_texHeight(0)
+    , m_texBytes(0)
+    , m_lowLocation(-1)
+    , m_rangeLocation(-1)
+    , m_offsetLocation(-1)
+{
+}
+
+GlDisplay::~GlDisplay() {
+    destroy();
+}
+
+bool GlDisplay::create(void* window) {
+    destroy();
+    if (!window) {
+        return false;
+    }
+    HWND hwnd = static_cast<HWND>(window);
+    HDC dc = GetDC(hwnd);
+    if (!dc) {
+        return false;
+    }
+
+    PIXELFORMATDESCRIPTOR pfd;
+    ZeroMemory(&pfd, sizeof(pfd));
+    pfd.nSize = sizeof(pfd);
+    pfd.nVersion = 1;
+    pfd.dwFlags = PFD_DRAW_TO_WINDOW | PFD_SUPPORT_OPENGL | PFD_DOUBLEBUFFER;
+    pfd.iPixelType = PFD_TYPE_RGBA;
+    pfd.cColorBits = 24;
+    pfd.iLayerType = PFD_MAIN_PLANE;
+    const int format = ChoosePixelFormat(dc, &pfd);
+    HGLRC context = nullptr;
+    if (format != 0 && SetPixelFormat(dc, format, &pfd)) {
+        context = wglCreateContext(dc);
+    }
+    if (!context) {
+        ReleaseDC(hwnd, dc);
+        return false;
+    }
+
+    m_window = window;
+    m_dc = dc;
+    m_context = context;
+    if (!begin() || !loadFunctions() || !buildProgram()) {
+        std::cerr << "[XShow] OpenGL 2.0 not available" << std::endl;
+        end();
+        destroy();
+        return false;
+    }
+
+    glGenTextures(1, &m_imageTexture);
+    glGenTextures(1, &m_lutTexture);
+    glBindTexture(GL_TEXTURE_2D, m_lutTexture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, HX_GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, HX_GL_CLAMP_TO_EDGE);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, 256, 1, 0, HX_GL_BGR, GL_UNSIGNED_BYTE, nullptr);
+    end();
+    return true;
+}
+
+void GlDisplay::destroy() {
+    if (m_context) {
+        if (begin()) {
+            if (m_imageTexture) {
+                glDeleteTextures(1, &m_imageTexture);
+            }
+            if (m_lutTexture) {
+                glDeleteTextures(1, &m_lutTexture);
+            }
+            if (m_program && gl.deleteProgram) {
+                gl.deleteProgram(m_program);
+            }
+            end();
+        }
+        wglDeleteContext(static_cast<HGLRC>(m_context));
+    }
+    if (m_dc) {
+        ReleaseDC(static_cast<HWND>(m_window), static_cast<HDC>(m_dc));
+    }
+    m_window = nullptr;
+    m_dc = nullptr;
+    m_context = nullptr;
+    m_program = 0;
+    m_imageTexture = 0;
+    m_lutTexture = 0;
+    m_texWidth = 0;
+    m_texHeight = 0;
+    m_texBytes = 0;
+}
+
+bool GlDisplay::begin() {
+    return m_context &&
+           wglMakeCurrent(static_cast<HDC>(m_dc), static_cast<HGLRC>(m_context)) != FALSE;
+}
+
+void GlDisplay::end() {
+    wglMakeCurrent(nullptr, nullptr);
+}
+
+bool GlDisplay::loadFunctions() {
+    return resolve(gl.createShader, "glCreateShader") &&
+           resolve(gl.shaderSource, "glShaderSource") &&
+           resolve(gl.compileShader, "glCompileShader") &&
+           resolve(gl.getShaderiv, "glGetShaderiv") &&
+           resolve(gl.deleteShader, "glDeleteShader") &&
+           resolve(gl.createProgram, "glCreateProgram") &&
+           resolve(gl.attachShader, "glAttachShader") &&
+           resolve(gl.linkProgram, "glLinkProgram") &&
+           resolve(gl.getProgramiv, "glGetProgramiv") &&
+           resolve(gl.useProgram, "glUseProgram") &&
+           resolve(gl.deleteProgram, "glDeleteProgram") &&
+           resolve(gl.getUniformLocation, "glGetUniformLocation") &&
+           resolve(gl.uniform1i, "glUniform1i") &&
+           resolve(gl.uniform1f, "glUniform1f") &&
+           resolve(gl.activeTexture, "glActiveTexture");
+}
+
+bool GlDisplay::buildProgram() {
+    GLuint vertex = compileShader(HX_GL_VERTEX_SHADER, VERTEX_SHADER);
+    GLuint fragment = compileShader(HX_GL_FRAGMENT_SHADER, FRAGMENT_SHADER);
+    if (!vertex || !fragment) {
+        if (vertex) gl.deleteShader(vertex);
+        if (fragment) gl.deleteShader(fragment);
+        return false;
+    }
+
+    m_program = gl.createProgram();
+    gl.attachShader(m_program, vertex);
+    gl.attachShader(m_program, fragment);
+    gl.linkProgram(m_program);
+    gl.deleteShader(vertex);
+    gl.deleteShader(fragment);
+    GLint ok = 0;
+    gl.getProgramiv(m_program, HX_GL_LINK_STATUS, &ok);
+    if (!ok) {
+        return false;
+    }
+
+    gl.useProgram(m_program);
+    gl.uniform1i(gl.getUniformLocation(m_program, "image"), 0);
+    gl.uniform1i(gl.getUniformLocation(m_program, "lut"), 1);
+    m_lowLocation = gl.getUniformLocation(m_program, "low");
+    m_rangeLocation = gl.getUniformLocation(m_program, "range");
+    m_offsetLocation = gl.getUniformLocation(m_program, "offset");
+    return true;
+}
+
+void GlDisplay::setLut(const uint8_t* bgr) {
+    glBindTexture(GL_TEXTURE_2D, m_lutTexture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 256, 1, HX_GL_BGR, GL_UNSIGNED_BYTE, bgr);
+}
+
+bool GlDisplay::upload(const uint8_t* data, size_t stride, uint32_t width, uint32_t rows,
+                       uint32_t bytes, uint32_t texHeight, uint32_t texRow) {
+    if ((bytes != 1 && bytes != 2) || rows == 0 || texRow + rows > texHeight) {
+        return false;
+    }
+    const GLenum type = (bytes == 2) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_BYTE;
+
+    glBindTexture(GL_TEXTURE_2D, m_imageTexture);
+    if (width != m_texWidth || texHeight != m_texHeight || bytes != m_texBytes) {
+        // Raw values, sampled exactly; T repeats for the waterfall ring
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, HX_GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexImage2D(GL_TEXTURE_2D, 0, (bytes == 2) ? GL_LUMINANCE16 : GL_LUMINANCE8,
+                     width, texHeight, 0, GL_LUMINANCE, type, nullptr);
+        m_texWidth = width;
+        m_texHeight = texHeight;
+        m_texBytes = bytes;
+    }
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, static_cast<GLint>(stride / bytes));
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, texRow, width, rows, GL_LUMINANCE, type, data);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    return glGetError() == GL_NO_ERROR;
+}
+
+void GlDisplay::draw(float low, float range, uint32_t topRow) {
+    RECT client;
+    if (!GetClientRect(static_cast<HWND>(m_window), &client) || m_texWidth == 0 ||
+        client.right <= 0 || client.bottom <= 0) {
+        return;
+    }
+
+    glViewport(0, 0, client.right, client.bottom);
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    // Fit the frame into the client area, keeping its aspect ratio
+    const float sx = static_cast<float>(client.right) / m_texWidth;
+    const float sy = static_cast<float>(client.bottom) / m_texHeight;
+    const float scale = (sx < sy) ? sx : sy;
+    const GLsizei w = static_cast<GLsizei>(m_texWidth * scale);
+    const GLsizei h = static_cast<GLsizei>(m_texHeight * scale);
+    glViewport(0, client.bottom - h, w, h);
+
+    gl.useProgram(m_program);
+    gl.uniform1f(m_lowLocation, low);
+    gl.uniform1f(m_rangeLocation, range);
+    gl.uniform1f(m_offsetLocation, static_cast<float>(topRow) / m_texHeight);
+    gl.activeTexture(HX_GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, m_lutTexture);
+    gl.activeTexture(HX_GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, m_imageTexture);
+
+    // Texture row 0 at the top of the window
+    glBegin(GL_QUADS);
+    glTexCoord2f(0.0f, 0.0f); glVertex2f(-1.0f,  1.0f);
+    glTexCoord2f(1.0f, 0.0f); glVertex2f( 1.0f,  1.0f);
+    glTexCoord2f(1.0f, 1.0f); glVertex2f( 1.0f, -1.0f);
+    glTexCoord2f(0.0f, 1.0f); glVertex2f(-1.0f, -1.0f);
+    glEnd();
+
+    SwapBuffers(static_cast<HDC>(m_dc));
+}
+
+#else // !_WIN32
+
+GlDisplay::GlDisplay()
+    : m_window(nullptr)
+    , m_dc(nullptr)
+    , m_context(nullptr)
+    , m_program(0)
+    , m_imageTexture(0)
+    , m_lutTexture(0)
+    , m_texWidth(0)
+    , m_texHeight(0)
+    , m_texBytes(0)
+    , m_lowLocation(-1)
+    , m_rangeLocation(-1)
+    , m_offsetLocation(-1)
+{
+}
+
+GlDisplay::~GlDisplay() {
+}
+
+bool GlDisplay::create(void* window) {
+    (void)window;
+    return false;
+}
+
+void GlDisplay::destroy() {
+}
+
+bool GlDisplay::begin() {
+    return false;
+}
+
+void GlDisplay::end() {
+}
+
+void GlDisplay::setLut(const uint8_t* bgr) {
+    (void)bgr;
+}
+
+bool GlDisplay::upload(const uint8_t* data, size_t stride, uint32_t width, uint32_t rows,
+                       uint32_t bytes, uint32_t texHeight, uint32_t texRow) {
+    (void)data;
+    (void)stride;
+    (void)width;
+    (void)rows;
+    (void)bytes;
+    (void)texHeight;
+    (void)texRow;
+    return false;
+}
+
+void GlDisplay::draw(float low, float range, uint32_t topRow) {
+    (void)low;
+    (void)range;
+    (void)topRow;
+}
+
+bool GlDisplay::loadFunctions() {
+    return false;
+}
+
+bool GlDisplay::buildProgram() {
+    return false;
+}
+
+#endif // _WIN32
+
+} // namespace Internal
+} // namespace HX
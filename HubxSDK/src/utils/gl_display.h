@@ -0,0 +1,111 @@
+// ============================================================================
+// gl_display.h
+// ============================================================================
+
+/**
+ * @file gl_display.h
+ * @brief OpenGL presentation of raw frames for XShow
+ * @version 2.1.0
+ *
+ * This header is INTERNAL to hubx.dll. Raw 8 or 16-bit rows are uploaded
+ * as a luminance texture; a fragment shader applies the window, looks the
+ * level up in a 256-entry color table (gamma and color map) and scales
+ * the frame to the window. The context is made current for each call, so
+ * frames may be presented from any one thread at a time.
+ *
+ * Only implemented on Windows (WGL, OpenGL 2.0); elsewhere create() fails
+ * and XShow keeps its software path.
+ */
+
+#ifndef GL_DISPLAY_H
+#define GL_DISPLAY_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace HX {
+namespace Internal {
+
+class GlDisplay {
+public:
+    GlDisplay();
+    ~GlDisplay();
+
+    /**
+     * @brief Create a context on a window and compile the shader
+     * @param window Window handle (HWND)
+     * @return false if OpenGL 2.0 is not available
+     */
+    bool create(void* window);
+
+    /**
+     * @brief Release the context, textures and program
+     */
+    void destroy();
+
+    bool isValid() const { return m_context != nullptr; }
+
+    /**
+     * @brief Make the context current on the calling thread
+     */
+    bool begin();
+
+    /**
+     * @brief Release the context from the calling thread
+     */
+    void end();
+
+    /**
+     * @brief Replace the color table
+     * @param bgr 256 entries of blue, green, red
+     */
+    void setLut(const uint8_t* bgr);
+
+    /**
+     * @brief Upload rows into the frame texture
+     * @param data First row
+     * @param stride Bytes between rows
+     * @param width Pixels per row
+     * @param rows Rows to upload
+     * @param bytes Pixel container size (1 or 2)
+     * @param texHeight Texture rows; the texture is reallocated on change
+     * @param texRow First texture row written (must leave room for rows)
+     * @return false for other container sizes
+     */
+    bool upload(const uint8_t* data, size_t stride, uint32_t width, uint32_t rows,
+                uint32_t bytes, uint32_t texHeight, uint32_t texRow);
+
+    /**
+     * @brief Draw the texture fitted to the window and present it
+     * @param low Window start as a fraction of the container range
+     * @param range Window width as a fraction of the container range
+     * @param topRow Texture row shown at the top (waterfall ring head)
+     */
+    void draw(float low, float range, uint32_t topRow);
+
+private:
+    bool loadFunctions();
+    bool buildProgram();
+
+    void* m_window;
+    void* m_dc;
+    void* m_context;
+    uint32_t m_program;
+    uint32_t m_imageTexture;
+    uint32_t m_lutTexture;
+    uint32_t m_texWidth;
+    uint32_t m_texHeight;
+    uint32_t m_texBytes;
+    int m_lowLocation;
+    int m_rangeLocation;
+    int m_offsetLocation;
+
+    // Non-copyable
+    GlDisplay(const GlDisplay&) = delete;
+    GlDisplay& operator=(const GlDisplay&) = delete;
+};
+
+} // namespace Internal
+} // namespace HX
+
+#endif // GL_DISPLAY_H
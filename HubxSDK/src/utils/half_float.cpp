@@ -0,0 +1,94 @@
+// ============================================================================
+// half_float.cpp
+// ============================================================================
+
+/**
+ * @file half_float.cpp
+ * @brief Pixel rows to normalized float16 / float32 (scalar, AVX2 + F16C)
+ * @version 2.1.0
+ */
+
+#include "half_float.h"
+#include "cpu_features.h"
+#include "XPixel.h"
+
+namespace HX {
+namespace Internal {
+
+namespace {
+
+// F16C shipped with every AVX2 CPU, so the AVX2 bit selects both
+const KernelFamily g_halfKernels("half_normalize", XFactory::CPU_AVX2);
+
+template <uint32_t Bytes>
+void HalfRowScalar(const uint8_t* src, uint16_t* dst, uint32_t count, float offset, float scale) {
+    for (uint32_t i = 0; i < count; ++i) {
+        const float value = static_cast<float>(XPixelAccess<Bytes>::Load(src + i * Bytes));
+        dst[i] = FloatToHalf((value - offset) * scale);
+    }
+}
+
+template <uint32_t Bytes>
+void FloatRow(const uint8_t* src, float* dst, uint32_t count, float offset, float scale) {
+    for (uint32_t i = 0; i < count; ++i) {
+        const float value = static_cast<float>(XPixelAccess<Bytes>::Load(src + i * Bytes));
+        dst[i] = (value - offset) * scale;
+    }
+}
+
+#if defined(HX_ARCH_X86)
+
+HX_TARGET("avx2,f16c")
+void HalfRow16AVX2(const uint8_t* src, uint16_t* dst, uint32_t count, float offset, float scale) {
+    const __m256 vOffset = _mm256_set1_ps(offset);
+    const __m256 vScale = _mm256_set1_ps(scale);
+    uint32_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        const __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i * 2));
+        const __m256 lo = _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(_mm256_castsi256_si128(d)));
+        const __m256 hi = _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(_mm256_extracti128_si256(d, 1)));
+        // Subtract, then multiply: an FMA would round once and differ from the scalar kernel
+        const __m128i hLo = _mm256_cvtps_ph(_mm256_mul_ps(_mm256_sub_ps(lo, vOffset), vScale),
+                                            _MM_FROUND_TO_NEAREST_INT);
+        const __m128i hHi = _mm256_cvtps_ph(_mm256_mul_ps(_mm256_sub_ps(hi, vOffset), vScale),
+                                            _MM_FROUND_TO_NEAREST_INT);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), hLo);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i + 8), hHi);
+    }
+    HalfRowScalar<2>(src + i * 2, dst + i, count - i, offset, scale);
+}
+
+HX_TARGET("avx2,f16c")
+void HalfRow8AVX2(const uint8_t* src, uint16_t* dst, uint32_t count, float offset, float scale) {
+    const __m256 vOffset = _mm256_set1_ps(offset);
+    const __m256 vScale = _mm256_set1_ps(scale);
+    uint32_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m128i d = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + i));
+        const __m256 value = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(d));
+        const __m128i half = _mm256_cvtps_ph(_mm256_mul_ps(_mm256_sub_ps(value, vOffset), vScale),
+                                             _MM_FROUND_TO_NEAREST_INT);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), half);
+    }
+    HalfRowScalar<1>(src + i, dst + i, count - i, offset, scale);
+}
+
+#endif // HX_ARCH_X86
+
+} // anonymous namespace
+
+HalfRowKernel selectHalfKernel(uint32_t bytesPerPixel) {
+    switch (g_halfKernels.isa()) {
+#if defined(HX_ARCH_X86)
+    case XFactory::CPU_AVX2: return (bytesPerPixel == 1) ? &HalfRow8AVX2 : &HalfRow16AVX2;
+#endif
+    default: return (bytesPerPixel == 1) ? &HalfRowScalar<1> : &HalfRowScalar<2>;
+    }
+}
+
+FloatRowKernel selectFloatKernel(uint32_t bytesPerPixel) {
+    return (bytesPerPixel == 1) ? &FloatRow<1> : &FloatRow<2>;
+}
+
+} // namespace Internal
+} // namespace HX
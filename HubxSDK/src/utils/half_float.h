@@ -0,0 +1,79 @@
+// ============================================================================
+// half_float.h
+// ============================================================================
+
+/**
+ * @file half_float.h
+ * @brief Pixel rows to normalized float16 / float32 (scalar, AVX2 + F16C)
+ * @version 2.1.0
+ *
+ * This header is INTERNAL to hubx.dll. A value v becomes
+ * (v - offset) * scale, rounded to the nearest IEEE binary16 (ties to
+ * even, overflow to infinity), the rounding _mm256_cvtps_ph applies, so
+ * every kernel gives the same bits for finite values.
+ */
+
+#ifndef HALF_FLOAT_H
+#define HALF_FLOAT_H
+
+#include <cstdint>
+#include <cstring>
+
+namespace HX {
+namespace Internal {
+
+/**
+ * @brief binary16 bits of a float, round to nearest even
+ */
+inline uint16_t FloatToHalf(float value) {
+    const uint32_t infinity = 255u << 23;
+    const uint32_t halfOverflow = (127u + 16) << 23;
+    const uint32_t denormMagic = ((127u - 15) + (23 - 10) + 1) << 23;
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    const uint32_t sign = bits & 0x80000000u;
+    bits ^= sign;
+
+    uint32_t half;
+    if (bits >= halfOverflow) {
+        // NaN stays a (quiet) NaN; the rest saturates to infinity
+        half = (bits > infinity) ? 0x7E00u : 0x7C00u;
+    } else if (bits < (113u << 23)) {
+        // Subnormal result: the float add rounds it into the low bits
+        float magnitude;
+        float magic;
+        memcpy(&magnitude, &bits, sizeof(magnitude));
+        memcpy(&magic, &denormMagic, sizeof(magic));
+        magnitude += magic;
+        uint32_t rounded;
+        memcpy(&rounded, &magnitude, sizeof(rounded));
+        half = rounded - denormMagic;
+    } else {
+        const uint32_t odd = (bits >> 13) & 1;
+        bits += (static_cast<uint32_t>(15 - 127) << 23) + 0xFFFu;
+        bits += odd;
+        half = bits >> 13;
+    }
+    return static_cast<uint16_t>(half | (sign >> 16));
+}
+
+/**
+ * @brief Normalizes one row of 1 or 2-byte pixels
+ * @param src count pixels, little-endian
+ * @param dst count binary16 values (HalfRowKernel) or floats (FloatRowKernel)
+ */
+typedef void (*HalfRowKernel)(const uint8_t* src, uint16_t* dst, uint32_t count,
+                              float offset, float scale);
+typedef void (*FloatRowKernel)(const uint8_t* src, float* dst, uint32_t count,
+                               float offset, float scale);
+
+/// Fastest float16 kernel for this CPU and pixel width (1 or 2 bytes)
+HalfRowKernel selectHalfKernel(uint32_t bytesPerPixel);
+
+/// float32 kernel for a pixel width (1 or 2 bytes)
+FloatRowKernel selectFloatKernel(uint32_t bytesPerPixel);
+
+} // namespace Internal
+} // namespace HX
+
+#endif // HALF_FLOAT_H
@@ -0,0 +1,149 @@
+// ============================================================================
+// host_profile.cpp
+// ============================================================================
+
+/**
+ * @file host_profile.cpp
+ * @brief Host profile storage and file format
+ * @version 2.1.0
+ */
+
+#include "host_profile.h"
+#include <cstdlib>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+
+namespace HX {
+namespace Internal {
+
+const char* const HOST_PROFILE_ENV = "HUBX_PROFILE";
+const char* const HOST_PROFILE_FILE = "hubx_profile.conf";
+
+namespace {
+
+std::mutex g_profileMutex;
+XFactory::HostProfile g_profile;
+
+bool parseValue(const std::string& text, uint64_t maxValue, uint32_t& value) {
+    char* end = nullptr;
+    // Base 0 takes the hexadecimal feature masks as written
+    const unsigned long long v = std::strtoull(text.c_str(), &end, 0);
+    if (text.empty() || text[0] == '-' || !end || *end != '\0' || v > maxValue) {
+        return false;
+    }
+    value = static_cast<uint32_t>(v);
+    return true;
+}
+
+} // namespace
+
+bool HostProfileValid(const XFactory::HostProfile& profile, std::string& error) {
+    if (profile.ringDepth == 1 || profile.ringDepth > (1u << 20)) {
+        error = "ring_depth must be 0 or 2..1048576";
+    } else if (profile.batchSize > 1024) {
+        error = "batch_size must be 0..1024";
+    } else if (profile.poolSize == 1 || profile.poolSize > 1024) {
+        error = "pool_size must be 0 or 2..1024";
+    } else if (profile.correctionThreads > 1024) {
+        error = "correction_threads must be 0..1024";
+    } else if (profile.bandPixels > 0 && profile.bandPixels < 64 * 1024) {
+        error = "band_pixels must be 0 or at least 65536";
+    } else if (profile.cpuFeatureMask & ~static_cast<uint32_t>(XFactory::CPU_ALL)) {
+        error = "cpu_features has unknown bits";
+    } else if (!(profile.lineRate >= 0.0)) {
+        error = "line_rate must not be negative";
+    } else {
+        return true;
+    }
+    return false;
+}
+
+void HostProfileSet(const XFactory::HostProfile& profile) {
+    std::lock_guard<std::mutex> lock(g_profileMutex);
+    g_profile = profile;
+}
+
+XFactory::HostProfile HostProfileGet() {
+    std::lock_guard<std::mutex> lock(g_profileMutex);
+    return g_profile;
+}
+
+bool HostProfileRead(const std::string& file, XFactory::HostProfile& profile, std::string& error) {
+    std::ifstream in(file.c_str());
+    if (!in) {
+        error = "cannot open " + file;
+        return false;
+    }
+    
+    profile = XFactory::HostProfile();
+    std::string line;
+    uint32_t number = 0;
+    while (std::getline(in, line)) {
+        ++number;
+        const size_t hash = line.find('#');
+        if (hash != std::string::npos) {
+            line.erase(hash);
+        }
+        std::istringstream fields(line);
+        std::string key;
+        std::string value;
+        if (!(fields >> key)) {
+            continue;
+        }
+        std::string extra;
+        bool ok = static_cast<bool>(fields >> value) && !(fields >> extra);
+        if (ok) {
+            if (key == "ring_depth") {
+                ok = parseValue(value, 1u << 20, profile.ringDepth);
+            } else if (key == "batch_size") {
+                ok = parseValue(value, 1024, profile.batchSize);
+            } else if (key == "pool_size") {
+                ok = parseValue(value, 1024, profile.poolSize);
+            } else if (key == "correction_threads") {
+                ok = parseValue(value, 1024, profile.correctionThreads);
+            } else if (key == "band_pixels") {
+                ok = parseValue(value, 0xFFFFFFFFu, profile.bandPixels);
+            } else if (key == "cpu_features") {
+                ok = parseValue(value, XFactory::CPU_ALL, profile.cpuFeatureMask);
+            } else if (key == "line_rate") {
+                char* end = nullptr;
+                profile.lineRate = std::strtod(value.c_str(), &end);
+                ok = end && *end == '\0';
+            } else {
+                std::ostringstream out;
+                out << file << ":" << number << ": unknown key " << key;
+                error = out.str();
+                return false;
+            }
+        }
+        if (!ok) {
+            std::ostringstream out;
+            out << file << ":" << number << ": bad value for " << key;
+            error = out.str();
+            return false;
+        }
+    }
+    return HostProfileValid(profile, error);
+}
+
+bool HostProfileWrite(const std::string& file, const XFactory::HostProfile& profile) {
+    std::ofstream out(file.c_str());
+    if (!out) {
+        return false;
+    }
+    out << "# HubxSDK host profile, loaded by XFactory::Initialize()\n"
+        << "# 0 keeps the built-in default\n"
+        << "ring_depth " << profile.ringDepth << "\n"
+        << "batch_size " << profile.batchSize << "\n"
+        << "pool_size " << profile.poolSize << "\n"
+        << "correction_threads " << profile.correctionThreads << "\n"
+        << "band_pixels " << profile.bandPixels << "\n"
+        << "cpu_features 0x" << std::hex << profile.cpuFeatureMask << std::dec << "\n"
+        << "line_rate " << static_cast<uint64_t>(profile.lineRate) << "\n";
+    out.flush();
+    return static_cast<bool>(out);
+}
+
+} // namespace Internal
+} // namespace HX
@@ -0,0 +1,60 @@
+// ============================================================================
+// host_profile.h
+// ============================================================================
+
+/**
+ * @file host_profile.h
+ * @brief Host-tuned pipeline defaults behind XFactory::SetHostProfile()
+ * @version 2.1.0
+ *
+ * This header is INTERNAL to hubx.dll. The profile is one process-wide
+ * value; XGrabber and XFrame read it when they are created or started, so
+ * a profile loaded by XFactory::Initialize() applies to every pipeline
+ * built afterwards. Files are "key value" lines, '#' starts a comment:
+ *
+ *   ring_depth 16384
+ *   batch_size 64
+ *   cpu_features 0x3
+ */
+
+#ifndef HOST_PROFILE_H
+#define HOST_PROFILE_H
+
+#include "xfactory.h"
+#include <string>
+
+namespace HX {
+namespace Internal {
+
+/// Environment variable naming the profile Initialize() loads
+extern const char* const HOST_PROFILE_ENV;
+
+/// File Initialize() loads from the working directory without it
+extern const char* const HOST_PROFILE_FILE;
+
+/**
+ * @brief Check every field of a profile
+ * @param error Receives the first invalid field
+ */
+bool HostProfileValid(const XFactory::HostProfile& profile, std::string& error);
+
+/// Store the profile objects read their defaults from
+void HostProfileSet(const XFactory::HostProfile& profile);
+
+/// Profile last stored
+XFactory::HostProfile HostProfileGet();
+
+/**
+ * @brief Parse a profile file
+ * @param error Receives what was wrong with the file
+ * @return false if it cannot be read, has an unknown key or a bad value
+ */
+bool HostProfileRead(const std::string& file, XFactory::HostProfile& profile, std::string& error);
+
+/// Write a profile file
+bool HostProfileWrite(const std::string& file, const XFactory::HostProfile& profile);
+
+} // namespace Internal
+} // namespace HX
+
+#endif // HOST_PROFILE_H
@@ -0,0 +1,338 @@
+// ============================================================================
+// io_ring.cpp
+// ============================================================================
+
+/**
+ * @file io_ring.cpp
+ * @brief io_uring set up and driven through the raw system calls
+ * @version 2.1.0
+ */
+
+#include "io_ring.h"
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#endif
+#endif
+
+// Multishot receive arrived with Linux 6.0, sparse buffer tables with 5.19
+#if defined(IORING_RECV_MULTISHOT) && defined(IORING_RSRC_REGISTER_SPARSE)
+#define HX_HAVE_IO_URING 1
+#endif
+
+#ifdef HX_HAVE_IO_URING
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+namespace HX {
+namespace Internal {
+
+#ifdef HX_HAVE_IO_URING
+
+struct IoRing::Sqe : io_uring_sqe {};
+
+namespace {
+
+int ringSetup(uint32_t entries, io_uring_params* params) {
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+int ringEnter(int fd, uint32_t submit, uint32_t wait, uint32_t flags, void* arg, size_t argSize) {
+    return static_cast<int>(syscall(__NR_io_uring_enter, fd, submit, wait, flags, arg, argSize));
+}
+
+int ringRegister(int fd, uint32_t opcode, const void* arg, uint32_t count) {
+    return static_cast<int>(syscall(__NR_io_uring_register, fd, opcode, arg, count));
+}
+
+void* mapRing(int fd, size_t size, uint64_t offset) {
+    void* ring = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd,
+                      static_cast<off_t>(offset));
+    return ring == MAP_FAILED ? nullptr : ring;
+}
+
+inline uint32_t loadAcquire(const uint32_t* p) {
+    return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+inline void storeRelease(uint32_t* p, uint32_t value) {
+    __atomic_store_n(p, value, __ATOMIC_RELEASE);
+}
+
+} // namespace
+
+IoRing::IoRing()
+    : m_fd(-1), m_wakeFd(-1),
+      m_sqRing(nullptr), m_sqRingSize(0), m_cqRing(nullptr), m_cqRingSize(0),
+      m_sqes(nullptr), m_sqesSize(0),
+      m_sqHead(nullptr), m_sqTail(nullptr), m_sqArray(nullptr), m_sqMask(0), m_sqEntries(0),
+      m_sqLocalTail(0),
+      m_cqHead(nullptr), m_cqTail(nullptr), m_cqes(nullptr), m_cqMask(0)
+{
+}
+
+IoRing::~IoRing() {
+    close();
+}
+
+bool IoRing::open(uint32_t entries) {
+    close();
+
+    // A multishot receive posts many completions per submission
+    io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    params.flags = IORING_SETUP_CLAMP | IORING_SETUP_CQSIZE;
+    params.cq_entries = entries * 4;
+    m_fd = ringSetup(entries, &params);
+    if (m_fd < 0) {
+        m_fd = -1;
+        return false;
+    }
+
+    m_sqRingSize = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+    m_cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        m_sqRingSize = m_cqRingSize = (m_sqRingSize > m_cqRingSize) ? m_sqRingSize : m_cqRingSize;
+    }
+    m_sqRing = mapRing(m_fd, m_sqRingSize, IORING_OFF_SQ_RING);
+    m_cqRing = (params.features & IORING_FEAT_SINGLE_MMAP)
+        ? m_sqRing : mapRing(m_fd, m_cqRingSize, IORING_OFF_CQ_RING);
+    m_sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+    m_sqes = mapRing(m_fd, m_sqesSize, IORING_OFF_SQES);
+    m_wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (!m_sqRing || !m_cqRing || !m_sqes || m_wakeFd < 0) {
+        close();
+        return false;
+    }
+
+    uint8_t* sq = static_cast<uint8_t*>(m_sqRing);
+    m_sqHead = reinterpret_cast<uint32_t*>(sq + params.sq_off.head);
+    m_sqTail = reinterpret_cast<uint32_t*>(sq + params.sq_off.tail);
+    m_sqArray = reinterpret_cast<uint32_t*>(sq + params.sq_off.array);
+    m_sqMask = *reinterpret_cast<uint32_t*>(sq + params.sq_off.ring_mask);
+    m_sqEntries = params.sq_entries;
+    m_sqLocalTail = *m_sqTail;
+
+    uint8_t* cq = static_cast<uint8_t*>(m_cqRing);
+    m_cqHead = reinterpret_cast<uint32_t*>(cq + params.cq_off.head);
+    m_cqTail = reinterpret_cast<uint32_t*>(cq + params.cq_off.tail);
+    m_cqes = cq + params.cq_off.cqes;
+    m_cqMask = *reinterpret_cast<uint32_t*>(cq + params.cq_off.ring_mask);
+    return true;
+}
+
+void IoRing::close() {
+    // Closing the ring cancels and unregisters everything
+    if (m_fd >= 0) {
+        ::close(m_fd);
+        m_fd = -1;
+    }
+    if (m_sqes) {
+        munmap(m_sqes, m_sqesSize);
+    }
+    if (m_cqRing && m_cqRing != m_sqRing) {
+        munmap(m_cqRing, m_cqRingSize);
+    }
+    if (m_sqRing) {
+        munmap(m_sqRing, m_sqRingSize);
+    }
+    if (m_wakeFd >= 0) {
+        ::close(m_wakeFd);
+    }
+    m_sqes = m_sqRing = m_cqRing = nullptr;
+    m_wakeFd = -1;
+}
+
+bool IoRing::reserveBuffers(uint32_t count) {
+    io_uring_rsrc_register table;
+    memset(&table, 0, sizeof(table));
+    table.nr = count;
+    table.flags = IORING_RSRC_REGISTER_SPARSE;
+    return ringRegister(m_fd, IORING_REGISTER_BUFFERS2, &table, sizeof(table)) == 0;
+}
+
+bool IoRing::setBuffer(uint32_t index, const void* data, size_t size) {
+    struct iovec iov;
+    iov.iov_base = const_cast<void*>(data);
+    iov.iov_len = data ? size : 0;
+    io_uring_rsrc_update2 update;
+    memset(&update, 0, sizeof(update));
+    update.offset = index;
+    update.data = reinterpret_cast<uint64_t>(&iov);
+    update.nr = 1;
+    return ringRegister(m_fd, IORING_REGISTER_BUFFERS_UPDATE, &update, sizeof(update)) == 1;
+}
+
+IoRing::Sqe* IoRing::nextSqe() {
+    if (m_sqLocalTail - loadAcquire(m_sqHead) >= m_sqEntries) {
+        return nullptr;
+    }
+    const uint32_t index = m_sqLocalTail & m_sqMask;
+    Sqe* sqe = static_cast<Sqe*>(m_sqes) + index;
+    memset(sqe, 0, sizeof(*sqe));
+    m_sqArray[index] = index;
+    ++m_sqLocalTail;
+    return sqe;
+}
+
+uint32_t IoRing::spaceLeft() const {
+    return m_sqEntries - (m_sqLocalTail - loadAcquire(m_sqHead));
+}
+
+bool IoRing::receiveMultishot(int fd, uint64_t tag) {
+    Sqe* sqe = nextSqe();
+    if (!sqe) {
+        return false;
+    }
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = fd;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = 0;
+    sqe->user_data = tag;
+    return true;
+}
+
+bool IoRing::provideBuffers(uint8_t* base, uint16_t first, uint32_t count, uint32_t size,
+                            uint64_t tag) {
+    Sqe* sqe = nextSqe();
+    if (!sqe) {
+        return false;
+    }
+    sqe->opcode = IORING_OP_PROVIDE_BUFFERS;
+    sqe->fd = static_cast<int32_t>(count);
+    sqe->addr = reinterpret_cast<uint64_t>(base + static_cast<size_t>(first) * size);
+    sqe->len = size;
+    sqe->off = first;
+    sqe->buf_group = 0;
+    sqe->user_data = tag;
+    return true;
+}
+
+bool IoRing::write(int fd, const void* data, uint32_t length, uint64_t offset,
+                   uint64_t tag, int fixedIndex) {
+    Sqe* sqe = nextSqe();
+    if (!sqe) {
+        return false;
+    }
+    sqe->opcode = fixedIndex >= 0 ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE;
+    sqe->fd = fd;
+    sqe->addr = reinterpret_cast<uint64_t>(data);
+    sqe->len = length;
+    sqe->off = offset;
+    sqe->buf_index = static_cast<uint16_t>(fixedIndex >= 0 ? fixedIndex : 0);
+    sqe->user_data = tag;
+    return true;
+}
+
+bool IoRing::pollWake(uint64_t tag) {
+    Sqe* sqe = nextSqe();
+    if (!sqe) {
+        return false;
+    }
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = m_wakeFd;
+    sqe->poll32_events = POLLIN;
+    sqe->user_data = tag;
+    return true;
+}
+
+void IoRing::wake() {
+    const uint64_t one = 1;
+    if (m_wakeFd >= 0 && ::write(m_wakeFd, &one, sizeof(one)) < 0) {
+        // Already signalled: the counter only saturates
+    }
+}
+
+void IoRing::clearWake() {
+    uint64_t count = 0;
+    if (m_wakeFd >= 0 && ::read(m_wakeFd, &count, sizeof(count)) < 0) {
+        // Nothing pending
+    }
+}
+
+int IoRing::submit(uint32_t waitFor, uint32_t timeoutMs) {
+    storeRelease(m_sqTail, m_sqLocalTail);
+    const uint32_t pending = m_sqLocalTail - loadAcquire(m_sqHead);
+    if (pending == 0 && waitFor == 0) {
+        return 0;
+    }
+
+    int result;
+    if (waitFor > 0 && timeoutMs > 0) {
+        struct __kernel_timespec ts;
+        ts.tv_sec = timeoutMs / 1000;
+        ts.tv_nsec = static_cast<long long>(timeoutMs % 1000) * 1000000;
+        io_uring_getevents_arg arg;
+        memset(&arg, 0, sizeof(arg));
+        arg.sigmask_sz = _NSIG / 8;
+        arg.ts = reinterpret_cast<uint64_t>(&ts);
+        result = ringEnter(m_fd, pending, waitFor, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG,
+                           &arg, sizeof(arg));
+    } else {
+        result = ringEnter(m_fd, pending, waitFor, waitFor > 0 ? IORING_ENTER_GETEVENTS : 0,
+                           nullptr, _NSIG / 8);
+    }
+    return result < 0 ? -errno : result;
+}
+
+uint32_t IoRing::reap(IoCompletion* out, uint32_t max) {
+    uint32_t head = *m_cqHead;
+    const uint32_t tail = loadAcquire(m_cqTail);
+    uint32_t count = 0;
+    while (head != tail && count < max) {
+        const io_uring_cqe& cqe = static_cast<const io_uring_cqe*>(m_cqes)[head & m_cqMask];
+        out[count].tag = cqe.user_data;
+        out[count].result = cqe.res;
+        out[count].flags = cqe.flags;
+        ++count;
+        ++head;
+    }
+    storeRelease(m_cqHead, head);
+    return count;
+}
+
+#else
+
+struct IoRing::Sqe {};
+
+IoRing::IoRing()
+    : m_fd(-1), m_wakeFd(-1),
+      m_sqRing(nullptr), m_sqRingSize(0), m_cqRing(nullptr), m_cqRingSize(0),
+      m_sqes(nullptr), m_sqesSize(0),
+      m_sqHead(nullptr), m_sqTail(nullptr), m_sqArray(nullptr), m_sqMask(0), m_sqEntries(0),
+      m_sqLocalTail(0),
+      m_cqHead(nullptr), m_cqTail(nullptr), m_cqes(nullptr), m_cqMask(0)
+{
+}
+
+IoRing::~IoRing() {}
+
+bool IoRing::open(uint32_t) { return false; }
+void IoRing::close() {}
+bool IoRing::reserveBuffers(uint32_t) { return false; }
+bool IoRing::setBuffer(uint32_t, const void*, size_t) { return false; }
+bool IoRing::provideBuffers(uint8_t*, uint16_t, uint32_t, uint32_t, uint64_t) { return false; }
+IoRing::Sqe* IoRing::nextSqe() { return nullptr; }
+uint32_t IoRing::spaceLeft() const { return 0; }
+bool IoRing::receiveMultishot(int, uint64_t) { return false; }
+bool IoRing::write(int, const void*, uint32_t, uint64_t, uint64_t, int) { return false; }
+bool IoRing::pollWake(uint64_t) { return false; }
+void IoRing::wake() {}
+void IoRing::clearWake() {}
+int IoRing::submit(uint32_t, uint32_t) { return -1; }
+uint32_t IoRing::reap(IoCompletion*, uint32_t) { return 0; }
+
+#endif // HX_HAVE_IO_URING
+
+} // namespace Internal
+} // namespace HX
@@ -0,0 +1,173 @@
+// ============================================================================
+// io_ring.h
+// ============================================================================
+
+/**
+ * @file io_ring.h
+ * @brief Minimal io_uring submission/completion ring
+ * @version 2.1.0
+ *
+ * This header is INTERNAL to hubx.dll. hubx does not depend on liburing:
+ * the ring is set up with the raw system calls and only the operations
+ * the receive and recording engines use are wrapped - multishot receive
+ * into provided buffers, writes from registered (fixed) buffers and a
+ * poll on a wake eventfd. Everywhere else (other systems, kernels before
+ * 6.0, io_uring disabled by sysctl or seccomp) open() returns false and
+ * the callers keep their blocking paths.
+ *
+ * One thread submits and reaps; only wake() may be called from others.
+ */
+
+#ifndef IO_RING_H
+#define IO_RING_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace HX {
+namespace Internal {
+
+/**
+ * @brief One completion
+ */
+struct IoCompletion {
+    uint64_t tag;           ///< Tag given at submission
+    int32_t result;         ///< Bytes transferred, or -errno
+    uint32_t flags;
+
+    /// The operation stays armed and will complete again (multishot)
+    bool more() const { return (flags & 0x2) != 0; }
+
+    /// Provided buffer the data landed in, -1 if none
+    int buffer() const { return (flags & 0x1) ? static_cast<int>(flags >> 16) : -1; }
+};
+
+/**
+ * @class IoRing
+ * @brief io_uring instance with fixed buffers and one provided-buffer group
+ */
+class IoRing {
+public:
+    IoRing();
+    ~IoRing();
+
+    /**
+     * @brief Set up the ring
+     * @param entries Submission queue entries (rounded up to a power of two)
+     * @return false if io_uring is unavailable
+     */
+    bool open(uint32_t entries);
+
+    /**
+     * @brief Tear down the ring, cancelling everything in flight
+     */
+    void close();
+
+    bool isOpen() const { return m_fd >= 0; }
+
+    /**
+     * @brief Reserve a table of fixed buffers, all empty
+     * @param count Table size
+     */
+    bool reserveBuffers(uint32_t count);
+
+    /**
+     * @brief Point fixed buffer index at memory (nullptr to empty it)
+     *
+     * @note The kernel pins the pages until the index is replaced or the
+     *       ring is closed
+     */
+    bool setBuffer(uint32_t index, const void* data, size_t size);
+
+    /**
+     * @brief Queue handing buffers first..first + count - 1 to group 0
+     * @param base Buffer 0; buffer b is base + b * size
+     *
+     * The kernel fills provided buffers in the order they were given, so
+     * buffers returned in the order they completed are reused in turn.
+     */
+    bool provideBuffers(uint8_t* base, uint16_t first, uint32_t count, uint32_t size,
+                        uint64_t tag);
+
+    /**
+     * @brief Arm a multishot receive on fd into buffer group 0
+     */
+    bool receiveMultishot(int fd, uint64_t tag);
+
+    /**
+     * @brief Queue a write at offset
+     * @param fixedIndex Fixed buffer holding data, or -1 for plain memory
+     */
+    bool write(int fd, const void* data, uint32_t length, uint64_t offset,
+               uint64_t tag, int fixedIndex = -1);
+
+    /**
+     * @brief Arm a one-shot poll on the wake eventfd
+     */
+    bool pollWake(uint64_t tag);
+
+    /**
+     * @brief Complete the pollWake() operation from any thread
+     */
+    void wake();
+
+    /**
+     * @brief Clear a wake once its completion has been reaped
+     */
+    void clearWake();
+
+    /**
+     * @brief Hand queued submissions to the kernel and optionally wait
+     * @param waitFor Completions to wait for (0 = do not block)
+     * @param timeoutMs Longest wait when waitFor > 0 (0 = none)
+     * @return Submissions consumed, or -errno (-ETIME on timeout)
+     */
+    int submit(uint32_t waitFor, uint32_t timeoutMs);
+
+    /**
+     * @brief Take completions off the completion queue
+     * @return Completions copied to out
+     */
+    uint32_t reap(IoCompletion* out, uint32_t max);
+
+    /**
+     * @brief Submission entries free right now
+     */
+    uint32_t spaceLeft() const;
+
+private:
+    struct Sqe;
+    Sqe* nextSqe();
+
+    int m_fd;
+    int m_wakeFd;
+
+    // Mapped rings
+    void* m_sqRing;
+    size_t m_sqRingSize;
+    void* m_cqRing;
+    size_t m_cqRingSize;
+    void* m_sqes;
+    size_t m_sqesSize;
+
+    uint32_t* m_sqHead;
+    uint32_t* m_sqTail;
+    uint32_t* m_sqArray;
+    uint32_t m_sqMask;
+    uint32_t m_sqEntries;
+    uint32_t m_sqLocalTail;     ///< Entries prepared, not yet published
+
+    uint32_t* m_cqHead;
+    uint32_t* m_cqTail;
+    void* m_cqes;
+    uint32_t m_cqMask;
+
+    // Non-copyable
+    IoRing(const IoRing&) = delete;
+    IoRing& operator=(const IoRing&) = delete;
+};
+
+} // namespace Internal
+} // namespace HX
+
+#endif // IO_RING_H
@@ -0,0 +1,345 @@
+// ============================================================================
+// latency_trace.cpp
+// ============================================================================
+
+/**
+ * @file latency_trace.cpp
+ * @brief Latency histograms and trace event capture
+ * @version 2.1.0
+ */
+
+#include "latency_trace.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace HX {
+namespace Internal {
+
+std::atomic<bool> g_traceEnabled(false);
+
+namespace {
+
+const uint32_t SUB_BITS = LatencyHistogram::SUB_BITS;
+const uint32_t SUB_BUCKETS = 1u << SUB_BITS;
+const uint32_t BUCKETS = LatencyHistogram::BUCKETS;
+
+LatencyHistogram g_stages[XFactory::TRACE_STAGE_COUNT];
+
+/**
+ * @brief One captured interval
+ *
+ * seq is the event index + 1 once written and 0 while a writer fills the
+ * fields, so a reader can tell a complete event from a torn one.
+ */
+struct TraceEvent {
+    std::atomic<uint64_t> seq;
+    std::atomic<uint64_t> startNs;
+    std::atomic<uint64_t> durationNs;
+    std::atomic<uint32_t> thread;
+    std::atomic<uint32_t> stage;
+};
+
+struct Capture {
+    std::unique_ptr<TraceEvent[]> events;
+    uint32_t capacity;
+};
+
+std::mutex g_captureMutex;
+std::atomic<Capture*> g_capture(nullptr);      ///< Being written, null when stopped
+std::atomic<uint64_t> g_captureHead(0);
+Capture* g_lastCapture = nullptr;              ///< Kept for WriteTraceCapture()
+// Writers may still hold a replaced buffer, so buffers live until exit
+std::vector<std::unique_ptr<Capture> > g_captures;
+
+std::mutex g_threadMutex;
+std::map<uint32_t, std::string> g_threadNames;
+std::atomic<uint32_t> g_nextThread(1);
+
+thread_local uint32_t t_thread = 0;
+thread_local TraceLineStamp t_line = {0, 0};
+
+const char* stageName(uint32_t stage) {
+    switch (stage) {
+        case XFactory::TRACE_RING:             return "ring";
+        case XFactory::TRACE_LINE:             return "line";
+        case XFactory::TRACE_ASSEMBLY:         return "assembly";
+        case XFactory::TRACE_END_TO_END:       return "end_to_end";
+        case XFactory::TRACE_SINK:             return "OnFrameReady";
+        case XFactory::TRACE_CORRECT_OG:       return "xog_apply";
+        case XFactory::TRACE_CORRECT_MOG:      return "xmog_apply";
+        case XFactory::TRACE_CORRECT_PIPELINE: return "pipeline_run";
+        default:                               return "unknown";
+    }
+}
+
+inline uint32_t highestBit(uint64_t v) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanReverse64(&index, v);
+    return static_cast<uint32_t>(index);
+#else
+    return 63u - static_cast<uint32_t>(__builtin_clzll(v));
+#endif
+}
+
+inline uint32_t bucketFor(uint64_t ns) {
+    if (ns < SUB_BUCKETS) {
+        return static_cast<uint32_t>(ns);
+    }
+    const uint32_t e = highestBit(ns);
+    return (e - SUB_BITS + 1) * SUB_BUCKETS +
+           static_cast<uint32_t>((ns >> (e - SUB_BITS)) & (SUB_BUCKETS - 1));
+}
+
+/// Middle of the values a bucket holds
+uint64_t bucketValue(uint32_t bucket) {
+    if (bucket < SUB_BUCKETS) {
+        return bucket;
+    }
+    const uint32_t e = bucket / SUB_BUCKETS + SUB_BITS - 1;
+    const uint64_t low = (static_cast<uint64_t>(SUB_BUCKETS + bucket % SUB_BUCKETS)) << (e - SUB_BITS);
+    return low + ((uint64_t(1) << (e - SUB_BITS)) >> 1);
+}
+
+uint32_t currentThread() {
+    if (t_thread == 0) {
+        t_thread = g_nextThread.fetch_add(1, std::memory_order_relaxed);
+    }
+    return t_thread;
+}
+
+void capture(uint32_t stage, uint64_t startNs, uint64_t durationNs) {
+    Capture* c = g_capture.load(std::memory_order_acquire);
+    if (!c) {
+        return;
+    }
+    const uint64_t index = g_captureHead.fetch_add(1, std::memory_order_relaxed);
+    TraceEvent& e = c->events[index % c->capacity];
+    e.seq.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    e.startNs.store(startNs, std::memory_order_relaxed);
+    e.durationNs.store(durationNs, std::memory_order_relaxed);
+    e.thread.store(currentThread(), std::memory_order_relaxed);
+    e.stage.store(stage, std::memory_order_relaxed);
+    e.seq.store(index + 1, std::memory_order_release);
+}
+
+/// Value below which a fraction q of the samples fall
+uint64_t percentile(const std::vector<uint64_t>& counts, uint64_t total, double q, uint64_t maxNs) {
+    uint64_t rank = static_cast<uint64_t>(q * static_cast<double>(total) + 0.999999);
+    if (rank == 0) {
+        rank = 1;
+    }
+    uint64_t seen = 0;
+    for (uint32_t b = 0; b < BUCKETS; ++b) {
+        seen += counts[b];
+        if (seen >= rank) {
+            return std::min(bucketValue(b), maxNs);
+        }
+    }
+    return maxNs;
+}
+
+} // namespace
+
+uint64_t TraceNow() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void TraceRecord(XFactory::TraceStage stage, uint64_t startNs, uint64_t endNs) {
+    if (stage < 0 || stage >= XFactory::TRACE_STAGE_COUNT) {
+        return;
+    }
+    const uint64_t ns = endNs > startNs ? endNs - startNs : 0;
+    g_stages[stage].add(ns);
+    capture(static_cast<uint32_t>(stage), startNs, ns);
+}
+
+void LatencyHistogram::add(uint64_t ns) {
+    m_buckets[bucketFor(ns)].fetch_add(1, std::memory_order_relaxed);
+    m_totalNs.fetch_add(ns, std::memory_order_relaxed);
+    uint64_t previous = m_maxNs.load(std::memory_order_relaxed);
+    while (ns > previous &&
+           !m_maxNs.compare_exchange_weak(previous, ns, std::memory_order_relaxed)) {
+    }
+}
+
+void LatencyHistogram::get(XFactory::TraceStats& stats) const {
+    // Snapshot first so count and percentiles agree while samples arrive
+    std::vector<uint64_t> counts(BUCKETS);
+    uint64_t total = 0;
+    for (uint32_t b = 0; b < BUCKETS; ++b) {
+        counts[b] = m_buckets[b].load(std::memory_order_relaxed);
+        total += counts[b];
+    }
+
+    stats = XFactory::TraceStats();
+    stats.count = total;
+    if (total == 0) {
+        return;
+    }
+    stats.maxNs = m_maxNs.load(std::memory_order_relaxed);
+    stats.meanNs = m_totalNs.load(std::memory_order_relaxed) / total;
+    stats.p50Ns = percentile(counts, total, 0.50, stats.maxNs);
+    stats.p99Ns = percentile(counts, total, 0.99, stats.maxNs);
+    stats.p999Ns = percentile(counts, total, 0.999, stats.maxNs);
+}
+
+void LatencyHistogram::reset() {
+    for (uint32_t b = 0; b < BUCKETS; ++b) {
+        m_buckets[b].store(0, std::memory_order_relaxed);
+    }
+    m_totalNs.store(0, std::memory_order_relaxed);
+    m_maxNs.store(0, std::memory_order_relaxed);
+}
+
+void TraceSetLine(uint64_t receivedNs, uint64_t dequeuedNs) {
+    t_line.receivedNs = receivedNs;
+    t_line.dequeuedNs = dequeuedNs;
+}
+
+const TraceLineStamp& TraceLine() {
+    return t_line;
+}
+
+void TraceThreadName(const char* name) {
+    const uint32_t thread = currentThread();
+    std::lock_guard<std::mutex> lock(g_threadMutex);
+    g_threadNames[thread] = name;
+}
+
+void TraceSetEnabled(bool enable) {
+    g_traceEnabled.store(enable, std::memory_order_relaxed);
+}
+
+bool TraceGetStats(XFactory::TraceStage stage, XFactory::TraceStats& stats) {
+    if (stage < 0 || stage >= XFactory::TRACE_STAGE_COUNT) {
+        return false;
+    }
+    g_stages[stage].get(stats);
+    return true;
+}
+
+void TraceResetStats() {
+    for (uint32_t s = 0; s < XFactory::TRACE_STAGE_COUNT; ++s) {
+        g_stages[s].reset();
+    }
+}
+
+bool TraceStartCapture(uint32_t events) {
+    if (events == 0) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(g_captureMutex);
+
+    Capture* c = nullptr;
+    if (g_lastCapture && g_lastCapture->capacity == events) {
+        c = g_lastCapture;
+    } else {
+        std::unique_ptr<Capture> fresh(new (std::nothrow) Capture());
+        if (!fresh) {
+            return false;
+        }
+        fresh->events.reset(new (std::nothrow) TraceEvent[events]);
+        if (!fresh->events) {
+            return false;
+        }
+        fresh->capacity = events;
+        c = fresh.get();
+        g_captures.push_back(std::move(fresh));
+    }
+
+    g_capture.store(nullptr, std::memory_order_release);
+    for (uint32_t i = 0; i < events; ++i) {
+        c->events[i].seq.store(0, std::memory_order_relaxed);
+    }
+    g_captureHead.store(0, std::memory_order_relaxed);
+    g_lastCapture = c;
+    g_capture.store(c, std::memory_order_release);
+    g_traceEnabled.store(true, std::memory_order_relaxed);
+    return true;
+}
+
+void TraceStopCapture() {
+    std::lock_guard<std::mutex> lock(g_captureMutex);
+    g_capture.store(nullptr, std::memory_order_release);
+}
+
+bool TraceWriteCapture(const std::string& file) {
+    struct Event {
+        uint64_t startNs;
+        uint64_t durationNs;
+        uint32_t thread;
+        uint32_t stage;
+
+        bool operator<(const Event& other) const { return startNs < other.startNs; }
+    };
+
+    std::vector<Event> events;
+    {
+        std::lock_guard<std::mutex> lock(g_captureMutex);
+        if (!g_lastCapture) {
+            return false;
+        }
+        const Capture& c = *g_lastCapture;
+        events.reserve(c.capacity);
+        for (uint32_t i = 0; i < c.capacity; ++i) {
+            const TraceEvent& e = c.events[i];
+            const uint64_t seq = e.seq.load(std::memory_order_acquire);
+            Event copy;
+            copy.startNs = e.startNs.load(std::memory_order_relaxed);
+            copy.durationNs = e.durationNs.load(std::memory_order_relaxed);
+            copy.thread = e.thread.load(std::memory_order_relaxed);
+            copy.stage = e.stage.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (seq != 0 && seq == e.seq.load(std::memory_order_relaxed)) {
+                events.push_back(copy);
+            }
+        }
+    }
+    if (events.empty()) {
+        return false;
+    }
+    std::sort(events.begin(), events.end());
+
+    FILE* f = fopen(file.c_str(), "w");
+    if (!f) {
+        return false;
+    }
+
+    // Chrome trace event format: complete events in microseconds
+    const uint64_t origin = events.front().startNs;
+    fprintf(f, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+    {
+        std::lock_guard<std::mutex> lock(g_threadMutex);
+        fprintf(f, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"hubx\"}}");
+        for (std::map<uint32_t, std::string>::const_iterator it = g_threadNames.begin();
+             it != g_threadNames.end(); ++it) {
+            fprintf(f, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,"
+                       "\"args\":{\"name\":\"%s\"}}", it->first, it->second.c_str());
+        }
+    }
+    for (size_t i = 0; i < events.size(); ++i) {
+        fprintf(f, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                stageName(events[i].stage), events[i].thread,
+                static_cast<double>(events[i].startNs - origin) / 1000.0,
+                static_cast<double>(events[i].durationNs) / 1000.0);
+    }
+    fprintf(f, "\n]}\n");
+
+    const bool ok = ferror(f) == 0;
+    return fclose(f) == 0 && ok;
+}
+
+} // namespace Internal
+} // namespace HX
@@ -0,0 +1,125 @@
+// ============================================================================
+// latency_trace.h
+// ============================================================================
+
+/**
+ * @file latency_trace.h
+ * @brief Per-stage latency histograms and Chrome trace capture
+ * @version 2.1.0
+ *
+ * This header is INTERNAL to hubx.dll. Trace points check TraceEnabled()
+ * and then time a stage with TraceNow(); TraceRecord() adds the interval
+ * to the lock-free histogram of the stage and, while a capture runs, to
+ * the event ring written by XFactory::WriteTraceCapture().
+ *
+ * The receive threads stamp each line with TraceSetLine() before handing
+ * it to XFrame on the same thread; XFrame reads the stamp back with
+ * TraceLine().
+ */
+
+#ifndef LATENCY_TRACE_H
+#define LATENCY_TRACE_H
+
+#include "xfactory.h"
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+namespace HX {
+namespace Internal {
+
+extern std::atomic<bool> g_traceEnabled;
+
+/// One relaxed load; everything else is skipped while tracing is off
+inline bool TraceEnabled() {
+    return g_traceEnabled.load(std::memory_order_relaxed);
+}
+
+/// Monotonic clock (ns)
+uint64_t TraceNow();
+
+/**
+ * @brief Add one interval of a stage
+ * @param stage Stage timed
+ * @param startNs TraceNow() at the start
+ * @param endNs TraceNow() at the end
+ */
+void TraceRecord(XFactory::TraceStage stage, uint64_t startNs, uint64_t endNs);
+
+/**
+ * @brief Receive stamps of the line the calling thread is about to place
+ */
+struct TraceLineStamp {
+    uint64_t receivedNs;    ///< Receive call returned
+    uint64_t dequeuedNs;    ///< Taken off the ring (receivedNs without a ring)
+};
+
+void TraceSetLine(uint64_t receivedNs, uint64_t dequeuedNs);
+
+/// Zero stamps if the calling thread is not a receive thread
+const TraceLineStamp& TraceLine();
+
+/// Name the calling thread in trace captures
+void TraceThreadName(const char* name);
+
+// XFactory entry points
+void TraceSetEnabled(bool enable);
+bool TraceGetStats(XFactory::TraceStage stage, XFactory::TraceStats& stats);
+void TraceResetStats();
+bool TraceStartCapture(uint32_t events);
+void TraceStopCapture();
+bool TraceWriteCapture(const std::string& file);
+
+/**
+ * @class LatencyHistogram
+ * @brief Lock-free log-linear histogram of intervals, as kept per stage
+ * @note add() from any thread; get() snapshots the buckets first, so
+ *       count and percentiles agree while samples arrive
+ */
+class LatencyHistogram {
+public:
+    /// Values below 16 ns exactly, then 16 buckets per power of two
+    static const uint32_t SUB_BITS = 4;
+    static const uint32_t BUCKETS = (64 - SUB_BITS + 1) << SUB_BITS;
+
+    LatencyHistogram() { reset(); }
+
+    void add(uint64_t ns);
+    void get(XFactory::TraceStats& stats) const;
+    void reset();
+
+private:
+    std::atomic<uint64_t> m_buckets[BUCKETS];
+    std::atomic<uint64_t> m_totalNs;
+    std::atomic<uint64_t> m_maxNs;
+
+    LatencyHistogram(const LatencyHistogram&) = delete;
+    LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+};
+
+/**
+ * @brief Time the enclosing scope as one stage
+ */
+class TraceScope {
+public:
+    explicit TraceScope(XFactory::TraceStage stage)
+        : m_stage(stage), m_start(TraceEnabled() ? TraceNow() : 0) {}
+
+    ~TraceScope() {
+        if (m_start) {
+            TraceRecord(m_stage, m_start, TraceNow());
+        }
+    }
+
+private:
+    XFactory::TraceStage m_stage;
+    uint64_t m_start;
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+};
+
+} // namespace Internal
+} // namespace HX
+
+#endif // LATENCY_TRACE_H
@@ -0,0 +1,174 @@
+// ============================================================================
+// line_binning.cpp
+// ============================================================================
+
+/**
+ * @file line_binning.cpp
+ * @brief Line accumulation kernels for software binning
+ * @version 2.1.0
+ *
+ * 16-bit lines take an AVX2 kernel when the CPU has it: pixels are
+ * widened to 32 bits and added eight accumulators at a time, with column
+ * pairs split out of each 32-bit word instead of shuffled.
+ */
+
+#include "line_binning.h"
+#include "cpu_features.h"
+#include <algorithm>
+#include <cstring>
+
+namespace HX {
+namespace Internal {
+
+namespace {
+
+const KernelFamily g_binningKernels("line_binning", XFactory::CPU_AVX2);
+
+template <typename In, typename Acc>
+void addScalar(Acc* acc, const In* in, uint32_t first, uint32_t outWidth, uint32_t columns) {
+    for (uint32_t x = first; x < outWidth; ++x) {
+        const In* p = in + static_cast<size_t>(x) * columns;
+        Acc sum = 0;
+        for (uint32_t c = 0; c < columns; ++c) {
+            sum += p[c];
+        }
+        acc[x] += sum;
+    }
+}
+
+template <typename Out, typename Acc>
+void reduce(const Acc* acc, Out* out, uint32_t width, uint64_t divisor, uint64_t maxValue, bool average) {
+    if (average) {
+        const uint64_t half = divisor / 2;
+        for (uint32_t x = 0; x < width; ++x) {
+            out[x] = static_cast<Out>((acc[x] + half) / divisor);
+        }
+    } else {
+        for (uint32_t x = 0; x < width; ++x) {
+            out[x] = static_cast<Out>(std::min<uint64_t>(acc[x], maxValue));
+        }
+    }
+}
+
+void add16Scalar(uint32_t* acc, const uint16_t* in, uint32_t outWidth, uint32_t columns) {
+    addScalar(acc, in, 0, outWidth, columns);
+}
+
+#if defined(HX_ARCH_X86)
+HX_TARGET("avx2")
+void add16AVX2(uint32_t* acc, const uint16_t* in, uint32_t outWidth, uint32_t columns) {
+    const __m256i low = _mm256_set1_epi32(0xFFFF);
+    uint32_t x = 0;
+    
+    if (columns == 1) {
+        for (; x + 8 <= outWidth; x += 8) {
+            __m256i v = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + x)));
+            __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(acc + x));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(acc + x), _mm256_add_epi32(a, v));
+        }
+    } else if (columns == 2) {
+        // Each 32-bit word holds one column pair: low half + high half
+        for (; x + 8 <= outWidth; x += 8) {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + 2 * x));
+            __m256i pairs = _mm256_add_epi32(_mm256_and_si256(v, low), _mm256_srli_epi32(v, 16));
+            __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(acc + x));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(acc + x), _mm256_add_epi32(a, pairs));
+        }
+    } else {
+        // Pair sums of 32 pixels, then adjacent pairs; hadd works per lane
+        for (; x + 8 <= outWidth; x += 8) {
+            __m256i v0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + 4 * x));
+            __m256i v1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + 4 * x + 16));
+            __m256i p0 = _mm256_add_epi32(_mm256_and_si256(v0, low), _mm256_srli_epi32(v0, 16));
+            __m256i p1 = _mm256_add_epi32(_mm256_and_si256(v1, low), _mm256_srli_epi32(v1, 16));
+            __m256i quads = _mm256_permute4x64_epi64(_mm256_hadd_epi32(p0, p1), 0xD8);
+            __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(acc + x));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(acc + x), _mm256_add_epi32(a, quads));
+        }
+    }
+    addScalar(acc, in, x, outWidth, columns);
+}
+#endif
+
+} // namespace
+
+LineBinner::LineBinner()
+    : m_outWidth(0)
+    , m_bytesPerPixel(2)
+    , m_columns(1)
+    , m_lines(1)
+    , m_count(0)
+    , m_average(false)
+    , m_maxValue(0xFFFF)
+    , m_add16(add16Scalar)
+{
+}
+
+bool LineBinner::configure(uint32_t width, uint32_t bytesPerPixel, uint32_t columns,
+                           uint32_t lines, bool average, uint32_t pixelDepth) {
+    if ((bytesPerPixel != 1 && bytesPerPixel != 2 && bytesPerPixel != 4) ||
+        (columns != 1 && columns != 2 && columns != 4) ||
+        lines == 0 || lines > MAX_LINES || width < columns || pixelDepth == 0 || pixelDepth > 32) {
+        return false;
+    }
+    
+    m_outWidth = width / columns;
+    m_bytesPerPixel = bytesPerPixel;
+    m_columns = columns;
+    m_lines = lines;
+    m_average = average;
+    m_maxValue = (pixelDepth >= 32) ? 0xFFFFFFFFull : ((uint64_t(1) << pixelDepth) - 1);
+    
+    m_add16 = add16Scalar;
+#if defined(HX_ARCH_X86)
+    if (g_binningKernels.isa() == XFactory::CPU_AVX2) {
+        m_add16 = add16AVX2;
+    }
+#endif
+    
+    if (bytesPerPixel == 4) {
+        m_acc.clear();
+        m_wide.assign(m_outWidth, 0);
+    } else {
+        m_wide.clear();
+        m_acc.assign(m_outWidth, 0);
+    }
+    m_count = 0;
+    return true;
+}
+
+void LineBinner::add(const uint8_t* line) {
+    if (m_bytesPerPixel == 2) {
+        m_add16(m_acc.data(), reinterpret_cast<const uint16_t*>(line), m_outWidth, m_columns);
+    } else if (m_bytesPerPixel == 1) {
+        addScalar(m_acc.data(), line, 0, m_outWidth, m_columns);
+    } else {
+        addScalar(m_wide.data(), reinterpret_cast<const uint32_t*>(line), 0, m_outWidth, m_columns);
+    }
+    m_count++;
+}
+
+void LineBinner::emit(uint8_t* out) {
+    const uint64_t divisor = static_cast<uint64_t>(std::max<uint32_t>(m_count, 1)) * m_columns;
+    if (m_bytesPerPixel == 2) {
+        reduce(m_acc.data(), reinterpret_cast<uint16_t*>(out), m_outWidth, divisor, m_maxValue, m_average);
+    } else if (m_bytesPerPixel == 1) {
+        reduce(m_acc.data(), out, m_outWidth, divisor, m_maxValue, m_average);
+    } else {
+        reduce(m_wide.data(), reinterpret_cast<uint32_t*>(out), m_outWidth, divisor, m_maxValue, m_average);
+    }
+    reset();
+}
+
+void LineBinner::reset() {
+    std::fill(m_acc.begin(), m_acc.end(), 0u);
+    std::fill(m_wide.begin(), m_wide.end(), uint64_t(0));
+    m_count = 0;
+}
+
+uint64_t LineBinner::bytes() const {
+    return m_acc.capacity() * sizeof(uint32_t) + m_wide.capacity() * sizeof(uint64_t);
+}
+
+} // namespace Internal
+} // namespace HX
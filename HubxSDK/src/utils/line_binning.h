@@ -0,0 +1,95 @@
+// ============================================================================
+// line_binning.h
+// ============================================================================
+
+/**
+ * @file line_binning.h
+ * @brief Software column binning and line summing for frame assembly
+ * @version 2.1.0
+ *
+ * This header is INTERNAL to hubx.dll. Lines are added into one row of
+ * wide integer accumulators, with adjacent columns folded as they are
+ * added, and the row is reduced to the frame depth once per line group.
+ * The accumulator stays in cache, so full-resolution lines are read once
+ * and never stored.
+ */
+
+#ifndef LINE_BINNING_H
+#define LINE_BINNING_H
+
+#include <cstdint>
+#include <vector>
+
+namespace HX {
+namespace Internal {
+
+/**
+ * @class LineBinner
+ * @brief Accumulates groups of lines into one binned row
+ */
+class LineBinner {
+public:
+    /// Lines per group; keeps 16-bit sums of 4 columns inside 32 bits
+    static const uint32_t MAX_LINES = 4096;
+    
+    LineBinner();
+    
+    /**
+     * @brief Size the accumulator for a line format
+     * @param width Pixels per input line
+     * @param bytesPerPixel 1, 2 or 4
+     * @param columns Adjacent columns folded into one (1, 2 or 4)
+     * @param lines Lines per group (1 - MAX_LINES)
+     * @param average true to divide by the pixels summed, false to
+     *                saturate the sum at the pixel depth
+     * @param pixelDepth Bits per pixel, sets the saturation limit
+     * @return false if the format is not supported
+     * 
+     * @note Columns beyond the last whole bin are dropped
+     */
+    bool configure(uint32_t width, uint32_t bytesPerPixel, uint32_t columns,
+                   uint32_t lines, bool average, uint32_t pixelDepth);
+    
+    /**
+     * @brief Add one input line to the current group
+     */
+    void add(const uint8_t* line);
+    
+    /**
+     * @brief Reduce the current group into one output row and start a new one
+     * @param out Output row, outWidth() pixels
+     * @note A short group is averaged over the lines it holds; sums stay partial
+     */
+    void emit(uint8_t* out);
+    
+    /**
+     * @brief Drop the current group
+     */
+    void reset();
+    
+    uint32_t outWidth() const { return m_outWidth; }
+    uint32_t lines() const { return m_lines; }
+    uint32_t count() const { return m_count; }
+    
+    /// Accumulator bytes, for memory profiling
+    uint64_t bytes() const;
+    
+private:
+    typedef void (*Add16Kernel)(uint32_t* acc, const uint16_t* in, uint32_t outWidth, uint32_t columns);
+    
+    uint32_t m_outWidth;
+    uint32_t m_bytesPerPixel;
+    uint32_t m_columns;
+    uint32_t m_lines;
+    uint32_t m_count;               ///< Lines in the current group
+    bool m_average;
+    uint64_t m_maxValue;
+    std::vector<uint32_t> m_acc;    ///< 8/16-bit pixels
+    std::vector<uint64_t> m_wide;   ///< 32-bit pixels
+    Add16Kernel m_add16;
+};
+
+} // namespace Internal
+} // namespace HX
+
+#endif // LINE_BINNING_H
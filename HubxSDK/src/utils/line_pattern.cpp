@@ -0,0 +1,156 @@
+// ============================================================================
+// line_pattern.cpp
+// ============================================================================
+
+/**
+ * @file line_pattern.cpp
+ * @brief Test pattern reference and compare kernels
+ * @version 2.1.0
+ *
+ * The AVX2 compare ORs the XOR of four 32-byte lanes and tests the result
+ * once per 128 bytes, so a matching line costs two loads and an XOR per
+ * 32 bytes and never branches inside a step.
+ */
+
+#include "line_pattern.h"
+#include "cpu_features.h"
+#include <algorithm>
+#include <cstring>
+
+namespace HX {
+namespace Internal {
+
+namespace {
+
+const KernelFamily g_patternKernels("line_pattern", XFactory::CPU_AVX2);
+
+// m_learned states
+const uint8_t CANDIDATE = 1;
+const uint8_t LEARNED = 2;
+
+#if defined(HX_ARCH_X86)
+HX_TARGET("avx2")
+bool equalAVX2(const uint8_t* a, const uint8_t* b, size_t bytes) {
+    size_t i = 0;
+    for (; i + 128 <= bytes; i += 128) {
+        const __m256i d0 = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i)),
+                                            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i)));
+        const __m256i d1 = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i + 32)),
+                                            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i + 32)));
+        const __m256i d2 = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i + 64)),
+                                            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i + 64)));
+        const __m256i d3 = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i + 96)),
+                                            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i + 96)));
+        const __m256i any = _mm256_or_si256(_mm256_or_si256(d0, d1), _mm256_or_si256(d2, d3));
+        if (!_mm256_testz_si256(any, any)) {
+            return false;
+        }
+    }
+    for (; i + 32 <= bytes; i += 32) {
+        const __m256i d = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i)),
+                                           _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i)));
+        if (!_mm256_testz_si256(d, d)) {
+            return false;
+        }
+    }
+    return memcmp(a + i, b + i, bytes - i) == 0;
+}
+#endif
+
+} // namespace
+
+bool PatternEqual(const uint8_t* a, const uint8_t* b, size_t bytes) {
+#if defined(HX_ARCH_X86)
+    if (g_patternKernels.isa() == XFactory::CPU_AVX2) {
+        return equalAVX2(a, b, bytes);
+    }
+#endif
+    return memcmp(a, b, bytes) == 0;
+}
+
+LinePattern::LinePattern()
+    : m_learn(false)
+    , m_learnLeft(0)
+    , m_lineBytes(0)
+    , m_segmentBytes(0)
+    , m_segments(1)
+    , m_lines(0)
+    , m_checked(0)
+    , m_mismatched(0)
+{
+}
+
+void LinePattern::configure(const uint8_t* expected, uint32_t lineBytes, uint32_t segments, uint32_t lines) {
+    m_segments = std::max<uint32_t>(1, segments);
+    m_lineBytes = lineBytes;
+    m_segmentBytes = lineBytes / m_segments;
+    m_lines = lines;
+    m_learn = (expected == nullptr);
+    
+    const size_t bytes = static_cast<size_t>(lines) * lineBytes;
+    if (m_learn) {
+        m_reference.assign(bytes, 0);
+        m_learned.assign(static_cast<size_t>(lines) * m_segments, 0);
+        m_learnLeft = lines * m_segments;
+    } else {
+        m_reference.assign(expected, expected + bytes);
+        m_learned.clear();
+        m_learnLeft = 0;
+    }
+    resetCounters();
+}
+
+void LinePattern::resetCounters() {
+    m_checked = 0;
+    m_mismatched = 0;
+}
+
+bool LinePattern::check(const uint8_t* data, uint32_t bytes, uint32_t lineId, uint32_t segment) {
+    if (m_lines == 0) {
+        return true;
+    }
+    if (segment >= m_segments || bytes != m_segmentBytes) {
+        m_checked.fetch_add(1, std::memory_order_relaxed);
+        m_mismatched.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    
+    const uint32_t line = lineId % m_lines;
+    uint8_t* expected = &m_reference[static_cast<size_t>(line) * m_lineBytes +
+                                     static_cast<size_t>(segment) * m_segmentBytes];
+    
+    // While segments are still being learned the reference is written, so
+    // a segment is first looked up under the lock
+    if (m_learnLeft.load(std::memory_order_acquire) > 0 && learn(data, line, segment, expected)) {
+        return true;
+    }
+    
+    m_checked.fetch_add(1, std::memory_order_relaxed);
+    if (!PatternEqual(data, expected, bytes)) {
+        m_mismatched.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+bool LinePattern::learn(const uint8_t* data, uint32_t line, uint32_t segment, uint8_t* expected) {
+    std::lock_guard<std::mutex> lock(m_learnMutex);
+    
+    // A segment is learned once two copies in a row agree, so a copy
+    // damaged on the wire does not become the reference
+    uint8_t& state = m_learned[static_cast<size_t>(line) * m_segments + segment];
+    if (state == LEARNED) {
+        return false;
+    }
+    if (state == CANDIDATE && PatternEqual(data, expected, m_segmentBytes)) {
+        state = LEARNED;
+        m_learnLeft.fetch_sub(1, std::memory_order_release);
+        return true;
+    }
+    memcpy(expected, data, m_segmentBytes);
+    state = CANDIDATE;
+    return true;
+}
+
+} // namespace Internal
+} // namespace HX
@@ -0,0 +1,101 @@
+// ============================================================================
+// line_pattern.h
+// ============================================================================
+
+/**
+ * @file line_pattern.h
+ * @brief Received lines compared with a known detector test pattern
+ * @version 2.1.0
+ *
+ * This header is INTERNAL to hubx.dll. The pattern is a run of expected
+ * lines that repeats every lines() lines, so line id L is compared with
+ * expected line L % lines(). Packets carry a segment of a line (a DM
+ * module's share or a fragment), compared at its offset. The reference is
+ * either given or learned: a segment of a pattern line is learned when
+ * two copies received in a row agree, and later copies are compared with
+ * it.
+ */
+
+#ifndef LINE_PATTERN_H
+#define LINE_PATTERN_H
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace HX {
+namespace Internal {
+
+/**
+ * @class LinePattern
+ * @brief Expected pattern lines and the mismatch counters
+ *
+ * configure() while no line is checked; check() is safe from every
+ * receive thread at once.
+ */
+class LinePattern {
+public:
+    LinePattern();
+    
+    /**
+     * @brief Set the pattern for a line format
+     * @param expected lines * lineBytes expected bytes, nullptr to learn them
+     * @param lineBytes Bytes per line
+     * @param segments Equal segments per line the packets carry
+     * @param lines Pattern period in lines (0 = off)
+     */
+    void configure(const uint8_t* expected, uint32_t lineBytes, uint32_t segments, uint32_t lines);
+    
+    /// Zero the counters; the reference stays
+    void resetCounters();
+    
+    bool enabled() const { return m_lines > 0; }
+    uint32_t lines() const { return m_lines; }
+    
+    /**
+     * @brief Compare one received segment
+     * @param data Segment bytes
+     * @param bytes Segment length, the line's share of one segment
+     * @param lineId Unwrapped detector line id
+     * @param segment Segment index within the line
+     * @return false on a mismatch
+     */
+    bool check(const uint8_t* data, uint32_t bytes, uint32_t lineId, uint32_t segment);
+    
+    /// Segments compared with the reference
+    uint64_t checked() const { return m_checked.load(std::memory_order_relaxed); }
+    
+    /// Segments that differed from it
+    uint64_t mismatched() const { return m_mismatched.load(std::memory_order_relaxed); }
+    
+private:
+    bool learn(const uint8_t* data, uint32_t line, uint32_t segment, uint8_t* expected);
+    
+    std::vector<uint8_t> m_reference;
+    bool m_learn;                           ///< Reference comes from the first lines
+    std::vector<uint8_t> m_learned;         ///< Per pattern segment: empty, candidate, learned
+    std::atomic<uint32_t> m_learnLeft;      ///< Segments still to learn
+    std::mutex m_learnMutex;
+    uint32_t m_lineBytes;
+    uint32_t m_segmentBytes;
+    uint32_t m_segments;
+    uint32_t m_lines;
+    std::atomic<uint64_t> m_checked;
+    std::atomic<uint64_t> m_mismatched;
+    
+    // Non-copyable
+    LinePattern(const LinePattern&) = delete;
+    LinePattern& operator=(const LinePattern&) = delete;
+};
+
+/**
+ * @brief true if @p a and @p b hold the same @p bytes
+ * @note AVX2 when the CPU has it, up to 128 bytes per step
+ */
+bool PatternEqual(const uint8_t* a, const uint8_t* b, size_t bytes);
+
+} // namespace Internal
+} // namespace HX
+
+#endif // LINE_PATTERN_H
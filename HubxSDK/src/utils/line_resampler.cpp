@@ -0,0 +1,135 @@
+// ============================================================================
+// line_resampler.cpp
+// ============================================================================
+
+/**
+ * @file line_resampler.cpp
+ * @brief Linear interpolation between consecutive scan lines
+ * @version 2.1.0
+ *
+ * Weights are 16-bit fixed point, so 8 and 16-bit lines blend in 32-bit
+ * integers, which the compiler vectorizes; a row that sits on a line is
+ * copied exactly.
+ */
+
+#include "line_resampler.h"
+#include <cstring>
+
+namespace HX {
+namespace Internal {
+
+namespace {
+
+template <typename Pixel, typename Wide>
+void blend(const uint8_t* prev, const uint8_t* cur, uint8_t* out, uint32_t width, uint32_t weight) {
+    const Pixel* a = reinterpret_cast<const Pixel*>(prev);
+    const Pixel* b = reinterpret_cast<const Pixel*>(cur);
+    Pixel* o = reinterpret_cast<Pixel*>(out);
+    const Wide wb = weight;
+    const Wide wa = 65536 - wb;
+    for (uint32_t x = 0; x < width; ++x) {
+        o[x] = static_cast<Pixel>((a[x] * wa + b[x] * wb + 32768) >> 16);
+    }
+}
+
+} // namespace
+
+void BlendLines(const uint8_t* a, const uint8_t* b, uint8_t* out, uint32_t width,
+                uint32_t bytesPerPixel, uint32_t weight) {
+    const size_t bytes = static_cast<size_t>(width) * bytesPerPixel;
+    if (weight >= 65536) {
+        memcpy(out, b, bytes);
+    } else if (weight == 0) {
+        memcpy(out, a, bytes);
+    } else if (bytesPerPixel == 1) {
+        blend<uint8_t, uint32_t>(a, b, out, width, weight);
+    } else if (bytesPerPixel == 2) {
+        blend<uint16_t, uint32_t>(a, b, out, width, weight);
+    } else {
+        blend<uint32_t, uint64_t>(a, b, out, width, weight);
+    }
+}
+
+LineResampler::LineResampler()
+    : m_width(0)
+    , m_bytesPerPixel(2)
+    , m_pitch(1.0)
+    , m_started(false)
+    , m_lastTime(0)
+    , m_prevPos(0.0)
+    , m_curPos(0.0)
+    , m_nextRow(0)
+{
+}
+
+bool LineResampler::configure(uint32_t width, uint32_t bytesPerPixel, double pitch) {
+    if (width == 0 || !(pitch > 0.0) ||
+        (bytesPerPixel != 1 && bytesPerPixel != 2 && bytesPerPixel != 4)) {
+        return false;
+    }
+    m_width = width;
+    m_bytesPerPixel = bytesPerPixel;
+    m_pitch = pitch;
+    m_prev.assign(static_cast<size_t>(width) * bytesPerPixel, 0);
+    m_cur.assign(m_prev.size(), 0);
+    reset();
+    return true;
+}
+
+bool LineResampler::add(const uint8_t* line, uint32_t timestampUs, double rate) {
+    if (!m_started) {
+        // The first line is row 0
+        memcpy(m_cur.data(), line, m_cur.size());
+        m_lastTime = timestampUs;
+        m_prevPos = 0.0;
+        m_curPos = 0.0;
+        m_nextRow = 0;
+        m_started = true;
+        return true;
+    }
+    
+    // Signed difference survives the 32-bit timestamp wrap
+    const int32_t elapsed = static_cast<int32_t>(timestampUs - m_lastTime);
+    if (elapsed < 0) {
+        return false;
+    }
+    m_prev.swap(m_cur);
+    memcpy(m_cur.data(), line, m_cur.size());
+    m_lastTime = timestampUs;
+    m_prevPos = m_curPos;
+    if (rate > 0.0) {
+        m_curPos += rate * elapsed * 1e-6 / m_pitch;
+    }
+    return true;
+}
+
+bool LineResampler::emit(uint8_t* out, uint32_t& row) {
+    const double target = static_cast<double>(m_nextRow);
+    if (!m_started || target > m_curPos) {
+        return false;
+    }
+    
+    // Row 0 sits on the first line, before the span opens
+    uint32_t weight = 65536;
+    if (m_curPos > m_prevPos) {
+        const double t = (target - m_prevPos) / (m_curPos - m_prevPos);
+        weight = static_cast<uint32_t>(t * 65536.0 + 0.5);
+    }
+    BlendLines(m_prev.data(), m_cur.data(), out, m_width, m_bytesPerPixel, weight);
+    row = static_cast<uint32_t>(m_nextRow++);
+    return true;
+}
+
+void LineResampler::reset() {
+    m_started = false;
+    m_prevPos = 0.0;
+    m_curPos = 0.0;
+    m_nextRow = 0;
+}
+
+uint64_t LineResampler::bytes() const {
+    return m_prev.capacity() + m_cur.capacity();
+}
+
+} // namespace Internal
+} // namespace HX
@@ -0,0 +1,92 @@
+// ============================================================================
+// line_resampler.h
+// ============================================================================
+
+/**
+ * @file line_resampler.h
+ * @brief Resampling of scan lines onto a uniform belt-travel grid
+ * @version 2.1.0
+ *
+ * This header is INTERNAL to hubx.dll. Every line advances the belt
+ * position by the encoder rate times the time since the previous line;
+ * output rows sit at whole multiples of the pitch and are interpolated
+ * between the two lines around them. Only those two lines are kept, so
+ * rows come out as the lines arrive, without a pass over the frame.
+ */
+
+#ifndef LINE_RESAMPLER_H
+#define LINE_RESAMPLER_H
+
+#include <cstdint>
+#include <vector>
+
+namespace HX {
+namespace Internal {
+
+/**
+ * @brief Blend two lines, out = a + (b - a) * weight / 65536
+ * @param bytesPerPixel 1, 2 or 4
+ * @param weight Share of b in 16-bit fixed point; 0 and 65536 copy a line
+ */
+void BlendLines(const uint8_t* a, const uint8_t* b, uint8_t* out, uint32_t width,
+                uint32_t bytesPerPixel, uint32_t weight);
+
+/**
+ * @class LineResampler
+ * @brief Turns time-stamped lines into rows at a fixed travel pitch
+ */
+class LineResampler {
+public:
+    LineResampler();
+    
+    /**
+     * @brief Size the line buffers and start a new run
+     * @param width Pixels per line
+     * @param bytesPerPixel 1, 2 or 4
+     * @param pitch Belt travel per output row, in encoder units
+     * @return false if the format or pitch is not supported
+     */
+    bool configure(uint32_t width, uint32_t bytesPerPixel, double pitch);
+    
+    /**
+     * @brief Add the next line
+     * @param line Line pixels
+     * @param timestampUs Acquisition time; wraps like XLibPacketHeader::timestamp
+     * @param rate Belt speed since the previous line, encoder units per second
+     * @return false if the line is older than the previous one (not used)
+     */
+    bool add(const uint8_t* line, uint32_t timestampUs, double rate);
+    
+    /**
+     * @brief Interpolate the next row the belt has passed
+     * @param out Output row, width pixels
+     * @param row Receives the row number, counted from the first line
+     * @return false when no further row lies before the last line added
+     */
+    bool emit(uint8_t* out, uint32_t& row);
+    
+    /**
+     * @brief Forget both lines; the next one starts row 0 again
+     */
+    void reset();
+    
+    /// Line buffer bytes, for memory profiling
+    uint64_t bytes() const;
+    
+private:
+    uint32_t m_width;
+    uint32_t m_bytesPerPixel;
+    double m_pitch;
+    bool m_started;
+    uint32_t m_lastTime;            ///< Timestamp of the current line
+    double m_prevPos;               ///< Positions in rows
+    double m_curPos;
+    uint64_t m_nextRow;             ///< Next row to emit
+    std::vector<uint8_t> m_prev;
+    std::vector<uint8_t> m_cur;
+};
+
+} // namespace Internal
+} // namespace HX
+
+#endif // LINE_RESAMPLER_H
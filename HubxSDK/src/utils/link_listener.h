@@ -0,0 +1,44 @@
+// ============================================================================
+// link_listener.h
+// ============================================================================
+
+/**
+ * @file link_listener.h
+ * @brief Link state notifications from XControl auto-reconnect
+ * @version 2.1.0
+ *
+ * This header is INTERNAL to hubx.dll. An XGrabber opened with an XControl
+ * registers itself so it can suspend acquisition while the control channel
+ * is being reopened and resume it afterwards.
+ */
+
+#ifndef LINK_LISTENER_H
+#define LINK_LISTENER_H
+
+#include <cstdint>
+
+namespace HX {
+namespace Internal {
+
+class LinkListener {
+public:
+    virtual ~LinkListener() {}
+
+    /**
+     * @brief The link is lost and the network is about to be closed
+     * @note Called from the XControl heartbeat thread
+     */
+    virtual void onLinkLost() = 0;
+
+    /**
+     * @brief The detector answers again and its parameters are restored
+     * @param gapMs Time since the last answer before the loss
+     * @note Called from the XControl heartbeat thread
+     */
+    virtual void onLinkRestored(uint32_t gapMs) = 0;
+};
+
+} // namespace Internal
+} // namespace HX
+
+#endif // LINK_LISTENER_H
@@ -0,0 +1,332 @@
+// ============================================================================
+// logger.cpp
+// ============================================================================
+
+/**
+ * @file logger.cpp
+ * @brief Lock-free log queue, log thread and per-message rate limiting
+ * @version 2.1.0
+ */
+
+#include "logger.h"
+#include "ixlog_sink.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace HX {
+namespace Internal {
+
+std::atomic<int32_t> g_logLevel(XFactory::LOG_INFO);
+
+namespace {
+
+const uint32_t QUEUE_SIZE = 1024;           // Power of two
+const size_t MAX_COMPONENT = 16;
+const size_t MAX_TEXT = 480;                // Longer messages are cut
+
+const uint32_t RATE_SLOTS = 1024;           // Power of two
+const uint32_t DEFAULT_RATE_LIMIT = 20;
+
+/// Log thread wake-up when no producer signalled
+const int IDLE_WAIT_MS = 10;
+
+/// Longest exit waits for the queue to drain
+const int STOP_WAIT_MS = 500;
+
+struct Record {
+    int32_t level;
+    char component[MAX_COMPONENT];
+    char text[MAX_TEXT];
+};
+
+/// Bounded multi-producer queue (Vyukov); the log thread is the only consumer
+struct Cell {
+    std::atomic<uint64_t> sequence;
+    Record record;
+};
+
+/// Messages admitted in the current second of one bucket
+struct RateSlot {
+    std::atomic<uint64_t> window;           // second << 32 | count
+    std::atomic<uint32_t> suppressed;
+};
+
+uint32_t nowSeconds() {
+    return static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void copyText(char* dst, size_t capacity, const char* src, size_t length) {
+    if (length >= capacity) length = capacity - 1;
+    memcpy(dst, src, length);
+    dst[length] = '\0';
+}
+
+class Logger {
+public:
+    static Logger& instance() {
+        // Leaked: components with static storage may log after exit begins
+        static Logger* logger = new Logger();
+        return *logger;
+    }
+
+    bool admit(uint32_t key) {
+        uint32_t limit = m_rateLimit.load(std::memory_order_relaxed);
+        if (limit == 0) return true;
+
+        RateSlot& slot = m_slots[key & (RATE_SLOTS - 1)];
+        uint64_t now = nowSeconds();
+        uint64_t state = slot.window.load(std::memory_order_relaxed);
+        for (;;) {
+            uint64_t next;
+            if ((state >> 32) != now) {
+                next = (now << 32) | 1;
+            } else if ((state & 0xFFFFFFFFu) < limit) {
+                next = state + 1;
+            } else {
+                slot.suppressed.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            if (slot.window.compare_exchange_weak(state, next, std::memory_order_relaxed)) {
+                return true;
+            }
+        }
+    }
+
+    uint32_t takeSuppressed(uint32_t key) {
+        return m_slots[key & (RATE_SLOTS - 1)].suppressed.exchange(0, std::memory_order_relaxed);
+    }
+
+    void submit(int32_t level, const char* component, const std::string& text) {
+        if (m_stopped.load(std::memory_order_acquire)) {
+            // Past exit: nobody drains the queue any more
+            // and the application's sink may be gone
+            Record record;
+            fill(record, level, component, text);
+            writeConsole(record);
+            fflush(stdout);
+            fflush(stderr);
+            return;
+        }
+        startThread();
+
+        uint64_t pos = m_enqueue.load(std::memory_order_relaxed);
+        Cell* cell;
+        for (;;) {
+            cell = &m_cells[pos & (QUEUE_SIZE - 1)];
+            uint64_t seq = cell->sequence.load(std::memory_order_acquire);
+            int64_t diff = static_cast<int64_t>(seq) - static_cast<int64_t>(pos);
+            if (diff == 0) {
+                if (m_enqueue.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            } else if (diff < 0) {
+                m_dropped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            } else {
+                pos = m_enqueue.load(std::memory_order_relaxed);
+            }
+        }
+        fill(cell->record, level, component, text);
+        cell->sequence.store(pos + 1, std::memory_order_release);
+
+        if (m_sleeping.load(std::memory_order_acquire)) {
+            m_wake.notify_one();
+        }
+    }
+
+    void setSink(IXLogSink* sink) {
+        // Once the lock is held the log thread is not inside the old sink
+        std::lock_guard<std::mutex> lock(m_sinkMutex);
+        m_sink = sink;
+    }
+
+    void setRateLimit(uint32_t perSecond) {
+        m_rateLimit.store(perSecond, std::memory_order_relaxed);
+    }
+
+    void flush() {
+        if (!m_started.load(std::memory_order_acquire)) return;
+        if (std::this_thread::get_id() == m_threadId) return; // From a sink
+
+        uint64_t target = m_enqueue.load(std::memory_order_acquire);
+        while (m_written.load(std::memory_order_acquire) < target &&
+               !m_stopped.load(std::memory_order_acquire)) {
+            m_wake.notify_one();
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    uint64_t dropped() const {
+        return m_dropped.load(std::memory_order_relaxed);
+    }
+
+private:
+    Logger()
+        : m_enqueue(0),
+          m_dequeue(0),
+          m_written(0),
+          m_dropped(0),
+          m_rateLimit(DEFAULT_RATE_LIMIT),
+          m_started(false),
+          m_stopped(false),
+          m_sleeping(false),
+          m_sink(nullptr) {
+        for (uint32_t i = 0; i < QUEUE_SIZE; i++) {
+            m_cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+        for (uint32_t i = 0; i < RATE_SLOTS; i++) {
+            m_slots[i].window.store(0, std::memory_order_relaxed);
+            m_slots[i].suppressed.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    static void fill(Record& record, int32_t level, const char* component, const std::string& text) {
+        record.level = level;
+        copyText(record.component, MAX_COMPONENT, component, strlen(component));
+        copyText(record.text, MAX_TEXT, text.data(), text.size());
+    }
+
+    void startThread() {
+        if (m_started.load(std::memory_order_acquire)) return;
+        std::lock_guard<std::mutex> lock(m_startMutex);
+        if (m_started.load(std::memory_order_relaxed)) return;
+        m_thread = std::thread(&Logger::logThread, this);
+        m_threadId = m_thread.get_id();
+        m_started.store(true, std::memory_order_release);
+        atexit(&Logger::stopAtExit);
+    }
+
+    static void stopAtExit() {
+        Logger& logger = instance();
+        {
+            std::lock_guard<std::mutex> lock(logger.m_wakeMutex);
+            logger.m_stopping = true;
+        }
+        logger.m_wake.notify_one();
+
+        // No join: inside a DLL unload the thread may never get to run again
+        for (int i = 0; i < STOP_WAIT_MS && !logger.m_stopped.load(std::memory_order_acquire); i++) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        if (logger.m_thread.joinable()) logger.m_thread.detach();
+    }
+
+    static void writeConsole(const Record& record) {
+        FILE* out = record.level >= XFactory::LOG_WARNING ? stderr : stdout;
+        fprintf(out, "[%s] %s\n", record.component, record.text);
+    }
+
+    void write(const Record& record) {
+        if (m_sink) {
+            m_sink->OnXLog(static_cast<uint32_t>(record.level), record.component, record.text);
+        } else {
+            writeConsole(record);
+        }
+    }
+
+    /// Write everything queued; returns the number of messages
+    uint32_t drain() {
+        uint32_t count = 0;
+        std::lock_guard<std::mutex> lock(m_sinkMutex);
+        for (;;) {
+            Cell& cell = m_cells[m_dequeue & (QUEUE_SIZE - 1)];
+            if (cell.sequence.load(std::memory_order_acquire) != m_dequeue + 1) break;
+
+            write(cell.record);
+            cell.sequence.store(m_dequeue + QUEUE_SIZE, std::memory_order_release);
+            m_dequeue++;
+            count++;
+            m_written.store(m_dequeue, std::memory_order_release);
+        }
+        if (count > 0 && !m_sink) {
+            fflush(stdout);
+            fflush(stderr);
+        }
+        return count;
+    }
+
+    void logThread() {
+        for (;;) {
+            if (drain() > 0) continue;
+
+            std::unique_lock<std::mutex> lock(m_wakeMutex);
+            if (m_stopping) break;
+            m_sleeping.store(true, std::memory_order_release);
+            m_wake.wait_for(lock, std::chrono::milliseconds(IDLE_WAIT_MS));
+            m_sleeping.store(false, std::memory_order_relaxed);
+        }
+        drain();
+        m_stopped.store(true, std::memory_order_release);
+        drain();                            // Producers that missed the flag
+    }
+
+    Cell m_cells[QUEUE_SIZE];
+    RateSlot m_slots[RATE_SLOTS];
+
+    std::atomic<uint64_t> m_enqueue;
+    uint64_t m_dequeue;                     // Log thread only
+    std::atomic<uint64_t> m_written;
+    std::atomic<uint64_t> m_dropped;
+    std::atomic<uint32_t> m_rateLimit;
+
+    std::mutex m_startMutex;
+    std::atomic<bool> m_started;
+    std::atomic<bool> m_stopped;
+    std::thread m_thread;
+    std::thread::id m_threadId;
+
+    std::mutex m_wakeMutex;
+    std::condition_variable m_wake;
+    std::atomic<bool> m_sleeping;
+    bool m_stopping = false;
+
+    std::mutex m_sinkMutex;
+    IXLogSink* m_sink;
+};
+
+} // namespace
+
+uint32_t LogErrorKey(const char* component, uint32_t id) {
+    uint32_t hash = 2166136261u;
+    for (const char* c = component; *c; c++) {
+        hash = (hash ^ static_cast<uint8_t>(*c)) * 16777619u;
+    }
+    return hash ^ (id * 2654435761u);
+}
+
+bool LogAdmit(uint32_t key) {
+    return Logger::instance().admit(key);
+}
+
+LogLine::~LogLine() {
+    Logger& logger = Logger::instance();
+    uint32_t suppressed = logger.takeSuppressed(m_key);
+    if (suppressed > 0) {
+        m_stream << " (" << suppressed << " similar messages suppressed)";
+    }
+    logger.submit(m_level, m_component, m_stream.str());
+}
+
+void LogSetSink(IXLogSink* sink) {
+    Logger::instance().setSink(sink);
+}
+
+void LogSetRateLimit(uint32_t perSecond) {
+    Logger::instance().setRateLimit(perSecond);
+}
+
+void LogFlush() {
+    Logger::instance().flush();
+}
+
+uint64_t LogDropped() {
+    return Logger::instance().dropped();
+}
+
+} // namespace Internal
+} // namespace HX
@@ -0,0 +1,103 @@
+// ============================================================================
+// logger.h
+// ============================================================================
+
+/**
+ * @file logger.h
+ * @brief Leveled, asynchronous SDK log
+ * @version 2.1.0
+ *
+ * This header is INTERNAL to hubx.dll. Components log with
+ *
+ *   HX_LOG_INFO("XGrabber") << "Grab thread started (batch " << n << ")";
+ *
+ * Below the XFactory::SetLogLevel() threshold the statement costs one
+ * relaxed load and its operands are not evaluated. Otherwise the text is
+ * formatted on the calling thread and put on a lock-free queue; a log
+ * thread writes it to the IXLogSink or the console, flushing once per
+ * batch. A full queue drops the message instead of waiting.
+ *
+ * Each call site (or, for HX_LOG_ID, each component and error id) may log
+ * XFactory::SetLogRateLimit() messages per second; the rest are counted
+ * and the count is appended to the next message that gets through.
+ */
+
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include "xfactory.h"
+#include <atomic>
+#include <cstdint>
+#include <sstream>
+
+namespace HX {
+namespace Internal {
+
+extern std::atomic<int32_t> g_logLevel;
+
+/// Rate-limit bucket of a call site
+inline uint32_t LogSiteKey(const char* file, int line) {
+    return static_cast<uint32_t>(reinterpret_cast<uintptr_t>(file)) ^
+           (static_cast<uint32_t>(line) * 2654435761u);
+}
+
+/// Rate-limit bucket of an error id; ids repeat across components
+uint32_t LogErrorKey(const char* component, uint32_t id);
+
+/// false if a rate limit suppresses the message (counted for later)
+bool LogAdmit(uint32_t key);
+
+/// Check the level, then the rate limit
+inline bool LogEnabled(XFactory::LogLevel level, uint32_t key) {
+    return level >= g_logLevel.load(std::memory_order_relaxed) && LogAdmit(key);
+}
+
+/**
+ * @brief One message, queued when the statement ends
+ */
+class LogLine {
+public:
+    LogLine(XFactory::LogLevel level, const char* component, uint32_t key)
+        : m_level(level), m_component(component), m_key(key) {}
+    ~LogLine();
+
+    std::ostream& stream() { return m_stream; }
+
+private:
+    XFactory::LogLevel m_level;
+    const char* m_component;
+    uint32_t m_key;
+    std::ostringstream m_stream;
+
+    LogLine(const LogLine&) = delete;
+    LogLine& operator=(const LogLine&) = delete;
+};
+
+// XFactory entry points
+void LogSetSink(IXLogSink* sink);
+void LogSetRateLimit(uint32_t perSecond);
+void LogFlush();
+uint64_t LogDropped();
+
+} // namespace Internal
+} // namespace HX
+
+// The empty if-branch keeps a trailing else bound to the caller's if
+#define HX_LOG_KEY(level, component, key)                                    \
+    if (!::HX::Internal::LogEnabled(level, key)) {                           \
+    } else                                                                   \
+        ::HX::Internal::LogLine(level, component, key).stream()
+
+#define HX_LOG(level, component) \
+    HX_LOG_KEY(level, component, ::HX::Internal::LogSiteKey(__FILE__, __LINE__))
+
+/// Error log rate-limited per component and error id
+#define HX_LOG_ID(level, component, id) \
+    HX_LOG_KEY(level, component, ::HX::Internal::LogErrorKey(component, id))
+
+#define HX_LOG_DEBUG(component)   HX_LOG(::HX::XFactory::LOG_DEBUG, component)
+#define HX_LOG_INFO(component)    HX_LOG(::HX::XFactory::LOG_INFO, component)
+#define HX_LOG_WARNING(component) HX_LOG(::HX::XFactory::LOG_WARNING, component)
+#define HX_LOG_ERROR(component)   HX_LOG(::HX::XFactory::LOG_ERROR, component)
+
+#endif // LOGGER_H
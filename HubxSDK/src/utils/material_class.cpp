@@ -0,0 +1,38 @@
+// ============================================================================
+// material_class.cpp
+// ============================================================================
+
+/**
+ * @file material_class.cpp
+ * @brief (high, low) material table
+ * @version 2.1.0
+ */
+
+#include "material_class.h"
+#include "thread_pool.h"
+
+namespace HX {
+namespace Internal {
+
+void BuildMaterialTable(const MaterialModel& model, int bitDepth, std::vector<uint16_t>& table) {
+    const int bits = MaterialTableBits(model, bitDepth);
+    const int cells = 1 << bits;
+    const float cell = static_cast<float>(1 << (bitDepth - bits));
+    const float fullScale = static_cast<float>((1 << bitDepth) - 1);
+    table.resize(static_cast<size_t>(cells) * cells);
+    uint16_t* entries = table.data();
+
+    // A row per quantized high value
+    ThreadPool::instance().parallelRows(cells, cells, [&](int firstRow, int endRow) {
+        for (int h = firstRow; h < endRow; ++h) {
+            const float high = (h + 0.5f) * cell;
+            uint16_t* row = entries + static_cast<size_t>(h) * cells;
+            for (int l = 0; l < cells; ++l) {
+                row[l] = MaterialEntry(model, high, (l + 0.5f) * cell, fullScale);
+            }
+        }
+    });
+}
+
+} // namespace Internal
+} // namespace HX
@@ -0,0 +1,114 @@
+// ============================================================================
+// material_class.h
+// ============================================================================
+
+/**
+ * @file material_class.h
+ * @brief Material class and Z-effective of a dual-energy (high, low) pair
+ * @version 2.1.0
+ *
+ * This header is INTERNAL to hubx.dll. Shared by the dual-energy fusion,
+ * which reports classes and Z-effective, and XShow, which colors a pair
+ * by class, so both agree on where organic ends and metal begins.
+ *
+ * A pair depends on nothing but its two values, so callers look it up in
+ * a 2-D table over the top lutBits bits of each value; an entry holds
+ * the class in its top bits and Z-effective * 100 below.
+ */
+
+#ifndef MATERIAL_CLASS_H
+#define MATERIAL_CLASS_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace HX {
+namespace Internal {
+
+/**
+ * @brief Classes of a (high, low) pair
+ */
+enum MaterialClass {
+    MATERIAL_BACKGROUND = 0,         ///< Next to no attenuation: air or belt
+    MATERIAL_ORGANIC,                ///< Z-effective below organicMaxZ
+    MATERIAL_INORGANIC,              ///< Mixed and light inorganic materials
+    MATERIAL_METAL,                  ///< Z-effective from metalMinZ up
+    MATERIAL_IMPENETRABLE,           ///< Too little high-energy signal to tell
+    MATERIAL_CLASSES
+};
+
+/**
+ * @brief Coefficients of the (high, low) -> class and Z-effective mapping
+ *
+ * With attenuations a = -ln(I / full scale), the ratio R = a_low / a_high
+ * grows with the atomic number, and Z-effective = z0 + z1 R + z2 R^2 is
+ * its calibration curve (fit on step wedges of known materials). The
+ * default is a linear stand-in through R = 1.1 -> Z 6 and R = 1.9 -> Z 28.
+ */
+struct MaterialModel {
+    float z0;
+    float z1;
+    float z2;
+    float organicMaxZ;               ///< Organic below this Z-effective
+    float metalMinZ;                 ///< Metal from this Z-effective up
+    float minAttenuation;            ///< a_high below this is background
+    float maxAttenuation;            ///< a_high above this is impenetrable
+    int lutBits;                     ///< Bits of high and of low in the table index
+
+    MaterialModel()
+        : z0(-24.25f), z1(27.5f), z2(0.0f), organicMaxZ(10.0f), metalMinZ(18.0f),
+          minAttenuation(0.02f), maxAttenuation(5.0f), lutBits(10) {}
+
+    /// Class limits ordered, attenuations sane, table of 64..4096 cells a side
+    bool valid() const {
+        return lutBits >= 6 && lutBits <= 12 && organicMaxZ <= metalMinZ &&
+               minAttenuation >= 0.0f && maxAttenuation > minAttenuation;
+    }
+};
+
+/// Table entry: the class in the top bits, Z-effective * 100 below
+const int MATERIAL_CLASS_SHIFT = 13;
+const uint16_t MATERIAL_ZEFF_MASK = (1 << MATERIAL_CLASS_SHIFT) - 1;
+
+/**
+ * @brief Table entry of one (high, low) pair, unquantized
+ */
+inline uint16_t MaterialEntry(const MaterialModel& model, float high, float low, float fullScale) {
+    // Attenuations, with signal at or below one count taken as one count
+    const float aHigh = -std::log(std::max(high, 1.0f) / fullScale);
+    const float aLow = -std::log(std::max(low, 1.0f) / fullScale);
+    if (aHigh < model.minAttenuation) {
+        return static_cast<uint16_t>(MATERIAL_BACKGROUND << MATERIAL_CLASS_SHIFT);
+    }
+    if (aHigh > model.maxAttenuation) {
+        return static_cast<uint16_t>(MATERIAL_IMPENETRABLE << MATERIAL_CLASS_SHIFT);
+    }
+
+    const float ratio = aLow / aHigh;
+    float z = model.z0 + (model.z1 + model.z2 * ratio) * ratio;
+    z = std::max(0.0f, std::min(static_cast<float>(MATERIAL_ZEFF_MASK) / 100.0f, z));
+    const int materialClass = (z < model.organicMaxZ) ? MATERIAL_ORGANIC :
+                              (z < model.metalMinZ) ? MATERIAL_INORGANIC : MATERIAL_METAL;
+    return static_cast<uint16_t>((materialClass << MATERIAL_CLASS_SHIFT) |
+                                 static_cast<int>(z * 100.0f + 0.5f));
+}
+
+/// Bits per value in the table index of a depth
+inline int MaterialTableBits(const MaterialModel& model, int bitDepth) {
+    return std::min(model.lutBits, bitDepth);
+}
+
+/**
+ * @brief Fill the table of a model and bit depth (1..16)
+ *
+ * Entry (h << bits) | l is the pair at the centre of cell (h, l). Rows
+ * are built on the shared pool.
+ */
+void BuildMaterialTable(const MaterialModel& model, int bitDepth, std::vector<uint16_t>& table);
+
+} // namespace Internal
+} // namespace HX
+
+#endif // MATERIAL_CLASS_H
@@ -0,0 +1,42 @@
+// ============================================================================
+// median_filter.h
+// ============================================================================
+
+/**
+ * @file median_filter.h
+ * @brief Square-window median of 16-bit images
+ * @version 2.1.0
+ *
+ * This header is INTERNAL to hubx.dll. 3x3 and 5x5 windows run a pruned
+ * sorting network on sixteen pixels at a time; larger windows keep a
+ * two-level histogram that slides along each row. Pixels outside the
+ * image repeat the nearest edge pixel, and both paths give the exact
+ * median, so the result does not depend on which one runs.
+ */
+
+#ifndef MEDIAN_FILTER_H
+#define MEDIAN_FILTER_H
+
+#include <cstdint>
+
+namespace HX {
+namespace Internal {
+
+/// Largest window radius medianFilter() accepts (101 x 101)
+const int MEDIAN_MAX_RADIUS = 50;
+
+/**
+ * @brief Median over a (2 * radius + 1)^2 window, in row bands on the pool
+ * @param src Input image, width * height values
+ * @param dst Output image; must not overlap src
+ * @param width Image width
+ * @param height Image height
+ * @param radius Window radius (0 copies the input, at most MEDIAN_MAX_RADIUS)
+ * @return false on invalid arguments
+ */
+bool medianFilter(const uint16_t* src, uint16_t* dst, int width, int height, int radius);
+
+} // namespace Internal
+} // namespace HX
+
+#endif // MEDIAN_FILTER_H
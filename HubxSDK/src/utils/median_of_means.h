@@ -0,0 +1,150 @@
+// ============================================================================
+// median_of_means.h
+// ============================================================================
+
+/**
+ * @file median_of_means.h
+ * @brief Streaming per-pixel median-of-means for outlier-robust calibration
+ * @version 2.1.0
+ *
+ * This header is INTERNAL to hubx.dll. Frames are dealt round-robin into
+ * a few groups and each group keeps a per-pixel sum; the estimate is the
+ * median of the group means. A cosmic hit or other one-frame transient
+ * corrupts only the group its frame went to, so up to (groups - 1) / 2
+ * hit frames per pixel leave the result untouched, where a plain mean
+ * would carry every hit into the gain map. Like WelfordAccumulator it is
+ * one pass over the frames with memory independent of their number.
+ */
+
+#ifndef MEDIAN_OF_MEANS_H
+#define MEDIAN_OF_MEANS_H
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#include "thread_pool.h"
+
+namespace HX {
+namespace Internal {
+
+/**
+ * @class MedianOfMeansAccumulator
+ * @brief Round-robin group sums of 16-bit frames, reduced by median
+ *
+ * Not synchronized; owners that are fed from a callback thread lock
+ * around add() and the readers.
+ */
+class MedianOfMeansAccumulator {
+public:
+    static const int MAX_GROUPS = 15;
+
+    /// A group sum of 16-bit values stays below 2^32 up to this many frames
+    static const uint64_t MAX_GROUP_FRAMES = 65537;
+
+    MedianOfMeansAccumulator() : m_groups(0), m_pixels(0), m_count(0) {}
+
+    /**
+     * @brief Discard all frames and size for @p pixels values per frame
+     * @param groups Number of group means the median is taken over (2..MAX_GROUPS)
+     */
+    void reset(size_t pixels, int groups) {
+        m_groups = std::max(2, std::min(groups, static_cast<int>(MAX_GROUPS)));
+        m_pixels = pixels;
+        m_sums.assign(pixels * m_groups, 0);
+        m_frames.assign(m_groups, 0);
+        m_count = 0;
+    }
+
+    /**
+     * @brief Free the storage
+     */
+    void clear() {
+        std::vector<uint32_t>().swap(m_sums);
+        m_frames.clear();
+        m_pixels = 0;
+        m_count = 0;
+    }
+
+    size_t pixels() const { return m_sums.empty() ? 0 : m_pixels; }
+    int groups() const { return m_groups; }
+    uint64_t count() const { return m_count; }
+
+    /**
+     * @brief Add one frame of pixels() values
+     * @return false once MAX_GROUP_FRAMES frames have gone into every group
+     */
+    bool add(const uint16_t* values) {
+        const int group = static_cast<int>(m_count % m_groups);
+        if (m_frames[group] >= MAX_GROUP_FRAMES) {
+            return false;
+        }
+        ++m_frames[group];
+        ++m_count;
+
+        // Pixel-major layout: the groups of one pixel share a cache line,
+        // which the median needs; add() strides by groups instead
+        uint32_t* sums = m_sums.data() + group;
+        const int stride = m_groups;
+        const int chunk = 4096;
+        const int chunks = static_cast<int>((m_pixels + chunk - 1) / chunk);
+        const size_t total = m_pixels;
+        ThreadPool::instance().parallelRows(chunks, chunk, [&](int first, int end) {
+            const size_t last = std::min(total, static_cast<size_t>(end) * chunk);
+            for (size_t i = static_cast<size_t>(first) * chunk; i < last; ++i) {
+                sums[i * stride] += values[i];
+            }
+        });
+        return true;
+    }
+
+    /**
+     * @brief Median of the group means of pixel @p i
+     *
+     * Groups that got no frame yet are left out; with an even number of
+     * groups the two middle means are averaged.
+     */
+    double estimate(size_t i) const {
+        double means[MAX_GROUPS];
+        int n = 0;
+        const uint32_t* sums = m_sums.data() + i * m_groups;
+        for (int g = 0; g < m_groups; ++g) {
+            if (m_frames[g] != 0) {
+                means[n++] = static_cast<double>(sums[g]) / static_cast<double>(m_frames[g]);
+            }
+        }
+        if (n == 0) {
+            return 0.0;
+        }
+        std::sort(means, means + n);
+        return (n & 1) ? means[n / 2] : 0.5 * (means[n / 2 - 1] + means[n / 2]);
+    }
+
+    /**
+     * @brief estimate() of every pixel, rounded and clamped to 16 bits,
+     *        computed in parallel row bands
+     */
+    void estimates(uint16_t* out) const {
+        const int chunk = 4096;
+        const int chunks = static_cast<int>((m_pixels + chunk - 1) / chunk);
+        const size_t total = m_pixels;
+        ThreadPool::instance().parallelRows(chunks, chunk, [&](int first, int end) {
+            const size_t last = std::min(total, static_cast<size_t>(end) * chunk);
+            for (size_t i = static_cast<size_t>(first) * chunk; i < last; ++i) {
+                const double value = estimate(i) + 0.5;
+                out[i] = static_cast<uint16_t>(std::min(65535.0, std::max(0.0, value)));
+            }
+        });
+    }
+
+private:
+    int m_groups;
+    size_t m_pixels;
+    std::vector<uint32_t> m_sums;       ///< pixels x groups, pixel-major
+    std::vector<uint64_t> m_frames;     ///< Frames per group
+    uint64_t m_count;
+};
+
+} // namespace Internal
+} // namespace HX
+
+#endif // MEDIAN_OF_MEANS_H
@@ -0,0 +1,268 @@
+// ============================================================================
+// mem_budget.cpp
+// ============================================================================
+
+/**
+ * @file mem_budget.cpp
+ * @brief Budget, governor thread and cache reclaim
+ * @version 2.1.0
+ */
+
+#include "mem_budget.h"
+#include "logger.h"
+#include "thread_policy.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace HX {
+namespace Internal {
+
+std::atomic<int64_t> g_memReclaimLevel(std::numeric_limits<int64_t>::max());
+
+namespace {
+
+/// Shortest time between reclaim passes, so allocations that stay above
+/// the level do not keep the governor spinning
+const std::chrono::milliseconds RECLAIM_INTERVAL(100);
+
+/// Share of the budget a pass frees below the reclaim level
+const double RECLAIM_SLACK = 0.05;
+
+class Governor {
+public:
+    static Governor& instance() {
+        static Governor governor;
+        return governor;
+    }
+
+    bool set(uint64_t bytes, float reclaimAt) {
+        if (!(reclaimAt > 0.0f && reclaimAt <= 1.0f)) {
+            return false;
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_limit.store(bytes, std::memory_order_relaxed);
+            m_slack = static_cast<int64_t>(bytes * RECLAIM_SLACK);
+            m_reclaims = 0;
+            m_reclaimedBytes = 0;
+            m_rejected = 0;
+            if (bytes > 0 && !m_thread.joinable()) {
+                m_thread = std::thread(&Governor::governorThread, this);
+            }
+        }
+        MemHoldAccounting(bytes > 0);
+        MemResetPeak();
+        g_memReclaimLevel.store(bytes > 0 ? static_cast<int64_t>(std::floor(bytes * double(reclaimAt)))
+                                          : std::numeric_limits<int64_t>::max(),
+                                std::memory_order_relaxed);
+        if (MemOverBudget()) {
+            pressure();
+        }
+        return true;
+    }
+
+    uint64_t limit() const {
+        return m_limit.load(std::memory_order_relaxed);
+    }
+
+    void stats(XFactory::MemoryBudgetStats& stats) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const int64_t used = g_memLive.load(std::memory_order_relaxed);
+        const int64_t peak = MemPeak();
+        stats.limitBytes = limit();
+        stats.usedBytes = used > 0 ? static_cast<uint64_t>(used) : 0;
+        stats.peakBytes = peak > used ? static_cast<uint64_t>(peak) : stats.usedBytes;
+        stats.reclaims = m_reclaims;
+        stats.reclaimedBytes = m_reclaimedBytes;
+        stats.rejected = m_rejected;
+    }
+
+    void pressure() {
+        if (m_pending.exchange(true, std::memory_order_relaxed)) {
+            return;
+        }
+        // Taking the lock orders this against the governor's wait
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_wake.notify_one();
+    }
+
+    bool admit(uint64_t bytes) {
+        const uint64_t budget = limit();
+        if (budget == 0 || bytes == 0) {
+            return true;
+        }
+        if (fits(bytes, budget)) {
+            return true;
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_reclaimMutex);
+            const int64_t over = used() + static_cast<int64_t>(bytes) - static_cast<int64_t>(budget);
+            if (over > 0) {
+                reclaimLocked(static_cast<uint64_t>(over));
+            }
+        }
+        if (fits(bytes, budget)) {
+            return true;
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            ++m_rejected;
+        }
+        HX_LOG_WARNING("XFactory") << "Memory budget of " << budget << " bytes refuses " << bytes
+                                   << " more (" << used() << " held)";
+        return false;
+    }
+
+    void add(MemReclaimer* reclaimer) {
+        std::lock_guard<std::mutex> lock(m_reclaimMutex);
+        std::vector<MemReclaimer*>::iterator pos = m_reclaimers.begin();
+        while (pos != m_reclaimers.end() && (*pos)->order() <= reclaimer->order()) {
+            ++pos;
+        }
+        m_reclaimers.insert(pos, reclaimer);
+    }
+
+    void remove(MemReclaimer* reclaimer) {
+        std::lock_guard<std::mutex> lock(m_reclaimMutex);
+        m_reclaimers.erase(std::remove(m_reclaimers.begin(), m_reclaimers.end(), reclaimer),
+                           m_reclaimers.end());
+    }
+
+private:
+    Governor()
+        : m_limit(0), m_slack(0), m_pending(false), m_stopping(false),
+          m_reclaims(0), m_reclaimedBytes(0), m_rejected(0) {}
+
+    ~Governor() {
+        // Allocations during exit must not wake a governor that is gone
+        g_memReclaimLevel.store(std::numeric_limits<int64_t>::max(), std::memory_order_relaxed);
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = true;
+        }
+        m_wake.notify_all();
+        if (m_thread.joinable()) {
+            m_thread.join();
+        }
+    }
+
+    static int64_t used() {
+        return g_memLive.load(std::memory_order_relaxed);
+    }
+
+    static bool fits(uint64_t bytes, uint64_t budget) {
+        const int64_t now = used();
+        return now < 0 || static_cast<uint64_t>(now) + bytes <= budget;
+    }
+
+    /// Ask the caches in order until bytes are released; m_reclaimMutex held
+    uint64_t reclaimLocked(uint64_t bytes) {
+        uint64_t released = 0;
+        for (size_t i = 0; i < m_reclaimers.size() && released < bytes; ++i) {
+            released += m_reclaimers[i]->release(bytes - released);
+        }
+        if (released > 0) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            ++m_reclaims;
+            m_reclaimedBytes += released;
+        }
+        return released;
+    }
+
+    void governorThread() {
+        ApplyThreadPolicy(XFactory::THREAD_SERVICE);
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        for (;;) {
+            m_wake.wait(lock, [this] {
+                return m_stopping || m_pending.load(std::memory_order_relaxed);
+            });
+            if (m_stopping) {
+                return;
+            }
+            const int64_t target = g_memReclaimLevel.load(std::memory_order_relaxed) - m_slack;
+            lock.unlock();
+
+            const int64_t over = used() - target;
+            if (over > 0) {
+                std::lock_guard<std::mutex> reclaimLock(m_reclaimMutex);
+                reclaimLocked(static_cast<uint64_t>(over));
+            }
+
+            lock.lock();
+            m_wake.wait_for(lock, RECLAIM_INTERVAL, [this] { return m_stopping; });
+            // Allocations from here on wake the next pass
+            m_pending.store(false, std::memory_order_relaxed);
+            if (MemOverBudget()) {
+                m_pending.store(true, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    std::mutex m_mutex;                 // Budget, counters, governor wake
+    std::condition_variable m_wake;
+    std::atomic<uint64_t> m_limit;
+    int64_t m_slack;
+    std::atomic<bool> m_pending;        ///< A pass is due
+    bool m_stopping;
+    uint64_t m_reclaims;
+    uint64_t m_reclaimedBytes;
+    uint64_t m_rejected;
+    std::thread m_thread;
+
+    std::mutex m_reclaimMutex;          // Held while a cache is asked
+    std::vector<MemReclaimer*> m_reclaimers;    ///< In release order
+};
+
+} // namespace
+
+void MemBudgetPressure() {
+    Governor::instance().pressure();
+}
+
+bool MemBudgetAdmit(uint64_t bytes) {
+    return Governor::instance().admit(bytes);
+}
+
+MemReclaimer::MemReclaimer(Order order, const ReleaseFn& release)
+    : m_order(order), m_release(release), m_added(false) {
+}
+
+MemReclaimer::~MemReclaimer() {
+    remove();
+}
+
+void MemReclaimer::add() {
+    if (!m_added) {
+        Governor::instance().add(this);
+        m_added = true;
+    }
+}
+
+void MemReclaimer::remove() {
+    if (m_added) {
+        Governor::instance().remove(this);
+        m_added = false;
+    }
+}
+
+bool MemBudgetSet(uint64_t bytes, float reclaimAt) {
+    return Governor::instance().set(bytes, reclaimAt);
+}
+
+uint64_t MemBudgetGet() {
+    return Governor::instance().limit();
+}
+
+void MemBudgetGetStats(XFactory::MemoryBudgetStats& stats) {
+    Governor::instance().stats(stats);
+}
+
+} // namespace Internal
+} // namespace HX
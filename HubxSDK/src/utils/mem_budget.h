@@ -0,0 +1,117 @@
+// ============================================================================
+// mem_budget.h
+// ============================================================================
+
+/**
+ * @file mem_budget.h
+ * @brief Node-wide memory budget behind XFactory::SetMemoryBudget()
+ * @version 2.1.0
+ *
+ * This header is INTERNAL to hubx.dll. The budget counts what the memory
+ * profiling accounting counts (mem_profile.h), summed over every tag, so
+ * XImage pixels, Allocate() blocks and the MemCharge owners all count
+ * towards one limit; accounting stays on while a budget is set.
+ *
+ * Two things happen against it:
+ *
+ * - Optional caches register a MemReclaimer. Once the bytes held pass the
+ *   reclaim level a governor thread asks them to release memory, cheapest
+ *   to rebuild first; caches also check MemOverBudget() before growing.
+ * - Objects that allocate a pipeline's buffers at Start() ask
+ *   MemBudgetAdmit() first, and fail to start if the buffers do not fit,
+ *   rather than push the node into swap during a scan.
+ *
+ * Allocations only ever flag the governor, they never release memory
+ * themselves, so a cache's own lock is never taken from inside it.
+ * Without a budget every entry point is one relaxed load.
+ */
+
+#ifndef MEM_BUDGET_H
+#define MEM_BUDGET_H
+
+#include "mem_profile.h"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+
+namespace HX {
+namespace Internal {
+
+/// Bytes above which caches are shrunk (INT64_MAX without a budget)
+extern std::atomic<int64_t> g_memReclaimLevel;
+
+/**
+ * @brief Check whether optional caches should not grow now
+ */
+inline bool MemOverBudget() {
+    return g_memLive.load(std::memory_order_relaxed) >
+           g_memReclaimLevel.load(std::memory_order_relaxed);
+}
+
+/// Wake the governor; called by MemProfileAlloc() above the reclaim level
+void MemBudgetPressure();
+
+/**
+ * @brief Check whether a new pipeline's buffers fit the budget
+ * @param bytes Bytes about to be allocated
+ * @return true if they fit, after shrinking the caches if needed; false
+ *         counts a rejection
+ * @note Shrinks the caches on the calling thread, so do not call it with
+ *       a MemReclaimer's lock held
+ */
+bool MemBudgetAdmit(uint64_t bytes);
+
+/**
+ * @class MemReclaimer
+ * @brief Optional cache the governor shrinks under pressure
+ *
+ * The release function runs on the governor thread or in MemBudgetAdmit(),
+ * one at a time, and takes the cache's own lock. It returns the bytes it
+ * gave up; anything left is rebuilt on demand.
+ */
+class MemReclaimer {
+public:
+    /// Release order, first to last
+    enum Order {
+        RECLAIM_PREVIEW = 0,    ///< Preview copies, refilled by the next frame
+        RECLAIM_VIEW,           ///< Corrected view bands, corrected again
+        RECLAIM_CALIBRATION     ///< Calibration sets, reloaded from file
+    };
+
+    typedef std::function<uint64_t(uint64_t bytes)> ReleaseFn;
+
+    MemReclaimer(Order order, const ReleaseFn& release);
+    ~MemReclaimer();
+
+    /// Start being asked; call once the cache can take release calls
+    void add();
+
+    /**
+     * @brief Stop being asked
+     * @note Returns once no release call is running; call it before the
+     *       cache goes away and without the cache's lock held
+     */
+    void remove();
+
+    Order order() const { return m_order; }
+    uint64_t release(uint64_t bytes) { return m_release(bytes); }
+
+private:
+    Order m_order;
+    ReleaseFn m_release;
+    bool m_added;
+
+    // Non-copyable
+    MemReclaimer(const MemReclaimer&) = delete;
+    MemReclaimer& operator=(const MemReclaimer&) = delete;
+};
+
+// XFactory entry points
+bool MemBudgetSet(uint64_t bytes, float reclaimAt);
+uint64_t MemBudgetGet();
+void MemBudgetGetStats(XFactory::MemoryBudgetStats& stats);
+
+} // namespace Internal
+} // namespace HX
+
+#endif // MEM_BUDGET_H
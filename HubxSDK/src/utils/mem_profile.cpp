@@ -0,0 +1,164 @@
+// ============================================================================
+// mem_profile.cpp
+// ============================================================================
+
+/**
+ * @file mem_profile.cpp
+ * @brief Per-tag live bytes, high-water marks and allocation rates
+ * @version 2.1.0
+ */
+
+#include "mem_profile.h"
+#include "mem_budget.h"
+#include <chrono>
+#include <mutex>
+
+namespace HX {
+namespace Internal {
+
+std::atomic<bool> g_memProfiling(false);
+std::atomic<int64_t> g_memLive(0);
+
+namespace {
+
+/// One tag; updates are relaxed, a snapshot may mix neighbouring updates
+struct TagCounters {
+    std::atomic<int64_t> live;
+    std::atomic<int64_t> highWater;
+    std::atomic<uint64_t> allocations;
+    std::atomic<uint64_t> allocatedBytes;
+};
+
+TagCounters g_tags[XFactory::MEM_TAG_COUNT];
+
+/// Start of the measurement window, steady_clock ticks
+std::atomic<int64_t> g_windowStart(0);
+
+std::atomic<int64_t> g_memPeak(0);
+
+/// Who wants accounting on: profiling, the budget
+std::mutex g_switchMutex;
+bool g_profilingEnabled = false;
+bool g_accountingHeld = false;
+
+thread_local int t_currentTag = -1;
+
+int64_t nowTicks() {
+    return std::chrono::steady_clock::now().time_since_epoch().count();
+}
+
+bool validTag(XFactory::MemoryTag tag) {
+    return tag >= 0 && tag < XFactory::MEM_TAG_COUNT;
+}
+
+void raiseTo(std::atomic<int64_t>& high, int64_t value) {
+    int64_t seen = high.load(std::memory_order_relaxed);
+    while (value > seen && !high.compare_exchange_weak(seen, value, std::memory_order_relaxed)) {
+    }
+}
+
+/// Called with g_switchMutex held
+void updateSwitch() {
+    g_memProfiling.store(g_profilingEnabled || g_accountingHeld, std::memory_order_relaxed);
+}
+
+} // namespace
+
+void MemProfileAlloc(XFactory::MemoryTag tag, uint64_t bytes) {
+    if (!validTag(tag)) {
+        return;
+    }
+    TagCounters& c = g_tags[tag];
+    const int64_t live = c.live.fetch_add(static_cast<int64_t>(bytes), std::memory_order_relaxed) +
+                         static_cast<int64_t>(bytes);
+    raiseTo(c.highWater, live);
+    c.allocations.fetch_add(1, std::memory_order_relaxed);
+    c.allocatedBytes.fetch_add(bytes, std::memory_order_relaxed);
+
+    const int64_t total = g_memLive.fetch_add(static_cast<int64_t>(bytes), std::memory_order_relaxed) +
+                          static_cast<int64_t>(bytes);
+    raiseTo(g_memPeak, total);
+    if (total > g_memReclaimLevel.load(std::memory_order_relaxed)) {
+        MemBudgetPressure();
+    }
+}
+
+void MemProfileFree(XFactory::MemoryTag tag, uint64_t bytes) {
+    if (validTag(tag)) {
+        g_tags[tag].live.fetch_sub(static_cast<int64_t>(bytes), std::memory_order_relaxed);
+        g_memLive.fetch_sub(static_cast<int64_t>(bytes), std::memory_order_relaxed);
+    }
+}
+
+int64_t MemPeak() {
+    return g_memPeak.load(std::memory_order_relaxed);
+}
+
+void MemResetPeak() {
+    g_memPeak.store(g_memLive.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+void MemHoldAccounting(bool hold) {
+    std::lock_guard<std::mutex> lock(g_switchMutex);
+    g_accountingHeld = hold;
+    updateSwitch();
+}
+
+XFactory::MemoryTag MemCurrentTag(XFactory::MemoryTag fallback) {
+    return t_currentTag >= 0 ? static_cast<XFactory::MemoryTag>(t_currentTag) : fallback;
+}
+
+MemTagScope::MemTagScope(XFactory::MemoryTag tag)
+    : m_previous(t_currentTag) {
+    t_currentTag = tag;
+}
+
+MemTagScope::~MemTagScope() {
+    t_currentTag = m_previous;
+}
+
+void MemSetProfiling(bool enable) {
+    std::lock_guard<std::mutex> lock(g_switchMutex);
+    if (enable && !g_profilingEnabled) {
+        MemResetStats();
+    }
+    g_profilingEnabled = enable;
+    updateSwitch();
+}
+
+bool MemGetProfiling() {
+    std::lock_guard<std::mutex> lock(g_switchMutex);
+    return g_profilingEnabled;
+}
+
+bool MemGetStats(XFactory::MemoryTag tag, XFactory::MemoryStats& stats) {
+    if (!validTag(tag)) {
+        return false;
+    }
+    const TagCounters& c = g_tags[tag];
+    const int64_t live = c.live.load(std::memory_order_relaxed);
+    const int64_t high = c.highWater.load(std::memory_order_relaxed);
+    stats.liveBytes = live > 0 ? static_cast<uint64_t>(live) : 0;
+    stats.highWaterBytes = high > live ? static_cast<uint64_t>(high) : stats.liveBytes;
+    stats.allocations = c.allocations.load(std::memory_order_relaxed);
+    stats.allocatedBytes = c.allocatedBytes.load(std::memory_order_relaxed);
+
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::duration(
+        nowTicks() - g_windowStart.load(std::memory_order_relaxed))).count();
+    stats.allocationsPerSecond = seconds > 0.0 ? stats.allocations / seconds : 0.0;
+    stats.bytesPerSecond = seconds > 0.0 ? stats.allocatedBytes / seconds : 0.0;
+    return true;
+}
+
+void MemResetStats() {
+    for (int t = 0; t < XFactory::MEM_TAG_COUNT; ++t) {
+        TagCounters& c = g_tags[t];
+        c.highWater.store(c.live.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        c.allocations.store(0, std::memory_order_relaxed);
+        c.allocatedBytes.store(0, std::memory_order_relaxed);
+    }
+    g_windowStart.store(nowTicks(), std::memory_order_relaxed);
+}
+
+} // namespace Internal
+} // namespace HX
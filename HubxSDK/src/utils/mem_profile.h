@@ -0,0 +1,124 @@
+// ============================================================================
+// mem_profile.h
+// ============================================================================
+
+/**
+ * @file mem_profile.h
+ * @brief Per-subsystem memory accounting behind XFactory::SetMemoryProfiling()
+ * @version 2.1.0
+ *
+ * This header is INTERNAL to hubx.dll. Buffers are attributed in one of
+ * two ways:
+ *
+ * - XImage pixels and XFactory blocks are charged to the tag of the
+ *   innermost MemTagScope on the allocating thread (MEM_IMAGE and
+ *   MEM_OTHER outside any scope), and credited back when freed;
+ * - owners of std::vector and new[] tables keep a MemCharge and set() it
+ *   to their current footprint after each resize.
+ *
+ * Either way a buffer charged while profiling was on is credited exactly
+ * once, so switching the mode never drives a tag negative. With profiling
+ * off every entry point is one relaxed load.
+ *
+ * MemProfiling() is the accounting switch: it is on while profiling is
+ * enabled or a memory budget (mem_budget.h) holds it on.
+ */
+
+#ifndef MEM_PROFILE_H
+#define MEM_PROFILE_H
+
+#include "xfactory.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace HX {
+namespace Internal {
+
+extern std::atomic<bool> g_memProfiling;
+
+/// Bytes held under every tag
+extern std::atomic<int64_t> g_memLive;
+
+inline bool MemProfiling() {
+    return g_memProfiling.load(std::memory_order_relaxed);
+}
+
+/// Record an allocation / free of bytes under tag
+void MemProfileAlloc(XFactory::MemoryTag tag, uint64_t bytes);
+void MemProfileFree(XFactory::MemoryTag tag, uint64_t bytes);
+
+/// Tag for allocations on this thread that have no owner of their own
+XFactory::MemoryTag MemCurrentTag(XFactory::MemoryTag fallback);
+
+/**
+ * @brief Attributes allocations on this thread to a tag while in scope
+ */
+class MemTagScope {
+public:
+    explicit MemTagScope(XFactory::MemoryTag tag);
+    ~MemTagScope();
+
+private:
+    int m_previous;
+
+    MemTagScope(const MemTagScope&) = delete;
+    MemTagScope& operator=(const MemTagScope&) = delete;
+};
+
+/**
+ * @brief Bytes one owner holds under a tag
+ * @note Not synchronized: the owner calls set() from one thread at a time
+ */
+class MemCharge {
+public:
+    explicit MemCharge(XFactory::MemoryTag tag) : m_tag(tag), m_bytes(0) {}
+    ~MemCharge() { set(0); }
+
+    /// Set the owner's footprint; growth counts as one allocation
+    void set(uint64_t bytes) {
+        if (m_bytes == 0 && !MemProfiling()) {
+            return;
+        }
+        if (!MemProfiling()) {
+            bytes = 0;
+        }
+        if (bytes > m_bytes) {
+            MemProfileAlloc(m_tag, bytes - m_bytes);
+        } else if (bytes < m_bytes) {
+            MemProfileFree(m_tag, m_bytes - bytes);
+        }
+        m_bytes = bytes;
+    }
+
+private:
+    XFactory::MemoryTag m_tag;
+    uint64_t m_bytes;
+
+    MemCharge(const MemCharge&) = delete;
+    MemCharge& operator=(const MemCharge&) = delete;
+};
+
+/// Heap bytes held by a vector
+template <typename Vector>
+inline uint64_t MemBytes(const Vector& v) {
+    return static_cast<uint64_t>(v.capacity()) * sizeof(typename Vector::value_type);
+}
+
+/// Most bytes held under every tag since MemResetPeak()
+int64_t MemPeak();
+void MemResetPeak();
+
+/// Keep accounting on without profiling having been enabled
+void MemHoldAccounting(bool hold);
+
+// XFactory entry points
+void MemSetProfiling(bool enable);
+bool MemGetProfiling();
+bool MemGetStats(XFactory::MemoryTag tag, XFactory::MemoryStats& stats);
+void MemResetStats();
+
+} // namespace Internal
+} // namespace HX
+
+#endif // MEM_PROFILE_H
@@ -0,0 +1,703 @@
+// ============================================================================
+// metrics.cpp
+// ============================================================================
+
+/**
+ * @file metrics.cpp
+ * @brief Metrics registry, Prometheus/JSON rendering and HTTP endpoint
+ * @version 2.1.0
+ */
+
+#include "metrics.h"
+#include "latency_trace.h"
+#include "logger.h"
+#include "mem_budget.h"
+#include "overload.h"
+#include "perf_counters.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <cerrno>
+#include <netinet/in.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#endif
+
+namespace HX {
+namespace Internal {
+
+namespace {
+
+#ifdef _WIN32
+typedef SOCKET SocketHandle;
+const SocketHandle NO_SOCKET = INVALID_SOCKET;
+#else
+typedef int SocketHandle;
+const SocketHandle NO_SOCKET = -1;
+#endif
+
+/// How often the server loop checks for stopServer()
+const long ACCEPT_POLL_MS = 100;
+
+/// A scraper that does not finish its request in time is dropped
+const long REQUEST_TIMEOUT_MS = 2000;
+const size_t MAX_REQUEST = 8192;
+
+void closeSocket(SocketHandle s) {
+#ifdef _WIN32
+    closesocket(s);
+#else
+    close(s);
+#endif
+}
+
+bool sendAll(SocketHandle s, const char* data, size_t size) {
+#ifdef MSG_NOSIGNAL
+    const int flags = MSG_NOSIGNAL;     // A closed peer must not raise SIGPIPE
+#else
+    const int flags = 0;
+#endif
+    while (size > 0) {
+        const int chunk = static_cast<int>(std::min<size_t>(size, 1 << 20));
+        const int sent = static_cast<int>(send(s, data, chunk, flags));
+        if (sent <= 0) {
+#ifndef _WIN32
+            if (sent < 0 && errno == EINTR) {
+                continue;
+            }
+#endif
+            return false;
+        }
+        data += sent;
+        size -= static_cast<size_t>(sent);
+    }
+    return true;
+}
+
+const char* typeName(MetricsWriter::Type type) {
+    switch (type) {
+        case MetricsWriter::TYPE_COUNTER:   return "counter";
+        case MetricsWriter::TYPE_GAUGE:     return "gauge";
+        case MetricsWriter::TYPE_HISTOGRAM: return "histogram";
+        default:                            return "summary";
+    }
+}
+
+/// Integers exactly, everything else with 9 significant digits
+std::string number(double v) {
+    if (std::isinf(v)) {
+        return v > 0 ? "+Inf" : "-Inf";
+    }
+    if (std::isnan(v)) {
+        return "NaN";
+    }
+    char text[32];
+    if (v == std::floor(v) && std::fabs(v) < 1e15) {
+        snprintf(text, sizeof(text), "%.0f", v);
+    } else {
+        snprintf(text, sizeof(text), "%.9g", v);
+    }
+    return text;
+}
+
+/// Label values: backslash, quote and newline escaped
+std::string escapeLabel(const std::string& value) {
+    std::string out;
+    out.reserve(value.size());
+    for (size_t i = 0; i < value.size(); ++i) {
+        const char c = value[i];
+        if (c == '\\' || c == '"') {
+            out += '\\';
+            out += c;
+        } else if (c == '\n') {
+            out += "\\n";
+        } else {
+            out += c;
+        }
+    }
+    return out;
+}
+
+std::string escapeJson(const std::string& value) {
+    std::string out;
+    out.reserve(value.size() + 2);
+    out += '"';
+    for (size_t i = 0; i < value.size(); ++i) {
+        const unsigned char c = static_cast<unsigned char>(value[i]);
+        if (c == '\\' || c == '"') {
+            out += '\\';
+            out += static_cast<char>(c);
+        } else if (c < 0x20) {
+            char code[8];
+            snprintf(code, sizeof(code), "\\u%04x", c);
+            out += code;
+        } else {
+            out += static_cast<char>(c);
+        }
+    }
+    out += '"';
+    return out;
+}
+
+/// JSON has no infinity, so the last histogram bound is a string
+std::string jsonNumber(double v) {
+    return std::isfinite(v) ? number(v) : "\"" + number(v) + "\"";
+}
+
+/// {a="x",b="y",extra="v"}, nothing for an empty set
+std::string braces(const MetricLabels& labels, const char* extraName = nullptr,
+                   const std::string& extraValue = std::string()) {
+    std::string text = labels.text();
+    if (extraName) {
+        if (!text.empty()) {
+            text += ',';
+        }
+        text += std::string(extraName) + "=\"" + extraValue + "\"";
+    }
+    return text.empty() ? text : "{" + text + "}";
+}
+
+/**
+ * @brief Trace percentiles, scraped while tracing has samples
+ */
+class TraceCollector : public MetricsCollector {
+public:
+    void collectMetrics(MetricsWriter& out) override {
+        static const char* const stages[] = {
+            "ring", "line", "assembly", "end_to_end", "sink",
+            "xog_apply", "xmog_apply", "pipeline_run"
+        };
+        static const double quantiles[] = { 0.5, 0.99, 0.999 };
+        for (int s = 0; s < XFactory::TRACE_STAGE_COUNT; ++s) {
+            XFactory::TraceStats stats;
+            if (!TraceGetStats(static_cast<XFactory::TraceStage>(s), stats) || stats.count == 0) {
+                continue;
+            }
+            const double values[] = {
+                stats.p50Ns * 1e-9, stats.p99Ns * 1e-9, stats.p999Ns * 1e-9
+            };
+            out.summary("hubx_latency_seconds",
+                        "Stage latency from XFactory tracing (SetTracing)",
+                        MetricLabels("stage", stages[s]), quantiles, values, 3,
+                        stats.count, static_cast<double>(stats.meanNs) * 1e-9 * stats.count);
+        }
+    }
+};
+
+/**
+ * @brief Per-tag memory accounting while it is on, and the memory budget
+ */
+class MemoryCollector : public MetricsCollector {
+public:
+    void collectMetrics(MetricsWriter& out) override {
+        if (!MemProfiling()) {
+            return;
+        }
+        static const char* const tags[] = {
+            "frame_pool", "receive", "calibration", "display", "recorder", "image", "other"
+        };
+        for (int t = 0; t < XFactory::MEM_TAG_COUNT; ++t) {
+            XFactory::MemoryStats stats;
+            if (!MemGetStats(static_cast<XFactory::MemoryTag>(t), stats)) {
+                continue;
+            }
+            const MetricLabels labels("tag", tags[t]);
+            out.gauge("hubx_memory_live_bytes", "Bytes held per subsystem (SetMemoryProfiling)",
+                      labels, static_cast<double>(stats.liveBytes));
+            out.gauge("hubx_memory_high_water_bytes", "Most bytes held since the last reset",
+                      labels, static_cast<double>(stats.highWaterBytes));
+            out.counter("hubx_memory_allocations_total", "Allocations since the last reset",
+                        labels, stats.allocations);
+            out.counter("hubx_memory_allocated_bytes_total", "Bytes allocated since the last reset",
+                        labels, stats.allocatedBytes);
+        }
+
+        XFactory::MemoryBudgetStats budget;
+        MemBudgetGetStats(budget);
+        if (budget.limitBytes == 0) {
+            return;
+        }
+        out.gauge("hubx_memory_budget_bytes", "Memory budget (SetMemoryBudget)", MetricLabels(),
+                  static_cast<double>(budget.limitBytes));
+        out.gauge("hubx_memory_budget_used_bytes", "Bytes held against the budget", MetricLabels(),
+                  static_cast<double>(budget.usedBytes));
+        out.counter("hubx_memory_reclaimed_bytes_total", "Bytes optional caches gave up for the budget",
+                    MetricLabels(), budget.reclaimedBytes);
+        out.counter("hubx_memory_rejected_total", "Starts refused by the memory budget",
+                    MetricLabels(), budget.rejected);
+    }
+};
+
+/**
+ * @brief Hardware counter totals, scraped while stages have samples
+ */
+class PerfCollector : public MetricsCollector {
+public:
+    void collectMetrics(MetricsWriter& out) override {
+        static const char* const stages[] = {
+            "frame_assembly", "sink", "xog_apply", "xmog_apply", "pipeline_run"
+        };
+        for (int s = 0; s < XFactory::PERF_STAGE_COUNT; ++s) {
+            XFactory::PerfStats stats;
+            if (!PerfGetStats(static_cast<XFactory::PerfStage>(s), stats) || stats.samples == 0) {
+                continue;
+            }
+            const MetricLabels labels("stage", stages[s]);
+            out.counter("hubx_perf_samples_total", "Regions measured by perf counters (SetPerfCounters)",
+                        labels, stats.samples);
+            out.counter("hubx_perf_cycles_total", "CPU cycles in user space", labels, stats.cycles);
+            out.counter("hubx_perf_instructions_total", "Instructions retired in user space",
+                        labels, stats.instructions);
+            out.counter("hubx_perf_llc_misses_total", "Last-level cache misses", labels, stats.llcMisses);
+        }
+    }
+};
+
+/**
+ * @brief Overload level, backlog and shed work (SetOverloadPolicy)
+ */
+class OverloadCollector : public MetricsCollector {
+public:
+    void collectMetrics(MetricsWriter& out) override {
+        XFactory::OverloadStats stats;
+        OverloadGetStats(stats);
+        out.gauge("hubx_overload_level", "Degradation level (0 none, 1 preview, 2 optional, 3 frames)",
+                  MetricLabels(), stats.level);
+        out.gauge("hubx_overload_backlog", "Fill of the fullest pipeline buffer (0-1)",
+                  MetricLabels(), stats.backlog);
+        out.counter("hubx_overload_shed_total", "Work shed by the overload policy",
+                    MetricLabels("stage", "preview"), stats.previewDropped);
+        out.counter("hubx_overload_shed_total", "Work shed by the overload policy",
+                    MetricLabels("stage", "optional"), stats.stagesSkipped);
+        out.counter("hubx_overload_shed_total", "Work shed by the overload policy",
+                    MetricLabels("stage", "frames"), stats.framesDropped);
+    }
+};
+
+} // namespace
+
+// ============================================================================
+// MetricLabels / MetricsWriter
+// ============================================================================
+
+std::string MetricLabels::text() const {
+    std::string text;
+    for (size_t i = 0; i < m_labels.size(); ++i) {
+        if (i > 0) {
+            text += ',';
+        }
+        text += m_labels[i].first + "=\"" + escapeLabel(m_labels[i].second) + "\"";
+    }
+    return text;
+}
+
+MetricsWriter::Sample& MetricsWriter::add(const char* name, const char* help, Type type,
+                                          const MetricLabels& labels) {
+    Family& family = m_families[name];
+    if (family.samples.empty()) {
+        family.type = type;
+        family.help = help;
+    }
+    family.samples.push_back(Sample());
+    Sample& sample = family.samples.back();
+    sample.labels = labels;
+    sample.value = 0;
+    sample.sum = 0;
+    return sample;
+}
+
+void MetricsWriter::counter(const char* name, const char* help, const MetricLabels& labels,
+                            uint64_t value) {
+    add(name, help, TYPE_COUNTER, labels).value = static_cast<double>(value);
+}
+
+void MetricsWriter::gauge(const char* name, const char* help, const MetricLabels& labels,
+                          double value) {
+    add(name, help, TYPE_GAUGE, labels).value = value;
+}
+
+void MetricsWriter::histogram(const char* name, const char* help, const MetricLabels& labels,
+                              const double* bounds, const uint64_t* buckets, uint32_t boundCount,
+                              double sum) {
+    Sample& sample = add(name, help, TYPE_HISTOGRAM, labels);
+    uint64_t cumulative = 0;
+    for (uint32_t b = 0; b < boundCount; ++b) {
+        cumulative += buckets[b];
+        sample.points.push_back(std::make_pair(bounds[b], static_cast<double>(cumulative)));
+    }
+    cumulative += buckets[boundCount];
+    sample.points.push_back(std::make_pair(HUGE_VAL, static_cast<double>(cumulative)));
+    sample.value = static_cast<double>(cumulative);
+    sample.sum = sum;
+}
+
+void MetricsWriter::summary(const char* name, const char* help, const MetricLabels& labels,
+                            const double* quantiles, const double* values, uint32_t quantileCount,
+                            uint64_t count, double sum) {
+    Sample& sample = add(name, help, TYPE_SUMMARY, labels);
+    for (uint32_t q = 0; q < quantileCount; ++q) {
+        sample.points.push_back(std::make_pair(quantiles[q], values[q]));
+    }
+    sample.value = static_cast<double>(count);
+    sample.sum = sum;
+}
+
+std::string MetricsWriter::prometheus() const {
+    std::string out;
+    for (std::map<std::string, Family>::const_iterator it = m_families.begin();
+         it != m_families.end(); ++it) {
+        const std::string& name = it->first;
+        const Family& family = it->second;
+        std::string help;
+        for (size_t i = 0; i < family.help.size(); ++i) {
+            help += family.help[i] == '\n' ? std::string("\\n") : std::string(1, family.help[i]);
+        }
+        out += "# HELP " + name + " " + help + "\n";
+        out += "# TYPE " + name + " " + typeName(family.type) + "\n";
+
+        for (size_t s = 0; s < family.samples.size(); ++s) {
+            const Sample& sample = family.samples[s];
+            if (family.type == TYPE_COUNTER || family.type == TYPE_GAUGE) {
+                out += name + braces(sample.labels) + " " + number(sample.value) + "\n";
+                continue;
+            }
+            const bool histogram = family.type == TYPE_HISTOGRAM;
+            for (size_t p = 0; p < sample.points.size(); ++p) {
+                const std::string point = number(sample.points[p].first);
+                out += name + (histogram ? "_bucket" : "") +
+                       braces(sample.labels, histogram ? "le" : "quantile", point) + " " +
+                       number(sample.points[p].second) + "\n";
+            }
+            out += name + "_sum" + braces(sample.labels) + " " + number(sample.sum) + "\n";
+            out += name + "_count" + braces(sample.labels) + " " + number(sample.value) + "\n";
+        }
+    }
+    return out;
+}
+
+std::string MetricsWriter::json() const {
+    std::string out = "{\"metrics\":[";
+    bool firstFamily = true;
+    for (std::map<std::string, Family>::const_iterator it = m_families.begin();
+         it != m_families.end(); ++it) {
+        const Family& family = it->second;
+        out += firstFamily ? "\n" : ",\n";
+        firstFamily = false;
+        out += "{\"name\":" + escapeJson(it->first) +
+               ",\"type\":\"" + typeName(family.type) + "\"" +
+               ",\"help\":" + escapeJson(family.help) + ",\"samples\":[";
+
+        for (size_t s = 0; s < family.samples.size(); ++s) {
+            const Sample& sample = family.samples[s];
+            out += s ? "," : "";
+            out += "{\"labels\":{";
+            const std::vector<std::pair<std::string, std::string> >& labels = sample.labels.labels();
+            for (size_t l = 0; l < labels.size(); ++l) {
+                out += (l ? "," : "") + escapeJson(labels[l].first) + ":" + escapeJson(labels[l].second);
+            }
+            out += "}";
+            if (family.type == TYPE_COUNTER || family.type == TYPE_GAUGE) {
+                out += ",\"value\":" + jsonNumber(sample.value) + "}";
+                continue;
+            }
+            const bool histogram = family.type == TYPE_HISTOGRAM;
+            out += ",\"count\":" + number(sample.value) + ",\"sum\":" + jsonNumber(sample.sum);
+            out += histogram ? ",\"buckets\":[" : ",\"quantiles\":[";
+            for (size_t p = 0; p < sample.points.size(); ++p) {
+                out += p ? "," : "";
+                out += histogram ? "{\"le\":" : "{\"quantile\":";
+                out += jsonNumber(sample.points[p].first);
+                out += histogram ? ",\"count\":" : ",\"value\":";
+                out += jsonNumber(sample.points[p].second) + "}";
+            }
+            out += "]}";
+        }
+        out += "]}";
+    }
+    out += "\n]}\n";
+    return out;
+}
+
+bool MetricsWriter::find(const std::string& name, double& value) const {
+    std::map<std::string, Family>::const_iterator it = m_families.find(name);
+    if (it == m_families.end()) {
+        return false;
+    }
+    value = 0;
+    for (size_t s = 0; s < it->second.samples.size(); ++s) {
+        value += it->second.samples[s].value;
+    }
+    return true;
+}
+
+// ============================================================================
+// MetricsRegistry
+// ============================================================================
+
+MetricsRegistry& MetricsRegistry::instance() {
+    // Never destroyed: components with static storage unregister after
+    // main() returns
+    static MetricsRegistry* registry = new MetricsRegistry();
+    return *registry;
+}
+
+MetricsRegistry::MetricsRegistry()
+    : m_instances(0)
+    , m_listen(static_cast<intptr_t>(NO_SOCKET))
+    , m_serving(false)
+    , m_port(0)
+{
+}
+
+MetricCounter& MetricsRegistry::counter(const char* name, const char* help,
+                                        const MetricLabels& labels) {
+    const std::string key = std::string(name) + "{" + labels.text() + "}";
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::unique_ptr<Registered>& metric = m_metrics[key];
+    if (!metric) {
+        metric.reset(new Registered());
+        metric->name = name;
+        metric->help = help;
+        metric->labels = labels;
+        metric->isCounter = true;
+    }
+    return metric->counter;
+}
+
+MetricGauge& MetricsRegistry::gauge(const char* name, const char* help,
+                                    const MetricLabels& labels) {
+    const std::string key = std::string(name) + "{" + labels.text() + "}";
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::unique_ptr<Registered>& metric = m_metrics[key];
+    if (!metric) {
+        metric.reset(new Registered());
+        metric->name = name;
+        metric->help = help;
+        metric->labels = labels;
+        metric->isCounter = false;
+    }
+    return metric->gauge;
+}
+
+void MetricsRegistry::addCollector(MetricsCollector* collector) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (std::find(m_collectors.begin(), m_collectors.end(), collector) == m_collectors.end()) {
+        m_collectors.push_back(collector);
+    }
+}
+
+void MetricsRegistry::removeCollector(MetricsCollector* collector) {
+    // Scrapes hold the lock while collecting, so none is inside collector after this
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_collectors.erase(std::remove(m_collectors.begin(), m_collectors.end(), collector),
+                       m_collectors.end());
+}
+
+uint32_t MetricsRegistry::nextInstance() {
+    return m_instances.fetch_add(1, std::memory_order_relaxed);
+}
+
+void MetricsRegistry::collect(MetricsWriter& out) {
+    static TraceCollector trace;
+    static MemoryCollector memory;
+    static PerfCollector perf;
+    static OverloadCollector overload;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (std::map<std::string, std::unique_ptr<Registered> >::const_iterator it = m_metrics.begin();
+         it != m_metrics.end(); ++it) {
+        const Registered& metric = *it->second;
+        if (metric.isCounter) {
+            out.counter(metric.name.c_str(), metric.help.c_str(), metric.labels, metric.counter.value());
+        } else {
+            out.gauge(metric.name.c_str(), metric.help.c_str(), metric.labels,
+                      static_cast<double>(metric.gauge.value()));
+        }
+    }
+    for (size_t c = 0; c < m_collectors.size(); ++c) {
+        m_collectors[c]->collectMetrics(out);
+    }
+    trace.collectMetrics(out);
+    memory.collectMetrics(out);
+    perf.collectMetrics(out);
+    overload.collectMetrics(out);
+}
+
+std::string MetricsRegistry::render(XFactory::MetricsFormat format) {
+    MetricsWriter out;
+    collect(out);
+    return format == XFactory::METRICS_JSON ? out.json() : out.prometheus();
+}
+
+bool MetricsRegistry::value(const std::string& name, double& value) {
+    MetricsWriter out;
+    collect(out);
+    return out.find(name, value);
+}
+
+bool MetricsRegistry::startServer(uint16_t port) {
+    std::lock_guard<std::mutex> lock(m_serverMutex);
+    if (m_serving) {
+        return true;
+    }
+
+#ifdef _WIN32
+    WSADATA wsa;
+    if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0) {
+        HX_LOG_WARNING("XFactory") << "Metrics server: WSAStartup failed";
+        return false;
+    }
+#endif
+
+    SocketHandle s = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (s == NO_SOCKET) {
+        HX_LOG_WARNING("XFactory") << "Metrics server: cannot create socket";
+#ifdef _WIN32
+        WSACleanup();
+#endif
+        return false;
+    }
+    const int reuse = 1;
+    setsockopt(s, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&reuse), sizeof(reuse));
+
+    sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(port);
+    socklen_t length = sizeof(addr);
+    if (bind(s, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0 ||
+        listen(s, 8) != 0 ||
+        getsockname(s, reinterpret_cast<sockaddr*>(&addr), &length) != 0) {
+        HX_LOG_WARNING("XFactory") << "Metrics server: cannot listen on port " << port;
+        closeSocket(s);
+#ifdef _WIN32
+        WSACleanup();
+#endif
+        return false;
+    }
+
+    m_listen = static_cast<intptr_t>(s);
+    m_port = ntohs(addr.sin_port);
+    m_serving = true;
+    m_thread = std::thread(&MetricsRegistry::serverThread, this);
+
+    HX_LOG_INFO("XFactory") << "Metrics server listening on port " << m_port;
+    return true;
+}
+
+void MetricsRegistry::stopServer() {
+    std::lock_guard<std::mutex> lock(m_serverMutex);
+    if (!m_serving) {
+        return;
+    }
+    m_serving = false;
+    m_thread.join();
+
+    closeSocket(static_cast<SocketHandle>(m_listen));
+    m_listen = static_cast<intptr_t>(NO_SOCKET);
+    m_port = 0;
+#ifdef _WIN32
+    WSACleanup();
+#endif
+
+    HX_LOG_INFO("XFactory") << "Metrics server stopped";
+}
+
+uint16_t MetricsRegistry::serverPort() const {
+    return m_port;
+}
+
+void MetricsRegistry::serverThread() {
+    const SocketHandle listening = static_cast<SocketHandle>(m_listen);
+    while (m_serving) {
+        fd_set readable;
+        FD_ZERO(&readable);
+        FD_SET(listening, &readable);
+        timeval timeout;
+        timeout.tv_sec = 0;
+        timeout.tv_usec = ACCEPT_POLL_MS * 1000;
+        const int ready = select(static_cast<int>(listening) + 1, &readable, nullptr, nullptr, &timeout);
+        if (ready <= 0 || !m_serving) {
+            continue;
+        }
+
+        SocketHandle s = accept(listening, nullptr, nullptr);
+        if (s == NO_SOCKET) {
+            continue;
+        }
+        serve(static_cast<intptr_t>(s));
+        closeSocket(s);
+    }
+}
+
+void MetricsRegistry::serve(intptr_t client) {
+    const SocketHandle s = static_cast<SocketHandle>(client);
+
+    // Scrapes are answered in turn, so a stalled client must not hold the loop
+#ifdef _WIN32
+    const DWORD wait = REQUEST_TIMEOUT_MS;
+#else
+    timeval wait;
+    wait.tv_sec = REQUEST_TIMEOUT_MS / 1000;
+    wait.tv_usec = (REQUEST_TIMEOUT_MS % 1000) * 1000;
+#endif
+    setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<const char*>(&wait), sizeof(wait));
+    setsockopt(s, SOL_SOCKET, SO_SNDTIMEO, reinterpret_cast<const char*>(&wait), sizeof(wait));
+
+    std::string request;
+    char buffer[1024];
+    while (request.find("\r\n\r\n") == std::string::npos && request.size() < MAX_REQUEST) {
+        const int got = static_cast<int>(recv(s, buffer, sizeof(buffer), 0));
+        if (got <= 0) {
+            return;
+        }
+        request.append(buffer, static_cast<size_t>(got));
+    }
+
+    // Request line: METHOD SP target SP version
+    const size_t methodEnd = request.find(' ');
+    const size_t targetEnd = methodEnd == std::string::npos ? methodEnd : request.find(' ', methodEnd + 1);
+    std::string status = "200 OK";
+    std::string type = "text/plain; version=0.0.4; charset=utf-8";
+    std::string body;
+    if (targetEnd == std::string::npos) {
+        status = "400 Bad Request";
+        body = "Bad request\n";
+    } else {
+        const std::string method = request.substr(0, methodEnd);
+        std::string target = request.substr(methodEnd + 1, targetEnd - methodEnd - 1);
+        target = target.substr(0, target.find('?'));
+        if (method != "GET" && method != "HEAD") {
+            status = "405 Method Not Allowed";
+            body = "Only GET is supported\n";
+        } else if (target == "/metrics") {
+            body = method == "GET" ? render(XFactory::METRICS_PROMETHEUS) : std::string();
+        } else if (target == "/metrics.json") {
+            type = "application/json";
+            body = method == "GET" ? render(XFactory::METRICS_JSON) : std::string();
+        } else {
+            status = "404 Not Found";
+            body = "Try /metrics or /metrics.json\n";
+        }
+    }
+
+    const std::string header = "HTTP/1.1 " + status + "\r\n"
+                               "Content-Type: " + type + "\r\n"
+                               "Content-Length: " + std::to_string(body.size()) + "\r\n"
+                               "Connection: close\r\n\r\n";
+    if (sendAll(s, header.data(), header.size())) {
+        sendAll(s, body.data(), body.size());
+    }
+}
+
+} // namespace Internal
+} // namespace HX
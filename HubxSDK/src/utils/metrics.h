@@ -0,0 +1,227 @@
+// ============================================================================
+// metrics.h
+// ============================================================================
+
+/**
+ * @file metrics.h
+ * @brief Process-wide metrics registry behind XFactory::GetMetrics()
+ * @version 2.1.0
+ *
+ * This header is INTERNAL to hubx.dll. Components publish in one of two
+ * ways:
+ *
+ * - values the component does not count yet live in the registry:
+ *   counter() and gauge() return a metric updated with one relaxed atomic
+ *   operation, which stays valid for the life of the process;
+ * - counters a component already keeps are read on demand: it registers
+ *   a MetricsCollector while open and adds its values to the scrape.
+ *
+ * Registration and scrapes take the registry mutex, updates never do.
+ * removeCollector() returns only once no scrape is inside the collector,
+ * so a component may call it from its destructor.
+ */
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include "xfactory.h"
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace HX {
+namespace Internal {
+
+/**
+ * @brief Label set of one sample, in the order given
+ */
+class MetricLabels {
+public:
+    MetricLabels() {}
+    MetricLabels(const std::string& name, const std::string& value) { add(name, value); }
+
+    MetricLabels& add(const std::string& name, const std::string& value) {
+        m_labels.push_back(std::make_pair(name, value));
+        return *this;
+    }
+
+    const std::vector<std::pair<std::string, std::string> >& labels() const { return m_labels; }
+
+    /// Registry key and Prometheus form: a="x",b="y"
+    std::string text() const;
+
+private:
+    std::vector<std::pair<std::string, std::string> > m_labels;
+};
+
+/**
+ * @brief Monotonic count
+ */
+class MetricCounter {
+public:
+    MetricCounter() : m_value(0) {}
+    void add(uint64_t n = 1) { m_value.fetch_add(n, std::memory_order_relaxed); }
+    uint64_t value() const { return m_value.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<uint64_t> m_value;
+};
+
+/**
+ * @brief Value that goes up and down
+ */
+class MetricGauge {
+public:
+    MetricGauge() : m_value(0) {}
+    void set(int64_t v) { m_value.store(v, std::memory_order_relaxed); }
+    void add(int64_t n) { m_value.fetch_add(n, std::memory_order_relaxed); }
+    int64_t value() const { return m_value.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<int64_t> m_value;
+};
+
+/**
+ * @brief Samples of one scrape, grouped by metric name
+ */
+class MetricsWriter {
+public:
+    enum Type {
+        TYPE_COUNTER = 0,
+        TYPE_GAUGE,
+        TYPE_HISTOGRAM,
+        TYPE_SUMMARY
+    };
+
+    void counter(const char* name, const char* help, const MetricLabels& labels, uint64_t value);
+    void gauge(const char* name, const char* help, const MetricLabels& labels, double value);
+
+    /**
+     * @brief Add a histogram
+     * @param bounds Upper bound of each bucket except the last (+Inf)
+     * @param buckets Samples per bucket, not cumulative, boundCount + 1 entries
+     * @param boundCount Number of bounds
+     * @param sum Sum of all samples
+     */
+    void histogram(const char* name, const char* help, const MetricLabels& labels,
+                   const double* bounds, const uint64_t* buckets, uint32_t boundCount, double sum);
+
+    /**
+     * @brief Add a summary
+     * @param quantiles Quantiles (0..1) with their values, count entries each
+     */
+    void summary(const char* name, const char* help, const MetricLabels& labels,
+                 const double* quantiles, const double* values, uint32_t quantileCount,
+                 uint64_t count, double sum);
+
+    std::string prometheus() const;
+    std::string json() const;
+
+    /// Sum of every sample named name (histograms and summaries: counts)
+    bool find(const std::string& name, double& value) const;
+
+private:
+    struct Sample {
+        MetricLabels labels;
+        double value;                                   ///< Counter/gauge value, or sample count
+        double sum;
+        std::vector<std::pair<double, double> > points; ///< (bound, cumulative) or (quantile, value)
+    };
+
+    struct Family {
+        Type type;
+        std::string help;
+        std::vector<Sample> samples;
+    };
+
+    Sample& add(const char* name, const char* help, Type type, const MetricLabels& labels);
+
+    std::map<std::string, Family> m_families;
+};
+
+/**
+ * @brief Adds a component's own counters to each scrape
+ */
+class MetricsCollector {
+public:
+    virtual ~MetricsCollector() {}
+
+    /**
+     * @brief Add current values
+     * @note Called from the scraping thread with the registry locked; must
+     *       not register metrics or collectors
+     */
+    virtual void collectMetrics(MetricsWriter& out) = 0;
+};
+
+/**
+ * @class MetricsRegistry
+ * @brief Registered metrics, collectors and the optional HTTP endpoint
+ */
+class MetricsRegistry {
+public:
+    static MetricsRegistry& instance();
+
+    MetricCounter& counter(const char* name, const char* help, const MetricLabels& labels);
+    MetricGauge& gauge(const char* name, const char* help, const MetricLabels& labels);
+
+    void addCollector(MetricsCollector* collector);
+    void removeCollector(MetricsCollector* collector);
+
+    /// Scrape everything
+    std::string render(XFactory::MetricsFormat format);
+    bool value(const std::string& name, double& value);
+
+    /**
+     * @brief Serve GET /metrics (Prometheus) and /metrics.json over HTTP
+     * @param port TCP port (0 = any free port)
+     */
+    bool startServer(uint16_t port);
+    void stopServer();
+    uint16_t serverPort() const;
+
+    /// Next instance number for the labels of unnamed components
+    uint32_t nextInstance();
+
+private:
+    MetricsRegistry();
+
+    struct Registered {
+        std::string name;
+        std::string help;
+        MetricLabels labels;
+        MetricCounter counter;
+        MetricGauge gauge;
+        bool isCounter;
+    };
+
+    void collect(MetricsWriter& out);
+    void serverThread();
+    void serve(intptr_t client);
+
+    mutable std::mutex m_mutex;
+    std::map<std::string, std::unique_ptr<Registered> > m_metrics;  ///< By name{labels}
+    std::vector<MetricsCollector*> m_collectors;
+    std::atomic<uint32_t> m_instances;
+
+    // HTTP endpoint
+    std::mutex m_serverMutex;
+    intptr_t m_listen;
+    std::atomic<bool> m_serving;
+    std::atomic<uint16_t> m_port;
+    std::thread m_thread;
+
+    MetricsRegistry(const MetricsRegistry&) = delete;
+    MetricsRegistry& operator=(const MetricsRegistry&) = delete;
+};
+
+} // namespace Internal
+} // namespace HX
+
+#endif // METRICS_H
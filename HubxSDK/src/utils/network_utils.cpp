@@ -0,0 +1,521 @@
+// ============================================================================
+// network_utils.cpp
+// ============================================================================
+
+/**
+ * @file network_utils.cpp
+ * @brief Adapter settings read from the host and checked against a line rate
+ * @version 2.1.0
+ */
+
+#include "network_utils.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#ifdef _WIN32
+    #include <winsock2.h>
+    #include <ws2tcpip.h>
+    #include <iphlpapi.h>
+#else
+    #include <arpa/inet.h>
+    #include <dirent.h>
+    #include <ifaddrs.h>
+    #include <net/if.h>
+    #include <netinet/in.h>
+    #include <sys/ioctl.h>
+    #include <sys/socket.h>
+    #include <unistd.h>
+    #include <linux/ethtool.h>
+    #include <linux/sockios.h>
+#endif
+
+namespace HX {
+namespace Internal {
+
+namespace {
+
+/// IPv4 and UDP headers inside the MTU
+const uint32_t IP_UDP_BYTES = 28;
+
+/// Bytes a packet takes on the wire besides its payload: preamble 8,
+/// Ethernet header 14, FCS 4, inter-frame gap 12, IPv4 20, UDP 8
+const uint32_t WIRE_OVERHEAD_BYTES = 66;
+
+/// The link is marginal above this share of its speed
+const double LINK_MARGIN = 0.9;
+
+/// Packets the NIC ring must hold while the receive core is busy elsewhere
+const double RX_RING_COVER_S = 0.002;
+
+/// Data SO_RCVBUF must hold when no size is asked for
+const double RCVBUF_COVER_S = 0.02;
+
+/// Idle state exit latency that never matters at line rates
+const uint32_t IDLE_LATENCY_US = 20;
+
+typedef XAdaptor::NetworkCheck Check;
+
+Check& addCheck(XAdaptor::NetworkReport& report, const char* name) {
+    report.checks.push_back(Check());
+    report.checks.back().name = name;
+    return report.checks.back();
+}
+
+std::string toString(uint64_t value) {
+    std::ostringstream out;
+    out << value;
+    return out.str();
+}
+
+std::string atLeast(uint64_t value, const char* unit = "") {
+    return ">= " + toString(value) + unit;
+}
+
+double packetsPerSecond(const NetRequirement& need) {
+    return need.lineRate > 0.0 ? need.lineRate : 0.0;
+}
+
+void checkMtu(XAdaptor::NetworkReport& report, const NetRequirement& need, int64_t mtu) {
+    Check& check = addCheck(report, "mtu");
+    const uint32_t required = need.packetBytes + IP_UDP_BYTES;
+    check.required = atLeast(required);
+    if (mtu <= 0) {
+        return;
+    }
+    check.value = toString(static_cast<uint64_t>(mtu));
+    check.status = mtu >= required ? XAdaptor::CHECK_PASS : XAdaptor::CHECK_FAIL;
+}
+
+void checkSpeed(XAdaptor::NetworkReport& report, const NetRequirement& need, int64_t mbps) {
+    Check& check = addCheck(report, "link_speed");
+    const double required = packetsPerSecond(need) * (need.packetBytes + WIRE_OVERHEAD_BYTES) * 8.0 / 1e6;
+    check.required = atLeast(static_cast<uint64_t>(std::ceil(required)), " Mb/s");
+    if (mbps <= 0) {
+        return;
+    }
+    check.value = toString(static_cast<uint64_t>(mbps)) + " Mb/s";
+    if (mbps < required) {
+        check.status = XAdaptor::CHECK_FAIL;
+    } else {
+        check.status = required > mbps * LINK_MARGIN ? XAdaptor::CHECK_WARN : XAdaptor::CHECK_PASS;
+    }
+}
+
+void checkRecvBuffer(XAdaptor::NetworkReport& report, const NetRequirement& need, int64_t rmemMax) {
+    Check& check = addCheck(report, "rmem_max");
+    uint64_t required = need.recvBufferBytes;
+    if (required == 0) {
+        required = static_cast<uint64_t>(std::ceil(packetsPerSecond(need) * RCVBUF_COVER_S)) * need.packetBytes;
+    }
+    check.required = atLeast(required, " bytes");
+    if (rmemMax <= 0) {
+        return;
+    }
+    check.value = toString(static_cast<uint64_t>(rmemMax)) + " bytes";
+    check.status = static_cast<uint64_t>(rmemMax) >= required ? XAdaptor::CHECK_PASS : XAdaptor::CHECK_FAIL;
+}
+
+#ifdef _WIN32
+void unknownCheck(XAdaptor::NetworkReport& report, const char* name, const char* value) {
+    Check& check = addCheck(report, name);
+    check.value = value;
+}
+#endif
+
+void finish(XAdaptor::NetworkReport& report) {
+    report.pass = true;
+    for (size_t i = 0; i < report.checks.size(); ++i) {
+        if (report.checks[i].status == XAdaptor::CHECK_FAIL) {
+            report.pass = false;
+        }
+    }
+}
+
+#ifndef _WIN32
+
+/// First line of a sysfs or procfs file
+bool readLine(const std::string& path, std::string& line) {
+    std::ifstream in(path.c_str());
+    if (!in || !std::getline(in, line)) {
+        return false;
+    }
+    while (!line.empty() && (line[line.size() - 1] == '\n' || line[line.size() - 1] == ' ')) {
+        line.erase(line.size() - 1);
+    }
+    return true;
+}
+
+bool readNumber(const std::string& path, int64_t& value) {
+    std::string line;
+    if (!readLine(path, line)) {
+        return false;
+    }
+    char* end = nullptr;
+    const long long v = std::strtoll(line.c_str(), &end, 10);
+    if (end == line.c_str()) {
+        return false;
+    }
+    value = v;
+    return true;
+}
+
+int64_t readNumber(const std::string& path) {
+    int64_t value = -1;
+    return readNumber(path, value) ? value : -1;
+}
+
+/// CPUs 0-63 of a cpulist such as "0-3,8"
+uint64_t parseCpuList(const std::string& list) {
+    uint64_t mask = 0;
+    std::stringstream in(list);
+    std::string item;
+    while (std::getline(in, item, ',')) {
+        unsigned first = 0;
+        unsigned last = 0;
+        const int fields = std::sscanf(item.c_str(), "%u-%u", &first, &last);
+        if (fields < 1) {
+            continue;
+        }
+        if (fields == 1) {
+            last = first;
+        }
+        for (unsigned cpu = first; cpu <= last && cpu < 64; ++cpu) {
+            mask |= 1ull << cpu;
+        }
+    }
+    return mask;
+}
+
+std::string formatCpus(uint64_t mask) {
+    std::ostringstream out;
+    for (unsigned cpu = 0; cpu < 64; ++cpu) {
+        if (mask & (1ull << cpu)) {
+            out << (out.tellp() > 0 ? "," : "") << cpu;
+        }
+    }
+    return out.str();
+}
+
+/// Interrupts of an interface: MSI vectors if it has any, else /proc/interrupts
+void listIrqs(const std::string& name, std::vector<unsigned>& irqs) {
+    irqs.clear();
+    const std::string msi = "/sys/class/net/" + name + "/device/msi_irqs";
+    if (DIR* dir = opendir(msi.c_str())) {
+        while (struct dirent* entry = readdir(dir)) {
+            unsigned irq = 0;
+            if (std::sscanf(entry->d_name, "%u", &irq) == 1) {
+                irqs.push_back(irq);
+            }
+        }
+        closedir(dir);
+    }
+    if (!irqs.empty()) {
+        std::sort(irqs.begin(), irqs.end());
+        return;
+    }
+    std::ifstream in("/proc/interrupts");
+    std::string line;
+    while (std::getline(in, line)) {
+        unsigned irq = 0;
+        if (line.find(name) != std::string::npos && std::sscanf(line.c_str(), " %u:", &irq) == 1) {
+            irqs.push_back(irq);
+        }
+    }
+}
+
+void checkRxRing(XAdaptor::NetworkReport& report, const NetRequirement& need, const std::string& name,
+                 uint32_t& rxPending) {
+    Check& check = addCheck(report, "rx_ring");
+    uint64_t required = std::max<uint64_t>(1,
+        static_cast<uint64_t>(std::ceil(packetsPerSecond(need) * RX_RING_COVER_S)));
+    check.required = atLeast(required, " descriptors");
+    rxPending = 0;
+
+    const int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0) {
+        return;
+    }
+    struct ethtool_ringparam ring;
+    std::memset(&ring, 0, sizeof(ring));
+    ring.cmd = ETHTOOL_GRINGPARAM;
+    struct ifreq request;
+    std::memset(&request, 0, sizeof(request));
+    std::strncpy(request.ifr_name, name.c_str(), IFNAMSIZ - 1);
+    request.ifr_data = reinterpret_cast<char*>(&ring);
+    const bool read = ioctl(fd, SIOCETHTOOL, &request) == 0 && ring.rx_pending > 0;
+    close(fd);
+    if (!read) {
+        return;
+    }
+
+    rxPending = ring.rx_pending;
+    check.value = toString(ring.rx_pending) + " of " + toString(ring.rx_max_pending);
+    if (ring.rx_max_pending > 0 && required > ring.rx_max_pending) {
+        // The hardware ring cannot cover it; the most it can do is its maximum
+        required = ring.rx_max_pending;
+        check.required = atLeast(required, " descriptors (the maximum)");
+        check.status = ring.rx_pending >= required ? XAdaptor::CHECK_WARN : XAdaptor::CHECK_FAIL;
+        return;
+    }
+    check.status = ring.rx_pending >= required ? XAdaptor::CHECK_PASS : XAdaptor::CHECK_FAIL;
+}
+
+void checkIrqs(XAdaptor::NetworkReport& report, const NetRequirement& need, const std::string& name) {
+    Check& check = addCheck(report, "irq_affinity");
+    check.required = need.receiveCpus ? "none on cpus " + formatCpus(need.receiveCpus)
+                                      : "receive threads pinned, interrupts on other cpus";
+    std::vector<unsigned> irqs;
+    listIrqs(name, irqs);
+    if (irqs.empty()) {
+        return;
+    }
+    if (need.receiveCpus == 0) {
+        check.value = toString(irqs.size()) + " irqs, receive threads not pinned";
+        check.status = XAdaptor::CHECK_WARN;
+        return;
+    }
+
+    uint64_t used = 0;
+    for (size_t i = 0; i < irqs.size(); ++i) {
+        const std::string base = "/proc/irq/" + toString(irqs[i]);
+        std::string list;
+        // The CPU the interrupt is delivered to, where the kernel reports it
+        if (!readLine(base + "/effective_affinity_list", list) &&
+            !readLine(base + "/smp_affinity_list", list)) {
+            continue;
+        }
+        const uint64_t cpus = parseCpuList(list);
+        used |= cpus;
+        if (cpus & need.receiveCpus) {
+            check.value = "irq " + toString(irqs[i]) + " on cpus " + list;
+            check.status = XAdaptor::CHECK_FAIL;
+            return;
+        }
+    }
+    if (used == 0) {
+        return;
+    }
+    check.value = toString(irqs.size()) + " irqs on cpus " + formatCpus(used);
+    check.status = XAdaptor::CHECK_PASS;
+}
+
+void checkRpFilter(XAdaptor::NetworkReport& report, const NetRequirement& need, const std::string& name,
+                   uint32_t address, uint32_t netmask) {
+    Check& check = addCheck(report, "rp_filter");
+    check.required = "0 or 2, or 1 with the detector on the adapter's subnet";
+    const int64_t all = readNumber("/proc/sys/net/ipv4/conf/all/rp_filter");
+    const int64_t own = readNumber("/proc/sys/net/ipv4/conf/" + name + "/rp_filter");
+    if (all < 0 && own < 0) {
+        return;
+    }
+    // The kernel uses the larger of the two, so loose on either wins over strict
+    const int64_t mode = std::max(all, own);
+    if (mode != 1) {
+        check.value = mode == 0 ? "0 (off)" : "2 (loose)";
+        check.status = XAdaptor::CHECK_PASS;
+        return;
+    }
+    check.value = "1 (strict)";
+    struct in_addr detector;
+    if (need.detectorIP.empty() || inet_pton(AF_INET, need.detectorIP.c_str(), &detector) != 1) {
+        check.status = XAdaptor::CHECK_WARN;
+        return;
+    }
+    const bool local = ((detector.s_addr ^ address) & netmask) == 0;
+    check.value += local ? ", detector on subnet" : ", detector off subnet";
+    check.status = local ? XAdaptor::CHECK_PASS : XAdaptor::CHECK_FAIL;
+}
+
+void checkIdle(XAdaptor::NetworkReport& report, const NetRequirement& need, uint32_t rxPending) {
+    Check& check = addCheck(report, "cpu_idle");
+    const double pps = packetsPerSecond(need);
+    const double coverUs = (rxPending > 0 && pps > 0.0) ? rxPending / pps * 1e6 : RX_RING_COVER_S * 1e6;
+    check.required = "exit latency <= " + toString(IDLE_LATENCY_US) + " us, fails above " +
+                     toString(static_cast<uint64_t>(coverUs / 2)) + " us";
+
+    int64_t worst = -1;
+    std::string worstName;
+    unsigned worstCpu = 0;
+    for (unsigned cpu = 0; cpu < 64; ++cpu) {
+        if (need.receiveCpus && !(need.receiveCpus & (1ull << cpu))) {
+            continue;
+        }
+        const std::string base = "/sys/devices/system/cpu/cpu" + toString(cpu) + "/cpuidle/state";
+        for (unsigned state = 0;; ++state) {
+            const std::string dir = base + toString(state);
+            const int64_t latency = readNumber(dir + "/latency");
+            if (latency < 0) {
+                break;
+            }
+            if (readNumber(dir + "/disable") > 0 || latency <= worst) {
+                continue;
+            }
+            worst = latency;
+            readLine(dir + "/name", worstName);
+            worstCpu = cpu;
+        }
+    }
+    if (worst < 0) {
+        return;
+    }
+    check.value = worstName + " (" + toString(static_cast<uint64_t>(worst)) + " us) on cpu " + toString(worstCpu);
+    if (worst > coverUs / 2) {
+        check.status = XAdaptor::CHECK_FAIL;
+    } else {
+        check.status = worst > IDLE_LATENCY_US ? XAdaptor::CHECK_WARN : XAdaptor::CHECK_PASS;
+    }
+}
+
+#endif
+
+void appendJson(std::ostringstream& out, const std::string& text) {
+    out << '"';
+    for (size_t i = 0; i < text.size(); ++i) {
+        const unsigned char c = static_cast<unsigned char>(text[i]);
+        if (c == '"' || c == '\\') {
+            out << '\\' << c;
+        } else if (c < 0x20) {
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            out << escaped;
+        } else {
+            out << c;
+        }
+    }
+    out << '"';
+}
+
+const char* statusName(XAdaptor::CheckStatus status) {
+    switch (status) {
+        case XAdaptor::CHECK_PASS: return "pass";
+        case XAdaptor::CHECK_WARN: return "warn";
+        case XAdaptor::CHECK_FAIL: return "fail";
+        default:                   return "unknown";
+    }
+}
+
+} // namespace
+
+bool NetInspectAdapter(const std::string& adapterIP, const NetRequirement& need,
+                       XAdaptor::NetworkReport& report) {
+    report = XAdaptor::NetworkReport();
+    report.adapter = adapterIP;
+    struct in_addr wanted;
+    if (inet_pton(AF_INET, adapterIP.c_str(), &wanted) != 1) {
+        return false;
+    }
+
+#ifdef _WIN32
+    ULONG size = 16 * 1024;
+    std::vector<uint8_t> buffer;
+    ULONG result = ERROR_BUFFER_OVERFLOW;
+    for (int attempt = 0; attempt < 3 && result == ERROR_BUFFER_OVERFLOW; ++attempt) {
+        buffer.resize(size);
+        result = GetAdaptersAddresses(AF_INET, GAA_FLAG_SKIP_ANYCAST | GAA_FLAG_SKIP_MULTICAST |
+                                      GAA_FLAG_SKIP_DNS_SERVER, nullptr,
+                                      reinterpret_cast<IP_ADAPTER_ADDRESSES*>(buffer.data()), &size);
+    }
+    if (result != NO_ERROR) {
+        return false;
+    }
+    const IP_ADAPTER_ADDRESSES* found = nullptr;
+    for (IP_ADAPTER_ADDRESSES* adapter = reinterpret_cast<IP_ADAPTER_ADDRESSES*>(buffer.data());
+         adapter && !found; adapter = adapter->Next) {
+        for (IP_ADAPTER_UNICAST_ADDRESS* address = adapter->FirstUnicastAddress;
+             address; address = address->Next) {
+            const sockaddr_in* in = reinterpret_cast<const sockaddr_in*>(address->Address.lpSockaddr);
+            if (in->sin_family == AF_INET && in->sin_addr.s_addr == wanted.s_addr) {
+                found = adapter;
+                break;
+            }
+        }
+    }
+    if (!found) {
+        return false;
+    }
+    report.interfaceName = found->AdapterName;
+    checkMtu(report, need, found->Mtu);
+    checkSpeed(report, need, static_cast<int64_t>(found->ReceiveLinkSpeed / 1000000));
+    unknownCheck(report, "rx_ring", "not inspected on Windows");
+    unknownCheck(report, "irq_affinity", "not inspected on Windows");
+    unknownCheck(report, "rp_filter", "not inspected on Windows");
+    unknownCheck(report, "cpu_idle", "not inspected on Windows");
+    unknownCheck(report, "rmem_max", "not inspected on Windows");
+#else
+    struct ifaddrs* list = nullptr;
+    if (getifaddrs(&list) != 0) {
+        return false;
+    }
+    uint32_t netmask = 0;
+    for (struct ifaddrs* entry = list; entry; entry = entry->ifa_next) {
+        if (!entry->ifa_addr || entry->ifa_addr->sa_family != AF_INET) {
+            continue;
+        }
+        const sockaddr_in* in = reinterpret_cast<const sockaddr_in*>(entry->ifa_addr);
+        if (in->sin_addr.s_addr == wanted.s_addr) {
+            report.interfaceName = entry->ifa_name;
+            if (entry->ifa_netmask) {
+                netmask = reinterpret_cast<const sockaddr_in*>(entry->ifa_netmask)->sin_addr.s_addr;
+            }
+            break;
+        }
+    }
+    freeifaddrs(list);
+    if (report.interfaceName.empty()) {
+        return false;
+    }
+
+    const std::string& name = report.interfaceName;
+    const std::string sys = "/sys/class/net/" + name;
+    uint32_t rxPending = 0;
+    checkMtu(report, need, readNumber(sys + "/mtu"));
+    checkSpeed(report, need, readNumber(sys + "/speed"));
+    checkRxRing(report, need, name, rxPending);
+    checkIrqs(report, need, name);
+    checkRpFilter(report, need, name, wanted.s_addr, netmask);
+    checkIdle(report, need, rxPending);
+    checkRecvBuffer(report, need, readNumber("/proc/sys/net/core/rmem_max"));
+#endif
+
+    finish(report);
+    return true;
+}
+
+std::string NetReportJson(const std::vector<XAdaptor::NetworkReport>& reports) {
+    bool pass = !reports.empty();
+    for (size_t i = 0; i < reports.size(); ++i) {
+        pass = pass && reports[i].pass;
+    }
+
+    std::ostringstream out;
+    out << "{\"pass\":" << (pass ? "true" : "false") << ",\"adapters\":[";
+    for (size_t i = 0; i < reports.size(); ++i) {
+        const XAdaptor::NetworkReport& report = reports[i];
+        out << (i ? "," : "") << "{\"adapter\":";
+        appendJson(out, report.adapter);
+        out << ",\"interface\":";
+        appendJson(out, report.interfaceName);
+        out << ",\"pass\":" << (report.pass ? "true" : "false") << ",\"checks\":[";
+        for (size_t c = 0; c < report.checks.size(); ++c) {
+            const XAdaptor::NetworkCheck& check = report.checks[c];
+            out << (c ? "," : "") << "{\"name\":";
+            appendJson(out, check.name);
+            out << ",\"status\":\"" << statusName(check.status) << "\",\"value\":";
+            appendJson(out, check.value);
+            out << ",\"required\":";
+            appendJson(out, check.required);
+            out << '}';
+        }
+        out << "]}";
+    }
+    out << "]}";
+    return out.str();
+}
+
+} // namespace Internal
+} // namespace HX
@@ -0,0 +1,58 @@
+// ============================================================================
+// network_utils.h
+// ============================================================================
+
+/**
+ * @file network_utils.h
+ * @brief Host network settings against the needs of a line rate
+ * @version 2.1.0
+ *
+ * This header is INTERNAL to hubx.dll. XAdaptor::InspectNetwork() sizes a
+ * NetRequirement from the detector and asks NetInspectAdapter() for each
+ * adapter. The settings are read from sysfs, procfs and the ethtool
+ * ioctl on Linux; Windows reports the MTU and link speed only.
+ */
+
+#ifndef NETWORK_UTILS_H
+#define NETWORK_UTILS_H
+
+#include "XAdaptor.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace HX {
+namespace Internal {
+
+/**
+ * @brief What an acquisition needs from an adapter
+ */
+struct NetRequirement {
+    double lineRate;            ///< Packets per second, one line each
+    uint32_t packetBytes;       ///< UDP payload per packet
+    uint32_t recvBufferBytes;   ///< SO_RCVBUF the grabber asks for
+    uint64_t receiveCpus;       ///< Receive thread affinity (0 = not pinned)
+    std::string detectorIP;     ///< Source of the packets, empty if unknown
+
+    NetRequirement() : lineRate(0.0), packetBytes(0), recvBufferBytes(0), receiveCpus(0) {}
+};
+
+/**
+ * @brief Inspect one adapter
+ * @param adapterIP IPv4 address of the adapter
+ * @param need Requirement to check against
+ * @param report Output; pass is false if any check failed
+ * @return false if no interface has that address
+ */
+bool NetInspectAdapter(const std::string& adapterIP, const NetRequirement& need,
+                       XAdaptor::NetworkReport& report);
+
+/**
+ * @brief Format reports as XAdaptor::NetworkReportJson() documents
+ */
+std::string NetReportJson(const std::vector<XAdaptor::NetworkReport>& reports);
+
+} // namespace Internal
+} // namespace HX
+
+#endif // NETWORK_UTILS_H
@@ -0,0 +1,392 @@
+// ============================================================================
+// notifier.cpp
+// ============================================================================
+
+/**
+ * @file notifier.cpp
+ * @brief Report queue, notifier thread and error coalescing
+ * @version 2.1.0
+ */
+
+#include "notifier.h"
+#include "logger.h"
+#include "iximg_sink.h"
+#include "ixcmd_sink.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+namespace HX {
+namespace Internal {
+
+namespace {
+
+const uint32_t QUEUE_SIZE = 4096;           // Power of two
+
+/// Notifier thread wake-up when no producer signalled
+const int IDLE_WAIT_MS = 10;
+
+/// Longest exit waits for the queue to drain
+const int STOP_WAIT_MS = 500;
+
+enum RecordKind {
+    RECORD_ERROR = 0,                       // id = error slot of the source
+    RECORD_EVENT
+};
+
+struct Record {
+    uint64_t source;
+    uint32_t kind;
+    uint32_t id;
+    uint32_t data;
+};
+
+/// Bounded multi-producer queue (Vyukov); the notifier thread is the only consumer
+struct Cell {
+    std::atomic<uint64_t> sequence;
+    Record record;
+};
+
+} // namespace
+
+class Notifier {
+public:
+    static Notifier& instance() {
+        // Leaked: components with static storage may report after exit begins
+        static Notifier* notifier = new Notifier();
+        return *notifier;
+    }
+
+    uint64_t attach(NotifySource* source) {
+        std::lock_guard<std::recursive_mutex> lock(m_deliveryMutex);
+        const uint64_t handle = ++m_nextHandle;
+        m_sources[handle] = source;
+        return handle;
+    }
+
+    void detach(uint64_t handle) {
+        std::lock_guard<std::recursive_mutex> lock(m_deliveryMutex);
+        m_sources.erase(handle);
+    }
+
+    /// Held around every callback, and to change a sink
+    std::recursive_mutex& deliveryMutex() { return m_deliveryMutex; }
+
+    bool stopped() const { return m_stopped.load(std::memory_order_acquire); }
+
+    /// false if the queue is full or nobody drains it any more
+    bool push(uint64_t source, uint32_t kind, uint32_t id, uint32_t data) {
+        if (stopped()) {
+            return false;
+        }
+        startThread();
+
+        uint64_t pos = m_enqueue.load(std::memory_order_relaxed);
+        Cell* cell;
+        for (;;) {
+            cell = &m_cells[pos & (QUEUE_SIZE - 1)];
+            uint64_t seq = cell->sequence.load(std::memory_order_acquire);
+            int64_t diff = static_cast<int64_t>(seq) - static_cast<int64_t>(pos);
+            if (diff == 0) {
+                if (m_enqueue.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            } else if (diff < 0) {
+                m_dropped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            } else {
+                pos = m_enqueue.load(std::memory_order_relaxed);
+            }
+        }
+        cell->record.source = source;
+        cell->record.kind = kind;
+        cell->record.id = id;
+        cell->record.data = data;
+        cell->sequence.store(pos + 1, std::memory_order_release);
+
+        if (m_sleeping.load(std::memory_order_acquire)) {
+            m_wake.notify_one();
+        }
+        return true;
+    }
+
+    void flush() {
+        if (!m_started.load(std::memory_order_acquire)) return;
+        if (std::this_thread::get_id() == m_threadId) return; // From a sink
+
+        uint64_t target = m_enqueue.load(std::memory_order_acquire);
+        while (m_delivered.load(std::memory_order_acquire) < target && !stopped()) {
+            m_wake.notify_one();
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    uint64_t dropped() const {
+        return m_dropped.load(std::memory_order_relaxed);
+    }
+
+private:
+    Notifier()
+        : m_enqueue(0),
+          m_dequeue(0),
+          m_delivered(0),
+          m_dropped(0),
+          m_reportedDrops(0),
+          m_nextHandle(0),
+          m_started(false),
+          m_stopped(false),
+          m_sleeping(false) {
+        for (uint32_t i = 0; i < QUEUE_SIZE; i++) {
+            m_cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    void startThread() {
+        if (m_started.load(std::memory_order_acquire)) return;
+        std::lock_guard<std::mutex> lock(m_startMutex);
+        if (m_started.load(std::memory_order_relaxed)) return;
+        m_thread = std::thread(&Notifier::notifyThread, this);
+        m_threadId = m_thread.get_id();
+        m_started.store(true, std::memory_order_release);
+        atexit(&Notifier::stopAtExit);
+    }
+
+    static void stopAtExit() {
+        Notifier& notifier = instance();
+        {
+            std::lock_guard<std::mutex> lock(notifier.m_wakeMutex);
+            notifier.m_stopping = true;
+        }
+        notifier.m_wake.notify_one();
+
+        // No join: inside a DLL unload the thread may never get to run again
+        for (int i = 0; i < STOP_WAIT_MS && !notifier.stopped(); i++) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        if (notifier.m_thread.joinable()) notifier.m_thread.detach();
+    }
+
+    void deliver(const Record& record) {
+        // Sources detached in the meantime are skipped
+        std::unordered_map<uint64_t, NotifySource*>::iterator it = m_sources.find(record.source);
+        if (it == m_sources.end()) {
+            return;
+        }
+        if (record.kind == RECORD_ERROR) {
+            it->second->deliverError(record.id);
+        } else {
+            it->second->deliverEvent(record.id, record.data);
+        }
+    }
+
+    /// Deliver everything queued; returns the number of reports
+    uint32_t drain() {
+        uint32_t count = 0;
+        std::lock_guard<std::recursive_mutex> lock(m_deliveryMutex);
+        for (;;) {
+            Cell& cell = m_cells[m_dequeue & (QUEUE_SIZE - 1)];
+            if (cell.sequence.load(std::memory_order_acquire) != m_dequeue + 1) break;
+
+            const Record record = cell.record;
+            cell.sequence.store(m_dequeue + QUEUE_SIZE, std::memory_order_release);
+            m_dequeue++;
+            deliver(record);
+            count++;
+            m_delivered.store(m_dequeue, std::memory_order_release);
+        }
+
+        const uint64_t dropped = m_dropped.load(std::memory_order_relaxed);
+        if (dropped != m_reportedDrops) {
+            HX_LOG_WARNING("XFactory") << (dropped - m_reportedDrops)
+                                       << " error/event report(s) dropped, notifier queue full";
+            m_reportedDrops = dropped;
+        }
+        return count;
+    }
+
+    void notifyThread() {
+        for (;;) {
+            if (drain() > 0) continue;
+
+            std::unique_lock<std::mutex> lock(m_wakeMutex);
+            if (m_stopping) break;
+            m_sleeping.store(true, std::memory_order_release);
+            m_wake.wait_for(lock, std::chrono::milliseconds(IDLE_WAIT_MS));
+            m_sleeping.store(false, std::memory_order_relaxed);
+        }
+        drain();
+        m_stopped.store(true, std::memory_order_release);
+        drain();                            // Producers that missed the flag
+    }
+
+    Cell m_cells[QUEUE_SIZE];
+
+    std::atomic<uint64_t> m_enqueue;
+    uint64_t m_dequeue;                     // Notifier thread only
+    std::atomic<uint64_t> m_delivered;
+    std::atomic<uint64_t> m_dropped;
+    uint64_t m_reportedDrops;               // Notifier thread only
+
+    std::recursive_mutex m_deliveryMutex;
+    std::unordered_map<uint64_t, NotifySource*> m_sources;
+    uint64_t m_nextHandle;
+
+    std::mutex m_startMutex;
+    std::atomic<bool> m_started;
+    std::atomic<bool> m_stopped;
+    std::thread m_thread;
+    std::thread::id m_threadId;
+
+    std::mutex m_wakeMutex;
+    std::condition_variable m_wake;
+    std::atomic<bool> m_sleeping;
+    bool m_stopping = false;
+};
+
+NotifySource::NotifySource()
+    : m_active(false)
+    , m_imgSink(nullptr)
+    , m_cmdSink(nullptr)
+{
+    for (uint32_t i = 0; i < ERROR_SLOTS; ++i) {
+        m_errors[i].key.store(0, std::memory_order_relaxed);
+        m_errors[i].pending.store(0, std::memory_order_relaxed);
+        m_errors[i].id = 0;
+        m_errors[i].message[0] = '\0';
+    }
+    m_handle = Notifier::instance().attach(this);
+}
+
+NotifySource::~NotifySource() {
+    // What was reported while the sink was set still reaches it
+    Notifier::instance().flush();
+    Notifier::instance().detach(m_handle);
+}
+
+void NotifySource::setSink(IXImgSink* sink) {
+    Notifier& notifier = Notifier::instance();
+    notifier.flush();
+    std::lock_guard<std::recursive_mutex> lock(notifier.deliveryMutex());
+    m_imgSink = sink;
+    m_cmdSink = nullptr;
+    m_active.store(sink != nullptr, std::memory_order_release);
+}
+
+void NotifySource::setSink(IXCmdSink* sink) {
+    Notifier& notifier = Notifier::instance();
+    notifier.flush();
+    std::lock_guard<std::recursive_mutex> lock(notifier.deliveryMutex());
+    m_cmdSink = sink;
+    m_imgSink = nullptr;
+    m_active.store(sink != nullptr, std::memory_order_release);
+}
+
+void NotifySource::error(uint32_t id, const char* message) {
+    if (!m_active.load(std::memory_order_acquire)) {
+        return;
+    }
+
+    // Find or claim this id's slot; the last one takes every id that is left
+    const uint32_t key = id + 1;
+    uint32_t slot = ERROR_SLOTS - 1;
+    for (uint32_t i = 0; i < ERROR_SLOTS - 1; ++i) {
+        uint32_t current = m_errors[i].key.load(std::memory_order_acquire);
+        if (current == 0 && m_errors[i].key.compare_exchange_strong(current, key, std::memory_order_acq_rel)) {
+            current = key;
+        }
+        // A failed claim leaves the id of the thread that won it in current
+        if (current == key) {
+            slot = i;
+            break;
+        }
+    }
+
+    // A report of this slot is queued already: it carries the count
+    ErrorSlot& entry = m_errors[slot];
+    if (entry.pending.fetch_add(1, std::memory_order_acq_rel) != 0) {
+        return;
+    }
+    entry.id = id;
+    const size_t length = message ? std::min<size_t>(strlen(message), MAX_MESSAGE - 1) : 0;
+    if (length > 0) {
+        memcpy(entry.message, message, length);
+    }
+    entry.message[length] = '\0';
+
+    Notifier& notifier = Notifier::instance();
+    if (!notifier.push(m_handle, RECORD_ERROR, slot, 0)) {
+        if (notifier.stopped()) {
+            std::lock_guard<std::recursive_mutex> lock(notifier.deliveryMutex());
+            deliverError(slot);
+        } else {
+            entry.pending.store(0, std::memory_order_release);
+        }
+    }
+}
+
+void NotifySource::event(uint32_t id, uint32_t data) {
+    if (!m_active.load(std::memory_order_acquire)) {
+        return;
+    }
+    Notifier& notifier = Notifier::instance();
+    if (!notifier.push(m_handle, RECORD_EVENT, id, data) && notifier.stopped()) {
+        std::lock_guard<std::recursive_mutex> lock(notifier.deliveryMutex());
+        deliverEvent(id, data);
+    }
+}
+
+void NotifySource::event(uint32_t id, float data) {
+    // Carried as its bits; a command sink reads them back as float
+    uint32_t bits = 0;
+    memcpy(&bits, &data, sizeof(bits));
+    event(id, bits);
+}
+
+void NotifySource::deliverError(uint32_t slot) {
+    ErrorSlot& entry = m_errors[slot];
+
+    // Copy before taking the count: a repeat after it writes a new message
+    char text[MAX_MESSAGE + 32];
+    memcpy(text, entry.message, MAX_MESSAGE);
+    text[MAX_MESSAGE - 1] = '\0';
+    const uint32_t id = entry.id;
+    const uint32_t count = entry.pending.exchange(0, std::memory_order_acq_rel);
+    if (count == 0) {
+        return;
+    }
+    if (count > 1) {
+        const size_t length = strlen(text);
+        snprintf(text + length, sizeof(text) - length, " (repeated %u times)", count);
+    }
+
+    if (m_imgSink) {
+        m_imgSink->OnXError(id, text);
+    } else if (m_cmdSink) {
+        m_cmdSink->OnXError(id, text);
+    }
+}
+
+void NotifySource::deliverEvent(uint32_t id, uint32_t data) {
+    if (m_imgSink) {
+        m_imgSink->OnXEvent(id, data);
+    } else if (m_cmdSink) {
+        float value = 0.0f;
+        memcpy(&value, &data, sizeof(value));
+        m_cmdSink->OnXEvent(id, value);
+    }
+}
+
+void NotifyFlush() {
+    Notifier::instance().flush();
+}
+
+uint64_t NotifyDropped() {
+    return Notifier::instance().dropped();
+}
+
+} // namespace Internal
+} // namespace HX
@@ -0,0 +1,95 @@
+// ============================================================================
+// notifier.h
+// ============================================================================
+
+/**
+ * @file notifier.h
+ * @brief Sink errors and events, delivered and coalesced off the hot thread
+ * @version 2.1.0
+ *
+ * This header is INTERNAL to hubx.dll. Components report through a
+ * NotifySource instead of calling OnXError/OnXEvent themselves. A report
+ * is one record on a lock-free queue; a notifier thread calls the sink.
+ * An error id that repeats before its first report was delivered only
+ * bumps a counter, and the sink gets the first message once, with the
+ * number of repeats appended, so an error storm costs the reporting
+ * thread an increment per error. Events carry data and are delivered one
+ * by one, in order. A full queue drops the report instead of waiting.
+ */
+
+#ifndef NOTIFIER_H
+#define NOTIFIER_H
+
+#include <atomic>
+#include <cstdint>
+
+namespace HX {
+
+class IXImgSink;
+class IXCmdSink;
+
+namespace Internal {
+
+/**
+ * @class NotifySource
+ * @brief The sink of one component and its pending error repeats
+ *
+ * setSink() and the destructor wait until no callback into the old sink
+ * runs; the destructor first delivers what is still queued. Reports are
+ * safe from any thread.
+ */
+class NotifySource {
+public:
+    /// Error ids coalesced separately; later ids share the last slot
+    static const uint32_t ERROR_SLOTS = 16;
+
+    /// Longer messages are cut
+    static const uint32_t MAX_MESSAGE = 128;
+
+    NotifySource();
+    ~NotifySource();
+
+    void setSink(IXImgSink* sink);
+    void setSink(IXCmdSink* sink);
+
+    void error(uint32_t id, const char* message);
+    void event(uint32_t id, uint32_t data);
+    void event(uint32_t id, float data);
+
+private:
+    friend class Notifier;
+
+    struct ErrorSlot {
+        std::atomic<uint32_t> key;          ///< id + 1, 0 = free
+        std::atomic<uint32_t> pending;      ///< Repeats not delivered yet
+        uint32_t id;                        ///< First id of the shared slot
+        char message[MAX_MESSAGE];          ///< First message of the repeats
+    };
+
+    void deliverError(uint32_t slot);
+    void deliverEvent(uint32_t id, uint32_t data);
+
+    uint64_t m_handle;
+    std::atomic<bool> m_active;             ///< A sink is set
+    IXImgSink* m_imgSink;                   ///< Guarded by the delivery lock
+    IXCmdSink* m_cmdSink;
+    ErrorSlot m_errors[ERROR_SLOTS];
+
+    // Non-copyable
+    NotifySource(const NotifySource&) = delete;
+    NotifySource& operator=(const NotifySource&) = delete;
+};
+
+/**
+ * @brief Wait until every report queued so far reached its sink
+ * @note No-op on the notifier thread, i.e. from inside a callback
+ */
+void NotifyFlush();
+
+/// Reports dropped because the queue was full
+uint64_t NotifyDropped();
+
+} // namespace Internal
+} // namespace HX
+
+#endif // NOTIFIER_H
@@ -0,0 +1,135 @@
+// ============================================================================
+// opencl_api.cpp
+// ============================================================================
+
+/**
+ * @file opencl_api.cpp
+ * @brief Run-time loading of the OpenCL ICD loader
+ * @version 2.1.0
+ */
+
+#include "opencl_api.h"
+#include <vector>
+
+#ifdef HUBX_WITH_OPENCL
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dlfcn.h>
+#endif
+#endif
+
+namespace HX {
+namespace Internal {
+
+#ifdef HUBX_WITH_OPENCL
+
+namespace {
+
+void* openLibrary() {
+#if defined(_WIN32)
+    return reinterpret_cast<void*>(LoadLibraryA("OpenCL.dll"));
+#elif defined(__APPLE__)
+    return dlopen("/System/Library/Frameworks/OpenCL.framework/OpenCL", RTLD_NOW | RTLD_LOCAL);
+#else
+    void* library = dlopen("libOpenCL.so.1", RTLD_NOW | RTLD_LOCAL);
+    return library ? library : dlopen("libOpenCL.so", RTLD_NOW | RTLD_LOCAL);
+#endif
+}
+
+template <typename Fn>
+bool resolve(void* library, Fn& fn, const char* name) {
+#ifdef _WIN32
+    fn = reinterpret_cast<Fn>(GetProcAddress(reinterpret_cast<HMODULE>(library), name));
+#else
+    fn = reinterpret_cast<Fn>(dlsym(library, name));
+#endif
+    return fn != nullptr;
+}
+
+bool resolveAll(void* library, OpenCLApi& cl) {
+    return resolve(library, cl.getPlatformIDs, "clGetPlatformIDs") &&
+           resolve(library, cl.getDeviceIDs, "clGetDeviceIDs") &&
+           resolve(library, cl.getDeviceInfo, "clGetDeviceInfo") &&
+           resolve(library, cl.createContext, "clCreateContext") &&
+           resolve(library, cl.releaseContext, "clReleaseContext") &&
+           resolve(library, cl.createCommandQueue, "clCreateCommandQueue") &&
+           resolve(library, cl.releaseCommandQueue, "clReleaseCommandQueue") &&
+           resolve(library, cl.createBuffer, "clCreateBuffer") &&
+           resolve(library, cl.releaseMemObject, "clReleaseMemObject") &&
+           resolve(library, cl.createProgramWithSource, "clCreateProgramWithSource") &&
+           resolve(library, cl.buildProgram, "clBuildProgram") &&
+           resolve(library, cl.getProgramBuildInfo, "clGetProgramBuildInfo") &&
+           resolve(library, cl.releaseProgram, "clReleaseProgram") &&
+           resolve(library, cl.createKernel, "clCreateKernel") &&
+           resolve(library, cl.releaseKernel, "clReleaseKernel") &&
+           resolve(library, cl.setKernelArg, "clSetKernelArg") &&
+           resolve(library, cl.enqueueNDRangeKernel, "clEnqueueNDRangeKernel") &&
+           resolve(library, cl.enqueueWriteBuffer, "clEnqueueWriteBuffer") &&
+           resolve(library, cl.enqueueReadBuffer, "clEnqueueReadBuffer") &&
+           resolve(library, cl.enqueueMapBuffer, "clEnqueueMapBuffer") &&
+           resolve(library, cl.enqueueUnmapMemObject, "clEnqueueUnmapMemObject") &&
+           resolve(library, cl.flush, "clFlush") &&
+           resolve(library, cl.finish, "clFinish");
+}
+
+const OpenCLApi* loadOnce() {
+    // The library stays loaded for the life of the process
+    static OpenCLApi cl;
+    void* library = openLibrary();
+    if (!library || !resolveAll(library, cl)) {
+        return nullptr;
+    }
+    return &cl;
+}
+
+} // namespace
+
+const OpenCLApi* LoadOpenCL() {
+    static const OpenCLApi* api = loadOnce();
+    return api;
+}
+
+int ListOpenCLDevices(cl_device_id* devices, int max) {
+    const OpenCLApi* cl = LoadOpenCL();
+    cl_uint platformCount = 0;
+    if (!cl || cl->getPlatformIDs(0, nullptr, &platformCount) != HX_CL_SUCCESS || platformCount == 0) {
+        return 0;
+    }
+    std::vector<cl_platform_id> platforms(platformCount);
+    cl->getPlatformIDs(platformCount, platforms.data(), nullptr);
+
+    int found = 0;
+    for (cl_uint p = 0; p < platformCount; ++p) {
+        cl_uint count = 0;
+        const cl_device_type type = HX_CL_DEVICE_TYPE_GPU | HX_CL_DEVICE_TYPE_ACCELERATOR;
+        if (cl->getDeviceIDs(platforms[p], type, 0, nullptr, &count) != HX_CL_SUCCESS || count == 0) {
+            continue;
+        }
+        std::vector<cl_device_id> ids(count);
+        cl->getDeviceIDs(platforms[p], type, count, ids.data(), nullptr);
+        for (cl_uint d = 0; d < count; ++d, ++found) {
+            if (devices && found < max) {
+                devices[found] = ids[d];
+            }
+        }
+    }
+    return found;
+}
+
+#else
+
+const OpenCLApi* LoadOpenCL() {
+    return nullptr;
+}
+
+int ListOpenCLDevices(cl_device_id* devices, int max) {
+    (void)devices;
+    (void)max;
+    return 0;
+}
+
+#endif // HUBX_WITH_OPENCL
+
+} // namespace Internal
+} // namespace HX
@@ -0,0 +1,124 @@
+// ============================================================================
+// opencl_api.h
+// ============================================================================
+
+/**
+ * @file opencl_api.h
+ * @brief OpenCL 1.2 entry points, loaded from the runtime at first use
+ * @version 2.1.0
+ *
+ * This header is INTERNAL to hubx.dll. hubx is not linked against
+ * OpenCL: the ICD loader (OpenCL.dll, libOpenCL.so.1) is opened the first
+ * time a GPU backend is asked for, so machines without a GPU driver run
+ * the CPU paths unchanged. Only the types, constants and functions the
+ * correction backend uses are declared here, with the values of the
+ * Khronos headers.
+ */
+
+#ifndef OPENCL_API_H
+#define OPENCL_API_H
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(_WIN32)
+#define HX_CL_CALL __stdcall
+#else
+#define HX_CL_CALL
+#endif
+
+namespace HX {
+namespace Internal {
+
+typedef int32_t cl_int;
+typedef uint32_t cl_uint;
+typedef uint64_t cl_ulong;
+typedef cl_ulong cl_bitfield;
+typedef cl_bitfield cl_device_type;
+typedef cl_bitfield cl_mem_flags;
+typedef cl_bitfield cl_map_flags;
+typedef cl_bitfield cl_command_queue_properties;
+typedef intptr_t cl_context_properties;
+
+typedef struct _cl_platform_id* cl_platform_id;
+typedef struct _cl_device_id* cl_device_id;
+typedef struct _cl_context* cl_context;
+typedef struct _cl_command_queue* cl_command_queue;
+typedef struct _cl_mem* cl_mem;
+typedef struct _cl_program* cl_program;
+typedef struct _cl_kernel* cl_kernel;
+typedef struct _cl_event* cl_event;
+
+const cl_int HX_CL_SUCCESS = 0;
+const cl_uint HX_CL_TRUE = 1;
+const cl_uint HX_CL_FALSE = 0;
+const cl_device_type HX_CL_DEVICE_TYPE_GPU = 1 << 2;
+const cl_device_type HX_CL_DEVICE_TYPE_ACCELERATOR = 1 << 3;
+const cl_uint HX_CL_DEVICE_NAME = 0x102B;
+const cl_mem_flags HX_CL_MEM_READ_WRITE = 1 << 0;
+const cl_mem_flags HX_CL_MEM_READ_ONLY = 1 << 2;
+const cl_mem_flags HX_CL_MEM_ALLOC_HOST_PTR = 1 << 4;
+const cl_mem_flags HX_CL_MEM_COPY_HOST_PTR = 1 << 5;
+const cl_map_flags HX_CL_MAP_READ = 1 << 0;
+const cl_map_flags HX_CL_MAP_WRITE = 1 << 1;
+const cl_uint HX_CL_PROGRAM_BUILD_LOG = 0x1183;
+
+/**
+ * @brief Resolved OpenCL functions
+ */
+struct OpenCLApi {
+    cl_int (HX_CL_CALL *getPlatformIDs)(cl_uint, cl_platform_id*, cl_uint*);
+    cl_int (HX_CL_CALL *getDeviceIDs)(cl_platform_id, cl_device_type, cl_uint, cl_device_id*, cl_uint*);
+    cl_int (HX_CL_CALL *getDeviceInfo)(cl_device_id, cl_uint, size_t, void*, size_t*);
+    cl_context (HX_CL_CALL *createContext)(const cl_context_properties*, cl_uint, const cl_device_id*,
+                                           void (HX_CL_CALL *)(const char*, const void*, size_t, void*),
+                                           void*, cl_int*);
+    cl_int (HX_CL_CALL *releaseContext)(cl_context);
+    cl_command_queue (HX_CL_CALL *createCommandQueue)(cl_context, cl_device_id,
+                                                      cl_command_queue_properties, cl_int*);
+    cl_int (HX_CL_CALL *releaseCommandQueue)(cl_command_queue);
+    cl_mem (HX_CL_CALL *createBuffer)(cl_context, cl_mem_flags, size_t, void*, cl_int*);
+    cl_int (HX_CL_CALL *releaseMemObject)(cl_mem);
+    cl_program (HX_CL_CALL *createProgramWithSource)(cl_context, cl_uint, const char**, const size_t*,
+                                                     cl_int*);
+    cl_int (HX_CL_CALL *buildProgram)(cl_program, cl_uint, const cl_device_id*, const char*,
+                                      void (HX_CL_CALL *)(cl_program, void*), void*);
+    cl_int (HX_CL_CALL *getProgramBuildInfo)(cl_program, cl_device_id, cl_uint, size_t, void*, size_t*);
+    cl_int (HX_CL_CALL *releaseProgram)(cl_program);
+    cl_kernel (HX_CL_CALL *createKernel)(cl_program, const char*, cl_int*);
+    cl_int (HX_CL_CALL *releaseKernel)(cl_kernel);
+    cl_int (HX_CL_CALL *setKernelArg)(cl_kernel, cl_uint, size_t, const void*);
+    cl_int (HX_CL_CALL *enqueueNDRangeKernel)(cl_command_queue, cl_kernel, cl_uint, const size_t*,
+                                              const size_t*, const size_t*, cl_uint, const cl_event*,
+                                              cl_event*);
+    cl_int (HX_CL_CALL *enqueueWriteBuffer)(cl_command_queue, cl_mem, cl_uint, size_t, size_t,
+                                            const void*, cl_uint, const cl_event*, cl_event*);
+    cl_int (HX_CL_CALL *enqueueReadBuffer)(cl_command_queue, cl_mem, cl_uint, size_t, size_t, void*,
+                                           cl_uint, const cl_event*, cl_event*);
+    void* (HX_CL_CALL *enqueueMapBuffer)(cl_command_queue, cl_mem, cl_uint, cl_map_flags, size_t,
+                                         size_t, cl_uint, const cl_event*, cl_event*, cl_int*);
+    cl_int (HX_CL_CALL *enqueueUnmapMemObject)(cl_command_queue, cl_mem, void*, cl_uint,
+                                               const cl_event*, cl_event*);
+    cl_int (HX_CL_CALL *flush)(cl_command_queue);
+    cl_int (HX_CL_CALL *finish)(cl_command_queue);
+};
+
+/**
+ * @brief Load the OpenCL runtime once
+ * @return Entry points, or nullptr if there is no runtime (or the build
+ *         has HUBX_WITH_OPENCL off)
+ */
+const OpenCLApi* LoadOpenCL();
+
+/**
+ * @brief List GPU and accelerator devices of every platform
+ * @param devices Receives up to max devices (may be nullptr to count)
+ * @param max Capacity of devices
+ * @return Devices found
+ */
+int ListOpenCLDevices(cl_device_id* devices, int max);
+
+} // namespace Internal
+} // namespace HX
+
+#endif // OPENCL_API_H
@@ -0,0 +1,199 @@
+// ============================================================================
+// overload.cpp
+// ============================================================================
+
+/**
+ * @file overload.cpp
+ * @brief Backlog tracking and shed decisions
+ * @version 2.1.0
+ */
+
+#include "overload.h"
+#include "logger.h"
+#include <algorithm>
+#include <mutex>
+
+namespace HX {
+namespace Internal {
+
+std::atomic<int32_t> g_overloadLevel(XFactory::OVERLOAD_NONE);
+
+namespace {
+    std::mutex g_overloadMutex;             // Policy and level transitions
+    XFactory::OverloadPolicy g_policy;
+    std::atomic<bool> g_enabled(false);
+
+    // Fill of every source in permille; a slot is taken while its flag is set
+    std::atomic<uint32_t> g_fill[OverloadSource::MAX_SOURCES];
+    std::atomic<bool> g_taken[OverloadSource::MAX_SOURCES];
+
+    std::atomic<uint32_t> g_backlog(0);     // Permille, fullest source
+    std::atomic<uint32_t> g_peak(0);
+    std::atomic<uint64_t> g_levelChanges(0);
+    std::atomic<uint64_t> g_shed[XFactory::OVERLOAD_LEVEL_COUNT];
+
+    const char* levelName(int32_t level) {
+        switch (level) {
+            case XFactory::OVERLOAD_PREVIEW:  return "dropping preview";
+            case XFactory::OVERLOAD_OPTIONAL: return "skipping optional stages";
+            case XFactory::OVERLOAD_FRAMES:   return "dropping frames";
+            default:                          return "none";
+        }
+    }
+
+    uint32_t permille(float fraction) {
+        return static_cast<uint32_t>(std::max(0.0f, std::min(1.0f, fraction)) * 1000.0f + 0.5f);
+    }
+
+    // Threshold of a level in permille (level 1 .. OVERLOAD_FRAMES)
+    uint32_t threshold(const XFactory::OverloadPolicy& policy, int32_t level) {
+        switch (level) {
+            case XFactory::OVERLOAD_PREVIEW:  return permille(policy.previewAt);
+            case XFactory::OVERLOAD_OPTIONAL: return permille(policy.optionalAt);
+            default:                          return permille(policy.framesAt);
+        }
+    }
+
+    void setLevel(int32_t level, uint32_t backlog) {
+        // Called with g_overloadMutex held
+        const int32_t previous = g_overloadLevel.load(std::memory_order_relaxed);
+        if (level == previous) {
+            return;
+        }
+        g_overloadLevel.store(level, std::memory_order_relaxed);
+        ++g_levelChanges;
+
+        if (level > previous) {
+            HX_LOG_WARNING("XFactory") << "Overload: " << levelName(level) << " (backlog "
+                                       << backlog / 10 << "%)";
+        } else {
+            HX_LOG_INFO("XFactory") << "Overload eased: " << levelName(level) << " (backlog "
+                                    << backlog / 10 << "%)";
+        }
+    }
+
+    void update() {
+        uint32_t backlog = 0;
+        for (int32_t s = 0; s < OverloadSource::MAX_SOURCES; ++s) {
+            backlog = std::max(backlog, g_fill[s].load(std::memory_order_relaxed));
+        }
+        g_backlog.store(backlog, std::memory_order_relaxed);
+        if (backlog > g_peak.load(std::memory_order_relaxed)) {
+            g_peak.store(backlog, std::memory_order_relaxed);
+        }
+
+        std::lock_guard<std::mutex> lock(g_overloadMutex);
+        if (!g_enabled.load(std::memory_order_relaxed)) {
+            return;
+        }
+
+        // Up at once to the highest level reached; down past a level only
+        // once the backlog is hysteresis below its threshold
+        int32_t level = g_overloadLevel.load(std::memory_order_relaxed);
+        int32_t reached = XFactory::OVERLOAD_NONE;
+        for (int32_t l = XFactory::OVERLOAD_PREVIEW; l < XFactory::OVERLOAD_LEVEL_COUNT; ++l) {
+            if (backlog >= threshold(g_policy, l)) {
+                reached = l;
+            }
+        }
+        if (reached > level) {
+            level = reached;
+        } else {
+            const uint32_t hysteresis = permille(g_policy.hysteresis);
+            while (level > reached && backlog + hysteresis < threshold(g_policy, level)) {
+                --level;
+            }
+        }
+        setLevel(level, backlog);
+    }
+}
+
+void OverloadCount(XFactory::OverloadLevel level) {
+    if (level >= 0 && level < XFactory::OVERLOAD_LEVEL_COUNT) {
+        g_shed[level].fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+bool OverloadSetPolicy(const XFactory::OverloadPolicy& policy) {
+    if (!(policy.previewAt > 0.0f && policy.previewAt <= policy.optionalAt &&
+          policy.optionalAt <= policy.framesAt && policy.framesAt <= 1.0f &&
+          policy.hysteresis >= 0.0f && policy.hysteresis < 1.0f)) {
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(g_overloadMutex);
+        g_policy = policy;
+        g_enabled.store(policy.enabled, std::memory_order_relaxed);
+        if (!policy.enabled) {
+            setLevel(XFactory::OVERLOAD_NONE, g_backlog.load(std::memory_order_relaxed));
+        }
+    }
+    update();
+    return true;
+}
+
+XFactory::OverloadPolicy OverloadGetPolicy() {
+    std::lock_guard<std::mutex> lock(g_overloadMutex);
+    return g_policy;
+}
+
+void OverloadGetStats(XFactory::OverloadStats& stats) {
+    stats.level = static_cast<XFactory::OverloadLevel>(g_overloadLevel.load(std::memory_order_relaxed));
+    stats.backlog = g_backlog.load(std::memory_order_relaxed) / 1000.0f;
+    stats.peakBacklog = g_peak.load(std::memory_order_relaxed) / 1000.0f;
+    stats.levelChanges = g_levelChanges.load(std::memory_order_relaxed);
+    stats.previewDropped = g_shed[XFactory::OVERLOAD_PREVIEW].load(std::memory_order_relaxed);
+    stats.stagesSkipped = g_shed[XFactory::OVERLOAD_OPTIONAL].load(std::memory_order_relaxed);
+    stats.framesDropped = g_shed[XFactory::OVERLOAD_FRAMES].load(std::memory_order_relaxed);
+}
+
+void OverloadResetStats() {
+    g_peak.store(g_backlog.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    g_levelChanges.store(0, std::memory_order_relaxed);
+    for (int32_t l = 0; l < XFactory::OVERLOAD_LEVEL_COUNT; ++l) {
+        g_shed[l].store(0, std::memory_order_relaxed);
+    }
+}
+
+OverloadSource::OverloadSource()
+    : m_slot(-1)
+    , m_permille(0)
+{
+}
+
+OverloadSource::~OverloadSource() {
+    clear();
+    if (m_slot >= 0) {
+        g_taken[m_slot].store(false, std::memory_order_release);
+    }
+}
+
+void OverloadSource::report(uint32_t used, uint32_t capacity) {
+    const uint32_t fill = capacity > 0 ?
+        static_cast<uint32_t>(std::min<uint64_t>(1000, static_cast<uint64_t>(used) * 1000 / capacity)) : 0;
+    if (fill == m_permille) {
+        return;
+    }
+    if (m_slot < 0) {
+        for (int32_t s = 0; s < MAX_SOURCES; ++s) {
+            bool expected = false;
+            if (g_taken[s].compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+                m_slot = s;
+                break;
+            }
+        }
+        if (m_slot < 0) {
+            return;
+        }
+    }
+    m_permille = fill;
+    g_fill[m_slot].store(fill, std::memory_order_relaxed);
+    update();
+}
+
+void OverloadSource::clear() {
+    report(0, 1);
+}
+
+} // namespace Internal
+} // namespace HX
@@ -0,0 +1,86 @@
+// ============================================================================
+// overload.h
+// ============================================================================
+
+/**
+ * @file overload.h
+ * @brief Backlog tracking and shed decisions behind XFactory::SetOverloadPolicy()
+ * @version 2.1.0
+ *
+ * This header is INTERNAL to hubx.dll. Buffers between the pipeline's
+ * stages report how full they are through an OverloadSource; the fullest
+ * one sets the level. Stages that can be left out ask OverloadShed()
+ * before doing their work, which also counts the decision. With no policy
+ * every entry point is one relaxed load.
+ */
+
+#ifndef OVERLOAD_H
+#define OVERLOAD_H
+
+#include "xfactory.h"
+#include <atomic>
+#include <cstdint>
+
+namespace HX {
+namespace Internal {
+
+extern std::atomic<int32_t> g_overloadLevel;
+
+/// Count one unit of work shed at a level
+void OverloadCount(XFactory::OverloadLevel level);
+
+/**
+ * @brief Check whether work of a stage should be shed, and count it if so
+ * @param level OVERLOAD_PREVIEW, OVERLOAD_OPTIONAL or OVERLOAD_FRAMES
+ */
+inline bool OverloadShed(XFactory::OverloadLevel level) {
+    if (g_overloadLevel.load(std::memory_order_relaxed) < level) {
+        return false;
+    }
+    OverloadCount(level);
+    return true;
+}
+
+bool OverloadSetPolicy(const XFactory::OverloadPolicy& policy);
+XFactory::OverloadPolicy OverloadGetPolicy();
+void OverloadGetStats(XFactory::OverloadStats& stats);
+void OverloadResetStats();
+
+/**
+ * @class OverloadSource
+ * @brief One buffer whose fill counts towards the backlog
+ * @note report() and clear() from one thread at a time
+ */
+class OverloadSource {
+public:
+    /// Sources beyond this many are not tracked
+    static const int32_t MAX_SOURCES = 64;
+
+    OverloadSource();
+    ~OverloadSource();
+
+    /**
+     * @brief Report the buffer's occupancy
+     * @param used Entries waiting
+     * @param capacity Entries the buffer holds
+     */
+    void report(uint32_t used, uint32_t capacity);
+
+    /**
+     * @brief The buffer no longer holds anything, e.g. after Stop()
+     */
+    void clear();
+
+private:
+    int32_t m_slot;                 ///< -1 until the first report
+    uint32_t m_permille;            ///< Last reported fill
+
+    // Non-copyable
+    OverloadSource(const OverloadSource&) = delete;
+    OverloadSource& operator=(const OverloadSource&) = delete;
+};
+
+} // namespace Internal
+} // namespace HX
+
+#endif // OVERLOAD_H
@@ -0,0 +1,231 @@
+// ============================================================================
+// perf_counters.cpp
+// ============================================================================
+
+/**
+ * @file perf_counters.cpp
+ * @brief perf_event_open counter groups and per-stage totals
+ * @version 2.1.0
+ */
+
+#include "perf_counters.h"
+
+#ifdef HUBX_WITH_PERF_COUNTERS
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace HX {
+namespace Internal {
+
+#ifdef HUBX_WITH_PERF_COUNTERS
+
+std::atomic<bool> g_perfEnabled(false);
+
+namespace {
+
+enum Counter { COUNTER_CYCLES = 0, COUNTER_INSTRUCTIONS, COUNTER_LLC_MISSES, COUNTER_COUNT };
+
+struct StageCounters {
+    std::atomic<uint64_t> samples;
+    std::atomic<uint64_t> values[COUNTER_COUNT];
+};
+
+StageCounters g_stages[XFactory::PERF_STAGE_COUNT];
+
+int openCounter(uint64_t config, int groupFd) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = config;
+    attr.read_format = PERF_FORMAT_GROUP;
+    attr.disabled = groupFd < 0 ? 1 : 0;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, groupFd, 0));
+}
+
+/**
+ * @brief Counter group of one thread; members the CPU lacks are skipped
+ */
+class ThreadCounters {
+public:
+    ThreadCounters() : m_leader(-1), m_opened(false), m_members(0) {
+        for (int c = 0; c < COUNTER_COUNT; ++c) {
+            m_fds[c] = -1;
+            m_slot[c] = -1;
+        }
+    }
+
+    ~ThreadCounters() {
+        for (int c = 0; c < COUNTER_COUNT; ++c) {
+            if (m_fds[c] >= 0) {
+                close(m_fds[c]);
+            }
+        }
+    }
+
+    bool read(PerfSample& sample) {
+        if (!m_opened) {
+            open();
+        }
+        if (m_leader < 0) {
+            return false;
+        }
+        uint64_t buffer[1 + COUNTER_COUNT];
+        const ssize_t bytes = static_cast<ssize_t>(sizeof(uint64_t)) * (1 + m_members);
+        if (::read(m_leader, buffer, sizeof(buffer)) != bytes) {
+            return false;
+        }
+        sample.cycles = m_slot[COUNTER_CYCLES] >= 0 ? buffer[1 + m_slot[COUNTER_CYCLES]] : 0;
+        sample.instructions =
+            m_slot[COUNTER_INSTRUCTIONS] >= 0 ? buffer[1 + m_slot[COUNTER_INSTRUCTIONS]] : 0;
+        sample.llcMisses = m_slot[COUNTER_LLC_MISSES] >= 0 ? buffer[1 + m_slot[COUNTER_LLC_MISSES]] : 0;
+        return true;
+    }
+
+private:
+    void open() {
+        static const uint64_t configs[COUNTER_COUNT] = {
+            PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES
+        };
+        m_opened = true;
+        for (int c = 0; c < COUNTER_COUNT; ++c) {
+            const int fd = openCounter(configs[c], m_leader);
+            if (fd < 0) {
+                continue;
+            }
+            m_fds[c] = fd;
+            m_slot[c] = m_members++;
+            if (m_leader < 0) {
+                m_leader = fd;
+            }
+        }
+        if (m_leader >= 0) {
+            ioctl(m_leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+        }
+    }
+
+    int m_leader;
+    bool m_opened;
+    int m_members;
+    int m_fds[COUNTER_COUNT];
+    int m_slot[COUNTER_COUNT];          ///< Position in the group read, -1 if missing
+};
+
+thread_local ThreadCounters t_counters;
+thread_local PerfScope* t_scope = nullptr;
+
+bool validStage(XFactory::PerfStage stage) {
+    return stage >= 0 && stage < XFactory::PERF_STAGE_COUNT;
+}
+
+} // namespace
+
+bool PerfRead(PerfSample& sample) {
+    return t_counters.read(sample);
+}
+
+PerfScope::PerfScope(XFactory::PerfStage stage)
+    : m_stage(stage), m_active(false), m_parent(nullptr) {
+    if (!g_perfEnabled.load(std::memory_order_relaxed) || !validStage(stage) || !PerfRead(m_start)) {
+        return;
+    }
+    memset(&m_nested, 0, sizeof(m_nested));
+    m_active = true;
+    m_parent = t_scope;
+    t_scope = this;
+}
+
+PerfScope::~PerfScope() {
+    if (!m_active) {
+        return;
+    }
+    t_scope = m_parent;
+    PerfSample end;
+    if (!PerfRead(end)) {
+        return;
+    }
+    const uint64_t total[COUNTER_COUNT] = {
+        end.cycles - m_start.cycles,
+        end.instructions - m_start.instructions,
+        end.llcMisses - m_start.llcMisses
+    };
+    const uint64_t nested[COUNTER_COUNT] = {
+        m_nested.cycles, m_nested.instructions, m_nested.llcMisses
+    };
+    StageCounters& stage = g_stages[m_stage];
+    stage.samples.fetch_add(1, std::memory_order_relaxed);
+    for (int c = 0; c < COUNTER_COUNT; ++c) {
+        stage.values[c].fetch_add(total[c] > nested[c] ? total[c] - nested[c] : 0,
+                                  std::memory_order_relaxed);
+    }
+    if (m_parent) {
+        m_parent->m_nested.cycles += total[COUNTER_CYCLES];
+        m_parent->m_nested.instructions += total[COUNTER_INSTRUCTIONS];
+        m_parent->m_nested.llcMisses += total[COUNTER_LLC_MISSES];
+    }
+}
+
+bool PerfSetEnabled(bool enable) {
+    if (enable) {
+        // Probe on the calling thread: a refusal here is a refusal everywhere
+        PerfSample sample;
+        if (!PerfRead(sample)) {
+            return false;
+        }
+    }
+    g_perfEnabled.store(enable, std::memory_order_relaxed);
+    return true;
+}
+
+bool PerfEnabled() {
+    return g_perfEnabled.load(std::memory_order_relaxed);
+}
+
+bool PerfGetStats(XFactory::PerfStage stage, XFactory::PerfStats& stats) {
+    if (!validStage(stage)) {
+        return false;
+    }
+    const StageCounters& counters = g_stages[stage];
+    stats.samples = counters.samples.load(std::memory_order_relaxed);
+    stats.cycles = counters.values[COUNTER_CYCLES].load(std::memory_order_relaxed);
+    stats.instructions = counters.values[COUNTER_INSTRUCTIONS].load(std::memory_order_relaxed);
+    stats.llcMisses = counters.values[COUNTER_LLC_MISSES].load(std::memory_order_relaxed);
+    return true;
+}
+
+void PerfResetStats() {
+    for (int s = 0; s < XFactory::PERF_STAGE_COUNT; ++s) {
+        g_stages[s].samples.store(0, std::memory_order_relaxed);
+        for (int c = 0; c < COUNTER_COUNT; ++c) {
+            g_stages[s].values[c].store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+#else
+
+bool PerfSetEnabled(bool enable) {
+    return !enable;
+}
+
+bool PerfEnabled() {
+    return false;
+}
+
+bool PerfGetStats(XFactory::PerfStage, XFactory::PerfStats&) {
+    return false;
+}
+
+void PerfResetStats() {
+}
+
+#endif
+
+} // namespace Internal
+} // namespace HX
@@ -0,0 +1,82 @@
+// ============================================================================
+// perf_counters.h
+// ============================================================================
+
+/**
+ * @file perf_counters.h
+ * @brief Hardware performance counters around pipeline stages
+ * @version 2.1.0
+ *
+ * This header is INTERNAL to hubx.dll. A PerfScope reads the calling
+ * thread's cycle, instruction and LLC-miss counters (perf_event_open, one
+ * group per thread, opened on first use) on entry and exit and adds the
+ * difference to its stage. Nested scopes are subtracted from the scope
+ * around them, so every stage counts its own code only.
+ *
+ * Without HUBX_WITH_PERF_COUNTERS (a Linux-only build option) PerfScope
+ * is an empty class and the XFactory entry points report the counters as
+ * unavailable.
+ */
+
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include "xfactory.h"
+#include <atomic>
+#include <cstdint>
+
+namespace HX {
+namespace Internal {
+
+// XFactory entry points
+bool PerfSetEnabled(bool enable);
+bool PerfEnabled();
+bool PerfGetStats(XFactory::PerfStage stage, XFactory::PerfStats& stats);
+void PerfResetStats();
+
+#ifdef HUBX_WITH_PERF_COUNTERS
+
+extern std::atomic<bool> g_perfEnabled;
+
+/// Counter values of the calling thread
+struct PerfSample {
+    uint64_t cycles;
+    uint64_t instructions;
+    uint64_t llcMisses;
+};
+
+/// false if the thread has no counters (kernel refused them)
+bool PerfRead(PerfSample& sample);
+
+/**
+ * @brief Count the enclosing scope as one region of a stage
+ */
+class PerfScope {
+public:
+    explicit PerfScope(XFactory::PerfStage stage);
+    ~PerfScope();
+
+private:
+    XFactory::PerfStage m_stage;
+    bool m_active;
+    PerfSample m_start;
+    PerfSample m_nested;        ///< Counted by scopes inside this one
+    PerfScope* m_parent;
+
+    PerfScope(const PerfScope&) = delete;
+    PerfScope& operator=(const PerfScope&) = delete;
+};
+
+#else
+
+class PerfScope {
+public:
+    explicit PerfScope(XFactory::PerfStage) {}
+};
+
+#endif // HUBX_WITH_PERF_COUNTERS
+
+} // namespace Internal
+} // namespace HX
+
+#endif // PERF_COUNTERS_H
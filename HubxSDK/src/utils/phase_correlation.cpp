@@ -0,0 +1,313 @@
+// ============================================================================
+// phase_correlation.cpp
+// ============================================================================
+
+/**
+ * @file phase_correlation.cpp
+ * @brief Radix-2 FFT, 2-D transforms on the pool and shift estimation
+ * @version 2.1.0
+ */
+
+#include "phase_correlation.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace HX {
+namespace Internal {
+
+namespace {
+
+typedef std::complex<float> Complex;
+typedef std::vector<Complex> Twiddles;
+
+/// Phase correlation peaks re-scored by cross-correlation
+const int CANDIDATES = 5;
+
+std::mutex g_fftMutex;
+FFTFunction g_fft = nullptr;
+void* g_fftUser = nullptr;
+std::map<int, std::shared_ptr<const Twiddles> > g_twiddles;
+
+bool isPowerOfTwo(int n) {
+    return n > 0 && (n & (n - 1)) == 0;
+}
+
+int paddedSize(int n) {
+    int size = 1;
+    while (size < 2 * n) {
+        size <<= 1;
+    }
+    return size;
+}
+
+/**
+ * @brief exp(-2 pi i k / n) for k < n / 2, computed once per length
+ */
+std::shared_ptr<const Twiddles> twiddles(int n) {
+    std::lock_guard<std::mutex> lock(g_fftMutex);
+    std::shared_ptr<const Twiddles>& table = g_twiddles[n];
+    if (!table) {
+        std::shared_ptr<Twiddles> w = std::make_shared<Twiddles>(std::max(n / 2, 1));
+        for (int k = 0; k < n / 2; ++k) {
+            const double angle = -2.0 * 3.14159265358979323846 * k / n;
+            (*w)[k] = Complex(static_cast<float>(std::cos(angle)), static_cast<float>(std::sin(angle)));
+        }
+        table = w;
+    }
+    return table;
+}
+
+void fftRadix2(Complex* x, int n, const Complex* w, bool inverse) {
+    for (int i = 1, j = 0; i < n; ++i) {
+        int bit = n >> 1;
+        for (; j & bit; bit >>= 1) {
+            j ^= bit;
+        }
+        j ^= bit;
+        if (i < j) {
+            std::swap(x[i], x[j]);
+        }
+    }
+    for (int len = 2; len <= n; len <<= 1) {
+        const int half = len / 2;
+        const int step = n / len;
+        for (int i = 0; i < n; i += len) {
+            for (int k = 0; k < half; ++k) {
+                const Complex tw = inverse ? std::conj(w[k * step]) : w[k * step];
+                const Complex t = tw * x[i + k + half];
+                const Complex u = x[i + k];
+                x[i + k] = u + t;
+                x[i + k + half] = u - t;
+            }
+        }
+    }
+}
+
+/**
+ * @brief One 1-D transform, user-supplied or built-in
+ */
+class Transform {
+public:
+    explicit Transform(int n) : m_n(n) {
+        std::lock_guard<std::mutex> lock(g_fftMutex);
+        m_fft = g_fft;
+        m_user = g_fftUser;
+    }
+    
+    void run(Complex* data, bool inverse) {
+        if (m_fft) {
+            m_fft(reinterpret_cast<float*>(data), m_n, inverse ? 1 : 0, m_user);
+            return;
+        }
+        if (!m_twiddles) {
+            m_twiddles = twiddles(m_n);
+        }
+        fftRadix2(data, m_n, m_twiddles->data(), inverse);
+    }
+    
+private:
+    int m_n;
+    FFTFunction m_fft;
+    void* m_user;
+    std::shared_ptr<const Twiddles> m_twiddles;
+};
+
+/**
+ * @brief Mean-free copy, tapered towards the edges, into a padded plane
+ */
+void loadPlane(const float* image, int width, int height, int padWidth, int padHeight,
+               std::vector<Complex>& plane) {
+    double sum = 0.0;
+    for (size_t i = 0; i < static_cast<size_t>(width) * height; ++i) {
+        sum += image[i];
+    }
+    const float mean = static_cast<float>(sum / (static_cast<double>(width) * height));
+    
+    // Tukey window: flat except for a cosine over the outer eighth, so
+    // content near a strip edge (where detectors overlap) still counts
+    std::vector<float> wx(width), wy(height);
+    for (int pass = 0; pass < 2; ++pass) {
+        std::vector<float>& w = pass ? wy : wx;
+        const int n = static_cast<int>(w.size());
+        const int taper = std::max(1, n / 8);
+        for (int i = 0; i < n; ++i) {
+            const int edge = std::min(i, n - 1 - i);
+            w[i] = edge >= taper ? 1.0f
+                 : 0.5f - 0.5f * static_cast<float>(std::cos(3.14159265358979323846 * (edge + 0.5) / taper));
+        }
+    }
+    
+    plane.assign(static_cast<size_t>(padWidth) * padHeight, Complex(0.0f, 0.0f));
+    for (int y = 0; y < height; ++y) {
+        const float* row = image + static_cast<size_t>(y) * width;
+        Complex* out = plane.data() + static_cast<size_t>(y) * padWidth;
+        for (int x = 0; x < width; ++x) {
+            out[x] = Complex((row[x] - mean) * wx[x] * wy[y], 0.0f);
+        }
+    }
+}
+
+/**
+ * @brief Normalized cross-correlation of b(u) against a(u - shift)
+ */
+float overlapNCC(const float* a, const float* b, int width, int height, int dx, int dy, int& count) {
+    const int x0 = std::max(0, dx);
+    const int x1 = std::min(width, width + dx);
+    const int y0 = std::max(0, dy);
+    const int y1 = std::min(height, height + dy);
+    count = std::max(0, x1 - x0) * std::max(0, y1 - y0);
+    if (count == 0) {
+        return -1.0f;
+    }
+    
+    double sa = 0.0, sb = 0.0, saa = 0.0, sbb = 0.0, sab = 0.0;
+    for (int y = y0; y < y1; ++y) {
+        const float* rb = b + static_cast<size_t>(y) * width;
+        const float* ra = a + static_cast<size_t>(y - dy) * width - dx;
+        for (int x = x0; x < x1; ++x) {
+            const double va = ra[x];
+            const double vb = rb[x];
+            sa += va;
+            sb += vb;
+            saa += va * va;
+            sbb += vb * vb;
+            sab += va * vb;
+        }
+    }
+    const double n = count;
+    const double cov = sab - sa * sb / n;
+    const double var = (saa - sa * sa / n) * (sbb - sb * sb / n);
+    return var > 0.0 ? static_cast<float>(cov / std::sqrt(var)) : -1.0f;
+}
+
+struct Peak {
+    float value;
+    int x;
+    int y;
+};
+
+} // namespace
+
+void setFFT(FFTFunction fft, void* user) {
+    std::lock_guard<std::mutex> lock(g_fftMutex);
+    g_fft = fft;
+    g_fftUser = user;
+}
+
+bool fft2D(std::complex<float>* data, int width, int height, bool inverse) {
+    if (!data || !isPowerOfTwo(width) || !isPowerOfTwo(height)) {
+        return false;
+    }
+    
+    ThreadPool& pool = ThreadPool::instance();
+    pool.parallelRows(height, width, [&](int firstRow, int endRow) {
+        Transform transform(width);
+        for (int y = firstRow; y < endRow; ++y) {
+            transform.run(data + static_cast<size_t>(y) * width, inverse);
+        }
+    });
+    
+    // Columns are gathered into a contiguous line, one band of columns per thread
+    pool.parallelRows(width, height, [&](int firstColumn, int endColumn) {
+        Transform transform(height);
+        std::vector<Complex> column(height);
+        for (int x = firstColumn; x < endColumn; ++x) {
+            for (int y = 0; y < height; ++y) {
+                column[y] = data[static_cast<size_t>(y) * width + x];
+            }
+            transform.run(column.data(), inverse);
+            for (int y = 0; y < height; ++y) {
+                data[static_cast<size_t>(y) * width + x] = column[y];
+            }
+        }
+    });
+    return true;
+}
+
+bool registerImages(const float* a, const float* b, int width, int height,
+                    int minOverlap, ImageShift& shift) {
+    if (!a || !b || width <= 0 || height <= 0) {
+        return false;
+    }
+    
+    // Twice the size keeps the correlation from wrapping
+    const int padWidth = paddedSize(width);
+    const int padHeight = paddedSize(height);
+    std::vector<Complex> fa, fb;
+    loadPlane(a, width, height, padWidth, padHeight, fa);
+    loadPlane(b, width, height, padWidth, padHeight, fb);
+    fft2D(fa.data(), padWidth, padHeight, false);
+    fft2D(fb.data(), padWidth, padHeight, false);
+    
+    // Cross-power spectrum, magnitude removed: only the phase difference is left
+    float largest = 0.0f;
+    for (size_t i = 0; i < fa.size(); ++i) {
+        largest = std::max(largest, std::abs(fa[i]) * std::abs(fb[i]));
+    }
+    const float floor = largest * 1e-6f + 1e-30f;
+    for (size_t i = 0; i < fa.size(); ++i) {
+        const Complex cross = fb[i] * std::conj(fa[i]);
+        const float magnitude = std::abs(cross);
+        fa[i] = magnitude > floor ? cross / magnitude : Complex(0.0f, 0.0f);
+    }
+    fft2D(fa.data(), padWidth, padHeight, true);
+    
+    // Strongest local maxima of the correlation surface
+    std::vector<Peak> peaks;
+    const float scale = 1.0f / (static_cast<float>(padWidth) * padHeight);
+    for (int y = 0; y < padHeight; ++y) {
+        for (int x = 0; x < padWidth; ++x) {
+            const float v = fa[static_cast<size_t>(y) * padWidth + x].real() * scale;
+            if (peaks.size() == CANDIDATES && v <= peaks.back().value) {
+                continue;
+            }
+            bool isMax = true;
+            for (int ny = -1; ny <= 1 && isMax; ++ny) {
+                for (int nx = -1; nx <= 1; ++nx) {
+                    const int qx = (x + nx + padWidth) % padWidth;
+                    const int qy = (y + ny + padHeight) % padHeight;
+                    if ((nx || ny) && fa[static_cast<size_t>(qy) * padWidth + qx].real() * scale > v) {
+                        isMax = false;
+                        break;
+                    }
+                }
+            }
+            if (!isMax) {
+                continue;
+            }
+            Peak peak = { v, x, y };
+            if (peaks.size() == CANDIDATES) {
+                peaks.pop_back();
+            }
+            peaks.insert(std::upper_bound(peaks.begin(), peaks.end(), peak,
+                                          [](const Peak& l, const Peak& r) { return l.value > r.value; }),
+                         peak);
+        }
+    }
+    
+    bool found = false;
+    for (size_t i = 0; i < peaks.size(); ++i) {
+        const int dx = peaks[i].x < padWidth / 2 ? peaks[i].x : peaks[i].x - padWidth;
+        const int dy = peaks[i].y < padHeight / 2 ? peaks[i].y : peaks[i].y - padHeight;
+        int count = 0;
+        const float ncc = overlapNCC(a, b, width, height, dx, dy, count);
+        if (count < std::max(minOverlap, 1) || (found && ncc <= shift.ncc)) {
+            continue;
+        }
+        shift.dx = dx;
+        shift.dy = dy;
+        shift.peak = peaks[i].value;
+        shift.ncc = ncc;
+        shift.overlap = count;
+        found = true;
+    }
+    return found;
+}
+
+} // namespace Internal
+} // namespace HX
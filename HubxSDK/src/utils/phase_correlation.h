@@ -0,0 +1,87 @@
+// ============================================================================
+// phase_correlation.h
+// ============================================================================
+
+/**
+ * @file phase_correlation.h
+ * @brief Translation between two images by phase correlation
+ * @version 2.1.0
+ *
+ * This header is INTERNAL to hubx.dll. Both images are windowed, padded
+ * to a power of two at least twice their size and transformed; the
+ * normalized cross-power spectrum transforms back to a surface that peaks
+ * at the shift. The strongest peaks are then scored by normalized
+ * cross-correlation over the pixels that overlap at that shift, which
+ * rejects the aliases periodic structure produces.
+ *
+ * The 1-D transform is pluggable (setFFT()); the built-in one is radix-2
+ * with twiddle tables cached per length. Rows and columns of the 2-D
+ * transform run in bands on the shared pool.
+ */
+
+#ifndef PHASE_CORRELATION_H
+#define PHASE_CORRELATION_H
+
+#include <complex>
+#include <cstdint>
+
+namespace HX {
+namespace Internal {
+
+/**
+ * @brief In-place complex FFT of n interleaved (re, im) floats
+ * @param data 2 * n floats
+ * @param n Length, a power of two
+ * @param inverse Nonzero for the inverse transform; no 1/n scaling either way
+ * @param user Pointer passed to setFFT()
+ * @note Called from several pool threads at once
+ */
+typedef void (*FFTFunction)(float* data, int n, int inverse, void* user);
+
+/**
+ * @brief Replace the built-in FFT, process-wide
+ * @param fft Transform, or nullptr for the built-in one
+ * @param user Passed to every call
+ */
+void setFFT(FFTFunction fft, void* user);
+
+/**
+ * @brief 2-D FFT in place, rows then columns
+ * @param data width * height values, row-major
+ * @param width Power of two
+ * @param height Power of two
+ * @param inverse true for the inverse transform (unscaled)
+ * @return false if a size is not a power of two
+ */
+bool fft2D(std::complex<float>* data, int width, int height, bool inverse);
+
+/**
+ * @brief Shift found by registerImages()
+ *
+ * b(x, y) matches a(x - dx, y - dy).
+ */
+struct ImageShift {
+    int dx;
+    int dy;
+    float peak;         ///< Phase correlation peak, 1 for a perfect match
+    float ncc;          ///< Normalized cross-correlation of the overlap, -1 to 1
+    int overlap;        ///< Pixels compared for ncc
+};
+
+/**
+ * @brief Find the translation between two images of the same size
+ * @param a First image, width * height
+ * @param b Second image, width * height
+ * @param width Image width
+ * @param height Image height
+ * @param minOverlap Fewest overlapping pixels a candidate shift may leave
+ * @param shift Result
+ * @return false if no candidate leaves minOverlap pixels
+ */
+bool registerImages(const float* a, const float* b, int width, int height,
+                    int minOverlap, ImageShift& shift);
+
+} // namespace Internal
+} // namespace HX
+
+#endif // PHASE_CORRELATION_H
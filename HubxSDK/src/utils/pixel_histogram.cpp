@@ -0,0 +1,157 @@
+// ============================================================================
+// pixel_histogram.cpp
+// ============================================================================
+
+/**
+ * @file pixel_histogram.cpp
+ * @brief One-pass threaded histogram of 16-bit frames
+ * @version 2.1.0
+ */
+
+#include "pixel_histogram.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <cmath>
+
+namespace HX {
+namespace Internal {
+
+namespace {
+    // A band must read enough pixels to pay for clearing and merging its
+    // 256 KB sub-histogram
+    const uint64_t MIN_BAND_SAMPLES = 1u << 18;
+
+    // Keeps every uint32_t sub-histogram counter from wrapping
+    const uint64_t MAX_BAND_SAMPLES = 1u << 31;
+}
+
+PixelHistogram::PixelHistogram()
+    : m_bins(BINS, 0)
+    , m_samples(0)
+    , m_min(0)
+    , m_max(0)
+    , m_sum(0.0)
+    , m_sumSquares(0.0)
+{
+}
+
+uint32_t PixelHistogram::stepFor(uint64_t pixels, uint64_t samples) {
+    if (samples == 0 || pixels <= samples) {
+        return 1;
+    }
+    return static_cast<uint32_t>(std::max(1.0, std::sqrt(static_cast<double>(pixels) / samples)));
+}
+
+void PixelHistogram::build(const uint16_t* data, uint32_t width, uint32_t height, uint32_t step) {
+    std::fill(m_bins.begin(), m_bins.end(), 0);
+    m_samples = 0;
+    m_min = 0;
+    m_max = 0;
+    m_sum = 0.0;
+    m_sumSquares = 0.0;
+    if (!data || width == 0 || height == 0) {
+        return;
+    }
+
+    // Sampled rows and columns start half a step in, like the auto-window
+    step = std::max<uint32_t>(1, step);
+    const uint32_t first = step > 1 ? step / 2 : 0;
+    const uint32_t rows = first < height ? (height - first + step - 1) / step : 0;
+    const uint32_t cols = first < width ? (width - first + step - 1) / step : 0;
+    const uint64_t samples = static_cast<uint64_t>(rows) * cols;
+    if (samples == 0) {
+        return;
+    }
+
+    ThreadPool& pool = ThreadPool::instance();
+    const uint64_t byPool = std::min<uint64_t>(pool.threadCount(), samples / MIN_BAND_SAMPLES);
+    const uint64_t bySize = (samples + MAX_BAND_SAMPLES - 1) / MAX_BAND_SAMPLES;
+    const int bands = static_cast<int>(std::min<uint64_t>(std::max<uint64_t>(std::max<uint64_t>(byPool, bySize), 1),
+                                                          rows));
+
+    std::vector<std::vector<uint32_t> > partial(bands);
+    pool.run(bands, [&](int band) {
+        std::vector<uint32_t>& bins = partial[band];
+        bins.assign(BINS, 0);
+        const uint32_t begin = static_cast<uint32_t>(static_cast<uint64_t>(rows) * band / bands);
+        const uint32_t end = static_cast<uint32_t>(static_cast<uint64_t>(rows) * (band + 1) / bands);
+        for (uint32_t r = begin; r < end; ++r) {
+            const uint16_t* row = data + static_cast<size_t>(first + r * step) * width + first;
+            if (step == 1) {
+                for (uint32_t c = 0; c < cols; ++c) {
+                    ++bins[row[c]];
+                }
+            } else {
+                for (uint32_t c = 0; c < cols; ++c) {
+                    ++bins[row[static_cast<size_t>(c) * step]];
+                }
+            }
+        }
+    });
+
+    for (int band = 0; band < bands; ++band) {
+        const std::vector<uint32_t>& bins = partial[band];
+        for (uint32_t v = 0; v < BINS; ++v) {
+            m_bins[v] += bins[v];
+        }
+    }
+
+    // Everything else comes from the bins
+    m_samples = samples;
+    bool seen = false;
+    for (uint32_t v = 0; v < BINS; ++v) {
+        const uint64_t n = m_bins[v];
+        if (n == 0) {
+            continue;
+        }
+        if (!seen) {
+            m_min = v;
+            seen = true;
+        }
+        m_max = v;
+        m_sum += static_cast<double>(n) * v;
+        m_sumSquares += static_cast<double>(n) * v * v;
+    }
+}
+
+double PixelHistogram::mean() const {
+    return m_samples ? m_sum / m_samples : 0.0;
+}
+
+double PixelHistogram::stdDev() const {
+    if (m_samples == 0) {
+        return 0.0;
+    }
+    const double m = mean();
+    return std::sqrt(std::max(0.0, m_sumSquares / m_samples - m * m));
+}
+
+void PixelHistogram::classCounts(const uint16_t* thresholds, int classes, uint64_t* counts) const {
+    if (!counts || classes <= 0) {
+        return;
+    }
+    uint32_t v = 0;
+    for (int c = 0; c < classes; ++c) {
+        const uint32_t end = (c < classes - 1 && thresholds) ? std::max<uint32_t>(thresholds[c], v) : BINS;
+        uint64_t n = 0;
+        for (; v < end; ++v) {
+            n += m_bins[v];
+        }
+        counts[c] = n;
+    }
+}
+
+uint32_t PixelHistogram::percentile(double fraction) const {
+    const double target = std::max(0.0, std::min(1.0, fraction)) * m_samples;
+    uint64_t count = 0;
+    for (uint32_t v = 0; v < BINS; ++v) {
+        count += m_bins[v];
+        if (count > 0 && count >= target) {
+            return v;
+        }
+    }
+    return m_max;
+}
+
+} // namespace Internal
+} // namespace HX
@@ -0,0 +1,79 @@
+// ============================================================================
+// pixel_histogram.h
+// ============================================================================
+
+/**
+ * @file pixel_histogram.h
+ * @brief One-pass threaded histogram of 16-bit frames
+ * @version 2.1.0
+ *
+ * This header is INTERNAL to hubx.dll. Every pool band scatters into its
+ * own full-resolution sub-histogram, so bands never share a counter; the
+ * sub-histograms are summed once at the end. Moments, extremes and
+ * percentiles are then read from the 65536 bins rather than from the
+ * pixels, so evaluating another threshold set costs O(bins), not a pass.
+ */
+
+#ifndef PIXEL_HISTOGRAM_H
+#define PIXEL_HISTOGRAM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace HX {
+namespace Internal {
+
+/**
+ * @class PixelHistogram
+ * @brief Counts of every 16-bit value in a frame, or a sample of it
+ */
+class PixelHistogram {
+public:
+    static const uint32_t BINS = 65536;
+
+    PixelHistogram();
+
+    /**
+     * @brief Count the pixels of a frame, replacing the previous counts
+     * @param data Frame, width * height values
+     * @param step Sample every step-th row and every step-th column of it
+     *        (1 = every pixel), so about 1 / step^2 of the pixels are read
+     */
+    void build(const uint16_t* data, uint32_t width, uint32_t height, uint32_t step = 1);
+
+    /// Sample step that reads about @p samples pixels of a frame (at least 1)
+    static uint32_t stepFor(uint64_t pixels, uint64_t samples);
+
+    const std::vector<uint64_t>& bins() const { return m_bins; }
+    uint64_t samples() const { return m_samples; }
+    uint32_t minValue() const { return m_min; }
+    uint32_t maxValue() const { return m_max; }
+    double mean() const;
+    double stdDev() const;
+
+    /**
+     * @brief Samples in each class split at ascending thresholds
+     * @param counts Class c counts values in [thresholds[c - 1], thresholds[c]),
+     *        classes - 1 thresholds, classes entries
+     */
+    void classCounts(const uint16_t* thresholds, int classes, uint64_t* counts) const;
+
+    /**
+     * @brief Smallest value v with at least fraction * samples() at or below it
+     */
+    uint32_t percentile(double fraction) const;
+
+private:
+    std::vector<uint64_t> m_bins;
+    uint64_t m_samples;
+    uint32_t m_min;
+    uint32_t m_max;
+    double m_sum;
+    double m_sumSquares;
+};
+
+} // namespace Internal
+} // namespace HX
+
+#endif // PIXEL_HISTOGRAM_H
@@ -0,0 +1,116 @@
+// ============================================================================
+// pixel_unpack.cpp
+// ============================================================================
+
+/**
+ * @file pixel_unpack.cpp
+ * @brief Vector unpacking of 18 and 20 bit wire lines
+ * @version 2.1.0
+ */
+
+#include "pixel_unpack.h"
+#include "cpu_features.h"
+
+namespace HX {
+namespace Internal {
+
+namespace {
+
+const KernelFamily g_unpackKernels("pixel_unpack", XFactory::CPU_SSE42);
+
+#if defined(HX_ARCH_X86)
+
+// Each 32-bit lane gathers the 3 bytes its pixel sits in; the multiply
+// lines the lanes up so one shift right leaves each pixel at bit 0.
+//   20 bit: pixels at bytes 0, 2, 5, 7 (+10 per group), bit offsets 0 4 0 4
+//   18 bit: pixels at bytes 0, 2, 4, 6 (+9 per group), bit offsets 0 2 4 6
+struct UnpackLayout {
+    uint32_t groupBytes;    ///< Bytes per 4 pixels
+    int8_t gather[16];
+    uint32_t align[4];      ///< 1 << (maxShift - shift)
+    uint32_t maxShift;
+    uint32_t mask;
+};
+
+const UnpackLayout LAYOUT_20 = {
+    10, { 0, 1, 2, -1, 2, 3, 4, -1, 5, 6, 7, -1, 7, 8, 9, -1 }, { 16, 1, 16, 1 }, 4, 0xFFFFF
+};
+const UnpackLayout LAYOUT_18 = {
+    9, { 0, 1, 2, -1, 2, 3, 4, -1, 4, 5, 6, -1, 6, 7, 8, -1 }, { 64, 16, 4, 1 }, 6, 0x3FFFF
+};
+
+HX_TARGET("sse4.2")
+inline __m128i unpack4(const uint8_t* p, __m128i gather, __m128i align, __m128i shift,
+                       __m128i mask, __m128i clip) {
+    __m128i v = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)), gather);
+    v = _mm_srl_epi32(_mm_mullo_epi32(v, align), shift);
+    return _mm_min_epu32(_mm_and_si128(v, mask), clip);
+}
+
+HX_TARGET("sse4.2")
+uint32_t unpackSse42(const uint8_t* in, uint32_t inBytes, uint16_t* out, uint32_t width,
+                     const UnpackLayout& layout, uint32_t clip) {
+    const __m128i gather = _mm_loadu_si128(reinterpret_cast<const __m128i*>(layout.gather));
+    const __m128i align = _mm_loadu_si128(reinterpret_cast<const __m128i*>(layout.align));
+    const __m128i shift = _mm_cvtsi32_si128(static_cast<int>(layout.maxShift));
+    const __m128i mask = _mm_set1_epi32(static_cast<int>(layout.mask));
+    const __m128i limit = _mm_set1_epi32(static_cast<int>(clip));
+    const uint32_t step = layout.groupBytes;
+    uint32_t x = 0;
+
+    // The second load reads 16 bytes from the second group
+    for (; x + 8 <= width && (x / 4) * step + step + 16 <= inBytes; x += 8) {
+        const uint8_t* p = in + (x / 4) * step;
+        const __m128i lo = unpack4(p, gather, align, shift, mask, limit);
+        const __m128i hi = unpack4(p + step, gather, align, shift, mask, limit);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x), _mm_packus_epi32(lo, hi));
+    }
+    return x;
+}
+
+HX_TARGET("sse4.2")
+uint32_t unpackSse42(const uint8_t* in, uint32_t inBytes, uint32_t* out, uint32_t width,
+                     const UnpackLayout& layout, uint32_t clip) {
+    const __m128i gather = _mm_loadu_si128(reinterpret_cast<const __m128i*>(layout.gather));
+    const __m128i align = _mm_loadu_si128(reinterpret_cast<const __m128i*>(layout.align));
+    const __m128i shift = _mm_cvtsi32_si128(static_cast<int>(layout.maxShift));
+    const __m128i mask = _mm_set1_epi32(static_cast<int>(layout.mask));
+    const __m128i limit = _mm_set1_epi32(static_cast<int>(clip));
+    const uint32_t step = layout.groupBytes;
+    uint32_t x = 0;
+
+    for (; x + 4 <= width && (x / 4) * step + 16 <= inBytes; x += 4) {
+        const __m128i v = unpack4(in + (x / 4) * step, gather, align, shift, mask, limit);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x), v);
+    }
+    return x;
+}
+
+#endif // HX_ARCH_X86
+
+template <typename Out>
+uint32_t unpackVector(const uint8_t* in, uint32_t inBytes, Out* out,
+                      uint32_t width, uint32_t bits, uint32_t clip) {
+#if defined(HX_ARCH_X86)
+    if ((bits == 20 || bits == 18) && g_unpackKernels.isa() == XFactory::CPU_SSE42) {
+        return unpackSse42(in, inBytes, out, width, bits == 20 ? LAYOUT_20 : LAYOUT_18, clip);
+    }
+#endif
+    (void)in; (void)inBytes; (void)out; (void)width; (void)bits; (void)clip;
+    return 0;
+}
+
+} // namespace
+
+uint32_t unpackLineVector(const uint8_t* in, uint32_t inBytes, uint16_t* out,
+                          uint32_t width, uint32_t bits, uint32_t clip) {
+    return unpackVector(in, inBytes, out, width, bits, clip);
+}
+
+uint32_t unpackLineVector(const uint8_t* in, uint32_t inBytes, uint32_t* out,
+                          uint32_t width, uint32_t bits, uint32_t clip) {
+    return unpackVector(in, inBytes, out, width, bits, clip);
+}
+
+} // namespace Internal
+} // namespace HX
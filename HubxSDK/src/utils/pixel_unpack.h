@@ -0,0 +1,139 @@
+// ============================================================================
+// pixel_unpack.h
+// ============================================================================
+
+/**
+ * @file pixel_unpack.h
+ * @brief Unpack bit-packed detector lines into 16/32-bit containers
+ * @version 2.1.0
+ *
+ * This header is INTERNAL to hubx.dll. Wire lines carry pixels as a
+ * little-endian bit stream of 17-24 bits each (18 and 20 bit detectors
+ * pack 4 pixels in 9 bytes and 2 pixels in 5 bytes respectively).
+ */
+
+#ifndef PIXEL_UNPACK_H
+#define PIXEL_UNPACK_H
+
+#include <cstdint>
+#include <cstring>
+
+namespace HX {
+namespace Internal {
+
+/**
+ * @brief Bytes a packed line of @p width pixels occupies on the wire
+ */
+inline uint32_t packedLineBytes(uint32_t width, uint32_t bits) {
+    return static_cast<uint32_t>((static_cast<uint64_t>(width) * bits + 7) / 8);
+}
+
+inline uint64_t loadLE64(const uint8_t* p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;   // all supported targets are little-endian
+}
+
+/**
+ * @brief Generic extractor: one 64-bit window load per pixel
+ *
+ * The window must not run past the line, so the last few pixels take
+ * the byte-wise path.
+ */
+template <typename Out>
+inline void unpackGeneric(const uint8_t* in, uint32_t inBytes, Out* out,
+                          uint32_t first, uint32_t width, uint32_t bits, uint32_t clip) {
+    const uint32_t mask = (1u << bits) - 1;
+    uint32_t x = first;
+
+    for (; x < width; ++x) {
+        uint64_t bit = static_cast<uint64_t>(x) * bits;
+        size_t byte = static_cast<size_t>(bit >> 3);
+        uint32_t v;
+        if (byte + 8 <= inBytes) {
+            v = static_cast<uint32_t>(loadLE64(in + byte) >> (bit & 7)) & mask;
+        } else {
+            uint64_t window = 0;
+            for (size_t i = 0; byte + i < inBytes && i < 8; ++i) {
+                window |= uint64_t(in[byte + i]) << (8 * i);
+            }
+            v = static_cast<uint32_t>(window >> (bit & 7)) & mask;
+        }
+        out[x] = static_cast<Out>(v > clip ? clip : v);
+    }
+}
+
+/**
+ * @brief Unpack the leading pixels of an 18 or 20 bit line with vector code
+ * @return Pixels written (a multiple of 4), 0 if no vector kernel applies
+ */
+uint32_t unpackLineVector(const uint8_t* in, uint32_t inBytes, uint16_t* out,
+                          uint32_t width, uint32_t bits, uint32_t clip);
+uint32_t unpackLineVector(const uint8_t* in, uint32_t inBytes, uint32_t* out,
+                          uint32_t width, uint32_t bits, uint32_t clip);
+
+/**
+ * @brief Unpack one line
+ * @param in Packed wire line
+ * @param inBytes Wire line length (packedLineBytes)
+ * @param out Output pixels, @p width elements
+ * @param width Pixels per line
+ * @param bits Bits per pixel on the wire (17-24)
+ * @param clip Largest output value (saturates, 0xFFFF for 16-bit output)
+ */
+template <typename Out>
+inline void unpackLine(const uint8_t* in, uint32_t inBytes, Out* out,
+                       uint32_t width, uint32_t bits, uint32_t clip) {
+    uint32_t x = 0;
+
+    if (bits == 24) {
+        for (; x < width; ++x) {
+            const uint8_t* p = in + x * 3;
+            uint32_t v = uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16);
+            out[x] = static_cast<Out>(v > clip ? clip : v);
+        }
+        return;
+    }
+
+    if (bits == 20 || bits == 18) {
+        x = unpackLineVector(in, inBytes, out, width, bits, clip);
+    }
+
+    if (bits == 20) {
+        // 2 pixels per 5 bytes; pixels 0-2 share one load, pixel 3 needs a second
+        const uint32_t mask = 0xFFFFF;
+        for (; x + 4 <= width && (x / 2) * 5 + 10 <= inBytes; x += 4) {
+            uint64_t w = loadLE64(in + (x / 2) * 5);
+            uint32_t v0 = static_cast<uint32_t>(w) & mask;
+            uint32_t v1 = static_cast<uint32_t>(w >> 20) & mask;
+            uint32_t v2 = static_cast<uint32_t>(w >> 40) & mask;
+            uint32_t v3 = static_cast<uint32_t>(loadLE64(in + (x / 2) * 5 + 2) >> 44) & mask;
+            out[x + 0] = static_cast<Out>(v0 > clip ? clip : v0);
+            out[x + 1] = static_cast<Out>(v1 > clip ? clip : v1);
+            out[x + 2] = static_cast<Out>(v2 > clip ? clip : v2);
+            out[x + 3] = static_cast<Out>(v3 > clip ? clip : v3);
+        }
+    } else if (bits == 18) {
+        // 4 pixels per 9 bytes: the first 3 sit in one load, the 4th in a second
+        const uint32_t mask = 0x3FFFF;
+        for (; x + 4 <= width && (x / 4) * 9 + 9 <= inBytes; x += 4) {
+            const uint8_t* p = in + (x / 4) * 9;
+            uint64_t w = loadLE64(p);
+            uint32_t v0 = static_cast<uint32_t>(w) & mask;
+            uint32_t v1 = static_cast<uint32_t>(w >> 18) & mask;
+            uint32_t v2 = static_cast<uint32_t>(w >> 36) & mask;
+            uint32_t v3 = static_cast<uint32_t>((w >> 54) | (uint64_t(p[8]) << 10)) & mask;
+            out[x + 0] = static_cast<Out>(v0 > clip ? clip : v0);
+            out[x + 1] = static_cast<Out>(v1 > clip ? clip : v1);
+            out[x + 2] = static_cast<Out>(v2 > clip ? clip : v2);
+            out[x + 3] = static_cast<Out>(v3 > clip ? clip : v3);
+        }
+    }
+
+    unpackGeneric(in, inBytes, out, x, width, bits, clip);
+}
+
+} // namespace Internal
+} // namespace HX
+
+#endif // PIXEL_UNPACK_H
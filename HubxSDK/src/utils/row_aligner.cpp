@@ -0,0 +1,116 @@
+// ============================================================================
+// row_aligner.cpp
+// ============================================================================
+
+/**
+ * @file row_aligner.cpp
+ * @brief Fractional line delay of one dual-energy plane
+ * @version 2.1.0
+ */
+
+#include "row_aligner.h"
+#include "line_resampler.h"
+#include <cmath>
+#include <cstring>
+
+namespace HX {
+namespace Internal {
+
+RowAligner::RowAligner()
+    : m_width(0)
+    , m_bytesPerPixel(2)
+    , m_whole(0)
+    , m_weight(0)
+    , m_slots(0)
+    , m_started(false)
+    , m_first(0)
+    , m_readyCount(0)
+    , m_readyNext(0)
+{
+}
+
+bool RowAligner::configure(uint32_t width, uint32_t bytesPerPixel, double offset, uint32_t reorder) {
+    if (width == 0 || !(offset >= 0.0) || offset > MAX_OFFSET ||
+        (bytesPerPixel != 1 && bytesPerPixel != 2 && bytesPerPixel != 4)) {
+        return false;
+    }
+    m_width = width;
+    m_bytesPerPixel = bytesPerPixel;
+    m_whole = static_cast<uint32_t>(std::floor(offset));
+    m_weight = static_cast<uint32_t>((offset - m_whole) * 65536.0 + 0.5);
+    if (m_weight >= 65536) {
+        // Rounds up to the next whole line
+        m_whole++;
+        m_weight = 0;
+    }
+    // A power of two, so slots stay in order across the lineId wrap
+    m_slots = 1;
+    while (m_slots < m_whole + 2 + reorder) {
+        m_slots <<= 1;
+    }
+    m_ring.assign(static_cast<size_t>(m_slots) * width * bytesPerPixel, 0);
+    m_ids.assign(m_slots, 0);
+    reset();
+    return true;
+}
+
+void RowAligner::add(const uint8_t* line, uint32_t lineId) {
+    if (!m_started) {
+        m_first = lineId;
+        m_started = true;
+    }
+
+    const uint32_t slot = lineId & (m_slots - 1);
+    const size_t lineBytes = static_cast<size_t>(m_width) * m_bytesPerPixel;
+    memcpy(m_ring.data() + slot * lineBytes, line, lineBytes);
+    m_ids[slot] = lineId;
+    m_valid[slot] = 1;
+
+    // A row needs lines row + k and, with a fraction, row + k + 1; this
+    // line completes the rows it is the last of those for
+    m_readyCount = 0;
+    m_readyNext = 0;
+    const uint32_t span = (m_weight > 0) ? 2 : 1;
+    for (uint32_t i = span; i-- > 0;) {
+        const uint32_t row = lineId - m_whole - i;
+        if (static_cast<int32_t>(row - m_first) < 0) {
+            continue;
+        }
+        if (find(row + m_whole) && (span == 1 || find(row + m_whole + 1))) {
+            m_ready[m_readyCount++] = row;
+        }
+    }
+}
+
+bool RowAligner::emit(uint8_t* out, uint32_t& row) {
+    if (m_readyNext >= m_readyCount) {
+        return false;
+    }
+    row = m_ready[m_readyNext++];
+    const uint8_t* a = find(row + m_whole);
+    const uint8_t* b = (m_weight > 0) ? find(row + m_whole + 1) : a;
+    BlendLines(a, b, out, m_width, m_bytesPerPixel, m_weight);
+    return true;
+}
+
+void RowAligner::reset() {
+    m_started = false;
+    m_valid.assign(m_slots, 0);
+    m_readyCount = 0;
+    m_readyNext = 0;
+}
+
+uint64_t RowAligner::bytes() const {
+    return m_ring.capacity() + m_ids.capacity() * sizeof(uint32_t) + m_valid.capacity();
+}
+
+const uint8_t* RowAligner::find(uint32_t lineId) const {
+    const uint32_t slot = lineId & (m_slots - 1);
+    if (!m_valid[slot] || m_ids[slot] != lineId) {
+        return nullptr;
+    }
+    return m_ring.data() + static_cast<size_t>(slot) * m_width * m_bytesPerPixel;
+}
+
+} // namespace Internal
+} // namespace HX
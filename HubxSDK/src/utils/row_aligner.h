@@ -0,0 +1,95 @@
+// ============================================================================
+// row_aligner.h
+// ============================================================================
+
+/**
+ * @file row_aligner.h
+ * @brief Fractional line delay of one dual-energy plane
+ * @version 2.1.0
+ *
+ * This header is INTERNAL to hubx.dll. The high and low detector rows sit
+ * a little apart along the belt, so the line one plane records at lineId
+ * n + offset shows what the other recorded at n. With offset = k + f,
+ * row n of the delayed plane is interpolated between its lines n + k and
+ * n + k + 1 with weights 1 - f and f. Lines are kept in a ring of
+ * k + 2 lines plus the reorder allowance, so a row comes out as soon as
+ * its second line arrives, without a pass over the frame.
+ */
+
+#ifndef ROW_ALIGNER_H
+#define ROW_ALIGNER_H
+
+#include <cstdint>
+#include <vector>
+
+namespace HX {
+namespace Internal {
+
+/**
+ * @class RowAligner
+ * @brief Turns lines of the later plane into rows aligned to the other
+ */
+class RowAligner {
+public:
+    /// Largest offset, in lines
+    static const uint32_t MAX_OFFSET = 64;
+
+    RowAligner();
+
+    /**
+     * @brief Size the ring and start a new run
+     * @param width Pixels per line
+     * @param bytesPerPixel 1, 2 or 4
+     * @param offset Delay in lines, 0..MAX_OFFSET
+     * @param reorder Lines a line may arrive late and still be used
+     * @return false if the format or offset is not supported
+     */
+    bool configure(uint32_t width, uint32_t bytesPerPixel, double offset, uint32_t reorder);
+
+    /**
+     * @brief Add a line of the delayed plane
+     * @param line Line pixels
+     * @param lineId Line identifier; wraps at 2^32
+     */
+    void add(const uint8_t* line, uint32_t lineId);
+
+    /**
+     * @brief Interpolate the next row the last add() completed
+     * @param out Output row, width pixels
+     * @param row Receives the row's lineId
+     * @return false when no further row is complete
+     *
+     * Rows before the first line of the run are not produced.
+     */
+    bool emit(uint8_t* out, uint32_t& row);
+
+    /**
+     * @brief Forget all lines; the next one starts the run again
+     */
+    void reset();
+
+    /// Ring bytes, for memory profiling
+    uint64_t bytes() const;
+
+private:
+    const uint8_t* find(uint32_t lineId) const;
+
+    uint32_t m_width;
+    uint32_t m_bytesPerPixel;
+    uint32_t m_whole;               ///< k
+    uint32_t m_weight;              ///< f in 16-bit fixed point
+    uint32_t m_slots;
+    bool m_started;
+    uint32_t m_first;               ///< First lineId of the run
+    std::vector<uint8_t> m_ring;    ///< Line lineId in slot lineId % m_slots
+    std::vector<uint32_t> m_ids;
+    std::vector<uint8_t> m_valid;
+    uint32_t m_ready[2];            ///< Rows the last line completed
+    uint32_t m_readyCount;
+    uint32_t m_readyNext;
+};
+
+} // namespace Internal
+} // namespace HX
+
+#endif // ROW_ALIGNER_H
@@ -0,0 +1,80 @@
+// ============================================================================
+// saturation_map.h
+// ============================================================================
+
+/**
+ * @file saturation_map.h
+ * @brief Bit-packed per-pixel linear ceilings from bright-field calibration
+ * @version 2.1.0
+ *
+ * This header is INTERNAL to hubx.dll. Each pixel gets a 4-bit code, two
+ * pixels per byte with the even pixel in the low nibble. Code c says the
+ * pixel's corrected output is linear for raw inputs below c / 15 of full
+ * scale: 15 is the whole range, 0 means the pixel has no usable linear
+ * range (its bright field saturated, it did not respond, or its gain hit
+ * the clamp). The ceiling is the lower of where the ADC saturates and
+ * where the correction clips the output. Codes round down, so a ceiling
+ * is never above the true one.
+ *
+ * XOGCorrect builds the map with every bright-field gain calibration; the
+ * multi-gain stage takes one map per mode and moves each pixel into the
+ * next mode (and its blend zone) below its own ceiling.
+ */
+
+#ifndef SATURATION_MAP_H
+#define SATURATION_MAP_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+namespace HX {
+namespace Internal {
+
+/// Highest code: linear over the whole range
+const int SATURATION_FULL_RANGE = 15;
+
+/// Bright levels this close to full scale count as saturated: a mean over
+/// frames that clipped only some of the time lands just below it
+const int SATURATION_HEADROOM_DIVISOR = 64;
+
+/// Bytes of a map for @p pixels pixels
+inline size_t SaturationMapBytes(size_t pixels) {
+    return (pixels + 1) / 2;
+}
+
+inline int GetSaturationCode(const uint8_t* map, size_t pixel) {
+    return (map[pixel >> 1] >> ((pixel & 1) * 4)) & 0xF;
+}
+
+/// Not atomic: two pixels share a byte, so writers own whole bytes
+inline void SetSaturationCode(uint8_t* map, size_t pixel, int code) {
+    const int shift = static_cast<int>(pixel & 1) * 4;
+    uint8_t& byte = map[pixel >> 1];
+    byte = static_cast<uint8_t>((byte & ~(0xF << shift)) | ((code & 0xF) << shift));
+}
+
+/// Code of a pixel linear below raw level @p ceiling
+inline int SaturationCode(double ceiling, double full_scale) {
+    if (!(full_scale > 0.0) || !(ceiling > 0.0)) {
+        return 0;
+    }
+    const double code = std::floor(ceiling * SATURATION_FULL_RANGE / full_scale);
+    return static_cast<int>(std::min<double>(SATURATION_FULL_RANGE, code));
+}
+
+/// Raw level below which a pixel with @p code is linear
+inline double SaturationCeiling(int code, double full_scale) {
+    return full_scale * code / SATURATION_FULL_RANGE;
+}
+
+/// True if a bright-field level is at the top of the ADC range
+inline bool IsSaturatedLevel(double level, double full_scale) {
+    return level >= full_scale - full_scale / SATURATION_HEADROOM_DIVISOR;
+}
+
+} // namespace Internal
+} // namespace HX
+
+#endif // SATURATION_MAP_H
@@ -0,0 +1,186 @@
+// ============================================================================
+// service_loop.cpp
+// ============================================================================
+
+/**
+ * @file service_loop.cpp
+ * @brief Shared service loop implementation
+ * @version 2.1.0
+ */
+
+#include "service_loop.h"
+#include "thread_policy.h"
+#include <algorithm>
+#include <chrono>
+
+namespace HX {
+namespace Internal {
+
+namespace {
+    // Task being polled by this thread, so it may remove itself
+    thread_local ServiceTask* t_current = nullptr;
+}
+
+ServiceLoop& ServiceLoop::instance() {
+    static ServiceLoop loop;
+    return loop;
+}
+
+ServiceLoop::ServiceLoop()
+    : m_configured(0)
+    , m_stopping(false)
+    , m_generation(0)
+{
+}
+
+ServiceLoop::~ServiceLoop() {
+    stopThreads();
+}
+
+bool ServiceLoop::setThreadCount(uint32_t count) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (count == 0 && !m_entries.empty()) {
+        return false;
+    }
+    if (count == m_configured) {
+        return true;
+    }
+    m_configured = count;
+
+    // Tasks stay registered; the new threads pick them up
+    lock.unlock();
+    stopThreads();
+    lock.lock();
+    if (m_configured > 0 && !m_entries.empty()) {
+        startThreads(m_configured);
+    }
+    return true;
+}
+
+uint32_t ServiceLoop::threadCount() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_configured;
+}
+
+bool ServiceLoop::add(ServiceTask* task) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_configured == 0 || !task) {
+        return false;
+    }
+
+    m_entries.push_back(std::make_shared<Entry>(task));
+    ++m_generation;
+    if (m_threads.empty()) {
+        startThreads(m_configured);
+    }
+    m_wake.notify_all();
+    return true;
+}
+
+void ServiceLoop::remove(ServiceTask* task) {
+    std::shared_ptr<Entry> entry;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (size_t i = 0; i < m_entries.size(); ++i) {
+            if (m_entries[i]->task == task) {
+                entry = m_entries[i];
+                m_entries.erase(m_entries.begin() + i);
+                ++m_generation;
+                break;
+            }
+        }
+    }
+    if (!entry) {
+        return;
+    }
+
+    // Pairs with the busy/removed order in loopThread: once busy is seen
+    // clear here, no thread will enter poll() again
+    entry->removed = true;
+    if (t_current == task) {
+        return;
+    }
+    while (entry->busy) {
+        std::this_thread::yield();
+    }
+}
+
+void ServiceLoop::startThreads(uint32_t count) {
+    // Called with m_mutex held
+    m_stopping = false;
+    for (uint32_t i = 0; i < count; ++i) {
+        m_threads.push_back(std::thread(&ServiceLoop::loopThread, this, i));
+    }
+}
+
+void ServiceLoop::stopThreads() {
+    std::vector<std::thread> threads;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+        threads.swap(m_threads);
+    }
+    m_wake.notify_all();
+
+    for (size_t i = 0; i < threads.size(); ++i) {
+        if (threads[i].joinable()) {
+            threads[i].join();
+        }
+    }
+}
+
+void ServiceLoop::loopThread(uint32_t index) {
+    ApplyThreadPolicy(XFactory::THREAD_SERVICE);
+
+    std::vector<std::shared_ptr<Entry> > tasks;
+    uint64_t seen = ~uint64_t(0);
+    uint32_t idleRounds = 0;
+
+    for (;;) {
+        if (m_generation.load() != seen) {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            // Nothing registered: sleep until something is
+            m_wake.wait(lock, [this] { return m_stopping || !m_entries.empty(); });
+            if (m_stopping) {
+                return;
+            }
+            tasks = m_entries;
+            seen = m_generation.load();
+        }
+
+        // Threads start at different tasks so they spread over them
+        bool busy = false;
+        const size_t count = tasks.size();
+        for (size_t k = 0; k < count; ++k) {
+            Entry& entry = *tasks[(k + index) % count];
+            if (entry.busy.exchange(true)) {
+                continue;
+            }
+            if (!entry.removed) {
+                t_current = entry.task;
+                busy |= entry.task->poll();
+                t_current = nullptr;
+            }
+            entry.busy = false;
+        }
+
+        if (busy) {
+            idleRounds = 0;
+            continue;
+        }
+
+        if (m_stopping) {
+            return;
+        }
+
+        // Same back-off as a dedicated assembly thread: spin, then nap
+        if (++idleRounds < 1000) {
+            std::this_thread::yield();
+        } else {
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+    }
+}
+
+} // namespace Internal
+} // namespace HX
@@ -0,0 +1,132 @@
+// ============================================================================
+// service_loop.h
+// ============================================================================
+
+/**
+ * @file service_loop.h
+ * @brief Fixed set of threads polling the per-detector background work
+ * @version 2.1.0
+ *
+ * This header is INTERNAL to hubx.dll. Without it every XControl runs a
+ * command receive and a heartbeat thread and every XGrabber an assembly
+ * thread, so the thread count grows with the detector count. Once
+ * XFactory::SetServiceThreads() is set, those objects register tasks here
+ * instead and a few loop threads poll all of them.
+ *
+ * Any idle loop thread takes whichever task is free, so a busy detector
+ * does not hold others back; a task never runs on two threads at once,
+ * which keeps single-consumer state (receive rings) single-consumer.
+ */
+
+#ifndef SERVICE_LOOP_H
+#define SERVICE_LOOP_H
+
+#include <cstdint>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace HX {
+namespace Internal {
+
+/**
+ * @class ServiceTask
+ * @brief Work polled by the loop threads
+ */
+class ServiceTask {
+public:
+    virtual ~ServiceTask() {}
+
+    /**
+     * @brief Do a bounded slice of work without blocking
+     * @return true if there was work, so the loop stays hot
+     */
+    virtual bool poll() = 0;
+};
+
+/**
+ * @class ServiceCall
+ * @brief Task that calls a function
+ */
+class ServiceCall : public ServiceTask {
+public:
+    explicit ServiceCall(const std::function<bool()>& fn) : m_fn(fn) {}
+    bool poll() override { return m_fn(); }
+
+private:
+    std::function<bool()> m_fn;
+};
+
+/**
+ * @class ServiceLoop
+ * @brief Process-wide loop threads
+ */
+class ServiceLoop {
+public:
+    static ServiceLoop& instance();
+
+    /**
+     * @brief Set loop threads
+     * @param count Threads (0 = off, objects keep their own threads)
+     * @return false if count is 0 while tasks are registered
+     */
+    bool setThreadCount(uint32_t count);
+
+    uint32_t threadCount() const;
+
+    /**
+     * @brief Check if objects starting now should use the loop
+     */
+    bool enabled() const { return threadCount() > 0; }
+
+    /**
+     * @brief Start polling a task
+     * @return false if the loop is off
+     */
+    bool add(ServiceTask* task);
+
+    /**
+     * @brief Stop polling a task
+     * @note Returns once no loop thread is inside task->poll(); called
+     *       from that poll itself it only unregisters
+     */
+    void remove(ServiceTask* task);
+
+private:
+    ServiceLoop();
+    ~ServiceLoop();
+
+    struct Entry {
+        ServiceTask* task;
+        std::atomic<bool> busy;         ///< A thread is polling it
+        std::atomic<bool> removed;
+
+        explicit Entry(ServiceTask* t) : task(t), busy(false), removed(false) {}
+    };
+
+    void startThreads(uint32_t count);
+    void stopThreads();
+    void loopThread(uint32_t index);
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wake;     ///< Task list changed or stopping
+    std::vector<std::thread> m_threads;
+    uint32_t m_configured;
+    std::atomic<bool> m_stopping;
+
+    std::vector<std::shared_ptr<Entry> > m_entries;
+    std::atomic<uint64_t> m_generation; ///< Incremented when m_entries changes
+
+    // Non-copyable
+    ServiceLoop(const ServiceLoop&) = delete;
+    ServiceLoop& operator=(const ServiceLoop&) = delete;
+};
+
+} // namespace Internal
+} // namespace HX
+
+#endif // SERVICE_LOOP_H
@@ -0,0 +1,87 @@
+// ============================================================================
+// snapshot.h
+// ============================================================================
+
+/**
+ * @file snapshot.h
+ * @brief Double-buffered publication of immutable calibration snapshots
+ * @version 2.1.0
+ *
+ * This header is INTERNAL to hubx.dll. A calibration call builds a new
+ * snapshot and publishes it; applies copy the pointer of the current one
+ * and keep it for the whole frame, so they never wait for, or race with,
+ * a recalibration, and never see half of one.
+ */
+
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <atomic>
+#include <memory>
+#include <thread>
+
+namespace HX {
+namespace Internal {
+
+/**
+ * @class SnapshotSlot
+ * @brief The current snapshot of T, replaced as a whole
+ *
+ * Two slots, each with a reader count: acquire() copies the pointer in the
+ * active slot, publish() fills the other one and flips. Readers stay in a
+ * slot only while copying the pointer, so publish() waits a few
+ * instructions at most. Publishers must be serialized by the owner.
+ */
+template <typename T>
+class SnapshotSlot {
+public:
+    SnapshotSlot() : m_active(0) {
+        m_readers[0] = 0;
+        m_readers[1] = 0;
+    }
+
+    /// Copy the pointer in the active slot (nullptr before the first publish)
+    std::shared_ptr<const T> acquire() const {
+        for (;;) {
+            const int slot = m_active.load();
+            ++m_readers[slot];
+            if (m_active.load() == slot) {
+                std::shared_ptr<const T> snapshot = m_published[slot];
+                --m_readers[slot];
+                return snapshot;
+            }
+            --m_readers[slot];
+        }
+    }
+
+    /// Make a snapshot current; holders of the old one finish with it
+    void publish(const std::shared_ptr<const T>& snapshot) {
+        const int previous = m_active.load();
+        const int target = 1 - previous;
+        while (m_readers[target].load() != 0) {
+            std::this_thread::yield();
+        }
+        m_published[target] = snapshot;
+        m_active.store(target);
+
+        // Drop the old slot's reference; holders keep theirs
+        while (m_readers[previous].load() != 0) {
+            std::this_thread::yield();
+        }
+        m_published[previous].reset();
+    }
+
+private:
+    std::shared_ptr<const T> m_published[2];
+    std::atomic<int> m_active;
+    mutable std::atomic<int> m_readers[2];
+
+    // Non-copyable
+    SnapshotSlot(const SnapshotSlot&) = delete;
+    SnapshotSlot& operator=(const SnapshotSlot&) = delete;
+};
+
+} // namespace Internal
+} // namespace HX
+
+#endif // SNAPSHOT_H
@@ -0,0 +1,187 @@
+// ============================================================================
+// spsc_ring.h
+// ============================================================================
+
+/**
+ * @file spsc_ring.h
+ * @brief Lock-free single-producer/single-consumer ring buffer
+ * @version 2.1.0
+ *
+ * This header is INTERNAL to hubx.dll. Exactly one thread may push and
+ * exactly one other thread may pop; no locks are taken on either side.
+ */
+
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <vector>
+
+namespace HX {
+namespace Internal {
+
+/**
+ * @class SpscRing
+ * @brief Bounded lock-free FIFO with power-of-two capacity
+ * @tparam T Element type (copied in and out)
+ */
+template <typename T>
+class SpscRing {
+public:
+    /**
+     * @brief Construct ring
+     * @param capacity Requested capacity (rounded up to a power of two)
+     */
+    explicit SpscRing(uint32_t capacity = 1024)
+        : m_head(0)
+        , m_tail(0)
+        , m_highWater(0)
+    {
+        reset(capacity);
+    }
+
+    /**
+     * @brief Reallocate the ring (not thread-safe, call while idle)
+     * @param capacity Requested capacity (rounded up to a power of two)
+     */
+    void reset(uint32_t capacity) {
+        uint32_t size = 2;
+        while (size < capacity && size < 0x80000000u) {
+            size <<= 1;
+        }
+        m_slots.assign(size, T());
+        m_mask = size - 1;
+        m_head.store(0, std::memory_order_relaxed);
+        m_tail.store(0, std::memory_order_relaxed);
+        m_highWater.store(0, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Push one element (producer thread only)
+     * @param value Element to push
+     * @return false if the ring is full
+     */
+    bool push(const T& value) {
+        const uint32_t head = m_head.load(std::memory_order_relaxed);
+        const uint32_t tail = m_tail.load(std::memory_order_acquire);
+
+        if (head - tail > m_mask) {
+            return false;
+        }
+
+        m_slots[head & m_mask] = value;
+        m_head.store(head + 1, std::memory_order_release);
+
+        updateHighWater(head + 1 - tail);
+        return true;
+    }
+
+    /**
+     * @brief Pop one element (consumer thread only)
+     * @param value Output element
+     * @return false if the ring is empty
+     */
+    bool pop(T& value) {
+        const uint32_t tail = m_tail.load(std::memory_order_relaxed);
+        const uint32_t head = m_head.load(std::memory_order_acquire);
+
+        if (tail == head) {
+            return false;
+        }
+
+        value = m_slots[tail & m_mask];
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Read the oldest element without releasing its slot (consumer only)
+     * @param value Output element
+     * @return false if the ring is empty
+     */
+    bool peek(T& value) const {
+        const uint32_t tail = m_tail.load(std::memory_order_relaxed);
+        const uint32_t head = m_head.load(std::memory_order_acquire);
+
+        if (tail == head) {
+            return false;
+        }
+
+        value = m_slots[tail & m_mask];
+        return true;
+    }
+
+    /**
+     * @brief Release the slot returned by the last peek (consumer only)
+     */
+    void consume() {
+        m_tail.store(m_tail.load(std::memory_order_relaxed) + 1,
+                     std::memory_order_release);
+    }
+
+    /**
+     * @brief Number of free slots as seen by the producer
+     */
+    uint32_t freeSlots() const {
+        return capacity() - (m_head.load(std::memory_order_relaxed) -
+                             m_tail.load(std::memory_order_acquire));
+    }
+
+    /**
+     * @brief Index the next push will use (producer thread only)
+     *
+     * Producers that keep payload storage parallel to the ring use this
+     * to pick the storage slot that belongs to the next element.
+     */
+    uint32_t nextIndex() const {
+        return m_head.load(std::memory_order_relaxed) & m_mask;
+    }
+
+    uint32_t size() const {
+        return m_head.load(std::memory_order_acquire) -
+               m_tail.load(std::memory_order_acquire);
+    }
+
+    bool empty() const { return size() == 0; }
+    uint32_t capacity() const { return m_mask + 1; }
+
+    /**
+     * @brief Highest occupancy observed since the last reset
+     */
+    uint32_t highWater() const {
+        return m_highWater.load(std::memory_order_relaxed);
+    }
+
+private:
+    void updateHighWater(uint32_t occupancy) {
+        // Only the producer writes, so a plain compare is race-free
+        if (occupancy > m_highWater.load(std::memory_order_relaxed)) {
+            m_highWater.store(occupancy, std::memory_order_relaxed);
+        }
+    }
+
+    std::vector<T> m_slots;
+    uint32_t m_mask;
+
+    // Producer and consumer indices live on separate cache lines. Padded,
+    // not alignas(64): C++11 new does not honour over-alignment of owners
+    static const size_t CACHE_LINE = 64;
+    char m_padSlots[CACHE_LINE];
+    std::atomic<uint32_t> m_head;
+    char m_padHead[CACHE_LINE - sizeof(std::atomic<uint32_t>)];
+    std::atomic<uint32_t> m_tail;
+    char m_padTail[CACHE_LINE - sizeof(std::atomic<uint32_t>)];
+    std::atomic<uint32_t> m_highWater;
+    char m_padHighWater[CACHE_LINE - sizeof(std::atomic<uint32_t>)];
+
+    // Non-copyable
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+};
+
+} // namespace Internal
+} // namespace HX
+
+#endif // SPSC_RING_H
@@ -0,0 +1,190 @@
+// ============================================================================
+// temporal_filter.cpp
+// ============================================================================
+
+/**
+ * @file temporal_filter.cpp
+ * @brief Block-sum and recursive averaging kernels
+ * @version 2.1.0
+ *
+ * Every pass is one streaming sweep over the frame and the accumulator.
+ * AVX2 kernels handle eight pixels per step; the scalar versions finish
+ * the tail and run on CPUs without AVX2. Both round the same way, so the
+ * output does not depend on the CPU.
+ */
+
+#include "temporal_filter.h"
+#include "cpu_features.h"
+#include <algorithm>
+#include <cstring>
+
+namespace HX {
+namespace Internal {
+
+namespace {
+
+// Block mode: sum += frame; optionally frame = round(sum * scale)
+typedef void (*BlockKernel)(uint32_t* sum, uint16_t* frame, size_t first, size_t end,
+                            bool output, float scale);
+
+// Recursive mode: avg += (frame - avg) * weight; frame = round(avg) if output
+typedef void (*RecursiveKernel)(float* avg, uint16_t* frame, size_t first, size_t end,
+                                bool output, float weight);
+
+inline uint16_t roundPixel(float v) {
+    v = std::max(0.0f, std::min(65535.0f, v));
+    return static_cast<uint16_t>(v + 0.5f);
+}
+
+void blockScalar(uint32_t* sum, uint16_t* frame, size_t first, size_t end, bool output, float scale) {
+    for (size_t i = first; i < end; ++i) {
+        sum[i] += frame[i];
+        if (output) {
+            frame[i] = roundPixel(static_cast<float>(sum[i]) * scale);
+        }
+    }
+}
+
+void recursiveScalar(float* avg, uint16_t* frame, size_t first, size_t end, bool output, float weight) {
+    for (size_t i = first; i < end; ++i) {
+        avg[i] += (static_cast<float>(frame[i]) - avg[i]) * weight;
+        if (output) {
+            frame[i] = roundPixel(avg[i]);
+        }
+    }
+}
+
+#if defined(HX_ARCH_X86)
+HX_TARGET("avx2")
+void blockAVX2(uint32_t* sum, uint16_t* frame, size_t first, size_t end, bool output, float scale) {
+    const __m256 vscale = _mm256_set1_ps(scale);
+    const __m256 half = _mm256_set1_ps(0.5f);
+    size_t i = first;
+    for (; i + 8 <= end; i += 8) {
+        __m128i px = _mm_loadu_si128(reinterpret_cast<const __m128i*>(frame + i));
+        __m256i s = _mm256_add_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(sum + i)),
+                                     _mm256_cvtepu16_epi32(px));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(sum + i), s);
+        if (output) {
+            // Sums stay below 2^31, so the signed conversion is exact enough
+            __m256 mean = _mm256_add_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(s), vscale), half);
+            __m256i v = _mm256_cvttps_epi32(mean);
+            __m128i packed = _mm_packus_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(frame + i), packed);
+        }
+    }
+    blockScalar(sum, frame, i, end, output, scale);
+}
+
+HX_TARGET("avx2")
+void recursiveAVX2(float* avg, uint16_t* frame, size_t first, size_t end, bool output, float weight) {
+    const __m256 vweight = _mm256_set1_ps(weight);
+    const __m256 half = _mm256_set1_ps(0.5f);
+    const __m256 zero = _mm256_setzero_ps();
+    size_t i = first;
+    for (; i + 8 <= end; i += 8) {
+        __m256 x = _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(frame + i))));
+        __m256 a = _mm256_loadu_ps(avg + i);
+        a = _mm256_add_ps(a, _mm256_mul_ps(_mm256_sub_ps(x, a), vweight));
+        _mm256_storeu_ps(avg + i, a);
+        if (output) {
+            __m256i v = _mm256_cvttps_epi32(_mm256_add_ps(_mm256_max_ps(a, zero), half));
+            __m128i packed = _mm_packus_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(frame + i), packed);
+        }
+    }
+    recursiveScalar(avg, frame, i, end, output, weight);
+}
+#endif
+
+const KernelFamily g_temporalKernels("temporal_average", XFactory::CPU_AVX2);
+
+BlockKernel selectBlock() {
+#if defined(HX_ARCH_X86)
+    if (g_temporalKernels.isa() == XFactory::CPU_AVX2) {
+        return blockAVX2;
+    }
+#endif
+    return blockScalar;
+}
+
+RecursiveKernel selectRecursive() {
+#if defined(HX_ARCH_X86)
+    if (g_temporalKernels.isa() == XFactory::CPU_AVX2) {
+        return recursiveAVX2;
+    }
+#endif
+    return recursiveScalar;
+}
+
+} // namespace
+
+TemporalFilter::TemporalFilter()
+    : m_pixels(0)
+    , m_frames(2)
+    , m_recursive(false)
+    , m_everyFrame(false)
+    , m_count(0)
+{
+}
+
+bool TemporalFilter::configure(size_t pixels, uint32_t frames, bool recursive, bool everyFrame) {
+    if (frames < 2 || frames > MAX_FRAMES) {
+        return false;
+    }
+    
+    m_pixels = pixels;
+    m_frames = frames;
+    m_recursive = recursive;
+    m_everyFrame = everyFrame;
+    
+    // Only the accumulator of the active mode is kept
+    if (recursive) {
+        std::vector<uint32_t>().swap(m_sum);
+        m_average.assign(pixels, 0.0f);
+    } else {
+        std::vector<float>().swap(m_average);
+        m_sum.assign(pixels, 0);
+    }
+    m_count = 0;
+    return true;
+}
+
+bool TemporalFilter::add(uint16_t* frame) {
+    const BlockKernel block = selectBlock();
+    const RecursiveKernel recursive = selectRecursive();
+    
+    m_count++;
+    
+    if (m_recursive) {
+        // Weight 1 seeds the average with the first frame
+        const float weight = (m_count == 1) ? 1.0f : 1.0f / static_cast<float>(m_frames);
+        const bool output = m_everyFrame || (m_count % m_frames) == 0;
+        recursive(m_average.data(), frame, 0, m_pixels, output, weight);
+        if (m_count >= 2 * m_frames) {
+            m_count -= m_frames;    // keeps the output phase, never reseeds
+        }
+        return output;
+    }
+    
+    const bool output = m_everyFrame || m_count == m_frames;
+    block(m_sum.data(), frame, 0, m_pixels, output, 1.0f / static_cast<float>(m_count));
+    if (m_count == m_frames) {
+        std::fill(m_sum.begin(), m_sum.end(), 0u);
+        m_count = 0;
+    }
+    return output;
+}
+
+void TemporalFilter::reset() {
+    std::fill(m_sum.begin(), m_sum.end(), 0u);
+    m_count = 0;
+}
+
+uint64_t TemporalFilter::bytes() const {
+    return m_sum.capacity() * sizeof(uint32_t) + m_average.capacity() * sizeof(float);
+}
+
+} // namespace Internal
+} // namespace HX
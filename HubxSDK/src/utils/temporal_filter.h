@@ -0,0 +1,80 @@
+// ============================================================================
+// temporal_filter.h
+// ============================================================================
+
+/**
+ * @file temporal_filter.h
+ * @brief Frame-to-frame noise averaging with a single accumulator
+ * @version 2.1.0
+ *
+ * This header is INTERNAL to hubx.dll. One accumulator frame replaces the
+ * K frames an application would otherwise hold: a block sum (mean of K
+ * frames, restarted every K) or a recursive average that weights frame n
+ * by 1/K and the history by (K-1)/K. The averaged image is written back
+ * into the frame it was computed from.
+ */
+
+#ifndef TEMPORAL_FILTER_H
+#define TEMPORAL_FILTER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace HX {
+namespace Internal {
+
+/**
+ * @class TemporalFilter
+ * @brief Running-sum or recursive average over 16-bit frames
+ */
+class TemporalFilter {
+public:
+    /// Frames per block; keeps 16-bit sums inside the signed 32-bit range
+    static const uint32_t MAX_FRAMES = 32768;
+    
+    TemporalFilter();
+    
+    /**
+     * @brief Size the accumulator
+     * @param pixels Pixels per frame
+     * @param frames Frames averaged (2 - MAX_FRAMES)
+     * @param recursive true for the recursive average, false for block sums
+     * @param everyFrame true to output every frame, false every frames-th
+     * @return false if frames is out of range
+     */
+    bool configure(size_t pixels, uint32_t frames, bool recursive, bool everyFrame);
+    
+    /**
+     * @brief Fold a frame into the average
+     * @param frame Frame pixels; overwritten with the average when it is output
+     * @return true if the frame now holds an average to deliver
+     * 
+     * @note In block mode with everyFrame, frames within a block carry the
+     *       mean of the block so far. The recursive average starts from
+     *       the first frame, so it needs no run-in.
+     */
+    bool add(uint16_t* frame);
+    
+    /**
+     * @brief Restart averaging with the next frame
+     */
+    void reset();
+    
+    /// Accumulator bytes, for memory profiling
+    uint64_t bytes() const;
+    
+private:
+    size_t m_pixels;
+    uint32_t m_frames;
+    bool m_recursive;
+    bool m_everyFrame;
+    uint32_t m_count;               ///< Frames in the current block or since reset
+    std::vector<uint32_t> m_sum;    ///< Block mode
+    std::vector<float> m_average;   ///< Recursive mode
+};
+
+} // namespace Internal
+} // namespace HX
+
+#endif // TEMPORAL_FILTER_H
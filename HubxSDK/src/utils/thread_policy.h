@@ -0,0 +1,50 @@
+// ============================================================================
+// thread_policy.h
+// ============================================================================
+
+/**
+ * @file thread_policy.h
+ * @brief Apply XFactory thread policies to SDK worker threads
+ * @version 2.1.0
+ *
+ * This header is INTERNAL to hubx.dll. Worker threads call
+ * ApplyThreadPolicy() once, first thing in their thread function.
+ */
+
+#ifndef THREAD_POLICY_H
+#define THREAD_POLICY_H
+
+#include "xfactory.h"
+
+namespace HX {
+namespace Internal {
+
+/**
+ * @brief Apply the configured policy of a role to the calling thread
+ * @param role Thread role
+ * @return false if affinity or priority could not be applied
+ */
+bool ApplyThreadPolicy(XFactory::ThreadRole role);
+
+/**
+ * @brief Apply a role's policy with the affinity replaced
+ * @param role Thread role
+ * @param cpuMask Affinity to use instead of the role's (0 = the role's)
+ * @return false if affinity or priority could not be applied
+ */
+bool ApplyThreadPolicy(XFactory::ThreadRole role, uint64_t cpuMask);
+
+/**
+ * @brief CPU the calling thread runs on right now, -1 if unknown
+ */
+int32_t CurrentCpu();
+
+/**
+ * @brief NUMA node of a CPU, -1 if unknown
+ */
+int32_t CpuNode(int32_t cpu);
+
+} // namespace Internal
+} // namespace HX
+
+#endif // THREAD_POLICY_H
@@ -0,0 +1,500 @@
+// ============================================================================
+// thread_pool.cpp
+// ============================================================================
+
+/**
+ * @file thread_pool.cpp
+ * @brief Shared work-stealing scheduler implementation
+ * @version 2.1.0
+ */
+
+#include "thread_pool.h"
+#include "thread_policy.h"
+#include <algorithm>
+
+namespace HX {
+namespace Internal {
+
+namespace {
+    // Worker index of a pool thread, -1 elsewhere
+    thread_local int t_worker = -1;
+
+    // Jobs a thread outside the pool is inside of, as caller
+    thread_local int t_depth = 0;
+
+    // Priority of jobs this thread submits
+    thread_local int t_priority = XFactory::TASK_NORMAL;
+
+    int bitCount(uint64_t mask) {
+        int count = 0;
+        for (; mask; mask &= mask - 1) {
+            ++count;
+        }
+        return count;
+    }
+
+    // CPU of the n-th set bit of mask (mask != 0)
+    int32_t nthCpu(uint64_t mask, int n) {
+        n %= bitCount(mask);
+        for (int32_t cpu = 0; cpu < 64; ++cpu) {
+            if ((mask & (1ULL << cpu)) && n-- == 0) {
+                return cpu;
+            }
+        }
+        return -1;
+    }
+}
+
+ThreadPool& ThreadPool::instance() {
+    static ThreadPool pool;
+    return pool;
+}
+
+ThreadPool::ThreadPool()
+    : m_stopping(false)
+    , m_queued(0)
+    , m_configured(0)
+    , m_cpuMask(0)
+    , m_numaAware(true)
+    , m_reconfiguring(false)
+    , m_jobs(0)
+    , m_bandPixels(0)
+{
+}
+
+ThreadPool::~ThreadPool() {
+    stopWorkers();
+}
+
+void ThreadPool::setThreadCount(uint32_t count) {
+    uint32_t threads;
+    uint64_t cpuMask;
+    bool numaAware;
+    configuration(threads, cpuMask, numaAware);
+    configure(count, cpuMask, numaAware);
+}
+
+void ThreadPool::configure(uint32_t threads, uint64_t cpuMask, bool numaAware) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock, [this] { return !m_reconfiguring; });
+    m_reconfiguring = true;
+    m_done.wait(lock, [this] { return m_jobs == 0; });
+
+    lock.unlock();
+    stopWorkers();
+    lock.lock();
+
+    m_configured = threads;
+    m_cpuMask = cpuMask;
+    m_numaAware = numaAware;
+    m_reconfiguring = false;
+    m_done.notify_all();
+}
+
+void ThreadPool::setBandPixels(uint32_t pixels) {
+    m_bandPixels.store(pixels > 0 ? std::max(pixels, static_cast<uint32_t>(MIN_BAND_PIXELS)) : 0, std::memory_order_relaxed);
+}
+
+void ThreadPool::configuration(uint32_t& threads, uint64_t& cpuMask, bool& numaAware) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    threads = m_configured;
+    cpuMask = m_cpuMask;
+    numaAware = m_numaAware;
+}
+
+uint32_t ThreadPool::threadCount() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return resolvedThreads();
+}
+
+uint32_t ThreadPool::resolvedThreads() const {
+    // Called with m_mutex held
+    if (m_configured > 0) {
+        return m_configured;
+    }
+    if (m_cpuMask != 0) {
+        return static_cast<uint32_t>(bitCount(m_cpuMask));
+    }
+    uint32_t hw = std::thread::hardware_concurrency();
+    return hw > 0 ? hw : 1;
+}
+
+void ThreadPool::setPriority(int priority) {
+    t_priority = std::max(0, std::min(PRIORITY_COUNT - 1, priority));
+}
+
+int ThreadPool::priority() {
+    return t_priority;
+}
+
+void ThreadPool::parallelRows(int rows, int rowPixels, const std::function<void(int, int)>& body) {
+    if (rows <= 0) {
+        return;
+    }
+
+    // Enough rows per band to amortize the hand-off
+    const int minRows = std::max(1, static_cast<int>(MIN_BAND_PIXELS / std::max(1, rowPixels)));
+    int bands = std::max(1, std::min(static_cast<int>(threadCount()), rows / minRows));
+    const uint32_t maxPixels = bandPixels();
+    if (maxPixels > 0) {
+        // More bands than threads, each small enough to stay in cache
+        const int64_t pixels = static_cast<int64_t>(rows) * std::max(1, rowPixels);
+        const int64_t small = (pixels + maxPixels - 1) / maxPixels;
+        bands = static_cast<int>(std::max<int64_t>(bands, std::min<int64_t>(small, rows / minRows)));
+    }
+
+    if (bands == 1) {
+        body(0, rows);
+        return;
+    }
+
+    run(bands, [&](int band) {
+        const int first = static_cast<int>(static_cast<int64_t>(rows) * band / bands);
+        const int end = static_cast<int>(static_cast<int64_t>(rows) * (band + 1) / bands);
+        body(first, end);
+    });
+}
+
+void ThreadPool::run(int bands, const std::function<void(int)>& body) {
+    submit(bands, body, false);
+}
+
+void ThreadPool::runPinned(int bands, const std::function<void(int)>& body) {
+    submit(bands, body, true);
+}
+
+int ThreadPool::runBatch(int items, int threads, const std::function<int(int)>& body) {
+    if (items <= 0) {
+        return 0;
+    }
+
+    const int limit = threads > 0 ? threads : static_cast<int>(threadCount());
+    const int lanes = std::max(1, std::min(limit, items));
+    std::vector<int> status(items, 0);
+
+    if (lanes == 1) {
+        for (int item = 0; item < items; ++item) {
+            status[item] = body(item);
+        }
+    } else {
+        std::atomic<int> next(0);
+        run(lanes, [&](int) {
+            for (int item = next.fetch_add(1); item < items; item = next.fetch_add(1)) {
+                status[item] = body(item);
+            }
+        });
+    }
+
+    for (int item = 0; item < items; ++item) {
+        if (status[item] != 0) {
+            return status[item];
+        }
+    }
+    return 0;
+}
+
+void ThreadPool::submit(int bands, const std::function<void(int)>& body, bool pinned) {
+    if (bands <= 0) {
+        return;
+    }
+
+    // Inside a band, slot numbers of a pinned job have no meaning
+    const bool nested = t_worker >= 0 || t_depth > 0;
+    if (bands == 1 || (pinned && nested)) {
+        for (int band = 0; band < bands; ++band) {
+            body(band);
+        }
+        return;
+    }
+
+    // Top-level jobs are counted so reconfiguration can wait for them;
+    // nested ones run inside a counted job and must not wait
+    size_t workers;
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (!nested) {
+            m_done.wait(lock, [this] { return !m_reconfiguring; });
+            const uint32_t threads = resolvedThreads();
+            if (m_workers.empty() && threads > 1) {
+                startWorkers(threads - 1);
+            }
+            ++m_jobs;
+        }
+        workers = m_workers.size();
+    }
+
+    Job job;
+    job.body = &body;
+    job.unfinished = bands;
+    job.priority = t_priority;
+
+    // Bands the caller runs itself; the rest are queued
+    std::vector<int> local;
+    if (workers == 0) {
+        for (int band = 0; band < bands; ++band) {
+            local.push_back(band);
+        }
+    } else if (pinned) {
+        const int slots = static_cast<int>(workers) + 1;
+        for (int band = 0; band < bands; ++band) {
+            const int slot = band % slots;
+            if (slot == 0) {
+                local.push_back(band);
+                continue;
+            }
+            Worker& worker = *m_workers[slot - 1];
+            std::lock_guard<std::mutex> lock(worker.mutex);
+            worker.pinned.push_back(Task{&job, band});
+            ++worker.pinnedCount;
+        }
+    } else {
+        local.push_back(0);
+        if (t_worker >= 0) {
+            // Nested: onto our own deque, band 1 at the back where we take it
+            Worker& own = *m_workers[t_worker];
+            for (int band = bands - 1; band >= 1; --band) {
+                push(own, Task{&job, band}, true);
+            }
+        } else {
+            // Spread over the workers, those on our node first
+            const std::vector<int>& order = handOutOrder();
+            for (int band = 1; band < bands; ++band) {
+                push(*m_workers[order[(band - 1) % order.size()]], Task{&job, band}, true);
+            }
+        }
+    }
+    if (workers > 0) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_wake.notify_all();
+    }
+
+    if (t_worker < 0) {
+        ++t_depth;
+    }
+    for (size_t i = 0; i < local.size(); ++i) {
+        runTask(Task{&job, local[i]});
+    }
+
+    // Run whatever of the job is still queued, then wait for the rest
+    Task task;
+    while (job.unfinished.load() > 0) {
+        if (takeOwn(job, task)) {
+            runTask(task);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_done.wait(lock, [&job] { return job.unfinished.load() == 0; });
+    }
+    if (t_worker < 0) {
+        --t_depth;
+    }
+
+    if (!nested) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        --m_jobs;
+        m_done.notify_all();
+    }
+}
+
+void ThreadPool::push(Worker& worker, const Task& task, bool back) {
+    {
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        std::deque<Task>& queue = worker.queues[task.job->priority];
+        if (back) {
+            queue.push_back(task);
+        } else {
+            queue.push_front(task);
+        }
+    }
+    ++m_queued;
+}
+
+bool ThreadPool::takeOwn(const Job& job, Task& task) {
+    // Own deque first: a nested job's bands are there
+    const size_t count = m_workers.size();
+    const size_t first = t_worker >= 0 ? static_cast<size_t>(t_worker) : 0;
+    for (size_t k = 0; k < count; ++k) {
+        Worker& worker = *m_workers[(first + k) % count];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        std::deque<Task>& queue = worker.queues[job.priority];
+        for (std::deque<Task>::iterator it = queue.begin(); it != queue.end(); ++it) {
+            if (it->job == &job) {
+                task = *it;
+                queue.erase(it);
+                --m_queued;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool ThreadPool::findTask(int index, Task& task) {
+    Worker& own = *m_workers[index];
+
+    // Pinned bands wait for this worker alone
+    if (own.pinnedCount.load() > 0) {
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.pinned.empty()) {
+            task = own.pinned.front();
+            own.pinned.pop_front();
+            --own.pinnedCount;
+            return true;
+        }
+    }
+    if (m_queued.load() == 0) {
+        return false;
+    }
+
+    // Highest priority anywhere before lower priority here
+    for (int p = 0; p < PRIORITY_COUNT; ++p) {
+        {
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if (!own.queues[p].empty()) {
+                task = own.queues[p].back();
+                own.queues[p].pop_back();
+                --m_queued;
+                return true;
+            }
+        }
+        for (size_t v = 0; v < own.victims.size(); ++v) {
+            Worker& victim = *m_workers[own.victims[v]];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.queues[p].empty()) {
+                task = victim.queues[p].front();
+                victim.queues[p].pop_front();
+                --m_queued;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void ThreadPool::runTask(const Task& task) {
+    // Jobs submitted from inside the band inherit its priority
+    const int saved = t_priority;
+    t_priority = task.job->priority;
+    (*task.job->body)(task.band);
+    t_priority = saved;
+
+    // The job may be gone once the count reaches zero
+    if (task.job->unfinished.fetch_sub(1) == 1) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_done.notify_all();
+    }
+}
+
+const std::vector<int>& ThreadPool::handOutOrder() {
+    int32_t node = -1;
+    if (m_nodeOrders.size() > 1) {
+        const int32_t cpu = CurrentCpu();
+        if (cpu >= 0 && static_cast<size_t>(cpu) < m_cpuNodes.size()) {
+            node = m_cpuNodes[cpu];
+        }
+    }
+    if (node + 1 < 0 || static_cast<size_t>(node + 1) >= m_nodeOrders.size()) {
+        node = -1;
+    }
+    return m_nodeOrders[node + 1];
+}
+
+void ThreadPool::startWorkers(uint32_t count) {
+    // Called with m_mutex held and no job running
+    m_stopping = false;
+    m_workers.clear();
+    for (uint32_t i = 0; i < count; ++i) {
+        std::unique_ptr<Worker> worker(new Worker());
+        if (m_cpuMask != 0) {
+            worker->cpu = nthCpu(m_cpuMask, static_cast<int>(i));
+            if (m_numaAware) {
+                worker->node = CpuNode(worker->cpu);
+            }
+        }
+        m_workers.push_back(std::move(worker));
+    }
+
+    // Steal order: same node first, then the rest, each from the next worker on
+    int32_t maxNode = -1;
+    for (uint32_t i = 0; i < count; ++i) {
+        Worker& worker = *m_workers[i];
+        worker.victims.clear();
+        for (int pass = 0; pass < 2; ++pass) {
+            for (uint32_t k = 1; k < count; ++k) {
+                const uint32_t v = (i + k) % count;
+                const bool local = m_workers[v]->node == worker.node;
+                if (local == (pass == 0)) {
+                    worker.victims.push_back(static_cast<int>(v));
+                }
+            }
+        }
+        maxNode = std::max(maxNode, worker.node);
+    }
+
+    // Hand-out order per node of the submitting thread; [0] when unknown
+    m_nodeOrders.assign(static_cast<size_t>(maxNode + 2), std::vector<int>());
+    for (int32_t node = -1; node <= maxNode; ++node) {
+        std::vector<int>& order = m_nodeOrders[node + 1];
+        for (int pass = 0; pass < 2; ++pass) {
+            for (uint32_t v = 0; v < count; ++v) {
+                const bool local = node >= 0 && m_workers[v]->node == node;
+                if (local == (pass == 0)) {
+                    order.push_back(static_cast<int>(v));
+                }
+            }
+        }
+    }
+    m_cpuNodes.clear();
+    if (maxNode >= 0) {
+        for (int32_t cpu = 0; cpu < 64; ++cpu) {
+            m_cpuNodes.push_back(CpuNode(cpu));
+        }
+    }
+
+    for (uint32_t i = 0; i < count; ++i) {
+        m_workers[i]->thread = std::thread(&ThreadPool::workerThread, this, static_cast<int>(i));
+    }
+}
+
+void ThreadPool::stopWorkers() {
+    // No job is running, so every deque is empty
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+
+    for (size_t i = 0; i < m_workers.size(); ++i) {
+        if (m_workers[i]->thread.joinable()) {
+            m_workers[i]->thread.join();
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_workers.clear();
+}
+
+void ThreadPool::workerThread(int index) {
+    Worker& self = *m_workers[index];
+    ApplyThreadPolicy(XFactory::THREAD_CORRECTION, self.cpu >= 0 ? 1ULL << self.cpu : 0);
+    t_worker = index;
+
+    for (;;) {
+        Task task;
+        if (findTask(index, task)) {
+            runTask(task);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_wake.wait(lock, [this, &self] {
+            return m_stopping || m_queued.load() > 0 || self.pinnedCount.load() > 0;
+        });
+        if (m_stopping) {
+            return;
+        }
+    }
+}
+
+} // namespace Internal
+} // namespace HX
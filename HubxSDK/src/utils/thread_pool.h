@@ -0,0 +1,207 @@
+// ============================================================================
+// thread_pool.h
+// ============================================================================
+
+/**
+ * @file thread_pool.h
+ * @brief Shared work-stealing scheduler for data-parallel image processing
+ * @version 2.1.0
+ *
+ * This header is INTERNAL to hubx.dll. Corrections, XMOG, fusion, batch
+ * reprocessing, XFile and display scaling split a frame into row bands
+ * and run them on one process-wide set of workers. Band boundaries depend
+ * only on the image size, the configured thread count and band size,
+ * never on scheduling, so output is identical from run to run.
+ *
+ * Jobs from any number of threads run concurrently. Each worker keeps a
+ * deque per priority: it works from the back of its own, idle workers
+ * steal from the front of others', those on the same NUMA node first.
+ * A thread waiting for its job runs the job's queued bands itself, so
+ * nested jobs cannot starve.
+ */
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <cstdint>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace HX {
+namespace Internal {
+
+/**
+ * @class ThreadPool
+ * @brief Fork-join scheduler; the calling thread works on its job too
+ */
+class ThreadPool {
+public:
+    /// Bands smaller than this are not worth a wake-up
+    static const uint32_t MIN_BAND_PIXELS = 64 * 1024;
+    
+    /// Priorities, matching XFactory::TaskPriority (0 = highest)
+    static const int PRIORITY_COUNT = 3;
+    
+    /**
+     * @brief Process-wide scheduler used by all SDK modules
+     */
+    static ThreadPool& instance();
+    
+    /**
+     * @brief Set threads used per job, including the caller
+     * @param count Threads (0 = one per hardware thread, 1 = run inline)
+     * @note Waits for running jobs; workers start on next use
+     */
+    void setThreadCount(uint32_t count);
+    
+    /**
+     * @brief Set threads, core set and NUMA awareness
+     * @param threads Threads per job including the caller (0 = one per
+     *                CPU of cpuMask, else per hardware thread)
+     * @param cpuMask Worker n is pinned to the n-th CPU of the mask
+     *                (0 = THREAD_CORRECTION affinity, not pinned)
+     * @param numaAware Steal and hand out bands within a node first
+     * @note Waits for running jobs; workers start on next use
+     */
+    void configure(uint32_t threads, uint64_t cpuMask, bool numaAware);
+    
+    /**
+     * @brief Get the configuration as set
+     */
+    void configuration(uint32_t& threads, uint64_t& cpuMask, bool& numaAware) const;
+    
+    /**
+     * @brief Threads used per job, including the caller
+     */
+    uint32_t threadCount() const;
+    
+    /**
+     * @brief Cap the pixels of a parallelRows() band
+     * @param pixels Largest band (0 = one band per thread; else at least
+     *               MIN_BAND_PIXELS), so a band's rows stay in cache
+     */
+    void setBandPixels(uint32_t pixels);
+    uint32_t bandPixels() const { return m_bandPixels.load(std::memory_order_relaxed); }
+    
+    /**
+     * @brief Set the priority of jobs the calling thread submits
+     * @note Workers running a band submit at the priority of its job
+     */
+    static void setPriority(int priority);
+    static int priority();
+    
+    /**
+     * @brief Run body(band) for every band in [0, bands) and wait
+     * @note Safe to call from any thread, including inside a band
+     */
+    void run(int bands, const std::function<void(int)>& body);
+    
+    /**
+     * @brief Split rows into bands and run body(firstRow, endRow) on each
+     * @param rows Rows in the image
+     * @param rowPixels Pixels per row, used to size the bands
+     * @param body Band function, rows [firstRow, endRow)
+     */
+    void parallelRows(int rows, int rowPixels, const std::function<void(int, int)>& body);
+    
+    /**
+     * @brief Like run(), but band b always runs on the same pool thread
+     * @param bands Number of bands, typically one per detector
+     * @param body Band function
+     * 
+     * @note Band b goes to thread b mod threadCount() (the caller is
+     *       thread 0) and is never stolen, so memory a band first touches
+     *       is placed on that thread's NUMA node and stays local on later
+     *       pinned jobs with the same band count - exactly so when
+     *       cpuMask pins the workers. The mapping holds until the
+     *       configuration changes. Called inside a band it runs inline.
+     */
+    void runPinned(int bands, const std::function<void(int)>& body);
+    
+    /**
+     * @brief Run body(item) for every item in [0, items) on up to threads
+     *        pool threads and wait
+     * @param items Number of items, typically frames of a batch
+     * @param threads Concurrent items (0 = threadCount()); with 1 the items
+     *                run in order on the caller, free to use the pool inside
+     * @param body Item function returning a status (0 = success)
+     * @return Status of the first failed item in item order, or 0
+     * 
+     * @note Items are handed out one at a time, so uneven items balance.
+     *       Jobs nested in an item are stolen by workers left idle.
+     */
+    int runBatch(int items, int threads, const std::function<int(int)>& body);
+    
+private:
+    ThreadPool();
+    ~ThreadPool();
+    
+    struct Job {
+        const std::function<void(int)>* body;
+        std::atomic<int> unfinished;    ///< Bands not yet completed
+        int priority;
+    };
+    
+    struct Task {
+        Job* job;
+        int band;
+    };
+    
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Task> queues[PRIORITY_COUNT];    ///< Owner takes the back, thieves the front
+        std::deque<Task> pinned;                    ///< runPinned() bands, never stolen
+        std::atomic<int> pinnedCount;
+        std::vector<int> victims;                   ///< Other workers, same node first
+        int32_t cpu;                                ///< Pinned CPU, -1 if not pinned
+        int32_t node;                               ///< NUMA node, -1 if unknown
+        std::thread thread;
+        
+        Worker() : pinnedCount(0), cpu(-1), node(-1) {}
+    };
+    
+    void submit(int bands, const std::function<void(int)>& body, bool pinned);
+    uint32_t resolvedThreads() const;
+    void push(Worker& worker, const Task& task, bool back);
+    bool takeOwn(const Job& job, Task& task);
+    bool findTask(int index, Task& task);
+    void runTask(const Task& task);
+    const std::vector<int>& handOutOrder();
+    void startWorkers(uint32_t count);
+    void stopWorkers();
+    void workerThread(int index);
+    
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wake;     ///< Work queued or stopping
+    std::condition_variable m_done;     ///< A job finished or reconfiguration ended
+    std::vector<std::unique_ptr<Worker> > m_workers;
+    bool m_stopping;
+    std::atomic<int> m_queued;          ///< Stealable tasks in all deques
+    
+    // Configuration, changed only while no job runs
+    uint32_t m_configured;              ///< 0 = CPUs of m_cpuMask or hardware concurrency
+    uint64_t m_cpuMask;
+    bool m_numaAware;
+    bool m_reconfiguring;
+    int m_jobs;                         ///< Top-level jobs running
+    std::atomic<uint32_t> m_bandPixels; ///< 0 = one band per thread
+    
+    // Workers by node for bands handed out by a thread outside the pool
+    std::vector<int32_t> m_cpuNodes;
+    std::vector<std::vector<int> > m_nodeOrders;    ///< [node + 1], same node first
+    
+    // Non-copyable
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+};
+
+} // namespace Internal
+} // namespace HX
+
+#endif // THREAD_POOL_H
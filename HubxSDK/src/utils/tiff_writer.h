@@ -0,0 +1,382 @@
+// ============================================================================
+// tiff_writer.h
+// ============================================================================
+
+/**
+ * @file tiff_writer.h
+ * @brief Little-endian TIFF/BigTIFF header builder
+ * @version 2.1.0
+ *
+ * This header is INTERNAL to hubx.dll. Shared by XFile and XRecorder so
+ * both write the same grayscale layout and metadata tags; multi-image
+ * (tiled pyramid) files are built one directory at a time with finishAt().
+ */
+
+#ifndef TIFF_WRITER_H
+#define TIFF_WRITER_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace HX {
+namespace Internal {
+
+// Baseline TIFF 6.0 tags
+const uint16_t TIFF_NEW_SUBFILE_TYPE  = 254;
+const uint16_t TIFF_IMAGE_WIDTH       = 256;
+const uint16_t TIFF_IMAGE_LENGTH      = 257;
+const uint16_t TIFF_BITS_PER_SAMPLE   = 258;
+const uint16_t TIFF_COMPRESSION       = 259;
+const uint16_t TIFF_PHOTOMETRIC       = 262;
+const uint16_t TIFF_STRIP_OFFSETS     = 273;
+const uint16_t TIFF_SAMPLES_PER_PIXEL = 277;
+const uint16_t TIFF_ROWS_PER_STRIP    = 278;
+const uint16_t TIFF_STRIP_BYTE_COUNTS = 279;
+const uint16_t TIFF_PLANAR_CONFIG     = 284;
+const uint16_t TIFF_SOFTWARE          = 305;
+const uint16_t TIFF_DATE_TIME         = 306;
+const uint16_t TIFF_TILE_WIDTH        = 322;
+const uint16_t TIFF_TILE_LENGTH       = 323;
+const uint16_t TIFF_TILE_OFFSETS      = 324;
+const uint16_t TIFF_TILE_BYTE_COUNTS  = 325;
+const uint16_t TIFF_SAMPLE_FORMAT     = 339;
+
+// Compression values
+const uint16_t TIFF_COMPRESSION_NONE  = 1;
+const uint16_t HX_COMPRESSION_DELTA   = 65000;  ///< Private: delta + bit-packing (delta_pack.h)
+const uint16_t HX_COMPRESSION_TEMPORAL = 65001; ///< Private: residuals against HX_TAG_REFERENCE
+
+// Detector metadata (XFCode) in the private tag range
+const uint16_t HX_TAG_DEPTH    = 65000;    ///< Significant bits per pixel
+const uint16_t HX_TAG_DM_NUM   = 65001;
+const uint16_t HX_TAG_DM_TYPE  = 65002;
+const uint16_t HX_TAG_DM_PIX   = 65003;
+const uint16_t HX_TAG_OP_MODE  = 65004;
+const uint16_t HX_TAG_INT_TIME = 65005;
+const uint16_t HX_TAG_ENERGY   = 65006;
+const uint16_t HX_TAG_BIN      = 65007;
+const uint16_t HX_TAG_TEMP     = 65008;
+const uint16_t HX_TAG_HUM      = 65009;
+const uint16_t HX_TAG_SN       = 65010;
+const uint16_t HX_TAG_REFERENCE = 65011;   ///< File the temporal residuals are against, same directory
+
+// Field types
+const uint16_t TIFF_ASCII = 2;
+const uint16_t TIFF_SHORT = 3;
+const uint16_t TIFF_LONG  = 4;
+const uint16_t TIFF_FLOAT = 11;
+const uint16_t TIFF_LONG8 = 16;
+
+// Byte-wise so files are little-endian on any host
+template <typename T>
+inline void storeLE(uint8_t* p, T value) {
+    for (size_t i = 0; i < sizeof(T); ++i) {
+        p[i] = static_cast<uint8_t>(static_cast<uint64_t>(value) >> (8 * i));
+    }
+}
+
+template <typename T>
+inline T loadLE(const uint8_t* p) {
+    uint64_t value = 0;
+    for (size_t i = 0; i < sizeof(T); ++i) {
+        value |= static_cast<uint64_t>(p[i]) << (8 * i);
+    }
+    return static_cast<T>(value);
+}
+
+/**
+ * @brief Layout of an image stored as several (compressed) strips
+ */
+struct TiffStrips {
+    uint16_t compression;               ///< TIFF_COMPRESSION_NONE or an HX_COMPRESSION_*
+    uint32_t rowsPerStrip;
+    std::vector<uint64_t> bytes;        ///< Stored size of every strip
+};
+
+/**
+ * @brief Builds the TIFF header and first IFD for one image
+ *
+ * Pixel data is not part of the buffer; the strips follow directly, back
+ * to back, at the offsets recorded for them.
+ */
+class TiffBuilder {
+public:
+    explicit TiffBuilder(bool big) : m_big(big), m_stripOffsetField(-1), m_next(0) {}
+
+    void addShort(uint16_t tag, uint16_t value) {
+        Field& f = add(tag, TIFF_SHORT, 1, 2);
+        storeLE(f.data.data(), value);
+    }
+
+    void addLong(uint16_t tag, uint32_t value) {
+        Field& f = add(tag, TIFF_LONG, 1, 4);
+        storeLE(f.data.data(), value);
+    }
+
+    void addFloat(uint16_t tag, float value) {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        Field& f = add(tag, TIFF_FLOAT, 1, 4);
+        storeLE(f.data.data(), bits);
+    }
+
+    void addAscii(uint16_t tag, const std::string& value) {
+        Field& f = add(tag, TIFF_ASCII, value.size() + 1, value.size() + 1);
+        std::memcpy(f.data.data(), value.c_str(), value.size() + 1);
+    }
+
+    /// Byte count or offset: LONG in classic TIFF, LONG8 in BigTIFF
+    void addCount(uint16_t tag, uint64_t value) {
+        Field& f = add(tag, m_big ? TIFF_LONG8 : TIFF_LONG, 1, m_big ? 8 : 4);
+        if (m_big) {
+            storeLE(f.data.data(), value);
+        } else {
+            storeLE(f.data.data(), static_cast<uint32_t>(value));
+        }
+    }
+
+    /// Byte counts, one per strip
+    void addCounts(uint16_t tag, const std::vector<uint64_t>& values) {
+        const size_t unit = m_big ? 8 : 4;
+        Field& f = add(tag, m_big ? TIFF_LONG8 : TIFF_LONG, values.size(), values.size() * unit);
+        for (size_t i = 0; i < values.size(); ++i) {
+            if (m_big) {
+                storeLE(f.data.data() + i * unit, values[i]);
+            } else {
+                storeLE(f.data.data() + i * unit, static_cast<uint32_t>(values[i]));
+            }
+        }
+    }
+
+    /// Offset of the pixel data, filled in by finish()
+    void addStripOffset(uint16_t tag) {
+        addStripOffsets(tag, std::vector<uint64_t>(1, 0));
+    }
+
+    /// Offsets of strips of these sizes stored back to back after the header
+    void addStripOffsets(uint16_t tag, const std::vector<uint64_t>& sizes) {
+        addCounts(tag, sizes);
+        m_stripOffsetField = static_cast<int>(m_fields.size()) - 1;
+        m_stripSizes = sizes;
+    }
+
+    /**
+     * @brief Tags every HubxSDK TIFF carries: geometry, strips, compression
+     * @param width Columns
+     * @param height Rows
+     * @param bytesPerPixel Container size (1, 2 or 4)
+     * @param depth Significant bits, stored in HX_TAG_DEPTH
+     * @param date "YYYY:MM:DD HH:MM:SS"
+     * @param strips Strip layout, nullptr for one uncompressed strip
+     */
+    void addImageTags(uint32_t width, uint32_t height, uint32_t bytesPerPixel,
+                      uint32_t depth, const std::string& date,
+                      const TiffStrips* strips = nullptr) {
+        const uint64_t pixelBytes = static_cast<uint64_t>(width) * bytesPerPixel * height;
+        addLong(TIFF_IMAGE_WIDTH, width);
+        addLong(TIFF_IMAGE_LENGTH, height);
+        addShort(TIFF_BITS_PER_SAMPLE, static_cast<uint16_t>(bytesPerPixel * 8));
+        addShort(TIFF_COMPRESSION, strips ? strips->compression : TIFF_COMPRESSION_NONE);
+        addShort(TIFF_PHOTOMETRIC, 1);
+        addShort(TIFF_SAMPLES_PER_PIXEL, 1);
+        if (strips) {
+            addStripOffsets(TIFF_STRIP_OFFSETS, strips->bytes);
+            addLong(TIFF_ROWS_PER_STRIP, strips->rowsPerStrip);
+            addCounts(TIFF_STRIP_BYTE_COUNTS, strips->bytes);
+        } else {
+            addStripOffset(TIFF_STRIP_OFFSETS);
+            addLong(TIFF_ROWS_PER_STRIP, height);
+            addCount(TIFF_STRIP_BYTE_COUNTS, pixelBytes);
+        }
+        addShort(TIFF_PLANAR_CONFIG, 1);
+        addAscii(TIFF_SOFTWARE, "HubxSDK 2.1.0");
+        addAscii(TIFF_DATE_TIME, date);
+        addShort(TIFF_SAMPLE_FORMAT, 1);
+        addLong(HX_TAG_DEPTH, depth);
+    }
+
+    /**
+     * @brief Add the layout tags of one uncompressed tiled image
+     * @param width Image width
+     * @param height Image height
+     * @param bytesPerPixel Container size (1, 2 or 4)
+     * @param tileSize Tile width and height (multiple of 16)
+     * @param reduced true for a reduced-resolution copy of the first image
+     *
+     * @note Tiles are stored row by row, all of them full size; the tile
+     *       offsets are filled in by finishAt()
+     */
+    void addTileTags(uint32_t width, uint32_t height, uint32_t bytesPerPixel,
+                     uint32_t tileSize, bool reduced) {
+        const uint64_t tiles = static_cast<uint64_t>((width + tileSize - 1) / tileSize) *
+                               ((height + tileSize - 1) / tileSize);
+        const std::vector<uint64_t> sizes(static_cast<size_t>(tiles),
+            static_cast<uint64_t>(tileSize) * tileSize * bytesPerPixel);
+        addLong(TIFF_NEW_SUBFILE_TYPE, reduced ? 1 : 0);
+        addLong(TIFF_IMAGE_WIDTH, width);
+        addLong(TIFF_IMAGE_LENGTH, height);
+        addShort(TIFF_BITS_PER_SAMPLE, static_cast<uint16_t>(bytesPerPixel * 8));
+        addShort(TIFF_COMPRESSION, TIFF_COMPRESSION_NONE);
+        addShort(TIFF_PHOTOMETRIC, 1);
+        addShort(TIFF_SAMPLES_PER_PIXEL, 1);
+        addShort(TIFF_PLANAR_CONFIG, 1);
+        addLong(TIFF_TILE_WIDTH, tileSize);
+        addLong(TIFF_TILE_LENGTH, tileSize);
+        addStripOffsets(TIFF_TILE_OFFSETS, sizes);
+        addCounts(TIFF_TILE_BYTE_COUNTS, sizes);
+        addShort(TIFF_SAMPLE_FORMAT, 1);
+    }
+
+    /**
+     * @brief Lay out header, IFD and out-of-line values
+     * @param pixelAlign Alignment of the pixel data in the file (power of two)
+     * @return Bytes to write before the pixel data
+     */
+    const std::vector<uint8_t>& finish(uint64_t pixelAlign = 64) {
+        return finishAt(0, pixelAlign, 0, false);
+    }
+
+    /**
+     * @brief Lay out one directory of a multi-image file
+     * @param base File offset of the returned buffer (0 = file start, the
+     *             buffer then begins with the TIFF header; otherwise even)
+     * @param pixelAlign Alignment of the image data in the file
+     * @param dataBytes Image data that follows the buffer
+     * @param linkNext Point the directory at one starting right after the
+     *                 image data (see nextOffset())
+     * @return Bytes to write at base, before the image data
+     */
+    const std::vector<uint8_t>& finishAt(uint64_t base, uint64_t pixelAlign,
+                                         uint64_t dataBytes, bool linkNext) {
+        const uint64_t inlineBytes = m_big ? 8 : 4;
+        const uint64_t headerBytes = base == 0 ? (m_big ? 16 : 8) : 0;
+        const uint64_t entryBytes = m_big ? 20 : 12;
+        const uint64_t ifdBytes = (m_big ? 16 : 6) + entryBytes * m_fields.size();
+
+        // IFD entries must be sorted by tag
+        std::vector<size_t> order(m_fields.size());
+        for (size_t i = 0; i < order.size(); ++i) {
+            order[i] = i;
+        }
+        std::sort(order.begin(), order.end(), [this](size_t a, size_t b) {
+            return m_fields[a].tag < m_fields[b].tag;
+        });
+
+        // Offsets below are relative to base
+        std::vector<uint64_t> valueOffset(m_fields.size(), 0);
+        uint64_t end = headerBytes + ifdBytes;
+        for (size_t i = 0; i < m_fields.size(); ++i) {
+            if (m_fields[i].data.size() > inlineBytes) {
+                end = (end + 7) & ~7ull;
+                valueOffset[i] = end;
+                end += m_fields[i].data.size();
+            }
+        }
+        const uint64_t pixelOffset = (base + end + pixelAlign - 1) & ~(pixelAlign - 1);
+        if (m_stripOffsetField >= 0) {
+            Field& f = m_fields[m_stripOffsetField];
+            uint64_t offset = pixelOffset;
+            for (size_t i = 0; i < m_stripSizes.size(); ++i) {
+                if (m_big) {
+                    storeLE(f.data.data() + i * 8, offset);
+                } else {
+                    storeLE(f.data.data() + i * 4, static_cast<uint32_t>(offset));
+                }
+                offset += m_stripSizes[i];
+            }
+        }
+        m_next = linkNext ? pixelOffset + dataBytes : 0;
+
+        m_buffer.assign(static_cast<size_t>(pixelOffset - base), 0);
+        uint8_t* p = m_buffer.data();
+        if (base == 0) {
+            p[0] = 'I';
+            p[1] = 'I';
+            if (m_big) {
+                storeLE<uint16_t>(p + 2, 43);
+                storeLE<uint16_t>(p + 4, 8);
+                storeLE<uint16_t>(p + 6, 0);
+                storeLE<uint64_t>(p + 8, headerBytes);
+            } else {
+                storeLE<uint16_t>(p + 2, 42);
+                storeLE<uint32_t>(p + 4, static_cast<uint32_t>(headerBytes));
+            }
+        }
+
+        uint8_t* ifd = p + headerBytes;
+        if (m_big) {
+            storeLE<uint64_t>(ifd, m_fields.size());
+            ifd += 8;
+        } else {
+            storeLE<uint16_t>(ifd, static_cast<uint16_t>(m_fields.size()));
+            ifd += 2;
+        }
+        for (size_t k = 0; k < order.size(); ++k) {
+            const size_t i = order[k];
+            const Field& f = m_fields[i];
+            storeLE(ifd, f.tag);
+            storeLE(ifd + 2, f.type);
+            if (m_big) {
+                storeLE<uint64_t>(ifd + 4, f.count);
+            } else {
+                storeLE<uint32_t>(ifd + 4, static_cast<uint32_t>(f.count));
+            }
+            uint8_t* value = ifd + (m_big ? 12 : 8);
+            if (valueOffset[i]) {
+                std::memcpy(p + valueOffset[i], f.data.data(), f.data.size());
+                if (m_big) {
+                    storeLE<uint64_t>(value, base + valueOffset[i]);
+                } else {
+                    storeLE<uint32_t>(value, static_cast<uint32_t>(base + valueOffset[i]));
+                }
+            } else {
+                std::memcpy(value, f.data.data(), f.data.size());
+            }
+            ifd += entryBytes;
+        }
+        // Next IFD offset, 0 for the last image
+        if (m_big) {
+            storeLE<uint64_t>(ifd, m_next);
+        } else {
+            storeLE<uint32_t>(ifd, static_cast<uint32_t>(m_next));
+        }
+        return m_buffer;
+    }
+
+    /// Offset of the next directory after finishAt(..., true)
+    uint64_t nextOffset() const { return m_next; }
+
+private:
+    struct Field {
+        uint16_t tag;
+        uint16_t type;
+        uint64_t count;
+        std::vector<uint8_t> data;
+    };
+
+    Field& add(uint16_t tag, uint16_t type, uint64_t count, size_t bytes) {
+        Field f;
+        f.tag = tag;
+        f.type = type;
+        f.count = count;
+        f.data.assign(bytes, 0);
+        m_fields.push_back(f);
+        return m_fields.back();
+    }
+
+    bool m_big;
+    int m_stripOffsetField;
+    std::vector<uint64_t> m_stripSizes;
+    uint64_t m_next;
+    std::vector<Field> m_fields;
+    std::vector<uint8_t> m_buffer;
+};
+
+} // namespace Internal
+} // namespace HX
+
+#endif // TIFF_WRITER_H
@@ -0,0 +1,100 @@
+// ============================================================================
+// welford.h
+// ============================================================================
+
+/**
+ * @file welford.h
+ * @brief Streaming per-pixel mean and variance for calibration
+ * @version 2.1.0
+ *
+ * This header is INTERNAL to hubx.dll. Calibration frames are pushed one
+ * at a time (typically straight from OnFrameReady), so memory stays at two
+ * doubles per pixel however many frames are averaged.
+ */
+
+#ifndef WELFORD_H
+#define WELFORD_H
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#include "thread_pool.h"
+
+namespace HX {
+namespace Internal {
+
+/**
+ * @class WelfordAccumulator
+ * @brief Welford running mean and sum of squared deviations per pixel
+ *
+ * Not synchronized; owners that are fed from a callback thread lock
+ * around add() and the readers.
+ */
+class WelfordAccumulator {
+public:
+    WelfordAccumulator() : m_count(0) {}
+    
+    /**
+     * @brief Discard all samples and size for @p pixels values per sample
+     */
+    void reset(size_t pixels) {
+        m_mean.assign(pixels, 0.0);
+        m_m2.assign(pixels, 0.0);
+        m_count = 0;
+    }
+    
+    /**
+     * @brief Free the storage
+     */
+    void clear() {
+        std::vector<double>().swap(m_mean);
+        std::vector<double>().swap(m_m2);
+        m_count = 0;
+    }
+    
+    size_t pixels() const { return m_mean.size(); }
+    uint64_t count() const { return m_count; }
+    
+    /**
+     * @brief Add one sample of pixels() values
+     * @tparam T unsigned short or float
+     */
+    template <typename T>
+    void add(const T* values) {
+        const double inv = 1.0 / static_cast<double>(++m_count);
+        double* mean = m_mean.data();
+        double* m2 = m_m2.data();
+        
+        const int chunk = 4096;
+        const int chunks = static_cast<int>((m_mean.size() + chunk - 1) / chunk);
+        const size_t total = m_mean.size();
+        ThreadPool::instance().parallelRows(chunks, chunk, [&](int first, int end) {
+            const size_t last = std::min(total, static_cast<size_t>(end) * chunk);
+            for (size_t i = static_cast<size_t>(first) * chunk; i < last; ++i) {
+                const double x = static_cast<double>(values[i]);
+                const double delta = x - mean[i];
+                mean[i] += delta * inv;
+                m2[i] += delta * (x - mean[i]);
+            }
+        });
+    }
+    
+    double mean(size_t i) const { return m_mean[i]; }
+    
+    /**
+     * @brief Unbiased sample variance (0 with fewer than two samples)
+     */
+    double variance(size_t i) const {
+        return m_count > 1 ? m_m2[i] / static_cast<double>(m_count - 1) : 0.0;
+    }
+    
+private:
+    std::vector<double> m_mean;
+    std::vector<double> m_m2;
+    uint64_t m_count;
+};
+
+} // namespace Internal
+} // namespace HX
+
+#endif // WELFORD_H
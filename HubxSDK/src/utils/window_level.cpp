@@ -0,0 +1,99 @@
+// ============================================================================
+// window_level.cpp
+// ============================================================================
+
+/**
+ * @file window_level.cpp
+ * @brief Window/level kernels (scalar, AVX2, NEON)
+ * @version 2.1.0
+ */
+
+#include "window_level.h"
+#include "cpu_features.h"
+
+namespace HX {
+namespace Internal {
+
+namespace {
+
+const KernelFamily g_windowKernels("window_level", XFactory::CPU_AVX2 | XFactory::CPU_NEON);
+
+void Window16Scalar(const uint8_t* src, uint8_t* dst, uint32_t count, const WindowParams& w) {
+    for (uint32_t i = 0; i < count; ++i) {
+        dst[i] = windowLevel(XPixelAccess<2>::Load(src + i * 2), w);
+    }
+}
+
+#if defined(HX_ARCH_X86)
+
+HX_TARGET("avx2")
+void Window16AVX2(const uint8_t* src, uint8_t* dst, uint32_t count, const WindowParams& w) {
+    const __m256i low = _mm256_set1_epi16(static_cast<short>(w.low));
+    const __m256i range = _mm256_set1_epi16(static_cast<short>(w.range));
+    const __m256i scale = _mm256_set1_epi32(static_cast<int>(w.scale));
+    uint32_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i * 2));
+        d = _mm256_min_epu16(_mm256_subs_epu16(d, low), range);
+        __m256i lo = _mm256_cvtepu16_epi32(_mm256_castsi256_si128(d));
+        __m256i hi = _mm256_cvtepu16_epi32(_mm256_extracti128_si256(d, 1));
+        lo = _mm256_srli_epi32(_mm256_mullo_epi32(lo, scale), 16);
+        hi = _mm256_srli_epi32(_mm256_mullo_epi32(hi, scale), 16);
+        // packus works per 128-bit lane; restore pixel order before narrowing
+        const __m256i words = _mm256_permute4x64_epi64(_mm256_packus_epi32(lo, hi), 0xD8);
+        const __m128i bytes = _mm_packus_epi16(_mm256_castsi256_si128(words),
+                                               _mm256_extracti128_si256(words, 1));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), bytes);
+    }
+    Window16Scalar(src + i * 2, dst + i, count - i, w);
+}
+
+#endif // HX_ARCH_X86
+
+#if defined(HX_ARCH_NEON)
+
+void Window16NEON(const uint8_t* src, uint8_t* dst, uint32_t count, const WindowParams& w) {
+    const uint16x8_t low = vdupq_n_u16(static_cast<uint16_t>(w.low));
+    const uint16x8_t range = vdupq_n_u16(static_cast<uint16_t>(w.range));
+    const uint32x4_t scale = vdupq_n_u32(w.scale);
+    uint32_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        uint16x8_t d = vreinterpretq_u16_u8(vld1q_u8(src + i * 2));
+        d = vminq_u16(vqsubq_u16(d, low), range);
+        const uint32x4_t lo = vmulq_u32(vmovl_u16(vget_low_u16(d)), scale);
+        const uint32x4_t hi = vmulq_u32(vmovl_u16(vget_high_u16(d)), scale);
+        const uint16x8_t words = vcombine_u16(vshrn_n_u32(lo, 16), vshrn_n_u32(hi, 16));
+        vst1_u8(dst + i, vqmovn_u16(words));
+    }
+    Window16Scalar(src + i * 2, dst + i, count - i, w);
+}
+
+#endif // HX_ARCH_NEON
+
+} // anonymous namespace
+
+WindowKernel selectWindowKernel() {
+    switch (g_windowKernels.isa()) {
+#if defined(HX_ARCH_X86)
+    case XFactory::CPU_AVX2: return &Window16AVX2;
+#endif
+#if defined(HX_ARCH_NEON)
+    case XFactory::CPU_NEON: return &Window16NEON;
+#endif
+    default: return &Window16Scalar;
+    }
+}
+
+WindowParams makeWindow(uint32_t low, uint32_t high, uint32_t pixelDepth) {
+    WindowParams w;
+    const uint32_t maxVal = windowMaxValue(pixelDepth);
+    high = (high == 0) ? maxVal : std::min(high, maxVal);
+    w.low = std::min(low, maxVal - 1);
+    high = std::max(high, w.low + 1);
+    w.range = high - w.low;
+    w.scale = static_cast<uint32_t>(((255ull << 16) + w.range - 1) / w.range);
+    return w;
+}
+
+} // namespace Internal
+} // namespace HX
@@ -0,0 +1,138 @@
+// ============================================================================
+// window_level.h
+// ============================================================================
+
+/**
+ * @file window_level.h
+ * @brief Window/level mapping of raw pixels to 8-bit display levels
+ * @version 2.1.0
+ *
+ * This header is INTERNAL to hubx.dll. Shared by XShow and the preview
+ * server, so a remote viewer sees the same levels as the local window.
+ * The window is applied in fixed point:
+ *
+ *   level = min(v - low, range) * scale >> 16
+ *
+ * with scale rounded up, so low maps to 0 and low + range to 255.
+ */
+
+#ifndef WINDOW_LEVEL_H
+#define WINDOW_LEVEL_H
+
+#include "XImage.h"
+#include "XPixel.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace HX {
+namespace Internal {
+
+/// Histogram resolution of the auto-window
+const uint32_t WINDOW_BINS_SHIFT = 12;
+
+/// Pixels sampled per image for the auto-window
+const uint64_t WINDOW_SAMPLES = 65536;
+
+/**
+ * @brief Window of one frame in fixed point
+ */
+struct WindowParams {
+    uint32_t low;
+    uint32_t range;
+    uint32_t scale;
+};
+
+/**
+ * @brief Window a run of 16-bit pixels to levels
+ */
+typedef void (*WindowKernel)(const uint8_t* src, uint8_t* dst, uint32_t count,
+                             const WindowParams& w);
+
+inline uint8_t windowLevel(uint32_t value, const WindowParams& w) {
+    uint64_t d = (value > w.low) ? value - w.low : 0;
+    if (d > w.range) {
+        d = w.range;
+    }
+    return static_cast<uint8_t>(std::min<uint64_t>((d * w.scale) >> 16, 255));
+}
+
+/**
+ * @brief Pick the fastest 16-bit window kernel for this CPU
+ */
+WindowKernel selectWindowKernel();
+
+/**
+ * @brief Largest pixel value of a depth
+ */
+inline uint32_t windowMaxValue(uint32_t pixelDepth) {
+    return (pixelDepth >= 32) ? 0xFFFFFFFFu : ((1u << pixelDepth) - 1);
+}
+
+/**
+ * @brief Fixed-point window for low..high
+ * @param low Window start
+ * @param high Window end; 0 is the full 0..2^depth-1 range
+ * @param pixelDepth Bits per pixel
+ */
+WindowParams makeWindow(uint32_t low, uint32_t high, uint32_t pixelDepth);
+
+/**
+ * @brief Window covering the histogram of a frame
+ * @param image Frame
+ * @param pixelDepth Bits per pixel
+ * @param clip Fraction of samples dropped at each end
+ * @param low Window start
+ * @param high Window end
+ *
+ * Samples a regular grid of about WINDOW_SAMPLES pixels.
+ */
+template <uint32_t Bytes>
+void autoWindowRange(const XImage* image, uint32_t pixelDepth, float clip,
+                     uint32_t& low, uint32_t& high) {
+    const uint32_t rows = image->_height;
+    const uint32_t cols = image->_width;
+    const uint64_t pixels = static_cast<uint64_t>(rows) * cols;
+    if (pixels == 0) {
+        return;
+    }
+
+    const uint32_t shift = (pixelDepth > WINDOW_BINS_SHIFT) ? pixelDepth - WINDOW_BINS_SHIFT : 0;
+    const uint32_t bins = 1u << (std::min(pixelDepth, 32u) - shift);
+    const uint32_t step = static_cast<uint32_t>(
+        std::max<double>(1.0, std::sqrt(static_cast<double>(pixels) / WINDOW_SAMPLES)));
+    std::vector<uint32_t> histogram(bins, 0);
+    uint64_t samples = 0;
+    for (uint32_t row = step / 2; row < rows; row += step) {
+        XPixelRow<Bytes> line = image->Row<Bytes>(row);
+        for (uint32_t col = step / 2; col < cols; col += step) {
+            ++histogram[std::min(line.Get(col) >> shift, bins - 1)];
+            ++samples;
+        }
+    }
+
+    // Drop the clip fraction at each end
+    const uint64_t clipped = static_cast<uint64_t>(samples * clip);
+    uint32_t lowBin = 0;
+    uint64_t count = 0;
+    while (lowBin + 1 < bins && count + histogram[lowBin] <= clipped) {
+        count += histogram[lowBin++];
+    }
+    uint32_t highBin = bins - 1;
+    count = 0;
+    while (highBin > lowBin && count + histogram[highBin] <= clipped) {
+        count += histogram[highBin--];
+    }
+
+    const uint64_t first = static_cast<uint64_t>(lowBin) << shift;
+    const uint64_t last = std::min<uint64_t>(((static_cast<uint64_t>(highBin) + 1) << shift) - 1,
+                                             windowMaxValue(pixelDepth));
+    low = static_cast<uint32_t>(first);
+    high = static_cast<uint32_t>(std::max<uint64_t>(last, first + 1));
+}
+
+} // namespace Internal
+} // namespace HX
+
+#endif // WINDOW_LEVEL_H
@@ -0,0 +1,290 @@
+// ============================================================================
+// x11_display.cpp
+// ============================================================================
+
+/**
+ * @file x11_display.cpp
+ * @brief X11 presentation of converted frames (MIT-SHM)
+ * @version 2.1.0
+ */
+
+#include "x11_display.h"
+
+#ifdef HUBX_WITH_X11
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include <X11/extensions/XShm.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#endif
+
+namespace HX {
+namespace Internal {
+
+#ifdef HUBX_WITH_X11
+
+namespace {
+
+// Set by trapErrors() while a request that may fail is checked
+bool g_xError = false;
+
+int trapHandler(Display* display, XErrorEvent* event) {
+    (void)display;
+    (void)event;
+    g_xError = true;
+    return 0;
+}
+
+/**
+ * @brief Run requests with X errors recorded instead of ending the process
+ */
+template <typename Fn>
+bool trapErrors(Display* display, Fn fn) {
+    XSync(display, False);
+    g_xError = false;
+    int (*previous)(Display*, XErrorEvent*) = XSetErrorHandler(trapHandler);
+    const bool ok = fn();
+    XSync(display, False);
+    XSetErrorHandler(previous);
+    return ok && !g_xError;
+}
+
+} // anonymous namespace
+
+X11Display::X11Display()
+    : m_display(nullptr)
+    , m_image(nullptr)
+    , m_gc(nullptr)
+    , m_shm(nullptr)
+    , m_window(0)
+    , m_buffer(nullptr)
+    , m_stride(0)
+{
+}
+
+X11Display::~X11Display() {
+    destroy();
+}
+
+bool X11Display::create(void* window, uint32_t width, uint32_t height) {
+    destroy();
+    if (!window || width == 0 || height == 0) {
+        return false;
+    }
+    Display* display = XOpenDisplay(nullptr);
+    if (!display) {
+        std::cerr << "[XShow] Cannot open X display" << std::endl;
+        return false;
+    }
+    m_display = display;
+    m_window = reinterpret_cast<unsigned long>(window);
+
+    // The image must match the window's visual; XShm does no conversion
+    XWindowAttributes attributes;
+    if (!trapErrors(display, [&] {
+            return XGetWindowAttributes(display, m_window, &attributes) != 0;
+        })) {
+        std::cerr << "[XShow] Invalid X window" << std::endl;
+        destroy();
+        return false;
+    }
+    Visual* visual = attributes.visual;
+    if ((attributes.depth != 24 && attributes.depth != 32) || visual->red_mask != 0xFF0000 ||
+        visual->green_mask != 0xFF00 || visual->blue_mask != 0xFF) {
+        std::cerr << "[XShow] Unsupported X visual (depth " << attributes.depth << ")" << std::endl;
+        destroy();
+        return false;
+    }
+
+    ::XImage* image = nullptr;
+    if (XShmQueryExtension(display)) {
+        XShmSegmentInfo* shm = new XShmSegmentInfo;
+        memset(shm, 0, sizeof(XShmSegmentInfo));
+        image = XShmCreateImage(display, visual, attributes.depth, ZPixmap, nullptr, shm,
+                                width, height);
+        if (image) {
+            shm->shmid = shmget(IPC_PRIVATE, static_cast<size_t>(image->bytes_per_line) * height,
+                                IPC_CREAT | 0600);
+        }
+        if (image && shm->shmid >= 0) {
+            shm->shmaddr = image->data = static_cast<char*>(shmat(shm->shmid, nullptr, 0));
+            shm->readOnly = False;
+            const bool attached = shm->shmaddr != reinterpret_cast<char*>(-1) &&
+                trapErrors(display, [&] { return XShmAttach(display, shm) != 0; });
+
+            // Freed once both sides detach
+            shmctl(shm->shmid, IPC_RMID, nullptr);
+            if (attached) {
+                m_shm = shm;
+            } else if (shm->shmaddr != reinterpret_cast<char*>(-1)) {
+                shmdt(shm->shmaddr);
+            }
+        }
+        if (!m_shm) {
+            // Remote server: fall back to XPutImage
+            if (image) {
+                image->data = nullptr;
+                XDestroyImage(image);
+                image = nullptr;
+            }
+            delete shm;
+        }
+    }
+    if (!image) {
+        image = XCreateImage(display, visual, attributes.depth, ZPixmap, 0, nullptr,
+                             width, height, 32, 0);
+        if (image) {
+            image->data = static_cast<char*>(malloc(static_cast<size_t>(image->bytes_per_line) * height));
+            if (!image->data) {
+                XDestroyImage(image);
+                image = nullptr;
+            }
+        }
+    }
+    m_image = image;
+    if (!image || image->bits_per_pixel != 32 || image->byte_order != LSBFirst) {
+        std::cerr << "[XShow] Cannot create X image" << std::endl;
+        destroy();
+        return false;
+    }
+
+    m_gc = XCreateGC(display, m_window, 0, nullptr);
+    m_buffer = reinterpret_cast<uint8_t*>(image->data);
+    m_stride = static_cast<size_t>(image->bytes_per_line);
+
+    // Black, opaque; the fourth byte is alpha on 32-bit visuals and never rewritten
+    memset(m_buffer, 0, m_stride * height);
+    for (uint32_t row = 0; row < height; ++row) {
+        uint8_t* pixel = m_buffer + static_cast<size_t>(row) * m_stride;
+        for (uint32_t col = 0; col < width; ++col) {
+            pixel[col * 4 + 3] = 0xFF;
+        }
+    }
+    return true;
+}
+
+void X11Display::destroy() {
+    Display* display = static_cast<Display*>(m_display);
+    if (!display) {
+        return;
+    }
+    ::XImage* image = static_cast< ::XImage*>(m_image);
+    XShmSegmentInfo* shm = static_cast<XShmSegmentInfo*>(m_shm);
+    if (shm) {
+        XShmDetach(display, shm);
+        XSync(display, False);
+        shmdt(shm->shmaddr);
+        delete shm;
+        if (image) {
+            image->data = nullptr;
+        }
+    }
+    if (image) {
+        XDestroyImage(image);
+    }
+    if (m_gc) {
+        XFreeGC(display, static_cast<GC>(m_gc));
+    }
+    XCloseDisplay(display);
+
+    m_display = nullptr;
+    m_image = nullptr;
+    m_gc = nullptr;
+    m_shm = nullptr;
+    m_window = 0;
+    m_buffer = nullptr;
+    m_stride = 0;
+}
+
+bool X11Display::windowSize(uint32_t& width, uint32_t& height) {
+    Display* display = static_cast<Display*>(m_display);
+    if (!display) {
+        return false;
+    }
+    Window root;
+    int x, y;
+    unsigned int w, h, border, depth;
+    if (!XGetGeometry(display, m_window, &root, &x, &y, &w, &h, &border, &depth)) {
+        return false;
+    }
+    width = w;
+    height = h;
+    return true;
+}
+
+void X11Display::put(uint32_t x, uint32_t srcRow, uint32_t width, uint32_t rows, uint32_t y) {
+    Display* display = static_cast<Display*>(m_display);
+    if (!display || rows == 0) {
+        return;
+    }
+    ::XImage* image = static_cast< ::XImage*>(m_image);
+    GC gc = static_cast<GC>(m_gc);
+    if (m_shm) {
+        XShmPutImage(display, m_window, gc, image, x, srcRow, x, y, width, rows, False);
+    } else {
+        XPutImage(display, m_window, gc, image, x, srcRow, x, y, width, rows);
+    }
+}
+
+void X11Display::flush() {
+    Display* display = static_cast<Display*>(m_display);
+    if (!display) {
+        return;
+    }
+    if (m_shm) {
+        XSync(display, False);
+    } else {
+        XFlush(display);
+    }
+}
+
+#else // !HUBX_WITH_X11
+
+X11Display::X11Display()
+    : m_display(nullptr)
+    , m_image(nullptr)
+    , m_gc(nullptr)
+    , m_shm(nullptr)
+    , m_window(0)
+    , m_buffer(nullptr)
+    , m_stride(0)
+{
+}
+
+X11Display::~X11Display() {
+}
+
+bool X11Display::create(void* window, uint32_t width, uint32_t height) {
+    (void)window;
+    (void)width;
+    (void)height;
+    return false;
+}
+
+void X11Display::destroy() {
+}
+
+bool X11Display::windowSize(uint32_t& width, uint32_t& height) {
+    (void)width;
+    (void)height;
+    return false;
+}
+
+void X11Display::put(uint32_t x, uint32_t srcRow, uint32_t width, uint32_t rows, uint32_t y) {
+    (void)x;
+    (void)srcRow;
+    (void)width;
+    (void)rows;
+    (void)y;
+}
+
+void X11Display::flush() {
+}
+
+#endif // HUBX_WITH_X11
+
+} // namespace Internal
+} // namespace HX
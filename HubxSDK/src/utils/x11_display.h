@@ -0,0 +1,103 @@
+// ============================================================================
+// x11_display.h
+// ============================================================================
+
+/**
+ * @file x11_display.h
+ * @brief X11 presentation of converted frames for XShow
+ * @version 2.1.0
+ *
+ * This header is INTERNAL to hubx.dll. XShow converts frames straight into
+ * the pixel buffer of an X image (BGRX, 4 bytes per pixel); with the
+ * MIT-SHM extension that buffer is shared with the X server, so putting it
+ * on the window costs no copy through the socket. Remote displays without
+ * MIT-SHM fall back to XPutImage on the same buffer.
+ *
+ * The display opens its own connection, so the window may belong to any
+ * toolkit; calls must come from one thread at a time.
+ *
+ * Only implemented when built with HUBX_WITH_X11; elsewhere create() fails.
+ */
+
+#ifndef X11_DISPLAY_H
+#define X11_DISPLAY_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace HX {
+namespace Internal {
+
+class X11Display {
+public:
+    X11Display();
+    ~X11Display();
+
+    /**
+     * @brief Connect to the window's server and allocate the image
+     * @param window X11 Window id
+     * @param width Image width in pixels
+     * @param height Image height in rows
+     * @return false without a server or a 24-bit TrueColor visual
+     */
+    bool create(void* window, uint32_t width, uint32_t height);
+
+    /**
+     * @brief Release the image, shared segment and connection
+     */
+    void destroy();
+
+    bool isValid() const { return m_display != nullptr; }
+
+    /**
+     * @brief Pixel buffer, B, G, R and one unused byte per pixel
+     */
+    uint8_t* buffer() const { return m_buffer; }
+
+    /**
+     * @brief Bytes between buffer rows
+     */
+    size_t stride() const { return m_stride; }
+
+    /**
+     * @brief Get the window's current size
+     * @return false if the window is gone
+     */
+    bool windowSize(uint32_t& width, uint32_t& height);
+
+    /**
+     * @brief Copy a band of the buffer to the window
+     * @param x First column, in the buffer and the window
+     * @param srcRow First buffer row
+     * @param width Columns to copy
+     * @param rows Rows to copy
+     * @param y Window row of the first one
+     */
+    void put(uint32_t x, uint32_t srcRow, uint32_t width, uint32_t rows, uint32_t y);
+
+    /**
+     * @brief Send queued requests to the server
+     *
+     * With MIT-SHM this waits for the server, since the next frame is
+     * converted into the buffer it reads from.
+     */
+    void flush();
+
+private:
+    void* m_display;
+    void* m_image;
+    void* m_gc;
+    void* m_shm;
+    unsigned long m_window;
+    uint8_t* m_buffer;
+    size_t m_stride;
+
+    // Non-copyable
+    X11Display(const X11Display&) = delete;
+    X11Display& operator=(const X11Display&) = delete;
+};
+
+} // namespace Internal
+} // namespace HX
+
+#endif // X11_DISPLAY_H
@@ -14,6 +14,7 @@
 
 #include <cstdint>
 #include <cstdio>
+#include "../utils/crc16.h"
 
 namespace HX {
 namespace Internal {
@@ -48,7 +49,8 @@ enum XLibErrorCode {
     XLIB_ERROR_NOT_INITIALIZED = -12,  ///< Not initialized
     XLIB_ERROR_ALREADY_OPEN = -13,     ///< Already opened
     XLIB_ERROR_NOT_OPEN = -14,         ///< Not opened
-    XLIB_ERROR_NO_DEVICE = -15         ///< No device available
+    XLIB_ERROR_NO_DEVICE = -15,        ///< No device available
+    XLIB_ERROR_CANCELLED = -16         ///< Receive woken by XLibProxy_WakeImageReceive
 };
 
 /**
@@ -110,6 +112,52 @@ struct XLibPacketHeader {
     uint8_t reserved[8];      ///< Reserved
 };
 
+/// Bytes of the image packet header on the wire
+const uint32_t XLIB_PACKET_HEADER_SIZE = 8;
+
+/// Bytes of the CRC16 trailer of image packets sent with checksums
+const uint32_t XLIB_PACKET_CRC_SIZE = 2;
+
+/// Header bytes of a packet carrying part of a line: the header, then the part's byte offset
+const uint32_t XLIB_FRAGMENT_HEADER_SIZE = 12;
+
+/// Bit of the energy byte set on the first line after a frame trigger
+const uint8_t XLIB_FLAG_FRAME_TRIGGER = 0x80;
+
+/**
+ * @struct XLibPacketView
+ * @brief Image packet header read in place from the received bytes
+ *
+ * The wire header is little-endian: packetId in bytes 0-3, lineId in 4-5,
+ * energyFlag in 6, moduleId in 7; the top bit of byte 6 marks the first
+ * line of an externally triggered frame. It has no timestamp field, so
+ * lines are timed by their arrival. Packets of a split line add the byte offset of
+ * their payload in the line in bytes 8-11. Unlike
+ * XLibProxy_ExtractPacketHeader() nothing is copied or cleared; the packet
+ * must outlive the view.
+ */
+struct XLibPacketView {
+    const uint8_t* data;      ///< First header byte
+
+    explicit XLibPacketView(const uint8_t* packet) : data(packet) {}
+
+    uint32_t packetId() const {
+        return static_cast<uint32_t>(data[0]) | static_cast<uint32_t>(data[1]) << 8 |
+               static_cast<uint32_t>(data[2]) << 16 | static_cast<uint32_t>(data[3]) << 24;
+    }
+    uint16_t lineId() const { return static_cast<uint16_t>(data[4] | data[5] << 8); }
+    uint8_t energyFlag() const { return static_cast<uint8_t>(data[6] & ~XLIB_FLAG_FRAME_TRIGGER); }
+    bool frameTrigger() const { return (data[6] & XLIB_FLAG_FRAME_TRIGGER) != 0; }
+    uint8_t moduleId() const { return data[7]; }
+    uint32_t timestamp() const { return 0; }
+
+    /// Split lines only (XLIB_FRAGMENT_HEADER_SIZE header)
+    uint32_t fragmentOffset() const {
+        return static_cast<uint32_t>(data[8]) | static_cast<uint32_t>(data[9]) << 8 |
+               static_cast<uint32_t>(data[10]) << 16 | static_cast<uint32_t>(data[11]) << 24;
+    }
+};
+
 /**
  * @struct XLibNetworkConfig
  * @brief Network configuration structure
@@ -122,7 +170,10 @@ struct XLibNetworkConfig {
     uint16_t imgPort;         ///< Image data channel port
     uint32_t timeout;         ///< Default timeout (ms)
     uint32_t bufferSize;      ///< Socket buffer size
-    uint8_t reserved[32];     ///< Reserved
+    uint32_t busyPollUs;      ///< SO_BUSY_POLL microseconds (0 = off)
+    uint8_t timestamping;     ///< Enable receive timestamping (SO_TIMESTAMPING)
+    uint8_t dscp;             ///< DSCP code point for the socket (0-63)
+    uint8_t reserved[26];     ///< Reserved
 };
 
 /**
@@ -168,6 +219,40 @@ struct XLibImageBuffer {
     uint8_t reserved[16];     ///< Reserved
 };
 
+/**
+ * @struct XLibPacketSlot
+ * @brief One packet slot for batched image reception
+ */
+struct XLibPacketSlot {
+    uint8_t* buffer;          ///< Caller-owned packet buffer
+    uint32_t bufferSize;      ///< Buffer capacity in bytes
+    uint32_t length;          ///< Bytes received into this slot
+};
+
+/**
+ * @struct XLibXdpConfig
+ * @brief Kernel-bypass (AF_XDP) image receive settings
+ */
+struct XLibXdpConfig {
+    char interfaceName[32];   ///< Network interface the detector is on
+    uint32_t queueId;         ///< NIC receive queue carrying the image flow
+    char remoteIP[32];        ///< Detector IP; other sources are passed to the kernel
+    uint16_t imgPort;         ///< Image port redirected to the socket
+    uint32_t frameSize;       ///< UMEM frame size, XLIB_XDP_FRAME_SIZE
+    uint32_t flags;           ///< XLIB_XDP_* flags
+    uint8_t reserved[24];     ///< Reserved
+};
+
+/**
+ * @struct XLibXdpDesc
+ * @brief One image packet received into the UMEM
+ */
+struct XLibXdpDesc {
+    uint64_t addr;            ///< UMEM offset of the UDP payload
+    uint32_t length;          ///< UDP payload bytes
+    uint32_t reserved;        ///< Reserved
+};
+
 /**
  * @struct XLibDetectorConfig
  * @brief Detector configuration from xlibdll
@@ -227,6 +312,18 @@ const uint32_t XLIB_DEFAULT_BUFFER_SIZE = 131072; // 128KB
 /// UDP packet header size
 const uint32_t XLIB_UDP_HEADER_SIZE = 28;
 
+/// AF_XDP UMEM frame size: one packet per frame, headroom and headers included
+const uint32_t XLIB_XDP_FRAME_SIZE = 4096;
+
+/// Bytes of a UMEM frame ahead of the UDP payload (XDP headroom, untagged Ethernet, IPv4, UDP)
+const uint32_t XLIB_XDP_PAYLOAD_OFFSET = 256 + 14 + 20 + 8;
+
+/// Require zero-copy driver mode instead of falling back to copy mode
+const uint32_t XLIB_XDP_ZEROCOPY = 0x1;
+
+/// Keep the NIC interrupt off; the receive thread busy-polls (XDP_USE_NEED_WAKEUP off)
+const uint32_t XLIB_XDP_BUSY_POLL = 0x2;
+
 /// Command packet header signature
 const uint16_t XLIB_PACKET_HEADER = 0xAA55;
 
@@ -283,6 +380,21 @@ bool XLibProxy_IsLoaded();
  */
 int32_t XLibProxy_InitNetwork(const char* localIP, uint16_t port);
 
+/**
+ * @brief Initialize network interface with full socket configuration
+ * 
+ * Applies SO_RCVBUF, SO_BUSY_POLL, SO_TIMESTAMPING and IP_TOS from
+ * @p config, then reads them back so the caller sees what the kernel
+ * actually granted (e.g. SO_RCVBUF clamped by net.core.rmem_max).
+ * 
+ * @param config Requested configuration
+ * @param effective Output effective configuration (may be nullptr)
+ * @return 0 on success, negative error code on failure
+ * @internal This function is for internal use only
+ */
+int32_t XLibProxy_InitNetworkEx(const XLibNetworkConfig* config,
+                                XLibNetworkConfig* effective);
+
 /**
  * @brief Close network interface
  * @internal This function is for internal use only
@@ -303,17 +415,234 @@ int32_t XLibProxy_SendCommand(const uint8_t* cmd, uint32_t cmdLen,
                                uint8_t* response, uint32_t* responseLen,
                                uint32_t timeout);
 
+/**
+ * @brief Send a command without waiting for its response
+ *
+ * The sequence number travels in the command frame header and the GCU
+ * echoes it in the response, so several commands can be in flight and
+ * their responses matched with XLibProxy_ReceiveCommandResponse.
+ *
+ * @param cmd Command buffer
+ * @param cmdLen Command length
+ * @param sequence Sequence number echoed in the response
+ * @return 0 on success, negative error code on failure
+ * @internal This function is for internal use only
+ */
+int32_t XLibProxy_PostCommand(const uint8_t* cmd, uint32_t cmdLen,
+                              uint16_t sequence);
+
+/**
+ * @brief Receive the next command response, whichever command it answers
+ * @param sequence Output sequence number of the answered command
+ * @param response Response buffer
+ * @param responseLen Pointer to response length (buffer size on input)
+ * @param timeout Timeout in milliseconds
+ * @return Bytes received on success, XLIB_ERROR_TIMEOUT if none arrived,
+ *         other negative error code on failure
+ * @internal This function is for internal use only
+ */
+int32_t XLibProxy_ReceiveCommandResponse(uint16_t* sequence,
+                                         uint8_t* response, uint32_t* responseLen,
+                                         uint32_t timeout);
+
 /**
  * @brief Receive image data packet
  * @param buffer Data buffer
  * @param bufferSize Buffer size
- * @param timeout Timeout in milliseconds
+ * @param timeout Timeout in milliseconds (0 = poll once without blocking)
  * @return Bytes received on success, negative error code on failure
  * @internal This function is for internal use only
  */
 int32_t XLibProxy_ReceiveImageData(uint8_t* buffer, uint32_t bufferSize,
                                    uint32_t timeout);
 
+/**
+ * @brief Receive several image data packets in one call
+ * 
+ * Fills up to @p slotCount slots with one packet each (recvmmsg on Linux,
+ * WSARecvMsg loop on Windows). Blocks until at least one packet arrives
+ * or the timeout expires, then returns whatever is already queued.
+ * 
+ * @param slots Packet slot array
+ * @param slotCount Number of slots
+ * @param timeout Timeout in milliseconds
+ * @return Number of slots filled on success, negative error code on failure
+ * @internal This function is for internal use only
+ */
+int32_t XLibProxy_ReceiveImageBatch(XLibPacketSlot* slots, uint32_t slotCount,
+                                    uint32_t timeout);
+
+/**
+ * @brief Receive several image packets with their NIC receive timestamps
+ * 
+ * As XLibProxy_ReceiveImageBatch, plus the hardware receive time of each
+ * packet from the SO_TIMESTAMPING control message (Linux; the NIC's PTP
+ * clock, nanoseconds since 1970). Requires timestamping in
+ * XLibProxy_InitNetworkEx; a packet the NIC did not stamp reads 0.
+ * 
+ * @param slots Packet slot array
+ * @param receiveNs Receive time per filled slot
+ * @param slotCount Number of slots and timestamps
+ * @param timeout Timeout in milliseconds
+ * @return Number of slots filled on success, negative error code on failure
+ * @internal This function is for internal use only
+ */
+int32_t XLibProxy_ReceiveImageBatchTimed(XLibPacketSlot* slots, uint64_t* receiveNs,
+                                         uint32_t slotCount, uint32_t timeout);
+
+/**
+ * @brief Receive one image packet split into header and payload buffers
+ * 
+ * Scatter receive (recvmsg/WSARecv with two iovecs): the first
+ * @p headerSize bytes land in @p header and the rest goes straight to
+ * @p payload, so the caller can point @p payload at its final destination.
+ * 
+ * @param header Header buffer
+ * @param headerSize Header size in bytes (0 = no header)
+ * @param payload Payload buffer
+ * @param payloadSize Payload buffer size
+ * @param timeout Timeout in milliseconds
+ * @return Total bytes received on success, XLIB_ERROR_BUFFER_OVERFLOW if the
+ *         packet was truncated, other negative error code on failure
+ * @internal This function is for internal use only
+ */
+int32_t XLibProxy_ReceiveImageScatter(uint8_t* header, uint32_t headerSize,
+                                      uint8_t* payload, uint32_t payloadSize,
+                                      uint32_t timeout);
+
+/**
+ * @brief Open one image receive queue of a multi-queue group
+ * 
+ * Every queue of a group binds its own socket to the image port with
+ * SO_REUSEPORT, so the kernel spreads module flows over the queues.
+ * 
+ * @param config Network configuration (shared by all queues)
+ * @param queueIndex Queue index (0-based)
+ * @param queueCount Number of queues in the group
+ * @return Queue handle (>= 0) on success, negative error code on failure
+ * @internal This function is for internal use only
+ */
+int32_t XLibProxy_OpenImageQueue(const XLibNetworkConfig* config,
+                                 uint32_t queueIndex, uint32_t queueCount);
+
+/**
+ * @brief Close an image receive queue
+ * @param queue Queue handle from XLibProxy_OpenImageQueue
+ * @internal This function is for internal use only
+ */
+void XLibProxy_CloseImageQueue(int32_t queue);
+
+/**
+ * @brief Receive several image packets from one queue
+ * @param queue Queue handle from XLibProxy_OpenImageQueue
+ * @param slots Packet slot array
+ * @param slotCount Number of slots
+ * @param timeout Timeout in milliseconds
+ * @return Number of slots filled on success, negative error code on failure
+ * @internal This function is for internal use only
+ */
+int32_t XLibProxy_ReceiveImageQueue(int32_t queue, XLibPacketSlot* slots,
+                                    uint32_t slotCount, uint32_t timeout);
+
+/**
+ * @brief Open a kernel-bypass image receive socket (AF_XDP)
+ * 
+ * Registers the caller's buffer as UMEM, puts every frame of it on the
+ * fill ring and attaches an XDP program that redirects the detector's
+ * image packets on the given NIC queue to the socket; other traffic goes
+ * on to the kernel. Packets are then written by the NIC into the UMEM and
+ * read without a system call per packet or a copy.
+ * 
+ * @param config Interface, queue and flow to redirect
+ * @param umem Page-aligned buffer, owned by the caller until CloseImageXdp
+ * @param umemSize Buffer size, a multiple of frameSize
+ * @return Socket handle (>= 0) on success, negative error code on failure
+ *         (not Linux, no XDP support in the driver, missing CAP_NET_RAW/CAP_BPF)
+ * @internal This function is for internal use only
+ */
+int32_t XLibProxy_OpenImageXdp(const XLibXdpConfig* config, uint8_t* umem, uint64_t umemSize);
+
+/**
+ * @brief Detach the XDP program and close the socket
+ * @param handle Handle from XLibProxy_OpenImageXdp
+ * @internal This function is for internal use only
+ */
+void XLibProxy_CloseImageXdp(int32_t handle);
+
+/**
+ * @brief Take received packets off the AF_XDP RX ring
+ * 
+ * A frame stays with the caller until it is given back with
+ * XLibProxy_ReleaseImageXdp. Blocking waits poll the socket together with
+ * the wake descriptor, like the other XLibProxy_ReceiveImage* calls.
+ * 
+ * @param handle Handle from XLibProxy_OpenImageXdp
+ * @param descs Output descriptors
+ * @param count Capacity of descs
+ * @param timeout Timeout in milliseconds (0 = poll once)
+ * @return Descriptors filled on success, negative error code on failure
+ * @internal This function is for internal use only
+ */
+int32_t XLibProxy_ReceiveImageXdp(int32_t handle, XLibXdpDesc* descs, uint32_t count,
+                                  uint32_t timeout);
+
+/**
+ * @brief Return UMEM frames to the fill ring
+ * 
+ * May be called from another thread than XLibProxy_ReceiveImageXdp: the
+ * receive thread only consumes the RX ring, the releasing one only
+ * produces on the fill ring.
+ * 
+ * @param handle Handle from XLibProxy_OpenImageXdp
+ * @param addrs Any address inside each frame, such as XLibXdpDesc::addr
+ * @param count Number of addresses
+ * @return 0 on success, negative error code on failure
+ * @internal This function is for internal use only
+ */
+int32_t XLibProxy_ReleaseImageXdp(int32_t handle, const uint64_t* addrs, uint32_t count);
+
+/**
+ * @brief Native descriptor of the image socket (queue 0)
+ *
+ * For callers that drive the socket themselves (io_uring): every datagram
+ * read from it is one image packet, as XLibProxy_ReceiveImageData returns
+ * it. The descriptor stays owned by the proxy and is closed by
+ * XLibProxy_CloseNetwork; until XLibProxy_ReleaseImageSocket, reads on it
+ * and XLibProxy_ReceiveImage* calls split the packet stream between them.
+ *
+ * @return Descriptor (>= 0) on success, negative error code on failure
+ *         (network not open, no descriptor on this platform)
+ * @internal This function is for internal use only
+ */
+int32_t XLibProxy_GetImageSocket();
+
+/**
+ * @brief Hand the image socket back to the XLibProxy_ReceiveImage* calls
+ * @internal This function is for internal use only
+ */
+void XLibProxy_ReleaseImageSocket();
+
+/**
+ * @brief Wake every thread blocked in an image receive call
+ * 
+ * Signals the proxy's wake descriptor (eventfd on Linux, a loopback
+ * socket on Windows) that is polled together with the image sockets.
+ * The wake is level-triggered: blocked and later XLibProxy_ReceiveImage*
+ * calls return XLIB_ERROR_CANCELLED at once until it is cleared, so a
+ * receiver that races the stop request cannot block for the full timeout.
+ * 
+ * @return 0 on success, negative error code on failure
+ * @internal This function is for internal use only
+ */
+int32_t XLibProxy_WakeImageReceive();
+
+/**
+ * @brief Clear a pending image receive wake
+ * @return 0 on success, negative error code on failure
+ * @internal This function is for internal use only
+ */
+int32_t XLibProxy_ClearImageWake();
+
 // ============================================================================
 // Device Discovery Functions
 // ============================================================================
@@ -335,6 +664,37 @@ int32_t XLibProxy_DiscoverDevices(const char* localIP);
  */
 int32_t XLibProxy_GetDeviceInfo(uint32_t index, XLibDeviceInfo* info);
 
+/**
+ * @brief Broadcast a discovery request on one adapter
+ *
+ * Each session owns its socket, so sessions on different adapters can
+ * run in parallel threads, unlike XLibProxy_DiscoverDevices.
+ *
+ * @param localIP Local IP address of the adapter
+ * @return Session handle (>= 0) on success, negative error code on failure
+ * @internal This function is for internal use only
+ */
+int32_t XLibProxy_OpenDiscovery(const char* localIP);
+
+/**
+ * @brief Receive the next discovery reply of a session
+ * @param session Session handle from XLibProxy_OpenDiscovery
+ * @param info Output device info
+ * @param timeout Timeout in milliseconds
+ * @return 1 if a device replied, XLIB_ERROR_TIMEOUT if none did,
+ *         other negative error code on failure
+ * @internal This function is for internal use only
+ */
+int32_t XLibProxy_ReceiveDiscovery(int32_t session, XLibDeviceInfo* info,
+                                   uint32_t timeout);
+
+/**
+ * @brief Close a discovery session
+ * @param session Session handle from XLibProxy_OpenDiscovery
+ * @internal This function is for internal use only
+ */
+void XLibProxy_CloseDiscovery(int32_t session);
+
 // ============================================================================
 // Configuration Functions
 // ============================================================================
@@ -454,23 +814,10 @@ const char* XLibProxy_GetErrorMessage(int32_t errorCode);
  * @brief Calculate CRC16 checksum
  * @param data Data buffer
  * @param length Data length
- * @return CRC16 checksum
+ * @return CRC16 checksum (reflected 0xA001, initial 0xFFFF)
  */
 inline uint16_t XLib_CalculateCRC16(const uint8_t* data, uint32_t length) {
-    uint16_t crc = 0xFFFF;
-    
-    for (uint32_t i = 0; i < length; ++i) {
-        crc ^= static_cast<uint16_t>(data[i]);
-        for (int j = 0; j < 8; ++j) {
-            if (crc & 0x0001) {
-                crc = (crc >> 1) ^ 0xA001;
-            } else {
-                crc >>= 1;
-            }
-        }
-    }
-    
-    return crc;
+    return Crc16(data, length);
 }
 
 /**
@@ -0,0 +1,522 @@
+// ============================================================================
+// hx_batch.cpp - Reapply calibration to archived captures
+// ============================================================================
+
+/**
+ * @file hx_batch.cpp
+ * @brief Batch reprocessing tool: read, correct and write a directory of TIFFs
+ * @version 2.1.0
+ *
+ * The three stages run on their own threads, connected by queues, so disk
+ * reads, correction and disk writes of different files overlap. At most
+ * --inflight frames are held in memory at once; readers wait for a writer
+ * to finish a frame before loading the next one.
+ *
+ *   hx_batch --og calib.bin  [options] <input dir> <output dir>
+ *   hx_batch --mog calib.bin [options] <input dir> <output dir>
+ *
+ * With --mog each frame holds the detectors side by side, in calibration
+ * order. Output files keep their names and metadata.
+ */
+
+#include "XFile.h"
+#include "xmog_correct.h"
+#include "xog_correct.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cctype>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dirent.h>
+#endif
+
+using namespace HX;
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+struct Options {
+    std::string ogFile;
+    std::string mogFile;
+    std::string inputDir;
+    std::string outputDir;
+    int readers;
+    int workers;
+    int writers;
+    int inflight;
+    bool compress;
+
+    Options() : readers(2), workers(1), writers(2), inflight(8), compress(false) {}
+};
+
+/// One file moving through the pipeline
+struct Job {
+    std::string name;
+    XFile* file;
+    uint16_t* pixels;
+    uint32_t width;
+    uint32_t height;
+
+    Job() : file(nullptr), pixels(nullptr), width(0), height(0) {}
+};
+
+/// Unbounded FIFO; the in-flight limit bounds what it can hold
+class JobQueue {
+public:
+    JobQueue() : m_closed(false) {}
+
+    void push(const Job& job) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_jobs.push_back(job);
+        }
+        m_ready.notify_one();
+    }
+
+    /// false once closed and drained
+    bool pop(Job& job) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_ready.wait(lock, [this] { return m_closed || !m_jobs.empty(); });
+        if (m_jobs.empty()) {
+            return false;
+        }
+        job = m_jobs.front();
+        m_jobs.pop_front();
+        return true;
+    }
+
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_closed = true;
+        }
+        m_ready.notify_all();
+    }
+
+private:
+    std::mutex m_mutex;
+    std::condition_variable m_ready;
+    std::deque<Job> m_jobs;
+    bool m_closed;
+};
+
+/// Counting semaphore limiting frames in memory
+class Slots {
+public:
+    explicit Slots(int count) : m_free(count) {}
+
+    void acquire() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_available.wait(lock, [this] { return m_free > 0; });
+        --m_free;
+    }
+
+    void release() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            ++m_free;
+        }
+        m_available.notify_one();
+    }
+
+private:
+    std::mutex m_mutex;
+    std::condition_variable m_available;
+    int m_free;
+};
+
+/// Per-stage counters; busy time is summed over the stage's threads
+struct StageStats {
+    std::atomic<uint64_t> frames;
+    std::atomic<uint64_t> bytes;
+    std::atomic<uint64_t> busyUs;
+    std::atomic<uint64_t> failures;
+
+    StageStats() : frames(0), bytes(0), busyUs(0), failures(0) {}
+
+    void add(uint64_t frameBytes, Clock::time_point start) {
+        const uint64_t us = static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count());
+        ++frames;
+        bytes += frameBytes;
+        busyUs += us;
+    }
+
+    void print(const char* name, int threads, double wallSeconds) const {
+        const double mb = static_cast<double>(bytes.load()) / (1024.0 * 1024.0);
+        const double busy = static_cast<double>(busyUs.load()) / 1e6;
+        const double perThread = busy > 0.0 ? mb / busy : 0.0;
+        const double occupancy = wallSeconds > 0.0 ? busy / (threads * wallSeconds) * 100.0 : 0.0;
+        std::printf("  %-8s %6llu frames %10.1f MB  %8.1f MB/s per thread  x%d  busy %5.1f%%",
+                    name, static_cast<unsigned long long>(frames.load()), mb, perThread,
+                    threads, occupancy);
+        if (failures.load()) {
+            std::printf("  %llu failed", static_cast<unsigned long long>(failures.load()));
+        }
+        std::printf("\n");
+    }
+};
+
+/**
+ * @brief Correction state of one worker thread
+ *
+ * Every worker loads its own handle, so workers never wait on each other's
+ * handle mutex; XMOG frames are split into per-detector buffers.
+ */
+class Corrector {
+public:
+    Corrector() : m_og(nullptr), m_mog(nullptr), m_width(0), m_height(0) {}
+
+    ~Corrector() {
+        hubx_xog_destroy(m_og);
+        hubx_xmog_destroy(m_mog);
+    }
+
+    bool load(const Options& options) {
+        if (!options.ogFile.empty()) {
+            m_og = hubx_xog_create();
+            int width = 0;
+            int height = 0;
+            if (!m_og || hubx_xog_load(m_og, options.ogFile.c_str()) != 0 ||
+                hubx_xog_get_size(m_og, &width, &height) != 0) {
+                std::cerr << "[hx_batch] Cannot load OG calibration: " << options.ogFile << std::endl;
+                return false;
+            }
+            m_width = static_cast<uint32_t>(width);
+            m_height = static_cast<uint32_t>(height);
+            return true;
+        }
+
+        m_mog = hubx_xmog_create();
+        const int count = m_mog ? (hubx_xmog_load(m_mog, options.mogFile.c_str()) == 0
+                                   ? hubx_xmog_detector_count(m_mog) : -1) : -1;
+        if (count <= 0) {
+            std::cerr << "[hx_batch] Cannot load MOG calibration: " << options.mogFile << std::endl;
+            return false;
+        }
+        for (int d = 0; d < count; ++d) {
+            int width = 0;
+            int height = 0;
+            hubx_xmog_get_detector_size(m_mog, d, &width, &height);
+            if (d > 0 && static_cast<uint32_t>(height) != m_height) {
+                std::cerr << "[hx_batch] MOG detectors differ in height" << std::endl;
+                return false;
+            }
+            m_widths.push_back(static_cast<uint32_t>(width));
+            m_width += static_cast<uint32_t>(width);
+            m_height = static_cast<uint32_t>(height);
+        }
+        m_buffers.resize(count);
+        return true;
+    }
+
+    bool apply(const Job& job) {
+        if (job.width != m_width || job.height != m_height) {
+            std::cerr << "[hx_batch] " << job.name << ": " << job.width << "x" << job.height
+                      << " does not match the calibration (" << m_width << "x" << m_height << ")"
+                      << std::endl;
+            return false;
+        }
+        if (m_og) {
+            return hubx_xog_apply(m_og, job.pixels, job.pixels) == 0;
+        }
+
+        // Detector d owns columns [x, x + widths[d]) of every row
+        std::vector<unsigned short*> frames(m_buffers.size());
+        uint32_t x = 0;
+        for (size_t d = 0; d < m_buffers.size(); ++d) {
+            const uint32_t w = m_widths[d];
+            m_buffers[d].resize(static_cast<size_t>(w) * m_height);
+            for (uint32_t row = 0; row < m_height; ++row) {
+                std::memcpy(&m_buffers[d][static_cast<size_t>(row) * w],
+                            job.pixels + static_cast<size_t>(row) * m_width + x, w * sizeof(uint16_t));
+            }
+            frames[d] = m_buffers[d].data();
+            x += w;
+        }
+        if (hubx_xmog_apply(m_mog, frames.data(), frames.data()) != 0) {
+            return false;
+        }
+        x = 0;
+        for (size_t d = 0; d < m_buffers.size(); ++d) {
+            const uint32_t w = m_widths[d];
+            for (uint32_t row = 0; row < m_height; ++row) {
+                std::memcpy(job.pixels + static_cast<size_t>(row) * m_width + x,
+                            &m_buffers[d][static_cast<size_t>(row) * w], w * sizeof(uint16_t));
+            }
+            x += w;
+        }
+        return true;
+    }
+
+private:
+    hubx_xog_t* m_og;
+    hubx_xmog_t* m_mog;
+    uint32_t m_width;
+    uint32_t m_height;
+    std::vector<uint32_t> m_widths;
+    std::vector<std::vector<unsigned short> > m_buffers;
+};
+
+bool hasTiffExtension(const std::string& name) {
+    const size_t dot = name.find_last_of('.');
+    if (dot == std::string::npos) {
+        return false;
+    }
+    std::string ext = name.substr(dot + 1);
+    for (size_t i = 0; i < ext.size(); ++i) {
+        ext[i] = static_cast<char>(std::tolower(static_cast<unsigned char>(ext[i])));
+    }
+    return ext == "tif" || ext == "tiff";
+}
+
+/// TIFF file names in a directory, sorted
+bool listTiffs(const std::string& dir, std::vector<std::string>& names) {
+#ifdef _WIN32
+    WIN32_FIND_DATAA data;
+    HANDLE find = FindFirstFileA((dir + "\\*").c_str(), &data);
+    if (find == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    do {
+        if (!(data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) && hasTiffExtension(data.cFileName)) {
+            names.push_back(data.cFileName);
+        }
+    } while (FindNextFileA(find, &data));
+    FindClose(find);
+#else
+    DIR* d = opendir(dir.c_str());
+    if (!d) {
+        return false;
+    }
+    while (struct dirent* entry = readdir(d)) {
+        if (entry->d_name[0] != '.' && hasTiffExtension(entry->d_name)) {
+            names.push_back(entry->d_name);
+        }
+    }
+    closedir(d);
+#endif
+    std::sort(names.begin(), names.end());
+    return true;
+}
+
+std::string joinPath(const std::string& dir, const std::string& name) {
+    if (dir.empty() || dir[dir.size() - 1] == '/' || dir[dir.size() - 1] == '\\') {
+        return dir + name;
+    }
+    return dir + "/" + name;
+}
+
+void usage() {
+    std::cerr <<
+        "Usage: hx_batch (--og <calib> | --mog <calib>) [options] <input dir> <output dir>\n"
+        "  --readers N    Reader threads (default 2)\n"
+        "  --workers N    Correction threads (default 1; each frame is already\n"
+        "                 corrected in parallel on the SDK thread pool)\n"
+        "  --writers N    Writer threads (default 2)\n"
+        "  --inflight N   Frames held in memory at once (default 8)\n"
+        "  --compress     Write delta-compressed TIFFs\n";
+}
+
+bool parseCount(const char* text, int& value) {
+    char* end = nullptr;
+    const long v = std::strtol(text, &end, 10);
+    if (!end || *end != '\0' || v < 1 || v > 1024) {
+        return false;
+    }
+    value = static_cast<int>(v);
+    return true;
+}
+
+bool parseOptions(int argc, char** argv, Options& options) {
+    std::vector<std::string> positional;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "--og" && hasValue) {
+            options.ogFile = argv[++i];
+        } else if (arg == "--mog" && hasValue) {
+            options.mogFile = argv[++i];
+        } else if (arg == "--readers" && hasValue) {
+            if (!parseCount(argv[++i], options.readers)) return false;
+        } else if (arg == "--workers" && hasValue) {
+            if (!parseCount(argv[++i], options.workers)) return false;
+        } else if (arg == "--writers" && hasValue) {
+            if (!parseCount(argv[++i], options.writers)) return false;
+        } else if (arg == "--inflight" && hasValue) {
+            if (!parseCount(argv[++i], options.inflight)) return false;
+        } else if (arg == "--compress") {
+            options.compress = true;
+        } else if (!arg.empty() && arg[0] == '-') {
+            return false;
+        } else {
+            positional.push_back(arg);
+        }
+    }
+    if (positional.size() != 2 || options.ogFile.empty() == options.mogFile.empty()) {
+        return false;
+    }
+    options.inputDir = positional[0];
+    options.outputDir = positional[1];
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        usage();
+        return 2;
+    }
+    if (options.inputDir == options.outputDir) {
+        std::cerr << "[hx_batch] Output directory must differ from the input directory" << std::endl;
+        return 2;
+    }
+
+    std::vector<std::string> names;
+    if (!listTiffs(options.inputDir, names)) {
+        std::cerr << "[hx_batch] Cannot read directory: " << options.inputDir << std::endl;
+        return 1;
+    }
+    if (names.empty()) {
+        std::cerr << "[hx_batch] No TIFF files in " << options.inputDir << std::endl;
+        return 0;
+    }
+
+    // Load every worker's calibration before any file is touched
+    std::vector<Corrector*> correctors;
+    bool loaded = true;
+    for (int i = 0; i < options.workers && loaded; ++i) {
+        correctors.push_back(new Corrector());
+        loaded = correctors.back()->load(options);
+    }
+    if (!loaded) {
+        for (size_t i = 0; i < correctors.size(); ++i) {
+            delete correctors[i];
+        }
+        return 1;
+    }
+
+    std::printf("[hx_batch] %zu files, %d readers, %d workers, %d writers, %d frames in flight\n",
+                names.size(), options.readers, options.workers, options.writers, options.inflight);
+
+    Slots slots(options.inflight);
+    JobQueue toCorrect;
+    JobQueue toWrite;
+    StageStats readStats;
+    StageStats correctStats;
+    StageStats writeStats;
+    std::atomic<size_t> nextFile(0);
+    std::atomic<int> readersLeft(options.readers);
+    std::atomic<int> workersLeft(options.workers);
+
+    const Clock::time_point start = Clock::now();
+    std::vector<std::thread> threads;
+
+    for (int r = 0; r < options.readers; ++r) {
+        threads.push_back(std::thread([&]() {
+            for (size_t i = nextFile++; i < names.size(); i = nextFile++) {
+                slots.acquire();
+                const Clock::time_point t0 = Clock::now();
+                Job job;
+                job.name = names[i];
+                job.file = new XFile();
+                uint32_t depth = 0;
+                uint8_t* data = nullptr;
+                if (!job.file->Read(joinPath(options.inputDir, job.name)) ||
+                    !job.file->Get(XFile::XF_COLS, job.width) ||
+                    !job.file->Get(XFile::XF_ROWS, job.height) ||
+                    !job.file->Get(XFile::XF_DEPTH, depth) ||
+                    !job.file->Get(XFile::XF_DATA, &data) || !data ||
+                    depth <= 8 || depth > 16) {
+                    std::cerr << "[hx_batch] Skipping " << job.name << ": not a 16-bit capture" << std::endl;
+                    ++readStats.failures;
+                    delete job.file;
+                    slots.release();
+                    continue;
+                }
+                job.pixels = reinterpret_cast<uint16_t*>(data);
+                readStats.add(static_cast<uint64_t>(job.width) * job.height * 2, t0);
+                toCorrect.push(job);
+            }
+            if (--readersLeft == 0) {
+                toCorrect.close();
+            }
+        }));
+    }
+
+    for (int w = 0; w < options.workers; ++w) {
+        Corrector* corrector = correctors[w];
+        threads.push_back(std::thread([&, corrector]() {
+            Job job;
+            while (toCorrect.pop(job)) {
+                const Clock::time_point t0 = Clock::now();
+                if (!corrector->apply(job)) {
+                    ++correctStats.failures;
+                    delete job.file;
+                    slots.release();
+                    continue;
+                }
+                correctStats.add(static_cast<uint64_t>(job.width) * job.height * 2, t0);
+                toWrite.push(job);
+            }
+            if (--workersLeft == 0) {
+                toWrite.close();
+            }
+        }));
+    }
+
+    for (int w = 0; w < options.writers; ++w) {
+        threads.push_back(std::thread([&]() {
+            Job job;
+            while (toWrite.pop(job)) {
+                const Clock::time_point t0 = Clock::now();
+                if (options.compress) {
+                    job.file->SetCompression(XFile::XF_COMPRESS_DELTA);
+                }
+                if (job.file->Write(joinPath(options.outputDir, job.name))) {
+                    writeStats.add(static_cast<uint64_t>(job.width) * job.height * 2, t0);
+                } else {
+                    ++writeStats.failures;
+                }
+                delete job.file;
+                slots.release();
+            }
+        }));
+    }
+
+    for (size_t i = 0; i < threads.size(); ++i) {
+        threads[i].join();
+    }
+    for (size_t i = 0; i < correctors.size(); ++i) {
+        delete correctors[i];
+    }
+
+    const double wall = std::chrono::duration<double>(Clock::now() - start).count();
+    const double mb = static_cast<double>(writeStats.bytes.load()) / (1024.0 * 1024.0);
+    std::printf("[hx_batch] %llu of %zu files in %.2f s, %.1f MB/s end to end\n",
+                static_cast<unsigned long long>(writeStats.frames.load()), names.size(), wall,
+                wall > 0.0 ? mb / wall : 0.0);
+    readStats.print("read", options.readers, wall);
+    correctStats.print("correct", options.workers, wall);
+    writeStats.print("write", options.writers, wall);
+
+    const uint64_t failed = readStats.failures + correctStats.failures + writeStats.failures;
+    return failed ? 1 : 0;
+}
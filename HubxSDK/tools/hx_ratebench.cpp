@@ -0,0 +1,711 @@
+// ============================================================================
+// hx_ratebench.cpp - Highest loss-free line rate of the acquisition chain
+// ============================================================================
+
+/**
+ * @file hx_ratebench.cpp
+ * @brief Find the line rate each configuration sustains without loss
+ * @version 2.1.0
+ *
+ * Runs xlib_sim -> XGrabber -> XFrame -> sink, with an optional
+ * XOGCorrect pass in the sink, for every combination of --widths,
+ * --depths, --header and --correct. Each configuration doubles the line
+ * rate from --start until a trial loses data, then bisects between the
+ * last clean and the first lossy rate. A trial is clean when the
+ * simulator's socket buffer never overflowed, the grabber lost no packet
+ * and had no ring overflow, XFrame dropped no frame and no error was
+ * reported.
+ *
+ * For CI, compare against a previous --csv output:
+ *
+ *   hx_ratebench --csv rates.csv
+ *   hx_ratebench --baseline rates.csv --tolerance 0.15
+ *
+ * The exit status is 1 when a configuration falls below --min-rate or
+ * more than --tolerance below its baseline.
+ *
+ * --tune writes a host profile (XFactory::LoadHostProfile()) for the first
+ * configuration, the first with correction if there is one. Correction
+ * then runs on an XFrame::AddSink() sink, and the ring depth, batch size,
+ * pool size, correction threads, band size and CPU features are tried one
+ * at a time, keeping each value that raises the loss-free rate by more
+ * than --precision:
+ *
+ *   hx_ratebench --widths 4096 --header on --correct on --tune hubx_profile.conf
+ */
+
+#include "XControl.h"
+#include "XDetector.h"
+#include "XFrame.h"
+#include "XGrabber.h"
+#include "XImage.h"
+#include "iximg_sink.h"
+#include "xfactory.h"
+#include "xlib_sim.h"
+#include "xog_correct.h"
+#include "utils/calib_file.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace HX;
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+struct Options {
+    std::vector<uint32_t> widths;
+    std::vector<uint32_t> depths;
+    std::vector<bool> headers;
+    std::vector<bool> corrections;
+    uint32_t lines;
+    uint32_t queues;
+    uint32_t batch;
+    double seconds;
+    double startRate;
+    double maxRate;
+    double precision;
+    double minRate;
+    double tolerance;
+    std::string csvFile;
+    std::string baselineFile;
+    std::string tuneFile;
+    bool verbose;
+    bool tuning;                    ///< Trials run with the tune settings
+    XFactory::HostProfile tune;
+
+    Options()
+        : lines(512), queues(1), batch(1), seconds(2.0), startRate(5000.0), maxRate(1e6),
+          precision(0.05), minRate(0.0), tolerance(0.1), verbose(false), tuning(false) {}
+};
+
+/// One point of the sweep
+struct Configuration {
+    uint32_t width;
+    uint32_t depth;
+    bool header;
+    bool correct;
+
+    std::string key() const {
+        std::ostringstream out;
+        out << width << ',' << depth << ',' << (header ? 1 : 0) << ',' << (correct ? 1 : 0);
+        return out.str();
+    }
+};
+
+struct Trial {
+    double rate;            ///< Requested lines per second
+    double achieved;        ///< Rows per second that reached XFrame
+    bool clean;
+    std::string reason;     ///< First kind of loss, empty if clean
+};
+
+/// Counts frames and optionally corrects each one
+class BenchSink : public IXImgSink {
+public:
+    BenchSink() : frames(0), errors(0), correctErrors(0), m_xog(nullptr), m_release(nullptr) {}
+
+    ~BenchSink() {
+        if (m_xog) {
+            hubx_xog_destroy(m_xog);
+        }
+    }
+
+    bool setCorrection(const std::string& calibration, uint32_t pixels) {
+        m_xog = hubx_xog_create();
+        if (!m_xog || hubx_xog_load(m_xog, calibration.c_str()) != 0) {
+            return false;
+        }
+        m_output.resize(pixels);
+        return true;
+    }
+
+    /// Return every frame to the pool of frame
+    void setRelease(XFrame* frame) {
+        m_release = frame;
+    }
+
+    void OnXError(uint32_t err_id, const char* err_msg_) override {
+        ++errors;
+        if (errors == 1) {
+            std::cerr << "[hx_ratebench] Error " << err_id << ": " << err_msg_ << std::endl;
+        }
+    }
+
+    void OnXEvent(uint32_t event_id, uint32_t data) override {
+        (void)event_id;
+        (void)data;
+    }
+
+    void OnFrameReady(XImage* image_) override {
+        if (m_xog && image_->_data_) {
+            const unsigned short* pixels =
+                reinterpret_cast<const unsigned short*>(image_->_data_ + image_->_data_offset);
+            if (hubx_xog_apply(m_xog, pixels, m_output.data()) != 0) {
+                ++correctErrors;
+            }
+        }
+        ++frames;
+        if (m_release) {
+            m_release->Release(image_);
+        }
+    }
+
+    std::atomic<uint64_t> frames;
+    std::atomic<uint64_t> errors;
+    std::atomic<uint64_t> correctErrors;
+
+private:
+    hubx_xog_t* m_xog;
+    std::vector<unsigned short> m_output;
+    XFrame* m_release;
+};
+
+/// Offset and gain of one frame, written where hubx_xog_load() reads it
+bool writeCalibration(const std::string& file, uint32_t width, uint32_t lines, uint32_t depth) {
+    const size_t pixels = static_cast<size_t>(width) * lines;
+    std::vector<unsigned short> offset(pixels);
+    std::vector<float> gain(pixels);
+    std::vector<unsigned short> baseline(pixels, 0);
+    for (size_t i = 0; i < pixels; ++i) {
+        offset[i] = static_cast<unsigned short>(900 + (i * 13) % 200);
+        gain[i] = 0.9f + static_cast<float>((i * 7) % 200) / 1000.0f;
+    }
+    const int32_t meta[3] = { static_cast<int32_t>(width), static_cast<int32_t>(lines),
+                              static_cast<int32_t>(depth) };
+
+    using Internal::CalibTag;
+    Internal::CalibFileWriter writer(CalibTag('X', 'O', 'G', ' '));
+    writer.AddSection(CalibTag('M', 'E', 'T', 'A'), meta, sizeof(meta), sizeof(int32_t));
+    writer.AddSection(CalibTag('O', 'F', 'F', 'S'), offset.data(),
+                      pixels * sizeof(unsigned short), sizeof(unsigned short));
+    writer.AddSection(CalibTag('G', 'A', 'I', 'N'), gain.data(), pixels * sizeof(float), sizeof(float));
+    writer.AddSection(CalibTag('B', 'A', 'S', 'E'), baseline.data(),
+                      pixels * sizeof(unsigned short), sizeof(unsigned short));
+    return writer.Write(file.c_str());
+}
+
+double frameMetric(const char* name) {
+    double value = 0.0;
+    XFactory::GetMetric(name, value);
+    return value;
+}
+
+/// Acquire for options.seconds at one rate
+bool runTrial(const Options& options, const Configuration& config, const std::string& calibration,
+              double rate, Trial& trial) {
+    Sim::Config sim;
+    sim.width = config.width;
+    sim.pixelDepth = static_cast<uint8_t>(config.depth);
+    sim.header = config.header;
+    sim.lineRate = rate;
+    Sim::configure(sim);
+
+    XDetector detector;
+    detector.SetIP(sim.ip);
+    detector.SetCmdPort(sim.cmdPort);
+    detector.SetImgPort(sim.imgPort);
+    detector.SetMAC(sim.mac);
+    detector.SetSerialNum(sim.serial);
+    detector.SetPixelCount(sim.width);
+    detector.SetModuleCount(1);
+    detector.SetPixelDepth(sim.pixelDepth);
+
+    XControl control;
+    if (!control.Open(detector)) {
+        std::cerr << "[hx_ratebench] Cannot open the command channel" << std::endl;
+        return false;
+    }
+
+    BenchSink sink;
+    if (config.correct && !sink.setCorrection(calibration, config.width * options.lines)) {
+        std::cerr << "[hx_ratebench] Cannot load " << calibration << std::endl;
+        return false;
+    }
+    BenchSink releaser;     // SetSink() sink while tuning, sink then runs on its own thread
+    XFrame frame;
+    frame.SetLines(options.lines);
+    if (options.tuning) {
+        frame.SetPoolSize(options.tune.poolSize);
+        releaser.setRelease(&frame);
+        frame.SetSink(&releaser);
+        frame.AddSink(&sink, options.tune.poolSize);
+    } else {
+        frame.SetSink(&sink);
+    }
+
+    XGrabber grabber;
+    grabber.SetSink(&sink);
+    grabber.SetFrame(frame);
+    grabber.SetHeader(config.header);
+    grabber.SetBatchSize(options.tuning ? options.tune.batchSize : options.batch);
+    if (options.tuning) {
+        grabber.SetRingDepth(options.tune.ringDepth);
+    }
+    grabber.SetReceiveQueues(options.queues);
+
+    Sim::resetStatistics();
+    grabber.ResetStatistics();
+    XGrabber::NetworkConfig network;
+    network.recvBufferSize = sim.bufferSize;
+    if (!grabber.Open(detector, control, network)) {
+        std::cerr << "[hx_ratebench] Cannot open the image channel" << std::endl;
+        return false;
+    }
+
+    const Clock::time_point start = Clock::now();
+    if (!grabber.Grab(0)) {
+        std::cerr << "[hx_ratebench] Grab failed" << std::endl;
+        return false;
+    }
+    std::this_thread::sleep_for(std::chrono::duration<double>(options.seconds));
+
+    // XFrame publishes its counters only while started
+    const double framesDropped = frameMetric("hubx_frame_frames_dropped_total") +
+                                 frameMetric("hubx_frame_frames_sink_dropped_total");
+    grabber.Stop();
+    const double wall = std::chrono::duration<double>(Clock::now() - start).count();
+
+    XGrabber::Statistics stats;
+    grabber.GetStatistics(stats);
+    Sim::Stats simStats;
+    Sim::statistics(simStats);
+    grabber.Close();
+    control.Close();
+
+    trial.rate = rate;
+    trial.achieved = static_cast<double>(stats.linesReceived) / wall;
+    trial.reason.clear();
+    if (simStats.packetsOverflowed > 0) {
+        trial.reason = "socket overflow";
+    } else if (stats.packetsLost > 0) {
+        trial.reason = "packets lost";
+    } else if (stats.ringOverflows > 0) {
+        trial.reason = "ring overflow";
+    } else if (framesDropped > 0) {
+        trial.reason = "frames dropped";
+    } else if (sink.errors.load() > 0 || sink.correctErrors.load() > 0 || releaser.errors.load() > 0) {
+        trial.reason = "errors reported";
+    } else if (static_cast<double>(simStats.lines) < 0.98 * rate * wall) {
+        // The generator itself fell behind: nothing was lost, but the rate
+        // was not offered either
+        trial.reason = "simulator bound";
+    }
+    trial.clean = trial.reason.empty();
+    return true;
+}
+
+/// Highest clean rate, or 0 if --start already loses data; capped if --max was clean
+bool findMaxRate(const Options& options, const Configuration& config, const std::string& calibration,
+                 double& best, uint32_t& trials, bool& capped) {
+    best = 0.0;
+    trials = 0;
+    capped = false;
+    double lossy = 0.0;
+    Trial trial;
+
+    for (double rate = options.startRate; rate <= options.maxRate; rate *= 2.0) {
+        if (!runTrial(options, config, calibration, rate, trial)) return false;
+        ++trials;
+        if (options.verbose) {
+            std::printf("    %10.0f lines/s  %s\n", rate, trial.clean ? "clean" : trial.reason.c_str());
+        }
+        if (!trial.clean) {
+            lossy = rate;
+            break;
+        }
+        best = rate;
+    }
+    if (best == 0.0 || lossy == 0.0) {
+        capped = best > 0.0;
+        return true;
+    }
+
+    while (lossy / best > 1.0 + options.precision) {
+        const double rate = std::sqrt(best * lossy);
+        if (!runTrial(options, config, calibration, rate, trial)) return false;
+        ++trials;
+        if (options.verbose) {
+            std::printf("    %10.0f lines/s  %s\n", rate, trial.clean ? "clean" : trial.reason.c_str());
+        }
+        if (trial.clean) {
+            best = rate;
+        } else {
+            lossy = rate;
+        }
+    }
+    return true;
+}
+
+/// One setting --tune varies
+struct Knob {
+    const char* name;
+    uint32_t XFactory::HostProfile::* field;
+    std::vector<uint32_t> values;
+};
+
+/// Apply the process-wide part of a profile; the rest goes to each trial
+void applyProfile(const XFactory::HostProfile& profile) {
+    XFactory::SchedulerConfig scheduler = XFactory::GetScheduler();
+    scheduler.bandPixels = profile.bandPixels;
+    XFactory::SetScheduler(scheduler);
+    XFactory::SetCorrectionThreads(profile.correctionThreads);
+    XFactory::SetCpuFeatureMask(profile.cpuFeatureMask);
+}
+
+/// Coordinate descent over the profile settings, best profile to options.tuneFile
+int tune(Options options, const Configuration& config, const std::string& calibration) {
+    const uint32_t hardware = std::max(1u, std::thread::hardware_concurrency());
+    XFactory::HostProfile& profile = options.tune;
+    profile = XFactory::HostProfile();
+    profile.ringDepth = 4096;
+    profile.batchSize = 32;
+    profile.poolSize = 4;
+    profile.correctionThreads = config.correct ? hardware : 0;
+    options.tuning = true;
+
+    std::vector<Knob> knobs;
+    Knob ring = { "ring_depth", &XFactory::HostProfile::ringDepth, { 1024, 4096, 16384 } };
+    Knob batch = { "batch_size", &XFactory::HostProfile::batchSize, { 1, 8, 32, 128 } };
+    Knob pool = { "pool_size", &XFactory::HostProfile::poolSize, { 2, 4, 8 } };
+    Knob threads = { "correction_threads", &XFactory::HostProfile::correctionThreads, {} };
+    for (uint32_t n = 1; n < hardware; n *= 2) {
+        threads.values.push_back(n);
+    }
+    threads.values.push_back(hardware);
+    Knob band = { "band_pixels", &XFactory::HostProfile::bandPixels, { 0, 256 * 1024, 64 * 1024 } };
+    Knob cpu = { "cpu_features", &XFactory::HostProfile::cpuFeatureMask,
+                 { XFactory::CPU_ALL, XFactory::CPU_ALL & ~static_cast<uint32_t>(XFactory::CPU_AVX512),
+                   XFactory::CPU_SSE42, 0 } };
+    knobs.push_back(ring);
+    knobs.push_back(batch);
+    knobs.push_back(pool);
+    if (config.correct) {
+        // Only correction runs on the shared pool
+        knobs.push_back(threads);
+        knobs.push_back(band);
+    }
+    knobs.push_back(cpu);
+
+    std::printf("hx_ratebench: tuning %u px, %u bits, header %s, correction %s, %.1f s per trial\n",
+                config.width, config.depth, config.header ? "on" : "off",
+                config.correct ? "on" : "off", options.seconds);
+
+    double best = 0.0;
+    uint32_t trials = 0;
+    bool capped = false;
+    applyProfile(profile);
+    if (!findMaxRate(options, config, calibration, best, trials, capped)) {
+        return 1;
+    }
+    std::printf("  %-20s %10s %12.0f\n", "defaults", "", best);
+
+    for (size_t k = 0; k < knobs.size(); ++k) {
+        const Knob& knob = knobs[k];
+        const uint32_t kept = profile.*knob.field;
+        uint32_t chosen = kept;
+        for (size_t v = 0; v < knob.values.size(); ++v) {
+            if (knob.values[v] == kept) {
+                continue;
+            }
+            profile.*knob.field = knob.values[v];
+            applyProfile(profile);
+            double rate = 0.0;
+            if (!findMaxRate(options, config, calibration, rate, trials, capped)) {
+                return 1;
+            }
+            XFactory::FlushLog();
+            std::printf("  %-20s %10u %12.0f%s\n", knob.name, knob.values[v], rate,
+                        rate > best * (1.0 + options.precision) ? "  better" : "");
+            std::fflush(stdout);
+            if (rate > best * (1.0 + options.precision)) {
+                best = rate;
+                chosen = knob.values[v];
+            }
+        }
+        profile.*knob.field = chosen;
+    }
+    applyProfile(profile);
+
+    profile.lineRate = best;
+    if (!XFactory::SaveHostProfile(options.tuneFile, profile)) {
+        std::cerr << "[hx_ratebench] Cannot write " << options.tuneFile << std::endl;
+        return 1;
+    }
+    std::printf("  %s: ring %u, batch %u, pool %u, threads %u, band %u px, cpu 0x%x, %.0f lines/s\n",
+                options.tuneFile.c_str(), profile.ringDepth, profile.batchSize, profile.poolSize,
+                profile.correctionThreads, profile.bandPixels, profile.cpuFeatureMask, best);
+    return 0;
+}
+
+/// Baseline rates by configuration key
+bool readBaseline(const std::string& file, std::map<std::string, double>& rates) {
+    std::ifstream in(file.c_str());
+    if (!in) {
+        return false;
+    }
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#' || line.compare(0, 5, "width") == 0) {
+            continue;
+        }
+        // width,depth,header,correct,max_rate,...
+        size_t pos = 0;
+        for (int field = 0; field < 4 && pos != std::string::npos; ++field) {
+            pos = line.find(',', pos + (field ? 1 : 0));
+        }
+        if (pos == std::string::npos) {
+            continue;
+        }
+        rates[line.substr(0, pos)] = std::atof(line.c_str() + pos + 1);
+    }
+    return true;
+}
+
+void usage() {
+    std::cerr <<
+        "Usage: hx_ratebench [options]\n"
+        "  --widths L      Pixels per line, comma separated (default 2048)\n"
+        "  --depths L      Bits per pixel, comma separated (default 16)\n"
+        "  --header M      on, off or both (default both)\n"
+        "  --correct M     on, off or both: XOGCorrect every frame in the sink (default both)\n"
+        "  --lines N       Lines per frame (default 512)\n"
+        "  --queues N      Receive queues, header mode only (default 1)\n"
+        "  --batch N       Packets per receive call (default 1)\n"
+        "  --seconds S     Acquisition time per trial (default 2)\n"
+        "  --start R       First line rate (default 5000)\n"
+        "  --max R         Highest line rate tried (default 1000000)\n"
+        "  --precision P   Stop bisecting within this ratio (default 0.05)\n"
+        "  --csv F         Write the results to F\n"
+        "  --baseline F    Fail if a rate drops more than --tolerance below F\n"
+        "  --tolerance T   Allowed drop against --baseline (default 0.1)\n"
+        "  --min-rate R    Fail if a configuration sustains less than R\n"
+        "  --tune F        Tune a host profile for the first configuration, write it to F\n"
+        "  --verbose       Print every trial and the SDK log\n";
+}
+
+bool parseCount(const char* text, uint32_t minValue, uint32_t maxValue, uint32_t& value) {
+    char* end = nullptr;
+    const long v = std::strtol(text, &end, 10);
+    if (!end || *end != '\0' || v < static_cast<long>(minValue) || v > static_cast<long>(maxValue)) {
+        return false;
+    }
+    value = static_cast<uint32_t>(v);
+    return true;
+}
+
+bool parseRatio(const char* text, double maxValue, double& value) {
+    char* end = nullptr;
+    const double v = std::strtod(text, &end);
+    if (!end || *end != '\0' || v < 0.0 || v > maxValue) {
+        return false;
+    }
+    value = v;
+    return true;
+}
+
+bool parseList(const char* text, uint32_t minValue, uint32_t maxValue, std::vector<uint32_t>& values) {
+    values.clear();
+    std::stringstream in(text);
+    std::string item;
+    while (std::getline(in, item, ',')) {
+        uint32_t v = 0;
+        if (!parseCount(item.c_str(), minValue, maxValue, v)) return false;
+        values.push_back(v);
+    }
+    return !values.empty();
+}
+
+bool parseMode(const std::string& text, std::vector<bool>& modes) {
+    modes.clear();
+    if (text == "off" || text == "both") modes.push_back(false);
+    if (text == "on" || text == "both") modes.push_back(true);
+    return !modes.empty();
+}
+
+bool parseOptions(int argc, char** argv, Options& options) {
+    options.widths.assign(1, 2048);
+    options.depths.assign(1, 16);
+    parseMode("both", options.headers);
+    parseMode("both", options.corrections);
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "--widths" && hasValue) {
+            if (!parseList(argv[++i], 1, 65536, options.widths)) return false;
+        } else if (arg == "--depths" && hasValue) {
+            if (!parseList(argv[++i], 8, 32, options.depths)) return false;
+        } else if (arg == "--header" && hasValue) {
+            if (!parseMode(argv[++i], options.headers)) return false;
+        } else if (arg == "--correct" && hasValue) {
+            if (!parseMode(argv[++i], options.corrections)) return false;
+        } else if (arg == "--lines" && hasValue) {
+            if (!parseCount(argv[++i], 1, 65536, options.lines)) return false;
+        } else if (arg == "--queues" && hasValue) {
+            if (!parseCount(argv[++i], 1, 16, options.queues)) return false;
+        } else if (arg == "--batch" && hasValue) {
+            if (!parseCount(argv[++i], 1, 1024, options.batch)) return false;
+        } else if (arg == "--seconds" && hasValue) {
+            if (!parseRatio(argv[++i], 3600.0, options.seconds) || options.seconds <= 0.0) return false;
+        } else if (arg == "--start" && hasValue) {
+            if (!parseRatio(argv[++i], 1e7, options.startRate) || options.startRate <= 0.0) return false;
+        } else if (arg == "--max" && hasValue) {
+            if (!parseRatio(argv[++i], 1e7, options.maxRate) || options.maxRate <= 0.0) return false;
+        } else if (arg == "--precision" && hasValue) {
+            if (!parseRatio(argv[++i], 1.0, options.precision) || options.precision <= 0.0) return false;
+        } else if (arg == "--csv" && hasValue) {
+            options.csvFile = argv[++i];
+        } else if (arg == "--baseline" && hasValue) {
+            options.baselineFile = argv[++i];
+        } else if (arg == "--tolerance" && hasValue) {
+            if (!parseRatio(argv[++i], 1.0, options.tolerance)) return false;
+        } else if (arg == "--min-rate" && hasValue) {
+            if (!parseRatio(argv[++i], 1e7, options.minRate)) return false;
+        } else if (arg == "--tune" && hasValue) {
+            options.tuneFile = argv[++i];
+        } else if (arg == "--verbose") {
+            options.verbose = true;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        usage();
+        return 2;
+    }
+    if (!options.verbose) {
+        XFactory::SetLogLevel(XFactory::LOG_WARNING);
+    }
+
+    std::map<std::string, double> baseline;
+    if (!options.baselineFile.empty() && !readBaseline(options.baselineFile, baseline)) {
+        std::cerr << "[hx_ratebench] Cannot read " << options.baselineFile << std::endl;
+        return 2;
+    }
+
+    std::vector<Configuration> configs;
+    for (size_t w = 0; w < options.widths.size(); ++w) {
+        for (size_t d = 0; d < options.depths.size(); ++d) {
+            for (size_t h = 0; h < options.headers.size(); ++h) {
+                for (size_t c = 0; c < options.corrections.size(); ++c) {
+                    Configuration config;
+                    config.width = options.widths[w];
+                    config.depth = options.depths[d];
+                    config.header = options.headers[h];
+                    config.correct = options.corrections[c];
+                    if (!config.header && options.queues > 1) {
+                        continue;   // Multi-queue receive needs headers
+                    }
+                    if (config.correct && (config.depth + 7) / 8 != 2) {
+                        continue;   // XOGCorrect takes 16-bit containers
+                    }
+                    configs.push_back(config);
+                }
+            }
+        }
+    }
+    if (configs.empty()) {
+        std::cerr << "[hx_ratebench] No valid configuration" << std::endl;
+        return 2;
+    }
+
+    std::ofstream csv;
+    if (!options.csvFile.empty()) {
+        csv.open(options.csvFile.c_str());
+        if (!csv) {
+            std::cerr << "[hx_ratebench] Cannot write " << options.csvFile << std::endl;
+            return 2;
+        }
+        csv << "width,depth,header,correct,max_rate,mb_per_s,trials\n";
+    }
+
+    const std::string calibration = "hx_ratebench_xog.cal";
+    if (!options.tuneFile.empty()) {
+        Configuration config = configs[0];
+        for (size_t i = 0; i < configs.size(); ++i) {
+            if (configs[i].correct) {
+                config = configs[i];
+                break;
+            }
+        }
+        if (config.correct && !writeCalibration(calibration, config.width, options.lines, config.depth)) {
+            std::cerr << "[hx_ratebench] Cannot write " << calibration << std::endl;
+            return 1;
+        }
+        const int result = tune(options, config, calibration);
+        std::remove(calibration.c_str());
+        return result;
+    }
+
+    std::printf("hx_ratebench: %u lines/frame, %u queue(s), batch %u, %.1f s per trial\n",
+                options.lines, options.queues, options.batch, options.seconds);
+    std::printf("  %6s %5s %6s %7s %12s %10s %6s\n",
+                "width", "depth", "header", "correct", "lines/s", "MB/s", "trials");
+
+    int status = 0;
+    for (size_t i = 0; i < configs.size(); ++i) {
+        const Configuration& config = configs[i];
+        if (config.correct && !writeCalibration(calibration, config.width, options.lines, config.depth)) {
+            std::cerr << "[hx_ratebench] Cannot write " << calibration << std::endl;
+            return 1;
+        }
+        if (options.verbose) {
+            std::printf("  %u px, %u bits, header %s, correction %s\n", config.width, config.depth,
+                        config.header ? "on" : "off", config.correct ? "on" : "off");
+        }
+
+        double best = 0.0;
+        uint32_t trials = 0;
+        bool capped = false;
+        if (!findMaxRate(options, config, calibration, best, trials, capped)) {
+            return 1;
+        }
+        XFactory::FlushLog();
+
+        const double mbs = best * config.width * ((config.depth + 7) / 8) / (1024.0 * 1024.0);
+        std::string verdict;
+        if (capped) {
+            verdict = " (no loss up to --max)";
+        }
+        if (best < options.minRate) {
+            verdict = " FAIL: below --min-rate";
+            status = 1;
+        }
+        std::map<std::string, double>::const_iterator it = baseline.find(config.key());
+        if (it != baseline.end() && best < it->second * (1.0 - options.tolerance)) {
+            std::ostringstream out;
+            out << " FAIL: baseline " << static_cast<uint64_t>(it->second);
+            verdict = out.str();
+            status = 1;
+        }
+        std::printf("  %6u %5u %6s %7s %12.0f %10.1f %6u%s\n",
+                    config.width, config.depth, config.header ? "on" : "off",
+                    config.correct ? "on" : "off", best, mbs, trials, verdict.c_str());
+        std::fflush(stdout);
+        if (csv.is_open()) {
+            csv << config.key() << ',' << static_cast<uint64_t>(best) << ','
+                << mbs << ',' << trials << '\n';
+        }
+    }
+    std::remove(calibration.c_str());
+    return status;
+}
@@ -0,0 +1,522 @@
+// ============================================================================
+// hx_simbench.cpp - Acquisition throughput against the detector simulator
+// ============================================================================
+
+/**
+ * @file hx_simbench.cpp
+ * @brief Run XControl and XGrabber against xlib_sim and report throughput
+ * @version 2.1.0
+ *
+ * Links hubx_sim, so no detector or network is involved: the simulator
+ * streams lines at --rate and the grabber assembles them into frames for
+ * --seconds. The report compares what the simulator sent with what reached
+ * XFrame, which shows receive-path regressions and how the loss/reorder
+ * accounting reacts to injected faults.
+ *
+ *   hx_simbench --width 4096 --rate 20000 --seconds 5
+ *   hx_simbench --modules 4 --queues 4 --loss 0.001 --reorder 0.01
+ *   hx_simbench --checksum --corrupt 0.001
+ *   hx_simbench --pattern --flip 0.001 --modules 4
+ *   hx_simbench --frames 10 --lines 256 --prepare
+ *   hx_simbench --burst 200 --rate 40000
+ *   hx_simbench --burst 2000 --burst-pack 256 --rate 40000
+ *   hx_simbench --trigger 2000 --lines 512
+ *   hx_simbench --sinks 3 --sink-delay 50
+ *   hx_simbench --width 512 --lines-per-packet 8 --rate 100000
+ *   hx_simbench --width 8192 --fragment 4096
+ *   hx_simbench --trace --trace-out simbench.json
+ *   hx_simbench --memory
+ *   hx_simbench --perf          (hubx_sim built with HUBX_WITH_PERF_COUNTERS)
+ */
+
+#include "XControl.h"
+#include "XDetector.h"
+#include "XFrame.h"
+#include "XGrabber.h"
+#include "iximg_sink.h"
+#include "xfactory.h"
+#include "xlib_sim.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace HX;
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+struct Options {
+    Sim::Config sim;
+    double seconds;
+    uint32_t frames;
+    uint32_t burst;
+    uint32_t burstPackMB;
+    bool prepare;
+    uint32_t lines;
+    uint32_t queues;
+    uint32_t batch;
+    bool busyPoll;
+    uint32_t adaptiveUs;
+    std::string xdpInterface;
+    bool uring;
+    uint32_t service;
+    bool trace;
+    std::string traceFile;
+    bool memory;
+    bool perf;
+    uint32_t sinks;
+    uint32_t sinkDelayMs;
+    bool pattern;
+
+    Options()
+        : seconds(5.0), frames(0), burst(0), burstPackMB(0), prepare(false), lines(512), queues(1), batch(1), busyPoll(false),
+          adaptiveUs(0), uring(false), service(0), trace(false), memory(false), perf(false), sinks(0), sinkDelayMs(0), pattern(false) {}
+};
+
+/// Counts frames; everything else is read from the statistics
+class CountingSink : public IXImgSink {
+public:
+    CountingSink() : frames(0), errors(0), delayMs(0), pool(nullptr) {}
+
+    void OnXError(uint32_t err_id, const char* err_msg_) override {
+        ++errors;
+        std::cerr << "[hx_simbench] Error " << err_id << ": " << err_msg_ << std::endl;
+    }
+
+    void OnXEvent(uint32_t event_id, uint32_t data) override {
+        (void)event_id;
+        (void)data;
+    }
+
+    void OnFrameReady(XImage* image_) override {
+        ++frames;
+        if (delayMs > 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(delayMs));
+        }
+        if (pool) {
+            pool->Release(image_);
+        }
+    }
+
+    std::atomic<uint64_t> frames;
+    std::atomic<uint64_t> errors;
+    uint32_t delayMs;               ///< Stands in for a slow consumer
+    XFrame* pool;                   ///< Frame to release to, for a pooled SetSink() sink
+};
+
+void usage() {
+    std::cerr <<
+        "Usage: hx_simbench [options]\n"
+        "  --width N      Pixels per line (default 2048)\n"
+        "  --rate N       Lines per second (default 10000)\n"
+        "  --modules N    DM modules, one packet each per line (default 1)\n"
+        "  --dual         Dual energy: a high and a low line per row\n"
+        "  --loss R       Fraction of packets dropped by the simulator\n"
+        "  --reorder R    Fraction of packets swapped with the next one\n"
+        "  --lines-per-packet N  Lines per packet, each with its header (default 1)\n"
+        "  --fragment B   Split lines into packets of B payload bytes\n"
+        "  --checksum     Send a CRC16 per packet and verify it in the grabber\n"
+        "  --corrupt R    Fraction of packets with a bit flipped (implies --checksum)\n"
+        "  --flip R       Fraction of packets with a bit flipped, no CRC16 (for --pattern)\n"
+        "  --pattern      Check every line against the simulator's test pattern\n"
+        "  --trigger P    Frame trigger marker every P rows; frames open only on it\n"
+        "  --seconds S    Acquisition time (default 5)\n"
+        "  --frames N     Grab N frames, waiting at most --seconds for them\n"
+        "  --burst N      Capture N frames into one preallocated block (implies --frames N)\n"
+        "  --burst-pack MB  Keep the burst packed losslessly in an MB arena (with --burst)\n"
+        "  --prepare      Allocate and touch the buffers before Grab (implied by --burst)\n"
+        "  --sinks N      Also deliver to N sinks on their own threads (pool of 8)\n"
+        "  --sink-delay MS  The first added sink takes MS per frame\n"
+        "  --lines N      Lines per frame (default 512)\n"
+        "  --queues N     Receive queues, at most 16 (default 1)\n"
+        "  --batch N      Packets per receive call (default 1)\n"
+        "  --busy-poll    Spin instead of sleeping in receive\n"
+        "  --adaptive US  Adaptive receive batches of up to --batch, held at most US\n"
+        "  --xdp IFACE    Receive through AF_XDP on IFACE, queue 0\n"
+        "  --uring        Receive through io_uring\n"
+        "  --service N    Assemble on N shared service loop threads\n"
+        "  --trace        Report per-stage latency percentiles\n"
+        "  --trace-out F  Also write a Chrome trace of the last 1M events to F\n"
+        "  --memory       Report live and peak bytes per subsystem\n"
+        "  --perf         Report hardware counters per stage\n";
+}
+
+bool parseCount(const char* text, uint32_t maxValue, uint32_t& value) {
+    char* end = nullptr;
+    const long v = std::strtol(text, &end, 10);
+    if (!end || *end != '\0' || v < 1 || v > static_cast<long>(maxValue)) {
+        return false;
+    }
+    value = static_cast<uint32_t>(v);
+    return true;
+}
+
+bool parseRatio(const char* text, double maxValue, double& value) {
+    char* end = nullptr;
+    const double v = std::strtod(text, &end);
+    if (!end || *end != '\0' || v < 0.0 || v > maxValue) {
+        return false;
+    }
+    value = v;
+    return true;
+}
+
+bool parseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "--width" && hasValue) {
+            if (!parseCount(argv[++i], 65536, options.sim.width)) return false;
+        } else if (arg == "--rate" && hasValue) {
+            if (!parseRatio(argv[++i], 1e7, options.sim.lineRate) || options.sim.lineRate <= 0.0) return false;
+        } else if (arg == "--modules" && hasValue) {
+            if (!parseCount(argv[++i], 64, options.sim.modules)) return false;
+        } else if (arg == "--dual") {
+            options.sim.dualEnergy = true;
+        } else if (arg == "--loss" && hasValue) {
+            if (!parseRatio(argv[++i], 1.0, options.sim.lossRatio)) return false;
+        } else if (arg == "--reorder" && hasValue) {
+            if (!parseRatio(argv[++i], 1.0, options.sim.reorderRatio)) return false;
+        } else if (arg == "--lines-per-packet" && hasValue) {
+            if (!parseCount(argv[++i], 256, options.sim.linesPerPacket)) return false;
+        } else if (arg == "--fragment" && hasValue) {
+            if (!parseCount(argv[++i], 65536, options.sim.fragmentBytes)) return false;
+        } else if (arg == "--checksum") {
+            options.sim.checksum = true;
+        } else if (arg == "--corrupt" && hasValue) {
+            if (!parseRatio(argv[++i], 1.0, options.sim.corruptRatio)) return false;
+            options.sim.checksum = true;
+        } else if (arg == "--flip" && hasValue) {
+            if (!parseRatio(argv[++i], 1.0, options.sim.corruptRatio)) return false;
+        } else if (arg == "--pattern") {
+            options.pattern = true;
+        } else if (arg == "--trigger" && hasValue) {
+            if (!parseCount(argv[++i], 1000000, options.sim.triggerPeriod)) return false;
+        } else if (arg == "--seconds" && hasValue) {
+            if (!parseRatio(argv[++i], 3600.0, options.seconds) || options.seconds <= 0.0) return false;
+        } else if (arg == "--frames" && hasValue) {
+            if (!parseCount(argv[++i], 1000000, options.frames)) return false;
+        } else if (arg == "--burst" && hasValue) {
+            if (!parseCount(argv[++i], 1000000, options.burst)) return false;
+            options.frames = options.burst;
+            options.prepare = true;
+        } else if (arg == "--burst-pack" && hasValue) {
+            if (!parseCount(argv[++i], 1u << 20, options.burstPackMB)) return false;
+        } else if (arg == "--prepare") {
+            options.prepare = true;
+        } else if (arg == "--sinks" && hasValue) {
+            if (!parseCount(argv[++i], 16, options.sinks)) return false;
+        } else if (arg == "--sink-delay" && hasValue) {
+            if (!parseCount(argv[++i], 10000, options.sinkDelayMs)) return false;
+        } else if (arg == "--lines" && hasValue) {
+            if (!parseCount(argv[++i], 65536, options.lines)) return false;
+        } else if (arg == "--queues" && hasValue) {
+            if (!parseCount(argv[++i], 16, options.queues)) return false;
+        } else if (arg == "--batch" && hasValue) {
+            if (!parseCount(argv[++i], 1024, options.batch)) return false;
+        } else if (arg == "--busy-poll") {
+            options.busyPoll = true;
+        } else if (arg == "--adaptive" && hasValue) {
+            if (!parseCount(argv[++i], 100000, options.adaptiveUs) || options.adaptiveUs == 0) return false;
+        } else if (arg == "--xdp" && hasValue) {
+            options.xdpInterface = argv[++i];
+        } else if (arg == "--uring") {
+            options.uring = true;
+        } else if (arg == "--service" && hasValue) {
+            if (!parseCount(argv[++i], 64, options.service)) return false;
+        } else if (arg == "--trace") {
+            options.trace = true;
+        } else if (arg == "--trace-out" && hasValue) {
+            options.trace = true;
+            options.traceFile = argv[++i];
+        } else if (arg == "--memory") {
+            options.memory = true;
+        } else if (arg == "--perf") {
+            options.perf = true;
+        } else {
+            return false;
+        }
+    }
+    if (options.sim.width % options.sim.modules != 0) {
+        std::cerr << "[hx_simbench] --width must be a multiple of --modules" << std::endl;
+        return false;
+    }
+    if (options.sim.linesPerPacket > 1 && options.sim.fragmentBytes > 0) {
+        std::cerr << "[hx_simbench] --lines-per-packet and --fragment exclude each other" << std::endl;
+        return false;
+    }
+    if (options.sim.fragmentBytes > 0 &&
+        (options.sim.dualEnergy ||
+         (options.sim.width * ((options.sim.pixelDepth + 7) / 8) / options.sim.modules) %
+             options.sim.fragmentBytes != 0)) {
+        std::cerr << "[hx_simbench] --fragment must divide a module's share of a single-energy line"
+                  << std::endl;
+        return false;
+    }
+    if (options.sim.dualEnergy && options.sim.modules > 1) {
+        std::cerr << "[hx_simbench] --dual sends full lines, use one module" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        usage();
+        return 2;
+    }
+    Sim::configure(options.sim);
+    const Sim::Config sim = Sim::configuration();
+    XFactory::SetMemoryProfiling(options.memory);
+    XFactory::SetServiceThreads(options.service);
+    if (options.perf && !XFactory::SetPerfCounters(true)) {
+        std::cerr << "[hx_simbench] Perf counters unavailable (build option or perf_event_paranoid)"
+                  << std::endl;
+        return 1;
+    }
+
+    XDetector detector;
+    detector.SetIP(sim.ip);
+    detector.SetCmdPort(sim.cmdPort);
+    detector.SetImgPort(sim.imgPort);
+    detector.SetMAC(sim.mac);
+    detector.SetSerialNum(sim.serial);
+    detector.SetPixelCount(sim.width);
+    detector.SetModuleCount(static_cast<uint8_t>(sim.modules));
+    detector.SetPixelDepth(sim.pixelDepth);
+
+    XControl control;
+    if (!control.Open(detector)) {
+        std::cerr << "[hx_simbench] Cannot open the command channel" << std::endl;
+        return 1;
+    }
+
+    CountingSink sink;
+    XFrame frame;
+    frame.SetLines(options.lines);
+    frame.SetSink(&sink);
+    frame.SetBurst(options.burst);
+    frame.SetBurstCompression(static_cast<uint64_t>(options.burstPackMB) << 20);
+    frame.SetFrameTrigger(sim.triggerPeriod > 0);
+    std::vector<CountingSink> addedSinks(options.sinks);
+    if (options.sinks > 0) {
+        frame.SetPoolSize(8);
+        sink.pool = &frame;
+        addedSinks[0].delayMs = options.sinkDelayMs;
+        for (uint32_t s = 0; s < options.sinks; ++s) {
+            frame.AddSink(&addedSinks[s]);
+        }
+    }
+    if (sim.dualEnergy) {
+        frame.SetDualEnergy(true);
+    } else if (sim.fragmentBytes > 0) {
+        frame.SetSegments(sim.width * ((sim.pixelDepth + 7) / 8) / sim.fragmentBytes);
+    } else if (sim.modules > 1) {
+        frame.SetSegments(sim.modules);
+    }
+
+    XGrabber grabber;
+    grabber.SetSink(&sink);
+    grabber.SetFrame(frame);
+    grabber.SetHeader(true);
+    grabber.SetPacketCheck(sim.checksum);
+    if (options.pattern) {
+        // Learned from the first period of lines the simulator sends
+        grabber.SetPatternCheck(nullptr, 0, Sim::PATTERN_LINES);
+    }
+    XGrabber::PacketLayout layout;
+    layout.linesPerPacket = sim.linesPerPacket;
+    layout.fragmentBytes = sim.fragmentBytes;
+    grabber.SetPacketLayout(layout);
+    grabber.SetBatchSize(options.batch);
+    grabber.SetReceiveQueues(options.queues);
+    grabber.SetReceiveMode(options.busyPoll ? XGrabber::RECEIVE_BUSY_POLL :
+                           options.adaptiveUs ? XGrabber::RECEIVE_ADAPTIVE : XGrabber::RECEIVE_BLOCKING);
+    if (options.adaptiveUs) {
+        grabber.SetBatchDelay(options.adaptiveUs);
+    }
+    grabber.SetKernelBypass(options.xdpInterface);
+    grabber.SetIoUring(options.uring);
+
+    // The simulator free-runs from the moment the image port is open, so
+    // both sides count from here
+    Sim::resetStatistics();
+    grabber.ResetStatistics();
+    if (options.trace) {
+        XFactory::ResetTraceStats();
+        XFactory::SetTracing(true);
+    }
+    if (!options.traceFile.empty() && !XFactory::StartTraceCapture(1u << 20)) {
+        std::cerr << "[hx_simbench] Cannot allocate the trace capture" << std::endl;
+        return 1;
+    }
+    XGrabber::NetworkConfig network;
+    network.recvBufferSize = sim.bufferSize;
+    if (!grabber.Open(detector, control, network)) {
+        std::cerr << "[hx_simbench] Cannot open the image channel" << std::endl;
+        return 1;
+    }
+
+    // Faulting a burst block in while the simulator streams loses packets
+    if (options.prepare && !grabber.Prepare()) {
+        std::cerr << "[hx_simbench] Prepare failed" << std::endl;
+        return 1;
+    }
+
+    const Clock::time_point start = Clock::now();
+    if (!grabber.Grab(options.frames)) {
+        std::cerr << "[hx_simbench] Grab failed" << std::endl;
+        return 1;
+    }
+    const bool xdp = grabber.GetKernelBypass();
+    const bool uring = grabber.GetIoUring();
+    if (options.frames > 0) {
+        if (!grabber.WaitGrab(static_cast<uint32_t>(options.seconds * 1000.0))) {
+            std::cerr << "[hx_simbench] Sequence of " << options.frames << " frame(s) not complete"
+                      << std::endl;
+        }
+    } else {
+        std::this_thread::sleep_for(std::chrono::duration<double>(options.seconds));
+    }
+    grabber.Stop();
+    XFactory::StopTraceCapture();
+    const double wall = std::chrono::duration<double>(Clock::now() - start).count();
+
+    XGrabber::Statistics stats;
+    grabber.GetStatistics(stats);
+    Sim::Stats simStats;
+    Sim::statistics(simStats);
+    XFactory::MemoryStats memory[XFactory::MEM_TAG_COUNT];
+    for (int t = 0; t < XFactory::MEM_TAG_COUNT; ++t) {
+        XFactory::GetMemoryStats(static_cast<XFactory::MemoryTag>(t), memory[t]);
+    }
+    grabber.Close();
+    control.Close();
+    XFactory::FlushLog();
+
+    const uint32_t energies = sim.dualEnergy ? 2 : 1;
+    const double lineBytes = static_cast<double>(sim.width) * ((sim.pixelDepth + 7) / 8) * energies;
+    const double rows = static_cast<double>(stats.linesReceived) / (frame.GetSegments() * energies);
+    std::printf("hx_simbench: %u px x %u module(s)%s, %.0f lines/s for %.2f s, "
+                "%u queue(s), batch %u%s%s%s%s%s%s\n",
+                sim.width, sim.modules, sim.dualEnergy ? ", dual energy" : "",
+                sim.lineRate, wall, options.queues, options.batch,
+                options.busyPoll ? ", busy poll" : "", options.adaptiveUs ? ", adaptive" : "", xdp ? ", AF_XDP" : "",
+                uring ? ", io_uring" : "", options.service ? ", service loop" : "",
+                sim.checksum ? ", CRC16" : "");
+    std::printf("  simulator  %10llu rows  %10llu packets sent  %llu dropped  %llu reordered  "
+                "%llu corrupted  %llu overflowed  late %u us\n",
+                static_cast<unsigned long long>(simStats.lines),
+                static_cast<unsigned long long>(simStats.packetsSent),
+                static_cast<unsigned long long>(simStats.packetsDropped),
+                static_cast<unsigned long long>(simStats.packetsReordered),
+                static_cast<unsigned long long>(simStats.packetsCorrupted),
+                static_cast<unsigned long long>(simStats.packetsOverflowed),
+                simStats.lateUs);
+    std::printf("  grabber    %10.0f rows  %10llu packets recv  %llu lost  %llu reordered  "
+                "%llu corrupt  %llu ring overflows\n",
+                rows,
+                static_cast<unsigned long long>(stats.packetsReceived),
+                static_cast<unsigned long long>(stats.packetsLost),
+                static_cast<unsigned long long>(stats.packetsReordered),
+                static_cast<unsigned long long>(stats.packetsCorrupt),
+                static_cast<unsigned long long>(stats.ringOverflows));
+    std::printf("  throughput %10.0f rows/s  %8.1f MB/s  %llu frames\n",
+                rows / wall, rows * lineBytes / wall / (1024.0 * 1024.0),
+                static_cast<unsigned long long>(sink.frames.load()));
+    if (options.pattern) {
+        std::printf("  pattern    %10llu segments checked  %llu mismatched\n",
+                    static_cast<unsigned long long>(stats.patternChecked),
+                    static_cast<unsigned long long>(stats.patternMismatched));
+    }
+    if (options.prepare) {
+        std::printf("  prepare    %10u us before Grab\n", grabber.GetPrepareTime());
+    }
+    if (options.burst > 0) {
+        // Kept by the frame after Stop(); a full one holds every row
+        uint64_t missing = 0;
+        for (uint32_t f = 0; f < frame.GetBurstFrames(); ++f) {
+            missing += frame.GetMissingLines(frame.GetBurstFrame(f), nullptr, 0);
+        }
+        std::printf("  burst      %10u of %u frames  %llu missing rows\n",
+                    frame.GetBurstFrames(), options.burst, static_cast<unsigned long long>(missing));
+        XFrame::BurstStats packed;
+        if (frame.GetBurstStats(packed)) {
+            std::printf("  packed     %10.2f ratio  %llu of %llu MB  %llu stalls  backlog peak %u%s\n",
+                        packed.ratio, static_cast<unsigned long long>(packed.packedBytes >> 20),
+                        static_cast<unsigned long long>(packed.arenaBytes >> 20),
+                        static_cast<unsigned long long>(packed.stalls), packed.backlogPeak,
+                        packed.arenaFull ? "  arena full" : "");
+        }
+    }
+    for (uint32_t s = 0; s < options.sinks; ++s) {
+        std::printf("  sink %-5u %10llu frames  %llu dropped%s\n", s + 1,
+                    static_cast<unsigned long long>(addedSinks[s].frames.load()),
+                    static_cast<unsigned long long>(frame.GetSinkDropped(&addedSinks[s])),
+                    (s == 0 && options.sinkDelayMs > 0) ? "  (slow)" : "");
+    }
+    if (sim.triggerPeriod > 0) {
+        std::printf("  trigger    %10llu lines dropped outside triggered frames\n",
+                    static_cast<unsigned long long>(frame.GetUntriggeredLines()));
+    }
+
+    if (options.trace) {
+        static const char* const names[] = {
+            "ring", "line", "assembly", "end-to-end", "sink"
+        };
+        std::printf("  latency    %-10s %10s %10s %10s %10s %10s (us)\n",
+                    "stage", "count", "p50", "p99", "p99.9", "max");
+        for (int s = XFactory::TRACE_RING; s <= XFactory::TRACE_SINK; ++s) {
+            XFactory::TraceStats t;
+            XFactory::GetTraceStats(static_cast<XFactory::TraceStage>(s), t);
+            std::printf("             %-10s %10llu %10.1f %10.1f %10.1f %10.1f\n",
+                        names[s], static_cast<unsigned long long>(t.count),
+                        t.p50Ns / 1000.0, t.p99Ns / 1000.0, t.p999Ns / 1000.0, t.maxNs / 1000.0);
+        }
+    }
+    if (options.memory) {
+        static const char* const names[] = {
+            "frame pool", "receive", "calibration", "display", "recorder", "image", "other"
+        };
+        std::printf("  memory     %-11s %10s %10s %10s %10s (KB)\n",
+                    "tag", "live", "peak", "allocs", "allocs/s");
+        for (int t = 0; t < XFactory::MEM_TAG_COUNT; ++t) {
+            const XFactory::MemoryStats& m = memory[t];
+            if (m.highWaterBytes == 0 && m.allocations == 0) {
+                continue;
+            }
+            std::printf("             %-11s %10.0f %10.0f %10llu %10.1f\n",
+                        names[t], m.liveBytes / 1024.0, m.highWaterBytes / 1024.0,
+                        static_cast<unsigned long long>(m.allocations), m.allocationsPerSecond);
+        }
+    }
+    if (options.perf) {
+        static const char* const names[] = { "assembly", "sink" };
+        std::printf("  perf       %-10s %10s %10s %10s %8s %10s (per region)\n",
+                    "stage", "regions", "cycles", "instr", "IPC", "LLC miss");
+        for (int s = XFactory::PERF_FRAME_ASSEMBLY; s <= XFactory::PERF_SINK; ++s) {
+            XFactory::PerfStats p;
+            XFactory::GetPerfStats(static_cast<XFactory::PerfStage>(s), p);
+            const double n = p.samples ? static_cast<double>(p.samples) : 1.0;
+            std::printf("             %-10s %10llu %10.0f %10.0f %8.2f %10.2f\n",
+                        names[s], static_cast<unsigned long long>(p.samples), p.cycles / n,
+                        p.instructions / n, p.cycles ? static_cast<double>(p.instructions) / p.cycles : 0.0,
+                        p.llcMisses / n);
+        }
+    }
+    if (!options.traceFile.empty() && !XFactory::WriteTraceCapture(options.traceFile)) {
+        std::cerr << "[hx_simbench] Cannot write " << options.traceFile << std::endl;
+        return 1;
+    }
+    return sink.errors.load() ? 1 : 0;
+}
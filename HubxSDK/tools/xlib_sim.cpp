@@ -0,0 +1,1423 @@
+// ============================================================================
+// xlib_sim.cpp - Simulated detector behind the xlibdll proxy
+// ============================================================================
+
+/**
+ * @file xlib_sim.cpp
+ * @brief XLibProxy_* implementation backed by an in-process detector emulator
+ * @version 2.1.0
+ */
+
+#include "xlib_sim.h"
+#include "xlibdll_wrapper/xlibdll_interface.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace HX {
+namespace Sim {
+
+using namespace HX::Internal;
+
+Config::Config()
+    : ip("192.168.1.2")
+    , cmdPort(3000)
+    , imgPort(4001)
+    , serial("SIM-0001")
+    , width(2048)
+    , pixelDepth(16)
+    , modules(1)
+    , lineRate(10000.0)
+    , dualEnergy(false)
+    , header(true)
+    , lossRatio(0.0)
+    , reorderRatio(0.0)
+    , checksum(false)
+    , linesPerPacket(1)
+    , fragmentBytes(0)
+    , corruptRatio(0.0)
+    , triggerPeriod(0)
+    , cmdLatencyUs(200)
+    , bufferSize(4 * 1024 * 1024)
+{
+    const uint8_t defaultMac[6] = { 0x02, 0x48, 0x58, 0x00, 0x00, 0x01 };
+    memcpy(mac, defaultMac, sizeof(mac));
+}
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+/// Image packet header bytes (see xlib_sim.h)
+const uint32_t PACKET_HEADER = 8;
+
+/// Receive queues of a multi-queue group
+const uint32_t MAX_QUEUES = 16;
+
+/// Rows emitted per burst before the schedule is checked again
+const uint64_t MAX_BURST = 1024;
+
+// Command codes the emulator answers specially (see XControl.cpp)
+const uint8_t CMD_LOAD_DEFAULT = 0x11;
+const uint8_t CMD_INTEGRATION_TIME = 0x20;
+const uint8_t CMD_CHANNEL_CONFIG = 0x25;
+const uint8_t CMD_GCU_SERIAL = 0x62;
+const uint8_t CMD_DM_SERIAL = 0x63;
+const uint8_t CMD_PIXEL_NUMBER = 0x64;
+const uint8_t CMD_GCU_FIRMWARE = 0x68;
+const uint8_t CMD_DM_PIXEL_NUM = 0x6C;
+const uint8_t CMD_CARD_NUM_PER_DFE = 0x6D;
+const uint8_t CMD_GCU_INFO = 0x72;
+const uint8_t CMD_ENERGY_MODE = 0x7B;
+const uint8_t CMD_BATCH = 0x7F;
+
+const uint8_t OP_WRITE = 0x01;
+const uint8_t OP_READ = 0x02;
+const uint8_t OP_LOAD = 0x04;
+
+const uint16_t FIRMWARE_VERSION = 0x0210;
+
+/**
+ * @brief Emulated socket receive buffer of one image queue
+ *
+ * Fixed-size slots; a packet that finds them all full is dropped, as the
+ * kernel drops datagrams when SO_RCVBUF is exhausted.
+ */
+class PacketQueue {
+public:
+    PacketQueue() : m_open(false), m_slotBytes(0), m_capacity(0), m_head(0), m_count(0) {}
+
+    void open(uint32_t packetBytes, uint32_t bufferSize) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_slotBytes = packetBytes;
+        m_capacity = std::max<uint32_t>(64, bufferSize / std::max<uint32_t>(packetBytes, 1));
+        m_store.assign(static_cast<size_t>(m_slotBytes) * m_capacity, 0);
+        m_lengths.assign(m_capacity, 0);
+        m_arrivals.assign(m_capacity, 0);
+        m_head = 0;
+        m_count = 0;
+        m_open = true;
+    }
+
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_open = false;
+            m_count = 0;
+        }
+        m_ready.notify_all();
+    }
+
+    bool isOpen() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_open;
+    }
+
+    /// false if closed or full
+    bool push(const uint8_t* packet, uint32_t length) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_open || m_count == m_capacity || length > m_slotBytes) {
+            return false;
+        }
+        const uint32_t slot = (m_head + m_count) % m_capacity;
+        memcpy(&m_store[static_cast<size_t>(slot) * m_slotBytes], packet, length);
+        m_lengths[slot] = length;
+        m_arrivals[slot] = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count());
+        if (m_count++ == 0) {
+            m_ready.notify_all();
+        }
+        return true;
+    }
+
+    void wake() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_ready.notify_all();
+    }
+
+    /**
+     * @brief Take up to count packets
+     * @param deliver Called as deliver(index, packet, length), returns 0 or
+     *        a negative error that ends the call
+     * @return Packets taken, or a negative error code
+     */
+    template <typename Deliver>
+    int32_t take(uint32_t count, uint32_t timeout, const std::atomic<bool>& wakeFlag,
+                 Deliver deliver) {
+        return takeTimed(count, timeout, wakeFlag,
+            [&](uint32_t i, const uint8_t* packet, uint32_t length, uint64_t) {
+                return deliver(i, packet, length);
+            });
+    }
+
+    /**
+     * @brief take() that also hands over the arrival time
+     * @param deliver Called as deliver(index, packet, length, arrivalNs);
+     *        arrivalNs stands in for the NIC's hardware receive stamp
+     */
+    template <typename Deliver>
+    int32_t takeTimed(uint32_t count, uint32_t timeout, const std::atomic<bool>& wakeFlag,
+                      Deliver deliver) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        const Clock::time_point deadline = Clock::now() + std::chrono::milliseconds(timeout);
+        while (m_open && m_count == 0 && !wakeFlag) {
+            // timeout 0 polls once
+            if (timeout == 0 || m_ready.wait_until(lock, deadline) == std::cv_status::timeout) {
+                break;
+            }
+        }
+        if (wakeFlag) {
+            return XLIB_ERROR_CANCELLED;
+        }
+        if (!m_open) {
+            return XLIB_ERROR_NOT_OPEN;
+        }
+        if (m_count == 0) {
+            return XLIB_ERROR_TIMEOUT;
+        }
+
+        uint32_t taken = 0;
+        while (taken < count && m_count > 0) {
+            const int32_t result = deliver(taken, &m_store[static_cast<size_t>(m_head) * m_slotBytes],
+                                           m_lengths[m_head], m_arrivals[m_head]);
+            m_head = (m_head + 1) % m_capacity;
+            --m_count;
+            if (result < 0) {
+                return result;
+            }
+            ++taken;
+        }
+        return static_cast<int32_t>(taken);
+    }
+
+private:
+    std::mutex m_mutex;
+    std::condition_variable m_ready;
+    bool m_open;
+    uint32_t m_slotBytes;
+    uint32_t m_capacity;
+    std::vector<uint8_t> m_store;
+    std::vector<uint32_t> m_lengths;
+    std::vector<uint64_t> m_arrivals;   ///< Realtime ns at push
+    uint32_t m_head;
+    uint32_t m_count;
+};
+
+/**
+ * @brief Emulated AF_XDP socket on image queue 0
+ *
+ * Packets are copied into free UMEM frames behind room for the headroom
+ * and Ethernet/IP/UDP headers, as the NIC would write them; a packet that
+ * finds the fill ring empty is dropped like a NIC drop.
+ */
+class XdpSocket {
+public:
+    XdpSocket() : m_open(false), m_umem(nullptr), m_frameSize(0) {}
+
+    int32_t open(uint8_t* umem, uint64_t umemSize, uint32_t frameSize) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_open) {
+            return XLIB_ERROR_ALREADY_OPEN;
+        }
+        if (frameSize <= XLIB_XDP_PAYLOAD_OFFSET || umemSize < frameSize ||
+            umemSize % frameSize != 0) {
+            return XLIB_ERROR_INVALID_PARAM;
+        }
+        m_umem = umem;
+        m_frameSize = frameSize;
+        m_fill.clear();
+        for (uint64_t addr = 0; addr < umemSize; addr += frameSize) {
+            m_fill.push_back(addr);
+        }
+        m_open = true;
+        return 0;
+    }
+
+    void close() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_open = false;
+        m_fill.clear();
+    }
+
+    int32_t receive(PacketQueue& queue, XLibXdpDesc* descs, uint32_t count, uint32_t timeout,
+                    const std::atomic<bool>& wakeFlag) {
+        uint32_t filled = 0;
+        const int32_t result = queue.take(count, timeout, wakeFlag,
+            [&](uint32_t, const uint8_t* packet, uint32_t length) -> int32_t {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (!m_open) {
+                    return XLIB_ERROR_NOT_OPEN;
+                }
+                if (m_fill.empty() || length > m_frameSize - XLIB_XDP_PAYLOAD_OFFSET) {
+                    return 0;
+                }
+                const uint64_t addr = m_fill.front() + XLIB_XDP_PAYLOAD_OFFSET;
+                m_fill.pop_front();
+                memcpy(m_umem + addr, packet, length);
+                descs[filled].addr = addr;
+                descs[filled].length = length;
+                descs[filled].reserved = 0;
+                ++filled;
+                return 0;
+            });
+        if (result < 0) {
+            return result;
+        }
+        return filled > 0 ? static_cast<int32_t>(filled) : XLIB_ERROR_TIMEOUT;
+    }
+
+    int32_t release(const uint64_t* addrs, uint32_t count) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_open) {
+            return XLIB_ERROR_NOT_OPEN;
+        }
+        for (uint32_t i = 0; i < count; ++i) {
+            m_fill.push_back(addrs[i] - addrs[i] % m_frameSize);
+        }
+        return 0;
+    }
+
+private:
+    std::mutex m_mutex;
+    bool m_open;
+    uint8_t* m_umem;
+    uint32_t m_frameSize;
+    std::deque<uint64_t> m_fill;
+};
+
+XdpSocket& xdpSocket() {
+    static XdpSocket instance;
+    return instance;
+}
+
+/**
+ * @brief Real datagram socket fed from image queue 0
+ *
+ * Gives XLibProxy_GetImageSocket a descriptor the kernel can wait on: a
+ * pump thread moves each packet from the queue into one end of a
+ * socketpair. It waits while the socket buffer is full, so overruns are
+ * still dropped at the queue as with the other receive calls.
+ */
+class ImageSocket {
+public:
+    ImageSocket() : m_running(false), m_queue(nullptr) {
+        m_fds[0] = m_fds[1] = -1;
+    }
+
+    ~ImageSocket() {
+        close();
+    }
+
+    int32_t open(PacketQueue& queue) {
+#ifdef _WIN32
+        (void)queue;
+        return XLIB_ERROR_GENERAL;
+#else
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_fds[0] >= 0) {
+            return m_fds[0];
+        }
+        if (socketpair(AF_UNIX, SOCK_DGRAM, 0, m_fds) != 0) {
+            m_fds[0] = m_fds[1] = -1;
+            return XLIB_ERROR_NETWORK;
+        }
+        const int bufferSize = 4 * 1024 * 1024;
+        setsockopt(m_fds[1], SOL_SOCKET, SO_SNDBUF, &bufferSize, sizeof(bufferSize));
+        setsockopt(m_fds[0], SOL_SOCKET, SO_RCVBUF, &bufferSize, sizeof(bufferSize));
+        m_running = true;
+        m_queue = &queue;
+        m_thread = std::thread(&ImageSocket::pump, this);
+        return m_fds[0];
+#endif
+    }
+
+    void close() {
+#ifndef _WIN32
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_fds[0] < 0) {
+            return;
+        }
+        m_running = false;
+        m_queue->wake();
+        m_thread.join();
+        ::close(m_fds[0]);
+        ::close(m_fds[1]);
+        m_fds[0] = m_fds[1] = -1;
+#endif
+    }
+
+private:
+#ifndef _WIN32
+    void pump() {
+        std::vector<uint8_t> packet;
+        const std::atomic<bool> noWake(false);
+        while (m_running) {
+            // Copy out under the queue lock, send without it
+            uint32_t length = 0;
+            const int32_t result = m_queue->take(1, 10, noWake,
+                [&](uint32_t, const uint8_t* data, uint32_t size) -> int32_t {
+                    packet.assign(data, data + size);
+                    length = size;
+                    return 0;
+                });
+            if (result == XLIB_ERROR_NOT_OPEN) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                continue;
+            }
+            if (result <= 0) {
+                continue;
+            }
+            while (m_running && send(m_fds[1], packet.data(), length, MSG_DONTWAIT) < 0) {
+                pollfd writable = { m_fds[1], POLLOUT, 0 };
+                poll(&writable, 1, 10);
+            }
+        }
+    }
+#endif
+
+    std::mutex m_mutex;
+    std::thread m_thread;
+    std::atomic<bool> m_running;
+    PacketQueue* m_queue;
+    int m_fds[2];
+};
+
+ImageSocket& imageSocket() {
+    static ImageSocket instance;
+    return instance;
+}
+
+/// Command response waiting out the emulated latency
+struct Response {
+    uint16_t sequence;
+    std::vector<uint8_t> data;
+    Clock::time_point due;
+};
+
+/**
+ * @brief The emulated detector
+ */
+class Device {
+public:
+    Device()
+        : m_networkOpen(false)
+        , m_timestamping(false)
+        , m_streaming(false)
+        , m_queueCount(1)
+        , m_bufferSize(0)
+        , m_nextSession(0)
+        , m_packetId(0)
+        , m_lineId(0)
+        , m_wake(false)
+        , m_lastError(XLIB_SUCCESS)
+    {
+        resetStatistics();
+    }
+
+    ~Device() {
+        closeNetwork();
+    }
+
+    // Configuration
+    void configure(const Config& config);
+    Config configuration();
+    void statistics(Stats& stats);
+    void resetStatistics();
+
+    // Network
+    int32_t initNetwork(uint16_t port);
+    int32_t initNetworkEx(const XLibNetworkConfig* config, XLibNetworkConfig* effective);
+    void closeNetwork();
+    int32_t openQueue(const XLibNetworkConfig* config, uint32_t index, uint32_t count);
+    void closeQueue(int32_t queue);
+    PacketQueue* queue(int32_t index);
+    bool timestamping() const { return m_timestamping; }
+
+    // Commands
+    int32_t sendCommand(const uint8_t* cmd, uint32_t cmdLen, uint8_t* response,
+                        uint32_t* responseLen);
+    int32_t postCommand(const uint8_t* cmd, uint32_t cmdLen, uint16_t sequence);
+    int32_t receiveResponse(uint16_t* sequence, uint8_t* response, uint32_t* responseLen,
+                            uint32_t timeout);
+
+    // Discovery
+    void deviceInfo(XLibDeviceInfo& info);
+    int32_t openDiscovery();
+    int32_t receiveDiscovery(int32_t session, XLibDeviceInfo* info, uint32_t timeout);
+    void closeDiscovery(int32_t session);
+    int32_t configureDevice(const uint8_t* mac, const char* ip, uint16_t cmdPort, uint16_t imgPort);
+    int32_t resetDevice(const uint8_t* mac);
+
+    // Receive wake
+    void wake(bool set);
+    const std::atomic<bool>& wakeFlag() const { return m_wake; }
+
+    int32_t fail(int32_t error) {
+        m_lastError = error;
+        return error;
+    }
+    int32_t lastError() const { return m_lastError; }
+
+private:
+    void startStreaming(uint32_t bufferSize, uint32_t queues, bool openAll);
+    void stopStreaming();
+    void streamThread(Config config);
+    void answer(const uint8_t* cmd, uint32_t cmdLen, std::vector<uint8_t>& out);
+    void readValue(uint8_t cmd, uint8_t dm, std::vector<uint8_t>& out);
+    uint32_t packetBytes(const Config& config) const;
+    void fillInfo(XLibDeviceInfo& info);
+
+    Config m_config;
+    bool m_networkOpen;
+    std::atomic<bool> m_timestamping;               // Receive stamps requested in initNetworkEx
+    std::mutex m_mutex;                             // Config, network state
+
+    // Image stream
+    PacketQueue m_queues[MAX_QUEUES];
+    std::thread m_streamThread;
+    std::atomic<bool> m_streaming;
+    uint32_t m_queueCount;                          // Modules spread over these
+    uint32_t m_bufferSize;
+
+    // Commands
+    std::map<uint32_t, std::vector<uint8_t> > m_params;    // cmd << 8 | dm
+    std::deque<Response> m_responses;
+    std::mutex m_cmdMutex;
+    std::condition_variable m_cmdReady;
+
+    // Discovery sessions, true once answered
+    std::map<int32_t, bool> m_sessions;
+    int32_t m_nextSession;
+
+    // Free-running counters, kept across restarts like a real detector
+    uint32_t m_packetId;
+    uint16_t m_lineId;
+
+    std::atomic<bool> m_wake;
+    std::atomic<int32_t> m_lastError;
+
+    std::atomic<uint64_t> m_lines;
+    std::atomic<uint64_t> m_packetsSent;
+    std::atomic<uint64_t> m_packetsDropped;
+    std::atomic<uint64_t> m_packetsReordered;
+    std::atomic<uint64_t> m_packetsCorrupted;
+    std::atomic<uint64_t> m_packetsOverflowed;
+    std::atomic<uint64_t> m_commands;
+    std::atomic<uint32_t> m_lateUs;
+};
+
+Device& device() {
+    static Device instance;
+    return instance;
+}
+
+void putBE(std::vector<uint8_t>& out, uint64_t value, uint32_t bytes) {
+    for (uint32_t i = bytes; i > 0; --i) {
+        out.push_back(static_cast<uint8_t>(value >> ((i - 1) * 8)));
+    }
+}
+
+/// xorshift32; the stream is reproducible between runs
+uint32_t nextRandom(uint32_t& state) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+bool chance(uint32_t& state, double ratio) {
+    return ratio > 0.0 && (nextRandom(state) >> 8) * (1.0 / 16777216.0) < ratio;
+}
+
+// ============================================================================
+// Device
+// ============================================================================
+
+void Device::configure(const Config& config) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_config = config;
+    m_config.modules = std::max<uint32_t>(1, config.modules);
+    m_config.pixelDepth = std::max<uint8_t>(8, std::min<uint8_t>(32, config.pixelDepth));
+
+    // Layouts need the header; fragments must tile a module's share
+    const uint32_t segmentBytes = m_config.width * ((m_config.pixelDepth + 7) / 8) / m_config.modules;
+    if (!m_config.header || segmentBytes == 0 ||
+        (m_config.fragmentBytes > 0 && segmentBytes % m_config.fragmentBytes != 0)) {
+        m_config.fragmentBytes = 0;
+    }
+    m_config.linesPerPacket = std::max<uint32_t>(1, config.linesPerPacket);
+    if (!m_config.header || m_config.fragmentBytes > 0) {
+        m_config.linesPerPacket = 1;
+    }
+}
+
+Config Device::configuration() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_config;
+}
+
+void Device::statistics(Stats& stats) {
+    stats.lines = m_lines;
+    stats.packetsSent = m_packetsSent;
+    stats.packetsDropped = m_packetsDropped;
+    stats.packetsReordered = m_packetsReordered;
+    stats.packetsCorrupted = m_packetsCorrupted;
+    stats.packetsOverflowed = m_packetsOverflowed;
+    stats.commands = m_commands;
+    stats.lateUs = m_lateUs;
+}
+
+void Device::resetStatistics() {
+    m_lines = 0;
+    m_packetsSent = 0;
+    m_packetsDropped = 0;
+    m_packetsReordered = 0;
+    m_packetsCorrupted = 0;
+    m_packetsOverflowed = 0;
+    m_commands = 0;
+    m_lateUs = 0;
+}
+
+uint32_t Device::packetBytes(const Config& config) const {
+    const uint32_t lineBytes = config.width * ((config.pixelDepth + 7) / 8);
+    const uint32_t crcBytes = config.checksum ? XLIB_PACKET_CRC_SIZE : 0;
+    if (config.fragmentBytes > 0) {
+        return XLIB_FRAGMENT_HEADER_SIZE + config.fragmentBytes + crcBytes;
+    }
+    return config.linesPerPacket * ((config.header ? PACKET_HEADER : 0) + lineBytes / config.modules) +
+           crcBytes;
+}
+
+int32_t Device::initNetwork(uint16_t port) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_networkOpen = true;
+    if (port == m_config.imgPort && !m_streaming) {
+        startStreaming(m_config.bufferSize, 1, true);
+    }
+    return XLIB_SUCCESS;
+}
+
+int32_t Device::initNetworkEx(const XLibNetworkConfig* config, XLibNetworkConfig* effective) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_networkOpen = true;
+    m_timestamping = config->timestamping != 0;
+    const uint32_t bufferSize = config->bufferSize > 0 ? config->bufferSize : m_config.bufferSize;
+    if (!m_streaming) {
+        startStreaming(bufferSize, 1, true);
+    }
+    if (effective) {
+        // Everything requested is granted
+        *effective = *config;
+        effective->bufferSize = bufferSize;
+    }
+    return XLIB_SUCCESS;
+}
+
+void Device::closeNetwork() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    stopStreaming();
+    m_networkOpen = false;
+    m_timestamping = false;
+
+    std::lock_guard<std::mutex> cmdLock(m_cmdMutex);
+    m_responses.clear();
+}
+
+int32_t Device::openQueue(const XLibNetworkConfig* config, uint32_t index, uint32_t count) {
+    if (count == 0 || count > MAX_QUEUES || index >= count) {
+        return fail(XLIB_ERROR_INVALID_PARAM);
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_networkOpen = true;
+    if (!m_streaming) {
+        // The first queue starts the stream; the rest join it
+        startStreaming(config->bufferSize > 0 ? config->bufferSize : m_config.bufferSize,
+                       count, false);
+    } else if (count != m_queueCount) {
+        return fail(XLIB_ERROR_ALREADY_OPEN);
+    }
+    if (m_queues[index].isOpen()) {
+        return fail(XLIB_ERROR_ALREADY_OPEN);
+    }
+    m_queues[index].open(packetBytes(m_config), m_bufferSize);
+    return static_cast<int32_t>(index);
+}
+
+void Device::closeQueue(int32_t queue) {
+    if (queue < 0 || static_cast<uint32_t>(queue) >= MAX_QUEUES) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_queues[queue].close();
+    for (uint32_t q = 0; q < m_queueCount; ++q) {
+        if (m_queues[q].isOpen()) {
+            return;
+        }
+    }
+    stopStreaming();
+}
+
+PacketQueue* Device::queue(int32_t index) {
+    if (index < 0 || static_cast<uint32_t>(index) >= MAX_QUEUES) {
+        return nullptr;
+    }
+    return &m_queues[index];
+}
+
+void Device::startStreaming(uint32_t bufferSize, uint32_t queues, bool openAll) {
+    // Called with m_mutex held
+    m_queueCount = queues;
+    m_bufferSize = bufferSize;
+    if (openAll) {
+        for (uint32_t q = 0; q < queues; ++q) {
+            m_queues[q].open(packetBytes(m_config), bufferSize);
+        }
+    }
+    m_streaming = true;
+    m_streamThread = std::thread(&Device::streamThread, this, m_config);
+}
+
+void Device::stopStreaming() {
+    // Called with m_mutex held; the stream thread never takes it
+    m_streaming = false;
+    if (m_streamThread.joinable()) {
+        m_streamThread.join();
+    }
+    for (uint32_t q = 0; q < MAX_QUEUES; ++q) {
+        m_queues[q].close();
+    }
+}
+
+void Device::streamThread(Config config) {
+    const uint32_t pixelBytes = (config.pixelDepth + 7) / 8;
+    const uint32_t lineBytes = config.width * pixelBytes;
+    const uint32_t segmentBytes = lineBytes / config.modules;
+    const uint32_t headerBytes = config.header ? PACKET_HEADER : 0;
+    const uint32_t crcBytes = config.checksum ? XLIB_PACKET_CRC_SIZE : 0;
+    const uint32_t recordBytes = headerBytes + segmentBytes;
+    const uint32_t records = config.linesPerPacket;
+    const uint32_t fragmentBytes = config.fragmentBytes;
+    const uint32_t packetLength = packetBytes(config);
+    const uint32_t energies = config.dualEnergy ? 2 : 1;
+    const uint32_t queues = m_queueCount;
+    const uint64_t pixelMask = (config.pixelDepth >= 32) ? 0xFFFFFFFFull
+                                                         : ((1ull << config.pixelDepth) - 1);
+
+    // Column ramps with a shift per line; index 0 low energy, 1 high
+    const uint32_t SHIFTS = PATTERN_LINES;
+    std::vector<uint8_t> pattern[2];
+    for (uint32_t e = 0; e < 2; ++e) {
+        pattern[e].resize(static_cast<size_t>(config.width + SHIFTS) * pixelBytes);
+        for (uint32_t x = 0; x < config.width + SHIFTS; ++x) {
+            const uint64_t value = ((e ? 0x6000ull : 0x3000ull) + (x * 37) % 4096) & pixelMask;
+            for (uint32_t b = 0; b < pixelBytes; ++b) {
+                pattern[e][static_cast<size_t>(x) * pixelBytes + b] = static_cast<uint8_t>(value >> (b * 8));
+            }
+        }
+    }
+
+    std::vector<uint8_t> packet(packetLength);
+    std::vector<uint8_t> held(packetLength);
+
+    // Packets being filled with records, one per module
+    std::vector<std::vector<uint8_t> > pending(config.modules, std::vector<uint8_t>(packetLength));
+    std::vector<uint32_t> pendingRecords(config.modules, 0);
+    std::vector<uint32_t> pendingIds(config.modules, 0);
+    uint32_t heldQueue = 0;
+    bool holding = false;
+    uint32_t random = 0x2545F491u;
+
+    // Put one packet on the wire, or keep it back to swap with the next
+    auto send = [&](uint32_t queue) {
+        if (m_queues[queue].push(packet.data(), packetLength)) {
+            ++m_packetsSent;
+        } else {
+            ++m_packetsOverflowed;
+        }
+    };
+    auto writeHeader = [](uint8_t* p, uint32_t packetId, uint16_t lineId, uint8_t energyFlag,
+                          uint32_t module) {
+        p[0] = static_cast<uint8_t>(packetId);
+        p[1] = static_cast<uint8_t>(packetId >> 8);
+        p[2] = static_cast<uint8_t>(packetId >> 16);
+        p[3] = static_cast<uint8_t>(packetId >> 24);
+        p[4] = static_cast<uint8_t>(lineId);
+        p[5] = static_cast<uint8_t>(lineId >> 8);
+        p[6] = energyFlag;
+        p[7] = static_cast<uint8_t>(module);
+    };
+    // Trailer and fault injection of a complete packet
+    auto seal = [&]() {
+        if (crcBytes > 0) {
+            const uint16_t crc = XLib_CalculateCRC16(packet.data(), packetLength - crcBytes);
+            packet[packetLength - crcBytes] = static_cast<uint8_t>(crc);
+            packet[packetLength - crcBytes + 1] = static_cast<uint8_t>(crc >> 8);
+        }
+        if (chance(random, config.corruptRatio)) {
+            // One bit anywhere, as a bad link would flip it
+            const uint32_t bit = nextRandom(random) % (packetLength * 8);
+            packet[bit / 8] ^= static_cast<uint8_t>(1u << (bit % 8));
+            ++m_packetsCorrupted;
+        }
+    };
+    auto emit = [&](uint32_t queue) {
+        if (chance(random, config.lossRatio)) {
+            ++m_packetsDropped;
+        } else if (holding) {
+            send(queue);
+            packet.swap(held);
+            send(heldQueue);
+            packet.swap(held);
+            holding = false;
+        } else if (chance(random, config.reorderRatio)) {
+            held.swap(packet);
+            heldQueue = queue;
+            holding = true;
+            ++m_packetsReordered;
+        } else {
+            send(queue);
+        }
+    };
+
+    const double rate = config.lineRate > 0.0 ? config.lineRate : 1.0;
+    const Clock::time_point start = Clock::now();
+    uint64_t rows = 0;
+
+    while (m_streaming) {
+        const double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+        const uint64_t due = static_cast<uint64_t>(elapsed * rate);
+        if (rows >= due) {
+            // Sleep until the next row, waking at least every 10 ms to see a stop
+            const Clock::time_point next = start + std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double>(static_cast<double>(rows + 1) / rate));
+            std::this_thread::sleep_until(std::min(next, Clock::now() + std::chrono::milliseconds(10)));
+            continue;
+        }
+
+        const uint64_t behind = due - rows;
+        if (behind > 1) {
+            const uint32_t lateUs = static_cast<uint32_t>(static_cast<double>(behind) / rate * 1e6);
+            if (lateUs > m_lateUs) {
+                m_lateUs = lateUs;
+            }
+        }
+
+        const uint64_t burst = std::min(behind, MAX_BURST);
+        for (uint64_t r = 0; r < burst; ++r) {
+            const uint16_t lineId = m_lineId++;
+            const size_t shift = static_cast<size_t>(lineId % SHIFTS) * pixelBytes;
+            const uint8_t triggerFlag =
+                (config.triggerPeriod > 0 && (rows + r) % config.triggerPeriod == 0) ? XLIB_FLAG_FRAME_TRIGGER : 0;
+            for (uint32_t e = 0; e < energies; ++e) {
+                // Dual energy sends the high line first
+                const uint8_t energyFlag = config.dualEnergy ? static_cast<uint8_t>(1 - e) : 0;
+                for (uint32_t m = 0; m < config.modules; ++m) {
+                    const uint8_t* segment =
+                        &pattern[config.dualEnergy ? energyFlag : 0][shift + static_cast<size_t>(m) * segmentBytes];
+                    if (fragmentBytes > 0) {
+                        // One packet per part, placed by its offset in the line
+                        for (uint32_t offset = 0; offset < segmentBytes; offset += fragmentBytes) {
+                            const uint32_t lineOffset = m * segmentBytes + offset;
+                            writeHeader(packet.data(), m_packetId++, lineId, energyFlag | triggerFlag, m);
+                            for (uint32_t b = 0; b < 4; ++b) {
+                                packet[PACKET_HEADER + b] = static_cast<uint8_t>(lineOffset >> (b * 8));
+                            }
+                            memcpy(&packet[XLIB_FRAGMENT_HEADER_SIZE], segment + offset, fragmentBytes);
+                            seal();
+                            emit(m % queues);
+                        }
+                        continue;
+                    }
+
+                    // Records of a packet share its packetId
+                    if (pendingRecords[m] == 0) {
+                        pendingIds[m] = m_packetId++;
+                    }
+                    uint8_t* record = &pending[m][static_cast<size_t>(pendingRecords[m]) * recordBytes];
+                    if (headerBytes > 0) {
+                        writeHeader(record, pendingIds[m], lineId, energyFlag | triggerFlag, m);
+                    }
+                    memcpy(record + headerBytes, segment, segmentBytes);
+                    if (++pendingRecords[m] == records) {
+                        pendingRecords[m] = 0;
+                        packet.swap(pending[m]);
+                        seal();
+                        emit(m % queues);
+                        packet.swap(pending[m]);
+                    }
+                }
+            }
+            ++m_lines;
+        }
+        rows += burst;
+    }
+}
+
+void Device::readValue(uint8_t cmd, uint8_t dm, std::vector<uint8_t>& out) {
+    // Written values first, then a write to all DMs, then the defaults
+    std::map<uint32_t, std::vector<uint8_t> >::const_iterator it = m_params.find(cmd << 8 | dm);
+    if (it == m_params.end()) {
+        it = m_params.find(cmd << 8 | 0xFF);
+    }
+    if (it != m_params.end()) {
+        out.insert(out.end(), it->second.begin(), it->second.end());
+        return;
+    }
+
+    const Config& c = m_config;
+    switch (cmd) {
+        case CMD_INTEGRATION_TIME:
+            putBE(out, static_cast<uint64_t>(1e6 / (c.lineRate > 0.0 ? c.lineRate : 1.0)), 4);
+            break;
+        case CMD_CHANNEL_CONFIG:
+            putBE(out, 0, 5);
+            break;
+        case CMD_PIXEL_NUMBER:
+            putBE(out, c.width, 2);
+            break;
+        case CMD_DM_PIXEL_NUM:
+            putBE(out, c.width / c.modules, 2);
+            break;
+        case CMD_CARD_NUM_PER_DFE:
+            putBE(out, c.modules, 1);
+            break;
+        case CMD_GCU_FIRMWARE:
+            putBE(out, FIRMWARE_VERSION, 2);
+            break;
+        case CMD_ENERGY_MODE:
+            putBE(out, c.dualEnergy ? 1 : 0, 1);
+            break;
+        case CMD_GCU_SERIAL:
+            out.insert(out.end(), c.serial.begin(), c.serial.end());
+            break;
+        case CMD_DM_SERIAL: {
+            const std::string serial = c.serial + "-DM" + std::to_string(static_cast<int>(dm));
+            out.insert(out.end(), serial.begin(), serial.end());
+            break;
+        }
+        default:
+            // Long enough for every numeric parameter
+            putBE(out, 0, 4);
+            break;
+    }
+}
+
+void Device::answer(const uint8_t* cmd, uint32_t cmdLen, std::vector<uint8_t>& out) {
+    const size_t start = out.size();
+    if (cmdLen < 4) {
+        const uint8_t invalid[4] = { cmdLen > 0 ? cmd[0] : uint8_t(0), cmdLen > 1 ? cmd[1] : uint8_t(0), 1, 0 };
+        out.insert(out.end(), invalid, invalid + 4);
+        return;
+    }
+
+    const uint8_t code = cmd[0];
+    const uint8_t op = cmd[1];
+    const uint8_t dm = cmd[2];
+    const uint32_t dataLen = std::min<uint32_t>(cmd[3], cmdLen - 4);
+    const uint8_t* data = cmd + 4;
+
+    out.push_back(code);
+    out.push_back(op);
+    out.push_back(0);
+    out.push_back(0);
+
+    if (code == CMD_BATCH) {
+        // Sub-commands back to back, answered back to back
+        uint32_t offset = 4;
+        while (offset + 4 <= cmdLen) {
+            const uint32_t subLen = std::min<uint32_t>(4 + cmd[offset + 3], cmdLen - offset);
+            answer(cmd + offset, subLen, out);
+            offset += subLen;
+        }
+    } else if (code == CMD_GCU_INFO) {
+        // Temperature and humidity in tenths, little-endian
+        const uint8_t info[6] = { 235 & 0xFF, 0, 400 & 0xFF, 400 >> 8, 0, 0 };
+        out.insert(out.end(), info, info + 6);
+    } else if (op == OP_WRITE) {
+        m_params[code << 8 | dm] = std::vector<uint8_t>(data, data + dataLen);
+    } else if (op == OP_READ) {
+        readValue(code, dm, out);
+    } else if (op == OP_LOAD && code == CMD_LOAD_DEFAULT) {
+        m_params.clear();
+    }
+
+    out[start + 3] = static_cast<uint8_t>(std::min<size_t>(out.size() - start - 4, 255));
+}
+
+int32_t Device::sendCommand(const uint8_t* cmd, uint32_t cmdLen, uint8_t* response,
+                            uint32_t* responseLen) {
+    std::vector<uint8_t> out;
+    uint32_t latency = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_networkOpen) {
+            return fail(XLIB_ERROR_NOT_OPEN);
+        }
+        answer(cmd, cmdLen, out);
+        latency = m_config.cmdLatencyUs;
+    }
+    ++m_commands;
+    std::this_thread::sleep_for(std::chrono::microseconds(latency));
+
+    const uint32_t copied = std::min<uint32_t>(*responseLen, static_cast<uint32_t>(out.size()));
+    memcpy(response, out.data(), copied);
+    *responseLen = copied;
+    return static_cast<int32_t>(copied);
+}
+
+int32_t Device::postCommand(const uint8_t* cmd, uint32_t cmdLen, uint16_t sequence) {
+    Response r;
+    r.sequence = sequence;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_networkOpen) {
+            return fail(XLIB_ERROR_NOT_OPEN);
+        }
+        answer(cmd, cmdLen, r.data);
+        r.due = Clock::now() + std::chrono::microseconds(m_config.cmdLatencyUs);
+    }
+    ++m_commands;
+
+    {
+        std::lock_guard<std::mutex> lock(m_cmdMutex);
+        m_responses.push_back(r);
+    }
+    m_cmdReady.notify_all();
+    return XLIB_SUCCESS;
+}
+
+int32_t Device::receiveResponse(uint16_t* sequence, uint8_t* response, uint32_t* responseLen,
+                                uint32_t timeout) {
+    std::unique_lock<std::mutex> lock(m_cmdMutex);
+    const Clock::time_point deadline = Clock::now() + std::chrono::milliseconds(timeout);
+    for (;;) {
+        // Same latency for every command, so the front is due first
+        const Clock::time_point now = Clock::now();
+        if (!m_responses.empty() && m_responses.front().due <= now) {
+            const Response& r = m_responses.front();
+            const uint32_t copied = std::min<uint32_t>(*responseLen, static_cast<uint32_t>(r.data.size()));
+            memcpy(response, r.data.data(), copied);
+            *responseLen = copied;
+            *sequence = r.sequence;
+            m_responses.pop_front();
+            return static_cast<int32_t>(copied);
+        }
+        if (now >= deadline) {
+            return XLIB_ERROR_TIMEOUT;
+        }
+        const Clock::time_point until = m_responses.empty() ? deadline
+                                                            : std::min(deadline, m_responses.front().due);
+        m_cmdReady.wait_until(lock, until);
+    }
+}
+
+void Device::deviceInfo(XLibDeviceInfo& info) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    fillInfo(info);
+}
+
+void Device::fillInfo(XLibDeviceInfo& info) {
+    // Called with m_mutex held
+    memset(&info, 0, sizeof(info));
+    memcpy(info.mac, m_config.mac, sizeof(info.mac));
+    strncpy(info.ip, m_config.ip.c_str(), sizeof(info.ip) - 1);
+    info.cmdPort = m_config.cmdPort;
+    info.imgPort = m_config.imgPort;
+    strncpy(info.serialNumber, m_config.serial.c_str(), sizeof(info.serialNumber) - 1);
+    info.pixelCount = m_config.width;
+    info.moduleCount = static_cast<uint8_t>(m_config.modules);
+    info.firmwareVersion = FIRMWARE_VERSION;
+}
+
+int32_t Device::openDiscovery() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const int32_t session = m_nextSession++;
+    m_sessions[session] = false;
+    return session;
+}
+
+int32_t Device::receiveDiscovery(int32_t session, XLibDeviceInfo* info, uint32_t timeout) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::map<int32_t, bool>::iterator it = m_sessions.find(session);
+        if (it == m_sessions.end()) {
+            return fail(XLIB_ERROR_INVALID_PARAM);
+        }
+        if (!it->second) {
+            it->second = true;
+            if (info) {
+                fillInfo(*info);
+            }
+            return 1;
+        }
+    }
+    // One detector, already answered
+    std::this_thread::sleep_for(std::chrono::milliseconds(timeout));
+    return XLIB_ERROR_TIMEOUT;
+}
+
+void Device::closeDiscovery(int32_t session) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_sessions.erase(session);
+}
+
+int32_t Device::configureDevice(const uint8_t* mac, const char* ip, uint16_t cmdPort,
+                                uint16_t imgPort) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (memcmp(mac, m_config.mac, sizeof(m_config.mac)) != 0) {
+        return fail(XLIB_ERROR_DEVICE_NOT_FOUND);
+    }
+    m_config.ip = ip;
+    m_config.cmdPort = cmdPort;
+    m_config.imgPort = imgPort;
+    return XLIB_SUCCESS;
+}
+
+int32_t Device::resetDevice(const uint8_t* mac) {
+    const Config defaults;
+    return configureDevice(mac, defaults.ip.c_str(), defaults.cmdPort, defaults.imgPort);
+}
+
+void Device::wake(bool set) {
+    m_wake = set;
+    if (set) {
+        for (uint32_t q = 0; q < MAX_QUEUES; ++q) {
+            m_queues[q].wake();
+        }
+    }
+}
+
+/// Copies one packet into a caller slot, truncating like a datagram socket
+int32_t toSlot(XLibPacketSlot& slot, const uint8_t* packet, uint32_t length) {
+    slot.length = std::min(length, slot.bufferSize);
+    memcpy(slot.buffer, packet, slot.length);
+    return 0;
+}
+
+} // namespace
+
+// ============================================================================
+// Emulator control
+// ============================================================================
+
+void configure(const Config& config) {
+    device().configure(config);
+}
+
+Config configuration() {
+    return device().configuration();
+}
+
+void statistics(Stats& stats) {
+    device().statistics(stats);
+}
+
+void resetStatistics() {
+    device().resetStatistics();
+}
+
+} // namespace Sim
+
+// ============================================================================
+// XLibProxy_* backed by the emulator
+// ============================================================================
+
+namespace Internal {
+
+using Sim::device;
+
+extern "C" {
+
+bool XLibProxy_Initialize() {
+    return true;
+}
+
+void XLibProxy_Cleanup() {
+    Sim::imageSocket().close();
+    device().closeNetwork();
+}
+
+bool XLibProxy_IsLoaded() {
+    return true;
+}
+
+int32_t XLibProxy_InitNetwork(const char* localIP, uint16_t port) {
+    (void)localIP;
+    return device().initNetwork(port);
+}
+
+int32_t XLibProxy_InitNetworkEx(const XLibNetworkConfig* config, XLibNetworkConfig* effective) {
+    XLIB_CHECK_POINTER(config);
+    return device().initNetworkEx(config, effective);
+}
+
+void XLibProxy_CloseNetwork() {
+    Sim::imageSocket().close();
+    device().closeNetwork();
+}
+
+int32_t XLibProxy_SendCommand(const uint8_t* cmd, uint32_t cmdLen,
+                              uint8_t* response, uint32_t* responseLen,
+                              uint32_t timeout) {
+    (void)timeout;
+    XLIB_CHECK_POINTER(cmd);
+    XLIB_CHECK_POINTER(response);
+    XLIB_CHECK_POINTER(responseLen);
+    return device().sendCommand(cmd, cmdLen, response, responseLen);
+}
+
+int32_t XLibProxy_PostCommand(const uint8_t* cmd, uint32_t cmdLen, uint16_t sequence) {
+    XLIB_CHECK_POINTER(cmd);
+    return device().postCommand(cmd, cmdLen, sequence);
+}
+
+int32_t XLibProxy_ReceiveCommandResponse(uint16_t* sequence,
+                                         uint8_t* response, uint32_t* responseLen,
+                                         uint32_t timeout) {
+    XLIB_CHECK_POINTER(sequence);
+    XLIB_CHECK_POINTER(response);
+    XLIB_CHECK_POINTER(responseLen);
+    return device().receiveResponse(sequence, response, responseLen, timeout);
+}
+
+int32_t XLibProxy_ReceiveImageData(uint8_t* buffer, uint32_t bufferSize, uint32_t timeout) {
+    XLIB_CHECK_POINTER(buffer);
+    uint32_t received = 0;
+    const int32_t result = device().queue(0)->take(1, timeout, device().wakeFlag(),
+        [&](uint32_t, const uint8_t* packet, uint32_t length) -> int32_t {
+            if (length > bufferSize) {
+                return XLIB_ERROR_BUFFER_OVERFLOW;
+            }
+            memcpy(buffer, packet, length);
+            received = length;
+            return 0;
+        });
+    return result < 0 ? result : static_cast<int32_t>(received);
+}
+
+int32_t XLibProxy_ReceiveImageBatch(XLibPacketSlot* slots, uint32_t slotCount, uint32_t timeout) {
+    XLIB_CHECK_POINTER(slots);
+    return device().queue(0)->take(slotCount, timeout, device().wakeFlag(),
+        [&](uint32_t i, const uint8_t* packet, uint32_t length) {
+            return Sim::toSlot(slots[i], packet, length);
+        });
+}
+
+int32_t XLibProxy_ReceiveImageBatchTimed(XLibPacketSlot* slots, uint64_t* receiveNs,
+                                         uint32_t slotCount, uint32_t timeout) {
+    XLIB_CHECK_POINTER(slots);
+    XLIB_CHECK_POINTER(receiveNs);
+    const bool stamped = device().timestamping();
+    return device().queue(0)->takeTimed(slotCount, timeout, device().wakeFlag(),
+        [&](uint32_t i, const uint8_t* packet, uint32_t length, uint64_t arrivalNs) {
+            receiveNs[i] = stamped ? arrivalNs : 0;
+            return Sim::toSlot(slots[i], packet, length);
+        });
+}
+
+int32_t XLibProxy_ReceiveImageScatter(uint8_t* header, uint32_t headerSize,
+                                      uint8_t* payload, uint32_t payloadSize,
+                                      uint32_t timeout) {
+    XLIB_CHECK_POINTER(payload);
+    uint32_t received = 0;
+    const int32_t result = device().queue(0)->take(1, timeout, device().wakeFlag(),
+        [&](uint32_t, const uint8_t* packet, uint32_t length) -> int32_t {
+            const uint32_t head = std::min(headerSize, length);
+            if (head > 0) {
+                memcpy(header, packet, head);
+            }
+            if (length - head > payloadSize) {
+                memcpy(payload, packet + head, payloadSize);
+                return XLIB_ERROR_BUFFER_OVERFLOW;
+            }
+            memcpy(payload, packet + head, length - head);
+            received = length;
+            return 0;
+        });
+    return result < 0 ? result : static_cast<int32_t>(received);
+}
+
+int32_t XLibProxy_OpenImageQueue(const XLibNetworkConfig* config,
+                                 uint32_t queueIndex, uint32_t queueCount) {
+    XLIB_CHECK_POINTER(config);
+    return device().openQueue(config, queueIndex, queueCount);
+}
+
+void XLibProxy_CloseImageQueue(int32_t queue) {
+    device().closeQueue(queue);
+}
+
+int32_t XLibProxy_ReceiveImageQueue(int32_t queue, XLibPacketSlot* slots,
+                                    uint32_t slotCount, uint32_t timeout) {
+    XLIB_CHECK_POINTER(slots);
+    Sim::PacketQueue* q = device().queue(queue);
+    if (!q) {
+        return device().fail(XLIB_ERROR_INVALID_PARAM);
+    }
+    return q->take(slotCount, timeout, device().wakeFlag(),
+        [&](uint32_t i, const uint8_t* packet, uint32_t length) {
+            return Sim::toSlot(slots[i], packet, length);
+        });
+}
+
+int32_t XLibProxy_OpenImageXdp(const XLibXdpConfig* config, uint8_t* umem, uint64_t umemSize) {
+    XLIB_CHECK_POINTER(config);
+    XLIB_CHECK_POINTER(umem);
+    const int32_t result = Sim::xdpSocket().open(umem, umemSize, config->frameSize);
+    return result < 0 ? device().fail(result) : result;
+}
+
+void XLibProxy_CloseImageXdp(int32_t handle) {
+    if (handle == 0) {
+        Sim::xdpSocket().close();
+    }
+}
+
+int32_t XLibProxy_ReceiveImageXdp(int32_t handle, XLibXdpDesc* descs, uint32_t count,
+                                  uint32_t timeout) {
+    XLIB_CHECK_POINTER(descs);
+    if (handle != 0) {
+        return device().fail(XLIB_ERROR_INVALID_PARAM);
+    }
+    return Sim::xdpSocket().receive(*device().queue(0), descs, count, timeout, device().wakeFlag());
+}
+
+int32_t XLibProxy_ReleaseImageXdp(int32_t handle, const uint64_t* addrs, uint32_t count) {
+    XLIB_CHECK_POINTER(addrs);
+    if (handle != 0) {
+        return device().fail(XLIB_ERROR_INVALID_PARAM);
+    }
+    return Sim::xdpSocket().release(addrs, count);
+}
+
+int32_t XLibProxy_GetImageSocket() {
+    if (!device().queue(0)->isOpen()) {
+        return device().fail(XLIB_ERROR_NOT_OPEN);
+    }
+    const int32_t result = Sim::imageSocket().open(*device().queue(0));
+    return result < 0 ? device().fail(result) : result;
+}
+
+void XLibProxy_ReleaseImageSocket() {
+    Sim::imageSocket().close();
+}
+
+int32_t XLibProxy_WakeImageReceive() {
+    device().wake(true);
+    return XLIB_SUCCESS;
+}
+
+int32_t XLibProxy_ClearImageWake() {
+    device().wake(false);
+    return XLIB_SUCCESS;
+}
+
+int32_t XLibProxy_DiscoverDevices(const char* localIP) {
+    (void)localIP;
+    return 1;
+}
+
+int32_t XLibProxy_GetDeviceInfo(uint32_t index, XLibDeviceInfo* info) {
+    XLIB_CHECK_POINTER(info);
+    if (index != 0) {
+        return device().fail(XLIB_ERROR_DEVICE_NOT_FOUND);
+    }
+    device().deviceInfo(*info);
+    return XLIB_SUCCESS;
+}
+
+int32_t XLibProxy_OpenDiscovery(const char* localIP) {
+    (void)localIP;
+    return device().openDiscovery();
+}
+
+int32_t XLibProxy_ReceiveDiscovery(int32_t session, XLibDeviceInfo* info, uint32_t timeout) {
+    return device().receiveDiscovery(session, info, timeout);
+}
+
+void XLibProxy_CloseDiscovery(int32_t session) {
+    device().closeDiscovery(session);
+}
+
+int32_t XLibProxy_ConfigureDevice(const uint8_t* mac, const char* ip,
+                                  uint16_t cmdPort, uint16_t imgPort) {
+    XLIB_CHECK_POINTER(mac);
+    XLIB_CHECK_POINTER(ip);
+    return device().configureDevice(mac, ip, cmdPort, imgPort);
+}
+
+int32_t XLibProxy_ResetDevice(const uint8_t* mac) {
+    XLIB_CHECK_POINTER(mac);
+    return device().resetDevice(mac);
+}
+
+int32_t XLibProxy_ParseImagePacket(const uint8_t* rawData, uint32_t rawLen,
+                                   uint8_t* imageData, uint32_t* imageLen) {
+    XLIB_CHECK_POINTER(rawData);
+    XLIB_CHECK_POINTER(imageData);
+    XLIB_CHECK_POINTER(imageLen);
+    if (rawLen < Sim::PACKET_HEADER) {
+        return XLIB_ERROR_PARSE_FAILED;
+    }
+    const uint32_t payload = rawLen - Sim::PACKET_HEADER;
+    if (payload > *imageLen) {
+        return XLIB_ERROR_BUFFER_OVERFLOW;
+    }
+    memcpy(imageData, rawData + Sim::PACKET_HEADER, payload);
+    *imageLen = payload;
+    return XLIB_SUCCESS;
+}
+
+int32_t XLibProxy_ExtractPacketHeader(const uint8_t* rawData, XLibPacketHeader* header) {
+    XLIB_CHECK_POINTER(rawData);
+    XLIB_CHECK_POINTER(header);
+    memset(header, 0, sizeof(*header));
+    header->packetId = static_cast<uint32_t>(rawData[0]) |
+                       static_cast<uint32_t>(rawData[1]) << 8 |
+                       static_cast<uint32_t>(rawData[2]) << 16 |
+                       static_cast<uint32_t>(rawData[3]) << 24;
+    header->lineId = static_cast<uint16_t>(rawData[4] | rawData[5] << 8);
+    header->energyFlag = rawData[6];
+    header->moduleId = rawData[7];
+    return XLIB_SUCCESS;
+}
+
+int32_t XLibProxy_GetLastError() {
+    return device().lastError();
+}
+
+const char* XLibProxy_GetErrorMessage(int32_t errorCode) {
+    switch (errorCode) {
+        case XLIB_SUCCESS:                return "Success";
+        case XLIB_ERROR_NETWORK:          return "Network error";
+        case XLIB_ERROR_TIMEOUT:          return "Operation timeout";
+        case XLIB_ERROR_INVALID_PARAM:    return "Invalid parameter";
+        case XLIB_ERROR_DEVICE_NOT_FOUND: return "Device not found";
+        case XLIB_ERROR_BUFFER_OVERFLOW:  return "Buffer overflow";
+        case XLIB_ERROR_ALREADY_OPEN:     return "Already opened";
+        case XLIB_ERROR_NOT_OPEN:         return "Not opened";
+        case XLIB_ERROR_CANCELLED:        return "Receive cancelled";
+        case XLIB_ERROR_PARSE_FAILED:     return "Parse error";
+        default:                          return "Simulator error";
+    }
+}
+
+} // extern "C"
+
+} // namespace Internal
+} // namespace HX
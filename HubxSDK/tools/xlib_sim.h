@@ -0,0 +1,122 @@
+// ============================================================================
+// xlib_sim.h - Simulated detector behind the xlibdll proxy
+// ============================================================================
+
+/**
+ * @file xlib_sim.h
+ * @brief In-process detector emulator implementing the XLibProxy_* interface
+ * @version 2.1.0
+ *
+ * xlib_sim.cpp provides every function of xlibdll_interface.h, so hubx
+ * built against it (the hubx_sim target) runs XAdaptor, XControl and
+ * XGrabber without hardware. The emulated detector:
+ *
+ * - answers discovery, network configuration and reset;
+ * - answers commands [cmd, op, dm, len, data] with [cmd, op, err, len,
+ *   data] after a configurable latency, keeps written parameters and
+ *   unpacks BATCH transactions;
+ * - streams image packets at a configured line rate from the moment the
+ *   image port is opened, as a free-running detector does, split into one
+ *   packet per DM module and, in dual-energy mode, a high and a low line
+ *   per lineId;
+ * - drops and swaps packets at configured ratios, and drops packets the
+ *   receiver does not take off its emulated socket buffer in time.
+ *
+ * Image packets carry an 8-byte header, little-endian:
+ *
+ *   bytes 0-3  packetId    bytes 4-5  lineId
+ *   byte  6    energyFlag  byte  7    moduleId
+ *
+ * with the top bit of byte 6 set on every Config::triggerPeriod-th row,
+ * as the frame trigger would, unless Config::header is off, for detectors streaming bare line payloads.
+ * With Config::checksum each packet ends in the CRC16 of the bytes before
+ * it, low byte first (see XGrabber::SetPacketCheck()). Config::linesPerPacket
+ * and Config::fragmentBytes pack several lines of a module into a packet or
+ * split a module's share of a line over several, as described at
+ * XGrabber::SetPacketLayout().
+ *
+ * One detector is emulated per process, like the single xlibdll network.
+ */
+
+#ifndef XLIB_SIM_H
+#define XLIB_SIM_H
+
+#include <cstdint>
+#include <string>
+
+namespace HX {
+namespace Sim {
+
+/// Line pixels are column ramps shifted by lineId % PATTERN_LINES, the
+/// period XGrabber::SetPatternCheck() needs to verify them
+const uint32_t PATTERN_LINES = 64;
+
+/**
+ * @struct Config
+ * @brief Emulated detector
+ */
+struct Config {
+    std::string ip;             ///< Detector IP
+    uint16_t cmdPort;           ///< Command port
+    uint16_t imgPort;           ///< Image port
+    uint8_t mac[6];             ///< MAC address
+    std::string serial;         ///< GCU serial number
+    uint32_t width;             ///< Pixels per line (all modules)
+    uint8_t pixelDepth;         ///< Bits per pixel (16 -> 2 bytes per pixel)
+    uint32_t modules;           ///< DM modules, one packet each per line
+    double lineRate;            ///< Lines per second (rows, not packets)
+    bool dualEnergy;            ///< High and low line per row
+    bool header;                ///< Packets start with the 8-byte header (false = pixels only)
+    double lossRatio;           ///< Fraction of packets dropped on the wire
+    double reorderRatio;        ///< Fraction of packets swapped with the next one
+    bool checksum;              ///< Packets end in a CRC16 trailer
+    uint32_t linesPerPacket;    ///< Header + line records per packet (header mode)
+    uint32_t fragmentBytes;     ///< Split each module's share of a line into parts this big (0 = off)
+    double corruptRatio;        ///< Fraction of packets with a bit flipped after the CRC
+    uint32_t triggerPeriod;     ///< Rows from one frame trigger marker to the next (0 = none)
+    uint32_t cmdLatencyUs;      ///< Command round trip
+    uint32_t bufferSize;        ///< Emulated socket buffer per receive queue (bytes)
+
+    Config();
+};
+
+/**
+ * @struct Stats
+ * @brief Emulator counters
+ */
+struct Stats {
+    uint64_t lines;             ///< Rows generated
+    uint64_t packetsSent;       ///< Packets put on the wire
+    uint64_t packetsDropped;    ///< Packets dropped by loss injection
+    uint64_t packetsReordered;  ///< Packets swapped by reorder injection
+    uint64_t packetsCorrupted;  ///< Packets damaged by corruption injection
+    uint64_t packetsOverflowed; ///< Packets dropped, socket buffer full
+    uint64_t commands;          ///< Commands answered (a BATCH counts once)
+    uint32_t lateUs;            ///< Largest lag behind the line schedule (µs)
+};
+
+/**
+ * @brief Set the emulated detector
+ * @note Applies to the next time the image port is opened
+ */
+void configure(const Config& config);
+
+/**
+ * @brief Get the emulated detector
+ */
+Config configuration();
+
+/**
+ * @brief Get the emulator counters
+ */
+void statistics(Stats& stats);
+
+/**
+ * @brief Reset the emulator counters
+ */
+void resetStatistics();
+
+} // namespace Sim
+} // namespace HX
+
+#endif // XLIB_SIM_H